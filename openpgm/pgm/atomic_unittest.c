@@ -115,6 +115,83 @@ START_TEST (test_int32_set_pass_001)
 }
 END_TEST
 
+/* target:
+ *	bool
+ *	pgm_atomic_compare_and_exchange32 (
+ *		volatile uint32_t*	atomic,
+ *		const uint32_t		oldval,
+ *		const uint32_t		newval
+ *	)
+ */
+
+START_TEST (test_int32_compare_and_exchange_pass_001)
+{
+	volatile uint32_t atomic = (uint32_t)-1;
+	fail_unless (TRUE == pgm_atomic_compare_and_exchange32 (&atomic, (uint32_t)-1, 5), "cas failed");
+	fail_unless (5 == atomic, "cas failed");
+	fail_unless (FALSE == pgm_atomic_compare_and_exchange32 (&atomic, (uint32_t)-1, 0), "cas failed");
+	fail_unless (5 == atomic, "cas failed");
+}
+END_TEST
+
+/* target:
+ *	uint32_t
+ *	pgm_atomic_fetch_and_or32 (
+ *		volatile uint32_t*	atomic,
+ *		const uint32_t		val
+ *	)
+ */
+
+START_TEST (test_int32_fetch_and_or_pass_001)
+{
+	volatile uint32_t atomic = 0x0f;
+	fail_unless (0x0f == pgm_atomic_fetch_and_or32 (&atomic, 0xf0), "fetch_and_or failed");
+	fail_unless (0xff == atomic, "fetch_and_or failed");
+	fail_unless (0xff == pgm_atomic_fetch_and_or32 (&atomic, 0x01), "fetch_and_or failed");
+	fail_unless (0xff == atomic, "fetch_and_or failed");
+}
+END_TEST
+
+/* target:
+ *	uint32_t
+ *	pgm_atomic_fetch_and_and32 (
+ *		volatile uint32_t*	atomic,
+ *		const uint32_t		val
+ *	)
+ */
+
+START_TEST (test_int32_fetch_and_and_pass_001)
+{
+	volatile uint32_t atomic = 0xff;
+	fail_unless (0xff == pgm_atomic_fetch_and_and32 (&atomic, ~0x0fU), "fetch_and_and failed");
+	fail_unless (0xf0 == atomic, "fetch_and_and failed");
+	fail_unless (0xf0 == pgm_atomic_fetch_and_and32 (&atomic, 0), "fetch_and_and failed");
+	fail_unless (0 == atomic, "fetch_and_and failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_atomic_compare_and_exchange_pointer (
+ *		void*volatile*		atomic,
+ *		void*			oldval,
+ *		void*			newval
+ *	)
+ */
+
+START_TEST (test_pointer_compare_and_exchange_pass_001)
+{
+	int a, b;
+	void*volatile atomic = &a;
+	fail_unless (TRUE == pgm_atomic_compare_and_exchange_pointer (&atomic, &a, &b), "cas failed");
+	fail_unless (&b == atomic, "cas failed");
+	fail_unless (FALSE == pgm_atomic_compare_and_exchange_pointer (&atomic, &a, NULL), "cas failed");
+	fail_unless (&b == atomic, "cas failed");
+	fail_unless (TRUE == pgm_atomic_compare_and_exchange_pointer (&atomic, &b, NULL), "cas failed");
+	fail_unless (NULL == atomic, "cas failed");
+}
+END_TEST
+
 
 static
 Suite*
@@ -141,6 +218,16 @@ make_test_suite (void)
 	suite_add_tcase (s, tc_set);
 	tcase_add_test (tc_set, test_int32_set_pass_001);
 
+	TCase* tc_compare_and_exchange = tcase_create ("compare-and-exchange");
+	suite_add_tcase (s, tc_compare_and_exchange);
+	tcase_add_test (tc_compare_and_exchange, test_int32_compare_and_exchange_pass_001);
+	tcase_add_test (tc_compare_and_exchange, test_pointer_compare_and_exchange_pass_001);
+
+	TCase* tc_fetch_and_op = tcase_create ("fetch-and-op");
+	suite_add_tcase (s, tc_fetch_and_op);
+	tcase_add_test (tc_fetch_and_op, test_int32_fetch_and_or_pass_001);
+	tcase_add_test (tc_fetch_and_op, test_int32_fetch_and_and_pass_001);
+
 	return s;
 }
 
@@ -0,0 +1,307 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * receiver state checkpoint and restore across process restarts.
+ *
+ * A receiving application records the receive state of every source, the
+ * next sequence to deliver, the FEC parameters and the address NAKs are sent
+ * to, in a file that a restarted process loads before pgm_connect().  The
+ * first packet of a restored source then places its window at the recorded
+ * sequence instead of at the packet, such that the update to the lead NAKs
+ * only what was missed whilst the process was down, without waiting for an
+ * SPM.  A file under /dev/shm keeps the checkpoint in shared memory.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#	include <unistd.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/checkpoint.h>
+
+
+//#define CHECKPOINT_DEBUG
+
+#ifndef CHECKPOINT_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+
+/* record the receive state of every source of a connected socket to path,
+ * replacing the file atomically.  called on the receiving thread between
+ * reads such that the checkpoint matches exactly what has been delivered.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error appropriately.
+ */
+
+bool
+pgm_checkpoint_save (
+	pgm_sock_t*    const restrict sock,
+	const char*	     restrict path,
+	pgm_error_t**	     restrict error
+	)
+{
+	struct pgm_checkpoint_header_t header;
+	struct pgm_checkpoint_peer_t* records;
+	unsigned count = 0;
+	char* tmp_path;
+	FILE* fp;
+
+	pgm_return_val_if_fail (NULL != sock, FALSE);
+	pgm_return_val_if_fail (NULL != path, FALSE);
+	if (PGM_UNLIKELY(!pgm_sock_reader_trylock (sock)))
+		pgm_return_val_if_reached (FALSE);
+	if (PGM_UNLIKELY(!sock->is_connected || !sock->can_recv_data)) {
+		pgm_sock_reader_unlock (sock);
+		pgm_return_val_if_reached (FALSE);
+	}
+
+/* snapshot under the peers lock, written out without it */
+	pgm_rwlock_reader_lock (&sock->peers_lock);
+	records = pgm_new0 (struct pgm_checkpoint_peer_t, MAX(1, MIN(pgm_list_length (sock->peers_list), PGM_CHECKPOINT_PEERS_MAX)));
+	for (pgm_list_t* list = sock->peers_list; NULL != list && count < PGM_CHECKPOINT_PEERS_MAX; list = list->next)
+	{
+		const pgm_peer_t* peer = list->data;
+		const pgm_rxw_t* window = peer->window;
+		if (!window->is_defined)
+			continue;
+		struct pgm_checkpoint_peer_t* record = &records[ count++ ];
+		memcpy (&record->tsi, &peer->tsi, sizeof (pgm_tsi_t));
+		record->trail		= window->trail;
+		record->lead		= window->lead;
+		record->commit_lead	= window->commit_lead;
+		if (window->is_fec_available) {
+			record->rs_k			= window->rs.k;
+			record->has_proactive_parity	= peer->has_proactive_parity;
+			record->has_ondemand_parity	= peer->has_ondemand_parity;
+		}
+		memcpy (&record->nla, &peer->nla, sizeof (struct sockaddr_storage));
+	}
+	pgm_rwlock_reader_unlock (&sock->peers_lock);
+	pgm_sock_reader_unlock (sock);
+
+	header.magic	  = PGM_CHECKPOINT_MAGIC;
+	header.version	  = PGM_CHECKPOINT_VERSION;
+	header.count	  = count;
+	header.record_len = sizeof (struct pgm_checkpoint_peer_t);
+
+/* written aside and renamed over path, a crash leaves the previous checkpoint */
+	const size_t path_len = strlen (path);
+	tmp_path = pgm_malloc (path_len + sizeof (".tmp"));
+	memcpy (tmp_path, path, path_len);
+	memcpy (tmp_path + path_len, ".tmp", sizeof (".tmp"));
+	fp = fopen (tmp_path, "wb");
+	if (NULL == fp ||
+	    1 != fwrite (&header, sizeof (header), 1, fp) ||
+	    (count > 0 && count != fwrite (records, sizeof (struct pgm_checkpoint_peer_t), count, fp)) ||
+	    0 != fflush (fp)
+#ifndef _WIN32
+	    || 0 != fsync (fileno (fp))
+#endif
+	   )
+	{
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_errno (save_errno),
+			       _("Writing checkpoint %s: %s"),
+			       tmp_path,
+			       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		if (NULL != fp) {
+			fclose (fp);
+			remove (tmp_path);
+		}
+		pgm_free (tmp_path);
+		pgm_free (records);
+		return FALSE;
+	}
+	fclose (fp);
+	pgm_free (records);
+#ifndef _WIN32
+	if (0 != rename (tmp_path, path))
+	{
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_errno (save_errno),
+			       _("Replacing checkpoint %s: %s"),
+			       path,
+			       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		remove (tmp_path);
+		pgm_free (tmp_path);
+		return FALSE;
+	}
+#else
+	if (!MoveFileExA (tmp_path, path, MOVEFILE_REPLACE_EXISTING))
+	{
+		const DWORD save_errno = GetLastError();
+		char winstr[1024];
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_win_errno (save_errno),
+			       _("Replacing checkpoint %s: %s"),
+			       path,
+			       pgm_win_strerror (winstr, sizeof (winstr), save_errno));
+		remove (tmp_path);
+		pgm_free (tmp_path);
+		return FALSE;
+	}
+#endif
+	pgm_free (tmp_path);
+	pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Checkpoint %s of %u sources."), path, count);
+	return TRUE;
+}
+
+/* load the checkpoint at path into a socket before pgm_connect(), replacing
+ * any loaded before.  sources of the checkpoint resume at the recorded
+ * sequence as they are next heard from.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error appropriately.
+ */
+
+bool
+pgm_checkpoint_restore (
+	pgm_sock_t*    const restrict sock,
+	const char*	     restrict path,
+	pgm_error_t**	     restrict error
+	)
+{
+	struct pgm_checkpoint_header_t header;
+	struct pgm_checkpoint_peer_t* records = NULL;
+	FILE* fp;
+
+	pgm_return_val_if_fail (NULL != sock, FALSE);
+	pgm_return_val_if_fail (NULL != path, FALSE);
+	if (PGM_UNLIKELY(!pgm_rwlock_writer_trylock (&sock->lock)))
+		pgm_return_val_if_reached (FALSE);
+	if (PGM_UNLIKELY(sock->is_connected || sock->is_destroyed || !sock->can_recv_data)) {
+		pgm_rwlock_writer_unlock (&sock->lock);
+		pgm_return_val_if_reached (FALSE);
+	}
+
+	fp = fopen (path, "rb");
+	if (NULL == fp) {
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_errno (save_errno),
+			       _("Opening checkpoint %s: %s"),
+			       path,
+			       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	if (1 != fread (&header, sizeof (header), 1, fp) ||
+	    PGM_CHECKPOINT_MAGIC != header.magic ||
+	    PGM_CHECKPOINT_VERSION != header.version ||
+	    sizeof (struct pgm_checkpoint_peer_t) != header.record_len ||
+	    header.count > PGM_CHECKPOINT_PEERS_MAX ||
+	    (header.count > 0 &&
+	     (NULL == (records = pgm_new (struct pgm_checkpoint_peer_t, header.count)) ||
+	      header.count != fread (records, sizeof (struct pgm_checkpoint_peer_t), header.count, fp))))
+	{
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Checkpoint %s is truncated or of another version."),
+			       path);
+		fclose (fp);
+		pgm_free (records);
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	fclose (fp);
+
+	pgm_checkpoint_free (sock);
+	sock->restore	  = records;
+	sock->restore_len = header.count;
+	pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Restoring %u sources from checkpoint %s."), header.count, path);
+	pgm_rwlock_writer_unlock (&sock->lock);
+	return TRUE;
+}
+
+/* place the receive window of a new peer found in the loaded checkpoint at
+ * the next sequence to deliver, with the FEC parameters and NAK address of the
+ * previous process.  each record restores one peer.  called by pgm_new_peer()
+ * with the peers writer lock before the window is shared.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_checkpoint_apply (
+	pgm_sock_t* const restrict sock,
+	pgm_peer_t* const restrict peer
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != peer);
+	pgm_assert (NULL != peer->window);
+
+	for (unsigned i = 0; i < sock->restore_len; i++)
+	{
+		const struct pgm_checkpoint_peer_t* record = &sock->restore[ i ];
+		if (!pgm_tsi_equal (&record->tsi, &peer->tsi))
+			continue;
+		if (record->rs_k > 1 && 0 == (record->rs_k & (record->rs_k - 1))) {
+			peer->has_proactive_parity = record->has_proactive_parity ? 1 : 0;
+			peer->has_ondemand_parity  = record->has_ondemand_parity ? 1 : 0;
+			pgm_rxw_update_fec (peer->window, record->rs_k);
+		}
+		if (AF_INET == record->nla.ss_family || AF_INET6 == record->nla.ss_family) {
+			memcpy (&peer->nla, &record->nla, sizeof (struct sockaddr_storage));
+			((struct sockaddr_in*)&peer->nla)->sin_port = pgm_htons (sock->udp_encap_ucast_port);
+		}
+		pgm_rxw_join (peer->window, record->commit_lead);
+		pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Restored %s at #%" PRIu32 " from checkpoint of #%" PRIu32 " to #%" PRIu32 "."),
+			   pgm_tsi_print (&peer->tsi), record->commit_lead, record->trail, record->lead);
+		sock->restore[ i ] = sock->restore[ --sock->restore_len ];
+		return;
+	}
+}
+
+/* release the loaded checkpoint.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_checkpoint_free (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	if (NULL == sock->restore)
+		return;
+	pgm_free (sock->restore);
+	sock->restore	  = NULL;
+	sock->restore_len = 0;
+}
+
+/* eof */
@@ -0,0 +1,602 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * unit tests for receiver state checkpoint and restore.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#	include <unistd.h>
+#endif
+#include <glib.h>
+#include <check.h>
+
+#ifdef _WIN32
+#	define PGM_CHECK_NOFORK		1
+#endif
+
+
+/* mock state */
+
+#define TEST_ENCAP_PORT		3056
+
+static unsigned		mock_join_count = 0;
+static uint32_t		mock_join_sqn = 0;
+static unsigned		mock_update_fec_count = 0;
+static uint8_t		mock_update_fec_k = 0;
+
+#define pgm_rxw_update_fec	mock_pgm_rxw_update_fec
+#define pgm_rxw_join		mock_pgm_rxw_join
+
+#define CHECKPOINT_DEBUG
+#include "checkpoint.c"
+
+PGM_GNUC_INTERNAL
+int
+pgm_get_nprocs (void)
+{
+	return 1;
+}
+
+static
+void
+mock_setup (void)
+{
+	if (!g_thread_supported ()) g_thread_init (NULL);
+	mock_join_count = mock_update_fec_count = 0;
+	mock_join_sqn = 0;
+	mock_update_fec_k = 0;
+}
+
+static
+pgm_sock_t*
+generate_sock (void)
+{
+	pgm_sock_t* sock = g_new0 (pgm_sock_t, 1);
+	pgm_rwlock_init (&sock->lock);
+	pgm_rwlock_init (&sock->peers_lock);
+	sock->can_recv_data = TRUE;
+	sock->udp_encap_ucast_port = TEST_ENCAP_PORT;
+	return sock;
+}
+
+static
+pgm_peer_t*
+generate_peer (
+	const uint8_t		sport,
+	const uint32_t		commit_lead
+	)
+{
+	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, sport };
+	pgm_peer_t* peer = g_new0 (pgm_peer_t, 1);
+	memcpy (&peer->tsi, &tsi, sizeof (pgm_tsi_t));
+	peer->window = g_new0 (pgm_rxw_t, 1);
+	peer->window->is_defined	= 1;
+	peer->window->trail		= commit_lead - 10;
+	peer->window->lead		= commit_lead + 10;
+	peer->window->commit_lead	= commit_lead;
+	struct sockaddr_in* nla = (struct sockaddr_in*)&peer->nla;
+	nla->sin_family		= AF_INET;
+	nla->sin_addr.s_addr	= inet_addr ("172.16.0.1");
+	return peer;
+}
+
+static
+void
+add_peer (
+	pgm_sock_t*		sock,
+	pgm_peer_t*		peer
+	)
+{
+	peer->peers_link.data = peer;
+	sock->peers_list = pgm_list_prepend_link (sock->peers_list, &peer->peers_link);
+}
+
+/* temporary file name, removed by the caller */
+static
+char*
+generate_path (void)
+{
+	char* path = NULL;
+	const int fd = g_file_open_tmp ("pgm-checkpoint-XXXXXX", &path, NULL);
+	fail_if (fd < 0, "g_file_open_tmp failed");
+	close (fd);
+	return path;
+}
+
+static
+void
+write_file (
+	const char*		path,
+	const void*		buf,
+	const size_t		len
+	)
+{
+	FILE* fp = fopen (path, "wb");
+	fail_if (NULL == fp, "fopen failed");
+	fail_unless (len == fwrite (buf, 1, len, fp), "fwrite failed");
+	fclose (fp);
+}
+
+static
+void
+write_checkpoint (
+	const char*		path,
+	const uint32_t		magic,
+	const uint32_t		version,
+	const uint32_t		count,
+	const unsigned		records
+	)
+{
+	const size_t len = sizeof (struct pgm_checkpoint_header_t) + records * sizeof (struct pgm_checkpoint_peer_t);
+	char* buf = g_malloc0 (len);
+	struct pgm_checkpoint_header_t* header = (struct pgm_checkpoint_header_t*)buf;
+	header->magic		= magic;
+	header->version		= version;
+	header->count		= count;
+	header->record_len	= sizeof (struct pgm_checkpoint_peer_t);
+	write_file (path, buf, len);
+	g_free (buf);
+}
+
+/* mock functions for external references */
+
+size_t
+pgm_pkt_offset (
+	const bool		can_fragment,
+	const sa_family_t	pgmcc_family	/* 0 = disable */
+	)
+{
+	return 0;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_rxw_update_fec (
+	pgm_rxw_t* const	window,
+	const uint8_t		rs_k
+	)
+{
+	g_assert (NULL != window);
+	mock_update_fec_count++;
+	mock_update_fec_k = rs_k;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_rxw_join (
+	pgm_rxw_t* const	window,
+	const uint32_t		sequence
+	)
+{
+	g_assert (NULL != window);
+	mock_join_count++;
+	mock_join_sqn = sequence;
+}
+
+
+/* target:
+ *	bool
+ *	pgm_checkpoint_save (
+ *		pgm_sock_t*	sock,
+ *		const char*	path,
+ *		pgm_error_t**	error
+ *		)
+ */
+
+/* save and restore round trip, undefined windows skipped */
+START_TEST (test_save_pass_001)
+{
+	pgm_error_t* err = NULL;
+	char* path = generate_path ();
+	pgm_sock_t* sock = generate_sock ();
+	pgm_peer_t* peer = generate_peer (100, 1000);
+	peer->window->is_fec_available	= 1;
+	peer->window->rs.k		= 8;
+	peer->has_ondemand_parity	= 1;
+	add_peer (sock, peer);
+	pgm_peer_t* undefined = generate_peer (101, 2000);
+	undefined->window->is_defined = 0;
+	add_peer (sock, undefined);
+	sock->is_connected = TRUE;
+	fail_unless (TRUE == pgm_checkpoint_save (sock, path, &err), "save failed");
+	fail_unless (NULL == err, "error raised");
+
+	pgm_sock_t* restored = generate_sock ();
+	fail_unless (TRUE == pgm_checkpoint_restore (restored, path, &err), "restore failed");
+	fail_unless (NULL == err, "error raised");
+	fail_unless (1 == restored->restore_len, "restore_len failed");
+	const struct pgm_checkpoint_peer_t* record = &restored->restore[ 0 ];
+	fail_unless (pgm_tsi_equal (&peer->tsi, &record->tsi), "tsi failed");
+	fail_unless (990 == record->trail, "trail failed");
+	fail_unless (1010 == record->lead, "lead failed");
+	fail_unless (1000 == record->commit_lead, "commit_lead failed");
+	fail_unless (8 == record->rs_k, "rs_k failed");
+	fail_unless (0 == record->has_proactive_parity, "has_proactive_parity failed");
+	fail_unless (1 == record->has_ondemand_parity, "has_ondemand_parity failed");
+	fail_unless (0 == pgm_sockaddr_cmp ((const struct sockaddr*)&peer->nla, (const struct sockaddr*)&record->nla), "nla failed");
+	g_unlink (path);
+	g_free (path);
+}
+END_TEST
+
+/* no sources */
+START_TEST (test_save_pass_002)
+{
+	pgm_error_t* err = NULL;
+	char* path = generate_path ();
+	pgm_sock_t* sock = generate_sock ();
+	sock->is_connected = TRUE;
+	fail_unless (TRUE == pgm_checkpoint_save (sock, path, &err), "save failed");
+	pgm_sock_t* restored = generate_sock ();
+	fail_unless (TRUE == pgm_checkpoint_restore (restored, path, &err), "restore failed");
+	fail_unless (0 == restored->restore_len, "restore_len failed");
+	g_unlink (path);
+	g_free (path);
+}
+END_TEST
+
+/* invalid parameters */
+START_TEST (test_save_fail_001)
+{
+	pgm_error_t* err = NULL;
+	fail_unless (FALSE == pgm_checkpoint_save (NULL, "checkpoint", &err), "save failed");
+}
+END_TEST
+
+/* unwritable path */
+START_TEST (test_save_fail_002)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = generate_sock ();
+	sock->is_connected = TRUE;
+	fail_unless (FALSE == pgm_checkpoint_save (sock, "/nonexistent/pgm/checkpoint", &err), "save failed");
+	fail_if (NULL == err, "error not raised");
+}
+END_TEST
+
+/* unconnected socket */
+START_TEST (test_save_fail_003)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = generate_sock ();
+	fail_unless (FALSE == pgm_checkpoint_save (sock, "checkpoint", &err), "save failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_checkpoint_restore (
+ *		pgm_sock_t*	sock,
+ *		const char*	path,
+ *		pgm_error_t**	error
+ *		)
+ */
+
+/* replaces a checkpoint loaded before */
+START_TEST (test_restore_pass_001)
+{
+	pgm_error_t* err = NULL;
+	char* path = generate_path ();
+	write_checkpoint (path, PGM_CHECKPOINT_MAGIC, PGM_CHECKPOINT_VERSION, 2, 2);
+	pgm_sock_t* sock = generate_sock ();
+	fail_unless (TRUE == pgm_checkpoint_restore (sock, path, &err), "restore failed");
+	fail_unless (2 == sock->restore_len, "restore_len failed");
+	write_checkpoint (path, PGM_CHECKPOINT_MAGIC, PGM_CHECKPOINT_VERSION, 1, 1);
+	fail_unless (TRUE == pgm_checkpoint_restore (sock, path, &err), "restore failed");
+	fail_unless (1 == sock->restore_len, "restore_len failed");
+	g_unlink (path);
+	g_free (path);
+}
+END_TEST
+
+/* invalid parameters */
+START_TEST (test_restore_fail_001)
+{
+	pgm_error_t* err = NULL;
+	fail_unless (FALSE == pgm_checkpoint_restore (NULL, "checkpoint", &err), "restore failed");
+}
+END_TEST
+
+/* missing file */
+START_TEST (test_restore_fail_002)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = generate_sock ();
+	fail_unless (FALSE == pgm_checkpoint_restore (sock, "/nonexistent/pgm/checkpoint", &err), "restore failed");
+	fail_if (NULL == err, "error not raised");
+	fail_unless (NULL == sock->restore, "restore set");
+}
+END_TEST
+
+/* truncated header */
+START_TEST (test_restore_fail_003)
+{
+	pgm_error_t* err = NULL;
+	char* path = generate_path ();
+	const uint32_t magic = PGM_CHECKPOINT_MAGIC;
+	write_file (path, &magic, sizeof (magic));
+	pgm_sock_t* sock = generate_sock ();
+	fail_unless (FALSE == pgm_checkpoint_restore (sock, path, &err), "restore failed");
+	fail_if (NULL == err, "error not raised");
+	fail_unless (PGM_ERROR_INVAL == err->code, "error code failed");
+	fail_unless (NULL == sock->restore, "restore set");
+	g_unlink (path);
+	g_free (path);
+}
+END_TEST
+
+/* truncated records */
+START_TEST (test_restore_fail_004)
+{
+	pgm_error_t* err = NULL;
+	char* path = generate_path ();
+	write_checkpoint (path, PGM_CHECKPOINT_MAGIC, PGM_CHECKPOINT_VERSION, 2, 1);
+	pgm_sock_t* sock = generate_sock ();
+	fail_unless (FALSE == pgm_checkpoint_restore (sock, path, &err), "restore failed");
+	fail_if (NULL == err, "error not raised");
+	fail_unless (PGM_ERROR_INVAL == err->code, "error code failed");
+	fail_unless (NULL == sock->restore, "restore set");
+	g_unlink (path);
+	g_free (path);
+}
+END_TEST
+
+/* corrupt magic */
+START_TEST (test_restore_fail_005)
+{
+	pgm_error_t* err = NULL;
+	char* path = generate_path ();
+	write_checkpoint (path, ~PGM_CHECKPOINT_MAGIC, PGM_CHECKPOINT_VERSION, 1, 1);
+	pgm_sock_t* sock = generate_sock ();
+	fail_unless (FALSE == pgm_checkpoint_restore (sock, path, &err), "restore failed");
+	fail_if (NULL == err, "error not raised");
+	fail_unless (PGM_ERROR_INVAL == err->code, "error code failed");
+	g_unlink (path);
+	g_free (path);
+}
+END_TEST
+
+/* version mismatch */
+START_TEST (test_restore_fail_006)
+{
+	pgm_error_t* err = NULL;
+	char* path = generate_path ();
+	write_checkpoint (path, PGM_CHECKPOINT_MAGIC, PGM_CHECKPOINT_VERSION + 1, 1, 1);
+	pgm_sock_t* sock = generate_sock ();
+	fail_unless (FALSE == pgm_checkpoint_restore (sock, path, &err), "restore failed");
+	fail_if (NULL == err, "error not raised");
+	fail_unless (PGM_ERROR_INVAL == err->code, "error code failed");
+	g_unlink (path);
+	g_free (path);
+}
+END_TEST
+
+/* count beyond limit */
+START_TEST (test_restore_fail_007)
+{
+	pgm_error_t* err = NULL;
+	char* path = generate_path ();
+	write_checkpoint (path, PGM_CHECKPOINT_MAGIC, PGM_CHECKPOINT_VERSION, PGM_CHECKPOINT_PEERS_MAX + 1, 1);
+	pgm_sock_t* sock = generate_sock ();
+	fail_unless (FALSE == pgm_checkpoint_restore (sock, path, &err), "restore failed");
+	fail_if (NULL == err, "error not raised");
+	g_unlink (path);
+	g_free (path);
+}
+END_TEST
+
+/* connected socket */
+START_TEST (test_restore_fail_008)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = generate_sock ();
+	sock->is_connected = TRUE;
+	fail_unless (FALSE == pgm_checkpoint_restore (sock, "checkpoint", &err), "restore failed");
+}
+END_TEST
+
+/* target:
+ *	void
+ *	pgm_checkpoint_apply (
+ *		pgm_sock_t*	sock,
+ *		pgm_peer_t*	peer
+ *		)
+ */
+
+/* recorded source joins at the next sequence to deliver */
+START_TEST (test_apply_pass_001)
+{
+	pgm_error_t* err = NULL;
+	char* path = generate_path ();
+	pgm_sock_t* sock = generate_sock ();
+	pgm_peer_t* peer = generate_peer (100, 1000);
+	peer->window->is_fec_available	= 1;
+	peer->window->rs.k		= 8;
+	peer->has_proactive_parity	= 1;
+	add_peer (sock, peer);
+	add_peer (sock, generate_peer (101, 2000));
+	sock->is_connected = TRUE;
+	fail_unless (TRUE == pgm_checkpoint_save (sock, path, &err), "save failed");
+
+	pgm_sock_t* restored = generate_sock ();
+	fail_unless (TRUE == pgm_checkpoint_restore (restored, path, &err), "restore failed");
+	fail_unless (2 == restored->restore_len, "restore_len failed");
+	pgm_peer_t* new_peer = generate_peer (100, 0);
+	memset (&new_peer->nla, 0, sizeof (new_peer->nla));
+	pgm_checkpoint_apply (restored, new_peer);
+	fail_unless (1 == mock_join_count, "rxw_join not called");
+	fail_unless (1000 == mock_join_sqn, "join sequence failed");
+	fail_unless (1 == mock_update_fec_count, "rxw_update_fec not called");
+	fail_unless (8 == mock_update_fec_k, "rs_k failed");
+	fail_unless (1 == new_peer->has_proactive_parity, "has_proactive_parity failed");
+	fail_unless (0 == new_peer->has_ondemand_parity, "has_ondemand_parity failed");
+	fail_unless (0 == pgm_sockaddr_cmp ((const struct sockaddr*)&peer->nla, (const struct sockaddr*)&new_peer->nla), "nla failed");
+	fail_unless (TEST_ENCAP_PORT == pgm_ntohs (((struct sockaddr_in*)&new_peer->nla)->sin_port), "nla port failed");
+	fail_unless (1 == restored->restore_len, "record not consumed");
+/* each record restores one peer */
+	pgm_checkpoint_apply (restored, new_peer);
+	fail_unless (1 == mock_join_count, "rxw_join called twice");
+	g_unlink (path);
+	g_free (path);
+}
+END_TEST
+
+/* unrecorded source left to the first packet */
+START_TEST (test_apply_pass_002)
+{
+	pgm_sock_t* sock = generate_sock ();
+	sock->restore = g_new0 (struct pgm_checkpoint_peer_t, 1);
+	sock->restore_len = 1;
+	pgm_peer_t* recorded = generate_peer (100, 1000);
+	memcpy (&sock->restore[ 0 ].tsi, &recorded->tsi, sizeof (pgm_tsi_t));
+	pgm_checkpoint_apply (sock, generate_peer (101, 0));
+	fail_unless (0 == mock_join_count, "rxw_join called");
+	fail_unless (1 == sock->restore_len, "record consumed");
+}
+END_TEST
+
+/* invalid transmission group size and address ignored */
+START_TEST (test_apply_pass_003)
+{
+	pgm_sock_t* sock = generate_sock ();
+	sock->restore = g_new0 (struct pgm_checkpoint_peer_t, 1);
+	sock->restore_len = 1;
+	pgm_peer_t* peer = generate_peer (100, 0);
+	memcpy (&sock->restore[ 0 ].tsi, &peer->tsi, sizeof (pgm_tsi_t));
+	sock->restore[ 0 ].commit_lead = 500;
+	sock->restore[ 0 ].rs_k = 6;
+	sock->restore[ 0 ].nla.ss_family = AF_UNSPEC;
+	pgm_checkpoint_apply (sock, peer);
+	fail_unless (1 == mock_join_count, "rxw_join not called");
+	fail_unless (500 == mock_join_sqn, "join sequence failed");
+	fail_unless (0 == mock_update_fec_count, "rxw_update_fec called");
+	fail_unless (AF_INET == peer->nla.ss_family, "nla replaced");
+	fail_unless (0 == sock->restore_len, "record not consumed");
+}
+END_TEST
+
+START_TEST (test_apply_fail_001)
+{
+	pgm_checkpoint_apply (NULL, generate_peer (100, 0));
+	fail ("reached");
+}
+END_TEST
+
+/* target:
+ *	void
+ *	pgm_checkpoint_free (
+ *		pgm_sock_t*	sock
+ *		)
+ */
+
+START_TEST (test_free_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	pgm_checkpoint_free (sock);
+	sock->restore = g_new0 (struct pgm_checkpoint_peer_t, 1);
+	sock->restore_len = 1;
+	pgm_checkpoint_free (sock);
+	fail_unless (NULL == sock->restore, "restore not released");
+	fail_unless (0 == sock->restore_len, "restore_len not reset");
+}
+END_TEST
+
+START_TEST (test_free_fail_001)
+{
+	pgm_checkpoint_free (NULL);
+	fail ("reached");
+}
+END_TEST
+
+
+static
+Suite*
+make_test_suite (void)
+{
+	Suite* s;
+
+	s = suite_create (__FILE__);
+
+	TCase* tc_save = tcase_create ("save");
+	suite_add_tcase (s, tc_save);
+	tcase_add_checked_fixture (tc_save, mock_setup, NULL);
+	tcase_add_test (tc_save, test_save_pass_001);
+	tcase_add_test (tc_save, test_save_pass_002);
+	tcase_add_test (tc_save, test_save_fail_001);
+	tcase_add_test (tc_save, test_save_fail_002);
+	tcase_add_test (tc_save, test_save_fail_003);
+
+	TCase* tc_restore = tcase_create ("restore");
+	suite_add_tcase (s, tc_restore);
+	tcase_add_checked_fixture (tc_restore, mock_setup, NULL);
+	tcase_add_test (tc_restore, test_restore_pass_001);
+	tcase_add_test (tc_restore, test_restore_fail_001);
+	tcase_add_test (tc_restore, test_restore_fail_002);
+	tcase_add_test (tc_restore, test_restore_fail_003);
+	tcase_add_test (tc_restore, test_restore_fail_004);
+	tcase_add_test (tc_restore, test_restore_fail_005);
+	tcase_add_test (tc_restore, test_restore_fail_006);
+	tcase_add_test (tc_restore, test_restore_fail_007);
+	tcase_add_test (tc_restore, test_restore_fail_008);
+
+	TCase* tc_apply = tcase_create ("apply");
+	suite_add_tcase (s, tc_apply);
+	tcase_add_checked_fixture (tc_apply, mock_setup, NULL);
+	tcase_add_test (tc_apply, test_apply_pass_001);
+	tcase_add_test (tc_apply, test_apply_pass_002);
+	tcase_add_test (tc_apply, test_apply_pass_003);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_apply, test_apply_fail_001, SIGABRT);
+#endif
+
+	TCase* tc_free = tcase_create ("free");
+	suite_add_tcase (s, tc_free);
+	tcase_add_checked_fixture (tc_free, mock_setup, NULL);
+	tcase_add_test (tc_free, test_free_pass_001);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_free, test_free_fail_001, SIGABRT);
+#endif
+	return s;
+}
+
+static
+Suite*
+make_master_suite (void)
+{
+	Suite* s = suite_create ("Master");
+	return s;
+}
+
+int
+main (void)
+{
+	SRunner* sr = srunner_create (make_master_suite ());
+	srunner_add_suite (sr, make_test_suite ());
+	srunner_run_all (sr, CK_ENV);
+	int number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* eof */
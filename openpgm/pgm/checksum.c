@@ -47,6 +47,42 @@
 #endif
 #endif
 
+/* AVX2 and AVX-512 variants are compiled with per-function target attributes
+ * and selected at run-time by pgm_checksum_init().
+ */
+#if defined(_MSC_VER) && (defined(_M_AMD64) || defined(_M_X64))
+#	define CSUM_TARGET(x)
+#	define USE_CSUM_AVX2
+#	if (_MSC_VER >= 1910)
+#		define USE_CSUM_AVX512
+#	endif
+#elif (defined(__i386__) || defined(__x86_64__)) && \
+      ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || defined(__clang__))
+#	define CSUM_TARGET(x)		__attribute__((__target__(x)))
+#	define USE_CSUM_AVX2
+#	if (__GNUC__ >= 5) || defined(__clang__)
+#		define USE_CSUM_AVX512
+#	endif
+#endif
+
+/* Advanced SIMD is architectural on AArch64, selected at run-time all the
+ * same for symmetry with the x86 variants.
+ */
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#	include <arm_neon.h>
+#	define USE_CSUM_NEON
+#endif
+
+/* CRC32C instructions, SSE4.2 selected at run-time as above, ARMv8 when the
+ * compiler targets the CRC extension.
+ */
+#if defined(USE_CSUM_AVX2)
+#	define USE_CRC32C_SSE42
+#elif defined(__ARM_FEATURE_CRC32)
+#	include <arm_acle.h>
+#	define USE_CRC32C_ARMV8
+#endif
+
 
 /* locals */
 
@@ -81,16 +117,52 @@ static uint16_t do_csum_sse41 (const void*, uint16_t, uint32_t) PGM_GNUC_PURE;
 /* SSE4a - Streaming store and combined mask-shift operation. */
 /* AVX - New three operand instructions. */
 /* AVX2 - Expands existing instructions to 256-bit operands. */
-#if defined(__AVX2__) || defined(_M_AMD64) || defined(_M_X64)
+#ifdef USE_CSUM_AVX2
 static uint16_t do_csum_avx2 (const void*, uint16_t, uint32_t) PGM_GNUC_PURE;
 #endif
 /* F16C (SSE5) - Floating point conversion. */
 /* XOP - Extended operations. including integer FMA. horizontal arithmetic. */
 /* FMA - Fused multiply-add. */
 /* AVX-512 - Adds 512-bit operands. */
+#ifdef USE_CSUM_AVX512
+static uint16_t do_csum_avx512 (const void*, uint16_t, uint32_t) PGM_GNUC_PURE;
+#endif
+/* NEON - ARM Advanced SIMD, 128-bit pairwise add and accumulate. */
+#ifdef USE_CSUM_NEON
+static uint16_t do_csum_neon (const void*, uint16_t, uint32_t) PGM_GNUC_PURE;
+static uint16_t do_csumcpy_neon (const void*restrict, void*restrict, uint16_t, uint32_t);
+#endif
+
+/* Non-temporal variants stream the destination past the cache for copies
+ * that are not read again by the processor, destination aligned.
+ */
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
+static uint16_t do_csumcpy_sse2_nt (const void*restrict, void*restrict, uint16_t, uint32_t);
+static void do_memcpy_sse2_nt (void*restrict, const void*restrict, size_t);
+#endif
+#ifdef USE_CSUM_AVX2
+static uint16_t do_csumcpy_avx2_nt (const void*restrict, void*restrict, uint16_t, uint32_t);
+static void do_memcpy_avx2_nt (void*restrict, const void*restrict, size_t);
+#endif
 
 static uint16_t (*do_csum) (const void*, uint16_t, uint32_t) = NULL;
 static uint16_t (*do_csumcpy) (const void* restrict src, void* restrict dst, uint16_t len, uint32_t csum) = NULL;
+static uint16_t (*do_csumcpy_nt) (const void* restrict src, void* restrict dst, uint16_t len, uint32_t csum) = NULL;
+static void (*do_memcpy_nt) (void* restrict dst, const void* restrict src, size_t len) = NULL;
+
+/* CRC32C of Castagnoli polynomial 0x1edc6f41, reflected */
+#define CRC32C_POLY		0x82f63b78
+
+static uint32_t do_crc32c_sw (uint32_t, const void*, size_t) PGM_GNUC_PURE;
+#ifdef USE_CRC32C_SSE42
+static uint32_t do_crc32c_sse42 (uint32_t, const void*, size_t) PGM_GNUC_PURE;
+#endif
+#ifdef USE_CRC32C_ARMV8
+static uint32_t do_crc32c_armv8 (uint32_t, const void*, size_t) PGM_GNUC_PURE;
+#endif
+
+static uint32_t (*do_crc32c) (uint32_t crc, const void* buf, size_t len) = do_crc32c_sw;
+static uint32_t crc32c_table[ 256 ];
 
 /* Explicitly protecting against alignment issues, so hush compiler. */
 #if (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 6) || defined(__clang__)
@@ -778,7 +850,7 @@ do_csumcpy_vector (
 							  "movq 5*8(%1), %%r13\n\t"
 							  "movq 6*8(%1), %%r14\n\t"
 							  "movq 7*8(%1), %%r15\n\t"
-							  "adcq %%r8, %0\n\t"		/* checksum */
+							  "addq %%r8, %0\n\t"		/* checksum, carry flag undefined on entry */
 							  "adcq %%r9, %0\n\t"
 							  "adcq %%r10, %0\n\t"
 							  "adcq %%r11, %0\n\t"
@@ -811,7 +883,8 @@ do_csumcpy_vector (
 							: "m" (*(const uint64_t*restrict)src), "r" (carry), "0" (acc)
 							: "cc"	);
 					if (carry) acc++;
-					count--; src += 8;
+					*(uint64_t*restrict)dst = *(const uint64_t*restrict)src;
+					count--; src += 8; dst += 8;
 				}
 				acc  = (acc >> 32) + (acc & 0xffffffff);
 			}
@@ -1111,10 +1184,96 @@ do_csumcpy_sse2 (
 
 		sum = _mm_add_epi32 (sum, lo);
 		sum = _mm_add_epi32 (sum, hi);
-		_mm_store_si128((__m128i*)dstbuf, tmp);
+		_mm_storeu_si128((__m128i*)dstbuf, tmp);			// dst alignment may differ from src
+		srcbuf = &srcbuf[ 16 ];
+		dstbuf = &dstbuf[ 16 ];
+	}
+
+// add all 32-bit components together
+	sum = _mm_add_epi32 (sum, _mm_srli_si128 (sum, 8));
+	sum = _mm_add_epi32 (sum, _mm_srli_si128 (sum, 4));
+	acc += _mm_cvtsi128_si32 (sum);
+	len %= 16;
+/* final 15 bytes */
+	count2 = len >> 1;
+	while (count2--) {
+		acc += ((uint16_t*restrict)dstbuf)[ 0 ] = ((const uint16_t*restrict)srcbuf)[ 0 ];
+		srcbuf = &srcbuf[ 2 ];
+		dstbuf = &dstbuf[ 2 ];
+	}
+/* trailing odd byte */
+	if (len & 1) {
+		((uint8_t*restrict)&remainder)[0] = *dstbuf = *srcbuf;
+	}
+	acc += remainder;
+	acc  = (acc >> 32) + (acc & 0xffffffff);
+	acc  = (acc >> 16) + (acc & 0xffff);
+	acc  = (acc >> 16) + (acc & 0xffff);
+	acc += (acc >> 16);
+	if (PGM_UNLIKELY(is_odd))
+		acc = ((acc & 0xff) << 8) | ((acc & 0xff00) >> 8);
+	return (uint16_t)acc;
+}
+#endif
+
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
+/* as do_csumcpy_sse2() aligned on the destination for streaming stores.
+ */
+
+static
+uint16_t
+do_csumcpy_sse2_nt (
+	const void* restrict srcaddr,
+	void* restrict	     dstaddr,
+	uint16_t	     len,
+	uint32_t	     csum
+	)
+{
+	uint64_t acc;			/* fixed size for asm */
+	const uint8_t*restrict srcbuf;
+	uint8_t*restrict dstbuf;
+	uint16_t remainder;		/* fixed size for endian swap */
+	uint_fast16_t count2;
+	uint_fast16_t count16;
+	bool is_odd;
+
+	acc = csum;
+	srcbuf = (const uint8_t*restrict)srcaddr;
+	dstbuf = (uint8_t*restrict)dstaddr;
+	remainder = 0;
+
+	if (PGM_UNLIKELY(len == 0))
+		return (uint16_t)acc;
+	pgm_prefetch (srcbuf);
+/* align first byte */
+	is_odd = ((uintptr_t)dstbuf & 1);
+	if (PGM_UNLIKELY(is_odd)) {
+		((uint8_t*restrict)&remainder)[1] = *dstbuf++ = *srcbuf++;
+		len--;
+	}
+/* drain upto 14-bytes to align on 128-bit strides */
+	count2 = ((0x10 - ((uintptr_t)dstbuf & 0xf)) & 0xf) >> 1;
+	while (len > 1 && count2--) {
+		acc += ((uint16_t*restrict)dstbuf)[ 0 ] = ((const uint16_t*restrict)srcbuf)[ 0 ];
+		srcbuf = &srcbuf[ 2 ];
+		dstbuf = &dstbuf[ 2 ];
+		len -= 2;
+	}
+/* 128-bit, 16-byte stride */
+	count16 = len >> 4;
+	__m128i sum = _mm_setzero_si128();
+	while (count16--) {
+		__m128i tmp = _mm_loadu_si128((const __m128i*)srcbuf);		// src alignment may differ from dst
+		__m128i lo = _mm_unpacklo_epi16 (tmp, _mm_setzero_si128());
+		__m128i hi = _mm_unpackhi_epi16 (tmp, _mm_setzero_si128());
+
+		sum = _mm_add_epi32 (sum, lo);
+		sum = _mm_add_epi32 (sum, hi);
+		_mm_stream_si128((__m128i*)dstbuf, tmp);
 		srcbuf = &srcbuf[ 16 ];
 		dstbuf = &dstbuf[ 16 ];
 	}
+	_mm_sfence();
 
 // add all 32-bit components together
 	sum = _mm_add_epi32 (sum, _mm_srli_si128 (sum, 8));
@@ -1141,6 +1300,42 @@ do_csumcpy_sse2 (
 		acc = ((acc & 0xff) << 8) | ((acc & 0xff00) >> 8);
 	return (uint16_t)acc;
 }
+
+static
+void
+do_memcpy_sse2_nt (
+	void* restrict	     dstaddr,
+	const void* restrict srcaddr,
+	size_t		     len
+	)
+{
+	uint8_t*restrict dstbuf = (uint8_t*restrict)dstaddr;
+	const uint8_t*restrict srcbuf = (const uint8_t*restrict)srcaddr;
+	size_t count64;
+
+/* align destination on 128-bit strides */
+	const size_t head = MIN(len, (0x10 - ((uintptr_t)dstbuf & 0xf)) & 0xf);
+	memcpy (dstbuf, srcbuf, head);
+	dstbuf = &dstbuf[ head ];
+	srcbuf = &srcbuf[ head ];
+	len -= head;
+/* 64-byte, cache line stride */
+	count64 = len >> 6;
+	while (count64--) {
+		const __m128i a = _mm_loadu_si128((const __m128i*)srcbuf);
+		const __m128i b = _mm_loadu_si128((const __m128i*)&srcbuf[ 16 ]);
+		const __m128i c = _mm_loadu_si128((const __m128i*)&srcbuf[ 32 ]);
+		const __m128i d = _mm_loadu_si128((const __m128i*)&srcbuf[ 48 ]);
+		_mm_stream_si128((__m128i*)dstbuf, a);
+		_mm_stream_si128((__m128i*)&dstbuf[ 16 ], b);
+		_mm_stream_si128((__m128i*)&dstbuf[ 32 ], c);
+		_mm_stream_si128((__m128i*)&dstbuf[ 48 ], d);
+		srcbuf = &srcbuf[ 64 ];
+		dstbuf = &dstbuf[ 64 ];
+	}
+	_mm_sfence();
+	memcpy (dstbuf, srcbuf, len & 0x3f);
+}
 #endif
 
 #if defined(__SSE3__) || defined(_M_AMD64) || defined(_M_X64)
@@ -1283,7 +1478,8 @@ do_csum_sse41 (
 }
 #endif
 
-#if defined(__AVX2__) || defined(_M_AMD64) || defined(_M_X64)
+#ifdef USE_CSUM_AVX2
+CSUM_TARGET("avx2")
 static
 uint16_t
 do_csum_avx2 (
@@ -1355,6 +1551,7 @@ do_csum_avx2 (
 	return (uint16_t)acc;
 }
 
+CSUM_TARGET("avx2")
 static
 uint16_t
 do_csumcpy_avx2 (
@@ -1409,7 +1606,7 @@ do_csumcpy_avx2 (
 
 		sum = _mm256_add_epi32 (sum, lo);
 		sum = _mm256_add_epi32 (sum, hi);
-		_mm256_store_si256((__m256i*)dstbuf, tmp);
+		_mm256_storeu_si256((__m256i*)dstbuf, tmp);		// dst alignment may differ from src
 		srcbuf = &srcbuf[ 32 ];
 		dstbuf = &dstbuf[ 32 ];
 	}
@@ -1447,19 +1644,499 @@ do_csumcpy_avx2 (
 		acc = ((acc & 0xff) << 8) | ((acc & 0xff00) >> 8);
 	return (uint16_t)acc;
 }
+
+/* as do_csumcpy_avx2() aligned on the destination for streaming stores.
+ */
+
+CSUM_TARGET("avx2")
+static
+uint16_t
+do_csumcpy_avx2_nt (
+	const void* restrict srcaddr,
+	void* restrict	     dstaddr,
+	uint16_t	     len,
+	uint32_t	     csum
+	)
+{
+	uint64_t acc;			/* fixed size for asm */
+	const uint8_t*restrict srcbuf;
+	uint8_t*restrict dstbuf;
+	uint16_t remainder;		/* fixed size for endian swap */
+	uint_fast16_t count2;
+	uint_fast16_t count32;
+	bool is_odd;
+
+	acc = csum;
+	srcbuf = (const uint8_t*restrict)srcaddr;
+	dstbuf = (uint8_t*restrict)dstaddr;
+	remainder = 0;
+
+	if (PGM_UNLIKELY(len == 0))
+		return (uint16_t)acc;
+	pgm_prefetch (srcbuf);
+/* align first byte */
+	is_odd = ((uintptr_t)dstbuf & 1);
+	if (PGM_UNLIKELY(is_odd)) {
+		((uint8_t*restrict)&remainder)[1] = *dstbuf++ = *srcbuf++;
+		len--;
+	}
+/* drain upto 30-bytes to align on 256-bit strides */
+	count2 = ((0x20 - ((uintptr_t)dstbuf & 0x1f)) & 0x1f) >> 1;
+	while (len > 1 && count2--) {
+		acc += ((uint16_t*restrict)dstbuf)[ 0 ] = ((const uint16_t*restrict)srcbuf)[ 0 ];
+		srcbuf = &srcbuf[ 2 ];
+		dstbuf = &dstbuf[ 2 ];
+		len -= 2;
+	}
+/* 256-bit, 32-byte stride */
+	count32 = len >> 5;
+	__m256i sum = _mm256_setzero_si256();
+	while (count32--) {
+		__m256i tmp = _mm256_loadu_si256((const __m256i*)srcbuf);		// src alignment may differ from dst
+		__m256i lo = _mm256_unpacklo_epi16 (tmp, _mm256_setzero_si256());
+		__m256i hi = _mm256_unpackhi_epi16 (tmp, _mm256_setzero_si256());
+
+		sum = _mm256_add_epi32 (sum, lo);
+		sum = _mm256_add_epi32 (sum, hi);
+		_mm256_stream_si256((__m256i*)dstbuf, tmp);
+		srcbuf = &srcbuf[ 32 ];
+		dstbuf = &dstbuf[ 32 ];
+	}
+	_mm_sfence();
+
+// add all 32-bit components together
+	sum = _mm256_add_epi32 (sum, _mm256_srli_si256 (sum, 8));
+	sum = _mm256_add_epi32 (sum, _mm256_srli_si256 (sum, 4));
+#ifndef _MSC_VER
+	acc += _mm256_extract_epi32 (sum, 0) + _mm256_extract_epi32 (sum, 4);
+#else
+	{
+		__m128i __Y1 = _mm256_extractf128_si256 (sum, 0 >> 2);
+		__m128i __Y2 = _mm256_extractf128_si256 (sum, 4 >> 2);
+		acc += _mm_extract_epi32 (__Y1, 0 % 4) + _mm_extract_epi32 (__Y2, 4 % 4);
+	}
+#endif
+	len %= 32;
+/* final 31 bytes */
+	count2 = len >> 1;
+	while (count2--) {
+		acc += ((uint16_t*restrict)dstbuf)[ 0 ] = ((const uint16_t*restrict)srcbuf)[ 0 ];
+		srcbuf = &srcbuf[ 2 ];
+		dstbuf = &dstbuf[ 2 ];
+	}
+/* trailing odd byte */
+	if (len & 1) {
+		((uint8_t*restrict)&remainder)[0] = *dstbuf = *srcbuf;
+	}
+	acc += remainder;
+	acc  = (acc >> 32) + (acc & 0xffffffff);
+	acc  = (acc >> 16) + (acc & 0xffff);
+	acc  = (acc >> 16) + (acc & 0xffff);
+	acc += (acc >> 16);
+	if (PGM_UNLIKELY(is_odd))
+		acc = ((acc & 0xff) << 8) | ((acc & 0xff00) >> 8);
+	return (uint16_t)acc;
+}
+
+CSUM_TARGET("avx2")
+static
+void
+do_memcpy_avx2_nt (
+	void* restrict	     dstaddr,
+	const void* restrict srcaddr,
+	size_t		     len
+	)
+{
+	uint8_t*restrict dstbuf = (uint8_t*restrict)dstaddr;
+	const uint8_t*restrict srcbuf = (const uint8_t*restrict)srcaddr;
+	size_t count64;
+
+/* align destination on 256-bit strides */
+	const size_t head = MIN(len, (0x20 - ((uintptr_t)dstbuf & 0x1f)) & 0x1f);
+	memcpy (dstbuf, srcbuf, head);
+	dstbuf = &dstbuf[ head ];
+	srcbuf = &srcbuf[ head ];
+	len -= head;
+/* 64-byte, cache line stride */
+	count64 = len >> 6;
+	while (count64--) {
+		const __m256i a = _mm256_loadu_si256((const __m256i*)srcbuf);
+		const __m256i b = _mm256_loadu_si256((const __m256i*)&srcbuf[ 32 ]);
+		_mm256_stream_si256((__m256i*)dstbuf, a);
+		_mm256_stream_si256((__m256i*)&dstbuf[ 32 ], b);
+		srcbuf = &srcbuf[ 64 ];
+		dstbuf = &dstbuf[ 64 ];
+	}
+	_mm_sfence();
+	memcpy (dstbuf, srcbuf, len & 0x3f);
+}
 #endif
 
-/* TBD: AVX-512 for Skylake and newer architectures.
- *
- *	_mm512_setzero_si512()
- *	_mm512_load_si512()		- 64-byte alignment
- *	_mm512_unpacklo_epi16()
- *	_mm512_unpackhi_epi16()
- *	_mm512_add_epi32()
- *	_mm512_srli_si512()
- *	_mm512_extract_epi32()
+/* AVX-512 for Skylake and newer architectures.  Masking and shifting each
+ * 32-bit lane into low and high 16-bit words avoids both the AVX-512BW unpack
+ * instructions and lane crossing zero extension.
  */
 
+#ifdef USE_CSUM_AVX512
+CSUM_TARGET("avx512f")
+static
+uint16_t
+do_csum_avx512 (
+	const void*	addr,
+	uint16_t	len,
+	uint32_t	csum
+	)
+{
+	uint_fast64_t acc = csum;		/* fixed size for asm */
+	const uint8_t* buf = (const uint8_t*)addr;
+	uint16_t remainder = 0;			/* fixed size for endian swap */
+	uint_fast16_t count2;
+	uint_fast16_t count64;
+	bool is_odd;
+
+	if (PGM_UNLIKELY(len == 0))
+		return (uint16_t)acc;
+/* align first byte */
+	is_odd = ((uintptr_t)buf & 1);
+	if (PGM_UNLIKELY(is_odd)) {
+		((uint8_t*)&remainder)[1] = *buf++;
+		len--;
+	}
+/* 512-bit, 64-byte stride */
+	count64 = len >> 6;
+	const __m512i mask = _mm512_set1_epi32 (0xffff);
+	__m512i sum = _mm512_setzero_si512();
+	while (count64--) {
+		__m512i tmp = _mm512_loadu_si512((const void*)buf);			// load 512-bit blob
+		__m512i lo = _mm512_and_si512 (tmp, mask);
+		__m512i hi = _mm512_srli_epi32 (tmp, 16);
+
+		sum = _mm512_add_epi32 (sum, lo);
+		sum = _mm512_add_epi32 (sum, hi);
+		buf += 64;
+	}
+
+// add all 32-bit components together
+	{
+		__m256i sum256 = _mm256_add_epi32 (_mm512_castsi512_si256 (sum), _mm512_extracti64x4_epi64 (sum, 1));
+		__m128i sum128 = _mm_add_epi32 (_mm256_castsi256_si128 (sum256), _mm256_extracti128_si256 (sum256, 1));
+		sum128 = _mm_add_epi32 (sum128, _mm_srli_si128 (sum128, 8));
+		sum128 = _mm_add_epi32 (sum128, _mm_srli_si128 (sum128, 4));
+		acc += (uint32_t)_mm_cvtsi128_si32 (sum128);
+	}
+	len %= 64;
+/* final 63 bytes */
+	count2 = len >> 1;
+	while (count2--) {
+		acc += ((const uint16_t*)buf)[ 0 ];
+		buf += 2;
+	}
+/* trailing odd byte */
+	if (len & 1) {
+		((uint8_t*)&remainder)[0] = *buf;
+	}
+	acc += remainder;
+	acc  = (acc >> 32) + (acc & 0xffffffff);
+	acc  = (acc >> 16) + (acc & 0xffff);
+	acc  = (acc >> 16) + (acc & 0xffff);
+	acc += (acc >> 16);
+	if (PGM_UNLIKELY(is_odd))
+		acc = ((acc & 0xff) << 8) | ((acc & 0xff00) >> 8);
+	return (uint16_t)acc;
+}
+
+CSUM_TARGET("avx512f")
+static
+uint16_t
+do_csumcpy_avx512 (
+	const void* restrict srcaddr,
+	void* restrict	     dstaddr,
+	uint16_t	     len,
+	uint32_t	     csum
+	)
+{
+	uint64_t acc;			/* fixed size for asm */
+	const uint8_t*restrict srcbuf;
+	uint8_t*restrict dstbuf;
+	uint16_t remainder;		/* fixed size for endian swap */
+	uint_fast16_t count2;
+	uint_fast16_t count64;
+	bool is_odd;
+
+	acc = csum;
+	srcbuf = (const uint8_t*restrict)srcaddr;
+	dstbuf = (uint8_t*restrict)dstaddr;
+	remainder = 0;
+
+	if (PGM_UNLIKELY(len == 0))
+		return (uint16_t)acc;
+	pgm_prefetch (srcbuf);
+	pgm_prefetchw (dstbuf);
+/* align first byte */
+	is_odd = ((uintptr_t)srcbuf & 1);
+	if (PGM_UNLIKELY(is_odd)) {
+		((uint8_t*restrict)&remainder)[1] = *dstbuf++ = *srcbuf++;
+		len--;
+	}
+/* drain upto 62-bytes to align on 512-bit strides, a load that splits a
+ * cache line costs more at 64 bytes than at narrower widths.
+ */
+	count2 = ((0x40 - ((uintptr_t)srcbuf & 0x3f)) & 0x3f) >> 1;
+	while (len > 1 && count2--) {
+		acc += ((uint16_t*restrict)dstbuf)[ 0 ] = ((const uint16_t*restrict)srcbuf)[ 0 ];
+		srcbuf = &srcbuf[ 2 ];
+		dstbuf = &dstbuf[ 2 ];
+		len -= 2;
+	}
+/* 512-bit, 64-byte stride */
+	count64 = len >> 6;
+	const __m512i mask = _mm512_set1_epi32 (0xffff);
+	__m512i sum = _mm512_setzero_si512();
+	while (count64--) {
+		__m512i tmp = _mm512_load_si512((const void*)srcbuf);			// load 512-bit blob
+		__m512i lo = _mm512_and_si512 (tmp, mask);
+		__m512i hi = _mm512_srli_epi32 (tmp, 16);
+
+		sum = _mm512_add_epi32 (sum, lo);
+		sum = _mm512_add_epi32 (sum, hi);
+		_mm512_storeu_si512((void*)dstbuf, tmp);		// dst alignment may differ from src
+		srcbuf = &srcbuf[ 64 ];
+		dstbuf = &dstbuf[ 64 ];
+	}
+
+// add all 32-bit components together
+	{
+		__m256i sum256 = _mm256_add_epi32 (_mm512_castsi512_si256 (sum), _mm512_extracti64x4_epi64 (sum, 1));
+		__m128i sum128 = _mm_add_epi32 (_mm256_castsi256_si128 (sum256), _mm256_extracti128_si256 (sum256, 1));
+		sum128 = _mm_add_epi32 (sum128, _mm_srli_si128 (sum128, 8));
+		sum128 = _mm_add_epi32 (sum128, _mm_srli_si128 (sum128, 4));
+		acc += (uint32_t)_mm_cvtsi128_si32 (sum128);
+	}
+	len %= 64;
+/* final 63 bytes */
+	count2 = len >> 1;
+	while (count2--) {
+		acc += ((uint16_t*restrict)dstbuf)[ 0 ] = ((const uint16_t*restrict)srcbuf)[ 0 ];
+		srcbuf = &srcbuf[ 2 ];
+		dstbuf = &dstbuf[ 2 ];
+	}
+/* trailing odd byte */
+	if (len & 1) {
+		((uint8_t*restrict)&remainder)[0] = *dstbuf = *srcbuf;
+	}
+	acc += remainder;
+	acc  = (acc >> 32) + (acc & 0xffffffff);
+	acc  = (acc >> 16) + (acc & 0xffff);
+	acc  = (acc >> 16) + (acc & 0xffff);
+	acc += (acc >> 16);
+	if (PGM_UNLIKELY(is_odd))
+		acc = ((acc & 0xff) << 8) | ((acc & 0xff00) >> 8);
+	return (uint16_t)acc;
+}
+#endif /* USE_CSUM_AVX512 */
+/* byte at a time for hosts without CRC32C instructions.
+ */
+
+static
+uint32_t
+do_crc32c_sw (
+	uint32_t	crc,
+	const void*	addr,
+	size_t		len
+	)
+{
+	const uint8_t* buf = (const uint8_t*)addr;
+	while (len--)
+		crc = crc32c_table[ (crc ^ *buf++) & 0xff ] ^ (crc >> 8);
+	return crc;
+}
+
+#ifdef USE_CRC32C_SSE42
+CSUM_TARGET("sse4.2")
+static
+uint32_t
+do_crc32c_sse42 (
+	uint32_t	crc,
+	const void*	addr,
+	size_t		len
+	)
+{
+	const uint8_t* buf = (const uint8_t*)addr;
+#	if defined(__x86_64__) || defined(_M_AMD64) || defined(_M_X64)
+	uint64_t crc64 = crc;
+	while (len >= 8) {
+		uint64_t word;
+		memcpy (&word, buf, sizeof (word));
+		crc64 = _mm_crc32_u64 (crc64, word);
+		buf += 8;
+		len -= 8;
+	}
+	crc = (uint32_t)crc64;
+#	else
+	while (len >= 4) {
+		uint32_t word;
+		memcpy (&word, buf, sizeof (word));
+		crc = _mm_crc32_u32 (crc, word);
+		buf += 4;
+		len -= 4;
+	}
+#	endif
+	while (len--)
+		crc = _mm_crc32_u8 (crc, *buf++);
+	return crc;
+}
+#endif /* USE_CRC32C_SSE42 */
+
+#ifdef USE_CRC32C_ARMV8
+static
+uint32_t
+do_crc32c_armv8 (
+	uint32_t	crc,
+	const void*	addr,
+	size_t		len
+	)
+{
+	const uint8_t* buf = (const uint8_t*)addr;
+	while (len >= 8) {
+		uint64_t word;
+		memcpy (&word, buf, sizeof (word));
+		crc = __crc32cd (crc, word);
+		buf += 8;
+		len -= 8;
+	}
+	while (len--)
+		crc = __crc32cb (crc, *buf++);
+	return crc;
+}
+#endif /* USE_CRC32C_ARMV8 */
+
+#ifdef USE_CSUM_NEON
+/* VPADAL folds each pair of 16-bit words into a 32-bit lane, no alignment is
+ * required of the loads and so only the odd leading byte is drained.  Lanes
+ * cannot overflow, 64KB adds at most 4096 × 2 × 0xffff to each.
+ */
+static
+uint16_t
+do_csum_neon (
+	const void*	addr,
+	uint16_t	len,
+	uint32_t	csum
+	)
+{
+	uint_fast64_t acc = csum;
+	const uint8_t* buf = (const uint8_t*)addr;
+	uint16_t remainder = 0;			/* fixed size for endian swap */
+	uint_fast16_t count2;
+	uint_fast16_t count32;
+	bool is_odd;
+
+	if (PGM_UNLIKELY(len == 0))
+		return (uint16_t)acc;
+/* align first byte */
+	is_odd = ((uintptr_t)buf & 1);
+	if (PGM_UNLIKELY(is_odd)) {
+		((uint8_t*)&remainder)[1] = *buf++;
+		len--;
+	}
+/* 256-bit, 32-byte stride over two accumulators */
+	count32 = len >> 5;
+	uint32x4_t sum0 = vdupq_n_u32 (0);
+	uint32x4_t sum1 = vdupq_n_u32 (0);
+	while (count32--) {
+		sum0 = vpadalq_u16 (sum0, vld1q_u16 ((const uint16_t*)buf));
+		sum1 = vpadalq_u16 (sum1, vld1q_u16 ((const uint16_t*)&buf[ 16 ]));
+		buf += 32;
+	}
+	if (len & 0x10) {
+		sum0 = vpadalq_u16 (sum0, vld1q_u16 ((const uint16_t*)buf));
+		buf += 16;
+	}
+	acc += vaddlvq_u32 (vaddq_u32 (sum0, sum1));
+	len %= 16;
+/* final 15 bytes */
+	count2 = len >> 1;
+	while (count2--) {
+		acc += ((const uint16_t*)buf)[ 0 ];
+		buf += 2;
+	}
+/* trailing odd byte */
+	if (len & 1) {
+		((uint8_t*)&remainder)[0] = *buf;
+	}
+	acc += remainder;
+	acc  = (acc >> 32) + (acc & 0xffffffff);
+	acc  = (acc >> 16) + (acc & 0xffff);
+	acc  = (acc >> 16) + (acc & 0xffff);
+	acc += (acc >> 16);
+	if (PGM_UNLIKELY(is_odd))
+		acc = ((acc & 0xff) << 8) | ((acc & 0xff00) >> 8);
+	return (uint16_t)acc;
+}
+
+static
+uint16_t
+do_csumcpy_neon (
+	const void* restrict srcaddr,
+	void* restrict	     dstaddr,
+	uint16_t	     len,
+	uint32_t	     csum
+	)
+{
+	uint_fast64_t acc = csum;
+	const uint8_t*restrict srcbuf = (const uint8_t*restrict)srcaddr;
+	uint8_t*restrict dstbuf = (uint8_t*restrict)dstaddr;
+	uint16_t remainder = 0;			/* fixed size for endian swap */
+	uint_fast16_t count2;
+	uint_fast16_t count16;
+	bool is_odd;
+
+	if (PGM_UNLIKELY(len == 0))
+		return (uint16_t)acc;
+	pgm_prefetch (srcbuf);
+	pgm_prefetchw (dstbuf);
+/* align first byte */
+	is_odd = ((uintptr_t)srcbuf & 1);
+	if (PGM_UNLIKELY(is_odd)) {
+		((uint8_t*restrict)&remainder)[1] = *dstbuf++ = *srcbuf++;
+		len--;
+	}
+/* 128-bit, 16-byte stride, destination alignment may differ from source */
+	count16 = len >> 4;
+	uint32x4_t sum = vdupq_n_u32 (0);
+	while (count16--) {
+		const uint8x16_t tmp = vld1q_u8 (srcbuf);
+		sum = vpadalq_u16 (sum, vreinterpretq_u16_u8 (tmp));
+		vst1q_u8 (dstbuf, tmp);
+		srcbuf = &srcbuf[ 16 ];
+		dstbuf = &dstbuf[ 16 ];
+	}
+	acc += vaddlvq_u32 (sum);
+	len %= 16;
+/* final 15 bytes */
+	count2 = len >> 1;
+	while (count2--) {
+		uint16_t word;
+		memcpy (&word, srcbuf, 2);
+		memcpy (dstbuf, &word, 2);
+		acc += word;
+		srcbuf = &srcbuf[ 2 ];
+		dstbuf = &dstbuf[ 2 ];
+	}
+/* trailing odd byte */
+	if (len & 1) {
+		((uint8_t*restrict)&remainder)[0] = *dstbuf = *srcbuf;
+	}
+	acc += remainder;
+	acc  = (acc >> 32) + (acc & 0xffffffff);
+	acc  = (acc >> 16) + (acc & 0xffff);
+	acc  = (acc >> 16) + (acc & 0xffff);
+	acc += (acc >> 16);
+	if (PGM_UNLIKELY(is_odd))
+		acc = ((acc & 0xff) << 8) | ((acc & 0xff00) >> 8);
+	return (uint16_t)acc;
+}
+#endif /* USE_CSUM_NEON */
+
 static
 uint16_t
 do_csum_memcpy (
@@ -1477,7 +2154,53 @@ PGM_GNUC_INTERNAL
 void
 pgm_checksum_init (const pgm_cpu_t* cpu)
 {
-#if defined(__AVX2__) || defined(_M_AMD64) || defined(_M_X64)
+/* CRC32C, independent of the checksum selection below */
+	for (unsigned i = 0; i < 256; i++) {
+		uint32_t crc = i;
+		for (unsigned j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (CRC32C_POLY & (0 - (crc & 1)));
+		crc32c_table[ i ] = crc;
+	}
+#if defined(USE_CRC32C_SSE42)
+	if (cpu->has_sse42) {
+		pgm_minor (_("Using SSE4.2 instructions for CRC32C."));
+		do_crc32c = do_crc32c_sse42;
+	} else
+		do_crc32c = do_crc32c_sw;
+#elif defined(USE_CRC32C_ARMV8)
+	pgm_minor (_("Using ARMv8 instructions for CRC32C."));
+	do_crc32c = do_crc32c_armv8;
+#else
+	do_crc32c = do_crc32c_sw;
+#endif
+
+/* non-temporal copies, independent of the checksum selection below */
+#ifdef USE_CSUM_AVX2
+	if (cpu->has_avx2) {
+		do_csumcpy_nt = do_csumcpy_avx2_nt;
+		do_memcpy_nt = do_memcpy_avx2_nt;
+	} else
+#endif
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
+	if (cpu->has_sse2) {
+		do_csumcpy_nt = do_csumcpy_sse2_nt;
+		do_memcpy_nt = do_memcpy_sse2_nt;
+	} else
+#endif
+	{
+		do_csumcpy_nt = NULL;
+		do_memcpy_nt = NULL;
+	}
+
+#ifdef USE_CSUM_AVX512
+	if (cpu->has_avx512f) {
+		pgm_minor (_("Using AVX-512 instructions for checksum."));
+		do_csum = do_csum_avx512;
+		do_csumcpy = do_csumcpy_avx512;
+		return;
+	}
+#endif
+#ifdef USE_CSUM_AVX2
 	if (cpu->has_avx2) {
 		pgm_minor (_("Using AVX2 instructions for checksum."));
 		do_csum = do_csum_avx2;
@@ -1485,7 +2208,15 @@ pgm_checksum_init (const pgm_cpu_t* cpu)
 		return;
 	}
 #endif
-#if defined(__SSE4_1_) || defined(_M_AMD64) || defined(_M_X64)
+#ifdef USE_CSUM_NEON
+	if (cpu->has_neon) {
+		pgm_minor (_("Using NEON instructions for checksum."));
+		do_csum = do_csum_neon;
+		do_csumcpy = do_csumcpy_neon;
+		return;
+	}
+#endif
+#if defined(__SSE4_1__) || defined(_M_AMD64) || defined(_M_X64)
 	if (cpu->has_sse41) {
 		pgm_minor (_("Using SSE4.1 instructions for checksum."));
 		do_csum = do_csum_sse41;
@@ -1586,6 +2317,65 @@ pgm_compat_csum_partial_copy (
 	return do_csumcpy (src, dst, len, csum);
 }
 
+/* Calculate & copy a partial PGM checksum, streaming the destination past
+ * the cache where supported.  For data not read again by the processor.
+ */
+
+uint32_t
+pgm_compat_csum_partial_copy_nt (
+	const void* restrict src,
+	void*	    restrict dst,
+	uint16_t	     len,
+	uint32_t	     csum
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != src);
+	pgm_assert (NULL != dst);
+
+	if (NULL == do_csumcpy_nt)
+		return do_csumcpy (src, dst, len, csum);
+	return do_csumcpy_nt (src, dst, len, csum);
+}
+
+/* Copy streaming the destination past the cache where supported.
+ */
+
+void
+pgm_memcpy_nt (
+	void*	    restrict dst,
+	const void* restrict src,
+	size_t		     len
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != dst);
+	pgm_assert (NULL != src);
+
+	if (NULL == do_memcpy_nt) {
+		memcpy (dst, src, len);
+		return;
+	}
+	do_memcpy_nt (dst, src, len);
+}
+
+/* CRC32C of len bytes continuing crc, zero to start, such that the CRC of
+ * concatenated buffers is computed by successive calls.
+ */
+
+uint32_t
+pgm_crc32c (
+	uint32_t	crc,
+	const void*	addr,
+	size_t		len
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != addr || 0 == len);
+
+	return ~do_crc32c (~crc, addr, len);
+}
+
 /* Fold 32 bit checksum accumulator into 16 bit final value.
  */
 
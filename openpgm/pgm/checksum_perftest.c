@@ -88,6 +88,9 @@ pgm_transport_pkt_offset2 (
 #define CHECKSUM_DEBUG
 #include "checksum.c"
 
+/* run-time detected variants are skipped on older processors */
+static pgm_cpu_t perf_cpu;
+
 PGM_GNUC_INTERNAL
 int
 pgm_get_nprocs (void)
@@ -100,6 +103,7 @@ void
 mock_setup (void)
 {
 	g_assert (pgm_time_init (NULL));
+	pgm_cpuid (&perf_cpu);
 }
 
 static
@@ -880,10 +884,12 @@ START_TEST (test_sse41_memcpy)
 END_TEST
 #endif
 
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 START_TEST (test_avx2)
 {
 	const unsigned iterations = 1000;
+	if (!perf_cpu.has_avx2)
+		return;
 	char* source = alloca (perf_testsize);
 	for (unsigned i = 0, j = 0; i < perf_testsize; i++) {
 		j = j * 1103515245 + 12345;
@@ -913,6 +919,8 @@ END_TEST
 START_TEST (test_avx2_memcpy)
 {
 	const unsigned iterations = 1000;
+	if (!perf_cpu.has_avx2)
+		return;
 	char* source = alloca (perf_testsize);
 	char* target = alloca (perf_testsize);
 	for (unsigned i = 0, j = 0; i < perf_testsize; i++) {
@@ -944,6 +952,8 @@ END_TEST
 START_TEST (test_avx2_csumcpy)
 {
 	const unsigned iterations = 1000;
+	if (!perf_cpu.has_avx2)
+		return;
 	char* source = alloca (perf_testsize);
 	char* target = alloca (perf_testsize);
 	for (unsigned i = 0, j = 0; i < perf_testsize; i++) {
@@ -972,6 +982,104 @@ START_TEST (test_avx2_csumcpy)
 END_TEST
 #endif
 
+#ifdef USE_CSUM_AVX512
+START_TEST (test_avx512)
+{
+	const unsigned iterations = 1000;
+	if (!perf_cpu.has_avx512f)
+		return;
+	char* source = alloca (perf_testsize);
+	for (unsigned i = 0, j = 0; i < perf_testsize; i++) {
+		j = j * 1103515245 + 12345;
+		source[i] = j;
+	}
+	const guint16 answer = perf_answer;		/* network order */
+
+	guint16 csum;
+	pgm_time_t start, check;
+
+	start = pgm_time_update_now();
+	for (unsigned i = iterations; i; i--) {
+		csum = ~do_csum_avx512 (source, perf_testsize, 0);
+/* function calculates answer in host order */
+		csum = g_htons (csum);
+		fail_unless (answer == csum, "checksum mismatch 0x%04x (0x%04x)", csum, answer);
+	}
+
+	check = pgm_time_update_now();
+	g_message ("avx512/%u: elapsed time %" PGM_TIME_FORMAT " us, unit time %" PGM_TIME_FORMAT " us",
+		perf_testsize,
+		(guint64)(check - start),
+		(guint64)((check - start) / iterations));
+}
+END_TEST
+
+START_TEST (test_avx512_memcpy)
+{
+	const unsigned iterations = 1000;
+	if (!perf_cpu.has_avx512f)
+		return;
+	char* source = alloca (perf_testsize);
+	char* target = alloca (perf_testsize);
+	for (unsigned i = 0, j = 0; i < perf_testsize; i++) {
+		j = j * 1103515245 + 12345;
+		source[i] = j;
+	}
+	const guint16 answer = perf_answer;		/* network order */
+
+	guint16 csum;
+	pgm_time_t start, check;
+
+	start = pgm_time_update_now();
+	for (unsigned i = iterations; i; i--) {
+		memcpy (target, source, perf_testsize);
+		csum = ~do_csum_avx512 (target, perf_testsize, 0);
+/* function calculates answer in host order */
+		csum = g_htons (csum);
+		fail_unless (answer == csum, "checksum mismatch 0x%04x (0x%04x)", csum, answer);
+	}
+
+	check = pgm_time_update_now();
+	g_message ("avx512/%u: elapsed time %" PGM_TIME_FORMAT " us, unit time %" PGM_TIME_FORMAT " us",
+		perf_testsize,
+		(guint64)(check - start),
+		(guint64)((check - start) / iterations));
+}
+END_TEST
+
+START_TEST (test_avx512_csumcpy)
+{
+	const unsigned iterations = 1000;
+	if (!perf_cpu.has_avx512f)
+		return;
+	char* source = alloca (perf_testsize);
+	char* target = alloca (perf_testsize);
+	for (unsigned i = 0, j = 0; i < perf_testsize; i++) {
+		j = j * 1103515245 + 12345;
+		source[i] = j;
+	}
+	const guint16 answer = perf_answer;		/* network order */
+
+	guint16 csum;
+	pgm_time_t start, check;
+
+	start = pgm_time_update_now();
+	for (unsigned i = iterations; i; i--) {
+		csum = ~do_csumcpy_avx512 (source, target, perf_testsize, 0);
+/* function calculates answer in host order */
+		csum = g_htons (csum);
+		fail_unless (answer == csum, "checksum mismatch 0x%04x (0x%04x)", csum, answer);
+	}
+
+	check = pgm_time_update_now();
+	g_message ("avx512/%u: elapsed time %" PGM_TIME_FORMAT " us, unit time %" PGM_TIME_FORMAT " us",
+		perf_testsize,
+		(guint64)(check - start),
+		(guint64)((check - start) / iterations));
+}
+END_TEST
+#endif
+
 static
 Suite*
 make_csum_performance_suite (void)
@@ -1003,9 +1111,12 @@ make_csum_performance_suite (void)
 #ifdef __SSE4_1__
 	tcase_add_test (tc_100b, test_sse41);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_100b, test_avx2);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_100b, test_avx512);
+#endif
 
 	TCase* tc_200b = tcase_create ("200b");
 	suite_add_tcase (s, tc_200b);
@@ -1030,9 +1141,12 @@ make_csum_performance_suite (void)
 #ifdef __SSE4_1__
 	tcase_add_test (tc_200b, test_sse41);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_200b, test_avx2);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_200b, test_avx512);
+#endif
 
 	TCase* tc_1500b = tcase_create ("1500b");
 	suite_add_tcase (s, tc_1500b);
@@ -1057,9 +1171,12 @@ make_csum_performance_suite (void)
 #ifdef __SSE4_1__
 	tcase_add_test (tc_1500b, test_sse41);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_1500b, test_avx2);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_1500b, test_avx512);
+#endif
 
 	TCase* tc_9kb = tcase_create ("9KB");
 	suite_add_tcase (s, tc_9kb);
@@ -1084,9 +1201,12 @@ make_csum_performance_suite (void)
 #ifdef __SSE4_1__
 	tcase_add_test (tc_9kb, test_sse41);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_9kb, test_avx2);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_9kb, test_avx512);
+#endif
 
 	TCase* tc_64kb = tcase_create ("64KB");
 	suite_add_tcase (s, tc_64kb);
@@ -1111,9 +1231,12 @@ make_csum_performance_suite (void)
 #ifdef __SSE4_1__
 	tcase_add_test (tc_64kb, test_sse41);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_64kb, test_avx2);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_64kb, test_avx512);
+#endif
 
 	return s;
 }
@@ -1149,9 +1272,12 @@ make_csum_memcpy_performance_suite (void)
 #ifdef __SSE4_1__
 	tcase_add_test (tc_100b, test_sse41_memcpy);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_100b, test_avx2_memcpy);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_100b, test_avx512_memcpy);
+#endif
 
 	TCase* tc_200b = tcase_create ("200b");
 	suite_add_tcase (s, tc_200b);
@@ -1176,9 +1302,12 @@ make_csum_memcpy_performance_suite (void)
 #ifdef __SSE4_1__
 	tcase_add_test (tc_200b, test_sse41_memcpy);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_200b, test_avx2_memcpy);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_200b, test_avx512_memcpy);
+#endif
 
 	TCase* tc_1500b = tcase_create ("1500b");
 	suite_add_tcase (s, tc_1500b);
@@ -1203,9 +1332,12 @@ make_csum_memcpy_performance_suite (void)
 #ifdef __SSE4_1__
 	tcase_add_test (tc_1500b, test_sse41_memcpy);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_1500b, test_avx2_memcpy);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_1500b, test_avx512_memcpy);
+#endif
 
 	TCase* tc_9kb = tcase_create ("9KB");
 	suite_add_tcase (s, tc_9kb);
@@ -1230,9 +1362,12 @@ make_csum_memcpy_performance_suite (void)
 #ifdef __SSE4_1__
 	tcase_add_test (tc_9kb, test_sse41_memcpy);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_9kb, test_avx2_memcpy);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_9kb, test_avx512_memcpy);
+#endif
 
 	TCase* tc_64kb = tcase_create ("64KB");
 	suite_add_tcase (s, tc_64kb);
@@ -1257,9 +1392,12 @@ make_csum_memcpy_performance_suite (void)
 #ifdef __SSE4_1__
 	tcase_add_test (tc_64kb, test_sse41_memcpy);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_64kb, test_avx2_memcpy);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_64kb, test_avx512_memcpy);
+#endif
 
 	return s;
 }
@@ -1289,9 +1427,12 @@ make_csumcpy_performance_suite (void)
 #ifdef __SSE2__
 	tcase_add_test (tc_100b, test_sse2_csumcpy);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_100b, test_avx2_csumcpy);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_100b, test_avx512_csumcpy);
+#endif
 
 	TCase* tc_200b = tcase_create ("200b");
 	suite_add_tcase (s, tc_200b);
@@ -1310,9 +1451,12 @@ make_csumcpy_performance_suite (void)
 #ifdef __SSE2__
 	tcase_add_test (tc_200b, test_sse2_csumcpy);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_200b, test_avx2_csumcpy);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_200b, test_avx512_csumcpy);
+#endif
 
 	TCase* tc_1500b = tcase_create ("1500b");
 	suite_add_tcase (s, tc_1500b);
@@ -1331,9 +1475,12 @@ make_csumcpy_performance_suite (void)
 #ifdef __SSE2__
 	tcase_add_test (tc_1500b, test_sse2_csumcpy);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_1500b, test_avx2_csumcpy);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_1500b, test_avx512_csumcpy);
+#endif
 
 	TCase* tc_9kb = tcase_create ("9KB");
 	suite_add_tcase (s, tc_9kb);
@@ -1352,9 +1499,12 @@ make_csumcpy_performance_suite (void)
 #ifdef __SSE2__
 	tcase_add_test (tc_9kb, test_sse2_csumcpy);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_9kb, test_avx2_csumcpy);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_9kb, test_avx512_csumcpy);
+#endif
 
 	TCase* tc_64kb = tcase_create ("64KB");
 	suite_add_tcase (s, tc_64kb);
@@ -1373,9 +1523,12 @@ make_csumcpy_performance_suite (void)
 #ifdef __SSE2__
 	tcase_add_test (tc_64kb, test_sse2_csumcpy);
 #endif
-#ifdef __AVX2__
+#ifdef USE_CSUM_AVX2
 	tcase_add_test (tc_64kb, test_avx2_csumcpy);
 #endif
+#ifdef USE_CSUM_AVX512
+	tcase_add_test (tc_64kb, test_avx512_csumcpy);
+#endif
 
 	return s;
 }
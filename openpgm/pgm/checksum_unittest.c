@@ -64,6 +64,18 @@ mock_setup (void)
 	do_csumcpy = do_csum_memcpy;
 }
 
+/* streaming kernels where compiled, regardless of the host processor */
+static
+void
+mock_setup_nt (void)
+{
+	mock_setup();
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
+	do_csumcpy_nt = do_csumcpy_sse2_nt;
+	do_memcpy_nt = do_memcpy_sse2_nt;
+#endif
+}
+
 /* target:
  *	uint16_t
  *	pgm_inet_checksum (
@@ -210,6 +222,42 @@ START_TEST (test_partial_copy_fail_001)
 }
 END_TEST
 
+/* target:
+ *	guint32
+ *	pgm_csum_partial_copy_nt (
+ *		const void*		src,
+ *		void*			dst,
+ *		guint16			len,
+ *		guint32			csum
+ *	)
+ */
+
+START_TEST (test_partial_copy_nt_pass_001)
+{
+	char source[4096 + 64], dest[4096 + 64], compare[4096 + 64];
+	for (unsigned i = 0; i < sizeof(source); i++)
+		source[i] = (char)(i * 7);
+/* unaligned source, odd and even destination offsets */
+	for (unsigned offset = 0; offset < 34; offset++) {
+		memset (dest, 0, sizeof(dest));
+		const guint32 csum_copy = pgm_csum_partial_copy_nt (source + 3, dest + offset, 4096, 0);
+		const guint32 csum_dest = pgm_csum_partial (dest + offset, 4096, 0);
+		fail_unless (0 == memcmp (source + 3, dest + offset, 4096), "copy mismatch in partial-copy-nt");
+		fail_unless (pgm_csum_fold (csum_copy) == pgm_csum_fold (csum_dest), "checksum mismatch in partial-copy-nt");
+		memset (compare, 0, sizeof(compare));
+		pgm_memcpy_nt (compare + offset, source + 3, 4096);
+		fail_unless (0 == memcmp (dest, compare, sizeof(dest)), "copy mismatch in memcpy-nt");
+	}
+}
+END_TEST
+
+START_TEST (test_partial_copy_nt_fail_001)
+{
+	pgm_csum_partial_copy_nt (NULL, NULL, 0, 0);
+	fail ("reached");
+}
+END_TEST
+
 /* target:
  *	guint32
  *	pgm_csum_block_add (
@@ -281,6 +329,14 @@ make_test_suite (void)
 #ifndef PGM_CHECK_NOFORK
 	tcase_add_test_raise_signal (tc_partial_copy, test_partial_copy_fail_001, SIGABRT);
 #endif
+
+	TCase* tc_partial_copy_nt = tcase_create ("partial-copy-nt");
+	suite_add_tcase (s, tc_partial_copy_nt);
+	tcase_add_checked_fixture (tc_partial_copy_nt, mock_setup_nt, NULL);
+	tcase_add_test (tc_partial_copy_nt, test_partial_copy_nt_pass_001);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_partial_copy_nt, test_partial_copy_nt_fail_001, SIGABRT);
+#endif
 	return s;
 }
 
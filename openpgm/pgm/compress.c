@@ -0,0 +1,111 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * APDU compression, LZ4 block format.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+#include <limits.h>
+#ifdef HAVE_LZ4_H
+#	include <lz4.h>
+#endif
+#include <impl/framework.h>
+
+
+//#define COMPRESS_DEBUG
+
+
+/* returns TRUE if built with LZ4.
+ */
+
+bool
+pgm_compress_is_available (void)
+{
+#ifdef PGM_HAVE_LZ4
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+/* compress src into dst as one LZ4 block of at most dst_len bytes, with
+ * acceleration trading ratio for speed from 1.
+ *
+ * returns compressed length, or 0 when the block does not fit dst_len, such
+ * that a dst_len shorter than src_len only compresses with a saving.
+ */
+
+size_t
+pgm_compress (
+	const void* restrict	src,
+	const size_t		src_len,
+	void*	    restrict	dst,
+	const size_t		dst_len,
+	const int		acceleration
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != src);
+	pgm_assert (NULL != dst);
+	pgm_assert_cmpint (acceleration, >, 0);
+
+#ifdef PGM_HAVE_LZ4
+	if (PGM_UNLIKELY(src_len > INT_MAX || 0 == dst_len))
+		return 0;
+	const int compressed_len = LZ4_compress_fast (src, dst, (int)src_len, (int)MIN(dst_len, INT_MAX), acceleration);
+	return compressed_len > 0 ? (size_t)compressed_len : 0;
+#else
+	(void)src_len;
+	(void)dst_len;
+	return 0;
+#endif
+}
+
+/* decompress one LZ4 block of src_len bytes into exactly dst_len bytes.
+ *
+ * returns TRUE on success, returns FALSE on a malformed block or a length
+ * other than dst_len.
+ */
+
+bool
+pgm_decompress (
+	const void* restrict	src,
+	const size_t		src_len,
+	void*	    restrict	dst,
+	const size_t		dst_len
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != src);
+	pgm_assert (NULL != dst);
+
+#ifdef PGM_HAVE_LZ4
+	if (PGM_UNLIKELY(src_len > INT_MAX || dst_len > INT_MAX))
+		return FALSE;
+	const int decompressed_len = LZ4_decompress_safe (src, dst, (int)src_len, (int)dst_len);
+	return (decompressed_len >= 0 && (size_t)decompressed_len == dst_len);
+#else
+	(void)src_len;
+	(void)dst_len;
+	return FALSE;
+#endif
+}
+
+/* eof */
@@ -33,14 +33,21 @@
 //#define CPU_DEBUG
 
 
-#ifndef _MSC_VER
+#if !defined(_MSC_VER) && (defined(__i386__) || defined(__x86_64__))
 static
 void
 __cpuidex (int cpu_info[4], int function_id, int subfunction_id) {
   __asm__ volatile (
+#if defined(__x86_64__)
+// preserve all of %rbx, a 32-bit exchange would zero the upper half.
+    "mov %%rbx, %%rdi\n"
+    "cpuid\n"
+    "xchg %%rdi, %%rbx\n"
+#else
     "mov %%ebx, %%edi\n"
     "cpuid\n"
     "xchg %%edi, %%ebx\n"
+#endif
     : "=a"(cpu_info[0]), "=D"(cpu_info[1]), "=c"(cpu_info[2]), "=d"(cpu_info[3])
     : "a"(function_id), "c"(subfunction_id)
   );
@@ -60,6 +67,42 @@ _xgetbv(uint32_t xcr) {
 
 
 #if defined(__i386__) || defined(__x86_64__)
+/* TSC frequency from the time stamp counter and core crystal clock leaf, the
+ * processor frequency leaf, or the timing leaf of a hypervisor.
+ */
+static
+uint32_t
+tsc_khz_from_cpuid (
+	const int	num_ids,
+	const bool	is_hypervisor
+	)
+{
+	int cpu_info[4] = {0};
+	if (num_ids >= 0x15) {
+		__cpuidex (cpu_info, 0x15, 0x0);
+		const uint32_t denominator = (uint32_t)cpu_info[0];
+		const uint32_t numerator   = (uint32_t)cpu_info[1];
+		const uint32_t crystal_hz  = (uint32_t)cpu_info[2];
+		if (0 != denominator && 0 != numerator && 0 != crystal_hz)
+			return (uint32_t)((uint64_t)crystal_hz * numerator / denominator / 1000);
+	}
+/* base frequency equals the TSC frequency where the crystal is not enumerated */
+	if (num_ids >= 0x16) {
+		__cpuidex (cpu_info, 0x16, 0x0);
+		const uint32_t base_mhz = (uint32_t)cpu_info[0] & 0xffff;
+		if (0 != base_mhz)
+			return base_mhz * 1000;
+	}
+	if (is_hypervisor) {
+		__cpuidex (cpu_info, 0x40000000, 0x0);
+		if ((uint32_t)cpu_info[0] >= 0x40000010) {
+			__cpuidex (cpu_info, 0x40000010, 0x0);
+			return (uint32_t)cpu_info[0];
+		}
+	}
+	return 0;
+}
+
 PGM_GNUC_INTERNAL
 void
 pgm_cpuid (pgm_cpu_t* cpu)
@@ -93,6 +136,23 @@ pgm_cpuid (pgm_cpu_t* cpu)
 			(cpu_info[2] & 0x08000000) != 0 /* OSXSAVE */ &&
 			(_xgetbv(0) & 6) == 6 /* XSAVE enabled by kernel */;
 	cpu->has_avx2 = cpu->has_avx && (cpu_info7[1] & 0x00000020) != 0;
+	cpu->has_avx512f = cpu->has_avx &&
+			(_xgetbv(0) & 0xe6) == 0xe6 /* opmask and ZMM state enabled by kernel */ &&
+			(cpu_info7[1] & 0x00010000) != 0;
+	cpu->has_avx512bw = cpu->has_avx512f && (cpu_info7[1] & 0x40000000) != 0;
+	cpu->has_gfni = (cpu_info7[2] & 0x00000100) != 0;
+	cpu->signature = (uint32_t)cpu_info[0];
+	cpu->tsc_khz = tsc_khz_from_cpuid (num_ids, (cpu_info[2] & 0x80000000) != 0);
+}
+#elif defined(__aarch64__)
+/* Advanced SIMD is mandatory in the AArch64 procedure call standard.
+ */
+PGM_GNUC_INTERNAL
+void
+pgm_cpuid (pgm_cpu_t* cpu)
+{
+	memset (cpu, 0, sizeof (pgm_cpu_t));
+	cpu->has_neon = TRUE;
 }
 #else
 PGM_GNUC_INTERNAL
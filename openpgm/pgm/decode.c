@@ -0,0 +1,356 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Reed-Solomon reconstruction of receive transmission groups on a pool of
+ * worker threads.
+ *
+ * The receiving thread prepares a transmission group exactly as for inline
+ * reconstruction and queues it to one decoder thread, chosen by receive
+ * window such that the groups of one source tend to stay on one thread.  An
+ * idle decoder thread takes work from the oldest end of the other queues.
+ * Completed groups are collected by the receiving thread of the window in
+ * submission order, so every window gets its reconstructed packets back in
+ * sequence whichever thread decoded them.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/decode.h>
+
+
+//#define DECODE_DEBUG
+
+#ifndef DECODE_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+struct pgm_decode_worker_t {
+#ifndef _WIN32
+	pthread_t		thread;
+#else
+	HANDLE			thread;
+#endif
+	struct pgm_decode_pool_t* pool;
+	pgm_spinlock_t		lock;			/* queue */
+	unsigned		head;
+	unsigned		len;
+	struct pgm_decode_job_t* jobs[ PGM_DECODE_QUEUE_MAX ];
+	pgm_rs_t		rs;			/* recovery matrices of this thread */
+};
+
+struct pgm_decode_pool_t {
+	pgm_sock_t*		sock;
+	pgm_mutex_t		mutex;
+	pgm_cond_t		cond;
+	bool			is_terminated;
+	unsigned		pending;		/* queued jobs of all workers */
+	unsigned		len;
+	struct pgm_decode_worker_t workers[];
+};
+
+static
+#ifndef _WIN32
+void*
+#else
+unsigned
+__stdcall
+#endif
+decode_routine (void*);
+
+/* start count decoder threads, called by pgm_bind().
+ *
+ * returns the pool on success, or NULL if no thread can be created and
+ * parity remains decoded by the receiving thread.
+ */
+
+PGM_GNUC_INTERNAL
+struct pgm_decode_pool_t*
+pgm_decode_pool_create (
+	pgm_sock_t* const	sock,
+	const unsigned		count
+	)
+{
+	struct pgm_decode_pool_t* pool;
+	unsigned started = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (count > 0 && count <= PGM_DECODE_THREADS_MAX);
+
+	pool = pgm_malloc0 (sizeof (struct pgm_decode_pool_t) + count * sizeof (struct pgm_decode_worker_t));
+	pool->sock = sock;
+	pool->len  = count;
+	pgm_mutex_init (&pool->mutex);
+	pgm_cond_init (&pool->cond);
+	for (unsigned i = 0; i < count; i++) {
+		struct pgm_decode_worker_t* worker = &pool->workers[ i ];
+		worker->pool = pool;
+		pgm_spinlock_init (&worker->lock);
+	}
+
+	for (unsigned i = 0; i < count; i++) {
+		struct pgm_decode_worker_t* worker = &pool->workers[ i ];
+#ifndef _WIN32
+		const int status = pthread_create (&worker->thread, NULL, &decode_routine, worker);
+		if (0 != status)
+			break;
+#else
+		worker->thread = (HANDLE)_beginthreadex (NULL, 0, &decode_routine, worker, 0, NULL);
+		if (0 == worker->thread)
+			break;
+#endif /* _WIN32 */
+		started++;
+	}
+
+/* queues of threads that failed to start are never filled */
+	if (0 == started) {
+		pgm_trace (PGM_LOG_ROLE_FEC,_("Creating FEC decoder threads failed, parity remains decoded on the receiving thread."));
+		for (unsigned i = 0; i < count; i++)
+			pgm_spinlock_free (&pool->workers[ i ].lock);
+		pgm_cond_free (&pool->cond);
+		pgm_mutex_free (&pool->mutex);
+		pgm_free (pool);
+		return NULL;
+	}
+	if (started < count)
+		pgm_trace (PGM_LOG_ROLE_FEC,_("Started %u of %u FEC decoder threads."), started, count);
+	pool->len = started;
+	return pool;
+}
+
+/* stop the decoder threads, jobs still queued are completed without decoding
+ * such that windows waiting on them can release them.  called by pgm_close()
+ * after the peers are destroyed.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_decode_pool_destroy (
+	struct pgm_decode_pool_t* const	pool
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != pool);
+
+	pgm_mutex_lock (&pool->mutex);
+	pool->is_terminated = TRUE;
+	pgm_cond_broadcast (&pool->cond);
+	pgm_mutex_unlock (&pool->mutex);
+
+	for (unsigned i = 0; i < pool->len; i++) {
+		struct pgm_decode_worker_t* worker = &pool->workers[ i ];
+#ifndef _WIN32
+		pthread_join (worker->thread, NULL);
+#else
+		WaitForSingleObject (worker->thread, INFINITE);
+		CloseHandle (worker->thread);
+#endif
+	}
+
+	for (unsigned i = 0; i < pool->len; i++) {
+		struct pgm_decode_worker_t* worker = &pool->workers[ i ];
+		while (worker->len > 0) {
+			struct pgm_decode_job_t* job = worker->jobs[ worker->head ];
+			worker->head = (worker->head + 1) % PGM_DECODE_QUEUE_MAX;
+			worker->len--;
+			pgm_atomic_inc32 (&job->is_done);
+		}
+		if (NULL != worker->rs.GM)
+			pgm_rs_destroy (&worker->rs);
+		pgm_spinlock_free (&worker->lock);
+	}
+	pgm_cond_free (&pool->cond);
+	pgm_mutex_free (&pool->mutex);
+	pgm_free (pool);
+}
+
+/* queue a prepared transmission group on the decoder thread selected by hint,
+ * or the next with room.
+ *
+ * returns TRUE on success, returns FALSE if all queues are full or the pool
+ * is stopping, and the job is left to the caller.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_decode_pool_submit (
+	struct pgm_decode_pool_t* const restrict pool,
+	struct pgm_decode_job_t*  const restrict job,
+	const uintptr_t				 hint
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != pool);
+	pgm_assert (NULL != job);
+
+	if (PGM_UNLIKELY(pool->is_terminated))
+		return FALSE;
+
+	for (unsigned i = 0; i < pool->len; i++) {
+		struct pgm_decode_worker_t* worker = &pool->workers[ (hint + i) % pool->len ];
+		pgm_spinlock_lock (&worker->lock);
+		if (worker->len < PGM_DECODE_QUEUE_MAX) {
+			worker->jobs[ (worker->head + worker->len++) % PGM_DECODE_QUEUE_MAX ] = job;
+			pgm_spinlock_unlock (&worker->lock);
+			pgm_mutex_lock (&pool->mutex);
+			pool->pending++;
+			pgm_cond_signal (&pool->cond);
+			pgm_mutex_unlock (&pool->mutex);
+			return TRUE;
+		}
+		pgm_spinlock_unlock (&worker->lock);
+	}
+	return FALSE;
+}
+
+/* restore the pending notification after the receiver cleared it while
+ * completed transmission groups remain uncollected.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_decode_pool_rearm (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	for (unsigned i = 0; i < sock->rx_shard_len; i++) {
+		if (0 != pgm_atomic_read32 (&sock->rx_shard[ i ].decode_ready)) {
+			pgm_notify_send (&sock->pending_notify);
+			sock->is_pending_read = TRUE;
+			return;
+		}
+	}
+}
+
+/* take the oldest job of the worker's own queue, else steal the oldest job of
+ * another queue.
+ *
+ * returns job or NULL if every queue is empty.
+ */
+
+static
+struct pgm_decode_job_t*
+decode_take (
+	struct pgm_decode_worker_t* const	worker
+	)
+{
+	struct pgm_decode_pool_t* pool = worker->pool;
+	const unsigned self = (unsigned)(worker - pool->workers);
+
+	for (unsigned i = 0; i < pool->len; i++) {
+		struct pgm_decode_worker_t* victim = &pool->workers[ (self + i) % pool->len ];
+		struct pgm_decode_job_t* job = NULL;
+		pgm_spinlock_lock (&victim->lock);
+		if (victim->len > 0) {
+			job = victim->jobs[ victim->head ];
+			victim->head = (victim->head + 1) % PGM_DECODE_QUEUE_MAX;
+			victim->len--;
+		}
+		pgm_spinlock_unlock (&victim->lock);
+		if (NULL != job)
+			return job;
+	}
+	return NULL;
+}
+
+static
+void
+decode_job (
+	struct pgm_decode_worker_t* const restrict worker,
+	struct pgm_decode_job_t*    const restrict job
+	)
+{
+	volatile uint32_t* ready = job->ready;
+
+	if (worker->rs.n != job->n || worker->rs.k != job->k) {
+		if (NULL != worker->rs.GM)
+			pgm_rs_destroy (&worker->rs);
+		pgm_rs_create (&worker->rs, job->n, job->k);
+	}
+	pgm_rs_decode_parity_appended (&worker->rs,
+				       job->data,
+				       job->offsets,
+				       job->parity_length);
+	if (job->is_op_encoded)
+		pgm_rs_decode_parity_appended (&worker->rs,
+					       job->opts,
+					       job->offsets,
+					       sizeof(struct pgm_opt_fragment));
+
+/* the job belongs to the receiving thread once done */
+	pgm_atomic_inc32 (&job->is_done);
+	if (NULL != ready && 0 == pgm_atomic_exchange_and_add32 (ready, 1)) {
+/* readiness of the receiver, re-checked by the receiver after clearing */
+		pgm_notify_send (&worker->pool->sock->pending_notify);
+		worker->pool->sock->is_pending_read = TRUE;
+	}
+}
+
+static
+#ifndef _WIN32
+void*
+#else
+unsigned
+__stdcall
+#endif
+decode_routine (
+	void*		arg
+	)
+{
+	struct pgm_decode_worker_t* worker = arg;
+	struct pgm_decode_pool_t* pool = worker->pool;
+
+	if (pool->sock->numa_node >= 0)
+		pgm_numa_bind_thread (pool->sock->numa_node);
+	pgm_thread_setup ("decode");
+	pgm_mutex_lock (&pool->mutex);
+	for (;;)
+	{
+		while (0 == pool->pending && !pool->is_terminated)
+#ifndef _WIN32
+			pgm_cond_wait (&pool->cond, &pool->mutex.pthread_mutex);
+#else
+			pgm_cond_wait (&pool->cond, &pool->mutex.win32_crit);
+#endif
+		if (pool->is_terminated)
+			break;
+		pool->pending--;
+		pgm_mutex_unlock (&pool->mutex);
+		struct pgm_decode_job_t* job = decode_take (worker);
+		if (PGM_LIKELY(NULL != job))
+			decode_job (worker, job);
+		pgm_mutex_lock (&pool->mutex);
+	}
+	pgm_mutex_unlock (&pool->mutex);
+
+#ifndef _WIN32
+	return NULL;
+#else
+	_endthread();
+	return 0;
+#endif
+}
+
+/* eof */
@@ -0,0 +1,364 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * receive socket shared by PGM sockets, demultiplexed by port and GSI.
+ *
+ * A raw PGM socket receives every PGM packet arriving at the host, such that
+ * each PGM socket with its own receive socket reads and parses the traffic of
+ * all the others.  Sockets opting in with PGM_SHARED_RECV bound to the same
+ * protocol, port and address instead share the first bound receive socket.
+ * Whichever member reads a packet parses it once and, when another member
+ * owns it by data-destination port or source GSI, moves the packet onto the
+ * queue of that member and raises its pending notification.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <string.h>
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/demux.h>
+#include <impl/shard.h>
+
+
+//#define DEMUX_DEBUG
+
+#ifndef DEMUX_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+/* packet read by one member on behalf of another */
+struct pgm_demux_packet_t {
+	pgm_list_t			link_;
+	struct pgm_sk_buff_t*		skb;
+	struct sockaddr_storage		src;
+	struct sockaddr_storage		dst;
+};
+
+/* shared receive sockets, under pgm_sock_list_lock */
+static pgm_slist_t*	demux_list = NULL;
+
+
+/* socket owning a packet, following the dispatch of on_pgm(): downstream to
+ * the receiver of the data-destination port, upstream to the source of the
+ * TSI, and peer-to-peer to the receiver of the session.
+ */
+
+static
+bool
+demux_is_owner (
+	const pgm_sock_t*	    const restrict sock,
+	const struct pgm_sk_buff_t* const restrict skb
+	)
+{
+	const struct pgm_header* header = skb->pgm_header;
+
+	if (PGM_IS_DOWNSTREAM (header->pgm_type))
+		return sock->can_recv_data && header->pgm_dport == sock->dport;
+	if (header->pgm_dport == sock->tsi.sport &&
+	    pgm_gsi_equal (&skb->tsi.gsi, &sock->tsi.gsi))
+		return sock->can_send_data && header->pgm_sport == sock->dport;
+	if (PGM_IS_PEER (header->pgm_type))
+		return sock->can_recv_data && header->pgm_sport == sock->dport;
+	return FALSE;
+}
+
+static
+void
+demux_member_add (
+	struct pgm_demux_t* const restrict demux,
+	pgm_sock_t*	    const restrict sock
+	)
+{
+	struct pgm_demux_member_t* member = pgm_new0 (struct pgm_demux_member_t, 1);
+	member->demux = demux;
+	member->sock  = sock;
+	pgm_mutex_init (&member->mutex);
+	demux->members = pgm_slist_append (demux->members, member);
+	sock->demux = member;
+}
+
+/* join an existing receive socket bound to the same protocol, port and
+ * address, closing the private receive socket of the PGM socket.
+ *
+ * returns TRUE when attached, returns FALSE when the caller binds its own
+ * receive socket and shares it with pgm_demux_create().
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_demux_attach (
+	pgm_sock_t*	       const restrict sock,
+	const struct sockaddr* const restrict addr
+	)
+{
+	struct pgm_demux_t* demux = NULL;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != addr);
+	pgm_assert (NULL == sock->demux);
+
+	pgm_rwlock_writer_lock (&pgm_sock_list_lock);
+	for (pgm_slist_t* list = demux_list; NULL != list; list = list->next)
+	{
+		struct pgm_demux_t* candidate = list->data;
+		if (candidate->protocol == sock->protocol &&
+		    candidate->udp_encap_mcast_port == sock->udp_encap_mcast_port &&
+		    0 == pgm_sockaddr_cmp ((const struct sockaddr*)&candidate->addr, addr))
+		{
+			demux = candidate;
+			break;
+		}
+	}
+	if (NULL == demux) {
+		pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+		return FALSE;
+	}
+	closesocket (sock->recv_sock);
+	sock->recv_sock = demux->recv_sock;
+	demux_member_add (demux, sock);
+	pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Sharing receive socket with %u other PGM sockets."),
+		   pgm_slist_length (demux->members) - 1);
+	return TRUE;
+}
+
+/* offer the bound receive socket of the PGM socket to later sockets.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_demux_create (
+	pgm_sock_t*	       const restrict sock,
+	const struct sockaddr* const restrict addr
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != addr);
+	pgm_assert (NULL == sock->demux);
+
+	struct pgm_demux_t* demux = pgm_new0 (struct pgm_demux_t, 1);
+	demux->recv_sock = sock->recv_sock;
+	demux->protocol = sock->protocol;
+	demux->udp_encap_mcast_port = sock->udp_encap_mcast_port;
+	memcpy (&demux->addr, addr, pgm_sockaddr_len (addr));
+
+	pgm_rwlock_writer_lock (&pgm_sock_list_lock);
+	demux_list = pgm_slist_prepend (demux_list, demux);
+	demux_member_add (demux, sock);
+	pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+}
+
+/* leave the shared receive socket, discarding packets still waiting, and close
+ * it with the last member.  called by pgm_close() in place of closing the
+ * receive socket.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_demux_detach (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_demux_member_t* member;
+	struct pgm_demux_t* demux;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->demux);
+
+	member = sock->demux;
+	demux = member->demux;
+
+	pgm_rwlock_writer_lock (&pgm_sock_list_lock);
+	demux->members = pgm_slist_remove (demux->members, member);
+	if (NULL == demux->members) {
+		demux_list = pgm_slist_remove (demux_list, demux);
+		closesocket (demux->recv_sock);
+		pgm_free (demux);
+	}
+	pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+
+	sock->recv_sock = INVALID_SOCKET;
+	sock->demux = NULL;
+
+/* no other member references the queue once unlisted */
+	pgm_list_t* link;
+	while (NULL != (link = pgm_queue_pop_tail_link (&member->queue))) {
+		struct pgm_demux_packet_t* packet = (struct pgm_demux_packet_t*)link;
+		pgm_free_skb (packet->skb);
+		pgm_free (packet);
+	}
+	pgm_mutex_free (&member->mutex);
+	pgm_free (member);
+}
+
+/* returns TRUE if other PGM sockets read the same receive socket, such that
+ * group membership is left in place for them.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_demux_is_shared (
+	pgm_sock_t* const	sock
+	)
+{
+	bool is_shared;
+
+	if (NULL == sock->demux)
+		return FALSE;
+	pgm_rwlock_reader_lock (&pgm_sock_list_lock);
+	is_shared = pgm_slist_length (sock->demux->demux->members) > 1;
+	pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
+	return is_shared;
+}
+
+/* hand a parsed packet in the receive buffer of the shard to the member
+ * owning it, replacing the receive buffer.  packets without an owner are
+ * discarded.
+ *
+ * returns TRUE if the packet belongs to the reading socket, returns FALSE if
+ * moved or discarded.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_demux_dispatch (
+	pgm_sock_t*	       const restrict sock,
+	struct pgm_rx_shard_t* const restrict shard,
+	const struct sockaddr* const restrict src_addr,
+	const struct sockaddr* const restrict dst_addr
+	)
+{
+	struct pgm_sk_buff_t* skb = shard->rx_buffer;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->demux);
+	pgm_assert (NULL != skb);
+
+	if (PGM_LIKELY(demux_is_owner (sock, skb)))
+		return TRUE;
+
+	pgm_rwlock_reader_lock (&pgm_sock_list_lock);
+	struct pgm_demux_member_t* owner = NULL;
+	for (pgm_slist_t* list = sock->demux->demux->members; NULL != list; list = list->next)
+	{
+		struct pgm_demux_member_t* member = list->data;
+		if (member->sock != sock &&
+		    !member->sock->is_destroyed &&
+		    demux_is_owner (member->sock, skb))
+		{
+			owner = member;
+			break;
+		}
+	}
+	if (NULL == owner) {
+		pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded packet for no sharing socket."));
+		return FALSE;
+	}
+
+	pgm_mutex_lock (&owner->mutex);
+	if (PGM_UNLIKELY(owner->queue.length >= PGM_DEMUX_QUEUE_MAX)) {
+		pgm_mutex_unlock (&owner->mutex);
+		pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded packet for sharing socket with full queue."));
+		return FALSE;
+	}
+	struct pgm_demux_packet_t* packet = pgm_new (struct pgm_demux_packet_t, 1);
+	packet->skb = skb;
+	memcpy (&packet->src, src_addr, pgm_sockaddr_len (src_addr));
+	memcpy (&packet->dst, dst_addr, pgm_sockaddr_len (dst_addr));
+	pgm_queue_push_head_link (&owner->queue, &packet->link_);
+/* readiness of the owner, re-checked by the owner after clearing */
+	pgm_notify_send (&owner->sock->pending_notify);
+	owner->sock->is_pending_read = TRUE;
+	pgm_mutex_unlock (&owner->mutex);
+	pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
+
+	shard->rx_buffer = pgm_skb_pool_alloc (sock->skb_pool, sock->max_tpdu);
+	return FALSE;
+}
+
+/* take the next packet read by another member into the receive buffer of the
+ * shard, with its addresses.
+ *
+ * returns TRUE on packet, returns FALSE if none waiting.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_demux_pop (
+	pgm_sock_t*	       const restrict sock,
+	struct pgm_rx_shard_t* const restrict shard,
+	struct sockaddr*       const restrict src_addr,
+	struct sockaddr*       const restrict dst_addr
+	)
+{
+	struct pgm_demux_member_t* member = sock->demux;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != member);
+
+	if (pgm_queue_is_empty (&member->queue))
+		return FALSE;
+	pgm_mutex_lock (&member->mutex);
+	struct pgm_demux_packet_t* packet = (struct pgm_demux_packet_t*)pgm_queue_pop_tail_link (&member->queue);
+	pgm_mutex_unlock (&member->mutex);
+	if (NULL == packet)
+		return FALSE;
+
+	pgm_free_skb (shard->rx_buffer);
+	shard->rx_buffer = packet->skb;
+	memcpy (src_addr, &packet->src, pgm_sockaddr_len ((struct sockaddr*)&packet->src));
+	memcpy (dst_addr, &packet->dst, pgm_sockaddr_len ((struct sockaddr*)&packet->dst));
+	pgm_free (packet);
+	return TRUE;
+}
+
+/* restore the pending notification cleared by the owner while another member
+ * queued a packet.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_demux_rearm (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_demux_member_t* member = sock->demux;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != member);
+
+	pgm_mutex_lock (&member->mutex);
+	if (!pgm_queue_is_empty (&member->queue)) {
+		pgm_notify_send (&sock->pending_notify);
+		sock->is_pending_read = TRUE;
+	}
+	pgm_mutex_unlock (&member->mutex);
+}
+
+/* eof */
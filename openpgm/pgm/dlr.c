@@ -0,0 +1,372 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Designated Local Repairer (DLR), RFC 3208 section 12.
+ *
+ * A receiving socket with PGM_DLR keeps a copy of the most recent original
+ * data of each source it receives, indexed by sequence number.  Receivers of
+ * the site redirect their NAKs to the DLR with PGM_DLR_REDIRECT, and the DLR
+ * answers from the cache with RDATA on the group of the source.  A NAK naming
+ * any sequence number no longer cached is forwarded unchanged to the source,
+ * which confirms and repairs as usual.  Network elements discover the DLR by
+ * a DLR POLL, answered with a POLR carrying OPT_REDIRECT.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <string.h>
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/dlr.h>
+#include <impl/relay.h>
+#include <impl/net.h>
+#include <impl/packet_parse.h>
+#include <impl/sqn_list.h>
+#include <impl/source.h>
+
+
+//#define DLR_DEBUG
+
+#ifndef DLR_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+/* one slot per sequence number modulo the cache size, a slot holds the
+ * complete TPDU from the PGM header.
+ */
+
+struct pgm_dlr_slot_t {
+	uint32_t		sequence;
+	uint16_t		tpdu_length;		/* 0 = empty */
+};
+
+struct pgm_dlr_t {
+	unsigned		sqns;
+	uint16_t		max_tpdu;
+	struct pgm_dlr_slot_t*	slot;
+	char*			tpdu;
+};
+
+static
+struct pgm_dlr_t*
+dlr_create (
+	const unsigned		sqns,
+	const uint16_t		max_tpdu
+	)
+{
+	struct pgm_dlr_t* dlr = pgm_new0 (struct pgm_dlr_t, 1);
+	dlr->sqns     = sqns;
+	dlr->max_tpdu = max_tpdu;
+	dlr->slot     = pgm_new0 (struct pgm_dlr_slot_t, sqns);
+	dlr->tpdu     = pgm_malloc ((size_t)sqns * max_tpdu);
+	return dlr;
+}
+
+void
+pgm_dlr_destroy (
+	struct pgm_dlr_t* const	dlr
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != dlr);
+
+	pgm_free (dlr->tpdu);
+	pgm_free (dlr->slot);
+	pgm_free (dlr);
+}
+
+/* copy original data or a repair of a source into the cache, before the
+ * receive window takes the buffer.  parity packets are not cached.
+ */
+
+void
+pgm_dlr_cache (
+	pgm_sock_t*		    const restrict sock,
+	pgm_peer_t*		    const restrict peer,
+	const struct pgm_sk_buff_t* const restrict skb
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != peer);
+	pgm_assert (NULL != skb);
+	pgm_assert (sock->dlr_sqns > 0);
+
+	if (skb->pgm_header->pgm_options & PGM_OPT_PARITY)
+		return;
+	const size_t tpdu_length = sizeof(struct pgm_header) + skb->len;
+	if (PGM_UNLIKELY(tpdu_length > sock->max_tpdu))
+		return;
+	if (PGM_UNLIKELY(NULL == peer->dlr))
+		peer->dlr = dlr_create (sock->dlr_sqns, sock->max_tpdu);
+
+	const struct pgm_data* data = skb->data;
+	const uint32_t sequence = pgm_ntohl (data->data_sqn);
+	struct pgm_dlr_t* dlr = peer->dlr;
+	const unsigned index_ = sequence % dlr->sqns;
+	dlr->slot[ index_ ].sequence    = sequence;
+	dlr->slot[ index_ ].tpdu_length = (uint16_t)tpdu_length;
+	memcpy (dlr->tpdu + (size_t)index_ * dlr->max_tpdu, skb->pgm_header, tpdu_length);
+}
+
+/* re-send one cached sequence number as RDATA to the group of the source,
+ * or for a relay to the group or subscriber of nak_src.
+ *
+ * returns TRUE if the sequence number was cached and sent.
+ */
+
+static
+bool
+dlr_repair (
+	pgm_sock_t*	       const restrict sock,
+	pgm_peer_t*	       const restrict peer,
+	const struct sockaddr* const restrict nak_src,
+	const uint32_t			      sequence
+	)
+{
+	const struct pgm_dlr_t* dlr = peer->dlr;
+	if (NULL == dlr)
+		return FALSE;
+	const unsigned index_ = sequence % dlr->sqns;
+	const struct pgm_dlr_slot_t* slot = &dlr->slot[ index_ ];
+	if (0 == slot->tpdu_length || sequence != slot->sequence)
+		return FALSE;
+
+	char* buf = pgm_alloca (slot->tpdu_length);
+	memcpy (buf, dlr->tpdu + (size_t)index_ * dlr->max_tpdu, slot->tpdu_length);
+	struct pgm_header* header = (struct pgm_header*)buf;
+	header->pgm_type	= PGM_RDATA;
+	header->pgm_checksum	= 0;
+	header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, slot->tpdu_length, 0));
+
+/* a relay repairs the receivers of its own group, or the subscriber */
+	if (NULL != sock->relay) {
+		if (!pgm_relay_repair (sock, nak_src, buf, slot->tpdu_length))
+			return FALSE;
+	} else {
+		const ssize_t sent = pgm_sendto (sock,
+						 FALSE,			/* not rate limited */
+						 NULL,
+						 FALSE,			/* regular socket */
+						 buf,
+						 slot->tpdu_length,
+						 (struct sockaddr*)&peer->group_nla,
+						 pgm_sockaddr_len ((struct sockaddr*)&peer->group_nla));
+		if (sent < 0)
+			return FALSE;
+		sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT] += slot->tpdu_length + sock->iphdr_len;
+	}
+	sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_MSGS_RETRANSMITTED]++;
+	sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_BYTES_RETRANSMITTED] += pgm_ntohs (header->pgm_tsdu_length);
+	return TRUE;
+}
+
+/* NAK redirected to this DLR by a receiver of the site at nak_src.  every
+ * sequence number found in the cache is repaired locally, if any is missing
+ * the NAK is forwarded to the source.
+ *
+ * returns TRUE on valid NAK, FALSE on invalid NAK.
+ */
+
+bool
+pgm_on_dlr_nak (
+	pgm_sock_t*	       const restrict sock,
+	pgm_peer_t*	       const restrict peer,
+	const struct sockaddr* const restrict nak_src,
+	struct pgm_sk_buff_t*  const restrict skb
+	)
+{
+	const struct pgm_nak  *nak;
+	const struct pgm_nak6 *nak6;
+	bool			is_complete = TRUE;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != peer);
+	pgm_assert (NULL != skb);
+
+	pgm_debug ("pgm_on_dlr_nak (sock:%p peer:%p skb:%p)",
+		(const void*)sock, (const void*)peer, (const void*)skb);
+
+	if (PGM_UNLIKELY(!pgm_verify_nak (skb)))
+	{
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded invalid redirected NAK."));
+		return FALSE;
+	}
+
+	nak  = (const struct pgm_nak *)skb->data;
+	nak6 = (const struct pgm_nak6*)skb->data;
+	sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAK_PACKETS_RECEIVED]++;
+
+/* parity NAKs name transmission groups, only the source can answer */
+	if (skb->pgm_header->pgm_options & PGM_OPT_PARITY) {
+		is_complete = FALSE;
+		goto forward;
+	}
+
+	sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED]++;
+	if (!dlr_repair (sock, peer, nak_src, pgm_ntohl (nak->nak_sqn)))
+		is_complete = FALSE;
+
+	if (skb->pgm_header->pgm_options & PGM_OPT_PRESENT)
+	{
+		const struct pgm_opt_length* opt_len = (AFI_IP6 == pgm_ntohs (nak->nak_src_nla_afi)) ?
+				(const struct pgm_opt_length*)(nak6 + 1) :
+				(const struct pgm_opt_length*)(nak + 1);
+		if (PGM_UNLIKELY(opt_len->opt_type != PGM_OPT_LENGTH ||
+				 opt_len->opt_length != sizeof(struct pgm_opt_length)))
+		{
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded malformed redirected NAK."));
+			return FALSE;
+		}
+		const struct pgm_opt_header* opt_header = (const struct pgm_opt_header*)opt_len;
+		do {
+			opt_header = (const struct pgm_opt_header*)((const char*)opt_header + opt_header->opt_length);
+			if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_NAK_LIST)
+			{
+				const uint32_t* nak_list = ((const struct pgm_opt_nak_list*)(opt_header + 1))->opt_sqn;
+				unsigned nak_list_len = ( opt_header->opt_length - sizeof(struct pgm_opt_header) - sizeof(uint8_t) ) / sizeof(uint32_t);
+				sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED] += nak_list_len;
+				while (nak_list_len--)
+					if (!dlr_repair (sock, peer, nak_src, pgm_ntohl (*nak_list++)))
+						is_complete = FALSE;
+			}
+			else if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_NAK_RANGE)
+			{
+				const struct pgm_opt_nak_range* opt_nak_range = (const struct pgm_opt_nak_range*)(opt_header + 1);
+				const unsigned nak_range_len = ( opt_header->opt_length - sizeof(struct pgm_opt_header) - sizeof(uint8_t) ) / sizeof(struct pgm_nak_range);
+				for (unsigned i = 0; i < MIN( nak_range_len, PGM_SQN_RANGE_MAX ); i++)
+				{
+					const uint32_t sqn   = pgm_ntohl (opt_nak_range->opt_range[i].range_sqn);
+					const uint32_t count = MIN( pgm_ntohl (opt_nak_range->opt_range[i].range_count), sock->dlr_sqns );
+					sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED] += count;
+					for (uint32_t j = 0; j < count; j++)
+						if (sqn + j != pgm_ntohl (nak->nak_sqn) &&
+						    !dlr_repair (sock, peer, nak_src, sqn + j))
+							is_complete = FALSE;
+				}
+			}
+		} while (!(opt_header->opt_type & PGM_OPT_END));
+	}
+
+forward:
+	if (is_complete)
+		return TRUE;
+	if (PGM_UNLIKELY(pgm_sockaddr_is_addr_unspecified ((struct sockaddr*)&peer->nla))) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Unable to forward NAK due to unknown NLA."));
+		return TRUE;
+	}
+/* NLAs of a relayed NAK name the relay and its group */
+	if (NULL != sock->relay) {
+		pgm_relay_forward_nak (sock, peer, skb);
+		return TRUE;
+	}
+/* forward the NAK as received, source and group NLAs are unchanged */
+	const size_t tpdu_length = sizeof(struct pgm_header) + skb->len;
+	pgm_sendto (sock,
+		    FALSE,			/* not rate limited */
+		    NULL,
+		    FALSE,			/* regular socket */
+		    skb->pgm_header,
+		    tpdu_length,
+		    (struct sockaddr*)&peer->nla,
+		    pgm_sockaddr_len ((struct sockaddr*)&peer->nla));
+	return TRUE;
+}
+
+/* answer a DLR POLL of a network element with a POLR naming this DLR in
+ * OPT_REDIRECT, sent to the path NLA of the poll.
+ *
+ * returns TRUE on success, FALSE if the POLR could not be sent.
+ */
+
+bool
+pgm_dlr_send_polr (
+	pgm_sock_t* const restrict	sock,
+	pgm_peer_t* const restrict	peer,
+	const uint32_t			poll_sqn,
+	const uint16_t			poll_round
+	)
+{
+	struct pgm_header	*header;
+	struct pgm_polr		*polr;
+	struct pgm_opt_length	*opt_len;
+	struct pgm_opt_header	*opt_header;
+	char			*buf;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != peer);
+
+	const bool is_ip6 = (AF_INET6 == sock->send_addr.ss_family);
+	const size_t opt_redirect_length = is_ip6 ? sizeof(struct pgm_opt6_redirect) : sizeof(struct pgm_opt_redirect);
+	const size_t tpdu_length = sizeof(struct pgm_header) +
+				   sizeof(struct pgm_polr) +
+				   sizeof(struct pgm_opt_length) +
+				   sizeof(struct pgm_opt_header) +
+				   opt_redirect_length;
+	buf = pgm_alloca (tpdu_length);
+	memset (buf, 0, tpdu_length);
+	header = (struct pgm_header*)buf;
+	polr   = (struct pgm_polr*)(header + 1);
+	memcpy (header->pgm_gsi, &peer->tsi.gsi, sizeof(pgm_gsi_t));
+/* dport & sport reversed communicating upstream */
+	header->pgm_sport	= sock->dport;
+	header->pgm_dport	= peer->tsi.sport;
+	header->pgm_type	= PGM_POLR;
+	header->pgm_options	= PGM_OPT_PRESENT | PGM_OPT_NETWORK;
+	header->pgm_tsdu_length	= 0;
+
+	polr->polr_sqn		= pgm_htonl (poll_sqn);
+	polr->polr_round	= pgm_htons (poll_round);
+
+	opt_len				= (struct pgm_opt_length*)(polr + 1);
+	opt_len->opt_type		= PGM_OPT_LENGTH;
+	opt_len->opt_length		= sizeof(struct pgm_opt_length);
+	opt_len->opt_total_length	= pgm_htons ((uint16_t)(sizeof(struct pgm_opt_length) + sizeof(struct pgm_opt_header) + opt_redirect_length));
+	opt_header			= (struct pgm_opt_header*)(opt_len + 1);
+	opt_header->opt_type		= PGM_OPT_REDIRECT | PGM_OPT_END;
+	opt_header->opt_length		= (uint8_t)(sizeof(struct pgm_opt_header) + opt_redirect_length);
+/* afi at the same offset for both families */
+	pgm_sockaddr_to_nla ((struct sockaddr*)&sock->send_addr,
+			     (char*)&((struct pgm_opt_redirect*)(opt_header + 1))->opt_nla_afi);
+
+	header->pgm_checksum	= 0;
+	header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
+
+	struct sockaddr_storage poll_nla;
+	memcpy (&poll_nla, &peer->poll_nla, sizeof(poll_nla));
+/* port at same location for sin/sin6 */
+	((struct sockaddr_in*)&poll_nla)->sin_port = pgm_htons (sock->udp_encap_ucast_port);
+	const ssize_t sent = pgm_sendto (sock,
+					 FALSE,			/* not rate limited */
+					 NULL,
+					 FALSE,			/* regular socket */
+					 buf,
+					 tpdu_length,
+					 (struct sockaddr*)&poll_nla,
+					 pgm_sockaddr_len ((struct sockaddr*)&poll_nla));
+	if (sent < 0)
+		return FALSE;
+	sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT] += tpdu_length + sock->iphdr_len;
+	return TRUE;
+}
+
+/* eof */
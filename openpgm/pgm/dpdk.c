@@ -0,0 +1,989 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * DPDK poll-mode driver packet I/O: receive and transmit bursts on an ethdev
+ * queue shared by many PGM sockets, with IGMP membership on the socket's
+ * behalf.  Received mbufs are handed to the receive window in place when the
+ * mbuf pool reserves PGM_SKB_MBUF_PRIV_SIZE private bytes.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_RTE_ETHDEV_H
+#	include <poll.h>
+#	include <net/ethernet.h>
+#	include <netinet/in.h>
+#	include <rte_errno.h>
+#	include <rte_pause.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/dpdk.h>
+
+
+//#define DPDK_DEBUG
+
+#ifndef DPDK_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+#ifdef PGM_HAVE_DPDK
+
+/* largest link, network and transport headers prepended on transmit */
+#define PGM_DPDK_HEADROOM	(sizeof(struct ether_header) + sizeof(struct pgm_ip) + 4 + sizeof(struct pgm_udphdr))
+
+/* upper bound of packets waiting for another member to read them */
+#define PGM_DPDK_QUEUE_MAX	4096
+
+/* IGMPv2, RFC 2236 */
+#define PGM_IGMP_MEMBERSHIP_QUERY	0x11
+#define PGM_IGMP_V2_MEMBERSHIP_REPORT	0x16
+#define PGM_IGMP_V2_LEAVE_GROUP		0x17
+#define PGM_INADDR_ALLRTRS_GROUP	0xe0000002	/* 224.0.0.2 */
+
+struct pgm_igmp {
+	uint8_t			igmp_type;
+	uint8_t			igmp_code;		/* max response time */
+	uint16_t		igmp_cksum;
+	struct in_addr		igmp_group;
+};
+
+/* packet polled by one member on behalf of another */
+struct pgm_dpdk_packet_t {
+	pgm_list_t			link_;
+	struct pgm_sk_buff_t*		skb;
+	struct sockaddr_in		src;
+	struct sockaddr_in		dst;
+};
+
+/* datagram located within a received frame */
+struct pgm_dpdk_frame_t {
+	const char*			datagram;	/* recvskb() format */
+	size_t				len;
+	const struct pgm_header*	header;
+	uint8_t				protocol;
+	uint16_t			udp_dport;
+	struct sockaddr_in		src;
+	struct sockaddr_in		dst;
+};
+
+/* ethdev queues in use, under pgm_sock_list_lock */
+static pgm_slist_t*	dpdk_port_list = NULL;
+
+
+/* last reference of an skb held in mbuf private space */
+
+static
+void
+dpdk_mbuf_release (
+	struct pgm_sk_buff_t*	skb
+	)
+{
+	rte_pktmbuf_free ((struct rte_mbuf*)((char*)skb - sizeof(struct rte_mbuf)));
+}
+
+/* RFC 1112 multicast mapping */
+
+static inline
+void
+dpdk_group_hwaddr (
+	const struct in_addr	group,
+	uint8_t*		hwaddr
+	)
+{
+	const uint8_t* g = (const uint8_t*)&group.s_addr;
+	hwaddr[0] = 0x01;
+	hwaddr[1] = 0x00;
+	hwaddr[2] = 0x5e;
+	hwaddr[3] = g[1] & 0x7f;
+	hwaddr[4] = g[2];
+	hwaddr[5] = g[3];
+}
+
+/* write Ethernet and IPv4 headers for a multicast destination.
+ *
+ * returns pointer to the IPv4 payload.
+ */
+
+static
+char*
+dpdk_build_ip (
+	struct pgm_dpdk_port_t* const restrict port,
+	char*			const restrict frame,
+	const uint8_t			       protocol,
+	const uint8_t			       ttl,
+	const bool			       use_router_alert,
+	const struct in_addr		       src,
+	const struct in_addr		       dst,
+	const size_t			       payload_len,
+	size_t*			const restrict frame_len
+	)
+{
+	struct ether_header* eth = (struct ether_header*)frame;
+	dpdk_group_hwaddr (dst, eth->ether_dhost);
+	memcpy (eth->ether_shost, port->hwaddr, sizeof(eth->ether_shost));
+	eth->ether_type = htons (ETHERTYPE_IP);
+
+	struct pgm_ip* ip = (struct pgm_ip*)(eth + 1);
+	size_t ip_header_length = sizeof(struct pgm_ip);
+	if (use_router_alert) {
+		uint8_t* ra = (uint8_t*)(ip + 1);
+		ra[0] = PGM_IPOPT_RA;
+		ra[1] = 4;
+		ra[2] = ra[3] = 0;
+		ip_header_length += 4;
+	}
+	ip->ip_v	= 4;
+	ip->ip_hl	= ip_header_length / 4;
+	ip->ip_tos	= 0;
+	ip->ip_len	= htons ((uint16_t)(ip_header_length + payload_len));
+	ip->ip_id	= htons (port->ip_id++);
+	ip->ip_off	= 0;
+	ip->ip_ttl	= ttl;
+	ip->ip_p	= protocol;
+	ip->ip_sum	= 0;
+	ip->ip_src	= src;
+	ip->ip_dst	= dst;
+	ip->ip_sum	= pgm_inet_checksum (ip, (uint16_t)ip_header_length, 0);
+	*frame_len = sizeof(struct ether_header) + ip_header_length + payload_len;
+	return (char*)ip + ip_header_length;
+}
+
+/* transmit a burst, caller holds tx_lock.  Blocking callers retry until the
+ * queue accepts every mbuf, otherwise the remainder is freed.
+ *
+ * returns number of mbufs queued.
+ */
+
+static
+unsigned
+dpdk_xmit (
+	struct pgm_dpdk_port_t* const restrict port,
+	struct rte_mbuf**	const restrict mbufs,
+	const unsigned			       count,
+	const bool			       is_nonblocking
+	)
+{
+	unsigned sent = 0;
+	do {
+		sent += rte_eth_tx_burst (port->port_id, port->queue_id, mbufs + sent, (uint16_t)(count - sent));
+	} while (sent < count && !is_nonblocking);
+	for (unsigned i = sent; i < count; i++)
+		rte_pktmbuf_free (mbufs[i]);
+	return sent;
+}
+
+/* send an IGMPv2 report or leave for group, caller holds tx_lock */
+
+static
+void
+dpdk_igmp_send (
+	struct pgm_dpdk_port_t* const	port,
+	const uint8_t			type,
+	const struct in_addr		group
+	)
+{
+	struct rte_mbuf* m = rte_pktmbuf_alloc (port->tx_pool);
+	if (PGM_UNLIKELY(NULL == m))
+		return;
+	struct in_addr dst = group;
+	if (PGM_IGMP_V2_LEAVE_GROUP == type)
+		dst.s_addr = htonl (PGM_INADDR_ALLRTRS_GROUP);
+	size_t frame_len;
+	struct pgm_igmp* igmp = (struct pgm_igmp*)dpdk_build_ip (port, rte_pktmbuf_mtod (m, char*),
+								  IPPROTO_IGMP, 1, TRUE,
+								  port->src_addr, dst,
+								  sizeof(struct pgm_igmp), &frame_len);
+	igmp->igmp_type		= type;
+	igmp->igmp_code		= 0;
+	igmp->igmp_cksum	= 0;
+	igmp->igmp_group	= group;
+	igmp->igmp_cksum	= pgm_inet_checksum (igmp, sizeof(struct pgm_igmp), 0);
+	m->data_len = m->pkt_len = (uint32_t)frame_len;
+	dpdk_xmit (port, &m, 1, TRUE);
+}
+
+/* accept the union of member groups at the NIC, all multicast when the
+ * driver cannot filter.  caller holds tx_lock.
+ */
+
+static
+void
+dpdk_set_mc_addr_list (
+	struct pgm_dpdk_port_t* const	port
+	)
+{
+	struct rte_ether_addr* list = pgm_newa (struct rte_ether_addr, port->groups_len + 1);
+	for (unsigned i = 0; i < port->groups_len; i++)
+		dpdk_group_hwaddr (port->groups[i], list[i].addr_bytes);
+	if (0 != rte_eth_dev_set_mc_addr_list (port->port_id, list, port->groups_len)) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("DPDK port %u multicast filter unavailable, enabling all-multicast."),
+			   (unsigned)port->port_id);
+		rte_eth_allmulticast_enable (port->port_id);
+	}
+}
+
+static inline
+bool
+dpdk_has_group (
+	const struct in_addr*	groups,
+	const unsigned		len,
+	const struct in_addr	group
+	)
+{
+	for (unsigned i = 0; i < len; i++)
+		if (groups[i].s_addr == group.s_addr)
+			return TRUE;
+	return FALSE;
+}
+
+/* replace the groups of one member, reporting groups new to the port and
+ * leaving groups no member still joins.  caller holds pgm_sock_list_lock.
+ */
+
+static
+void
+dpdk_set_groups (
+	struct pgm_dpdk_t*   const restrict member,
+	struct in_addr*	     const restrict groups,
+	const unsigned			    groups_len
+	)
+{
+	struct pgm_dpdk_port_t* port = member->port;
+	pgm_spinlock_lock (&port->tx_lock);
+	if (NULL != member->groups)
+		pgm_free (member->groups);
+	member->groups     = groups;
+	member->groups_len = groups_len;
+
+	unsigned capacity = 0;
+	for (pgm_slist_t* list = port->members; NULL != list; list = list->next)
+		capacity += ((struct pgm_dpdk_t*)list->data)->groups_len;
+	struct in_addr* joined = pgm_new (struct in_addr, capacity + 1);
+	unsigned joined_len = 0;
+	for (pgm_slist_t* list = port->members; NULL != list; list = list->next) {
+		const struct pgm_dpdk_t* other = list->data;
+		for (unsigned i = 0; i < other->groups_len; i++)
+			if (!dpdk_has_group (joined, joined_len, other->groups[i]))
+				joined[ joined_len++ ] = other->groups[i];
+	}
+	for (unsigned i = 0; i < joined_len; i++)
+		if (!dpdk_has_group (port->groups, port->groups_len, joined[i]))
+			dpdk_igmp_send (port, PGM_IGMP_V2_MEMBERSHIP_REPORT, joined[i]);
+	for (unsigned i = 0; i < port->groups_len; i++)
+		if (!dpdk_has_group (joined, joined_len, port->groups[i]))
+			dpdk_igmp_send (port, PGM_IGMP_V2_LEAVE_GROUP, port->groups[i]);
+	if (NULL != port->groups)
+		pgm_free (port->groups);
+	port->groups     = joined;
+	port->groups_len = joined_len;
+	dpdk_set_mc_addr_list (port);
+	pgm_spinlock_unlock (&port->tx_lock);
+}
+
+/* locate the datagram of a received frame in the format of recvskb(): IP
+ * header onwards for raw PGM, payload for UDP encapsulation.
+ *
+ * returns TRUE for PGM or IGMP frames, FALSE otherwise.
+ */
+
+static
+bool
+dpdk_parse (
+	const struct rte_mbuf*	 const restrict m,
+	struct pgm_dpdk_frame_t* const restrict frame
+	)
+{
+	const char* data = rte_pktmbuf_mtod (m, const char*);
+	const size_t data_len = m->data_len;
+	if (PGM_UNLIKELY(data_len < sizeof(struct ether_header) + sizeof(struct pgm_ip)))
+		return FALSE;
+
+	const struct ether_header* eth = (const struct ether_header*)data;
+	size_t offset = sizeof(struct ether_header);
+	uint16_t ether_type = eth->ether_type;
+/* single 802.1Q tag */
+	if (htons (ETHERTYPE_VLAN) == ether_type) {
+		memcpy (&ether_type, data + offset + 2, sizeof(ether_type));
+		offset += 4;
+	}
+	if (htons (ETHERTYPE_IP) != ether_type)
+		return FALSE;
+
+	const struct pgm_ip* ip = (const struct pgm_ip*)(data + offset);
+	const size_t ip_header_length = ip->ip_hl * 4;
+	const size_t packet_length = ntohs (ip->ip_len);
+/* frames spanning segments are not reassembled */
+	if (PGM_UNLIKELY(4 != ip->ip_v ||
+			 ip_header_length < sizeof(struct pgm_ip) ||
+			 packet_length < ip_header_length ||
+			 offset + packet_length > data_len))
+		return FALSE;
+	if (PGM_UNLIKELY(0 != (ntohs (ip->ip_off) & 0x3fff)))
+		return FALSE;
+
+	memset (&frame->src, 0, sizeof(struct sockaddr_in));
+	frame->src.sin_family	= AF_INET;
+	frame->src.sin_addr	= ip->ip_src;
+	memset (&frame->dst, 0, sizeof(struct sockaddr_in));
+	frame->dst.sin_family	= AF_INET;
+	frame->dst.sin_addr	= ip->ip_dst;
+	frame->protocol		= ip->ip_p;
+	frame->udp_dport	= 0;
+
+	const char* payload = (const char*)ip + ip_header_length;
+	const size_t payload_len = packet_length - ip_header_length;
+	switch (ip->ip_p) {
+	case IPPROTO_IGMP:
+		if (payload_len < sizeof(struct pgm_igmp))
+			return FALSE;
+		frame->datagram	= payload;
+		frame->len	= payload_len;
+		frame->header	= NULL;
+		return TRUE;
+
+	case IPPROTO_UDP:
+	{
+		if (payload_len < sizeof(struct pgm_udphdr) + sizeof(struct pgm_header))
+			return FALSE;
+		const struct pgm_udphdr* udp = (const struct pgm_udphdr*)payload;
+		const size_t udp_length = ntohs (udp->uh_ulen);
+		if (PGM_UNLIKELY(udp_length < sizeof(struct pgm_udphdr) + sizeof(struct pgm_header) ||
+				 udp_length > payload_len))
+			return FALSE;
+		frame->src.sin_port	= udp->uh_sport;
+		frame->dst.sin_port	= udp->uh_dport;
+		frame->udp_dport	= ntohs (udp->uh_dport);
+		frame->datagram		= (const char*)(udp + 1);
+		frame->len		= udp_length - sizeof(struct pgm_udphdr);
+		frame->header		= (const struct pgm_header*)frame->datagram;
+		return TRUE;
+	}
+
+	case IPPROTO_PGM:
+		if (payload_len < sizeof(struct pgm_header))
+			return FALSE;
+		frame->datagram	= (const char*)ip;
+		frame->len	= packet_length;
+		frame->header	= (const struct pgm_header*)payload;
+		return TRUE;
+
+	default:
+		return FALSE;
+	}
+}
+
+/* socket owning a frame, following the dispatch of on_pgm() as per the
+ * shared receive socket demultiplexer.
+ */
+
+static
+bool
+dpdk_is_owner (
+	const pgm_sock_t*	       const restrict sock,
+	const struct pgm_dpdk_frame_t* const restrict frame
+	)
+{
+	if (sock->is_destroyed || sock->protocol != frame->protocol)
+		return FALSE;
+	if (IPPROTO_UDP == frame->protocol &&
+	    frame->udp_dport != sock->udp_encap_mcast_port &&
+	    frame->udp_dport != sock->udp_encap_ucast_port)
+		return FALSE;
+
+	const struct pgm_header* header = frame->header;
+	if (PGM_IS_DOWNSTREAM (header->pgm_type))
+		return sock->can_recv_data && header->pgm_dport == sock->dport;
+	if (header->pgm_dport == sock->tsi.sport &&
+	    0 == memcmp (header->pgm_gsi, &sock->tsi.gsi, sizeof(header->pgm_gsi)))
+		return sock->can_send_data && header->pgm_sport == sock->dport;
+	if (PGM_IS_PEER (header->pgm_type))
+		return sock->can_recv_data && header->pgm_sport == sock->dport;
+	return FALSE;
+}
+
+/* wrap the datagram of an mbuf as an skb of the owning socket, in the mbuf
+ * private space when reserved otherwise copied and the mbuf freed.
+ */
+
+static
+struct pgm_sk_buff_t*
+dpdk_skb (
+	struct pgm_dpdk_port_t*	       const restrict port,
+	pgm_sock_t*		       const restrict sock,
+	struct rte_mbuf*	       const restrict m,
+	const struct pgm_dpdk_frame_t* const restrict frame
+	)
+{
+	struct pgm_sk_buff_t* skb;
+/* truncate as per recvmsg() into max_tpdu */
+	const size_t len = MIN(frame->len, sock->max_tpdu);
+	if (rte_pktmbuf_priv_size (m->pool) >= PGM_SKB_MBUF_PRIV_SIZE) {
+		skb = rte_mbuf_to_priv (m);
+		memset (skb, 0, sizeof(struct pgm_sk_buff_t));
+		skb->truesize	= sizeof(struct pgm_sk_buff_t) + m->buf_len;
+		pgm_atomic_write32 (&skb->users, 1);
+		skb->head	= (void*)frame->datagram;
+		skb->end	= (char*)m->buf_addr + m->buf_len;
+		skb->pool	= port->skb_pool;
+		pgm_atomic_inc32 (&port->skb_pool->ref_count);
+	} else {
+		skb = pgm_skb_pool_alloc (sock->skb_pool, sock->max_tpdu);
+		memcpy (skb->head, frame->datagram, len);
+		rte_pktmbuf_free (m);
+	}
+	skb->sock		= sock;
+	skb->tstamp		= pgm_time_coarse_now();
+	skb->rx_tstamp		= 0;
+	skb->data		= skb->head;
+	skb->len		= (uint16_t)len;
+	skb->zero_padded	= 0;
+	skb->tail		= (char*)skb->data + len;
+	return skb;
+}
+
+/* next received mbuf of the port, polling a burst when none are held.
+ *
+ * returns NULL when the queue is empty.
+ */
+
+static
+struct rte_mbuf*
+dpdk_next (
+	struct pgm_dpdk_port_t*	const	port
+	)
+{
+	struct rte_mbuf* m = NULL;
+	pgm_spinlock_lock (&port->rx_lock);
+	if (port->rx_head == port->rx_len) {
+		port->rx_head = 0;
+		port->rx_len  = rte_eth_rx_burst (port->port_id, port->queue_id, port->rx_burst, PGM_DPDK_BURST);
+	}
+	if (port->rx_head < port->rx_len)
+		m = port->rx_burst[ port->rx_head++ ];
+	pgm_spinlock_unlock (&port->rx_lock);
+	return m;
+}
+
+/* queue an skb for another member and raise its pending notification */
+
+static
+void
+dpdk_push (
+	struct pgm_dpdk_t*     const restrict owner,
+	struct pgm_sk_buff_t*  const restrict skb,
+	const struct sockaddr_in*const restrict src,
+	const struct sockaddr_in*const restrict dst
+	)
+{
+	pgm_mutex_lock (&owner->mutex);
+	if (PGM_UNLIKELY(owner->queue.length >= PGM_DPDK_QUEUE_MAX)) {
+		pgm_mutex_unlock (&owner->mutex);
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded packet for DPDK member with full queue."));
+		pgm_free_skb (skb);
+		return;
+	}
+	struct pgm_dpdk_packet_t* packet = pgm_new (struct pgm_dpdk_packet_t, 1);
+	packet->skb = skb;
+	packet->src = *src;
+	packet->dst = *dst;
+	pgm_queue_push_head_link (&owner->queue, &packet->link_);
+	pgm_notify_send (&owner->sock->pending_notify);
+	owner->sock->is_pending_read = TRUE;
+	pgm_mutex_unlock (&owner->mutex);
+}
+#endif /* PGM_HAVE_DPDK */
+
+/* attach to the receive and transmit queue pair of a started ethdev port,
+ * shared with other sockets on the same queue.  Called from pgm_bind()
+ * after the send socket is bound.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error appropriately.
+ */
+
+bool
+pgm_dpdk_open (
+	pgm_sock_t*    const restrict sock,
+	pgm_error_t**	     restrict error
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL == sock->dpdk);
+	pgm_assert (sock->dpdk_port_id >= 0);
+
+#ifdef PGM_HAVE_DPDK
+	char errbuf[1024];
+
+	if (AF_INET != sock->family) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_AFNOSUPPORT,
+			       _("DPDK transport requires IPv4."));
+		return FALSE;
+	}
+	if ((size_t)sock->max_tpdu + PGM_DPDK_HEADROOM > RTE_MBUF_DEFAULT_DATAROOM) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Maximum TPDU %u exceeds DPDK mbuf data room %u."),
+			       (unsigned)sock->max_tpdu, (unsigned)RTE_MBUF_DEFAULT_DATAROOM);
+		return FALSE;
+	}
+	if (!rte_eth_dev_is_valid_port ((uint16_t)sock->dpdk_port_id)) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_NODEV,
+			       _("DPDK port %d is not available."),
+			       sock->dpdk_port_id);
+		return FALSE;
+	}
+
+	struct pgm_dpdk_t* member = pgm_new0 (struct pgm_dpdk_t, 1);
+	member->sock = sock;
+	pgm_mutex_init (&member->mutex);
+
+/* source network address for transmitted frames */
+	socklen_t addrlen = sizeof(member->src_addr);
+	if (SOCKET_ERROR == getsockname (sock->send_sock, (struct sockaddr*)&member->src_addr, &addrlen)) {
+		const int save_errno = errno;
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_errno (save_errno),
+			       _("DPDK getsockname: %s"),
+			       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		pgm_mutex_free (&member->mutex);
+		pgm_free (member);
+		return FALSE;
+	}
+
+	pgm_rwlock_writer_lock (&pgm_sock_list_lock);
+	struct pgm_dpdk_port_t* port = NULL;
+	for (pgm_slist_t* list = dpdk_port_list; NULL != list; list = list->next) {
+		struct pgm_dpdk_port_t* candidate = list->data;
+		if (candidate->port_id == sock->dpdk_port_id &&
+		    candidate->queue_id == sock->dpdk_queue_id)
+		{
+			port = candidate;
+			break;
+		}
+	}
+	if (NULL == port) {
+		char name[ 32 ];
+		snprintf (name, sizeof(name), "pgm_tx_%d_%u", sock->dpdk_port_id, (unsigned)sock->dpdk_queue_id);
+		struct rte_mempool* tx_pool = rte_pktmbuf_pool_create (name,
+								       PGM_DPDK_POOL_SIZE,
+								       RTE_MEMPOOL_CACHE_MAX_SIZE,
+								       0,
+								       RTE_MBUF_DEFAULT_BUF_SIZE,
+								       rte_eth_dev_socket_id ((uint16_t)sock->dpdk_port_id));
+		if (NULL == tx_pool) {
+			const int save_errno = rte_errno;
+			pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_SOCKET,
+				       pgm_error_from_errno (save_errno),
+				       _("DPDK rte_pktmbuf_pool_create: %s"),
+				       rte_strerror (save_errno));
+			pgm_mutex_free (&member->mutex);
+			pgm_free (member);
+			return FALSE;
+		}
+		port = pgm_new0 (struct pgm_dpdk_port_t, 1);
+		port->port_id	= (uint16_t)sock->dpdk_port_id;
+		port->queue_id	= sock->dpdk_queue_id;
+		port->tx_pool	= tx_pool;
+		port->src_addr	= member->src_addr.sin_addr;
+		struct rte_ether_addr hwaddr;
+		rte_eth_macaddr_get (port->port_id, &hwaddr);
+		memcpy (port->hwaddr, hwaddr.addr_bytes, sizeof(port->hwaddr));
+		port->skb_pool	= pgm_skb_pool_create (sock->max_tpdu, 0);
+		port->skb_pool->release = dpdk_mbuf_release;
+		pgm_spinlock_init (&port->rx_lock);
+		pgm_spinlock_init (&port->tx_lock);
+		dpdk_port_list = pgm_slist_prepend (dpdk_port_list, port);
+	}
+	port->ref_count++;
+	port->members = pgm_slist_prepend (port->members, member);
+	member->port = port;
+	sock->dpdk = member;
+	pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+
+/* groups joined before binding */
+	pgm_dpdk_update_groups (sock);
+
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("DPDK port %u queue %u attached, %u sockets sharing."),
+		   (unsigned)port->port_id, (unsigned)port->queue_id, port->ref_count);
+	return TRUE;
+#else
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       PGM_ERROR_NOSYS,
+		       _("DPDK unavailable on this platform."));
+	return FALSE;
+#endif /* PGM_HAVE_DPDK */
+}
+
+/* leave every group of the socket and detach, releasing the port with its
+ * last socket.
+ */
+
+void
+pgm_dpdk_close (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+#ifdef PGM_HAVE_DPDK
+	struct pgm_dpdk_t* member = sock->dpdk;
+	if (NULL == member)
+		return;
+	struct pgm_dpdk_port_t* port = member->port;
+
+	pgm_rwlock_writer_lock (&pgm_sock_list_lock);
+	dpdk_set_groups (member, NULL, 0);
+	port->members = pgm_slist_remove (port->members, member);
+	const bool is_last = (0 == --port->ref_count);
+	if (is_last)
+		dpdk_port_list = pgm_slist_remove (dpdk_port_list, port);
+	pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+
+/* no other member references the queue once unlisted */
+	pgm_list_t* link;
+	while (NULL != (link = pgm_queue_pop_tail_link (&member->queue))) {
+		struct pgm_dpdk_packet_t* packet = (struct pgm_dpdk_packet_t*)link;
+		pgm_free_skb (packet->skb);
+		pgm_free (packet);
+	}
+	pgm_mutex_free (&member->mutex);
+	pgm_free (member);
+	sock->dpdk = NULL;
+
+	if (is_last) {
+		for (unsigned i = port->rx_head; i < port->rx_len; i++)
+			rte_pktmbuf_free (port->rx_burst[i]);
+		if (NULL != port->groups)
+			pgm_free (port->groups);
+		rte_mempool_free (port->tx_pool);
+/* mbuf backed skbs still held by receive windows keep the pool */
+		pgm_skb_pool_destroy (port->skb_pool);
+		pgm_spinlock_free (&port->tx_lock);
+		pgm_spinlock_free (&port->rx_lock);
+		pgm_free (port);
+	}
+#endif
+}
+
+#ifdef PGM_HAVE_DPDK
+/* re-read the IPv4 groups joined by the socket after a membership change */
+
+void
+pgm_dpdk_update_groups (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->dpdk);
+
+	struct in_addr* groups = pgm_new (struct in_addr, sock->recv_gsr_len + 1);
+	unsigned groups_len = 0;
+	for (unsigned i = 0; i < sock->recv_gsr_len; i++) {
+		const struct sockaddr_in* sin = (const struct sockaddr_in*)&sock->recv_gsr[i].gsr_group;
+		if (AF_INET == sin->sin_family &&
+		    IN_MULTICAST (ntohl (sin->sin_addr.s_addr)) &&
+		    !dpdk_has_group (groups, groups_len, sin->sin_addr))
+			groups[ groups_len++ ] = sin->sin_addr;
+	}
+	pgm_rwlock_reader_lock (&pgm_sock_list_lock);
+	dpdk_set_groups (sock->dpdk, groups, groups_len);
+	pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
+}
+
+/* packets polled by any member and not yet read */
+
+bool
+pgm_dpdk_is_pending (
+	const pgm_sock_t* const	sock
+	)
+{
+	const struct pgm_dpdk_t* member = sock->dpdk;
+	return (NULL != member &&
+		(!pgm_queue_is_empty (&member->queue) ||
+		 member->port->rx_head < member->port->rx_len));
+}
+
+/* restore the pending notification cleared by the owner while another member
+ * queued a packet.
+ */
+
+void
+pgm_dpdk_rearm (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_dpdk_t* member = sock->dpdk;
+	pgm_mutex_lock (&member->mutex);
+	if (!pgm_queue_is_empty (&member->queue)) {
+		pgm_notify_send (&sock->pending_notify);
+		sock->is_pending_read = TRUE;
+	}
+	pgm_mutex_unlock (&member->mutex);
+}
+
+/* read the next PGM packet of the socket: those polled by other members
+ * first, then bursts of the shared queue, handing packets of other members
+ * to their queues and answering IGMP queries.  The packet replaces the
+ * receive buffer of the shard.
+ *
+ * on success returns packet length, on empty queue returns -1 with EAGAIN.
+ */
+
+ssize_t
+pgm_dpdk_recvskb (
+	pgm_sock_t*	       const restrict sock,
+	struct pgm_rx_shard_t* const restrict shard,
+	struct sockaddr*       const restrict src_addr,
+	const socklen_t			      src_addrlen,
+	struct sockaddr*       const restrict dst_addr,
+	const socklen_t			      dst_addrlen
+	)
+{
+	struct pgm_dpdk_t* member = sock->dpdk;
+	struct pgm_dpdk_port_t* port = member->port;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != member);
+	pgm_assert (NULL != shard);
+	pgm_assert (NULL != src_addr);
+	pgm_assert (src_addrlen > 0);
+	pgm_assert (NULL != dst_addr);
+	pgm_assert (dst_addrlen > 0);
+
+	if (PGM_UNLIKELY(sock->is_destroyed))
+		return 0;
+
+	struct pgm_sk_buff_t* skb = NULL;
+	struct sockaddr_in src, dst;
+
+	if (!pgm_queue_is_empty (&member->queue)) {
+		pgm_mutex_lock (&member->mutex);
+		struct pgm_dpdk_packet_t* packet = (struct pgm_dpdk_packet_t*)pgm_queue_pop_tail_link (&member->queue);
+		pgm_mutex_unlock (&member->mutex);
+		if (NULL != packet) {
+			skb = packet->skb;
+			src = packet->src;
+			dst = packet->dst;
+			pgm_free (packet);
+		}
+	}
+
+	while (NULL == skb)
+	{
+		struct rte_mbuf* m = dpdk_next (port);
+		if (NULL == m) {
+/* return an idle mbuf to the driver, kernel reads need a full buffer */
+			if (port->skb_pool == shard->rx_buffer->pool) {
+				pgm_free_skb (shard->rx_buffer);
+				shard->rx_buffer = pgm_skb_pool_alloc (sock->skb_pool, sock->max_tpdu);
+			}
+			pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+			return SOCKET_ERROR;
+		}
+		struct pgm_dpdk_frame_t frame;
+		if (!dpdk_parse (m, &frame)) {
+			rte_pktmbuf_free (m);
+			continue;
+		}
+		if (IPPROTO_IGMP == frame.protocol) {
+			const struct pgm_igmp* igmp = (const struct pgm_igmp*)frame.datagram;
+			if (PGM_IGMP_MEMBERSHIP_QUERY == igmp->igmp_type) {
+				pgm_spinlock_lock (&port->tx_lock);
+				for (unsigned i = 0; i < port->groups_len; i++)
+					if (0 == igmp->igmp_group.s_addr ||
+					    igmp->igmp_group.s_addr == port->groups[i].s_addr)
+						dpdk_igmp_send (port, PGM_IGMP_V2_MEMBERSHIP_REPORT, port->groups[i]);
+				pgm_spinlock_unlock (&port->tx_lock);
+			}
+			rte_pktmbuf_free (m);
+			continue;
+		}
+
+		if (dpdk_is_owner (sock, &frame)) {
+			skb = dpdk_skb (port, sock, m, &frame);
+			src = frame.src;
+			dst = frame.dst;
+			break;
+		}
+		struct pgm_dpdk_t* owner = NULL;
+		pgm_rwlock_reader_lock (&pgm_sock_list_lock);
+		for (pgm_slist_t* list = port->members; NULL != list; list = list->next) {
+			struct pgm_dpdk_t* other = list->data;
+			if (other != member && dpdk_is_owner (other->sock, &frame)) {
+				owner = other;
+				break;
+			}
+		}
+		if (NULL == owner)
+			rte_pktmbuf_free (m);
+		else
+			dpdk_push (owner, dpdk_skb (port, owner->sock, m, &frame), &frame.src, &frame.dst);
+		pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
+	}
+
+	pgm_free_skb (shard->rx_buffer);
+	shard->rx_buffer = skb;
+	memcpy (src_addr, &src, MIN(src_addrlen, sizeof(src)));
+	memcpy (dst_addr, &dst, MIN(dst_addrlen, sizeof(dst)));
+	return skb->len;
+}
+
+/* queue a vector of PGM packets to one multicast destination as a transmit
+ * burst on the shared queue.  Blocking sockets retry until the driver
+ * accepts the burst.
+ *
+ * on success, returns number of packets queued.  on error, -1 is returned
+ * and errno set to EAGAIN.
+ */
+
+int
+pgm_dpdk_sendv (
+	pgm_sock_t*	       const restrict sock,
+	const bool			      use_router_alert,
+	const int			      hops,
+	const struct pgm_iovec* const restrict vector,
+	const unsigned			      count,
+	const struct sockaddr*  const restrict to
+	)
+{
+	struct pgm_dpdk_t* member = sock->dpdk;
+	struct pgm_dpdk_port_t* port = member->port;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != member);
+	pgm_assert (NULL != vector);
+	pgm_assert (count > 0);
+	pgm_assert (pgm_dpdk_can_sendto (sock, to));
+
+	const struct sockaddr_in* sin = (const struct sockaddr_in*)to;
+	const bool is_udp = (IPPROTO_UDP == sock->protocol);
+	const uint8_t ttl = (-1 != hops) ? hops : sock->hops;
+	struct rte_mbuf* mbufs[ PGM_DPDK_BURST ];
+	unsigned sent = 0;
+
+	pgm_spinlock_lock (&port->tx_lock);
+	while (sent < count)
+	{
+		const unsigned burst = MIN(count - sent, PGM_DPDK_BURST);
+		if (0 != rte_pktmbuf_alloc_bulk (port->tx_pool, mbufs, burst))
+			break;
+		for (unsigned i = 0; i < burst; i++)
+		{
+			const struct pgm_iovec* iov = &vector[ sent + i ];
+			pgm_assert_cmpuint (iov->iov_len + PGM_DPDK_HEADROOM, <=, RTE_MBUF_DEFAULT_DATAROOM);
+			const size_t payload_len = (is_udp ? sizeof(struct pgm_udphdr) : 0) + iov->iov_len;
+			size_t frame_len;
+			char* payload = dpdk_build_ip (port, rte_pktmbuf_mtod (mbufs[i], char*),
+						       is_udp ? IPPROTO_UDP : IPPROTO_PGM, ttl, use_router_alert,
+						       member->src_addr.sin_addr, sin->sin_addr,
+						       payload_len, &frame_len);
+			if (is_udp) {
+				struct pgm_udphdr* udp = (struct pgm_udphdr*)payload;
+				udp->uh_sport	= member->src_addr.sin_port;
+				udp->uh_dport	= sin->sin_port;
+				udp->uh_ulen	= htons ((uint16_t)payload_len);
+				udp->uh_sum	= 0;		/* optional for IPv4 */
+				payload += sizeof(struct pgm_udphdr);
+			}
+			memcpy (payload, iov->iov_base, iov->iov_len);
+			mbufs[i]->data_len = mbufs[i]->pkt_len = (uint32_t)frame_len;
+		}
+		const unsigned queued = dpdk_xmit (port, mbufs, burst, sock->is_nonblocking);
+		sent += queued;
+		if (queued < burst)
+			break;
+	}
+	pgm_spinlock_unlock (&port->tx_lock);
+	if (0 == sent) {
+		pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+		return -1;
+	}
+	return (int)sent;
+}
+
+/* spin on the shared queue for up to timeout microseconds, checking the
+ * kernel descriptors of the socket between bursts.
+ *
+ * returns 1 when ready, 0 on timeout, -1 on error.
+ */
+
+int
+pgm_dpdk_wait (
+	pgm_sock_t* const	sock,
+	const int		timeout		/* μs */
+	)
+{
+	struct pgm_dpdk_t* member = sock->dpdk;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != member);
+
+	int n_fds = 3 + sock->recv_shards;
+	struct pollfd fds[ n_fds ];
+	memset (fds, 0, sizeof(fds));
+	if (-1 == pgm_poll_info (sock, fds, &n_fds, POLLIN))
+		return SOCKET_ERROR;
+
+	const pgm_time_t expiry = pgm_time_update_now() + (timeout > 0 ? timeout : 0);
+	for (unsigned spins = 0;; spins++)
+	{
+		if (pgm_dpdk_is_pending (sock))
+			return 1;
+		struct pgm_dpdk_port_t* port = member->port;
+		pgm_spinlock_lock (&port->rx_lock);
+		if (port->rx_head == port->rx_len) {
+			port->rx_head = 0;
+			port->rx_len  = rte_eth_rx_burst (port->port_id, port->queue_id, port->rx_burst, PGM_DPDK_BURST);
+		}
+		const bool is_ready = port->rx_head < port->rx_len;
+		pgm_spinlock_unlock (&port->rx_lock);
+		if (is_ready)
+			return 1;
+		if (0 == (spins % 64)) {
+			const int ready = poll (fds, n_fds, 0);
+			if (0 != ready)
+				return ready;
+			if (pgm_time_after_eq (pgm_time_update_now(), expiry))
+				return 0;
+		}
+		rte_pause();
+	}
+}
+#endif /* PGM_HAVE_DPDK */
+
+/* eof */
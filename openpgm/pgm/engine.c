@@ -8,7 +8,8 @@
  * - PRNG API for global lock on global generator,
  * - Timing API for calibration, device locking as appropriate,
  * - PGM protocol# resolution,
- * - Lock on global list of PGM sockets.
+ * - Lock on global list of PGM sockets,
+ * - Optional timer thread servicing every connected socket.
  *
  * Copyright (c) 2006-2011 Miru Limited.
  *
@@ -43,6 +44,9 @@
 #include <impl/engine.h>
 #include <impl/mem.h>
 #include <impl/socket.h>
+#include <impl/sock_registry.h>
+#include <impl/stats.h>
+#include <impl/timer.h>
 #include <pgm/engine.h>
 #include <pgm/version.h>
 
@@ -57,8 +61,9 @@ int			pgm_ipproto_pgm PGM_GNUC_READ_MOSTLY = IPPROTO_PGM;
 LPFN_WSARECVMSG		pgm_WSARecvMsg PGM_GNUC_READ_MOSTLY = NULL;
 #endif
 
-#ifdef PGM_DEBUG
+#ifdef PGM_LOSS_INJECTION
 unsigned		pgm_loss_rate PGM_GNUC_READ_MOSTLY = 0;
+unsigned		pgm_loss_burst PGM_GNUC_READ_MOSTLY = 0;
 #endif
 
 /* locals */
@@ -67,6 +72,35 @@ static volatile uint32_t pgm_ref_count	 = 0;
 
 static pgm_cpu_t	pgm_cpu;
 
+/* shared timer service, SPM heartbeats, NAK and peer expiry of every connected
+ * socket run without the application calling into each socket.
+ */
+
+#define PGM_ENGINE_TIMER_RETRY	pgm_msecs(1)	/* due socket busy in another thread */
+
+static bool		engine_timer_is_running PGM_GNUC_READ_MOSTLY = FALSE;
+static bool		engine_timer_is_terminated = FALSE;
+static pgm_time_t	engine_timer_deadline = 0;	/* next sweep, under engine_timer_mutex */
+static pgm_mutex_t	engine_timer_mutex;
+static pgm_notify_t	engine_timer_notify = PGM_NOTIFY_INIT;
+#ifndef _WIN32
+static pthread_t	engine_timer_thread;
+#else
+static HANDLE		engine_timer_thread;
+#endif
+
+static bool engine_timer_create (void);
+static void engine_timer_destroy (void);
+
+/* publisher of the shared-memory statistics segment */
+static bool		engine_stats_is_running = FALSE;
+
+/* one second samples of socket and peer counters for rates */
+static bool		engine_sampler_is_running = FALSE;
+
+/* background formatting of log messages */
+static bool		engine_logring_is_running = FALSE;
+
 #ifdef _WIN32
 #	ifndef WSAID_WSARECVMSG
 /* http://cvs.winehq.org/cvsweb/wine/include/mswsock.h */
@@ -104,6 +138,27 @@ pgm_init (
 	pgm_thread_init();
 	pgm_mem_init();
 	pgm_rand_init();
+	pgm_latency_init();
+	pgm_thread_attr_init();
+	pgm_if_cache_init();
+
+/* asynchronous logging */
+	char* log_env;
+	size_t log_envlen;
+
+	const errno_t log_err = pgm_dupenv_s (&log_env, &log_envlen, "PGM_LOG_ASYNC");
+	if (0 == log_err && log_envlen > 0) {
+		if (atoi (log_env) > 0) {
+			pgm_error_t* log_error = NULL;
+			if (pgm_logring_init (&log_error))
+				engine_logring_is_running = TRUE;
+			else if (log_error) {
+				pgm_warn (_("%s"), log_error->message);
+				pgm_error_free (log_error);
+			}
+		}
+		pgm_free (log_env);
+	}
 
 #ifdef _WIN32
 	WORD wVersionRequested = MAKEWORD (2, 2);
@@ -185,12 +240,17 @@ pgm_init (
 		goto err_shutdown;
 	}
 
+#ifdef USE_TRACE_EVENTS
+/* protocol timeline from the probes, PGM_TRACE_EVENTS */
+	pgm_trace_event_init();
+#endif
+
 /* receiver simulated loss rate */
-#ifdef PGM_DEBUG
+#ifdef PGM_LOSS_INJECTION
 	char* env;
 	size_t envlen;
 
-	const errno_t err = pgm_dupenv_s (&env, &envlen, "PGM_LOSS_RATE");
+	errno_t err = pgm_dupenv_s (&env, &envlen, "PGM_LOSS_RATE");
 	if (0 == err && envlen > 0) {
 		const int loss_rate = atoi (env);
 		if (loss_rate > 0 && loss_rate <= 100) {
@@ -199,18 +259,76 @@ pgm_init (
 		}
 		pgm_free (env);
 	}
+
+/* mean length of loss bursts */
+	err = pgm_dupenv_s (&env, &envlen, "PGM_LOSS_BURST");
+	if (0 == err && envlen > 0) {
+		const int loss_burst = atoi (env);
+		if (loss_burst > 1) {
+			pgm_loss_burst = loss_burst;
+			pgm_minor (_("Setting PGM packet loss burst length to %i."), pgm_loss_burst);
+		}
+		pgm_free (env);
+	}
 #endif
 
-/* create global sock list lock */
+/* create global sock registry and shared member lock */
+	pgm_sock_registry_init ();
 	pgm_rwlock_init (&pgm_sock_list_lock);
+	pgm_rwlock_set_name (&pgm_sock_list_lock, "sock_list_lock");
 
 /* set preferred checksum algorithm */
 	pgm_checksum_init (&pgm_cpu);
 
+/* set preferred Galois field vector multiplication */
+	pgm_rs_init (&pgm_cpu);
+
+/* shared timer thread */
+	char* timer_env;
+	size_t timer_envlen;
+
+	const errno_t timer_err = pgm_dupenv_s (&timer_env, &timer_envlen, "PGM_TIMER_THREAD");
+	if (0 == timer_err && timer_envlen > 0) {
+		if (atoi (timer_env) > 0 && engine_timer_create())
+			pgm_minor (_("Running socket timers on shared engine thread."));
+		pgm_free (timer_env);
+	}
+
+/* shared-memory statistics segment, a name or a positive value for the
+ * default name.
+ */
+	char* stats_env;
+	size_t stats_envlen;
+
+	const errno_t stats_err = pgm_dupenv_s (&stats_env, &stats_envlen, "PGM_STATS_SHM");
+	if (0 == stats_err && stats_envlen > 0) {
+		if ('/' == stats_env[0] || atoi (stats_env) > 0) {
+			if (pgm_stats_shm_init ('/' == stats_env[0] ? stats_env : NULL, &sub_error))
+				engine_stats_is_running = TRUE;
+			else if (sub_error) {
+				pgm_warn (_("%s"), sub_error->message);
+				pgm_error_free (sub_error);
+				sub_error = NULL;
+			}
+		}
+		pgm_free (stats_env);
+	}
+
+/* counter rates, without the sampler rates read zero */
+	engine_sampler_is_running = pgm_stats_sampler_init();
+	if (!engine_sampler_is_running)
+		pgm_minor (_("Counter rate sampling unavailable."));
+
 	pgm_is_supported = TRUE;
 	return TRUE;
 
 err_shutdown:
+	if (engine_logring_is_running) {
+		pgm_logring_shutdown();
+		engine_logring_is_running = FALSE;
+	}
+	pgm_if_cache_shutdown();
+	pgm_latency_shutdown();
 	pgm_rand_shutdown();
 	pgm_mem_shutdown();
 	pgm_thread_shutdown();
@@ -243,19 +361,47 @@ pgm_shutdown (void)
 
 	pgm_is_supported = FALSE;
 
-/* destroy all open socks */
-	while (pgm_sock_list) {
-		pgm_close ((pgm_sock_t*)pgm_sock_list->data, FALSE);
+/* stop timers and the statistics publisher before the sockets they service */
+	if (engine_timer_is_running)
+		engine_timer_destroy();
+	if (engine_stats_is_running) {
+		pgm_stats_shm_shutdown();
+		engine_stats_is_running = FALSE;
+	}
+	if (engine_sampler_is_running) {
+		pgm_stats_sampler_shutdown();
+		engine_sampler_is_running = FALSE;
+	}
+
+/* destroy all open socks, closing outside of the read section */
+	for (;;) {
+		unsigned epoch;
+		const pgm_sock_registry_t* registry = pgm_sock_registry_enter (&epoch);
+		pgm_sock_t* sock = registry->len ? registry->socks[ 0 ] : NULL;
+		pgm_sock_registry_leave (epoch);
+		if (NULL == sock)
+			break;
+		pgm_close (sock, FALSE);
 	}
 
 	pgm_rwlock_free (&pgm_sock_list_lock);
+	pgm_sock_registry_shutdown ();
 
+#ifdef USE_TRACE_EVENTS
+	pgm_trace_event_shutdown();
+#endif
 	pgm_time_shutdown();
 
 #ifdef _WIN32
 	WSACleanup();
 #endif
 
+	if (engine_logring_is_running) {
+		pgm_logring_shutdown();
+		engine_logring_is_running = FALSE;
+	}
+	pgm_if_cache_shutdown();
+	pgm_latency_shutdown();
 	pgm_rand_shutdown();
 	pgm_mem_shutdown();
 	pgm_thread_shutdown();
@@ -263,6 +409,209 @@ pgm_shutdown (void)
 	return TRUE;
 }
 
+/* service due timers of every connected socket, skipping sockets being closed
+ * or with all receive shards held by application threads.
+ *
+ * returns the earliest timer expiration, or expiration if none earlier.
+ */
+
+static
+pgm_time_t
+engine_timer_sweep (
+	pgm_time_t		expiration
+	)
+{
+	unsigned epoch;
+	const pgm_sock_registry_t* registry = pgm_sock_registry_enter (&epoch);
+	for (unsigned n = 0; n < registry->len; n++)
+	{
+		pgm_sock_t* sock = registry->socks[ n ];
+		if (!pgm_rwlock_reader_trylock (&sock->lock))
+			continue;
+/* timers of an exclusive socket run on its owning thread alone */
+		if (!sock->is_connected || sock->is_destroyed || sock->is_exclusive) {
+			pgm_rwlock_reader_unlock (&sock->lock);
+			continue;
+		}
+		if (pgm_timer_check (sock)) {
+			for (unsigned i = 0; i < sock->rx_shard_len; i++) {
+				struct pgm_rx_shard_t* shard = &sock->rx_shard[ i ];
+				if (pgm_mutex_trylock (&shard->mutex)) {
+					pgm_timer_dispatch (sock, shard);
+					pgm_mutex_unlock (&shard->mutex);
+					break;
+				}
+			}
+		}
+		pgm_timer_lock (sock);
+		pgm_time_t next_poll = sock->next_poll;
+		pgm_timer_unlock (sock);
+/* a blocked send or held shard leaves the timer due, retry shortly */
+		const pgm_time_t now = pgm_time_update_now();
+		if (pgm_time_after_eq (now, next_poll))
+			next_poll = now + PGM_ENGINE_TIMER_RETRY;
+		if (pgm_time_after (expiration, next_poll))
+			expiration = next_poll;
+		pgm_rwlock_reader_unlock (&sock->lock);
+	}
+	pgm_sock_registry_leave (epoch);
+	return expiration;
+}
+
+/* wait on the wake notification until the deadline, returning early when a
+ * socket pulls its timer before it.  without connected sockets wait only on
+ * the notification.
+ */
+
+static
+void
+engine_timer_wait (
+	const pgm_time_t	deadline
+	)
+{
+	const SOCKET notify_fd = pgm_notify_get_socket (&engine_timer_notify);
+	int timeout = -1;
+	if (UINT64_MAX != deadline) {
+		const pgm_time_t now = pgm_time_update_now();
+		timeout = pgm_time_after (deadline, now) ? (int)MIN(pgm_to_msecs (deadline - now) + 1, INT_MAX) : 0;
+	}
+#ifdef HAVE_POLL
+	struct pollfd p = {
+		.fd		= notify_fd,
+		.events		= POLLIN,
+		.revents	= 0
+	};
+	poll (&p, 1, timeout /* ms */);
+#else
+	fd_set readfds;
+	FD_ZERO(&readfds);
+	FD_SET(notify_fd, &readfds);
+#	ifndef _WIN32
+	const int n_fds = notify_fd + 1;	/* largest fd + 1 */
+#	else
+	const int n_fds = 1;			/* count of fds */
+#	endif
+	struct timeval tv = {
+		.tv_sec  = timeout / 1000,
+		.tv_usec = (timeout % 1000) * 1000
+	};
+	select (n_fds, &readfds, NULL, NULL, timeout < 0 ? NULL : &tv);
+#endif /* HAVE_POLL */
+}
+
+static
+#ifndef _WIN32
+void*
+#else
+unsigned
+__stdcall
+#endif
+engine_timer_routine (
+	PGM_GNUC_UNUSED void*	arg
+	)
+{
+	pgm_thread_setup ("timer");
+	for (;;)
+	{
+/* wakes from here on force another sweep */
+		pgm_mutex_lock (&engine_timer_mutex);
+		if (engine_timer_is_terminated) {
+			pgm_mutex_unlock (&engine_timer_mutex);
+			break;
+		}
+		engine_timer_deadline = UINT64_MAX;
+		pgm_notify_clear (&engine_timer_notify);
+		pgm_mutex_unlock (&engine_timer_mutex);
+
+		const pgm_time_t expiration = engine_timer_sweep (UINT64_MAX);
+
+		pgm_mutex_lock (&engine_timer_mutex);
+		if (pgm_time_after (engine_timer_deadline, expiration))
+			engine_timer_deadline = expiration;
+		const pgm_time_t deadline = engine_timer_deadline;
+		pgm_mutex_unlock (&engine_timer_mutex);
+
+		engine_timer_wait (deadline);
+	}
+
+#ifndef _WIN32
+	return NULL;
+#else
+	_endthread();
+	return 0;
+#endif
+}
+
+/* returns TRUE on success, returns FALSE if the thread cannot be created and
+ * timers remain with the application.
+ */
+
+static
+bool
+engine_timer_create (void)
+{
+	if (0 != pgm_notify_init (&engine_timer_notify)) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Creating timer notification channel failed."));
+		return FALSE;
+	}
+	pgm_mutex_init (&engine_timer_mutex);
+	engine_timer_is_terminated = FALSE;
+	engine_timer_deadline = 0;
+
+#ifndef _WIN32
+	const int status = pthread_create (&engine_timer_thread, NULL, &engine_timer_routine, NULL);
+	if (0 != status) {
+#else
+	engine_timer_thread = (HANDLE)_beginthreadex (NULL, 0, &engine_timer_routine, NULL, 0, NULL);
+	if (0 == engine_timer_thread) {
+#endif /* _WIN32 */
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Creating timer thread failed, timers remain with the application."));
+		pgm_mutex_free (&engine_timer_mutex);
+		pgm_notify_destroy (&engine_timer_notify);
+		return FALSE;
+	}
+	engine_timer_is_running = TRUE;
+	return TRUE;
+}
+
+static
+void
+engine_timer_destroy (void)
+{
+	pgm_mutex_lock (&engine_timer_mutex);
+	engine_timer_is_terminated = TRUE;
+	pgm_notify_send (&engine_timer_notify);
+	pgm_mutex_unlock (&engine_timer_mutex);
+#ifndef _WIN32
+	pthread_join (engine_timer_thread, NULL);
+#else
+	WaitForSingleObject (engine_timer_thread, INFINITE);
+	CloseHandle (engine_timer_thread);
+#endif
+	engine_timer_is_running = FALSE;
+	pgm_mutex_free (&engine_timer_mutex);
+	pgm_notify_destroy (&engine_timer_notify);
+}
+
+/* wake the shared timer thread when a socket timer moves before its next sweep.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_engine_timer_wake (
+	const pgm_time_t	expiration
+	)
+{
+	if (!engine_timer_is_running)
+		return;
+	pgm_mutex_lock (&engine_timer_mutex);
+	if (pgm_time_after (engine_timer_deadline, expiration)) {
+		engine_timer_deadline = expiration;
+		pgm_notify_send (&engine_timer_notify);
+	}
+	pgm_mutex_unlock (&engine_timer_mutex);
+}
+
 /* helper to drop out of setuid 0 after creating PGM sockets
  */
 void
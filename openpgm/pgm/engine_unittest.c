@@ -40,13 +40,21 @@ struct pgm_slist_t;
 
 static gint mock_time_init = 0;
 static struct pgm_rwlock_t mock_pgm_sock_list_lock;
-static struct pgm_slist_t* mock_pgm_sock_list = NULL;
 
 #define pgm_time_init		mock_pgm_time_init
 #define pgm_time_shutdown	mock_pgm_time_shutdown
 #define pgm_close		mock_pgm_close
+#define pgm_timer_check		mock_pgm_timer_check
+#define pgm_timer_dispatch	mock_pgm_timer_dispatch
 #define pgm_sock_list_lock	mock_pgm_sock_list_lock
-#define pgm_sock_list		mock_pgm_sock_list
+#define pgm_stats_shm_init	mock_pgm_stats_shm_init
+#define pgm_stats_shm_shutdown	mock_pgm_stats_shm_shutdown
+#define pgm_stats_sampler_init	mock_pgm_stats_sampler_init
+#define pgm_stats_sampler_shutdown	mock_pgm_stats_sampler_shutdown
+#define pgm_logring_init	mock_pgm_logring_init
+#define pgm_logring_shutdown	mock_pgm_logring_shutdown
+#define pgm_if_cache_init	mock_pgm_if_cache_init
+#define pgm_if_cache_shutdown	mock_pgm_if_cache_shutdown
 
 #define ENGINE_DEBUG
 #include "engine.c"
@@ -105,6 +113,56 @@ mock_pgm_time_shutdown (void)
 	return TRUE;
 }
 
+bool
+mock_pgm_stats_shm_init (
+	const char*		name,
+	pgm_error_t**		error
+	)
+{
+	return TRUE;
+}
+
+bool
+mock_pgm_stats_shm_shutdown (void)
+{
+	return TRUE;
+}
+
+bool
+mock_pgm_stats_sampler_init (void)
+{
+	return TRUE;
+}
+
+void
+mock_pgm_stats_sampler_shutdown (void)
+{
+}
+
+bool
+mock_pgm_logring_init (
+	pgm_error_t**		error
+	)
+{
+	return TRUE;
+}
+
+bool
+mock_pgm_logring_shutdown (void)
+{
+	return TRUE;
+}
+
+void
+mock_pgm_if_cache_init (void)
+{
+}
+
+void
+mock_pgm_if_cache_shutdown (void)
+{
+}
+
 bool
 mock_pgm_close (
 	pgm_sock_t*		sock,
@@ -114,6 +172,25 @@ mock_pgm_close (
 	return TRUE;
 }
 
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_timer_check (
+	pgm_sock_t* const		sock
+	)
+{
+	return FALSE;
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_timer_dispatch (
+	pgm_sock_t* const		sock,
+	struct pgm_rx_shard_t* const	shard
+	)
+{
+	return TRUE;
+}
+
 
 /* target:
  *	bool
@@ -197,6 +274,18 @@ START_TEST (test_shutdown_pass_004)
 }
 END_TEST
 
+/* shared timer thread stopped before sockets */
+START_TEST (test_shutdown_pass_005)
+{
+	g_setenv ("PGM_TIMER_THREAD", "1", TRUE);
+	fail_unless (TRUE == pgm_init (NULL), "init failed");
+	g_unsetenv ("PGM_TIMER_THREAD");
+	fail_unless (TRUE == engine_timer_is_running, "timer thread not running");
+	fail_unless (TRUE == pgm_shutdown (), "shutdown failed");
+	fail_unless (FALSE == engine_timer_is_running, "timer thread still running");
+}
+END_TEST
+
 /* target:
  *	bool
  *	pgm_supported (void)
@@ -234,6 +323,7 @@ make_test_suite (void)
 	tcase_add_test (tc_shutdown, test_shutdown_pass_002);
 	tcase_add_test (tc_shutdown, test_shutdown_pass_003);
 	tcase_add_test (tc_shutdown, test_shutdown_pass_004);
+	tcase_add_test (tc_shutdown, test_shutdown_pass_005);
 	
 	TCase* tc_supported = tcase_create ("supported");
 	tcase_add_checked_fixture (tc_supported, mock_setup, mock_teardown);
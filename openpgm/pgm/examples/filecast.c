@@ -0,0 +1,399 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * Bulk file distribution over PGM.  The sender repeats every chunk of an
+ * object for a number of passes, a receiver writes each chunk at its offset
+ * the first time it arrives and ignores repeats, so a receiver that joins
+ * late or loses a whole transmission group completes on a later pass.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* MSVC secure CRT */
+#define _CRT_SECURE_NO_WARNINGS		1
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#	include <unistd.h>
+#	include <sys/time.h>
+#else
+#	include <io.h>
+#endif
+#ifdef __APPLE__
+#	include <pgm/in.h>
+#endif
+#include <pgm/pgm.h>
+
+#include "filecast.h"
+
+#ifdef _WIN32
+#	define open(p,f,m)	_open((p),(f)|_O_BINARY,(m))
+#	define close		_close
+#	define O_RDONLY		_O_RDONLY
+#	define O_WRONLY		_O_WRONLY
+#	define O_CREAT		_O_CREAT
+#endif
+
+
+static
+uint64_t
+hton64 (
+	const uint64_t	v
+	)
+{
+	if (1 == htonl (1))
+		return v;
+	return ((uint64_t)htonl ((uint32_t)v) << 32) | htonl ((uint32_t)(v >> 32));
+}
+
+#define ntoh64(v)	hton64(v)
+
+/* read or write the whole range at offset, without moving a shared file
+ * position on POSIX.
+ */
+
+static
+bool
+file_pread (
+	const int	fd,
+	void*		buf,
+	size_t		len,
+	uint64_t	offset
+	)
+{
+	char* p = (char*)buf;
+	while (len > 0) {
+#ifndef _WIN32
+		const ssize_t bytes_read = pread (fd, p, len, (off_t)offset);
+#else
+		if (-1 == _lseeki64 (fd, (__int64)offset, SEEK_SET))
+			return FALSE;
+		const int bytes_read = _read (fd, p, (unsigned)len);
+#endif
+		if (bytes_read <= 0) {
+			if (bytes_read < 0 && EINTR == errno)
+				continue;
+			return FALSE;
+		}
+		p += bytes_read;
+		len -= bytes_read;
+		offset += bytes_read;
+	}
+	return TRUE;
+}
+
+static
+bool
+file_pwrite (
+	const int	fd,
+	const void*	buf,
+	size_t		len,
+	uint64_t	offset
+	)
+{
+	const char* p = (const char*)buf;
+	while (len > 0) {
+#ifndef _WIN32
+		const ssize_t bytes_written = pwrite (fd, p, len, (off_t)offset);
+#else
+		if (-1 == _lseeki64 (fd, (__int64)offset, SEEK_SET))
+			return FALSE;
+		const int bytes_written = _write (fd, p, (unsigned)len);
+#endif
+		if (bytes_written <= 0) {
+			if (bytes_written < 0 && EINTR == errno)
+				continue;
+			return FALSE;
+		}
+		p += bytes_written;
+		len -= bytes_written;
+		offset += bytes_written;
+	}
+	return TRUE;
+}
+
+/* wall clock in microseconds for throughput reports.
+ */
+
+uint64_t
+filecast_now (void)
+{
+#ifndef _WIN32
+	struct timeval now;
+	gettimeofday (&now, NULL);
+	return (uint64_t)now.tv_sec * 1000000 + now.tv_usec;
+#else
+	FILETIME ft;
+	ULARGE_INTEGER now;
+	GetSystemTimeAsFileTime (&ft);
+	now.LowPart  = ft.dwLowDateTime;
+	now.HighPart = ft.dwHighDateTime;
+	return now.QuadPart / 10;
+#endif
+}
+
+/* send the file at path as object_id, every chunk once per pass.  the socket
+ * should be blocking such that the rate regulator paces each send.
+ *
+ * returns TRUE on success, FALSE on error with a message on stderr.
+ */
+
+bool
+filecast_send (
+	pgm_sock_t* const restrict	sock,
+	const char*	  restrict	path,
+	const uint32_t			object_id,
+	const size_t			chunk_size,
+	const unsigned			passes,
+	filecast_stats_t*	  restrict	stats
+	)
+{
+	struct filecast_header_t header;
+	char* buf = NULL;
+	int fd;
+#ifndef _WIN32
+	struct stat st;
+#else
+	struct _stati64 st;
+#endif
+
+	if (NULL == sock || NULL == path || 0 == chunk_size || chunk_size > UINT32_MAX || NULL == stats) {
+		fprintf (stderr, "Invalid arguments to filecast_send.\n");
+		return FALSE;
+	}
+
+	fd = open (path, O_RDONLY, 0);
+	if (-1 == fd) {
+		fprintf (stderr, "Opening %s: %s\n", path, strerror (errno));
+		return FALSE;
+	}
+#ifndef _WIN32
+	if (-1 == fstat (fd, &st)) {
+#else
+	if (-1 == _fstati64 (fd, &st)) {
+#endif
+		fprintf (stderr, "Reading size of %s: %s\n", path, strerror (errno));
+		close (fd);
+		return FALSE;
+	}
+	const uint64_t object_size = (uint64_t)st.st_size;
+
+	buf = malloc (sizeof(header) + chunk_size);
+	if (NULL == buf) {
+		fprintf (stderr, "Allocating %zu byte chunk buffer failed.\n", chunk_size);
+		close (fd);
+		return FALSE;
+	}
+
+	header.magic		= htonl (FILECAST_MAGIC);
+	header.object_id	= htonl (object_id);
+	header.object_size	= hton64 (object_size);
+	header.chunk_size	= htonl ((uint32_t)chunk_size);
+
+	memset (stats, 0, sizeof(filecast_stats_t));
+	stats->start = filecast_now();
+	for (unsigned pass = 0; pass < passes; pass++)
+	{
+		uint64_t offset = 0;
+/* an empty object is a single empty chunk */
+		do {
+			const size_t len = (object_size - offset) < chunk_size ? (size_t)(object_size - offset) : chunk_size;
+			if (!file_pread (fd, buf + sizeof(header), len, offset)) {
+				fprintf (stderr, "Reading %s at offset %" PRIu64 ": %s\n", path, offset, strerror (errno));
+				goto err_abort;
+			}
+			header.offset	= hton64 (offset);
+			header.len	= htonl ((uint32_t)len);
+			memcpy (buf, &header, sizeof(header));
+			const int status = pgm_send (sock, buf, sizeof(header) + len, NULL);
+			if (PGM_IO_STATUS_NORMAL != status) {
+				fprintf (stderr, "pgm_send() failed.\n");
+				goto err_abort;
+			}
+			stats->bytes += len;
+			stats->chunks++;
+			offset += len;
+		} while (offset < object_size);
+		stats->passes++;
+	}
+	stats->finish = filecast_now();
+
+	free (buf);
+	close (fd);
+	return TRUE;
+
+err_abort:
+	stats->finish = filecast_now();
+	free (buf);
+	close (fd);
+	return FALSE;
+}
+
+/* prepare to receive one object into path, the file is created on the first
+ * chunk.
+ */
+
+void
+filecast_recv_init (
+	filecast_recv_t* const restrict	recv,
+	const char*	       restrict	path
+	)
+{
+	memset (recv, 0, sizeof(filecast_recv_t));
+	recv->path = path;
+	recv->fd   = -1;
+}
+
+/* write one received APDU at its offset, the first chunk fixes the object,
+ * chunks of other objects are ignored.
+ *
+ * returns 1 for a new chunk, 0 for a repeat or an ignored APDU, -1 on error.
+ */
+
+int
+filecast_recv_chunk (
+	filecast_recv_t* const restrict	recv,
+	const void*	       restrict	buf,
+	const size_t			len
+	)
+{
+	struct filecast_header_t header;
+
+	if (len < sizeof(header))
+		return 0;
+	memcpy (&header, buf, sizeof(header));
+	if (FILECAST_MAGIC != ntohl (header.magic))
+		return 0;
+
+	const uint32_t object_id	= ntohl (header.object_id);
+	const uint64_t object_size	= ntoh64 (header.object_size);
+	const uint64_t offset		= ntoh64 (header.offset);
+	const uint32_t chunk_size	= ntohl (header.chunk_size);
+	const uint32_t chunk_len	= ntohl (header.len);
+
+	if (0 == chunk_size ||
+	    (len - sizeof(header)) != chunk_len ||
+	    0 != (offset % chunk_size) ||
+	    offset > object_size ||
+	    chunk_len != ((object_size - offset) < chunk_size ? (object_size - offset) : chunk_size))
+	{
+		fprintf (stderr, "Discarding malformed chunk at offset %" PRIu64 ".\n", offset);
+		return 0;
+	}
+
+	if (0 == recv->chunk_count)
+	{
+		const uint64_t chunk_count = object_size ? (object_size + chunk_size - 1) / chunk_size : 1;
+		if (chunk_count > UINT32_MAX) {
+			fprintf (stderr, "Object of %" PRIu64 " bytes has too many chunks.\n", object_size);
+			return -1;
+		}
+		recv->fd = open (recv->path, O_WRONLY | O_CREAT, 0644);
+		if (-1 == recv->fd) {
+			fprintf (stderr, "Opening %s: %s\n", recv->path, strerror (errno));
+			return -1;
+		}
+/* size the file up front such that chunks land in any order */
+#ifndef _WIN32
+		if (-1 == ftruncate (recv->fd, (off_t)object_size)) {
+#else
+		if (0 != _chsize_s (recv->fd, (__int64)object_size)) {
+#endif
+			fprintf (stderr, "Sizing %s to %" PRIu64 " bytes: %s\n", recv->path, object_size, strerror (errno));
+			return -1;
+		}
+		recv->bitmap = calloc ((size_t)((chunk_count + 7) / 8), 1);
+		if (NULL == recv->bitmap) {
+			fprintf (stderr, "Allocating chunk bitmap failed.\n");
+			return -1;
+		}
+		recv->object_id		= object_id;
+		recv->object_size	= object_size;
+		recv->chunk_size	= chunk_size;
+		recv->chunk_count	= (uint32_t)chunk_count;
+		recv->stats.start	= filecast_now();
+		printf ("Receiving object %" PRIu32 " of %" PRIu64 " bytes in %" PRIu32 " chunks.\n",
+			object_id, object_size, recv->chunk_count);
+	}
+	else if (object_id != recv->object_id || object_size != recv->object_size || chunk_size != recv->chunk_size)
+	{
+		return 0;
+	}
+
+	const uint32_t chunk = (uint32_t)(offset / chunk_size);
+	if (recv->bitmap[ chunk / 8 ] & (1 << (chunk % 8))) {
+		recv->stats.duplicate_bytes += chunk_len;
+		return 0;
+	}
+	if (!file_pwrite (recv->fd, (const char*)buf + sizeof(header), chunk_len, offset)) {
+		fprintf (stderr, "Writing %s at offset %" PRIu64 ": %s\n", recv->path, offset, strerror (errno));
+		return -1;
+	}
+	recv->bitmap[ chunk / 8 ] |= 1 << (chunk % 8);
+	recv->stats.bytes += chunk_len;
+	recv->stats.chunks++;
+	if (++recv->chunks_written == recv->chunk_count)
+		recv->stats.finish = filecast_now();
+	return 1;
+}
+
+void
+filecast_recv_close (
+	filecast_recv_t* const	recv
+	)
+{
+	if (-1 != recv->fd) {
+		close (recv->fd);
+		recv->fd = -1;
+	}
+	free (recv->bitmap);
+	recv->bitmap = NULL;
+}
+
+/* one line of totals and goodput, duplicates are data received again from a
+ * later carousel pass.
+ */
+
+void
+filecast_report (
+	FILE*		       restrict	fp,
+	const char*	       restrict	label,
+	const filecast_stats_t* const restrict	stats
+	)
+{
+	const uint64_t finish = stats->finish ? stats->finish : filecast_now();
+	const double secs = finish > stats->start ? (finish - stats->start) / 1000000.0 : 0.0;
+	fprintf (fp, "%s: %" PRIu64 " bytes in %" PRIu32 " chunks over %.3f s, %.2f Mb/s",
+		 label,
+		 stats->bytes,
+		 stats->chunks,
+		 secs,
+		 secs > 0.0 ? (stats->bytes * 8.0) / (secs * 1000000.0) : 0.0);
+	if (stats->passes)
+		fprintf (fp, ", %" PRIu32 " passes", stats->passes);
+	if (stats->duplicate_bytes)
+		fprintf (fp, ", %" PRIu64 " duplicate bytes", stats->duplicate_bytes);
+	fputs (".\n", fp);
+}
+
+/* eof */
@@ -0,0 +1,98 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Bulk file distribution over PGM, objects are cut into self-describing
+ * chunks sent under heavy proactive parity and repeated as a carousel such
+ * that receivers recover from loss without NAKs.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __PGM_FILECAST_H__
+#define __PGM_FILECAST_H__
+
+#include <stdio.h>
+#ifdef __APPLE__
+#	include <pgm/in.h>
+#endif
+#include <pgm/pgm.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/* bytes of file data per APDU by default */
+#define FILECAST_DEFAULT_CHUNK_SIZE	(64 * 1024)
+
+/* largest transmission group and the parity sent with each, 32 of 160
+ * packets may be lost per group before a receiver has to NAK.
+ */
+#define FILECAST_DEFAULT_RS_K		128
+#define FILECAST_DEFAULT_RS_N		255
+#define FILECAST_DEFAULT_PROACTIVE	32
+
+/* every APDU carries one chunk after this header, network order */
+struct filecast_header_t {
+	uint32_t		magic;
+	uint32_t		object_id;
+	uint64_t		object_size;
+	uint64_t		offset;
+	uint32_t		chunk_size;		/* of every chunk but the last */
+	uint32_t		len;			/* of this chunk */
+};
+
+#define FILECAST_MAGIC			0x50474d46	/* "PGMF" */
+
+struct filecast_stats_t {
+	uint64_t		bytes;			/* file data sent or written */
+	uint64_t		duplicate_bytes;	/* received again on a later pass */
+	uint32_t		chunks;
+	uint32_t		passes;
+	uint64_t		start;			/* μs */
+	uint64_t		finish;
+};
+typedef struct filecast_stats_t filecast_stats_t;
+
+struct filecast_recv_t {
+	const char*		path;
+	int			fd;
+	uint32_t		object_id;
+	uint64_t		object_size;
+	uint32_t		chunk_size;
+	uint32_t		chunk_count;
+	uint32_t		chunks_written;
+	uint8_t*		bitmap;			/* of chunks written */
+	filecast_stats_t	stats;
+};
+typedef struct filecast_recv_t filecast_recv_t;
+
+uint64_t filecast_now (void);
+bool filecast_send (pgm_sock_t*const restrict, const char*restrict, const uint32_t, const size_t, const unsigned, filecast_stats_t*restrict);
+void filecast_recv_init (filecast_recv_t*const restrict, const char*restrict);
+int filecast_recv_chunk (filecast_recv_t*const restrict, const void*restrict, const size_t);
+void filecast_recv_close (filecast_recv_t*const);
+void filecast_report (FILE*restrict, const char*restrict, const filecast_stats_t*const restrict);
+
+static inline bool filecast_recv_is_complete (const filecast_recv_t*const recv)
+{
+	return 0 != recv->chunk_count && recv->chunks_written == recv->chunk_count;
+}
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __PGM_FILECAST_H__ */
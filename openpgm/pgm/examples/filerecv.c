@@ -0,0 +1,500 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * Bulk file receiver.  Writes each chunk of one object straight to the
+ * output file at its offset and exits once every chunk has arrived, lost
+ * transmission groups are recovered from parity or a later carousel pass
+ * before resorting to NAKs.  Pairs up with filesend.c as the send-side.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* MSVC secure CRT */
+#define _CRT_SECURE_NO_WARNINGS		1
+
+#include <assert.h>
+#include <inttypes.h>
+#include <locale.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _MSC_VER
+#	include <tchar.h>
+#endif
+#ifndef _WIN32
+#	include <unistd.h>
+#	include <getopt.h>
+#else
+#	include "getopt.h"
+#endif
+#ifdef __APPLE__
+#	include <pgm/in.h>
+#endif
+#include <pgm/pgm.h>
+
+#include "filecast.h"
+
+/* globals */
+
+static int		port = 0;
+static const char*	network = "";
+static bool		use_multicast_loop = FALSE;
+static int		udp_encap_port = 0;
+
+static int		max_tpdu = 1500;
+static int		sqns = 8192;
+static int		chunk_size = FILECAST_DEFAULT_CHUNK_SIZE;
+
+static pgm_sock_t*	sock = NULL;
+static filecast_recv_t	recv_object;
+static bool		is_terminated = FALSE;
+
+#ifndef _WIN32
+static int		terminate_pipe[2];
+static void on_signal (int);
+#else
+static WSAEVENT		terminateEvent;
+static BOOL on_console_ctrl (DWORD);
+#endif
+#ifndef _MSC_VER
+static void usage (const char*) __attribute__((__noreturn__));
+#else
+static void usage (const char*);
+#endif
+
+static bool on_startup (void);
+static int on_data (const void*restrict, const size_t, const struct pgm_sockaddr_t*restrict);
+static void on_progress (void);
+
+
+static void
+usage (
+	const char*	bin
+	)
+{
+	fprintf (stderr, "Usage: %s [options] file\n", bin);
+	fprintf (stderr, "  -n, --network NETWORK    : Multicast group or unicast IP address\n");
+	fprintf (stderr, "  -s, --service PORT       : IP port\n");
+	fprintf (stderr, "  -p, --port PORT          : Encapsulate PGM in UDP on IP port\n");
+	fprintf (stderr, "  -c, --chunk-size BYTES   : Largest file data per message (%d)\n", FILECAST_DEFAULT_CHUNK_SIZE);
+	fprintf (stderr, "  -l, --enable-loop        : Enable multicast loopback and address sharing\n");
+	fprintf (stderr, "  -i, --list               : List available interfaces\n");
+	exit (EXIT_SUCCESS);
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	pgm_error_t* pgm_err = NULL;
+	int retval = EXIT_SUCCESS;
+
+	setlocale (LC_ALL, "");
+
+	if (!pgm_init (&pgm_err)) {
+		fprintf (stderr, "Unable to start PGM engine: %s\n", pgm_err->message);
+		pgm_error_free (pgm_err);
+		return EXIT_FAILURE;
+	}
+
+/* parse program arguments */
+#ifdef _WIN32
+	const char* binary_name = strrchr (argv[0], '\\');
+#else
+	const char* binary_name = strrchr (argv[0], '/');
+#endif
+	if (NULL == binary_name)	binary_name = argv[0];
+	else				binary_name++;
+
+	static struct option long_options[] = {
+		{ "network",        required_argument, NULL, 'n' },
+		{ "service",        required_argument, NULL, 's' },
+		{ "port",           required_argument, NULL, 'p' },
+		{ "chunk-size",     required_argument, NULL, 'c' },
+		{ "enable-loop",    no_argument,       NULL, 'l' },
+		{ "list",           no_argument,       NULL, 'i' },
+		{ "help",           no_argument,       NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	int c;
+	while ((c = getopt_long (argc, argv, "s:n:p:c:lih", long_options, NULL)) != -1)
+	{
+		switch (c) {
+		case 'n':	network = optarg; break;
+		case 's':	port = atoi (optarg); break;
+		case 'p':	udp_encap_port = atoi (optarg); break;
+		case 'c':	chunk_size = atoi (optarg); break;
+		case 'l':	use_multicast_loop = TRUE; break;
+
+		case 'i':
+			pgm_if_print_all();
+			return EXIT_SUCCESS;
+
+		case 'h':
+		case '?': usage (binary_name);
+		}
+	}
+
+	if (optind + 1 != argc || chunk_size <= 0)
+		usage (binary_name);
+	filecast_recv_init (&recv_object, argv[optind]);
+
+/* a whole chunk and header per call such that no APDU is truncated */
+	const size_t buflen = sizeof(struct filecast_header_t) + chunk_size;
+	char* buffer = malloc (buflen);
+	if (NULL == buffer) {
+		fprintf (stderr, "Allocating %zu byte receive buffer failed.\n", buflen);
+		return EXIT_FAILURE;
+	}
+
+/* setup signal handlers */
+#ifdef SIGHUP
+	signal (SIGHUP,  SIG_IGN);
+#endif
+#ifndef _WIN32
+	int e = pipe (terminate_pipe);
+	assert (0 == e);
+	signal (SIGINT,  on_signal);
+	signal (SIGTERM, on_signal);
+#else
+	terminateEvent = WSACreateEvent();
+	SetConsoleCtrlHandler ((PHANDLER_ROUTINE)on_console_ctrl, TRUE);
+	setvbuf (stdout, (char *) NULL, _IONBF, 0);
+#endif /* !_WIN32 */
+
+	if (!on_startup()) {
+		fprintf (stderr, "Startup failed\n");
+		return EXIT_FAILURE;
+	}
+
+/* dispatch loop */
+#ifndef _WIN32
+	int fds;
+	fd_set readfds;
+#else
+	SOCKET recv_sock, pending_sock;
+	DWORD cEvents = PGM_RECV_SOCKET_READ_COUNT + 1;
+	WSAEVENT waitEvents[ PGM_RECV_SOCKET_READ_COUNT + 1 ];
+	socklen_t socklen = sizeof (SOCKET);
+
+	waitEvents[0] = terminateEvent;
+	waitEvents[1] = WSACreateEvent();
+	waitEvents[2] = WSACreateEvent();
+	assert (2 == PGM_RECV_SOCKET_READ_COUNT);
+	pgm_getsockopt (sock, IPPROTO_PGM, PGM_RECV_SOCK, &recv_sock, &socklen);
+	WSAEventSelect (recv_sock, waitEvents[1], FD_READ);
+	pgm_getsockopt (sock, IPPROTO_PGM, PGM_PENDING_SOCK, &pending_sock, &socklen);
+	WSAEventSelect (pending_sock, waitEvents[2], FD_READ);
+#endif /* !_WIN32 */
+	puts ("Entering PGM message loop ... ");
+	uint64_t next_progress = filecast_now() + 1000000;
+	do {
+		struct timeval tv;
+#ifdef _WIN32
+		DWORD dwTimeout, dwEvents;
+#endif
+		size_t len;
+		struct pgm_sockaddr_t from;
+		socklen_t fromlen = sizeof (from);
+		const int status = pgm_recvfrom (sock,
+					         buffer,
+					         buflen,
+					         0,
+					         &len,
+					         &from,
+						 &fromlen,
+					         &pgm_err);
+		switch (status) {
+		case PGM_IO_STATUS_NORMAL:
+			if (on_data (buffer, len, &from) < 0) {
+				retval = EXIT_FAILURE;
+				is_terminated = TRUE;
+			}
+			break;
+		case PGM_IO_STATUS_TIMER_PENDING:
+			{
+				socklen_t optlen = sizeof (tv);
+				pgm_getsockopt (sock, IPPROTO_PGM, PGM_TIME_REMAIN, &tv, &optlen);
+			}
+			goto block;
+		case PGM_IO_STATUS_RATE_LIMITED:
+			{
+				socklen_t optlen = sizeof (tv);
+				pgm_getsockopt (sock, IPPROTO_PGM, PGM_RATE_REMAIN, &tv, &optlen);
+			}
+		case PGM_IO_STATUS_WOULD_BLOCK:
+/* select for next event */
+block:
+#ifndef _WIN32
+			fds = terminate_pipe[0] + 1;
+			FD_ZERO(&readfds);
+			FD_SET(terminate_pipe[0], &readfds);
+			pgm_select_info (sock, &readfds, NULL, &fds);
+			fds = select (fds, &readfds, NULL, NULL, PGM_IO_STATUS_WOULD_BLOCK == status ? NULL : &tv);
+#else
+			dwTimeout = PGM_IO_STATUS_WOULD_BLOCK == status ? WSA_INFINITE : (DWORD)((tv.tv_sec * 1000) + (tv.tv_usec / 1000));
+			dwEvents = WSAWaitForMultipleEvents (cEvents, waitEvents, FALSE, dwTimeout, FALSE);
+			switch (dwEvents) {
+			case WSA_WAIT_EVENT_0+1: WSAResetEvent (waitEvents[1]); break;
+			case WSA_WAIT_EVENT_0+2: WSAResetEvent (waitEvents[2]); break;
+			default: break;
+			}
+#endif /* !_WIN32 */
+			break;
+
+		default:
+			if (pgm_err) {
+				fprintf (stderr, "%s\n", pgm_err->message);
+				pgm_error_free (pgm_err);
+				pgm_err = NULL;
+			}
+			if (PGM_IO_STATUS_ERROR == status)
+				break;
+		}
+		if (filecast_now() >= next_progress) {
+			on_progress();
+			next_progress += 1000000;
+		}
+	} while (!is_terminated);
+
+	puts ("Message loop terminated, cleaning up.");
+	if (filecast_recv_is_complete (&recv_object)) {
+		filecast_report (stdout, recv_object.path, &recv_object.stats);
+	} else {
+		on_progress();
+		fprintf (stderr, "%s is incomplete.\n", recv_object.path);
+		retval = EXIT_FAILURE;
+	}
+	filecast_recv_close (&recv_object);
+	free (buffer);
+
+/* cleanup */
+#ifndef _WIN32
+	close (terminate_pipe[0]);
+	close (terminate_pipe[1]);
+#else
+	WSACloseEvent (waitEvents[0]);
+	WSACloseEvent (waitEvents[1]);
+	WSACloseEvent (waitEvents[2]);
+#endif /* !_WIN32 */
+
+	if (sock) {
+		puts ("Destroying PGM socket.");
+		pgm_close (sock, TRUE);
+		sock = NULL;
+	}
+
+	puts ("PGM engine shutdown.");
+	pgm_shutdown ();
+	puts ("finished.");
+	return retval;
+}
+
+#ifndef _WIN32
+static
+void
+on_signal (
+	int		signum
+	)
+{
+	printf ("on_signal (signum:%d)\n", signum);
+	is_terminated = TRUE;
+	const char one = '1';
+	const size_t writelen = write (terminate_pipe[1], &one, sizeof(one));
+	assert (sizeof(one) == writelen);
+}
+#else
+static
+BOOL
+on_console_ctrl (
+	DWORD		dwCtrlType
+	)
+{
+	printf ("on_console_ctrl (dwCtrlType:%lu)\n", (unsigned long)dwCtrlType);
+	is_terminated = TRUE;
+	WSASetEvent (terminateEvent);
+	return TRUE;
+}
+#endif /* !_WIN32 */
+
+static
+bool
+on_startup (void)
+{
+	struct pgm_addrinfo_t* res = NULL;
+	pgm_error_t* pgm_err = NULL;
+	sa_family_t sa_family = AF_UNSPEC;
+
+/* parse network parameter into PGM socket address structure */
+	if (!pgm_getaddrinfo (network, NULL, &res, &pgm_err)) {
+		fprintf (stderr, "Parsing network parameter: %s\n", pgm_err->message);
+		goto err_abort;
+	} else {
+		char s[1024];
+		printf ("Network parameter: { %s }\n", pgm_addrinfo_to_string (res, s, sizeof (s)));
+	}
+
+	sa_family = res->ai_send_addrs[0].gsr_group.ss_family;
+
+	if (udp_encap_port) {
+		puts ("Create PGM/UDP socket.");
+		if (!pgm_socket (&sock, sa_family, SOCK_SEQPACKET, IPPROTO_UDP, &pgm_err)) {
+			fprintf (stderr, "Creating PGM/UDP socket: %s\n", pgm_err->message);
+			goto err_abort;
+		}
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_UDP_ENCAP_UCAST_PORT, &udp_encap_port, sizeof(udp_encap_port));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_UDP_ENCAP_MCAST_PORT, &udp_encap_port, sizeof(udp_encap_port));
+	} else {
+		puts ("Create PGM/IP socket.");
+		if (!pgm_socket (&sock, sa_family, SOCK_SEQPACKET, IPPROTO_PGM, &pgm_err)) {
+			fprintf (stderr, "Creating PGM/IP socket: %s\n", pgm_err->message);
+			goto err_abort;
+		}
+	}
+
+/* Use RFC 2113 tagging for PGM Router Assist */
+	const int no_router_assist = 0;
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_IP_ROUTER_ALERT, &no_router_assist, sizeof(no_router_assist));
+
+	pgm_drop_superuser();
+
+/* set PGM parameters */
+	const int recv_only = 1,
+		  passive = 0,
+		  peer_expiry = pgm_secs (300),
+		  spmr_expiry = pgm_msecs (250),
+		  nak_bo_ivl = pgm_msecs (250),		/* let proactive parity arrive first */
+		  nak_rpt_ivl = pgm_secs (2),
+		  nak_rdata_ivl = pgm_secs (2),
+		  nak_data_retries = 5,			/* then wait for the next pass */
+		  nak_ncf_retries = 5;
+
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_RECV_ONLY, &recv_only, sizeof(recv_only));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_PASSIVE, &passive, sizeof(passive));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_MTU, &max_tpdu, sizeof(max_tpdu));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_RXW_SQNS, &sqns, sizeof(sqns));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_PEER_EXPIRY, &peer_expiry, sizeof(peer_expiry));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_SPMR_EXPIRY, &spmr_expiry, sizeof(spmr_expiry));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_BO_IVL, &nak_bo_ivl, sizeof(nak_bo_ivl));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_RPT_IVL, &nak_rpt_ivl, sizeof(nak_rpt_ivl));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_RDATA_IVL, &nak_rdata_ivl, sizeof(nak_rdata_ivl));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_DATA_RETRIES, &nak_data_retries, sizeof(nak_data_retries));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_NCF_RETRIES, &nak_ncf_retries, sizeof(nak_ncf_retries));
+/* parity decoding follows the parameters advertised in the source's SPMs */
+
+/* create global session identifier */
+	struct pgm_sockaddr_t addr;
+	memset (&addr, 0, sizeof(addr));
+	addr.sa_port = port ? port : DEFAULT_DATA_DESTINATION_PORT;
+	addr.sa_addr.sport = DEFAULT_DATA_SOURCE_PORT;
+	if (!pgm_gsi_create_from_hostname (&addr.sa_addr.gsi, &pgm_err)) {
+		fprintf (stderr, "Creating GSI: %s\n", pgm_err->message);
+		goto err_abort;
+	}
+
+/* assign socket to specified address */
+	struct pgm_interface_req_t if_req;
+	memset (&if_req, 0, sizeof(if_req));
+	if_req.ir_interface = res->ai_recv_addrs[0].gsr_interface;
+	memcpy (&if_req.ir_address, &res->ai_send_addrs[0].gsr_addr, sizeof(struct sockaddr_storage));
+	if (!pgm_bind3 (sock,
+			&addr, sizeof(addr),
+			&if_req, sizeof(if_req),	/* tx interface */
+			&if_req, sizeof(if_req),	/* rx interface */
+			&pgm_err))
+	{
+		fprintf (stderr, "Binding PGM socket: %s\n", pgm_err->message);
+		goto err_abort;
+	}
+
+/* join IP multicast groups */
+	for (unsigned i = 0; i < res->ai_recv_addrs_len; i++)
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_JOIN_GROUP, &res->ai_recv_addrs[i], sizeof(struct pgm_group_source_req));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_SEND_GROUP, &res->ai_send_addrs[0], sizeof(struct pgm_group_source_req));
+
+	pgm_freeaddrinfo (res);
+
+/* set IP parameters */
+	const int nonblocking = 1,
+		  multicast_loop = use_multicast_loop ? 1 : 0,
+		  multicast_hops = 16,
+		  dscp = 0x2e << 2;		/* Expedited Forwarding PHB for network elements, no ECN. */
+
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_MULTICAST_LOOP, &multicast_loop, sizeof(multicast_loop));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_MULTICAST_HOPS, &multicast_hops, sizeof(multicast_hops));
+	if (AF_INET6 != sa_family)
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_TOS, &dscp, sizeof(dscp));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NOBLOCK, &nonblocking, sizeof(nonblocking));
+
+	if (!pgm_connect (sock, &pgm_err)) {
+		fprintf (stderr, "Connecting PGM socket: %s\n", pgm_err->message);
+		goto err_abort;
+	}
+
+	puts ("Startup complete.");
+	return TRUE;
+
+err_abort:
+	if (NULL != sock) {
+		pgm_close (sock, FALSE);
+		sock = NULL;
+	}
+	if (NULL != res) {
+		pgm_freeaddrinfo (res);
+		res = NULL;
+	}
+	if (NULL != pgm_err) {
+		pgm_error_free (pgm_err);
+		pgm_err = NULL;
+	}
+	if (NULL != sock) {
+		pgm_close (sock, FALSE);
+		sock = NULL;
+	}
+	return FALSE;
+}
+
+static
+int
+on_data (
+	const void*     	     restrict data,
+	const size_t		  	      len,
+	const struct pgm_sockaddr_t* restrict from
+	)
+{
+	(void)from;
+	const int status = filecast_recv_chunk (&recv_object, data, len);
+	if (filecast_recv_is_complete (&recv_object))
+		is_terminated = TRUE;
+	return status;
+}
+
+/* running totals once a second */
+
+static
+void
+on_progress (void)
+{
+	if (0 == recv_object.chunk_count)
+		return;
+	printf ("%" PRIu32 "/%" PRIu32 " chunks, ", recv_object.chunks_written, recv_object.chunk_count);
+	filecast_report (stdout, recv_object.path, &recv_object.stats);
+}
+
+/* eof */
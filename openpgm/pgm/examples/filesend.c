@@ -0,0 +1,326 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * Bulk file sender.  Each file is sent as an object of chunks under heavy
+ * proactive parity and repeated for a number of carousel passes such that
+ * receivers complete without NAKs.  Pairs up with filerecv.c.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifndef _WIN32
+#	include <unistd.h>
+#	include <getopt.h>
+#else
+#	include "getopt.h"
+#endif
+#ifdef __APPLE__
+#	include <pgm/in.h>
+#endif
+#include <pgm/pgm.h>
+
+#include "filecast.h"
+
+
+/* globals */
+
+static int		port = 0;
+static const char*	network = "";
+static bool		use_multicast_loop = FALSE;
+static int		udp_encap_port = 0;
+
+static int		max_tpdu = 1500;
+static int		max_rte = 10*1000*1000;		/* 80mb/s */
+static int		sqns = 8192;
+
+static int		rs_k = FILECAST_DEFAULT_RS_K;
+static int		rs_n = FILECAST_DEFAULT_RS_N;
+static int		rs_h = FILECAST_DEFAULT_PROACTIVE;
+static int		chunk_size = FILECAST_DEFAULT_CHUNK_SIZE;
+static int		passes = 3;
+
+static pgm_sock_t*	sock = NULL;
+
+#ifndef _MSC_VER
+static void usage (const char*) __attribute__((__noreturn__));
+#else
+static void usage (const char*);
+#endif
+static bool create_sock (void);
+
+
+static void
+usage (
+	const char*	bin
+	)
+{
+	fprintf (stderr, "Usage: %s [options] file ...\n", bin);
+	fprintf (stderr, "  -n, --network NETWORK    : Multicast group or unicast IP address\n");
+	fprintf (stderr, "  -s, --service PORT       : IP port\n");
+	fprintf (stderr, "  -p, --port PORT          : Encapsulate PGM in UDP on IP port\n");
+	fprintf (stderr, "  -r, --speed-limit RATE   : Regulate to RATE bytes per second\n");
+	fprintf (stderr, "  -N N                     : Reed-Solomon block size (%d)\n", FILECAST_DEFAULT_RS_N);
+	fprintf (stderr, "  -K K                     : Reed-Solomon group size (%d)\n", FILECAST_DEFAULT_RS_K);
+	fprintf (stderr, "  -H H                     : Proactive parity packets per group (%d)\n", FILECAST_DEFAULT_PROACTIVE);
+	fprintf (stderr, "  -c, --chunk-size BYTES   : File data per message (%d)\n", FILECAST_DEFAULT_CHUNK_SIZE);
+	fprintf (stderr, "  -P, --passes COUNT       : Carousel passes over each file (3)\n");
+	fprintf (stderr, "  -l, --enable-loop        : Enable multicast loopback and address sharing\n");
+	fprintf (stderr, "  -i, --list               : List available interfaces\n");
+	exit (EXIT_SUCCESS);
+}
+
+int
+main (
+	int	argc,
+	char   *argv[]
+	)
+{
+	pgm_error_t* pgm_err = NULL;
+	int retval = EXIT_SUCCESS;
+
+	setlocale (LC_ALL, "");
+
+	if (!pgm_init (&pgm_err)) {
+		fprintf (stderr, "Unable to start PGM engine: %s\n", pgm_err->message);
+		pgm_error_free (pgm_err);
+		return EXIT_FAILURE;
+	}
+
+/* parse program arguments */
+#ifdef _WIN32
+	const char* binary_name = strrchr (argv[0], '\\');
+#else
+	const char* binary_name = strrchr (argv[0], '/');
+#endif
+	if (NULL == binary_name)	binary_name = argv[0];
+	else				binary_name++;
+
+	static struct option long_options[] = {
+		{ "network",        required_argument, NULL, 'n' },
+		{ "service",        required_argument, NULL, 's' },
+		{ "port",           required_argument, NULL, 'p' },
+		{ "speed-limit",    required_argument, NULL, 'r' },
+		{ "chunk-size",     required_argument, NULL, 'c' },
+		{ "passes",         required_argument, NULL, 'P' },
+		{ "enable-loop",    no_argument,       NULL, 'l' },
+		{ "list",           no_argument,       NULL, 'i' },
+		{ "help",           no_argument,       NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	int c;
+	while ((c = getopt_long (argc, argv, "s:n:p:r:K:N:H:c:P:lih", long_options, NULL)) != -1)
+	{
+		switch (c) {
+		case 'n':	network = optarg; break;
+		case 's':	port = atoi (optarg); break;
+		case 'p':	udp_encap_port = atoi (optarg); break;
+		case 'r':	max_rte = atoi (optarg); break;
+		case 'K':	rs_k = atoi (optarg); break;
+		case 'N':	rs_n = atoi (optarg); break;
+		case 'H':	rs_h = atoi (optarg); break;
+		case 'c':	chunk_size = atoi (optarg); break;
+		case 'P':	passes = atoi (optarg); break;
+
+		case 'l':	use_multicast_loop = TRUE; break;
+
+		case 'i':
+			pgm_if_print_all();
+			return EXIT_SUCCESS;
+
+		case 'h':
+		case '?':
+			usage (binary_name);
+		}
+	}
+
+	if (optind == argc || chunk_size <= 0 || passes <= 0)
+		usage (binary_name);
+
+	if (create_sock())
+	{
+		filecast_stats_t total;
+		memset (&total, 0, sizeof(total));
+		total.start = filecast_now();
+		for (uint32_t object_id = 1; optind < argc; optind++, object_id++) {
+			filecast_stats_t stats;
+			if (!filecast_send (sock, argv[optind], object_id, chunk_size, passes, &stats)) {
+				retval = EXIT_FAILURE;
+				break;
+			}
+			filecast_report (stdout, argv[optind], &stats);
+			total.bytes  += stats.bytes;
+			total.chunks += stats.chunks;
+		}
+		total.finish = filecast_now();
+		filecast_report (stdout, "Total", &total);
+	} else {
+		retval = EXIT_FAILURE;
+	}
+
+/* cleanup, a graceful close lingers for repairs of the final pass */
+	if (sock) {
+		pgm_close (sock, TRUE);
+		sock = NULL;
+	}
+	pgm_shutdown();
+	return retval;
+}
+
+static
+bool
+create_sock (void)
+{
+	struct pgm_addrinfo_t* res = NULL;
+	pgm_error_t* pgm_err = NULL;
+	sa_family_t sa_family = AF_UNSPEC;
+
+/* parse network parameter into PGM socket address structure */
+	if (!pgm_getaddrinfo (network, NULL, &res, &pgm_err)) {
+		fprintf (stderr, "Parsing network parameter: %s\n", pgm_err->message);
+		goto err_abort;
+	} else {
+		char s[1024];
+		printf ("Network parameter: { %s }\n", pgm_addrinfo_to_string (res, s, sizeof (s)));
+	}
+
+	sa_family = res->ai_send_addrs[0].gsr_group.ss_family;
+
+	if (udp_encap_port) {
+		if (!pgm_socket (&sock, sa_family, SOCK_SEQPACKET, IPPROTO_UDP, &pgm_err)) {
+			fprintf (stderr, "Creating PGM/UDP socket: %s\n", pgm_err->message);
+			goto err_abort;
+		}
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_UDP_ENCAP_UCAST_PORT, &udp_encap_port, sizeof(udp_encap_port));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_UDP_ENCAP_MCAST_PORT, &udp_encap_port, sizeof(udp_encap_port));
+	} else {
+		if (!pgm_socket (&sock, sa_family, SOCK_SEQPACKET, IPPROTO_PGM, &pgm_err)) {
+			fprintf (stderr, "Creating PGM/IP socket: %s\n", pgm_err->message);
+			goto err_abort;
+		}
+	}
+
+/* Use RFC 2113 tagging for PGM Router Assist */
+	const int no_router_assist = 0;
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_IP_ROUTER_ALERT, &no_router_assist, sizeof(no_router_assist));
+
+	pgm_drop_superuser();
+
+/* set PGM parameters */
+	const int send_only = 1,
+		  ambient_spm = pgm_secs (30),
+		  heartbeat_spm[] = { pgm_msecs (100),
+				      pgm_msecs (100),
+                                      pgm_msecs (100),
+				      pgm_msecs (100),
+				      pgm_msecs (1300),
+				      pgm_secs  (7),
+				      pgm_secs  (16),
+				      pgm_secs  (25),
+				      pgm_secs  (30) };
+
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_SEND_ONLY, &send_only, sizeof(send_only));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_MTU, &max_tpdu, sizeof(max_tpdu));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_TXW_SQNS, &sqns, sizeof(sqns));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_TXW_MAX_RTE, &max_rte, sizeof(max_rte));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_AMBIENT_SPM, &ambient_spm, sizeof(ambient_spm));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_HEARTBEAT_SPM, &heartbeat_spm, sizeof(heartbeat_spm));
+
+/* proactive parity with every transmission group, on-demand parity repairs
+ * the rare group that loses more.
+ */
+	struct pgm_fecinfo_t fecinfo;
+	fecinfo.block_size		= rs_n;
+	fecinfo.proactive_packets	= rs_h;
+	fecinfo.group_size		= rs_k;
+	fecinfo.ondemand_parity_enabled	= TRUE;
+	fecinfo.var_pktlen_enabled	= TRUE;
+	if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_USE_FEC, &fecinfo, sizeof(fecinfo))) {
+		fprintf (stderr, "Invalid Reed-Solomon parameters RS(%d,%d) with %d proactive.\n", rs_n, rs_k, rs_h);
+		goto err_abort;
+	}
+
+/* create global session identifier */
+	struct pgm_sockaddr_t addr;
+	memset (&addr, 0, sizeof(addr));
+	addr.sa_port = port ? port : DEFAULT_DATA_DESTINATION_PORT;
+	addr.sa_addr.sport = DEFAULT_DATA_SOURCE_PORT;
+	if (!pgm_gsi_create_from_hostname (&addr.sa_addr.gsi, &pgm_err)) {
+		fprintf (stderr, "Creating GSI: %s\n", pgm_err->message);
+		goto err_abort;
+	}
+
+/* assign socket to specified address */
+	struct pgm_interface_req_t if_req;
+	memset (&if_req, 0, sizeof(if_req));
+	if_req.ir_interface = res->ai_recv_addrs[0].gsr_interface;
+	memcpy (&if_req.ir_address, &res->ai_send_addrs[0].gsr_addr, sizeof(struct sockaddr_storage));
+	if (!pgm_bind3 (sock,
+			&addr, sizeof(addr),
+			&if_req, sizeof(if_req),	/* tx interface */
+			&if_req, sizeof(if_req),	/* rx interface */
+			&pgm_err))
+	{
+		fprintf (stderr, "Binding PGM socket: %s\n", pgm_err->message);
+		goto err_abort;
+	}
+
+/* join IP multicast groups */
+	unsigned i;
+	for (i = 0; i < res->ai_recv_addrs_len; i++)
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_JOIN_GROUP, &res->ai_recv_addrs[i], sizeof(struct pgm_group_source_req));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_SEND_GROUP, &res->ai_send_addrs[0], sizeof(struct pgm_group_source_req));
+	pgm_freeaddrinfo (res);
+
+/* set IP parameters */
+	const int blocking = 0,
+		  multicast_loop = use_multicast_loop ? 1 : 0,
+		  multicast_hops = 16,
+		  dscp = 0x2e << 2;		/* Expedited Forwarding PHB for network elements, no ECN. */
+
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_MULTICAST_LOOP, &multicast_loop, sizeof(multicast_loop));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_MULTICAST_HOPS, &multicast_hops, sizeof(multicast_hops));
+	if (AF_INET6 != sa_family)
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_TOS, &dscp, sizeof(dscp));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NOBLOCK, &blocking, sizeof(blocking));
+
+	if (!pgm_connect (sock, &pgm_err)) {
+		fprintf (stderr, "Connecting PGM socket: %s\n", pgm_err->message);
+		goto err_abort;
+	}
+
+	return TRUE;
+
+err_abort:
+	if (NULL != sock) {
+		pgm_close (sock, FALSE);
+		sock = NULL;
+	}
+	if (NULL != res) {
+		pgm_freeaddrinfo (res);
+		res = NULL;
+	}
+	if (NULL != pgm_err) {
+		pgm_error_free (pgm_err);
+		pgm_err = NULL;
+	}
+	return FALSE;
+}
+
+/* eof */
@@ -34,6 +34,9 @@
 #	include <arpa/inet.h>
 #	include <netinet/in.h>
 #	include <sys/socket.h>
+#	include <getopt.h>
+#else
+#	include "getopt.h"
 #endif
 
 #include <pgm/pgm.h>
@@ -48,12 +51,24 @@
 #include <pgm/log.h>
 
 
+/* pcap file format with raw IP link-layer for pgmreplay or PGM_REPLAY */
+#define PCAP_MAGIC		0xa1b2c3d4
+#define PCAP_SNAPLEN		65535
+#define LINKTYPE_RAW		101
+
+/* IPv4 and UDP headers synthesized for UDP encapsulated captures */
+#define UDP_ENCAP_HEADROOM	28
+
 /* globals */
 
 static const char* g_network = "239.192.0.1";
+static int g_udp_encap_port = 0;
+static const char* g_dump_file = NULL;
+static gboolean g_quiet = FALSE;
 
 static GIOChannel* g_io_channel = NULL;
 static GMainLoop* g_loop = NULL;
+static FILE* g_dump = NULL;
 
 
 static void on_signal (int);
@@ -63,10 +78,23 @@ static gboolean on_mark (gpointer);
 static gboolean on_io_data (GIOChannel*, GIOCondition, gpointer);
 
 
+G_GNUC_NORETURN static void
+usage (
+	const char*	bin
+	)
+{
+	fprintf (stderr, "Usage: %s [options]\n", bin);
+	fprintf (stderr, "  -n, --network GROUP      : Multicast group\n");
+	fprintf (stderr, "  -p, --port PORT          : PGM encapsulated in UDP on IP port\n");
+	fprintf (stderr, "  -w, --write FILE         : Write packets to a pcap capture\n");
+	fprintf (stderr, "  -q, --quiet              : Do not print packets\n");
+	exit (EXIT_SUCCESS);
+}
+
 int
 main (
-	G_GNUC_UNUSED int	argc,
-	G_GNUC_UNUSED char   *argv[]
+	int		argc,
+	char*		argv[]
 	)
 {
 	GError* err = NULL;
@@ -76,6 +104,50 @@ main (
 	log_init ();
 	g_message ("pgmdump");
 
+/* parse program arguments */
+	const char* binary_name = strrchr (argv[0], '/');
+
+	static struct option long_options[] = {
+		{ "network",        required_argument, NULL, 'n' },
+		{ "port",           required_argument, NULL, 'p' },
+		{ "write",          required_argument, NULL, 'w' },
+		{ "quiet",          no_argument,       NULL, 'q' },
+		{ "help",           no_argument,       NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	int c;
+	while ((c = getopt_long (argc, argv, "n:p:w:qh", long_options, NULL)) != -1)
+	{
+		switch (c) {
+		case 'n':	g_network = optarg; break;
+		case 'p':	g_udp_encap_port = atoi (optarg); break;
+		case 'w':	g_dump_file = optarg; break;
+		case 'q':	g_quiet = TRUE; break;
+
+		case 'h':
+		case '?':
+			usage (binary_name ? binary_name + 1 : argv[0]);
+		}
+	}
+
+/* capture file header */
+	if (g_dump_file) {
+		g_dump = fopen (g_dump_file, "wb");
+		if (NULL == g_dump) {
+			g_error ("opening capture %s: %s", g_dump_file, strerror (errno));
+			return EXIT_FAILURE;
+		}
+		const struct {
+			guint32	magic;
+			guint16	version_major, version_minor;
+			gint32	thiszone;
+			guint32	sigfigs, snaplen, linktype;
+		} header = { PCAP_MAGIC, 2, 4, 0, 0, PCAP_SNAPLEN, LINKTYPE_RAW };
+		fwrite (&header, sizeof(header), 1, g_dump);
+		g_message ("writing capture to %s.", g_dump_file);
+	}
+
 /* setup signal handlers */
 	signal (SIGSEGV, on_sigsegv);
 	signal (SIGINT, on_signal);
@@ -106,6 +178,12 @@ main (
 		g_io_channel = NULL;
 	}
 
+	if (g_dump) {
+		g_message ("closing capture.");
+		fclose (g_dump);
+		g_dump = NULL;
+	}
+
 	g_message ("finished.");
 	return EXIT_SUCCESS;
 }
@@ -143,21 +221,33 @@ on_startup (
 	}
 
 /* open socket for snooping */
-	g_message ("opening raw socket.");
-	int sock = socket (PF_INET, SOCK_RAW, ipproto_pgm);
-	if (sock < 0) {
-		perror("on_startup() failed");
-#ifdef G_OS_UNIX
-		if (EPERM == errno && 0 != getuid()) {
-			g_message ("PGM protocol requires this program to run as superuser.");
+	int sock;
+	int _t = 1;
+	if (g_udp_encap_port) {
+		g_message ("opening UDP socket on port %i.", g_udp_encap_port);
+		sock = socket (PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (sock < 0) {
+			perror ("on_startup() failed");
+			g_main_loop_quit (g_loop);
+			return FALSE;
 		}
+/* share the port with receivers on this host */
+		e = setsockopt (sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&_t, sizeof(_t));
+	} else {
+		g_message ("opening raw socket.");
+		sock = socket (PF_INET, SOCK_RAW, ipproto_pgm);
+		if (sock < 0) {
+			perror("on_startup() failed");
+#ifdef G_OS_UNIX
+			if (EPERM == errno && 0 != getuid()) {
+				g_message ("PGM protocol requires this program to run as superuser.");
+			}
 #endif
-		g_main_loop_quit (g_loop);
-		return FALSE;
+			g_main_loop_quit (g_loop);
+			return FALSE;
+		}
+		e = setsockopt (sock, IPPROTO_IP, IP_HDRINCL, (const char*)&_t, sizeof(_t));
 	}
-
-	int _t = 1;
-	e = setsockopt (sock, IPPROTO_IP, IP_HDRINCL, (const char*)&_t, sizeof(_t));
 	if (e < 0) {
 		perror ("on_startup() failed");
 		close (sock);
@@ -192,6 +282,7 @@ on_startup (
 	memset (&addr, 0, sizeof(addr));
 	addr.sin_family = AF_INET;
 	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons (g_udp_encap_port);
 
 	e = bind (sock, (struct sockaddr*)&addr, sizeof(addr));
 	if (e < 0) {
@@ -249,16 +340,63 @@ on_io_data (
 	G_GNUC_UNUSED gpointer data
 	)
 {
-	char buffer[4096];
+	char buffer[UDP_ENCAP_HEADROOM + 4096];
+	char* packet = g_udp_encap_port ? buffer + UDP_ENCAP_HEADROOM : buffer;
 
 	int fd = g_io_channel_unix_get_fd (source);
 	struct sockaddr_in addr;
 	socklen_t addr_len = sizeof(addr);
-	int len = recvfrom (fd, buffer, sizeof(buffer), MSG_DONTWAIT, (struct sockaddr*)&addr, &addr_len);
+	int len = recvfrom (fd, packet, sizeof(buffer) - UDP_ENCAP_HEADROOM, MSG_DONTWAIT, (struct sockaddr*)&addr, &addr_len);
+	if (len <= 0)
+		return TRUE;
+
+	if (!g_quiet)
+		g_message ("%i bytes received from %s.\n", len, inet_ntoa (addr.sin_addr));
+
+/* the UDP payload is the PGM packet, rebuild the datagram for the capture and
+ * a raw PGM packet for printing.
+ */
+	if (g_udp_encap_port) {
+		struct pgm_ip* ip = (struct pgm_ip*)buffer;
+		struct pgm_udphdr* udp = (struct pgm_udphdr*)(ip + 1);
+		memset (buffer, 0, UDP_ENCAP_HEADROOM);
+		ip->ip_v	= 4;
+		ip->ip_hl	= sizeof(struct pgm_ip) / 4;
+		ip->ip_len	= htons (UDP_ENCAP_HEADROOM + len);
+		ip->ip_ttl	= 1;
+		ip->ip_p	= IPPROTO_UDP;
+		ip->ip_src	= addr.sin_addr;
+		ip->ip_dst.s_addr = inet_addr (g_network);
+		udp->uh_sport	= addr.sin_port;
+		udp->uh_dport	= htons (g_udp_encap_port);
+		udp->uh_ulen	= htons (sizeof(struct pgm_udphdr) + len);
+		guint32 sum = 0;
+		for (unsigned i = 0; i < sizeof(struct pgm_ip) / 2; i++)
+			sum += ((const guint16*)ip)[i];
+		sum = (sum >> 16) + (sum & 0xffff);
+		ip->ip_sum	= ~(sum + (sum >> 16));
+		len += UDP_ENCAP_HEADROOM;
+	}
 
-	g_message ("%i bytes received from %s.\n", len, inet_ntoa (addr.sin_addr));
+	if (g_dump) {
+		struct timeval tv;
+		gettimeofday (&tv, NULL);
+		const guint32 record[4] = { (guint32)tv.tv_sec, (guint32)tv.tv_usec, (guint32)len, (guint32)len };
+		fwrite (record, sizeof(record), 1, g_dump);
+		fwrite (buffer, len, 1, g_dump);
+	}
 
-	if (!pgm_print_packet (buffer, len)) {
+	if (g_quiet)
+		return TRUE;
+
+	if (g_udp_encap_port) {
+		struct pgm_ip* ip = (struct pgm_ip*)(buffer + sizeof(struct pgm_udphdr));
+		memmove (ip, buffer, sizeof(struct pgm_ip));
+		ip->ip_p	= IPPROTO_PGM;
+		ip->ip_len	= htons (len - sizeof(struct pgm_udphdr));
+		if (!pgm_print_packet (ip, len - sizeof(struct pgm_udphdr)))
+			g_message ("invalid packet :(");
+	} else if (!pgm_print_packet (buffer, len)) {
 		g_message ("invalid packet :(");
 	}
 
@@ -0,0 +1,475 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * Run a PGM source and receiver in one process over an in-process loopback
+ * bus and report the protocol cost per message.  No packet reaches the
+ * network, the measurement is of PGM alone, optionally under a repeatable
+ * channel of loss and reordering to include NAK and repair processing.
+ *
+ * Copyright (c) 2006-2010 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* MSVC secure CRT */
+#define _CRT_SECURE_NO_WARNINGS		1
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <locale.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#	include <unistd.h>
+#	include <getopt.h>
+#	include <time.h>
+#else
+#	include "getopt.h"
+#endif
+#ifdef __APPLE__
+#	include <pgm/in.h>
+#endif
+#include <pgm/pgm.h>
+
+
+/* globals */
+
+static int		port = 0;
+static const char*	network = "";
+static int		udp_encap_port = 0;
+static const char*	bus = "pgmloop";
+static int		count = 1000000;
+static int		size = 64;
+static int		loss_rate = 0;
+static int		reorder_rate = 0;
+static int		seed = 1;
+
+static int		max_tpdu = 1500;
+static int		sqns = 10000;
+
+static pgm_sock_t*	source = NULL;
+static pgm_sock_t*	receiver = NULL;
+static volatile bool	is_terminated = FALSE;
+
+#ifndef _MSC_VER
+static void usage (const char*) __attribute__((__noreturn__));
+#else
+static void usage (const char*);
+#endif
+
+static void on_signal (int);
+static bool on_startup (void);
+static void on_shutdown (void);
+
+
+static void
+usage (
+	const char*	bin
+	)
+{
+	fprintf (stderr, "Usage: %s [options]\n", bin);
+	fprintf (stderr, "  -b, --bus NAME           : Loopback bus name (pgmloop)\n");
+	fprintf (stderr, "  -c, --count N            : Messages to send (1000000)\n");
+	fprintf (stderr, "  -l, --length BYTES       : Message length (64)\n");
+	fprintf (stderr, "  -L, --loss PPM           : Packets lost, parts per million (0)\n");
+	fprintf (stderr, "  -R, --reorder PPM        : Packets reordered, parts per million (0)\n");
+	fprintf (stderr, "  -x, --seed N             : Channel model seed, 0 for random (1)\n");
+	fprintf (stderr, "  -n, --network NETWORK    : Multicast group or unicast IP address\n");
+	fprintf (stderr, "  -s, --service PORT       : IP port\n");
+	fprintf (stderr, "  -p, --port PORT          : Encapsulate PGM in UDP on IP port\n");
+	fprintf (stderr, "  -w, --window-sqns N      : Transmit and receive window in sequences (10000)\n");
+	fprintf (stderr, "  -i, --list               : List available interfaces\n");
+	exit (EXIT_SUCCESS);
+}
+
+/* elapsed time and CPU time of the process in nanoseconds.
+ */
+
+static
+void
+sample_time (
+	uint64_t*	wall_ns,
+	uint64_t*	process_ns
+	)
+{
+#ifndef _WIN32
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	*wall_ns    = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &ts);
+	*process_ns = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+	FILETIME creation, exit, kernel, user;
+	*wall_ns    = (uint64_t)GetTickCount64() * 1000000;
+	GetProcessTimes (GetCurrentProcess(), &creation, &exit, &kernel, &user);
+	*process_ns = ((((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime) +
+		       (((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime)) * 100;
+#endif
+}
+
+/* service a socket without blocking until nothing remains to read, counting
+ * delivered messages and bytes.
+ */
+
+static
+void
+drain (
+	pgm_sock_t*	sock,
+	uint64_t*	messages,
+	uint64_t*	bytes,
+	uint64_t*	resets
+	)
+{
+	struct pgm_msgv_t msgv[ 32 ];
+	pgm_error_t* pgm_err = NULL;
+
+	for (;;) {
+		size_t len;
+		const int status = pgm_recvmsgv (sock,
+						 msgv,
+						 sizeof(msgv) / sizeof(msgv[0]),
+						 MSG_DONTWAIT,
+						 &len,
+						 &pgm_err);
+		if (PGM_IO_STATUS_NORMAL == status) {
+			*bytes += len;
+			for (unsigned i = 0; len > 0; i++) {
+				for (unsigned j = 0; j < msgv[i].msgv_len; j++)
+					len -= msgv[i].msgv_skb[j]->len;
+				(*messages)++;
+			}
+			continue;
+		}
+		if (pgm_err) {
+			pgm_error_free (pgm_err);
+			pgm_err = NULL;
+		}
+		if (PGM_IO_STATUS_RESET == status) {
+			(*resets)++;
+			continue;
+		}
+		return;
+	}
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	pgm_error_t* pgm_err = NULL;
+
+	setlocale (LC_ALL, "");
+
+	puts ("pgmloop");
+	if (!pgm_init (&pgm_err)) {
+		fprintf (stderr, "Unable to start PGM engine: %s\n", pgm_err->message);
+		pgm_error_free (pgm_err);
+		return EXIT_FAILURE;
+	}
+
+/* parse program arguments */
+#ifdef _WIN32
+	const char* binary_name = strrchr (argv[0], '\\');
+#else
+	const char* binary_name = strrchr (argv[0], '/');
+#endif
+	if (NULL == binary_name)	binary_name = argv[0];
+	else				binary_name++;
+
+	static struct option long_options[] = {
+		{ "bus",            required_argument, NULL, 'b' },
+		{ "count",          required_argument, NULL, 'c' },
+		{ "length",         required_argument, NULL, 'l' },
+		{ "loss",           required_argument, NULL, 'L' },
+		{ "reorder",        required_argument, NULL, 'R' },
+		{ "seed",           required_argument, NULL, 'x' },
+		{ "network",        required_argument, NULL, 'n' },
+		{ "service",        required_argument, NULL, 's' },
+		{ "port",           required_argument, NULL, 'p' },
+		{ "window-sqns",    required_argument, NULL, 'w' },
+		{ "list",           no_argument,       NULL, 'i' },
+		{ "help",           no_argument,       NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	int c;
+	while ((c = getopt_long (argc, argv, "b:c:l:L:R:x:n:s:p:w:ih", long_options, NULL)) != -1)
+	{
+		switch (c) {
+		case 'b':	bus = optarg; break;
+		case 'c':	count = atoi (optarg); break;
+		case 'l':	size = atoi (optarg); break;
+		case 'L':	loss_rate = atoi (optarg); break;
+		case 'R':	reorder_rate = atoi (optarg); break;
+		case 'x':	seed = atoi (optarg); break;
+		case 'n':	network = optarg; break;
+		case 's':	port = atoi (optarg); break;
+		case 'p':	udp_encap_port = atoi (optarg); break;
+		case 'w':	sqns = atoi (optarg); break;
+
+		case 'i':
+			pgm_if_print_all();
+			return EXIT_SUCCESS;
+
+		case 'h':
+		case '?': usage (binary_name);
+		}
+	}
+
+	if (count <= 0 || size <= 0 || sqns <= 0 ||
+	    loss_rate < 0 || loss_rate > 1000000 ||
+	    reorder_rate < 0 || reorder_rate > 1000000)
+		usage (binary_name);
+
+	signal (SIGINT,  on_signal);
+	signal (SIGTERM, on_signal);
+
+	if (!on_startup()) {
+		fprintf (stderr, "Startup failed\n");
+		return EXIT_FAILURE;
+	}
+
+/* one thread alternates between the source, serving NAKs, and the receiver */
+	char* buf = calloc (1, size);
+	uint64_t messages = 0, bytes = 0, resets = 0, unused = 0;
+	uint64_t wall_start, process_start, wall_end, process_end;
+	sample_time (&wall_start, &process_start);
+	for (int i = 0; i < count && !is_terminated; ) {
+		size_t bytes_written;
+		const int status = pgm_send (source, buf, size, &bytes_written);
+		if (PGM_IO_STATUS_NORMAL == status)
+			i++;
+		else if (PGM_IO_STATUS_ERROR == status)
+			break;
+		drain (source, &unused, &unused, &unused);
+		drain (receiver, &messages, &bytes, &resets);
+	}
+/* repairs of the tail, bounded should the loss be unrecoverable */
+	const uint64_t deadline = wall_start + (uint64_t)60 * 1000000000;
+	sample_time (&wall_end, &process_end);
+	while (messages + resets < (uint64_t)count && !is_terminated && wall_end < deadline) {
+		drain (source, &unused, &unused, &unused);
+		drain (receiver, &messages, &bytes, &resets);
+		sample_time (&wall_end, &process_end);
+	}
+	free (buf);
+
+	struct pgm_loopinfo_t loopinfo;
+	socklen_t optlen = sizeof (loopinfo);
+	pgm_getsockopt (source, IPPROTO_PGM, PGM_LOOPBACK, &loopinfo, &optlen);
+	const uint64_t losses = loopinfo.losses;
+	pgm_getsockopt (receiver, IPPROTO_PGM, PGM_LOOPBACK, &loopinfo, &optlen);
+	const uint64_t per = messages ? messages : 1;
+
+	printf ("Delivered %" PRIu64 " of %d messages of %d bytes in %.3f s, %" PRIu64 " resets.\n",
+		messages, count, size,
+		(double)(wall_end - wall_start) / 1e9,
+		resets);
+	printf ("Bus carried %" PRIu64 " packets to the receiver, %" PRIu64 " lost, %" PRIu64 " overrun.\n",
+		loopinfo.packets, losses, loopinfo.overruns);
+	printf ("Process CPU %.3f s, %" PRIu64 " ns per message.\n",
+		(double)(process_end - process_start) / 1e9,
+		(process_end - process_start) / per);
+
+	on_shutdown();
+	pgm_shutdown ();
+	return EXIT_SUCCESS;
+}
+
+static
+void
+on_signal (
+	int		signum
+	)
+{
+	(void)signum;
+	is_terminated = TRUE;
+}
+
+/* create and connect one socket of the bus, a source sends data and serves
+ * repairs, a receiver is receive-only.
+ */
+
+static
+pgm_sock_t*
+create_sock (
+	struct pgm_addrinfo_t*	res,
+	bool			is_source,
+	pgm_error_t**		pgm_err
+	)
+{
+	pgm_sock_t* sock = NULL;
+	const sa_family_t sa_family = res->ai_send_addrs[0].gsr_group.ss_family;
+
+	if (udp_encap_port) {
+		if (!pgm_socket (&sock, sa_family, SOCK_SEQPACKET, IPPROTO_UDP, pgm_err)) {
+			fprintf (stderr, "Creating PGM/UDP socket: %s\n", (*pgm_err)->message);
+			return NULL;
+		}
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_UDP_ENCAP_UCAST_PORT, &udp_encap_port, sizeof(udp_encap_port));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_UDP_ENCAP_MCAST_PORT, &udp_encap_port, sizeof(udp_encap_port));
+	} else {
+		if (!pgm_socket (&sock, sa_family, SOCK_SEQPACKET, IPPROTO_PGM, pgm_err)) {
+			fprintf (stderr, "Creating PGM/IP socket: %s\n", (*pgm_err)->message);
+			return NULL;
+		}
+	}
+
+/* set PGM parameters */
+	const int recv_only = 1,
+		  nonblocking = 1,
+		  txw_max_rte = 0,
+		  ambient_spm = pgm_secs (30),
+		  heartbeat_spm[] = { pgm_msecs (100),
+				      pgm_msecs (100),
+				      pgm_msecs (100),
+				      pgm_msecs (100),
+				      pgm_msecs (1300),
+				      pgm_secs  (7),
+				      pgm_secs  (16),
+				      pgm_secs  (25),
+				      pgm_secs  (30) },
+		  peer_expiry = pgm_secs (300),
+		  spmr_expiry = pgm_msecs (250),
+		  nak_bo_ivl = pgm_msecs (5),
+		  nak_rpt_ivl = pgm_msecs (200),
+		  nak_rdata_ivl = pgm_msecs (200),
+		  nak_data_retries = 50,
+		  nak_ncf_retries = 50;
+
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_MTU, &max_tpdu, sizeof(max_tpdu));
+	if (is_source) {
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_TXW_SQNS, &sqns, sizeof(sqns));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_TXW_MAX_RTE, &txw_max_rte, sizeof(txw_max_rte));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_AMBIENT_SPM, &ambient_spm, sizeof(ambient_spm));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_HEARTBEAT_SPM, &heartbeat_spm, sizeof(heartbeat_spm));
+	} else {
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_RECV_ONLY, &recv_only, sizeof(recv_only));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_RXW_SQNS, &sqns, sizeof(sqns));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_PEER_EXPIRY, &peer_expiry, sizeof(peer_expiry));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_SPMR_EXPIRY, &spmr_expiry, sizeof(spmr_expiry));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_BO_IVL, &nak_bo_ivl, sizeof(nak_bo_ivl));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_RPT_IVL, &nak_rpt_ivl, sizeof(nak_rpt_ivl));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_RDATA_IVL, &nak_rdata_ivl, sizeof(nak_rdata_ivl));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_DATA_RETRIES, &nak_data_retries, sizeof(nak_data_retries));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_NCF_RETRIES, &nak_ncf_retries, sizeof(nak_ncf_retries));
+	}
+
+/* the same channel model applies in both directions */
+	struct pgm_loopinfo_t loopinfo;
+	memset (&loopinfo, 0, sizeof(loopinfo));
+	loopinfo.name	      = bus;
+	loopinfo.loss_rate    = loss_rate;
+	loopinfo.reorder_rate = reorder_rate;
+	loopinfo.seed	      = is_source ? seed : seed + 1;
+	if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_LOOPBACK, &loopinfo, sizeof(loopinfo))) {
+		fprintf (stderr, "Setting PGM_LOOPBACK failed.\n");
+		goto err_abort;
+	}
+
+/* create global session identifier */
+	struct pgm_sockaddr_t addr;
+	memset (&addr, 0, sizeof(addr));
+	addr.sa_port = port ? port : DEFAULT_DATA_DESTINATION_PORT;
+	addr.sa_addr.sport = DEFAULT_DATA_SOURCE_PORT;
+	if (!pgm_gsi_create_from_hostname (&addr.sa_addr.gsi, pgm_err)) {
+		fprintf (stderr, "Creating GSI: %s\n", (*pgm_err)->message);
+		goto err_abort;
+	}
+
+/* assign socket to specified address, packets travel the bus in place of the network */
+	struct pgm_interface_req_t if_req;
+	memset (&if_req, 0, sizeof(if_req));
+	if_req.ir_interface = res->ai_recv_addrs[0].gsr_interface;
+	memcpy (&if_req.ir_address, &res->ai_send_addrs[0].gsr_addr, sizeof(struct sockaddr_storage));
+	if (!pgm_bind3 (sock,
+			&addr, sizeof(addr),
+			&if_req, sizeof(if_req),	/* tx interface */
+			&if_req, sizeof(if_req),	/* rx interface */
+			pgm_err))
+	{
+		fprintf (stderr, "Binding PGM socket: %s\n", (*pgm_err)->message);
+		goto err_abort;
+	}
+
+	for (unsigned i = 0; i < res->ai_recv_addrs_len; i++)
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_JOIN_GROUP, &res->ai_recv_addrs[i], sizeof(struct pgm_group_source_req));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_SEND_GROUP, &res->ai_send_addrs[0], sizeof(struct pgm_group_source_req));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NOBLOCK, &nonblocking, sizeof(nonblocking));
+
+	if (!pgm_connect (sock, pgm_err)) {
+		fprintf (stderr, "Connecting PGM socket: %s\n", (*pgm_err)->message);
+		goto err_abort;
+	}
+	return sock;
+
+err_abort:
+	pgm_close (sock, FALSE);
+	return NULL;
+}
+
+static
+bool
+on_startup (void)
+{
+	struct pgm_addrinfo_t* res = NULL;
+	pgm_error_t* pgm_err = NULL;
+
+/* parse network parameter into PGM socket address structure */
+	if (!pgm_getaddrinfo (network, NULL, &res, &pgm_err)) {
+		fprintf (stderr, "Parsing network parameter: %s\n", pgm_err->message);
+		goto err_abort;
+	}
+
+	if (NULL == (source = create_sock (res, TRUE, &pgm_err)) ||
+	    NULL == (receiver = create_sock (res, FALSE, &pgm_err)))
+		goto err_abort;
+
+	pgm_drop_superuser();
+
+	pgm_freeaddrinfo (res);
+	return TRUE;
+
+err_abort:
+	on_shutdown();
+	if (NULL != res) {
+		pgm_freeaddrinfo (res);
+		res = NULL;
+	}
+	if (NULL != pgm_err) {
+		pgm_error_free (pgm_err);
+		pgm_err = NULL;
+	}
+	return FALSE;
+}
+
+static
+void
+on_shutdown (void)
+{
+	if (receiver) {
+		pgm_close (receiver, TRUE);
+		receiver = NULL;
+	}
+	if (source) {
+		pgm_close (source, TRUE);
+		source = NULL;
+	}
+}
+
+/* eof */
@@ -10,6 +10,14 @@
  *
  * With no arguments, one message is sent per second.
  *
+ * As a load generator -T runs several sender threads each with its own
+ * socket, -z sweeps a list of message sizes holding each for -d seconds,
+ * and -J writes latency percentiles per size as JSON on exit.  With -m
+ * senders are scheduled open-loop at a constant rate and each message is
+ * stamped with its scheduled rather than actual send time, so a sender
+ * falling behind is charged to latency instead of hidden by it
+ * (coordinated omission).
+ *
  * Copyright (c) 2006-2010 Miru Limited.
  *
  * This library is free software; you can redistribute it and/or
@@ -104,7 +112,11 @@ static int		g_udp_encap_port = 0;
 
 static int		g_odata_rate = 0;
 static int		g_odata_interval = 0;
-static guint32		g_payload = 0;
+static int		g_threads = 1;
+static guint*		g_sizes = NULL;		/* payload per step */
+static guint		g_size_count = 0;
+static int		g_step_duration = 0;	/* ms, 0 = until terminated */
+static const char*	g_json_filename = NULL;
 static int		g_max_tpdu = 1500;
 static int		g_max_rte = 16*1000*1000;
 static int		g_odata_rte = 0;	/* 0 = disabled */
@@ -125,27 +137,60 @@ static enum {
 	PGMPING_MODE_REFLECTOR
 }			g_mode = PGMPING_MODE_INITIATOR;
 
-static pgm_sock_t*	g_sock = NULL;
+/* log-linear latency histogram in microseconds: exact below 1024 us, then
+ * 512 buckets per power of two, so any percentile is within 0.2%.
+ */
+#define HISTOGRAM_LINEAR	1024
+#define HISTOGRAM_SUB_BITS	9
+#define HISTOGRAM_GROUPS	32
+#define HISTOGRAM_BUCKETS	(HISTOGRAM_LINEAR + (HISTOGRAM_GROUPS << HISTOGRAM_SUB_BITS))
+
+struct histogram_t {
+	guint64		count;
+	guint64		min;
+	guint64		max;
+	double		total;
+	guint64		buckets[HISTOGRAM_BUCKETS];
+};
+
+/* one per socket, each with a sender and a receiver thread */
+struct ping_thread_t {
+	unsigned		index;
+	pgm_sock_t*		sock;
+	GThread*		sender_thread;
+	GThread*		receiver_thread;
+	string			subject;
+	char*			apdu;		/* reassembly of fragmented messages */
+	gsize			apdu_size;
+	pgm_time_t		last_time;
+
+/* sender feedback, written by the receiver thread */
+	pgm_time_t		latency_current;
+	guint64			latency_seqno;
+	guint64			msg_sent;
+
+/* interval statistics for on_mark */
+	GMutex*			lock;
+	double			latency_total;
+	double			latency_square_total;
+	guint64			latency_count;
+	double			latency_max;
+	double			latency_min;
+	guint64			out_total;
+	guint64			in_total;
+
+/* per step totals, read after the threads are joined */
+	guint64*		step_sent;
+	struct histogram_t*	step_latency;
+};
+
+static struct ping_thread_t* g_ctx = NULL;
 
 /* stats */
-static guint64		g_msg_sent = 0;
-static guint64		g_msg_received = 0;
 static pgm_time_t	g_interval_start = 0;
-static pgm_time_t	g_latency_current = 0;
-static guint64		g_latency_seqno = 0;
-static guint64		g_last_seqno = 0;
-static double		g_latency_total = 0.0;
-static double		g_latency_square_total = 0.0;
-static guint64		g_latency_count = 0;
-static double		g_latency_max = 0.0;
-#ifdef INFINITY
-static double		g_latency_min = INFINITY;
-#else
-static double		g_latency_min = (double)INT64_MAX;
-#endif
-static double		g_latency_running_average = 0.0;
-static guint64		g_out_total = 0;
-static guint64		g_in_total = 0;
+static volatile guint	g_step = 0;
+static pgm_time_t*	g_step_start = NULL;
+static pgm_time_t	g_finish = 0;
 
 #ifdef CONFIG_WITH_HEATMAP
 static FILE*		g_heatmap_file = NULL;
@@ -167,11 +212,12 @@ static BOOL on_console_ctrl (DWORD);
 #endif
 
 static gboolean on_startup (gpointer);
-static gboolean on_shutdown (gpointer);
+static gboolean on_step (gpointer);
 static gboolean on_mark (gpointer);
 
-static void send_odata (void);
-static int on_msgv (struct pgm_msgv_t*, size_t);
+static int on_msgv (struct ping_thread_t*, struct pgm_msgv_t*, size_t);
+static void print_summary (void);
+static void write_json (const char*);
 
 static gpointer sender_thread (gpointer);
 static gpointer receiver_thread (gpointer);
@@ -184,8 +230,11 @@ usage (const char* bin)
 	fprintf (stderr, "  -n <network>    : Multicast group or unicast IP address\n");
 	fprintf (stderr, "  -s <port>       : IP port\n");
         fprintf (stderr, "  -p <port>       : Encapsulate PGM in UDP on IP port\n");
-	fprintf (stderr, "  -d <seconds>    : Terminate transport after duration.\n");
-	fprintf (stderr, "  -m <frequency>  : Number of message to send per second\n");
+	fprintf (stderr, "  -d <seconds>    : Terminate transport after duration, per size with -z.\n");
+	fprintf (stderr, "  -m <frequency>  : Number of message to send per second per sender\n");
+	fprintf (stderr, "  -T <threads>    : Number of sender threads and sockets\n");
+	fprintf (stderr, "  -z <sizes>      : Sweep comma separated payload sizes, -d seconds each\n");
+	fprintf (stderr, "  -J <filename>   : Write latency percentiles as JSON on exit\n");
 	fprintf (stderr, "  -o              : Send-only mode (default send & receive mode)\n");
 	fprintf (stderr, "  -l              : Listen-only mode\n");
 	fprintf (stderr, "  -e              : Relect mode\n");
@@ -215,6 +264,7 @@ main (
 	gboolean enable_http = FALSE;
 	gboolean enable_snmpx = FALSE;
 	int timeout = 0;
+	gchar** sizes = NULL;
 
 	GOOGLE_PROTOBUF_VERIFY_VERSION;
 
@@ -238,7 +288,7 @@ main (
 /* parse program arguments */
 	const char* binary_name = g_get_prgname();
 	int c;
-	while ((c = getopt (argc, argv, "s:n:p:m:old:r:O:D:cfeK:N:M:HSh")) != -1)
+	while ((c = getopt (argc, argv, "s:n:p:m:old:r:O:D:cfeK:N:M:T:z:J:HSh")) != -1)
 	{
 		switch (c) {
 		case 'n':	g_network = optarg; break;
@@ -266,6 +316,10 @@ main (
 		case 'm':	g_odata_rate = atoi (optarg);
 				g_odata_interval = (1000 * 1000) / g_odata_rate; break;
 		case 'd':	timeout = 1000 * atoi (optarg); break;
+		case 'T':	g_threads = atoi (optarg); break;
+		case 'z':	g_strfreev (sizes);
+				sizes = g_strsplit (optarg, ",", 0); break;
+		case 'J':	g_json_filename = optarg; break;
 
 		case 'o':	g_mode = PGMPING_MODE_SOURCE; break;
 		case 'l':	g_mode = PGMPING_MODE_RECEIVER; break;
@@ -281,6 +335,65 @@ main (
 		usage (binary_name);
 	}
 
+	if (g_threads < 1)
+		usage (binary_name);
+	if (g_threads > 1 &&
+	    (PGMPING_MODE_RECEIVER == g_mode || PGMPING_MODE_REFLECTOR == g_mode))
+	{
+		g_warning ("Multiple sockets only apply to source and initiator modes.");
+		g_threads = 1;
+	}
+
+/* message size sweep, default single step of 1000 bytes */
+	if (NULL != sizes) {
+		g_size_count = g_strv_length (sizes);
+		g_sizes = g_new (guint, MAX(g_size_count, 1));
+		for (guint i = 0; i < g_size_count; i++) {
+			g_sizes[i] = atoi (sizes[i]);
+			if (0 == g_sizes[i])
+				usage (binary_name);
+		}
+		g_strfreev (sizes);
+	}
+	if (0 == g_size_count) {
+		g_sizes = g_new (guint, 1);
+		g_sizes[0] = 1000;
+		g_size_count = 1;
+	}
+	g_step_duration = timeout;
+	if (g_size_count > 1 && 0 == g_step_duration)
+		g_step_duration = 10 * 1000;
+	g_step_start = g_new0 (pgm_time_t, g_size_count);
+
+	g_ctx = new ping_thread_t[ g_threads ];
+	for (int i = 0; i < g_threads; i++) {
+		struct ping_thread_t* ctx = &g_ctx[i];
+		ctx->index		= i;
+		ctx->sock		= NULL;
+		ctx->sender_thread	= NULL;
+		ctx->receiver_thread	= NULL;
+		ctx->apdu		= NULL;
+		ctx->apdu_size		= 0;
+		ctx->last_time		= pgm_time_update_now();
+		ctx->latency_current	= 0;
+		ctx->latency_seqno	= 0;
+		ctx->msg_sent		= 0;
+		ctx->lock		= g_mutex_new ();
+		ctx->latency_total	= 0.0;
+		ctx->latency_square_total = 0.0;
+		ctx->latency_count	= 0;
+		ctx->latency_max	= 0.0;
+#ifdef INFINITY
+		ctx->latency_min	= INFINITY;
+#else
+		ctx->latency_min	= (double)INT64_MAX;
+#endif
+		ctx->out_total		= 0;
+		ctx->in_total		= 0;
+		ctx->step_sent		= g_new0 (guint64, g_size_count);
+		ctx->step_latency	= g_new0 (struct histogram_t, g_size_count);
+	}
+
 #ifdef CONFIG_WITH_HEATMAP
 	if (NULL != g_heatmap_file) {
 		g_heatmap_slice = g_hash_table_new (g_direct_hash, g_direct_equal);
@@ -346,9 +459,9 @@ main (
 	g_message ("scheduling startup.");
 	g_timeout_add (0, (GSourceFunc)on_startup, g_loop);
 
-	if (timeout) {
-		g_message ("scheduling shutdown.");
-		g_timeout_add (timeout, (GSourceFunc)on_shutdown, g_loop);
+	if (g_step_duration) {
+		g_message ("scheduling %u step%s of %d ms.", g_size_count, g_size_count > 1 ? "s" : "", g_step_duration);
+		g_timeout_add (g_step_duration, (GSourceFunc)on_step, g_loop);
 	}
 
 /* dispatch loop */
@@ -358,21 +471,25 @@ main (
 	g_message ("event loop terminated, cleaning up.");
 
 /* cleanup */
+	g_finish = pgm_time_update_now();
 	g_quit = TRUE;
 #ifdef G_OS_UNIX
 	const char one = '1';
 	write (g_quit_pipe[1], &one, sizeof(one));
-	if (PGMPING_MODE_SOURCE == g_mode || PGMPING_MODE_INITIATOR == g_mode)
-		g_thread_join (g_sender_thread);
-	g_thread_join (g_receiver_thread);
-	close (g_quit_pipe[0]);
-	close (g_quit_pipe[1]);
 #else
 	const char one = '1';
 	send (g_quit_socket[1], &one, sizeof(one), 0);
-	if (PGMPING_MODE_SOURCE == g_mode || PGMPING_MODE_INITIATOR == g_mode)
-		g_thread_join (g_sender_thread);
-	g_thread_join (g_receiver_thread);
+#endif
+	for (int i = 0; i < g_threads; i++) {
+		if (NULL != g_ctx[i].sender_thread)
+			g_thread_join (g_ctx[i].sender_thread);
+		if (NULL != g_ctx[i].receiver_thread)
+			g_thread_join (g_ctx[i].receiver_thread);
+	}
+#ifdef G_OS_UNIX
+	close (g_quit_pipe[0]);
+	close (g_quit_pipe[1]);
+#else
 	closesocket (g_quit_socket[0]);
 	closesocket (g_quit_socket[1]);
 #endif
@@ -380,11 +497,26 @@ main (
 	g_main_loop_unref (g_loop);
 	g_loop = NULL;
 
-	if (g_sock) {
-		g_message ("closing PGM socket.");
-		pgm_close (g_sock, TRUE);
-		g_sock = NULL;
+	print_summary ();
+	if (NULL != g_json_filename)
+		write_json (g_json_filename);
+
+	for (int i = 0; i < g_threads; i++) {
+		struct ping_thread_t* ctx = &g_ctx[i];
+		if (ctx->sock) {
+			g_message ("closing PGM socket %d.", i);
+			pgm_close (ctx->sock, TRUE);
+			ctx->sock = NULL;
+		}
+		g_mutex_free (ctx->lock);
+		g_free (ctx->apdu);
+		g_free (ctx->step_sent);
+		g_free (ctx->step_latency);
 	}
+	delete [] g_ctx;
+	g_ctx = NULL;
+	g_free (g_step_start);
+	g_free (g_sizes);
 
 #ifdef CONFIG_WITH_HTTP
 	if (enable_http)
@@ -440,31 +572,41 @@ on_console_ctrl (
 }
 #endif /* !G_OS_UNIX */
 
+/* advance the message size sweep, terminating after the last step.
+ */
+
 static
 gboolean
-on_shutdown (
+on_step (
 	gpointer	user_data
 	)
 {
 	GMainLoop* loop = (GMainLoop*)user_data;
-	g_message ("on_shutdown (user-data:%p)", user_data);
-	g_main_loop_quit (loop);
-	return FALSE;
+	if (g_step + 1 >= g_size_count) {
+		g_message ("on_shutdown (user-data:%p)", user_data);
+		g_main_loop_quit (loop);
+		return FALSE;
+	}
+	g_step_start[ g_step + 1 ] = pgm_time_update_now();
+	g_step++;
+	g_message ("step %u: %u byte payload.", g_step, g_sizes[ g_step ]);
+	return TRUE;
 }
 
+/* create, bind and connect the socket for one thread, each socket has a
+ * distinct data-source port and hence TSI.
+ */
+
 static
 gboolean
-on_startup (
-	gpointer	user_data
+create_sock (
+	struct ping_thread_t*	ctx
 	)
 {
-	GMainLoop* loop = (GMainLoop*)user_data;
 	struct pgm_addrinfo_t* res = NULL;
-	GError* err = NULL;
 	pgm_error_t* pgm_err = NULL;
 	sa_family_t sa_family = AF_UNSPEC;
-
-	g_message ("startup.");
+	pgm_sock_t* sock = NULL;
 
 /* parse network parameter into transport address structure */
 	if (!pgm_getaddrinfo (g_network, NULL, &res, &pgm_err)) {
@@ -478,21 +620,21 @@ on_startup (
 
 	if (g_udp_encap_port) {
 		g_message ("create PGM/UDP socket.");
-		if (!pgm_socket (&g_sock, sa_family, SOCK_SEQPACKET, IPPROTO_UDP, &pgm_err)) {
+		if (!pgm_socket (&sock, sa_family, SOCK_SEQPACKET, IPPROTO_UDP, &pgm_err)) {
 			g_error ("socket: %s", pgm_err->message);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_UDP_ENCAP_UCAST_PORT, &g_udp_encap_port, sizeof(g_udp_encap_port))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_UDP_ENCAP_UCAST_PORT, &g_udp_encap_port, sizeof(g_udp_encap_port))) {
 			g_error ("setting PGM_UDP_ENCAP_UCAST_PORT = %d", g_udp_encap_port);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_UDP_ENCAP_MCAST_PORT, &g_udp_encap_port, sizeof(g_udp_encap_port))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_UDP_ENCAP_MCAST_PORT, &g_udp_encap_port, sizeof(g_udp_encap_port))) {
 			g_error ("setting PGM_UDP_ENCAP_MCAST_PORT = %d", g_udp_encap_port);
 			goto err_abort;
 		}
 	} else {
 		g_message ("create PGM/IP socket.");
-		if (!pgm_socket (&g_sock, sa_family, SOCK_SEQPACKET, IPPROTO_PGM, &pgm_err)) {
+		if (!pgm_socket (&sock, sa_family, SOCK_SEQPACKET, IPPROTO_PGM, &pgm_err)) {
 			g_error ("socket: %s", pgm_err->message);
 			goto err_abort;
 		}
@@ -501,23 +643,12 @@ on_startup (
 /* Use RFC 2113 tagging for PGM Router Assist */
 	{
 		const int no_router_assist = 0;
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_IP_ROUTER_ALERT, &no_router_assist, sizeof(no_router_assist))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_IP_ROUTER_ALERT, &no_router_assist, sizeof(no_router_assist))) {
 			g_error ("setting PGM_IP_ROUTER_ALERT = %d", no_router_assist);
 			goto err_abort;
 		}
 	}
 
-#ifndef CONFIG_HAVE_SCHEDPARAM
-	pgm_drop_superuser();
-#endif
-#ifdef CONFIG_PRIORITY_CLASS
-/* Any priority above normal usually yields worse performance than expected */
-	if (!SetPriorityClass (GetCurrentProcess(), NORMAL_PRIORITY_CLASS))
-	{
-		g_warning ("setting priority class (%d)", GetLastError());
-	}
-#endif
-
 /* set PGM parameters */
 /* common */
 	{
@@ -529,15 +660,15 @@ on_startup (
 #endif
 			  max_tpdu = g_max_tpdu;
 
-		if (!pgm_setsockopt (g_sock, SOL_SOCKET, SO_RCVBUF, &rxbufsize, sizeof(rxbufsize))) {
+		if (!pgm_setsockopt (sock, SOL_SOCKET, SO_RCVBUF, &rxbufsize, sizeof(rxbufsize))) {
 			g_error ("setting SO_RCVBUF = %d", rxbufsize);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, SOL_SOCKET, SO_SNDBUF, &txbufsize, sizeof(txbufsize))) {
+		if (!pgm_setsockopt (sock, SOL_SOCKET, SO_SNDBUF, &txbufsize, sizeof(txbufsize))) {
 			g_error ("setting SO_SNDBUF = %d", txbufsize);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_MTU, &max_tpdu, sizeof(max_tpdu))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_MTU, &max_tpdu, sizeof(max_tpdu))) {
 			g_error ("setting PGM_MTU = %d", max_tpdu);
 			goto err_abort;
 		}
@@ -564,34 +695,34 @@ on_startup (
 					      pgm_secs  (25),
 					      pgm_secs  (30) };
 
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_SEND_ONLY, &send_only, sizeof(send_only))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_SEND_ONLY, &send_only, sizeof(send_only))) {
 			g_error ("setting PGM_SEND_ONLY = %d", send_only);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_TXW_SQNS, &txw_sqns, sizeof(txw_sqns))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_TXW_SQNS, &txw_sqns, sizeof(txw_sqns))) {
 			g_error ("setting PGM_TXW_SQNS = %d", txw_sqns);
 			goto err_abort;
 		}
 		if (txw_max_rte > 0 &&
-		    !pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_TXW_MAX_RTE, &txw_max_rte, sizeof(txw_max_rte))) {
+		    !pgm_setsockopt (sock, IPPROTO_PGM, PGM_TXW_MAX_RTE, &txw_max_rte, sizeof(txw_max_rte))) {
 			g_error ("setting PGM_TXW_MAX_RTE = %d", txw_max_rte);
 			goto err_abort;
 		}
 		if (odata_max_rte > 0 &&
-		    !pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_ODATA_MAX_RTE, &odata_max_rte, sizeof(odata_max_rte))) {
+		    !pgm_setsockopt (sock, IPPROTO_PGM, PGM_ODATA_MAX_RTE, &odata_max_rte, sizeof(odata_max_rte))) {
 			g_error ("setting PGM_ODATA_MAX_RTE = %d", odata_max_rte);
 			goto err_abort;
 		}
 		if (rdata_max_rte > 0 &&
-		    !pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_RDATA_MAX_RTE, &rdata_max_rte, sizeof(rdata_max_rte))) {
+		    !pgm_setsockopt (sock, IPPROTO_PGM, PGM_RDATA_MAX_RTE, &rdata_max_rte, sizeof(rdata_max_rte))) {
 			g_error ("setting PGM_RDATA_MAX_RTE = %d", rdata_max_rte);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_AMBIENT_SPM, &ambient_spm, sizeof(ambient_spm))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_AMBIENT_SPM, &ambient_spm, sizeof(ambient_spm))) {
 			g_error ("setting PGM_AMBIENT_SPM = %d", ambient_spm);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_HEARTBEAT_SPM, &heartbeat_spm, sizeof(heartbeat_spm))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_HEARTBEAT_SPM, &heartbeat_spm, sizeof(heartbeat_spm))) {
 	                char buffer[1024];
 	                sprintf (buffer, "%d", heartbeat_spm[0]);
 	                for (unsigned i = 1; i < G_N_ELEMENTS(heartbeat_spm); i++) {
@@ -621,43 +752,43 @@ on_startup (
 			  nak_data_retries = 50,
 			  nak_ncf_retries  = 50;
 
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_RECV_ONLY, &recv_only, sizeof(recv_only))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_RECV_ONLY, &recv_only, sizeof(recv_only))) {
 			g_error ("setting PGM_RECV_ONLY = %d", recv_only);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_PASSIVE, &not_passive, sizeof(not_passive))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_PASSIVE, &not_passive, sizeof(not_passive))) {
 			g_error ("setting PGM_PASSIVE = %d", not_passive);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_RXW_SQNS, &rxw_sqns, sizeof(rxw_sqns))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_RXW_SQNS, &rxw_sqns, sizeof(rxw_sqns))) {
 			g_error ("setting PGM_RXW_SQNS = %d", rxw_sqns);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_PEER_EXPIRY, &peer_expiry, sizeof(peer_expiry))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_PEER_EXPIRY, &peer_expiry, sizeof(peer_expiry))) {
 			g_error ("setting PGM_PEER_EXPIRY = %d", peer_expiry);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_SPMR_EXPIRY, &spmr_expiry, sizeof(spmr_expiry))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_SPMR_EXPIRY, &spmr_expiry, sizeof(spmr_expiry))) {
 			g_error ("setting PGM_SPMR_EXPIRY = %d", spmr_expiry);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_NAK_BO_IVL, &nak_bo_ivl, sizeof(nak_bo_ivl))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_BO_IVL, &nak_bo_ivl, sizeof(nak_bo_ivl))) {
 			g_error ("setting PGM_NAK_BO_IVL = %d", nak_bo_ivl);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_NAK_RPT_IVL, &nak_rpt_ivl, sizeof(nak_rpt_ivl))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_RPT_IVL, &nak_rpt_ivl, sizeof(nak_rpt_ivl))) {
 			g_error ("setting PGM_NAK_RPT_IVL = %d", nak_rpt_ivl);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_NAK_RDATA_IVL, &nak_rdata_ivl, sizeof(nak_rdata_ivl))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_RDATA_IVL, &nak_rdata_ivl, sizeof(nak_rdata_ivl))) {
 			g_error ("setting PGM_NAK_RDATA_IVL = %d", nak_rdata_ivl);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_NAK_DATA_RETRIES, &nak_data_retries, sizeof(nak_data_retries))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_DATA_RETRIES, &nak_data_retries, sizeof(nak_data_retries))) {
 			g_error ("setting PGM_NAK_DATA_RETRIES = %d", nak_data_retries);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_NAK_NCF_RETRIES, &nak_ncf_retries, sizeof(nak_ncf_retries))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_NCF_RETRIES, &nak_ncf_retries, sizeof(nak_ncf_retries))) {
 			g_error ("setting PGM_NAK_NCF_RETRIES = %d", nak_ncf_retries);
 			goto err_abort;
 		}
@@ -670,7 +801,7 @@ on_startup (
 		pgmccinfo.ack_bo_ivl		= pgm_msecs (50);
 		pgmccinfo.ack_c			= 75;
 		pgmccinfo.ack_c_p		= 500;
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_USE_PGMCC, &pgmccinfo, sizeof(pgmccinfo))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_USE_PGMCC, &pgmccinfo, sizeof(pgmccinfo))) {
 			g_error ("setting PGM_USE_PGMCC = { ack_bo_ivl = %d ack_c = %d ack_c_p = %d }",
 				pgmccinfo.ack_bo_ivl,
 				pgmccinfo.ack_c,
@@ -687,7 +818,7 @@ on_startup (
 		fecinfo.group_size		= g_rs_k;
 		fecinfo.ondemand_parity_enabled	= TRUE;
 		fecinfo.var_pktlen_enabled	= TRUE;
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_USE_FEC, &fecinfo, sizeof(fecinfo))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_USE_FEC, &fecinfo, sizeof(fecinfo))) {
 			g_error ("setting PGM_USE_FEC = { block_size = %d proactive_packets = %d group_size = %d ondemand_parity_enabled = %s var_pktlen_enabled = %s }",
 				fecinfo.block_size,
 				fecinfo.proactive_packets,
@@ -703,7 +834,7 @@ on_startup (
 	struct pgm_sockaddr_t addr;
 	memset (&addr, 0, sizeof(addr));
 	addr.sa_port = (0 != g_port) ? g_port : DEFAULT_DATA_DESTINATION_PORT;
-	addr.sa_addr.sport = DEFAULT_DATA_SOURCE_PORT;
+	addr.sa_addr.sport = DEFAULT_DATA_SOURCE_PORT + ctx->index;
 	if (!pgm_gsi_create_from_hostname (&addr.sa_addr.gsi, &pgm_err)) {
 		g_error ("creating GSI: %s", pgm_err->message);
 		goto err_abort;
@@ -714,7 +845,7 @@ on_startup (
 	memset (&if_req, 0, sizeof(if_req));
 	if_req.ir_interface = res->ai_recv_addrs[0].gsr_interface;
 	memcpy (&if_req.ir_address, &res->ai_send_addrs[0].gsr_addr, sizeof(struct sockaddr_storage));
-	if (!pgm_bind3 (g_sock,
+	if (!pgm_bind3 (sock,
 			&addr, sizeof(addr),
 			&if_req, sizeof(if_req),	/* tx interface */
 			&if_req, sizeof(if_req),	/* rx interface */
@@ -727,7 +858,7 @@ on_startup (
 /* join IP multicast groups */
 	for (unsigned i = 0; i < res->ai_recv_addrs_len; i++)
 	{
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_JOIN_GROUP, &res->ai_recv_addrs[i], sizeof(struct pgm_group_source_req))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_JOIN_GROUP, &res->ai_recv_addrs[i], sizeof(struct pgm_group_source_req))) {
 			char group[INET6_ADDRSTRLEN];
 			getnameinfo ((struct sockaddr*)&res->ai_recv_addrs[i].gsr_group, sizeof(struct sockaddr_in),
                                         group, sizeof(group),
@@ -739,7 +870,7 @@ on_startup (
 			goto err_abort;
 		}
 	}
-	if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_SEND_GROUP, &res->ai_send_addrs[0], sizeof(struct pgm_group_source_req))) {
+	if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_SEND_GROUP, &res->ai_send_addrs[0], sizeof(struct pgm_group_source_req))) {
                 char group[INET6_ADDRSTRLEN];
                 getnameinfo ((struct sockaddr*)&res->ai_send_addrs[0].gsr_group, sizeof(struct sockaddr_in),
 				group, sizeof(group),
@@ -759,60 +890,115 @@ on_startup (
 			  multicast_hops   = 16,
 			  dscp		   = 0x2e << 2;	/* Expedited Forwarding PHB for network elements, no ECN. */
 
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_MULTICAST_LOOP, &multicast_direct, sizeof(multicast_direct))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_MULTICAST_LOOP, &multicast_direct, sizeof(multicast_direct))) {
 			g_error ("setting PGM_MULTICAST_LOOP = %d", multicast_direct);
 			goto err_abort;
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_MULTICAST_HOPS, &multicast_hops, sizeof(multicast_hops))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_MULTICAST_HOPS, &multicast_hops, sizeof(multicast_hops))) {
 			g_error ("setting PGM_MULTICAST_HOPS = %d", multicast_hops);
 			goto err_abort;
 		}
 /* ToS only exists for IPv4 */
 		if (AF_INET6 != sa_family) {
 /* Some platforms require additional privilege for setting ToS */
-			if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_TOS, &dscp, sizeof(dscp))) {
+			if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_TOS, &dscp, sizeof(dscp))) {
 				g_warning ("setting PGM_TOS = 0x%x", dscp);
 			}
 		}
-		if (!pgm_setsockopt (g_sock, IPPROTO_PGM, PGM_NOBLOCK, &nonblocking, sizeof(nonblocking))) {
+		if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_NOBLOCK, &nonblocking, sizeof(nonblocking))) {
 			g_error ("setting PGM_NOBLOCK = %d", nonblocking);
 			goto err_abort;
 		}
 	}
 
-	if (!pgm_connect (g_sock, &pgm_err)) {
+	if (!pgm_connect (sock, &pgm_err)) {
 		g_error ("connecting PGM socket: %s", pgm_err->message);
 		goto err_abort;
 	}
 
+	ctx->sock = sock;
+	return TRUE;
+
+err_abort:
+	if (NULL != sock) {
+		pgm_close (sock, FALSE);
+		sock = NULL;
+	}
+	if (NULL != res) {
+		pgm_freeaddrinfo (res);
+		res = NULL;
+	}
+	if (NULL != pgm_err) {
+		pgm_error_free (pgm_err);
+		pgm_err = NULL;
+	}
+	return FALSE;
+}
+
+static
+gboolean
+on_startup (
+	G_GNUC_UNUSED gpointer	user_data
+	)
+{
+	GError* err = NULL;
+	char hostname[NI_MAXHOST + 1];
+
+	g_message ("startup.");
+
+	gethostname (hostname, sizeof(hostname));
+	for (int i = 0; i < g_threads; i++) {
+		struct ping_thread_t* ctx = &g_ctx[i];
+		if (!create_sock (ctx))
+			goto err_abort;
+/* distinguishes reflected messages of each sender */
+		char index[16];
+		sprintf (index, ".%d", i);
+		ctx->subject = string("PING.PGM.TEST.") + hostname + index;
+	}
+
+#ifndef CONFIG_HAVE_SCHEDPARAM
+	pgm_drop_superuser();
+#endif
+#ifdef CONFIG_PRIORITY_CLASS
+/* Any priority above normal usually yields worse performance than expected */
+	if (!SetPriorityClass (GetCurrentProcess(), NORMAL_PRIORITY_CLASS))
+	{
+		g_warning ("setting priority class (%d)", GetLastError());
+	}
+#endif
+
 /* period timer to indicate some form of life */
 // TODO: Gnome 2.14: replace with g_timeout_add_seconds()
 	g_timeout_add (2 * 1000, (GSourceFunc)on_mark, NULL);
+	g_interval_start = g_step_start[0] = pgm_time_update_now();
 
-	if (PGMPING_MODE_SOURCE == g_mode || PGMPING_MODE_INITIATOR == g_mode)
+	for (int i = 0; i < g_threads; i++)
 	{
-		g_sender_thread = g_thread_create_full (sender_thread,
-							g_sock,
-							0,
-							TRUE,
-							TRUE,
-							G_THREAD_PRIORITY_NORMAL,
-							&err);
-		if (!g_sender_thread) {
-			g_critical ("g_thread_create_full failed errno %i: \"%s\"", err->code, err->message);
-			goto err_abort;
+		struct ping_thread_t* ctx = &g_ctx[i];
+		if (PGMPING_MODE_SOURCE == g_mode || PGMPING_MODE_INITIATOR == g_mode)
+		{
+			ctx->sender_thread = g_thread_create_full (sender_thread,
+								   ctx,
+								   0,
+								   TRUE,
+								   TRUE,
+								   G_THREAD_PRIORITY_NORMAL,
+								   &err);
+			if (!ctx->sender_thread) {
+				g_critical ("g_thread_create_full failed errno %i: \"%s\"", err->code, err->message);
+				goto err_abort;
+			}
 		}
-	}
 
-	{
-		g_receiver_thread = g_thread_create_full (receiver_thread,
-							  g_sock,
-							  0,
-							  TRUE,
-							  TRUE,
-							  G_THREAD_PRIORITY_HIGH,
-							  &err);
-		if (!g_receiver_thread) {
+		ctx->receiver_thread = g_thread_create_full (receiver_thread,
+							     ctx,
+							     0,
+							     TRUE,
+							     TRUE,
+							     G_THREAD_PRIORITY_HIGH,
+							     &err);
+		if (!ctx->receiver_thread) {
 			g_critical ("g_thread_create_full failed errno %i: \"%s\"", err->code, err->message);
 			goto err_abort;
 		}
@@ -822,18 +1008,7 @@ on_startup (
 	return FALSE;
 
 err_abort:
-	if (NULL != g_sock) {
-		pgm_close (g_sock, FALSE);
-		g_sock = NULL;
-	}
-	if (NULL != res) {
-		pgm_freeaddrinfo (res);
-		res = NULL;
-	}
-	if (NULL != pgm_err) {
-		pgm_error_free (pgm_err);
-		pgm_err = NULL;
-	}
+	g_main_loop_quit (g_loop);
 	return FALSE;
 }
 
@@ -843,13 +1018,13 @@ sender_thread (
 	gpointer	user_data
 	)
 {
-	pgm_sock_t* tx_sock = (pgm_sock_t*)user_data;
+	struct ping_thread_t* ctx = (struct ping_thread_t*)user_data;
+	pgm_sock_t* tx_sock = ctx->sock;
 	example::Ping ping;
-	string subject("PING.PGM.TEST.");
-	char hostname[NI_MAXHOST + 1];
-	const long payload_len = 1000;
-	char payload[payload_len];
-	gpointer buffer = NULL;
+	guint max_payload = 0;
+	char* payload;
+	char* buffer = NULL;
+	gsize buffer_size = 0;
 	guint64 latency, now, last = 0;
 
 #ifdef CONFIG_HAVE_EPOLL
@@ -902,9 +1077,9 @@ sender_thread (
 	WSAEventSelect (send_sock, waitEvents[1], FD_WRITE);
 #endif /* !CONFIG_HAVE_EPOLL */
 
-	gethostname (hostname, sizeof(hostname));
-	subject.append(hostname);
-	memset (payload, 0, sizeof(payload));
+	for (guint i = 0; i < g_size_count; i++)
+		max_payload = MAX(max_payload, g_sizes[i]);
+	payload = g_new0 (char, max_payload);
 
 #ifdef CONFIG_HAVE_SCHEDPARAM
 /* realtime scheduling */
@@ -921,7 +1096,7 @@ sender_thread (
 		g_warning ("Cannot get thread scheduling parameters.");
 #endif
 
-	ping.mutable_subscription_header()->set_subject (subject);
+	ping.mutable_subscription_header()->set_subject (ctx->subject);
 	ping.mutable_market_data_header()->set_msg_type (example::MarketDataHeader::MSG_VERIFY);
 	ping.mutable_market_data_header()->set_rec_type (example::MarketDataHeader::PING);
 	ping.mutable_market_data_header()->set_rec_status (example::MarketDataHeader::STATUS_OK);
@@ -929,22 +1104,33 @@ sender_thread (
 
 	last = now = pgm_time_update_now();
 	do {
-		if (g_msg_sent && g_latency_seqno + 1 == g_msg_sent)
-			latency = g_latency_current;
+		const guint step = g_step;
+		if (ctx->msg_sent && ctx->latency_seqno + 1 == ctx->msg_sent)
+			latency = ctx->latency_current;
 		else
 			latency = g_odata_interval;
 
-		ping.set_seqno (g_msg_sent);
+		ping.set_seqno (ctx->msg_sent);
 		ping.set_latency (latency);
-		ping.set_payload (payload, sizeof(payload));
+		ping.set_payload (payload, g_sizes[ step ]);
 
+/* messages larger than one TPDU are copied and fragmented by pgm_send() */
 		const size_t header_size = pgm_pkt_offset (FALSE, g_pgmcc_family);
 		const size_t apdu_size = ping.ByteSize();
-		struct pgm_sk_buff_t* skb = pgm_alloc_skb (g_max_tpdu);
-		pgm_skb_reserve (skb, header_size);
-		pgm_skb_put (skb, apdu_size);
+		const gboolean use_skb = (header_size + apdu_size <= (size_t)g_max_tpdu);
+		struct pgm_sk_buff_t* skb = NULL;
+		if (use_skb) {
+			skb = pgm_alloc_skb (g_max_tpdu);
+			pgm_skb_reserve (skb, header_size);
+			pgm_skb_put (skb, apdu_size);
+		} else if (apdu_size > buffer_size) {
+			buffer_size = apdu_size;
+			buffer = (char*)g_realloc (buffer, buffer_size);
+		}
 
-/* wait on packet rate limit */
+/* wait on packet rate limit, open-loop: a late sender does not skip
+ * messages but catches up on the schedule.
+ */
 		if ((last + g_odata_interval) > now) {
 #ifndef _WIN32
 			const unsigned int usec = g_odata_interval - (now - last);
@@ -959,8 +1145,14 @@ sender_thread (
 			now = pgm_time_update_now();
 		}
 		last += g_odata_interval;
-		ping.set_time (now);
-		ping.SerializeToArray (skb->data, skb->len);
+/* stamp the scheduled send time so that delay behind schedule counts
+ * towards latency, correcting coordinated omission.
+ */
+		ping.set_time (g_odata_interval ? last : now);
+		if (use_skb)
+			ping.SerializeToArray (skb->data, skb->len);
+		else
+			ping.SerializeToArray (buffer, apdu_size);
 
 		struct timeval tv;
 #if defined(CONFIG_HAVE_EPOLL) || defined(CONFIG_HAVE_POLL)
@@ -976,7 +1168,10 @@ sender_thread (
 		size_t bytes_written;
 		int status;
 again:
-		status = pgm_send_skbv (tx_sock, &skb, 1, TRUE, &bytes_written);
+		if (use_skb)
+			status = pgm_send_skbv (tx_sock, &skb, 1, TRUE, &bytes_written);
+		else
+			status = pgm_send (tx_sock, buffer, apdu_size, &bytes_written);
 		switch (status) {
 /* rate control */
 		case PGM_IO_STATUS_RATE_LIMITED:
@@ -1040,7 +1235,7 @@ again:
 			FD_SET(g_quit_socket[0], &readfds);
 			n_fds = 1;				/* count of fds */
 #	endif
-			pgm_select_info (g_sock, &readfds, NULL, &n_fds);
+			pgm_select_info (tx_sock, &readfds, NULL, &n_fds);
 			n_fds = select (n_fds, &readfds, NULL, NULL, PGM_IO_STATUS_WOULD_BLOCK == status ? NULL : &tv);
 #endif /* !CONFIG_HAVE_EPOLL */
 			if (G_UNLIKELY(g_quit))
@@ -1081,7 +1276,7 @@ again:
 			fds[0].fd = g_quit_pipe[0];
 			fds[0].events = POLLIN;
 			n_fds = G_N_ELEMENTS(fds) - 1;
-			pgm_poll_info (g_sock, &fds[1], &n_fds, POLLOUT);
+			pgm_poll_info (tx_sock, &fds[1], &n_fds, POLLOUT);
 			poll (fds, 1 + n_fds, -1 /* ms */);
 #elif defined(CONFIG_HAVE_WSAPOLL)
 			ZeroMemory (fds, sizeof(WSAPOLLFD) * (n_fds + 1));
@@ -1106,7 +1301,7 @@ again:
 			FD_SET(g_quit_socket[0], &readfds);
 			n_fds = 1;				/* count of fds */
 #	endif
-			pgm_select_info (g_sock, &readfds, &writefds, &n_fds);
+			pgm_select_info (tx_sock, &readfds, &writefds, &n_fds);
 			n_fds = select (n_fds, &readfds, &writefds, NULL, NULL);
 			
 #endif /* !CONFIG_HAVE_EPOLL */
@@ -1122,10 +1317,16 @@ again:
 			g_main_loop_quit (g_loop);
 			return NULL;
 		}
-		g_out_total += bytes_written;
-		g_msg_sent++;
+		g_mutex_lock (ctx->lock);
+		ctx->out_total += bytes_written;
+		g_mutex_unlock (ctx->lock);
+		ctx->step_sent[ step ]++;
+		ctx->msg_sent++;
 	} while (G_LIKELY(!g_quit));
 
+	g_free (payload);
+	g_free (buffer);
+
 #if defined(CONFIG_HAVE_EPOLL)
 	close (efd_again);
 #elif defined(CONFIG_WSA_WAIT)
@@ -1141,7 +1342,8 @@ receiver_thread (
 	gpointer	data
 	)
 {
-	pgm_sock_t* rx_sock = (pgm_sock_t*)data;
+	struct ping_thread_t* ctx = (struct ping_thread_t*)data;
+	pgm_sock_t* rx_sock = ctx->sock;
 	const long iov_len = 20;
 	struct pgm_msgv_t msgv[iov_len];
 	pgm_time_t lost_tstamp = 0;
@@ -1251,12 +1453,12 @@ again:
 		switch (status) {
 		case PGM_IO_STATUS_NORMAL:
 //			g_message ("recv %u bytes", (unsigned)len);
-			on_msgv (msgv, len);
+			on_msgv (ctx, msgv, len);
 			break;
 		case PGM_IO_STATUS_TIMER_PENDING:
 			{
 				socklen_t optlen = sizeof (tv);
-				const gboolean status = pgm_getsockopt (g_sock, IPPROTO_PGM, PGM_TIME_REMAIN, &tv, &optlen);
+				const gboolean status = pgm_getsockopt (rx_sock, IPPROTO_PGM, PGM_TIME_REMAIN, &tv, &optlen);
 //g_message ("timer pending %d", ((tv.tv_sec * 1000) + (tv.tv_usec / 1000)));
 				if (G_UNLIKELY(!status)) {
 					g_error ("getting PGM_TIME_REMAIN failed");
@@ -1267,7 +1469,7 @@ again:
 		case PGM_IO_STATUS_RATE_LIMITED:
 			{
 				socklen_t optlen = sizeof (tv);
-				const gboolean status = pgm_getsockopt (g_sock, IPPROTO_PGM, PGM_RATE_REMAIN, &tv, &optlen);
+				const gboolean status = pgm_getsockopt (rx_sock, IPPROTO_PGM, PGM_RATE_REMAIN, &tv, &optlen);
 //g_message ("rate limited %d", ((tv.tv_sec * 1000) + (tv.tv_usec / 1000)));
 				if (G_UNLIKELY(!status)) {
 					g_error ("getting PGM_RATE_REMAIN failed");
@@ -1304,13 +1506,13 @@ block:
 			memset (fds, 0, sizeof(fds));
 			fds[0].fd = g_quit_pipe[0];
 			fds[0].events = POLLIN;
-			pgm_poll_info (g_sock, &fds[1], &n_fds, POLLIN);
+			pgm_poll_info (rx_sock, &fds[1], &n_fds, POLLIN);
 			poll (fds, 1 + n_fds, timeout /* ms */);
 #elif defined(CONFIG_HAVE_WSAPOLL)
 			ZeroMemory (fds, sizeof(fds));
 			fds[0].fd = g_quit_socket[0];
 			fds[0].events = POLLRDNORM;
-			pgm_poll_info (g_sock, &fds[1], &n_fds, POLLRDNORM);
+			pgm_poll_info (rx_sock, &fds[1], &n_fds, POLLRDNORM);
 			WSAPoll (fds, 1 + n_fds, dwTimeout /* ms */);
 #elif defined(CONFIG_WSA_WAIT)
 #	ifdef CONFIG_HAVE_IOCP
@@ -1332,7 +1534,7 @@ block:
 			FD_SET(g_quit_socket[0], &readfds);
 			n_fds = 1;				/* count of fds */
 #	endif
-			pgm_select_info (g_sock, &readfds, NULL, &n_fds);
+			pgm_select_info (rx_sock, &readfds, NULL, &n_fds);
 			n_fds = select (n_fds, &readfds, NULL, NULL, PGM_IO_STATUS_WOULD_BLOCK == status ? NULL : &tv);
 #endif /* !CONFIG_HAVE_EPOLL */
 			break;
@@ -1370,16 +1572,146 @@ block:
 	return NULL;
 }
 
+/* latency histogram */
+
+static inline
+guint
+histogram_index (
+	guint64		value		/* μs */
+	)
+{
+	if (value < HISTOGRAM_LINEAR)
+		return (guint)value;
+	guint msb = 63 - __builtin_clzll (value);
+	if (msb >= 10 + HISTOGRAM_GROUPS) {
+		msb = 10 + HISTOGRAM_GROUPS - 1;
+		value = (G_GUINT64_CONSTANT(2) << msb) - 1;
+	}
+	const guint shift = msb - HISTOGRAM_SUB_BITS;
+	return HISTOGRAM_LINEAR + ((msb - 10) << HISTOGRAM_SUB_BITS) + (guint)((value >> shift) - (1 << HISTOGRAM_SUB_BITS));
+}
+
+/* highest value sharing the bucket */
+
+static inline
+guint64
+histogram_value (
+	guint		index
+	)
+{
+	if (index < HISTOGRAM_LINEAR)
+		return index;
+	const guint group = (index - HISTOGRAM_LINEAR) >> HISTOGRAM_SUB_BITS;
+	const guint64 sub = (index - HISTOGRAM_LINEAR) & ((1 << HISTOGRAM_SUB_BITS) - 1);
+	return (((1 << HISTOGRAM_SUB_BITS) + sub + 1) << (group + 1)) - 1;
+}
+
+static
+void
+histogram_add (
+	struct histogram_t*	h,
+	guint64			value
+	)
+{
+	if (0 == h->count || value < h->min)
+		h->min = value;
+	if (value > h->max)
+		h->max = value;
+	h->total += value;
+	h->count++;
+	h->buckets[ histogram_index (value) ]++;
+}
+
+static
+void
+histogram_merge (
+	struct histogram_t*		h,
+	const struct histogram_t*	from
+	)
+{
+	if (0 == from->count)
+		return;
+	if (0 == h->count || from->min < h->min)
+		h->min = from->min;
+	if (from->max > h->max)
+		h->max = from->max;
+	h->total += from->total;
+	h->count += from->count;
+	for (guint i = 0; i < HISTOGRAM_BUCKETS; i++)
+		h->buckets[i] += from->buckets[i];
+}
+
+static
+guint64
+histogram_percentile (
+	const struct histogram_t*	h,
+	double				percentile
+	)
+{
+	if (0 == h->count)
+		return 0;
+	const guint64 rank = MAX((guint64)ceil (percentile / 100.0 * h->count), 1);
+	guint64 total = 0;
+	for (guint i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		total += h->buckets[i];
+		if (total >= rank)
+			return MIN(histogram_value (i), h->max);
+	}
+	return h->max;
+}
+
+/* return contiguous APDU, copying fragments into the reassembly buffer.
+ */
+
+static
+const char*
+apdu_data (
+	struct ping_thread_t*		ctx,
+	const struct pgm_msgv_t*	msgv,
+	gsize				apdu_len
+	)
+{
+	if (1 == msgv->msgv_len)
+		return (const char*)msgv->msgv_skb[0]->data;
+	if (apdu_len > ctx->apdu_size) {
+		ctx->apdu_size = apdu_len;
+		ctx->apdu = (char*)g_realloc (ctx->apdu, ctx->apdu_size);
+	}
+	gsize offset = 0;
+	for (unsigned j = 0; j < msgv->msgv_len; j++) {
+		memcpy (ctx->apdu + offset, msgv->msgv_skb[j]->data, msgv->msgv_skb[j]->len);
+		offset += msgv->msgv_skb[j]->len;
+	}
+	return ctx->apdu;
+}
+
+/* step of a received message by payload size, straggling messages of the
+ * previous size are not mis-attributed, unknown sizes count towards the
+ * current step.
+ */
+
+static
+guint
+find_step (
+	gsize		payload_len
+	)
+{
+	for (guint i = 0; i < g_size_count; i++)
+		if (g_sizes[i] == payload_len)
+			return i;
+	return g_step;
+}
+
 static
 int
 on_msgv (
+	struct ping_thread_t*	ctx,
 	struct pgm_msgv_t*	msgv,		/* an array of msgvs */
 	size_t			len
 	)
 {
 	example::Ping ping;
 	guint i = 0;
-	static pgm_time_t last_time = pgm_time_update_now();
 
 	while (len)
 	{
@@ -1387,12 +1719,13 @@ on_msgv (
 		gsize apdu_len = 0;
 		for (unsigned j = 0; j < msgv[i].msgv_len; j++)
 			apdu_len += msgv[i].msgv_skb[j]->len;
+		const char* apdu = apdu_data (ctx, &msgv[i], apdu_len);
 
 		if (PGMPING_MODE_REFLECTOR == g_mode)
 		{
 			int status;
 again:
-			status = pgm_send (g_sock, pskb->data, pskb->len, NULL);
+			status = pgm_send (ctx->sock, apdu, apdu_len, NULL);
 			switch (status) {
 			case PGM_IO_STATUS_RATE_LIMITED:
 //g_message ("reflector ratelimit");
@@ -1416,25 +1749,25 @@ g_message ("reflector congestion");
 			goto next_msg;
 		}
 
-/* only parse first fragment of each apdu */
-		if (!ping.ParseFromArray (pskb->data, pskb->len))
+		if (!ping.ParseFromArray (apdu, apdu_len))
 			goto next_msg;
 //		g_message ("payload: %s", ping.DebugString().c_str());
 
+/* reflections of other senders */
+		if (PGMPING_MODE_INITIATOR == g_mode &&
+		    ping.subscription_header().subject() != ctx->subject)
+			goto next_msg;
+
 		{
 			const pgm_time_t send_time	= ping.time();
 			const pgm_time_t recv_time	= pskb->tstamp;
 			const guint64 seqno		= ping.seqno();
-			const guint64 latency		= ping.latency();
 
-			if (seqno < g_latency_seqno) {
+			if (seqno < ctx->latency_seqno) {
 				g_message ("seqno replay?");
 				goto next_msg;
 			}
 
-			g_in_total += pskb->len;
-			g_msg_received++;
-
 /* handle ping */
 			const pgm_time_t now = pgm_time_update_now();
 			if (send_time > now)
@@ -1446,24 +1779,27 @@ g_message ("reflector congestion");
 			if (send_time > recv_time){
 				g_message ("timer mismatch, send time = recv time + %.3f ms (last time + %.3f ms)",
 					   pgm_to_msecsf(send_time - recv_time),
-					   pgm_to_msecsf(last_time - send_time));
+					   pgm_to_msecsf(ctx->last_time - send_time));
 				goto next_msg;
 			}
-			g_latency_current	= pgm_to_secs (recv_time - send_time);
-			g_latency_seqno		= seqno;
+			ctx->latency_current	= pgm_to_secs (recv_time - send_time);
+			ctx->latency_seqno	= seqno;
 
 			const double elapsed    = pgm_to_usecsf (recv_time - send_time);
-			g_latency_total	       += elapsed;
-			g_latency_square_total += elapsed * elapsed;
-
-			if (elapsed > g_latency_max)
-				g_latency_max = elapsed;
-			if (elapsed < g_latency_min)
-				g_latency_min = elapsed;
-
-			g_latency_running_average += elapsed;
-			g_latency_count++;
-			last_time = recv_time;
+			g_mutex_lock (ctx->lock);
+			ctx->in_total	       += apdu_len;
+			ctx->latency_total     += elapsed;
+			ctx->latency_square_total += elapsed * elapsed;
+			if (elapsed > ctx->latency_max)
+				ctx->latency_max = elapsed;
+			if (elapsed < ctx->latency_min)
+				ctx->latency_min = elapsed;
+			ctx->latency_count++;
+			g_mutex_unlock (ctx->lock);
+			ctx->last_time = recv_time;
+
+			histogram_add (&ctx->step_latency[ find_step (ping.payload().size()) ],
+				       pgm_to_usecs (recv_time - send_time));
 
 #ifdef CONFIG_WITH_HEATMAP
 /* update heatmap slice */
@@ -1504,50 +1840,72 @@ on_mark (
 	const double interval = pgm_to_secsf(now - g_interval_start);
 	g_interval_start = now;
 
+/* collect and reset interval counters of every thread */
+	double latency_total = 0.0, latency_square_total = 0.0, latency_max = 0.0;
+#ifdef INFINITY
+	double latency_min = INFINITY;
+#else
+	double latency_min = (double)INT64_MAX;
+#endif
+	guint64 latency_count = 0, latency_seqno = 0, out_total = 0, in_total = 0;
+	for (int i = 0; i < g_threads; i++) {
+		struct ping_thread_t* ctx = &g_ctx[i];
+		g_mutex_lock (ctx->lock);
+		if (ctx->latency_count) {
+			latency_total	     += ctx->latency_total;
+			latency_square_total += ctx->latency_square_total;
+			latency_count	     += ctx->latency_count;
+			latency_max	      = MAX(latency_max, ctx->latency_max);
+			latency_min	      = MIN(latency_min, ctx->latency_min);
+			latency_seqno	      = MAX(latency_seqno, ctx->latency_seqno);
+			out_total	     += ctx->out_total;
+			in_total	     += ctx->in_total;
+
+			ctx->latency_total	  = 0.0;
+			ctx->latency_square_total = 0.0;
+			ctx->latency_count	  = 0;
+#ifdef INFINITY
+			ctx->latency_min	  = INFINITY;
+#else
+			ctx->latency_min	  = (double)INT64_MAX;
+#endif
+			ctx->latency_max	  = 0.0;
+			ctx->out_total		  = 0;
+			ctx->in_total		  = 0;
+		}
+		g_mutex_unlock (ctx->lock);
+	}
+
 /* receiving a ping */
-	if (g_latency_count)
+	if (latency_count)
 	{
-		const double average = g_latency_total / g_latency_count;
-		const double variance = g_latency_square_total / g_latency_count
+		const double average = latency_total / latency_count;
+		const double variance = latency_square_total / latency_count
 					- average * average;
 		const double standard_deviation = sqrt (variance);
 
-		if (g_latency_count < 10)
+		if (latency_count < 10)
 		{
 			if (average < 1000.0)
 				g_message ("seqno=%" G_GUINT64_FORMAT " time=%.01f us",
-						g_latency_seqno, average);
+						latency_seqno, average);
 			else
 				g_message ("seqno=%" G_GUINT64_FORMAT " time=%.01f ms",
-						g_latency_seqno, average / 1000);
+						latency_seqno, average / 1000);
 		}
 		else
 		{
-			double seq_rate = (g_latency_seqno - g_last_seqno) / interval;
-			double out_rate = g_out_total * 8.0 / 1000000.0 / interval;
-			double  in_rate = g_in_total  * 8.0 / 1000000.0 / interval;
-			if (g_latency_min < 1000.0)
+			double seq_rate = latency_count / interval;
+			double out_rate = out_total * 8.0 / 1000000.0 / interval;
+			double  in_rate = in_total  * 8.0 / 1000000.0 / interval;
+			if (latency_min < 1000.0)
 				g_message ("s=%.01f avg=%.01f min=%.01f max=%.01f stddev=%0.1f us o=%.2f i=%.2f mbit",
-					seq_rate, average, g_latency_min, g_latency_max, standard_deviation, out_rate, in_rate);
+					seq_rate, average, latency_min, latency_max, standard_deviation, out_rate, in_rate);
 			else
 				g_message ("s=%.01f avg=%.01f min=%.01f max=%.01f stddev=%0.1f ms o=%.2f i=%.2f mbit",
-					seq_rate, average / 1000, g_latency_min / 1000, g_latency_max / 1000, standard_deviation / 1000, out_rate, in_rate);
+					seq_rate, average / 1000, latency_min / 1000, latency_max / 1000, standard_deviation / 1000, out_rate, in_rate);
 		}
 
-/* reset interval counters */
-		g_latency_total		= 0.0;
-		g_latency_square_total	= 0.0;
-		g_latency_count		= 0;
-		g_last_seqno		= g_latency_seqno;
-#ifdef INFINITY
-		g_latency_min		= INFINITY;
-#else
-		g_latency_min		= (double)INT64_MAX;
-#endif
-		g_latency_max		= 0.0;
-		g_out_total		= 0;
-		g_in_total		= 0;
-
 #ifdef CONFIG_WITH_HEATMAP
 /* serialize heatmap slice */
 		if (NULL != g_heatmap_file) {
@@ -1575,4 +1933,121 @@ on_mark (
 	return TRUE;
 }
 
+/* merge the histograms of every thread for one step.
+ */
+
+static
+void
+step_totals (
+	guint			step,
+	struct histogram_t*	latency,
+	guint64*		sent,
+	double*			elapsed		/* seconds */
+	)
+{
+	memset (latency, 0, sizeof(struct histogram_t));
+	*sent = 0;
+	for (int i = 0; i < g_threads; i++) {
+		histogram_merge (latency, &g_ctx[i].step_latency[ step ]);
+		*sent += g_ctx[i].step_sent[ step ];
+	}
+	const pgm_time_t end = (step + 1 < g_size_count && step < g_step) ? g_step_start[ step + 1 ] : g_finish;
+	*elapsed = (end > g_step_start[ step ]) ? pgm_to_secsf (end - g_step_start[ step ]) : 0.0;
+}
+
+static
+void
+print_summary (void)
+{
+	struct histogram_t* latency = g_new (struct histogram_t, 1);
+	for (guint step = 0; step <= g_step && step < g_size_count; step++)
+	{
+		guint64 sent;
+		double elapsed;
+		step_totals (step, latency, &sent, &elapsed);
+		g_message ("size=%u sent=%" G_GUINT64_FORMAT " received=%" G_GUINT64_FORMAT " s=%.01f"
+			   " p50=%" G_GUINT64_FORMAT " p99=%" G_GUINT64_FORMAT " p99.9=%" G_GUINT64_FORMAT " max=%" G_GUINT64_FORMAT " us",
+			   g_sizes[ step ], sent, latency->count,
+			   elapsed > 0.0 ? latency->count / elapsed : 0.0,
+			   histogram_percentile (latency, 50.0),
+			   histogram_percentile (latency, 99.0),
+			   histogram_percentile (latency, 99.9),
+			   latency->max);
+	}
+	g_free (latency);
+}
+
+static
+void
+write_json_string (
+	FILE*		fp,
+	const char*	str
+	)
+{
+	fputc ('"', fp);
+	for (const char* c = str; *c; c++) {
+		if ('"' == *c || '\\' == *c)
+			fputc ('\\', fp);
+		if ((unsigned char)*c < 0x20)
+			fprintf (fp, "\\u%04x", (unsigned char)*c);
+		else
+			fputc (*c, fp);
+	}
+	fputc ('"', fp);
+}
+
+/* one object per run with an entry per message size, latencies in
+ * microseconds from scheduled send time.
+ */
+
+static
+void
+write_json (
+	const char*	filename
+	)
+{
+	static const char* modes[] = { "source", "receiver", "initiator", "reflector" };
+	FILE* fp = fopen (filename, "w");
+	if (NULL == fp) {
+		g_warning ("Cannot open %s: %s", filename, strerror (errno));
+		return;
+	}
+	fprintf (fp, "{\n");
+	fprintf (fp, "  \"mode\": \"%s\",\n", modes[ g_mode ]);
+	fprintf (fp, "  \"network\": ");
+	write_json_string (fp, g_network);
+	fprintf (fp, ",\n");
+	fprintf (fp, "  \"threads\": %d,\n", g_threads);
+	fprintf (fp, "  \"rate\": %d,\n", g_odata_rate);
+	fprintf (fp, "  \"step_duration_ms\": %d,\n", g_step_duration);
+	fprintf (fp, "  \"coordinated_omission_corrected\": %s,\n", g_odata_interval ? "true" : "false");
+	fprintf (fp, "  \"steps\": [");
+	struct histogram_t* latency = g_new (struct histogram_t, 1);
+	for (guint step = 0; step <= g_step && step < g_size_count; step++)
+	{
+		guint64 sent;
+		double elapsed;
+		step_totals (step, latency, &sent, &elapsed);
+		fprintf (fp, "%s\n    {\n", step ? "," : "");
+		fprintf (fp, "      \"size\": %u,\n", g_sizes[ step ]);
+		fprintf (fp, "      \"elapsed\": %.3f,\n", elapsed);
+		fprintf (fp, "      \"sent\": %" G_GUINT64_FORMAT ",\n", sent);
+		fprintf (fp, "      \"received\": %" G_GUINT64_FORMAT ",\n", latency->count);
+		fprintf (fp, "      \"latency\": { \"min\": %" G_GUINT64_FORMAT ", \"mean\": %.1f, \"p50\": %" G_GUINT64_FORMAT
+			     ", \"p90\": %" G_GUINT64_FORMAT ", \"p99\": %" G_GUINT64_FORMAT ", \"p99.9\": %" G_GUINT64_FORMAT
+			     ", \"max\": %" G_GUINT64_FORMAT " }\n",
+			 latency->min,
+			 latency->count ? latency->total / latency->count : 0.0,
+			 histogram_percentile (latency, 50.0),
+			 histogram_percentile (latency, 90.0),
+			 histogram_percentile (latency, 99.0),
+			 histogram_percentile (latency, 99.9),
+			 latency->max);
+		fprintf (fp, "    }");
+	}
+	fprintf (fp, "\n  ]\n}\n");
+	g_free (latency);
+	fclose (fp);
+}
+
 /* eof */
@@ -0,0 +1,384 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * Replay a packet capture through the PGM receive path without a network
+ * and report the receive cost per packet.  Captures may be taken with
+ * pgmdump -w or tcpdump -w, the same capture replayed through two builds
+ * compares their per-packet CPU cost on identical input.
+ *
+ * Copyright (c) 2006-2010 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* MSVC secure CRT */
+#define _CRT_SECURE_NO_WARNINGS		1
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <locale.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#	include <unistd.h>
+#	include <getopt.h>
+#	include <time.h>
+#else
+#	include "getopt.h"
+#endif
+#ifdef __APPLE__
+#	include <pgm/in.h>
+#endif
+#include <pgm/pgm.h>
+
+
+/* globals */
+
+static int		port = 0;
+static const char*	network = "";
+static int		udp_encap_port = 0;
+static const char*	capture = NULL;
+static int		speed = 0;
+static bool		use_naks = FALSE;
+
+static int		max_tpdu = 1500;
+static int		sqns = 100;
+
+static pgm_sock_t*	sock = NULL;
+static volatile bool	is_terminated = FALSE;
+
+#ifndef _MSC_VER
+static void usage (const char*) __attribute__((__noreturn__));
+#else
+static void usage (const char*);
+#endif
+
+static void on_signal (int);
+static bool on_startup (void);
+
+
+static void
+usage (
+	const char*	bin
+	)
+{
+	fprintf (stderr, "Usage: %s [options] -r FILE\n", bin);
+	fprintf (stderr, "  -r, --read FILE          : pcap capture to replay\n");
+	fprintf (stderr, "  -x, --speed PERCENT      : Percent of captured timing, 0 for maximum (0)\n");
+	fprintf (stderr, "  -n, --network NETWORK    : Multicast group or unicast IP address\n");
+	fprintf (stderr, "  -s, --service PORT       : IP port\n");
+	fprintf (stderr, "  -p, --port PORT          : Encapsulate PGM in UDP on IP port\n");
+	fprintf (stderr, "  -w, --rxw-sqns N         : Receive window in sequences (100)\n");
+	fprintf (stderr, "  -a, --active             : Send NAKs and SPMRs, on an isolated host only\n");
+	fprintf (stderr, "  -i, --list               : List available interfaces\n");
+	exit (EXIT_SUCCESS);
+}
+
+/* elapsed time, CPU time of the calling thread and of the process in
+ * nanoseconds.
+ */
+
+static
+void
+sample_time (
+	uint64_t*	wall_ns,
+	uint64_t*	thread_ns,
+	uint64_t*	process_ns
+	)
+{
+#ifndef _WIN32
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	*wall_ns    = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+	clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts);
+	*thread_ns  = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &ts);
+	*process_ns = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+	FILETIME creation, exit, kernel, user;
+	*wall_ns    = (uint64_t)GetTickCount64() * 1000000;
+	GetThreadTimes (GetCurrentThread(), &creation, &exit, &kernel, &user);
+	*thread_ns  = ((((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime) +
+		       (((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime)) * 100;
+	GetProcessTimes (GetCurrentProcess(), &creation, &exit, &kernel, &user);
+	*process_ns = ((((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime) +
+		       (((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime)) * 100;
+#endif
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	pgm_error_t* pgm_err = NULL;
+
+	setlocale (LC_ALL, "");
+
+	puts ("pgmreplay");
+	if (!pgm_init (&pgm_err)) {
+		fprintf (stderr, "Unable to start PGM engine: %s\n", pgm_err->message);
+		pgm_error_free (pgm_err);
+		return EXIT_FAILURE;
+	}
+
+/* parse program arguments */
+#ifdef _WIN32
+	const char* binary_name = strrchr (argv[0], '\\');
+#else
+	const char* binary_name = strrchr (argv[0], '/');
+#endif
+	if (NULL == binary_name)	binary_name = argv[0];
+	else				binary_name++;
+
+	static struct option long_options[] = {
+		{ "read",           required_argument, NULL, 'r' },
+		{ "speed",          required_argument, NULL, 'x' },
+		{ "network",        required_argument, NULL, 'n' },
+		{ "service",        required_argument, NULL, 's' },
+		{ "port",           required_argument, NULL, 'p' },
+		{ "rxw-sqns",       required_argument, NULL, 'w' },
+		{ "active",         no_argument,       NULL, 'a' },
+		{ "list",           no_argument,       NULL, 'i' },
+		{ "help",           no_argument,       NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	int c;
+	while ((c = getopt_long (argc, argv, "r:x:n:s:p:w:aih", long_options, NULL)) != -1)
+	{
+		switch (c) {
+		case 'r':	capture = optarg; break;
+		case 'x':	speed = atoi (optarg); break;
+		case 'n':	network = optarg; break;
+		case 's':	port = atoi (optarg); break;
+		case 'p':	udp_encap_port = atoi (optarg); break;
+		case 'w':	sqns = atoi (optarg); break;
+		case 'a':	use_naks = TRUE; break;
+
+		case 'i':
+			pgm_if_print_all();
+			return EXIT_SUCCESS;
+
+		case 'h':
+		case '?': usage (binary_name);
+		}
+	}
+
+	if (NULL == capture || speed < 0 || sqns <= 0)
+		usage (binary_name);
+
+	signal (SIGINT,  on_signal);
+	signal (SIGTERM, on_signal);
+
+	if (!on_startup()) {
+		fprintf (stderr, "Startup failed\n");
+		return EXIT_FAILURE;
+	}
+
+/* blocking reads, a replayed capture never waits on the network */
+	struct pgm_msgv_t msgv[ 32 ];
+	uint64_t messages = 0, bytes = 0, resets = 0;
+	uint64_t wall_start, thread_start, process_start, wall_end, thread_end, process_end;
+	sample_time (&wall_start, &thread_start, &process_start);
+	do {
+		size_t len;
+		const int status = pgm_recvmsgv (sock,
+						 msgv,
+						 sizeof(msgv) / sizeof(msgv[0]),
+						 0,
+						 &len,
+						 &pgm_err);
+		if (PGM_IO_STATUS_NORMAL == status) {
+			bytes += len;
+			for (unsigned i = 0; len > 0; i++) {
+				for (unsigned j = 0; j < msgv[i].msgv_len; j++)
+					len -= msgv[i].msgv_skb[j]->len;
+				messages++;
+			}
+			continue;
+		}
+		if (pgm_err) {
+			fprintf (stderr, "%s\n", pgm_err->message);
+			pgm_error_free (pgm_err);
+			pgm_err = NULL;
+		}
+		if (PGM_IO_STATUS_RESET == status) {
+			resets++;
+			continue;
+		}
+		if (PGM_IO_STATUS_EOF == status || PGM_IO_STATUS_ERROR == status)
+			break;
+	} while (!is_terminated);
+	sample_time (&wall_end, &thread_end, &process_end);
+
+	struct pgm_replayinfo_t replayinfo;
+	socklen_t optlen = sizeof (replayinfo);
+	pgm_getsockopt (sock, IPPROTO_PGM, PGM_REPLAY, &replayinfo, &optlen);
+	const uint64_t packets = replayinfo.packets ? replayinfo.packets : 1;
+
+	printf ("Replayed %" PRIu64 " packets in %.3f s, delivered %" PRIu64 " messages of %" PRIu64 " bytes, %" PRIu64 " resets.\n",
+		replayinfo.packets,
+		(double)(wall_end - wall_start) / 1e9,
+		messages, bytes, resets);
+	printf ("Receive thread CPU %.3f s, %" PRIu64 " ns per packet.\n",
+		(double)(thread_end - thread_start) / 1e9,
+		(thread_end - thread_start) / packets);
+	printf ("Process CPU %.3f s, %" PRIu64 " ns per packet.\n",
+		(double)(process_end - process_start) / 1e9,
+		(process_end - process_start) / packets);
+
+/* cleanup */
+	if (sock) {
+		pgm_close (sock, TRUE);
+		sock = NULL;
+	}
+	pgm_shutdown ();
+	return EXIT_SUCCESS;
+}
+
+static
+void
+on_signal (
+	int		signum
+	)
+{
+	(void)signum;
+	is_terminated = TRUE;
+}
+
+static
+bool
+on_startup (void)
+{
+	struct pgm_addrinfo_t* res = NULL;
+	pgm_error_t* pgm_err = NULL;
+	sa_family_t sa_family = AF_UNSPEC;
+
+/* parse network parameter into PGM socket address structure */
+	if (!pgm_getaddrinfo (network, NULL, &res, &pgm_err)) {
+		fprintf (stderr, "Parsing network parameter: %s\n", pgm_err->message);
+		goto err_abort;
+	}
+
+	sa_family = res->ai_send_addrs[0].gsr_group.ss_family;
+
+	if (udp_encap_port) {
+		if (!pgm_socket (&sock, sa_family, SOCK_SEQPACKET, IPPROTO_UDP, &pgm_err)) {
+			fprintf (stderr, "Creating PGM/UDP socket: %s\n", pgm_err->message);
+			goto err_abort;
+		}
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_UDP_ENCAP_UCAST_PORT, &udp_encap_port, sizeof(udp_encap_port));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_UDP_ENCAP_MCAST_PORT, &udp_encap_port, sizeof(udp_encap_port));
+	} else {
+		if (!pgm_socket (&sock, sa_family, SOCK_SEQPACKET, IPPROTO_PGM, &pgm_err)) {
+			fprintf (stderr, "Creating PGM/IP socket: %s\n", pgm_err->message);
+			goto err_abort;
+		}
+	}
+
+	pgm_drop_superuser();
+
+/* set PGM parameters, passive unless asked otherwise as repairs of a
+ * capture would be requested from its production sources.
+ */
+	const int recv_only = 1,
+		  passive = use_naks ? 0 : 1,
+		  peer_expiry = pgm_secs (300),
+		  spmr_expiry = pgm_msecs (250),
+		  nak_bo_ivl = pgm_msecs (50),
+		  nak_rpt_ivl = pgm_secs (2),
+		  nak_rdata_ivl = pgm_secs (2),
+		  nak_data_retries = 50,
+		  nak_ncf_retries = 50;
+
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_RECV_ONLY, &recv_only, sizeof(recv_only));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_PASSIVE, &passive, sizeof(passive));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_MTU, &max_tpdu, sizeof(max_tpdu));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_RXW_SQNS, &sqns, sizeof(sqns));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_PEER_EXPIRY, &peer_expiry, sizeof(peer_expiry));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_SPMR_EXPIRY, &spmr_expiry, sizeof(spmr_expiry));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_BO_IVL, &nak_bo_ivl, sizeof(nak_bo_ivl));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_RPT_IVL, &nak_rpt_ivl, sizeof(nak_rpt_ivl));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_RDATA_IVL, &nak_rdata_ivl, sizeof(nak_rdata_ivl));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_DATA_RETRIES, &nak_data_retries, sizeof(nak_data_retries));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_NCF_RETRIES, &nak_ncf_retries, sizeof(nak_ncf_retries));
+
+	struct pgm_replayinfo_t replayinfo;
+	memset (&replayinfo, 0, sizeof(replayinfo));
+	replayinfo.path  = capture;
+	replayinfo.speed = speed;
+	if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_REPLAY, &replayinfo, sizeof(replayinfo))) {
+		fprintf (stderr, "Setting PGM_REPLAY failed.\n");
+		goto err_abort;
+	}
+
+/* create global session identifier */
+	struct pgm_sockaddr_t addr;
+	memset (&addr, 0, sizeof(addr));
+	addr.sa_port = port ? port : DEFAULT_DATA_DESTINATION_PORT;
+	addr.sa_addr.sport = DEFAULT_DATA_SOURCE_PORT;
+	if (!pgm_gsi_create_from_hostname (&addr.sa_addr.gsi, &pgm_err)) {
+		fprintf (stderr, "Creating GSI: %s\n", pgm_err->message);
+		goto err_abort;
+	}
+
+/* assign socket to specified address, the capture is read in place of the network */
+	struct pgm_interface_req_t if_req;
+	memset (&if_req, 0, sizeof(if_req));
+	if_req.ir_interface = res->ai_recv_addrs[0].gsr_interface;
+	memcpy (&if_req.ir_address, &res->ai_send_addrs[0].gsr_addr, sizeof(struct sockaddr_storage));
+	if (!pgm_bind3 (sock,
+			&addr, sizeof(addr),
+			&if_req, sizeof(if_req),	/* tx interface */
+			&if_req, sizeof(if_req),	/* rx interface */
+			&pgm_err))
+	{
+		fprintf (stderr, "Binding PGM socket: %s\n", pgm_err->message);
+		goto err_abort;
+	}
+
+	for (unsigned i = 0; i < res->ai_recv_addrs_len; i++)
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_JOIN_GROUP, &res->ai_recv_addrs[i], sizeof(struct pgm_group_source_req));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_SEND_GROUP, &res->ai_send_addrs[0], sizeof(struct pgm_group_source_req));
+
+	pgm_freeaddrinfo (res);
+	res = NULL;
+
+	if (!pgm_connect (sock, &pgm_err)) {
+		fprintf (stderr, "Connecting PGM socket: %s\n", pgm_err->message);
+		goto err_abort;
+	}
+	return TRUE;
+
+err_abort:
+	if (NULL != sock) {
+		pgm_close (sock, FALSE);
+		sock = NULL;
+	}
+	if (NULL != res) {
+		pgm_freeaddrinfo (res);
+		res = NULL;
+	}
+	if (NULL != pgm_err) {
+		pgm_error_free (pgm_err);
+		pgm_err = NULL;
+	}
+	return FALSE;
+}
+
+/* eof */
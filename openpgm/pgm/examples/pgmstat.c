@@ -0,0 +1,163 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * Print the statistics a PGM process publishes to shared memory, start the
+ * process with PGM_STATS_SHM set to a segment name.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pgm/pgm.h>
+#include <pgm/stats.h>
+
+
+/* globals */
+
+static const char*	segment = NULL;
+static int		interval = 0;		/* seconds, 0 to print once */
+
+static void usage (const char*) __attribute__((__noreturn__));
+
+
+static void
+usage (
+	const char*	bin
+	)
+{
+	fprintf (stderr, "Usage: %s [options]\n", bin);
+	fprintf (stderr, "  -n NAME                  : Shared memory segment, e.g. /pgm-stats.1234\n");
+	fprintf (stderr, "  -i SECONDS               : Repeat every SECONDS\n");
+	exit (EXIT_SUCCESS);
+}
+
+/* copy the segment out between two equal sequence numbers, the publisher is
+ * never blocked.
+ */
+
+static void
+print_stats (
+	const struct pgm_stats_shm_t*	shm,
+	char*				copy,
+	const size_t			len
+	)
+{
+	const struct pgm_stats_shm_t* snap = (const struct pgm_stats_shm_t*)copy;
+	uint32_t seq;
+
+	do {
+		seq = pgm_stats_shm_read_begin (shm);
+		memcpy (copy, shm, len);
+	} while (pgm_stats_shm_read_retry (shm, seq));
+
+	const struct pgm_stats_name_t* names = pgm_stats_shm_names (snap);
+	printf ("pid %" PRIu32 ": %" PRIu32 " sockets, %" PRIu32 " peers, %" PRIu32 " dropped\n",
+		snap->pid, snap->sock_count, snap->peer_count, snap->dropped);
+	for (unsigned i = 0; i < snap->sock_count; i++)
+	{
+		const struct pgm_stats_sock_t* sock = pgm_stats_shm_sock (snap, i);
+		printf ("socket %s\n", sock->tsi);
+		if (sock->mem_budget)
+			printf ("  memory %" PRIu64 "/%" PRIu64 " bytes\n", sock->mem_used, sock->mem_budget);
+		else
+			printf ("  memory %" PRIu64 " bytes\n", sock->mem_used);
+		if (sock->rx_cpu >= 0)
+			printf ("  receive cpu %" PRIi32 "\n", sock->rx_cpu);
+		if (sock->is_source) {
+			printf ("  window %" PRIu64 "/%" PRIu64 " packets, %" PRIu64 " bytes\n",
+				sock->txw_length, sock->txw_max_length, sock->txw_size);
+			for (unsigned k = 0; k < snap->source_counters; k++)
+				if ('\0' != names[ k ].name[ 0 ] && 0 != sock->stats[ k ])
+					printf ("  %-36s %" PRIu64 "\n", names[ k ].name, sock->stats[ k ]);
+		}
+		for (unsigned j = 0; j < sock->peer_count; j++)
+		{
+			const struct pgm_stats_peer_t* peer = pgm_stats_shm_peer (snap, sock->peer_first + j);
+			printf ("  peer %s window %" PRIu64 "/%" PRIu64 " packets, %" PRIu64 " bytes\n",
+				peer->tsi, peer->rxw_length, peer->rxw_max_length, peer->rxw_size);
+			for (unsigned k = 0; k < snap->receiver_counters; k++) {
+				const struct pgm_stats_name_t* name = &names[ snap->source_counters + k ];
+				if ('\0' != name->name[ 0 ] && 0 != peer->stats[ k ])
+					printf ("    %-34s %" PRIu64 "\n", name->name, peer->stats[ k ]);
+			}
+		}
+	}
+	fflush (stdout);
+}
+
+int
+main (
+	int	argc,
+	char   *argv[]
+	)
+{
+	setlocale (LC_ALL, "");
+
+	const char* binary_name = strrchr (argv[0], '/');
+	binary_name = binary_name ? binary_name + 1 : argv[0];
+	int c;
+	while ((c = getopt (argc, argv, "n:i:h")) != -1)
+	{
+		switch (c) {
+		case 'n':	segment = optarg; break;
+		case 'i':	interval = atoi (optarg); break;
+
+		case 'h':
+		case '?': usage (binary_name);
+		}
+	}
+	if (NULL == segment)
+		usage (binary_name);
+
+	const int fd = shm_open (segment, O_RDONLY, 0);
+	struct stat st;
+	if (-1 == fd || 0 != fstat (fd, &st)) {
+		fprintf (stderr, "Opening segment %s: %s\n", segment, strerror (errno));
+		return EXIT_FAILURE;
+	}
+	const struct pgm_stats_shm_t* shm = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close (fd);
+	if (MAP_FAILED == shm) {
+		fprintf (stderr, "Mapping segment %s: %s\n", segment, strerror (errno));
+		return EXIT_FAILURE;
+	}
+	if (PGM_STATS_SHM_MAGIC != __atomic_load_n (&shm->magic, __ATOMIC_ACQUIRE) ||
+	    PGM_STATS_SHM_VERSION != shm->version)
+	{
+		fprintf (stderr, "Segment %s is not a version %d statistics segment.\n", segment, PGM_STATS_SHM_VERSION);
+		return EXIT_FAILURE;
+	}
+
+	char* copy = malloc (st.st_size);
+	do {
+		print_stats (shm, copy, st.st_size);
+	} while (interval > 0 && 0 == sleep (interval));
+
+	free (copy);
+	munmap ((void*)shm, st.st_size);
+	return EXIT_SUCCESS;
+}
+
+/* eof */
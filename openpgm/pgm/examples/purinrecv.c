@@ -50,6 +50,8 @@ static int		port = 0;
 static const char*	network = "";
 static bool		use_multicast_loop = FALSE;
 static int		udp_encap_port = 0;
+static const char*	shm_name = NULL;
+static bool		use_late_join = FALSE;
 
 static int		max_tpdu = 1500;
 static int		sqns = 100;
@@ -93,6 +95,8 @@ usage (
 	fprintf (stderr, "  -N N                     : Reed-Solomon block size (255)\n");
 	fprintf (stderr, "  -K K                     : Reed-Solomon group size (8)\n");
 	fprintf (stderr, "  -l, --enable-loop        : Enable multicast loopback and address sharing\n");
+	fprintf (stderr, "  -S, --shm NAME           : Same-host transport through shared memory NAME\n");
+	fprintf (stderr, "  -J, --late-join          : Recover from the oldest data offered by the source\n");
 	fprintf (stderr, "  -i, --list               : List available interfaces\n");
 	exit (EXIT_SUCCESS);
 }
@@ -134,6 +138,8 @@ main (
 		{ "port",           required_argument, NULL, 'p' },
 		{ "enable-pgmcc",   no_argument,       NULL, 'c' },
 		{ "enable-loop",    no_argument,       NULL, 'l' },
+		{ "shm",            required_argument, NULL, 'S' },
+		{ "late-join",      no_argument,       NULL, 'J' },
 		{ "enable-fec",     required_argument, NULL, 'f' },
 		{ "list",           no_argument,       NULL, 'i' },
 		{ "help",           no_argument,       NULL, 'h' },
@@ -141,7 +147,7 @@ main (
 	};
 
 	int c;
-	while ((c = getopt_long (argc, argv, "s:n:p:cf:K:N:lih", long_options, NULL)) != -1)
+	while ((c = getopt_long (argc, argv, "s:n:p:cf:K:N:S:Jlih", long_options, NULL)) != -1)
 	{
 		switch (c) {
 		case 'n':	network = optarg; break;
@@ -152,6 +158,8 @@ main (
 		case 'K':	rs_k = atoi (optarg); break;
 		case 'N':	rs_n = atoi (optarg); break;
 		case 'l':	use_multicast_loop = TRUE; break;
+		case 'S':	shm_name = optarg; break;
+		case 'J':	use_late_join = TRUE; break;
 
 		case 'i':
 			pgm_if_print_all();
@@ -384,6 +392,18 @@ on_startup (void)
 	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_RDATA_IVL, &nak_rdata_ivl, sizeof(nak_rdata_ivl));
 	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_DATA_RETRIES, &nak_data_retries, sizeof(nak_data_retries));
 	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_NCF_RETRIES, &nak_ncf_retries, sizeof(nak_ncf_retries));
+	if (shm_name) {
+		struct pgm_shminfo_t shminfo;
+		memset (&shminfo, 0, sizeof(shminfo));
+		shminfo.name = shm_name;
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_SHM, &shminfo, sizeof(shminfo));
+	}
+	if (use_late_join) {
+		struct pgm_joininfo_t joininfo;
+		memset (&joininfo, 0, sizeof(joininfo));
+		joininfo.is_oldest = 1;
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_LATE_JOIN, &joininfo, sizeof(joininfo));
+	}
 
 #ifdef I_UNDERSTAND_PGMCC_AND_FEC_ARE_NOT_SUPPORTED
 	if (use_pgmcc) {
@@ -41,6 +41,7 @@
 #	include <pgm/in.h>
 #endif
 #include <pgm/pgm.hh>
+#include <pgm/pgm_message.hh>
 
 
 /* globals */
@@ -75,7 +76,7 @@ static void usage (const char*);
 #endif
 
 static bool on_startup (void);
-static int on_data (const void*, size_t, const ip::pgm::endpoint&);
+static int on_data (const pgm_message_view&);
 
 
 static void
@@ -194,24 +195,18 @@ main (
 	WSAEventSelect (pending_sock, waitEvents[2], FD_READ);
 #endif /* !_WIN32 */
 	std::cout << "Entering PGM message loop ... " << std::endl;
+	pgm_message_batch<> batch;
 	do {
 		socklen_t optlen;
 		struct timeval tv;
 #ifdef _WIN32
 		DWORD dwTimeout, dwEvents;
 #endif
-		char buffer[4096];
-		size_t len;
-		ip::pgm::endpoint from;
-		const int status = sock->receive_from (buffer,
-						       sizeof(buffer),
-						       0,
-						       &len,
-						       &from,
-						       &pgm_err);
+		const int status = batch.receive (*sock, 0, &pgm_err);
 		switch (status) {
 		case cpgm::PGM_IO_STATUS_NORMAL:
-			on_data (buffer, len, from);
+			for (std::size_t i = 0; i < batch.size(); i++)
+				on_data (batch[ i ]);
 			break;
 		case cpgm::PGM_IO_STATUS_TIMER_PENDING:
 			optlen = sizeof (tv);
@@ -430,21 +425,22 @@ err_abort:
 	return FALSE;
 }
 
+/* fragments are written in place from the receive window, the text need not
+ * be null terminated.
+ */
+
 static
 int
 on_data (
-	const void*       		data,
-	size_t				len,
-	const ip::pgm::endpoint&	from
+	const pgm_message_view&		msg
 	)
 {
-/* protect against non-null terminated strings */
-	char buf[1024], tsi[PGM_TSISTRLEN];
-	const size_t buflen = MIN(sizeof(buf) - 1, len);
-	strncpy (buf, (char*)data, buflen);
-	buf[buflen] = '\0';
-	cpgm::pgm_tsi_print_r (from.address(), tsi, sizeof(tsi));
-	std::cout << "\"" << buf << "\" (" << len << " bytes from " << tsi << ")" << std::endl;
+	char tsi[PGM_TSISTRLEN];
+	cpgm::pgm_tsi_print_r (&msg.tsi(), tsi, sizeof(tsi));
+	std::cout << "\"";
+	for (std::size_t i = 0; i < msg.size(); i++)
+		std::cout.write (reinterpret_cast<const char*> (msg[ i ].data()), msg[ i ].size());
+	std::cout << "\" (" << msg.bytes() << " bytes from " << tsi << ")" << std::endl;
 	return 0;
 }
 
@@ -42,6 +42,8 @@ static int		port = 0;
 static const char*	network = "";
 static bool		use_multicast_loop = FALSE;
 static int		udp_encap_port = 0;
+static const char*	shm_name = NULL;
+static const char*	txlog_path = NULL;
 
 static int		max_tpdu = 1500;
 static int		max_rte = 400*1000;		/* very conservative rate, 2.5mb/s */
@@ -75,6 +77,8 @@ usage (
 	fprintf (stderr, "  -N N                     : Reed-Solomon block size (255)\n");
 	fprintf (stderr, "  -K K                     : Reed-Solomon group size (8)\n");
 	fprintf (stderr, "  -l, --enable-loop        : Enable multicast loopback and address sharing\n");
+	fprintf (stderr, "  -S, --shm NAME           : Same-host transport through shared memory NAME\n");
+	fprintf (stderr, "  -T, --txlog PATH         : Keep sent data for late join in segment files PATH\n");
 	fprintf (stderr, "  -i, --list               : List available interfaces\n");
 	exit (EXIT_SUCCESS);
 }
@@ -110,6 +114,8 @@ main (
 		{ "port",           required_argument, NULL, 'p' },
 		{ "speed-limit",    required_argument, NULL, 'r' },
 		{ "enable-loop",    no_argument,       NULL, 'l' },
+		{ "shm",            required_argument, NULL, 'S' },
+		{ "txlog",          required_argument, NULL, 'T' },
 		{ "enable-fec",     required_argument, NULL, 'f' },
 		{ "list",           no_argument,       NULL, 'i' },
 		{ "help",           no_argument,       NULL, 'h' },
@@ -117,7 +123,7 @@ main (
 	};
 
 	int c;
-	while ((c = getopt_long (argc, argv, "s:n:p:r:f:K:N:lih", long_options, NULL)) != -1)
+	while ((c = getopt_long (argc, argv, "s:n:p:r:f:K:N:S:T:lih", long_options, NULL)) != -1)
 	{
 		switch (c) {
 		case 'n':	network = optarg; break;
@@ -129,6 +135,8 @@ main (
 		case 'N':	rs_n = atoi (optarg); break;
 
 		case 'l':	use_multicast_loop = TRUE; break;
+		case 'S':	shm_name = optarg; break;
+		case 'T':	txlog_path = optarg; break;
 
 		case 'i':
 			pgm_if_print_all();
@@ -223,6 +231,18 @@ create_sock (void)
 	pgm_setsockopt (sock, IPPROTO_PGM, PGM_TXW_MAX_RTE, &max_rte, sizeof(max_rte));
 	pgm_setsockopt (sock, IPPROTO_PGM, PGM_AMBIENT_SPM, &ambient_spm, sizeof(ambient_spm));
 	pgm_setsockopt (sock, IPPROTO_PGM, PGM_HEARTBEAT_SPM, &heartbeat_spm, sizeof(heartbeat_spm));
+	if (shm_name) {
+		struct pgm_shminfo_t shminfo;
+		memset (&shminfo, 0, sizeof(shminfo));
+		shminfo.name = shm_name;
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_SHM, &shminfo, sizeof(shminfo));
+	}
+	if (txlog_path) {
+		struct pgm_txloginfo_t txloginfo;
+		memset (&txloginfo, 0, sizeof(txloginfo));
+		txloginfo.path = txlog_path;
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_TXLOG, &txloginfo, sizeof(txloginfo));
+	}
 	if (use_fec) {
 		struct pgm_fecinfo_t fecinfo; 
 		fecinfo.block_size		= rs_n;
@@ -0,0 +1,370 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * kernel socket filter of the packets of one PGM session.
+ *
+ * A raw PGM socket sees every PGM packet arriving at the host, and a UDP
+ * encapsulated socket every packet on the encapsulation port, so each
+ * receiving socket wakes and parses traffic of unrelated sessions.  A
+ * classic BPF program on the receive socket keeps only the packet types the
+ * socket handles for its data-destination port, and for downstream packets
+ * only the joined source set less blocked sources.  The program is rebuilt
+ * on every membership change.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/filter.h>
+
+
+//#define FILTER_DEBUG
+
+#ifndef FILTER_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+#ifdef PGM_HAVE_SESSION_FILTER
+/* enough for an IPv6 source set of twenty plus blocked sources, larger sets
+ * filter by port only.
+ */
+#define FILTER_INSNS_MAX	320
+
+/* jump targets resolved once the program is complete */
+enum {
+	FILTER_LABEL_NONE = 0,
+	FILTER_LABEL_UPSTREAM,
+	FILTER_LABEL_DOWNSTREAM,
+	FILTER_LABEL_ACCEPT,
+	FILTER_LABEL_DROP,
+	FILTER_LABEL_MAX
+};
+
+struct filter_prog_t {
+	struct sock_filter	code[FILTER_INSNS_MAX];
+	uint8_t			jt[FILTER_INSNS_MAX];
+	uint8_t			jf[FILTER_INSNS_MAX];
+	unsigned		label[FILTER_LABEL_MAX];
+	unsigned		len;
+	bool			is_overflow;
+};
+
+static
+void
+emit (
+	struct filter_prog_t* const	prog,
+	const uint16_t			code,
+	const uint32_t			k
+	)
+{
+	if (PGM_UNLIKELY(prog->len == FILTER_INSNS_MAX)) {
+		prog->is_overflow = TRUE;
+		return;
+	}
+	const struct sock_filter insn = BPF_STMT(code, k);
+	prog->jt[ prog->len ] = prog->jf[ prog->len ] = FILTER_LABEL_NONE;
+	prog->code[ prog->len++ ] = insn;
+}
+
+/* jump to a label, or skip a literal count of instructions when the label is
+ * FILTER_LABEL_NONE.
+ */
+static
+void
+emit_jeq (
+	struct filter_prog_t* const	prog,
+	const uint32_t			k,
+	const uint8_t			jt_label,
+	const uint8_t			jt,
+	const uint8_t			jf_label,
+	const uint8_t			jf
+	)
+{
+	if (PGM_UNLIKELY(prog->len == FILTER_INSNS_MAX)) {
+		prog->is_overflow = TRUE;
+		return;
+	}
+	const struct sock_filter insn = BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, k, jt, jf);
+	prog->jt[ prog->len ] = jt_label;
+	prog->jf[ prog->len ] = jf_label;
+	prog->code[ prog->len++ ] = insn;
+}
+
+static
+void
+set_label (
+	struct filter_prog_t* const	prog,
+	const unsigned			label
+	)
+{
+	prog->label[ label ] = prog->len;
+}
+
+/* returns FALSE when a jump is out of range of the 8-bit offsets.
+ */
+static
+bool
+resolve_labels (
+	struct filter_prog_t* const	prog
+	)
+{
+	for (unsigned i = 0; i < prog->len; i++)
+	{
+		if (FILTER_LABEL_NONE != prog->jt[ i ]) {
+			const unsigned offset = prog->label[ prog->jt[ i ] ] - (i + 1);
+			if (offset > UINT8_MAX)
+				return FALSE;
+			prog->code[ i ].jt = (uint8_t)offset;
+		}
+		if (FILTER_LABEL_NONE != prog->jf[ i ]) {
+			const unsigned offset = prog->label[ prog->jf[ i ] ] - (i + 1);
+			if (offset > UINT8_MAX)
+				return FALSE;
+			prog->code[ i ].jf = (uint8_t)offset;
+		}
+	}
+	return TRUE;
+}
+
+/* compare the network source address to one source and jump to a label on match.
+ */
+static
+void
+emit_source (
+	struct filter_prog_t* const	prog,
+	const struct sockaddr* const	sa,
+	const uint8_t			label
+	)
+{
+	if (AF_INET6 == sa->sa_family) {
+		struct sockaddr_in6 sin6;
+		memcpy (&sin6, sa, sizeof(sin6));
+		const uint8_t* a = sin6.sin6_addr.s6_addr;
+		for (unsigned i = 0; i < 4; i++) {
+			const uint32_t w = (uint32_t)a[4*i] << 24 | (uint32_t)a[4*i+1] << 16 | (uint32_t)a[4*i+2] << 8 | a[4*i+3];
+			emit (prog, BPF_LD | BPF_W | BPF_ABS, (uint32_t)(SKF_NET_OFF + 8 + 4*i));
+			if (i < 3)
+				emit_jeq (prog, w, FILTER_LABEL_NONE, 0, FILTER_LABEL_NONE, (uint8_t)(6 - 2*i));
+			else
+				emit_jeq (prog, w, label, 0, FILTER_LABEL_NONE, 0);
+		}
+	} else {
+		struct sockaddr_in sin;
+		memcpy (&sin, sa, sizeof(sin));
+		emit_jeq (prog, ntohl (sin.sin_addr.s_addr), label, 0, FILTER_LABEL_NONE, 0);
+	}
+}
+
+/* accept the packet types handled by on_upstream(), on_peer() and on_downstream()
+ * for the session ports, optionally restricting downstream packets to a source set.
+ */
+static
+void
+build_program (
+	const pgm_sock_t* const		sock,
+	struct filter_prog_t* const	prog,
+	const bool			use_sources
+	)
+{
+	const uint32_t dport = ntohs (sock->dport);
+	const uint32_t sport = ntohs (sock->tsi.sport);
+
+	memset (prog, 0, sizeof(struct filter_prog_t));
+
+/* X = offset of the PGM header */
+	if (IPPROTO_UDP == sock->protocol)
+		emit (prog, BPF_LDX | BPF_IMM, sizeof(struct pgm_udphdr));
+	else if (AF_INET == sock->family)
+		emit (prog, BPF_LDX | BPF_B | BPF_MSH, 0);
+	else
+		emit (prog, BPF_LDX | BPF_IMM, 0);
+
+	emit (prog, BPF_LD | BPF_B | BPF_IND, offsetof(struct pgm_header, pgm_type));
+	emit_jeq (prog, PGM_ODATA, FILTER_LABEL_DOWNSTREAM, 0, FILTER_LABEL_NONE, 0);
+	emit_jeq (prog, PGM_RDATA, FILTER_LABEL_DOWNSTREAM, 0, FILTER_LABEL_NONE, 0);
+	emit_jeq (prog, PGM_SPM,   FILTER_LABEL_DOWNSTREAM, 0, FILTER_LABEL_NONE, 0);
+	emit_jeq (prog, PGM_NCF,   FILTER_LABEL_DOWNSTREAM, 0, FILTER_LABEL_NONE, 0);
+	emit_jeq (prog, PGM_POLL,  FILTER_LABEL_DOWNSTREAM, 0, FILTER_LABEL_NONE, 0);
+	emit_jeq (prog, PGM_NAK,   FILTER_LABEL_UPSTREAM,   0, FILTER_LABEL_NONE, 0);
+	emit_jeq (prog, PGM_NNAK,  FILTER_LABEL_UPSTREAM,   0, FILTER_LABEL_NONE, 0);
+	emit_jeq (prog, PGM_SPMR,  FILTER_LABEL_UPSTREAM,   0, FILTER_LABEL_NONE, 0);
+	emit_jeq (prog, PGM_ACK,   FILTER_LABEL_UPSTREAM,   0, FILTER_LABEL_NONE, 0);
+	emit_jeq (prog, PGM_POLR,  FILTER_LABEL_UPSTREAM,   0, FILTER_LABEL_DROP, 0);
+
+/* upstream ports are reversed: from the data-destination port to the source port
+ * of a source, or to the source port of another source for peer NAKs and SPMRs.
+ */
+	set_label (prog, FILTER_LABEL_UPSTREAM);
+	emit (prog, BPF_LD | BPF_H | BPF_IND, offsetof(struct pgm_header, pgm_sport));
+	emit_jeq (prog, dport, FILTER_LABEL_NONE, 0, FILTER_LABEL_DROP, 0);
+	if (sock->can_send_data) {
+		emit (prog, BPF_LD | BPF_H | BPF_IND, offsetof(struct pgm_header, pgm_dport));
+		emit_jeq (prog, sport, FILTER_LABEL_ACCEPT, 0, FILTER_LABEL_NONE, 0);
+	}
+	if (sock->can_recv_data) {
+		emit (prog, BPF_LD | BPF_B | BPF_IND, offsetof(struct pgm_header, pgm_type));
+		emit_jeq (prog, PGM_NAK,  FILTER_LABEL_ACCEPT, 0, FILTER_LABEL_NONE, 0);
+		emit_jeq (prog, PGM_SPMR, FILTER_LABEL_ACCEPT, 0, FILTER_LABEL_NONE, 0);
+	}
+	emit (prog, BPF_RET | BPF_K, 0);
+
+	set_label (prog, FILTER_LABEL_DOWNSTREAM);
+	if (!sock->can_recv_data) {
+		emit (prog, BPF_RET | BPF_K, 0);
+		goto tail;
+	}
+	emit (prog, BPF_LD | BPF_H | BPF_IND, offsetof(struct pgm_header, pgm_dport));
+	emit_jeq (prog, dport, FILTER_LABEL_NONE, 0, FILTER_LABEL_DROP, 0);
+	if (!use_sources)
+		goto tail;
+
+/* blocked sources */
+	if (AF_INET == sock->family && sock->block_src_len > 0)
+		emit (prog, BPF_LD | BPF_W | BPF_ABS, (uint32_t)(SKF_NET_OFF + 12));
+	for (unsigned i = 0; i < sock->block_src_len; i++)
+		emit_source (prog, (const struct sockaddr*)&sock->block_src[ i ], FILTER_LABEL_DROP);
+
+/* any-source membership admits every source not blocked */
+	unsigned ssm_count = 0;
+	for (unsigned i = 0; i < sock->recv_gsr_len; i++) {
+		const struct group_source_req* gsr = &sock->recv_gsr[ i ];
+		if (sock->family != gsr->gsr_source.ss_family)
+			goto tail;
+		if (0 == pgm_sockaddr_cmp ((const struct sockaddr*)&gsr->gsr_group, (const struct sockaddr*)&gsr->gsr_source))
+			goto tail;
+		ssm_count++;
+	}
+	if (0 == ssm_count)
+		goto tail;
+
+	if (AF_INET == sock->family)
+		emit (prog, BPF_LD | BPF_W | BPF_ABS, (uint32_t)(SKF_NET_OFF + 12));
+	for (unsigned i = 0; i < sock->recv_gsr_len; i++) {
+		const struct sockaddr* source = (const struct sockaddr*)&sock->recv_gsr[ i ].gsr_source;
+		bool is_duplicate = FALSE;
+		for (unsigned j = 0; j < i && !is_duplicate; j++)
+			is_duplicate = (0 == pgm_sockaddr_cmp (source, (const struct sockaddr*)&sock->recv_gsr[ j ].gsr_source));
+		if (!is_duplicate)
+			emit_source (prog, source, FILTER_LABEL_ACCEPT);
+	}
+	emit (prog, BPF_RET | BPF_K, 0);
+
+tail:
+	set_label (prog, FILTER_LABEL_ACCEPT);
+	emit (prog, BPF_RET | BPF_K, 0xffffffff);
+	set_label (prog, FILTER_LABEL_DROP);
+	emit (prog, BPF_RET | BPF_K, 0);
+}
+#endif /* PGM_HAVE_SESSION_FILTER */
+
+/* attach or replace the session filter of the receive socket.  a receive socket
+ * shared with other PGM sockets carries no filter, and sharded receive sockets
+ * keep their steering filter.  a source set too large for the program is left
+ * to the kernel membership.
+ *
+ * failure is not fatal, the parser discards foreign packets as before.
+ */
+
+void
+pgm_filter_update (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+#ifdef PGM_HAVE_SESSION_FILTER
+	if (NULL != sock->demux || sock->recv_shards > 1 || INVALID_SOCKET == sock->recv_sock)
+		return;
+	if (AF_INET != sock->family && AF_INET6 != sock->family)
+		return;
+
+	struct filter_prog_t* prog = pgm_new (struct filter_prog_t, 1);
+	build_program (sock, prog, TRUE);
+	if (prog->is_overflow || !resolve_labels (prog)) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Source set exceeds session filter, filtering by port only."));
+		build_program (sock, prog, FALSE);
+		if (PGM_UNLIKELY(!resolve_labels (prog))) {
+			pgm_free (prog);
+			return;
+		}
+	}
+	const struct sock_fprog fprog = {
+		.len	= prog->len,
+		.filter	= prog->code
+	};
+	if (SOCKET_ERROR == setsockopt (sock->recv_sock, SOL_SOCKET, SO_ATTACH_FILTER, (const char*)&fprog, sizeof(fprog)))
+	{
+		const int save_errno = pgm_get_last_sock_error();
+		char errbuf[1024];
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Attaching session filter: %s"),
+			   pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+	}
+	else
+		pgm_debug ("session filter attached with %u instructions", prog->len);
+	pgm_free (prog);
+#endif /* PGM_HAVE_SESSION_FILTER */
+}
+
+/* record a blocked source for the next filter update.
+ */
+
+void
+pgm_filter_block_source (
+	pgm_sock_t*            const restrict sock,
+	const struct sockaddr* const restrict source
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != source);
+
+	for (unsigned i = 0; i < sock->block_src_len; i++)
+		if (0 == pgm_sockaddr_cmp (source, (const struct sockaddr*)&sock->block_src[ i ]))
+			return;
+	if (sock->block_src_len == PGM_FILTER_BLOCK_MAX)
+		return;
+	memcpy (&sock->block_src[ sock->block_src_len++ ], source, pgm_sockaddr_len (source));
+}
+
+void
+pgm_filter_unblock_source (
+	pgm_sock_t*            const restrict sock,
+	const struct sockaddr* const restrict source
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != source);
+
+	for (unsigned i = 0; i < sock->block_src_len; i++)
+	{
+		if (0 != pgm_sockaddr_cmp (source, (const struct sockaddr*)&sock->block_src[ i ]))
+			continue;
+		sock->block_src_len--;
+		memmove (&sock->block_src[ i ], &sock->block_src[ i + 1 ], (sock->block_src_len - i) * sizeof(struct sockaddr_storage));
+		return;
+	}
+}
+
+/* eof */
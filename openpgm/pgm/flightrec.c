@@ -0,0 +1,225 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * Flight recorder, a fixed ring of recent protocol events per socket kept for
+ * post-mortem analysis of resets.  Recording costs one atomic increment and
+ * a 24 byte store, events are only formatted when dumped.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/flightrec.h>
+#include <impl/rxw.h>
+
+
+//#define FLIGHTREC_DEBUG
+
+
+/* locals */
+
+static const char* const flightrec_event_names[ PGM_FLIGHTREC_EVENT_MAX ] = {
+	"receive",
+	"nak-send",
+	"ncf-send",
+	"rdata-send",
+	"gap-state",
+	"reset"
+};
+
+static const char* flightrec_type_string (const unsigned, const unsigned);
+
+
+/* create a recorder of at least len events, rounded up to a power of two.
+ *
+ * returns NULL when len is zero, the recorder is then disabled.
+ */
+
+PGM_GNUC_INTERNAL
+pgm_flightrec_t*
+pgm_flightrec_create (
+	const unsigned		len
+	)
+{
+	pgm_flightrec_t* fr;
+	unsigned pow2_len = 1;
+
+	if (0 == len)
+		return NULL;
+	while (pow2_len < len && pow2_len < (1U << 31))
+		pow2_len <<= 1;
+
+	fr = pgm_malloc0 (sizeof (pgm_flightrec_t) + pow2_len * sizeof (pgm_flightrec_event_t));
+	fr->mask = pow2_len - 1;
+	return fr;
+}
+
+PGM_GNUC_INTERNAL
+void
+pgm_flightrec_destroy (
+	pgm_flightrec_t*	fr
+	)
+{
+	if (NULL == fr)
+		return;
+	pgm_free (fr);
+}
+
+/* copy up to n of the most recent events into events, oldest first.
+ *
+ * returns number of events copied.
+ */
+
+PGM_GNUC_INTERNAL
+unsigned
+pgm_flightrec_copy (
+	const pgm_flightrec_t* const restrict	fr,
+	pgm_flightrec_event_t*	     restrict	events,
+	const unsigned				n
+	)
+{
+	uint32_t head, count;
+
+/* pre-conditions */
+	pgm_assert (NULL != fr);
+	pgm_assert (NULL != events);
+
+	head  = pgm_atomic_read32 (&fr->head);
+	count = MIN(head, fr->mask + 1);
+	count = MIN(count, n);
+	for (uint32_t i = 0; i < count; i++)
+		events[ i ] = fr->events[ (head - count + i) & fr->mask ];
+	return count;
+}
+
+static
+const char*
+flightrec_type_string (
+	const unsigned		event,
+	const unsigned		type
+	)
+{
+	if (PGM_FLIGHTREC_GAP_STATE == event)
+		return pgm_pkt_state_string (type);
+	if (PGM_FLIGHTREC_RECEIVE != event)
+		return "";
+	switch (type) {
+	case PGM_SPM:	return "SPM";
+	case PGM_POLL:	return "POLL";
+	case PGM_POLR:	return "POLR";
+	case PGM_ODATA:	return "ODATA";
+	case PGM_RDATA:	return "RDATA";
+	case PGM_NAK:	return "NAK";
+	case PGM_NNAK:	return "NNAK";
+	case PGM_NCF:	return "NCF";
+	case PGM_SPMR:	return "SPMR";
+	case PGM_ACK:	return "ACK";
+	default:	return "(unknown)";
+	}
+}
+
+/* render the ring as a table, times relative to the newest event.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_flightrec_write_html (
+	const pgm_flightrec_t* const restrict	fr,
+	pgm_string_t*		     restrict	string
+	)
+{
+	pgm_flightrec_event_t* events;
+	unsigned count;
+
+	if (NULL == fr)
+		return;
+
+	events = pgm_new (pgm_flightrec_event_t, fr->mask + 1);
+	count = pgm_flightrec_copy (fr, events, fr->mask + 1);
+	const pgm_time_t newest = count > 0 ? events[ count - 1 ].tstamp : 0;
+	pgm_string_append (string,	"\n<h2>Flight recorder</h2>"
+						"\n<table>"
+						"<tr>"
+							"<th>Time</th>"
+							"<th>Event</th>"
+							"<th>Type</th>"
+							"<th>Source port</th>"
+							"<th>Sequence</th>"
+							"<th>Argument</th>"
+						"</tr>");
+	for (unsigned i = 0; i < count; i++)
+	{
+		const pgm_flightrec_event_t* e = &events[ i ];
+		if (e->event >= PGM_FLIGHTREC_EVENT_MAX)	/* torn by a concurrent writer */
+			continue;
+		pgm_string_append_printf (string,	"<tr>"
+								"<td>-%" PGM_TIME_FORMAT " μs</td>"
+								"<td>%s</td>"
+								"<td>%s</td>"
+								"<td>%u</td>"
+								"<td>%" PRIu32 "</td>"
+								"<td>%" PRIu32 "</td>"
+							"</tr>",
+					  newest > e->tstamp ? newest - e->tstamp : 0,
+					  flightrec_event_names[ e->event ],
+					  flightrec_type_string (e->event, e->type),
+					  pgm_ntohs (e->sport),
+					  e->sequence,
+					  e->arg);
+	}
+	pgm_string_append (string,	"</table>\n");
+	pgm_free (events);
+}
+
+/* dump the ring to the log, one line per event.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_flightrec_log (
+	const pgm_flightrec_t* const	fr
+	)
+{
+	pgm_flightrec_event_t* events;
+	unsigned count;
+
+	if (NULL == fr)
+		return;
+
+	events = pgm_new (pgm_flightrec_event_t, fr->mask + 1);
+	count = pgm_flightrec_copy (fr, events, fr->mask + 1);
+	pgm_warn (_("Flight recorder, %u events:"), count);
+	for (unsigned i = 0; i < count; i++)
+	{
+		const pgm_flightrec_event_t* e = &events[ i ];
+		if (e->event >= PGM_FLIGHTREC_EVENT_MAX)
+			continue;
+		pgm_warn ("%" PGM_TIME_FORMAT " %s %s sport %u seq %" PRIu32 " arg %" PRIu32,
+			  e->tstamp,
+			  flightrec_event_names[ e->event ],
+			  flightrec_type_string (e->event, e->type),
+			  pgm_ntohs (e->sport),
+			  e->sequence,
+			  e->arg);
+	}
+	pgm_free (events);
+}
+
+/* eof */
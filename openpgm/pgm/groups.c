@@ -0,0 +1,307 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * multicast group membership of a socket.
+ *
+ * Joined group/source pairs are kept in join order in a dynamically sized
+ * array, sock::recv_gsr, so that the first entry remains the primary group.
+ * Two hash tables index the array: one by group, source and interface for
+ * duplicate joins, and one by group alone for membership checks on the
+ * receive path.  Neither depends on the number of joins.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <string.h>
+#include <impl/framework.h>
+#include <impl/groups.h>
+
+
+//#define GROUPS_DEBUG
+
+#ifndef GROUPS_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+/* initial entries of sock::recv_gsr, doubled when full */
+#define GROUPS_INITIAL_SIZE	8
+
+/* MurmurHash3 finaliser of the network address, port excluded as per
+ * pgm_sockaddr_cmp().
+ */
+
+static
+pgm_hash_t
+groups_addr_hash (
+	const struct sockaddr*	sa
+	)
+{
+	uint32_t h = sa->sa_family;
+	if (AF_INET6 == sa->sa_family) {
+		struct sockaddr_in6 sin6;
+		uint32_t words[4];
+		memcpy (&sin6, sa, sizeof(sin6));
+		memcpy (words, &sin6.sin6_addr, sizeof(words));
+		h ^= words[0] ^ words[1] ^ words[2] ^ words[3] ^ sin6.sin6_scope_id;
+	} else if (AF_INET == sa->sa_family) {
+		struct sockaddr_in sin;
+		memcpy (&sin, sa, sizeof(sin));
+		h ^= sin.sin_addr.s_addr;
+	}
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+	return h;
+}
+
+static
+pgm_hash_t
+groups_group_hash (
+	const void*	p
+	)
+{
+	const struct pgm_group_t* group = p;
+	return groups_addr_hash ((const struct sockaddr*)&group->group);
+}
+
+static
+bool
+groups_group_equal (
+	const void* restrict	p1,
+	const void* restrict	p2
+	)
+{
+	const struct pgm_group_t* group1 = p1;
+	const struct pgm_group_t* group2 = p2;
+	return (0 == pgm_sockaddr_cmp ((const struct sockaddr*)&group1->group, (const struct sockaddr*)&group2->group));
+}
+
+static
+pgm_hash_t
+groups_gsr_hash (
+	const void*	p
+	)
+{
+	const struct group_source_req* gsr = p;
+	return groups_addr_hash ((const struct sockaddr*)&gsr->gsr_group) ^
+	       (groups_addr_hash ((const struct sockaddr*)&gsr->gsr_source) * 31) ^
+	       gsr->gsr_interface;
+}
+
+static
+bool
+groups_gsr_equal (
+	const void* restrict	p1,
+	const void* restrict	p2
+	)
+{
+	const struct group_source_req* gsr1 = p1;
+	const struct group_source_req* gsr2 = p2;
+	return (gsr1->gsr_interface == gsr2->gsr_interface &&
+		0 == pgm_sockaddr_cmp ((const struct sockaddr*)&gsr1->gsr_group,  (const struct sockaddr*)&gsr2->gsr_group) &&
+		0 == pgm_sockaddr_cmp ((const struct sockaddr*)&gsr1->gsr_source, (const struct sockaddr*)&gsr2->gsr_source));
+}
+
+/* drop entry i from both indices, caller compacts the array */
+
+static
+void
+groups_unindex (
+	pgm_sock_t* const	sock,
+	const unsigned		i
+	)
+{
+	const struct group_source_req* gsr = &sock->recv_gsr[ i ];
+	struct group_source_req* key = pgm_hashtable_lookup (sock->recv_gsr_index, gsr);
+	if (NULL != key) {
+		pgm_hashtable_remove (sock->recv_gsr_index, key);
+		pgm_free (key);
+	}
+
+	struct pgm_group_t lookup;
+	memcpy (&lookup.group, &gsr->gsr_group, sizeof(struct sockaddr_storage));
+	struct pgm_group_t* group = pgm_hashtable_lookup (sock->recv_group_index, &lookup);
+	if (NULL != group && 0 == --group->ref_count) {
+		pgm_hashtable_remove (sock->recv_group_index, group);
+		sock->recv_group_list = pgm_slist_remove (sock->recv_group_list, group);
+		pgm_free (group);
+	}
+}
+
+/* test for an existing join of the same group and source on the interface
+ * or on all interfaces.
+ */
+
+bool
+pgm_groups_is_joined (
+	const pgm_sock_t*	     const restrict sock,
+	const struct group_source_req* const restrict gsr
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != gsr);
+
+	if (NULL == sock->recv_gsr_index)
+		return FALSE;
+	if (NULL != pgm_hashtable_lookup (sock->recv_gsr_index, gsr))
+		return TRUE;
+	if (0 == gsr->gsr_interface)
+		return FALSE;
+	struct group_source_req any;
+	memcpy (&any, gsr, sizeof(any));
+	any.gsr_interface = 0;
+	return (NULL != pgm_hashtable_lookup (sock->recv_gsr_index, &any));
+}
+
+/* test whether any join names the group, independent of source and
+ * interface.
+ */
+
+bool
+pgm_groups_is_member (
+	const pgm_sock_t*      const restrict sock,
+	const struct sockaddr* const restrict group
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != group);
+
+	if (NULL == sock->recv_group_index)
+		return FALSE;
+	struct pgm_group_t lookup;
+	memset (&lookup.group, 0, sizeof(struct sockaddr_storage));
+	memcpy (&lookup.group, group, pgm_sockaddr_len (group));
+	return (NULL != pgm_hashtable_lookup (sock->recv_group_index, &lookup));
+}
+
+/* append a group/source pair, the caller has already joined it on the
+ * receive sockets.
+ */
+
+void
+pgm_groups_add (
+	pgm_sock_t*		     const restrict sock,
+	const struct group_source_req* const restrict gsr
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != gsr);
+
+	if (NULL == sock->recv_gsr_index) {
+		sock->recv_gsr_index   = pgm_hashtable_new (groups_gsr_hash, groups_gsr_equal);
+		sock->recv_group_index = pgm_hashtable_new (groups_group_hash, groups_group_equal);
+	}
+	if (sock->recv_gsr_len == sock->recv_gsr_size) {
+		sock->recv_gsr_size = sock->recv_gsr_size ? 2 * sock->recv_gsr_size : GROUPS_INITIAL_SIZE;
+		sock->recv_gsr = pgm_realloc (sock->recv_gsr, sock->recv_gsr_size * sizeof(struct group_source_req));
+	}
+	memcpy (&sock->recv_gsr[ sock->recv_gsr_len++ ], gsr, sizeof(struct group_source_req));
+
+	struct group_source_req* key = pgm_new (struct group_source_req, 1);
+	memcpy (key, gsr, sizeof(struct group_source_req));
+	pgm_hashtable_insert (sock->recv_gsr_index, key, key);
+
+	struct pgm_group_t lookup;
+	memcpy (&lookup.group, &gsr->gsr_group, sizeof(struct sockaddr_storage));
+	struct pgm_group_t* group = pgm_hashtable_lookup (sock->recv_group_index, &lookup);
+	if (NULL == group) {
+		group = pgm_new0 (struct pgm_group_t, 1);
+		memcpy (&group->group, &gsr->gsr_group, sizeof(struct sockaddr_storage));
+		pgm_hashtable_insert (sock->recv_group_index, group, group);
+		sock->recv_group_list = pgm_slist_append (sock->recv_group_list, group);
+	}
+	group->ref_count++;
+}
+
+/* remove the entry matching group, source and interface, or with is_any_source
+ * every source of the group on the interface, all interfaces for zero.
+ * remaining entries keep their join order.
+ *
+ * returns number of entries removed.
+ */
+
+unsigned
+pgm_groups_remove (
+	pgm_sock_t*		     const restrict sock,
+	const struct group_source_req* const restrict gsr,
+	const bool				    is_any_source
+	)
+{
+	unsigned count = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != gsr);
+
+	if (!is_any_source && !pgm_groups_is_joined (sock, gsr))
+		return 0;
+	for (unsigned i = 0; i < sock->recv_gsr_len; i++)
+	{
+		const struct group_source_req* entry = &sock->recv_gsr[ i ];
+		const bool is_match = is_any_source ?
+				(0 == pgm_sockaddr_cmp ((const struct sockaddr*)&gsr->gsr_group, (const struct sockaddr*)&entry->gsr_group) &&
+				 (0 == gsr->gsr_interface || gsr->gsr_interface == entry->gsr_interface)) :
+				groups_gsr_equal (gsr, entry);
+		if (is_match) {
+			groups_unindex (sock, i);
+			count++;
+		} else if (count > 0) {
+			memcpy (&sock->recv_gsr[ i - count ], entry, sizeof(struct group_source_req));
+		}
+		if (!is_any_source && count > 0 && i + 1 < sock->recv_gsr_len) {
+/* single match, shift the tail at once */
+			memmove (&sock->recv_gsr[ i ], &sock->recv_gsr[ i + 1 ], (sock->recv_gsr_len - i - 1) * sizeof(struct group_source_req));
+			break;
+		}
+	}
+	sock->recv_gsr_len -= count;
+	return count;
+}
+
+void
+pgm_groups_destroy (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	if (NULL != sock->recv_gsr_index) {
+		for (unsigned i = 0; i < sock->recv_gsr_len; i++)
+			groups_unindex (sock, i);
+		pgm_hashtable_destroy (sock->recv_gsr_index);
+		pgm_hashtable_destroy (sock->recv_group_index);
+		sock->recv_gsr_index = sock->recv_group_index = NULL;
+	}
+	pgm_slist_free (sock->recv_group_list);
+	sock->recv_group_list = NULL;
+	if (NULL != sock->recv_gsr) {
+		pgm_free (sock->recv_gsr);
+		sock->recv_gsr = NULL;
+	}
+	sock->recv_gsr_len = sock->recv_gsr_size = 0;
+}
+
+/* eof */
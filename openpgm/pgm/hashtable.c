@@ -30,6 +30,9 @@
 #define HASHTABLE_MIN_SIZE	11
 #define HASHTABLE_MAX_SIZE	13845163
 
+/* buckets migrated from the previous array per insert or remove */
+#define HASHTABLE_REHASH_STEP	8
+
 struct pgm_hashnode_t
 {
 	const void*		key;
@@ -40,25 +43,38 @@ struct pgm_hashnode_t
 
 typedef struct pgm_hashnode_t pgm_hashnode_t;
 
+/* a resize allocates the new bucket array and migrates the chains of the
+ * previous array a few buckets per insert or remove, such that no single
+ * call rehashes the whole table.  lookups search both arrays meanwhile.
+ */
+
 struct pgm_hashtable_t
 {
 	unsigned		size;
 	unsigned		nnodes;
 	pgm_hashnode_t**	nodes;
+	pgm_hashnode_t**	old_nodes;		/* pending migration, NULL when none */
+	unsigned		old_size;
+	unsigned		rehash_index;		/* next bucket of old_nodes to migrate */
 	pgm_hashfunc_t		hash_func;
 	pgm_equalfunc_t		key_equal_func;
 };
 
 #define PGM_HASHTABLE_RESIZE(hash_table) \
 	do { \
-		if ( (hash_table->size >= 3 * hash_table->nnodes && hash_table->size > HASHTABLE_MIN_SIZE) || \
-		     (3 * hash_table->size <= hash_table->nnodes && hash_table->size < HASHTABLE_MAX_SIZE) ) \
+		if (NULL != hash_table->old_nodes) \
+		{ \
+			pgm_hashtable_rehash_step (hash_table); \
+		} \
+		else if ( (hash_table->size >= 3 * hash_table->nnodes && hash_table->size > HASHTABLE_MIN_SIZE) || \
+			  (3 * hash_table->size <= hash_table->nnodes && hash_table->size < HASHTABLE_MAX_SIZE) ) \
 		{ \
 			pgm_hashtable_resize (hash_table); \
 		} \
 	} while (0)
 
 static void pgm_hashtable_resize (pgm_hashtable_t*);
+static void pgm_hashtable_rehash_step (pgm_hashtable_t*);
 static pgm_hashnode_t** pgm_hashtable_lookup_node (const pgm_hashtable_t*restrict, const void*restrict, pgm_hash_t*restrict) PGM_GNUC_PURE;
 static pgm_hashnode_t* pgm_hash_node_new (const void*restrict, void*restrict, const pgm_hash_t);
 static void pgm_hash_node_destroy (pgm_hashnode_t*);
@@ -76,7 +92,7 @@ pgm_hashtable_new (
 
 	pgm_hashtable_t *hash_table;
   
-	hash_table = pgm_new (pgm_hashtable_t, 1);
+	hash_table = pgm_new0 (pgm_hashtable_t, 1);
 	hash_table->size               = HASHTABLE_MIN_SIZE;
 	hash_table->nnodes             = 0;
 	hash_table->hash_func          = hash_func;
@@ -97,6 +113,11 @@ pgm_hashtable_unref (
 	for (unsigned i = 0; i < hash_table->size; i++)
 		pgm_hash_nodes_destroy (hash_table->nodes[i]);
 	pgm_free (hash_table->nodes);
+	if (NULL != hash_table->old_nodes) {
+		for (unsigned i = hash_table->rehash_index; i < hash_table->old_size; i++)
+			pgm_hash_nodes_destroy (hash_table->old_nodes[i]);
+		pgm_free (hash_table->old_nodes);
+	}
 	pgm_free (hash_table);
 }
 
@@ -121,11 +142,25 @@ pgm_hashtable_lookup_node (
 	)
 {
 	const pgm_hash_t hash_value = (*hash_table->hash_func) (key);
-	pgm_hashnode_t** node = &hash_table->nodes[hash_value % hash_table->size];
+	pgm_hashnode_t** node;
   
 	if (hash_return)
 		*hash_return = hash_value;
-  
+
+/* entries not yet migrated, migrated buckets are empty */
+	if (NULL != hash_table->old_nodes)
+	{
+		node = &hash_table->old_nodes[hash_value % hash_table->old_size];
+		while (*node && (((*node)->key_hash != hash_value) ||
+			!(*hash_table->key_equal_func) ((*node)->key, key)))
+		{
+			node = &(*node)->next;
+		}
+		if (*node)
+			return node;
+	}
+
+	node = &hash_table->nodes[hash_value % hash_table->size];
 	while (*node && (((*node)->key_hash != hash_value) ||
                      !(*hash_table->key_equal_func) ((*node)->key, key)))
 	{
@@ -220,10 +255,19 @@ pgm_hashtable_remove_all (
 		pgm_hash_nodes_destroy (hash_table->nodes[i]);
 		hash_table->nodes[i] = NULL;
 	}
+	if (NULL != hash_table->old_nodes) {
+		for (unsigned i = hash_table->rehash_index; i < hash_table->old_size; i++)
+			pgm_hash_nodes_destroy (hash_table->old_nodes[i]);
+		pgm_free (hash_table->old_nodes);
+		hash_table->old_nodes = NULL;
+	}
 	hash_table->nnodes = 0;
 	PGM_HASHTABLE_RESIZE (hash_table);
 }
 
+/* start migration to a bucket array sized for the current entries.
+ */
+
 static
 void
 pgm_hashtable_resize (
@@ -232,20 +276,48 @@ pgm_hashtable_resize (
 {
 	const unsigned new_size = CLAMP (pgm_spaced_primes_closest (hash_table->nnodes),
 					 HASHTABLE_MIN_SIZE, HASHTABLE_MAX_SIZE);
-	pgm_hashnode_t** new_nodes = pgm_new0 (pgm_hashnode_t*, new_size);
-  
-	for (unsigned i = 0; i < hash_table->size; i++)
-		for (pgm_hashnode_t *node = hash_table->nodes[i], *next; node; node = next)
+
+	if (new_size == hash_table->size)
+		return;
+
+	hash_table->old_nodes    = hash_table->nodes;
+	hash_table->old_size     = hash_table->size;
+	hash_table->rehash_index = 0;
+	hash_table->nodes        = pgm_new0 (pgm_hashnode_t*, new_size);
+	hash_table->size         = new_size;
+	pgm_hashtable_rehash_step (hash_table);
+}
+
+/* move the chains of the next HASHTABLE_REHASH_STEP buckets of the previous
+ * array, releasing it once empty.
+ */
+
+static
+void
+pgm_hashtable_rehash_step (
+	pgm_hashtable_t*	hash_table
+	)
+{
+	for (unsigned n = 0;
+	     n < HASHTABLE_REHASH_STEP && hash_table->rehash_index < hash_table->old_size;
+	     n++, hash_table->rehash_index++)
+	{
+		pgm_hashnode_t* node = hash_table->old_nodes[hash_table->rehash_index];
+		hash_table->old_nodes[hash_table->rehash_index] = NULL;
+		while (node)
 		{
-			next = node->next;
-			const pgm_hash_t hash_val = node->key_hash % new_size;
-			node->next = new_nodes[hash_val];
-			new_nodes[hash_val] = node;
+			pgm_hashnode_t* next = node->next;
+			const pgm_hash_t hash_val = node->key_hash % hash_table->size;
+			node->next = hash_table->nodes[hash_val];
+			hash_table->nodes[hash_val] = node;
+			node = next;
 		}
-  
-	pgm_free (hash_table->nodes);
-	hash_table->nodes = new_nodes;
-	hash_table->size = new_size;
+	}
+
+	if (hash_table->rehash_index == hash_table->old_size) {
+		pgm_free (hash_table->old_nodes);
+		hash_table->old_nodes = NULL;
+	}
 }
 
 static
@@ -0,0 +1,351 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * unit tests for the hash table.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <check.h>
+
+#ifdef _WIN32
+#	define PGM_CHECK_NOFORK		1
+#endif
+
+
+/* mock state */
+
+#define TEST_KEYS	2000
+
+static int mock_keys[ TEST_KEYS ];
+
+/* mock functions for external references */
+
+#define HASHTABLE_DEBUG
+#include "hashtable.c"
+
+PGM_GNUC_INTERNAL
+int
+pgm_get_nprocs (void)
+{
+	return 1;
+}
+
+static
+void
+mock_setup (void)
+{
+	for (unsigned i = 0; i < TEST_KEYS; i++)
+		mock_keys[ i ] = (int)i;
+}
+
+static
+void*
+make_value (
+	unsigned	i
+	)
+{
+	return (void*)(uintptr_t)(i + 1);
+}
+
+/* every key in [first, last) present with its value, every other key of
+ * mock_keys absent.
+ */
+
+static
+bool
+check_keys (
+	const pgm_hashtable_t*	hash_table,
+	const unsigned		first,
+	const unsigned		last
+	)
+{
+	for (unsigned i = 0; i < TEST_KEYS; i++) {
+		void* value = pgm_hashtable_lookup (hash_table, &mock_keys[ i ]);
+		if (i >= first && i < last) {
+			if (make_value (i) != value)
+				return FALSE;
+		} else if (NULL != value)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* target:
+ *	pgm_hashtable_t*
+ *	pgm_hashtable_new (
+ *		pgm_hashfunc_t		hash_func,
+ *		pgm_equalfunc_t		key_equal_func
+ *	)
+ */
+
+START_TEST (test_new_pass_001)
+{
+	pgm_hashtable_t* hash_table = pgm_hashtable_new (pgm_int_hash, pgm_int_equal);
+	fail_if (NULL == hash_table, "new failed");
+	fail_unless (HASHTABLE_MIN_SIZE == hash_table->size, "unexpected size");
+	fail_unless (0 == hash_table->nnodes, "not empty");
+	fail_unless (NULL == hash_table->old_nodes, "migration pending");
+	pgm_hashtable_destroy (hash_table);
+}
+END_TEST
+
+START_TEST (test_new_fail_001)
+{
+	fail_unless (NULL == pgm_hashtable_new (NULL, pgm_int_equal), "new failed");
+	fail_unless (NULL == pgm_hashtable_new (pgm_int_hash, NULL), "new failed");
+}
+END_TEST
+
+/* target:
+ *	void
+ *	pgm_hashtable_insert (
+ *		pgm_hashtable_t*	hash_table,
+ *		const void*		key,
+ *		void*			value
+ *	)
+ */
+
+/* every key is found after each insert while growth migrates the buckets */
+START_TEST (test_insert_pass_001)
+{
+	pgm_hashtable_t* hash_table = pgm_hashtable_new (pgm_int_hash, pgm_int_equal);
+	unsigned migrating = 0, resizes = 0;
+	for (unsigned i = 0; i < TEST_KEYS; i++) {
+		const unsigned size = hash_table->size;
+		pgm_hashtable_insert (hash_table, &mock_keys[ i ], make_value (i));
+		fail_unless (i + 1 == hash_table->nnodes, "unexpected node count");
+		if (size != hash_table->size)
+			resizes++;
+		if (NULL != hash_table->old_nodes) {
+			migrating++;
+			fail_unless (hash_table->rehash_index < hash_table->old_size, "migration overrun");
+		}
+		fail_unless (check_keys (hash_table, 0, i + 1), "key lost");
+	}
+	fail_unless (resizes > 2, "table did not grow");
+	fail_unless (migrating > resizes, "no migration over several steps");
+	fail_unless (hash_table->size > HASHTABLE_MIN_SIZE, "table did not grow");
+	pgm_hashtable_destroy (hash_table);
+}
+END_TEST
+
+/* duplicate key */
+START_TEST (test_insert_fail_001)
+{
+	pgm_hashtable_t* hash_table = pgm_hashtable_new (pgm_int_hash, pgm_int_equal);
+	pgm_hashtable_insert (hash_table, &mock_keys[ 0 ], make_value (0));
+	pgm_hashtable_insert (hash_table, &mock_keys[ 0 ], make_value (1));
+	fail_unless (1 == hash_table->nnodes, "duplicate inserted");
+	fail_unless (make_value (0) == pgm_hashtable_lookup (hash_table, &mock_keys[ 0 ]), "value replaced");
+	pgm_hashtable_destroy (hash_table);
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_hashtable_remove (
+ *		pgm_hashtable_t*	hash_table,
+ *		const void*		key
+ *	)
+ */
+
+/* every remaining key is found after each remove while the table shrinks */
+START_TEST (test_remove_pass_001)
+{
+	pgm_hashtable_t* hash_table = pgm_hashtable_new (pgm_int_hash, pgm_int_equal);
+	for (unsigned i = 0; i < TEST_KEYS; i++)
+		pgm_hashtable_insert (hash_table, &mock_keys[ i ], make_value (i));
+	unsigned migrating = 0, resizes = 0;
+	for (unsigned i = 0; i < TEST_KEYS; i++) {
+		const unsigned size = hash_table->size;
+		fail_unless (TRUE == pgm_hashtable_remove (hash_table, &mock_keys[ i ]), "remove failed");
+		fail_unless (TEST_KEYS - i - 1 == hash_table->nnodes, "unexpected node count");
+		if (size != hash_table->size)
+			resizes++;
+		if (NULL != hash_table->old_nodes)
+			migrating++;
+		fail_unless (check_keys (hash_table, i + 1, TEST_KEYS), "key lost");
+	}
+	fail_unless (resizes > 2, "table did not shrink");
+	fail_unless (migrating > resizes, "no migration over several steps");
+	fail_unless (HASHTABLE_MIN_SIZE == hash_table->size, "table not shrunk to minimum");
+	fail_unless (FALSE == pgm_hashtable_remove (hash_table, &mock_keys[ 0 ]), "remove on empty table");
+	pgm_hashtable_destroy (hash_table);
+}
+END_TEST
+
+/* inserts and removes in between the steps of one migration, keys on either
+ * side of the migrated buckets.
+ */
+START_TEST (test_remove_pass_002)
+{
+	pgm_hashtable_t* hash_table = pgm_hashtable_new (pgm_int_hash, pgm_int_equal);
+	unsigned last = 0;
+	while (NULL == hash_table->old_nodes || hash_table->old_size < 4 * HASHTABLE_REHASH_STEP) {
+		pgm_hashtable_insert (hash_table, &mock_keys[ last ], make_value (last));
+		last++;
+	}
+	const pgm_hashnode_t* const* old_nodes = (const pgm_hashnode_t* const*)hash_table->old_nodes;
+	const unsigned old_size = hash_table->old_size;
+	fail_unless (hash_table->rehash_index < old_size, "migration complete");
+	fail_unless (check_keys (hash_table, 0, last), "key lost");
+/* key of a bucket not yet migrated */
+	unsigned pending = old_size - 1;
+	fail_unless (NULL != old_nodes[ pending ], "pending bucket empty");
+	const int pending_key = *(const int*)old_nodes[ pending ]->key;
+	fail_unless (TRUE == pgm_hashtable_remove (hash_table, &mock_keys[ pending_key ]), "remove pending failed");
+	fail_unless (NULL == pgm_hashtable_lookup (hash_table, &mock_keys[ pending_key ]), "pending key found");
+/* key of a migrated bucket */
+	fail_unless (NULL == old_nodes[ 0 ], "migrated bucket not empty");
+	fail_unless (TRUE == pgm_hashtable_remove (hash_table, &mock_keys[ 0 ]), "remove migrated failed");
+	fail_unless (NULL == pgm_hashtable_lookup (hash_table, &mock_keys[ 0 ]), "migrated key found");
+	fail_unless (NULL != hash_table->old_nodes, "migration complete");
+/* insert mid-migration lands in the new array */
+	pgm_hashtable_insert (hash_table, &mock_keys[ last ], make_value (last));
+	fail_unless (make_value (last) == pgm_hashtable_lookup (hash_table, &mock_keys[ last ]), "inserted key not found");
+	last++;
+	while (NULL != hash_table->old_nodes) {
+		pgm_hashtable_insert (hash_table, &mock_keys[ last ], make_value (last));
+		last++;
+	}
+	for (unsigned i = 1; i < last; i++) {
+		void* value = pgm_hashtable_lookup (hash_table, &mock_keys[ i ]);
+		if ((int)i == pending_key)
+			fail_unless (NULL == value, "pending key found");
+		else
+			fail_unless (make_value (i) == value, "key lost");
+	}
+	fail_unless (last - 2 == hash_table->nnodes, "unexpected node count");
+	pgm_hashtable_destroy (hash_table);
+}
+END_TEST
+
+/* target:
+ *	void
+ *	pgm_hashtable_remove_all (
+ *		pgm_hashtable_t*	hash_table
+ *	)
+ */
+
+/* mid-migration */
+START_TEST (test_remove_all_pass_001)
+{
+	pgm_hashtable_t* hash_table = pgm_hashtable_new (pgm_int_hash, pgm_int_equal);
+	unsigned last = 0;
+	while (NULL == hash_table->old_nodes || hash_table->old_size < 4 * HASHTABLE_REHASH_STEP) {
+		pgm_hashtable_insert (hash_table, &mock_keys[ last ], make_value (last));
+		last++;
+	}
+	pgm_hashtable_remove_all (hash_table);
+	fail_unless (0 == hash_table->nnodes, "not empty");
+	fail_unless (check_keys (hash_table, 0, 0), "key found");
+	for (unsigned i = 0; i < last; i++)
+		pgm_hashtable_insert (hash_table, &mock_keys[ i ], make_value (i));
+	fail_unless (check_keys (hash_table, 0, last), "key lost");
+	pgm_hashtable_destroy (hash_table);
+}
+END_TEST
+
+/* target:
+ *	void*
+ *	pgm_hashtable_lookup_extended (
+ *		const pgm_hashtable_t*	hash_table,
+ *		const void*		key,
+ *		void*			hash_return
+ *	)
+ */
+
+START_TEST (test_lookup_extended_pass_001)
+{
+	pgm_hashtable_t* hash_table = pgm_hashtable_new (pgm_int_hash, pgm_int_equal);
+	pgm_hash_t hash = 0;
+	pgm_hashtable_insert (hash_table, &mock_keys[ 42 ], make_value (42));
+	fail_unless (make_value (42) == pgm_hashtable_lookup_extended (hash_table, &mock_keys[ 42 ], &hash), "lookup failed");
+	fail_unless (pgm_int_hash (&mock_keys[ 42 ]) == hash, "unexpected hash");
+	fail_unless (NULL == pgm_hashtable_lookup_extended (hash_table, &mock_keys[ 43 ], &hash), "lookup failed");
+	fail_unless (pgm_int_hash (&mock_keys[ 43 ]) == hash, "unexpected hash");
+	pgm_hashtable_destroy (hash_table);
+}
+END_TEST
+
+
+static
+Suite*
+make_test_suite (void)
+{
+	Suite* s;
+
+	s = suite_create (__FILE__);
+
+	TCase* tc_new = tcase_create ("new");
+	suite_add_tcase (s, tc_new);
+	tcase_add_checked_fixture (tc_new, mock_setup, NULL);
+	tcase_add_test (tc_new, test_new_pass_001);
+	tcase_add_test (tc_new, test_new_fail_001);
+
+	TCase* tc_insert = tcase_create ("insert");
+	suite_add_tcase (s, tc_insert);
+	tcase_add_checked_fixture (tc_insert, mock_setup, NULL);
+	tcase_add_test (tc_insert, test_insert_pass_001);
+	tcase_add_test (tc_insert, test_insert_fail_001);
+
+	TCase* tc_remove = tcase_create ("remove");
+	suite_add_tcase (s, tc_remove);
+	tcase_add_checked_fixture (tc_remove, mock_setup, NULL);
+	tcase_add_test (tc_remove, test_remove_pass_001);
+	tcase_add_test (tc_remove, test_remove_pass_002);
+
+	TCase* tc_remove_all = tcase_create ("remove-all");
+	suite_add_tcase (s, tc_remove_all);
+	tcase_add_checked_fixture (tc_remove_all, mock_setup, NULL);
+	tcase_add_test (tc_remove_all, test_remove_all_pass_001);
+
+	TCase* tc_lookup_extended = tcase_create ("lookup-extended");
+	suite_add_tcase (s, tc_lookup_extended);
+	tcase_add_checked_fixture (tc_lookup_extended, mock_setup, NULL);
+	tcase_add_test (tc_lookup_extended, test_lookup_extended_pass_001);
+	return s;
+}
+
+static
+Suite*
+make_master_suite (void)
+{
+	Suite* s = suite_create ("Master");
+	return s;
+}
+
+int
+main (void)
+{
+	pgm_messages_init();
+	SRunner* sr = srunner_create (make_master_suite ());
+	srunner_add_suite (sr, make_test_suite ());
+	srunner_run_all (sr, CK_ENV);
+	int number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	pgm_messages_shutdown();
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* eof */
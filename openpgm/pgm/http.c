@@ -26,6 +26,13 @@
 #include <inttypes.h>
 #ifndef _WIN32
 #	include <netdb.h>
+#	include <unistd.h>
+#	ifdef HAVE_EPOLL_CTL
+#		include <sys/epoll.h>
+#	elif defined(HAVE_KQUEUE)
+#		include <sys/types.h>
+#		include <sys/event.h>
+#	endif
 #else
 #	include <io.h>
 #	include <lmcons.h>
@@ -33,10 +40,17 @@
 #endif
 #include <stdio.h>
 #include <time.h>
+#ifdef HAVE_ZLIB_H
+#	include <zlib.h>
+#endif
 #include <impl/i18n.h>
 #include <impl/framework.h>
 #include <impl/receiver.h>
 #include <impl/socket.h>
+#include <impl/sock_registry.h>
+#include <impl/shard.h>
+#include <impl/stats.h>
+#include <impl/flightrec.h>
 #include <pgm/if.h>
 #include <pgm/version.h>
 
@@ -61,6 +75,7 @@
 #	define read		_read
 #	define write		_write
 #	define SHUT_WR		SD_SEND
+#	define strncasecmp	_strnicmp
 #endif
 
 #ifdef HAVE_SPRINTF_GROUPING
@@ -72,6 +87,24 @@
 #define HTTP_BACKLOG			10 /* connections */
 #define HTTP_TIMEOUT			60 /* seconds */
 
+/* readiness notification, select() where neither epoll nor kqueue exist */
+#if defined(HAVE_EPOLL_CTL)
+#	define HTTP_USE_EPOLL
+#elif defined(HAVE_KQUEUE)
+#	define HTTP_USE_KQUEUE
+#else
+#	define HTTP_USE_SELECT
+#endif
+#define HTTP_MAX_EVENTS			(HTTP_BACKLOG + 2)
+
+/* rendered pages are served again until stale such that polling dashboards
+ * neither walk sockets nor take locks more than once an interval.
+ */
+#define HTTP_CACHE_IVL			pgm_secs(1)
+#define HTTP_CACHE_MAX			16 /* pages */
+#define HTTP_ETAG_LEN			(2 + 16 + 1) /* quoted 64-bit hash */
+#define HTTP_GZIP_MIN			1024 /* bytes, shorter content sent as is */
+
 
 /* locals */
 
@@ -90,6 +123,25 @@ struct http_connection_t {
 	unsigned	status_code;
 	const char*	status_text;
 	const char*	content_type;
+	char*		content;	/* body from a page callback */
+	size_t		content_length;
+	bool		is_static;
+};
+
+/* one rendered response body, with its compressed form made on first request */
+struct http_page_t {
+	char*		path;		/* NULL for an unused entry */
+	pgm_time_t	expiry;
+	unsigned	status_code;
+	const char*	status_text;
+	const char*	content_type;
+	bool		is_static;
+	char*		content;
+	size_t		content_length;
+	char		etag[ HTTP_ETAG_LEN ];
+	bool		has_gzip;	/* compression attempted */
+	char*		gzip;		/* NULL unless smaller */
+	size_t		gzip_length;
 };
 
 enum {
@@ -110,16 +162,29 @@ static void*			http_routine (void*);
 static HANDLE			http_thread;
 static unsigned __stdcall	http_routine (void*);
 #endif
+#ifdef HTTP_USE_SELECT
 static SOCKET			http_max_sock = INVALID_SOCKET;
 static fd_set			http_readfds, http_writefds, http_exceptfds;
+#else
+static int			http_event_fd = -1;	/* epoll or kqueue instance */
+#endif
 static pgm_list_t*		http_socks = NULL;
 static pgm_notify_t		http_notify = PGM_NOTIFY_INIT;
 static volatile uint32_t	http_ref_count = 0;
+static struct http_page_t	http_cache[ HTTP_CACHE_MAX ];	/* http thread only */
 
 
+static int http_watch (SOCKET, void*, const bool, const bool);
+static void http_unwatch (SOCKET, const bool);
+static struct http_page_t* http_cache_lookup (const char*, const pgm_time_t);
+static struct http_page_t* http_cache_insert (struct http_connection_t*restrict, const char*restrict, const pgm_time_t, struct http_page_t*restrict);
+static void http_page_free (struct http_page_t*);
+static void http_respond (struct http_connection_t*restrict, struct http_page_t*restrict, const char*restrict);
 static int http_tsi_response (struct http_connection_t*restrict, const pgm_tsi_t*restrict);
 static void http_each_receiver (const pgm_sock_t*restrict, const pgm_peer_t*restrict, pgm_string_t*restrict);
 static int http_receiver_response (struct http_connection_t*restrict, const pgm_sock_t*restrict, const pgm_peer_t*restrict);
+static void http_latency_table (pgm_string_t*restrict, const char*restrict, const uint32_t*restrict);
+static void http_rates_table (pgm_string_t*restrict, const struct pgm_stats_ring_t*restrict);
 
 static void default_callback (struct http_connection_t*restrict, const char*restrict);
 static void robots_callback (struct http_connection_t*restrict, const char*restrict);
@@ -128,6 +193,8 @@ static void index_callback (struct http_connection_t*restrict, const char*restri
 static void interfaces_callback (struct http_connection_t*restrict, const char*restrict);
 static void transports_callback (struct http_connection_t*restrict, const char*restrict);
 static void histograms_callback (struct http_connection_t*restrict, const char*restrict);
+static void metrics_callback (struct http_connection_t*restrict, const char*restrict);
+static void stats_json_callback (struct http_connection_t*restrict, const char*restrict);
 
 static struct {
 	const char*	path;
@@ -137,10 +204,38 @@ static struct {
 	{ "/base.css",		css_callback },
 	{ "/",			index_callback },
 	{ "/interfaces",	interfaces_callback },
-	{ "/transports",	transports_callback }
-#ifdef USE_HISTOGRAMS
-       ,{ "/histograms",	histograms_callback }
-#endif
+	{ "/transports",	transports_callback },
+	{ "/histograms",	histograms_callback },
+	{ "/metrics",		metrics_callback },
+	{ "/stats.json",	stats_json_callback }
+};
+
+static const char* http_latency_stages[PGM_LATENCY_STAGE_MAX] = {
+	[PGM_LATENCY_RX_INSERT]		= "rx_insert",
+	[PGM_LATENCY_RX_DELIVER]	= "rx_deliver",
+	[PGM_LATENCY_NAK_RDATA]		= "nak_rdata",
+	[PGM_LATENCY_TX_WIRE]		= "tx_wire"
+};
+
+/* counters of one socket and its peers copied for export outside of any lock.
+ */
+struct http_peer_snapshot_t {
+	char		tsi[PGM_TSISTRLEN];
+	uint64_t	stats[PGM_PC_RECEIVER_MAX];
+	uint32_t	rxw_length;
+	uint32_t	rxw_max_length;
+	size_t		rxw_size;
+};
+
+struct http_sock_snapshot_t {
+	char				tsi[PGM_TSISTRLEN];
+	bool				is_source;
+	uint64_t			stats[PGM_PC_SOURCE_MAX];
+	uint32_t			txw_length;
+	size_t				txw_max_length;
+	size_t				txw_size;
+	unsigned			peer_count;
+	struct http_peer_snapshot_t*	peers;
 };
 
 
@@ -341,6 +436,28 @@ pgm_http_init (
 		goto err_cleanup;
 	}
 
+#ifndef HTTP_USE_SELECT
+/* persistent readiness instance for the listening socket and notification */
+#	ifdef HTTP_USE_EPOLL
+	http_event_fd = epoll_create1 (EPOLL_CLOEXEC);
+#	else
+	http_event_fd = kqueue ();
+#	endif
+	if (-1 == http_event_fd ||
+	    0 != http_watch (pgm_notify_get_socket (&http_notify), &http_notify, FALSE, TRUE) ||
+	    0 != http_watch (http_sock, &http_sock, FALSE, TRUE))
+	{
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			     PGM_ERROR_DOMAIN_HTTP,
+			     pgm_error_from_errno (save_errno),
+			     _("Creating HTTP event instance: %s"),
+			     pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		goto err_cleanup;
+	}
+#endif
+
 /* spawn thread to handle HTTP requests */
 #ifndef _WIN32
 	const int status = pthread_create (&http_thread, NULL, &http_routine, NULL);
@@ -373,6 +490,12 @@ pgm_http_init (
 	return TRUE;
 
 err_cleanup:
+#ifndef HTTP_USE_SELECT
+	if (-1 != http_event_fd) {
+		close (http_event_fd);
+		http_event_fd = -1;
+	}
+#endif
 	if (INVALID_SOCKET != http_sock) {
 		closesocket (http_sock);
 		http_sock = INVALID_SOCKET;
@@ -401,15 +524,86 @@ pgm_http_shutdown (void)
 #else
 	WaitForSingleObject (http_thread, INFINITE);
 	CloseHandle (http_thread);
+#endif
+#ifndef HTTP_USE_SELECT
+	close (http_event_fd);
+	http_event_fd = -1;
 #endif
 	if (INVALID_SOCKET != http_sock) {
 		closesocket (http_sock);
 		http_sock = INVALID_SOCKET;
 	}
+	for (unsigned i = 0; i < HTTP_CACHE_MAX; i++)
+		http_page_free (&http_cache[ i ]);
 	pgm_notify_destroy (&http_notify);
 	return TRUE;
 }
 
+/* register interest in a descriptor becoming readable or writable, data
+ * is returned with readiness of the descriptor by the event instance.
+ * Error conditions are always reported.
+ *
+ * returns 0 on success, -1 on error.
+ */
+
+static
+int
+http_watch (
+	SOCKET			fd,
+	void*			data,
+	const bool		is_write,
+	const bool		is_new
+	)
+{
+#if defined(HTTP_USE_EPOLL)
+	struct epoll_event event;
+	event.events	= is_write ? EPOLLOUT : EPOLLIN;
+	event.data.ptr	= data;
+	return epoll_ctl (http_event_fd, is_new ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event);
+#elif defined(HTTP_USE_KQUEUE)
+	struct kevent changes[2];
+	int nchanges = 0;
+	if (!is_new)
+		EV_SET(&changes[nchanges++], fd, is_write ? EVFILT_READ : EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
+	EV_SET(&changes[nchanges++], fd, is_write ? EVFILT_WRITE : EVFILT_READ, EV_ADD, 0, 0, data);
+	return kevent (http_event_fd, changes, nchanges, NULL, 0, NULL);
+#else
+	(void)data;
+	if (!is_new)
+		FD_CLR( fd, is_write ? &http_readfds : &http_writefds );
+	else
+		FD_SET( fd, &http_exceptfds );
+	FD_SET( fd, is_write ? &http_writefds : &http_readfds );
+	if (is_new && fd > http_max_sock)
+		http_max_sock = fd;
+	return 0;
+#endif
+}
+
+/* remove a descriptor from the event instance before closing.
+ */
+
+static
+void
+http_unwatch (
+	SOCKET			fd,
+	const bool		is_write
+	)
+{
+#if defined(HTTP_USE_EPOLL)
+	struct epoll_event event;
+	memset (&event, 0, sizeof(event));
+	epoll_ctl (http_event_fd, EPOLL_CTL_DEL, fd, &event);
+#elif defined(HTTP_USE_KQUEUE)
+	struct kevent change;
+	EV_SET(&change, fd, is_write ? EVFILT_WRITE : EVFILT_READ, EV_DELETE, 0, 0, NULL);
+	kevent (http_event_fd, &change, 1, NULL, 0, NULL);
+#else
+	FD_CLR( fd, is_write ? &http_writefds : &http_readfds );
+	FD_CLR( fd, &http_exceptfds );
+#endif
+}
+
 /* accept a new incoming HTTP connection.
  */
 
@@ -433,7 +627,7 @@ http_accept (
 		return;
 	}
 
-#ifndef _WIN32
+#if !defined(_WIN32) && defined(HTTP_USE_SELECT)
 /* out of bounds file descriptor for select() */
 	if (new_sock >= FD_SETSIZE) {
 		closesocket (new_sock);
@@ -447,11 +641,16 @@ http_accept (
 	struct http_connection_t* connection = pgm_new0 (struct http_connection_t, 1);
 	connection->sock = new_sock;
 	connection->state = HTTP_STATE_READ;
+	if (0 != http_watch (new_sock, connection, FALSE, TRUE)) {
+		const int save_errno = pgm_get_last_sock_error();
+		char errbuf[1024];
+		pgm_warn (_("HTTP client watch: %s"),
+			pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		closesocket (new_sock);
+		pgm_free (connection);
+		return;
+	}
 	http_socks = pgm_list_prepend_link (http_socks, &connection->link_);
-	FD_SET( new_sock, &http_readfds );
-	FD_SET( new_sock, &http_exceptfds );
-	if (new_sock > http_max_sock)
-		http_max_sock = new_sock;
 }
 
 static
@@ -460,28 +659,21 @@ http_close (
 	struct http_connection_t*	connection
 	)
 {
+	http_unwatch (connection->sock, HTTP_STATE_WRITE == connection->state);
 	if (SOCKET_ERROR == closesocket (connection->sock)) {
 		const int save_errno = pgm_get_last_sock_error();
 		char errbuf[1024];
 		pgm_warn (_("Close HTTP client socket: %s"),
 			pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
 	}
-	switch (connection->state) {
-	case HTTP_STATE_READ:
-	case HTTP_STATE_FINWAIT:
-		FD_CLR( connection->sock, &http_readfds );
-		break;
-	case HTTP_STATE_WRITE:
-		FD_CLR( connection->sock, &http_writefds );
-		break;
-	}
-	FD_CLR( connection->sock, &http_exceptfds );
 	http_socks = pgm_list_remove_link (http_socks, &connection->link_);
 	if (connection->buflen > 0) {
 		pgm_free (connection->buf);
 		connection->buf = NULL;
 		connection->buflen = 0;
 	}
+	pgm_free (connection->content);
+#ifdef HTTP_USE_SELECT
 /* find new highest fd */
 	if (connection->sock == http_max_sock)
 	{
@@ -493,6 +685,7 @@ http_close (
 				http_max_sock = c->sock;
 		}
 	}
+#endif
 	pgm_free (connection);
 }
 
@@ -539,6 +732,9 @@ http_read (
 	}
 
 	char* request_uri = connection->buf + strlen("GET ");
+	const char* headers = strstr (request_uri, "\r\n");
+	if (NULL != headers)
+		headers += 2;
 	char* p = request_uri;
 	do {
 		if (*p == '?' || *p == ' ') {
@@ -547,24 +743,37 @@ http_read (
 		}
 	} while (*(++p));
 
+/* render only pages gone stale */
+	struct http_page_t uncached, *page;
+	const pgm_time_t now = pgm_time_update_now();
+	memset (&uncached, 0, sizeof(uncached));
+	page = http_cache_lookup (request_uri, now);
+	if (NULL != page)
+		goto complete;
+
 	connection->status_code	 = 200;	/* OK */
 	connection->status_text  = "OK";
 	connection->content_type = "text/html";
-	connection->bufoff       = 0;
 	for (unsigned i = 0; i < PGM_N_ELEMENTS(http_directory); i++)
 	{
 		if (0 == strcmp (request_uri, http_directory[i].path))
 		{
 			http_directory[i].callback (connection, request_uri);
-			goto complete;
+			goto render;
 		}
 	}
 	default_callback (connection, request_uri);
 
+render:
+	page = http_cache_insert (connection, request_uri, now, &uncached);
+
 complete:
+	http_respond (connection, page, headers);
+	if (page == &uncached)
+		http_page_free (&uncached);
+	connection->bufoff = 0;
 	connection->state = HTTP_STATE_WRITE;
-	FD_CLR( connection->sock, &http_readfds );
-	FD_SET( connection->sock, &http_writefds );
+	http_watch (connection->sock, connection, TRUE, FALSE);
 }
 
 /* non-blocking write a HTTP response
@@ -596,8 +805,7 @@ http_write (
 	} else {
 		pgm_debug ("HTTP socket entering finwait state.");
 		connection->state = HTTP_STATE_FINWAIT;
-		FD_CLR( connection->sock, &http_writefds );
-		FD_SET( connection->sock, &http_readfds );
+		http_watch (connection->sock, connection, FALSE, FALSE);
 	}
 }
 
@@ -655,7 +863,9 @@ http_set_content_type (
 	connection->content_type = content_type;
 }
 
-/* finalise response buffer with headers and content */
+/* hold the content of the response, headers are added with the page cache in
+ * http_respond().
+ */
 
 static
 void
@@ -665,25 +875,11 @@ http_set_static_response (
 	size_t				  content_length
 	)
 {
-	pgm_string_t* response = pgm_string_new (NULL);
-	pgm_string_printf (response, "HTTP/1.0 %d %s\r\n"
-				     "Server: OpenPGM HTTP Server %u.%u.%u\r\n"
-			   	     "Last-Modified: Fri, 1 Jan 2010, 00:00:01 GMT\r\n"
-				     "Content-Length: %" PRIzd "\r\n"
-				     "Content-Type: %s\r\n"
-				     "Connection: close\r\n"
-				     "\r\n",
-			   connection->status_code,
-			   connection->status_text,
-			   pgm_major_version, pgm_minor_version, pgm_micro_version,
-			   content_length,
-			   connection->content_type
-			);
-	pgm_string_append (response, content);
-	if (connection->buflen)
-		pgm_free (connection->buf);
-	connection->buflen = response->len;
-	connection->buf = pgm_string_free (response, FALSE);
+	pgm_free (connection->content);
+	connection->content = pgm_malloc (content_length);
+	memcpy (connection->content, content, content_length);
+	connection->content_length = content_length;
+	connection->is_static = TRUE;
 }
 
 static
@@ -694,25 +890,239 @@ http_set_response (
 	size_t				  content_length
 	)
 {
+	pgm_free (connection->content);
+	connection->content = content;
+	connection->content_length = content_length;
+	connection->is_static = FALSE;
+}
+
+/* 64-bit FNV-1a of the content as a quoted entity tag.
+ */
+
+static
+void
+http_etag (
+	const char*	restrict content,
+	const size_t		 content_length,
+	char*		restrict etag
+	)
+{
+	uint64_t hash = UINT64_C(0xcbf29ce484222325);
+	for (size_t i = 0; i < content_length; i++) {
+		hash ^= (uint8_t)content[ i ];
+		hash *= UINT64_C(0x100000001b3);
+	}
+	snprintf (etag, HTTP_ETAG_LEN, "\"%016" PRIx64 "\"", hash);
+}
+
+/* compress the content of page once with the gzip encoding, kept only when
+ * smaller.
+ */
+
+static
+void
+http_page_gzip (
+	struct http_page_t*	page
+	)
+{
+	page->has_gzip = TRUE;
+#ifdef HAVE_ZLIB_H
+	if (page->content_length < HTTP_GZIP_MIN)
+		return;
+	z_stream zs;
+	memset (&zs, 0, sizeof(zs));
+/* window bits plus 16 for the gzip header and trailer */
+	if (Z_OK != deflateInit2 (&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY))
+		return;
+	const size_t bound = deflateBound (&zs, (uLong)page->content_length);
+	char* gzip = pgm_malloc (bound);
+	zs.next_in	= (Bytef*)page->content;
+	zs.avail_in	= (uInt)page->content_length;
+	zs.next_out	= (Bytef*)gzip;
+	zs.avail_out	= (uInt)bound;
+	if (Z_STREAM_END == deflate (&zs, Z_FINISH) && zs.total_out < page->content_length) {
+		page->gzip	  = gzip;
+		page->gzip_length = zs.total_out;
+	} else
+		pgm_free (gzip);
+	deflateEnd (&zs);
+#endif
+}
+
+static
+void
+http_page_free (
+	struct http_page_t*	page
+	)
+{
+	pgm_free (page->path);
+	pgm_free (page->content);
+	pgm_free (page->gzip);
+	memset (page, 0, sizeof(struct http_page_t));
+}
+
+/* returns the cached page of path rendered within the cache interval, or NULL.
+ */
+
+static
+struct http_page_t*
+http_cache_lookup (
+	const char*		path,
+	const pgm_time_t	now
+	)
+{
+	for (unsigned i = 0; i < HTTP_CACHE_MAX; i++)
+	{
+		struct http_page_t* page = &http_cache[ i ];
+		if (NULL != page->path &&
+		    0 == strcmp (page->path, path) &&
+		    pgm_time_after (page->expiry, now))
+			return page;
+	}
+	return NULL;
+}
+
+/* move the content of connection into page, cached under path for successful
+ * responses replacing the same path, a free entry, or the stalest.
+ */
+
+static
+struct http_page_t*
+http_cache_insert (
+	struct http_connection_t*restrict connection,
+	const char*		 restrict path,
+	const pgm_time_t		  now,
+	struct http_page_t*	 restrict uncached
+	)
+{
+	struct http_page_t* page = uncached;
+
+	if (200 == connection->status_code)
+	{
+		page = &http_cache[ 0 ];
+		for (unsigned i = 0; i < HTTP_CACHE_MAX; i++)
+		{
+			struct http_page_t* candidate = &http_cache[ i ];
+			if (NULL == candidate->path || 0 == strcmp (candidate->path, path)) {
+				page = candidate;
+				break;
+			}
+			if (pgm_time_after (page->expiry, candidate->expiry))
+				page = candidate;
+		}
+		http_page_free (page);
+		page->path	= pgm_strdup (path);
+		page->expiry	= now + HTTP_CACHE_IVL;
+	}
+	page->status_code	= connection->status_code;
+	page->status_text	= connection->status_text;
+	page->content_type	= connection->content_type;
+	page->is_static		= connection->is_static;
+	page->content		= connection->content;
+	page->content_length	= connection->content_length;
+	connection->content	= NULL;
+	connection->content_length = 0;
+	http_etag (page->content, page->content_length, page->etag);
+	return page;
+}
+
+/* returns the value of the named request header, terminated by CR, or NULL.
+ */
+
+static
+const char*
+http_header_value (
+	const char*	restrict headers,
+	const char*	restrict name
+	)
+{
+	const size_t name_len = strlen (name);
+	for (const char* line = headers; NULL != line && '\r' != *line; )
+	{
+		if (0 == strncasecmp (line, name, name_len) && ':' == line[ name_len ]) {
+			const char* value = line + name_len + 1;
+			while (' ' == *value || '\t' == *value)
+				value++;
+			return value;
+		}
+		line = strstr (line, "\r\n");
+		if (NULL != line)
+			line += 2;
+	}
+	return NULL;
+}
+
+/* returns TRUE if the header value, up to CR, contains token.
+ */
+
+static
+bool
+http_header_contains (
+	const char*	restrict value,
+	const char*	restrict token
+	)
+{
+	if (NULL == value)
+		return FALSE;
+	const char* end = strchr (value, '\r');
+	const char* match = strstr (value, token);
+	return NULL != match && (NULL == end || match < end);
+}
+
+/* finalise response buffer with headers and content of page, only headers if
+ * the client holds the same entity.
+ */
+
+static
+void
+http_respond (
+	struct http_connection_t*restrict connection,
+	struct http_page_t*	 restrict page,
+	const char*		 restrict headers
+	)
+{
+	const char* if_none_match = http_header_value (headers, "If-None-Match");
+	const bool is_not_modified = 200 == page->status_code &&
+				     (http_header_contains (if_none_match, page->etag) ||
+				      http_header_contains (if_none_match, "*"));
+	bool is_gzip = FALSE;
+
+	if (!is_not_modified && http_header_contains (http_header_value (headers, "Accept-Encoding"), "gzip")) {
+		if (!page->has_gzip)
+			http_page_gzip (page);
+		is_gzip = (NULL != page->gzip);
+	}
+	const char* content = is_gzip ? page->gzip : page->content;
+	const size_t content_length = is_not_modified ? 0 : (is_gzip ? page->gzip_length : page->content_length);
+
 	pgm_string_t* response = pgm_string_new (NULL);
 	pgm_string_printf (response, "HTTP/1.0 %d %s\r\n"
-				     "Server: OpenPGM HTTP Server %u.%u.%u\r\n"
-				     "Content-Length: %" PRIzd "\r\n"
-				     "Content-Type: %s\r\n"
-				     "Connection: close\r\n"
-				     "\r\n",
-			   connection->status_code,
-			   connection->status_text,
-			   pgm_major_version, pgm_minor_version, pgm_micro_version,
-			   content_length,
-			   connection->content_type
-			);
-	pgm_string_append (response, content);
-	pgm_free (content);
+				     "Server: OpenPGM HTTP Server %u.%u.%u\r\n",
+			   is_not_modified ? 304 : page->status_code,
+			   is_not_modified ? "Not Modified" : page->status_text,
+			   pgm_major_version, pgm_minor_version, pgm_micro_version);
+	if (page->is_static)
+		pgm_string_append (response, "Last-Modified: Fri, 1 Jan 2010, 00:00:01 GMT\r\n");
+	pgm_string_append_printf (response, "ETag: %s\r\n"
+					    "Cache-Control: no-cache\r\n"
+					    "Vary: Accept-Encoding\r\n"
+					    "%s"
+					    "Content-Length: %" PRIzd "\r\n"
+					    "Content-Type: %s\r\n"
+					    "Connection: close\r\n"
+					    "\r\n",
+				  page->etag,
+				  is_gzip ? "Content-Encoding: gzip\r\n" : "",
+				  content_length,
+				  page->content_type);
 	if (connection->buflen)
 		pgm_free (connection->buf);
-	connection->buflen = response->len;
+	connection->buflen = response->len + content_length;
 	connection->buf = pgm_string_free (response, FALSE);
+	if (content_length > 0) {
+		connection->buf = pgm_realloc (connection->buf, connection->buflen);
+		memcpy (connection->buf + connection->buflen - content_length, content, content_length);
+	}
 }
 
 /* Thread routine for processing HTTP requests
@@ -729,6 +1139,40 @@ http_routine (
 	PGM_GNUC_UNUSED	void*	arg
 	)
 {
+	pgm_thread_setup ("http");
+#ifndef HTTP_USE_SELECT
+	for (;;)
+	{
+#	ifdef HTTP_USE_EPOLL
+		struct epoll_event events[ HTTP_MAX_EVENTS ];
+		const int ready = epoll_wait (http_event_fd, events, PGM_N_ELEMENTS(events), -1);
+#	else
+		struct kevent events[ HTTP_MAX_EVENTS ];
+		const int ready = kevent (http_event_fd, NULL, 0, events, PGM_N_ELEMENTS(events), NULL);
+#	endif
+/* signal interrupt */
+		if (PGM_UNLIKELY(-1 == ready))
+			continue;
+		for (int i = 0; i < ready; i++)
+		{
+#	ifdef HTTP_USE_EPOLL
+			void* data = events[i].data.ptr;
+#	else
+			void* data = events[i].udata;
+#	endif
+/* terminate */
+			if (PGM_UNLIKELY(&http_notify == data))
+				goto out;
+/* new connection */
+			if (&http_sock == data)
+				http_accept (http_sock);
+/* existing connection, one registration per descriptor */
+			else
+				http_process (data);
+		}
+	}
+out:
+#else /* HTTP_USE_SELECT */
 	const SOCKET notify_fd = pgm_notify_get_socket (&http_notify);
 	const int max_fd = MAX( notify_fd, http_sock );
 
@@ -768,6 +1212,7 @@ http_routine (
 			}
 		}
 	}
+#endif /* HTTP_USE_SELECT */
 
 /* cleanup */
 #ifndef _WIN32
@@ -830,9 +1275,7 @@ http_create_response (
 						"<a href=\"/\"><span class=\"tab\" id=\"tab%s\">General Information</span></a>"
 						"<a href=\"/interfaces\"><span class=\"tab\" id=\"tab%s\">Interfaces</span></a>"
 						"<a href=\"/transports\"><span class=\"tab\" id=\"tab%s\">Transports</span></a>"
-#ifdef USE_HISTOGRAMS
 						"<a href=\"/histograms\"><span class=\"tab\" id=\"tab%s\">Histograms</span></a>"
-#endif
 						"<div id=\"tabline\"></div>"
 					"</div>"
 					"<div id=\"content\">",
@@ -843,11 +1286,8 @@ http_create_response (
 				timestamp,
 				tab == HTTP_TAB_GENERAL_INFORMATION ? "top" : "bottom",
 				tab == HTTP_TAB_INTERFACES ? "top" : "bottom",
-				tab == HTTP_TAB_TRANSPORTS ? "top" : "bottom"
-#ifdef USE_HISTOGRAMS
-			       ,tab == HTTP_TAB_HISTOGRAMS ? "top" : "bottom"
-#endif
-	);
+				tab == HTTP_TAB_TRANSPORTS ? "top" : "bottom",
+				tab == HTTP_TAB_HISTOGRAMS ? "top" : "bottom");
 
 	return response;
 }
@@ -903,9 +1343,9 @@ index_callback (
 		default_callback (connection, path);
 		return;
 	}
-	pgm_rwlock_reader_lock (&pgm_sock_list_lock);
-	const unsigned transport_count = pgm_slist_length (pgm_sock_list);
-	pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
+	unsigned epoch;
+	const unsigned transport_count = pgm_sock_registry_enter (&epoch)->len;
+	pgm_sock_registry_leave (epoch);
 
 	pgm_string_t* response = http_create_response ("OpenPGM", HTTP_TAB_GENERAL_INFORMATION);
 	pgm_string_append_printf (response,	"<table>"
@@ -1012,15 +1452,13 @@ transports_callback (
 					"</tr>"
 				);
 
-	if (pgm_sock_list)
+	unsigned epoch;
+	const pgm_sock_registry_t* registry = pgm_sock_registry_enter (&epoch);
+	if (registry->len)
 	{
-		pgm_rwlock_reader_lock (&pgm_sock_list_lock);
-
-		pgm_slist_t* list = pgm_sock_list;
-		while (list)
+		for (unsigned n = 0; n < registry->len; n++)
 		{
-			pgm_slist_t* next = list->next;
-			pgm_sock_t*  sock = list->data;
+			const pgm_sock_t* sock = registry->socks[ n ];
 
 			char group_address[INET6_ADDRSTRLEN];
 			getnameinfo ((struct sockaddr*)&sock->send_gsr.gsr_group, pgm_sockaddr_len ((struct sockaddr*)&sock->send_gsr.gsr_group),
@@ -1043,9 +1481,7 @@ transports_callback (
 						gsi,
 						gsi, sport,
 						sport);
-			list = next;
 		}
-		pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
 	}
 	else
 	{
@@ -1055,6 +1491,7 @@ transports_callback (
 							"</tr>"
 				);
 	}
+	pgm_sock_registry_leave (epoch);
 
 	pgm_string_append (response,		"</table>\n"
 						"</div>");
@@ -1069,10 +1506,314 @@ histograms_callback (
         )
 {
 	pgm_string_t* response = http_create_response ("Histograms", HTTP_TAB_HISTOGRAMS);
+	pgm_latency_write_html_all (response);
+	pgm_lockstat_write_html_all (response);
+#ifdef USE_HISTOGRAMS
 	pgm_histogram_write_html_graph_all (response);
+#endif
 	http_finalize_response (connection, response);
 }
 
+/* copy the counters of the index'th socket and its peers, each counter is read
+ * whole without pausing the writers.  the registry read section is left between
+ * sockets so that a scrape cannot hold back a socket close for the duration of
+ * the whole response.
+ *
+ * returns FALSE when the registry holds fewer sockets.
+ */
+
+static
+bool
+http_snapshot_sock (
+	const unsigned				  index,
+	struct http_sock_snapshot_t*	 restrict snapshot
+	)
+{
+	bool found = FALSE;
+
+	unsigned epoch;
+	const pgm_sock_registry_t* registry = pgm_sock_registry_enter (&epoch);
+	if (index < registry->len)
+	{
+		const pgm_sock_t* sock = registry->socks[ index ];
+		pgm_tsi_print_r (&sock->tsi, snapshot->tsi, sizeof(snapshot->tsi));
+		snapshot->is_source = (NULL != sock->window);
+		for (unsigned k = 0; k < PGM_PC_SOURCE_MAX; k++)
+			snapshot->stats[ k ] = pgm_atomic_read64 (&sock->cumulative_stats[ k ]);
+		if (snapshot->is_source) {
+			snapshot->txw_length	 = pgm_txw_length (sock->window);
+			snapshot->txw_max_length = pgm_txw_max_length (sock->window);
+			snapshot->txw_size	 = pgm_txw_size (sock->window);
+		}
+		pgm_rwlock_reader_lock (&((pgm_sock_t*)sock)->peers_lock);
+		snapshot->peer_count = pgm_list_length (sock->peers_list);
+		snapshot->peers = snapshot->peer_count ? pgm_new0 (struct http_peer_snapshot_t, snapshot->peer_count) : NULL;
+		unsigned j = 0;
+		for (pgm_list_t* peers = sock->peers_list; peers; peers = peers->next, j++)
+		{
+			const pgm_peer_t* peer = peers->data;
+			struct http_peer_snapshot_t* p = &snapshot->peers[ j ];
+			pgm_tsi_print_r (&peer->tsi, p->tsi, sizeof(p->tsi));
+			for (unsigned k = 0; k < PGM_PC_RECEIVER_MAX; k++)
+				p->stats[ k ] = pgm_atomic_read64 (&peer->cumulative_stats[ k ]);
+			p->rxw_length	  = pgm_rxw_length (peer->window);
+			p->rxw_max_length = pgm_rxw_max_length (peer->window);
+			p->rxw_size	  = pgm_rxw_size (peer->window);
+		}
+		pgm_rwlock_reader_unlock (&((pgm_sock_t*)sock)->peers_lock);
+		found = TRUE;
+	}
+	pgm_sock_registry_leave (epoch);
+	return found;
+}
+
+/* returns array of socket snapshots, count in *count, free with
+ * http_free_snapshots().
+ */
+
+static
+struct http_sock_snapshot_t*
+http_snapshot_all (
+	unsigned*		count
+	)
+{
+	struct http_sock_snapshot_t* snapshots = NULL;
+	unsigned allocated = 0;
+
+	*count = 0;
+	for (;;) {
+		if (*count == allocated) {
+			allocated = allocated ? allocated * 2 : 8;
+			snapshots = pgm_realloc (snapshots, allocated * sizeof(struct http_sock_snapshot_t));
+		}
+		memset (&snapshots[ *count ], 0, sizeof(struct http_sock_snapshot_t));
+		if (!http_snapshot_sock (*count, &snapshots[ *count ]))
+			break;
+		++*count;
+	}
+	return snapshots;
+}
+
+static
+void
+http_free_snapshots (
+	struct http_sock_snapshot_t*	snapshots,
+	const unsigned			count
+	)
+{
+	for (unsigned i = 0; i < count; i++)
+		pgm_free (snapshots[ i ].peers);
+	pgm_free (snapshots);
+}
+
+/* latency in μs as decimal seconds.
+ */
+
+static
+void
+http_append_seconds (
+	pgm_string_t*restrict	string,
+	const uint64_t		usecs
+	)
+{
+	pgm_string_append_printf (string, "%" PRIu64 ".%06u", usecs / 1000000, (unsigned)(usecs % 1000000));
+}
+
+/* OpenMetrics text exposition, every family is emitted once with all of its
+ * samples as the format requires.
+ */
+
+static
+void
+metrics_callback (
+	struct http_connection_t*restrict connection,
+	PGM_GNUC_UNUSED const char*restrict path
+        )
+{
+	static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+	unsigned count;
+	struct http_sock_snapshot_t* snapshots = http_snapshot_all (&count);
+	pgm_string_t* response = pgm_string_new (NULL);
+
+	for (unsigned k = 0; k < PGM_PC_SOURCE_MAX; k++)
+	{
+		const struct pgm_counter_name_t* counter = &pgm_source_counter_names[ k ];
+		if (NULL == counter->name)
+			continue;
+		pgm_string_append_printf (response, "# TYPE pgm_source_%s %s\n",
+					  counter->name, counter->is_gauge ? "gauge" : "counter");
+		for (unsigned i = 0; i < count; i++) {
+			if (!snapshots[ i ].is_source)
+				continue;
+			pgm_string_append_printf (response, "pgm_source_%s%s{sock=\"%s\"} %" PRIu64 "\n",
+						  counter->name, counter->is_gauge ? "" : "_total",
+						  snapshots[ i ].tsi, snapshots[ i ].stats[ k ]);
+		}
+	}
+
+	pgm_string_append (response, "# TYPE pgm_source_window_packets gauge\n");
+	for (unsigned i = 0; i < count; i++)
+		if (snapshots[ i ].is_source)
+			pgm_string_append_printf (response, "pgm_source_window_packets{sock=\"%s\"} %" PRIu32 "\n",
+						  snapshots[ i ].tsi, snapshots[ i ].txw_length);
+	pgm_string_append (response, "# TYPE pgm_source_window_max_packets gauge\n");
+	for (unsigned i = 0; i < count; i++)
+		if (snapshots[ i ].is_source)
+			pgm_string_append_printf (response, "pgm_source_window_max_packets{sock=\"%s\"} %zu\n",
+						  snapshots[ i ].tsi, snapshots[ i ].txw_max_length);
+	pgm_string_append (response, "# TYPE pgm_source_window_bytes gauge\n");
+	for (unsigned i = 0; i < count; i++)
+		if (snapshots[ i ].is_source)
+			pgm_string_append_printf (response, "pgm_source_window_bytes{sock=\"%s\"} %zu\n",
+						  snapshots[ i ].tsi, snapshots[ i ].txw_size);
+
+	for (unsigned k = 0; k < PGM_PC_RECEIVER_MAX; k++)
+	{
+		const struct pgm_counter_name_t* counter = &pgm_receiver_counter_names[ k ];
+		if (NULL == counter->name)
+			continue;
+		pgm_string_append_printf (response, "# TYPE pgm_receiver_%s %s\n",
+					  counter->name, counter->is_gauge ? "gauge" : "counter");
+		for (unsigned i = 0; i < count; i++)
+			for (unsigned j = 0; j < snapshots[ i ].peer_count; j++)
+				pgm_string_append_printf (response, "pgm_receiver_%s%s{sock=\"%s\",peer=\"%s\"} %" PRIu64 "\n",
+							  counter->name, counter->is_gauge ? "" : "_total",
+							  snapshots[ i ].tsi, snapshots[ i ].peers[ j ].tsi,
+							  snapshots[ i ].peers[ j ].stats[ k ]);
+	}
+
+	pgm_string_append (response, "# TYPE pgm_receiver_window_packets gauge\n");
+	for (unsigned i = 0; i < count; i++)
+		for (unsigned j = 0; j < snapshots[ i ].peer_count; j++)
+			pgm_string_append_printf (response, "pgm_receiver_window_packets{sock=\"%s\",peer=\"%s\"} %" PRIu32 "\n",
+						  snapshots[ i ].tsi, snapshots[ i ].peers[ j ].tsi,
+						  snapshots[ i ].peers[ j ].rxw_length);
+	pgm_string_append (response, "# TYPE pgm_receiver_window_max_packets gauge\n");
+	for (unsigned i = 0; i < count; i++)
+		for (unsigned j = 0; j < snapshots[ i ].peer_count; j++)
+			pgm_string_append_printf (response, "pgm_receiver_window_max_packets{sock=\"%s\",peer=\"%s\"} %" PRIu32 "\n",
+						  snapshots[ i ].tsi, snapshots[ i ].peers[ j ].tsi,
+						  snapshots[ i ].peers[ j ].rxw_max_length);
+	pgm_string_append (response, "# TYPE pgm_receiver_window_bytes gauge\n");
+	for (unsigned i = 0; i < count; i++)
+		for (unsigned j = 0; j < snapshots[ i ].peer_count; j++)
+			pgm_string_append_printf (response, "pgm_receiver_window_bytes{sock=\"%s\",peer=\"%s\"} %zu\n",
+						  snapshots[ i ].tsi, snapshots[ i ].peers[ j ].tsi,
+						  snapshots[ i ].peers[ j ].rxw_size);
+	http_free_snapshots (snapshots, count);
+
+	pgm_latency_stage_t* merged = pgm_new (pgm_latency_stage_t, 1);
+	pgm_string_append (response, "# TYPE pgm_stage_latency_seconds summary\n");
+	for (unsigned stage = 0; stage < PGM_LATENCY_STAGE_MAX; stage++)
+	{
+		if (!pgm_latency_snapshot (stage, merged))
+			continue;
+		if (merged->count > 0) {
+			for (unsigned q = 0; q < PGM_N_ELEMENTS(quantiles); q++) {
+				pgm_string_append_printf (response, "pgm_stage_latency_seconds{stage=\"%s\",quantile=\"%g\"} ",
+							  http_latency_stages[ stage ], quantiles[ q ]);
+				http_append_seconds (response, pgm_latency_percentile (merged, quantiles[ q ]));
+				pgm_string_append (response, "\n");
+			}
+		}
+		pgm_string_append_printf (response, "pgm_stage_latency_seconds_sum{stage=\"%s\"} ",
+					  http_latency_stages[ stage ]);
+		http_append_seconds (response, merged->sum);
+		pgm_string_append_printf (response, "\npgm_stage_latency_seconds_count{stage=\"%s\"} %" PRIu64 "\n",
+					  http_latency_stages[ stage ], merged->count);
+	}
+	pgm_free (merged);
+	pgm_string_append (response, "# EOF\n");
+
+	char* buf = pgm_string_free (response, FALSE);
+	http_set_content_type (connection, "application/openmetrics-text; version=1.0.0; charset=utf-8");
+	http_set_response (connection, buf, strlen (buf));
+}
+
+static
+void
+http_append_json_counters (
+	pgm_string_t*		     restrict string,
+	const struct pgm_counter_name_t* restrict counters,
+	const uint64_t*		     restrict stats,
+	const unsigned			      len
+	)
+{
+	const char* sep = "";
+	pgm_string_append (string, "\"counters\":{");
+	for (unsigned k = 0; k < len; k++) {
+		if (NULL == counters[ k ].name)
+			continue;
+		pgm_string_append_printf (string, "%s\"%s\":%" PRIu64, sep, counters[ k ].name, stats[ k ]);
+		sep = ",";
+	}
+	pgm_string_append (string, "}");
+}
+
+/* the same content as /metrics nested by socket and peer.
+ */
+
+static
+void
+stats_json_callback (
+	struct http_connection_t*restrict connection,
+	PGM_GNUC_UNUSED const char*restrict path
+        )
+{
+	unsigned count;
+	struct http_sock_snapshot_t* snapshots = http_snapshot_all (&count);
+	pgm_string_t* response = pgm_string_new (NULL);
+
+	pgm_string_append_printf (response, "{\"host\":\"%s\",\"pid\":%d,\"sockets\":[", http_hostname, http_pid);
+	for (unsigned i = 0; i < count; i++)
+	{
+		const struct http_sock_snapshot_t* snapshot = &snapshots[ i ];
+		pgm_string_append_printf (response, "%s{\"tsi\":\"%s\"", i ? "," : "", snapshot->tsi);
+		if (snapshot->is_source) {
+			pgm_string_append (response, ",\"source\":{");
+			http_append_json_counters (response, pgm_source_counter_names, snapshot->stats, PGM_PC_SOURCE_MAX);
+			pgm_string_append_printf (response, ",\"window\":{\"packets\":%" PRIu32 ",\"max_packets\":%zu,\"bytes\":%zu}}",
+						  snapshot->txw_length, snapshot->txw_max_length, snapshot->txw_size);
+		}
+		pgm_string_append (response, ",\"peers\":[");
+		for (unsigned j = 0; j < snapshot->peer_count; j++)
+		{
+			const struct http_peer_snapshot_t* peer = &snapshot->peers[ j ];
+			pgm_string_append_printf (response, "%s{\"tsi\":\"%s\",", j ? "," : "", peer->tsi);
+			http_append_json_counters (response, pgm_receiver_counter_names, peer->stats, PGM_PC_RECEIVER_MAX);
+			pgm_string_append_printf (response, ",\"window\":{\"packets\":%" PRIu32 ",\"max_packets\":%" PRIu32 ",\"bytes\":%zu}}",
+						  peer->rxw_length, peer->rxw_max_length, peer->rxw_size);
+		}
+		pgm_string_append (response, "]}");
+	}
+	http_free_snapshots (snapshots, count);
+
+	pgm_latency_stage_t* merged = pgm_new (pgm_latency_stage_t, 1);
+	pgm_string_append (response, "],\"latency\":{");
+	const char* sep = "";
+	for (unsigned stage = 0; stage < PGM_LATENCY_STAGE_MAX; stage++)
+	{
+		if (!pgm_latency_snapshot (stage, merged))
+			continue;
+		pgm_string_append_printf (response, "%s\"%s\":{\"count\":%" PRIu64 ",\"sum_us\":%" PRIu64 ",\"max_us\":%" PRIu64,
+					  sep, http_latency_stages[ stage ], merged->count, merged->sum, merged->max);
+		if (merged->count > 0)
+			pgm_string_append_printf (response, ",\"p50_us\":%" PRIu64 ",\"p90_us\":%" PRIu64 ",\"p99_us\":%" PRIu64 ",\"p999_us\":%" PRIu64,
+						  pgm_latency_percentile (merged, 0.5),
+						  pgm_latency_percentile (merged, 0.9),
+						  pgm_latency_percentile (merged, 0.99),
+						  pgm_latency_percentile (merged, 0.999));
+		pgm_string_append (response, "}");
+		sep = ",";
+	}
+	pgm_free (merged);
+	pgm_string_append (response, "}}\n");
+
+	char* buf = pgm_string_free (response, FALSE);
+	http_set_content_type (connection, "application/json");
+	http_set_response (connection, buf, strlen (buf));
+}
+
 static
 void
 default_callback (
@@ -1107,39 +1848,28 @@ http_tsi_response (
 	const pgm_tsi_t*	 restrict tsi
 	)
 {
-/* first verify this is a valid TSI */
-	pgm_rwlock_reader_lock (&pgm_sock_list_lock);
+/* first verify this is a valid TSI, a source by index */
+	unsigned epoch;
+	const pgm_sock_registry_t* registry = pgm_sock_registry_enter (&epoch);
+	pgm_sock_t* sock = pgm_sock_registry_lookup (registry, tsi);
 
-	pgm_sock_t* sock = NULL;
-	pgm_slist_t* list = pgm_sock_list;
-	while (list)
+/* otherwise check receivers of each socket */
+	for (unsigned n = 0; NULL == sock && n < registry->len; n++)
 	{
-		pgm_sock_t* list_sock = (pgm_sock_t*)list->data;
-		pgm_slist_t* next = list->next;
-
-/* check source */
-		if (pgm_tsi_equal (tsi, &list_sock->tsi))
-		{
-			sock = list_sock;
-			break;
-		}
-
-/* check receivers */
+		pgm_sock_t* list_sock = registry->socks[ n ];
 		pgm_rwlock_reader_lock (&list_sock->peers_lock);
-		pgm_peer_t* receiver = pgm_hashtable_lookup (list_sock->peers_hashtable, tsi);
+		pgm_peer_t* receiver = pgm_peer_table_lookup (pgm_rx_shard_for (list_sock, tsi)->peers_table, tsi);
 		if (receiver) {
 			const int retval = http_receiver_response (connection, list_sock, receiver);
 			pgm_rwlock_reader_unlock (&list_sock->peers_lock);
-			pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
+			pgm_sock_registry_leave (epoch);
 			return retval;
 		}
 		pgm_rwlock_reader_unlock (&list_sock->peers_lock);
-
-		list = next;
 	}
 
 	if (!sock) {
-		pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
+		pgm_sock_registry_leave (epoch);
 		return -1;
 	}
 
@@ -1170,11 +1900,12 @@ http_tsi_response (
 	const pgm_time_t ihb_min = sock->spm_heartbeat_len ? sock->spm_heartbeat_interval[ 1 ] : 0;
 	const pgm_time_t ihb_max = sock->spm_heartbeat_len ? sock->spm_heartbeat_interval[ sock->spm_heartbeat_len - 1 ] : 0;
 
-	char spm_path[INET6_ADDRSTRLEN];
-	getnameinfo ((struct sockaddr*)&sock->recv_gsr[0].gsr_source, pgm_sockaddr_len ((struct sockaddr*)&sock->recv_gsr[0].gsr_source),
-		     spm_path, sizeof(spm_path),
-		     NULL, 0,
-		     NI_NUMERICHOST);
+	char spm_path[INET6_ADDRSTRLEN] = "";
+	if (sock->recv_gsr_len > 0)
+		getnameinfo ((struct sockaddr*)&sock->recv_gsr[0].gsr_source, pgm_sockaddr_len ((struct sockaddr*)&sock->recv_gsr[0].gsr_source),
+			     spm_path, sizeof(spm_path),
+			     NULL, 0,
+			     NI_NUMERICHOST);
 
 	pgm_string_t* response = http_create_response (title, HTTP_TAB_TRANSPORTS);
 	pgm_string_append_printf (response,	"<div class=\"heading\">"
@@ -1290,39 +2021,39 @@ http_tsi_response (
 	pgm_string_append_printf (response,	"\n<h2>Performance information</h2>"
 						"\n<table>"
 						"<tr>"
-							"<th>Data bytes sent</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Data bytes sent</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Data packets sent</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Data packets sent</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
 							"<th>Bytes buffered</th><td>%" GROUP_FORMAT PRIu32 "</td>"
 						"</tr><tr>"
 							"<th>Packets buffered</th><td>%" GROUP_FORMAT PRIu32 "</td>"
 						"</tr><tr>"
-							"<th>Bytes sent</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Bytes sent</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Raw NAKs received</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Raw NAKs received</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Checksum errors</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Checksum errors</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Malformed NAKs</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Malformed NAKs</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Packets discarded</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Packets discarded</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Bytes retransmitted</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Bytes retransmitted</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Packets retransmitted</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Packets retransmitted</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>NAKs received</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NAKs received</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>NAKs ignored</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NAKs ignored</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Transmission rate</th><td>%" GROUP_FORMAT PRIu32 " bps</td>"
+							"<th>Transmission rate</th><td>%" GROUP_FORMAT PRIu64 " bps</td>"
 						"</tr><tr>"
-							"<th>NNAK packets received</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NNAK packets received</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>NNAKs received</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NNAKs received</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Malformed NNAKs</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Malformed NNAKs</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr>"
 						"</table>\n",
 						sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT],
@@ -1343,7 +2074,10 @@ http_tsi_response (
 						sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NNAKS_RECEIVED],
 						sock->cumulative_stats[PGM_PC_SOURCE_NNAK_ERRORS]);
 
-	pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
+	http_rates_table (response, sock->rates);
+	pgm_flightrec_write_html (sock->flightrec, response);
+
+	pgm_sock_registry_leave (epoch);
 	http_finalize_response (connection, response);
 	return 0;
 }
@@ -1452,6 +2186,83 @@ http_time_summary (
 	}
 }
 
+/* one row per non-empty latency bucket, labelled by its upper bound.
+ */
+
+static
+void
+http_latency_table (
+	pgm_string_t*	restrict response,
+	const char*	restrict title,
+	const uint32_t*	restrict buckets
+	)
+{
+	pgm_string_append_printf (response,	"\n<h2>%s</h2>"
+						"\n<table>",
+				  title);
+	for (unsigned i = 0; i < PGM_RX_LATENCY_BUCKETS; i++)
+	{
+		if (0 == buckets[ i ])
+			continue;
+		if (PGM_RX_LATENCY_BUCKETS - 1 == i)
+			pgm_string_append_printf (response,	"<tr>"
+								"<th>&ge; %" GROUP_FORMAT "u μs</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"</tr>",
+						  1u << (i - 1),
+						  buckets[ i ]);
+		else
+			pgm_string_append_printf (response,	"<tr>"
+								"<th>&lt; %" GROUP_FORMAT "u μs</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"</tr>",
+						  1u << i,
+						  buckets[ i ]);
+	}
+	pgm_string_append (response,	"</table>\n");
+}
+
+/* per second rates over the last second, ten seconds and minute of samples.
+ */
+
+static
+void
+http_rates_table (
+	pgm_string_t*			 restrict response,
+	const struct pgm_stats_ring_t*	 restrict ring
+	)
+{
+	static const unsigned intervals[] = { 1, 10, PGM_STATS_RING_LEN - 1 };
+
+	pgm_string_append (response,		"\n<h2>Rates</h2>"
+						"\n<table>"
+						"<tr>"
+							"<th>Interval</th>"
+							"<th>Packets/s</th>"
+							"<th>Bytes/s</th>"
+							"<th>NAKs/s</th>"
+							"<th>Losses/s</th>"
+						"</tr>");
+	for (unsigned i = 0; i < PGM_N_ELEMENTS(intervals); i++)
+	{
+		uint64_t rates[PGM_STATS_RATE_MAX];
+		const unsigned span = pgm_stats_ring_rates (ring, intervals[ i ], rates);
+		if (0 == span)
+			break;
+		pgm_string_append_printf (response,	"<tr>"
+								"<td>%u s</td>"
+								"<td>%" GROUP_FORMAT PRIu64 "</td>"
+								"<td>%" GROUP_FORMAT PRIu64 "</td>"
+								"<td>%" GROUP_FORMAT PRIu64 "</td>"
+								"<td>%" GROUP_FORMAT PRIu64 "</td>"
+							"</tr>",
+					  span,
+					  rates[PGM_STATS_RATE_PACKETS],
+					  rates[PGM_STATS_RATE_BYTES],
+					  rates[PGM_STATS_RATE_NAKS],
+					  rates[PGM_STATS_RATE_LOSSES]);
+	}
+	pgm_string_append (response,	"</table>\n");
+}
+
 static
 int
 http_receiver_response (
@@ -1488,9 +2299,7 @@ http_receiver_response (
 	const in_port_t sport = pgm_ntohs (peer->tsi.sport);
 	const in_port_t dport = pgm_ntohs (sock->dport);	/* by definition must be the same */
 	const pgm_rxw_t* window = peer->window;
-	const uint32_t outstanding_naks = window->nak_backoff_queue.length +
-					  window->wait_ncf_queue.length +
-					  window->wait_data_queue.length;
+	const uint32_t outstanding_naks = window->missing_count;
 
 	time_t last_activity_time;
 	pgm_time_since_epoch (&peer->last_packet, &last_activity_time);
@@ -1564,25 +2373,25 @@ http_receiver_response (
 	pgm_string_append_printf (response,	"\n<h2>Performance information</h2>"
 						"\n<table>"
 						"<tr>"
-							"<th>Data bytes received</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Data bytes received</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Data packets received</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Data packets received</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>NAK failures</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NAK failures</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Bytes received</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Bytes received</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Checksum errors</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Checksum errors</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Malformed SPMs</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Malformed SPMs</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Malformed ODATA</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Malformed ODATA</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Malformed RDATA</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Malformed RDATA</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Malformed NCFs</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Malformed NCFs</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Packets discarded</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Packets discarded</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
 							"<th>Losses</th><td>%" GROUP_FORMAT PRIu32 "</td>"	/* detected missed packets */
 						"</tr><tr>"
@@ -1590,29 +2399,29 @@ http_receiver_response (
 						"</tr><tr>"
 							"<th>Packets delivered to app</th><td>%" GROUP_FORMAT PRIu32 "</td>"
 						"</tr><tr>"
-							"<th>Duplicate SPMs</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Duplicate SPMs</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Duplicate ODATA/RDATA</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Duplicate ODATA/RDATA</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>NAK packets sent</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NAK packets sent</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>NAKs sent</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NAKs sent</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>NAKs retransmitted</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NAKs retransmitted</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>NAKs failed</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NAKs failed</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>NAKs failed due to RXW advance</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NAKs failed due to RXW advance</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>NAKs failed due to NCF retries</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NAKs failed due to NCF retries</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>NAKs failed due to DATA retries</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NAKs failed due to DATA retries</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>NAK failures delivered to app</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NAK failures delivered to app</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>NAKs suppressed</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NAKs suppressed</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
-							"<th>Malformed NAKs</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>Malformed NAKs</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
 							"<th>Outstanding NAKs</th><td>%" GROUP_FORMAT PRIu32 "</td>"
 						"</tr><tr>"
@@ -1620,21 +2429,25 @@ http_receiver_response (
 						"</tr><tr>"
 							"<th>NAK repair min time</th><td>%" GROUP_FORMAT PRIu32 " μs</td>"
 						"</tr><tr>"
-							"<th>NAK repair mean time</th><td>%" GROUP_FORMAT PRIu32 " μs</td>"
+							"<th>NAK repair mean time</th><td>%" GROUP_FORMAT PRIu64 " μs</td>"
 						"</tr><tr>"
 							"<th>NAK repair max time</th><td>%" GROUP_FORMAT PRIu32 " μs</td>"
 						"</tr><tr>"
 							"<th>NAK fail min time</th><td>%" GROUP_FORMAT PRIu32 " μs</td>"
 						"</tr><tr>"
-							"<th>NAK fail mean time</th><td>%" GROUP_FORMAT PRIu32 " μs</td>"
+							"<th>NAK fail mean time</th><td>%" GROUP_FORMAT PRIu64 " μs</td>"
 						"</tr><tr>"
 							"<th>NAK fail max time</th><td>%" GROUP_FORMAT PRIu32 " μs</td>"
 						"</tr><tr>"
 							"<th>NAK min retransmit count</th><td>%" GROUP_FORMAT PRIu32 "</td>"
 						"</tr><tr>"
-							"<th>NAK mean retransmit count</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+							"<th>NAK mean retransmit count</th><td>%" GROUP_FORMAT PRIu64 "</td>"
 						"</tr><tr>"
 							"<th>NAK max retransmit count</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+						"</tr><tr>"
+							"<th>FEC decode matrix cache hits</th><td>%" GROUP_FORMAT PRIu32 "</td>"
+						"</tr><tr>"
+							"<th>FEC decode matrix cache misses</th><td>%" GROUP_FORMAT PRIu32 "</td>"
 						"</tr>"
 						"</table>\n",
 						peer->cumulative_stats[PGM_PC_RECEIVER_DATA_BYTES_RECEIVED],
@@ -1672,7 +2485,17 @@ http_receiver_response (
 						peer->max_fail_time,
 						window->min_nak_transmit_count,
 						peer->cumulative_stats[PGM_PC_RECEIVER_TRANSMIT_MEAN],
-						window->max_nak_transmit_count);
+						window->max_nak_transmit_count,
+						window->rs.matrix_hits,
+						window->rs.matrix_misses);
+
+/* NIC to application latency from arrival time stamps */
+	if (sock->use_rx_timestamp)
+		http_latency_table (response, "Receive latency", peer->rx_latency);
+/* publish to delivery latency from source send time stamps */
+	if (peer->has_send_tstamp)
+		http_latency_table (response, "Publish latency", peer->send_latency);
+	http_rates_table (response, peer->rates);
 	http_finalize_response (connection, response);
 	return 0;
 }
@@ -33,18 +33,28 @@
 #endif
 
 
-/* mock state */
-static pgm_rwlock_t	mock_pgm_sock_list_lock;
-static pgm_slist_t*	mock_pgm_sock_list;
-
 /* mock functions for external references */
 
-#define pgm_sock_list_lock	mock_pgm_sock_list_lock
-#define pgm_sock_list		mock_pgm_sock_list
+#define pgm_stats_ring_rates	mock_pgm_stats_ring_rates
 
 #define HTTP_DEBUG
 #include "http.c"
 
+PGM_GNUC_INTERNAL
+unsigned
+mock_pgm_stats_ring_rates (
+	const struct pgm_stats_ring_t* const restrict ring,
+	const unsigned				      interval,
+	uint64_t*		       const restrict rates
+	)
+{
+	memset (rates, 0, PGM_STATS_RATE_MAX * sizeof (uint64_t));
+	return 0;
+}
+
+const struct pgm_counter_name_t pgm_source_counter_names[PGM_PC_SOURCE_MAX];
+const struct pgm_counter_name_t pgm_receiver_counter_names[PGM_PC_RECEIVER_MAX];
+
 PGM_GNUC_INTERNAL
 int
 pgm_get_nprocs (void)
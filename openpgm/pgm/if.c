@@ -38,6 +38,10 @@
 #	include <sys/socket.h>
 #	include <netdb.h>		/* _GNU_SOURCE for EAI_NODATA */
 #endif
+#ifdef __linux__
+#	include <linux/netlink.h>
+#	include <linux/rtnetlink.h>
+#endif
 #include <impl/i18n.h>
 #include <impl/framework.h>
 #include <impl/inet_lnaof.h>
@@ -2133,6 +2137,200 @@ free_lists:
 	return FALSE;
 }
 
+/* resolved network specifications by family, most recent first.  entries
+ * expire after PGM_IF_CACHE_TTL for name service changes, and are flushed at
+ * once when the kernel reports a link, address or route change.
+ */
+
+struct if_cache_entry_t {
+	char*			network;
+	int			family;
+	pgm_time_t		expiry;
+	size_t			len;		/* of ai */
+	struct pgm_addrinfo_t*	ai;
+};
+
+static pgm_mutex_t	if_cache_mutex;
+static bool		if_cache_is_running = FALSE;
+static pgm_slist_t*	if_cache = NULL;
+static unsigned		if_cache_len = 0;
+#ifdef __linux__
+static SOCKET		if_cache_netlink = INVALID_SOCKET;
+#endif
+
+static
+void
+if_cache_flush (void)
+{
+	while (if_cache) {
+		struct if_cache_entry_t* entry = if_cache->data;
+		pgm_free (entry->network);
+		pgm_free (entry->ai);
+		pgm_free (entry);
+		if_cache = pgm_slist_remove_first (if_cache);
+	}
+	if_cache_len = 0;
+}
+
+PGM_GNUC_INTERNAL
+void
+pgm_if_cache_init (void)
+{
+	pgm_mutex_init (&if_cache_mutex);
+#ifdef __linux__
+/* change notifications, without which entries only expire */
+	const SOCKET s = socket (AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+	if (INVALID_SOCKET != s) {
+		struct sockaddr_nl addr;
+		memset (&addr, 0, sizeof (addr));
+		addr.nl_family = AF_NETLINK;
+		addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR | RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE;
+		if (0 == bind (s, (struct sockaddr*)&addr, sizeof (addr)))
+			if_cache_netlink = s;
+		else
+			closesocket (s);
+	}
+#endif
+	if_cache_is_running = TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+pgm_if_cache_shutdown (void)
+{
+	if (!if_cache_is_running)
+		return;
+	if_cache_is_running = FALSE;
+	if_cache_flush();
+#ifdef __linux__
+	if (INVALID_SOCKET != if_cache_netlink) {
+		closesocket (if_cache_netlink);
+		if_cache_netlink = INVALID_SOCKET;
+	}
+#endif
+	pgm_mutex_free (&if_cache_mutex);
+}
+
+/* drop every entry on pending change notifications.  caller holds
+ * if_cache_mutex.
+ */
+
+static
+void
+if_cache_check (void)
+{
+#ifdef __linux__
+	if (INVALID_SOCKET == if_cache_netlink)
+		return;
+	char buf[4096];
+	bool is_changed = FALSE;
+	for (;;) {
+		const ssize_t len = recv (if_cache_netlink, buf, sizeof (buf), MSG_DONTWAIT);
+		if (len > 0) {
+			is_changed = TRUE;
+			continue;
+		}
+/* lost notifications on overflow */
+		if (len < 0 && ENOBUFS == errno) {
+			is_changed = TRUE;
+			continue;
+		}
+		break;
+	}
+	if (is_changed && NULL != if_cache) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Interface change, flushing %u cached network resolutions."), if_cache_len);
+		if_cache_flush();
+	}
+#endif
+}
+
+/* copy of a cached resolution with its address arrays re-pointed into the
+ * copy.
+ */
+
+static
+struct pgm_addrinfo_t*
+if_cache_copy (
+	const struct pgm_addrinfo_t*	ai,
+	const size_t			len
+	)
+{
+	struct pgm_addrinfo_t* copy = pgm_malloc (len);
+	memcpy (copy, ai, len);
+	copy->ai_recv_addrs = (void*)((char*)copy + sizeof(struct pgm_addrinfo_t));
+	copy->ai_send_addrs = (void*)((char*)copy->ai_recv_addrs + copy->ai_recv_addrs_len * sizeof(struct pgm_group_source_req));
+	return copy;
+}
+
+/* returns TRUE and a copy in res when the specification is cached.
+ */
+
+static
+bool
+if_cache_lookup (
+	const char*		      restrict network,
+	const int			       family,
+	struct pgm_addrinfo_t**	      restrict res
+	)
+{
+	if (!if_cache_is_running)
+		return FALSE;
+	const pgm_time_t now = pgm_time_update_now();
+	pgm_mutex_lock (&if_cache_mutex);
+	if_cache_check();
+	for (pgm_slist_t* list = if_cache; NULL != list; list = list->next)
+	{
+		struct if_cache_entry_t* entry = list->data;
+		if (family != entry->family || 0 != strcmp (network, entry->network))
+			continue;
+		if (pgm_time_after_eq (now, entry->expiry))
+			break;
+		*res = if_cache_copy (entry->ai, entry->len);
+		pgm_mutex_unlock (&if_cache_mutex);
+		return TRUE;
+	}
+	pgm_mutex_unlock (&if_cache_mutex);
+	return FALSE;
+}
+
+static
+void
+if_cache_insert (
+	const char*		     restrict network,
+	const int			      family,
+	const struct pgm_addrinfo_t* restrict ai,
+	const size_t			      len
+	)
+{
+	if (!if_cache_is_running)
+		return;
+	struct if_cache_entry_t* entry = pgm_new (struct if_cache_entry_t, 1);
+	entry->network	= pgm_strdup (network);
+	entry->family	= family;
+	entry->expiry	= pgm_time_update_now() + PGM_IF_CACHE_TTL;
+	entry->len	= len;
+	entry->ai	= if_cache_copy (ai, len);
+	pgm_mutex_lock (&if_cache_mutex);
+/* replace an expired entry of the specification, otherwise start over at capacity */
+	for (pgm_slist_t* list = if_cache; NULL != list; list = list->next)
+	{
+		struct if_cache_entry_t* old = list->data;
+		if (family == old->family && 0 == strcmp (network, old->network)) {
+			pgm_free (old->network);
+			pgm_free (old->ai);
+			pgm_free (old);
+			list->data = entry;
+			pgm_mutex_unlock (&if_cache_mutex);
+			return;
+		}
+	}
+	if (if_cache_len == PGM_IF_CACHE_MAX)
+		if_cache_flush();
+	if_cache = pgm_slist_prepend (if_cache, entry);
+	if_cache_len++;
+	pgm_mutex_unlock (&if_cache_mutex);
+}
+
 /* create pgm_group_source_req as used by pgm_transport_create which specify port, address & interface.
  * gsr_source is copied from gsr_group for ASM, caller needs to populate gsr_source for SSM.
  *
@@ -2170,6 +2368,8 @@ pgm_getaddrinfo (
 			(const void*)error);
 	}
 
+	if (if_cache_lookup (network, family, res))
+		return TRUE;
 	if (!network_parse (network, family, &recv_list, &send_list, error))
 		return FALSE;
 	const size_t recv_list_len = pgm_list_length (recv_list);
@@ -2193,6 +2393,7 @@ pgm_getaddrinfo (
 		pgm_free (send_list->data);
 		send_list = pgm_list_delete_link (send_list, send_list);
 	}
+	if_cache_insert (network, family, ai, sizeof(struct pgm_addrinfo_t) + (recv_list_len + send_list_len) * sizeof(struct pgm_group_source_req));
 	*res = ai;
 	return TRUE;
 }
@@ -0,0 +1,68 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * receiver state checkpoint and restore across process restarts.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_CHECKPOINT_H__
+#define __PGM_IMPL_CHECKPOINT_H__
+
+struct pgm_checkpoint_peer_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+#include <impl/receiver.h>
+
+PGM_BEGIN_DECLS
+
+#define PGM_CHECKPOINT_MAGIC		0x4b435850u	/* "PXCK" */
+#define PGM_CHECKPOINT_VERSION		1
+#define PGM_CHECKPOINT_PEERS_MAX	65536
+
+/* file header, count records follow.  host byte order, the file is read back
+ * by a process on the same host.
+ */
+struct pgm_checkpoint_header_t {
+	uint32_t			magic;
+	uint32_t			version;
+	uint32_t			count;
+	uint32_t			record_len;
+};
+
+/* receive state of one source */
+struct pgm_checkpoint_peer_t {
+	pgm_tsi_t			tsi;
+	uint32_t			trail;		/* receive window edges */
+	uint32_t			lead;
+	uint32_t			commit_lead;	/* next sequence to deliver */
+	uint8_t				rs_k;		/* transmission group size, 0 without FEC */
+	uint8_t				has_proactive_parity;
+	uint8_t				has_ondemand_parity;
+	uint8_t				__padding;
+	struct sockaddr_storage		nla;		/* advertised by SPM, AF_UNSPEC for none */
+};
+
+PGM_GNUC_INTERNAL void pgm_checkpoint_apply (pgm_sock_t*const restrict, pgm_peer_t*const restrict);
+PGM_GNUC_INTERNAL void pgm_checkpoint_free (pgm_sock_t*const);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_CHECKPOINT_H__ */
@@ -38,6 +38,9 @@ uint16_t pgm_csum_fold (uint32_t) PGM_GNUC_CONST;
 uint32_t pgm_csum_block_add (uint32_t, uint32_t, const uint16_t) PGM_GNUC_CONST;
 uint32_t pgm_compat_csum_partial (const void*, uint16_t, uint32_t);
 uint32_t pgm_compat_csum_partial_copy (const void*restrict, void*restrict, uint16_t, uint32_t);
+uint32_t pgm_compat_csum_partial_copy_nt (const void*restrict, void*restrict, uint16_t, uint32_t);
+void pgm_memcpy_nt (void*restrict, const void*restrict, size_t);
+uint32_t pgm_crc32c (uint32_t, const void*, size_t) PGM_GNUC_PURE;
 
 static inline uint32_t add32_with_carry (uint32_t, uint32_t) PGM_GNUC_CONST;
 
@@ -71,6 +74,7 @@ static inline uint32_t add32_with_carry (uint32_t a, uint32_t b)
 
 #	define pgm_csum_partial            pgm_compat_csum_partial
 #	define pgm_csum_partial_copy       pgm_compat_csum_partial_copy
+#	define pgm_csum_partial_copy_nt    pgm_compat_csum_partial_copy_nt
 
 PGM_END_DECLS
 
@@ -0,0 +1,49 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * APDU compression, LZ4 block format.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if !defined (__PGM_IMPL_FRAMEWORK_H_INSIDE__) && !defined (PGM_COMPILATION)
+#       error "Only <framework.h> can be included directly."
+#endif
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_COMPRESS_H__
+#define __PGM_IMPL_COMPRESS_H__
+
+#include <pgm/types.h>
+
+#ifdef HAVE_LZ4_H
+#	define PGM_HAVE_LZ4
+#endif
+
+PGM_BEGIN_DECLS
+
+/* shorter APDUs are sent as is */
+#define PGM_COMPRESS_MIN_APDU		64
+
+PGM_GNUC_INTERNAL bool pgm_compress_is_available (void) PGM_GNUC_CONST;
+PGM_GNUC_INTERNAL size_t pgm_compress (const void*restrict, const size_t, void*restrict, const size_t, const int) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL bool pgm_decompress (const void*restrict, const size_t, void*restrict, const size_t) PGM_GNUC_WARN_UNUSED_RESULT;
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_COMPRESS_H__ */
@@ -45,6 +45,12 @@ struct pgm_cpu_t {
 	bool		has_sse42;
 	bool		has_avx;
 	bool		has_avx2;
+	bool		has_avx512f;
+	bool		has_avx512bw;
+	bool		has_gfni;
+	bool		has_neon;	/* ARM Advanced SIMD */
+	uint32_t	signature;	/* family, model and stepping */
+	uint32_t	tsc_khz;	/* reported by processor or hypervisor, 0 when unknown */
 };
 
 PGM_GNUC_INTERNAL void pgm_cpuid (pgm_cpu_t*);
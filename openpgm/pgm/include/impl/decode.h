@@ -0,0 +1,77 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Reed-Solomon reconstruction of receive transmission groups on a pool of
+ * worker threads.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_DECODE_H__
+#define __PGM_IMPL_DECODE_H__
+
+struct pgm_decode_pool_t;
+struct pgm_decode_job_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+PGM_BEGIN_DECLS
+
+/* upper bound of decoder threads of a socket */
+#define PGM_DECODE_THREADS_MAX		16
+
+/* transmission groups queued per decoder thread, further groups are decoded
+ * by the receiving thread.
+ */
+#define PGM_DECODE_QUEUE_MAX		64
+
+/* transmission groups of one receive window being decoded */
+#define PGM_DECODE_WINDOW_MAX		16
+
+/* one transmission group, blocks of the k original or reconstructed packets
+ * followed by the rs_h parity packets in use, as pgm_rs_decode_parity_appended().
+ * original and parity packets are referenced for the life of the job, the
+ * reconstructed packets are owned by it until inserted into the window.
+ */
+struct pgm_decode_job_t {
+	pgm_list_t		link_;			/* window queue, in submission order */
+	uint32_t		tg_sqn;
+	uint8_t			n, k;
+	uint8_t			rs_h;
+	uint16_t		parity_length;
+	bool			is_var_pktlen;
+	bool			is_op_encoded;
+	volatile uint32_t	is_done;		/* atomic, set once decoded */
+	volatile uint32_t*	ready;			/* shard count of completed jobs, optional */
+	uint8_t			offsets[PGM_RS_DEFAULT_N];
+	struct pgm_sk_buff_t*	skbs[PGM_RS_DEFAULT_N];
+	pgm_gf8_t*		data[PGM_RS_DEFAULT_N];
+	pgm_gf8_t*		opts[PGM_RS_DEFAULT_N];
+	struct pgm_opt_fragment	null_opt_fragment;	/* original data without a fragment header */
+};
+
+PGM_GNUC_INTERNAL struct pgm_decode_pool_t* pgm_decode_pool_create (pgm_sock_t*const, const unsigned) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_decode_pool_destroy (struct pgm_decode_pool_t*const);
+PGM_GNUC_INTERNAL void pgm_decode_pool_rearm (pgm_sock_t*const);
+PGM_GNUC_INTERNAL bool pgm_decode_pool_submit (struct pgm_decode_pool_t*const restrict, struct pgm_decode_job_t*const restrict, const uintptr_t) PGM_GNUC_WARN_UNUSED_RESULT;
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_DECODE_H__ */
@@ -0,0 +1,77 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * receive socket shared by PGM sockets, demultiplexed by port and GSI.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_DEMUX_H__
+#define __PGM_IMPL_DEMUX_H__
+
+struct pgm_demux_t;
+struct pgm_demux_member_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+PGM_BEGIN_DECLS
+
+/* upper bound of packets waiting for a sharing socket to read them */
+#define PGM_DEMUX_QUEUE_MAX		4096
+
+/* one bound receive socket per protocol, port and address */
+struct pgm_demux_t {
+	SOCKET				recv_sock;
+	int				protocol;
+	uint16_t			udp_encap_mcast_port;
+	struct sockaddr_storage		addr;
+	pgm_slist_t*			members;	/* under pgm_sock_list_lock */
+};
+
+/* attachment of one PGM socket, packets read by other members for this
+ * socket wait on the queue.
+ */
+struct pgm_demux_member_t {
+	struct pgm_demux_t*		demux;
+	pgm_sock_t*			sock;
+	pgm_mutex_t			mutex;
+	pgm_queue_t			queue;		/* struct pgm_demux_packet_t */
+};
+
+static inline
+bool
+pgm_demux_is_pending (
+	const pgm_sock_t* const	sock
+	)
+{
+	return NULL != sock->demux && !pgm_queue_is_empty (&sock->demux->queue);
+}
+
+PGM_GNUC_INTERNAL bool pgm_demux_attach (pgm_sock_t*const restrict, const struct sockaddr*const restrict);
+PGM_GNUC_INTERNAL void pgm_demux_create (pgm_sock_t*const restrict, const struct sockaddr*const restrict);
+PGM_GNUC_INTERNAL void pgm_demux_detach (pgm_sock_t*const);
+PGM_GNUC_INTERNAL bool pgm_demux_is_shared (pgm_sock_t*const);
+PGM_GNUC_INTERNAL bool pgm_demux_dispatch (pgm_sock_t*const restrict, struct pgm_rx_shard_t*const restrict, const struct sockaddr*const restrict, const struct sockaddr*const restrict);
+PGM_GNUC_INTERNAL bool pgm_demux_pop (pgm_sock_t*const restrict, struct pgm_rx_shard_t*const restrict, struct sockaddr*const restrict, struct sockaddr*const restrict);
+PGM_GNUC_INTERNAL void pgm_demux_rearm (pgm_sock_t*const);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_DEMUX_H__ */
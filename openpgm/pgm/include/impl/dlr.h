@@ -0,0 +1,46 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Designated Local Repairer (DLR), RFC 3208 section 12.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_DLR_H__
+#define __PGM_IMPL_DLR_H__
+
+struct pgm_dlr_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+#include <impl/receiver.h>
+
+PGM_BEGIN_DECLS
+
+/* upper bound of PGM_DLR sequence numbers cached per source */
+#define PGM_DLR_SQNS_MAX	65536
+
+PGM_GNUC_INTERNAL void pgm_dlr_cache (pgm_sock_t*const restrict, pgm_peer_t*const restrict, const struct pgm_sk_buff_t*const restrict);
+PGM_GNUC_INTERNAL void pgm_dlr_destroy (struct pgm_dlr_t*const);
+PGM_GNUC_INTERNAL bool pgm_on_dlr_nak (pgm_sock_t*const restrict, pgm_peer_t*const restrict, const struct sockaddr*const restrict, struct pgm_sk_buff_t*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL bool pgm_dlr_send_polr (pgm_sock_t*const restrict, pgm_peer_t*const restrict, const uint32_t, const uint16_t);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_DLR_H__ */
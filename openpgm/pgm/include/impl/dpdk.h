@@ -0,0 +1,109 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * DPDK poll-mode driver packet I/O.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_DPDK_H__
+#define __PGM_IMPL_DPDK_H__
+
+struct pgm_dpdk_t;
+struct pgm_dpdk_port_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+#ifdef HAVE_RTE_ETHDEV_H
+#	include <rte_ethdev.h>
+#	include <rte_mbuf.h>
+#	define PGM_HAVE_DPDK
+#endif
+
+PGM_BEGIN_DECLS
+
+/* mbufs per receive and transmit burst */
+#define PGM_DPDK_BURST			32
+/* transmit mbufs of each port queue */
+#define PGM_DPDK_POOL_SIZE		8191
+
+#ifdef PGM_HAVE_DPDK
+/* one ethdev receive and transmit queue pair, shared by every socket
+ * attached to it and polled by whichever socket reads first.
+ */
+struct pgm_dpdk_port_t {
+	uint16_t			port_id;
+	uint16_t			queue_id;
+	unsigned			ref_count;	/* under pgm_sock_list_lock */
+	pgm_slist_t*			members;	/* under pgm_sock_list_lock */
+	uint8_t				hwaddr[6];
+	struct in_addr			src_addr;	/* IGMP source, first member address */
+	struct rte_mempool*		tx_pool;
+	pgm_skb_pool_t*			skb_pool;	/* owner of mbuf backed skbs */
+	pgm_spinlock_t			rx_lock;
+	struct rte_mbuf*		rx_burst[ PGM_DPDK_BURST ];
+	unsigned			rx_head;
+	unsigned			rx_len;
+	pgm_spinlock_t			tx_lock;
+	uint16_t			ip_id;
+	struct in_addr*			groups;		/* union of member groups, under tx_lock */
+	unsigned			groups_len;
+};
+
+/* attachment of one PGM socket, packets polled by other members for this
+ * socket wait on the queue.
+ */
+struct pgm_dpdk_t {
+	struct pgm_dpdk_port_t*		port;
+	pgm_sock_t*			sock;
+	struct sockaddr_in		src_addr;	/* bound send address */
+	pgm_mutex_t			mutex;
+	pgm_queue_t			queue;		/* struct pgm_dpdk_packet_t */
+	struct in_addr*			groups;		/* joined IPv4 groups, under port tx_lock */
+	unsigned			groups_len;
+};
+
+static inline
+bool
+pgm_dpdk_can_sendto (
+	const pgm_sock_t*      const restrict sock,
+	const struct sockaddr* const restrict to
+	)
+{
+/* unicast destinations require neighbour resolution by the kernel */
+	return (NULL != sock->dpdk &&
+		AF_INET == to->sa_family &&
+		IN_MULTICAST (ntohl (((const struct sockaddr_in*)to)->sin_addr.s_addr)));
+}
+
+PGM_GNUC_INTERNAL ssize_t pgm_dpdk_recvskb (pgm_sock_t*const restrict, struct pgm_rx_shard_t*const restrict, struct sockaddr*const restrict, const socklen_t, struct sockaddr*const restrict, const socklen_t);
+PGM_GNUC_INTERNAL int pgm_dpdk_sendv (pgm_sock_t*const restrict, const bool, const int, const struct pgm_iovec*const restrict, const unsigned, const struct sockaddr*const restrict);
+PGM_GNUC_INTERNAL int pgm_dpdk_wait (pgm_sock_t*const, const int);
+PGM_GNUC_INTERNAL bool pgm_dpdk_is_pending (const pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_dpdk_rearm (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_dpdk_update_groups (pgm_sock_t*const);
+#endif /* PGM_HAVE_DPDK */
+
+PGM_GNUC_INTERNAL bool pgm_dpdk_open (pgm_sock_t*const restrict, pgm_error_t**restrict);
+PGM_GNUC_INTERNAL void pgm_dpdk_close (pgm_sock_t*const);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_DPDK_H__ */
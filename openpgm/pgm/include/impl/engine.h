@@ -37,10 +37,18 @@ PGM_BEGIN_DECLS
 extern LPFN_WSARECVMSG pgm_WSARecvMsg;
 #endif
 
-#ifdef PGM_DEBUG
+/* simulated receive loss, always present in debug builds */
+#if defined( PGM_DEBUG ) && !defined( PGM_LOSS_INJECTION )
+#	define PGM_LOSS_INJECTION
+#endif
+
+#ifdef PGM_LOSS_INJECTION
 extern unsigned pgm_loss_rate;
+extern unsigned pgm_loss_burst;
 #endif
 
+PGM_GNUC_INTERNAL void pgm_engine_timer_wake (const pgm_time_t);
+
 PGM_END_DECLS
 
 #endif /* __PGM_IMPL_ENGINE_H__ */
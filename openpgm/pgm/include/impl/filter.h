@@ -0,0 +1,46 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * kernel socket filter of the packets of one PGM session.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_FILTER_H__
+#define __PGM_IMPL_FILTER_H__
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+#ifdef HAVE_LINUX_FILTER_H
+#	include <linux/filter.h>
+#	if defined(SO_ATTACH_FILTER) && defined(SKF_NET_OFF)
+#		define PGM_HAVE_SESSION_FILTER
+#	endif
+#endif
+
+PGM_BEGIN_DECLS
+
+PGM_GNUC_INTERNAL void pgm_filter_update (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_filter_block_source (pgm_sock_t*const restrict, const struct sockaddr*const restrict);
+PGM_GNUC_INTERNAL void pgm_filter_unblock_source (pgm_sock_t*const restrict, const struct sockaddr*const restrict);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_FILTER_H__ */
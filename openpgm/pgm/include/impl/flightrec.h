@@ -0,0 +1,104 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Flight recorder, a fixed ring of recent protocol events per socket kept for
+ * post-mortem analysis of resets.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_FLIGHTREC_H__
+#define __PGM_IMPL_FLIGHTREC_H__
+
+typedef struct pgm_flightrec_event_t pgm_flightrec_event_t;
+typedef struct pgm_flightrec_t pgm_flightrec_t;
+
+#include <impl/framework.h>
+
+PGM_BEGIN_DECLS
+
+/* events per socket by default, rounded up to a power of two */
+#define PGM_FLIGHTREC_DEFAULT_LEN	1024
+
+enum
+{
+	PGM_FLIGHTREC_RECEIVE = 0,	/* type = PGM packet type, arg = length */
+	PGM_FLIGHTREC_NAK_SEND,		/* type = PGM_OPT_PARITY for parity, arg = sequences */
+	PGM_FLIGHTREC_NCF_SEND,		/* type = PGM_OPT_PARITY for parity, arg = sequences */
+	PGM_FLIGHTREC_RDATA_SEND,	/* arg = length */
+	PGM_FLIGHTREC_GAP_STATE,	/* type = receive window packet state, arg = sequences */
+	PGM_FLIGHTREC_RESET,		/* sequence = sequences lost */
+	PGM_FLIGHTREC_EVENT_MAX
+};
+
+struct pgm_flightrec_event_t {
+	pgm_time_t		tstamp;
+	uint32_t		sequence;
+	uint32_t		arg;
+	uint16_t		sport;			/* of the source TSI */
+	uint8_t			event;
+	uint8_t			type;
+};
+
+/* any thread records with one atomic increment, a reader copies events
+ * without locking and may see some overwritten in the meantime.
+ */
+struct pgm_flightrec_t {
+	volatile uint32_t	head;			/* events recorded, free running */
+	uint32_t		mask;			/* len - 1 */
+	pgm_flightrec_event_t	events[];
+};
+
+PGM_GNUC_INTERNAL pgm_flightrec_t* pgm_flightrec_create (const unsigned) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_flightrec_destroy (pgm_flightrec_t*);
+PGM_GNUC_INTERNAL unsigned pgm_flightrec_copy (const pgm_flightrec_t*const restrict, pgm_flightrec_event_t*restrict, const unsigned);
+PGM_GNUC_INTERNAL void pgm_flightrec_write_html (const pgm_flightrec_t*const restrict, pgm_string_t*restrict);
+PGM_GNUC_INTERNAL void pgm_flightrec_log (const pgm_flightrec_t*const);
+
+/* record one event, the clock is the coarse reading of the thread where
+ * enabled.  no-op without a recorder.
+ */
+
+static inline
+void
+pgm_flightrec_add (
+	pgm_flightrec_t* const	fr,
+	const unsigned		event,
+	const unsigned		type,
+	const uint16_t		sport,
+	const uint32_t		sequence,
+	const uint32_t		arg
+	)
+{
+	if (NULL == fr)
+		return;
+	pgm_flightrec_event_t* e = &fr->events[ pgm_atomic_exchange_and_add32 (&fr->head, 1) & fr->mask ];
+	e->tstamp	= pgm_time_coarse_now();
+	e->sequence	= sequence;
+	e->arg		= arg;
+	e->sport	= sport;
+	e->event	= (uint8_t)event;
+	e->type		= (uint8_t)type;
+}
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_FLIGHTREC_H__ */
+
+/* eof */
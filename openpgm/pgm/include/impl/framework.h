@@ -44,6 +44,7 @@
 
 #include <impl/byteorder.h>
 #include <impl/checksum.h>
+#include <impl/compress.h>
 #include <impl/cpu.h>
 #include <impl/endian.h>
 #include <impl/errno.h>
@@ -56,28 +57,36 @@
 #include <impl/getprotobyname.h>
 #include <impl/hashtable.h>
 #include <impl/histogram.h>
+#include <impl/if.h>
 #include <impl/indextoaddr.h>
 #include <impl/indextoname.h>
 #include <impl/inet_network.h>
 #include <impl/ip.h>
+#include <impl/latency.h>
 #include <impl/list.h>
+#include <impl/logring.h>
 #include <impl/math.h>
 #include <impl/md5.h>
 #include <impl/messages.h>
 #include <impl/nametoindex.h>
 #include <impl/notify.h>
+#include <impl/numa.h>
+#include <impl/peer_table.h>
+#include <impl/probe.h>
 #include <impl/processor.h>
 #include <impl/queue.h>
 #include <impl/rand.h>
 #include <impl/rate_control.h>
 #include <impl/reed_solomon.h>
 #include <impl/security.h>
+#include <impl/skbuff.h>
 #include <impl/slist.h>
 #include <impl/sn.h>
 #include <impl/sockaddr.h>
 #include <impl/string.h>
 #include <impl/thread.h>
 #include <impl/time.h>
+#include <impl/trace_event.h>
 #include <impl/tsi.h>
 #include <impl/wsastrerror.h>
 
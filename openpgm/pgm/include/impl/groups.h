@@ -0,0 +1,49 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * multicast group membership of a socket.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_GROUPS_H__
+#define __PGM_IMPL_GROUPS_H__
+
+struct pgm_group_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+PGM_BEGIN_DECLS
+
+/* one distinct joined group with the number of group/source entries on it */
+struct pgm_group_t {
+	struct sockaddr_storage		group;
+	unsigned			ref_count;
+};
+
+PGM_GNUC_INTERNAL bool pgm_groups_is_joined (const pgm_sock_t*const restrict, const struct group_source_req*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL bool pgm_groups_is_member (const pgm_sock_t*const restrict, const struct sockaddr*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_groups_add (pgm_sock_t*const restrict, const struct group_source_req*const restrict);
+PGM_GNUC_INTERNAL unsigned pgm_groups_remove (pgm_sock_t*const restrict, const struct group_source_req*const restrict, const bool);
+PGM_GNUC_INTERNAL void pgm_groups_destroy (pgm_sock_t*const);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_GROUPS_H__ */
@@ -31,5 +31,7 @@
 #else
 #	define _(String) (String)
 #endif
+/* marked for translation where used */
+#define N_(String) (String)
 
 #endif /* __PGM_IMPL_I18N_H__ */
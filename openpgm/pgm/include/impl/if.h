@@ -0,0 +1,47 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * Process-wide cache of network specification resolution.
+ *
+ * Copyright (c) 2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if !defined (__PGM_IMPL_FRAMEWORK_H_INSIDE__) && !defined (PGM_COMPILATION)
+#	error "Only <framework.h> can be included directly."
+#endif
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_IF_H__
+#define __PGM_IMPL_IF_H__
+
+#include <pgm/types.h>
+
+PGM_BEGIN_DECLS
+
+/* distinct network specifications held by the resolution cache */
+#define PGM_IF_CACHE_MAX		64
+
+/* lifetime of a cached resolution, interface changes flush sooner where notified */
+#define PGM_IF_CACHE_TTL		pgm_secs(30)
+
+PGM_GNUC_INTERNAL void pgm_if_cache_init (void);
+PGM_GNUC_INTERNAL void pgm_if_cache_shutdown (void);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_IF_H__ */
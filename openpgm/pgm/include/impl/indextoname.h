@@ -34,6 +34,7 @@
 PGM_BEGIN_DECLS
 
 PGM_GNUC_INTERNAL char* pgm_if_indextoname (unsigned, char*);
+PGM_GNUC_INTERNAL unsigned pgm_if_indextomtu (unsigned);
 
 PGM_END_DECLS
 
@@ -0,0 +1,144 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * Per-thread latency histograms of internal processing stages.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if !defined (__PGM_IMPL_FRAMEWORK_H_INSIDE__) && !defined (PGM_COMPILATION)
+#	error "Only <framework.h> can be included directly."
+#endif
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_LATENCY_H__
+#define __PGM_IMPL_LATENCY_H__
+
+typedef struct pgm_latency_stage_t pgm_latency_stage_t;
+typedef struct pgm_latency_t pgm_latency_t;
+
+#include <pgm/types.h>
+#include <pgm/time.h>
+#include <impl/slist.h>
+#include <impl/string.h>
+#include <impl/time.h>
+
+PGM_BEGIN_DECLS
+
+enum
+{
+	PGM_LATENCY_RX_INSERT = 0,	/* packet receipt to receive window insert */
+	PGM_LATENCY_RX_DELIVER,		/* receive window insert to application delivery */
+	PGM_LATENCY_NAK_RDATA,		/* first NAK to repair data */
+	PGM_LATENCY_TX_WIRE,		/* send call to return of the socket send */
+	PGM_LATENCY_STAGE_MAX
+};
+
+/* log-linear buckets: values below 2^SUB_BITS are exact, above that each
+ * power of two is split into 2^SUB_BITS linear buckets bounding the relative
+ * error to 1/2^SUB_BITS, values of 2^MAX_BITS or more share the last bucket.
+ */
+#define PGM_LATENCY_SUB_BITS		4
+#define PGM_LATENCY_SUB_BUCKETS		(1u << PGM_LATENCY_SUB_BITS)
+#define PGM_LATENCY_MAX_BITS		36		/* μs, ~19 hours */
+#define PGM_LATENCY_BUCKETS		((PGM_LATENCY_MAX_BITS - PGM_LATENCY_SUB_BITS + 1) << PGM_LATENCY_SUB_BITS)
+
+struct pgm_latency_stage_t {
+	uint64_t	count;
+	uint64_t	sum;
+	uint64_t	max;
+	uint64_t	buckets[PGM_LATENCY_BUCKETS];
+};
+
+/* written only by the owning thread, read without locking when merged.  the
+ * counters are padded apart from neighbouring allocations of other threads.
+ */
+#define PGM_LATENCY_PAD			64
+
+struct pgm_latency_t {
+	char			head_pad[PGM_LATENCY_PAD];
+	pgm_latency_stage_t	stages[PGM_LATENCY_STAGE_MAX];
+	pgm_slist_t		link;
+	char			tail_pad[PGM_LATENCY_PAD];
+};
+
+extern uint32_t					pgm_latency_generation;
+extern PGM_THREAD_LOCAL pgm_latency_t*		pgm_latency_local;
+extern PGM_THREAD_LOCAL uint32_t		pgm_latency_local_generation;
+
+PGM_GNUC_INTERNAL void pgm_latency_init (void);
+PGM_GNUC_INTERNAL void pgm_latency_shutdown (void);
+PGM_GNUC_INTERNAL pgm_latency_t* pgm_latency_attach (void);
+bool pgm_latency_snapshot (const unsigned, pgm_latency_stage_t*);
+uint64_t pgm_latency_percentile (const pgm_latency_stage_t*, const double) PGM_GNUC_PURE;
+void pgm_latency_write_html_all (pgm_string_t*);
+
+static inline
+unsigned
+pgm_latency_bucket (
+	const uint64_t		value
+	)
+{
+	unsigned msb;
+
+	if (value < PGM_LATENCY_SUB_BUCKETS)
+		return (unsigned)value;
+	if (value >> PGM_LATENCY_MAX_BITS)
+		return PGM_LATENCY_BUCKETS - 1;
+#if defined(__GNUC__)
+	msb = 63 - __builtin_clzll (value);
+#else
+	msb = PGM_LATENCY_SUB_BITS;
+	while (value >> (msb + 1))
+		msb++;
+#endif
+	return ((msb - PGM_LATENCY_SUB_BITS + 1) << PGM_LATENCY_SUB_BITS) +
+		(unsigned)(value >> (msb - PGM_LATENCY_SUB_BITS)) - PGM_LATENCY_SUB_BUCKETS;
+}
+
+/* add the time from since to now to stage of the calling thread's histograms.
+ */
+
+static inline
+void
+pgm_latency_record (
+	const unsigned		stage,
+	const pgm_time_t	since,
+	const pgm_time_t	now
+	)
+{
+	pgm_latency_t* latency = pgm_latency_local;
+
+	if (PGM_UNLIKELY(NULL == latency || pgm_latency_local_generation != pgm_latency_generation) &&
+	    NULL == (latency = pgm_latency_attach()))
+		return;
+
+	pgm_latency_stage_t* s = &latency->stages[ stage ];
+	const uint64_t elapsed = pgm_time_after (now, since) ? now - since : 0;
+	s->count++;
+	s->sum += elapsed;
+	if (elapsed > s->max)
+		s->max = elapsed;
+	s->buckets[ pgm_latency_bucket (elapsed) ]++;
+}
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_LATENCY_H__ */
+
+/* eof */
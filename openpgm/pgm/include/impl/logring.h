@@ -0,0 +1,94 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * Asynchronous logging: binary log events recorded into per-thread rings
+ * and formatted on a background thread.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if !defined (__PGM_IMPL_FRAMEWORK_H_INSIDE__) && !defined (PGM_COMPILATION)
+#	error "Only <framework.h> can be included directly."
+#endif
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_LOGRING_H__
+#define __PGM_IMPL_LOGRING_H__
+
+typedef struct pgm_logring_record_t pgm_logring_record_t;
+typedef struct pgm_logring_t pgm_logring_t;
+
+#include <stdarg.h>
+#include <pgm/types.h>
+#include <pgm/error.h>
+#include <impl/processor.h>
+#include <impl/slist.h>
+
+PGM_BEGIN_DECLS
+
+#define PGM_LOGRING_LEN			256		/* records per thread, power of two */
+#define PGM_LOGRING_ARGS		8		/* arguments per record */
+#define PGM_LOGRING_DATA		320		/* bytes of copied strings per record */
+#define PGM_LOGRING_INTERVAL		10		/* ms between drains */
+
+/* arguments are stored as read from the va_list, the format string is kept
+ * by reference and must be static, %s arguments are copied into data.
+ */
+union pgm_logring_arg_t {
+	intmax_t		i;
+	uintmax_t		u;
+	double			d;
+	long double		ld;
+	const void*		p;
+	size_t			offset;		/* into data */
+};
+
+struct pgm_logring_record_t {
+	int			log_level;
+	unsigned		count;
+	const char*		format;
+	union pgm_logring_arg_t	args[PGM_LOGRING_ARGS];
+	char			data[PGM_LOGRING_DATA];
+};
+
+/* single producer, the owning thread, and single consumer, the logging
+ * thread.  head and tail are each written by one side only.
+ */
+struct pgm_logring_t {
+	char			head_pad[PGM_CACHELINE_PAD];
+	volatile uint32_t	head;
+	char			tail_pad[PGM_CACHELINE_PAD - sizeof(uint32_t)];
+	volatile uint32_t	tail;
+	volatile uint32_t	dropped;	/* records lost to a full ring */
+	uint32_t		reported;	/* consumer copy of dropped */
+	pgm_slist_t		link;
+	pgm_logring_record_t	records[PGM_LOGRING_LEN];
+};
+
+extern bool					pgm_log_async;
+
+PGM_GNUC_INTERNAL bool pgm_logring_init (pgm_error_t**) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL bool pgm_logring_shutdown (void);
+PGM_GNUC_INTERNAL bool pgm_logring_push (const int, const char*, va_list);
+PGM_GNUC_INTERNAL void pgm_logring_flush (void);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_LOGRING_H__ */
+
+/* eof */
@@ -0,0 +1,85 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * in-process packet bus in place of the network.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_LOOP_H__
+#define __PGM_IMPL_LOOP_H__
+
+struct pgm_loop_t;
+struct pgm_loop_member_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+PGM_BEGIN_DECLS
+
+/* upper bound of packets waiting for a member to read them, further packets
+ * are dropped as on a full socket buffer.
+ */
+#define PGM_LOOP_QUEUE_MAX		4096
+
+/* named bus of the process, every packet sent by a member is delivered to
+ * all other members.
+ */
+struct pgm_loop_t {
+	char*				name;
+	pgm_slist_t*			members;	/* under pgm_sock_list_lock */
+};
+
+/* attachment of one PGM socket */
+struct pgm_loop_member_t {
+	struct pgm_loop_t*		loop;
+	pgm_sock_t*			sock;
+	pgm_mutex_t			mutex;
+	pgm_queue_t			queue;		/* struct pgm_loop_packet_t */
+	uint64_t			packets;	/* read by the socket */
+	uint64_t			overruns;	/* dropped on a full queue */
+
+/* channel model of packets sent by the socket */
+	pgm_mutex_t			tx_mutex;
+	uint32_t			loss_rate;	/* parts per million */
+	uint32_t			reorder_rate;	/* parts per million */
+	pgm_rand_t			rand_;
+	struct pgm_loop_packet_t*	held;		/* delivered behind the next packet */
+	uint64_t			losses;
+	uint64_t			reorders;
+};
+
+static inline
+bool
+pgm_loop_is_pending (
+	const pgm_sock_t* const	sock
+	)
+{
+	return NULL != sock->loop && !pgm_queue_is_empty (&sock->loop->queue);
+}
+
+PGM_GNUC_INTERNAL bool pgm_loop_open (pgm_sock_t*const restrict, pgm_error_t**restrict);
+PGM_GNUC_INTERNAL void pgm_loop_close (pgm_sock_t*const);
+PGM_GNUC_INTERNAL ssize_t pgm_loop_sendto (pgm_sock_t*const restrict, const void*restrict, const size_t, const struct sockaddr*const restrict);
+PGM_GNUC_INTERNAL ssize_t pgm_loop_recvskb (pgm_sock_t*const restrict, struct pgm_sk_buff_t*const restrict, struct sockaddr*const restrict, const socklen_t, struct sockaddr*const restrict, const socklen_t);
+PGM_GNUC_INTERNAL void pgm_loop_rearm (pgm_sock_t*const);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_LOOP_H__ */
@@ -30,6 +30,9 @@
 #define __PGM_IMPL_MATH_H__
 
 #include <pgm/types.h>
+#ifdef _MSC_VER
+#	include <intrin.h>
+#endif
 
 PGM_BEGIN_DECLS
 
@@ -72,6 +75,48 @@ pgm_nearest_power (
 	return b;
 }
 
+/* population count and count of trailing zero bits of a 32-bit word, n must
+ * be non-zero for the latter.
+ */
+
+static inline unsigned pgm_popcount32 (uint32_t) PGM_GNUC_CONST;
+static inline unsigned pgm_ctz32 (uint32_t) PGM_GNUC_CONST;
+
+static inline
+unsigned
+pgm_popcount32 (
+	uint32_t	n
+	)
+{
+#if (__GNUC__ > 3) || (__GNUC__ == 3 && __GNUC_MINOR__ >= 4)
+	return __builtin_popcount (n);
+#elif defined(_MSC_VER)
+	return __popcnt (n);
+#else
+/* MIT HAKMEM 169 */
+	const uint32_t t = n - ((n >> 1) & 033333333333)
+			     - ((n >> 2) & 011111111111);
+	return ((t + (t >> 3) & 030707070707)) % 63;
+#endif
+}
+
+static inline
+unsigned
+pgm_ctz32 (
+	uint32_t	n
+	)
+{
+#if (__GNUC__ > 3) || (__GNUC__ == 3 && __GNUC_MINOR__ >= 4)
+	return __builtin_ctz (n);
+#elif defined(_MSC_VER)
+	unsigned long r;
+	_BitScanForward (&r, n);
+	return (unsigned)r;
+#else
+	return pgm_popcount32 ((n & -n) - 1);
+#endif
+}
+
 unsigned pgm_spaced_primes_closest (unsigned) PGM_GNUC_PURE;
 
 PGM_END_DECLS
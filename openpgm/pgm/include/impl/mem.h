@@ -25,12 +25,100 @@
 #ifndef __PGM_IMPL_MEM_H__
 #define __PGM_IMPL_MEM_H__
 
+typedef struct pgm_mem_region_t pgm_mem_region_t;
+typedef struct pgm_mem_budget_t pgm_mem_budget_t;
+typedef struct pgm_mem_slab_t pgm_mem_slab_t;
+
 #include <pgm/types.h>
+#include <pgm/atomic.h>
+#include <impl/thread.h>
 
 PGM_BEGIN_DECLS
 
+/* explicit huge page sizes */
+#define PGM_HUGEPAGE_2MB	(2 * 1024 * 1024)
+#define PGM_HUGEPAGE_1GB	(1024 * 1024 * 1024)
+
+/* smallest page size of supported platforms, prefault touches one byte per stride */
+#define PGM_PREFAULT_STRIDE	4096
+
+/* anonymous mapping, optionally on huge pages, prefaulted and locked */
+struct pgm_mem_region_t {
+	void*		addr;
+	size_t		len;			/* mapped bytes, whole pages */
+	size_t		locked;			/* bytes pinned by mlock() */
+	size_t		page_size;		/* huge page size, 0 for regular pages */
+};
+
+/* packet buffer bytes held by windows, charged against a limit and every
+ * enclosing budget.  a socket budget nests in the process-wide budget.
+ */
+struct pgm_mem_budget_t {
+	volatile uint64_t	used;			/* in bytes */
+	uint64_t		max;			/* in bytes, 0 = unlimited */
+	pgm_mem_budget_t*	parent;
+};
+
+/* slab size classes, powers of two from 64 bytes to 2 MiB, larger blocks
+ * are taken from the heap.  blocks up to a quarter chunk are carved from
+ * shared chunks.
+ */
+#define PGM_MEM_SLAB_MIN_SHIFT	6
+#define PGM_MEM_SLAB_CLASSES	16
+#define PGM_MEM_SLAB_CHUNK	(64 * 1024)
+
+/* blocks of related objects with one owner, released blocks wait on the free
+ * list of their size class for the next allocation and memory returns to
+ * the heap only with the slab.  objects of churning owners then reuse the
+ * same pages instead of fragmenting the heap.
+ */
+struct pgm_mem_slab_t {
+	pgm_spinlock_t		lock;
+	void*			free_list[ PGM_MEM_SLAB_CLASSES ];
+	void*			chunks;			/* heap allocations, freed with the slab */
+	char*			cursor;			/* uncarved tail of the newest chunk */
+	size_t			remaining;
+	size_t			len;			/* bytes held from the heap */
+	size_t			used;			/* bytes of blocks in use */
+};
+
+extern pgm_mem_budget_t pgm_mem_global_budget;
+
+static inline
+void
+pgm_mem_budget_charge (
+	pgm_mem_budget_t*	budget,
+	const int64_t		delta
+	)
+{
+	for (; NULL != budget; budget = budget->parent)
+		pgm_atomic_add64 (&budget->used, (uint64_t)delta);
+}
+
+/* returns TRUE if this or any enclosing budget is over its limit.
+ */
+
+static inline
+bool
+pgm_mem_budget_is_exceeded (
+	const pgm_mem_budget_t*	budget
+	)
+{
+	for (; NULL != budget; budget = budget->parent)
+		if (budget->max && pgm_atomic_read64 (&budget->used) > budget->max)
+			return TRUE;
+	return FALSE;
+}
+
 PGM_GNUC_INTERNAL void pgm_mem_init (void);
 PGM_GNUC_INTERNAL void pgm_mem_shutdown (void);
+PGM_GNUC_INTERNAL void pgm_mem_region_map (pgm_mem_region_t*const, const size_t, const size_t, const bool, const int);
+PGM_GNUC_INTERNAL void pgm_mem_region_unmap (pgm_mem_region_t*const);
+PGM_GNUC_INTERNAL size_t pgm_mem_prefault (void*const, const size_t);
+PGM_GNUC_INTERNAL pgm_mem_slab_t* pgm_mem_slab_new (void) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_mem_slab_destroy (pgm_mem_slab_t*const);
+PGM_GNUC_INTERNAL void* pgm_mem_slab_alloc0 (pgm_mem_slab_t*const, const size_t) PGM_GNUC_MALLOC PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_mem_slab_free (pgm_mem_slab_t*const, void*const, const size_t);
 
 PGM_END_DECLS
 
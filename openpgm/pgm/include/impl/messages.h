@@ -44,6 +44,7 @@ PGM_BEGIN_DECLS
 
 PGM_GNUC_INTERNAL void pgm__log  (const int, const char*, ...) PGM_GNUC_PRINTF (2, 3);
 PGM_GNUC_INTERNAL void pgm__logv (const int, const char*, va_list) PGM_GNUC_PRINTF (2, 0);
+PGM_GNUC_INTERNAL void pgm__log_text (const int, const char*);
 
 #if defined( HAVE_ISO_VARARGS )
 
@@ -58,11 +59,16 @@ PGM_GNUC_INTERNAL void pgm__logv (const int, const char*, va_list) PGM_GNUC_PRIN
 #		define pgm_debug(...)	while (0)
 #	endif /* !PGM_DEBUG */
 
-#	define pgm_trace(r,...) \
+/* trace level removed entirely when built with PGM_DISABLE_TRACE */
+#	ifndef PGM_DISABLE_TRACE
+#		define pgm_trace(r,...) \
 			do { \
 				if (pgm_min_log_level <= PGM_LOG_LEVEL_TRACE && pgm_log_mask & (r)) \
 					pgm__log (PGM_LOG_LEVEL_TRACE, __VA_ARGS__); \
 			} while (0)
+#	else
+#		define pgm_trace(r,...)	while (0)
+#	endif /* !PGM_DISABLE_TRACE */
 #	define pgm_minor(...) \
 			do { \
 				if (pgm_min_log_level <= PGM_LOG_LEVEL_MINOR) \
@@ -100,8 +106,12 @@ PGM_GNUC_INTERNAL void pgm__logv (const int, const char*, va_list) PGM_GNUC_PRIN
 #		define pgm_debug(f...)	while (0)
 #	endif /* !PGM_DEBUG */
 
-#	define pgm_trace(r,f...)	if (pgm_min_log_level <= PGM_LOG_LEVEL_TRACE && pgm_log_mask & (r)) \
-					pgm__log (PGM_LOG_LEVEL_TRACE, f)
+#	ifndef PGM_DISABLE_TRACE
+#		define pgm_trace(r,f...)	if (pgm_min_log_level <= PGM_LOG_LEVEL_TRACE && pgm_log_mask & (r)) \
+						pgm__log (PGM_LOG_LEVEL_TRACE, f)
+#	else
+#		define pgm_trace(r,f...)	while (0)
+#	endif /* !PGM_DISABLE_TRACE */
 #	define pgm_minor(f...)		if (pgm_min_log_level <= PGM_LOG_LEVEL_MINOR) pgm__log (PGM_LOG_LEVEL_MINOR, f)
 #	define pgm_info(f...)		if (pgm_min_log_level <= PGM_LOG_LEVEL_NORMAL) pgm__log (PGM_LOG_LEVEL_NORMAL, f)
 #	define pgm_warn(f...)		if (pgm_min_log_level <= PGM_LOG_LEVEL_WARNING) pgm__log (PGM_LOG_LEVEL_WARNING, f)
@@ -129,12 +139,14 @@ static inline void pgm_debug (const char* format, ...) {
 }
 
 static inline void pgm_trace (const int role, const char* format, ...) {
+#ifndef PGM_DISABLE_TRACE
 	if (PGM_LOG_LEVEL_TRACE >= pgm_min_log_level && pgm_log_mask & role) {
 		va_list args;
 		va_start (args, format);
 		pgm__logv (PGM_LOG_LEVEL_TRACE, format, args);
 		va_end (args);
 	}
+#endif
 }
 
 static inline void pgm_minor (const char* format, ...) {
@@ -30,10 +30,69 @@
 #endif
 #include <impl/framework.h>
 
+struct pgm_rx_shard_t;
+
 PGM_BEGIN_DECLS
 
+/* packets held by reference pending MSG_ZEROCOPY completion */
+#define PGM_ZEROCOPY_MAX	1024
+
+/* arrival time stamps in receive control messages */
+#if defined( SO_TIMESTAMPNS ) && defined( SCM_TIMESTAMPNS )
+#	include <time.h>
+#	define PGM_HAVE_RX_TIMESTAMP
+#endif
+
+/* kernel receive queue drop counter in receive control messages */
+#if defined( SO_RXQ_OVFL )
+#	define PGM_HAVE_RXQ_OVFL
+#endif
+
+/* receive auto-tuning sample interval and defaults */
+#define PGM_RX_TUNE_IVL			pgm_secs(1)
+#define PGM_RX_TUNE_RCVBUF_MIN		(128 * 1024)
+#define PGM_RX_TUNE_RXW_MIN_SQNS	1024
+#define PGM_RX_TUNE_RXW_SECS		10
+
 PGM_GNUC_INTERNAL ssize_t pgm_sendto_hops (pgm_sock_t*restrict, bool, pgm_rate_t*restrict, bool, int, const void*restrict, size_t, const struct sockaddr*restrict, socklen_t);
+PGM_GNUC_INTERNAL int pgm_sendmmsg (pgm_sock_t*restrict, bool, pgm_rate_t*restrict, bool, struct pgm_sk_buff_t*const*restrict, unsigned, const struct sockaddr*restrict, socklen_t);
+PGM_GNUC_INTERNAL int pgm_sendmmsg_to (pgm_sock_t*restrict, bool, const struct pgm_iovec*restrict, const struct sockaddr*const*restrict, unsigned);
 PGM_GNUC_INTERNAL int pgm_set_nonblocking (SOCKET fd[2]);
+PGM_GNUC_INTERNAL void pgm_txtime_create (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_zerocopy_create (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_rx_timestamp_create (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_rx_tune_create (pgm_sock_t*const);
+PGM_GNUC_INTERNAL bool pgm_rx_tune_rcvbuf (pgm_sock_t*const restrict, const struct pgm_rx_shard_t*const restrict, const size_t);
+#ifdef PGM_HAVE_RXQ_OVFL
+PGM_GNUC_INTERNAL void pgm_rxq_ovfl (const struct msghdr*const restrict, uint32_t*const restrict);
+#endif
+#ifdef PGM_HAVE_RX_TIMESTAMP
+PGM_GNUC_INTERNAL pgm_time_t pgm_rx_timestamp (const struct msghdr*const);
+
+static inline
+pgm_time_t
+pgm_timespec_to_usecs (
+	const struct timespec*	ts
+	)
+{
+	return (pgm_time_t)ts->tv_sec * 1000000 + (pgm_time_t)ts->tv_nsec / 1000;
+}
+
+/* system time in microseconds since the epoch, the clock of arrival time stamps.
+ */
+
+static inline
+pgm_time_t
+pgm_rx_wall_now (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_REALTIME, &ts);
+	return pgm_timespec_to_usecs (&ts);
+}
+#endif
+PGM_GNUC_INTERNAL void pgm_zerocopy_destroy (pgm_sock_t*const);
+PGM_GNUC_INTERNAL bool pgm_zerocopy_is_pinned (pgm_sock_t*const restrict, const struct pgm_sk_buff_t*const restrict);
+PGM_GNUC_INTERNAL ssize_t pgm_sendskb (pgm_sock_t*restrict, bool, pgm_rate_t*restrict, struct pgm_sk_buff_t*, const struct sockaddr*restrict, socklen_t);
 
 static inline
 ssize_t
@@ -32,8 +32,22 @@
 
 PGM_BEGIN_DECLS
 
-PGM_GNUC_INTERNAL bool pgm_parse_raw (struct pgm_sk_buff_t*const restrict, struct sockaddr*const restrict, pgm_error_t**restrict);
-PGM_GNUC_INTERNAL bool pgm_parse_udp_encap (struct pgm_sk_buff_t*const restrict, pgm_error_t**restrict);
+/* reason a packet is discarded, recorded without allocation and formatted only
+ * on request as floods of invalid packets are discarded on the receive path.
+ */
+typedef struct pgm_parse_error_t {
+	int		code;		/* PGM_ERROR_* */
+	const char*	format;		/* untranslated, two unsigned long arguments */
+	unsigned long	arg[2];
+} pgm_parse_error_t;
+
+#define PGM_PARSE_ERROR_INIT	{ PGM_ERROR_FAILED, NULL, { 0, 0 } }
+
+PGM_GNUC_INTERNAL bool pgm_parse_raw (struct pgm_sk_buff_t*const restrict, struct sockaddr*const restrict, pgm_parse_error_t*restrict);
+PGM_GNUC_INTERNAL bool pgm_parse_udp_encap (struct pgm_sk_buff_t*const restrict, const bool, pgm_parse_error_t*restrict);
+PGM_GNUC_INTERNAL char* pgm_parse_strerror_s (char*restrict, size_t, const pgm_parse_error_t*restrict);
+PGM_GNUC_INTERNAL void pgm_parse_set_error (pgm_error_t**restrict, const pgm_parse_error_t*restrict);
+PGM_GNUC_INTERNAL void pgm_parse_csum_batch (struct pgm_sk_buff_t*const*const, const unsigned, const bool);
 PGM_GNUC_INTERNAL bool pgm_verify_spm (const struct pgm_sk_buff_t* const);
 PGM_GNUC_INTERNAL bool pgm_verify_spmr (const struct pgm_sk_buff_t* const);
 PGM_GNUC_INTERNAL bool pgm_verify_nak (const struct pgm_sk_buff_t* const);
@@ -0,0 +1,120 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * open-addressing TSI to peer table.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if !defined (__PGM_IMPL_FRAMEWORK_H_INSIDE__) && !defined (PGM_COMPILATION)
+#	error "Only <framework.h> can be included directly."
+#endif
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_PEER_TABLE_H__
+#define __PGM_IMPL_PEER_TABLE_H__
+
+typedef struct pgm_peer_table_t pgm_peer_table_t;
+
+struct pgm_peer_t;
+
+#include <pgm/types.h>
+#include <pgm/tsi.h>
+
+PGM_BEGIN_DECLS
+
+/* initial slots, power of two */
+#define PGM_PEER_TABLE_MIN_SIZE		16
+
+/* minimum slots of the previous table migrated per insert or remove */
+#define PGM_PEER_TABLE_MIGRATE		8
+
+/* empty slots have a NULL peer, a TSI packs exactly into the 64-bit key */
+struct pgm_peer_table_entry_t {
+	uint64_t			key;
+	struct pgm_peer_t*		peer;
+};
+
+struct pgm_peer_table_t {
+/* most recently used entry, ahead of hashing */
+	uint64_t			mru_key;
+	struct pgm_peer_t*		mru_peer;
+
+	uint64_t			seed;
+	struct pgm_peer_table_entry_t*	entries;
+	unsigned			mask;		/* slots - 1 */
+	unsigned			len;		/* entries across both tables */
+
+/* previous table draining into entries after growth */
+	struct pgm_peer_table_entry_t*	old_entries;
+	unsigned			old_mask;
+	unsigned			old_cursor;	/* next slot to migrate */
+	unsigned			old_remaining;	/* slots left to scan */
+};
+
+PGM_GNUC_INTERNAL pgm_peer_table_t* pgm_peer_table_new (const uint64_t) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_peer_table_destroy (pgm_peer_table_t*);
+PGM_GNUC_INTERNAL void pgm_peer_table_insert (pgm_peer_table_t*restrict, const pgm_tsi_t*restrict, struct pgm_peer_t*restrict);
+PGM_GNUC_INTERNAL bool pgm_peer_table_remove (pgm_peer_table_t*restrict, const pgm_tsi_t*restrict);
+PGM_GNUC_INTERNAL size_t pgm_peer_table_reserve (pgm_peer_table_t*, const unsigned);
+PGM_GNUC_INTERNAL struct pgm_peer_t* pgm_peer_table_lookup (const pgm_peer_table_t*restrict, const pgm_tsi_t*restrict) PGM_GNUC_PURE PGM_GNUC_WARN_UNUSED_RESULT;
+
+static inline
+uint64_t
+pgm_peer_table_key (
+	const pgm_tsi_t*	tsi
+	)
+{
+	uint64_t key;
+	memcpy (&key, tsi, sizeof (key));
+	return key;
+}
+
+/* one-entry cache for the receive path, only the receiving thread may update it.
+ *
+ * returns peer of matching TSI, returns NULL on miss.
+ */
+
+static inline
+struct pgm_peer_t*
+pgm_peer_table_lookup_mru (
+	const pgm_peer_table_t* restrict table,
+	const pgm_tsi_t*	restrict tsi
+	)
+{
+	if (PGM_LIKELY(NULL != table->mru_peer &&
+		       pgm_peer_table_key (tsi) == table->mru_key))
+		return table->mru_peer;
+	return NULL;
+}
+
+static inline
+void
+pgm_peer_table_set_mru (
+	pgm_peer_table_t*  restrict table,
+	const pgm_tsi_t*   restrict tsi,
+	struct pgm_peer_t* restrict peer
+	)
+{
+	table->mru_key  = pgm_peer_table_key (tsi);
+	table->mru_peer = peer;
+}
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_PEER_TABLE_H__ */
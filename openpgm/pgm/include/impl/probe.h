@@ -0,0 +1,79 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * Static user-space tracing probes on the packet paths.
+ *
+ * With <sys/sdt.h> each probe is a single nop with the argument locations
+ * recorded in an ELF note, attach with e.g. bpftrace usdt:libpgm.so:libpgm:receive
+ * or perf probe sdt_libpgm:receive.  Without it probes compile away.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if !defined (__PGM_IMPL_FRAMEWORK_H_INSIDE__) && !defined (PGM_COMPILATION)
+#	error "Only <framework.h> can be included directly."
+#endif
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_PROBE_H__
+#define __PGM_IMPL_PROBE_H__
+
+/* provider libpgm:
+ *
+ *	receive		(sock, type, length, tstamp)
+ *	rxw_add		(sock, peer, sqn, status)		PGM_RXW_* outcome
+ *	nak_send	(sock, peer, sqn, count)		selective, list or range
+ *	parity_nak_send	(sock, peer, sqn, count)
+ *	nak_receive	(sock, sqn, count, is_parity)
+ *	ncf_send	(sock, sqn, count, is_parity)		count of sequences or runs
+ *	ncf_receive	(sock, peer, sqn, status)		PGM_RXW_* outcome of the first sqn
+ *	rdata_send	(sock, sqn, length)
+ *	rate_stall	(bucket, is_refused, wait)		μs until the rate limit permits,
+ *								is_refused for non-blocking
+ *	apdu_deliver	(window, sqn, length)			first sqn of the APDU
+ */
+
+#ifdef HAVE_SYS_SDT_H
+#	include <sys/sdt.h>
+#	define PGM_SDT_PROBE3(name,a,b,c)		DTRACE_PROBE3(libpgm, name, a, b, c)
+#	define PGM_SDT_PROBE4(name,a,b,c,d)		DTRACE_PROBE4(libpgm, name, a, b, c, d)
+#else
+#	define PGM_SDT_PROBE3(name,a,b,c)		do { } while (0)
+#	define PGM_SDT_PROBE4(name,a,b,c,d)		do { } while (0)
+#endif
+
+/* trace events omit the first argument, the object of the probe */
+#ifdef USE_TRACE_EVENTS
+#	define PGM_PROBE3(name,a,b,c) \
+		do { \
+			PGM_SDT_PROBE3(name, a, b, c); \
+			pgm_trace_event_add (#name, (uint64_t)(uintptr_t)(b), (uint64_t)(uintptr_t)(c), 0); \
+		} while (0)
+#	define PGM_PROBE4(name,a,b,c,d) \
+		do { \
+			PGM_SDT_PROBE4(name, a, b, c, d); \
+			pgm_trace_event_add (#name, (uint64_t)(uintptr_t)(b), (uint64_t)(uintptr_t)(c), (uint64_t)(uintptr_t)(d)); \
+		} while (0)
+#else
+#	define PGM_PROBE3(name,a,b,c)		PGM_SDT_PROBE3(name, a, b, c)
+#	define PGM_PROBE4(name,a,b,c,d)		PGM_SDT_PROBE4(name, a, b, c, d)
+#endif
+
+#endif /* __PGM_IMPL_PROBE_H__ */
+
+/* eof */
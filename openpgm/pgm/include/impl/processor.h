@@ -43,9 +43,14 @@
 
 #else
 
-#	define pgm_prefetch(addr)	(addr)
-#	define pgm_prefetchw(addr)	(addr)
+#	define pgm_prefetch(addr)	((void)(addr))
+#	define pgm_prefetchw(addr)	((void)(addr))
 
 #endif
 
+/* Padding to keep data written by different threads on separate cache lines,
+ * two lines to cover adjacent line prefetch.
+ */
+#define PGM_CACHELINE_PAD	128
+
 #endif /* __PGM_IMPL_PROCESSOR_H__ */
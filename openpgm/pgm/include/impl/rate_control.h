@@ -33,24 +33,42 @@ typedef struct pgm_rate_t pgm_rate_t;
 
 #include <pgm/types.h>
 #include <pgm/time.h>
+#include <pgm/atomic.h>
 #include <impl/thread.h>
 
 PGM_BEGIN_DECLS
 
+/* bucket state is a single fixed-point time at which the bucket drains empty,
+ * so that refill and debit are one compare-and-swap.
+ */
 struct pgm_rate_t {
 	ssize_t		rate_per_sec;
 	ssize_t		rate_per_msec;
 	size_t		iphdr_len;
 
-	ssize_t		rate_limit;		/* signed for math */
-	pgm_time_t	last_rate_check;
-	pgm_spinlock_t	spinlock;
+	uint64_t	capacity;		/* fixed-point time to fill bucket */
+	volatile uint64_t drain_time;		/* fixed-point */
+	bool		is_paced;		/* SO_TXTIME launch times */
+
+/* stall accounting into the owner's counters: number of stalls then μs */
+	volatile uint64_t* stall_stats;		/* NULL for none */
+	volatile uint64_t stall_start;		/* fixed-point time of first refusal, 0 for none */
+
+/* hierarchical limit: traffic is further debited from a parent bucket shared
+ * between sockets, except traffic within the guarantee which is charged to the
+ * parent without waiting on it.
+ */
+	pgm_rate_t*	parent;			/* NULL for none */
+	pgm_rate_t*	guarantee;		/* NULL for none */
 };
 
 PGM_GNUC_INTERNAL void pgm_rate_create (pgm_rate_t*, const ssize_t, const size_t, const uint16_t);
+PGM_GNUC_INTERNAL void pgm_rate_set (pgm_rate_t*, const ssize_t, const uint16_t);
 PGM_GNUC_INTERNAL void pgm_rate_destroy (pgm_rate_t*);
 PGM_GNUC_INTERNAL bool pgm_rate_check2 (pgm_rate_t*, pgm_rate_t*, const size_t, const bool);
 PGM_GNUC_INTERNAL bool pgm_rate_check (pgm_rate_t*, const size_t, const bool);
+PGM_GNUC_INTERNAL bool pgm_rate_pace2 (pgm_rate_t*, pgm_rate_t*, const size_t, const bool, uint64_t*);
+PGM_GNUC_INTERNAL bool pgm_rate_pace (pgm_rate_t*, const size_t, const bool, uint64_t*);
 PGM_GNUC_INTERNAL pgm_time_t pgm_rate_remaining2 (pgm_rate_t*, pgm_rate_t*, const size_t);
 PGM_GNUC_INTERNAL pgm_time_t pgm_rate_remaining (pgm_rate_t*, const size_t);
 
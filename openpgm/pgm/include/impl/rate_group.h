@@ -0,0 +1,47 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * aggregate rate limit shared by the sockets of a process.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_RATE_GROUP_H__
+#define __PGM_IMPL_RATE_GROUP_H__
+
+struct pgm_rate_group_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+PGM_BEGIN_DECLS
+
+/* named parent bucket of the rate control of member sockets */
+struct pgm_rate_group_t {
+	char*				name;
+	unsigned			ref_count;	/* under pgm_sock_list_lock */
+	pgm_rate_t			bucket;
+};
+
+PGM_GNUC_INTERNAL bool pgm_rate_group_open (pgm_sock_t*const restrict, pgm_error_t**restrict);
+PGM_GNUC_INTERNAL void pgm_rate_group_close (pgm_sock_t*const);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_RATE_GROUP_H__ */
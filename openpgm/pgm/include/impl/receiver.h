@@ -27,6 +27,9 @@
 
 typedef struct pgm_peer_t pgm_peer_t;
 
+struct pgm_rx_shard_t;
+struct pgm_dlr_t;
+
 #ifndef _WIN32
 #	include <sys/socket.h>
 #endif
@@ -79,60 +82,124 @@ enum {
 	PGM_PC_RECEIVER_TRANSMIT_MEAN,
 /*	PGM_PC_RECEIVER_TRANSMIT_MAX, */
 	PGM_PC_RECEIVER_ACKS_SENT, 
+	PGM_PC_RECEIVER_DEADLINE_DROPS,
+	PGM_PC_RECEIVER_PEER_REPAIRS_SENT,
+	PGM_PC_RECEIVER_MSGS_CONFLATED,
 
 /* marker */
 	PGM_PC_RECEIVER_MAX
 };
 
+/* lower bound of NAK intervals derived from round-trip time */
+#define PGM_NAK_ADAPTIVE_MIN_IVL	pgm_msecs(1)
+
+/* NIC to application latency of data packets with arrival time stamps, and
+ * publish to delivery latency of data packets with OPT_TIMESTAMP, bucket n
+ * counting latencies from 2^(n-1) up to 2^n microseconds, the last unbounded.
+ */
+#define PGM_RX_LATENCY_BUCKETS		24
+
+/* NAKs and SPMRs of one timer sweep are transmitted together, the largest
+ * being a NAK list of 62 sequence numbers on IPv6.
+ */
+#define PGM_NAK_BATCH_MAX		64
+#define PGM_NAK_BATCH_TPDU_MAX		512
+
+struct pgm_nak_batch_t {
+	unsigned			len;
+	struct pgm_nak_batch_entry_t {
+		bool				use_router_alert;
+		size_t				tpdu_length;
+		struct sockaddr_storage		to;
+		char				tpdu[ PGM_NAK_BATCH_TPDU_MAX ];
+	} entry[ PGM_NAK_BATCH_MAX ];
+};
+
+/* repairs of neighbours' NAKs waiting on back-off per source, further NAKed
+ * sequences are left to the source.
+ */
+#define PGM_PEER_REPAIR_MAX		64
+
+struct pgm_peer_repair_t {
+	uint32_t			sequence;
+	pgm_time_t			expiry;
+};
+
 struct pgm_peer_t {
+/* receive fast path, one cache line on LP64 */
 	volatile uint32_t		ref_count;		    /* atomic integer */
-
 	pgm_tsi_t			tsi;
-	struct sockaddr_storage		group_nla;
-	struct sockaddr_storage		nla, local_nla;		/* nla = advertised, local_nla = from packet */
-	struct sockaddr_storage		poll_nla;		/* from parent to direct poll-response */
-	struct sockaddr_storage		redirect_nla;		/* from dlr */
-	pgm_time_t			polr_expiry;
-	pgm_time_t			spmr_expiry;
-	pgm_time_t			spmr_tstamp;
-
 	pgm_rxw_t*      restrict      	window;
-	pgm_list_t			peers_link;
-	pgm_slist_t			pending_link;
-
+	struct pgm_rx_shard_t*		shard;				/* owning receive shard */
+	pgm_time_t			last_packet;
+	pgm_time_t			expiry;
+	uint32_t			spm_sqn;
+	unsigned			last_commit;
 	unsigned			is_fec_enabled:1;
 	unsigned			has_proactive_parity:1;	    /* indicating availability from this source */
 	unsigned			has_ondemand_parity:1;
-
-	uint32_t			spm_sqn;
-	pgm_time_t			expiry;
-
+	unsigned			has_nak_range:1;	/* source accepts OPT_NAK_RANGE */
+	unsigned			has_crc32c:1;		/* source sends CRC32C trailers */
+	unsigned			is_priority:1;		/* flushed ahead of other peers */
+	unsigned			has_send_tstamp:1;	/* source sends OPT_TIMESTAMP */
+	unsigned			timer_index;			/* position in shard::peers_heap */
+
+/* timers */
+	pgm_time_t			timer_expiry;			/* earliest state timer, heap key */
+	pgm_time_t			spmr_expiry;
+	pgm_time_t			spmr_tstamp;
+	pgm_time_t			polr_expiry;
 	pgm_time_t			ack_rb_expiry;			/* 0 = no ACK pending */
 	pgm_time_t			ack_last_tstamp;		/* in source time reference */
+	pgm_time_t			last_data_tstamp;		/* local timestamp of ack_last_tstamp */
 	pgm_list_t			ack_link;
+	pgm_slist_t			pending_link;
+	unsigned			weight;				/* multiple of recv_quantum per flush turn */
+	pgm_list_t			peers_link;
 
+	struct pgm_dlr_t*		dlr;				/* repair cache when a DLR */
+	struct pgm_peer_repair_t*	repair;				/* PGM_PEER_REPAIR_MAX, lazily allocated */
+	unsigned			repair_len;
 	uint32_t			last_poll_sqn;
 	uint16_t			last_poll_round;
-	pgm_time_t			last_packet;
-	pgm_time_t			last_data_tstamp;		/* local timestamp of ack_last_tstamp */
-	unsigned			last_commit;
 	uint32_t			lost_count;
 	uint32_t			last_cumulative_losses;
-	volatile uint32_t		cumulative_stats[PGM_PC_RECEIVER_MAX];
-	uint32_t			snap_stats[PGM_PC_RECEIVER_MAX];
+
+/* addresses, read on NAK and POLR transmit */
+	struct sockaddr_storage		group_nla;
+	struct sockaddr_storage		nla, local_nla;		/* nla = advertised, local_nla = from packet */
+	struct sockaddr_storage		poll_nla;		/* from parent to direct poll-response */
+	struct sockaddr_storage		redirect_nla;		/* from dlr */
+	char				stats_head_pad[PGM_CACHELINE_PAD];	/* isolate from monitoring readers */
+	volatile uint64_t		cumulative_stats[PGM_PC_RECEIVER_MAX];
+	char				stats_tail_pad[PGM_CACHELINE_PAD];
+	struct pgm_stats_ring_t*	rates;				/* one second samples of cumulative_stats */
+	pgm_mem_slab_t*			slab;				/* of the peer, window and rates */
 
 	uint32_t			min_fail_time;
 	uint32_t			max_fail_time;
+
+	pgm_time_t			nak_srtt;			/* 0 = no sample */
+	pgm_time_t			nak_rttvar;
+	uint32_t			population;			/* by OPT_POPULATION, 0 = none */
+
+	uint32_t			rx_latency[PGM_RX_LATENCY_BUCKETS];
+	uint32_t			send_latency[PGM_RX_LATENCY_BUCKETS];
 };
 
 PGM_GNUC_INTERNAL pgm_peer_t* pgm_new_peer (pgm_sock_t*const restrict, const pgm_tsi_t*const restrict, const struct sockaddr*const restrict, const socklen_t, const struct sockaddr*const restrict, const socklen_t, const pgm_time_t);
 PGM_GNUC_INTERNAL void pgm_peer_unref (pgm_peer_t*);
-PGM_GNUC_INTERNAL int pgm_flush_peers_pending (pgm_sock_t*const restrict, struct pgm_msgv_t**restrict, const struct pgm_msgv_t*const, size_t*const restrict, unsigned*const restrict);
+PGM_GNUC_INTERNAL size_t pgm_receiver_prewarm (pgm_sock_t*const);
+PGM_GNUC_INTERNAL int pgm_flush_peers_pending (pgm_sock_t*const restrict, struct pgm_rx_shard_t*const restrict, pgm_rxw_cursor_t*const restrict, size_t*const restrict, unsigned*const restrict);
 PGM_GNUC_INTERNAL bool pgm_peer_has_pending (pgm_peer_t*const) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL void pgm_peer_set_pending (pgm_sock_t*const restrict, pgm_peer_t*const restrict);
-PGM_GNUC_INTERNAL bool pgm_check_peer_state (pgm_sock_t*const, const pgm_time_t);
-PGM_GNUC_INTERNAL void pgm_set_reset_error (pgm_sock_t*const restrict, pgm_peer_t*const restrict, struct pgm_msgv_t*const restrict);
-PGM_GNUC_INTERNAL pgm_time_t pgm_min_receiver_expiry (pgm_sock_t*, pgm_time_t) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_peer_update_weight (pgm_sock_t*const restrict, pgm_peer_t*const restrict);
+PGM_GNUC_INTERNAL void pgm_peer_get_stats (pgm_peer_t*const restrict, struct pgm_peerstatsinfo_t*const restrict);
+PGM_GNUC_INTERNAL void pgm_collect_decoded (pgm_sock_t*const restrict, struct pgm_rx_shard_t*const restrict);
+PGM_GNUC_INTERNAL void pgm_peer_timer_update (pgm_sock_t*const restrict, pgm_peer_t*const restrict);
+PGM_GNUC_INTERNAL bool pgm_check_peer_state (pgm_sock_t*const restrict, struct pgm_rx_shard_t*const restrict, const pgm_time_t);
+PGM_GNUC_INTERNAL void pgm_set_reset_error (pgm_sock_t*const restrict, pgm_peer_t*const restrict, pgm_rxw_cursor_t*const restrict);
+PGM_GNUC_INTERNAL pgm_time_t pgm_min_receiver_expiry (pgm_sock_t*, struct pgm_rx_shard_t*, pgm_time_t) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL bool pgm_on_peer_nak (pgm_sock_t*const restrict, pgm_peer_t*const restrict, struct pgm_sk_buff_t*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL bool pgm_on_data (pgm_sock_t*const restrict, pgm_peer_t*const restrict, struct pgm_sk_buff_t*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL bool pgm_on_ncf (pgm_sock_t*const restrict, pgm_peer_t*const restrict, struct pgm_sk_buff_t*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
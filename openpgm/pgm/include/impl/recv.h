@@ -0,0 +1,55 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Transport recv API.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_RECV_H__
+#define __PGM_IMPL_RECV_H__
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+PGM_BEGIN_DECLS
+
+/* upper bound of datagrams read per recvmmsg() call, Linux UIO_MAXIOV */
+#define PGM_RECV_BATCH_MAX	1024
+
+/* asynchronous receive defaults, messages per batch and batches on an executor */
+#define PGM_RECV_ASYNC_MSGV	32
+#define PGM_RECV_ASYNC_INFLIGHT	4
+
+/* drain ring default in messages, and messages completed per read of the thread */
+#define PGM_RECV_DRAIN_LEN	1024
+#define PGM_RECV_DRAIN_BATCH	32
+
+PGM_GNUC_INTERNAL void pgm_recv_batch_create (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_recv_batch_destroy (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_recv_gro_create (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_recv_gro_destroy (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_recv_busy_poll_create (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_recv_async_destroy (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_recv_drain_destroy (pgm_sock_t*const);
+PGM_GNUC_INTERNAL SOCKET pgm_recv_pending_socket (pgm_sock_t*const);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_RECV_H__ */
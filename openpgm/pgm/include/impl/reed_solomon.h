@@ -32,20 +32,39 @@ typedef struct pgm_rs_t pgm_rs_t;
 
 #include <pgm/types.h>
 #include <impl/galois.h>
+#include <impl/cpu.h>
 
 PGM_BEGIN_DECLS
 
+/* inverted recovery matrices retained per code */
+#define PGM_RS_MATRIX_CACHE	4
+
+struct pgm_rs_matrix_t {
+	uint8_t*	offsets;	/* key: erasure pattern and parity offsets, length k */
+	pgm_gf8_t*	RM;		/* inverted recovery matrix, k × k */
+	uint32_t	last_use;
+};
+
 struct pgm_rs_t {
 	uint8_t		n, k;		/* RS(n, k) */
 	pgm_gf8_t*	GM;
-	pgm_gf8_t*	RM;
+	struct pgm_rs_matrix_t	matrix_cache[PGM_RS_MATRIX_CACHE];
+	uint32_t	matrix_clock;
+	uint32_t	matrix_hits;
+	uint32_t	matrix_misses;
 };
 
 #define PGM_RS_DEFAULT_N	255
 
+/* fused encode strip sizing, bytes */
+#define PGM_RS_STRIP_CACHE	16384
+#define PGM_RS_STRIP_MIN	256
+
+PGM_GNUC_INTERNAL void pgm_rs_init (const pgm_cpu_t*);
 PGM_GNUC_INTERNAL void pgm_rs_create (pgm_rs_t*, const uint8_t, const uint8_t);
 PGM_GNUC_INTERNAL void pgm_rs_destroy (pgm_rs_t*);
 PGM_GNUC_INTERNAL void pgm_rs_encode (pgm_rs_t*restrict, const pgm_gf8_t**restrict, const uint8_t, pgm_gf8_t*restrict, const uint16_t);
+PGM_GNUC_INTERNAL void pgm_rs_encode_multi (pgm_rs_t*restrict, const pgm_gf8_t**restrict, const uint8_t*restrict, pgm_gf8_t**restrict, const uint8_t, const uint16_t);
 PGM_GNUC_INTERNAL void pgm_rs_decode_parity_inline (pgm_rs_t*restrict, pgm_gf8_t**restrict, const uint8_t*restrict, const uint16_t);
 PGM_GNUC_INTERNAL void pgm_rs_decode_parity_appended (pgm_rs_t*restrict, pgm_gf8_t**restrict, const uint8_t*restrict, const uint16_t);
 
@@ -0,0 +1,67 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * PGM relay, forwarding the sessions of a receiving socket to a multicast
+ * group of another network or to unicast subscribers.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_RELAY_H__
+#define __PGM_IMPL_RELAY_H__
+
+struct pgm_relay_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+#include <impl/receiver.h>
+
+PGM_BEGIN_DECLS
+
+/* upper bound of unicast subscribers of a relay */
+#define PGM_RELAY_SUBSCRIBERS_MAX	64
+
+struct pgm_relay_subscriber_t {
+	struct sockaddr_storage	addr;			/* UDP-encapsulated unicast receiver */
+	uint32_t		rate;			/* bytes per second, 0 = unlimited */
+	pgm_rate_t		rate_control;
+};
+
+struct pgm_relay_t {
+	SOCKET			send_sock;		/* downstream multicast and unicast */
+	struct group_req	gr;			/* downstream interface and group, AF_UNSPEC group for none */
+	struct sockaddr_storage	nla;			/* downstream interface address, NAK target */
+	unsigned		subscriber_len;
+	struct pgm_relay_subscriber_t subscribers[ PGM_RELAY_SUBSCRIBERS_MAX ];
+};
+
+PGM_GNUC_INTERNAL struct pgm_relay_t* pgm_relay_create (pgm_sock_t*const restrict, const struct group_req*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_relay_destroy (struct pgm_relay_t*const);
+PGM_GNUC_INTERNAL void pgm_relay_set_group (pgm_sock_t*const restrict, const struct group_req*const restrict);
+PGM_GNUC_INTERNAL bool pgm_relay_add_subscriber (struct pgm_relay_t*const restrict, const struct pgm_relaysubinfo_t*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL bool pgm_relay_bind (pgm_sock_t*const restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL bool pgm_relay_send (pgm_sock_t*const restrict, const void*restrict, const size_t);
+PGM_GNUC_INTERNAL bool pgm_relay_repair (pgm_sock_t*const restrict, const struct sockaddr*const restrict, const void*restrict, const size_t);
+PGM_GNUC_INTERNAL void pgm_relay_forward (pgm_sock_t*const restrict, const struct pgm_sk_buff_t*const restrict);
+PGM_GNUC_INTERNAL void pgm_relay_forward_spm (pgm_sock_t*const restrict, const struct pgm_sk_buff_t*const restrict);
+PGM_GNUC_INTERNAL void pgm_relay_forward_nak (pgm_sock_t*const restrict, pgm_peer_t*const restrict, const struct pgm_sk_buff_t*const restrict);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_RELAY_H__ */
@@ -0,0 +1,56 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * replay of captured packets through the receive path.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_REPLAY_H__
+#define __PGM_IMPL_REPLAY_H__
+
+struct pgm_replay_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+PGM_BEGIN_DECLS
+
+/* capture file held in memory, so that replay costs no I/O */
+struct pgm_replay_t {
+	char*				buf;
+	size_t				len;
+	size_t				offset;		/* next record */
+	bool				is_swapped;	/* written in the other byte order */
+	bool				is_nsec;	/* nanosecond time stamps */
+	uint32_t			linktype;
+	unsigned			speed;		/* percent of captured timing, 0 = maximum */
+	pgm_time_t			first_tstamp;	/* capture time of first packet */
+	pgm_time_t			start;		/* replay time of first packet */
+	uint64_t			packets;
+	uint64_t			skipped;	/* not PGM, fragments, or beyond max_tpdu */
+};
+
+PGM_GNUC_INTERNAL bool pgm_replay_open (pgm_sock_t*const restrict, pgm_error_t**restrict);
+PGM_GNUC_INTERNAL void pgm_replay_close (pgm_sock_t*const);
+PGM_GNUC_INTERNAL ssize_t pgm_replay_recvskb (pgm_sock_t*const restrict, struct pgm_sk_buff_t*const restrict, struct sockaddr*const restrict, const socklen_t, struct sockaddr*const restrict, const socklen_t);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_REPLAY_H__ */
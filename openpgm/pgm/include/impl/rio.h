@@ -0,0 +1,106 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Windows Registered I/O packet I/O.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_RIO_H__
+#define __PGM_IMPL_RIO_H__
+
+struct pgm_rio_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+/* Registered I/O extension functions, Windows 8 */
+#if defined( _WIN32 ) && ( _WIN32_WINNT >= 0x0602 )
+#	include <mswsock.h>
+#	ifdef WSAID_MULTIPLE_RIO
+#		define PGM_HAVE_RIO
+#	endif
+#endif
+
+PGM_BEGIN_DECLS
+
+/* upper bound of outstanding receives and in-flight sends */
+#define PGM_RIO_ENTRIES_MAX		4096
+
+#ifdef PGM_HAVE_RIO
+/* control buffer per datagram, sufficient for IP_PKTINFO or IPV6_PKTINFO */
+#	define PGM_RIO_AUXLEN		(RIO_CMSG_BASE_SIZE + 64)
+
+/* address and control buffers of one outstanding receive */
+struct pgm_rio_name_t {
+	SOCKADDR_INET			addr;
+	char				control[ PGM_RIO_AUXLEN ];
+};
+
+struct pgm_rio_send_t;
+
+struct pgm_rio_t {
+	unsigned			entries;
+	RIO_EXTENSION_FUNCTION_TABLE	fn;
+	RIO_BUFFERID			pool_id;	/* packet buffer pool */
+	RIO_BUFFERID			window_id;	/* transmit window slots, if any */
+	char*				window_addr;
+	size_t				window_len;
+/* receive: entries outstanding RIOReceiveEx() over pool buffers */
+	RIO_CQ				rx_cq;
+	RIO_RQ				rx_rq;
+	struct pgm_rio_name_t*		rx_name;	/* registered, indexed by slot */
+	RIO_BUFFERID			rx_name_id;
+	struct pgm_sk_buff_t**		rx_skb;		/* indexed by slot */
+	unsigned*			rx_unposted;	/* stack of slots awaiting a buffer */
+	unsigned			rx_unposted_len;
+	RIORESULT*			results;	/* dequeued, not yet read */
+	unsigned			results_head;
+	unsigned			results_len;
+/* transmit: deferred RIOSendEx() batches holding skb references */
+	RIO_CQ				tx_cq;
+	RIO_RQ				tx_rq;
+	RIO_RQ				tx_ra_rq;	/* router alert socket */
+	pgm_mutex_t			tx_mutex;
+	struct pgm_rio_send_t*		tx_slot;
+	SOCKADDR_INET*			tx_name;	/* registered, indexed by slot */
+	RIO_BUFFERID			tx_name_id;
+	char*				tx_bounce;	/* registered copies of unregistered packets */
+	RIO_BUFFERID			tx_bounce_id;
+	unsigned*			tx_free;	/* stack of idle slots */
+	unsigned			tx_free_len;
+/* receive completion signalled to an event, or an application completion port */
+	HANDLE				event;
+	WSAEVENT			notify_event;	/* pending and repair notifications */
+	bool				is_iocp;
+	OVERLAPPED			overlapped;
+};
+
+PGM_GNUC_INTERNAL ssize_t pgm_rio_recvskb (pgm_sock_t*const restrict, struct sockaddr*const restrict, const socklen_t, WSAMSG*const restrict);
+PGM_GNUC_INTERNAL int pgm_rio_sendv (pgm_sock_t*const restrict, const bool, struct pgm_sk_buff_t*const*const restrict, const unsigned, const struct sockaddr*const restrict, const socklen_t);
+PGM_GNUC_INTERNAL int pgm_rio_wait (pgm_sock_t*const, const int);
+PGM_GNUC_INTERNAL bool pgm_rio_is_pending (const pgm_sock_t*const) PGM_GNUC_PURE;
+#endif /* PGM_HAVE_RIO */
+
+PGM_GNUC_INTERNAL bool pgm_rio_open (pgm_sock_t*const restrict, pgm_error_t**restrict);
+PGM_GNUC_INTERNAL void pgm_rio_close (pgm_sock_t*const);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_RIO_H__ */
@@ -53,10 +53,14 @@ static inline void pgm_rwspinlock_free (pgm_rwspinlock_t* rwspinlock) {
 	pgm_ticket_free (&rwspinlock->lock);
 }
 
-static inline void pgm_rwspinlock_reader_lock (pgm_rwspinlock_t* rwspinlock) {
+/* lock functions return spins waiting for the lock.
+ */
+
+static inline unsigned pgm_rwspinlock_reader_lock (pgm_rwspinlock_t* rwspinlock) {
+	unsigned total_spins = 0;
 	for (;;) {
-#if defined( _WIN32 ) || defined( __i386__ ) || defined( __i386 ) || defined( __x86_64__ ) || defined( __amd64 )
 		unsigned spins = 0;
+#if defined( _WIN32 ) || defined( __i386__ ) || defined( __i386 ) || defined( __x86_64__ ) || defined( __amd64 )
 		while (!pgm_ticket_is_unlocked (&rwspinlock->lock))
 			if (!pgm_smp_system || (++spins > PGM_ADAPTIVE_MUTEX_SPINCOUNT))
 #	ifdef _WIN32
@@ -72,13 +76,16 @@ static inline void pgm_rwspinlock_reader_lock (pgm_rwspinlock_t* rwspinlock) {
 				__asm volatile ("pause" ::: "memory");
 #	endif
 #else
-		while (!pgm_ticket_is_unlocked (&rwspinlock->lock))
+		while (!pgm_ticket_is_unlocked (&rwspinlock->lock)) {
+			spins++;
 			sched_yield();
+		}
 #endif
+		total_spins += spins;
 /* speculative lock */
 		pgm_atomic_inc32 (&rwspinlock->readers);
 		if (pgm_ticket_is_unlocked (&rwspinlock->lock))
-			return;
+			return total_spins;
 		pgm_atomic_dec32 (&rwspinlock->readers);
 	}
 }
@@ -95,10 +102,10 @@ static inline void pgm_rwspinlock_reader_unlock (pgm_rwspinlock_t* rwspinlock) {
 	pgm_atomic_dec32 (&rwspinlock->readers);
 }
 
-static inline void pgm_rwspinlock_writer_lock (pgm_rwspinlock_t* rwspinlock) {
+static inline unsigned pgm_rwspinlock_writer_lock (pgm_rwspinlock_t* rwspinlock) {
 #if defined( _WIN32 ) || defined( __i386__ ) || defined( __i386 ) || defined( __x86_64__ ) || defined( __amd64 )
+	const unsigned ticket_spins = pgm_ticket_lock (&rwspinlock->lock);
 	unsigned spins = 0;
-	pgm_ticket_lock (&rwspinlock->lock);
 	while (rwspinlock->readers)
 		if (!pgm_smp_system || (++spins > PGM_ADAPTIVE_MUTEX_SPINCOUNT))
 #	ifdef _WIN32
@@ -113,10 +120,14 @@ static inline void pgm_rwspinlock_writer_lock (pgm_rwspinlock_t* rwspinlock) {
 			__asm volatile ("pause" ::: "memory");
 #	endif
 #else
-	pgm_ticket_lock (&rwspinlock->lock);
-	while (rwspinlock->readers)
+	const unsigned ticket_spins = pgm_ticket_lock (&rwspinlock->lock);
+	unsigned spins = 0;
+	while (rwspinlock->readers) {
+		spins++;
 		sched_yield();
+	}
 #endif
+	return ticket_spins + spins;
 }
 
 static inline bool pgm_rwspinlock_writer_trylock (pgm_rwspinlock_t* rwspinlock) {
@@ -26,7 +26,9 @@
 #define __PGM_IMPL_RXW_H__
 
 typedef struct pgm_rxw_state_t pgm_rxw_state_t;
+typedef struct pgm_rxw_gap_t pgm_rxw_gap_t;
 typedef struct pgm_rxw_t pgm_rxw_t;
+typedef struct pgm_rxw_cursor_t pgm_rxw_cursor_t;
 
 #include <impl/framework.h>
 
@@ -61,6 +63,7 @@ enum
 /* must be smaller than PGM skbuff control buffer */
 struct pgm_rxw_state_t {
 	pgm_time_t	timer_expiry;
+	pgm_time_t	insert_tstamp;		/* entered window, by data or parity */
         int		pkt_state;
 
 	uint8_t		nak_transmit_count;	/* 8-bit for size constraints */
@@ -69,29 +72,109 @@ struct pgm_rxw_state_t {
 
 /* only valid on tg_sqn::pkt_sqn = 0 */
 	unsigned	is_contiguous:1;	/* transmission group */
+
+/* only valid on parity, original packets of a partial transmission group by
+ * OPT_CURR_TGSIZE, 0 for the whole group.
+ */
+	uint8_t		tg_size;
+
+/* only valid on the first fragment of an APDU, the contiguous fragments from
+ * this sequence already verified by _pgm_rxw_is_apdu_complete().
+ */
+	uint32_t	apdu_tpdus;
+	uint32_t	apdu_size;
+};
+
+/* size classes of reassembled APDU buffers, 1 KiB doubling up to PGM_MAX_APDU,
+ * with idle buffers held per class.
+ */
+#define PGM_RXW_REASM_CLASSES	7
+#define PGM_RXW_REASM_POOL_SIZE	16
+
+static inline
+uint16_t
+pgm_rxw_reasm_class_size (
+	const unsigned		class_
+	)
+{
+	return class_ < PGM_RXW_REASM_CLASSES - 1 ? (uint16_t)(1024U << class_) : PGM_MAX_APDU;
+}
+
+/* skbs describing the APDUs of coalesced TPDUs read this call, the payload
+ * remains in the committing TPDU.
+ */
+#define PGM_RXW_RECORDS_LEN	64
+
+struct pgm_rxw_records_t {
+	struct pgm_rxw_records_t*	next;
+	unsigned			len;		/* records in use */
+	struct pgm_sk_buff_t		skb[PGM_RXW_RECORDS_LEN];
+};
+
+/* repair latency from loss detection, bucket n counting fill times from
+ * 2^(n-1) up to 2^n microseconds, the last unbounded.
+ */
+#define PGM_RXW_FILL_TIME_BUCKETS	24
+
+/* time held from window insert to release behind the commit lead, bucket n
+ * counting residencies from 2^(n-1) up to 2^n microseconds, the last unbounded.
+ */
+#define PGM_RXW_RESIDENCY_BUCKETS	32
+
+/* run of missing sequences sharing one recovery state, skbs are only
+ * allocated on arrival of data or parity.
+ */
+struct pgm_rxw_gap_t {
+	pgm_list_t		link;			/* state queue, must be first */
+	pgm_list_t		order_link;		/* gap_queue */
+	uint32_t		sequence;		/* first missing sequence */
+	uint32_t		len;
+	pgm_time_t		tstamp;			/* loss detected */
+	pgm_time_t		nak_tstamp;		/* first NAK sent, 0 once sampled */
+	pgm_time_t		nak_sent_tstamp;	/* first NAK sent */
+	pgm_rxw_state_t		state;
+};
+
+/* gaps are taken from chunks held by the window and recycled through a free
+ * list, such that state changes of a loss burst do not touch the allocator.
+ */
+#define PGM_RXW_GAPS_LEN	64
+
+struct pgm_rxw_gaps_t {
+	struct pgm_rxw_gaps_t*	next;
+	pgm_rxw_gap_t		gap[PGM_RXW_GAPS_LEN];
 };
 
 struct pgm_rxw_t {
 	const pgm_tsi_t*	tsi;
 
         pgm_queue_t		ack_backoff_queue;
-        pgm_queue_t		nak_backoff_queue;
+        pgm_queue_t		nak_backoff_queue;	/* of gaps */
         pgm_queue_t		wait_ncf_queue;
         pgm_queue_t		wait_data_queue;
+	pgm_queue_t		gap_queue;		/* in sequence order, lead at head */
+	pgm_rxw_gap_t*		gap_hint;		/* last gap found */
+	struct pgm_rxw_gaps_t*	gaps;			/* chunks, released with the window */
+	pgm_list_t*		gap_free;		/* idle gaps by link.next */
 /* window context counters */
+	uint32_t		missing_count;		/* sequences waiting repair */
 	uint32_t		lost_count;		/* failed to repair */
 	uint32_t		fragment_count;		/* incomplete apdu */
 	uint32_t		parity_count;		/* parity for repairs */
 	uint32_t		committed_count;	/* but still in window */
 
         uint16_t		max_tpdu;               /* maximum packet size */
+	pgm_skb_pool_t*		skb_pool;		/* owning socket buffers, optional */
         uint32_t		lead, trail;
         uint32_t		rxw_trail, rxw_trail_init;
 	uint32_t		commit_lead;
+	uint32_t		unordered_lead;		/* next sequence to scan beyond commit_lead */
         unsigned		is_constrained:1;
         unsigned		is_defined:1;
 	unsigned		has_event:1;		/* edge triggered */
 	unsigned		is_fec_available:1;
+	unsigned		can_shrink:1;		/* release slots when idle */
+	unsigned		is_unordered:1;		/* deliver complete APDUs beyond gaps */
 	pgm_rs_t		rs;
 	uint32_t		tg_size;		/* transmission group size for parity recovery */
 	uint8_t			tg_sqn_shift;
@@ -103,32 +186,97 @@ struct pgm_rxw_t {
 /* counters all guint32 */
 	uint32_t		min_fill_time;		/* restricted from pgm_time_t */
 	uint32_t		max_fill_time;
+	uint32_t		fill_time_hist[PGM_RXW_FILL_TIME_BUCKETS];
+	uint32_t		max_residency;
+	uint32_t		residency_hist[PGM_RXW_RESIDENCY_BUCKETS];
+	uint32_t		peak_length;		/* high-water of sequences held */
 	uint32_t		min_nak_transmit_count;
 	uint32_t		max_nak_transmit_count;
 	uint32_t		cumulative_losses;
 	uint32_t		bytes_delivered;
 	uint32_t		msgs_delivered;
+	pgm_time_t		read_tstamp;		/* start of the current read */
 
 	size_t			size;			/* in bytes */
-	unsigned		alloc;			/* in pkts */
-/* C90 and older */
-	struct pgm_sk_buff_t*   pdata[1];
+	size_t			peak_size;		/* high-water of size */
+	pgm_mem_budget_t*	budget;			/* charged with truesize of held skbs, optional */
+	pgm_mem_slab_t*		slab;			/* window, pointer array and chunks, optional */
+	struct pgm_flightrec_t*	flightrec;		/* gap states recorded, optional */
+	struct pgm_xdp_filter_t* xdp_filter;		/* held sequences published, optional */
+	uint32_t		xdp_filter_lead;	/* commit lead last published */
+	unsigned		alloc;			/* in pkts, current slots of pdata, a power of two */
+	uint32_t		mask;			/* alloc - 1, sequence to pdata index */
+	unsigned		min_alloc, max_alloc;	/* in pkts */
+	unsigned		resize_alloc;		/* max_alloc pending the trail, 0 for none */
+	struct pgm_sk_buff_t**  pdata;
+
+/* coalesced TPDUs */
+	struct pgm_rxw_records_t* records;		/* chunks, released with the window */
+	struct pgm_rxw_records_t* records_tail;		/* chunk in use, NULL when none read */
+	uint32_t		coalesce_sqn;		/* TPDU partially read */
+	uint16_t		coalesce_offset;	/* payload bytes read, 0 for none */
+
+/* complete APDUs pulled unread from a full window by a slow consumer */
+	pgm_queue_t		spill_queue;		/* in sequence order, oldest at tail */
+	pgm_queue_t		spill_commit_queue;	/* read, released on next commit */
+	size_t			spill_size;		/* in bytes */
+	size_t			spill_max;		/* in bytes, 0 for disabled */
+	uint32_t		cumulative_spilled;	/* sequences */
+
+/* large APDUs copied to one contiguous buffer by fragment offset on arrival */
+	uint16_t		reasm_min;		/* APDU bytes, 0 for disabled */
+	pgm_skb_pool_t**	reasm_pool;		/* PGM_RXW_REASM_CLASSES buffer pools, optional */
+	pgm_queue_t		reasm_queue;		/* APDUs being filled, by first sequence */
+	pgm_queue_t		reasm_commit_queue;	/* read, released on next commit */
+	uint32_t		cumulative_reassembled;	/* APDUs */
+
+/* LZ4 compressed APDUs decompressed on read, fragmented ones reassembled first */
+	pgm_skb_pool_t**	inflate_pool;		/* PGM_RXW_REASM_CLASSES buffer pools, optional */
+	uint32_t		cumulative_inflated;	/* APDUs */
+
+/* transmission groups reconstructed on the decoder threads of the socket */
+	struct pgm_decode_pool_t* decode_pool;		/* optional */
+	volatile uint32_t*	decode_ready;		/* shard count of completed groups */
+	pgm_queue_t		decode_queue;		/* in submission order, oldest at tail */
 };
 
+/* destination of a read, the next message of a message vector array or of a
+ * compact vector.  a compact vector is full with fewer than PGM_MAX_FRAGMENTS
+ * free packets such that any complete APDU fits as with struct pgm_msgv_t.
+ */
+struct pgm_rxw_cursor_t
+{
+	struct pgm_msgv_t*		msgv;		/* next message, NULL with skbv */
+	const struct pgm_msgv_t*	msgv_end;	/* last message */
+	struct pgm_skbv_t*		skbv;		/* compact vector, NULL with msgv */
+	unsigned			len;		/* packets of the message being appended */
+	unsigned			last_len;	/* packets of the last message appended */
+};
 
 PGM_GNUC_INTERNAL pgm_rxw_t* pgm_rxw_create (const pgm_tsi_t*const, const uint16_t, const unsigned, const unsigned, const ssize_t, const uint32_t) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL pgm_rxw_t* pgm_rxw_create_from (pgm_mem_slab_t*const, const pgm_tsi_t*const, const uint16_t, const unsigned, const unsigned, const ssize_t, const uint32_t) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL void pgm_rxw_destroy (pgm_rxw_t*const);
+PGM_GNUC_INTERNAL void pgm_rxw_set_min_length (pgm_rxw_t*const, const unsigned, const bool);
+PGM_GNUC_INTERNAL void pgm_rxw_set_max_length (pgm_rxw_t*const, const unsigned);
+PGM_GNUC_INTERNAL size_t pgm_rxw_prewarm (pgm_rxw_t*const);
 PGM_GNUC_INTERNAL int pgm_rxw_add (pgm_rxw_t*const restrict, struct pgm_sk_buff_t*const restrict, const pgm_time_t, const pgm_time_t) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL void pgm_rxw_add_ack (pgm_rxw_t*const restrict, struct pgm_sk_buff_t*const restrict, const pgm_time_t);
 PGM_GNUC_INTERNAL void pgm_rxw_remove_ack (pgm_rxw_t*const restrict, struct pgm_sk_buff_t*const restrict);
 PGM_GNUC_INTERNAL void pgm_rxw_remove_commit (pgm_rxw_t*const);
 PGM_GNUC_INTERNAL ssize_t pgm_rxw_readv (pgm_rxw_t*const restrict, struct pgm_msgv_t** restrict, const unsigned) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL ssize_t pgm_rxw_read (pgm_rxw_t*const restrict, pgm_rxw_cursor_t*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL unsigned pgm_rxw_decode_collect (pgm_rxw_t*const);
 PGM_GNUC_INTERNAL unsigned pgm_rxw_remove_trail (pgm_rxw_t*const) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL unsigned pgm_rxw_update (pgm_rxw_t*const, const uint32_t, const uint32_t, const pgm_time_t, const pgm_time_t) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL void pgm_rxw_update_fec (pgm_rxw_t*const, const uint8_t);
+PGM_GNUC_INTERNAL void pgm_rxw_join (pgm_rxw_t*const, const uint32_t);
 PGM_GNUC_INTERNAL int pgm_rxw_confirm (pgm_rxw_t*const, const uint32_t, const pgm_time_t, const pgm_time_t, const pgm_time_t) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL void pgm_rxw_lost (pgm_rxw_t*const, const uint32_t);
-PGM_GNUC_INTERNAL void pgm_rxw_state (pgm_rxw_t*const restrict, struct pgm_sk_buff_t*const restrict, const int);
+PGM_GNUC_INTERNAL pgm_time_t pgm_rxw_nak_rtt (pgm_rxw_t*const, const uint32_t, const pgm_time_t) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL uint32_t pgm_rxw_expire (pgm_rxw_t*const, const pgm_time_t);
+PGM_GNUC_INTERNAL pgm_time_t pgm_rxw_gap_tstamp (const pgm_rxw_t*const) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_rxw_state (pgm_rxw_t*const restrict, pgm_rxw_gap_t*const restrict, const int);
+PGM_GNUC_INTERNAL pgm_rxw_gap_t* pgm_rxw_split (pgm_rxw_t*const restrict, pgm_rxw_gap_t*const restrict, const uint32_t) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL struct pgm_sk_buff_t* pgm_rxw_peek (pgm_rxw_t*const, const uint32_t) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL const char* pgm_pkt_state_string (const int) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL const char* pgm_rxw_returns_string (const int) PGM_GNUC_WARN_UNUSED_RESULT;
@@ -142,6 +290,7 @@ static inline bool pgm_rxw_is_empty (const pgm_rxw_t*const) PGM_GNUC_WARN_UNUSED
 static inline bool pgm_rxw_is_full (const pgm_rxw_t*const) PGM_GNUC_WARN_UNUSED_RESULT;
 static inline uint32_t pgm_rxw_lead (const pgm_rxw_t*const) PGM_GNUC_WARN_UNUSED_RESULT;
 static inline uint32_t pgm_rxw_next_lead (const pgm_rxw_t*const) PGM_GNUC_WARN_UNUSED_RESULT;
+static inline bool pgm_rxw_cursor_is_full (const pgm_rxw_cursor_t*const) PGM_GNUC_WARN_UNUSED_RESULT;
 
 static inline
 unsigned
@@ -150,7 +299,7 @@ pgm_rxw_max_length (
 	)
 {
 	pgm_assert (NULL != window);
-	return window->alloc;
+	return window->max_alloc;
 }
 
 static inline
@@ -213,6 +362,88 @@ pgm_rxw_next_lead (
 	return (uint32_t)(pgm_rxw_lead (window) + 1);
 }
 
+static inline
+void
+pgm_rxw_cursor_init_msgv (
+	pgm_rxw_cursor_t*	   const restrict cursor,
+	struct pgm_msgv_t*	   const restrict msgv,
+	const unsigned				  msgv_len
+	)
+{
+	pgm_assert (NULL != cursor);
+	cursor->msgv		= msgv;
+	cursor->msgv_end	= msgv + msgv_len - 1;
+	cursor->skbv		= NULL;
+	cursor->len		= 0;
+	cursor->last_len	= 0;
+}
+
+static inline
+void
+pgm_rxw_cursor_init_skbv (
+	pgm_rxw_cursor_t*	   const restrict cursor,
+	struct pgm_skbv_t*	   const restrict skbv
+	)
+{
+	pgm_assert (NULL != cursor);
+	pgm_assert (NULL != skbv);
+	skbv->skbv_skb_used	= 0;
+	skbv->skbv_msg_used	= 0;
+	cursor->msgv		= NULL;
+	cursor->msgv_end	= NULL;
+	cursor->skbv		= skbv;
+	cursor->len		= 0;
+	cursor->last_len	= 0;
+}
+
+static inline
+bool
+pgm_rxw_cursor_is_full (
+	const pgm_rxw_cursor_t* const cursor
+	)
+{
+	if (NULL == cursor->skbv)
+		return cursor->msgv > cursor->msgv_end;
+	return cursor->skbv->skbv_msg_used == cursor->skbv->skbv_msg_len ||
+	       cursor->skbv->skbv_skb_len - cursor->skbv->skbv_skb_used < PGM_MAX_FRAGMENTS;
+}
+
+/* append a packet to the message being read */
+static inline
+void
+pgm_rxw_cursor_append (
+	pgm_rxw_cursor_t*	   const restrict cursor,
+	struct pgm_sk_buff_t*	   const restrict skb
+	)
+{
+	pgm_assert (cursor->len < PGM_MAX_FRAGMENTS);
+	if (NULL == cursor->skbv)
+		cursor->msgv->msgv_skb[ cursor->len++ ] = skb;
+	else
+		cursor->skbv->skbv_skb[ cursor->skbv->skbv_skb_used + cursor->len++ ] = skb;
+}
+
+/* complete the message being read and move to the next */
+static inline
+void
+pgm_rxw_cursor_next (
+	pgm_rxw_cursor_t* const cursor
+	)
+{
+	if (NULL == cursor->skbv) {
+		cursor->msgv->msgv_len = cursor->len;
+		cursor->msgv++;
+	} else {
+		struct pgm_skbv_t* skbv = cursor->skbv;
+		skbv->skbv_offset[ skbv->skbv_msg_used ] = skbv->skbv_skb_used;
+		skbv->skbv_count[ skbv->skbv_msg_used ]  = (uint16_t)cursor->len;
+		skbv->skbv_skb_used += cursor->len;
+		skbv->skbv_msg_used++;
+	}
+	cursor->last_len = cursor->len;
+	cursor->len = 0;
+}
+
 PGM_END_DECLS
 
 #endif /* __PGM_IMPL_RXW_H__ */
@@ -0,0 +1,41 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * PGM socket selector, library internals.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_SELECTOR_H__
+#define __PGM_IMPL_SELECTOR_H__
+
+#include <impl/framework.h>
+#include <pgm/selector.h>
+
+#if defined(HAVE_EPOLL_CTL) || defined(HAVE_KQUEUE)
+#	define PGM_HAVE_SELECTOR
+#endif
+
+PGM_BEGIN_DECLS
+
+PGM_GNUC_INTERNAL bool pgm_selector_set_wake (pgm_selector_t*const, const SOCKET);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_SELECTOR_H__ */
@@ -0,0 +1,117 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * receive fan-out over SO_REUSEPORT sockets, sharded by source GSI.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_SHARD_H__
+#define __PGM_IMPL_SHARD_H__
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+#ifdef HAVE_LINUX_FILTER_H
+#	include <linux/filter.h>
+/* per-socket classic BPF with access to the network header */
+#	if defined(SO_REUSEPORT) && defined(SO_ATTACH_FILTER) && defined(SKF_NET_OFF)
+#		define PGM_HAVE_RECV_SHARDS
+#	endif
+#endif
+
+PGM_BEGIN_DECLS
+
+/* upper bound of receive sockets per PGM socket */
+#define PGM_RECV_SHARDS_MAX		64
+
+/* shard 0 is the receive socket itself */
+static inline
+SOCKET
+pgm_recv_shard_sock (
+	const pgm_sock_t* const	sock,
+	const unsigned		shard
+	)
+{
+	return 0 == shard ? sock->recv_sock : sock->recv_shard_sock[ shard - 1 ];
+}
+
+/* shard owning a source, matches the kernel filter: the first four GSI octets
+ * XOR the last two, both in network order, modulo the shard count.
+ */
+static inline
+unsigned
+pgm_recv_shard_of (
+	const pgm_gsi_t* const	gsi,
+	const unsigned		shards
+	)
+{
+	const uint8_t* id = gsi->identifier;
+	const uint32_t hash = ((uint32_t)id[0] << 24 | (uint32_t)id[1] << 16 | (uint32_t)id[2] << 8 | id[3])
+			    ^ ((uint32_t)id[4] << 8 | id[5]);
+	return hash % shards;
+}
+
+/* receive shard owning the state of a source */
+static inline
+struct pgm_rx_shard_t*
+pgm_rx_shard_for (
+	const pgm_sock_t* const restrict sock,
+	const pgm_tsi_t*  const restrict tsi
+	)
+{
+	if (PGM_LIKELY(1 == sock->rx_shard_len))
+		return sock->rx_shard;
+	return &sock->rx_shard[ pgm_recv_shard_of (&tsi->gsi, sock->rx_shard_len) ];
+}
+
+/* the pending notification is shared by the receiving threads of all shards */
+static inline
+void
+pgm_rx_pending_lock (
+	pgm_sock_t* const	sock
+	)
+{
+	if (sock->rx_shard_len > 1)
+		pgm_mutex_lock (&sock->pending_mutex);
+}
+
+static inline
+void
+pgm_rx_pending_unlock (
+	pgm_sock_t* const	sock
+	)
+{
+	if (sock->rx_shard_len > 1)
+		pgm_mutex_unlock (&sock->pending_mutex);
+}
+
+PGM_GNUC_INTERNAL bool pgm_recv_shards_create (pgm_sock_t*const, const unsigned);
+PGM_GNUC_INTERNAL void pgm_rx_shards_create (pgm_sock_t*const, const unsigned);
+PGM_GNUC_INTERNAL void pgm_rx_shards_destroy (pgm_sock_t*const);
+PGM_GNUC_INTERNAL bool pgm_recv_shards_bind (pgm_sock_t*const restrict, const struct sockaddr*const restrict, pgm_error_t**restrict);
+PGM_GNUC_INTERNAL bool pgm_recv_shards_set_cpu (pgm_sock_t*const restrict, pgm_error_t**restrict);
+PGM_GNUC_INTERNAL void pgm_recv_shards_close (pgm_sock_t*const);
+#ifdef PGM_HAVE_RECV_SHARDS
+PGM_GNUC_INTERNAL ssize_t pgm_recv_shards_recvmsg (pgm_sock_t*const restrict, struct msghdr*const restrict, const int);
+#endif
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_SHARD_H__ */
@@ -0,0 +1,136 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * same-host transport through a shared memory ring.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_SHM_H__
+#define __PGM_IMPL_SHM_H__
+
+struct pgm_shm_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+/* POSIX shared memory */
+#ifndef _WIN32
+#	define PGM_HAVE_SHM
+#endif
+
+PGM_BEGIN_DECLS
+
+#define PGM_SHM_MAGIC			0x52534750u	/* "PGSR" */
+#define PGM_SHM_VERSION			1
+#define PGM_SHM_SLOTS_DEFAULT		4096
+#define PGM_SHM_SLOTS_MAX		(1u << 20)
+#define PGM_SHM_INTERVAL_DEFAULT	1000		/* usecs between ring polls when idle */
+#define PGM_SHM_ATTACH_INTERVAL		(100 * 1000)	/* usecs between attach attempts */
+#define PGM_SHM_HEADER_LEN		512		/* ring header, slots follow */
+
+/* shared layout, written by one publishing socket and read by any number of
+ * receiving sockets on the host.  packet n occupies slot n % slots, the slot
+ * sequence is 2n+1 whilst written and 2n+2 when complete, such that a reader
+ * detects being lapped without the publisher ever waiting on a reader.
+ */
+struct pgm_shm_ring_t {
+	uint32_t			magic;
+	uint32_t			version;
+	uint32_t			slots;		/* power of two */
+	uint32_t			slot_len;	/* slot header and packet */
+	uint32_t			pid;		/* publisher */
+	uint32_t			is_closed;
+	struct sockaddr_storage		src;		/* publisher unicast NLA */
+	struct sockaddr_storage		dst;		/* multicast group, set on first packet */
+	char				pad[ PGM_SHM_HEADER_LEN - 6 * sizeof(uint32_t) - 2 * sizeof(struct sockaddr_storage) - sizeof(uint64_t) ];
+	uint64_t			head;		/* next packet to write */
+};
+
+struct pgm_shm_slot_t {
+	uint64_t			seq;
+	uint16_t			len;
+	uint16_t			reserved[3];
+	char				data[];		/* PGM header onward */
+};
+
+/* per socket */
+struct pgm_shm_t {
+	char*				name;
+	bool				is_writer;
+	struct pgm_shm_ring_t*		ring;
+	size_t				map_len;
+#ifdef PGM_HAVE_SHM
+	ino_t				ino;		/* created segment, unlinked only if unchanged */
+#endif
+	pgm_mutex_t			mutex;		/* writers */
+	uint64_t			cursor;		/* next packet to read */
+	pgm_time_t			next_attach;
+	unsigned			interval;
+	uint64_t			packets;
+	uint64_t			overruns;	/* packets lapped by the publisher */
+};
+
+static inline
+struct pgm_shm_slot_t*
+pgm_shm_slot (
+	const struct pgm_shm_ring_t*	ring,
+	const uint64_t			n
+	)
+{
+	return (struct pgm_shm_slot_t*)((char*)ring + PGM_SHM_HEADER_LEN + (n & (ring->slots - 1)) * ring->slot_len);
+}
+
+/* receiving socket, attached or waiting for a publisher */
+static inline
+bool
+pgm_shm_is_reader (
+	const struct pgm_shm_t*		shm
+	)
+{
+	return (NULL != shm && !shm->is_writer);
+}
+
+/* packets waiting for a receiving socket, or an attempt to attach is due */
+static inline
+bool
+pgm_shm_is_readable (
+	const struct pgm_shm_t*		shm
+	)
+{
+#ifdef PGM_HAVE_SHM
+	if (NULL == shm || shm->is_writer)
+		return FALSE;
+	if (NULL == shm->ring)
+		return !pgm_time_after (shm->next_attach, pgm_time_update_now());
+	return (shm->cursor != __atomic_load_n (&shm->ring->head, __ATOMIC_ACQUIRE));
+#else
+	(void)shm;
+	return FALSE;
+#endif
+}
+
+PGM_GNUC_INTERNAL bool pgm_shm_open (pgm_sock_t*const restrict, pgm_error_t**restrict);
+PGM_GNUC_INTERNAL void pgm_shm_close (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_shm_write (pgm_sock_t*const restrict, const void*restrict, const size_t, const struct sockaddr*const restrict);
+PGM_GNUC_INTERNAL ssize_t pgm_shm_recvskb (pgm_sock_t*const restrict, struct pgm_sk_buff_t*const restrict, struct sockaddr*const restrict, const socklen_t, struct sockaddr*const restrict, const socklen_t);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_SHM_H__ */
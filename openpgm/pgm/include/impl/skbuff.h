@@ -0,0 +1,82 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ * 
+ * Fixed size socket buffer slab.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if !defined (__PGM_IMPL_FRAMEWORK_H_INSIDE__) && !defined (PGM_COMPILATION)
+#	error "Only <framework.h> can be included directly."
+#endif
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_SKBUFF_H__
+#define __PGM_IMPL_SKBUFF_H__
+
+typedef struct pgm_skb_pool_t pgm_skb_pool_t;
+
+#include <pgm/types.h>
+#include <pgm/skbuff.h>
+#include <impl/list.h>
+#include <impl/thread.h>
+#include <impl/mem.h>
+
+PGM_BEGIN_DECLS
+
+/* default upper bound of idle buffers held by a socket */
+#define PGM_SKB_POOL_DEFAULT_SIZE	1024
+
+struct pgm_skb_pool_t {
+	uint16_t		size;			/* slab payload bytes, at least max_tpdu */
+	volatile uint32_t	max_cached;		/* idle buffer limit */
+	volatile uint32_t	ref_count;		/* owner + outstanding buffers */
+	volatile uint32_t	cached;			/* idle buffers on both lists */
+
+	pgm_spinlock_t		lock;			/* allocation side */
+	pgm_list_t*		free_list;
+	void* volatile		return_list;		/* lock-free push from pgm_free_skb() */
+
+	uint32_t		hits;			/* allocation from idle buffers */
+	uint32_t		misses;			/* allocation from heap */
+
+/* buffers carved from one mapped region, a ring of slots taken in place by
+ * index or reserved idle buffers of a slab.
+ */
+	pgm_mem_region_t	region;
+	size_t			slot_size;		/* header and payload, cache aligned */
+	unsigned		ring_len;		/* slots, 0 for a slab */
+	bool			is_external;		/* region supplied by the application, never unmapped */
+
+/* buffers owned elsewhere, e.g. DPDK mbufs, returned by callback */
+	void		      (*release)(struct pgm_sk_buff_t*);
+};
+
+PGM_GNUC_INTERNAL pgm_skb_pool_t* pgm_skb_pool_create (const uint16_t, const unsigned) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_skb_pool_destroy (pgm_skb_pool_t*const);
+PGM_GNUC_INTERNAL struct pgm_sk_buff_t* pgm_skb_pool_alloc (pgm_skb_pool_t*const, const uint16_t) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL struct pgm_sk_buff_t* pgm_skb_copy_compact (pgm_skb_pool_t*const, const struct pgm_sk_buff_t*const) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_skb_pool_reserve (pgm_skb_pool_t*const, const unsigned, const size_t, const bool, const int);
+PGM_GNUC_INTERNAL unsigned pgm_skb_pool_attach (pgm_skb_pool_t*const, void*const, const size_t);
+PGM_GNUC_INTERNAL size_t pgm_skb_pool_prewarm (pgm_skb_pool_t*const, const unsigned);
+PGM_GNUC_INTERNAL pgm_skb_pool_t* pgm_skb_ring_create (const uint16_t, const unsigned, const size_t, const bool, const int) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL struct pgm_sk_buff_t* pgm_skb_ring_alloc (pgm_skb_pool_t*const, const uint32_t) PGM_GNUC_WARN_UNUSED_RESULT;
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_SKBUFF_H__ */
@@ -0,0 +1,59 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * registry of open sockets for the admin interfaces, indexed by TSI.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_SOCK_REGISTRY_H__
+#define __PGM_IMPL_SOCK_REGISTRY_H__
+
+typedef struct pgm_sock_registry_t pgm_sock_registry_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+PGM_BEGIN_DECLS
+
+/* immutable snapshot of the open sockets in creation order, replaced whole on
+ * every change.  index is an open addressed table of twice the sockets,
+ * rounded to a power of two, keyed by the TSI of each socket.
+ */
+struct pgm_sock_registry_t {
+	unsigned			len;
+	unsigned			mask;		/* index slots - 1 */
+	pgm_sock_t**			index;
+	pgm_sock_registry_t*		next;		/* retired snapshots */
+	unsigned			retired_at;	/* grace period count */
+	pgm_sock_t*			socks[];
+};
+
+PGM_GNUC_INTERNAL void pgm_sock_registry_init (void);
+PGM_GNUC_INTERNAL void pgm_sock_registry_shutdown (void);
+PGM_GNUC_INTERNAL void pgm_sock_registry_add (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_sock_registry_remove (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_sock_registry_rekey (void);
+PGM_GNUC_INTERNAL const pgm_sock_registry_t* pgm_sock_registry_enter (unsigned*const) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_sock_registry_leave (const unsigned);
+PGM_GNUC_INTERNAL pgm_sock_t* pgm_sock_registry_lookup (const pgm_sock_registry_t*const restrict, const pgm_tsi_t*const restrict) PGM_GNUC_PURE PGM_GNUC_WARN_UNUSED_RESULT;
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_SOCK_REGISTRY_H__ */
@@ -56,11 +56,13 @@ PGM_BEGIN_DECLS
 #	define SOCKET				int
 #	define INVALID_SOCKET			(int)-1
 #	define SOCKET_ERROR			(int)-1
+#	define PGM_SOCK_EADDRINUSE		EADDRINUSE
 #	define PGM_SOCK_EAGAIN			EAGAIN
 #	define PGM_SOCK_ECONNRESET		ECONNRESET
 #	define PGM_SOCK_EHOSTUNREACH		EHOSTUNREACH
 #	define PGM_SOCK_EINTR			EINTR
 #	define PGM_SOCK_EINVAL			EINVAL
+#	define PGM_SOCK_EMSGSIZE		EMSGSIZE
 #	define PGM_SOCK_ENETUNREACH		ENETUNREACH
 #	define PGM_SOCK_ENOBUFS			ENOBUFS
 #	define closesocket			close
@@ -97,11 +99,13 @@ pgm_gai_strerror_s (char* buffer, size_t size, int errnum)
 }
 
 #else
+#	define PGM_SOCK_EADDRINUSE		WSAEADDRINUSE
 #	define PGM_SOCK_EAGAIN			WSAEWOULDBLOCK
 #	define PGM_SOCK_ECONNRESET		WSAECONNRESET
 #	define PGM_SOCK_EHOSTUNREACH		WSAEHOSTUNREACH
 #	define PGM_SOCK_EINTR			WSAEINTR
 #	define PGM_SOCK_EINVAL			WSAEINVAL
+#	define PGM_SOCK_EMSGSIZE		WSAEMSGSIZE
 #	define PGM_SOCK_ENETUNREACH		WSAENETUNREACH
 #	define PGM_SOCK_ENOBUFS			WSAENOBUFS
 #	define pgm_get_last_sock_error()	WSAGetLastError()
@@ -126,6 +130,15 @@ pgm_gai_strerror_s (char* buffer, size_t size, int errnum)
 
 #endif
 
+/* per-packet test of the address family, constant in builds without IPv6
+ * such that the hot paths keep only their IPv4 branch.
+ */
+#ifdef PGM_DISABLE_IPV6
+#	define pgm_is_inet6(family)		(FALSE)
+#else
+#	define pgm_is_inet6(family)		(AF_INET6 == (family))
+#endif
+
 PGM_GNUC_INTERNAL sa_family_t pgm_sockaddr_family (const struct sockaddr* sa);
 PGM_GNUC_INTERNAL in_port_t pgm_sockaddr_port (const struct sockaddr* sa);
 PGM_GNUC_INTERNAL socklen_t pgm_sockaddr_len (const struct sockaddr* sa);
@@ -141,6 +154,7 @@ PGM_GNUC_INTERNAL int pgm_sockaddr_hdrincl (const SOCKET s, const sa_family_t sa
 PGM_GNUC_INTERNAL int pgm_sockaddr_pktinfo (const SOCKET s, const sa_family_t sa_family, const bool v);
 PGM_GNUC_INTERNAL int pgm_sockaddr_router_alert (const SOCKET s, const sa_family_t sa_family, const bool v);
 PGM_GNUC_INTERNAL int pgm_sockaddr_tos (const SOCKET s, const sa_family_t sa_family, const int tos);
+PGM_GNUC_INTERNAL int pgm_sockaddr_dontfrag (const SOCKET s, const sa_family_t sa_family, const bool v);
 PGM_GNUC_INTERNAL int pgm_sockaddr_join_group (const SOCKET s, const sa_family_t sa_family, const struct group_req* gr);
 PGM_GNUC_INTERNAL int pgm_sockaddr_leave_group (const SOCKET s, const sa_family_t sa_family, const struct group_req* gr);
 PGM_GNUC_INTERNAL int pgm_sockaddr_block_source (const SOCKET s, const sa_family_t sa_family, const struct group_source_req* gsr);
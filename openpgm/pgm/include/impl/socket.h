@@ -26,16 +26,99 @@
 #define __PGM_IMPL_SOCKET_H__
 
 struct pgm_sock_t;
+struct pgm_recv_batch_t;
+struct pgm_recv_gro_t;
+struct pgm_xdp_t;
+struct pgm_xdp_filter_t;
+struct pgm_dpdk_t;
+struct pgm_uring_t;
+struct pgm_rio_t;
+struct pgm_replay_t;
+struct pgm_shm_t;
+struct pgm_loop_member_t;
+struct pgm_txlog_t;
+struct pgm_fec_thread_t;
+struct pgm_rdata_thread_t;
+struct pgm_async_thread_t;
+struct pgm_checkpoint_peer_t;
+struct pgm_decode_pool_t;
+struct pgm_relay_t;
+struct pgm_standby_t;
+struct pgm_flightrec_t;
+struct pgm_recv_async_t;
+struct pgm_recv_drain_t;
+struct pgm_peer_t;
+struct pgm_rx_shard_t;
+struct pgm_conflate_slot_t;
+struct pgm_demux_member_t;
 
 #include <impl/framework.h>
 #include <impl/txw.h>
+#include <impl/rxw.h>
 #include <impl/source.h>
 
 PGM_BEGIN_DECLS
 
-#ifndef IP_MAX_MEMBERSHIPS
-#	define IP_MAX_MEMBERSHIPS	20
-#endif
+/* blocked sources mirrored in the session filter, further blocks are left to
+ * the kernel membership alone.
+ */
+#define PGM_FILTER_BLOCK_MAX		8
+
+/* sources with a delivery weight or priority other than the default, further
+ * sources are refused.
+ */
+#define PGM_PEER_WEIGHT_MAX		16
+
+/* path MTU lowered on EMSGSIZE is raised back after, RFC 1191 section 6.3 */
+#define PGM_PMTU_RAISE_IVL		pgm_secs(600)
+
+/* packet classes with a DSCP of their own */
+enum {
+	PGM_TX_CLASS_ODATA = 0,
+	PGM_TX_CLASS_RDATA,
+	PGM_TX_CLASS_SPM,
+	PGM_TX_CLASS_NAK,		/* NAK, NNAK and NCF */
+	PGM_TX_CLASS_MAX
+};
+
+/* receiver state of the sources owned by one shard, a receiving thread holds
+ * the shard mutex for the duration of pgm_recvmsgv().  a single shard unless
+ * a receive-only socket reads multiple receive shards.
+ */
+struct pgm_rx_shard_t {
+	pgm_mutex_t			mutex;				/* receiver API */
+	unsigned			index;				/* as pgm_recv_shard_of() */
+	bool				is_reset;
+	unsigned			last_commit;
+	struct pgm_sk_buff_t* restrict	rx_buffer;
+	pgm_peer_table_t* restrict	peers_table;		    /* fast lookup */
+	pgm_slist_t*     restrict	peers_pending;		    /* rxw: have or lost data */
+	pgm_slist_t*			peers_pending_tail;	    /* valid while peers_pending */
+	struct pgm_peer_t** restrict	peers_heap;		    /* min-heap on next state timer */
+	pgm_time_t* restrict		peers_heap_expiry;	    /* heap keys by position, compared without touching peers */
+	unsigned			peers_heap_len;
+	unsigned			peers_heap_size;
+	pgm_time_t			next_poll;		    /* earliest peer timer */
+	struct pgm_nak_batch_t*		nak_batch;		    /* pending timer sweep transmit */
+/* receive auto-tuning sample */
+	pgm_time_t			rx_tune_expiry;		    /* end of sample, 0 before the first */
+	size_t				rx_tune_bytes;		    /* received this sample */
+	uint32_t			rx_tune_ovfl;		    /* SO_RXQ_OVFL counter of the shard socket */
+	uint32_t			rx_tune_ovfl_last;	    /* at start of sample */
+	uint64_t			rx_tune_drops;
+	uint32_t			rx_tune_rate;		    /* bytes per second, fast rise and slow decay */
+	size_t				rx_tune_rcvbuf;		    /* requested of the kernel */
+	unsigned			rx_tune_sqns;		    /* receive window of the shard peers, 0 untuned */
+/* SO_INCOMING_CPU sample */
+	int				rx_cpu;			    /* kernel receive CPU of a recent packet, -1 unknown */
+	pgm_time_t			rx_cpu_expiry;		    /* next sample */
+	volatile uint32_t		decode_ready;		    /* transmission groups decoded off thread */
+/* PGM_CONFLATE key table, open addressing sized to the read vector */
+	struct pgm_conflate_slot_t*	conflate_table;
+	unsigned			conflate_size;		    /* power of two */
+	uint32_t			conflate_gen;		    /* slots of other generations are empty */
+	uint64_t			conflate_drops;
+};
 
 struct pgm_sock_t {
 	sa_family_t			family;				/* communications domain */
@@ -47,17 +130,9 @@ struct pgm_sock_t {
 	in_port_t			udp_encap_mcast_port;
 	uint32_t			rand_node_id;			/* node identifier */
 
-	pgm_rwlock_t			lock;				/* running / destroyed */
-	pgm_mutex_t			receiver_mutex;			/* receiver API */
-	pgm_mutex_t			source_mutex;			/* source API */
-	pgm_spinlock_t			txw_spinlock;			/* transmit window */
-	pgm_mutex_t			send_mutex;			/* non-router alert socket */
-	pgm_mutex_t			timer_mutex;			/* next timer expiration */
-
 	bool				is_bound;
 	bool				is_connected;
 	bool				is_destroyed;
-	bool	            		is_reset;
 	bool				is_abort_on_reset;
 
 	bool				can_send_data;			/* and SPMs */
@@ -65,33 +140,95 @@ struct pgm_sock_t {
 	bool				can_recv_data;			/* send-only */
 	bool				is_edge_triggered_recv;
 	bool				is_nonblocking;
+	bool				is_exclusive;			/* one application thread, no internal locking */
+#ifdef PGM_DEBUG
+	bool				has_owner_thread;
+#	ifndef _WIN32
+	pthread_t			owner_thread;
+#	else
+	DWORD				owner_thread;
+#	endif
+#endif
 
 	struct group_source_req		send_gsr;			/* multicast */
+	struct sockaddr_storage* restrict send_stripe;			/* further ODATA groups */
+	unsigned			send_stripe_len;
+	struct group_req* restrict	send_path;			/* redundant interface and group */
+	SOCKET*		  restrict	send_path_sock;
+	unsigned			send_path_len;
 	struct sockaddr_storage		send_addr;			/* unicast nla */
 	SOCKET				send_sock;
 	SOCKET				send_with_router_alert_sock;
-	struct group_source_req 	recv_gsr[IP_MAX_MEMBERSHIPS];	/* sa_family = 0 terminated */
+	struct group_source_req* restrict recv_gsr;			/* join order, first is primary */
 	unsigned			recv_gsr_len;
+	unsigned			recv_gsr_size;		    /* allocated entries */
+	pgm_hashtable_t* restrict	recv_gsr_index;		    /* group/source/interface → entry */
+	pgm_hashtable_t* restrict	recv_group_index;	    /* group → struct pgm_group_t */
+	pgm_slist_t*	 restrict	recv_group_list;	    /* distinct groups */
 	SOCKET				recv_sock;
+	unsigned			recv_shards;		    /* receive sockets including recv_sock */
+	unsigned			recv_shard_next;	    /* shard of next read */
+	SOCKET*		 restrict	recv_shard_sock;	    /* SO_REUSEPORT peers of recv_sock */
+	bool				use_shared_recv;
+	struct pgm_demux_member_t* restrict demux;		    /* recv_sock shared with other PGM sockets */
 
 	size_t				max_apdu;
 	uint16_t			max_tpdu;
 	uint16_t			max_tsdu;		    /* excluding optional var_pktlen word */
 	uint16_t			max_tsdu_fragment;
+	uint16_t			path_mtu;		    /* TPDU bound of max_tsdu, at most max_tpdu */
+	bool				use_pmtud;		    /* path MTU discovery */
+	uint16_t			pmtu_ceiling;		    /* max_tpdu bounded by the send interface MTU */
+	uint16_t			pmtu_probed;		    /* lowered on EMSGSIZE */
+	pgm_time_t			pmtu_probed_expiry;	    /* raise back to the ceiling */
+	volatile uint32_t		pmtu_target;		    /* applied between APDUs */
+	uint16_t			pmtu_report;		    /* receive interface MTU in POLRs */
 	size_t				iphdr_len;
 	bool				use_multicast_loop;    	    /* and reuseaddr for UDP encapsulation */
 	unsigned			hops;
+	int				tos;			    /* PGM_TOS */
+	int				class_dscp[PGM_TX_CLASS_MAX];   /* -1 for tos */
+	bool				use_class_dscp;
+	int				send_sock_tos;		    /* ODATA, set on the socket */
+	int				router_alert_sock_tos;	    /* RDATA, set on the socket */
 	unsigned			txw_sqns, txw_secs;
+	unsigned			txw_max_sqns;		    /* transmit window allocation, 0 for txw_sqns */
+	bool				use_txw_slots;		    /* transmit window slot ring */
 	unsigned			rxw_sqns, rxw_secs;
+	unsigned			rxw_min_sqns;		    /* initial receive window, 0 for rxw_sqns */
+	bool				use_rxw_shrink;		    /* release idle receive window slots */
+	size_t				rxw_spill_bytes;	    /* unread data beyond the receive window, 0 for none */
+	unsigned			rx_compact_len;		    /* copy smaller TPDUs out of the slab, 0 = off */
+	pgm_skb_pool_t*			compact_pool;		    /* buffers of rx_compact_len */
+	unsigned			rx_reasm_len;		    /* reassemble larger APDUs in place, 0 = off */
+	pgm_skb_pool_t*			reasm_pool[PGM_RXW_REASM_CLASSES];
+	pgm_skb_pool_t*			inflate_pool[PGM_RXW_REASM_CLASSES];	/* decompressed APDUs */
+	pgm_mem_budget_t		mem_budget;		    /* packet buffers held by all windows */
 	ssize_t				txw_max_rte, rxw_max_rte;
 	ssize_t				odata_max_rte;
 	ssize_t				rdata_max_rte;
 	size_t				sndbuf, rcvbuf;		    /* setsockopt (SO_SNDBUF/SO_RCVBUF) */
 
+/* locks are written by every contending thread, padded apart from the
+ * read-mostly configuration above and the send path state below.
+ */
+	char				lock_head_pad[PGM_CACHELINE_PAD];
+	pgm_rwlock_t			lock;				/* running / destroyed */
+	pgm_mutex_t			source_mutex;			/* source API */
+	pgm_spinlock_t			txw_spinlock;			/* transmit window repair path */
+	pgm_mutex_t			send_mutex;			/* non-router alert socket */
+	pgm_mutex_t			timer_mutex;			/* next timer expiration */
+	char				lock_tail_pad[PGM_CACHELINE_PAD];
+
 	pgm_txw_t* restrict    		window;
 	pgm_rate_t			rate_control;
 	pgm_rate_t			odata_rate_control;
 	pgm_rate_t			rdata_rate_control;
+	char*		 restrict	rate_group_name;	/* process-wide parent bucket */
+	ssize_t				rate_group_max;
+	ssize_t				rate_group_min;		/* guaranteed within the group */
+	struct pgm_rate_group_t* restrict rate_group;
+	pgm_rate_t			rate_guarantee;
 	pgm_time_t			adv_ivl;		/* advancing with data */
 	unsigned			adv_mode;		/* 0 = time, 1 = data */
 	bool				is_controlled_spm;
@@ -118,16 +255,87 @@ struct pgm_sock_t {
 	pgm_time_t			ack_bo_ivl;
 	struct sockaddr_storage		acker_nla;
 	uint64_t			acker_loss;
+	uint16_t			acker_loss_rate;	/* 1/65535ths */
+
+	bool				use_tfmcc;		/* equation-based rate instead of PGMCC window */
+	bool				tfmcc_is_slow_start;
+	ssize_t				tfmcc_rate;		/* bytes per second */
+	pgm_time_t			tfmcc_rtt;		/* of the current limiting receiver */
+	pgm_time_t			tfmcc_last_update;
+	pgm_time_t			tfmcc_expiry;		/* no-feedback timer */
+
+	pgm_time_t			poll_ivl;		/* general POLL rounds, 0 = disabled */
+	pgm_time_t			next_general_poll;
+	uint32_t			poll_sqn;		/* of the open round */
+	bool				is_poll_open;
+	unsigned			poll_mask_bits;		/* responding one in 2^bits receivers */
+	uint32_t			polr_count;		/* responses to the open round */
+	uint16_t			polr_loss_rate;		/* worst reported, 1/65535ths */
+	uint32_t			polr_rtt;		/* worst reported, milliseconds */
+	uint16_t			polr_path_mtu;		/* smallest reported, 0 for none */
+	uint32_t			poll_population;	/* estimates of the last closed round */
+	uint16_t			poll_loss_rate;
+	uint32_t			poll_rtt;
+
+	pgm_time_t			txw_ack_hold;		/* minimum hold of acknowledged data, 0 = disabled */
+	unsigned			txw_ack_quorum;		/* receivers, 0 = all known */
+	struct pgm_ack_peer_t*		ack_peers;		/* receivers ACKing within peer expiry */
+	unsigned			ack_peers_len;
+	uint32_t			nak_receiver_rate;	/* sequences per second per receiver, 0 = unlimited */
+	struct pgm_nak_peer_t*		nak_peers;		/* PGM_NAK_PEERS_LEN receivers by address hash */
+	bool				use_nak_batch;
+	struct pgm_ncf_batch_t*		ncf_batch;		/* NAKs pending the receive socket draining */
 
 	pgm_notify_t			ack_notify;
 	pgm_notify_t			rdata_notify;
 
-	pgm_hash_t			last_hash_key;
-	void* restrict			last_hash_value;
-	unsigned			last_commit;
 	size_t				blocklen;		    /* length of buffer blocked */
+	volatile uint64_t		congestion_stall_start;	    /* first send without PGMCC tokens, 0 for none */
+	pgm_time_t			sndbuf_stall_start;	    /* first would-block send, under send_mutex */
+	uint32_t			max_rdata_age;		    /* by the repair path */
+	uint32_t			rdata_age_hist[PGM_RDATA_AGE_BUCKETS];
 	bool				is_apdu_eagain;		    /* writer-lock on window_lock exists as send would block */
 	bool				is_spm_eagain;		    /* writer-lock in receiver */
+	unsigned			tx_batch_size;		    /* datagrams per sendmmsg() */
+	struct pgm_sk_buff_t** restrict	tx_batch;
+	bool				use_multi_producer;	    /* PGM_MULTI_PRODUCER */
+	volatile uint32_t		mp_reserve_sqn;		    /* next sequence reserved by a producer */
+	volatile uint32_t		mp_commit_sqn;		    /* next sequence added to the window */
+	volatile uint32_t		is_mp_committing;	    /* one thread draining mp_ring */
+	struct pgm_sk_buff_t* volatile*	mp_ring;		    /* built packets by sequence awaiting commit */
+	unsigned			async_len;		    /* PGM_SEND_ASYNC */
+	struct pgm_async_thread_t* restrict async_thread;
+	bool				use_udp_gso;		    /* UDP_SEGMENT super-buffers */
+	int				txtime_mode;		    /* PGM_TXTIME qdisc */
+	bool				use_txtime;		    /* SO_TXTIME launch times */
+	int				txtime_clockid;
+	int				rx_timestamp_mode;	    /* PGM_RX_TIMESTAMP requested */
+	bool				use_rx_timestamp;	    /* arrival time in control messages */
+	bool				use_rx_tune;		    /* auto-tune SO_RCVBUF and receive windows */
+	bool				use_rxq_ovfl;		    /* kernel drop counters in control messages */
+	size_t				rx_tune_rcvbuf_min, rx_tune_rcvbuf_max;
+	unsigned			rx_tune_rxw_min_sqns, rx_tune_rxw_max_sqns;
+	unsigned			rx_tune_rxw_secs;
+	pgm_conflate_key_t		conflate_key;		    /* PGM_CONFLATE, NULL delivers every message */
+	void*				conflate_data;
+	bool				use_zerocopy;		    /* MSG_ZEROCOPY transmit of window packets */
+	struct pgm_sk_buff_t** restrict	zerocopy_skb;		    /* packets pinned pending completion */
+	uint32_t			zerocopy_lead;		    /* next completion id */
+	uint32_t			zerocopy_trail;		    /* oldest pending completion id */
+	uint16_t			coalesce_threshold;	    /* framed bytes sending a coalesced TPDU, 0 = off */
+	uint16_t			max_tsdu_coalesce;	    /* framed bytes of one coalesced TPDU */
+	pgm_time_t			coalesce_ivl;		    /* longest wait of a partial TPDU */
+	pgm_time_t			coalesce_expiry;	    /* 0 when no APDUs are pending */
+	char*		 restrict	coalesce_buf;		    /* length prefixed APDUs */
+	uint16_t			coalesce_len;
+	bool				is_coalesce_eagain;	    /* coalesced TPDU blocked in send */
+	int				compress_accel;		    /* LZ4 acceleration of sent APDUs, 0 = off */
+	char*		 restrict	compress_buf;		    /* compressed APDU being sent */
+	unsigned			stream_copy_len;	    /* non-temporal copies of larger APDUs, 0 = off */
+	bool				use_send_timestamp;	    /* OPT_TIMESTAMP on single packet ODATA */
+	char*		 restrict	compress_gather;	    /* vector of one APDU made contiguous */
+	struct pgm_odata_template_t	odata_template[ PGM_ODATA_TEMPLATE_MAX ];
+	struct pgm_spm_template_t	spm_template;
 
 	struct {
 		size_t			    	data_pkt_offset;
@@ -140,19 +348,55 @@ struct pgm_sock_t {
 		unsigned			vector_index;
 		size_t				vector_offset;
 		bool				is_rate_limited;
+		unsigned			batch_len;	/* packets held in tx_batch */
+		unsigned			batch_index;	/* packets of tx_batch sent */
+		bool				is_batch_eagain; /* pgm_send_batch() blocked */
+		size_t				compress_len;	/* of compress_buf, 0 for uncompressed */
+		bool				is_unreliable;	/* pgm_send_unreliable(), skb held apart from the window */
 	} pkt_dontwait_state;
 
+/* pgm_send_begin() to pgm_send_commit(), source_mutex held throughout */
+	struct {
+		bool				is_open;
+		size_t				apdu_length;
+		size_t				offset;		/* bytes appended */
+		uint32_t			first_sqn;
+		struct pgm_sk_buff_t*		skb;		/* fragment being filled */
+		uint16_t			tsdu_length;
+		uint16_t			tsdu_offset;	/* bytes of skb filled */
+		uint32_t			unfolded_odata;
+		bool				is_eagain;	/* skb complete and not sent */
+	} stream_state;
+
 	uint32_t			spm_sqn;
 	unsigned			spm_ambient_interval;	    /* microseconds */
 	unsigned* restrict		spm_heartbeat_interval;     /* zero terminated, zero lead-pad */
 	unsigned			spm_heartbeat_state;	    /* indexof spm_heartbeat_interval */
 	unsigned			spm_heartbeat_len;
+	unsigned			spm_suppress_ivl;	    /* longest ambient gap with data flowing, 0 = off */
+	pgm_time_t			spm_tstamp;		    /* last ambient or heartbeat SPM */
+	pgm_time_t			spm_data_tstamp;	    /* last data, under timer_mutex */
 	unsigned			peer_expiry;		    /* from absence of SPMs */
 	unsigned			spmr_expiry;		    /* waiting for peer SPMRs */
+	unsigned			dlr_sqns;		    /* DLR repair cache per source, 0 = not a DLR */
+	struct pgm_relay_t* restrict	relay;			    /* forward sessions to another network */
+	struct pgm_standby_t* restrict	standby;		    /* hot-standby side channel, primary or standby */
+	volatile bool			is_standby;		    /* mirroring a primary, not sending */
+	struct pgm_flightrec_t* restrict flightrec;		    /* recent protocol events, NULL when disabled */
+	unsigned			flightrec_len;
+	bool				use_flightrec_dump;	    /* log flightrec on reset */
 
 	pgm_rand_t			rand_;			    /* for calculating nak_rb_ivl from nak_bo_ivl */
+	bool				is_loss_burst;		    /* simulated loss channel state */
 	unsigned			nak_data_retries, nak_ncf_retries;
 	pgm_time_t			nak_bo_ivl, nak_rpt_ivl, nak_rdata_ivl;
+	bool				use_adaptive_nak;	    /* per-peer intervals from round-trip time */
+	uint32_t			nak_population;		    /* exponential back-off receivers, 0 = uniform */
+	bool				use_nak_range;		    /* OPT_NAK_RANGE runs of sequences */
+	pgm_time_t			latency_budget;		    /* from loss detection, 0 = unbounded */
+	bool				use_unordered;		    /* deliver complete APDUs beyond gaps */
+	unsigned			recv_quantum;		    /* messages per peer per flush turn, 0 = drain each peer */
+	bool				use_peer_repair;	    /* answer neighbours' NAKs from the receive window */
 	pgm_time_t			next_heartbeat_spm, next_ambient_spm;
 
 	bool				use_proactive_parity;
@@ -161,28 +405,266 @@ struct pgm_sock_t {
 	uint8_t				rs_n;
 	uint8_t				rs_k;
 	uint8_t				rs_proactive_h;		    /* 0 <= proactive-h <= ( n - k ) */
+	bool				use_adaptive_parity;	    /* proactive-h follows observed loss */
+	uint8_t				rs_proactive_h_min, rs_proactive_h_max;
+	uint32_t			adaptive_tg_count;	    /* transmission groups this interval */
+	uint32_t			adaptive_nak_count;	    /* packets NAKed this interval */
 	uint8_t				tg_sqn_shift;
-	struct pgm_sk_buff_t* restrict	rx_buffer;
+	pgm_time_t			fec_idle_ivl;		    /* parity of a partial group after idle, 0 = off */
+	pgm_time_t			fec_idle_expiry;	    /* 0 when no partial group awaits parity */
+	size_t				parity_cache;		    /* on-demand parity budget in bytes */
+	bool				use_fec_thread;		    /* proactive parity off the send path */
+	struct pgm_fec_thread_t* restrict fec_thread;
+	bool				use_rdata_thread;	    /* repairs off the application thread */
+	struct pgm_rdata_thread_t* restrict rdata_thread;
+	unsigned			decode_threads;		    /* parity decoded off the receive path */
+	struct pgm_decode_pool_t* restrict decode_pool;
+	bool				use_tx_priority;	    /* SPM > RDATA > ODATA */
+	unsigned			rdata_share;		    /* percent of payload for repairs under contention */
+	volatile uint32_t		rdata_credit;		    /* signed bytes of repairs due */
+	volatile uint32_t		is_rdata_busy;		    /* one thread sending repairs */
+	unsigned			rx_batch_size;		    /* datagrams per recvmmsg() */
+	struct pgm_recv_batch_t* restrict rx_batch;
+	bool				use_udp_gro;		    /* UDP_GRO coalesced reads */
+	struct pgm_recv_gro_t* restrict	rx_gro;
+	bool				use_zero_checksum;	    /* UDP checksum covers ODATA & RDATA */
+	uint32_t			zero_checksum_sent;
+	uint32_t			zero_checksum_received;
+	bool				use_crc32c;		    /* CRC32C trailer on ODATA & RDATA */
+	uint32_t			xdp_queue_id;
+	int				xdp_xskmap_fd;		    /* AF_XDP redirect map */
+	struct pgm_xdp_t* restrict	xdp;
+	bool				use_xdp_filter;		    /* early drop by XDP program */
+	struct pgm_xdp_filter_t* restrict xdp_filter;
+	unsigned			uring_entries;		    /* provided buffers and in-flight sends */
+	struct pgm_uring_t* restrict	uring;
+	unsigned			rio_entries;		    /* Registered I/O outstanding receives and sends */
+	void*				rio_port;		    /* application completion port */
+	uintptr_t			rio_key;
+	struct pgm_rio_t* restrict	rio;
+	int32_t				dpdk_port_id;		    /* ethdev port, < 0 for kernel sockets */
+	uint16_t			dpdk_queue_id;
+	struct pgm_dpdk_t* restrict	dpdk;
+	char*		 restrict	replay_path;		    /* capture read in place of recv_sock */
+	unsigned			replay_speed;		    /* percent of captured timing, 0 = maximum */
+	struct pgm_replay_t* restrict	replay;
+	char*		 restrict	shm_name;		    /* same-host ring */
+	unsigned			shm_slots;
+	unsigned			shm_interval;		    /* usecs between idle ring polls */
+	struct pgm_shm_t* restrict	shm;
+	char*		 restrict	loop_name;		    /* in-process bus in place of the network */
+	uint32_t			loop_loss_rate;		    /* parts per million */
+	uint32_t			loop_reorder_rate;
+	uint32_t			loop_seed;
+	struct pgm_loop_member_t* restrict loop;
+	char*		 restrict	txlog_path;		    /* segment files continuing the transmit window */
+	unsigned			txlog_segment_sqns;
+	unsigned			txlog_segments;
+	struct pgm_txlog_t* restrict	txlog;
+	bool				use_late_join;		    /* OPT_JOIN recovery of new sources */
+	bool				late_join_is_oldest;
+	uint32_t			late_join_sqn;
+	struct pgm_checkpoint_peer_t* restrict restore;	    /* loaded checkpoint, sources not yet heard from */
+	unsigned			restore_len;
+	unsigned			busy_poll_usecs;	    /* spin budget before blocking */
+	SOCKET				wait_fd;		    /* epoll or kqueue instance */
+	bool				use_event_sock;		    /* one readiness descriptor for event loops */
+	SOCKET				event_sock;		    /* epoll instance of PGM_EVENT_SOCK */
+	SOCKET				event_timer_fd;		    /* timerfd of the next timer or rate expiry */
+	pgm_time_t			event_rate_expiry;
+	struct pgm_recv_async_t* restrict recv_async;		    /* callback delivery thread */
+	struct pgm_recv_drain_t* restrict recv_drain;		    /* kernel drain thread */
+	unsigned			skb_pool_size;		    /* idle packet buffers */
+	pgm_skb_pool_t* restrict	skb_pool;
+	void*				skb_pool_addr;		    /* application packet memory */
+	size_t				skb_pool_len;
+	size_t				hugetlb_size;		    /* page size of slot ring and pool, 0 = base pages */
+	bool				use_mlock;		    /* pin slot ring and pool at bind */
+	uint64_t			pinned_bytes;		    /* locked by pgm_bind() */
+	int				numa_node;		    /* resolved by pgm_bind(), -1 for first touch */
+	unsigned			prewarm_peers;		    /* expected peers readied by pgm_connect(), 0 = lazy */
+	uint64_t			prewarm_bytes;		    /* touched by pgm_connect() */
 
+/* peers are only added or expired by the receiver holding the mutex of the
+ * owning shard, which therefore reads its peers_table without peers_lock.  the
+ * writer-lock is taken on change to exclude other shards and monitoring
+ * readers of peers_list.
+ */
 	pgm_rwlock_t			peers_lock;
-	pgm_hashtable_t* restrict	peers_hashtable;	    /* fast lookup */
 	pgm_list_t*      restrict	peers_list;		    /* easy iteration */
-	pgm_slist_t*     restrict	peers_pending;		    /* rxw: have or lost data */
+	struct pgm_rxw_t**		rxw_spare;		    /* prewarmed windows for new peers */
+	unsigned			rxw_spare_len;
+	pgm_mem_slab_t*			peer_slab;		    /* peers and their windows, NULL = heap */
+	struct pgm_rx_shard_t* restrict	rx_shard;
+	unsigned			rx_shard_len;
+	volatile uint32_t		rx_shard_next;		    /* next shard to try */
+	pgm_mutex_t			pending_mutex;		    /* pending_notify across shards */
 	pgm_notify_t			pending_notify;		    /* timer to rx */
 	bool				is_pending_read;
 	pgm_time_t			next_poll;
 
-	uint32_t			cumulative_stats[PGM_PC_SOURCE_MAX];
-	uint32_t			snap_stats[PGM_PC_SOURCE_MAX];
-	pgm_time_t			snap_time;
+/* cold configuration, only read on setup or filter rebuild */
+	struct sockaddr_storage		block_src[PGM_FILTER_BLOCK_MAX];
+	unsigned			block_src_len;
+	struct pgm_peerweightinfo_t	peer_weight[PGM_PEER_WEIGHT_MAX];
+	unsigned			peer_weight_len;
+	struct sockaddr_storage		dlr_nla;		    /* NAKs redirected to a DLR */
+	int* restrict			incoming_cpu;		    /* SO_INCOMING_CPU by receive shard, NULL for none */
+	unsigned			incoming_cpu_len;
+	pgm_list_t*			opt_log;		    /* options applied before bind, for pgm_socket_clone() */
+
+	struct pgm_stats_ring_t*	rates;			    /* one second samples of cumulative_stats */
+
+/* written from the data path by any thread, padded onto cache lines of their
+ * own so that monitoring readers and neighbouring fields do not share them.
+ */
+	char				stats_head_pad[PGM_CACHELINE_PAD];
+	volatile uint64_t		cumulative_stats[PGM_PC_SOURCE_MAX];
+	char				stats_tail_pad[PGM_CACHELINE_PAD];
 };
 
 
 /* global variables */
 extern pgm_rwlock_t pgm_sock_list_lock;
-extern pgm_slist_t* pgm_sock_list;
 
 size_t pgm_pkt_offset (bool, sa_family_t);
+size_t pgm_coalesce_pkt_offset (sa_family_t);
+void pgm_sock_set_path_mtu (pgm_sock_t*const, const uint16_t);
+
+/* debug builds bind an exclusive socket to the first thread calling into it
+ * and assert every later call comes from the same thread.
+ */
+
+static inline
+void
+pgm_sock_assert_owner (
+	pgm_sock_t*const	sock
+	)
+{
+#ifdef PGM_DEBUG
+#	ifndef _WIN32
+	if (!sock->has_owner_thread) {
+		sock->owner_thread = pthread_self();
+		sock->has_owner_thread = TRUE;
+	}
+	pgm_assert (pthread_equal (sock->owner_thread, pthread_self()));
+#	else
+	if (!sock->has_owner_thread) {
+		sock->owner_thread = GetCurrentThreadId();
+		sock->has_owner_thread = TRUE;
+	}
+	pgm_assert (sock->owner_thread == GetCurrentThreadId());
+#	endif
+#else
+	(void)sock;
+#endif
+}
+
+/* guard the send and receive calls against a concurrent pgm_close(), an
+ * exclusive socket is only ever closed by the thread calling them and skips
+ * the shared reader lock.  background threads always take sock::lock.
+ */
+
+static inline
+bool
+pgm_sock_reader_trylock (
+	pgm_sock_t*const	sock
+	)
+{
+	if (sock->is_exclusive) {
+		pgm_sock_assert_owner (sock);
+		return TRUE;
+	}
+	return pgm_rwlock_reader_trylock (&sock->lock);
+}
+
+static inline
+void
+pgm_sock_reader_unlock (
+	pgm_sock_t*const	sock
+	)
+{
+	if (!sock->is_exclusive)
+		pgm_rwlock_reader_unlock (&sock->lock);
+}
+
+/* internal locks of the data path, no-ops on an exclusive socket.
+ */
+
+static inline
+void
+pgm_sock_mutex_lock (
+	const pgm_sock_t*const	sock,
+	pgm_mutex_t*const	mutex
+	)
+{
+	if (!sock->is_exclusive)
+		pgm_mutex_lock (mutex);
+}
+
+static inline
+bool
+pgm_sock_mutex_trylock (
+	const pgm_sock_t*const	sock,
+	pgm_mutex_t*const	mutex
+	)
+{
+	return sock->is_exclusive || pgm_mutex_trylock (mutex);
+}
+
+static inline
+void
+pgm_sock_mutex_unlock (
+	const pgm_sock_t*const	sock,
+	pgm_mutex_t*const	mutex
+	)
+{
+	if (!sock->is_exclusive)
+		pgm_mutex_unlock (mutex);
+}
+
+static inline
+void
+pgm_sock_spinlock_lock (
+	const pgm_sock_t*const	sock,
+	pgm_spinlock_t*const	spinlock
+	)
+{
+	if (!sock->is_exclusive)
+		pgm_spinlock_lock (spinlock);
+}
+
+static inline
+void
+pgm_sock_spinlock_unlock (
+	const pgm_sock_t*const	sock,
+	pgm_spinlock_t*const	spinlock
+	)
+{
+	if (!sock->is_exclusive)
+		pgm_spinlock_unlock (spinlock);
+}
+
+/* TOS byte of a packet class, the class DSCP in place of PGM_TOS when set */
+static inline
+int
+pgm_tx_class_tos (
+	const pgm_sock_t*const	sock,
+	const unsigned		tx_class
+	)
+{
+	return sock->class_dscp[ tx_class ] < 0 ? sock->tos : (sock->class_dscp[ tx_class ] << 2);
+}
+
+/* bytes after the TSDU of ODATA and RDATA */
+static inline
+size_t
+pgm_data_trailer_len (
+	const pgm_sock_t*const	sock
+	)
+{
+	return sock->use_crc32c ? sizeof(uint32_t) : 0;
+}
 
 PGM_END_DECLS
 
@@ -61,16 +61,171 @@ enum {
 	PGM_PC_SOURCE_SELECTIVE_NNAKS_RECEIVED,
 	PGM_PC_SOURCE_NNAK_ERRORS,
 
+/* sends held up by each limiter, a count then total μs of each pair */
+	PGM_PC_SOURCE_RATE_STALLS,
+	PGM_PC_SOURCE_RATE_STALL_USECS,
+	PGM_PC_SOURCE_ODATA_RATE_STALLS,
+	PGM_PC_SOURCE_ODATA_RATE_STALL_USECS,
+	PGM_PC_SOURCE_CONGESTION_STALLS,		/* PGMCC tokens */
+	PGM_PC_SOURCE_CONGESTION_STALL_USECS,
+	PGM_PC_SOURCE_SNDBUF_STALLS,			/* SO_SNDBUF full */
+	PGM_PC_SOURCE_SNDBUF_STALL_USECS,
+
+/* NAK intake limited per receiver with PGM_NAK_RECEIVER_RATE */
+	PGM_PC_SOURCE_NAKS_RATE_LIMITED,		/* sequences refused */
+	PGM_PC_SOURCE_PATHOLOGICAL_NAKERS,
+
+/* ambient SPMs with PGM_SPM_SUPPRESS_IVL */
+	PGM_PC_SOURCE_SPMS_SENT,
+	PGM_PC_SOURCE_SPMS_SUPPRESSED,
+
+/* pgm_send() with PGM_SEND_ASYNC */
+	PGM_PC_SOURCE_ASYNC_QUEUE_FULL,			/* APDUs refused */
+
 /* marker */
 	PGM_PC_SOURCE_MAX
 };
 
+/* packets built ahead of the commit sequence with PGM_MULTI_PRODUCER, power of 2 */
+#define PGM_MP_RING_LEN		256
+
+/* distance behind the lead of sequences served by RDATA, bucket n counting
+ * ages from 2^(n-1) up to 2^n sequences.
+ */
+#define PGM_RDATA_AGE_BUCKETS	32
+
+/* upper bound of APDUs queued for the sender thread with PGM_SEND_ASYNC */
+#define PGM_SEND_ASYNC_MAX	65536
+
+/* upper bound of datagrams written per sendmmsg() call, Linux UIO_MAXIOV */
+#define PGM_SEND_BATCH_MAX	1024
+
+/* upper bound of multicast groups striping original data besides the send group */
+#define PGM_SEND_STRIPES_MAX	15
+
+/* upper bound of redundant interfaces duplicating multicast besides the send interface */
+#define PGM_SEND_PATHS_MAX	3
+
+/* closed transmission groups pending the proactive parity encoder thread */
+#define PGM_FEC_THREAD_QUEUE_MAX	64
+
+/* transmission groups between adjustments of adaptive proactive parity */
+#define PGM_ADAPTIVE_PARITY_INTERVAL	32
+
+/* POLR responses sought per general POLL round, the matching bit-mask widens
+ * as the estimated receiver population grows.
+ */
+#define PGM_POLR_TARGET			64
+
+/* upper bound of ACKing receivers tracked for trailing edge release */
+#define PGM_ACK_PEERS_MAX		64
+
+struct pgm_ack_peer_t {
+	struct sockaddr_storage	nla;
+	uint32_t		acked_sqn;	/* received without gap in the ACK bitmap */
+	pgm_time_t		expiry;
+};
+
+/* receivers tracked for NAK intake, colliding receivers replace each other */
+#define PGM_NAK_PEERS_LEN		512
+
+/* consecutive seconds a receiver NAKs beyond its rate before reported */
+#define PGM_NAK_PATHOLOGICAL_SECS	10
+
+struct pgm_nak_peer_t {
+	struct sockaddr_storage	nla;
+	pgm_time_t		tstamp;		/* last token refill */
+	uint32_t		tokens;		/* sequences */
+	pgm_time_t		period_start;
+	uint32_t		period_refused;	/* sequences refused since period_start */
+	unsigned		strikes;	/* consecutive periods with refusals */
+	bool			is_pathological;
+};
+
+/* distinct sequences of each kind confirmed by one NAK batch */
+#define PGM_NCF_BATCH_MAX		512
+
+/* NAKs merged until the receive socket drains, confirmed with one NCF list
+ * per 63 distinct sequences and queued for repair once.
+ */
+struct pgm_ncf_batch_t {
+	struct sockaddr_storage	grp_nla;	/* of every NAK in the batch */
+	unsigned		len[2];		/* selective, parity */
+	uint32_t		sqn[2][PGM_NCF_BATCH_MAX];
+};
+
+/* longest wait of coalesced APDUs below the send threshold */
+#define PGM_COALESCE_DEFAULT_IVL	pgm_usecs(200)
+
+/* maximum packets of repair credit carried by the transmit scheduler */
+#define PGM_TX_SCHED_BURST		16
+
+/* prebuilt ODATA headers without congestion control, constant fields set and
+ * per packet fields zero.
+ */
+enum {
+	PGM_ODATA_TEMPLATE_DATA = 0,		/* single packet APDU */
+	PGM_ODATA_TEMPLATE_FRAGMENT,		/* OPT_FRAGMENT */
+	PGM_ODATA_TEMPLATE_COMPRESS,		/* OPT_FRAGMENT, OPT_COMPRESS */
+	PGM_ODATA_TEMPLATE_MAX
+};
+
+struct pgm_odata_template_t {
+	char		header[ sizeof(struct pgm_header) +
+				sizeof(struct pgm_data) +
+				sizeof(struct pgm_opt_length) +
+				sizeof(struct pgm_opt_header) +
+				sizeof(struct pgm_opt_fragment) +
+				sizeof(struct pgm_opt_header) +
+				sizeof(struct pgm_opt_compress) ];
+	uint16_t	header_length;
+	uint32_t	unfolded_header;	/* partial checksum of header */
+};
+
+/* prebuilt heartbeat and ambient SPM, sequence number, window edges and
+ * OPT_JOIN minimum zero
+ */
+struct pgm_spm_template_t {
+	char		header[ sizeof(struct pgm_header) +
+				sizeof(struct pgm_spm6) +
+				sizeof(struct pgm_opt_length) +
+				sizeof(struct pgm_opt_header) +
+				sizeof(struct pgm_opt_join) +
+				sizeof(struct pgm_opt_header) +
+				sizeof(struct pgm_opt_parity_prm) +
+				sizeof(struct pgm_opt_header) +
+				sizeof(struct pgm_opt_nak_range) +
+				sizeof(struct pgm_opt_header) +
+				sizeof(struct pgm_opt_population) +
+				sizeof(struct pgm_opt_header) +
+				sizeof(struct pgm_opt_crc32c) ];
+	uint16_t	header_length;
+	uint16_t	join_offset;		/* of opt_join_min, 0 = no OPT_JOIN */
+	uint32_t	population;		/* advertised, 0 = no OPT_POPULATION */
+	uint32_t	unfolded_header;	/* partial checksum of header */
+};
+
 PGM_GNUC_INTERNAL bool pgm_send_spm (pgm_sock_t*const, const int) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL bool pgm_on_deferred_nak (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_odata_template_init (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_spm_template_init (pgm_sock_t*const);
+PGM_GNUC_INTERNAL int pgm_coalesce_flush (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_fec_idle_flush (pgm_sock_t*const, const pgm_time_t);
+PGM_GNUC_INTERNAL bool pgm_spm_is_suppressed (pgm_sock_t*const, const pgm_time_t);
+PGM_GNUC_INTERNAL bool pgm_fec_thread_create (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_fec_thread_destroy (pgm_sock_t*const);
+PGM_GNUC_INTERNAL bool pgm_rdata_thread_create (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_rdata_thread_destroy (pgm_sock_t*const);
+PGM_GNUC_INTERNAL bool pgm_async_thread_create (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_source_get_stats (pgm_sock_t*const restrict, struct pgm_sourcestatsinfo_t*const restrict);
+PGM_GNUC_INTERNAL void pgm_async_thread_destroy (pgm_sock_t*const);
 PGM_GNUC_INTERNAL bool pgm_on_spmr (pgm_sock_t*const restrict, pgm_peer_t*const restrict, struct pgm_sk_buff_t*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
-PGM_GNUC_INTERNAL bool pgm_on_nak (pgm_sock_t*const restrict, struct pgm_sk_buff_t*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL bool pgm_on_nak (pgm_sock_t*const restrict, const struct sockaddr*const restrict, struct pgm_sk_buff_t*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_ncf_batch_flush (pgm_sock_t*const);
 PGM_GNUC_INTERNAL bool pgm_on_nnak (pgm_sock_t*const restrict, struct pgm_sk_buff_t*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL bool pgm_on_ack (pgm_sock_t*const restrict, struct pgm_sk_buff_t*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL bool pgm_send_poll (pgm_sock_t*const) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL bool pgm_on_polr (pgm_sock_t*const restrict, struct pgm_sk_buff_t*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
 
 PGM_END_DECLS
 
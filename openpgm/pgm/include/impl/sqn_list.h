@@ -26,6 +26,7 @@
 #define __PGM_IMPL_SQN_LIST_H__
 
 struct pgm_sqn_list_t;
+struct pgm_sqn_range_list_t;
 
 #include <impl/framework.h>
 
@@ -36,6 +37,17 @@ struct pgm_sqn_list_t {
 	uint32_t		sqn[63];	/* list of sequence numbers */
 };
 
+/* runs of sequence numbers fitting one OPT_NAK_RANGE */
+#define PGM_SQN_RANGE_MAX	31
+
+struct pgm_sqn_range_list_t {
+	uint8_t			len;
+	struct {
+		uint32_t	sqn;
+		uint32_t	count;
+	}			range[PGM_SQN_RANGE_MAX];
+};
+
 PGM_END_DECLS
 
 #endif /* __PGM_IMPL_SQN_LIST_H__ */
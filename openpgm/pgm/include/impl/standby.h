@@ -0,0 +1,77 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Hot-standby source, the transmit window and sequence state of a primary
+ * mirrored to a standby over a side channel.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_STANDBY_H__
+#define __PGM_IMPL_STANDBY_H__
+
+struct pgm_standby_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+PGM_BEGIN_DECLS
+
+/* SPM sequence numbers skipped on takeover, covering SPMs of the primary
+ * lost on the side channel.
+ */
+#define PGM_STANDBY_SPM_SQN_GAP		16
+
+/* upper bound of one wait of the standby thread on the side channel, such
+ * that close is noticed.
+ */
+#define PGM_STANDBY_POLL_IVL		pgm_msecs(100)
+
+struct pgm_standby_t {
+	SOCKET			side_sock;		/* side channel */
+	struct sockaddr_storage	addr;			/* primary: standby address, standby: bound address */
+	struct sockaddr_storage	peer;			/* primary: bound address, standby: accepted source */
+	bool			is_mirror;		/* primary mirroring, otherwise standby */
+	pgm_time_t		timeout;		/* standby: mirror silence before takeover, 0 = manual */
+
+/* standby thread */
+#ifndef _WIN32
+	pthread_t		thread;
+#else
+	HANDLE			thread;
+#endif
+	bool			has_thread;
+	volatile uint32_t	is_terminated;		/* atomic */
+	volatile uint32_t	is_active;		/* atomic, standby took over */
+	pgm_time_t		last_heard;
+	uint32_t		spm_sqn;		/* of the last mirrored SPM */
+	uint64_t		packets;		/* mirrored */
+	uint64_t		gaps;			/* standby: window restarted on lost mirror packets */
+	uint64_t		refused;		/* standby: packets from other than the primary */
+};
+
+PGM_GNUC_INTERNAL struct pgm_standby_t* pgm_standby_create (pgm_sock_t*const restrict, const struct pgm_standbyinfo_t*const restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_standby_destroy (struct pgm_standby_t*const);
+PGM_GNUC_INTERNAL bool pgm_standby_bind (pgm_sock_t*const restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_standby_mirror (struct pgm_standby_t*const restrict, const void*restrict, const size_t);
+PGM_GNUC_INTERNAL bool pgm_standby_takeover (pgm_sock_t*const);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_STANDBY_H__ */
@@ -0,0 +1,80 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Statistics export: counter names and shared-memory publishing.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_STATS_H__
+#define __PGM_IMPL_STATS_H__
+
+#include <impl/framework.h>
+#include <impl/source.h>
+#include <impl/receiver.h>
+#include <pgm/stats.h>
+
+PGM_BEGIN_DECLS
+
+/* machine readable names of performance counters, unnamed counters are not
+ * exported.
+ */
+struct pgm_counter_name_t {
+	const char*	name;
+	bool		is_gauge;
+};
+
+extern const struct pgm_counter_name_t pgm_source_counter_names[PGM_PC_SOURCE_MAX];
+extern const struct pgm_counter_name_t pgm_receiver_counter_names[PGM_PC_RECEIVER_MAX];
+
+/* samples kept per socket and peer by the sampler thread */
+#define PGM_STATS_RING_LEN		60
+#define PGM_STATS_RING_INTERVAL		1000		/* ms between samples */
+
+/* sampled counters, sources count sent data and received NAKs, receivers
+ * received data, sent NAKs and unrecoverable losses.
+ */
+enum {
+	PGM_STATS_RATE_PACKETS = 0,
+	PGM_STATS_RATE_BYTES,
+	PGM_STATS_RATE_NAKS,
+	PGM_STATS_RATE_LOSSES,
+	PGM_STATS_RATE_MAX
+};
+
+/* written by the sampler thread alone, readers copy under the seqlock with
+ * pgm_stats_ring_rates().
+ */
+struct pgm_stats_ring_t {
+	volatile uint32_t	sequence;		/* odd while sampling */
+	uint32_t		count;			/* samples taken */
+	pgm_time_t		tstamp[PGM_STATS_RING_LEN];
+	uint64_t		value[PGM_STATS_RING_LEN][PGM_STATS_RATE_MAX];
+};
+
+PGM_GNUC_INTERNAL bool pgm_stats_sampler_init (void);
+PGM_GNUC_INTERNAL void pgm_stats_sampler_shutdown (void);
+PGM_GNUC_INTERNAL void pgm_stats_ring_sample (struct pgm_stats_ring_t*const restrict, const uint64_t*const restrict, const pgm_time_t);
+PGM_GNUC_INTERNAL unsigned pgm_stats_ring_rates (const struct pgm_stats_ring_t*const restrict, const unsigned, uint64_t*const restrict);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_STATS_H__ */
+
+/* eof */
@@ -0,0 +1,45 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Equation-based multicast congestion control after TFMCC.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_TFMCC_H__
+#define __PGM_IMPL_TFMCC_H__
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+PGM_BEGIN_DECLS
+
+/* round-trip time assumed before the first feedback */
+#define PGM_TFMCC_INITIAL_RTT		pgm_secs(1)
+
+/* no-feedback timer in round-trip times of the current limiting receiver */
+#define PGM_TFMCC_NOFEEDBACK_RTTS	4
+
+PGM_GNUC_INTERNAL void pgm_tfmcc_init (pgm_sock_t*const, const pgm_time_t);
+PGM_GNUC_INTERNAL void pgm_tfmcc_feedback (pgm_sock_t*const, const uint32_t, const uint16_t, const pgm_time_t);
+PGM_GNUC_INTERNAL void pgm_tfmcc_check (pgm_sock_t*const, const pgm_time_t);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_TFMCC_H__ */
@@ -33,6 +33,9 @@ typedef struct pgm_mutex_t pgm_mutex_t;
 typedef struct pgm_spinlock_t pgm_spinlock_t;
 typedef struct pgm_cond_t pgm_cond_t;
 typedef struct pgm_rwlock_t pgm_rwlock_t;
+typedef struct pgm_lockstat_t pgm_lockstat_t;
+
+struct pgm_string_t;
 
 /* spins before yielding, 200 (Linux) - 4,000 (Windows)
  */
@@ -66,6 +69,21 @@ extern bool pgm_smp_system;
 
 PGM_BEGIN_DECLS
 
+/* with USE_LOCK_STATS, acquisitions of named locks are counted into the
+ * statistics of their name, shared by every lock of that name.  hold times
+ * are sampled of exclusive holders only.
+ */
+#define PGM_LOCKSTAT_HOLD_BUCKETS	24		/* log2 of μs held */
+
+struct pgm_lockstat_t {
+	const char*		name;
+	volatile uint64_t	acquisitions;
+	volatile uint64_t	contended;		/* attempts finding the lock taken */
+	volatile uint64_t	spins;
+	volatile uint64_t	hold_sum;		/* μs */
+	volatile uint64_t	hold[PGM_LOCKSTAT_HOLD_BUCKETS];
+};
+
 struct pgm_mutex_t {
 #ifndef _WIN32
 /* POSIX mutex */
@@ -74,6 +92,10 @@ struct pgm_mutex_t {
 /* Windows process-private adaptive mutex */
 	CRITICAL_SECTION	win32_crit;
 #endif /* !_WIN32 */
+#ifdef USE_LOCK_STATS
+	pgm_lockstat_t*		stats;			/* NULL when unnamed */
+	uint64_t		locked_at;
+#endif
 };
 
 struct pgm_spinlock_t {
@@ -93,6 +115,10 @@ struct pgm_spinlock_t {
 /* GCC atomic-op based spinlock */
 	volatile uint32_t	taken;
 #endif
+#ifdef USE_LOCK_STATS
+	pgm_lockstat_t*		stats;
+	uint64_t		locked_at;
+#endif
 };
 
 struct pgm_cond_t {
@@ -130,12 +156,16 @@ struct pgm_rwlock_t {
 	unsigned		want_to_read;
 	unsigned		want_to_write;
 #endif /* USE_DUMB_RWSPINLOCK */
+#ifdef USE_LOCK_STATS
+	pgm_lockstat_t*		stats;
+	uint64_t		locked_at;		/* by the writer */
+#endif
 };
 
 PGM_GNUC_INTERNAL void pgm_mutex_init (pgm_mutex_t*);
 PGM_GNUC_INTERNAL void pgm_mutex_free (pgm_mutex_t*);
 
-static inline bool pgm_mutex_trylock (pgm_mutex_t* mutex) {
+static inline bool _pgm_mutex_trylock (pgm_mutex_t* mutex) {
 #ifndef _WIN32
 	const int result = pthread_mutex_trylock (&mutex->pthread_mutex);
 	if (EBUSY == result)
@@ -150,7 +180,7 @@ static inline bool pgm_mutex_trylock (pgm_mutex_t* mutex) {
 /* call to pgm_mutex_lock on locked mutex or non-init pointer is undefined.
  */
 
-static inline void pgm_mutex_lock (pgm_mutex_t* mutex) {
+static inline void _pgm_mutex_lock (pgm_mutex_t* mutex) {
 #ifndef _WIN32
 	pthread_mutex_lock (&mutex->pthread_mutex);
 #else
@@ -161,7 +191,7 @@ static inline void pgm_mutex_lock (pgm_mutex_t* mutex) {
 /* call to pgm_mutex_unlock on unlocked mutex or non-init pointer is undefined.
  */
 
-static inline void pgm_mutex_unlock (pgm_mutex_t* mutex) {
+static inline void _pgm_mutex_unlock (pgm_mutex_t* mutex) {
 #ifndef _WIN32
 	pthread_mutex_unlock (&mutex->pthread_mutex);
 #else
@@ -172,7 +202,7 @@ static inline void pgm_mutex_unlock (pgm_mutex_t* mutex) {
 PGM_GNUC_INTERNAL void pgm_spinlock_init (pgm_spinlock_t*);
 PGM_GNUC_INTERNAL void pgm_spinlock_free (pgm_spinlock_t*);
 
-static inline bool pgm_spinlock_trylock (pgm_spinlock_t* spinlock) {
+static inline bool _pgm_spinlock_trylock (pgm_spinlock_t* spinlock) {
 #if defined( USE_TICKET_SPINLOCK )
 	return pgm_ticket_trylock (&spinlock->ticket_lock);
 #elif defined( HAVE_PTHREAD_SPINLOCK )
@@ -191,14 +221,16 @@ static inline bool pgm_spinlock_trylock (pgm_spinlock_t* spinlock) {
 #endif
 }
 
-static inline void pgm_spinlock_lock (pgm_spinlock_t* spinlock) {
+static inline unsigned _pgm_spinlock_lock (pgm_spinlock_t* spinlock) {
 #if defined( USE_TICKET_SPINLOCK )
-	pgm_ticket_lock (&spinlock->ticket_lock);
+	return pgm_ticket_lock (&spinlock->ticket_lock);
 #elif defined( HAVE_PTHREAD_SPINLOCK )
 	pthread_spin_lock (&spinlock->pthread_spinlock);
+	return 0;
 #elif defined( __APPLE__ )
 /* Anderson's exponential back-off */
 	OSSpinLockLock (&spinlock->darwin_spinlock);
+	return 0;
 #elif defined( _WIN32 )
 /* Segall and Rudolph bus-optimised spinlock acquire with Intel's recommendation
  * for a pause instruction for hyper-threading.
@@ -210,6 +242,7 @@ static inline void pgm_spinlock_lock (pgm_spinlock_t* spinlock) {
 				SwitchToThread();
 			else
 				YieldProcessor();
+	return spins;
 #elif defined( __i386__ ) || defined( __i386 ) || defined( __x86_64__ ) || defined( __amd64 )
 /* GCC atomics with x86 pause */
 	unsigned spins = 0;
@@ -219,15 +252,20 @@ static inline void pgm_spinlock_lock (pgm_spinlock_t* spinlock) {
 				sched_yield();
 			else
 				__asm volatile ("pause" ::: "memory");
+	return spins;
 #else
 /* GCC atomics */
+	unsigned spins = 0;
 	while (__sync_lock_test_and_set (&spinlock->taken, 1))
-		while (spinlock->taken)
+		while (spinlock->taken) {
+			spins++;
 			sched_yield();
+		}
+	return spins;
 #endif
 }
 
-static inline void pgm_spinlock_unlock (pgm_spinlock_t* spinlock) {
+static inline void _pgm_spinlock_unlock (pgm_spinlock_t* spinlock) {
 #if defined( USE_TICKET_SPINLOCK )
 	pgm_ticket_unlock (&spinlock->ticket_lock);
 #elif defined( HAVE_PTHREAD_SPINLOCK )
@@ -253,26 +291,28 @@ PGM_GNUC_INTERNAL void pgm_cond_free (pgm_cond_t*);
 
 #if defined( _WIN32 ) && !( _WIN32_WINNT >= 0x600 ) && !defined( USE_DUMB_RWSPINLOCK )
 /* read-write lock implementation for Windows XP */
-PGM_GNUC_INTERNAL void pgm_rwlock_reader_lock (pgm_rwlock_t*);
-PGM_GNUC_INTERNAL bool pgm_rwlock_reader_trylock (pgm_rwlock_t*);
-PGM_GNUC_INTERNAL void pgm_rwlock_reader_unlock(pgm_rwlock_t*);
-PGM_GNUC_INTERNAL void pgm_rwlock_writer_lock (pgm_rwlock_t*);
-PGM_GNUC_INTERNAL bool pgm_rwlock_writer_trylock (pgm_rwlock_t*);
-PGM_GNUC_INTERNAL void pgm_rwlock_writer_unlock (pgm_rwlock_t*);
+PGM_GNUC_INTERNAL unsigned _pgm_rwlock_reader_lock (pgm_rwlock_t*);
+PGM_GNUC_INTERNAL bool _pgm_rwlock_reader_trylock (pgm_rwlock_t*);
+PGM_GNUC_INTERNAL void _pgm_rwlock_reader_unlock (pgm_rwlock_t*);
+PGM_GNUC_INTERNAL unsigned _pgm_rwlock_writer_lock (pgm_rwlock_t*);
+PGM_GNUC_INTERNAL bool _pgm_rwlock_writer_trylock (pgm_rwlock_t*);
+PGM_GNUC_INTERNAL void _pgm_rwlock_writer_unlock (pgm_rwlock_t*);
 #else
-static inline void pgm_rwlock_reader_lock (pgm_rwlock_t* rwlock) {
+static inline unsigned _pgm_rwlock_reader_lock (pgm_rwlock_t* rwlock) {
 #	if defined( USE_DUMB_RWSPINLOCK )
 /* User-space read/write lock */
-	pgm_rwspinlock_reader_lock (&rwlock->rwspinlock);
+	return pgm_rwspinlock_reader_lock (&rwlock->rwspinlock);
 #	elif defined( _WIN32 ) && ( _WIN32_WINNT >= 0x0600 )
 /* Vista+ slim read/write lock */
 	AcquireSRWLockShared (&rwlock->win32_rwlock);
+	return 0;
 #	else
 /* POSIX read/write lock */
 	pthread_rwlock_rdlock (&rwlock->pthread_rwlock);
+	return 0;
 #	endif
 }
-static inline bool pgm_rwlock_reader_trylock (pgm_rwlock_t* rwlock) {
+static inline bool _pgm_rwlock_reader_trylock (pgm_rwlock_t* rwlock) {
 #	if defined( USE_DUMB_RWSPINLOCK )
 	return pgm_rwspinlock_reader_trylock (&rwlock->rwspinlock);
 #	elif defined( _WIN32 ) && ( _WIN32_WINNT >= 0x0600 )
@@ -281,7 +321,7 @@ static inline bool pgm_rwlock_reader_trylock (pgm_rwlock_t* rwlock) {
 	return !pthread_rwlock_tryrdlock (&rwlock->pthread_rwlock);
 #	endif
 }
-static inline void pgm_rwlock_reader_unlock(pgm_rwlock_t* rwlock) {
+static inline void _pgm_rwlock_reader_unlock (pgm_rwlock_t* rwlock) {
 #	if defined( USE_DUMB_RWSPINLOCK )
 	pgm_rwspinlock_reader_unlock (&rwlock->rwspinlock);
 #	elif defined( _WIN32 ) && ( _WIN32_WINNT >= 0x0600 )
@@ -290,16 +330,18 @@ static inline void pgm_rwlock_reader_unlock(pgm_rwlock_t* rwlock) {
 	pthread_rwlock_unlock (&rwlock->pthread_rwlock);
 #	endif
 }
-static inline void pgm_rwlock_writer_lock (pgm_rwlock_t* rwlock) {
+static inline unsigned _pgm_rwlock_writer_lock (pgm_rwlock_t* rwlock) {
 #	if defined( USE_DUMB_RWSPINLOCK )
-	pgm_rwspinlock_writer_lock (&rwlock->rwspinlock);
+	return pgm_rwspinlock_writer_lock (&rwlock->rwspinlock);
 #	elif defined( _WIN32 ) && ( _WIN32_WINNT >= 0x0600 )
 	AcquireSRWLockExclusive (&rwlock->win32_rwlock);
+	return 0;
 #	else
 	pthread_rwlock_wrlock (&rwlock->pthread_rwlock);
+	return 0;
 #	endif
 }
-static inline bool pgm_rwlock_writer_trylock (pgm_rwlock_t* rwlock) {
+static inline bool _pgm_rwlock_writer_trylock (pgm_rwlock_t* rwlock) {
 #	if defined( USE_DUMB_RWSPINLOCK )
 	return pgm_rwspinlock_writer_trylock (&rwlock->rwspinlock);
 #	elif defined( _WIN32 ) && ( _WIN32_WINNT >= 0x0600 )
@@ -308,7 +350,7 @@ static inline bool pgm_rwlock_writer_trylock (pgm_rwlock_t* rwlock) {
 	return !pthread_rwlock_trywrlock (&rwlock->pthread_rwlock);
 #	endif
 }
-static inline void pgm_rwlock_writer_unlock (pgm_rwlock_t* rwlock) {
+static inline void _pgm_rwlock_writer_unlock (pgm_rwlock_t* rwlock) {
 #	if defined( USE_DUMB_RWSPINLOCK )
 	pgm_rwspinlock_writer_unlock (&rwlock->rwspinlock);
 #	elif defined( _WIN32 ) && ( _WIN32_WINNT >= 0x0600 )
@@ -322,8 +364,161 @@ static inline void pgm_rwlock_writer_unlock (pgm_rwlock_t* rwlock) {
 PGM_GNUC_INTERNAL void pgm_rwlock_init (pgm_rwlock_t*);
 PGM_GNUC_INTERNAL void pgm_rwlock_free (pgm_rwlock_t*);
 
+/* name a lock for statistics before it is shared, no-op without
+ * USE_LOCK_STATS.
+ */
+PGM_GNUC_INTERNAL void pgm_mutex_set_name (pgm_mutex_t*, const char*);
+PGM_GNUC_INTERNAL void pgm_spinlock_set_name (pgm_spinlock_t*, const char*);
+PGM_GNUC_INTERNAL void pgm_rwlock_set_name (pgm_rwlock_t*, const char*);
+PGM_GNUC_INTERNAL void pgm_lockstat_write_html_all (struct pgm_string_t*);
+
+#ifdef USE_LOCK_STATS
+PGM_GNUC_INTERNAL uint64_t pgm_lockstat_acquired (pgm_lockstat_t*, const bool, const unsigned);
+PGM_GNUC_INTERNAL void pgm_lockstat_busy (pgm_lockstat_t*);
+PGM_GNUC_INTERNAL void pgm_lockstat_released (pgm_lockstat_t*, const uint64_t);
+#endif
+
+/* lock wrappers, uninstrumented locks go straight to the implementation.
+ */
+
+static inline bool pgm_mutex_trylock (pgm_mutex_t* mutex) {
+#ifdef USE_LOCK_STATS
+	if (NULL != mutex->stats) {
+		if (!_pgm_mutex_trylock (mutex)) {
+			pgm_lockstat_busy (mutex->stats);
+			return FALSE;
+		}
+		mutex->locked_at = pgm_lockstat_acquired (mutex->stats, FALSE, 0);
+		return TRUE;
+	}
+#endif
+	return _pgm_mutex_trylock (mutex);
+}
+
+static inline void pgm_mutex_lock (pgm_mutex_t* mutex) {
+#ifdef USE_LOCK_STATS
+	if (NULL != mutex->stats) {
+		const bool is_contended = !_pgm_mutex_trylock (mutex);
+		if (is_contended)
+			_pgm_mutex_lock (mutex);
+		mutex->locked_at = pgm_lockstat_acquired (mutex->stats, is_contended, 0);
+		return;
+	}
+#endif
+	_pgm_mutex_lock (mutex);
+}
+
+static inline void pgm_mutex_unlock (pgm_mutex_t* mutex) {
+#ifdef USE_LOCK_STATS
+	if (NULL != mutex->stats)
+		pgm_lockstat_released (mutex->stats, mutex->locked_at);
+#endif
+	_pgm_mutex_unlock (mutex);
+}
+
+static inline bool pgm_spinlock_trylock (pgm_spinlock_t* spinlock) {
+#ifdef USE_LOCK_STATS
+	if (NULL != spinlock->stats) {
+		if (!_pgm_spinlock_trylock (spinlock)) {
+			pgm_lockstat_busy (spinlock->stats);
+			return FALSE;
+		}
+		spinlock->locked_at = pgm_lockstat_acquired (spinlock->stats, FALSE, 0);
+		return TRUE;
+	}
+#endif
+	return _pgm_spinlock_trylock (spinlock);
+}
+
+static inline void pgm_spinlock_lock (pgm_spinlock_t* spinlock) {
+#ifdef USE_LOCK_STATS
+	if (NULL != spinlock->stats) {
+		const bool is_contended = !_pgm_spinlock_trylock (spinlock);
+		const unsigned spins = is_contended ? _pgm_spinlock_lock (spinlock) : 0;
+		spinlock->locked_at = pgm_lockstat_acquired (spinlock->stats, is_contended, spins);
+		return;
+	}
+#endif
+	_pgm_spinlock_lock (spinlock);
+}
+
+static inline void pgm_spinlock_unlock (pgm_spinlock_t* spinlock) {
+#ifdef USE_LOCK_STATS
+	if (NULL != spinlock->stats)
+		pgm_lockstat_released (spinlock->stats, spinlock->locked_at);
+#endif
+	_pgm_spinlock_unlock (spinlock);
+}
+
+static inline void pgm_rwlock_reader_lock (pgm_rwlock_t* rwlock) {
+#ifdef USE_LOCK_STATS
+	if (NULL != rwlock->stats) {
+		const bool is_contended = !_pgm_rwlock_reader_trylock (rwlock);
+		const unsigned spins = is_contended ? _pgm_rwlock_reader_lock (rwlock) : 0;
+		pgm_lockstat_acquired (rwlock->stats, is_contended, spins);
+		return;
+	}
+#endif
+	_pgm_rwlock_reader_lock (rwlock);
+}
+
+static inline bool pgm_rwlock_reader_trylock (pgm_rwlock_t* rwlock) {
+#ifdef USE_LOCK_STATS
+	if (NULL != rwlock->stats) {
+		if (!_pgm_rwlock_reader_trylock (rwlock)) {
+			pgm_lockstat_busy (rwlock->stats);
+			return FALSE;
+		}
+		pgm_lockstat_acquired (rwlock->stats, FALSE, 0);
+		return TRUE;
+	}
+#endif
+	return _pgm_rwlock_reader_trylock (rwlock);
+}
+
+static inline void pgm_rwlock_reader_unlock (pgm_rwlock_t* rwlock) {
+	_pgm_rwlock_reader_unlock (rwlock);
+}
+
+static inline void pgm_rwlock_writer_lock (pgm_rwlock_t* rwlock) {
+#ifdef USE_LOCK_STATS
+	if (NULL != rwlock->stats) {
+		const bool is_contended = !_pgm_rwlock_writer_trylock (rwlock);
+		const unsigned spins = is_contended ? _pgm_rwlock_writer_lock (rwlock) : 0;
+		rwlock->locked_at = pgm_lockstat_acquired (rwlock->stats, is_contended, spins);
+		return;
+	}
+#endif
+	_pgm_rwlock_writer_lock (rwlock);
+}
+
+static inline bool pgm_rwlock_writer_trylock (pgm_rwlock_t* rwlock) {
+#ifdef USE_LOCK_STATS
+	if (NULL != rwlock->stats) {
+		if (!_pgm_rwlock_writer_trylock (rwlock)) {
+			pgm_lockstat_busy (rwlock->stats);
+			return FALSE;
+		}
+		rwlock->locked_at = pgm_lockstat_acquired (rwlock->stats, FALSE, 0);
+		return TRUE;
+	}
+#endif
+	return _pgm_rwlock_writer_trylock (rwlock);
+}
+
+static inline void pgm_rwlock_writer_unlock (pgm_rwlock_t* rwlock) {
+#ifdef USE_LOCK_STATS
+	if (NULL != rwlock->stats)
+		pgm_lockstat_released (rwlock->stats, rwlock->locked_at);
+#endif
+	_pgm_rwlock_writer_unlock (rwlock);
+}
+
 PGM_GNUC_INTERNAL void pgm_thread_init (void);
 PGM_GNUC_INTERNAL void pgm_thread_shutdown (void);
+PGM_GNUC_INTERNAL void pgm_thread_attr_init (void);
+PGM_GNUC_INTERNAL void pgm_thread_setup (const char*);
+PGM_GNUC_INTERNAL void pgm_thread_setup_nth (const char*, const unsigned);
 
 static inline
 void
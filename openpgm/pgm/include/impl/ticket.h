@@ -95,79 +95,7 @@ union pgm_ticket_t {
 
 /* additional required atomic ops */
 
-/* 32-bit word CAS, returns TRUE if swap occurred.
- *
- *	if (*atomic == oldval) {
- *		*atomic = newval;
- *		return TRUE;
- *	}
- *	return FALSE;
- *
- * Sun Studio on x86 GCC-compatible assembler not implemented.
- */
-
-static inline
-bool
-pgm_atomic_compare_and_exchange32 (
-	volatile uint32_t*	atomic,
-	const uint32_t		newval,
-	const uint32_t		oldval
-	)
-{
-#if defined( __GNUC__ ) && ( defined( __i386__ ) || defined( __x86_64__ ) )
-/* GCC assembler */
-	uint8_t result;
-	__asm__ volatile ("lock; cmpxchgl %2, %0\n\t"
-			  "setz %1\n\t"
-			: "+m" (*atomic), "=q" (result)
-			: "ir" (newval),  "a" (oldval)
-			: "memory", "cc"  );
-	return (bool)result;
-#elif defined( __SUNPRO_C ) && ( defined( __i386__ ) || defined( __x86_64__ ) )
-/* GCC-compatible assembler */
-	uint8_t result;
-	__asm__ volatile ("lock; cmpxchgl %2, %0\n\t"
-			  "setz %1\n\t"
-			: "+m" (*atomic), "=q" (result)
-			: "r" (newval),  "a" (oldval)
-			: "memory", "cc"  );
-	return (bool)result;
-#elif defined( __sun ) || defined( _NetBSD__ )
-/* Solaris and NetBSD intrinsic */
-	const uint32_t original = atomic_cas_32 (atomic, oldval, newval);
-	return (oldval == original);
-#elif defined( __APPLE__ )
-/* Darwin intrinsic */
-	return OSAtomicCompareAndSwap32Barrier ((int32_t)oldval, (int32_t)newval, (volatile int32_t*)atomic);
-#elif defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 401 )
-/* GCC 4.0.1 intrinsic */
-	return __sync_bool_compare_and_swap (atomic, oldval, newval);
-#elif defined( _AIX )
-	return compare_and_swap ((int *)atomic, (int *)&oldval, newval);
-#elif defined( _WIN32 )
-/* Windows intrinsic */
-	const uint32_t original = _InterlockedCompareExchange ((volatile LONG*)atomic, newval, oldval);
-	return (oldval == original);
-#endif
-}
-
 #if defined( _WIN64 )
-/* returns TRUE if swap occurred
- */
-
-static inline
-bool
-pgm_atomic_compare_and_exchange64 (
-	volatile uint64_t*	atomic,
-	const uint64_t		newval,
-	const uint64_t		oldval
-	)
-{
-/* Windows intrinsic */
-	const uint64_t original = _InterlockedCompareExchange64 ((volatile LONGLONG*)atomic, newval, oldval);
-	return (oldval == original);
-}
-
 /* returns original atomic value
  */
 
@@ -181,18 +109,6 @@ pgm_atomic_fetch_and_inc32 (
 	return nv - 1;
 }
 
-/* 64-bit word load
- */
-
-static inline
-uint64_t
-pgm_atomic_read64 (
-	const volatile uint64_t* atomic
-	)
-{
-	return *atomic;
-}
-
 #else
 /* 16-bit word addition.
  */
@@ -365,20 +281,23 @@ static inline bool pgm_ticket_trylock (pgm_ticket_t* ticket) {
 	comparand.pgm_tkt_user = comparand.pgm_tkt_ticket = exchange.pgm_tkt_ticket = user;
 	exchange.pgm_tkt_user = user + 1;
 #ifdef _WIN64
-	return pgm_atomic_compare_and_exchange64 (&ticket->pgm_tkt_data64, exchange.pgm_tkt_data64, comparand.pgm_tkt_data64);
+	return pgm_atomic_compare_and_exchange64 (&ticket->pgm_tkt_data64, comparand.pgm_tkt_data64, exchange.pgm_tkt_data64);
 #else
-	return pgm_atomic_compare_and_exchange32 (&ticket->pgm_tkt_data32, exchange.pgm_tkt_data32, comparand.pgm_tkt_data32);
+	return pgm_atomic_compare_and_exchange32 (&ticket->pgm_tkt_data32, comparand.pgm_tkt_data32, exchange.pgm_tkt_data32);
 #endif
 }
 
-static inline void pgm_ticket_lock (pgm_ticket_t* ticket) {
+/* returns spins waiting for the ticket, before yielding on a uniprocessor.
+ */
+
+static inline unsigned pgm_ticket_lock (pgm_ticket_t* ticket) {
 #ifdef _WIN64
 	const uint32_t user = pgm_atomic_fetch_and_inc32 (&ticket->pgm_tkt_user);
 #else
 	const uint16_t user = pgm_atomic_fetch_and_inc16 (&ticket->pgm_tkt_user);
 #endif
-#if defined( _WIN32 ) || defined( __i386__ ) || defined( __i386 ) || defined( __x86_64__ ) || defined( __amd64 )
 	unsigned spins = 0;
+#if defined( _WIN32 ) || defined( __i386__ ) || defined( __i386 ) || defined( __x86_64__ ) || defined( __amd64 )
 	while (ticket->pgm_tkt_ticket != user)
 		if (!pgm_smp_system || (++spins > PGM_ADAPTIVE_MUTEX_SPINCOUNT))
 #	ifdef _WIN32
@@ -393,9 +312,12 @@ static inline void pgm_ticket_lock (pgm_ticket_t* ticket) {
 			__asm volatile ("pause" ::: "memory");
 #	endif
 #else
-	while (ticket->pgm_tkt_ticket != user)
+	while (ticket->pgm_tkt_ticket != user) {
+		spins++;
 		sched_yield();
+	}
 #endif
+	return spins;
 }
 
 static inline void pgm_ticket_unlock (pgm_ticket_t* ticket) {
@@ -43,10 +43,43 @@ typedef pgm_time_t (*pgm_time_update_func)(void);
 #define pgm_time_after_eq(a,b)  ( (a) >= (b) )
 #define pgm_time_before_eq(a,b) ( pgm_time_after_eq((b),(a)) )
 
+#if defined(_MSC_VER)
+#	define PGM_THREAD_LOCAL		__declspec(thread)
+#else
+#	define PGM_THREAD_LOCAL		__thread
+#endif
+
 extern pgm_time_update_func		pgm_time_update_now;
 
+/* coarse clock, enabled with PGM_TIMER_COARSE, where the receive path shares
+ * one reading per call or receive batch.
+ */
+extern bool				pgm_time_is_coarse;
+extern PGM_THREAD_LOCAL pgm_time_t	pgm_time_cached;
+
 PGM_GNUC_INTERNAL bool pgm_time_init (pgm_error_t**) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL bool pgm_time_shutdown (void);
+PGM_GNUC_INTERNAL pgm_time_t pgm_time_wall_now (void);
+
+/* read the clock and update the calling thread's cached time.
+ */
+
+static inline
+pgm_time_t
+pgm_time_refresh (void)
+{
+	return pgm_time_cached = pgm_time_update_now();
+}
+
+/* time of the last refresh by this thread in coarse mode, otherwise current time.
+ */
+
+static inline
+pgm_time_t
+pgm_time_coarse_now (void)
+{
+	return pgm_time_is_coarse ? pgm_time_cached : pgm_time_update_now();
+}
 
 PGM_END_DECLS
 
@@ -26,14 +26,18 @@
 #define __PGM_IMPL_TIMER_H__
 
 #include <impl/framework.h>
+#include <impl/engine.h>
 #include <impl/socket.h>
 
 PGM_BEGIN_DECLS
 
 PGM_GNUC_INTERNAL bool pgm_timer_prepare (pgm_sock_t*const);
 PGM_GNUC_INTERNAL bool pgm_timer_check (pgm_sock_t*const);
+PGM_GNUC_INTERNAL bool pgm_timer_check_at (pgm_sock_t*const, const pgm_time_t);
 PGM_GNUC_INTERNAL pgm_time_t pgm_timer_expiration (pgm_sock_t*const);
-PGM_GNUC_INTERNAL bool pgm_timer_dispatch (pgm_sock_t*const);
+PGM_GNUC_INTERNAL bool pgm_timer_dispatch (pgm_sock_t*const restrict, struct pgm_rx_shard_t*const restrict);
+PGM_GNUC_INTERNAL void pgm_timer_event_arm (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_timer_event_rate (pgm_sock_t*const, const pgm_time_t);
 
 static inline
 void
@@ -41,7 +45,7 @@ pgm_timer_lock (
 	pgm_sock_t* const sock
 	)
 {
-	if (sock->can_send_data)
+	if (!sock->is_exclusive && (sock->can_send_data || sock->rx_shard_len > 1))
 		pgm_mutex_lock (&sock->timer_mutex);
 }
 
@@ -51,10 +55,37 @@ pgm_timer_unlock (
 	pgm_sock_t* const sock
 	)
 {
-	if (sock->can_send_data)
+	if (!sock->is_exclusive && (sock->can_send_data || sock->rx_shard_len > 1))
 		pgm_mutex_unlock (&sock->timer_mutex);
 }
 
+/* bring the next timer expiration forward for a shard and the socket.
+ */
+
+static inline
+void
+pgm_timer_pull (
+	pgm_sock_t*	       const restrict sock,
+	struct pgm_rx_shard_t* const restrict shard,
+	const pgm_time_t		      expiration
+	)
+{
+	bool is_pulled = FALSE;
+	pgm_timer_lock (sock);
+	if (pgm_time_after (sock->next_poll, expiration)) {
+		sock->next_poll = expiration;
+		is_pulled = TRUE;
+	}
+	if (pgm_time_after (shard->next_poll, expiration))
+		shard->next_poll = expiration;
+	pgm_timer_unlock (sock);
+	if (is_pulled) {
+		pgm_engine_timer_wake (expiration);
+		if (INVALID_SOCKET != sock->event_timer_fd)
+			pgm_timer_event_arm (sock);
+	}
+}
+
 PGM_END_DECLS
 
 #endif /* __PGM_IMPL_TIMER_H__ */
@@ -0,0 +1,116 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Trace events of the protocol probes in Chrome trace-event JSON, buffered
+ * per thread and appended to a file for viewing as a timeline.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if !defined (__PGM_IMPL_FRAMEWORK_H_INSIDE__) && !defined (PGM_COMPILATION)
+#	error "Only <framework.h> can be included directly."
+#endif
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_TRACE_EVENT_H__
+#define __PGM_IMPL_TRACE_EVENT_H__
+
+typedef struct pgm_trace_event_t pgm_trace_event_t;
+typedef struct pgm_trace_buffer_t pgm_trace_buffer_t;
+
+#include <pgm/types.h>
+#include <pgm/time.h>
+#include <impl/slist.h>
+#include <impl/time.h>
+
+PGM_BEGIN_DECLS
+
+/* events per thread between writes to the file */
+#define PGM_TRACE_BUFFER_LEN		4096
+
+struct pgm_trace_event_t {
+	pgm_time_t		tstamp;
+	const char*		name;			/* static probe name */
+	uint64_t		arg[3];
+};
+
+/* written only by the owning thread, the thread appends a full buffer to the
+ * file itself and the remainder at shutdown.
+ */
+struct pgm_trace_buffer_t {
+	uint32_t		tid;			/* trace thread number */
+	uint32_t		len;
+	uint32_t		countdown;		/* events until the next sample */
+	pgm_slist_t		link;
+	pgm_trace_event_t	events[PGM_TRACE_BUFFER_LEN];
+};
+
+/* zero when not tracing */
+extern uint32_t					pgm_trace_event_generation;
+extern uint32_t					pgm_trace_event_sample;
+extern pgm_time_t				pgm_trace_event_expiry;
+extern PGM_THREAD_LOCAL pgm_trace_buffer_t*	pgm_trace_event_local;
+extern PGM_THREAD_LOCAL uint32_t		pgm_trace_event_local_generation;
+
+PGM_GNUC_INTERNAL void pgm_trace_event_init (void);
+PGM_GNUC_INTERNAL void pgm_trace_event_shutdown (void);
+PGM_GNUC_INTERNAL pgm_trace_buffer_t* pgm_trace_event_attach (void);
+PGM_GNUC_INTERNAL void pgm_trace_event_flush (pgm_trace_buffer_t*);
+
+/* record one sampled event in the calling thread's buffer, a single branch
+ * when tracing is not enabled.
+ */
+
+static inline
+void
+pgm_trace_event_add (
+	const char*		name,
+	const uint64_t		a,
+	const uint64_t		b,
+	const uint64_t		c
+	)
+{
+	pgm_trace_buffer_t* buffer = pgm_trace_event_local;
+
+	if (PGM_LIKELY(0 == pgm_trace_event_generation))
+		return;
+	if (PGM_UNLIKELY(NULL == buffer || pgm_trace_event_local_generation != pgm_trace_event_generation) &&
+	    NULL == (buffer = pgm_trace_event_attach()))
+		return;
+	if (--buffer->countdown > 0)
+		return;
+	buffer->countdown = pgm_trace_event_sample;
+
+	const pgm_time_t now = pgm_time_update_now();
+	if (PGM_UNLIKELY(pgm_time_after_eq (now, pgm_trace_event_expiry)))
+		return;
+	pgm_trace_event_t* e = &buffer->events[ buffer->len ];
+	e->tstamp	= now;
+	e->name		= name;
+	e->arg[0]	= a;
+	e->arg[1]	= b;
+	e->arg[2]	= c;
+	if (PGM_TRACE_BUFFER_LEN == ++buffer->len)
+		pgm_trace_event_flush (buffer);
+}
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_TRACE_EVENT_H__ */
+
+/* eof */
@@ -0,0 +1,140 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * transmit log, packets leaving the transmit window spilled to memory-mapped
+ * segment files.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_TXLOG_H__
+#define __PGM_IMPL_TXLOG_H__
+
+typedef struct pgm_txlog_t pgm_txlog_t;
+
+#include <impl/framework.h>
+
+/* POSIX memory-mapped files */
+#ifndef _WIN32
+#	define PGM_HAVE_TXLOG
+#endif
+
+PGM_BEGIN_DECLS
+
+#define PGM_TXLOG_MAGIC			0x4c585450u	/* "PTXL" */
+#define PGM_TXLOG_VERSION		1
+#define PGM_TXLOG_SEGMENT_SQNS_DEFAULT	(64 * 1024)
+#define PGM_TXLOG_SEGMENTS_DEFAULT	16
+#define PGM_TXLOG_SEGMENTS_MAX		1024
+#define PGM_TXLOG_HEADER_LEN		4096		/* segment header, records follow */
+#define PGM_TXLOG_REQUESTS_MAX		256		/* outstanding runs of repair requests */
+
+/* segment file header, one file per segment_sqns consecutive sequences */
+struct pgm_txlog_header_t {
+	uint32_t			magic;
+	uint32_t			version;
+	pgm_tsi_t			tsi;
+	uint32_t			first_sqn;
+	uint32_t			sqns;
+	uint32_t			record_len;
+};
+
+/* fixed length record of sequence n at header + (n - first_sqn) × record_len */
+struct pgm_txlog_record_t {
+	uint32_t			sequence;
+	uint32_t			unfolded_checksum;	/* of TSDU */
+	uint16_t			tpdu_length;		/* PGM header onward */
+	uint16_t			header_length;		/* PGM header and options */
+	uint32_t			reserved;
+	char				tpdu[];
+};
+
+struct pgm_txlog_segment_t {
+	uint32_t			first_sqn;
+	char*				addr;
+};
+
+/* a run of requested sequences */
+struct pgm_txlog_request_t {
+	uint32_t			sequence;
+	uint32_t			count;
+};
+
+struct pgm_txlog_t {
+	const pgm_tsi_t* restrict	tsi;
+	char*				path;			/* segment file prefix */
+	uint16_t			max_tpdu;
+	size_t				record_len;
+	uint32_t			segment_sqns;
+	unsigned			segments_max;
+
+/* segments[] ring of oldest to newest, changed under mutex */
+	pgm_mutex_t			mutex;
+	struct pgm_txlog_segment_t*	segments;
+	unsigned			segment_head;		/* index of oldest */
+	unsigned			segment_len;
+
+/* appended by the sending thread alone, read lockless elsewhere */
+	volatile uint32_t		lead;
+	volatile uint32_t		trail;
+
+/* repair requests of spilled sequences, under mutex */
+	struct pgm_txlog_request_t	requests[PGM_TXLOG_REQUESTS_MAX];
+	unsigned			request_head;
+	unsigned			request_len;
+	volatile uint32_t		request_pending;
+
+/* owned by the repair path, the request in service */
+	struct pgm_sk_buff_t* restrict	retransmit_skb;
+
+	uint64_t			packets;		/* appended */
+	uint64_t			retransmits;		/* served from the log */
+};
+
+PGM_GNUC_INTERNAL pgm_txlog_t* pgm_txlog_create (const pgm_tsi_t*const, const char*const, const uint16_t, const uint32_t, const unsigned, pgm_error_t**) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_txlog_destroy (pgm_txlog_t*const);
+PGM_GNUC_INTERNAL void pgm_txlog_append (pgm_txlog_t*const restrict, const struct pgm_sk_buff_t*const restrict, const uint32_t);
+PGM_GNUC_INTERNAL bool pgm_txlog_retransmit_push (pgm_txlog_t*const, const uint32_t) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL struct pgm_sk_buff_t* pgm_txlog_retransmit_try_peek (pgm_txlog_t*const) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL void pgm_txlog_retransmit_remove_head (pgm_txlog_t*const);
+
+/* no sequences spilled yet */
+static inline
+bool
+pgm_txlog_is_empty (
+	const pgm_txlog_t*const	log
+	)
+{
+	pgm_assert (NULL != log);
+	return (pgm_atomic_read32 (&log->lead) + 1 == pgm_atomic_read32 (&log->trail));
+}
+
+static inline
+bool
+pgm_txlog_retransmit_is_empty (
+	const pgm_txlog_t*const	log
+	)
+{
+	pgm_assert (NULL != log);
+	return (NULL == log->retransmit_skb && 0 == pgm_atomic_read32 (&log->request_pending));
+}
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_TXLOG_H__ */
@@ -28,17 +28,30 @@
 typedef struct pgm_txw_state_t pgm_txw_state_t;
 typedef struct pgm_txw_t pgm_txw_t;
 
+struct pgm_txlog_t;
+struct pgm_standby_t;
+
 #include <impl/framework.h>
 
 PGM_BEGIN_DECLS
 
+/* upper bound of parity packets of one transmission group encoded together */
+#define PGM_TXW_PARITY_BATCH_MAX	16
+
+/* default memory budget of cached on-demand parity packets in bytes */
+#define PGM_TXW_PARITY_CACHE_DEFAULT	(256 * 1024)
+
+/* time held from window insert to removal at the trailing edge, bucket n
+ * counting residencies from 2^(n-1) up to 2^n microseconds, the last unbounded.
+ */
+#define PGM_TXW_RESIDENCY_BUCKETS	32
+
 /* must be smaller than PGM skbuff control buffer */
 struct pgm_txw_state_t {
 	uint32_t	unfolded_checksum;	/* first 32-bit word must be checksum */
 
 	unsigned	waiting_retransmit:1;	/* in retransmit queue */
 	unsigned	retransmit_count:15;
-	unsigned	nak_elimination_count:16;
 
 	uint8_t		pkt_cnt_requested;	/* # parity packets to send */
 	uint8_t		pkt_cnt_sent;		/* # parity packets already sent */
@@ -47,15 +60,49 @@ struct pgm_txw_state_t {
 struct pgm_txw_t {
 	const pgm_tsi_t* restrict	tsi;
 
-/* option: lockless atomics */
+/* advanced by the sending thread alone, read lockless elsewhere */
         volatile uint32_t		lead;
         volatile uint32_t		trail;
 
+/* repair path hold on one entry against release by trail advancement */
+	volatile uint32_t		pinned;
+	volatile uint32_t		pinned_sqn;
+
+/* outstanding requests set by NAK processing with word-wide atomics, one bit
+ * per pdata[] slot for selective requests, one bit and the highest requested
+ * packet count per transmission group slot for parity requests.  cleared by
+ * the repair path once served.
+ */
+	volatile uint32_t* restrict	retransmit_bitmap;
+	volatile uint32_t* restrict	unreliable_bitmap;	/* one bit per pdata[] slot, never repaired */
+	uint32_t			unreliable_recent;	/* bit i set for unreliable next_lead - 1 - i */
+	volatile uint32_t* restrict	parity_bitmap;
+	volatile uint32_t* restrict	parity_requested;
+	unsigned			tg_alloc;		/* transmission group slots */
+	volatile uint32_t		retransmit_pending;	/* bits set across both bitmaps */
+	volatile uint32_t		nak_elimination_count;
+
+/* owned by the repair path, requests in service, each queued skb holds a reference */
         pgm_queue_t			retransmit_queue;
 
 	pgm_rs_t			rs;
 	uint8_t				tg_sqn_shift;
-	struct pgm_sk_buff_t* restrict	parity_buffer;
+	struct pgm_sk_buff_t** restrict	parity_buffer;		/* fused encode output */
+	unsigned			parity_buffer_len;
+	uint32_t			parity_tg_sqn;		/* transmission group of encoded parity */
+	uint8_t				parity_h;		/* index of parity_buffer[0] */
+	uint8_t				parity_len;		/* encoded parity packets, 0 = none */
+	uint16_t			parity_tpdu;		/* parity packet buffer size */
+	pgm_queue_t			parity_cache;		/* on-demand parity, head most recent */
+	size_t				parity_cache_size;	/* bytes held by parity_cache */
+	size_t				parity_cache_max;	/* 0 = disabled */
+	uint32_t			parity_cache_hits;
+	uint32_t			parity_cache_misses;
+	uint32_t			parity_cache_trail;	/* transmission group of last eviction */
+
+/* trailing edge release on receiver ACKs */
+	pgm_time_t			ack_hold;		/* 0 = disabled */
+	volatile uint32_t		ack_sqn;		/* acknowledged by the receiver quorum */
 
 /* Advance with data */
 	pgm_time_t			adv_ivl_expiry;	
@@ -67,17 +114,41 @@ struct pgm_txw_t {
 	unsigned			adv_mode:1;		/* 0 = advance by time, 1 = advance by data */
 
 	size_t				size;			/* window content size in bytes */
-	unsigned			alloc;			/* length of pdata[] */
+	size_t				peak_size;		/* high-water of size */
+	uint32_t			peak_length;		/* high-water of sequences held */
+	uint32_t			max_residency;
+	uint32_t			residency_hist[PGM_TXW_RESIDENCY_BUCKETS];
+	pgm_mem_budget_t*		budget;			/* charged with truesize of held skbs, optional */
+	struct pgm_txlog_t* restrict	log;			/* continues the trail, NULL = none */
+	struct pgm_standby_t* restrict	mirror;			/* copied on add to a standby, NULL = none */
+	pgm_skb_pool_t* restrict	slots;			/* ring of max_length + 1 packet slots, NULL for pool buffers */
+	unsigned			alloc;			/* length of pdata[], a power of two */
+	uint32_t			mask;			/* alloc - 1, sequence to pdata[] index */
+	volatile uint32_t		max_length;		/* in use of alloc, resized live by the sending thread */
 /* C90 and older */
 	struct pgm_sk_buff_t*		pdata[1];
 };
 
-PGM_GNUC_INTERNAL pgm_txw_t* pgm_txw_create (const pgm_tsi_t*const, const uint16_t, const uint32_t, const unsigned, const ssize_t, const bool, const uint8_t, const uint8_t) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL pgm_txw_t* pgm_txw_create (const pgm_tsi_t*const, const uint16_t, const uint32_t, const unsigned, const ssize_t, const bool, const uint8_t, const uint8_t, const size_t) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL void pgm_txw_shutdown (pgm_txw_t*const);
+PGM_GNUC_INTERNAL void pgm_txw_set_slots (pgm_txw_t*const, const uint16_t, const size_t, const bool, const int);
+PGM_GNUC_INTERNAL size_t pgm_txw_prewarm (pgm_txw_t*const);
+PGM_GNUC_INTERNAL void pgm_txw_set_log (pgm_txw_t*const restrict, struct pgm_txlog_t*const restrict);
+PGM_GNUC_INTERNAL void pgm_txw_set_mirror (pgm_txw_t*const restrict, struct pgm_standby_t*const restrict);
+PGM_GNUC_INTERNAL void pgm_txw_reset (pgm_txw_t*const, const uint32_t);
+PGM_GNUC_INTERNAL void pgm_txw_set_ack_release (pgm_txw_t*const, const pgm_time_t);
+PGM_GNUC_INTERNAL void pgm_txw_ack (pgm_txw_t*const, const uint32_t);
+PGM_GNUC_INTERNAL bool pgm_txw_set_max_length (pgm_txw_t*const, const uint32_t);
+PGM_GNUC_INTERNAL struct pgm_sk_buff_t* pgm_txw_alloc_skb (pgm_txw_t*const restrict, pgm_skb_pool_t*const restrict, const uint16_t) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL void pgm_txw_add (pgm_txw_t*const restrict, struct pgm_sk_buff_t*const restrict);
+PGM_GNUC_INTERNAL void pgm_txw_add_unreliable (pgm_txw_t*const restrict, struct pgm_sk_buff_t*const restrict);
 PGM_GNUC_INTERNAL struct pgm_sk_buff_t* pgm_txw_peek (const pgm_txw_t*const, const uint32_t) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL struct pgm_sk_buff_t* pgm_txw_peek_get (pgm_txw_t*const, const uint32_t) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL bool pgm_txw_retransmit_push (pgm_txw_t*const, const uint32_t, const bool, const uint8_t) PGM_GNUC_WARN_UNUSED_RESULT;
 PGM_GNUC_INTERNAL struct pgm_sk_buff_t* pgm_txw_retransmit_try_peek (pgm_txw_t*const) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL unsigned pgm_txw_retransmit_try_peekv (pgm_txw_t*const, struct pgm_sk_buff_t**const, const unsigned) PGM_GNUC_WARN_UNUSED_RESULT;
+PGM_GNUC_INTERNAL uint8_t pgm_txw_parity_reserve (pgm_txw_t*const restrict, struct pgm_sk_buff_t*const restrict, const uint8_t);
+PGM_GNUC_INTERNAL void pgm_txw_parity_encode (pgm_txw_t*const, struct pgm_sk_buff_t*const*const, const uint8_t, const uint8_t, struct pgm_sk_buff_t*const*const);
 PGM_GNUC_INTERNAL void pgm_txw_retransmit_remove_head (pgm_txw_t*const);
 PGM_GNUC_INTERNAL uint32_t pgm_txw_get_unfolded_checksum (const struct pgm_sk_buff_t*const) PGM_GNUC_PURE;
 PGM_GNUC_INTERNAL void pgm_txw_set_unfolded_checksum (struct pgm_sk_buff_t*const, const uint32_t);
@@ -95,6 +166,7 @@ static inline uint32_t pgm_txw_lead_atomic (const pgm_txw_t* const) PGM_GNUC_WAR
 static inline uint32_t pgm_txw_next_lead (const pgm_txw_t* const) PGM_GNUC_WARN_UNUSED_RESULT;
 static inline uint32_t pgm_txw_trail (const pgm_txw_t* const) PGM_GNUC_WARN_UNUSED_RESULT;
 static inline uint32_t pgm_txw_trail_atomic (const pgm_txw_t* const) PGM_GNUC_WARN_UNUSED_RESULT;
+static inline uint32_t pgm_txw_unreliable_recent (const pgm_txw_t* const) PGM_GNUC_WARN_UNUSED_RESULT;
 
 static inline
 size_t
@@ -103,7 +175,7 @@ pgm_txw_max_length (
 	)
 {
 	pgm_assert (NULL != window);
-	return window->alloc;
+	return window->max_length;
 }
 
 static inline
@@ -143,7 +215,7 @@ pgm_txw_is_full (
 	)
 {
 	pgm_assert (NULL != window);
-	return (pgm_txw_length (window) == pgm_txw_max_length (window));
+	return (pgm_txw_length (window) >= pgm_txw_max_length (window));
 }
 
 static inline
@@ -197,6 +269,17 @@ pgm_txw_trail_atomic (
 	return pgm_atomic_read32 (&window->trail);
 }
 
+/* unreliable sequences preceding the next lead as carried by OPT_UNRELIABLE */
+static inline
+uint32_t
+pgm_txw_unreliable_recent (
+	const pgm_txw_t*const window
+	)
+{
+	pgm_assert (NULL != window);
+	return window->unreliable_recent;
+}
+
 PGM_END_DECLS
 
 #endif /* __PGM_IMPL_TXW_H__ */
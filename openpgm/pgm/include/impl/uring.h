@@ -0,0 +1,116 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * io_uring packet I/O.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_URING_H__
+#define __PGM_IMPL_URING_H__
+
+struct pgm_uring_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+#ifdef HAVE_LINUX_IO_URING_H
+#	include <linux/io_uring.h>
+/* multishot receive with provided buffer rings, Linux 6.0 */
+#	ifdef IORING_RECV_MULTISHOT
+#		define PGM_HAVE_IO_URING
+#	endif
+#endif
+
+PGM_BEGIN_DECLS
+
+/* upper bound of ring entries, provided buffers and in-flight sends */
+#define PGM_URING_ENTRIES_MAX		4096
+
+#ifdef PGM_HAVE_IO_URING
+/* control buffer per datagram, sufficient for IP_PKTINFO or IPV6_PKTINFO */
+#	define PGM_URING_AUXLEN		64
+
+/* multishot recvmsg layout ahead of payload in each provided buffer */
+#	define PGM_URING_RECV_HEADROOM	(sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_storage) + PGM_URING_AUXLEN)
+
+struct pgm_uring_ring_t {
+	SOCKET				fd;
+	uint32_t*			sq_head;
+	uint32_t*			sq_tail;
+	uint32_t*			sq_array;
+	uint32_t			sq_mask;
+	struct io_uring_sqe*		sqes;
+	uint32_t*			cq_head;
+	uint32_t*			cq_tail;
+	uint32_t			cq_mask;
+	struct io_uring_cqe*		cqes;
+	void*				ring_map;
+	size_t				ring_map_len;
+	size_t				sqes_len;
+	unsigned			pending;	/* prepared, not yet submitted */
+};
+
+struct pgm_uring_send_t;
+
+struct pgm_uring_t {
+	unsigned			entries;
+/* receive: one multishot recvmsg over a provided buffer ring of skbs */
+	struct pgm_uring_ring_t		rx;
+	struct io_uring_buf_ring*	br;
+	size_t				br_len;
+	uint16_t			br_tail;
+	uint16_t			buffer_len;	/* headroom and max_tpdu */
+	bool				is_armed;
+	struct msghdr			recv_msg;
+	struct pgm_sk_buff_t**		rx_skb;		/* indexed by buffer id */
+/* transmit: batched sendmsg submissions holding skb references */
+	struct pgm_uring_ring_t		tx;
+	pgm_mutex_t			tx_mutex;
+	struct pgm_uring_send_t*	tx_slot;
+	unsigned*			tx_free;	/* stack of idle slots */
+	unsigned			tx_free_len;
+};
+
+PGM_GNUC_INTERNAL ssize_t pgm_uring_recvskb (pgm_sock_t*const restrict, struct sockaddr*const restrict, const socklen_t, struct msghdr*const restrict);
+PGM_GNUC_INTERNAL int pgm_uring_sendv (pgm_sock_t*const restrict, const bool, struct pgm_sk_buff_t*const*const restrict, const unsigned, const struct sockaddr*const restrict, const socklen_t);
+#endif /* PGM_HAVE_IO_URING */
+
+/* descriptor signalling incoming packets, the completion ring under io_uring */
+
+static inline
+SOCKET
+pgm_recv_event_sock (
+	const pgm_sock_t* const	sock
+	)
+{
+#ifdef PGM_HAVE_IO_URING
+	if (NULL != sock->uring)
+		return sock->uring->rx.fd;
+#endif
+	return sock->recv_sock;
+}
+
+PGM_GNUC_INTERNAL uint16_t pgm_uring_buffer_len (const pgm_sock_t*const) PGM_GNUC_PURE;
+PGM_GNUC_INTERNAL bool pgm_uring_open (pgm_sock_t*const restrict, pgm_error_t**restrict);
+PGM_GNUC_INTERNAL void pgm_uring_close (pgm_sock_t*const);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_URING_H__ */
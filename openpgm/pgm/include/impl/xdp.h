@@ -0,0 +1,91 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * AF_XDP packet I/O.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_XDP_H__
+#define __PGM_IMPL_XDP_H__
+
+struct pgm_xdp_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+PGM_BEGIN_DECLS
+
+/* UMEM chunk, one packet per frame */
+#define PGM_XDP_FRAME_SIZE		2048
+/* frames per ring, half of UMEM receives and half transmits */
+#define PGM_XDP_RING_SIZE		2048
+
+#ifdef HAVE_LINUX_IF_XDP_H
+struct pgm_xdp_ring_t {
+	uint32_t*			producer;
+	uint32_t*			consumer;
+	uint32_t*			flags;
+	void*				ring;
+	uint32_t			mask;
+	uint32_t			cached_prod;
+	uint32_t			cached_cons;
+	void*				map;
+	size_t				map_len;
+};
+
+struct pgm_xdp_t {
+	SOCKET				fd;		/* AF_XDP socket, pollable for receive */
+	char*				umem;
+	size_t				umem_len;
+	struct pgm_xdp_ring_t		fill;
+	struct pgm_xdp_ring_t		comp;
+	struct pgm_xdp_ring_t		rx;
+	struct pgm_xdp_ring_t		tx;
+	pgm_spinlock_t			tx_lock;
+	uint64_t*			tx_frames;	/* stack of idle transmit frames */
+	unsigned			tx_free;
+	uint8_t				src_hwaddr[6];
+	struct sockaddr_in		src_addr;	/* bound send address */
+	uint16_t			ip_id;
+};
+
+static inline
+bool
+pgm_xdp_can_sendto (
+	const pgm_sock_t*      const restrict sock,
+	const struct sockaddr* const restrict to
+	)
+{
+/* unicast destinations require neighbour resolution by the kernel */
+	return (NULL != sock->xdp &&
+		AF_INET == to->sa_family &&
+		IN_MULTICAST (ntohl (((const struct sockaddr_in*)to)->sin_addr.s_addr)));
+}
+
+PGM_GNUC_INTERNAL ssize_t pgm_xdp_recvskb (pgm_sock_t*const restrict, struct pgm_sk_buff_t*const restrict, struct sockaddr*const restrict, const socklen_t, struct sockaddr*const restrict, const socklen_t);
+PGM_GNUC_INTERNAL int pgm_xdp_sendv (pgm_sock_t*const restrict, const bool, const int, const struct pgm_iovec*const restrict, const unsigned, const struct sockaddr*const restrict);
+#endif /* HAVE_LINUX_IF_XDP_H */
+
+PGM_GNUC_INTERNAL bool pgm_xdp_open (pgm_sock_t*const restrict, const unsigned, pgm_error_t**restrict);
+PGM_GNUC_INTERNAL void pgm_xdp_close (pgm_sock_t*const);
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_XDP_H__ */
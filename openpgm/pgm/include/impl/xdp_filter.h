@@ -0,0 +1,71 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * XDP early drop of duplicate and irrelevant PGM traffic.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_IMPL_XDP_FILTER_H__
+#define __PGM_IMPL_XDP_FILTER_H__
+
+typedef struct pgm_xdp_filter_t pgm_xdp_filter_t;
+
+#include <impl/framework.h>
+#include <impl/socket.h>
+
+PGM_BEGIN_DECLS
+
+/* sources tracked by the held sequence map, further sources are not filtered */
+#define PGM_XDP_FILTER_SOURCES		1024
+
+struct pgm_xdp_filter_t {
+	int			prog_fd;
+	int			map_fd;		/* BPF_MAP_TYPE_HASH, TSI to commit lead */
+	int			link_fd;	/* attachment, detached on close */
+};
+
+PGM_GNUC_INTERNAL bool pgm_xdp_filter_attach (pgm_sock_t*const restrict, const unsigned, pgm_error_t**restrict);
+PGM_GNUC_INTERNAL void pgm_xdp_filter_detach (pgm_sock_t*const);
+PGM_GNUC_INTERNAL void pgm_xdp_filter_update (pgm_xdp_filter_t*const restrict, const pgm_tsi_t*const restrict, const uint32_t);
+PGM_GNUC_INTERNAL void pgm_xdp_filter_remove (pgm_xdp_filter_t*const restrict, const pgm_tsi_t*const restrict);
+
+/* publish the sequence below which a source's packets are held, such that
+ * later copies are dropped by the driver.  no-op without a filter or when
+ * unchanged since the last call.
+ */
+
+static inline
+void
+pgm_xdp_filter_publish (
+	pgm_xdp_filter_t* const restrict filter,
+	const pgm_tsi_t*  const restrict tsi,
+	uint32_t*	  const restrict published,
+	const uint32_t			 commit_lead
+	)
+{
+	if (PGM_LIKELY(NULL == filter) || *published == commit_lead)
+		return;
+	*published = commit_lead;
+	pgm_xdp_filter_update (filter, tsi, commit_lead);
+}
+
+PGM_END_DECLS
+
+#endif /* __PGM_IMPL_XDP_FILTER_H__ */
@@ -224,4 +224,368 @@ pgm_atomic_write32 (
 	*atomic = val;
 }
 
+/* 32-bit word compare and swap, returns TRUE if exchanged.
+ *
+ *	if (*atomic == oldval) { *atomic = newval; return TRUE; }
+ *	return FALSE;
+ */
+
+static inline
+bool
+pgm_atomic_compare_and_exchange32 (
+	volatile uint32_t*	atomic,
+	const uint32_t		oldval,
+	const uint32_t		newval
+	)
+{
+#if defined( __GNUC__ ) && ( defined( __i386__ ) || defined( __x86_64__ ) )
+	uint32_t result;
+	__asm__ volatile ("lock; cmpxchgl %2, %1"
+			: "=a" (result), "+m" (*atomic)
+			: "r" (newval), "0" (oldval)
+			: "memory", "cc"  );
+	return result == oldval;
+#elif defined( __sun ) || defined( __NetBSD__ )
+	return atomic_cas_32 (atomic, oldval, newval) == oldval;
+#elif defined( __APPLE__ )
+	return OSAtomicCompareAndSwap32Barrier ((int32_t)oldval, (int32_t)newval, (volatile int32_t*)atomic);
+#elif defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 401 )
+	return __sync_bool_compare_and_swap (atomic, oldval, newval);
+#elif defined( _AIX )
+	int expected = (int)oldval;
+	return compare_and_swap ((atomic_p)atomic, &expected, (int)newval);
+#elif defined( _WIN32 )
+	return (uint32_t)_InterlockedCompareExchange ((volatile LONG*)atomic, newval, oldval) == oldval;
+#else
+#	error "No supported atomic operations for this platform."
+#endif
+}
+
+/* 64-bit word compare and swap, returns TRUE if exchanged.
+ *
+ *	if (*atomic == oldval) { *atomic = newval; return TRUE; }
+ *	return FALSE;
+ *
+ * NB: CMPXCHG8B on 32-bit x86 requires Pentium microprocessor.
+ */
+
+static inline
+bool
+pgm_atomic_compare_and_exchange64 (
+	volatile uint64_t*	atomic,
+	const uint64_t		oldval,
+	const uint64_t		newval
+	)
+{
+#if defined( __GNUC__ ) && defined( __x86_64__ )
+	uint64_t result;
+	__asm__ volatile ("lock; cmpxchgq %2, %1"
+			: "=a" (result), "+m" (*atomic)
+			: "r" (newval), "0" (oldval)
+			: "memory", "cc"  );
+	return result == oldval;
+#elif defined( __sun ) || defined( __NetBSD__ )
+	return atomic_cas_64 (atomic, oldval, newval) == oldval;
+#elif defined( __APPLE__ )
+	return OSAtomicCompareAndSwap64Barrier ((int64_t)oldval, (int64_t)newval, (volatile int64_t*)atomic);
+#elif defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 401 )
+	return __sync_bool_compare_and_swap (atomic, oldval, newval);
+#elif defined( _AIX ) && defined( __64BIT__ )
+	long expected = (long)oldval;
+	return compare_and_swaplp ((atomic_l)atomic, &expected, (long)newval);
+#elif defined( _WIN32 )
+	return (uint64_t)_InterlockedCompareExchange64 ((volatile LONGLONG*)atomic, newval, oldval) == oldval;
+#else
+#	error "No supported atomic operations for this platform."
+#endif
+}
+
+/* 64-bit word addition.
+ *
+ * 	*atomic += val;
+ */
+
+static inline
+void
+pgm_atomic_add64 (
+	volatile uint64_t*	atomic,
+	const uint64_t		val
+	)
+{
+#if defined( __GNUC__ ) && defined( __x86_64__ )
+	__asm__ volatile ("lock; addq %1, %0"
+		        : "=m" (*atomic)
+		        : "er" (val), "m" (*atomic)
+		        : "memory", "cc"  );
+#elif defined( __sun ) || defined( __NetBSD__ )
+	atomic_add_64 (atomic, (int64_t)val);
+#elif defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 401 )
+	__sync_add_and_fetch (atomic, val);
+#else
+	uint64_t oldval;
+	do {
+		oldval = *atomic;
+	} while (!pgm_atomic_compare_and_exchange64 (atomic, oldval, oldval + val));
+#endif
+}
+
+/* 64-bit word load, on 32-bit platforms a plain load may tear so confirm
+ * the value with a no-op compare and swap.
+ */
+
+static inline
+uint64_t
+pgm_atomic_read64 (
+	const volatile uint64_t* atomic
+	)
+{
+#if defined( __x86_64__ ) || defined( __amd64 ) || defined( _WIN64 ) || defined( __LP64__ ) || defined( _LP64 ) || defined( __64BIT__ )
+	return *atomic;
+#else
+	uint64_t val;
+	do {
+		val = *atomic;
+	} while (!pgm_atomic_compare_and_exchange64 ((volatile uint64_t*)atomic, val, val));
+	return val;
+#endif
+}
+
+/* 32-bit word bitwise or and and, return the previous value.
+ *
+ *	tmp = *atomic; *atomic |= val; return tmp;
+ *	tmp = *atomic; *atomic &= val; return tmp;
+ */
+
+static inline
+uint32_t
+pgm_atomic_fetch_and_or32 (
+	volatile uint32_t*	atomic,
+	const uint32_t		val
+	)
+{
+	uint32_t oldval;
+	do {
+		oldval = pgm_atomic_read32 (atomic);
+	} while (!pgm_atomic_compare_and_exchange32 (atomic, oldval, oldval | val));
+	return oldval;
+}
+
+static inline
+uint32_t
+pgm_atomic_fetch_and_and32 (
+	volatile uint32_t*	atomic,
+	const uint32_t		val
+	)
+{
+	uint32_t oldval;
+	do {
+		oldval = pgm_atomic_read32 (atomic);
+	} while (!pgm_atomic_compare_and_exchange32 (atomic, oldval, oldval & val));
+	return oldval;
+}
+
+/* pointer compare and swap, returns TRUE if exchanged.
+ *
+ *	if (*atomic == oldval) { *atomic = newval; return TRUE; }
+ *	return FALSE;
+ */
+
+static inline
+bool
+pgm_atomic_compare_and_exchange_pointer (
+	void*volatile*		atomic,
+	void*			oldval,
+	void*			newval
+	)
+{
+#if defined( __GNUC__ ) && ( defined( __i386__ ) || defined( __x86_64__ ) )
+	void* result;
+	__asm__ volatile ("lock; cmpxchg %2, %1"
+			: "=a" (result), "+m" (*atomic)
+			: "r" (newval), "0" (oldval)
+			: "memory", "cc"  );
+	return result == oldval;
+#elif defined( __sun ) || defined( __NetBSD__ )
+	return atomic_cas_ptr (atomic, oldval, newval) == oldval;
+#elif defined( __APPLE__ )
+	return OSAtomicCompareAndSwapPtrBarrier (oldval, newval, atomic);
+#elif defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 401 )
+	return __sync_bool_compare_and_swap (atomic, oldval, newval);
+#elif defined( _AIX ) && defined( __64BIT__ )
+	return compare_and_swaplp ((atomic_l)atomic, (long*)&oldval, (long)newval);
+#elif defined( _AIX )
+	return compare_and_swap ((atomic_p)atomic, (int*)&oldval, (int)newval);
+#elif defined( _WIN32 )
+	return _InterlockedCompareExchangePointer (atomic, newval, oldval) == oldval;
+#else
+#	error "No supported atomic operations for this platform."
+#endif
+}
+
+/* full memory barrier, no load or store moves across in either direction.
+ */
+
+static inline
+void
+pgm_atomic_fence (void)
+{
+#if defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 407 )
+	__atomic_thread_fence (__ATOMIC_SEQ_CST);
+#elif defined( __GNUC__ ) && defined( __x86_64__ )
+	__asm__ volatile ("mfence" ::: "memory");
+#elif defined( __GNUC__ ) && defined( __i386__ )
+/* mfence requires SSE2 */
+	__asm__ volatile ("lock; orl $0, (%%esp)" ::: "memory", "cc");
+#elif defined( __sun )
+	membar_enter ();
+	membar_consumer ();
+	membar_exit ();
+#elif defined( __NetBSD__ )
+	membar_sync ();
+#elif defined( __APPLE__ )
+	OSMemoryBarrier ();
+#elif defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 401 )
+	__sync_synchronize ();
+#elif defined( _AIX )
+	__sync ();
+#elif defined( _WIN32 )
+	MemoryBarrier ();
+#else
+#	error "No supported atomic operations for this platform."
+#endif
+}
+
+/* acquire barrier, loads before are ordered before loads and stores after.
+ */
+
+static inline
+void
+pgm_atomic_fence_acquire (void)
+{
+#if defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 407 )
+	__atomic_thread_fence (__ATOMIC_ACQUIRE);
+#elif defined( __GNUC__ ) && ( defined( __i386__ ) || defined( __x86_64__ ) )
+/* loads are not reordered with other loads or stores after */
+	__asm__ volatile ("" ::: "memory");
+#elif defined( __sun ) || defined( __NetBSD__ )
+	membar_consumer ();
+	membar_exit ();
+#elif defined( __APPLE__ )
+	OSMemoryBarrier ();
+#elif defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 401 )
+	__sync_synchronize ();
+#elif defined( _AIX )
+	__lwsync ();
+#elif defined( _WIN32 ) && ( defined( _M_IX86 ) || defined( _M_X64 ) )
+	_ReadWriteBarrier ();
+#elif defined( _WIN32 )
+	MemoryBarrier ();
+#else
+#	error "No supported atomic operations for this platform."
+#endif
+}
+
+/* release barrier, loads and stores before are ordered before stores after.
+ */
+
+static inline
+void
+pgm_atomic_fence_release (void)
+{
+#if defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 407 )
+	__atomic_thread_fence (__ATOMIC_RELEASE);
+#elif defined( __GNUC__ ) && ( defined( __i386__ ) || defined( __x86_64__ ) )
+/* stores are not reordered with other stores or loads before */
+	__asm__ volatile ("" ::: "memory");
+#elif defined( __sun ) || defined( __NetBSD__ )
+	membar_exit ();
+#elif defined( __APPLE__ )
+	OSMemoryBarrier ();
+#elif defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 401 )
+	__sync_synchronize ();
+#elif defined( _AIX )
+	__lwsync ();
+#elif defined( _WIN32 ) && ( defined( _M_IX86 ) || defined( _M_X64 ) )
+	_ReadWriteBarrier ();
+#elif defined( _WIN32 )
+	MemoryBarrier ();
+#else
+#	error "No supported atomic operations for this platform."
+#endif
+}
+
+/* 32-bit word load with acquire semantics, loads and stores after are not
+ * moved before.
+ */
+
+static inline
+uint32_t
+pgm_atomic_read32_acquire (
+	const volatile uint32_t* atomic
+	)
+{
+#if defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 407 )
+	return __atomic_load_n (atomic, __ATOMIC_ACQUIRE);
+#else
+	const uint32_t val = *atomic;
+	pgm_atomic_fence_acquire ();
+	return val;
+#endif
+}
+
+/* 32-bit word store with release semantics, loads and stores before are not
+ * moved after.
+ */
+
+static inline
+void
+pgm_atomic_write32_release (
+	volatile uint32_t*	atomic,
+	const uint32_t		val
+	)
+{
+#if defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 407 )
+	__atomic_store_n (atomic, val, __ATOMIC_RELEASE);
+#else
+	pgm_atomic_fence_release ();
+	*atomic = val;
+#endif
+}
+
+/* pointer load with acquire semantics.
+ */
+
+static inline
+void*
+pgm_atomic_read_pointer_acquire (
+	void*const volatile*	atomic
+	)
+{
+#if defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 407 )
+	return __atomic_load_n (atomic, __ATOMIC_ACQUIRE);
+#else
+	void* const val = *atomic;
+	pgm_atomic_fence_acquire ();
+	return val;
+#endif
+}
+
+/* pointer store with release semantics.
+ */
+
+static inline
+void
+pgm_atomic_write_pointer_release (
+	void*volatile*		atomic,
+	void*			val
+	)
+{
+#if defined( __GNUC__ ) && ( __GNUC__ * 100 + __GNUC_MINOR__ >= 407 )
+	__atomic_store_n (atomic, val, __ATOMIC_RELEASE);
+#else
+	pgm_atomic_fence_release ();
+	*atomic = val;
+#endif
+}
+
 #endif /* __PGM_ATOMIC_H__ */
@@ -30,10 +30,27 @@
 
 PGM_BEGIN_DECLS
 
+/* placement of the threads the library creates, by role name: "timer",
+ * "http", "snmp", "stats", "logring", "recv", "fec", "rdata", "decode",
+ * "standby", "core", "async" or "sampler".
+ */
+enum {
+	PGM_SCHED_OTHER = 0,
+	PGM_SCHED_FIFO,
+	PGM_SCHED_RR
+};
+
+struct pgm_thread_attr_t {
+	const char*	cpus;		/* CPU list such as "2-3,8", NULL to inherit */
+	int		policy;		/* PGM_SCHED_OTHER, PGM_SCHED_FIFO or PGM_SCHED_RR */
+	int		priority;	/* real-time priority of FIFO and RR */
+};
+
 bool pgm_init (pgm_error_t**);
 bool pgm_supported (void) PGM_GNUC_WARN_UNUSED_RESULT PGM_GNUC_PURE;
 bool pgm_shutdown (void);
 void pgm_drop_superuser (void);
+bool pgm_thread_attr_set (const char*, const struct pgm_thread_attr_t*);
 
 PGM_END_DECLS
 
@@ -0,0 +1,220 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * PGM socket driven by a libevent event base.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_LIBEVENT_H__
+#define __PGM_LIBEVENT_H__
+
+/* header only such that libpgm does not depend on libevent 2.  POSIX only,
+ * descriptors are registered edge-triggered where the backend supports it.
+ */
+
+typedef struct pgm_event_t pgm_event_t;
+
+#include <string.h>
+#include <event2/event.h>
+#include <pgm/pgm.h>
+
+PGM_BEGIN_DECLS
+
+/* messages read per receive call */
+#define PGM_EVENT_MSGV_LEN	32
+
+/* receive, pending and repair descriptors without PGM_EVENT_SOCK */
+#define PGM_EVENT_FD_MAX	3
+
+/* connected socket serviced on an event base.  with PGM_EVENT_SOCK enabled
+ * before pgm_connect() one event covers every descriptor and timer of the
+ * socket.  otherwise each descriptor has an event and a timer event is added
+ * only when a receive call reports a pending timer or rate limit.  every
+ * wakeup reads until the socket would block, as edge-triggered events
+ * require, and so no descriptor is left ready to wake the base again.
+ */
+struct pgm_event_t {
+	pgm_sock_t*		sock;
+	pgm_recv_callback_t	callback;		/* messages, resets and errors */
+	void*			user_data;
+	struct event*		ev[ PGM_EVENT_FD_MAX ];
+	unsigned		ev_len;
+	struct event*		timer;			/* without PGM_EVENT_SOCK */
+	struct pgm_msgv_t	msgv[ PGM_EVENT_MSGV_LEN ];
+};
+
+/* read until the socket would block, handing every batch, reset and error to
+ * the callback.
+ *
+ * returns FALSE when the socket is closed.
+ */
+
+static inline
+bool
+_pgm_event_service (
+	pgm_event_t* const	handle
+	)
+{
+	for (;;) {
+		struct timeval tv;
+		socklen_t optlen = sizeof (tv);
+		size_t bytes_read = 0, len = 0;
+		pgm_error_t* pgm_err = NULL;
+		const int status = pgm_recvmsgv (handle->sock, handle->msgv, PGM_EVENT_MSGV_LEN, MSG_DONTWAIT, &bytes_read, &pgm_err);
+		switch (status) {
+		case PGM_IO_STATUS_NORMAL:
+			while (bytes_read > 0 && len < PGM_EVENT_MSGV_LEN) {
+				const struct pgm_msgv_t* msgv = &handle->msgv[ len++ ];
+				for (unsigned j = 0; j < msgv->msgv_len; j++)
+					bytes_read -= MIN(bytes_read, msgv->msgv_skb[ j ]->len);
+			}
+			handle->callback (handle->sock, handle->msgv, len, status, handle->user_data);
+			break;
+
+/* the event socket carries its own timer */
+		case PGM_IO_STATUS_TIMER_PENDING:
+		case PGM_IO_STATUS_RATE_LIMITED:
+			if (NULL != handle->timer &&
+			    pgm_getsockopt (handle->sock, IPPROTO_PGM,
+					    PGM_IO_STATUS_TIMER_PENDING == status ? PGM_TIME_REMAIN : PGM_RATE_REMAIN,
+					    &tv, &optlen))
+			{
+				evtimer_add (handle->timer, &tv);
+			}
+			return TRUE;
+
+		case PGM_IO_STATUS_WOULD_BLOCK:
+			if (NULL != handle->timer)
+				evtimer_del (handle->timer);
+			return TRUE;
+
+		case PGM_IO_STATUS_ERROR:
+			pgm_error_free (pgm_err);
+/* fall through */
+		default:
+			handle->callback (handle->sock, NULL, 0, status, handle->user_data);
+			if (PGM_IO_STATUS_EOF == status)
+				return FALSE;
+			break;
+		}
+	}
+}
+
+static
+void
+_pgm_event_cb (
+	evutil_socket_t		fd,
+	short			events,
+	void*			arg
+	)
+{
+	pgm_event_t* handle = (pgm_event_t*)arg;
+	(void)fd;
+	(void)events;
+	if (_pgm_event_service (handle))
+		return;
+	for (unsigned i = 0; i < handle->ev_len; i++)
+		event_del (handle->ev[ i ]);
+	if (NULL != handle->timer)
+		evtimer_del (handle->timer);
+}
+
+/* stop watching the socket, after which the socket may be closed and handle
+ * freed.  call from the thread running the base.
+ */
+
+static inline
+void
+pgm_event_stop (
+	pgm_event_t* const	handle
+	)
+{
+	for (unsigned i = 0; i < handle->ev_len; i++)
+		event_free (handle->ev[ i ]);
+	handle->ev_len = 0;
+	if (NULL != handle->timer) {
+		event_free (handle->timer);
+		handle->timer = NULL;
+	}
+}
+
+/* watch a connected socket on base, calling callback on the thread running
+ * the base.  messages passed to the callback are valid until it returns.
+ *
+ * returns 0 on success, returns -1 on failure.
+ */
+
+static inline
+int
+pgm_event_start (
+	struct event_base*  const restrict base,
+	pgm_event_t*	    const restrict handle,
+	pgm_sock_t*	    const restrict sock,
+	pgm_recv_callback_t		   callback,
+	void*				   user_data
+	)
+{
+	int fds[ PGM_EVENT_FD_MAX ];
+	unsigned fds_len = 0;
+	socklen_t optlen = sizeof (int);
+
+	memset (handle, 0, sizeof (pgm_event_t));
+	handle->sock	  = sock;
+	handle->callback  = callback;
+	handle->user_data = user_data;
+
+	if (pgm_getsockopt (sock, IPPROTO_PGM, PGM_EVENT_SOCK, &fds[ 0 ], &optlen)) {
+		fds_len = 1;
+	} else {
+		static const int optnames[ PGM_EVENT_FD_MAX ] = { PGM_RECV_SOCK, PGM_PENDING_SOCK, PGM_REPAIR_SOCK };
+		for (unsigned i = 0; i < PGM_EVENT_FD_MAX; i++) {
+			optlen = sizeof (int);
+			if (pgm_getsockopt (sock, IPPROTO_PGM, optnames[ i ], &fds[ fds_len ], &optlen) &&
+			    -1 != fds[ fds_len ])
+				fds_len++;
+		}
+		if (0 == fds_len)
+			return -1;
+		handle->timer = evtimer_new (base, _pgm_event_cb, handle);
+		if (NULL == handle->timer)
+			return -1;
+	}
+
+	for (unsigned i = 0; i < fds_len; i++) {
+		struct event* ev = event_new (base, fds[ i ], EV_READ | EV_PERSIST | EV_ET, _pgm_event_cb, handle);
+		if (NULL == ev)
+			goto err_free;
+		handle->ev[ handle->ev_len++ ] = ev;
+		if (0 != event_add (ev, NULL))
+			goto err_free;
+	}
+
+/* edge-triggered events miss whatever arrived before registration */
+	_pgm_event_cb (-1, 0, handle);
+	return 0;
+
+err_free:
+	pgm_event_stop (handle);
+	return -1;
+}
+
+PGM_END_DECLS
+
+#endif /* __PGM_LIBEVENT_H__ */
@@ -27,6 +27,8 @@
 
 struct pgm_iovec;
 struct pgm_msgv_t;
+struct pgm_apdu_t;
+struct pgm_skbv_t;
 
 #include <pgm/types.h>
 #include <pgm/packet.h>
@@ -52,6 +54,28 @@ struct pgm_msgv_t {
 	struct pgm_sk_buff_t*	msgv_skb[PGM_MAX_FRAGMENTS];	/* PGM socket buffer array */
 };
 
+/* compact vector of messages over one flat packet array, message i spanning
+ * skbv_count[i] packets from skbv_skb[skbv_offset[i]].  all arrays owned by
+ * the caller, reading stops with fewer than PGM_MAX_FRAGMENTS free packets.
+ */
+struct pgm_skbv_t {
+	struct pgm_sk_buff_t**	skbv_skb;			/* packet array */
+	uint32_t*		skbv_offset;			/* first packet of each message */
+	uint16_t*		skbv_count;			/* packets of each message */
+	uint32_t		skbv_skb_len;			/* number of elements in skbv_skb */
+	uint32_t		skbv_msg_len;			/* number of elements in skbv_offset and skbv_count */
+	uint32_t		skbv_skb_used;			/* packets read */
+	uint32_t		skbv_msg_used;			/* messages read */
+};
+
+/* one APDU as a scatter list over retained fragment payloads */
+struct pgm_apdu_t {
+	size_t			apdu_len;			/* total payload bytes */
+	unsigned		apdu_iovlen;			/* number of elements in apdu_iov */
+	struct pgm_iovec*	apdu_iov;			/* fragment payloads */
+	struct pgm_sk_buff_t**	apdu_skb;			/* fragment references */
+};
+
 PGM_END_DECLS
 
 #endif /* __PGM_MSGV_H__ */
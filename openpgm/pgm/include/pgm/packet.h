@@ -107,6 +107,15 @@ enum pgm_type_e {
 #define PGM_OPT_PGMCC_DATA	    0x12
 #define PGM_OPT_PGMCC_FEEDBACK	    0x13
 
+#define PGM_OPT_COALESCE	    0x14	/* length prefixed APDUs, OpenPGM */
+#define PGM_OPT_NAK_RANGE	    0x15	/* runs of nak entries, OpenPGM */
+#define PGM_OPT_COMPRESS	    0x16	/* LZ4 compressed APDU, OpenPGM */
+#define PGM_OPT_UNRELIABLE	    0x17	/* preceding sequences not repaired, OpenPGM */
+#define PGM_OPT_TIMESTAMP	    0x18	/* source send time, OpenPGM */
+#define PGM_OPT_POPULATION	    0x19	/* receiver population, OpenPGM */
+#define PGM_OPT_CRC32C		    0x1a	/* CRC32C data trailers, OpenPGM */
+#define PGM_OPT_PATH_MTU	    0x1b	/* receiver interface MTU, OpenPGM */
+
 #define PGM_OPT_NAK_BO_IVL	    0x04	/* nak back-off interval */
 #define PGM_OPT_NAK_BO_RNG	    0x05	/* nak back-off range */
 #define PGM_OPT_NBR_UNREACH	    0x0b	/* neighbour unreachable */
@@ -361,6 +370,110 @@ struct pgm_opt6_pgmcc_feedback {
 	struct in6_addr	opt6_nla;		/* ACKER nla */
 };
 
+/*
+ * Small message coalescing
+ */
+
+/* Option Coalesce - OPT_COALESCE, payload is a sequence of APDUs each preceded
+ * by a 16-bit length in network order.
+ */
+struct pgm_opt_coalesce {
+	uint8_t		opt_reserved;		/* reserved */
+};
+
+/*
+ * APDU compression
+ */
+
+/* Option Compress - OPT_COMPRESS, on every TPDU of an APDU compressed as one
+ * LZ4 block, OPT_FRAGMENT describing the compressed APDU.
+ */
+struct pgm_opt_compress {
+	uint8_t		opt_reserved;		/* reserved */
+	uint32_t	opt_apdu_len;		/* decompressed APDU length */
+};
+
+/*
+ * Partial reliability
+ */
+
+/* Option Unreliable - OPT_UNRELIABLE, on original data following unreliable
+ * packets, bit i set for data_sqn - 1 - i sent without repair.
+ */
+struct pgm_opt_unreliable {
+	uint8_t		opt_reserved;		/* reserved */
+	uint32_t	opt_bitmap;		/* preceding unreliable sequences */
+};
+
+/*
+ * One-way latency
+ */
+
+/* Option Timestamp - OPT_TIMESTAMP, on original data and its repairs the
+ * source's system time of the original send in microseconds since the epoch.
+ */
+struct pgm_opt_timestamp {
+	uint8_t		opt_reserved;		/* reserved */
+	uint32_t	opt_tstamp_hi;		/* high 32 bits of send time */
+	uint32_t	opt_tstamp_lo;		/* low 32 bits */
+};
+
+/*
+ * NAK suppression
+ */
+
+/* Option Population - OPT_POPULATION, in SPMs the number of receivers the
+ * source estimates from general POLL rounds, scaling exponential NAK back-off.
+ */
+struct pgm_opt_population {
+	uint8_t		opt_reserved;		/* reserved */
+	uint32_t	opt_population;		/* estimated receivers */
+};
+
+/*
+ * Range encoded NAKs
+ */
+
+/* Option NAK Range - OPT_NAK_RANGE, in SPMs advertises that the source accepts
+ * runs of sequence numbers, in NAKs and NCFs every requested run including the
+ * one starting at NAK_SQN.
+ */
+struct pgm_nak_range {
+	uint32_t	range_sqn;		/* first sequence number */
+	uint32_t	range_count;		/* sequence numbers in run */
+};
+
+struct pgm_opt_nak_range {
+	uint8_t		opt_reserved;		/* reserved */
+/* C90 and older */
+	struct pgm_nak_range opt_range[1];	/* requested runs [31] */
+};
+
+/*
+ * Data integrity
+ */
+
+/* Option CRC32C - OPT_CRC32C, in SPMs advertises that ODATA and RDATA carry
+ * a CRC32C trailer after the TSDU in place of the PGM checksum.  the CRC
+ * covers the TSDU followed by the header and options with a zero checksum
+ * field, such that a repair recomputes only the header part.
+ */
+struct pgm_opt_crc32c {
+	uint8_t		opt_reserved;		/* reserved */
+};
+
+/*
+ * Path MTU
+ */
+
+/* Option Path MTU - OPT_PATH_MTU, in POLRs the MTU of the interface the
+ * receiver joined the session on, bounding the TPDU size of the source.
+ */
+struct pgm_opt_path_mtu {
+	uint8_t		opt_reserved;		/* reserved */
+	uint16_t	opt_mtu;		/* largest IP datagram received whole */
+};
+
 
 /*
  * SPM Requests
@@ -43,6 +43,8 @@
 #include <pgm/messages.h>
 #include <pgm/msgv.h>
 #include <pgm/packet.h>
+#include <pgm/reactor.h>
+#include <pgm/selector.h>
 #include <pgm/skbuff.h>
 #include <pgm/socket.h>
 #include <pgm/time.h>
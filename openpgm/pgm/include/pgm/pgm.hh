@@ -29,5 +29,8 @@
 #include <pgm/pgm_socket.hh>
 #include <pgm/ip/pgm_endpoint.hh>
 #include <pgm/ip/pgm.hh>
+#if defined(PGM_HAVE_BOOST_ASIO) || defined(PGM_HAVE_ASIO)
+#	include <pgm/pgm_async_socket.hh>
+#endif
 
 #endif /* __PGM_HH__ */
@@ -0,0 +1,361 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * PGM socket driven by an Asio io_context.
+ *
+ * Copyright (c) 2010 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __PGM_ASYNC_SOCKET_HH__
+#define __PGM_ASYNC_SOCKET_HH__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+// Requires C++14 and POSIX descriptors; select the Asio flavour with
+// PGM_HAVE_BOOST_ASIO or PGM_HAVE_ASIO (standalone) before inclusion.
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#if __cplusplus >= 202002L
+#	include <span>
+#endif
+
+#if defined(PGM_HAVE_BOOST_ASIO)
+#	include <boost/asio.hpp>
+namespace pgm_asio = boost::asio;
+typedef boost::system::error_code pgm_error_code;
+#elif defined(PGM_HAVE_ASIO)
+#	include <asio.hpp>
+namespace pgm_asio = asio;
+typedef std::error_code pgm_error_code;
+#else
+#	error "PGM_HAVE_BOOST_ASIO or PGM_HAVE_ASIO must be defined."
+#endif
+
+#include <pgm/pgm_socket.hh>
+
+template <typename Protocol>
+class pgm_async_socket : public pgm_socket<Protocol>
+{
+public:
+	/// The native socket type.
+	typedef typename pgm_socket<Protocol>::native_type native_type;
+
+	/// The type of the executor associated with the object.
+	typedef pgm_asio::io_context::executor_type executor_type;
+
+	/// Construct a pgm_async_socket without opening it.
+	explicit pgm_async_socket (pgm_asio::io_context& io_context)
+		: io_context_ (io_context),
+		  recv_sock_ (io_context),
+		  pending_sock_ (io_context),
+		  repair_sock_ (io_context),
+		  send_sock_ (io_context),
+		  recv_timer_ (io_context),
+		  send_timer_ (io_context),
+		  is_registered_ (false)
+	{
+	}
+
+	/// Destroy the object, outstanding operations complete with operation_aborted.
+	~pgm_async_socket()
+	{
+		unregister();
+	}
+
+	/// Get the executor associated with the object.
+	executor_type get_executor (void)
+	{
+		return this->io_context_.get_executor();
+	}
+
+	/// Connect non-blocking and register the socket descriptors with the io_context.
+	bool connect (cpgm::pgm_error_t** error)
+	{
+		const int nonblocking = 1;
+		if (!this->set_option (IPPROTO_PGM, cpgm::PGM_NOBLOCK, &nonblocking, sizeof (nonblocking)) ||
+		    !pgm_socket<Protocol>::connect (error))
+			return false;
+		assign (cpgm::PGM_RECV_SOCK, this->recv_sock_);
+		assign (cpgm::PGM_PENDING_SOCK, this->pending_sock_);
+		assign (cpgm::PGM_REPAIR_SOCK, this->repair_sock_);
+		assign (cpgm::PGM_SEND_SOCK, this->send_sock_);
+		this->is_registered_ = true;
+		return true;
+	}
+
+	/// Abort outstanding operations and close the PGM socket implementation.
+	bool close (bool flush)
+	{
+		unregister();
+		return pgm_socket<Protocol>::close (flush);
+	}
+
+	/// Abort outstanding operations, handlers are passed operation_aborted.
+	void cancel (void)
+	{
+		cancel_waits (false);
+		cancel_waits (true);
+	}
+
+	/// Start an asynchronous receive of a batch of APDUs.
+	///
+	/// The vector is filled without copying: skbs remain owned by the receive
+	/// window and are valid until the next receive on the socket.  At most one
+	/// receive may be outstanding.  Handler signature:
+	///	void (pgm_error_code ec, std::size_t bytes_read)
+	template <typename ReadToken>
+	auto async_receive (struct cpgm::pgm_msgv_t* msgv, std::size_t msgv_len, ReadToken&& token)
+	{
+		return pgm_asio::async_initiate<ReadToken, void (pgm_error_code, std::size_t)> (
+			[this, msgv, msgv_len] (auto&& handler) {
+				this->start (false,
+					     [msgv, msgv_len] (native_type sock, std::size_t* bytes_read) {
+						cpgm::pgm_error_t* pgm_err = NULL;
+						const int status = cpgm::pgm_recvmsgv (sock, msgv, msgv_len, MSG_DONTWAIT, bytes_read, &pgm_err);
+						if (NULL != pgm_err)
+							cpgm::pgm_error_free (pgm_err);
+						return status;
+					     },
+					     std::forward<decltype(handler)> (handler));
+			}, token);
+	}
+
+#if __cplusplus >= 202002L
+	/// Start an asynchronous receive of a batch of APDUs into a span.
+	template <typename ReadToken>
+	auto async_receive (std::span<struct cpgm::pgm_msgv_t> msgv, ReadToken&& token)
+	{
+		return async_receive (msgv.data(), msgv.size(), std::forward<ReadToken> (token));
+	}
+#endif
+
+	/// Start an asynchronous send of one APDU, copied once into transmit skbs.
+	///
+	/// Rate limiting is honoured by waiting on PGM_RATE_REMAIN.  At most one send
+	/// may be outstanding and the buffer must remain valid until completion.
+	template <typename WriteToken>
+	auto async_send (const void* buf, std::size_t len, WriteToken&& token)
+	{
+		return pgm_asio::async_initiate<WriteToken, void (pgm_error_code, std::size_t)> (
+			[this, buf, len] (auto&& handler) {
+				this->start (true,
+					     [buf, len] (native_type sock, std::size_t* bytes_sent) {
+						return cpgm::pgm_send (sock, buf, len, bytes_sent);
+					     },
+					     std::forward<decltype(handler)> (handler));
+			}, token);
+	}
+
+	/// Start an asynchronous zero-copy send of a vector of skbs.
+	template <typename WriteToken>
+	auto async_send_skbv (struct cpgm::pgm_sk_buff_t** skbv, unsigned count, bool is_one_apdu, WriteToken&& token)
+	{
+		return pgm_asio::async_initiate<WriteToken, void (pgm_error_code, std::size_t)> (
+			[this, skbv, count, is_one_apdu] (auto&& handler) {
+				this->start (true,
+					     [skbv, count, is_one_apdu] (native_type sock, std::size_t* bytes_sent) {
+						return cpgm::pgm_send_skbv (sock, skbv, count, is_one_apdu, bytes_sent);
+					     },
+					     std::forward<decltype(handler)> (handler));
+			}, token);
+	}
+
+private:
+	typedef pgm_asio::posix::stream_descriptor descriptor_type;
+	typedef pgm_asio::steady_timer timer_type;
+
+	/// State of one outstanding operation, shared by its waits.
+	template <typename Handler, typename Operation>
+	struct io_op
+	{
+		typedef typename pgm_asio::associated_executor<Handler, executor_type>::type handler_executor_type;
+
+		io_op (pgm_async_socket* self_, bool is_send_, Operation operation_, Handler handler_)
+			: self (self_),
+			  is_send (is_send_),
+			  round (0),
+			  operation (std::move (operation_)),
+			  handler (std::move (handler_)),
+			  executor (pgm_asio::get_associated_executor (handler, self_->get_executor()))
+		{
+		}
+
+		pgm_async_socket*	self;
+		const bool		is_send;
+/* bumped per wait so that late waits of a finished round are discarded */
+		unsigned		round;
+		Operation		operation;
+		Handler			handler;
+		handler_executor_type	executor;
+	};
+
+	template <typename Operation, typename Handler>
+	void start (bool is_send, Operation operation, Handler&& handler)
+	{
+		typedef io_op<typename std::decay<Handler>::type, Operation> op_type;
+		std::shared_ptr<op_type> op = std::make_shared<op_type> (this, is_send, std::move (operation), std::forward<Handler> (handler));
+		if (!this->is_registered_) {
+			complete (op, pgm_error_code (pgm_asio::error::bad_descriptor), 0);
+			return;
+		}
+		perform (op);
+	}
+
+	template <typename Op>
+	static void perform (const std::shared_ptr<Op>& op)
+	{
+		std::size_t bytes = 0;
+		const int status = op->operation (op->self->native(), &bytes);
+		switch (status) {
+		case cpgm::PGM_IO_STATUS_NORMAL:
+			complete (op, pgm_error_code(), bytes);
+			break;
+		case cpgm::PGM_IO_STATUS_WOULD_BLOCK:
+		case cpgm::PGM_IO_STATUS_RATE_LIMITED:
+		case cpgm::PGM_IO_STATUS_TIMER_PENDING:
+		case cpgm::PGM_IO_STATUS_CONGESTION:
+			op->self->wait (op, status);
+			break;
+		case cpgm::PGM_IO_STATUS_RESET:
+			complete (op, pgm_error_code (pgm_asio::error::connection_reset), bytes);
+			break;
+		case cpgm::PGM_IO_STATUS_FIN:
+		case cpgm::PGM_IO_STATUS_EOF:
+			complete (op, pgm_error_code (pgm_asio::error::eof), bytes);
+			break;
+		default:
+			complete (op, pgm_error_code (errno ? errno : EIO, pgm_asio::error::get_system_category()), bytes);
+			break;
+		}
+	}
+
+/* Arm every wake-up source for the operation's direction, the first to fire
+ * cancels the others and retries.
+ */
+	template <typename Op>
+	void wait (const std::shared_ptr<Op>& op, int status)
+	{
+		const unsigned round = ++op->round;
+		auto waiter = [op, round] (const pgm_error_code& ec) {
+			if (round != op->round)
+				return;
+			++op->round;
+			if (pgm_asio::error::operation_aborted == ec) {
+				complete (op, ec, 0);
+				return;
+			}
+			op->self->cancel_waits (op->is_send);
+			perform (op);
+		};
+
+		if (op->is_send) {
+			if (cpgm::PGM_IO_STATUS_WOULD_BLOCK == status)
+				this->send_sock_.async_wait (descriptor_type::wait_write, waiter);
+			else
+				arm (this->send_timer_, cpgm::PGM_IO_STATUS_RATE_LIMITED == status ? cpgm::PGM_RATE_REMAIN : cpgm::PGM_TIME_REMAIN, waiter);
+			return;
+		}
+
+		if (this->recv_sock_.is_open())
+			this->recv_sock_.async_wait (descriptor_type::wait_read, waiter);
+		if (this->pending_sock_.is_open())
+			this->pending_sock_.async_wait (descriptor_type::wait_read, waiter);
+		if (this->repair_sock_.is_open())
+			this->repair_sock_.async_wait (descriptor_type::wait_read, waiter);
+		if (cpgm::PGM_IO_STATUS_RATE_LIMITED == status)
+			arm (this->recv_timer_, cpgm::PGM_RATE_REMAIN, waiter);
+		else if (cpgm::PGM_IO_STATUS_WOULD_BLOCK != status)
+			arm (this->recv_timer_, cpgm::PGM_TIME_REMAIN, waiter);
+	}
+
+	template <typename Waiter>
+	void arm (timer_type& timer, int optname, Waiter&& waiter)
+	{
+		struct timeval tv = { 0, 0 };
+		::socklen_t optlen = sizeof (tv);
+		this->get_option (IPPROTO_PGM, optname, &tv, &optlen);
+		timer.expires_after (std::chrono::seconds (tv.tv_sec) + std::chrono::microseconds (tv.tv_usec));
+		timer.async_wait (std::forward<Waiter> (waiter));
+	}
+
+	template <typename Op>
+	static void complete (const std::shared_ptr<Op>& op, const pgm_error_code& ec, std::size_t bytes)
+	{
+		pgm_asio::post (op->executor, [op, ec, bytes]() {
+			std::move (op->handler) (ec, bytes);
+		});
+	}
+
+	void cancel_waits (bool is_send)
+	{
+		pgm_error_code ec;
+		if (is_send) {
+			this->send_sock_.cancel (ec);
+			this->send_timer_.cancel();
+			return;
+		}
+		this->recv_sock_.cancel (ec);
+		this->pending_sock_.cancel (ec);
+		this->repair_sock_.cancel (ec);
+		this->recv_timer_.cancel();
+	}
+
+	void assign (int optname, descriptor_type& descriptor)
+	{
+		int fd = -1;
+		::socklen_t optlen = sizeof (fd);
+		pgm_error_code ec;
+		if (this->get_option (IPPROTO_PGM, optname, &fd, &optlen) && fd >= 0)
+			descriptor.assign (fd, ec);
+	}
+
+/* descriptors belong to the PGM socket, release rather than close */
+	void unregister (void)
+	{
+		if (!this->is_registered_)
+			return;
+		this->is_registered_ = false;
+		this->recv_timer_.cancel();
+		this->send_timer_.cancel();
+		release (this->recv_sock_);
+		release (this->pending_sock_);
+		release (this->repair_sock_);
+		release (this->send_sock_);
+	}
+
+	static void release (descriptor_type& descriptor)
+	{
+		if (descriptor.is_open())
+			descriptor.release();
+	}
+
+	pgm_asio::io_context&	io_context_;
+	descriptor_type		recv_sock_;
+	descriptor_type		pending_sock_;
+	descriptor_type		repair_sock_;
+	descriptor_type		send_sock_;
+	timer_type		recv_timer_;
+	timer_type		send_timer_;
+	bool			is_registered_;
+};
+
+#endif /* __PGM_ASYNC_SOCKET_HH__ */
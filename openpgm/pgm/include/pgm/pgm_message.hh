@@ -0,0 +1,295 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Zero-copy views of received PGM messages.
+ *
+ * Copyright (c) 2010 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __PGM_MESSAGE_HH__
+#define __PGM_MESSAGE_HH__
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+// Requires C++11; fragments are std::span<const std::byte> under C++20.
+
+#include <cstddef>
+#if __cplusplus >= 202002L
+#	include <span>
+#endif
+
+#include <pgm/pgm_socket.hh>
+
+/// One received APDU as the packets carrying its fragments.  A view filled
+/// by pgm_message_batch borrows the packets from the receive window and is
+/// valid until the next read of the socket; retain() returns a view owning
+/// references that remain valid until it is destroyed, on any thread.
+class pgm_message_view
+{
+public:
+#if __cplusplus >= 202002L
+	typedef std::byte byte_type;
+
+	/// The contiguous payload of one fragment.
+	typedef std::span<const std::byte> fragment_type;
+#else
+	typedef char byte_type;
+
+	/// The contiguous payload of one fragment.
+	class fragment_type
+	{
+	public:
+		fragment_type (const void* data, std::size_t size) : data_ (data), size_ (size) {}
+		const void* data() const { return this->data_; }
+		std::size_t size() const { return this->size_; }
+	private:
+		const void* data_;
+		std::size_t size_;
+	};
+#endif
+
+	/// Iterator over the fragments of the message.
+	class const_iterator
+	{
+	public:
+		explicit const_iterator (struct cpgm::pgm_sk_buff_t* const* skb) : skb_ (skb) {}
+		fragment_type operator* () const
+		{
+			return fragment_type (static_cast<const byte_type*> ((*this->skb_)->data), (*this->skb_)->len);
+		}
+		const_iterator& operator++ () { ++this->skb_; return *this; }
+		bool operator== (const const_iterator& other) const { return this->skb_ == other.skb_; }
+		bool operator!= (const const_iterator& other) const { return this->skb_ != other.skb_; }
+	private:
+		struct cpgm::pgm_sk_buff_t* const* skb_;
+	};
+
+	/// Construct an empty view.
+	pgm_message_view() : msgv_ (nullptr), is_owner_ (false)
+	{
+	}
+
+	/// Construct a view borrowing a message of the receive window.
+	explicit pgm_message_view (const struct cpgm::pgm_msgv_t* msgv) : msgv_ (msgv), is_owner_ (false)
+	{
+	}
+
+	pgm_message_view (const pgm_message_view&) = delete;
+	pgm_message_view& operator= (const pgm_message_view&) = delete;
+
+	pgm_message_view (pgm_message_view&& other) noexcept
+		: msgv_ (other.msgv_), is_owner_ (other.is_owner_)
+	{
+		if (other.is_owner_) {
+			this->owned_ = other.owned_;
+			this->msgv_ = &this->owned_;
+		}
+		other.msgv_ = nullptr;
+		other.is_owner_ = false;
+	}
+
+	pgm_message_view& operator= (pgm_message_view&& other) noexcept
+	{
+		if (this != &other) {
+			this->reset();
+			this->msgv_ = other.msgv_;
+			this->is_owner_ = other.is_owner_;
+			if (other.is_owner_) {
+				this->owned_ = other.owned_;
+				this->msgv_ = &this->owned_;
+			}
+			other.msgv_ = nullptr;
+			other.is_owner_ = false;
+		}
+		return *this;
+	}
+
+	/// Release owned packet references.
+	~pgm_message_view()
+	{
+		this->reset();
+	}
+
+	/// Take packet references such that the message outlives the next read
+	/// and may be handed to another thread.  Copies only records of coalesced
+	/// TPDUs, which have no packet of their own.
+	pgm_message_view retain() const
+	{
+		pgm_message_view view;
+		if (nullptr == this->msgv_)
+			return view;
+		view.owned_.msgv_len = this->msgv_->msgv_len;
+		for (unsigned i = 0; i < this->msgv_->msgv_len; i++)
+			view.owned_.msgv_skb[ i ] = cpgm::pgm_skb_retain (this->msgv_->msgv_skb[ i ]);
+		view.msgv_ = &view.owned_;
+		view.is_owner_ = true;
+		return view;
+	}
+
+	/// Release owned references and empty the view.
+	void reset()
+	{
+		if (this->is_owner_)
+			for (unsigned i = 0; i < this->owned_.msgv_len; i++)
+				cpgm::pgm_free_skb (this->owned_.msgv_skb[ i ]);
+		this->msgv_ = nullptr;
+		this->is_owner_ = false;
+	}
+
+	/// Whether the view holds its own packet references.
+	bool is_retained() const
+	{
+		return this->is_owner_;
+	}
+
+	/// Number of fragments.
+	std::size_t size() const
+	{
+		return nullptr == this->msgv_ ? 0 : this->msgv_->msgv_len;
+	}
+
+	/// Total payload bytes.
+	std::size_t bytes() const
+	{
+		std::size_t len = 0;
+		for (std::size_t i = 0; i < this->size(); i++)
+			len += this->msgv_->msgv_skb[ i ]->len;
+		return len;
+	}
+
+	/// Transport session of the sender.
+	const struct cpgm::pgm_tsi_t& tsi() const
+	{
+		return this->msgv_->msgv_skb[ 0 ]->tsi;
+	}
+
+	/// The underlying message vector.
+	const struct cpgm::pgm_msgv_t* native() const
+	{
+		return this->msgv_;
+	}
+
+	fragment_type operator[] (std::size_t i) const
+	{
+		return *const_iterator (&this->msgv_->msgv_skb[ i ]);
+	}
+
+	const_iterator begin() const
+	{
+		return const_iterator (nullptr == this->msgv_ ? nullptr : &this->msgv_->msgv_skb[ 0 ]);
+	}
+
+	const_iterator end() const
+	{
+		return const_iterator (nullptr == this->msgv_ ? nullptr : &this->msgv_->msgv_skb[ this->msgv_->msgv_len ]);
+	}
+
+private:
+	const struct cpgm::pgm_msgv_t* msgv_;
+	bool is_owner_;
+	struct cpgm::pgm_msgv_t owned_;
+};
+
+/// Up to MaxMessages APDUs of one read held in place, no allocation per
+/// read or per message.  Views borrow from the receive window and are valid
+/// until the next read of the socket.
+template <std::size_t MaxMessages = 32>
+class pgm_message_batch
+{
+public:
+	/// Iterator over the messages of the batch.
+	class const_iterator
+	{
+	public:
+		explicit const_iterator (const struct cpgm::pgm_msgv_t* msgv) : msgv_ (msgv) {}
+		pgm_message_view operator* () const { return pgm_message_view (this->msgv_); }
+		const_iterator& operator++ () { ++this->msgv_; return *this; }
+		bool operator== (const const_iterator& other) const { return this->msgv_ == other.msgv_; }
+		bool operator!= (const const_iterator& other) const { return this->msgv_ != other.msgv_; }
+	private:
+		const struct cpgm::pgm_msgv_t* msgv_;
+	};
+
+	/// Construct an empty batch.
+	pgm_message_batch() : len_ (0), bytes_ (0)
+	{
+	}
+
+	pgm_message_batch (const pgm_message_batch&) = delete;
+	pgm_message_batch& operator= (const pgm_message_batch&) = delete;
+	pgm_message_batch (pgm_message_batch&&) = default;
+	pgm_message_batch& operator= (pgm_message_batch&&) = default;
+
+	/// Read the next batch from socket with pgm_recvmsgv(), returning its
+	/// PGM_IO_STATUS_*.  Views of the previous batch become invalid.
+	template <typename Socket>
+	int receive (Socket& socket, int flags, cpgm::pgm_error_t** error)
+	{
+		return this->receive (socket.native(), flags, error);
+	}
+
+	int receive (struct cpgm::pgm_sock_t* sock, int flags, cpgm::pgm_error_t** error)
+	{
+		std::size_t bytes_read = 0;
+		this->len_ = this->bytes_ = 0;
+		const int status = cpgm::pgm_recvmsgv (sock, this->msgv_, MaxMessages, flags, &bytes_read, error);
+		if (cpgm::PGM_IO_STATUS_NORMAL != status)
+			return status;
+		this->bytes_ = bytes_read;
+		while (bytes_read > 0 && this->len_ < MaxMessages) {
+			const struct cpgm::pgm_msgv_t& msgv = this->msgv_[ this->len_++ ];
+			for (unsigned j = 0; j < msgv.msgv_len; j++)
+				bytes_read -= bytes_read < msgv.msgv_skb[ j ]->len ? bytes_read : msgv.msgv_skb[ j ]->len;
+		}
+		return status;
+	}
+
+	/// Number of messages.
+	std::size_t size() const
+	{
+		return this->len_;
+	}
+
+	/// Total payload bytes.
+	std::size_t bytes() const
+	{
+		return this->bytes_;
+	}
+
+	pgm_message_view operator[] (std::size_t i) const
+	{
+		return pgm_message_view (&this->msgv_[ i ]);
+	}
+
+	const_iterator begin() const
+	{
+		return const_iterator (&this->msgv_[ 0 ]);
+	}
+
+	const_iterator end() const
+	{
+		return const_iterator (&this->msgv_[ this->len_ ]);
+	}
+
+private:
+	std::size_t len_;
+	std::size_t bytes_;
+	struct cpgm::pgm_msgv_t msgv_[ MaxMessages ];
+};
+
+#endif /* __PGM_MESSAGE_HH__ */
@@ -131,6 +131,24 @@ public:
 		return pgm_send (this->native_type_, buf, len, bytes_sent);
 	}
 
+	/// Begin an APDU of len bytes to be sent as it is appended.
+	int send_begin (std::size_t len)
+	{
+		return pgm_send_begin (this->native_type_, len);
+	}
+
+	/// Append data to the APDU, sending each fragment filled.
+	int send_append (const void* buf, std::size_t len, std::size_t* bytes_sent)
+	{
+		return pgm_send_append (this->native_type_, buf, len, bytes_sent);
+	}
+
+	/// Complete the APDU.
+	int send_commit (std::size_t* bytes_sent)
+	{
+		return pgm_send_commit (this->native_type_, bytes_sent);
+	}
+
 	/// Receive some data from the peer.
 	int receive (void* buf, std::size_t len, int flags, std::size_t* bytes_read, cpgm::pgm_error_t** error)
 	{
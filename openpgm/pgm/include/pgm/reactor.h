@@ -0,0 +1,55 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Thread per core event loops each owning a shard of PGM sockets.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_REACTOR_H__
+#define __PGM_REACTOR_H__
+
+typedef struct pgm_reactor_t pgm_reactor_t;
+
+#include <pgm/types.h>
+#include <pgm/error.h>
+#include <pgm/socket.h>
+#include <pgm/selector.h>
+
+PGM_BEGIN_DECLS
+
+/* called on the owning core for a ready socket with PGM_SELECTOR_* events,
+ * services the socket with a receive call.
+ */
+typedef void (*pgm_reactor_event_func_t) (pgm_sock_t*, unsigned, void*);
+
+/* work passed to a core, run on that core between events */
+typedef void (*pgm_reactor_task_func_t) (void*);
+
+bool pgm_reactor_create (pgm_reactor_t**restrict, const unsigned, pgm_reactor_event_func_t, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+unsigned pgm_reactor_cores (const pgm_reactor_t*const) PGM_GNUC_PURE;
+int pgm_reactor_self (const pgm_reactor_t*const);
+bool pgm_reactor_post (pgm_reactor_t*const, const unsigned, pgm_reactor_task_func_t, void*);
+bool pgm_reactor_add (pgm_reactor_t*const restrict, pgm_sock_t*const restrict, void*, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+bool pgm_reactor_remove (pgm_reactor_t*const restrict, pgm_sock_t*const restrict);
+void pgm_reactor_destroy (pgm_reactor_t*);
+
+PGM_END_DECLS
+
+#endif /* __PGM_REACTOR_H__ */
@@ -0,0 +1,56 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * PGM socket selector, readiness and timers across many sockets.
+ *
+ * Copyright (c) 2006-2010 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_SELECTOR_H__
+#define __PGM_SELECTOR_H__
+
+typedef struct pgm_selector_t pgm_selector_t;
+
+#include <pgm/types.h>
+#include <pgm/error.h>
+#include <pgm/socket.h>
+
+PGM_BEGIN_DECLS
+
+/* reasons a socket is ready */
+#define PGM_SELECTOR_DATA			0x1	/* packets received or messages pending */
+#define PGM_SELECTOR_REPAIR			0x2	/* repair requests queued for the source */
+#define PGM_SELECTOR_ACK			0x4	/* PGMCC acknowledgement received */
+#define PGM_SELECTOR_TIMER			0x8	/* socket timer expired */
+
+struct pgm_selector_event_t {
+	pgm_sock_t*	sock;
+	void*		user_data;
+	unsigned	events;			/* PGM_SELECTOR_* */
+};
+
+bool pgm_selector_create (pgm_selector_t**restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+bool pgm_selector_add (pgm_selector_t*const restrict, pgm_sock_t*const restrict, void*, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+bool pgm_selector_remove (pgm_selector_t*const restrict, pgm_sock_t*const restrict);
+int pgm_selector_wait (pgm_selector_t*const restrict, struct pgm_selector_event_t*const restrict, const unsigned, const int, pgm_error_t**restrict);
+void pgm_selector_destroy (pgm_selector_t*);
+
+PGM_END_DECLS
+
+#endif /* __PGM_SELECTOR_H__ */
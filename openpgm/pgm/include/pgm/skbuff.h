@@ -28,6 +28,7 @@
 #include <string.h>
 
 struct pgm_sk_buff_t;
+struct pgm_skb_pool_t;
 
 #include <pgm/types.h>
 #include <pgm/atomic.h>
@@ -45,6 +46,8 @@ struct pgm_sk_buff_t {
 
 	pgm_sock_t* restrict		sock;
 	pgm_time_t			tstamp;
+	pgm_time_t			rx_tstamp;	/* kernel or NIC arrival since epoch in μs, 0 for none */
+	pgm_time_t			send_tstamp;	/* source send since epoch in μs by OPT_TIMESTAMP, 0 for none */
 	pgm_tsi_t			tsi;
 
 	uint32_t			sequence;
@@ -54,7 +57,13 @@ struct pgm_sk_buff_t {
 
 	uint16_t			len;		/* actual data */
 	unsigned			zero_padded:1;
-	unsigned			__padding2:31;	/* fix bit field */
+	unsigned			coalesced:1;	/* payload of length prefixed APDUs */
+	unsigned			preparsed:1;	/* ODATA fields validated by the parser */
+	unsigned			csum_verified:1; /* PGM checksum passed ahead of parsing */
+	unsigned			compressed:1;	/* TPDU of an LZ4 compressed APDU */
+	unsigned			unreliable:1;	/* OPT_UNRELIABLE of preceding sequences */
+	unsigned			crc32c:1;	/* CRC32C trailer appended or verified */
+	unsigned			__padding2:25;	/* fix bit field */
 
 	struct pgm_header*		pgm_header;
 	struct pgm_opt_fragment* 	pgm_opt_fragment;
@@ -70,11 +79,19 @@ struct pgm_sk_buff_t {
 				       *end;
 	uint32_t			truesize;
 	volatile uint32_t		users;		/* atomic */
+	struct pgm_skb_pool_t*		pool;		/* owning slab, NULL for heap */
 };
 
+/* DPDK mbuf private area for received packets to carry their pgm_sk_buff_t
+ * in place, argument priv_size of rte_pktmbuf_pool_create().
+ */
+#define PGM_SKB_MBUF_PRIV_SIZE		((sizeof(struct pgm_sk_buff_t) + 7) & ~(size_t)7)
+
 void pgm_skb_over_panic (const struct pgm_sk_buff_t*const, const uint16_t) PGM_GNUC_NORETURN;
 void pgm_skb_under_panic (const struct pgm_sk_buff_t*const, const uint16_t) PGM_GNUC_NORETURN;
 bool pgm_skb_is_valid (const struct pgm_sk_buff_t*const) PGM_GNUC_PURE PGM_GNUC_WARN_UNUSED_RESULT;
+void pgm_skb_pool_release (struct pgm_sk_buff_t*const);
+struct pgm_sk_buff_t* pgm_skb_retain (struct pgm_sk_buff_t*const) PGM_GNUC_WARN_UNUSED_RESULT;
 
 /* attribute __pure__ only valid for platforms with atomic ops.
  * attribute __malloc__ not used as only part of the memory should be aliased.
@@ -125,8 +142,12 @@ pgm_free_skb (
 	struct pgm_sk_buff_t*const skb
 	)
 {
-	if (pgm_atomic_exchange_and_add32 (&skb->users, (uint32_t)-1) == 1)
-		pgm_free (skb);
+	if (pgm_atomic_exchange_and_add32 (&skb->users, (uint32_t)-1) == 1) {
+		if (skb->pool)
+			pgm_skb_pool_release (skb);
+		else
+			pgm_free (skb);
+	}
 }
 
 /* add data */
@@ -217,6 +238,7 @@ pgm_skb_copy (
 	memcpy (newskb, skb, PGM_OFFSETOF(struct pgm_sk_buff_t, pgm_header));
 	newskb->zero_padded = 0;
 	newskb->truesize = skb->truesize;
+	newskb->pool = NULL;
 	pgm_atomic_write32 (&newskb->users, 1);
 	newskb->head = newskb + 1;
 	newskb->end  = (char*)newskb->head + ((char*)skb->end  - (char*)skb->head);
@@ -36,6 +36,10 @@ struct pgm_fecinto_t;
 #ifdef HAVE_EPOLL
 #	include <sys/epoll.h>
 #endif
+#ifdef HAVE_KQUEUE
+#	include <sys/types.h>
+#	include <sys/event.h>
+#endif
 #ifndef _WIN32
 #ifdef _AIX
 #   define IP_MULTICAST
@@ -88,12 +92,208 @@ struct pgm_fecinfo_t {
 	bool					var_pktlen_enabled;
 };
 
+struct pgm_adaptivefecinfo_t {
+	uint8_t					min_proactive_packets;
+	uint8_t					max_proactive_packets;
+};
+
 struct pgm_pgmccinfo_t {
 	uint32_t				ack_bo_ivl;
 	uint32_t				ack_c;
 	uint32_t				ack_c_p;
 };
 
+struct pgm_xdpinfo_t {
+	uint32_t				queue_id;	/* NIC queue of send interface */
+	int					xskmap_fd;	/* BPF_MAP_TYPE_XSKMAP, < 0 disables */
+};
+
+struct pgm_dpdkinfo_t {
+	int32_t					port_id;	/* started ethdev port, < 0 disables */
+	uint16_t				queue_id;	/* receive and transmit queue pair */
+};
+
+struct pgm_iocpinfo_t {
+	void*					port;		/* I/O completion port HANDLE, NULL disables */
+	uintptr_t				key;		/* completion key of receive notifications */
+};
+
+struct pgm_skbmeminfo_t {
+	void*					addr;		/* application owned packet memory */
+	size_t					len;		/* bytes, NULL addr disables */
+};
+
+struct pgm_replayinfo_t {
+	const char*				path;		/* pcap capture, NULL disables */
+	uint32_t				speed;		/* percent of captured timing, 0 = maximum */
+	uint64_t				packets;	/* read back: packets replayed */
+};
+
+struct pgm_shminfo_t {
+	const char*				name;		/* shared memory ring, NULL disables */
+	uint32_t				slots;		/* publisher ring capacity in packets, 0 = default */
+	uint32_t				interval;	/* usecs between idle ring polls, 0 = default */
+	uint64_t				packets;	/* read back: packets published or read */
+	uint64_t				overruns;	/* read back: packets lost to the publisher lapping */
+};
+
+struct pgm_loopinfo_t {
+	const char*				name;		/* in-process bus, NULL disables */
+	uint32_t				loss_rate;	/* sent packets dropped, parts per million */
+	uint32_t				reorder_rate;	/* sent packets delivered behind the next, parts per million */
+	uint32_t				seed;		/* channel model generator, 0 = random */
+	uint64_t				packets;	/* read back: packets read from the bus */
+	uint64_t				overruns;	/* read back: packets dropped on a full queue */
+	uint64_t				losses;		/* read back: sent packets dropped by the model */
+};
+
+struct pgm_rategroupinfo_t {
+	const char*				name;		/* process-wide aggregate limit, NULL disables */
+	int64_t					max_rte;	/* group bytes per second, 0 = as created by another member */
+	int64_t					min_rte;	/* bytes per second sent regardless of other members, 0 for none */
+	uint32_t				members;	/* read back: sockets of the group */
+};
+
+struct pgm_txloginfo_t {
+	const char*				path;		/* segment file prefix, NULL disables */
+	uint32_t				segment_sqns;	/* sequences per segment, 0 = default */
+	uint32_t				segments;	/* segments retained, 0 = default */
+	uint32_t				trail;		/* read back: oldest logged sequence */
+	uint64_t				packets;	/* read back: packets appended */
+	uint64_t				retransmits;	/* read back: repairs served from the log */
+};
+
+struct pgm_joininfo_t {
+	uint32_t				sequence;	/* first sequence requested of a new source */
+	int					is_oldest;	/* from the oldest sequence offered, sequence ignored */
+};
+
+struct pgm_rxtuneinfo_t {
+	uint32_t				rcvbuf_min;	/* kernel receive buffer bytes, 0 = default */
+	uint32_t				rcvbuf_max;	/* 0 disables */
+	uint32_t				rxw_min_sqns;	/* receive window bounds, 0 = default */
+	uint32_t				rxw_max_sqns;	/* 0 leaves receive windows untuned */
+	uint32_t				rxw_secs;	/* span of the observed rate held, 0 = default */
+	uint32_t				rate;		/* read back: bytes per second received */
+	uint32_t				rcvbuf;		/* read back: kernel receive buffer requested */
+	uint32_t				rxw_sqns;	/* read back: receive window of new peers */
+	uint64_t				drops;		/* read back: kernel receive queue overflows */
+};
+
+/* conflation: key of a message, returning FALSE for a message always delivered.
+ */
+typedef bool (*pgm_conflate_key_t) (const struct pgm_msgv_t*, uint64_t*, void*);
+
+struct pgm_conflateinfo_t {
+	pgm_conflate_key_t			key;		/* NULL disables */
+	void*					user_data;
+	uint64_t				conflated;	/* read back: superseded messages not delivered */
+};
+
+/* asynchronous receive: callback of messages, message count, PGM_IO_STATUS_* and user data.
+ * executor runs task(arg) on a caller thread.
+ */
+typedef void (*pgm_recv_callback_t) (pgm_sock_t*, const struct pgm_msgv_t*, size_t, int, void*);
+typedef void (*pgm_executor_t) (void (*)(void*), void*, void*);
+
+struct pgm_recvasyncinfo_t {
+	pgm_recv_callback_t			callback;
+	void*					user_data;
+	pgm_executor_t				executor;	/* NULL calls back on the receive thread */
+	void*					executor_data;
+	unsigned				max_msgv;	/* messages per batch, 0 = default */
+	unsigned				max_inflight;	/* batches queued on the executor, 0 = default */
+};
+
+struct pgm_relaysubinfo_t {
+	struct sockaddr_storage			addr;		/* unicast subscriber, port 0 = UDP encapsulation multicast port */
+	uint32_t				rate;		/* bytes per second, 0 = unlimited */
+};
+
+struct pgm_standbyinfo_t {
+	struct sockaddr_storage			addr;		/* side channel of the standby, with port */
+	struct sockaddr_storage			peer;		/* primary: local side channel address, AF_UNSPEC for any.
+								 * standby: side channel of the primary, port 0 for any */
+	int					is_standby;	/* mirror the primary at addr, else mirror to addr */
+	uint32_t				timeout;	/* standby: usecs without mirror before takeover, 0 = manual */
+	int					is_active;	/* read back: sending as the source */
+	uint64_t				packets;	/* read back: packets mirrored */
+	uint64_t				gaps;		/* read back: standby window restarts on lost packets */
+	uint64_t				refused;	/* read back: standby side channel packets not from the peer */
+};
+
+struct pgm_peerweightinfo_t {
+	pgm_tsi_t				tsi;		/* source */
+	uint32_t				weight;		/* multiple of PGM_RECV_QUANTUM, 0 = default of 1 */
+	int					is_priority;	/* flushed ahead of other sources */
+};
+
+/* PGM_PEER_STATS: metrics of one source, all but tsi read back */
+struct pgm_peerstatsinfo_t {
+	pgm_tsi_t				tsi;		/* source */
+	uint64_t				data_bytes;	/* payload bytes received */
+	uint64_t				data_msgs;	/* data packets received */
+	uint64_t				bytes_per_sec;	/* payload rate over the last second sampled */
+	uint64_t				msgs_per_sec;
+	uint64_t				losses;		/* sequences lost without repair */
+	uint64_t				naks_sent;	/* selective and parity sequences requested */
+	uint64_t				rxw_size;	/* bytes held by the receive window */
+	uint32_t				rxw_length;	/* sequences held by the receive window */
+	uint32_t				rxw_max_length;
+	uint32_t				loss_rate;	/* moving average of data loss, parts per million */
+	uint32_t				repair_p50;	/* μs from loss detection to repair, bucket upper bound */
+	uint32_t				repair_p90;
+	uint32_t				repair_p99;
+	uint32_t				repair_max;
+	uint32_t				rtt;		/* smoothed NAK round-trip time in μs, 0 for no sample */
+	uint32_t				send_latency_p50; /* μs from send time in OPT_TIMESTAMP to delivery, bucket upper bound, 0 for no sample */
+	uint32_t				send_latency_p90;
+	uint32_t				send_latency_p99;
+	uint64_t				rxw_peak_size;	/* high-water of rxw_size */
+	uint32_t				rxw_peak_length;
+	uint32_t				residency_p50;	/* μs from window insert to release after delivery, bucket upper bound */
+	uint32_t				residency_p90;
+	uint32_t				residency_p99;
+	uint32_t				residency_max;
+};
+
+/* PGM_SOURCE_STATS: transmit window metrics of the socket as a source, read
+ * back.
+ */
+struct pgm_sourcestatsinfo_t {
+	uint64_t				txw_size;	/* bytes held by the transmit window */
+	uint64_t				txw_peak_size;	/* high-water of txw_size */
+	uint32_t				txw_length;	/* sequences held by the transmit window */
+	uint32_t				txw_peak_length;
+	uint32_t				txw_max_length;
+	uint32_t				residency_p50;	/* μs from window insert to removal at the trail, bucket upper bound */
+	uint32_t				residency_p90;
+	uint32_t				residency_p99;
+	uint32_t				residency_max;
+	uint32_t				rdata_age_p50;	/* sequences behind the lead of data repaired, bucket upper bound */
+	uint32_t				rdata_age_p90;
+	uint32_t				rdata_age_p99;
+	uint32_t				rdata_age_max;
+};
+
+/* PGM_RATES: per second rates over up to the last interval seconds, of the
+ * socket itself as a source with its own tsi, else of the source of tsi.
+ */
+struct pgm_rateinfo_t {
+	pgm_tsi_t				tsi;
+	uint32_t				interval;	/* seconds, 1 to 59, read back: seconds covered, 0 before two samples */
+	uint64_t				packets_per_sec; /* data packets sent or received */
+	uint64_t				bytes_per_sec;	/* payload bytes sent or received */
+	uint64_t				naks_per_sec;	/* sequences NAKed to or by this socket */
+	uint64_t				losses_per_sec;	/* sequences lost without repair, 0 for the socket itself */
+};
+
+struct pgm_flightrecinfo_t {
+	uint32_t				len;		/* events kept, rounded up to a power of two, 0 = disabled */
+	int					dump_on_reset;	/* log the recorder on unrecoverable loss */
+	uint32_t				events;		/* read back: events recorded, modulo 2^32 */
+};
+
 /* socket options */
 enum {
 	PGM_SEND_SOCK		= 0x2000,
@@ -149,9 +349,127 @@ enum {
 	PGM_UNCONTROLLED_ODATA,
 	PGM_UNCONTROLLED_RDATA,
 	PGM_ODATA_MAX_RTE,
-	PGM_RDATA_MAX_RTE
+	PGM_RDATA_MAX_RTE,
+	PGM_RECV_BATCH,
+	PGM_SEND_BATCH,
+	PGM_SKB_POOL,
+	PGM_SKB_POOL_HITS,
+	PGM_SKB_POOL_MISSES,
+	PGM_UDP_GSO,
+	PGM_UDP_GRO,
+	PGM_XDP,
+	PGM_IO_URING,
+	PGM_BUSY_POLL,
+	PGM_FEC_THREAD,
+	PGM_PARITY_CACHE,
+	PGM_PARITY_CACHE_HITS,
+	PGM_PARITY_CACHE_MISSES,
+	PGM_ADAPTIVE_FEC,
+	PGM_UDP_ENCAP_ZERO_CHECKSUM,
+	PGM_ZERO_CHECKSUM_SENT,
+	PGM_ZERO_CHECKSUM_RECEIVED,
+	PGM_RECV_SHARDS,
+	PGM_RECV_SHARD_SOCKS,
+	PGM_RDATA_THREAD,
+	PGM_RXW_MIN_SQNS,
+	PGM_RXW_SHRINK,
+	PGM_TXW_SLOTS,
+	PGM_HUGETLB,
+	PGM_MLOCK,
+	PGM_PINNED_BYTES,
+	PGM_NUMA_NODE,
+	PGM_COALESCE,
+	PGM_COALESCE_IVL,
+	PGM_TXTIME,
+	PGM_TX_PRIORITY,
+	PGM_RDATA_SHARE,
+	PGM_NAK_ADAPTIVE,
+	PGM_NAK_RANGE,
+	PGM_LATENCY_BUDGET,
+	PGM_UNORDERED,
+	PGM_ZEROCOPY,
+	PGM_SKB_POOL_MEMORY,
+	PGM_SHARED_RECV,
+	PGM_RX_TIMESTAMP,
+	PGM_REPLAY,
+	PGM_SHM,
+	PGM_TXLOG,
+	PGM_LATE_JOIN,
+	PGM_RXW_SPILL,
+	PGM_TXW_MAX_SQNS,
+	PGM_RX_TUNE,
+	PGM_EVENT_SOCK,
+	PGM_RIO,
+	PGM_RIO_IOCP,
+	PGM_DPDK,
+	PGM_SEND_STRIPE,
+	PGM_SEND_PATH,
+	PGM_DLR,
+	PGM_DLR_REDIRECT,
+	PGM_PEER_REPAIR,
+	PGM_POLL_IVL,
+	PGM_POLL_POPULATION,
+	PGM_USE_TFMCC,
+	PGM_TXW_ACK_RELEASE,
+	PGM_TXW_ACK_QUORUM,
+	PGM_MEM_BUDGET,
+	PGM_MEM_USED,
+	PGM_RX_COMPACT,
+	PGM_EXCLUSIVE,
+	PGM_INCOMING_CPU,
+	PGM_RX_CPU,
+	PGM_RX_REASSEMBLE,
+	PGM_DECODE_THREADS,
+	PGM_RELAY,
+	PGM_RELAY_SUBSCRIBER,
+	PGM_STANDBY,
+	PGM_STANDBY_TAKEOVER,
+	PGM_COMPRESS,
+	PGM_RECV_QUANTUM,
+	PGM_PEER_WEIGHT,
+	PGM_FLIGHTREC,
+	PGM_PEERS,
+	PGM_PEER_STATS,
+	PGM_STREAM_COPY,
+	PGM_SEND_TIMESTAMP,
+	PGM_NAK_POPULATION,
+	PGM_NAK_RECEIVER_RATE,
+	PGM_NAK_BATCH,
+	PGM_CRC32C,
+	PGM_XDP_FILTER,
+	PGM_PREWARM,
+	PGM_PREWARM_BYTES,
+	PGM_RATES,
+	PGM_PMTU_DISCOVERY,
+	PGM_PATH_MTU,
+	PGM_ODATA_DSCP,
+	PGM_RDATA_DSCP,
+	PGM_SPM_DSCP,
+	PGM_NAK_DSCP,
+	PGM_LOOPBACK,
+	PGM_RATE_GROUP,
+	PGM_FEC_IDLE_IVL,
+	PGM_SPM_SUPPRESS_IVL,
+	PGM_MULTI_PRODUCER,
+	PGM_CONFLATE,
+	PGM_SEND_ASYNC,
+	PGM_SOURCE_STATS
 };
 
+/* PGM_NUMA_NODE placement other than an explicit node */
+#define PGM_NUMA_NODE_NONE			(-1)	/* first touch by the allocating thread */
+#define PGM_NUMA_NODE_INTERFACE			(-2)	/* node of the bound interface device */
+
+/* PGM_TXTIME launch time clock by pacing qdisc */
+#define PGM_TXTIME_NONE				0	/* regulate rate in userspace */
+#define PGM_TXTIME_FQ				1	/* fq, monotonic clock */
+#define PGM_TXTIME_ETF				2	/* etf, TAI clock */
+
+/* PGM_RX_TIMESTAMP source of packet arrival time */
+#define PGM_RX_TIMESTAMP_NONE			0	/* time of processing only */
+#define PGM_RX_TIMESTAMP_SOFTWARE		1	/* kernel, SO_TIMESTAMPNS */
+#define PGM_RX_TIMESTAMP_HARDWARE		2	/* NIC, SO_TIMESTAMPING */
+
 /* IO status */
 enum {
 	PGM_IO_STATUS_ERROR,		/* an error occurred */
@@ -174,6 +492,7 @@ enum {
 #define PGM_BUS_SOCKET_WRITE_COUNT		PGM_SEND_SOCKET_WRITE_COUNT
 
 bool pgm_socket (pgm_sock_t**restrict, const sa_family_t, const int, const int, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+bool pgm_socket_clone (pgm_sock_t**restrict, pgm_sock_t*const restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
 bool pgm_bind (pgm_sock_t*restrict, const struct pgm_sockaddr_t*const restrict, const socklen_t, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
 bool pgm_bind3 (pgm_sock_t*restrict, const struct pgm_sockaddr_t*const restrict, const socklen_t, const struct pgm_interface_req_t*const, const socklen_t, const struct pgm_interface_req_t*const, const socklen_t, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
 bool pgm_connect (pgm_sock_t*restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
@@ -183,12 +502,29 @@ bool pgm_getsockopt (pgm_sock_t*const restrict, const int, const int, void*restr
 bool pgm_getaddrinfo (const char*restrict, const struct pgm_addrinfo_t*const restrict, struct pgm_addrinfo_t**restrict, pgm_error_t**restrict);
 void pgm_freeaddrinfo (struct pgm_addrinfo_t*);
 int pgm_send (pgm_sock_t*const restrict, const void*restrict, const size_t, size_t*restrict);
+int pgm_sendfile (pgm_sock_t*const restrict, const int, const uint64_t, const size_t, size_t*restrict);
+int pgm_send_begin (pgm_sock_t*const restrict, const size_t);
+int pgm_send_append (pgm_sock_t*const restrict, const void*restrict, const size_t, size_t*restrict);
+int pgm_send_commit (pgm_sock_t*const restrict, size_t*restrict);
+int pgm_send_unreliable (pgm_sock_t*const restrict, const void*restrict, const size_t, size_t*restrict);
 int pgm_sendv (pgm_sock_t*const restrict, const struct pgm_iovec*const restrict, const unsigned, const bool, size_t*restrict);
+int pgm_send_batch (pgm_sock_t*const restrict, const struct pgm_iovec*const restrict, const unsigned, size_t*restrict);
 int pgm_send_skbv (pgm_sock_t*const restrict, struct pgm_sk_buff_t**const restrict, const unsigned, const bool, size_t*restrict);
 int pgm_recvmsg (pgm_sock_t*const restrict, struct pgm_msgv_t*const restrict, const int, size_t*restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
 int pgm_recvmsgv (pgm_sock_t*const restrict, struct pgm_msgv_t*const restrict, const size_t, const int, size_t*restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+int pgm_recvskbv (pgm_sock_t*const restrict, struct pgm_skbv_t*const restrict, const int, size_t*restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+int pgm_recvmsgv_multi (pgm_sock_t*const*const restrict, const size_t, struct pgm_msgv_t*const restrict, pgm_sock_t**const restrict, const size_t, const int, size_t*restrict, size_t*restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
 int pgm_recv (pgm_sock_t*const restrict, void*restrict, const size_t, const int, size_t*const restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
 int pgm_recvfrom (pgm_sock_t*const restrict, void*restrict, const size_t, const int, size_t*restrict, struct pgm_sockaddr_t*restrict, socklen_t*restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+int pgm_recvapdu (pgm_sock_t*const restrict, struct pgm_apdu_t**restrict, const int, size_t*restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+void pgm_apdu_free (struct pgm_apdu_t*);
+bool pgm_recv_async_start (pgm_sock_t*const restrict, const struct pgm_recvasyncinfo_t*const restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+bool pgm_recv_async_stop (pgm_sock_t*const);
+bool pgm_recv_drain_start (pgm_sock_t*const restrict, const unsigned, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+bool pgm_recv_drain_stop (pgm_sock_t*const);
+/* receive state across a process restart, save between reads, restore before pgm_connect() */
+bool pgm_checkpoint_save (pgm_sock_t*const restrict, const char*restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
+bool pgm_checkpoint_restore (pgm_sock_t*const restrict, const char*restrict, pgm_error_t**restrict) PGM_GNUC_WARN_UNUSED_RESULT;
 
 bool pgm_getsockname (pgm_sock_t*const restrict, struct pgm_sockaddr_t*restrict, socklen_t*restrict);
 int pgm_select_info (pgm_sock_t*const restrict, fd_set*const restrict, fd_set*const restrict, int*const restrict);
@@ -201,6 +537,9 @@ int pgm_wsapoll_info (pgm_sock_t*const restrict, WSAPOLLFD*const restrict, ULONG
 #if defined( EPOLLIN ) && defined( EPOLLOUT )
 int pgm_epoll_ctl (pgm_sock_t*const, const int, const int, const int);
 #endif
+#if defined( EVFILT_READ ) && defined( EVFILT_WRITE )
+int pgm_kqueue_ctl (pgm_sock_t*const, const int, const int, const int);
+#endif
 
 static
 const char*
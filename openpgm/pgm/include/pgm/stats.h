@@ -0,0 +1,170 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Shared-memory statistics segment.
+ *
+ * The segment is written by a publisher thread in the hosting process and
+ * may be mapped read-only by any process on the host, readers never touch
+ * the locks of the hosting process.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_STATS_H__
+#define __PGM_STATS_H__
+
+#include <pgm/pgm.h>
+
+PGM_BEGIN_DECLS
+
+#define PGM_STATS_SHM_MAGIC		0x534d4750u	/* "PGMS" */
+#define PGM_STATS_SHM_VERSION		3
+#define PGM_STATS_SHM_INTERVAL		100		/* ms between updates */
+#define PGM_STATS_SHM_MAX_SOCKS		64
+#define PGM_STATS_SHM_MAX_PEERS		1024
+#define PGM_STATS_NAMELEN		44
+
+/* layout:
+ *
+ *	struct pgm_stats_shm_t		header
+ *	struct pgm_stats_name_t		[source_counters + receiver_counters]
+ *	struct pgm_stats_sock_t		[max_socks], stride sock_len
+ *	struct pgm_stats_peer_t		[max_peers], stride peer_len
+ *
+ * all offsets are from the start of the segment.  names are written once
+ * before the magic is set, everything else is only consistent between two
+ * equal even reads of sequence, see pgm_stats_shm_read_begin().
+ */
+
+struct pgm_stats_shm_t {
+	uint32_t		magic;
+	uint32_t		version;
+	uint32_t		pid;
+	uint32_t		source_counters;
+	uint32_t		receiver_counters;
+	uint32_t		max_socks;
+	uint32_t		max_peers;
+	uint32_t		names_offset;
+	uint32_t		socks_offset;
+	uint32_t		sock_len;
+	uint32_t		peers_offset;
+	uint32_t		peer_len;
+
+	volatile uint32_t	sequence;		/* odd while updating */
+	uint32_t		sock_count;
+	uint32_t		peer_count;
+	uint32_t		dropped;		/* sockets and peers exceeding capacity */
+	uint64_t		update_time;		/* μs since the epoch */
+};
+
+struct pgm_stats_name_t {
+	char			name[PGM_STATS_NAMELEN];
+	uint32_t		is_gauge;
+};
+
+struct pgm_stats_sock_t {
+	char			tsi[PGM_TSISTRLEN];
+	uint32_t		is_source;
+	uint32_t		peer_first;		/* index into peers */
+	uint32_t		peer_count;
+	uint64_t		txw_length;
+	uint64_t		txw_max_length;
+	uint64_t		txw_size;
+	uint64_t		mem_used;		/* bytes held by all windows */
+	uint64_t		mem_budget;		/* 0 = unlimited */
+	int32_t			rx_cpu;			/* kernel receive CPU of the first shard, -1 unknown */
+	uint32_t		__padding;
+	uint64_t		stats[];		/* [source_counters] */
+};
+
+struct pgm_stats_peer_t {
+	char			tsi[PGM_TSISTRLEN];
+	uint32_t		sock_index;
+	uint64_t		rxw_length;
+	uint64_t		rxw_max_length;
+	uint64_t		rxw_size;
+	uint64_t		stats[];		/* [receiver_counters] */
+};
+
+bool pgm_stats_shm_init (const char*, pgm_error_t**) PGM_GNUC_WARN_UNUSED_RESULT;
+bool pgm_stats_shm_shutdown (void);
+
+static inline
+const struct pgm_stats_name_t*
+pgm_stats_shm_names (
+	const struct pgm_stats_shm_t*	shm
+	)
+{
+	return (const struct pgm_stats_name_t*)((const char*)shm + shm->names_offset);
+}
+
+static inline
+const struct pgm_stats_sock_t*
+pgm_stats_shm_sock (
+	const struct pgm_stats_shm_t*	shm,
+	const unsigned			index
+	)
+{
+	return (const struct pgm_stats_sock_t*)((const char*)shm + shm->socks_offset + index * shm->sock_len);
+}
+
+static inline
+const struct pgm_stats_peer_t*
+pgm_stats_shm_peer (
+	const struct pgm_stats_shm_t*	shm,
+	const unsigned			index
+	)
+{
+	return (const struct pgm_stats_peer_t*)((const char*)shm + shm->peers_offset + index * shm->peer_len);
+}
+
+/* seqlock read side, copy out what is needed between begin and retry:
+ *
+ *	do {
+ *		seq = pgm_stats_shm_read_begin (shm);
+ *		...
+ *	} while (pgm_stats_shm_read_retry (shm, seq));
+ */
+
+static inline
+uint32_t
+pgm_stats_shm_read_begin (
+	const struct pgm_stats_shm_t*	shm
+	)
+{
+	uint32_t seq;
+	while ((seq = pgm_atomic_read32_acquire (&shm->sequence)) & 1)
+		;
+	return seq;
+}
+
+static inline
+bool
+pgm_stats_shm_read_retry (
+	const struct pgm_stats_shm_t*	shm,
+	const uint32_t			seq
+	)
+{
+	pgm_atomic_fence_acquire ();
+	return pgm_atomic_read32 (&shm->sequence) != seq;
+}
+
+PGM_END_DECLS
+
+#endif /* __PGM_STATS_H__ */
@@ -0,0 +1,268 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * PGM socket driven by a libuv event loop.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#	pragma once
+#endif
+#ifndef __PGM_UV_H__
+#define __PGM_UV_H__
+
+/* header only such that libpgm does not depend on libuv.  POSIX only, the
+ * descriptors are watched with uv_poll_init().
+ */
+
+typedef struct pgm_uv_t pgm_uv_t;
+
+#include <string.h>
+#include <uv.h>
+#include <pgm/pgm.h>
+
+PGM_BEGIN_DECLS
+
+/* messages read per receive call */
+#define PGM_UV_MSGV_LEN		32
+
+/* receive, pending and repair descriptors without PGM_EVENT_SOCK */
+#define PGM_UV_POLL_MAX		3
+
+/* connected socket serviced on a loop.  with PGM_EVENT_SOCK enabled before
+ * pgm_connect() one poll handle covers every descriptor and timer of the
+ * socket.  otherwise each descriptor is polled and a timer handle is armed
+ * only when a receive call reports a pending timer or rate limit.  every
+ * wakeup reads until the socket would block, such that no descriptor is left
+ * ready to wake the loop again for the same event.
+ */
+struct pgm_uv_t {
+	pgm_sock_t*		sock;
+	pgm_recv_callback_t	callback;		/* messages, resets and errors */
+	void*			user_data;
+	uv_poll_t		poll[ PGM_UV_POLL_MAX ];
+	unsigned		poll_len;
+	uv_timer_t		timer;			/* without PGM_EVENT_SOCK */
+	bool			has_timer;
+	unsigned		close_len;		/* handles awaiting close */
+	void		      (*close_cb) (pgm_uv_t*);
+	struct pgm_msgv_t	msgv[ PGM_UV_MSGV_LEN ];
+};
+
+static void _pgm_uv_timer_cb (uv_timer_t*);
+
+/* read until the socket would block, handing every batch, reset and error to
+ * the callback.
+ *
+ * returns FALSE when the socket is closed.
+ */
+
+static inline
+bool
+_pgm_uv_service (
+	pgm_uv_t* const		handle
+	)
+{
+	for (;;) {
+		struct timeval tv;
+		socklen_t optlen = sizeof (tv);
+		size_t bytes_read = 0, len = 0;
+		pgm_error_t* pgm_err = NULL;
+		const int status = pgm_recvmsgv (handle->sock, handle->msgv, PGM_UV_MSGV_LEN, MSG_DONTWAIT, &bytes_read, &pgm_err);
+		switch (status) {
+		case PGM_IO_STATUS_NORMAL:
+			while (bytes_read > 0 && len < PGM_UV_MSGV_LEN) {
+				const struct pgm_msgv_t* msgv = &handle->msgv[ len++ ];
+				for (unsigned j = 0; j < msgv->msgv_len; j++)
+					bytes_read -= MIN(bytes_read, msgv->msgv_skb[ j ]->len);
+			}
+			handle->callback (handle->sock, handle->msgv, len, status, handle->user_data);
+			break;
+
+/* the event socket carries its own timer */
+		case PGM_IO_STATUS_TIMER_PENDING:
+		case PGM_IO_STATUS_RATE_LIMITED:
+			if (handle->has_timer &&
+			    pgm_getsockopt (handle->sock, IPPROTO_PGM,
+					    PGM_IO_STATUS_TIMER_PENDING == status ? PGM_TIME_REMAIN : PGM_RATE_REMAIN,
+					    &tv, &optlen))
+			{
+				uv_timer_start (&handle->timer, _pgm_uv_timer_cb,
+						(uint64_t)tv.tv_sec * 1000 + (uint64_t)(tv.tv_usec + 999) / 1000, 0);
+			}
+			return TRUE;
+
+		case PGM_IO_STATUS_WOULD_BLOCK:
+			if (handle->has_timer)
+				uv_timer_stop (&handle->timer);
+			return TRUE;
+
+		case PGM_IO_STATUS_ERROR:
+			pgm_error_free (pgm_err);
+/* fall through */
+		default:
+			handle->callback (handle->sock, NULL, 0, status, handle->user_data);
+			if (PGM_IO_STATUS_EOF == status)
+				return FALSE;
+			break;
+		}
+	}
+}
+
+static inline
+void
+_pgm_uv_quiesce (
+	pgm_uv_t* const		handle
+	)
+{
+	for (unsigned i = 0; i < handle->poll_len; i++)
+		uv_poll_stop (&handle->poll[ i ]);
+	if (handle->has_timer)
+		uv_timer_stop (&handle->timer);
+}
+
+static
+void
+_pgm_uv_poll_cb (
+	uv_poll_t*		poll,
+	int			status,
+	int			events
+	)
+{
+	pgm_uv_t* handle = (pgm_uv_t*)poll->data;
+	(void)status;
+	(void)events;
+	if (!_pgm_uv_service (handle))
+		_pgm_uv_quiesce (handle);
+}
+
+static
+void
+_pgm_uv_timer_cb (
+	uv_timer_t*		timer
+	)
+{
+	pgm_uv_t* handle = (pgm_uv_t*)timer->data;
+	if (!_pgm_uv_service (handle))
+		_pgm_uv_quiesce (handle);
+}
+
+static
+void
+_pgm_uv_close_cb (
+	uv_handle_t*		uv_handle
+	)
+{
+	pgm_uv_t* handle = (pgm_uv_t*)uv_handle->data;
+	if (0 == --handle->close_len && NULL != handle->close_cb)
+		handle->close_cb (handle);
+}
+
+/* watch a connected socket on loop, calling callback on the loop thread.
+ * messages passed to the callback are valid until it returns.
+ *
+ * returns 0 on success, returns a libuv error code on failure.
+ */
+
+static inline
+int
+pgm_uv_start (
+	uv_loop_t*	    const restrict loop,
+	pgm_uv_t*	    const restrict handle,
+	pgm_sock_t*	    const restrict sock,
+	pgm_recv_callback_t		   callback,
+	void*				   user_data
+	)
+{
+	int fds[ PGM_UV_POLL_MAX ];
+	unsigned fds_len = 0;
+	socklen_t optlen = sizeof (int);
+	int rc;
+
+	memset (handle, 0, sizeof (pgm_uv_t));
+	handle->sock	  = sock;
+	handle->callback  = callback;
+	handle->user_data = user_data;
+
+	if (pgm_getsockopt (sock, IPPROTO_PGM, PGM_EVENT_SOCK, &fds[ 0 ], &optlen)) {
+		fds_len = 1;
+	} else {
+		static const int optnames[ PGM_UV_POLL_MAX ] = { PGM_RECV_SOCK, PGM_PENDING_SOCK, PGM_REPAIR_SOCK };
+		for (unsigned i = 0; i < PGM_UV_POLL_MAX; i++) {
+			optlen = sizeof (int);
+			if (pgm_getsockopt (sock, IPPROTO_PGM, optnames[ i ], &fds[ fds_len ], &optlen) &&
+			    -1 != fds[ fds_len ])
+				fds_len++;
+		}
+		if (0 == fds_len)
+			return UV_EINVAL;
+		if (0 != (rc = uv_timer_init (loop, &handle->timer)))
+			return rc;
+		handle->timer.data = handle;
+		handle->has_timer = TRUE;
+	}
+
+	for (unsigned i = 0; i < fds_len; i++) {
+		uv_poll_t* poll = &handle->poll[ handle->poll_len ];
+		if (0 != (rc = uv_poll_init (loop, poll, fds[ i ])))
+			goto err_close;
+		poll->data = handle;
+		handle->poll_len++;
+		if (0 != (rc = uv_poll_start (poll, UV_READABLE, _pgm_uv_poll_cb)))
+			goto err_close;
+	}
+
+/* service whatever arrived before registration */
+	if (!_pgm_uv_service (handle))
+		_pgm_uv_quiesce (handle);
+	return 0;
+
+err_close:
+	handle->close_cb = NULL;
+	for (unsigned i = 0; i < handle->poll_len; i++) {
+		handle->close_len++;
+		uv_close ((uv_handle_t*)&handle->poll[ i ], _pgm_uv_close_cb);
+	}
+	if (handle->has_timer) {
+		handle->close_len++;
+		uv_close ((uv_handle_t*)&handle->timer, _pgm_uv_close_cb);
+	}
+	return rc;
+}
+
+/* stop watching the socket, close_cb is called once the loop has released
+ * every handle, after which the socket may be closed and handle freed.
+ */
+
+static inline
+void
+pgm_uv_stop (
+	pgm_uv_t* const		handle,
+	void		      (*close_cb) (pgm_uv_t*)
+	)
+{
+	handle->close_cb = close_cb;
+	handle->close_len = handle->poll_len + (handle->has_timer ? 1 : 0);
+	for (unsigned i = 0; i < handle->poll_len; i++)
+		uv_close ((uv_handle_t*)&handle->poll[ i ], _pgm_uv_close_cb);
+	if (handle->has_timer)
+		uv_close ((uv_handle_t*)&handle->timer, _pgm_uv_close_cb);
+}
+
+PGM_END_DECLS
+
+#endif /* __PGM_UV_H__ */
@@ -2,7 +2,7 @@
  *
  * Interface index to interface name function.  Defined as part of RFC2553
  * for IPv6 basic socket extensions, but also available for IPv4 addresses
- * on many platforms.
+ * on many platforms.  Also the link MTU of an interface index.
  *
  * Copyright (c) 2006-2011 Miru Limited.
  *
@@ -24,6 +24,14 @@
 #ifdef HAVE_CONFIG_H
 #	include <config.h>
 #endif
+#ifndef _WIN32
+#	include <string.h>
+#	include <sys/ioctl.h>
+#	include <net/if.h>
+#endif
+#if defined( __sun )
+#	include <sys/sockio.h>
+#endif
 #ifdef _WIN32
 #	include <ws2tcpip.h>
 #	include <iphlpapi.h>
@@ -59,4 +67,44 @@ pgm_if_indextoname (
 #endif /* _WIN32 */
 }
 
+/* MTU of the link behind the interface index, i.e. the largest IP datagram
+ * sent without fragmentation.
+ *
+ * returns MTU in bytes, or 0 if unknown or ifindex is 0 for any interface.
+ */
+
+PGM_GNUC_INTERNAL
+unsigned
+pgm_if_indextomtu (
+	unsigned int		ifindex
+	)
+{
+	if (0 == ifindex)
+		return 0;
+#if !defined( _WIN32 )
+#	ifdef SIOCGIFMTU
+	struct ifreq ifr;
+	unsigned mtu = 0;
+
+	memset (&ifr, 0, sizeof(ifr));
+	if (NULL == pgm_if_indextoname (ifindex, ifr.ifr_name))
+		return 0;
+	const SOCKET s = socket (AF_INET, SOCK_DGRAM, 0);
+	if (INVALID_SOCKET == s)
+		return 0;
+	if (SOCKET_ERROR != ioctlsocket (s, SIOCGIFMTU, &ifr) && ifr.ifr_mtu > 0)
+		mtu = (unsigned)ifr.ifr_mtu;
+	closesocket (s);
+	return mtu;
+#	else
+	return 0;
+#	endif
+#else
+	MIB_IFROW ifRow = { .dwIndex = ifindex };
+	if (NO_ERROR != GetIfEntry (&ifRow))
+		return 0;
+	return (unsigned)ifRow.dwMtu;
+#endif /* _WIN32 */
+}
+
 /* eof */
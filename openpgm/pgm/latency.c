@@ -0,0 +1,258 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * Per-thread latency histograms of internal processing stages.  Each thread
+ * records into its own block of counters without locking or shared cache
+ * lines, blocks are only merged when read.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+#include <impl/framework.h>
+
+
+//#define LATENCY_DEBUG
+
+
+/* globals */
+
+/* zero when not initialized, otherwise changes with every initialization
+ * such that blocks of a prior initialization are detached.
+ */
+uint32_t				pgm_latency_generation = 0;
+PGM_THREAD_LOCAL pgm_latency_t*		pgm_latency_local = NULL;
+PGM_THREAD_LOCAL uint32_t		pgm_latency_local_generation = 0;
+
+/* locals */
+
+static const char* const latency_stage_names[ PGM_LATENCY_STAGE_MAX ] = {
+	"Receive to window insert",
+	"Window insert to delivery",
+	"NAK to RDATA",
+	"Send call to wire"
+};
+
+static volatile uint32_t	latency_ref_count = 0;
+static uint32_t			latency_epoch = 0;
+static pgm_mutex_t		latency_mutex;
+static pgm_slist_t*		latency_list = NULL;		/* of pgm_latency_t */
+
+static void latency_merge (const unsigned, pgm_latency_stage_t*);
+static uint64_t latency_bucket_upper (const unsigned) PGM_GNUC_CONST;
+
+
+PGM_GNUC_INTERNAL
+void
+pgm_latency_init (void)
+{
+	if (pgm_atomic_exchange_and_add32 (&latency_ref_count, 1) > 0)
+		return;
+
+	pgm_mutex_init (&latency_mutex);
+	if (0 == ++latency_epoch)
+		++latency_epoch;
+	pgm_latency_generation = latency_epoch;
+}
+
+/* release the blocks of every thread, no thread may be recording.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_latency_shutdown (void)
+{
+	pgm_return_if_fail (pgm_atomic_read32 (&latency_ref_count) > 0);
+
+	if (pgm_atomic_exchange_and_add32 (&latency_ref_count, (uint32_t)-1) != 1)
+		return;
+
+	pgm_latency_generation = 0;
+	while (latency_list) {
+		pgm_latency_t* latency = latency_list->data;
+		latency_list = pgm_slist_remove_first (latency_list);
+		pgm_free (latency);
+	}
+	pgm_mutex_free (&latency_mutex);
+}
+
+/* allocate and register a block for the calling thread.
+ *
+ * returns the block, or NULL if not initialized.
+ */
+
+PGM_GNUC_INTERNAL
+pgm_latency_t*
+pgm_latency_attach (void)
+{
+	pgm_latency_t* latency = NULL;
+
+	if (0 == pgm_atomic_read32 (&latency_ref_count))
+		goto detach;
+
+	pgm_mutex_lock (&latency_mutex);
+	if (0 != pgm_latency_generation) {
+		latency = pgm_new0 (pgm_latency_t, 1);
+		latency->link.data = latency;
+		latency_list = pgm_slist_prepend_link (latency_list, &latency->link);
+	}
+	pgm_mutex_unlock (&latency_mutex);
+
+detach:
+	pgm_latency_local = latency;
+	pgm_latency_local_generation = pgm_latency_generation;
+	return latency;
+}
+
+/* sum the blocks of all threads for one stage, values are read without
+ * locking the writers and hence approximate for active threads.
+ */
+
+static
+void
+latency_merge (
+	const unsigned			stage,
+	pgm_latency_stage_t* restrict	merged
+	)
+{
+	memset (merged, 0, sizeof(pgm_latency_stage_t));
+	for (pgm_slist_t* list = latency_list; list; list = list->next)
+	{
+		const pgm_latency_stage_t* s = &((const pgm_latency_t*)list->data)->stages[ stage ];
+		merged->count += s->count;
+		merged->sum   += s->sum;
+		if (s->max > merged->max)
+			merged->max = s->max;
+		for (unsigned i = 0; i < PGM_LATENCY_BUCKETS; i++)
+			merged->buckets[ i ] += s->buckets[ i ];
+	}
+}
+
+/* highest value counted by a bucket.
+ */
+
+static
+uint64_t
+latency_bucket_upper (
+	const unsigned		bucket
+	)
+{
+	if (bucket < PGM_LATENCY_SUB_BUCKETS)
+		return bucket;
+	const unsigned magnitude = (bucket >> PGM_LATENCY_SUB_BITS) - 1;
+	const uint64_t lower = (uint64_t)(PGM_LATENCY_SUB_BUCKETS + (bucket & (PGM_LATENCY_SUB_BUCKETS - 1))) << magnitude;
+	return lower + ((uint64_t)1 << magnitude) - 1;
+}
+
+/* merge the blocks of all threads for one stage.
+ *
+ * returns TRUE on success, returns FALSE if not initialized.
+ */
+
+bool
+pgm_latency_snapshot (
+	const unsigned			stage,
+	pgm_latency_stage_t* restrict	merged
+	)
+{
+	pgm_assert (stage < PGM_LATENCY_STAGE_MAX);
+	pgm_assert (NULL != merged);
+
+	if (0 == pgm_atomic_read32 (&latency_ref_count))
+		return FALSE;
+
+	pgm_mutex_lock (&latency_mutex);
+	latency_merge (stage, merged);
+	pgm_mutex_unlock (&latency_mutex);
+	return TRUE;
+}
+
+/* returns value at or below which fraction of samples lie, no more than the
+ * recorded maximum.
+ */
+
+uint64_t
+pgm_latency_percentile (
+	const pgm_latency_stage_t*	s,
+	const double			fraction
+	)
+{
+	uint64_t rank = (uint64_t)(fraction * s->count + 0.5);
+	uint64_t seen = 0;
+
+	if (0 == rank)
+		rank = 1;
+	for (unsigned i = 0; i < PGM_LATENCY_BUCKETS; i++) {
+		seen += s->buckets[ i ];
+		if (seen >= rank)
+			return MIN(latency_bucket_upper (i), s->max);
+	}
+	return s->max;
+}
+
+void
+pgm_latency_write_html_all (
+	pgm_string_t*		string
+	)
+{
+	pgm_latency_stage_t* merged;
+
+	if (0 == pgm_atomic_read32 (&latency_ref_count))
+		return;
+
+	merged = pgm_new (pgm_latency_stage_t, 1);
+	pgm_string_append (string,	"\n<h2>Stage latency</h2>"
+					"\n<table>"
+					"<tr>"
+						"<th>Stage</th>"
+						"<th>Samples</th>"
+						"<th>Mean</th>"
+						"<th>50%</th>"
+						"<th>90%</th>"
+						"<th>99%</th>"
+						"<th>99.9%</th>"
+						"<th>Max</th>"
+					"</tr>");
+	for (unsigned stage = 0; stage < PGM_LATENCY_STAGE_MAX; stage++)
+	{
+		if (!pgm_latency_snapshot (stage, merged) || 0 == merged->count)
+			continue;
+		pgm_string_append_printf (string,	"<tr>"
+								"<th>%s</th>"
+								"<td>%" PRIu64 "</td>"
+								"<td>%" PRIu64 " μs</td>"
+								"<td>%" PRIu64 " μs</td>"
+								"<td>%" PRIu64 " μs</td>"
+								"<td>%" PRIu64 " μs</td>"
+								"<td>%" PRIu64 " μs</td>"
+								"<td>%" PRIu64 " μs</td>"
+							"</tr>",
+					  latency_stage_names[ stage ],
+					  merged->count,
+					  merged->sum / merged->count,
+					  pgm_latency_percentile (merged, 0.5),
+					  pgm_latency_percentile (merged, 0.9),
+					  pgm_latency_percentile (merged, 0.99),
+					  pgm_latency_percentile (merged, 0.999),
+					  merged->max);
+	}
+	pgm_string_append (string,	"</table>\n");
+	pgm_free (merged);
+}
+
+/* eof */
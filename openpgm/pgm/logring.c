@@ -0,0 +1,626 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * Asynchronous logging.  The calling thread records the format reference and
+ * raw arguments of a log message into its own ring without locking or
+ * formatting, a background thread drains every ring, formats and writes the
+ * messages through the usual log handler.  Messages are ordered per thread
+ * only.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+#include <errno.h>
+#include <stdio.h>
+#ifndef _WIN32
+#	include <poll.h>
+#	include <pthread.h>
+#	include <sys/types.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+
+
+//#define LOGRING_DEBUG
+
+
+/* globals */
+
+bool pgm_log_async PGM_GNUC_READ_MOSTLY = FALSE;
+
+#ifndef _WIN32
+
+/* locals */
+
+/* length modifiers */
+enum {
+	LOGRING_LENGTH_NONE = 0,
+	LOGRING_LENGTH_HH,
+	LOGRING_LENGTH_H,
+	LOGRING_LENGTH_L,
+	LOGRING_LENGTH_LL,
+	LOGRING_LENGTH_J,
+	LOGRING_LENGTH_Z,
+	LOGRING_LENGTH_T,
+	LOGRING_LENGTH_BIG_L
+};
+
+struct logring_spec_t {
+	const char*	start;			/* at '%' */
+	const char*	end;			/* after conversion */
+	unsigned	stars;			/* '*' width or precision arguments */
+	int		precision;		/* -1 none, -2 from argument */
+	int		length;
+	char		conversion;
+};
+
+static volatile uint32_t		logring_ref_count = 0;
+static uint32_t				logring_epoch = 0;
+static uint32_t				logring_generation = 0;
+static PGM_THREAD_LOCAL pgm_logring_t*	logring_local = NULL;
+static PGM_THREAD_LOCAL uint32_t	logring_local_generation = 0;
+static pgm_mutex_t			logring_mutex;
+static pgm_slist_t*			logring_list = NULL;	/* of pgm_logring_t */
+static pgm_notify_t			logring_notify = PGM_NOTIFY_INIT;
+static pthread_t			logring_thread;
+
+static void* logring_routine (void*);
+static pgm_logring_t* logring_attach (void);
+static const char* logring_parse (const char*, struct logring_spec_t*);
+static bool logring_capture (pgm_logring_record_t*, const char*, va_list);
+static void logring_format (const pgm_logring_record_t*, char*, size_t);
+static void logring_drain (void);
+
+
+/* start the logging thread, messages are recorded asynchronously until
+ * shutdown.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_logring_init (
+	pgm_error_t**		error
+	)
+{
+	if (pgm_atomic_exchange_and_add32 (&logring_ref_count, 1) > 0)
+		return TRUE;
+
+	pgm_mutex_init (&logring_mutex);
+	if (0 == ++logring_epoch)
+		++logring_epoch;
+	logring_generation = logring_epoch;
+
+	if (0 != pgm_notify_init (&logring_notify)) {
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			     PGM_ERROR_DOMAIN_ENGINE,
+			     pgm_error_from_errno (save_errno),
+			     _("Creating logging notification channel: %s"),
+			     pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		goto err_cleanup;
+	}
+
+	const int status = pthread_create (&logring_thread, NULL, &logring_routine, NULL);
+	if (0 != status) {
+		char errbuf[1024];
+		pgm_set_error (error,
+			     PGM_ERROR_DOMAIN_ENGINE,
+			     pgm_error_from_errno (status),
+			     _("Creating logging thread: %s"),
+			     pgm_strerror_s (errbuf, sizeof (errbuf), status));
+		goto err_cleanup;
+	}
+	pgm_log_async = TRUE;
+	return TRUE;
+
+err_cleanup:
+	if (pgm_notify_is_valid (&logring_notify))
+		pgm_notify_destroy (&logring_notify);
+	logring_generation = 0;
+	pgm_mutex_free (&logring_mutex);
+	pgm_atomic_dec32 (&logring_ref_count);
+	return FALSE;
+}
+
+/* write out pending messages and stop the logging thread, no other thread
+ * may be logging.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_logring_shutdown (void)
+{
+	pgm_return_val_if_fail (pgm_atomic_read32 (&logring_ref_count) > 0, FALSE);
+
+	if (pgm_atomic_exchange_and_add32 (&logring_ref_count, (uint32_t)-1) != 1)
+		return TRUE;
+
+	pgm_log_async = FALSE;
+	pgm_notify_send (&logring_notify);
+	pthread_join (logring_thread, NULL);
+	pgm_notify_destroy (&logring_notify);
+
+	logring_generation = 0;
+	while (logring_list) {
+		pgm_logring_t* ring = logring_list->data;
+		logring_list = pgm_slist_remove_first (logring_list);
+		pgm_free (ring);
+	}
+	pgm_mutex_free (&logring_mutex);
+	return TRUE;
+}
+
+/* write out pending messages from the calling thread, e.g. before a fatal
+ * message written synchronously.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_logring_flush (void)
+{
+	if (0 == pgm_atomic_read32 (&logring_ref_count))
+		return;
+	logring_drain ();
+}
+
+/* record a log message into the ring of the calling thread.  a full ring
+ * drops the message.
+ *
+ * returns TRUE if the message is recorded or dropped, returns FALSE if the
+ * message must be written synchronously.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_logring_push (
+	const int		log_level,
+	const char*		format,
+	va_list			args
+	)
+{
+	pgm_logring_t* ring = logring_local;
+	va_list copy;
+	bool is_captured;
+
+	if (PGM_UNLIKELY(NULL == ring || logring_local_generation != logring_generation) &&
+	    NULL == (ring = logring_attach()))
+		return FALSE;
+
+	const uint32_t head = ring->head;
+	if (PGM_UNLIKELY(head - __atomic_load_n (&ring->tail, __ATOMIC_ACQUIRE) == PGM_LOGRING_LEN)) {
+		pgm_atomic_inc32 (&ring->dropped);
+		return TRUE;
+	}
+
+	pgm_logring_record_t* record = &ring->records[ head & (PGM_LOGRING_LEN - 1) ];
+	record->log_level = log_level;
+	va_copy (copy, args);
+	is_captured = logring_capture (record, format, copy);
+	va_end (copy);
+	if (PGM_UNLIKELY(!is_captured))
+		return FALSE;
+	__atomic_store_n (&ring->head, head + 1, __ATOMIC_RELEASE);
+	return TRUE;
+}
+
+/* allocate and register a ring for the calling thread.
+ *
+ * returns the ring, or NULL if not running.
+ */
+
+static
+pgm_logring_t*
+logring_attach (void)
+{
+	pgm_logring_t* ring = NULL;
+
+	if (0 == pgm_atomic_read32 (&logring_ref_count))
+		goto detach;
+
+	pgm_mutex_lock (&logring_mutex);
+	if (0 != logring_generation) {
+		ring = pgm_new0 (pgm_logring_t, 1);
+		ring->link.data = ring;
+		logring_list = pgm_slist_prepend_link (logring_list, &ring->link);
+	}
+	pgm_mutex_unlock (&logring_mutex);
+
+detach:
+	logring_local = ring;
+	logring_local_generation = logring_generation;
+	return ring;
+}
+
+static
+void*
+logring_routine (
+	PGM_GNUC_UNUSED void*	arg
+	)
+{
+	struct pollfd fds = {
+		.fd	= pgm_notify_get_socket (&logring_notify),
+		.events	= POLLIN
+	};
+
+	pgm_thread_setup ("logring");
+	for (;;) {
+		const int ready = poll (&fds, 1, PGM_LOGRING_INTERVAL);
+		logring_drain ();
+		if (ready > 0 || (-1 == ready && EINTR != errno))
+			break;
+	}
+	return NULL;
+}
+
+/* format and write out every recorded message, the logging mutex serialises
+ * consumers of each ring.
+ */
+
+static
+void
+logring_drain (void)
+{
+	char buf[1024];
+
+	pgm_mutex_lock (&logring_mutex);
+	for (pgm_slist_t* list = logring_list; list; list = list->next)
+	{
+		pgm_logring_t* ring = list->data;
+		uint32_t tail = ring->tail;
+		const uint32_t head = __atomic_load_n (&ring->head, __ATOMIC_ACQUIRE);
+
+		while (tail != head) {
+			const pgm_logring_record_t* record = &ring->records[ tail & (PGM_LOGRING_LEN - 1) ];
+			logring_format (record, buf, sizeof (buf));
+			pgm__log_text (record->log_level, buf);
+			__atomic_store_n (&ring->tail, ++tail, __ATOMIC_RELEASE);
+		}
+
+		const uint32_t dropped = pgm_atomic_read32 (&ring->dropped);
+		if (PGM_UNLIKELY(dropped != ring->reported)) {
+			pgm_snprintf_s (buf, sizeof (buf), _TRUNCATE, _("%" PRIu32 " log messages dropped on a full ring."), dropped - ring->reported);
+			pgm__log_text (PGM_LOG_LEVEL_WARNING, buf);
+			ring->reported = dropped;
+		}
+	}
+	pgm_mutex_unlock (&logring_mutex);
+}
+
+/* parse one conversion specification starting at '%'.
+ *
+ * returns the character following the specification.
+ */
+
+static
+const char*
+logring_parse (
+	const char*			p,
+	struct logring_spec_t* restrict	spec
+	)
+{
+	spec->start	= p++;
+	spec->stars	= 0;
+	spec->precision	= -1;
+	spec->length	= LOGRING_LENGTH_NONE;
+
+/* flags, including the thousands grouping extension */
+	while ('\0' != *p && NULL != strchr ("-+ #0'", *p))
+		p++;
+/* width */
+	if ('*' == *p) {
+		spec->stars++;
+		p++;
+	} else {
+		while (*p >= '0' && *p <= '9')
+			p++;
+	}
+/* precision */
+	if ('.' == *p) {
+		p++;
+		if ('*' == *p) {
+			spec->stars++;
+			spec->precision = -2;
+			p++;
+		} else {
+			spec->precision = 0;
+			while (*p >= '0' && *p <= '9')
+				spec->precision = spec->precision * 10 + (*p++ - '0');
+		}
+	}
+/* length modifier */
+	switch (*p) {
+	case 'h':
+		if ('h' == *++p) { spec->length = LOGRING_LENGTH_HH; p++; }
+		else spec->length = LOGRING_LENGTH_H;
+		break;
+	case 'l':
+		if ('l' == *++p) { spec->length = LOGRING_LENGTH_LL; p++; }
+		else spec->length = LOGRING_LENGTH_L;
+		break;
+	case 'j':	spec->length = LOGRING_LENGTH_J; p++; break;
+	case 'z':	spec->length = LOGRING_LENGTH_Z; p++; break;
+	case 't':	spec->length = LOGRING_LENGTH_T; p++; break;
+	case 'L':	spec->length = LOGRING_LENGTH_BIG_L; p++; break;
+	default: break;
+	}
+	spec->conversion = *p;
+	if ('\0' != *p)
+		p++;
+	spec->end = p;
+	return p;
+}
+
+/* read the arguments of format into record.
+ *
+ * returns FALSE if the arguments do not fit or a conversion is not supported.
+ */
+
+static
+bool
+logring_capture (
+	pgm_logring_record_t* restrict	record,
+	const char*			format,
+	va_list				args
+	)
+{
+	struct logring_spec_t spec;
+	unsigned count = 0;
+	size_t data_len = 0;
+
+	for (const char* p = format; '\0' != *p; )
+	{
+		if ('%' != *p) {
+			p++;
+			continue;
+		}
+		if ('%' == p[1]) {
+			p += 2;
+			continue;
+		}
+		p = logring_parse (p, &spec);
+		if (count + spec.stars + 1 > PGM_LOGRING_ARGS)
+			return FALSE;
+
+		int precision = spec.precision;
+		for (unsigned i = 0; i < spec.stars; i++) {
+			const int value = va_arg (args, int);
+			record->args[ count++ ].i = value;
+			if (-2 == precision && i == spec.stars - 1)
+				precision = value;
+		}
+
+		union pgm_logring_arg_t* arg = &record->args[ count++ ];
+		switch (spec.conversion) {
+		case 'd':
+		case 'i':
+			switch (spec.length) {
+			case LOGRING_LENGTH_NONE:
+			case LOGRING_LENGTH_HH:
+			case LOGRING_LENGTH_H:	arg->i = va_arg (args, int); break;
+			case LOGRING_LENGTH_L:	arg->i = va_arg (args, long); break;
+			case LOGRING_LENGTH_LL:	arg->i = va_arg (args, long long); break;
+			case LOGRING_LENGTH_J:	arg->i = va_arg (args, intmax_t); break;
+			case LOGRING_LENGTH_Z:	arg->i = va_arg (args, ssize_t); break;
+			case LOGRING_LENGTH_T:	arg->i = va_arg (args, ptrdiff_t); break;
+			default:		return FALSE;
+			}
+			break;
+
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+			switch (spec.length) {
+			case LOGRING_LENGTH_NONE:
+			case LOGRING_LENGTH_HH:
+			case LOGRING_LENGTH_H:	arg->u = va_arg (args, unsigned); break;
+			case LOGRING_LENGTH_L:	arg->u = va_arg (args, unsigned long); break;
+			case LOGRING_LENGTH_LL:	arg->u = va_arg (args, unsigned long long); break;
+			case LOGRING_LENGTH_J:	arg->u = va_arg (args, uintmax_t); break;
+			case LOGRING_LENGTH_Z:	arg->u = va_arg (args, size_t); break;
+			case LOGRING_LENGTH_T:	arg->u = (uintmax_t)va_arg (args, ptrdiff_t); break;
+			default:		return FALSE;
+			}
+			break;
+
+		case 'c':
+			if (LOGRING_LENGTH_NONE != spec.length)
+				return FALSE;
+			arg->i = va_arg (args, int);
+			break;
+
+		case 'e': case 'E':
+		case 'f': case 'F':
+		case 'g': case 'G':
+		case 'a': case 'A':
+			if (LOGRING_LENGTH_BIG_L == spec.length)
+				arg->ld = va_arg (args, long double);
+			else
+				arg->d = va_arg (args, double);
+			break;
+
+		case 'p':
+			if (LOGRING_LENGTH_NONE != spec.length)
+				return FALSE;
+			arg->p = va_arg (args, const void*);
+			break;
+
+		case 's': {
+			if (LOGRING_LENGTH_NONE != spec.length)
+				return FALSE;
+			const char* s = va_arg (args, const char*);
+			if (NULL == s)
+				s = "(null)";
+			const size_t len = precision >= 0 ? strnlen (s, precision) : strlen (s);
+			if (data_len + len + 1 > sizeof (record->data))
+				return FALSE;
+			memcpy (record->data + data_len, s, len);
+			record->data[ data_len + len ] = '\0';
+			arg->offset = data_len;
+			data_len += len + 1;
+			break;
+		}
+
+/* %n and unknown conversions */
+		default:
+			return FALSE;
+		}
+	}
+	record->format = format;
+	record->count = count;
+	return TRUE;
+}
+
+/* format a captured message into buf, the format is parsed exactly as when
+ * captured and each conversion is formatted on its own.
+ */
+
+static
+void
+logring_format (
+	const pgm_logring_record_t* restrict	record,
+	char*			    restrict	buf,
+	const size_t				bufsize
+	)
+{
+	struct logring_spec_t spec;
+	char conversion[64];
+	size_t len = 0;
+	unsigned count = 0;
+
+	for (const char* p = record->format; '\0' != *p && len < bufsize - 1; )
+	{
+		if ('%' != *p || '%' == p[1]) {
+			buf[ len++ ] = *p;
+			p += ('%' == *p) ? 2 : 1;
+			continue;
+		}
+		p = logring_parse (p, &spec);
+
+/* substitute star arguments into the specification */
+		size_t clen = 0;
+		for (const char* q = spec.start; q < spec.end && clen < sizeof (conversion) - 12; q++) {
+			if ('*' == *q)
+				clen += sprintf (conversion + clen, "%d", (int)record->args[ count++ ].i);
+			else
+				conversion[ clen++ ] = *q;
+		}
+		conversion[ clen ] = '\0';
+
+		const union pgm_logring_arg_t* arg = &record->args[ count++ ];
+		char* out = buf + len;
+		const size_t remaining = bufsize - len;
+		int n;
+		switch (spec.conversion) {
+		case 'd':
+		case 'i':
+			switch (spec.length) {
+			case LOGRING_LENGTH_L:	n = snprintf (out, remaining, conversion, (long)arg->i); break;
+			case LOGRING_LENGTH_LL:	n = snprintf (out, remaining, conversion, (long long)arg->i); break;
+			case LOGRING_LENGTH_J:	n = snprintf (out, remaining, conversion, arg->i); break;
+			case LOGRING_LENGTH_Z:	n = snprintf (out, remaining, conversion, (ssize_t)arg->i); break;
+			case LOGRING_LENGTH_T:	n = snprintf (out, remaining, conversion, (ptrdiff_t)arg->i); break;
+			default:		n = snprintf (out, remaining, conversion, (int)arg->i); break;
+			}
+			break;
+
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+			switch (spec.length) {
+			case LOGRING_LENGTH_L:	n = snprintf (out, remaining, conversion, (unsigned long)arg->u); break;
+			case LOGRING_LENGTH_LL:	n = snprintf (out, remaining, conversion, (unsigned long long)arg->u); break;
+			case LOGRING_LENGTH_J:	n = snprintf (out, remaining, conversion, arg->u); break;
+			case LOGRING_LENGTH_Z:	n = snprintf (out, remaining, conversion, (size_t)arg->u); break;
+			case LOGRING_LENGTH_T:	n = snprintf (out, remaining, conversion, (ptrdiff_t)arg->u); break;
+			default:		n = snprintf (out, remaining, conversion, (unsigned)arg->u); break;
+			}
+			break;
+
+		case 'c':
+			n = snprintf (out, remaining, conversion, (int)arg->i);
+			break;
+
+		case 'p':
+			n = snprintf (out, remaining, conversion, arg->p);
+			break;
+
+		case 's':
+			n = snprintf (out, remaining, conversion, record->data + arg->offset);
+			break;
+
+		default:
+			if (LOGRING_LENGTH_BIG_L == spec.length)
+				n = snprintf (out, remaining, conversion, arg->ld);
+			else
+				n = snprintf (out, remaining, conversion, arg->d);
+			break;
+		}
+		if (n > 0)
+			len += ((size_t)n < remaining) ? (size_t)n : remaining - 1;
+	}
+	buf[ len ] = '\0';
+}
+
+#else /* _WIN32 */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_logring_init (
+	pgm_error_t**		error
+	)
+{
+	pgm_set_error (error,
+		     PGM_ERROR_DOMAIN_ENGINE,
+		     PGM_ERROR_NOSYS,
+		     _("Asynchronous logging is not supported on this platform."));
+	return FALSE;
+}
+
+PGM_GNUC_INTERNAL
+bool
+pgm_logring_shutdown (void)
+{
+	return FALSE;
+}
+
+PGM_GNUC_INTERNAL
+void
+pgm_logring_flush (void)
+{
+}
+
+PGM_GNUC_INTERNAL
+bool
+pgm_logring_push (
+	PGM_GNUC_UNUSED const int	log_level,
+	PGM_GNUC_UNUSED const char*	format,
+	PGM_GNUC_UNUSED va_list		args
+	)
+{
+	return FALSE;
+}
+
+#endif /* _WIN32 */
+
+/* eof */
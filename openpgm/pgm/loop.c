@@ -0,0 +1,365 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * in-process packet bus in place of the network.
+ *
+ * Sockets naming the same bus with PGM_LOOPBACK exchange packets through
+ * in-memory queues, sources and receivers in one process run the full
+ * protocol without the kernel or a network such that the CPU cost of PGM
+ * itself can be measured.  A sending socket copies each packet onto the queue
+ * of every other member and raises its pending notification, the receiving
+ * socket reads the queue through the regular receive path.  The channel of
+ * each sending socket may drop or reorder packets at configured rates from a
+ * seeded generator, for repeatable loss and repair runs.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <string.h>
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/loop.h>
+
+
+//#define LOOP_DEBUG
+
+#ifndef LOOP_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+/* packet waiting for a member, or held back by the channel model */
+struct pgm_loop_packet_t {
+	pgm_list_t			link_;
+	struct sockaddr_storage		src;
+	struct sockaddr_storage		dst;
+	uint16_t			len;
+	char				data[];		/* PGM header onward */
+};
+
+/* buses of the process, under pgm_sock_list_lock */
+static pgm_slist_t*	loop_list = NULL;
+
+
+static
+struct pgm_loop_packet_t*
+loop_packet_new (
+	const struct sockaddr* const restrict src,
+	const struct sockaddr* const restrict dst,
+	const void*		     restrict buf,
+	const size_t			      len
+	)
+{
+	struct pgm_loop_packet_t* packet = pgm_malloc (sizeof (struct pgm_loop_packet_t) + len);
+	memcpy (&packet->src, src, pgm_sockaddr_len (src));
+	memcpy (&packet->dst, dst, pgm_sockaddr_len (dst));
+	packet->len = (uint16_t)len;
+	memcpy (packet->data, buf, len);
+	return packet;
+}
+
+/* returns TRUE for an event of rate parts per million.
+ */
+
+static inline
+bool
+loop_chance (
+	struct pgm_loop_member_t* const	member,
+	const uint32_t			rate
+	)
+{
+	if (PGM_LIKELY(0 == rate))
+		return FALSE;
+	return (uint32_t)pgm_rand_int_range (&member->rand_, 0, 1000000) < rate;
+}
+
+/* copy a packet onto the queue of every member other than the sender, and of
+ * the sender itself with multicast loop.  caller holds pgm_sock_list_lock as
+ * reader.
+ */
+
+static
+void
+loop_deliver (
+	struct pgm_loop_member_t* const restrict sender,
+	const struct sockaddr*	  const restrict src,
+	const struct sockaddr*	  const restrict dst,
+	const void*			restrict buf,
+	const size_t				 len
+	)
+{
+	for (pgm_slist_t* list = sender->loop->members; NULL != list; list = list->next)
+	{
+		struct pgm_loop_member_t* member = list->data;
+		if (member == sender && !sender->sock->use_multicast_loop)
+			continue;
+		if (PGM_UNLIKELY(len > member->sock->max_tpdu))
+			continue;
+		pgm_mutex_lock (&member->mutex);
+		if (PGM_UNLIKELY(member->queue.length >= PGM_LOOP_QUEUE_MAX)) {
+			member->overruns++;
+			pgm_mutex_unlock (&member->mutex);
+			continue;
+		}
+		struct pgm_loop_packet_t* packet = loop_packet_new (src, dst, buf, len);
+		pgm_queue_push_head_link (&member->queue, &packet->link_);
+/* readiness of the member, re-checked by the member after clearing */
+		pgm_notify_send (&member->sock->pending_notify);
+		member->sock->is_pending_read = TRUE;
+		pgm_mutex_unlock (&member->mutex);
+	}
+}
+
+/* join the named bus, creating it for the first member.  Called from
+ * pgm_bind() with sock::loop_name set.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error appropriately.
+ */
+
+bool
+pgm_loop_open (
+	pgm_sock_t*    const restrict sock,
+	pgm_error_t**	     restrict error
+	)
+{
+	struct pgm_loop_t* loop = NULL;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->loop_name);
+	pgm_assert (NULL == sock->loop);
+
+	if (PGM_UNLIKELY('\0' == sock->loop_name[ 0 ])) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Loopback bus requires a name."));
+		return FALSE;
+	}
+
+	struct pgm_loop_member_t* member = pgm_new0 (struct pgm_loop_member_t, 1);
+	member->sock	     = sock;
+	member->loss_rate    = sock->loop_loss_rate;
+	member->reorder_rate = sock->loop_reorder_rate;
+	if (0 != sock->loop_seed)
+		member->rand_.seed = sock->loop_seed;
+	else
+		pgm_rand_create (&member->rand_);
+	pgm_mutex_init (&member->mutex);
+	pgm_mutex_init (&member->tx_mutex);
+
+	pgm_rwlock_writer_lock (&pgm_sock_list_lock);
+	for (pgm_slist_t* list = loop_list; NULL != list; list = list->next)
+	{
+		struct pgm_loop_t* candidate = list->data;
+		if (0 == strcmp (candidate->name, sock->loop_name)) {
+			loop = candidate;
+			break;
+		}
+	}
+	if (NULL == loop) {
+		loop = pgm_new0 (struct pgm_loop_t, 1);
+		loop->name = pgm_strdup (sock->loop_name);
+		loop_list = pgm_slist_prepend (loop_list, loop);
+	}
+	member->loop = loop;
+	loop->members = pgm_slist_append (loop->members, member);
+	sock->loop = member;
+	pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Joined loopback bus %s with %u other PGM sockets."),
+		   loop->name, pgm_slist_length (loop->members) - 1);
+	return TRUE;
+}
+
+/* leave the bus, discarding packets still waiting and any held back, and
+ * free the bus with the last member.
+ */
+
+void
+pgm_loop_close (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_loop_member_t* member;
+	struct pgm_loop_t* loop;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	member = sock->loop;
+	if (NULL == member)
+		return;
+	loop = member->loop;
+
+	pgm_rwlock_writer_lock (&pgm_sock_list_lock);
+	loop->members = pgm_slist_remove (loop->members, member);
+	if (NULL == loop->members) {
+		loop_list = pgm_slist_remove (loop_list, loop);
+		pgm_free (loop->name);
+		pgm_free (loop);
+	}
+	sock->loop = NULL;
+	pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Read %" PRIu64 " packets from loopback bus, %" PRIu64 " overrun, %" PRIu64 " sent lost and %" PRIu64 " reordered."),
+		   member->packets, member->overruns, member->losses, member->reorders);
+
+/* no other member references the queue once unlisted */
+	pgm_list_t* link;
+	while (NULL != (link = pgm_queue_pop_tail_link (&member->queue)))
+		pgm_free (link);
+	if (NULL != member->held)
+		pgm_free (member->held);
+	pgm_mutex_free (&member->tx_mutex);
+	pgm_mutex_free (&member->mutex);
+	pgm_free (member);
+}
+
+/* send a packet over the bus in place of the network, subject to the channel
+ * model of the socket.  a packet held back for reordering follows the next
+ * packet sent, heartbeat SPMs release a packet held at the end of a stream.
+ *
+ * returns len, lost packets count as sent as on the network.
+ */
+
+ssize_t
+pgm_loop_sendto (
+	pgm_sock_t*	       const restrict sock,
+	const void*		     restrict buf,
+	const size_t			      len,
+	const struct sockaddr* const restrict to
+	)
+{
+	struct pgm_loop_member_t* member = sock->loop;
+	struct pgm_loop_packet_t* held = NULL;
+	const struct sockaddr* src = (const struct sockaddr*)&sock->send_addr;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != member);
+	pgm_assert (NULL != buf);
+	pgm_assert (len >= sizeof (struct pgm_header));
+	pgm_assert (NULL != to);
+
+	if (0 != member->loss_rate || 0 != member->reorder_rate || NULL != member->held)
+	{
+		pgm_mutex_lock (&member->tx_mutex);
+		if (loop_chance (member, member->loss_rate)) {
+			member->losses++;
+			pgm_mutex_unlock (&member->tx_mutex);
+			return (ssize_t)len;
+		}
+		held = member->held;
+		if (NULL == held && loop_chance (member, member->reorder_rate)) {
+			member->held = loop_packet_new (src, to, buf, len);
+			member->reorders++;
+			pgm_mutex_unlock (&member->tx_mutex);
+			return (ssize_t)len;
+		}
+		member->held = NULL;
+		pgm_mutex_unlock (&member->tx_mutex);
+	}
+
+	pgm_rwlock_reader_lock (&pgm_sock_list_lock);
+	loop_deliver (member, src, to, buf, len);
+	if (NULL != held)
+		loop_deliver (member, (const struct sockaddr*)&held->src, (const struct sockaddr*)&held->dst, held->data, held->len);
+	pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
+	if (NULL != held)
+		pgm_free (held);
+	return (ssize_t)len;
+}
+
+/* read the next packet of the queue into a PGM skbuff, the PGM header onwards
+ * with the sender and destination addresses, as recvskb() would from a UDP
+ * encapsulated socket.
+ *
+ * on success returns packet length, when the queue is empty returns -1 for
+ * the caller to read the network.
+ */
+
+ssize_t
+pgm_loop_recvskb (
+	pgm_sock_t*           const restrict sock,
+	struct pgm_sk_buff_t* const restrict skb,
+	struct sockaddr*      const restrict src_addr,
+	const socklen_t			     src_addrlen,
+	struct sockaddr*      const restrict dst_addr,
+	const socklen_t			     dst_addrlen
+	)
+{
+	struct pgm_loop_member_t* member = sock->loop;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != member);
+	pgm_assert (NULL != skb);
+	pgm_assert (NULL != src_addr);
+	pgm_assert (src_addrlen >= sizeof(struct sockaddr_storage));
+	pgm_assert (NULL != dst_addr);
+	pgm_assert (dst_addrlen >= sizeof(struct sockaddr_storage));
+
+	if (pgm_queue_is_empty (&member->queue))
+		return -1;
+	pgm_mutex_lock (&member->mutex);
+	struct pgm_loop_packet_t* packet = (struct pgm_loop_packet_t*)pgm_queue_pop_tail_link (&member->queue);
+	pgm_mutex_unlock (&member->mutex);
+	if (NULL == packet)
+		return -1;
+	member->packets++;
+
+	memcpy (skb->head, packet->data, packet->len);
+	memcpy (src_addr, &packet->src, pgm_sockaddr_len ((const struct sockaddr*)&packet->src));
+	memcpy (dst_addr, &packet->dst, pgm_sockaddr_len ((const struct sockaddr*)&packet->dst));
+	skb->sock		= sock;
+	skb->tstamp		= pgm_time_coarse_now();
+	skb->rx_tstamp		= 0;
+	skb->data		= skb->head;
+	skb->len		= packet->len;
+	skb->zero_padded	= 0;
+	skb->tail		= (char*)skb->data + skb->len;
+	pgm_free (packet);
+	return skb->len;
+}
+
+/* restore the pending notification cleared by the member while another member
+ * queued a packet.
+ */
+
+void
+pgm_loop_rearm (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_loop_member_t* member = sock->loop;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != member);
+
+	pgm_mutex_lock (&member->mutex);
+	if (!pgm_queue_is_empty (&member->queue)) {
+		pgm_notify_send (&sock->pending_notify);
+		sock->is_pending_read = TRUE;
+	}
+	pgm_mutex_unlock (&member->mutex);
+}
+
+/* eof */
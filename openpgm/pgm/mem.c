@@ -25,11 +25,21 @@
 #	include <config.h>
 #endif
 #include <ctype.h>
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#ifdef HAVE_MMAP
+#	include <sys/mman.h>
+#	ifdef __linux__
+#		include <unistd.h>
+#		include <sys/syscall.h>
+#	endif
+#endif
 #ifdef _WIN32
 #	define strcasecmp	stricmp
 #endif
+#include <impl/i18n.h>
 #include <impl/framework.h>
 #include <impl/mem.h>
 
@@ -40,6 +50,7 @@
 /* globals */
 
 bool pgm_mem_gc_friendly PGM_GNUC_READ_MOSTLY = FALSE;
+pgm_mem_budget_t pgm_mem_global_budget = { 0, 0, NULL };
 
 
 /* locals */
@@ -135,6 +146,17 @@ pgm_mem_init (void)
 
 	if (flags & 1)
 		pgm_mem_gc_friendly = TRUE;
+
+/* process-wide limit of window packet buffers in bytes */
+	const errno_t budget_err = pgm_dupenv_s (&env, &envlen, "PGM_MEM_BUDGET");
+	if (0 == budget_err && envlen > 0) {
+		const unsigned long long budget = strtoull (env, NULL, 10);
+		if (budget > 0) {
+			pgm_mem_global_budget.max = budget;
+			pgm_minor (_("Setting PGM memory budget to %llu bytes."), budget);
+		}
+		pgm_free (env);
+	}
 }
 
 PGM_GNUC_INTERNAL
@@ -285,4 +307,299 @@ pgm_free (
 		free (mem);
 }
 
+#if defined( HAVE_MMAP ) && defined( __linux__ ) && defined( SYS_mbind )
+/* as <numaif.h>, without a dependency on libnuma */
+#	ifndef MPOL_PREFERRED
+#		define MPOL_PREFERRED	1
+#	endif
+#	define PGM_MEM_MAX_NODES	1024
+
+/* prefer node for pages of the region not yet faulted.  preferred rather than
+ * bound such that an exhausted node, or one without reserved huge pages,
+ * falls back to other nodes instead of failing the fault.
+ */
+
+static
+void
+_pgm_mem_region_prefer_node (
+	pgm_mem_region_t*const	region,
+	const int		node
+	)
+{
+	unsigned long nodemask[ PGM_MEM_MAX_NODES / (8 * sizeof (unsigned long)) ];
+
+	if (node >= PGM_MEM_MAX_NODES)
+		return;
+	memset (nodemask, 0, sizeof (nodemask));
+	nodemask[ node / (8 * sizeof (unsigned long)) ] |= 1UL << (node % (8 * sizeof (unsigned long)));
+	if (0 != syscall (SYS_mbind, region->addr, region->len, MPOL_PREFERRED, nodemask, PGM_MEM_MAX_NODES + 1, 0))
+		pgm_trace (PGM_LOG_ROLE_MEMORY,_("Failed to place %" PRIzu " bytes on NUMA node %d: %s"),
+			   region->len, node, strerror (errno));
+}
+#else
+#	define _pgm_mem_region_prefer_node(region, node)	do { (void)(region); (void)(node); } while (0)
+#endif
+
+/* map len zeroed bytes, on huge pages of page_size bytes when non-zero and
+ * available, otherwise on regular pages, preferring numa_node when not
+ * negative.  with use_mlock every page is
+ * faulted in and locked so the first packets through a window take neither
+ * page faults nor swap.  failure to lock is not fatal, region->locked
+ * reports the bytes pinned.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_mem_region_map (
+	pgm_mem_region_t*const	region,
+	const size_t		len,
+	const size_t		page_size,	/* 0 = regular pages */
+	const bool		use_mlock,
+	const int		numa_node	/* -1 = first touch */
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != region);
+	pgm_assert_cmpuint (len, >, 0);
+	pgm_assert (0 == page_size || PGM_HUGEPAGE_2MB == page_size || PGM_HUGEPAGE_1GB == page_size);
+
+	memset (region, 0, sizeof (pgm_mem_region_t));
+#ifdef HAVE_MMAP
+#	if defined(MAP_HUGETLB)
+#		ifndef MAP_HUGE_SHIFT
+#			define MAP_HUGE_SHIFT	26
+#		endif
+	if (page_size) {
+		const size_t map_len = (len + page_size - 1) & ~(page_size - 1);
+		const int huge_flag = (int)pgm_power2_log2 ((unsigned)page_size) << MAP_HUGE_SHIFT;
+		void* addr = mmap (NULL, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | huge_flag, -1, 0);
+		if (MAP_FAILED != addr) {
+			region->addr = addr;
+			region->len = map_len;
+			region->page_size = page_size;
+		} else {
+			pgm_trace (PGM_LOG_ROLE_MEMORY,_("%" PRIzu " byte huge pages unavailable for %" PRIzu " byte region, using regular pages: %s"),
+				   page_size, map_len, strerror (errno));
+		}
+	}
+#	endif
+	if (NULL == region->addr) {
+		void* addr = mmap (NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (MAP_FAILED == addr) {
+			pgm_fatal (_("Failed to map %" PRIzu " bytes: %s"), len, strerror (errno));
+			abort ();
+		}
+		region->addr = addr;
+		region->len = len;
+	}
+/* placement applies to pages faulted after the policy is set */
+	if (numa_node >= 0)
+		_pgm_mem_region_prefer_node (region, numa_node);
+#else
+	(void)page_size;
+	(void)numa_node;
+	region->addr = pgm_malloc0 (len);
+	region->len = len;
+#endif
+	if (!use_mlock)
+		return;
+
+/* prefault */
+	memset (region->addr, 0, region->len);
+#ifdef HAVE_MMAP
+	if (0 == mlock (region->addr, region->len))
+		region->locked = region->len;
+	else
+		pgm_trace (PGM_LOG_ROLE_MEMORY,_("Failed to lock %" PRIzu " bytes in memory: %s"),
+			   region->len, strerror (errno));
+#endif
+}
+
+/* fault in every page of len bytes at addr keeping the contents, such that
+ * the first packets through the memory take no page fault.  the memory must
+ * not be written concurrently.
+ *
+ * returns bytes touched.
+ */
+
+PGM_GNUC_INTERNAL
+size_t
+pgm_mem_prefault (
+	void*const		addr,
+	const size_t		len
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != addr || 0 == len);
+
+	volatile char* p = addr;
+	for (size_t offset = 0; offset < len; offset += PGM_PREFAULT_STRIDE)
+		p[offset] = p[offset];
+	if (len > 0)
+		p[len - 1] = p[len - 1];
+	return len;
+}
+
+PGM_GNUC_INTERNAL
+void
+pgm_mem_region_unmap (
+	pgm_mem_region_t*const	region
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != region);
+
+	if (NULL == region->addr)
+		return;
+#ifdef HAVE_MMAP
+	munmap (region->addr, region->len);
+#else
+	pgm_free (region->addr);
+#endif
+	memset (region, 0, sizeof (pgm_mem_region_t));
+}
+
+/* chunk header, a cache line such that blocks keep the chunk alignment */
+#define PGM_MEM_SLAB_HEADER	64
+
+/* returns size class of a block of len bytes, PGM_MEM_SLAB_CLASSES when
+ * larger than the largest class.
+ */
+
+static inline
+unsigned
+_pgm_mem_slab_class (
+	const size_t		len
+	)
+{
+	unsigned class_ = 0;
+	while (class_ < PGM_MEM_SLAB_CLASSES && ((size_t)1 << (PGM_MEM_SLAB_MIN_SHIFT + class_)) < len)
+		class_++;
+	return class_;
+}
+
+/* take a new heap allocation of len bytes onto the chunk list.  caller holds
+ * the slab lock.
+ */
+
+static
+char*
+_pgm_mem_slab_chunk (
+	pgm_mem_slab_t*const	slab,
+	const size_t		len
+	)
+{
+	char* chunk = pgm_malloc (PGM_MEM_SLAB_HEADER + len);
+	*(void**)chunk = slab->chunks;
+	slab->chunks = chunk;
+	slab->len += PGM_MEM_SLAB_HEADER + len;
+	return chunk + PGM_MEM_SLAB_HEADER;
+}
+
+PGM_GNUC_INTERNAL
+pgm_mem_slab_t*
+pgm_mem_slab_new (void)
+{
+	pgm_mem_slab_t* slab = pgm_new0 (pgm_mem_slab_t, 1);
+	pgm_spinlock_init (&slab->lock);
+	return slab;
+}
+
+/* free every chunk of the slab, no block may remain in use.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_mem_slab_destroy (
+	pgm_mem_slab_t*const	slab
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != slab);
+
+	while (NULL != slab->chunks) {
+		void* next = *(void**)slab->chunks;
+		pgm_free (slab->chunks);
+		slab->chunks = next;
+	}
+	pgm_spinlock_free (&slab->lock);
+	pgm_free (slab);
+}
+
+/* zeroed block of at least len bytes from the free list of its size class,
+ * carved from the newest chunk when the list is empty.  the tail of a chunk
+ * too short for the request is split onto the lists of smaller classes.
+ * without a slab, or beyond the largest class, the block is from the heap.
+ */
+
+PGM_GNUC_INTERNAL
+void*
+pgm_mem_slab_alloc0 (
+	pgm_mem_slab_t*const	slab,
+	const size_t		len
+	)
+{
+	const unsigned class_ = _pgm_mem_slab_class (len);
+	if (NULL == slab || class_ >= PGM_MEM_SLAB_CLASSES)
+		return pgm_malloc0 (len);
+
+	const size_t block_len = (size_t)1 << (PGM_MEM_SLAB_MIN_SHIFT + class_);
+	void* block;
+	pgm_spinlock_lock (&slab->lock);
+	if (NULL != slab->free_list[ class_ ]) {
+		block = slab->free_list[ class_ ];
+		slab->free_list[ class_ ] = *(void**)block;
+	} else if (block_len > PGM_MEM_SLAB_CHUNK / 4) {
+		block = _pgm_mem_slab_chunk (slab, block_len);
+	} else {
+		if (slab->remaining < block_len) {
+			for (unsigned i = class_; i-- > 0; ) {
+				const size_t piece = (size_t)1 << (PGM_MEM_SLAB_MIN_SHIFT + i);
+				if (slab->remaining < piece)
+					continue;
+				*(void**)slab->cursor = slab->free_list[ i ];
+				slab->free_list[ i ] = slab->cursor;
+				slab->cursor += piece;
+				slab->remaining -= piece;
+			}
+			slab->cursor = _pgm_mem_slab_chunk (slab, PGM_MEM_SLAB_CHUNK);
+			slab->remaining = PGM_MEM_SLAB_CHUNK;
+		}
+		block = slab->cursor;
+		slab->cursor += block_len;
+		slab->remaining -= block_len;
+	}
+	slab->used += block_len;
+	pgm_spinlock_unlock (&slab->lock);
+	memset (block, 0, len);
+	return block;
+}
+
+/* return a block of len bytes, as requested of pgm_mem_slab_alloc0(), to the
+ * free list of its size class.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_mem_slab_free (
+	pgm_mem_slab_t*const	slab,
+	void*const		mem,
+	const size_t		len
+	)
+{
+	const unsigned class_ = _pgm_mem_slab_class (len);
+	if (NULL == slab || class_ >= PGM_MEM_SLAB_CLASSES) {
+		pgm_free (mem);
+		return;
+	}
+	if (PGM_UNLIKELY(NULL == mem))
+		return;
+
+	pgm_spinlock_lock (&slab->lock);
+	*(void**)mem = slab->free_list[ class_ ];
+	slab->free_list[ class_ ] = mem;
+	slab->used -= (size_t)1 << (PGM_MEM_SLAB_MIN_SHIFT + class_);
+	pgm_spinlock_unlock (&slab->lock);
+}
+
 /* eof */
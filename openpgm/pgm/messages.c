@@ -58,6 +58,7 @@ static pgm_log_func_t 		log_handler PGM_GNUC_READ_MOSTLY = NULL;
 static void* 			log_handler_closure PGM_GNUC_READ_MOSTLY = NULL;
 
 static inline const char* log_level_text (const int) PGM_GNUC_PURE;
+static void log_write (const int, const char*);
 
 
 static inline
@@ -168,6 +169,11 @@ pgm__log (
 	va_end (args);
 }
 
+/* format on the calling thread unless recorded for the logging thread, fatal
+ * messages and those that cannot be recorded are written synchronously after
+ * any pending messages.
+ */
+
 PGM_GNUC_INTERNAL
 void
 pgm__logv (
@@ -178,9 +184,47 @@ pgm__logv (
 {
 	char tbuf[1024];
 
+	if (pgm_log_async) {
+		if (PGM_LOG_LEVEL_FATAL != log_level && pgm_logring_push (log_level, format, args))
+			return;
+		pgm_logring_flush ();
+	}
+
 	pgm_mutex_lock (&messages_mutex);
 	const int offset = pgm_snprintf_s (tbuf, sizeof (tbuf), _TRUNCATE, "%s: ", log_level_text (log_level));
 	pgm_vsnprintf_s (tbuf + offset, sizeof(tbuf) - offset, _TRUNCATE, format, args);
+	log_write (log_level, tbuf);
+	pgm_mutex_unlock (&messages_mutex);
+}
+
+/* write a formatted message, used by the logging thread.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm__log_text (
+	const int		log_level,
+	const char*		text
+	)
+{
+	char tbuf[1024];
+
+	pgm_mutex_lock (&messages_mutex);
+	pgm_snprintf_s (tbuf, sizeof (tbuf), _TRUNCATE, "%s: %s", log_level_text (log_level), text);
+	log_write (log_level, tbuf);
+	pgm_mutex_unlock (&messages_mutex);
+}
+
+/* messages mutex must be held.
+ */
+
+static
+void
+log_write (
+	const int		log_level,
+	const char*		tbuf
+	)
+{
 	if (log_handler) {
 		log_handler (log_level, tbuf, log_handler_closure);
 	} else {
@@ -194,8 +238,6 @@ pgm__logv (
 		(void) write (STDOUT_FILENO, "\n", 1);
 #endif
 	}
-		
-	pgm_mutex_unlock (&messages_mutex);
 }
 
 /* eof */
@@ -22,23 +22,889 @@
 #ifdef HAVE_CONFIG_H
 #	include <config.h>
 #endif
+
+#ifndef _GNU_SOURCE
+#	define _GNU_SOURCE		/* sendmmsg */
+#endif
+
 #include <errno.h>
+#include <string.h>
 #ifdef HAVE_POLL
 #	include <poll.h>
 #endif
 #ifndef _WIN32
 #	include <sys/socket.h>
 #	include <netinet/in.h>
+#	include <netinet/udp.h>
 #	include <arpa/inet.h>
 #endif
+#ifdef HAVE_LINUX_NET_TSTAMP_H
+#	include <time.h>
+#	include <linux/net_tstamp.h>
+#endif
+#ifdef HAVE_LINUX_ERRQUEUE_H
+#	include <linux/errqueue.h>
+#endif
+#if defined( HAVE_LINUX_NET_TSTAMP_H ) && defined( SO_TIMESTAMPING )
+#	include <net/if.h>
+#	include <sys/ioctl.h>
+#	include <linux/sockios.h>
+#endif
 #include <impl/i18n.h>
 #include <impl/framework.h>
 #include <impl/net.h>
 #include <impl/socket.h>
+#include <impl/shard.h>
+#include <impl/xdp.h>
+#include <impl/dpdk.h>
+#include <impl/uring.h>
+#include <impl/rio.h>
+#include <impl/shm.h>
+#include <impl/loop.h>
 
 
 //#define NET_DEBUG
 
+/* kernel limits on one UDP GSO super-buffer, UDP_MAX_SEGMENTS and the IPv4
+ * UDP payload ceiling.
+ */
+#define PGM_UDP_GSO_MAX_SEGMENTS	64
+#define PGM_UDP_GSO_MAX_LEN		65507
+
+#if defined( HAVE_LINUX_NET_TSTAMP_H ) && defined( SO_TXTIME ) && defined( SCM_TXTIME )
+#	define PGM_HAVE_TXTIME
+#endif
+#if defined( HAVE_LINUX_ERRQUEUE_H ) && defined( SO_ZEROCOPY ) && defined( MSG_ZEROCOPY ) && defined( SO_EE_ORIGIN_ZEROCOPY )
+#	define PGM_HAVE_ZEROCOPY
+#endif
+#if defined( PGM_HAVE_RX_TIMESTAMP ) && defined( HAVE_LINUX_NET_TSTAMP_H ) && defined( SO_TIMESTAMPING ) && defined( SIOCSHWTSTAMP )
+#	define PGM_HAVE_HW_TIMESTAMP
+#endif
+#if !defined( _WIN32 ) && defined( IP_TOS ) && defined( IPV6_TCLASS )
+#	define PGM_HAVE_TOS_CMSG
+#endif
+
+
+/* wait for a congested socket to clear and retry the send once.  unreachable
+ * destinations and would-block conditions are returned to the caller as-is.
+ *
+ * on success, returns number of bytes sent.  on error, -1 is returned, and
+ * errno set appropriately.
+ */
+
+static
+ssize_t
+sendto_on_error (
+	const SOCKET			send_sock,
+	const void*	       restrict	buf,
+	const size_t			len,
+	const struct sockaddr* restrict	to,
+	const socklen_t			tolen
+	)
+{
+	ssize_t sent = -1;
+	int save_errno = pgm_get_last_sock_error();
+	if (PGM_UNLIKELY(save_errno != PGM_SOCK_ENETUNREACH &&	/* Network is unreachable */
+			 save_errno != PGM_SOCK_EHOSTUNREACH &&	/* No route to host */
+			 save_errno != PGM_SOCK_EAGAIN))	/* would block on non-blocking send */
+	{
+#ifdef HAVE_POLL
+/* poll for cleared socket */
+		struct pollfd p = {
+			.fd		= send_sock,
+			.events		= POLLOUT,
+			.revents	= 0
+		};
+		const int ready = poll (&p, 1, 500 /* ms */);
+#else
+		fd_set writefds;
+		FD_ZERO(&writefds);
+		FD_SET(send_sock, &writefds);
+#	ifndef _WIN32
+		const int n_fds = send_sock + 1;	/* largest fd + 1 */
+#	else
+		const int n_fds = 1;			/* count of fds */
+#	endif
+		struct timeval tv = {
+			.tv_sec  = 0,
+			.tv_usec = 500 /* ms */ * 1000
+		};
+		const int ready = select (n_fds, NULL, &writefds, NULL, &tv);
+#endif /* HAVE_POLL */
+		if (ready > 0)
+		{
+			sent = sendto (send_sock, buf, len, 0, to, (socklen_t)tolen);
+			if ( sent < 0 )
+			{
+				char errbuf[1024];
+				char toaddr[INET6_ADDRSTRLEN];
+				save_errno = pgm_get_last_sock_error();
+				pgm_sockaddr_ntop (to, toaddr, sizeof(toaddr));
+				pgm_warn (_("sendto() %s failed: %s"),
+					toaddr,
+					pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+			}
+		}
+		else if (ready == 0)
+		{
+			char toaddr[INET6_ADDRSTRLEN];
+			pgm_sockaddr_ntop (to, toaddr, sizeof(toaddr));
+			pgm_warn (_("sendto() %s failed: socket timeout."), toaddr);
+		}
+		else
+		{
+			char errbuf[1024];
+			save_errno = pgm_get_last_sock_error();
+			pgm_warn (_("blocked socket failed: %s"),
+				  pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		}
+	}
+	return sent;
+}
+
+#ifdef PGM_HAVE_TXTIME
+/* launch time in nanoseconds of the SO_TXTIME clock.
+ */
+
+static inline
+uint64_t
+txtime_launch (
+	const pgm_sock_t*	sock,
+	const uint64_t		delay
+	)
+{
+	struct timespec ts;
+	clock_gettime (sock->txtime_clockid, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec + delay;
+}
+
+/* send one packet to be transmitted by the qdisc at launch time.
+ *
+ * on success, returns number of bytes sent.  on error, -1 is returned, and
+ * errno set appropriately.
+ */
+
+static
+ssize_t
+sendto_txtime (
+	const SOCKET			send_sock,
+	const void*	       restrict	buf,
+	const size_t			len,
+	const struct sockaddr* restrict	to,
+	const socklen_t			tolen,
+	const uint64_t			launch
+	)
+{
+	char aux[ CMSG_SPACE(sizeof(uint64_t)) ];
+	struct pgm_iovec iov = { .iov_base = (void*)buf, .iov_len = len };
+	struct msghdr msg;
+	struct cmsghdr* cmsg;
+
+	memset (aux, 0, sizeof(aux));
+	memset (&msg, 0, sizeof(msg));
+	msg.msg_name		= (void*)to;
+	msg.msg_namelen		= tolen;
+	msg.msg_iov		= (void*)&iov;
+	msg.msg_iovlen		= 1;
+	msg.msg_control		= aux;
+	msg.msg_controllen	= sizeof(aux);
+	cmsg			= CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level	= SOL_SOCKET;
+	cmsg->cmsg_type		= SCM_TXTIME;
+	cmsg->cmsg_len		= CMSG_LEN(sizeof(uint64_t));
+	memcpy (CMSG_DATA(cmsg), &launch, sizeof(launch));
+	return sendmsg (send_sock, &msg, 0);
+}
+#endif /* PGM_HAVE_TXTIME */
+
+/* TOS of the packet class of buf where it differs from the TOS set on the
+ * send socket, per PGM_ODATA_DSCP and siblings.
+ *
+ * returns TOS byte, or -1 to send with the socket TOS.
+ */
+
+static inline
+int
+sendto_class_tos (
+	const pgm_sock_t* restrict	sock,
+	const bool			use_router_alert,
+	const void*	  restrict	buf
+	)
+{
+#ifdef PGM_HAVE_TOS_CMSG
+	int tos;
+
+	if (PGM_LIKELY(!sock->use_class_dscp))
+		return -1;
+	switch (((const struct pgm_header*)buf)->pgm_type) {
+	case PGM_ODATA:	tos = pgm_tx_class_tos (sock, PGM_TX_CLASS_ODATA); break;
+	case PGM_RDATA:	tos = pgm_tx_class_tos (sock, PGM_TX_CLASS_RDATA); break;
+	case PGM_SPM:	tos = pgm_tx_class_tos (sock, PGM_TX_CLASS_SPM); break;
+	case PGM_NAK:
+	case PGM_NNAK:
+	case PGM_NCF:	tos = pgm_tx_class_tos (sock, PGM_TX_CLASS_NAK); break;
+	default:	tos = sock->tos; break;
+	}
+	return (tos == (use_router_alert ? sock->router_alert_sock_tos : sock->send_sock_tos)) ? -1 : tos;
+#else
+	(void)sock;
+	(void)use_router_alert;
+	(void)buf;
+	return -1;
+#endif
+}
+
+#ifdef PGM_HAVE_TOS_CMSG
+/* IP_TOS or IPV6_TCLASS control message into msg, aux of CMSG_SPACE(sizeof(int))
+ * bytes.
+ */
+
+static inline
+void
+sendto_tos_cmsg (
+	struct msghdr* restrict	msg,
+	char*	       restrict	aux,
+	const sa_family_t	family,
+	const int		tos
+	)
+{
+	struct cmsghdr* cmsg;
+
+	memset (aux, 0, CMSG_SPACE(sizeof(int)));
+	msg->msg_control	= aux;
+	msg->msg_controllen	= CMSG_SPACE(sizeof(int));
+	cmsg			= CMSG_FIRSTHDR(msg);
+	cmsg->cmsg_level	= (AF_INET6 == family) ? IPPROTO_IPV6 : IPPROTO_IP;
+	cmsg->cmsg_type		= (AF_INET6 == family) ? IPV6_TCLASS : IP_TOS;
+	cmsg->cmsg_len		= CMSG_LEN(sizeof(int));
+	memcpy (CMSG_DATA(cmsg), &tos, sizeof(tos));
+}
+#endif /* PGM_HAVE_TOS_CMSG */
+
+/* send one packet marked with tos, or with the socket TOS for -1, within the
+ * one system call.
+ *
+ * on success, returns number of bytes sent.  on error, -1 is returned, and
+ * errno set appropriately.
+ */
+
+static
+ssize_t
+sendto_tos (
+	const SOCKET			send_sock,
+	const sa_family_t		family,
+	const void*	       restrict	buf,
+	const size_t			len,
+	const struct sockaddr* restrict	to,
+	const socklen_t			tolen,
+	const int			tos
+	)
+{
+#ifdef PGM_HAVE_TOS_CMSG
+	if (tos >= 0) {
+		char aux[ CMSG_SPACE(sizeof(int)) ];
+		struct pgm_iovec iov = { .iov_base = (void*)buf, .iov_len = len };
+		struct msghdr msg;
+
+		memset (&msg, 0, sizeof(msg));
+		msg.msg_name		= (void*)to;
+		msg.msg_namelen		= tolen;
+		msg.msg_iov		= (void*)&iov;
+		msg.msg_iovlen		= 1;
+		sendto_tos_cmsg (&msg, aux, family, tos);
+		return sendmsg (send_sock, &msg, 0);
+	}
+#else
+	(void)family;
+	(void)tos;
+#endif
+	return sendto (send_sock, buf, len, 0, to, (socklen_t)tolen);
+}
+
+/* enable kernel pacing of the send socket with SO_TXTIME, the rate regulators
+ * then stamp each data packet with a launch time instead of holding it back.
+ * falls back to userspace regulation where unavailable.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_txtime_create (
+	pgm_sock_t*	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (PGM_TXTIME_NONE != sock->txtime_mode);
+
+	if (0 == sock->txw_max_rte) {
+		pgm_trace (PGM_LOG_ROLE_RATE_CONTROL,_("Transmit pacing requires PGM_TXW_MAX_RTE."));
+		return;
+	}
+	if (sock->xdp_xskmap_fd >= 0 || NULL != sock->dpdk || NULL != sock->uring) {
+		pgm_trace (PGM_LOG_ROLE_RATE_CONTROL,_("Transmit pacing unavailable with XDP, DPDK or io_uring transmit."));
+		return;
+	}
+#ifdef PGM_HAVE_TXTIME
+	struct sock_txtime config;
+	memset (&config, 0, sizeof(config));
+/* fq schedules on the monotonic clock, etf on TAI */
+	config.clockid = (PGM_TXTIME_ETF == sock->txtime_mode) ? CLOCK_TAI : CLOCK_MONOTONIC;
+	if (SOCKET_ERROR == setsockopt (sock->send_sock, SOL_SOCKET, SO_TXTIME, (const char*)&config, sizeof (config))) {
+		char errbuf[1024];
+		const int save_errno = pgm_get_last_sock_error();
+		pgm_warn (_("SO_TXTIME failed, regulating rate in userspace: %s"),
+			  pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		return;
+	}
+	sock->txtime_clockid			= config.clockid;
+	sock->use_txtime			= TRUE;
+	sock->rate_control.is_paced		= TRUE;
+	sock->odata_rate_control.is_paced	= TRUE;
+	sock->rdata_rate_control.is_paced	= TRUE;
+	pgm_trace (PGM_LOG_ROLE_RATE_CONTROL,_("Pacing transmit with SO_TXTIME on the %s clock."),
+		   (PGM_TXTIME_ETF == sock->txtime_mode) ? "TAI" : "monotonic");
+#else
+	pgm_trace (PGM_LOG_ROLE_RATE_CONTROL,_("SO_TXTIME unavailable, regulating rate in userspace."));
+#endif
+}
+
+/* enable MSG_ZEROCOPY on the send socket, original data packets are then
+ * transmitted from the transmit window by reference and each held until the
+ * kernel reports completion on the error queue.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_zerocopy_create (
+	pgm_sock_t*	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (sock->use_zerocopy);
+
+	if (sock->xdp_xskmap_fd >= 0 || NULL != sock->dpdk || NULL != sock->uring || sock->use_txtime) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Zero-copy transmit unavailable with XDP, DPDK, io_uring or transmit pacing."));
+		return;
+	}
+#ifdef PGM_HAVE_ZEROCOPY
+	const int optval = 1;
+	if (SOCKET_ERROR == setsockopt (sock->send_sock, SOL_SOCKET, SO_ZEROCOPY, (const char*)&optval, sizeof (optval))) {
+		char errbuf[1024];
+		const int save_errno = pgm_get_last_sock_error();
+		pgm_warn (_("SO_ZEROCOPY failed, copying transmit data: %s"),
+			  pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		return;
+	}
+	sock->zerocopy_skb	= pgm_new0 (struct pgm_sk_buff_t*, PGM_ZEROCOPY_MAX);
+	sock->zerocopy_lead	= 0;
+	sock->zerocopy_trail	= 0;
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Transmitting original data with MSG_ZEROCOPY."));
+#else
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("MSG_ZEROCOPY unavailable, copying transmit data."));
+#endif
+}
+
+#ifdef PGM_HAVE_HW_TIMESTAMP
+/* configure the NIC of the first joined group to stamp all received packets,
+ * requiring CAP_NET_ADMIN, then request raw hardware time stamps with kernel
+ * time stamps for packets the NIC leaves unstamped.
+ *
+ * returns TRUE on success, returns FALSE if unsupported.
+ */
+
+static
+bool
+rx_timestamp_hardware (
+	pgm_sock_t*	sock
+	)
+{
+	struct hwtstamp_config config;
+	struct ifreq ifr;
+	const int flags = SOF_TIMESTAMPING_RX_HARDWARE |
+			  SOF_TIMESTAMPING_RAW_HARDWARE |
+			  SOF_TIMESTAMPING_RX_SOFTWARE |
+			  SOF_TIMESTAMPING_SOFTWARE;
+
+	memset (&config, 0, sizeof(config));
+	memset (&ifr, 0, sizeof(ifr));
+	config.tx_type		= HWTSTAMP_TX_OFF;
+	config.rx_filter	= HWTSTAMP_FILTER_ALL;
+	if (0 == sock->recv_gsr_len ||
+	    NULL == if_indextoname (sock->recv_gsr[0].gsr_interface, ifr.ifr_name))
+	{
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Hardware receive time stamps require an explicit interface."));
+		return FALSE;
+	}
+	ifr.ifr_data = (void*)&config;
+	if (SOCKET_ERROR == ioctl (sock->recv_sock, SIOCSHWTSTAMP, &ifr) ||
+	    HWTSTAMP_FILTER_NONE == config.rx_filter)
+	{
+		char errbuf[1024];
+		const int save_errno = pgm_get_last_sock_error();
+		pgm_warn (_("SIOCSHWTSTAMP on %s failed, using kernel receive time stamps: %s"),
+			  ifr.ifr_name,
+			  pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		return FALSE;
+	}
+	for (unsigned i = 0; i < sock->recv_shards; i++)
+	{
+		if (SOCKET_ERROR == setsockopt (pgm_recv_shard_sock (sock, i), SOL_SOCKET, SO_TIMESTAMPING, (const char*)&flags, sizeof (flags))) {
+			char errbuf[1024];
+			const int save_errno = pgm_get_last_sock_error();
+			pgm_warn (_("SO_TIMESTAMPING failed, using kernel receive time stamps: %s"),
+				  pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+			return FALSE;
+		}
+	}
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Receiving with hardware time stamps from %s."), ifr.ifr_name);
+	return TRUE;
+}
+#endif /* PGM_HAVE_HW_TIMESTAMP */
+
+/* enable arrival time stamps on every receive socket, hardware falling back
+ * to kernel time stamps.  io_uring and AF_XDP receive bypass the control
+ * messages carrying them.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_rx_timestamp_create (
+	pgm_sock_t*	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (PGM_RX_TIMESTAMP_NONE != sock->rx_timestamp_mode);
+
+	if (sock->xdp_xskmap_fd >= 0 || NULL != sock->uring) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Receive time stamps unavailable with XDP or io_uring receive."));
+		sock->rx_timestamp_mode = PGM_RX_TIMESTAMP_NONE;
+		return;
+	}
+#ifdef PGM_HAVE_RX_TIMESTAMP
+	if (PGM_RX_TIMESTAMP_HARDWARE == sock->rx_timestamp_mode) {
+#	ifdef PGM_HAVE_HW_TIMESTAMP
+		if (!rx_timestamp_hardware (sock))
+#	endif
+			sock->rx_timestamp_mode = PGM_RX_TIMESTAMP_SOFTWARE;
+	}
+	if (PGM_RX_TIMESTAMP_SOFTWARE == sock->rx_timestamp_mode)
+	{
+		const int optval = 1;
+		for (unsigned i = 0; i < sock->recv_shards; i++)
+		{
+			if (SOCKET_ERROR == setsockopt (pgm_recv_shard_sock (sock, i), SOL_SOCKET, SO_TIMESTAMPNS, (const char*)&optval, sizeof (optval))) {
+				char errbuf[1024];
+				const int save_errno = pgm_get_last_sock_error();
+				pgm_warn (_("SO_TIMESTAMPNS failed, using processing time stamps: %s"),
+					  pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+				sock->rx_timestamp_mode = PGM_RX_TIMESTAMP_NONE;
+				return;
+			}
+		}
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Receiving with kernel time stamps."));
+	}
+	sock->use_rx_timestamp = TRUE;
+#else
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Receive time stamps unavailable, using processing time stamps."));
+	sock->rx_timestamp_mode = PGM_RX_TIMESTAMP_NONE;
+#endif
+}
+
+#ifdef PGM_HAVE_RX_TIMESTAMP
+/* arrival time of a received datagram, preferring the raw NIC time stamp.
+ *
+ * returns time since the epoch in microseconds, or 0 when absent.
+ */
+
+PGM_GNUC_INTERNAL
+pgm_time_t
+pgm_rx_timestamp (
+	const struct msghdr*	msg
+	)
+{
+	for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg); NULL != cmsg; cmsg = CMSG_NXTHDR((struct msghdr*)msg, cmsg))
+	{
+		if (SOL_SOCKET != cmsg->cmsg_level)
+			continue;
+		if (SCM_TIMESTAMPNS == cmsg->cmsg_type) {
+			struct timespec ts;
+			memcpy (&ts, CMSG_DATA(cmsg), sizeof (ts));
+			return pgm_timespec_to_usecs (&ts);
+		}
+#	ifdef SCM_TIMESTAMPING
+/* software, deprecated, raw hardware */
+		if (SCM_TIMESTAMPING == cmsg->cmsg_type) {
+			struct timespec ts[3];
+			memcpy (ts, CMSG_DATA(cmsg), sizeof (ts));
+			return pgm_timespec_to_usecs (0 != ts[2].tv_sec ? &ts[2] : &ts[0]);
+		}
+#	endif
+	}
+	return 0;
+}
+#endif /* PGM_HAVE_RX_TIMESTAMP */
+
+/* start receive auto-tuning at the minimum kernel receive buffer and enable
+ * drop counters on every receive socket.  counters require one socket per
+ * receive shard, and io_uring and AF_XDP receive bypass the control messages
+ * carrying them, otherwise tuning follows the received rate alone.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_rx_tune_create (
+	pgm_sock_t*	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (sock->use_rx_tune);
+	pgm_assert (NULL != sock->rx_shard);
+
+	for (unsigned i = 0; i < sock->rx_shard_len; i++) {
+		struct pgm_rx_shard_t* shard = &sock->rx_shard[ i ];
+		shard->rx_tune_rcvbuf = sock->rx_tune_rcvbuf_min;
+		shard->rx_tune_sqns   = 0;
+		pgm_rx_tune_rcvbuf (sock, shard, shard->rx_tune_rcvbuf);
+	}
+
+#ifdef PGM_HAVE_RXQ_OVFL
+	if (sock->xdp_xskmap_fd >= 0 || NULL != sock->uring) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Kernel drop counters unavailable with XDP or io_uring receive."));
+		return;
+	}
+	if (sock->recv_shards != sock->rx_shard_len) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Kernel drop counters unavailable with receive sockets sharing a shard."));
+		return;
+	}
+	const int optval = 1;
+	for (unsigned i = 0; i < sock->recv_shards; i++)
+	{
+		if (SOCKET_ERROR == setsockopt (pgm_recv_shard_sock (sock, i), SOL_SOCKET, SO_RXQ_OVFL, (const char*)&optval, sizeof (optval))) {
+			char errbuf[1024];
+			const int save_errno = pgm_get_last_sock_error();
+			pgm_warn (_("SO_RXQ_OVFL failed, tuning on received rate alone: %s"),
+				  pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+			return;
+		}
+	}
+	sock->use_rxq_ovfl = TRUE;
+#else
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Kernel drop counters unavailable, tuning on received rate alone."));
+#endif
+}
+
+/* set the kernel receive buffer of the receive sockets read by a shard, the
+ * kernel may clamp to its configured maximum.
+ *
+ * returns TRUE on success, returns FALSE on error.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_rx_tune_rcvbuf (
+	pgm_sock_t*		     const restrict sock,
+	const struct pgm_rx_shard_t* const restrict shard,
+	const size_t				    rcvbuf
+	)
+{
+	const int optval = (int)MIN(rcvbuf, INT_MAX);
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != shard);
+
+	for (unsigned i = 0; i < sock->recv_shards; i++)
+	{
+/* a receiver per shard reads only its own socket, otherwise fan in */
+		if (sock->rx_shard_len > 1 && i != shard->index)
+			continue;
+		if (SOCKET_ERROR == setsockopt (pgm_recv_shard_sock (sock, i), SOL_SOCKET, SO_RCVBUF, (const char*)&optval, sizeof (optval))) {
+			char errbuf[1024];
+			const int save_errno = pgm_get_last_sock_error();
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("SO_RCVBUF of %d bytes failed: %s"),
+				   optval,
+				   pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+#ifdef PGM_HAVE_RXQ_OVFL
+/* kernel receive queue overflow counter of the receiving socket, cumulative
+ * and only present once drops have occurred.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_rxq_ovfl (
+	const struct msghdr* const restrict msg,
+	uint32_t*	     const restrict ovfl
+	)
+{
+	for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg); NULL != cmsg; cmsg = CMSG_NXTHDR((struct msghdr*)msg, cmsg))
+	{
+		if (SOL_SOCKET == cmsg->cmsg_level && SO_RXQ_OVFL == cmsg->cmsg_type) {
+			memcpy (ovfl, CMSG_DATA(cmsg), sizeof (*ovfl));
+			return;
+		}
+	}
+}
+#endif /* PGM_HAVE_RXQ_OVFL */
+
+#ifdef PGM_HAVE_ZEROCOPY
+/* release packets of completed sends read from the send socket error queue,
+ * then advance the trail over released slots.  caller holds the send lock.
+ */
+
+static
+void
+zerocopy_reap (
+	pgm_sock_t*	sock
+	)
+{
+	char aux[ CMSG_SPACE(sizeof (struct sock_extended_err) + sizeof (struct sockaddr_in6)) ];
+
+	for (;;)
+	{
+		struct msghdr msg;
+		memset (&msg, 0, sizeof (msg));
+		msg.msg_control		= aux;
+		msg.msg_controllen	= sizeof (aux);
+		if (recvmsg (sock->send_sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+			break;
+		for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); NULL != cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+		{
+			if (!((IPPROTO_IP == cmsg->cmsg_level && IP_RECVERR == cmsg->cmsg_type) ||
+			      (IPPROTO_IPV6 == cmsg->cmsg_level && IPV6_RECVERR == cmsg->cmsg_type)))
+				continue;
+			const struct sock_extended_err* serr = (const void*)CMSG_DATA(cmsg);
+			if (SO_EE_ORIGIN_ZEROCOPY != serr->ee_origin || 0 != serr->ee_errno)
+				continue;
+/* inclusive range of completion ids, ignoring any outside the pending span */
+			for (uint32_t id = serr->ee_info; id != serr->ee_data + 1; id++) {
+				if (id - sock->zerocopy_trail >= sock->zerocopy_lead - sock->zerocopy_trail)
+					continue;
+				struct pgm_sk_buff_t** slot = &sock->zerocopy_skb[ id % PGM_ZEROCOPY_MAX ];
+				if (NULL != *slot) {
+					pgm_free_skb (*slot);
+					*slot = NULL;
+				}
+			}
+		}
+	}
+	while (sock->zerocopy_trail != sock->zerocopy_lead &&
+	       NULL == sock->zerocopy_skb[ sock->zerocopy_trail % PGM_ZEROCOPY_MAX ])
+		sock->zerocopy_trail++;
+}
+
+/* send each packet with MSG_ZEROCOPY taking a reference until completion,
+ * copying instead when the pending ring is full or the kernel is out of
+ * option memory.  caller holds the send lock.
+ *
+ * returns number of packets sent.
+ */
+
+static
+unsigned
+sendmsg_zerocopy (
+	pgm_sock_t*	       restrict	sock,
+	struct pgm_sk_buff_t*const*restrict skbs,
+	unsigned			count,
+	const struct sockaddr* restrict	to,
+	socklen_t			tolen
+	)
+{
+	unsigned i;
+
+	zerocopy_reap (sock);
+	for (i = 0; i < count; i++)
+	{
+		struct pgm_iovec iov;
+		struct msghdr msg;
+		iov.iov_base		= skbs[i]->head;
+		iov.iov_len		= (char*)skbs[i]->tail - (char*)skbs[i]->head;
+		memset (&msg, 0, sizeof (msg));
+		msg.msg_name		= (void*)to;
+		msg.msg_namelen		= tolen;
+		msg.msg_iov		= (void*)&iov;
+		msg.msg_iovlen		= 1;
+		bool is_zerocopy = (sock->zerocopy_lead - sock->zerocopy_trail) < PGM_ZEROCOPY_MAX;
+		ssize_t sent = sendmsg (sock->send_sock, &msg, is_zerocopy ? MSG_ZEROCOPY : 0);
+		pgm_debug ("sendmsg with MSG_ZEROCOPY returned %" PRIzd, sent);
+		if (sent < 0 && is_zerocopy && PGM_SOCK_ENOBUFS == pgm_get_last_sock_error()) {
+			is_zerocopy = FALSE;
+			sent = sendmsg (sock->send_sock, &msg, 0);
+		}
+		if (sent < 0) {
+			if (sendto_on_error (sock->send_sock, iov.iov_base, iov.iov_len, to, tolen) < 0 &&
+			    PGM_SOCK_EAGAIN == pgm_get_last_sock_error())
+				break;
+			continue;
+		}
+/* completion ids are allocated only by successful zero-copy sends */
+		if (is_zerocopy)
+			sock->zerocopy_skb[ sock->zerocopy_lead++ % PGM_ZEROCOPY_MAX ] = pgm_skb_get (skbs[i]);
+	}
+	return i;
+}
+#endif /* PGM_HAVE_ZEROCOPY */
+
+/* test whether a packet may still be read by the kernel from an earlier
+ * zero-copy send, such that its contents cannot yet be rewritten.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_zerocopy_is_pinned (
+	pgm_sock_t*		    const restrict sock,
+	const struct pgm_sk_buff_t* const restrict skb
+	)
+{
+	bool is_pinned = FALSE;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != skb);
+
+#ifdef PGM_HAVE_ZEROCOPY
+	if (NULL == sock->zerocopy_skb)
+		return FALSE;
+	pgm_sock_mutex_lock (sock, &sock->send_mutex);
+	zerocopy_reap (sock);
+	for (uint32_t id = sock->zerocopy_trail; id != sock->zerocopy_lead; id++)
+		if (skb == sock->zerocopy_skb[ id % PGM_ZEROCOPY_MAX ]) {
+			is_pinned = TRUE;
+			break;
+		}
+	pgm_sock_mutex_unlock (sock, &sock->send_mutex);
+#endif
+	return is_pinned;
+}
+
+/* release packets still pending completion, called at socket close when the
+ * send socket has been shut down.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_zerocopy_destroy (
+	pgm_sock_t*	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->zerocopy_skb);
+
+	for (unsigned i = 0; i < PGM_ZEROCOPY_MAX; i++)
+		if (NULL != sock->zerocopy_skb[ i ])
+			pgm_free_skb (sock->zerocopy_skb[ i ]);
+	pgm_free (sock->zerocopy_skb);
+	sock->zerocopy_skb = NULL;
+}
+
+/* copy a multicast packet to each redundant path, the send group mapped to
+ * the group of the path.  best effort, the regular send determines the
+ * result and a copy refused is left to the other paths.
+ */
+
+static
+void
+sendto_paths (
+	pgm_sock_t*	       restrict	sock,
+	const void*	       restrict	buf,
+	size_t				len,
+	const struct sockaddr* restrict	to,
+	socklen_t			tolen
+	)
+{
+	if (PGM_LIKELY(0 == sock->send_path_len) ||
+	    !pgm_sockaddr_is_addr_multicast (to))
+		return;
+	const bool is_send_group = (0 == pgm_sockaddr_cmp (to, (const struct sockaddr*)&sock->send_gsr.gsr_group));
+	for (unsigned i = 0; i < sock->send_path_len; i++) {
+		const struct sockaddr* path_to = is_send_group ? (const struct sockaddr*)&sock->send_path[ i ].gr_group : to;
+		const socklen_t path_tolen = is_send_group ? pgm_sockaddr_len (path_to) : tolen;
+		if (sendto (sock->send_path_sock[ i ], buf, len, 0, path_to, path_tolen) < 0)
+			pgm_debug ("sendto on redundant path %u failed", i);
+	}
+}
+
+/* account a full send socket buffer, a stall lasts from the first send
+ * refused with would-block until the next accepted.  called with send_mutex.
+ */
+
+static
+void
+sendto_sndbuf_stall (
+	pgm_sock_t*	       restrict	sock,
+	const bool			is_blocked
+	)
+{
+	if (is_blocked) {
+		if (0 == sock->sndbuf_stall_start) {
+			sock->sndbuf_stall_start = pgm_time_update_now();
+			sock->cumulative_stats[PGM_PC_SOURCE_SNDBUF_STALLS]++;
+		}
+	} else if (PGM_UNLIKELY(0 != sock->sndbuf_stall_start)) {
+		const pgm_time_t now = pgm_time_update_now();
+		const pgm_time_t stalled = now > sock->sndbuf_stall_start ? now - sock->sndbuf_stall_start : 0;
+		sock->sndbuf_stall_start = 0;
+		sock->cumulative_stats[PGM_PC_SOURCE_SNDBUF_STALL_USECS] += stalled;
+		PGM_HISTOGRAM_COUNTS("Tx.SndbufStallUsecs", (int)MIN(stalled, INT_MAX));
+	}
+}
+
+/* common MTUs, RFC 1191 section 7 with jumbo frames, Ethernet and the IPv6
+ * minimum.
+ */
+static const uint16_t pmtu_plateaus[] = { 32000, 17914, 9000, 8166, 4352, 2002, 1500, 1492, 1280, 1006, 576, 508, 296, 68 };
+
+/* a send with don't fragment exceeded the path MTU known to the stack: lower
+ * the path MTU of the socket to the next plateau below the TPDU, and as the
+ * TPDU is already in the transmit window send it fragmented.
+ *
+ * on success, returns number of bytes sent.  on error, -1 is returned, and
+ * errno set appropriately.
+ */
+
+static
+ssize_t
+sendto_emsgsize (
+	pgm_sock_t*	       restrict	sock,
+	const SOCKET			send_sock,
+	const void*	       restrict	buf,
+	const size_t			len,
+	const struct sockaddr* restrict	to,
+	const socklen_t			tolen
+	)
+{
+	const size_t tpdu_length = len + sock->iphdr_len;
+	const uint16_t floor_mtu = (AF_INET6 == sock->family) ? 1280 : 68;
+	uint16_t plateau = floor_mtu;
+	for (unsigned i = 0; i < PGM_N_ELEMENTS(pmtu_plateaus); i++)
+		if (pmtu_plateaus[ i ] < tpdu_length && pmtu_plateaus[ i ] >= floor_mtu) {
+			plateau = pmtu_plateaus[ i ];
+			break;
+		}
+	if (plateau < sock->pmtu_probed) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Path MTU below %" PRIzu " bytes, lowering TPDU to %u bytes."),
+			   tpdu_length, (unsigned)plateau);
+		sock->pmtu_probed = plateau;
+		sock->pmtu_probed_expiry = pgm_time_update_now() + PGM_PMTU_RAISE_IVL;
+		if (plateau < sock->pmtu_target)
+			sock->pmtu_target = plateau;
+	}
+	pgm_sockaddr_dontfrag (send_sock, sock->family, FALSE);
+	const ssize_t sent = sendto (send_sock, buf, len, 0, to, (socklen_t)tolen);
+	const int save_errno = pgm_get_last_sock_error();
+	pgm_sockaddr_dontfrag (send_sock, sock->family, TRUE);
+	pgm_set_last_sock_error (save_errno);
+	return sent;
+}
 
 /* locked and rate regulated sendto
  *
@@ -82,9 +948,28 @@ pgm_sendto_hops (
 #endif
 
 	const SOCKET send_sock = use_router_alert ? sock->send_with_router_alert_sock : sock->send_sock;
+#ifdef PGM_HAVE_TXTIME
+/* only the send socket is paced, router alert packets debit the regulators */
+	const bool use_txtime = use_rate_limit && sock->use_txtime && !use_router_alert;
+	uint64_t delay = 0;
+#endif
 
 	if (use_rate_limit)
 	{
+#ifdef PGM_HAVE_TXTIME
+		if (use_txtime)
+		{
+			const bool is_permitted = (NULL == minor_rate_control) ?
+				pgm_rate_pace (&sock->rate_control, len, sock->is_nonblocking, &delay) :
+				pgm_rate_pace2 (&sock->rate_control, minor_rate_control, len, sock->is_nonblocking, &delay);
+			if (!is_permitted)
+			{
+				pgm_set_last_sock_error (PGM_SOCK_ENOBUFS);
+				return (const ssize_t)-1;
+			}
+		}
+		else
+#endif
 		if (NULL == minor_rate_control)
 		{
 			if (!pgm_rate_check (&sock->rate_control, len, sock->is_nonblocking))
@@ -103,78 +988,519 @@ pgm_sendto_hops (
 		}
 	}
 
+/* same-host receivers, ahead of the network.  a packet refused on would-block
+ * is sent again by the caller and discarded by the receivers as a duplicate.
+ */
+	if (NULL != sock->shm)
+		pgm_shm_write (sock, buf, len, to);
+/* in-process bus in place of the network */
+	if (NULL != sock->loop)
+		return pgm_loop_sendto (sock, buf, len, to);
+
+#ifdef HAVE_LINUX_IF_XDP_H
+	if (pgm_xdp_can_sendto (sock, to)) {
+		const struct pgm_iovec iov = { .iov_base = (void*)buf, .iov_len = len };
+		return (pgm_xdp_sendv (sock, use_router_alert, hops, &iov, 1, to) < 0) ? (const ssize_t)-1 : (ssize_t)len;
+	}
+#endif
+#ifdef PGM_HAVE_DPDK
+	if (pgm_dpdk_can_sendto (sock, to)) {
+		const struct pgm_iovec iov = { .iov_base = (void*)buf, .iov_len = len };
+		return (pgm_dpdk_sendv (sock, use_router_alert, hops, &iov, 1, to) < 0) ? (const ssize_t)-1 : (ssize_t)len;
+	}
+#endif
+
 	if (!use_router_alert && sock->can_send_data)
-		pgm_mutex_lock (&sock->send_mutex);
+		pgm_sock_mutex_lock (sock, &sock->send_mutex);
 	if (-1 != hops)
 		pgm_sockaddr_multicast_hops (send_sock, sock->send_gsr.gsr_group.ss_family, hops);
 
-	ssize_t sent = sendto (send_sock, buf, len, 0, to, (socklen_t)tolen);
-	pgm_debug ("sendto returned %" PRIzd, sent);
-	if (sent < 0) {
-		int save_errno = pgm_get_last_sock_error();
-		if (PGM_UNLIKELY(save_errno != PGM_SOCK_ENETUNREACH &&	/* Network is unreachable */
-		 		 save_errno != PGM_SOCK_EHOSTUNREACH &&	/* No route to host */
-		    		 save_errno != PGM_SOCK_EAGAIN))	/* would block on non-blocking send */
-		{
-#ifdef HAVE_POLL
-/* poll for cleared socket */
-			struct pollfd p = {
-				.fd		= send_sock,
-				.events		= POLLOUT,
-				.revents	= 0
-			};
-			const int ready = poll (&p, 1, 500 /* ms */);
+/* paced packets are ODATA carrying the TOS of the socket */
+	const int tos = sendto_class_tos (sock, use_router_alert, buf);
+#ifdef PGM_HAVE_TXTIME
+	ssize_t sent = use_txtime ?
+		sendto_txtime (send_sock, buf, len, to, tolen, txtime_launch (sock, delay)) :
+		sendto_tos (send_sock, sock->family, buf, len, to, tolen, tos);
 #else
-			fd_set writefds;
-			FD_ZERO(&writefds);
-			FD_SET(send_sock, &writefds);
-#	ifndef _WIN32
-			const int n_fds = send_sock + 1;	/* largest fd + 1 */
-#	else
-			const int n_fds = 1;			/* count of fds */
+	ssize_t sent = sendto_tos (send_sock, sock->family, buf, len, to, tolen, tos);
+#endif
+	pgm_debug ("sendto returned %" PRIzd, sent);
+	if (sent < 0 && sock->use_pmtud && PGM_SOCK_EMSGSIZE == pgm_get_last_sock_error())
+		sent = sendto_emsgsize (sock, send_sock, buf, len, to, tolen);
+/* retry is sent immediately */
+	if (sent < 0)
+		sent = sendto_on_error (send_sock, buf, len, to, tolen);
+	if (sent >= 0)
+		sendto_paths (sock, buf, len, to, tolen);
+
+/* revert to default value hop limit */
+	if (-1 != hops)
+		pgm_sockaddr_multicast_hops (send_sock, sock->send_gsr.gsr_group.ss_family, sock->hops);
+	if (!use_router_alert && sock->can_send_data) {
+		sendto_sndbuf_stall (sock, sent < 0 && PGM_SOCK_EAGAIN == pgm_get_last_sock_error());
+		pgm_sock_mutex_unlock (sock, &sock->send_mutex);
+	}
+	return sent;
+}
+
+#if defined( HAVE_SENDMMSG ) && defined( UDP_SEGMENT )
+/* count leading packets that one UDP GSO super-buffer can carry: every
+ * segment the length of the first except a shorter trailing segment.
+ */
+
+static
+unsigned
+udp_gso_segments (
+	const struct pgm_iovec*	iov,
+	const unsigned		count
+	)
+{
+	const size_t gso_size = iov[0].iov_len;
+	size_t total = 0;
+	unsigned n = 0;
+
+	while (n < count &&
+	       n < PGM_UDP_GSO_MAX_SEGMENTS &&
+	       iov[n].iov_len <= gso_size &&
+	       total + iov[n].iov_len <= PGM_UDP_GSO_MAX_LEN)
+	{
+		total += iov[n].iov_len;
+		if (iov[n++].iov_len < gso_size)
+			break;
+	}
+	return n;
+}
+
+/* send segments as one datagram for the kernel to split on gso_size boundaries.
+ *
+ * on success, returns number of bytes sent.  on error, -1 is returned, and
+ * errno set appropriately.
+ */
+
+static
+ssize_t
+sendto_udp_gso (
+	const SOCKET			send_sock,
+	const struct pgm_iovec*restrict	iov,
+	const unsigned			segments,
+	const struct sockaddr* restrict	to,
+	const socklen_t			tolen
+	)
+{
+	char aux[ CMSG_SPACE(sizeof(uint16_t)) ];
+	struct msghdr msg;
+	struct cmsghdr* cmsg;
+
+	memset (aux, 0, sizeof(aux));
+	memset (&msg, 0, sizeof(msg));
+	msg.msg_name		= (void*)to;
+	msg.msg_namelen		= tolen;
+	msg.msg_iov		= (void*)iov;
+	msg.msg_iovlen		= segments;
+	msg.msg_control		= aux;
+	msg.msg_controllen	= sizeof(aux);
+	cmsg			= CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level	= SOL_UDP;
+	cmsg->cmsg_type		= UDP_SEGMENT;
+	cmsg->cmsg_len		= CMSG_LEN(sizeof(uint16_t));
+	*(uint16_t*)CMSG_DATA(cmsg) = (uint16_t)iov[0].iov_len;
+	return sendmsg (send_sock, &msg, 0);
+}
+#endif /* HAVE_SENDMMSG && UDP_SEGMENT */
+
+/* locked and rate regulated transmit of a vector of packets to one
+ * destination, with sendmmsg() where available.  The rate regulator is
+ * debited once for the entire vector and the send lock acquired once.
+ *
+ * on success, returns number of packets sent which may be less than count
+ * when the socket would block.  on error, -1 is returned, and errno set
+ * appropriately.  Packets failing for reasons other than would-block are
+ * skipped as per pgm_sendto().
+ */
+
+PGM_GNUC_INTERNAL
+int
+pgm_sendmmsg (
+	pgm_sock_t*	       restrict	sock,
+	bool				use_rate_limit,
+	pgm_rate_t*	       restrict	minor_rate_control,
+	bool				use_router_alert,
+	struct pgm_sk_buff_t*const*restrict skbs,
+	unsigned			count,
+	const struct sockaddr* restrict	to,
+	socklen_t			tolen
+	)
+{
+	unsigned i;
+
+	pgm_assert( NULL != sock );
+	pgm_assert( NULL != skbs );
+	pgm_assert( count > 0 );
+	pgm_assert( count <= PGM_SEND_BATCH_MAX );
+	pgm_assert( NULL != to );
+	pgm_assert( tolen > 0 );
+
+	pgm_debug ("pgm_sendmmsg (sock:%p use_rate_limit:%s minor_rate_control:%p use_router_alert:%s skbs:%p count:%u tolen:%d)",
+		(const void*)sock,
+		use_rate_limit ? "TRUE" : "FALSE",
+		(const void*)minor_rate_control,
+		use_router_alert ? "TRUE" : "FALSE",
+		(const void*)skbs,
+		count,
+		(int)tolen);
+
+	const SOCKET send_sock = use_router_alert ? sock->send_with_router_alert_sock : sock->send_sock;
+#ifdef PGM_HAVE_TXTIME
+	const bool use_txtime = use_rate_limit && sock->use_txtime && !use_router_alert;
+	uint64_t* delay = NULL;
+#endif
+/* a vector is of one packet class */
+	const int tos = sendto_class_tos (sock, use_router_alert, skbs[0]->head);
+
+#ifdef PGM_HAVE_TXTIME
+/* each packet of the vector is paced with its own launch time */
+	if (use_txtime)
+	{
+		delay = pgm_newa (uint64_t, count);
+		for (i = 0; i < count; i++) {
+			const size_t len = (char*)skbs[i]->tail - (char*)skbs[i]->head;
+			const bool is_permitted = (NULL == minor_rate_control) ?
+				pgm_rate_pace (&sock->rate_control, len, sock->is_nonblocking, &delay[i]) :
+				pgm_rate_pace2 (&sock->rate_control, minor_rate_control, len, sock->is_nonblocking, &delay[i]);
+			if (!is_permitted)
+				break;
+		}
+		if (0 == i) {
+			pgm_set_last_sock_error (PGM_SOCK_ENOBUFS);
+			return -1;
+		}
+		count = i;
+	}
+	else
+#endif
+	if (use_rate_limit)
+	{
+/* single IP header included by rate check */
+		size_t len = (count - 1) * sock->iphdr_len;
+		for (i = 0; i < count; i++)
+			len += (char*)skbs[i]->tail - (char*)skbs[i]->head;
+		bool is_permitted = (NULL == minor_rate_control) ?
+			pgm_rate_check (&sock->rate_control, len, sock->is_nonblocking) :
+			pgm_rate_check2 (&sock->rate_control, minor_rate_control, len, sock->is_nonblocking);
+/* vector may exceed bucket capacity on non-blocking sockets, fall back to one packet */
+		if (!is_permitted && count > 1) {
+			count = 1;
+			len = (char*)skbs[0]->tail - (char*)skbs[0]->head;
+			is_permitted = (NULL == minor_rate_control) ?
+				pgm_rate_check (&sock->rate_control, len, sock->is_nonblocking) :
+				pgm_rate_check2 (&sock->rate_control, minor_rate_control, len, sock->is_nonblocking);
+		}
+		if (!is_permitted) {
+			pgm_set_last_sock_error (PGM_SOCK_ENOBUFS);
+			return -1;
+		}
+	}
+
+	if (NULL != sock->shm)
+		for (i = 0; i < count; i++)
+			pgm_shm_write (sock, skbs[i]->head, (char*)skbs[i]->tail - (char*)skbs[i]->head, to);
+	if (NULL != sock->loop) {
+		for (i = 0; i < count; i++)
+			pgm_loop_sendto (sock, skbs[i]->head, (char*)skbs[i]->tail - (char*)skbs[i]->head, to);
+		return (int)count;
+	}
+
+#ifdef HAVE_LINUX_IF_XDP_H
+	if (pgm_xdp_can_sendto (sock, to)) {
+		struct pgm_iovec* vector = pgm_newa (struct pgm_iovec, count);
+		for (unsigned j = 0; j < count; j++) {
+			vector[j].iov_base	= skbs[j]->head;
+			vector[j].iov_len	= (char*)skbs[j]->tail - (char*)skbs[j]->head;
+		}
+		return pgm_xdp_sendv (sock, use_router_alert, -1, vector, count, to);
+	}
+#endif
+#ifdef PGM_HAVE_DPDK
+	if (pgm_dpdk_can_sendto (sock, to)) {
+		struct pgm_iovec* vector = pgm_newa (struct pgm_iovec, count);
+		for (unsigned j = 0; j < count; j++) {
+			vector[j].iov_base	= skbs[j]->head;
+			vector[j].iov_len	= (char*)skbs[j]->tail - (char*)skbs[j]->head;
+		}
+		return pgm_dpdk_sendv (sock, use_router_alert, -1, vector, count, to);
+	}
+#endif
+
+#ifdef PGM_HAVE_IO_URING
+/* asynchronous transmit, packet references held until completion */
+	if (NULL != sock->uring)
+		return pgm_uring_sendv (sock, use_router_alert, skbs, count, to, tolen);
+#endif
+#ifdef PGM_HAVE_RIO
+/* deferred Registered I/O transmit, committed per vector */
+	if (NULL != sock->rio)
+		return pgm_rio_sendv (sock, use_router_alert, skbs, count, to, tolen);
+#endif
+
+	if (!use_router_alert && sock->can_send_data)
+		pgm_sock_mutex_lock (sock, &sock->send_mutex);
+
+#ifdef PGM_HAVE_ZEROCOPY
+/* transmit from the window, packet references held until completion */
+	if (!use_router_alert && NULL != sock->zerocopy_skb) {
+		i = sendmsg_zerocopy (sock, skbs, count, to, tolen);
+		for (unsigned j = 0; j < i; j++)
+			sendto_paths (sock, skbs[j]->head, (char*)skbs[j]->tail - (char*)skbs[j]->head, to, tolen);
+		sendto_sndbuf_stall (sock, 0 == i);
+		pgm_sock_mutex_unlock (sock, &sock->send_mutex);
+		if (0 == i) {
+			pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+			return -1;
+		}
+		return (int)i;
+	}
+#endif
+
+	i = 0;
+#ifdef HAVE_SENDMMSG
+	struct mmsghdr* msgvec = pgm_newa (struct mmsghdr, count);
+	struct pgm_iovec* iov = pgm_newa (struct pgm_iovec, count);
+	for (unsigned j = 0; j < count; j++) {
+		iov[j].iov_base			= skbs[j]->head;
+		iov[j].iov_len			= (char*)skbs[j]->tail - (char*)skbs[j]->head;
+		memset (&msgvec[j], 0, sizeof(struct mmsghdr));
+		msgvec[j].msg_hdr.msg_name	= (void*)to;
+		msgvec[j].msg_hdr.msg_namelen	= tolen;
+		msgvec[j].msg_hdr.msg_iov	= (void*)&iov[j];
+		msgvec[j].msg_hdr.msg_iovlen	= 1;
+	}
+#	ifdef PGM_HAVE_TXTIME
+	if (use_txtime) {
+		const size_t aux_len = CMSG_SPACE(sizeof(uint64_t));
+		char* aux = pgm_newa (char, count * aux_len);
+		memset (aux, 0, count * aux_len);
+		for (unsigned j = 0; j < count; j++) {
+			const uint64_t launch = txtime_launch (sock, delay[j]);
+			struct cmsghdr* cmsg;
+			msgvec[j].msg_hdr.msg_control	 = aux + (j * aux_len);
+			msgvec[j].msg_hdr.msg_controllen = aux_len;
+			cmsg				= CMSG_FIRSTHDR(&msgvec[j].msg_hdr);
+			cmsg->cmsg_level		= SOL_SOCKET;
+			cmsg->cmsg_type			= SCM_TXTIME;
+			cmsg->cmsg_len			= CMSG_LEN(sizeof(uint64_t));
+			memcpy (CMSG_DATA(cmsg), &launch, sizeof(launch));
+		}
+	}
 #	endif
-			struct timeval tv = {
-				.tv_sec  = 0,
-				.tv_usec = 500 /* ms */ * 1000
-			};
-			const int ready = select (n_fds, NULL, &writefds, NULL, &tv);
-#endif /* HAVE_POLL */
-			if (ready > 0)
-			{
-				sent = sendto (send_sock, buf, len, 0, to, (socklen_t)tolen);
-				if ( sent < 0 )
-				{
+#	ifdef PGM_HAVE_TOS_CMSG
+	if (tos >= 0
+#		ifdef PGM_HAVE_TXTIME
+	    && !use_txtime
+#		endif
+	   ) {
+		char* aux = pgm_newa (char, count * CMSG_SPACE(sizeof(int)));
+		for (unsigned j = 0; j < count; j++)
+			sendto_tos_cmsg (&msgvec[j].msg_hdr, aux + (j * CMSG_SPACE(sizeof(int))), sock->family, tos);
+	}
+#	endif
+	while (i < count) {
+#ifdef UDP_SEGMENT
+/* equal sized packets handed to the kernel as one super-buffer, except paced
+ * or marked packets which each carry their own control message.
+ */
+		if (sock->use_udp_gso && tos < 0
+#	ifdef PGM_HAVE_TXTIME
+		    && !use_txtime
+#	endif
+		   ) {
+			const unsigned segments = udp_gso_segments (&iov[i], count - i);
+			if (segments > 1) {
+				const ssize_t sent = sendto_udp_gso (send_sock, &iov[i], segments, to, tolen);
+				pgm_debug ("sendmsg with UDP_SEGMENT returned %" PRIzd, sent);
+				if (sent >= 0) {
+					i += segments;
+					continue;
+				}
+				const int save_errno = pgm_get_last_sock_error();
+				if (PGM_SOCK_EAGAIN == save_errno)
+					break;
+/* kernel without UDP GSO support */
+				if (EIO == save_errno || EINVAL == save_errno || ENOPROTOOPT == save_errno) {
 					char errbuf[1024];
-					char toaddr[INET6_ADDRSTRLEN];
-					save_errno = pgm_get_last_sock_error();
-					pgm_sockaddr_ntop (to, toaddr, sizeof(toaddr));
-					pgm_warn (_("sendto() %s failed: %s"),
-						toaddr,
-						pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+					pgm_warn (_("Disabling UDP GSO: %s"),
+						  pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+					sock->use_udp_gso = FALSE;
 				}
 			}
-			else if (ready == 0)
-			{
-				char toaddr[INET6_ADDRSTRLEN];
-				pgm_sockaddr_ntop (to, toaddr, sizeof(toaddr));
-				pgm_warn (_("sendto() %s failed: socket timeout."), toaddr);
-			}
-			else
-			{
-				char errbuf[1024];
-				save_errno = pgm_get_last_sock_error();
-				pgm_warn (_("blocked socket failed: %s"),
-					  pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
-			}
 		}
+#endif
+		const int sent = sendmmsg (send_sock, &msgvec[i], count - i, 0);
+		pgm_debug ("sendmmsg returned %d", sent);
+		if (sent > 0) {
+			i += sent;
+			continue;
+		}
+/* first remaining packet failed */
+		const ssize_t retry = (sock->use_pmtud && PGM_SOCK_EMSGSIZE == pgm_get_last_sock_error()) ?
+			sendto_emsgsize (sock, send_sock, iov[i].iov_base, iov[i].iov_len, to, tolen) :
+			sendto_on_error (send_sock, iov[i].iov_base, iov[i].iov_len, to, tolen);
+		if (retry < 0 && PGM_SOCK_EAGAIN == pgm_get_last_sock_error())
+			break;
+		i++;
 	}
+#else
+	for (; i < count; i++) {
+		const size_t len = (char*)skbs[i]->tail - (char*)skbs[i]->head;
+#	ifdef PGM_HAVE_TXTIME
+		ssize_t sent = use_txtime ?
+			sendto_txtime (send_sock, skbs[i]->head, len, to, tolen, txtime_launch (sock, delay[i])) :
+			sendto_tos (send_sock, sock->family, skbs[i]->head, len, to, tolen, tos);
+#	else
+		ssize_t sent = sendto_tos (send_sock, sock->family, skbs[i]->head, len, to, tolen, tos);
+#	endif
+		if (sent < 0 && sock->use_pmtud && PGM_SOCK_EMSGSIZE == pgm_get_last_sock_error())
+			sent = sendto_emsgsize (sock, send_sock, skbs[i]->head, len, to, tolen);
+		if (sent < 0 &&
+		    sendto_on_error (send_sock, skbs[i]->head, len, to, tolen) < 0 &&
+		    PGM_SOCK_EAGAIN == pgm_get_last_sock_error())
+			break;
+	}
+#endif /* HAVE_SENDMMSG */
+
+	for (unsigned j = 0; j < i; j++)
+		sendto_paths (sock, skbs[j]->head, (char*)skbs[j]->tail - (char*)skbs[j]->head, to, tolen);
+	if (!use_router_alert && sock->can_send_data) {
+		sendto_sndbuf_stall (sock, 0 == i);
+		pgm_sock_mutex_unlock (sock, &sock->send_mutex);
+	}
+	if (0 == i) {
+		pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+		return -1;
+	}
+	return (int)i;
+}
+
+/* send one packet of the transmit window on the regular socket, by reference
+ * with MSG_ZEROCOPY when enabled.
+ *
+ * on success, returns number of bytes sent.  on error, -1 is returned, and
+ * errno set appropriately.
+ */
+
+PGM_GNUC_INTERNAL
+ssize_t
+pgm_sendskb (
+	pgm_sock_t*	       restrict	sock,
+	bool				use_rate_limit,
+	pgm_rate_t*	       restrict	minor_rate_control,
+	struct pgm_sk_buff_t*		skb,
+	const struct sockaddr* restrict	to,
+	socklen_t			tolen
+	)
+{
+	const size_t len = (char*)skb->tail - (char*)skb->head;
+
+	pgm_assert( NULL != sock );
+	pgm_assert( NULL != skb );
+
+	if (NULL != sock->zerocopy_skb)
+		return (pgm_sendmmsg (sock, use_rate_limit, minor_rate_control, FALSE, &skb, 1, to, tolen) < 0) ? (ssize_t)-1 : (ssize_t)len;
+	return pgm_sendto (sock, use_rate_limit, minor_rate_control, FALSE, skb->head, len, to, tolen);
+}
+
+/* send a vector of packets each to its own destination with one sendmmsg()
+ * call where available, without rate regulation.
+ *
+ * on success, returns number of packets sent which may be less than count
+ * when the socket would block.  on error, -1 is returned, and errno set
+ * appropriately.  Packets failing for reasons other than would-block are
+ * skipped as per pgm_sendto().
+ */
+
+PGM_GNUC_INTERNAL
+int
+pgm_sendmmsg_to (
+	pgm_sock_t*	       restrict	sock,
+	bool				use_router_alert,
+	const struct pgm_iovec*restrict	vector,
+	const struct sockaddr*const*restrict to,
+	unsigned			count
+	)
+{
+	unsigned i;
+
+	pgm_assert( NULL != sock );
+	pgm_assert( NULL != vector );
+	pgm_assert( NULL != to );
+	pgm_assert( count > 0 );
+
+	pgm_debug ("pgm_sendmmsg_to (sock:%p use_router_alert:%s vector:%p to:%p count:%u)",
+		(const void*)sock,
+		use_router_alert ? "TRUE" : "FALSE",
+		(const void*)vector,
+		(const void*)to,
+		count);
+
+	if (NULL != sock->loop) {
+		for (i = 0; i < count; i++)
+			pgm_loop_sendto (sock, vector[i].iov_base, vector[i].iov_len, to[i]);
+		return (int)count;
+	}
+
+	const SOCKET send_sock = use_router_alert ? sock->send_with_router_alert_sock : sock->send_sock;
+	const int tos = sendto_class_tos (sock, use_router_alert, vector[0].iov_base);
 
-/* revert to default value hop limit */
-	if (-1 != hops)
-		pgm_sockaddr_multicast_hops (send_sock, sock->send_gsr.gsr_group.ss_family, sock->hops);
 	if (!use_router_alert && sock->can_send_data)
-		pgm_mutex_unlock (&sock->send_mutex);
-	return sent;
+		pgm_sock_mutex_lock (sock, &sock->send_mutex);
+
+	i = 0;
+#ifdef HAVE_SENDMMSG
+	struct mmsghdr* msgvec = pgm_newa (struct mmsghdr, count);
+	for (unsigned j = 0; j < count; j++) {
+		memset (&msgvec[j], 0, sizeof(struct mmsghdr));
+		msgvec[j].msg_hdr.msg_name	= (void*)to[j];
+		msgvec[j].msg_hdr.msg_namelen	= pgm_sockaddr_len (to[j]);
+		msgvec[j].msg_hdr.msg_iov	= (void*)&vector[j];
+		msgvec[j].msg_hdr.msg_iovlen	= 1;
+	}
+#	ifdef PGM_HAVE_TOS_CMSG
+	if (tos >= 0) {
+		char* aux = pgm_newa (char, count * CMSG_SPACE(sizeof(int)));
+		for (unsigned j = 0; j < count; j++)
+			sendto_tos_cmsg (&msgvec[j].msg_hdr, aux + (j * CMSG_SPACE(sizeof(int))), sock->family, tos);
+	}
+#	endif
+	while (i < count) {
+		const int sent = sendmmsg (send_sock, &msgvec[i], count - i, 0);
+		pgm_debug ("sendmmsg returned %d", sent);
+		if (sent > 0) {
+			i += sent;
+			continue;
+		}
+/* first remaining packet failed */
+		if (sendto_on_error (send_sock, vector[i].iov_base, vector[i].iov_len, to[i], pgm_sockaddr_len (to[i])) < 0 &&
+		    PGM_SOCK_EAGAIN == pgm_get_last_sock_error())
+			break;
+		i++;
+	}
+#else
+	for (; i < count; i++) {
+		const socklen_t tolen = pgm_sockaddr_len (to[i]);
+		const ssize_t sent = sendto_tos (send_sock, sock->family, vector[i].iov_base, vector[i].iov_len, to[i], tolen, tos);
+		if (sent < 0 &&
+		    sendto_on_error (send_sock, vector[i].iov_base, vector[i].iov_len, to[i], tolen) < 0 &&
+		    PGM_SOCK_EAGAIN == pgm_get_last_sock_error())
+			break;
+	}
+#endif /* HAVE_SENDMMSG */
+
+	if (!use_router_alert && sock->can_send_data)
+		pgm_sock_mutex_unlock (sock, &sock->send_mutex);
+	if (0 == i) {
+		pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+		return -1;
+	}
+	return (int)i;
 }
 
 /* socket helper, for setting pipe ends non-blocking
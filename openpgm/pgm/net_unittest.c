@@ -50,6 +50,10 @@ int mock_select (int, fd_set*, fd_set*, fd_set*, struct timeval*);
 
 
 #define pgm_rate_check		mock_pgm_rate_check
+#define pgm_xdp_sendv		mock_pgm_xdp_sendv
+#define pgm_shm_write		mock_pgm_shm_write
+#define pgm_loop_sendto		mock_pgm_loop_sendto
+#define pgm_uring_sendv		mock_pgm_uring_sendv
 #define sendto			mock_sendto
 #define poll			mock_poll
 #define select			mock_select
@@ -173,6 +177,61 @@ mock_pgm_rate_check (
 	return TRUE;
 }
 
+/** xdp module */
+PGM_GNUC_INTERNAL
+int
+mock_pgm_xdp_sendv (
+	pgm_sock_t*		sock,
+	const bool		use_router_alert,
+	const int		hops,
+	const struct pgm_iovec*	vector,
+	const unsigned		count,
+	const struct sockaddr*	to
+	)
+{
+	return count;
+}
+
+/** shm module */
+PGM_GNUC_INTERNAL
+void
+mock_pgm_shm_write (
+	pgm_sock_t*		sock,
+	const void*		buf,
+	const size_t		len,
+	const struct sockaddr*	to
+	)
+{
+}
+
+/** loop module */
+PGM_GNUC_INTERNAL
+ssize_t
+mock_pgm_loop_sendto (
+	pgm_sock_t*		sock,
+	const void*		buf,
+	const size_t		len,
+	const struct sockaddr*	to
+	)
+{
+	return len;
+}
+
+/** uring module */
+PGM_GNUC_INTERNAL
+int
+mock_pgm_uring_sendv (
+	pgm_sock_t*			sock,
+	const bool			use_router_alert,
+	struct pgm_sk_buff_t*const*	skbs,
+	const unsigned			count,
+	const struct sockaddr*		to,
+	const socklen_t			tolen
+	)
+{
+	return count;
+}
+
 #ifndef _WIN32
 ssize_t
 mock_sendto (
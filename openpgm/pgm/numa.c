@@ -0,0 +1,132 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * NUMA topology of interfaces and processor placement through sysfs,
+ * without a dependency on libnuma.
+ *
+ * Copyright (c) 2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#ifndef _GNU_SOURCE
+#	define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#ifdef __linux__
+#	include <limits.h>
+#	include <sched.h>
+#	include <unistd.h>
+#	include <net/if.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+
+
+//#define NUMA_DEBUG
+
+/* returns the node of the device behind the interface index, or -1 if the
+ * interface has no device, such as loopback, or the platform has one node.
+ */
+
+PGM_GNUC_INTERNAL
+int
+pgm_numa_node_of_interface (
+	unsigned	ifindex
+	)
+{
+#ifdef __linux__
+	char ifname[IF_NAMESIZE];
+	char path[PATH_MAX];
+	int node = -1;
+	FILE* fp;
+
+	if (0 == ifindex || NULL == pgm_if_indextoname (ifindex, ifname))
+		return -1;
+	pgm_snprintf_s (path, sizeof (path), _TRUNCATE, "/sys/class/net/%s/device/numa_node", ifname);
+	fp = fopen (path, "r");
+	if (NULL == fp)
+		return -1;
+	if (1 != fscanf (fp, "%d", &node))
+		node = -1;
+	fclose (fp);
+	return node;
+#else
+	(void)ifindex;
+	return -1;
+#endif
+}
+
+/* restrict the calling thread to the processors of node as listed by sysfs
+ * in cpulist format, e.g. "0-7,16-23".
+ *
+ * returns TRUE on success, FALSE if the node is unknown or affinity cannot be
+ * set.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_numa_bind_thread (
+	int		node
+	)
+{
+/* pre-conditions */
+	pgm_assert (node >= 0);
+
+#if defined( __linux__ ) && defined( CPU_SETSIZE )
+	char path[PATH_MAX];
+	cpu_set_t cpu_set;
+	unsigned first, last;
+	int c, cpus = 0;
+	FILE* fp;
+
+	pgm_snprintf_s (path, sizeof (path), _TRUNCATE, "/sys/devices/system/node/node%d/cpulist", node);
+	fp = fopen (path, "r");
+	if (NULL == fp)
+		return FALSE;
+	CPU_ZERO (&cpu_set);
+	while (1 == fscanf (fp, "%u", &first)) {
+		last = first;
+		c = fgetc (fp);
+		if ('-' == c) {
+			if (1 != fscanf (fp, "%u", &last))
+				break;
+			c = fgetc (fp);
+		}
+		for (unsigned cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++, cpus++)
+			CPU_SET (cpu, &cpu_set);
+		if (',' != c)
+			break;
+	}
+	fclose (fp);
+	if (0 == cpus)
+		return FALSE;
+	if (0 != sched_setaffinity (0, sizeof (cpu_set), &cpu_set)) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Failed to bind thread to NUMA node %d: %s"),
+			   node, strerror (errno));
+		return FALSE;
+	}
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+/* eof */
@@ -36,7 +36,79 @@
 
 /* locals */
 
-static bool pgm_parse (struct pgm_sk_buff_t*const restrict, pgm_error_t**restrict);
+static bool pgm_parse (struct pgm_sk_buff_t*const restrict, const bool, pgm_parse_error_t*restrict);
+static void pgm_parse_odata (struct pgm_sk_buff_t*const);
+static int pgm_parse_crc32c (struct pgm_sk_buff_t*const restrict, pgm_parse_error_t*restrict);
+
+
+/* record why a packet is discarded, without formatting.
+ */
+
+static inline
+void
+parse_set_error (
+	pgm_parse_error_t*  restrict error,
+	const int		     code,
+	const char*	    restrict format,
+	const unsigned long	     arg0,
+	const unsigned long	     arg1
+	)
+{
+	if (NULL == error)
+		return;
+	error->code	= code;
+	error->format	= format;
+	error->arg[ 0 ]	= arg0;
+	error->arg[ 1 ]	= arg1;
+}
+
+/* format the reason a packet was discarded into buf.
+ *
+ * returns buf.
+ */
+
+PGM_GNUC_INTERNAL
+char*
+pgm_parse_strerror_s (
+	char*			 restrict buf,
+	size_t				  buflen,
+	const pgm_parse_error_t* restrict error
+	)
+{
+	pgm_assert (NULL != buf);
+	pgm_assert (buflen > 0);
+	pgm_assert (NULL != error);
+
+	if (NULL == error->format)
+		pgm_strncpy_s (buf, buflen, "(null)", _TRUNCATE);
+	else
+		pgm_snprintf_s (buf, buflen, _TRUNCATE, _(error->format), error->arg[ 0 ], error->arg[ 1 ]);
+	return buf;
+}
+
+/* convert the reason a packet was discarded into an error for callers that
+ * report to the application.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_parse_set_error (
+	pgm_error_t**		 restrict error,
+	const pgm_parse_error_t* restrict parse_error
+	)
+{
+	char errbuf[1024];
+
+	pgm_assert (NULL != parse_error);
+
+	if (NULL == error)
+		return;
+	pgm_set_error (error,
+		     PGM_ERROR_DOMAIN_PACKET,
+		     parse_error->code,
+		     "%s",
+		     pgm_parse_strerror_s (errbuf, sizeof (errbuf), parse_error));
+}
 
 
 /* Parse a raw-IP packet for IP and PGM header and any payload.
@@ -52,7 +124,7 @@ bool
 pgm_parse_raw (
 	struct pgm_sk_buff_t* const restrict skb,	/* data will be modified */
 	struct sockaddr*      const restrict dst,
-	pgm_error_t**		    restrict error
+	pgm_parse_error_t*		    restrict error
 	)
 {
 /* pre-conditions */
@@ -65,11 +137,10 @@ pgm_parse_raw (
 /* minimum size should be IPv4 header plus PGM header, check IP version later */
 	if (PGM_UNLIKELY(skb->len < PGM_MIN_SIZE))
 	{
-		pgm_set_error (error,
-			     PGM_ERROR_DOMAIN_PACKET,
-			     PGM_ERROR_BOUNDS,
-			     _("IP packet too small at %" PRIu16 " bytes, expecting at least %" PRIu16 " bytes."),
-			     skb->len, (uint16_t)PGM_MIN_SIZE);
+		parse_set_error (error,
+		                 PGM_ERROR_BOUNDS,
+		                 N_("IP packet too small at %lu bytes, expecting at least %lu bytes."),
+		                 skb->len, PGM_MIN_SIZE);
 		return FALSE;
 	}
 
@@ -130,28 +201,26 @@ pgm_parse_raw (
 	}
 
 	case 6:
-		pgm_set_error (error,
-			     PGM_ERROR_DOMAIN_PACKET,
-			     PGM_ERROR_AFNOSUPPORT,
-			     _("IPv6 is not supported for raw IP header parsing."));
+		parse_set_error (error,
+		                 PGM_ERROR_AFNOSUPPORT,
+		                 N_("IPv6 is not supported for raw IP header parsing."),
+		                 0, 0);
 		return FALSE;
 
 	default:
-		pgm_set_error (error,
-			     PGM_ERROR_DOMAIN_PACKET,
-			     PGM_ERROR_AFNOSUPPORT,
-			     _("IP header reports an invalid version %d."),
-			     ip->ip_v);
+		parse_set_error (error,
+		                 PGM_ERROR_AFNOSUPPORT,
+		                 N_("IP header reports an invalid version %lu."),
+		                 ip->ip_v, 0);
 		return FALSE;
 	}
 
 	const size_t ip_header_length = ip->ip_hl * 4;		/* IP header length in 32bit octets */
 	if (PGM_UNLIKELY(ip_header_length < sizeof(struct pgm_ip))) {
-		pgm_set_error (error,
-			     PGM_ERROR_DOMAIN_PACKET,
-			     PGM_ERROR_BOUNDS,
-			     _("IP header reports an invalid header length %" PRIzu " bytes."),
-			     ip_header_length);
+		parse_set_error (error,
+		                 PGM_ERROR_BOUNDS,
+		                 N_("IP header reports an invalid header length %lu bytes."),
+		                 ip_header_length, 0);
 		return FALSE;
 	}
 
@@ -172,11 +241,10 @@ pgm_parse_raw (
 	}
 
 	if (PGM_UNLIKELY(skb->len < packet_length)) {	/* redundant: often handled in kernel */
-		pgm_set_error (error,
-			     PGM_ERROR_DOMAIN_PACKET,
-			     PGM_ERROR_BOUNDS,
-			     _("IP packet received at %" PRIu16 " bytes whilst IP header reports %" PRIzu " bytes."),
-			     skb->len, packet_length);
+		parse_set_error (error,
+		                 PGM_ERROR_BOUNDS,
+		                 N_("IP packet received at %lu bytes whilst IP header reports %lu bytes."),
+		                 skb->len, packet_length);
 		return FALSE;
 	}
 
@@ -186,11 +254,10 @@ pgm_parse_raw (
 	const uint16_t sum = in_cksum (data, packet_length, 0);
 	if (PGM_UNLIKELY(0 != sum)) {
 		const uint16_t ip_sum = pgm_ntohs (ip->ip_sum);
-		pgm_set_error (error,
-			     PGM_ERROR_DOMAIN_PACKET,
-			     PGM_ERROR_CKSUM,
-			     _("IP packet checksum mismatch, reported 0x%x whilst calculated 0x%x."),
-			     ip_sum, sum);
+		parse_set_error (error,
+		                 PGM_ERROR_CKSUM,
+		                 N_("IP packet checksum mismatch, reported 0x%lx whilst calculated 0x%lx."),
+		                 ip_sum, sum);
 		return FALSE;
 	}
 #endif
@@ -202,11 +269,10 @@ pgm_parse_raw (
 	const uint16_t offset = ip->ip_off;
 #endif
 	if (PGM_UNLIKELY((offset & 0x1fff) != 0)) {
-		pgm_set_error (error,
-			     PGM_ERROR_DOMAIN_PACKET,
-			     PGM_ERROR_PROTO,
-			     _("IP header reports packet fragmentation, offset %u."),
-			     offset & 0x1fff);
+		parse_set_error (error,
+		                 PGM_ERROR_PROTO,
+		                 N_("IP header reports packet fragmentation, offset %lu."),
+		                 offset & 0x1fff, 0);
 		return FALSE;
 	}
 
@@ -232,68 +298,134 @@ pgm_parse_raw (
 /* advance DATA pointer to PGM packet */
 	skb->data	= skb->pgm_header;
 	skb->len       -= ip_header_length;
-	return pgm_parse (skb, error);
+	return pgm_parse (skb, FALSE, error);
 }
 
 PGM_GNUC_INTERNAL
 bool
 pgm_parse_udp_encap (
 	struct pgm_sk_buff_t*const restrict skb,		/* will be modified */
-	pgm_error_t**	      restrict error
+	const bool			    allow_zero_checksum,	/* UDP checksum covers data */
+	pgm_parse_error_t*	      restrict error
 	)
 {
 	pgm_assert (NULL != skb);
 
 	if (PGM_UNLIKELY(skb->len < sizeof(struct pgm_header))) {
-		pgm_set_error (error,
-			     PGM_ERROR_DOMAIN_PACKET,
-			     PGM_ERROR_BOUNDS,
-			     _("UDP payload too small for PGM packet at %" PRIu16 " bytes, expecting at least %" PRIzu " bytes."),
-			     skb->len, sizeof(struct pgm_header));
+		parse_set_error (error,
+		                 PGM_ERROR_BOUNDS,
+		                 N_("UDP payload too small for PGM packet at %lu bytes, expecting at least %lu bytes."),
+		                 skb->len, sizeof(struct pgm_header));
 		return FALSE;
 	}
 
 /* DATA payload is PGM packet, no headers */
 	skb->pgm_header = skb->data;
-	return pgm_parse (skb, error);
+	return pgm_parse (skb, allow_zero_checksum, error);
 }
 
-/* will modify packet contents to calculate and check PGM checksum
+/* verify the PGM checksums of a batch of received datagrams ahead of parsing,
+ * prefetching the next datagram whilst summing the current such that the
+ * memory latency of one overlaps the arithmetic of the other.  datagrams
+ * that pass are marked for pgm_parse() to skip the check, anything else
+ * including a mismatch or malformed header is left to pgm_parse() to report
+ * and count individually.
+ *
+ * skb::data and skb::len describe each datagram, with_ip_header for raw IPv4
+ * sockets.  packet contents are modified and restored as pgm_parse().
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_parse_csum_batch (
+	struct pgm_sk_buff_t*const*const skbs,
+	const unsigned			 count,
+	const bool			 with_ip_header
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != skbs);
+
+	if (count > 0)
+		pgm_prefetchw (skbs[ 0 ]->data);
+	for (unsigned i = 0; i < count; i++)
+	{
+		struct pgm_sk_buff_t* skb = skbs[ i ];
+		if (i + 1 < count)
+			pgm_prefetchw (skbs[ i + 1 ]->data);
+
+		skb->csum_verified = 0;
+		struct pgm_header* header = skb->data;
+		size_t len = skb->len;
+		if (with_ip_header) {
+			if (PGM_UNLIKELY(len < PGM_MIN_SIZE))
+				continue;
+			const size_t ip_header_length = ((const struct pgm_ip*)skb->data)->ip_hl * 4;
+			if (PGM_UNLIKELY(ip_header_length < sizeof(struct pgm_ip) ||
+					 len < ip_header_length + sizeof(struct pgm_header)))
+				continue;
+			header = (void*)( (char*)skb->data + ip_header_length );
+			len   -= ip_header_length;
+		} else if (PGM_UNLIKELY(len < sizeof(struct pgm_header)))
+			continue;
+
+		const uint16_t sum = header->pgm_checksum;
+		if (0 == sum)
+			continue;
+		header->pgm_checksum = 0;
+		const uint16_t pgm_sum = pgm_csum_fold (pgm_csum_partial ((const char*)header, len, 0));
+		header->pgm_checksum = sum;
+		skb->csum_verified = (pgm_sum == sum);
+	}
+}
+
+/* will modify packet contents to calculate and check PGM checksum, data packets
+ * without a checksum are only accepted with allow_zero_checksum.
  */
 static
 bool
 pgm_parse (
 	struct pgm_sk_buff_t*const restrict skb,		/* will be modified to calculate checksum */
-	pgm_error_t**		    restrict error
+	const bool			    allow_zero_checksum,
+	pgm_parse_error_t*		    restrict error
 	)
 {
 /* pre-conditions */
 	pgm_assert (NULL != skb);
 
 /* pgm_checksum == 0 means no transmitted checksum */
-	if (skb->pgm_header->pgm_checksum)
+	skb->crc32c = 0;
+	if (skb->csum_verified)
+	{
+		skb->csum_verified = 0;
+	}
+	else if (skb->pgm_header->pgm_checksum)
 	{
 		const uint16_t sum = skb->pgm_header->pgm_checksum;
 		skb->pgm_header->pgm_checksum = 0;
 		const uint16_t pgm_sum = pgm_csum_fold (pgm_csum_partial ((const char*)skb->pgm_header, skb->len, 0));
 		skb->pgm_header->pgm_checksum = sum;
 		if (PGM_UNLIKELY(pgm_sum != sum)) {
-			pgm_set_error (error,
-				     PGM_ERROR_DOMAIN_PACKET,
-				     PGM_ERROR_CKSUM,
-			     	     _("PGM packet checksum mismatch, reported 0x%x whilst calculated 0x%x."),
-			     	     pgm_sum, sum);
+			parse_set_error (error,
+			                 PGM_ERROR_CKSUM,
+			                 N_("PGM packet checksum mismatch, reported 0x%lx whilst calculated 0x%lx."),
+			                 pgm_sum, sum);
 			return FALSE;
 		}
 	} else {
-		if (PGM_ODATA == skb->pgm_header->pgm_type ||
-		    PGM_RDATA == skb->pgm_header->pgm_type)
+		const int crc32c = pgm_parse_crc32c (skb, error);
+		if (PGM_UNLIKELY(crc32c < 0))
+			return FALSE;
+		if (!crc32c && !allow_zero_checksum &&
+		    (PGM_ODATA == skb->pgm_header->pgm_type ||
+		     PGM_RDATA == skb->pgm_header->pgm_type))
 		{
-			pgm_set_error (error,
-				     PGM_ERROR_DOMAIN_PACKET,
-				     PGM_ERROR_PROTO,
-			     	     _("PGM checksum missing whilst mandatory for %cDATA packets."),
-				     PGM_ODATA == skb->pgm_header->pgm_type ? 'O' : 'R');
+			parse_set_error (error,
+			                 PGM_ERROR_PROTO,
+			                 PGM_ODATA == skb->pgm_header->pgm_type ?
+			                 	N_("PGM checksum missing whilst mandatory for ODATA packets.") :
+			                 	N_("PGM checksum missing whilst mandatory for RDATA packets."),
+			                 0, 0);
 			return FALSE;
 		}
 		pgm_debug ("No PGM checksum :O");
@@ -302,9 +434,133 @@ pgm_parse (
 /* copy packets source transport identifier */
 	memcpy (&skb->tsi.gsi, skb->pgm_header->pgm_gsi, sizeof(pgm_gsi_t));
 	skb->tsi.sport = skb->pgm_header->pgm_sport;
+
+	skb->preparsed = 0;
+	if (PGM_ODATA == skb->pgm_header->pgm_type)
+		pgm_parse_odata (skb);
 	return TRUE;
 }
 
+/* data packets without a PGM checksum may carry a CRC32C trailer following
+ * the TSDU, detected by the packet being exactly four octets longer than the
+ * header, options, and TSDU declare.  the CRC covers the TSDU followed by the
+ * header and options with a zero checksum field.
+ *
+ * returns 1 with the trailer verified and removed, 0 when absent, or -1 on
+ * mismatch.
+ */
+static
+int
+pgm_parse_crc32c (
+	struct pgm_sk_buff_t*const restrict skb,
+	pgm_parse_error_t*		   restrict error
+	)
+{
+	const struct pgm_header* header = skb->pgm_header;
+	size_t header_length = sizeof(struct pgm_header) + sizeof(struct pgm_data);
+
+	if (PGM_ODATA != header->pgm_type && PGM_RDATA != header->pgm_type)
+		return 0;
+	if (PGM_UNLIKELY(skb->len < header_length + sizeof(uint32_t)))
+		return 0;
+	if (header->pgm_options & PGM_OPT_PRESENT)
+	{
+		const struct pgm_opt_length* opt_len = (const struct pgm_opt_length*)((const char*)header + header_length);
+		if (PGM_UNLIKELY(skb->len < header_length + sizeof(struct pgm_opt_length) ||
+				 PGM_OPT_LENGTH != opt_len->opt_type))
+			return 0;
+		header_length += pgm_ntohs (opt_len->opt_total_length);
+	}
+
+	const uint16_t tsdu_length = pgm_ntohs (header->pgm_tsdu_length);
+	if (skb->len != header_length + tsdu_length + sizeof(uint32_t))
+		return 0;
+
+	const char* tsdu = (const char*)header + header_length;
+	uint32_t trailer;
+	memcpy (&trailer, tsdu + tsdu_length, sizeof(trailer));
+	trailer = pgm_ntohl (trailer);
+	const uint32_t crc = pgm_crc32c (pgm_crc32c (0, tsdu, tsdu_length), header, header_length);
+	if (PGM_UNLIKELY(crc != trailer)) {
+		parse_set_error (error,
+		                 PGM_ERROR_CKSUM,
+		                 N_("PGM packet CRC32C mismatch, reported 0x%lx whilst calculated 0x%lx."),
+		                 trailer, crc);
+		return -1;
+	}
+
+	skb->len   -= sizeof(uint32_t);
+	skb->tail   = (char*)skb->tail - sizeof(uint32_t);
+	skb->crc32c = 1;
+	return 1;
+}
+
+/* fast path for the dominant packet, original data without options or with
+ * a single OPT_FRAGMENT.  performs the protocol sanity checks of pgm_on_data()
+ * and pgm_rxw_add() and extracts the data header, fragment option and sequence
+ * such that both skip their own option walk.  anything else is left for the
+ * full receive path.
+ */
+static
+void
+pgm_parse_odata (
+	struct pgm_sk_buff_t* const	skb
+	)
+{
+	const struct pgm_header* header = skb->pgm_header;
+	struct pgm_data* data = (struct pgm_data*)(header + 1);
+	size_t opt_total_length = 0;
+	struct pgm_opt_fragment* opt_fragment = NULL;
+
+	if (PGM_UNLIKELY(skb->len < sizeof(struct pgm_header) + sizeof(struct pgm_data)))
+		return;
+	if (header->pgm_options & PGM_OPT_PRESENT)
+	{
+		const struct pgm_opt_length* opt_len = (const struct pgm_opt_length*)(data + 1);
+		const struct pgm_opt_header* opt_header = (const struct pgm_opt_header*)(opt_len + 1);
+		opt_total_length = sizeof(struct pgm_opt_length) + sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_fragment);
+		if (PGM_UNLIKELY(PGM_OPT_PRESENT != header->pgm_options ||
+				 skb->len < sizeof(struct pgm_header) + sizeof(struct pgm_data) + opt_total_length ||
+				 PGM_OPT_LENGTH != opt_len->opt_type ||
+				 sizeof(struct pgm_opt_length) != opt_len->opt_length ||
+				 opt_total_length != pgm_ntohs (opt_len->opt_total_length) ||
+				 (PGM_OPT_FRAGMENT | PGM_OPT_END) != opt_header->opt_type ||
+				 sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_fragment) != opt_header->opt_length))
+			return;
+		opt_fragment = (struct pgm_opt_fragment*)(opt_header + 1);
+	}
+	else if (PGM_UNLIKELY(0 != header->pgm_options))
+		return;
+
+	const uint16_t tsdu_length = pgm_ntohs (header->pgm_tsdu_length);
+	const uint32_t sequence = pgm_ntohl (data->data_sqn);
+	if (PGM_UNLIKELY(skb->len != sizeof(struct pgm_header) + sizeof(struct pgm_data) + opt_total_length + tsdu_length))
+		return;
+	if (PGM_UNLIKELY(sequence - pgm_ntohl (data->data_trail) >= ((UINT32_MAX/2)-1)))
+		return;
+	if (NULL != opt_fragment)
+	{
+		const uint32_t apdu_length = pgm_ntohl (opt_fragment->opt_frag_len);
+		if (PGM_UNLIKELY(apdu_length < tsdu_length ||
+				 apdu_length > PGM_MAX_APDU ||
+				 pgm_uint32_gt (pgm_ntohl (opt_fragment->opt_sqn), sequence)))
+			return;
+/* single fragment APDU */
+		if (apdu_length == tsdu_length)
+			opt_fragment = NULL;
+	}
+
+	skb->pgm_data		= data;
+	skb->pgm_opt_fragment	= opt_fragment;
+	skb->pgm_opt_pgmcc_data	= NULL;
+	skb->coalesced		= 0;
+	skb->compressed		= 0;
+	skb->unreliable		= 0;
+	skb->send_tstamp	= 0;
+	skb->sequence		= sequence;
+	skb->preparsed		= 1;
+}
+
 /* 8.1.  Source Path Messages (SPM)
  *
  *  0                   1                   2                   3
@@ -342,10 +598,12 @@ pgm_verify_spm (
 	const struct pgm_spm* spm = (const struct pgm_spm*)skb->data;
 	switch (pgm_ntohs (spm->spm_nla_afi)) {
 /* truncated packet */
+#ifndef PGM_DISABLE_IPV6
 	case AFI_IP6:
 		if (PGM_UNLIKELY(skb->len < sizeof(struct pgm_spm6)))
 			return FALSE;
 		break;
+#endif
 	case AFI_IP:
 		if (PGM_UNLIKELY(skb->len < sizeof(struct pgm_spm)))
 			return FALSE;
@@ -397,10 +655,12 @@ pgm_verify_poll (
 	const struct pgm_poll* poll4 = (const struct pgm_poll*)skb->data;
 	switch (pgm_ntohs (poll4->poll_nla_afi)) {
 /* truncated packet */
+#ifndef PGM_DISABLE_IPV6
 	case AFI_IP6:
 		if (PGM_UNLIKELY(skb->len < sizeof(struct pgm_poll6)))
 			return FALSE;
 		break;
+#endif
 	case AFI_IP:
 		if (PGM_UNLIKELY(skb->len < sizeof(struct pgm_poll)))
 			return FALSE;
@@ -509,9 +769,11 @@ pgm_verify_nak (
 		nak_grp_nla_afi = pgm_ntohs (nak->nak_grp_nla_afi);
 		break;
 
+#ifndef PGM_DISABLE_IPV6
 	case AFI_IP6:
 		nak_grp_nla_afi = pgm_ntohs (((const struct pgm_nak6*)nak)->nak6_grp_nla_afi);
 		break;
+#endif
 
 	default:
 		return FALSE;
@@ -519,6 +781,7 @@ pgm_verify_nak (
 
 /* check multicast group NLA */
 	switch (nak_grp_nla_afi) {
+#ifndef PGM_DISABLE_IPV6
 	case AFI_IP6:
 		switch (nak_src_nla_afi) {
 /* IPv4 + IPv6 NLA */
@@ -533,6 +796,7 @@ pgm_verify_nak (
 				return FALSE;
 			break;
 		}
+#endif
 
 	case AFI_IP:
 		break;
@@ -159,6 +159,67 @@ generate_udp_encap_pgm (void)
 	return skb;
 }
 
+/* ODATA carrying the first fragment of a larger APDU */
+static
+struct pgm_sk_buff_t*
+generate_udp_encap_fragment (void)
+{
+	const char source[] = "i am not a string";
+	const guint source_len = sizeof(source);
+	const guint opt_total_length = sizeof(struct pgm_opt_length) + sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_fragment);
+	struct pgm_sk_buff_t* skb;
+
+	skb = pgm_alloc_skb (1500);
+	skb->sock		= (pgm_sock_t*)0x1;
+	skb->tstamp		= 0x1;
+	skb->data		= skb->head;
+	skb->len		= sizeof(struct pgm_header) + sizeof(struct pgm_data) + opt_total_length + source_len;
+	skb->tail		= (guint8*)skb->data + skb->len;
+
+/* add PGM header */
+	struct pgm_header* pgmhdr = skb->head;
+	pgmhdr->pgm_sport	= g_htons ((guint16)1000);
+	pgmhdr->pgm_dport	= g_htons ((guint16)7500);
+	pgmhdr->pgm_type	= PGM_ODATA;
+	pgmhdr->pgm_options	= PGM_OPT_PRESENT;
+	pgmhdr->pgm_gsi[0]	= 1;
+	pgmhdr->pgm_gsi[1]	= 2;
+	pgmhdr->pgm_gsi[2]	= 3;
+	pgmhdr->pgm_gsi[3]	= 4;
+	pgmhdr->pgm_gsi[4]	= 5;
+	pgmhdr->pgm_gsi[5]	= 6;
+	pgmhdr->pgm_tsdu_length = g_htons (source_len);
+
+/* add ODATA header */
+	struct pgm_data* datahdr = (gpointer)(pgmhdr + 1);
+	datahdr->data_sqn	= g_htonl ((guint32)0);
+	datahdr->data_trail	= g_htonl ((guint32)-1);
+
+/* add OPT_LENGTH and OPT_FRAGMENT */
+	struct pgm_opt_length* opt_len = (gpointer)(datahdr + 1);
+	opt_len->opt_type	= PGM_OPT_LENGTH;
+	opt_len->opt_length	= sizeof(struct pgm_opt_length);
+	opt_len->opt_total_length = g_htons (opt_total_length);
+	struct pgm_opt_header* opt_header = (gpointer)(opt_len + 1);
+	opt_header->opt_type	= PGM_OPT_FRAGMENT | PGM_OPT_END;
+	opt_header->opt_length	= sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_fragment);
+	struct pgm_opt_fragment* opt_fragment = (gpointer)(opt_header + 1);
+	opt_fragment->opt_reserved = 0;
+	opt_fragment->opt_sqn	= g_htonl ((guint32)0);
+	opt_fragment->opt_frag_off = g_htonl ((guint32)0);
+	opt_fragment->opt_frag_len = g_htonl ((guint32)(2 * source_len));
+
+/* add payload */
+	gpointer data = (gpointer)(opt_fragment + 1);
+	memcpy (data, source, source_len);
+
+/* finally PGM checksum */
+	pgmhdr->pgm_checksum 	= 0;
+	pgmhdr->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (pgmhdr, skb->len, 0));
+
+	return skb;
+}
+
 /* mock functions for external references */
 
 size_t
@@ -182,18 +243,19 @@ pgm_get_nprocs (void)
  *	pgm_parse_raw (
  *		struct pgm_sk_buff_t* const	skb,
  *		struct sockaddr* const		addr,
- *		pgm_error_t**			error
+ *		pgm_parse_error_t*		error
  *	)
  */
 
 START_TEST (test_parse_raw_pass_001)
 {
 	struct sockaddr_storage addr;
-	pgm_error_t* err = NULL;
+	pgm_parse_error_t err = PGM_PARSE_ERROR_INIT;
 	struct pgm_sk_buff_t* skb = generate_raw_pgm ();
 	gboolean success = pgm_parse_raw (skb, (struct sockaddr*)&addr, &err);
-	if (!success && err) {
-		g_error ("Parsing raw packet: %s", err->message);
+	if (!success) {
+		char errbuf[1024];
+		g_error ("Parsing raw packet: %s", pgm_parse_strerror_s (errbuf, sizeof (errbuf), &err));
 	}
 	fail_unless (TRUE == success, "parse_raw failed");
 	char saddr[INET6_ADDRSTRLEN];
@@ -205,7 +267,7 @@ END_TEST
 START_TEST (test_parse_raw_fail_001)
 {
 	struct sockaddr_storage addr;
-	pgm_error_t* err = NULL;
+	pgm_parse_error_t err = PGM_PARSE_ERROR_INIT;
 	pgm_parse_raw (NULL, (struct sockaddr*)&addr, &err);
 	fail ("reached");
 }
@@ -215,26 +277,181 @@ END_TEST
  *	bool
  *	pgm_parse_udp_encap (
  *		struct pgm_sk_buff_t* const	skb,
- *		pgm_error_t**			error
+ *		const bool			allow_zero_checksum,
+ *		pgm_parse_error_t*		error
  *	)
  */
 
 START_TEST (test_parse_udp_encap_pass_001)
 {
-	pgm_error_t* err = NULL;
+	pgm_parse_error_t err = PGM_PARSE_ERROR_INIT;
+	struct pgm_sk_buff_t* skb = generate_udp_encap_pgm ();
+	gboolean success = pgm_parse_udp_encap (skb, FALSE, &err);
+	if (!success) {
+		char errbuf[1024];
+		g_error ("Parsing UDP encapsulated packet: %s", pgm_parse_strerror_s (errbuf, sizeof (errbuf), &err));
+	}
+	fail_unless (TRUE == success, "parse_udp_encap failed");
+}
+END_TEST
+
+/* ODATA without checksum */
+START_TEST (test_parse_udp_encap_pass_002)
+{
+	pgm_parse_error_t err = PGM_PARSE_ERROR_INIT;
 	struct pgm_sk_buff_t* skb = generate_udp_encap_pgm ();
-	gboolean success = pgm_parse_udp_encap (skb, &err);
-	if (!success && err) {
-		g_error ("Parsing UDP encapsulated packet: %s", err->message);
+	skb->pgm_header = skb->data;
+	skb->pgm_header->pgm_checksum = 0;
+	gboolean success = pgm_parse_udp_encap (skb, TRUE, &err);
+	if (!success) {
+		char errbuf[1024];
+		g_error ("Parsing UDP encapsulated packet: %s", pgm_parse_strerror_s (errbuf, sizeof (errbuf), &err));
 	}
 	fail_unless (TRUE == success, "parse_udp_encap failed");
 }
 END_TEST
 
+/* plain ODATA is pre-parsed */
+START_TEST (test_parse_udp_encap_pass_003)
+{
+	pgm_parse_error_t err = PGM_PARSE_ERROR_INIT;
+	struct pgm_sk_buff_t* skb = generate_udp_encap_pgm ();
+	gboolean success = pgm_parse_udp_encap (skb, FALSE, &err);
+	fail_unless (TRUE == success, "parse_udp_encap failed");
+	fail_unless (1 == skb->preparsed, "not pre-parsed");
+	fail_unless ((gpointer)(skb->pgm_header + 1) == (gpointer)skb->pgm_data, "pgm_data mismatch");
+	fail_unless (NULL == skb->pgm_opt_fragment, "unexpected fragment option");
+	fail_unless (0 == skb->sequence, "sequence mismatch");
+}
+END_TEST
+
+/* ODATA with OPT_FRAGMENT is pre-parsed */
+START_TEST (test_parse_udp_encap_pass_004)
+{
+	pgm_parse_error_t err = PGM_PARSE_ERROR_INIT;
+	struct pgm_sk_buff_t* skb = generate_udp_encap_fragment ();
+	gboolean success = pgm_parse_udp_encap (skb, FALSE, &err);
+	fail_unless (TRUE == success, "parse_udp_encap failed");
+	fail_unless (1 == skb->preparsed, "not pre-parsed");
+	fail_unless (NULL != skb->pgm_opt_fragment, "fragment option not extracted");
+	fail_unless (g_htonl (2 * sizeof("i am not a string")) == skb->of_apdu_len, "APDU length mismatch");
+}
+END_TEST
+
+/* inconsistent TSDU length is left for the full receive path */
+START_TEST (test_parse_udp_encap_pass_005)
+{
+	pgm_parse_error_t err = PGM_PARSE_ERROR_INIT;
+	struct pgm_sk_buff_t* skb = generate_udp_encap_pgm ();
+	skb->pgm_header = skb->data;
+	skb->pgm_header->pgm_tsdu_length = g_htons (1);
+	skb->pgm_header->pgm_checksum = 0;
+	gboolean success = pgm_parse_udp_encap (skb, TRUE, &err);
+	fail_unless (TRUE == success, "parse_udp_encap failed");
+	fail_unless (0 == skb->preparsed, "pre-parsed");
+}
+END_TEST
+
+/* CRC32C trailer replaces the PGM checksum, verified and removed */
+START_TEST (test_parse_udp_encap_pass_006)
+{
+	pgm_parse_error_t err = PGM_PARSE_ERROR_INIT;
+	struct pgm_sk_buff_t* skb = generate_udp_encap_pgm ();
+	struct pgm_header* pgmhdr = skb->data;
+	const gsize header_length = sizeof(struct pgm_header) + sizeof(struct pgm_data);
+	const guint16 tsdu_length = g_ntohs (pgmhdr->pgm_tsdu_length);
+	pgmhdr->pgm_checksum = 0;
+	const guint32 crc = g_htonl (pgm_crc32c (pgm_crc32c (0, (char*)pgmhdr + header_length, tsdu_length), pgmhdr, header_length));
+	memcpy (pgm_skb_put (skb, sizeof(crc)), &crc, sizeof(crc));
+	gboolean success = pgm_parse_udp_encap (skb, FALSE, &err);
+	fail_unless (TRUE == success, "parse_udp_encap failed");
+	fail_unless (1 == skb->crc32c, "trailer not verified");
+	fail_unless (header_length + tsdu_length == skb->len, "trailer not removed");
+}
+END_TEST
+
 START_TEST (test_parse_udp_encap_fail_001)
 {
-	pgm_error_t* err = NULL;
-	pgm_parse_udp_encap (NULL, &err);
+	pgm_parse_error_t err = PGM_PARSE_ERROR_INIT;
+	pgm_parse_udp_encap (NULL, FALSE, &err);
+	fail ("reached");
+}
+END_TEST
+
+/* ODATA without checksum, mandatory unless allowed */
+START_TEST (test_parse_udp_encap_fail_002)
+{
+	pgm_parse_error_t err = PGM_PARSE_ERROR_INIT;
+	struct pgm_sk_buff_t* skb = generate_udp_encap_pgm ();
+	skb->pgm_header = skb->data;
+	skb->pgm_header->pgm_checksum = 0;
+	gboolean success = pgm_parse_udp_encap (skb, FALSE, &err);
+	fail_unless (FALSE == success, "parse_udp_encap succeeded");
+	fail_unless (NULL != err.format, "error not set");
+}
+END_TEST
+
+/* CRC32C trailer mismatch */
+START_TEST (test_parse_udp_encap_fail_003)
+{
+	pgm_parse_error_t err = PGM_PARSE_ERROR_INIT;
+	struct pgm_sk_buff_t* skb = generate_udp_encap_pgm ();
+	skb->pgm_header = skb->data;
+	skb->pgm_header->pgm_checksum = 0;
+	const guint32 crc = 0;
+	memcpy (pgm_skb_put (skb, sizeof(crc)), &crc, sizeof(crc));
+	gboolean success = pgm_parse_udp_encap (skb, TRUE, &err);
+	fail_unless (FALSE == success, "parse_udp_encap succeeded");
+	fail_unless (NULL != err.format, "error not set");
+	fail_unless (PGM_ERROR_CKSUM == err.code, "error code mismatch");
+}
+END_TEST
+
+/* target:
+ *	void
+ *	pgm_parse_csum_batch (
+ *		struct pgm_sk_buff_t*const*const skbs,
+ *		const unsigned			 count,
+ *		const bool			 with_ip_header
+ *	)
+ */
+
+/* valid checksum is skipped by the parser, a mismatch is left to it */
+START_TEST (test_parse_csum_batch_pass_001)
+{
+	pgm_parse_error_t err = PGM_PARSE_ERROR_INIT;
+	struct pgm_sk_buff_t* skbs[3];
+	skbs[0] = generate_udp_encap_pgm ();
+	skbs[1] = generate_udp_encap_pgm ();
+	skbs[2] = generate_udp_encap_fragment ();
+	((struct pgm_header*)skbs[1]->data)->pgm_checksum ^= 0xffff;
+	pgm_parse_csum_batch (skbs, G_N_ELEMENTS(skbs), FALSE);
+	fail_unless (1 == skbs[0]->csum_verified, "checksum not verified");
+	fail_unless (0 == skbs[1]->csum_verified, "corrupt checksum verified");
+	fail_unless (1 == skbs[2]->csum_verified, "checksum not verified");
+	fail_unless (TRUE == pgm_parse_udp_encap (skbs[0], FALSE, &err), "parse_udp_encap failed");
+	fail_unless (0 == skbs[0]->csum_verified, "verification not consumed");
+	fail_unless (FALSE == pgm_parse_udp_encap (skbs[1], FALSE, &err), "parse_udp_encap succeeded");
+	fail_unless (NULL != err.format && PGM_ERROR_CKSUM == err.code, "checksum error not set");
+}
+END_TEST
+
+/* raw IP datagrams are checksummed past the IP header */
+START_TEST (test_parse_csum_batch_pass_002)
+{
+	struct pgm_sk_buff_t* skbs[2];
+	skbs[0] = generate_raw_pgm ();
+	skbs[1] = generate_raw_pgm ();
+	skbs[1]->len = sizeof(struct pgm_ip);
+	pgm_parse_csum_batch (skbs, G_N_ELEMENTS(skbs), TRUE);
+	fail_unless (1 == skbs[0]->csum_verified, "checksum not verified");
+	fail_unless (0 == skbs[1]->csum_verified, "truncated packet verified");
+}
+END_TEST
+
+START_TEST (test_parse_csum_batch_fail_001)
+{
+	pgm_parse_csum_batch (NULL, 1, FALSE);
 	fail ("reached");
 }
 END_TEST
@@ -353,10 +570,25 @@ make_test_suite (void)
 	TCase* tc_parse_udp_encap = tcase_create ("parse-udp-encap");
 	suite_add_tcase (s, tc_parse_udp_encap);
 	tcase_add_test (tc_parse_udp_encap, test_parse_udp_encap_pass_001);
+	tcase_add_test (tc_parse_udp_encap, test_parse_udp_encap_pass_002);
+	tcase_add_test (tc_parse_udp_encap, test_parse_udp_encap_pass_003);
+	tcase_add_test (tc_parse_udp_encap, test_parse_udp_encap_pass_004);
+	tcase_add_test (tc_parse_udp_encap, test_parse_udp_encap_pass_005);
+	tcase_add_test (tc_parse_udp_encap, test_parse_udp_encap_pass_006);
+	tcase_add_test (tc_parse_udp_encap, test_parse_udp_encap_fail_002);
+	tcase_add_test (tc_parse_udp_encap, test_parse_udp_encap_fail_003);
 #ifndef PGM_CHECK_NOFORK
 	tcase_add_test_raise_signal (tc_parse_udp_encap, test_parse_udp_encap_fail_001, SIGABRT);
 #endif
 
+	TCase* tc_parse_csum_batch = tcase_create ("parse-csum-batch");
+	suite_add_tcase (s, tc_parse_csum_batch);
+	tcase_add_test (tc_parse_csum_batch, test_parse_csum_batch_pass_001);
+	tcase_add_test (tc_parse_csum_batch, test_parse_csum_batch_pass_002);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_parse_csum_batch, test_parse_csum_batch_fail_001, SIGABRT);
+#endif
+
 	TCase* tc_verify_spm = tcase_create ("verify-spm");
 	suite_add_tcase (s, tc_verify_spm);
 	tcase_add_test (tc_verify_spm, test_verify_spm_pass_001);
@@ -0,0 +1,346 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * open-addressing TSI to peer table.
+ *
+ * Linear probing over a power-of-two array of 64-bit keys, growth allocates
+ * a table of twice the size and migrates whole probe clusters of the previous
+ * table on each following insert or remove, such that no single packet pays
+ * for rehashing every peer.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+#include <impl/framework.h>
+
+
+//#define PEER_TABLE_DEBUG
+
+static void peer_table_grow (pgm_peer_table_t*);
+static void peer_table_migrate (pgm_peer_table_t*, unsigned);
+static void peer_table_migrate_cluster (pgm_peer_table_t*, unsigned);
+
+
+/* MurmurHash3 64-bit finaliser, every key bit affects the low slot bits.  the
+ * per-table seed resists crafted GSIs colliding on purpose.
+ */
+
+static inline
+uint64_t
+peer_table_hash (
+	const pgm_peer_table_t*	table,
+	uint64_t		key
+	)
+{
+	key ^= table->seed;
+	key ^= key >> 33;
+	key *= UINT64_C(0xff51afd7ed558ccd);
+	key ^= key >> 33;
+	key *= UINT64_C(0xc4ceb9fe1a85ec53);
+	key ^= key >> 33;
+	return key;
+}
+
+/* returns slot of matching key, or the empty slot terminating its probe sequence.
+ */
+
+static inline
+unsigned
+peer_table_probe (
+	const pgm_peer_table_t*		    restrict table,
+	const struct pgm_peer_table_entry_t* restrict entries,
+	const unsigned				     mask,
+	const uint64_t				     key
+	)
+{
+	unsigned i = (unsigned)peer_table_hash (table, key) & mask;
+	while (NULL != entries[i].peer && key != entries[i].key)
+		i = (i + 1) & mask;
+	return i;
+}
+
+PGM_GNUC_INTERNAL
+pgm_peer_table_t*
+pgm_peer_table_new (
+	const uint64_t		seed
+	)
+{
+	pgm_peer_table_t* table = pgm_new0 (pgm_peer_table_t, 1);
+	table->seed    = seed;
+	table->mask    = PGM_PEER_TABLE_MIN_SIZE - 1;
+	table->entries = pgm_new0 (struct pgm_peer_table_entry_t, PGM_PEER_TABLE_MIN_SIZE);
+	return table;
+}
+
+/* references held by entries are released by the caller.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_peer_table_destroy (
+	pgm_peer_table_t*	table
+	)
+{
+	pgm_return_if_fail (NULL != table);
+
+	if (table->old_entries)
+		pgm_free (table->old_entries);
+	pgm_free (table->entries);
+	pgm_free (table);
+}
+
+PGM_GNUC_INTERNAL
+struct pgm_peer_t*
+pgm_peer_table_lookup (
+	const pgm_peer_table_t* restrict table,
+	const pgm_tsi_t*	restrict tsi
+	)
+{
+	pgm_return_val_if_fail (NULL != table, NULL);
+	pgm_return_val_if_fail (NULL != tsi, NULL);
+
+	const uint64_t key = pgm_peer_table_key (tsi);
+	unsigned i = peer_table_probe (table, table->entries, table->mask, key);
+	if (NULL != table->entries[i].peer)
+		return table->entries[i].peer;
+	if (NULL != table->old_entries) {
+		i = peer_table_probe (table, table->old_entries, table->old_mask, key);
+		return table->old_entries[i].peer;
+	}
+	return NULL;
+}
+
+/* replaces the peer of an existing TSI.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_peer_table_insert (
+	pgm_peer_table_t* restrict table,
+	const pgm_tsi_t*  restrict tsi,
+	struct pgm_peer_t* restrict peer
+	)
+{
+	pgm_return_if_fail (NULL != table);
+	pgm_return_if_fail (NULL != tsi);
+	pgm_return_if_fail (NULL != peer);
+
+	const uint64_t key = pgm_peer_table_key (tsi);
+	if (NULL != table->old_entries) {
+		const unsigned j = peer_table_probe (table, table->old_entries, table->old_mask, key);
+		if (NULL != table->old_entries[j].peer) {
+			table->old_entries[j].peer = peer;
+			if (key == table->mru_key)
+				table->mru_peer = NULL;
+			return;
+		}
+		peer_table_migrate (table, PGM_PEER_TABLE_MIGRATE);
+	}
+
+	unsigned i = peer_table_probe (table, table->entries, table->mask, key);
+	if (NULL != table->entries[i].peer) {
+		table->entries[i].peer = peer;
+		if (key == table->mru_key)
+			table->mru_peer = NULL;
+		return;
+	}
+
+/* grow at 3/4 load */
+	if (4 * (table->len + 1) > 3 * (table->mask + 1)) {
+		peer_table_grow (table);
+		i = peer_table_probe (table, table->entries, table->mask, key);
+	}
+	table->entries[i].key  = key;
+	table->entries[i].peer = peer;
+	table->len++;
+}
+
+/* backward shift deletion, no tombstones.
+ *
+ * returns TRUE if TSI was found and removed, returns FALSE otherwise.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_peer_table_remove (
+	pgm_peer_table_t* restrict table,
+	const pgm_tsi_t*  restrict tsi
+	)
+{
+	pgm_return_val_if_fail (NULL != table, FALSE);
+	pgm_return_val_if_fail (NULL != tsi, FALSE);
+
+	const uint64_t key = pgm_peer_table_key (tsi);
+	if (key == table->mru_key)
+		table->mru_peer = NULL;
+
+	if (NULL != table->old_entries) {
+		const unsigned j = peer_table_probe (table, table->old_entries, table->old_mask, key);
+		if (NULL != table->old_entries[j].peer) {
+/* the rest of the cluster moves on rather than shifting back behind the cursor */
+			table->old_entries[j].peer = NULL;
+			table->len--;
+			peer_table_migrate_cluster (table, (j + 1) & table->old_mask);
+			peer_table_migrate (table, PGM_PEER_TABLE_MIGRATE);
+			return TRUE;
+		}
+		peer_table_migrate (table, PGM_PEER_TABLE_MIGRATE);
+	}
+
+	struct pgm_peer_table_entry_t* entries = table->entries;
+	const unsigned mask = table->mask;
+	unsigned i = peer_table_probe (table, entries, mask, key);
+	if (NULL == entries[i].peer)
+		return FALSE;
+
+	for (unsigned j = (i + 1) & mask; NULL != entries[j].peer; j = (j + 1) & mask)
+	{
+		const unsigned home = (unsigned)peer_table_hash (table, entries[j].key) & mask;
+/* shift back unless home lies cyclically within (i, j] */
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			entries[i] = entries[j];
+			i = j;
+		}
+	}
+	entries[i].peer = NULL;
+	table->len--;
+	return TRUE;
+}
+
+/* size the table to hold count peers below 3/4 load without growing, moving
+ * existing entries at once, and touch the slots.
+ *
+ * returns bytes made resident.
+ */
+
+PGM_GNUC_INTERNAL
+size_t
+pgm_peer_table_reserve (
+	pgm_peer_table_t*	table,
+	const unsigned		count
+	)
+{
+	pgm_return_val_if_fail (NULL != table, 0);
+
+	if (NULL != table->old_entries)
+		peer_table_migrate (table, table->old_remaining);
+
+	unsigned size = table->mask + 1;
+	while (4 * (uint64_t)count > 3 * (uint64_t)size)
+		size *= 2;
+	if (size > table->mask + 1) {
+#ifdef PEER_TABLE_DEBUG
+		pgm_debug ("pgm_peer_table_reserve (table:%p count:%u size:%u)", (const void*)table, count, size);
+#endif
+		struct pgm_peer_table_entry_t* entries = pgm_new0 (struct pgm_peer_table_entry_t, size);
+		for (unsigned j = 0; j <= table->mask; j++) {
+			if (NULL == table->entries[j].peer)
+				continue;
+			const unsigned i = peer_table_probe (table, entries, size - 1, table->entries[j].key);
+			entries[i] = table->entries[j];
+		}
+		pgm_free (table->entries);
+		table->entries = entries;
+		table->mask    = size - 1;
+	}
+	return pgm_mem_prefault (table->entries, size * sizeof(struct pgm_peer_table_entry_t));
+}
+
+/* move a table at 3/4 load aside and start over at twice the size, draining
+ * any previous migration first.
+ */
+
+static
+void
+peer_table_grow (
+	pgm_peer_table_t*	table
+	)
+{
+	if (NULL != table->old_entries)
+		peer_table_migrate (table, table->old_remaining);
+
+	const unsigned size = 2 * (table->mask + 1);
+#ifdef PEER_TABLE_DEBUG
+	pgm_debug ("peer_table_grow (table:%p size:%u)", (const void*)table, size);
+#endif
+	table->old_entries = table->entries;
+	table->old_mask    = table->mask;
+	table->entries     = pgm_new0 (struct pgm_peer_table_entry_t, size);
+	table->mask	   = size - 1;
+
+/* start on an empty slot so that every cluster is met from its head */
+	unsigned cursor = 0;
+	while (NULL != table->old_entries[cursor].peer)
+		cursor++;
+	table->old_cursor    = cursor;
+	table->old_remaining = table->old_mask + 1;
+}
+
+/* move the cluster starting at slot of the previous table into the current
+ * table, clusters are moved whole to keep remaining probe sequences intact.
+ */
+
+static
+void
+peer_table_migrate_cluster (
+	pgm_peer_table_t*	table,
+	unsigned		slot
+	)
+{
+	struct pgm_peer_table_entry_t* old_entries = table->old_entries;
+	while (NULL != old_entries[slot].peer) {
+		const uint64_t key = old_entries[slot].key;
+		const unsigned i = peer_table_probe (table, table->entries, table->mask, key);
+		table->entries[i].key  = key;
+		table->entries[i].peer = old_entries[slot].peer;
+		old_entries[slot].peer = NULL;
+		slot = (slot + 1) & table->old_mask;
+	}
+}
+
+/* scan at least count slots of the previous table from the cursor, finishing
+ * the last cluster entered, and release the previous table once exhausted.
+ */
+
+static
+void
+peer_table_migrate (
+	pgm_peer_table_t*	table,
+	unsigned		count
+	)
+{
+	pgm_assert (NULL != table->old_entries);
+
+	while (table->old_remaining > 0 &&
+	       (count > 0 || NULL != table->old_entries[table->old_cursor].peer))
+	{
+		peer_table_migrate_cluster (table, table->old_cursor);
+		table->old_cursor = (table->old_cursor + 1) & table->old_mask;
+		table->old_remaining--;
+		if (count > 0)
+			count--;
+	}
+
+	if (0 == table->old_remaining) {
+		pgm_free (table->old_entries);
+		table->old_entries = NULL;
+	}
+}
+
+/* eof */
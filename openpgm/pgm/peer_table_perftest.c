@@ -0,0 +1,367 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * performance tests for peer table.
+ *
+ * Copyright (c) 2010-2016 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <glib.h>
+#include <check.h>
+
+
+/* mock state */
+
+#define PERF_ITERATIONS		1000000
+
+static unsigned perf_peers	= 0;
+
+static
+void
+mock_setup_16 (void)
+{
+	perf_peers	= 16;
+}
+
+static
+void
+mock_setup_1k (void)
+{
+	perf_peers	= 1000;
+}
+
+static
+void
+mock_setup_64k (void)
+{
+	perf_peers	= 65536;
+}
+
+/* mock functions for external references */
+
+size_t
+pgm_transport_pkt_offset2 (
+        const bool                      can_fragment,
+        const bool                      use_pgmcc
+        )
+{
+        return 0;
+}
+
+#define PEER_TABLE_DEBUG
+#include "peer_table.c"
+
+PGM_GNUC_INTERNAL
+int
+pgm_get_nprocs (void)
+{
+	return 1;
+}
+
+static
+void
+mock_setup (void)
+{
+	g_assert (pgm_time_init (NULL));
+}
+
+static
+void
+mock_teardown (void)
+{
+	g_assert (pgm_time_shutdown ());
+}
+
+static
+void
+perf_report (
+	const char*		name,
+	const pgm_time_t	elapsed,		/* μs */
+	const guint64		count
+	)
+{
+	g_message ("%s/%u: elapsed time %" PGM_TIME_FORMAT " us, unit time %" PGM_TIME_FORMAT " ns, %" PGM_TIME_FORMAT " packets/s",
+		name, perf_peers,
+		(guint64)elapsed,
+		(guint64)((1000 * elapsed) / count),
+		(guint64)(elapsed ? (1000000 * count) / elapsed : 0));
+}
+
+static
+void
+make_tsi (
+	pgm_tsi_t*	tsi,
+	unsigned	i
+	)
+{
+	memset (tsi, 0, sizeof (pgm_tsi_t));
+	tsi->gsi.identifier[0] = i & 0xff;
+	tsi->gsi.identifier[1] = (i >> 8) & 0xff;
+	tsi->gsi.identifier[2] = (i >> 16) & 0xff;
+	tsi->sport = g_htons (1000 + (i % 7));
+}
+
+static
+struct pgm_peer_t*
+make_peer (
+	unsigned	i
+	)
+{
+	return (struct pgm_peer_t*)(uintptr_t)(i + 1);
+}
+
+/* TSIs precomputed so only the table is timed.
+ */
+static
+pgm_tsi_t*
+generate_tsis (
+	const unsigned	count
+	)
+{
+	pgm_tsi_t* tsis = g_malloc0 (count * sizeof(pgm_tsi_t));
+	for (unsigned i = 0; i < count; i++)
+		make_tsi (&tsis[i], i);
+	return tsis;
+}
+
+static
+pgm_peer_table_t*
+generate_table (
+	const pgm_tsi_t*	tsis
+	)
+{
+	pgm_peer_table_t* table = pgm_peer_table_new (0x0123456789abcdefULL);
+	fail_if (NULL == table, "new failed");
+	for (unsigned i = 0; i < perf_peers; i++)
+		pgm_peer_table_insert (table, &tsis[i], make_peer (i));
+	return table;
+}
+
+/* target:
+ *	void
+ *	pgm_peer_table_insert (
+ *		pgm_peer_table_t*	table,
+ *		const pgm_tsi_t*	tsi,
+ *		struct pgm_peer_t*	peer
+ *	)
+ *
+ * tables are built from empty so the cost includes incremental growth.
+ */
+
+START_TEST (test_insert)
+{
+	pgm_tsi_t* tsis = generate_tsis (perf_peers);
+	const unsigned rounds = (PERF_ITERATIONS + perf_peers - 1) / perf_peers;
+	pgm_time_t elapsed = 0;
+
+	for (unsigned r = 0; r < rounds; r++) {
+		pgm_peer_table_t* table = pgm_peer_table_new (0x0123456789abcdefULL);
+		const pgm_time_t start = pgm_time_update_now();
+		for (unsigned i = 0; i < perf_peers; i++)
+			pgm_peer_table_insert (table, &tsis[i], make_peer (i));
+		elapsed += pgm_time_update_now() - start;
+		pgm_peer_table_destroy (table);
+	}
+	perf_report ("insert", elapsed, (guint64)rounds * perf_peers);
+	g_free (tsis);
+}
+END_TEST
+
+/* target:
+ *	struct pgm_peer_t*
+ *	pgm_peer_table_lookup (
+ *		const pgm_peer_table_t*	table,
+ *		const pgm_tsi_t*	tsi
+ *	)
+ *
+ * packets from many sources interleaved, each lookup a different peer.
+ */
+
+START_TEST (test_lookup)
+{
+	pgm_tsi_t* tsis = generate_tsis (perf_peers);
+	pgm_peer_table_t* table = generate_table (tsis);
+	pgm_time_t start, check;
+	unsigned found = 0;
+
+	start = pgm_time_update_now();
+	for (unsigned i = 0; i < PERF_ITERATIONS; i++)
+		if (NULL != pgm_peer_table_lookup (table, &tsis[ (i * 7919) % perf_peers ]))
+			found++;
+	check = pgm_time_update_now();
+	fail_unless (PERF_ITERATIONS == found, "lookup failed");
+	perf_report ("lookup", check - start, PERF_ITERATIONS);
+	pgm_peer_table_destroy (table);
+	g_free (tsis);
+}
+END_TEST
+
+/* unknown sources, as every packet from a new peer before it is created.
+ */
+
+START_TEST (test_lookup_miss)
+{
+	pgm_tsi_t* tsis = generate_tsis (2 * perf_peers);
+	pgm_peer_table_t* table = generate_table (tsis);
+	pgm_time_t start, check;
+	unsigned found = 0;
+
+	start = pgm_time_update_now();
+	for (unsigned i = 0; i < PERF_ITERATIONS; i++)
+		if (NULL != pgm_peer_table_lookup (table, &tsis[ perf_peers + ((i * 7919) % perf_peers) ]))
+			found++;
+	check = pgm_time_update_now();
+	fail_unless (0 == found, "unknown tsi found");
+	perf_report ("lookup_miss", check - start, PERF_ITERATIONS);
+	pgm_peer_table_destroy (table);
+	g_free (tsis);
+}
+END_TEST
+
+/* target:
+ *	struct pgm_peer_t*
+ *	pgm_peer_table_lookup_mru (
+ *		const pgm_peer_table_t*	table,
+ *		const pgm_tsi_t*	tsi
+ *	)
+ *
+ * bursts of eight packets per source as the receive path sees them, falling
+ * back to the table on a cache miss.
+ */
+
+START_TEST (test_lookup_mru)
+{
+	pgm_tsi_t* tsis = generate_tsis (perf_peers);
+	pgm_peer_table_t* table = generate_table (tsis);
+	pgm_time_t start, check;
+	unsigned found = 0;
+
+	start = pgm_time_update_now();
+	for (unsigned i = 0; i < PERF_ITERATIONS; i++) {
+		const pgm_tsi_t* tsi = &tsis[ ((i / 8) * 7919) % perf_peers ];
+		struct pgm_peer_t* peer = pgm_peer_table_lookup_mru (table, tsi);
+		if (NULL == peer) {
+			peer = pgm_peer_table_lookup (table, tsi);
+			pgm_peer_table_set_mru (table, tsi, peer);
+		}
+		if (NULL != peer)
+			found++;
+	}
+	check = pgm_time_update_now();
+	fail_unless (PERF_ITERATIONS == found, "lookup failed");
+	perf_report ("lookup_mru", check - start, PERF_ITERATIONS);
+	pgm_peer_table_destroy (table);
+	g_free (tsis);
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_peer_table_remove (
+ *		pgm_peer_table_t*	table,
+ *		const pgm_tsi_t*	tsi
+ *	)
+ *
+ * peers expiring and rejoining, one remove and one insert per iteration.
+ */
+
+START_TEST (test_churn)
+{
+	pgm_tsi_t* tsis = generate_tsis (perf_peers);
+	pgm_peer_table_t* table = generate_table (tsis);
+	pgm_time_t start, check;
+
+	start = pgm_time_update_now();
+	for (unsigned i = 0; i < PERF_ITERATIONS; i++) {
+		const unsigned j = (i * 7919) % perf_peers;
+		const bool is_removed = pgm_peer_table_remove (table, &tsis[j]);
+		fail_unless (is_removed, "remove failed");
+		pgm_peer_table_insert (table, &tsis[j], make_peer (j));
+	}
+	check = pgm_time_update_now();
+	perf_report ("churn", check - start, PERF_ITERATIONS);
+	pgm_peer_table_destroy (table);
+	g_free (tsis);
+}
+END_TEST
+
+static
+Suite*
+make_peer_table_suite (void)
+{
+	Suite* s;
+
+	s = suite_create ("Peer table");
+
+	TCase* tc_16 = tcase_create ("16 peers");
+	suite_add_tcase (s, tc_16);
+	tcase_add_checked_fixture (tc_16, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_16, mock_setup_16, NULL);
+	tcase_add_test (tc_16, test_insert);
+	tcase_add_test (tc_16, test_lookup);
+	tcase_add_test (tc_16, test_lookup_miss);
+	tcase_add_test (tc_16, test_lookup_mru);
+	tcase_add_test (tc_16, test_churn);
+
+	TCase* tc_1k = tcase_create ("1k peers");
+	suite_add_tcase (s, tc_1k);
+	tcase_add_checked_fixture (tc_1k, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_1k, mock_setup_1k, NULL);
+	tcase_add_test (tc_1k, test_insert);
+	tcase_add_test (tc_1k, test_lookup);
+	tcase_add_test (tc_1k, test_lookup_miss);
+	tcase_add_test (tc_1k, test_lookup_mru);
+	tcase_add_test (tc_1k, test_churn);
+
+	TCase* tc_64k = tcase_create ("64k peers");
+	suite_add_tcase (s, tc_64k);
+	tcase_add_checked_fixture (tc_64k, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_64k, mock_setup_64k, NULL);
+	tcase_add_test (tc_64k, test_insert);
+	tcase_add_test (tc_64k, test_lookup);
+	tcase_add_test (tc_64k, test_lookup_miss);
+	tcase_add_test (tc_64k, test_lookup_mru);
+	tcase_add_test (tc_64k, test_churn);
+
+	return s;
+}
+
+static
+Suite*
+make_master_suite (void)
+{
+	Suite* s = suite_create ("Master");
+	return s;
+}
+
+int
+main (void)
+{
+	SRunner* sr = srunner_create (make_master_suite ());
+	srunner_add_suite (sr, make_peer_table_suite ());
+	srunner_run_all (sr, CK_ENV);
+	int number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* eof */
@@ -0,0 +1,317 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * unit tests for the TSI to peer table.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <check.h>
+
+#ifdef _WIN32
+#	define PGM_CHECK_NOFORK		1
+#endif
+
+
+/* mock state */
+
+#define TEST_PEERS	1000
+
+/* mock functions for external references */
+
+size_t
+pgm_transport_pkt_offset2 (
+        const bool                      can_fragment,
+        const bool                      use_pgmcc
+        )
+{
+        return 0;
+}
+
+#define PEER_TABLE_DEBUG
+#include "peer_table.c"
+
+PGM_GNUC_INTERNAL
+int
+pgm_get_nprocs (void)
+{
+	return 1;
+}
+
+static
+void
+make_tsi (
+	pgm_tsi_t*	tsi,
+	unsigned	i
+	)
+{
+	memset (tsi, 0, sizeof (pgm_tsi_t));
+	tsi->gsi.identifier[0] = i & 0xff;
+	tsi->gsi.identifier[1] = (i >> 8) & 0xff;
+	tsi->sport = g_htons (1000 + (i % 7));
+}
+
+static
+struct pgm_peer_t*
+make_peer (
+	unsigned	i
+	)
+{
+	return (struct pgm_peer_t*)(uintptr_t)(i + 1);
+}
+
+/* target:
+ *	pgm_peer_table_t*
+ *	pgm_peer_table_new (
+ *		const uint64_t		seed
+ *	)
+ */
+
+START_TEST (test_new_pass_001)
+{
+	pgm_peer_table_t* table = pgm_peer_table_new (0);
+	fail_if (NULL == table, "new failed");
+	fail_unless (0 == table->len, "not empty");
+	pgm_peer_table_destroy (table);
+}
+END_TEST
+
+/* target:
+ *	void
+ *	pgm_peer_table_insert (
+ *		pgm_peer_table_t*	table,
+ *		const pgm_tsi_t*	tsi,
+ *		struct pgm_peer_t*	peer
+ *	)
+ *
+ *	struct pgm_peer_t*
+ *	pgm_peer_table_lookup (
+ *		const pgm_peer_table_t*	table,
+ *		const pgm_tsi_t*	tsi
+ *	)
+ */
+
+/* lookups stay correct across incremental growth */
+START_TEST (test_insert_pass_001)
+{
+	pgm_peer_table_t* table = pgm_peer_table_new (0x0123456789abcdefULL);
+	pgm_tsi_t tsi;
+	for (unsigned i = 0; i < TEST_PEERS; i++) {
+		make_tsi (&tsi, i);
+		pgm_peer_table_insert (table, &tsi, make_peer (i));
+		for (unsigned j = 0; j <= i; j++) {
+			make_tsi (&tsi, j);
+			fail_unless (make_peer (j) == pgm_peer_table_lookup (table, &tsi), "lookup failed");
+		}
+	}
+	fail_unless (TEST_PEERS == table->len, "len mismatch");
+	make_tsi (&tsi, TEST_PEERS);
+	fail_unless (NULL == pgm_peer_table_lookup (table, &tsi), "unknown tsi found");
+	pgm_peer_table_destroy (table);
+}
+END_TEST
+
+/* re-insert replaces */
+START_TEST (test_insert_pass_002)
+{
+	pgm_peer_table_t* table = pgm_peer_table_new (0);
+	pgm_tsi_t tsi;
+	make_tsi (&tsi, 1);
+	pgm_peer_table_insert (table, &tsi, make_peer (1));
+	pgm_peer_table_insert (table, &tsi, make_peer (2));
+	fail_unless (1 == table->len, "len mismatch");
+	fail_unless (make_peer (2) == pgm_peer_table_lookup (table, &tsi), "lookup failed");
+	pgm_peer_table_destroy (table);
+}
+END_TEST
+
+START_TEST (test_insert_fail_001)
+{
+	pgm_tsi_t tsi;
+	make_tsi (&tsi, 1);
+	pgm_peer_table_insert (NULL, &tsi, make_peer (1));
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_peer_table_remove (
+ *		pgm_peer_table_t*	table,
+ *		const pgm_tsi_t*	tsi
+ *	)
+ */
+
+/* remove alternate entries, including during migration */
+START_TEST (test_remove_pass_001)
+{
+	pgm_peer_table_t* table = pgm_peer_table_new (42);
+	pgm_tsi_t tsi;
+	for (unsigned i = 0; i < TEST_PEERS; i++) {
+		make_tsi (&tsi, i);
+		pgm_peer_table_insert (table, &tsi, make_peer (i));
+		if (i & 1) {
+			make_tsi (&tsi, i - 1);
+			fail_unless (TRUE == pgm_peer_table_remove (table, &tsi), "remove failed");
+		}
+	}
+	fail_unless (TEST_PEERS / 2 == table->len, "len mismatch");
+	for (unsigned i = 0; i < TEST_PEERS; i++) {
+		make_tsi (&tsi, i);
+		fail_unless ((i & 1 ? make_peer (i) : NULL) == pgm_peer_table_lookup (table, &tsi), "lookup failed");
+	}
+	make_tsi (&tsi, 0);
+	fail_unless (FALSE == pgm_peer_table_remove (table, &tsi), "remove succeeded twice");
+	pgm_peer_table_destroy (table);
+}
+END_TEST
+
+/* removal invalidates a matching cache entry */
+START_TEST (test_remove_pass_002)
+{
+	pgm_peer_table_t* table = pgm_peer_table_new (0);
+	pgm_tsi_t tsi;
+	make_tsi (&tsi, 1);
+	pgm_peer_table_insert (table, &tsi, make_peer (1));
+	pgm_peer_table_set_mru (table, &tsi, make_peer (1));
+	fail_unless (make_peer (1) == pgm_peer_table_lookup_mru (table, &tsi), "mru failed");
+	pgm_peer_table_remove (table, &tsi);
+	fail_unless (NULL == pgm_peer_table_lookup_mru (table, &tsi), "stale mru");
+	pgm_peer_table_destroy (table);
+}
+END_TEST
+
+/* target:
+ *	size_t
+ *	pgm_peer_table_reserve (
+ *		pgm_peer_table_t*	table,
+ *		const unsigned		count
+ *	)
+ */
+
+/* reserve mid-migration keeps entries and then holds count without growing */
+START_TEST (test_reserve_pass_001)
+{
+	pgm_peer_table_t* table = pgm_peer_table_new (42);
+	pgm_tsi_t tsi;
+	unsigned n = 0;
+	while (NULL == table->old_entries) {
+		make_tsi (&tsi, n);
+		pgm_peer_table_insert (table, &tsi, make_peer (n));
+		n++;
+	}
+	fail_unless (0 < pgm_peer_table_reserve (table, TEST_PEERS), "reserve failed");
+	fail_unless (NULL == table->old_entries, "migration not drained");
+	const unsigned mask = table->mask;
+	fail_unless (4 * TEST_PEERS <= 3 * (mask + 1), "undersized");
+	for (unsigned i = n; i < TEST_PEERS; i++) {
+		make_tsi (&tsi, i);
+		pgm_peer_table_insert (table, &tsi, make_peer (i));
+	}
+	fail_unless (mask == table->mask, "table grew");
+	fail_unless (NULL == table->old_entries, "table grew");
+	for (unsigned i = 0; i < TEST_PEERS; i++) {
+		make_tsi (&tsi, i);
+		fail_unless (make_peer (i) == pgm_peer_table_lookup (table, &tsi), "lookup failed");
+	}
+	pgm_peer_table_destroy (table);
+}
+END_TEST
+
+/* target:
+ *	struct pgm_peer_t*
+ *	pgm_peer_table_lookup_mru (
+ *		const pgm_peer_table_t*	table,
+ *		const pgm_tsi_t*	tsi
+ *	)
+ */
+
+/* cache matches on the full TSI */
+START_TEST (test_lookup_mru_pass_001)
+{
+	pgm_peer_table_t* table = pgm_peer_table_new (0);
+	pgm_tsi_t tsi1, tsi2;
+	make_tsi (&tsi1, 1);
+	make_tsi (&tsi2, 1);
+	tsi2.sport = ~tsi1.sport;
+	pgm_peer_table_set_mru (table, &tsi1, make_peer (1));
+	fail_unless (make_peer (1) == pgm_peer_table_lookup_mru (table, &tsi1), "mru failed");
+	fail_unless (NULL == pgm_peer_table_lookup_mru (table, &tsi2), "mru matched other tsi");
+	pgm_peer_table_destroy (table);
+}
+END_TEST
+
+static
+Suite*
+make_test_suite (void)
+{
+	Suite* s;
+
+	s = suite_create (__FILE__);
+
+	TCase* tc_new = tcase_create ("new");
+	suite_add_tcase (s, tc_new);
+	tcase_add_test (tc_new, test_new_pass_001);
+
+	TCase* tc_insert = tcase_create ("insert");
+	suite_add_tcase (s, tc_insert);
+	tcase_add_test (tc_insert, test_insert_pass_001);
+	tcase_add_test (tc_insert, test_insert_pass_002);
+	tcase_add_test (tc_insert, test_insert_fail_001);
+
+	TCase* tc_remove = tcase_create ("remove");
+	suite_add_tcase (s, tc_remove);
+	tcase_add_test (tc_remove, test_remove_pass_001);
+	tcase_add_test (tc_remove, test_remove_pass_002);
+
+	TCase* tc_reserve = tcase_create ("reserve");
+	suite_add_tcase (s, tc_reserve);
+	tcase_add_test (tc_reserve, test_reserve_pass_001);
+
+	TCase* tc_lookup_mru = tcase_create ("lookup-mru");
+	suite_add_tcase (s, tc_lookup_mru);
+	tcase_add_test (tc_lookup_mru, test_lookup_mru_pass_001);
+
+	return s;
+}
+
+static
+Suite*
+make_master_suite (void)
+{
+	Suite* s = suite_create ("Master");
+	return s;
+}
+
+int
+main (void)
+{
+	pgm_messages_init();
+	SRunner* sr = srunner_create (make_master_suite ());
+	srunner_add_suite (sr, make_test_suite ());
+	srunner_run_all (sr, CK_ENV);
+	int number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	pgm_messages_shutdown();
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* eof */
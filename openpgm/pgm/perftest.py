@@ -0,0 +1,142 @@
+#!/usr/bin/python3
+#
+# Run the performance tests, collect their unit times as JSON, and compare
+# against a stored baseline.
+#
+# Usage: perftest.py [-o results.json] [-b baseline.json] [-t percent]
+#                    [-m ns] [-r runs] program...
+#
+# Each perftest reports lines of the form
+#
+#   name/param: elapsed time N us, unit time N ns, ...
+#   name/param: N bytes per peer
+#
+# which are keyed as "program:name/param"; a label repeated within one
+# program gains a "#n" suffix in order of appearance.  Times are kept in
+# nanoseconds, the best of all runs is recorded to damp scheduler noise.
+#
+# Exit status is 1 when any metric is slower than the baseline by more than
+# the tolerance, 2 on a failing perftest.
+
+import getopt
+import json
+import os
+import platform
+import re
+import subprocess
+import sys
+import time
+
+unit_time = re.compile (r'(\S+): elapsed time \d+ us, unit time (\d+) (ns|us)')
+unit_size = re.compile (r'(\S+): (\d+) bytes per \w+')
+
+def usage():
+	sys.stderr.write ("Usage: %s [-o results.json] [-b baseline.json] [-t percent] [-m ns] [-r runs] program...\n" % sys.argv[0])
+	sys.exit (2)
+
+def run (program):
+	name = os.path.basename (program)
+	env = dict (os.environ)
+# report to the console in a single process so that output ordering is stable
+	env['CK_FORK'] = 'no'
+	proc = subprocess.Popen ([program], stdout=subprocess.PIPE, stderr=subprocess.STDOUT, env=env, universal_newlines=True)
+	output, _ = proc.communicate()
+	if 0 != proc.returncode:
+		sys.stderr.write (output)
+		sys.stderr.write ("%s: exit status %d\n" % (name, proc.returncode))
+		sys.exit (2)
+	metrics = {}
+	seen = {}
+	for line in output.splitlines():
+		m = unit_time.search (line)
+		if m:
+			label, value, unit = m.group (1), int (m.group (2)), 'ns'
+			if 'us' == m.group (3):
+				value *= 1000
+		else:
+			m = unit_size.search (line)
+			if not m:
+				continue
+			label, value, unit = m.group (1), int (m.group (2)), 'bytes'
+		seen[label] = seen.get (label, 0) + 1
+		if seen[label] > 1:
+			label = "%s#%d" % (label, seen[label])
+		metrics["%s:%s" % (name, label)] = { 'value': value, 'unit': unit }
+	return metrics
+
+def main():
+	try:
+		opts, programs = getopt.getopt (sys.argv[1:], 'o:b:t:m:r:h')
+	except getopt.GetoptError:
+		usage()
+	results_path = None
+	baseline_path = None
+	tolerance = 10.0
+	noise = 5
+	runs = 3
+	for o, a in opts:
+		if   '-o' == o: results_path = a
+		elif '-b' == o: baseline_path = a
+		elif '-t' == o: tolerance = float (a)
+		elif '-m' == o: noise = int (a)
+		elif '-r' == o: runs = max (1, int (a))
+		else: usage()
+	if not programs:
+		usage()
+
+	metrics = {}
+	for program in programs:
+		for i in range (runs):
+			for key, metric in run (program).items():
+				if key not in metrics or metric['value'] < metrics[key]['value']:
+					metrics[key] = metric
+
+	results = {
+		'date': time.strftime ("%Y-%m-%dT%H:%M:%SZ", time.gmtime()),
+		'system': platform.system(),
+		'machine': platform.machine(),
+		'node': platform.node(),
+		'runs': runs,
+		'metrics': metrics
+	}
+	if results_path:
+		with open (results_path, 'w') as f:
+			json.dump (results, f, indent=1, sort_keys=True)
+			f.write ("\n")
+
+	if not baseline_path:
+		for key in sorted (metrics):
+			print ("%-48s %10d %s" % (key, metrics[key]['value'], metrics[key]['unit']))
+		return 0
+	if not os.path.exists (baseline_path):
+		sys.stderr.write ("%s: no baseline, nothing to compare\n" % baseline_path)
+		return 0
+
+	with open (baseline_path) as f:
+		baseline = json.load (f)['metrics']
+	regressions = 0
+	print ("%-48s %10s %10s %8s" % ('metric', 'baseline', 'current', 'change'))
+	for key in sorted (set (metrics) | set (baseline)):
+		if key not in metrics:
+			print ("%-48s %10d %10s %8s" % (key, baseline[key]['value'], '-', 'missing'))
+			continue
+		if key not in baseline:
+			print ("%-48s %10s %10d %8s" % (key, '-', metrics[key]['value'], 'new'))
+			continue
+		old, new = baseline[key]['value'], metrics[key]['value']
+		change = 100.0 * (new - old) / old if old else (float ('inf') if new > old else 0.0)
+# bytes are exact, times below the noise floor are timer resolution
+		floor = 0 if 'bytes' == metrics[key]['unit'] else noise
+		is_regression = change > tolerance and new - old > floor
+		if is_regression:
+			regressions += 1
+		print ("%-48s %10d %10d %+7.1f%%%s" % (key, old, new, change, ' REGRESSION' if is_regression else ''))
+	if regressions:
+		print ("%d metrics regressed beyond %.1f%% of %s" % (regressions, tolerance, baseline_path))
+		return 1
+	return 0
+
+if __name__ == '__main__':
+	sys.exit (main())
+
+# end of file
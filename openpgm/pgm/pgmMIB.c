@@ -14,6 +14,8 @@
 #include <impl/framework.h>
 #include <impl/receiver.h>
 #include <impl/socket.h>
+#include <impl/sock_registry.h>
+#include <impl/stats.h>
 
 #include "pgm/snmp.h"
 #include "impl/pgmMIB.h"
@@ -24,24 +26,63 @@
 //#define PGMMIB_DEBUG
 
 
+/* tables are copied from live sockets and peers at most once per interval on
+ * demand, GetNext and GetBulk requests are then served from the sorted copy
+ * without taking socket or peer locks.
+ */
+#define PGM_SNMP_CACHE_TIMEOUT		5	/* seconds */
+
+/* longest row index: GSI string with length, source port, and instance */
+#define PGM_SNMP_INDEX_LEN		(1 + PGM_GSISTRLEN + 2)
+
+/* widest table */
+#define PGM_SNMP_COLUMNS_MAX		64
+
+#define PGM_SNMP_ALIGN(len)		(((len) + sizeof(long) - 1) & ~(sizeof(long) - 1))
+
+
 /* locals */
 
-struct pgm_snmp_data_context_t {
-	pgm_sock_t*	sock;
-	pgm_peer_t*	peer;
+struct pgm_snmp_value_t {
+	union {
+		long		integer;
+		u_char		string[ PGM_GSISTRLEN ];
+	} val;
+	size_t			len;
+	u_char			type;			/* 0 for no such object */
+};
+
+typedef struct pgm_snmp_value_t pgm_snmp_value_t;
+
+/* copied value of one column at offset from the row */
+struct pgm_snmp_cell_t {
+	uint16_t		offset;
+	uint8_t			len;
+	u_char			type;
+};
+
+struct pgm_snmp_row_t {
+	netsnmp_index		index;			/* container key, must be first */
+	oid			oids[ PGM_SNMP_INDEX_LEN ];
+	struct pgm_snmp_cell_t	cell[];			/* from min_column, values follow */
 };
 
-typedef struct pgm_snmp_data_context_t pgm_snmp_data_context_t;
+typedef struct pgm_snmp_row_t pgm_snmp_row_t;
+
+typedef void (pgm_snmp_column_func)(const pgm_sock_t*const restrict, const pgm_peer_t*const restrict, const netsnmp_variable_list*const restrict, const unsigned, pgm_snmp_value_t*const restrict);
 
-struct pgm_snmp_context_t {
-	pgm_slist_t*	list;
-	pgm_list_t*	node;
-	int		index;		/* table index */
-	unsigned 	instance;	/* unique number per node */
-	pgm_snmp_data_context_t	data_context;
+struct pgm_snmp_table_t {
+	const char*		name;
+	const oid*		table_oid;
+	size_t			table_oid_len;
+	unsigned		min_column;
+	unsigned		max_column;
+	bool			is_per_peer;		/* row per peer, otherwise per sock */
+	pgm_snmp_column_func*	column;
+	netsnmp_container*	container;		/* rows of the current copy */
 };
 
-typedef struct pgm_snmp_context_t pgm_snmp_context_t;
+typedef struct pgm_snmp_table_t pgm_snmp_table_t;
 
 
 static const oid snmptrap_oid[] = {1, 3, 6, 1, 6, 3, 1, 1, 4, 1, 0};
@@ -49,41 +90,39 @@ static const oid snmptrap_oid[] = {1, 3, 6, 1, 6, 3, 1, 1, 4, 1, 0};
 
 /* functions */
 
-static int initialize_table_pgmSourceTable(void);
-static Netsnmp_Node_Handler pgmSourceTable_handler;
-static Netsnmp_First_Data_Point pgmSourceTable_get_first_data_point;
-static Netsnmp_Next_Data_Point pgmSourceTable_get_next_data_point;
-static Netsnmp_Free_Loop_Context pgmSourceTable_free_loop_context;
-
-static int initialize_table_pgmSourceConfigTable(void);
-static Netsnmp_Node_Handler pgmSourceConfigTable_handler;
-static Netsnmp_First_Data_Point pgmSourceConfigTable_get_first_data_point;
-static Netsnmp_Next_Data_Point pgmSourceConfigTable_get_next_data_point;
-static Netsnmp_Free_Loop_Context pgmSourceConfigTable_free_loop_context;
-
-static int initialize_table_pgmSourcePerformanceTable(void);
-static Netsnmp_Node_Handler pgmSourcePerformanceTable_handler;
-static Netsnmp_First_Data_Point pgmSourcePerformanceTable_get_first_data_point;
-static Netsnmp_Next_Data_Point pgmSourcePerformanceTable_get_next_data_point;
-static Netsnmp_Free_Loop_Context pgmSourcePerformanceTable_free_loop_context;
-
-static int initialize_table_pgmReceiverTable(void);
-static Netsnmp_Node_Handler pgmReceiverTable_handler;
-static Netsnmp_First_Data_Point pgmReceiverTable_get_first_data_point;
-static Netsnmp_Next_Data_Point pgmReceiverTable_get_next_data_point;
-static Netsnmp_Free_Loop_Context pgmReceiverTable_free_loop_context;
-
-static int initialize_table_pgmReceiverConfigTable(void);
-static Netsnmp_Node_Handler pgmReceiverConfigTable_handler;
-static Netsnmp_First_Data_Point pgmReceiverConfigTable_get_first_data_point;
-static Netsnmp_Next_Data_Point pgmReceiverConfigTable_get_next_data_point;
-static Netsnmp_Free_Loop_Context pgmReceiverConfigTable_free_loop_context;
-
-static int initialize_table_pgmReceiverPerformanceTable(void);
-static Netsnmp_Node_Handler pgmReceiverPerformanceTable_handler;
-static Netsnmp_First_Data_Point pgmReceiverPerformanceTable_get_first_data_point;
-static Netsnmp_Next_Data_Point pgmReceiverPerformanceTable_get_next_data_point;
-static Netsnmp_Free_Loop_Context pgmReceiverPerformanceTable_free_loop_context;
+static int pgm_snmp_table_register (pgm_snmp_table_t*const);
+static Netsnmp_Node_Handler pgm_snmp_table_handler;
+static NetsnmpCacheLoad pgm_snmp_table_load;
+static NetsnmpCacheFree pgm_snmp_table_free;
+
+static pgm_snmp_column_func pgmSourceTable_column;
+static pgm_snmp_column_func pgmSourceConfigTable_column;
+static pgm_snmp_column_func pgmSourcePerformanceTable_column;
+static pgm_snmp_column_func pgmReceiverTable_column;
+static pgm_snmp_column_func pgmReceiverConfigTable_column;
+static pgm_snmp_column_func pgmReceiverPerformanceTable_column;
+
+static const oid pgmSourceTable_oid[] = {1,3,6,1,3,112,1,2,100,2};
+static const oid pgmSourceConfigTable_oid[] = {1,3,6,1,3,112,1,2,100,3};
+static const oid pgmSourcePerformanceTable_oid[] = {1,3,6,1,3,112,1,2,100,4};
+static const oid pgmReceiverTable_oid[] = {1,3,6,1,3,112,1,3,100,2};
+static const oid pgmReceiverConfigTable_oid[] = {1,3,6,1,3,112,1,3,100,3};
+static const oid pgmReceiverPerformanceTable_oid[] = {1,3,6,1,3,112,1,3,100,4};
+
+static pgm_snmp_table_t pgm_snmp_tables[] = {
+	{ "pgmSourceTable",		 pgmSourceTable_oid,		  OID_LENGTH( pgmSourceTable_oid ),
+	  COLUMN_PGMSOURCESOURCEADDRESS,	COLUMN_PGMSOURCESOURCEPORTNUMBER,	FALSE, pgmSourceTable_column,		   NULL },
+	{ "pgmSourceConfigTable",	 pgmSourceConfigTable_oid,	  OID_LENGTH( pgmSourceConfigTable_oid ),
+	  COLUMN_PGMSOURCETTL,			COLUMN_PGMSOURCESPMPATHADDRESS,		FALSE, pgmSourceConfigTable_column,	   NULL },
+	{ "pgmSourcePerformanceTable",	 pgmSourcePerformanceTable_oid,	  OID_LENGTH( pgmSourcePerformanceTable_oid ),
+	  COLUMN_PGMSOURCEDATABYTESSENT,	COLUMN_PGMSOURCENNAKERRORS,		FALSE, pgmSourcePerformanceTable_column,   NULL },
+	{ "pgmReceiverTable",		 pgmReceiverTable_oid,		  OID_LENGTH( pgmReceiverTable_oid ),
+	  COLUMN_PGMRECEIVERGROUPADDRESS,	COLUMN_PGMRECEIVERUNIQUEINSTANCE,	TRUE,  pgmReceiverTable_column,		   NULL },
+	{ "pgmReceiverConfigTable",	 pgmReceiverConfigTable_oid,	  OID_LENGTH( pgmReceiverConfigTable_oid ),
+	  COLUMN_PGMRECEIVERNAKBACKOFFIVL,	COLUMN_PGMRECEIVERNAKFAILURETHRESHOLD,	TRUE,  pgmReceiverConfigTable_column,	   NULL },
+	{ "pgmReceiverPerformanceTable", pgmReceiverPerformanceTable_oid, OID_LENGTH( pgmReceiverPerformanceTable_oid ),
+	  COLUMN_PGMRECEIVERDATABYTESRECEIVED,	COLUMN_PGMRECEIVERLASTINTERVALNAKFAILURES, TRUE, pgmReceiverPerformanceTable_column, NULL }
+};
 
 PGM_GNUC_INTERNAL
 bool
@@ -91,54 +130,23 @@ pgm_mib_init (
 	pgm_error_t**	error
 	)
 {
-	if (MIB_REGISTERED_OK != initialize_table_pgmSourceTable()) {
-		pgm_set_error (error,
-			     PGM_ERROR_DOMAIN_SNMP,
-			     PGM_ERROR_FAILED,
-			     _("pgmSourceTable registration: see SNMP log for further details."));
-		return FALSE;
-	}
-	if (MIB_REGISTERED_OK != initialize_table_pgmSourceConfigTable()) {
-		pgm_set_error (error,
-			     PGM_ERROR_DOMAIN_SNMP,
-			     PGM_ERROR_FAILED,
-			     _("pgmSourceConfigTable registration: see SNMP log for further details."));
-		return FALSE;
-	}
-	if (MIB_REGISTERED_OK != initialize_table_pgmSourcePerformanceTable()) {
-		pgm_set_error (error,
-			     PGM_ERROR_DOMAIN_SNMP,
-			     PGM_ERROR_FAILED,
-			     _("pgmSourcePerformanceTable registration: see SNMP log for further details."));
-		return FALSE;
-	}
-	if (MIB_REGISTERED_OK != initialize_table_pgmReceiverTable()) {
-		pgm_set_error (error,
-			     PGM_ERROR_DOMAIN_SNMP,
-			     PGM_ERROR_FAILED,
-			     _("pgmReceiverTable registration: see SNMP log for further details."));
-		return FALSE;
-	}
-	if (MIB_REGISTERED_OK != initialize_table_pgmReceiverConfigTable()) {
-		pgm_set_error (error,
-			     PGM_ERROR_DOMAIN_SNMP,
-			     PGM_ERROR_FAILED,
-			     _("pgmReceiverConfigTable registration: see SNMP log for further details."));
-		return FALSE;
-	}
-	if (MIB_REGISTERED_OK != initialize_table_pgmReceiverPerformanceTable()) {
-		pgm_set_error (error,
-			     PGM_ERROR_DOMAIN_SNMP,
-			     PGM_ERROR_FAILED,
-			     _("pgmReceiverPerformanceTable registration: see SNMP log for further details."));
-		return FALSE;
+	for (unsigned i = 0; i < PGM_N_ELEMENTS(pgm_snmp_tables); i++)
+	{
+		if (MIB_REGISTERED_OK != pgm_snmp_table_register (&pgm_snmp_tables[i])) {
+			pgm_set_error (error,
+				     PGM_ERROR_DOMAIN_SNMP,
+				     PGM_ERROR_FAILED,
+				     _("%s registration: see SNMP log for further details."),
+				     pgm_snmp_tables[i].name);
+			return FALSE;
+		}
 	}
 
 	return TRUE;
 }
 
-/*
- * pgmSourceTable
+/* register a table served from a sorted container of copied rows, refreshed
+ * through the cache helper ahead of each request once expired.
  *
  * returns MIB_REGISTERED_OK on success, failures include:
  * 	MIB_REGISTRATION_FAILED
@@ -148,169 +156,273 @@ pgm_mib_init (
 
 static
 int
-initialize_table_pgmSourceTable (void)
+pgm_snmp_table_register (
+	pgm_snmp_table_t* const	table
+	)
 {
-	pgm_debug ("initialize_table_pgmSourceTable ()");
+/* pre-conditions */
+	pgm_assert (NULL != table);
+	pgm_assert_cmpuint (table->max_column - table->min_column, <, PGM_SNMP_COLUMNS_MAX);
+
+	pgm_debug ("pgm_snmp_table_register (table:%s)", table->name);
 
-	static const oid pgmSourceTable_oid[] = {1,3,6,1,3,112,1,2,100,2};
 	netsnmp_table_registration_info* table_info = NULL;
-	netsnmp_iterator_info* iinfo = NULL;
 	netsnmp_handler_registration* reg = NULL;
+	netsnmp_cache* cache = NULL;
 
-	reg = netsnmp_create_handler_registration ("pgmSourceTable",	pgmSourceTable_handler,
-						   pgmSourceTable_oid,	OID_LENGTH( pgmSourceTable_oid ),
+	reg = netsnmp_create_handler_registration (table->name,		pgm_snmp_table_handler,
+						   (oid*)table->table_oid, table->table_oid_len,
 						   HANDLER_CAN_RONLY);
 	if (NULL == reg)
 		goto error;
+	reg->handler->myvoid = table;
 
 	table_info = SNMP_MALLOC_TYPEDEF( netsnmp_table_registration_info );
 	if (NULL == table_info)
 		goto error;
 
-	table_info->min_column = COLUMN_PGMSOURCESOURCEADDRESS;
-	table_info->max_column = COLUMN_PGMSOURCESOURCEPORTNUMBER;
+	table_info->min_column = table->min_column;
+	table_info->max_column = table->max_column;
+
+	if (table->is_per_peer)
+		netsnmp_table_helper_add_indexes (table_info,
+						  ASN_OCTET_STR,  /* index: pgmReceiverGlobalId */
+						  ASN_UNSIGNED,  /* index: pgmReceiverSourcePort */
+						  ASN_UNSIGNED,  /* index: pgmReceiverInstance */
+						  0);
+	else
+		netsnmp_table_helper_add_indexes (table_info,
+						  ASN_OCTET_STR,  /* index: pgmSourceGlobalId */
+						  ASN_UNSIGNED,  /* index: pgmSourceSourcePort */
+						  0);
 
-	netsnmp_table_helper_add_indexes (table_info,
-					  ASN_OCTET_STR,  /* index: pgmSourceGlobalId */
-					  ASN_UNSIGNED,  /* index: pgmSourceSourcePort */
-					  0);
+	table->container = netsnmp_container_find ("table_container");
+	if (NULL == table->container)
+		goto error;
 
-	iinfo = SNMP_MALLOC_TYPEDEF( netsnmp_iterator_info );
-	if (NULL == iinfo)
+	cache = netsnmp_cache_create (PGM_SNMP_CACHE_TIMEOUT,
+				      pgm_snmp_table_load, pgm_snmp_table_free,
+				      table->table_oid, table->table_oid_len);
+	if (NULL == cache)
 		goto error;
+	cache->magic = table;
+	cache->flags = NETSNMP_CACHE_DONT_INVALIDATE_ON_SET;
 
-	iinfo->get_first_data_point 	= pgmSourceTable_get_first_data_point;
-	iinfo->get_next_data_point  	= pgmSourceTable_get_next_data_point;
-	iinfo->free_loop_context_at_end = pgmSourceTable_free_loop_context;
-	iinfo->table_reginfo        	= table_info;
+/* handlers run in reverse order of injection: table, cache, container */
+	if (SNMPERR_SUCCESS != netsnmp_inject_handler (reg, netsnmp_container_table_handler_get (table_info, table->container, TABLE_CONTAINER_KEY_NETSNMP_INDEX)))
+		goto error;
+	if (SNMPERR_SUCCESS != netsnmp_inject_handler (reg, netsnmp_cache_handler_get (cache)))
+		goto error;
 
-	return netsnmp_register_table_iterator (reg, iinfo);
+	return netsnmp_register_table (reg, table_info);
 
 error:
 	if (table_info && table_info->indexes)		/* table_data_free_func() is internal */
 		snmp_free_var (table_info->indexes);
 	SNMP_FREE( table_info );
-	SNMP_FREE( iinfo );
+	if (table->container) {
+		CONTAINER_FREE( table->container );
+		table->container = NULL;
+	}
 	netsnmp_handler_registration_free (reg);
 
 	return -1;
 }
 
-/* called for first row of data in SNMP table
- *
- * goal is to cache all the relevant data for subsequent get_next_data_point (row) calls in my_loop_context,
- * optionally returns my_data_context.
- *
- * returns answer or NULL
+/* set row index from TSI, with instance for per-peer tables.
  */
 
 static
-netsnmp_variable_list*
-pgmSourceTable_get_first_data_point(
-	void**			my_loop_context,	/* valid through one query of multiple "data points" */
-	void**			my_data_context,	/* answer blob which is passed to handler() */
-	netsnmp_variable_list*	put_index_data,		/* answer */
-	netsnmp_iterator_info*	mydata			/* iinfo on init() */
+void
+pgm_snmp_index_set (
+	netsnmp_variable_list* const restrict indexes,
+	const pgm_tsi_t*       const restrict tsi,
+	const unsigned			      instance
 	)
 {
-/* pre-conditions */
-	pgm_assert (NULL != my_loop_context);
-	pgm_assert (NULL != my_data_context);
-	pgm_assert (NULL != put_index_data);
-	pgm_assert (NULL != mydata);
+	netsnmp_variable_list *idx = indexes;
+
+/* pgmSourceGlobalId, pgmReceiverGlobalId */
+	char gsi[ PGM_GSISTRLEN ];
+	pgm_gsi_print_r (&tsi->gsi, gsi, sizeof(gsi));
+	snmp_set_var_typed_value (idx, ASN_OCTET_STR, (const u_char*)&gsi, strlen (gsi));
+	idx = idx->next_variable;
+
+/* pgmSourceSourcePort, pgmReceiverSourcePort */
+	const unsigned sport = pgm_ntohs (tsi->sport);
+	snmp_set_var_typed_value (idx, ASN_UNSIGNED, (const u_char*)&sport, sizeof(sport));
+	idx = idx->next_variable;
 
-	pgm_debug ("pgmSourceTable_get_first_data_point (my_loop_context:%p my_data_context:%p put_index_data:%p mydata:%p)",
-		(const void*)my_loop_context,
-		(const void*)my_data_context,
-		(const void*)put_index_data,
-		(const void*)mydata);
+/* pgmReceiverInstance */
+	if (NULL != idx)
+		snmp_set_var_typed_value (idx, ASN_UNSIGNED, (const u_char*)&instance, sizeof(instance));
+}
 
-	pgm_rwlock_reader_lock (&pgm_sock_list_lock);
+/* copy every column of the sock or peer into a new row keyed by indexes.
+ *
+ * returns new row, or NULL if the index cannot be encoded.
+ */
 
-	if (NULL == pgm_sock_list) {
-		pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
-		return NULL;
+static
+pgm_snmp_row_t*
+pgm_snmp_row_new (
+	const pgm_snmp_table_t*	     const restrict table,
+	const pgm_sock_t*	     const restrict sock,
+	const pgm_peer_t*	     const restrict peer,
+	const netsnmp_variable_list* const restrict indexes
+	)
+{
+	pgm_snmp_value_t values[ PGM_SNMP_COLUMNS_MAX ];
+	const unsigned columns = table->max_column - table->min_column + 1;
+	const size_t header_len = PGM_SNMP_ALIGN(sizeof(pgm_snmp_row_t) + columns * sizeof(struct pgm_snmp_cell_t));
+	size_t len = header_len;
+
+	for (unsigned i = 0; i < columns; i++) {
+		values[i].len  = 0;
+		values[i].type = 0;
+		table->column (sock, peer, indexes, table->min_column + i, &values[i]);
+		len += PGM_SNMP_ALIGN(values[i].len);
 	}
 
-/* create our own context for this SNMP loop */
-	pgm_snmp_context_t* context = pgm_new0 (pgm_snmp_context_t, 1);
-	context->list = pgm_sock_list;
-	*my_loop_context = context;
+	pgm_snmp_row_t* row = pgm_malloc (len);
+	row->index.oids = row->oids;
+	row->index.len  = 0;
+	if (SNMPERR_SUCCESS != build_oid_noalloc (row->oids, PGM_SNMP_INDEX_LEN, &row->index.len,
+						  NULL, 0, (netsnmp_variable_list*)indexes))
+	{
+		pgm_free (row);
+		return NULL;
+	}
 
-/* pass on for generic row access */
-	return pgmSourceTable_get_next_data_point (my_loop_context, my_data_context, put_index_data, mydata);
+	size_t offset = header_len;
+	for (unsigned i = 0; i < columns; i++) {
+		row->cell[i].offset = (uint16_t)offset;
+		row->cell[i].len    = (uint8_t)values[i].len;
+		row->cell[i].type   = values[i].type;
+		memcpy ((char*)row + offset, values[i].val.string, values[i].len);
+		offset += PGM_SNMP_ALIGN(values[i].len);
+	}
+	return row;
 }
 
-static
-netsnmp_variable_list*
-pgmSourceTable_get_next_data_point(
-	void**			my_loop_context,
-	void**			my_data_context,
-	netsnmp_variable_list*	put_index_data,
-	netsnmp_iterator_info*	mydata
+/* column value of a row, replaying the typed value of the copy.
+ */
+
+static inline
+void
+pgm_snmp_value_set (
+	pgm_snmp_value_t* const restrict value,
+	const u_char			 type,
+	const u_char*	  const restrict val,
+	const size_t			 len
 	)
 {
-/* pre-conditions */
-	pgm_assert (NULL != my_loop_context);
-	pgm_assert (NULL != my_data_context);
-	pgm_assert (NULL != put_index_data);
-	pgm_assert (NULL != mydata);
-
-	pgm_debug ("pgmSourceTable_get_next_data_point (my_loop_context:%p my_data_context:%p put_index_data:%p mydata:%p)",
-		(const void*)my_loop_context,
-		(const void*)my_data_context,
-		(const void*)put_index_data,
-		(const void*)mydata);
+	pgm_assert (len <= sizeof(value->val));
+	value->type = type;
+	value->len  = len;
+	memcpy (value->val.string, val, len);
+}
 
-	pgm_snmp_context_t* context = (pgm_snmp_context_t*)*my_loop_context;
-	netsnmp_variable_list *idx = put_index_data;
+/* cache helper load hook, copy rows of all socks or all peers of all socks
+ * into the table container.  sock and peer list reader locks are held only
+ * for the duration of the copy.
+ *
+ * returns 0 on success.
+ */
 
-	if (NULL == context->list)
-		return NULL;
+static
+int
+pgm_snmp_table_load (
+	netsnmp_cache*		cache,
+	void*			magic
+	)
+{
+	pgm_snmp_table_t* table = (pgm_snmp_table_t*)magic;
+	netsnmp_variable_list indexes[3];
+	unsigned rows = 0, instance = 0;
 
-	pgm_sock_t* sock = context->list->data;
+/* pre-conditions */
+	pgm_assert (NULL != table);
+	pgm_assert (NULL != table->container);
 
-/* pgmSourceGlobalId */
-	char gsi[ PGM_GSISTRLEN ];
-	pgm_gsi_print_r (&sock->tsi.gsi, gsi, sizeof(gsi));
-	snmp_set_var_typed_value (idx, ASN_OCTET_STR, (const u_char*)&gsi, strlen (gsi));
-	idx = idx->next_variable;
+	memset (indexes, 0, sizeof(indexes));
+	indexes[0].next_variable = &indexes[1];
+	if (table->is_per_peer)
+		indexes[1].next_variable = &indexes[2];
 
-/* pgmSourceSourcePort */
-	const unsigned sport = pgm_ntohs (sock->tsi.sport);
-	snmp_set_var_typed_value (idx, ASN_UNSIGNED, (const u_char*)&sport, sizeof(sport));
+	unsigned epoch;
+	const pgm_sock_registry_t* registry = pgm_sock_registry_enter (&epoch);
+	for (unsigned n = 0; n < registry->len; n++)
+	{
+		pgm_sock_t* sock = registry->socks[ n ];
+		if (!table->is_per_peer) {
+			pgm_snmp_index_set (indexes, &sock->tsi, 0);
+			pgm_snmp_row_t* row = pgm_snmp_row_new (table, sock, NULL, indexes);
+			if (NULL != row && 0 != CONTAINER_INSERT( table->container, row ))
+				pgm_free (row);
+			else if (NULL != row)
+				rows++;
+			continue;
+		}
+/* and through all peers for each sock */
+		pgm_rwlock_reader_lock (&sock->peers_lock);
+		for (pgm_list_t* node = sock->peers_list;
+		     node;
+		     node = node->next)
+		{
+			const pgm_peer_t* peer = (const pgm_peer_t*)node->data;
+			pgm_snmp_index_set (indexes, &peer->tsi, instance++);
+			pgm_snmp_row_t* row = pgm_snmp_row_new (table, sock, peer, indexes);
+			if (NULL != row && 0 != CONTAINER_INSERT( table->container, row ))
+				pgm_free (row);
+			else if (NULL != row)
+				rows++;
+		}
+		pgm_rwlock_reader_unlock (&sock->peers_lock);
+	}
+	pgm_sock_registry_leave (epoch);
 
-	*my_data_context = sock;
-	context->list = context->list->next;
+	snmp_reset_var_buffers (indexes);
+	pgm_debug ("pgm_snmp_table_load (table:%s rows:%u)", table->name, rows);
+	return 0;
+}
 
-	return put_index_data;
+static
+void
+pgm_snmp_row_free (
+	void*			data,
+	void*			context
+	)
+{
+	pgm_free (data);
 }
 
+/* cache helper free hook, release copied rows ahead of the next load.
+ */
+
 static
 void
-pgmSourceTable_free_loop_context (
-	void*			my_loop_context,
-	netsnmp_iterator_info*	mydata
+pgm_snmp_table_free (
+	netsnmp_cache*		cache,
+	void*			magic
 	)
 {
-/* pre-conditions */
-	pgm_assert (NULL != my_loop_context);
-	pgm_assert (NULL != mydata);
+	pgm_snmp_table_t* table = (pgm_snmp_table_t*)magic;
 
-	pgm_debug ("pgmSourceTable_free_loop_context (my_loop_context:%p mydata:%p)",
-		(const void*)my_loop_context,
-		(const void*)mydata);
+/* pre-conditions */
+	pgm_assert (NULL != table);
 
-	pgm_snmp_context_t* context = (pgm_snmp_context_t*)my_loop_context;
-	pgm_free (context);
-	my_loop_context = NULL;
+	pgm_debug ("pgm_snmp_table_free (table:%s)", table->name);
 
-	pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
+	CONTAINER_CLEAR( table->container, pgm_snmp_row_free, NULL );
 }
 
+/* serve requests from the copied row located by the container helper.
+ */
+
 static
 int
-pgmSourceTable_handler (
+pgm_snmp_table_handler (
 	netsnmp_mib_handler*		handler,
 	netsnmp_handler_registration*	reginfo,
 	netsnmp_agent_request_info*	reqinfo,
@@ -323,95 +435,52 @@ pgmSourceTable_handler (
 	pgm_assert (NULL != reqinfo);
 	pgm_assert (NULL != requests);
 
-	pgm_debug ("pgmSourceTable_handler (handler:%p reginfo:%p reqinfo:%p requests:%p)",
+	const pgm_snmp_table_t* table = (const pgm_snmp_table_t*)handler->myvoid;
+
+	pgm_debug ("pgm_snmp_table_handler (handler:%p reginfo:%p reqinfo:%p requests:%p)",
 		(const void*)handler,
 		(const void*)reginfo,
 		(const void*)reqinfo,
 		(const void*)requests);
-	
+
 	switch (reqinfo->mode) {
 
-/* Read-support (also covers GetNext requests) */
+/* Read-support (also covers GetNext and GetBulk requests) */
 
 	case MODE_GET:
 		for (netsnmp_request_info* request = requests;
 		     request;
 		     request = request->next)
 		{
-			const pgm_sock_t* sock = (pgm_sock_t*)netsnmp_extract_iterator_context (request);
-			if (NULL == sock) {
+			const pgm_snmp_row_t* row = (const pgm_snmp_row_t*)netsnmp_container_table_row_extract (request);
+			if (NULL == row) {
 				netsnmp_set_request_error (reqinfo, request, SNMP_NOSUCHINSTANCE);
 				continue;
 			}
 
-			netsnmp_variable_list *var = request->requestvb;
 			netsnmp_table_request_info* table_info = netsnmp_extract_table_info (request);
 			if (NULL == table_info) {
-				snmp_log (LOG_ERR, "pgmSourceTable_handler: empty table request info.\n");
+				snmp_log (LOG_ERR, "%s_handler: empty table request info.\n", table->name);
 				continue;
 			}
 
-			switch (table_info->colnum) {
-
-			case COLUMN_PGMSOURCESOURCEADDRESS:
-				{
-					struct sockaddr_in s4;
-					if (AF_INET == sock->send_gsr.gsr_source.ss_family)
-						memcpy (&s4, &sock->send_gsr.gsr_source, sizeof(s4));
-					else
-						memset (&s4, 0, sizeof(s4));
-					snmp_set_var_typed_value (var, ASN_IPADDRESS,
-								  (const u_char*)&s4.sin_addr.s_addr,
-								  sizeof(struct in_addr) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCEGROUPADDRESS:
-				{
-					struct sockaddr_in s4;
-					if (AF_INET == sock->send_gsr.gsr_group.ss_family)
-						memcpy (&s4, &sock->send_gsr.gsr_group, sizeof(s4));
-					else
-						memset (&s4, 0, sizeof(s4));
-					snmp_set_var_typed_value (var, ASN_IPADDRESS,
-								  (const u_char*)&s4.sin_addr.s_addr,
-								  sizeof(struct in_addr) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCEDESTPORT:
-				{
-					const unsigned dport = pgm_ntohs (sock->dport);
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&dport, sizeof(dport) );
-				}
-				break;
-
-/* copy index[0] */
-			case COLUMN_PGMSOURCESOURCEGSI:
-				snmp_set_var_typed_value (var, ASN_OCTET_STR,
-							  (const u_char*)table_info->indexes->val.string,
-							  table_info->indexes->val_len);
-				break;
-
-/* copy index[1] */
-			case COLUMN_PGMSOURCESOURCEPORTNUMBER:
-				snmp_set_var_typed_value (var, ASN_UNSIGNED,
-							  (const u_char*)table_info->indexes->next_variable->val.integer,
-							  table_info->indexes->next_variable->val_len);
-			
-				break;
-
-			default:
-				snmp_log (LOG_ERR, "pgmSourceTable_handler: unknown column.\n");
-				break;
+			if (table_info->colnum < table->min_column ||
+			    table_info->colnum > table->max_column ||
+			    0 == row->cell[ table_info->colnum - table->min_column ].type)
+			{
+				netsnmp_set_request_error (reqinfo, request, SNMP_NOSUCHOBJECT);
+				continue;
 			}
+
+			const struct pgm_snmp_cell_t* cell = &row->cell[ table_info->colnum - table->min_column ];
+			snmp_set_var_typed_value (request->requestvb, cell->type,
+						  (const u_char*)row + cell->offset, cell->len);
 		}
 		break;
 
 	case MODE_SET_RESERVE1:
 	default:
-		snmp_log (LOG_ERR, "pgmSourceTable_handler: unsupported mode.\n");
+		snmp_log (LOG_ERR, "%s_handler: unsupported mode.\n", table->name);
 		break;
 
 	}
@@ -420,2399 +489,1294 @@ pgmSourceTable_handler (
 }
 
 /*
- * pgmSourceConfigTable
- *
+ * pgmSourceTable
  */
 
 static
-int
-initialize_table_pgmSourceConfigTable(void)
+void
+pgmSourceTable_column (
+	const pgm_sock_t*	     const restrict sock,
+	const pgm_peer_t*	     const restrict peer,
+	const netsnmp_variable_list* const restrict indexes,
+	const unsigned				    colnum,
+	pgm_snmp_value_t*	     const restrict value
+	)
 {
-	pgm_debug ("initialize_table_pgmSourceConfigTable ()");
-
-	static const oid pgmSourceConfigTable_oid[] = {1,3,6,1,3,112,1,2,100,3};
-	netsnmp_table_registration_info* table_info = NULL;
-	netsnmp_iterator_info* iinfo = NULL;
-	netsnmp_handler_registration* reg = NULL;
-
-	reg = netsnmp_create_handler_registration ("pgmSourceConfigTable",	pgmSourceConfigTable_handler,
-						   pgmSourceConfigTable_oid,	OID_LENGTH( pgmSourceConfigTable_oid ),
-						   HANDLER_CAN_RONLY);
-	if (NULL == reg)
-		goto error;
-
-	table_info = SNMP_MALLOC_TYPEDEF( netsnmp_table_registration_info );
-	if (NULL == table_info)
-		goto error;
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != indexes);
+	pgm_assert (NULL != value);
 
-	table_info->min_column = COLUMN_PGMSOURCETTL;
-	table_info->max_column = COLUMN_PGMSOURCESPMPATHADDRESS;
+	switch (colnum) {
 
-	netsnmp_table_helper_add_indexes (table_info,
-					  ASN_OCTET_STR,  /* index: pgmSourceConfigGlobalId */
-					  ASN_UNSIGNED,  /* index: pgmSourceConfigSourcePort */
-					  0);
+	case COLUMN_PGMSOURCESOURCEADDRESS:
+		{
+			struct sockaddr_in s4;
+			if (AF_INET == sock->send_gsr.gsr_source.ss_family)
+				memcpy (&s4, &sock->send_gsr.gsr_source, sizeof(s4));
+			else
+				memset (&s4, 0, sizeof(s4));
+			pgm_snmp_value_set (value, ASN_IPADDRESS,
+					    (const u_char*)&s4.sin_addr.s_addr,
+					    sizeof(struct in_addr) );
+		}
+		break;
 
-	iinfo = SNMP_MALLOC_TYPEDEF( netsnmp_iterator_info );
-	if (NULL == iinfo)
-		goto error;
+	case COLUMN_PGMSOURCEGROUPADDRESS:
+		{
+			struct sockaddr_in s4;
+			if (AF_INET == sock->send_gsr.gsr_group.ss_family)
+				memcpy (&s4, &sock->send_gsr.gsr_group, sizeof(s4));
+			else
+				memset (&s4, 0, sizeof(s4));
+			pgm_snmp_value_set (value, ASN_IPADDRESS,
+					    (const u_char*)&s4.sin_addr.s_addr,
+					    sizeof(struct in_addr) );
+		}
+		break;
 
-	iinfo->get_first_data_point 	= pgmSourceConfigTable_get_first_data_point;
-	iinfo->get_next_data_point 	= pgmSourceConfigTable_get_next_data_point;
-	iinfo->free_loop_context_at_end = pgmSourceConfigTable_free_loop_context;
-	iinfo->table_reginfo        	= table_info;
+	case COLUMN_PGMSOURCEDESTPORT:
+		{
+			const unsigned dport = pgm_ntohs (sock->dport);
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&dport, sizeof(dport) );
+		}
+		break;
 
-	return netsnmp_register_table_iterator (reg, iinfo);
+/* copy index[0] */
+	case COLUMN_PGMSOURCESOURCEGSI:
+		pgm_snmp_value_set (value, ASN_OCTET_STR,
+				    (const u_char*)indexes->val.string,
+				    indexes->val_len);
+		break;
 
-error:
-	if (table_info && table_info->indexes)		/* table_data_free_func() is internal */
-		snmp_free_var (table_info->indexes);
-	SNMP_FREE( table_info );
-	SNMP_FREE( iinfo );
-	netsnmp_handler_registration_free (reg);
+/* copy index[1] */
+	case COLUMN_PGMSOURCESOURCEPORTNUMBER:
+		pgm_snmp_value_set (value, ASN_UNSIGNED,
+				    (const u_char*)indexes->next_variable->val.integer,
+				    indexes->next_variable->val_len);
+	
+		break;
 
-	return -1;
+	default:
+		snmp_log (LOG_ERR, "pgmSourceTable_column: unknown column.\n");
+		break;
+	}
 }
 
-/* called for first row of data in SNMP table
- *
- * goal is to cache all the relevant data for subsequent get_next_data_point (row) calls in my_loop_context,
- * optionally returns my_data_context.
- *
- * returns answer or NULL
+/*
+ * pgmSourceConfigTable
  */
 
 static
-netsnmp_variable_list*
-pgmSourceConfigTable_get_first_data_point(
-	void**			my_loop_context,	/* valid through one query of multiple "data points" */
-	void**			my_data_context,	/* answer blob which is passed to handler() */
-	netsnmp_variable_list*	put_index_data,		/* answer */
-	netsnmp_iterator_info*	mydata			/* iinfo on init() */
+void
+pgmSourceConfigTable_column (
+	const pgm_sock_t*	     const restrict sock,
+	const pgm_peer_t*	     const restrict peer,
+	const netsnmp_variable_list* const restrict indexes,
+	const unsigned				    colnum,
+	pgm_snmp_value_t*	     const restrict value
 	)
 {
 /* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-        pgm_assert (NULL != my_data_context);
-        pgm_assert (NULL != put_index_data);
-	pgm_assert (NULL != mydata);
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != indexes);
+	pgm_assert (NULL != value);
 
-        pgm_debug ("pgmSourceConfigTable_get_first_data_point (my_loop_context:%p my_data_context:%p put_index_data:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)my_data_context,
-		(const void*)put_index_data,
-		(const void*)mydata);
+	switch (colnum) {
 
-	pgm_rwlock_reader_lock (&pgm_sock_list_lock);
-
-	if (NULL == pgm_sock_list) {
-		pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
-		return NULL;
-	}
+	case COLUMN_PGMSOURCETTL:
+		{
+			const unsigned hops = sock->hops;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&hops, sizeof(hops) );
+		}
+		break;
 
-/* create our own context for this SNMP loop */
-	pgm_snmp_context_t* context = pgm_new0 (pgm_snmp_context_t, 1);
-	context->list = pgm_sock_list;
-	*my_loop_context = context;
+	case COLUMN_PGMSOURCEADVMODE:
+		{
+			const unsigned adv_mode = 0 == sock->adv_mode ? PGMSOURCEADVMODE_TIME : PGMSOURCEADVMODE_DATA;
+			pgm_snmp_value_set (value, ASN_INTEGER,
+					    (const u_char*)&adv_mode, sizeof(adv_mode) );
+		}
+		break;
 
-/* pass on for generic row access */
-	return pgmSourceConfigTable_get_next_data_point (my_loop_context, my_data_context, put_index_data, mydata);
-}
+/* FIXED: pgmSourceLateJoin = disable(2) */
+	case COLUMN_PGMSOURCELATEJOIN:
+		{
+			const unsigned late_join = PGMSOURCELATEJOIN_DISABLE;
+			pgm_snmp_value_set (value, ASN_INTEGER,
+					    (const u_char*)&late_join, sizeof(late_join) );
+		}
+		break;
 
-static
-netsnmp_variable_list*
-pgmSourceConfigTable_get_next_data_point(
-	void**			my_loop_context,
-	void**			my_data_context,
-	netsnmp_variable_list*	put_index_data,
-	netsnmp_iterator_info*	mydata
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-        pgm_assert (NULL != my_data_context);
-        pgm_assert (NULL != put_index_data);
-	pgm_assert (NULL != mydata);
+	case COLUMN_PGMSOURCETXWMAXRTE:
+		{
+			const unsigned txw_max_rte = sock->txw_max_rte;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&txw_max_rte, sizeof(txw_max_rte) );
+		}
+		break;
 
-        pgm_debug ("pgmSourceConfigTable_get_next_data_point (my_loop_context:%p my_data_context:%p put_index_data:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)my_data_context,
-		(const void*)put_index_data,
-		(const void*)mydata);
+	case COLUMN_PGMSOURCETXWSECS:
+		{
+			const unsigned txw_secs = sock->txw_secs;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&txw_secs, sizeof(txw_secs) );
+		}
+		break;
 
-	pgm_snmp_context_t* context = (pgm_snmp_context_t*)*my_loop_context;
-	netsnmp_variable_list *idx = put_index_data;
+/* FIXED: TXW_ADV_SECS = 0 */
+	case COLUMN_PGMSOURCETXWADVSECS:
+		{
+			const unsigned txw_adv_secs = 0;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&txw_adv_secs, sizeof(txw_adv_secs) );
+		}
+		break;
 
-	if (NULL == context->list)
-		return NULL;
+/* FIXED: pgmSourceAdvIvl = TXW_ADV_SECS * 1000 = 0 */
+	case COLUMN_PGMSOURCEADVIVL:
+		{
+			const unsigned adv_ivl = 0;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&adv_ivl, sizeof(adv_ivl) );
+		}
+		break;
 
-	pgm_sock_t* sock = context->list->data;
+	case COLUMN_PGMSOURCESPMIVL:
+		{
+			const unsigned spm_ivl = pgm_to_msecs (sock->spm_ambient_interval);
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&spm_ivl, sizeof(spm_ivl) );
+		}
+		break;
 
-/* pgmSourceGlobalId */
-	char gsi[ PGM_GSISTRLEN ];
-	pgm_gsi_print_r (&sock->tsi.gsi, gsi, sizeof(gsi));
-	snmp_set_var_typed_value (idx, ASN_OCTET_STR, (const u_char*)&gsi, strlen (gsi));
-	idx = idx->next_variable;
+/* TODO: IHB_MIN */
+	case COLUMN_PGMSOURCESPMHEARTBEATIVLMIN:
+		{
+			const unsigned ihb_min = 0;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&ihb_min, sizeof(ihb_min) );
+		}
+		break;
 
-/* pgmSourceSourcePort */
-	const unsigned sport = pgm_ntohs (sock->tsi.sport);
-	snmp_set_var_typed_value (idx, ASN_UNSIGNED, (const u_char*)&sport, sizeof(sport));
+/* TODO: IHB_MAX */
+	case COLUMN_PGMSOURCESPMHEARTBEATIVLMAX:
+		{
+			const unsigned ihb_max = 0;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&ihb_max, sizeof(ihb_max) );
+		}
+		break;
 
-	*my_data_context = sock;
-	context->list = context->list->next;
+/* NAK_BO_IVL */
+	case COLUMN_PGMSOURCERDATABACKOFFIVL:
+		{
+			const unsigned nak_bo_ivl = pgm_to_msecs (sock->nak_bo_ivl);
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&nak_bo_ivl, sizeof(nak_bo_ivl) );
+		}
+		break;
 
-	return put_index_data;
-}
+/* FIXED: pgmSourceFEC = disabled(1) */
+	case COLUMN_PGMSOURCEFEC:
+		{
+			const unsigned fec = (sock->use_ondemand_parity || sock->use_proactive_parity) ? 1 : 0;
+			pgm_snmp_value_set (value, ASN_INTEGER,
+					    (const u_char*)&fec, sizeof(fec) );
+		}
+		break;
 
-static
-void
-pgmSourceConfigTable_free_loop_context (
-	void*			my_loop_context,
-	netsnmp_iterator_info*	mydata
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-	pgm_assert (NULL != mydata);
+/* FIXED: pgmSourceFECTransmissionGrpSize = 0 */
+	case COLUMN_PGMSOURCEFECTRANSMISSIONGRPSIZE:
+		{
+			const unsigned fec_tgs = sock->rs_k;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&fec_tgs, sizeof(fec_tgs) );
+		}
+		break;
 
-        pgm_debug ("pgmSourceConfigTable_free_loop_context (my_loop_context:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)mydata);
+/* FIXED: pgmSourceFECProactiveParitySize = 0 */
+	case COLUMN_PGMSOURCEFECPROACTIVEPARITYSIZE:
+		{
+			const unsigned fec_paps = sock->rs_proactive_h;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&fec_paps, sizeof(fec_paps) );
+		}
+		break;
 
-	pgm_snmp_context_t* context = (pgm_snmp_context_t*)my_loop_context;
-	pgm_free (context);
-	my_loop_context = NULL;
+/* IPv6 not supported */
+	case COLUMN_PGMSOURCESPMPATHADDRESS:
+		{
+			struct sockaddr_in s4;
+			if (sock->recv_gsr_len > 0 &&
+			    AF_INET == sock->recv_gsr[0].gsr_source.ss_family)
+				memcpy (&s4, &sock->recv_gsr[0].gsr_source, sizeof(s4));
+			else
+				memset (&s4, 0, sizeof(s4));
+			pgm_snmp_value_set (value, ASN_IPADDRESS,
+					    (const u_char*)&s4.sin_addr.s_addr,
+					    sizeof(struct in_addr) );
+		}
+		break;
 
-	pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
+	default:
+		snmp_log (LOG_ERR, "pgmSourceConfigTable_column: unknown column.\n");
+		break;
+	}
 }
 
+/*
+ * pgmSourcePerformanceTable
+ */
+
 static
-int
-pgmSourceConfigTable_handler (
-	netsnmp_mib_handler*		handler,
-	netsnmp_handler_registration*	reginfo,
-	netsnmp_agent_request_info*	reqinfo,
-	netsnmp_request_info*		requests
+void
+pgmSourcePerformanceTable_column (
+	const pgm_sock_t*	     const restrict sock,
+	const pgm_peer_t*	     const restrict peer,
+	const netsnmp_variable_list* const restrict indexes,
+	const unsigned				    colnum,
+	pgm_snmp_value_t*	     const restrict value
 	)
 {
 /* pre-conditions */
-        pgm_assert (NULL != handler);
-        pgm_assert (NULL != reginfo);
-        pgm_assert (NULL != reqinfo);
-        pgm_assert (NULL != requests);
-
-        pgm_debug ("pgmSourceConfigTable_handler (handler:%p reginfo:%p reqinfo:%p requests:%p)",
-                (const void*)handler,
-		(const void*)reginfo,
-		(const void*)reqinfo,
-		(const void*)requests);
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != indexes);
+	pgm_assert (NULL != value);
 
-	switch (reqinfo->mode) {
+	const pgm_txw_t* window = (const pgm_txw_t*)sock->window;
 
-/* Read-support (also covers GetNext requests) */
+	switch (colnum) {
 
-	case MODE_GET:
-		for (netsnmp_request_info* request = requests;
-		     request;
-		     request = request->next)
+	case COLUMN_PGMSOURCEDATABYTESSENT:
 		{
-			const pgm_sock_t* sock = (pgm_sock_t*)netsnmp_extract_iterator_context (request);
-			if (NULL == sock) {
-				netsnmp_set_request_error (reqinfo, request, SNMP_NOSUCHINSTANCE);
-				continue;
-			}
+			const unsigned data_bytes = sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&data_bytes, sizeof(data_bytes) );
+		}
+		break;
 
-			netsnmp_variable_list *var = request->requestvb;
-			netsnmp_table_request_info* table_info = netsnmp_extract_table_info (request);
-			if (NULL == table_info) {
-				snmp_log (LOG_ERR, "pgmSourceTable_handler: empty table request info.\n");
-				continue;
-			}
+	case COLUMN_PGMSOURCEDATAMSGSSENT:
+		{
+			const unsigned data_msgs = sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&data_msgs, sizeof(data_msgs) );
+		}
+		break;
 
-			switch (table_info->colnum) {
+	case COLUMN_PGMSOURCEBYTESBUFFERED:
+		{
+			const unsigned bytes_buffered = sock->can_send_data ? pgm_txw_size (window) : 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&bytes_buffered, sizeof(bytes_buffered) );
+		}
+		break;
 
-			case COLUMN_PGMSOURCETTL:
-				{
-					const unsigned hops = sock->hops;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&hops, sizeof(hops) );
-				}
-				break;
+	case COLUMN_PGMSOURCEMSGSBUFFERED:
+		{
+			const unsigned msgs_buffered = sock->can_send_data ? pgm_txw_length (window) : 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&msgs_buffered, sizeof(msgs_buffered) );
+		}
+		break;
 
-			case COLUMN_PGMSOURCEADVMODE:
-				{
-					const unsigned adv_mode = 0 == sock->adv_mode ? PGMSOURCEADVMODE_TIME : PGMSOURCEADVMODE_DATA;
-					snmp_set_var_typed_value (var, ASN_INTEGER,
-								  (const u_char*)&adv_mode, sizeof(adv_mode) );
-				}
-				break;
+/* PGM_PC_SOURCE_SELECTIVE_BYTES_RETRANSMITTED + COLUMN_PGMSOURCEPARITYBYTESRETRANSMITTED */
+	case COLUMN_PGMSOURCEBYTESRETRANSMITTED:
+		{
+			const unsigned bytes_resent = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_BYTES_RETRANSMITTED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&bytes_resent, sizeof(bytes_resent) );
+		}
+		break;
 
-/* FIXED: pgmSourceLateJoin = disable(2) */
-			case COLUMN_PGMSOURCELATEJOIN:
-				{
-					const unsigned late_join = PGMSOURCELATEJOIN_DISABLE;
-					snmp_set_var_typed_value (var, ASN_INTEGER,
-								  (const u_char*)&late_join, sizeof(late_join) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCETXWMAXRTE:
-				{
-					const unsigned txw_max_rte = sock->txw_max_rte;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&txw_max_rte, sizeof(txw_max_rte) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCETXWSECS:
-				{
-					const unsigned txw_secs = sock->txw_secs;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&txw_secs, sizeof(txw_secs) );
-				}
-				break;
+/* PGM_PC_SOURCE_SELECTIVE_MSGS_RETRANSMITTED + COLUMN_PGMSOURCEPARITYMSGSRETRANSMITTED */
+	case COLUMN_PGMSOURCEMSGSRETRANSMITTED:
+		{
+			const unsigned msgs_resent = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_MSGS_RETRANSMITTED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&msgs_resent, sizeof(msgs_resent) );
+		}
+		break;
 
-/* FIXED: TXW_ADV_SECS = 0 */
-			case COLUMN_PGMSOURCETXWADVSECS:
-				{
-					const unsigned txw_adv_secs = 0;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&txw_adv_secs, sizeof(txw_adv_secs) );
-				}
-				break;
+	case COLUMN_PGMSOURCEBYTESSENT:
+		{
+			const unsigned bytes_sent = sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&bytes_sent, sizeof(bytes_sent) );
+		}
+		break;
 
-/* FIXED: pgmSourceAdvIvl = TXW_ADV_SECS * 1000 = 0 */
-			case COLUMN_PGMSOURCEADVIVL:
-				{
-					const unsigned adv_ivl = 0;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&adv_ivl, sizeof(adv_ivl) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCESPMIVL:
-				{
-					const unsigned spm_ivl = pgm_to_msecs (sock->spm_ambient_interval);
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&spm_ivl, sizeof(spm_ivl) );
-				}
-				break;
+/* COLUMN_PGMSOURCEPARITYNAKPACKETSRECEIVED + COLUMN_PGMSOURCESELECTIVENAKPACKETSRECEIVED */
+	case COLUMN_PGMSOURCERAWNAKSRECEIVED:
+		{
+			const unsigned nak_packets = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&nak_packets, sizeof(nak_packets) );
+		}
+		break;
 
-/* TODO: IHB_MIN */
-			case COLUMN_PGMSOURCESPMHEARTBEATIVLMIN:
-				{
-					const unsigned ihb_min = 0;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&ihb_min, sizeof(ihb_min) );
-				}
-				break;
+/* PGM_PC_SOURCE_SELECTIVE_NAKS_IGNORED + COLUMN_PGMSOURCEPARITYNAKSIGNORED */
+	case COLUMN_PGMSOURCENAKSIGNORED:
+		{
+			const unsigned naks_ignored = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_IGNORED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&naks_ignored, sizeof(naks_ignored) );
+		}
+		break;
 
-/* TODO: IHB_MAX */
-			case COLUMN_PGMSOURCESPMHEARTBEATIVLMAX:
-				{
-					const unsigned ihb_max = 0;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&ihb_max, sizeof(ihb_max) );
-				}
-				break;
+	case COLUMN_PGMSOURCECKSUMERRORS:
+		{
+			const unsigned cksum_errors = sock->cumulative_stats[PGM_PC_SOURCE_CKSUM_ERRORS];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&cksum_errors, sizeof(cksum_errors) );
+		}
+		break;
 
-/* NAK_BO_IVL */
-			case COLUMN_PGMSOURCERDATABACKOFFIVL:
-				{
-					const unsigned nak_bo_ivl = pgm_to_msecs (sock->nak_bo_ivl);
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&nak_bo_ivl, sizeof(nak_bo_ivl) );
-				}
-				break;
+	case COLUMN_PGMSOURCEMALFORMEDNAKS:
+		{
+			const unsigned malformed_naks = sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&malformed_naks, sizeof(malformed_naks) );
+		}
+		break;
 
-/* FIXED: pgmSourceFEC = disabled(1) */
-			case COLUMN_PGMSOURCEFEC:
-				{
-					const unsigned fec = (sock->use_ondemand_parity || sock->use_proactive_parity) ? 1 : 0;
-					snmp_set_var_typed_value (var, ASN_INTEGER,
-								  (const u_char*)&fec, sizeof(fec) );
-				}
-				break;
+	case COLUMN_PGMSOURCEPACKETSDISCARDED:
+		{
+			const unsigned packets_discarded = sock->cumulative_stats[PGM_PC_SOURCE_PACKETS_DISCARDED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&packets_discarded, sizeof(packets_discarded) );
+		}
+		break;
 
-/* FIXED: pgmSourceFECTransmissionGrpSize = 0 */
-			case COLUMN_PGMSOURCEFECTRANSMISSIONGRPSIZE:
-				{
-					const unsigned fec_tgs = sock->rs_k;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&fec_tgs, sizeof(fec_tgs) );
-				}
-				break;
+/* PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED + COLUMN_PGMSOURCEPARITYNAKSRECEIVED */
+	case COLUMN_PGMSOURCENAKSRCVD:
+		{
+			const unsigned naks_received = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&naks_received, sizeof(naks_received) );
+		}
+		break;
 
-/* FIXED: pgmSourceFECProactiveParitySize = 0 */
-			case COLUMN_PGMSOURCEFECPROACTIVEPARITYSIZE:
-				{
-					const unsigned fec_paps = sock->rs_proactive_h;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&fec_paps, sizeof(fec_paps) );
-				}
-				break;
+/* FIXED: 0 */
+	case COLUMN_PGMSOURCEPARITYBYTESRETRANSMITTED:
+		{
+			const unsigned parity_bytes_resent = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&parity_bytes_resent, sizeof(parity_bytes_resent) );
+		}
+		break;
 
-/* IPv6 not supported */
-			case COLUMN_PGMSOURCESPMPATHADDRESS:
-				{
-					struct sockaddr_in s4;
-					if (AF_INET == sock->recv_gsr[0].gsr_source.ss_family)
-						memcpy (&s4, &sock->recv_gsr[0].gsr_source, sizeof(s4));
-					else
-						memset (&s4, 0, sizeof(s4));
-					snmp_set_var_typed_value (var, ASN_IPADDRESS,
-								  (const u_char*)&s4.sin_addr.s_addr,
-								  sizeof(struct in_addr) );
-				}
-				break;
-
-			default:
-				snmp_log (LOG_ERR, "pgmSourceConfigTable_handler: unknown column.\n");
-				break;
-			}
+	case COLUMN_PGMSOURCESELECTIVEBYTESRETRANSMITED:
+		{
+			const unsigned selective_bytes_resent = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_BYTES_RETRANSMITTED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&selective_bytes_resent, sizeof(selective_bytes_resent) );
 		}
 		break;
 
-	case MODE_SET_RESERVE1:
-	default:
-		snmp_log (LOG_ERR, "pgmSourceConfigTable_handler: unsupported mode.\n");
+/* FIXED: 0 */
+	case COLUMN_PGMSOURCEPARITYMSGSRETRANSMITTED:
+		{
+			const unsigned parity_msgs_resent = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&parity_msgs_resent, sizeof(parity_msgs_resent) );
+		}
 		break;
 
-	}
+	case COLUMN_PGMSOURCESELECTIVEMSGSRETRANSMITTED:
+		{
+			const unsigned selective_msgs_resent = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_MSGS_RETRANSMITTED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&selective_msgs_resent, sizeof(selective_msgs_resent) );
+		}
+		break;
 
-	return SNMP_ERR_NOERROR;
-}
+/* FIXED: 0 */
+	case COLUMN_PGMSOURCEBYTESADMIT:
+		{
+			const unsigned bytes_admit = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&bytes_admit, sizeof(bytes_admit) );
+		}
+		break;
 
-/*
- * pgmSourcePerformanceTable
- */
+/* FIXED: 0 */
+	case COLUMN_PGMSOURCEMSGSADMIT:
+		{
+			const unsigned msgs_admit = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&msgs_admit, sizeof(msgs_admit) );
+		}
+		break;
 
-static
-int
-initialize_table_pgmSourcePerformanceTable (void)
-{
-	pgm_debug ("initialize_table_pgmSourcePerformanceTable ()");
+/* FIXED: 0 */
+	case COLUMN_PGMSOURCEPARITYNAKPACKETSRECEIVED:
+		{
+			const unsigned parity_nak_packets = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&parity_nak_packets, sizeof(parity_nak_packets) );
+		}
+		break;
 
-	static const oid pgmSourcePerformanceTable_oid[] = {1,3,6,1,3,112,1,2,100,4};
-	netsnmp_table_registration_info* table_info = NULL;
-	netsnmp_iterator_info* iinfo = NULL;
-	netsnmp_handler_registration* reg = NULL;
+	case COLUMN_PGMSOURCESELECTIVENAKPACKETSRECEIVED:
+		{
+			const unsigned selective_nak_packets = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&selective_nak_packets, sizeof(selective_nak_packets) );
+		}
+		break;
 
-	reg = netsnmp_create_handler_registration ("pgmSourcePerformanceTable",		pgmSourcePerformanceTable_handler,
-						   pgmSourcePerformanceTable_oid,	OID_LENGTH( pgmSourcePerformanceTable_oid ),
-						   HANDLER_CAN_RONLY);
-	if (NULL == reg)
-		goto error;
+/* FIXED: 0 */
+	case COLUMN_PGMSOURCEPARITYNAKSRECEIVED:
+		{
+			const unsigned parity_naks = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&parity_naks, sizeof(parity_naks) );
+		}
+		break;
 
-	table_info = SNMP_MALLOC_TYPEDEF( netsnmp_table_registration_info );
-	if (NULL == table_info)
-		goto error;
+	case COLUMN_PGMSOURCESELECTIVENAKSRECEIVED:
+		{
+			const unsigned selective_naks = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&selective_naks, sizeof(selective_naks) );
+		}
+		break;
 
-	table_info->min_column = COLUMN_PGMSOURCEDATABYTESSENT;
-	table_info->max_column = COLUMN_PGMSOURCENNAKERRORS;
+/* FIXED: 0 */
+	case COLUMN_PGMSOURCEPARITYNAKSIGNORED:
+		{
+			const unsigned parity_naks_ignored = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&parity_naks_ignored, sizeof(parity_naks_ignored) );
+		}
+		break;
 
-	netsnmp_table_helper_add_indexes (table_info,
-					  ASN_OCTET_STR,  /* index: pgmSourceGlobalId */
-					  ASN_UNSIGNED,  /* index: pgmSourceSourcePort */
-					  0);
+	case COLUMN_PGMSOURCESELECTIVENAKSIGNORED:
+		{
+			const unsigned selective_naks_ignored = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_IGNORED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&selective_naks_ignored, sizeof(selective_naks_ignored) );
+		}
+		break;
 
-	iinfo = SNMP_MALLOC_TYPEDEF( netsnmp_iterator_info );
-	if (NULL == iinfo)
-		goto error;
+	case COLUMN_PGMSOURCEACKERRORS:
+		{
+			const unsigned ack_errors = sock->cumulative_stats[PGM_PC_SOURCE_ACK_ERRORS];;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&ack_errors, sizeof(ack_errors) );
+		}
+		break;
 
-	iinfo->get_first_data_point 	= pgmSourcePerformanceTable_get_first_data_point;
-	iinfo->get_next_data_point  	= pgmSourcePerformanceTable_get_next_data_point;
-	iinfo->free_loop_context_at_end = pgmSourcePerformanceTable_free_loop_context;
-	iinfo->table_reginfo        	= table_info;
+	case COLUMN_PGMSOURCEPGMCCACKER:
+		{
+			struct sockaddr_in s4;
+			if (AF_INET == sock->acker_nla.ss_family)
+				memcpy (&s4, &sock->acker_nla, sizeof(s4));
+			else
+				memset (&s4, 0, sizeof(s4));
+			pgm_snmp_value_set (value, ASN_IPADDRESS,
+					    (const u_char*)&s4.sin_addr.s_addr,
+					    sizeof(struct in_addr) );
+		}
+		break;
 
-	return netsnmp_register_table_iterator (reg, iinfo);
+/* data bytes per second over the last sampled second */
+	case COLUMN_PGMSOURCETRANSMISSIONCURRENTRATE:
+		{
+			uint64_t rates[PGM_STATS_RATE_MAX];
+			pgm_stats_ring_rates (sock->rates, 1, rates);
+			const unsigned tx_current_rate = (unsigned)rates[PGM_STATS_RATE_BYTES];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&tx_current_rate, sizeof(tx_current_rate) );
+		}
+		break;
 
-error:
-	if (table_info && table_info->indexes)		/* table_data_free_func() is internal */
-		snmp_free_var (table_info->indexes);
-	SNMP_FREE( table_info );
-	SNMP_FREE( iinfo );
-	netsnmp_handler_registration_free (reg);
+	case COLUMN_PGMSOURCEACKPACKETSRECEIVED:
+		{
+			const unsigned ack_packets = sock->cumulative_stats[PGM_PC_SOURCE_ACK_PACKETS_RECEIVED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&ack_packets, sizeof(ack_packets) );
+		}
+		break;
 
-	return -1;
-}
+/* COLUMN_PGMSOURCEPARITYNNAKPACKETSRECEIVED + COLUMN_PGMSOURCESELECTIVENNAKPACKETSRECEIVED */
+	case COLUMN_PGMSOURCENNAKPACKETSRECEIVED:
+		{
+			const unsigned nnak_packets = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NNAK_PACKETS_RECEIVED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&nnak_packets, sizeof(nnak_packets) );
+		}
+		break;
 
-/* called for first row of data in SNMP table
- *
- * goal is to cache all the relevant data for subsequent get_next_data_point (row) calls in my_loop_context,
- * optionally returns my_data_context.
- *
- * returns answer or NULL
- */
+/* FIXED: 0 */
+	case COLUMN_PGMSOURCEPARITYNNAKPACKETSRECEIVED:
+		{
+			const unsigned parity_nnak_packets = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&parity_nnak_packets, sizeof(parity_nnak_packets) );
+		}
+		break;
 
-static
-netsnmp_variable_list*
-pgmSourcePerformanceTable_get_first_data_point (
-	void**			my_loop_context,	/* valid through one query of multiple "data points" */
-	void**			my_data_context,	/* answer blob which is passed to handler() */
-	netsnmp_variable_list*	put_index_data,		/* answer */
-	netsnmp_iterator_info*	mydata			/* iinfo on init() */
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-        pgm_assert (NULL != my_data_context);
-        pgm_assert (NULL != put_index_data);
-	pgm_assert (NULL != mydata);
+	case COLUMN_PGMSOURCESELECTIVENNAKPACKETSRECEIVED:
+		{
+			const unsigned selective_nnak_packets = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NNAK_PACKETS_RECEIVED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&selective_nnak_packets, sizeof(selective_nnak_packets) );
+		}
+		break;
 
-        pgm_debug ("pgmSourcePerformanceTable_get_first_data_point (my_loop_context:%p my_data_context:%p put_index_data:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)my_data_context,
-		(const void*)put_index_data,
-		(const void*)mydata);
+/* COLUMN_PGMSOURCEPARITYNNAKSRECEIVED + COLUMN_PGMSOURCESELECTIVENNAKSRECEIVED */
+	case COLUMN_PGMSOURCENNAKSRECEIVED:
+		{
+			const unsigned nnaks_received = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NNAKS_RECEIVED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&nnaks_received, sizeof(nnaks_received) );
+		}
+		break;
 
-	pgm_rwlock_reader_lock (&pgm_sock_list_lock);
+/* FIXED: 0 */
+	case COLUMN_PGMSOURCEPARITYNNAKSRECEIVED:
+		{
+			const unsigned parity_nnaks = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&parity_nnaks, sizeof(parity_nnaks) );
+		}
+		break;
 
-	if (NULL == pgm_sock_list) {
-		pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
-		return NULL;
-	}
+	case COLUMN_PGMSOURCESELECTIVENNAKSRECEIVED:
+		{
+			const unsigned selective_nnaks = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NNAKS_RECEIVED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&selective_nnaks, sizeof(selective_nnaks) );
+		}
+		break;
 
-/* create our own context for this SNMP loop */
-	pgm_snmp_context_t* context = pgm_new0 (pgm_snmp_context_t, 1);
-	context->list = pgm_sock_list;
-	*my_loop_context = context;
+	case COLUMN_PGMSOURCENNAKERRORS:
+		{
+			const unsigned malformed_nnaks = sock->cumulative_stats[PGM_PC_SOURCE_NNAK_ERRORS];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&malformed_nnaks, sizeof(malformed_nnaks) );
+		}
+		break;
 
-/* pass on for generic row access */
-	return pgmSourcePerformanceTable_get_next_data_point (my_loop_context, my_data_context, put_index_data, mydata);
+	default:
+		snmp_log (LOG_ERR, "pgmSourcePerformanceTable_column: unknown column.\n");
+		break;
+	}
 }
 
+/*
+ * pgmReceiverTable
+ */
+
 static
-netsnmp_variable_list*
-pgmSourcePerformanceTable_get_next_data_point (
-	void**			my_loop_context,
-	void**			my_data_context,
-	netsnmp_variable_list*	put_index_data,
-	netsnmp_iterator_info*	mydata
+void
+pgmReceiverTable_column (
+	const pgm_sock_t*	     const restrict sock,
+	const pgm_peer_t*	     const restrict peer,
+	const netsnmp_variable_list* const restrict indexes,
+	const unsigned				    colnum,
+	pgm_snmp_value_t*	     const restrict value
 	)
 {
 /* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-        pgm_assert (NULL != my_data_context);
-        pgm_assert (NULL != put_index_data);
-	pgm_assert (NULL != mydata);
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != peer);
+	pgm_assert (NULL != indexes);
+	pgm_assert (NULL != value);
 
-        pgm_debug ("pgmSourcePerformanceTable_get_next_data_point (my_loop_context:%p my_data_context:%p put_index_data:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)my_data_context,
-		(const void*)put_index_data,
-		(const void*)mydata);
+	switch (colnum) {
 
-	pgm_snmp_context_t* context = (pgm_snmp_context_t*)*my_loop_context;
-	netsnmp_variable_list *idx = put_index_data;
+	case COLUMN_PGMRECEIVERGROUPADDRESS:
+		{
+			struct sockaddr_in s4;
+			if (AF_INET == peer->group_nla.ss_family)
+				memcpy (&s4, &peer->group_nla, sizeof(s4));
+			else
+				memset (&s4, 0, sizeof(s4));
+			pgm_snmp_value_set (value, ASN_IPADDRESS,
+					    (const u_char*)&s4.sin_addr.s_addr,
+					    sizeof(struct in_addr) );
+		}
+		break;
 
-	if (NULL == context->list)
-		return NULL;
+/* by definition same as sock */
+	case COLUMN_PGMRECEIVERDESTPORT:
+		{
+			const unsigned dport = pgm_ntohs (sock->dport);
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&dport, sizeof(dport) );
+		}
+		break;
 
-	pgm_sock_t* sock = context->list->data;
+	case COLUMN_PGMRECEIVERSOURCEADDRESS:
+		{
+			struct sockaddr_in s4;
+			if (AF_INET == peer->nla.ss_family)
+				memcpy (&s4, &peer->nla, sizeof(s4));
+			else
+				memset (&s4, 0, sizeof(s4));
+			pgm_snmp_value_set (value, ASN_IPADDRESS,
+					    (const u_char*)&s4.sin_addr.s_addr,
+					    sizeof(struct in_addr) );
+		}
+		break;
 
-/* pgmSourceGlobalId */
-	char gsi[ PGM_GSISTRLEN ];
-	pgm_gsi_print_r (&sock->tsi.gsi, gsi, sizeof(gsi));
-	snmp_set_var_typed_value (idx, ASN_OCTET_STR, (const u_char*)&gsi, strlen (gsi));
-	idx = idx->next_variable;
+	case COLUMN_PGMRECEIVERLASTHOP:
+		{
+			struct sockaddr_in s4;
+			if (AF_INET == peer->local_nla.ss_family)
+				memcpy (&s4, &peer->local_nla, sizeof(s4));
+			else
+				memset (&s4, 0, sizeof(s4));
+			pgm_snmp_value_set (value, ASN_IPADDRESS,
+					    (const u_char*)&s4.sin_addr.s_addr,
+					    sizeof(struct in_addr) );
+		}
+		break;
 
-/* pgmSourceSourcePort */
-	const unsigned sport = pgm_ntohs (sock->tsi.sport);
-	snmp_set_var_typed_value (idx, ASN_UNSIGNED, (const u_char*)&sport, sizeof(sport));
+/* copy index[0] */
+	case COLUMN_PGMRECEIVERSOURCEGSI:
+		pgm_snmp_value_set (value, ASN_OCTET_STR,
+				    (const u_char*)indexes->val.string,
+				    indexes->val_len);
+		break;
+
+/* copy index[1] */
+	case COLUMN_PGMRECEIVERSOURCEPORTNUMBER:
+		pgm_snmp_value_set (value, ASN_UNSIGNED,
+				    (const u_char*)indexes->next_variable->val.integer,
+				    indexes->next_variable->val_len);
+		break;
 
-	*my_data_context = sock;
-	context->list = context->list->next;
+/* copy index[2] */
+	case COLUMN_PGMRECEIVERUNIQUEINSTANCE:
+		pgm_snmp_value_set (value, ASN_UNSIGNED,
+				    (const u_char*)indexes->next_variable->next_variable->val.integer,
+				    indexes->next_variable->next_variable->val_len);
+		break;
 
-	return put_index_data;
+	default:
+		snmp_log (LOG_ERR, "pgmReceiverTable_column: unknown column.\n");
+		break;
+	}
 }
 
-static
-void
-pgmSourcePerformanceTable_free_loop_context (
-	void*			my_loop_context,
-	netsnmp_iterator_info*	mydata
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-	pgm_assert (NULL != mydata);
-
-        pgm_debug ("pgmPerformanceSourceTable_free_loop_context (my_loop_context:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)mydata);
- 
-	pgm_snmp_context_t* context = (pgm_snmp_context_t*)my_loop_context;
-	pgm_free (context);
-	my_loop_context = NULL;
-
-	pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
-}
+/*
+ * pgmReceiverConfigTable
+ */
 
 static
-int
-pgmSourcePerformanceTable_handler (
-	netsnmp_mib_handler*		handler,
-	netsnmp_handler_registration*	reginfo,
-	netsnmp_agent_request_info*	reqinfo,
-	netsnmp_request_info*		requests
+void
+pgmReceiverConfigTable_column (
+	const pgm_sock_t*	     const restrict sock,
+	const pgm_peer_t*	     const restrict peer,
+	const netsnmp_variable_list* const restrict indexes,
+	const unsigned				    colnum,
+	pgm_snmp_value_t*	     const restrict value
 	)
 {
 /* pre-conditions */
-        pgm_assert (NULL != handler);
-        pgm_assert (NULL != reginfo);
-        pgm_assert (NULL != reqinfo);
-        pgm_assert (NULL != requests);
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != peer);
+	pgm_assert (NULL != indexes);
+	pgm_assert (NULL != value);
 
-        pgm_debug ("pgmSourcePerformanceTable_handler (handler:%p reginfo:%p reqinfo:%p requests:%p)",
-                (const void*)handler,
-		(const void*)reginfo,
-		(const void*)reqinfo,
-		(const void*)requests);
+	switch (colnum) {
 
-	switch (reqinfo->mode) {
+/* nak_bo_ivl from sock */
+	case COLUMN_PGMRECEIVERNAKBACKOFFIVL:
+		{
+			const unsigned nak_bo_ivl = sock->nak_bo_ivl;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&nak_bo_ivl, sizeof(nak_bo_ivl) );
+		}
+		break;
 
-/* Read-support (also covers GetNext requests) */
+/* nak_rpt_ivl from sock */
+	case COLUMN_PGMRECEIVERNAKREPEATIVL:
+		{
+			const unsigned nak_rpt_ivl = sock->nak_rpt_ivl;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&nak_rpt_ivl, sizeof(nak_rpt_ivl) );
+		}
+		break;
 
-	case MODE_GET:
-		for (netsnmp_request_info* request = requests;
-		     request;
-		     request = request->next)
+/* nak_ncf_retries from sock */
+	case COLUMN_PGMRECEIVERNAKNCFRETRIES:
 		{
-			const pgm_sock_t* sock = (pgm_sock_t*)netsnmp_extract_iterator_context (request);
-			if (NULL == sock) {
-				netsnmp_set_request_error (reqinfo, request, SNMP_NOSUCHINSTANCE);
-				continue;
-			}
+			const unsigned nak_ncf_retries = sock->nak_ncf_retries;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&nak_ncf_retries, sizeof(nak_ncf_retries) );
+		}
+		break;
 
-			const pgm_txw_t* window = (const pgm_txw_t*)sock->window;
+/* nak_rdata_ivl from sock */
+	case COLUMN_PGMRECEIVERNAKRDATAIVL:
+		{
+			const unsigned nak_rdata_ivl = sock->nak_rdata_ivl;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&nak_rdata_ivl, sizeof(nak_rdata_ivl) );
+		}
+		break;
 
-			netsnmp_variable_list *var = request->requestvb;
-			netsnmp_table_request_info* table_info = netsnmp_extract_table_info (request);
-			if (NULL == table_info) {
-				snmp_log (LOG_ERR, "pgmSourceTable_handler: empty table request info.\n");
-				continue;
-			}
+/* nak_data_retries from sock */
+	case COLUMN_PGMRECEIVERNAKDATARETRIES:
+		{
+			const unsigned nak_data_retries = sock->nak_data_retries;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&nak_data_retries, sizeof(nak_data_retries) );
+		}
+		break;
 
-			switch (table_info->colnum) {
-
-			case COLUMN_PGMSOURCEDATABYTESSENT:
-				{
-					const unsigned data_bytes = sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&data_bytes, sizeof(data_bytes) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCEDATAMSGSSENT:
-				{
-					const unsigned data_msgs = sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&data_msgs, sizeof(data_msgs) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCEBYTESBUFFERED:
-				{
-					const unsigned bytes_buffered = sock->can_send_data ? pgm_txw_size (window) : 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&bytes_buffered, sizeof(bytes_buffered) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCEMSGSBUFFERED:
-				{
-					const unsigned msgs_buffered = sock->can_send_data ? pgm_txw_length (window) : 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&msgs_buffered, sizeof(msgs_buffered) );
-				}
-				break;
+/* FIXED: pgmReceiverSendNaks = enabled(1) */
+	case COLUMN_PGMRECEIVERSENDNAKS:
+		{
+			const unsigned send_naks = PGMRECEIVERSENDNAKS_ENABLED;
+			pgm_snmp_value_set (value, ASN_INTEGER,
+					    (const u_char*)&send_naks, sizeof(send_naks) );
+		}
+		break;
 
-/* PGM_PC_SOURCE_SELECTIVE_BYTES_RETRANSMITTED + COLUMN_PGMSOURCEPARITYBYTESRETRANSMITTED */
-			case COLUMN_PGMSOURCEBYTESRETRANSMITTED:
-				{
-					const unsigned bytes_resent = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_BYTES_RETRANSMITTED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&bytes_resent, sizeof(bytes_resent) );
-				}
-				break;
+/* FIXED: pgmReceiverLateJoin = disabled(2) */
+	case COLUMN_PGMRECEIVERLATEJOIN:
+		{
+			const unsigned late_join = PGMRECEIVERLATEJOIN_DISABLED;
+			pgm_snmp_value_set (value, ASN_INTEGER,
+					    (const u_char*)&late_join, sizeof(late_join) );
+		}
+		break;
 
-/* PGM_PC_SOURCE_SELECTIVE_MSGS_RETRANSMITTED + COLUMN_PGMSOURCEPARITYMSGSRETRANSMITTED */
-			case COLUMN_PGMSOURCEMSGSRETRANSMITTED:
-				{
-					const unsigned msgs_resent = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_MSGS_RETRANSMITTED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&msgs_resent, sizeof(msgs_resent) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCEBYTESSENT:
-				{
-					const unsigned bytes_sent = sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&bytes_sent, sizeof(bytes_sent) );
-				}
-				break;
-
-/* COLUMN_PGMSOURCEPARITYNAKPACKETSRECEIVED + COLUMN_PGMSOURCESELECTIVENAKPACKETSRECEIVED */
-			case COLUMN_PGMSOURCERAWNAKSRECEIVED:
-				{
-					const unsigned nak_packets = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&nak_packets, sizeof(nak_packets) );
-				}
-				break;
-
-/* PGM_PC_SOURCE_SELECTIVE_NAKS_IGNORED + COLUMN_PGMSOURCEPARITYNAKSIGNORED */
-			case COLUMN_PGMSOURCENAKSIGNORED:
-				{
-					const unsigned naks_ignored = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_IGNORED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&naks_ignored, sizeof(naks_ignored) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCECKSUMERRORS:
-				{
-					const unsigned cksum_errors = sock->cumulative_stats[PGM_PC_SOURCE_CKSUM_ERRORS];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&cksum_errors, sizeof(cksum_errors) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCEMALFORMEDNAKS:
-				{
-					const unsigned malformed_naks = sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&malformed_naks, sizeof(malformed_naks) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCEPACKETSDISCARDED:
-				{
-					const unsigned packets_discarded = sock->cumulative_stats[PGM_PC_SOURCE_PACKETS_DISCARDED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&packets_discarded, sizeof(packets_discarded) );
-				}
-				break;
-
-/* PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED + COLUMN_PGMSOURCEPARITYNAKSRECEIVED */
-			case COLUMN_PGMSOURCENAKSRCVD:
-				{
-					const unsigned naks_received = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&naks_received, sizeof(naks_received) );
-				}
-				break;
-
-/* FIXED: 0 */
-			case COLUMN_PGMSOURCEPARITYBYTESRETRANSMITTED:
-				{
-					const unsigned parity_bytes_resent = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&parity_bytes_resent, sizeof(parity_bytes_resent) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCESELECTIVEBYTESRETRANSMITED:
-				{
-					const unsigned selective_bytes_resent = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_BYTES_RETRANSMITTED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&selective_bytes_resent, sizeof(selective_bytes_resent) );
-				}
-				break;
-
-/* FIXED: 0 */
-			case COLUMN_PGMSOURCEPARITYMSGSRETRANSMITTED:
-				{
-					const unsigned parity_msgs_resent = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&parity_msgs_resent, sizeof(parity_msgs_resent) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCESELECTIVEMSGSRETRANSMITTED:
-				{
-					const unsigned selective_msgs_resent = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_MSGS_RETRANSMITTED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&selective_msgs_resent, sizeof(selective_msgs_resent) );
-				}
-				break;
-
-/* FIXED: 0 */
-			case COLUMN_PGMSOURCEBYTESADMIT:
-				{
-					const unsigned bytes_admit = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&bytes_admit, sizeof(bytes_admit) );
-				}
-				break;
-
-/* FIXED: 0 */
-			case COLUMN_PGMSOURCEMSGSADMIT:
-				{
-					const unsigned msgs_admit = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&msgs_admit, sizeof(msgs_admit) );
-				}
-				break;
-
-/* FIXED: 0 */
-			case COLUMN_PGMSOURCEPARITYNAKPACKETSRECEIVED:
-				{
-					const unsigned parity_nak_packets = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&parity_nak_packets, sizeof(parity_nak_packets) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCESELECTIVENAKPACKETSRECEIVED:
-				{
-					const unsigned selective_nak_packets = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&selective_nak_packets, sizeof(selective_nak_packets) );
-				}
-				break;
-
-/* FIXED: 0 */
-			case COLUMN_PGMSOURCEPARITYNAKSRECEIVED:
-				{
-					const unsigned parity_naks = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&parity_naks, sizeof(parity_naks) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCESELECTIVENAKSRECEIVED:
-				{
-					const unsigned selective_naks = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&selective_naks, sizeof(selective_naks) );
-				}
-				break;
-
-/* FIXED: 0 */
-			case COLUMN_PGMSOURCEPARITYNAKSIGNORED:
-				{
-					const unsigned parity_naks_ignored = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&parity_naks_ignored, sizeof(parity_naks_ignored) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCESELECTIVENAKSIGNORED:
-				{
-					const unsigned selective_naks_ignored = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_IGNORED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&selective_naks_ignored, sizeof(selective_naks_ignored) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCEACKERRORS:
-				{
-					const unsigned ack_errors = sock->cumulative_stats[PGM_PC_SOURCE_ACK_ERRORS];;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&ack_errors, sizeof(ack_errors) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCEPGMCCACKER:
-				{
-					struct sockaddr_in s4;
-					if (AF_INET == sock->acker_nla.ss_family)
-						memcpy (&s4, &sock->acker_nla, sizeof(s4));
-					else
-						memset (&s4, 0, sizeof(s4));
-					snmp_set_var_typed_value (var, ASN_IPADDRESS,
-								  (const u_char*)&s4.sin_addr.s_addr,
-								  sizeof(struct in_addr) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCETRANSMISSIONCURRENTRATE:
-				{
-					const unsigned tx_current_rate = sock->cumulative_stats[PGM_PC_SOURCE_TRANSMISSION_CURRENT_RATE];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&tx_current_rate, sizeof(tx_current_rate) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCEACKPACKETSRECEIVED:
-				{
-					const unsigned ack_packets = sock->cumulative_stats[PGM_PC_SOURCE_ACK_PACKETS_RECEIVED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&ack_packets, sizeof(ack_packets) );
-				}
-				break;
-
-/* COLUMN_PGMSOURCEPARITYNNAKPACKETSRECEIVED + COLUMN_PGMSOURCESELECTIVENNAKPACKETSRECEIVED */
-			case COLUMN_PGMSOURCENNAKPACKETSRECEIVED:
-				{
-					const unsigned nnak_packets = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NNAK_PACKETS_RECEIVED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&nnak_packets, sizeof(nnak_packets) );
-				}
-				break;
-
-/* FIXED: 0 */
-			case COLUMN_PGMSOURCEPARITYNNAKPACKETSRECEIVED:
-				{
-					const unsigned parity_nnak_packets = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&parity_nnak_packets, sizeof(parity_nnak_packets) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCESELECTIVENNAKPACKETSRECEIVED:
-				{
-					const unsigned selective_nnak_packets = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NNAK_PACKETS_RECEIVED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&selective_nnak_packets, sizeof(selective_nnak_packets) );
-				}
-				break;
-
-/* COLUMN_PGMSOURCEPARITYNNAKSRECEIVED + COLUMN_PGMSOURCESELECTIVENNAKSRECEIVED */
-			case COLUMN_PGMSOURCENNAKSRECEIVED:
-				{
-					const unsigned nnaks_received = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NNAKS_RECEIVED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&nnaks_received, sizeof(nnaks_received) );
-				}
-				break;
-
-/* FIXED: 0 */
-			case COLUMN_PGMSOURCEPARITYNNAKSRECEIVED:
-				{
-					const unsigned parity_nnaks = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&parity_nnaks, sizeof(parity_nnaks) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCESELECTIVENNAKSRECEIVED:
-				{
-					const unsigned selective_nnaks = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NNAKS_RECEIVED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&selective_nnaks, sizeof(selective_nnaks) );
-				}
-				break;
-
-			case COLUMN_PGMSOURCENNAKERRORS:
-				{
-					const unsigned malformed_nnaks = sock->cumulative_stats[PGM_PC_SOURCE_NNAK_ERRORS];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&malformed_nnaks, sizeof(malformed_nnaks) );
-				}
-				break;
-
-			default:
-				snmp_log (LOG_ERR, "pgmSourcePerformanceTable_handler: unknown column.\n");
-				break;
-			}
-		}
-		break;
-
-	case MODE_SET_RESERVE1:
-	default:
-		snmp_log (LOG_ERR, "pgmSourcePerformanceTable_handler: unsupported mode.\n");
-		break;
-
-	}
-
-	return SNMP_ERR_NOERROR;
-}
-
-/*
- * pgmReceiverTable
- */
-
-static
-int
-initialize_table_pgmReceiverTable(void)
-{
-	pgm_debug ("initialize_table_pgmReceiverTable ()");
-
-	static const oid pgmReceiverTable_oid[] = {1,3,6,1,3,112,1,3,100,2};
-	netsnmp_table_registration_info* table_info = NULL;
-	netsnmp_iterator_info* iinfo = NULL;
-	netsnmp_handler_registration* reg = NULL;
-
-	reg = netsnmp_create_handler_registration ("pgmReceiverTable",		pgmReceiverTable_handler,
-						   pgmReceiverTable_oid,	OID_LENGTH( pgmReceiverTable_oid ),
-						   HANDLER_CAN_RONLY);
-	if (NULL == reg)
-		goto error;
-
-	table_info = SNMP_MALLOC_TYPEDEF( netsnmp_table_registration_info );
-	if (NULL == table_info)
-		goto error;
-
-	table_info->min_column = COLUMN_PGMRECEIVERGROUPADDRESS;
-	table_info->max_column = COLUMN_PGMRECEIVERUNIQUEINSTANCE;
-
-	netsnmp_table_helper_add_indexes (table_info,
-					  ASN_OCTET_STR,  /* index: pgmReceiverGlobalId */
-					  ASN_UNSIGNED,  /* index: pgmReceiverSourcePort */
-					  ASN_UNSIGNED,  /* index: pgmReceiverInstance */
-					  0);
-
-	iinfo = SNMP_MALLOC_TYPEDEF( netsnmp_iterator_info );
-	if (NULL == iinfo)
-		goto error;
-
-	iinfo->get_first_data_point 	= pgmReceiverTable_get_first_data_point;
-	iinfo->get_next_data_point  	= pgmReceiverTable_get_next_data_point;
-	iinfo->free_loop_context_at_end = pgmReceiverTable_free_loop_context;
-	iinfo->table_reginfo        	= table_info;
-
-	return netsnmp_register_table_iterator (reg, iinfo);
-
-error:
-	if (table_info && table_info->indexes)		/* table_data_free_func() is internal */
-		snmp_free_var (table_info->indexes);
-	SNMP_FREE( table_info );
-	SNMP_FREE( iinfo );
-	netsnmp_handler_registration_free (reg);
-
-	return -1;
-}
-
-/* called for first row of data in SNMP table
- *
- * goal is to cache all the relevant data for subsequent get_next_data_point (row) calls in my_loop_context,
- * optionally returns my_data_context.
- *
- * returns answer or NULL
- */
-
-static
-netsnmp_variable_list*
-pgmReceiverTable_get_first_data_point (
-	void**			my_loop_context,	/* valid through one query of multiple "data points" */
-	void**			my_data_context,	/* answer blob which is passed to handler() */
-	netsnmp_variable_list*	put_index_data,		/* answer */
-	netsnmp_iterator_info*	mydata			/* iinfo on init() */
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-        pgm_assert (NULL != my_data_context);
-        pgm_assert (NULL != put_index_data);
-	pgm_assert (NULL != mydata);
-
-        pgm_debug ("pgmReceiverTable_get_first_data_point (my_loop_context:%p my_data_context:%p put_index_data:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)my_data_context,
-		(const void*)put_index_data,
-		(const void*)mydata);
-
-	pgm_rwlock_reader_lock (&pgm_sock_list_lock);
-
-	if (NULL == pgm_sock_list) {
-		pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
-		return NULL;
-	}
-
-/* create our own context for this SNMP loop */
-	pgm_snmp_context_t* context = pgm_new0 (pgm_snmp_context_t, 1);
-
-/* hunt to find first node, through all socks */
-	for (context->list = pgm_sock_list;
-	     context->list;
-	     context->list = context->list->next)
-	{
-/* and through all peers for each sock */
-		pgm_sock_t* sock = (pgm_sock_t*)context->list->data;
-		pgm_rwlock_reader_lock (&sock->peers_lock);
-		context->node = sock->peers_list;
-		if (context->node) {
-/* maintain this sock's peers lock */
-			break;
-		}
-
-		pgm_rwlock_reader_unlock (&sock->peers_lock);
-	}
-
-/* no node found */
-	if (NULL == context->node) {
-		pgm_free (context);
-		pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
-		return NULL;
-	}
-
-	*my_loop_context = context; 
-	*my_data_context = &context->data_context;
-
-/* pass on for generic row access */
-	return pgmReceiverTable_get_next_data_point (my_loop_context, my_data_context, put_index_data, mydata);
-}
-
-static
-netsnmp_variable_list*
-pgmReceiverTable_get_next_data_point (
-	void**			my_loop_context,
-	void**			my_data_context,
-	netsnmp_variable_list*	put_index_data,
-	netsnmp_iterator_info*	mydata
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-        pgm_assert (NULL != my_data_context);
-        pgm_assert (NULL != put_index_data);
-	pgm_assert (NULL != mydata);
-
-        pgm_debug ("pgmReceiverTable_get_next_data_point (my_loop_context:%p my_data_context:%p put_index_data:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)my_data_context,
-		(const void*)put_index_data,
-		(const void*)mydata);
-
-	pgm_snmp_context_t* context = (pgm_snmp_context_t*)*my_loop_context;
-	pgm_snmp_data_context_t* data_context = (pgm_snmp_data_context_t*)*my_data_context;
-	netsnmp_variable_list *idx = put_index_data;
-
-	if (NULL == context->list)
-		return NULL;
-
-	pgm_sock_t* sock = context->list->data;
-	data_context->sock = sock;
-
-	if (NULL == context->node)
-		return NULL;
-
-	pgm_peer_t* peer = context->node->data;
-	data_context->peer = peer;
-
-/* pgmReceiverGlobalId */
-	char gsi[ PGM_GSISTRLEN ];
-	pgm_gsi_print_r (&peer->tsi.gsi, gsi, sizeof(gsi));
-	snmp_set_var_typed_value (idx, ASN_OCTET_STR, (const u_char*)&gsi, strlen (gsi));
-	idx = idx->next_variable;
-
-/* pgmReceiverSourcePort */
-	const unsigned sport = pgm_ntohs (peer->tsi.sport);
-	snmp_set_var_typed_value (idx, ASN_UNSIGNED, (const u_char*)&sport, sizeof(sport));
-	idx = idx->next_variable;
-
-/* pgmReceiverInstance */
-	const unsigned instance = context->instance++;
-	snmp_set_var_typed_value (idx, ASN_UNSIGNED, (const u_char*)&instance, sizeof(instance));
-
-/* hunt for next valid node */
-	if (context->node->next) {
-		context->node = context->node->next;
-	}
-	else
-	{
-		context->node = NULL;
-		while (context->list->next) {
-			pgm_rwlock_reader_unlock (&sock->peers_lock);
-			context->list = context->list->next;
-			sock = context->list->data;
-			pgm_rwlock_reader_lock (&sock->peers_lock);
-			context->node = sock->peers_list;
-			if (context->node) {
-/* keep lock */
-				break;
-			}
-		}
-	}
-
-	return put_index_data;
-}
-
-static
-void
-pgmReceiverTable_free_loop_context (
-	void*			my_loop_context,
-	netsnmp_iterator_info*	mydata
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-	pgm_assert (NULL != mydata);
-
-        pgm_debug ("pgmReceiverTable_free_loop_context (my_loop_context:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)mydata);
-
-	pgm_snmp_context_t* context = (pgm_snmp_context_t*)my_loop_context;
-
-/* check for intra-peer state */
-	if (context->list) {
-		pgm_sock_t* sock = context->list->data;
-		pgm_rwlock_reader_unlock (&sock->peers_lock);
-	}
-
-	pgm_free (context);
-	my_loop_context = NULL;
-
-	pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
-}
-
-static
-int
-pgmReceiverTable_handler (
-	netsnmp_mib_handler*		handler,
-	netsnmp_handler_registration*	reginfo,
-	netsnmp_agent_request_info*	reqinfo,
-	netsnmp_request_info*		requests
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != handler);
-        pgm_assert (NULL != reginfo);
-        pgm_assert (NULL != reqinfo);
-        pgm_assert (NULL != requests);
-
-        pgm_debug ("pgmReceiverTable_handler (handler:%p reginfo:%p reqinfo:%p requests:%p)",
-                (const void*)handler,
-		(const void*)reginfo,
-		(const void*)reqinfo,
-		(const void*)requests);
-
-	switch (reqinfo->mode) {
-
-/* Read-support (also covers GetNext requests) */
-
-	case MODE_GET:
-		for (netsnmp_request_info* request = requests;
-		     request;
-		     request = request->next)
-		{
-			const pgm_snmp_data_context_t* data_context = (pgm_snmp_data_context_t*)netsnmp_extract_iterator_context (request);
-			if (!data_context) {
-				netsnmp_set_request_error (reqinfo, request, SNMP_NOSUCHINSTANCE);
-				continue;
-			}
-
-			const pgm_sock_t* sock = data_context->sock;
-			const pgm_peer_t* peer = data_context->peer;
-
-			netsnmp_variable_list *var = request->requestvb;
-			netsnmp_table_request_info* table_info = netsnmp_extract_table_info(request);
-
-			if (table_info == NULL) {
-				snmp_log (LOG_ERR, "pgmReceiverTable_handler: empty table request info.\n");
-				continue;
-			}
-
-			switch (table_info->colnum) {
-
-			case COLUMN_PGMRECEIVERGROUPADDRESS:
-				{
-					struct sockaddr_in s4;
-					if (AF_INET == peer->group_nla.ss_family)
-						memcpy (&s4, &peer->group_nla, sizeof(s4));
-					else
-						memset (&s4, 0, sizeof(s4));
-					snmp_set_var_typed_value (var, ASN_IPADDRESS,
-								  (const u_char*)&s4.sin_addr.s_addr,
-								  sizeof(struct in_addr) );
-				}
-				break;
-
-/* by definition same as sock */
-			case COLUMN_PGMRECEIVERDESTPORT:
-				{
-					const unsigned dport = pgm_ntohs (sock->dport);
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&dport, sizeof(dport) );
-				}
-				break;
-
-			case COLUMN_PGMRECEIVERSOURCEADDRESS:
-				{
-					struct sockaddr_in s4;
-					if (AF_INET == peer->nla.ss_family)
-						memcpy (&s4, &peer->nla, sizeof(s4));
-					else
-						memset (&s4, 0, sizeof(s4));
-					snmp_set_var_typed_value (var, ASN_IPADDRESS,
-								  (const u_char*)&s4.sin_addr.s_addr,
-								  sizeof(struct in_addr) );
-				}
-				break;
-
-			case COLUMN_PGMRECEIVERLASTHOP:
-				{
-					struct sockaddr_in s4;
-					if (AF_INET == peer->local_nla.ss_family)
-						memcpy (&s4, &peer->local_nla, sizeof(s4));
-					else
-						memset (&s4, 0, sizeof(s4));
-					snmp_set_var_typed_value (var, ASN_IPADDRESS,
-								  (const u_char*)&s4.sin_addr.s_addr,
-								  sizeof(struct in_addr) );
-				}
-				break;
-
-/* copy index[0] */
-			case COLUMN_PGMRECEIVERSOURCEGSI:
-				snmp_set_var_typed_value (var, ASN_OCTET_STR,
-							  (const u_char*)table_info->indexes->val.string,
-							  table_info->indexes->val_len);
-				break;
-
-/* copy index[1] */
-			case COLUMN_PGMRECEIVERSOURCEPORTNUMBER:
-				snmp_set_var_typed_value (var, ASN_UNSIGNED,
-							  (const u_char*)table_info->indexes->next_variable->val.integer,
-							  table_info->indexes->next_variable->val_len);
-				break;
-
-/* copy index[2] */
-			case COLUMN_PGMRECEIVERUNIQUEINSTANCE:
-				snmp_set_var_typed_value (var, ASN_UNSIGNED,
-							  (const u_char*)table_info->indexes->next_variable->next_variable->val.integer,
-							  table_info->indexes->next_variable->next_variable->val_len);
-				break;
-
-			default:
-				snmp_log (LOG_ERR, "pgmReceiverTable_handler: unknown column.\n");
-				break;
-			}
-		}
-		break;
-
-	case MODE_SET_RESERVE1:
-	default:
-		snmp_log (LOG_ERR, "pgmReceiverTable_handler: unsupported mode.\n");
-		break;
-
-	}
-
-	return SNMP_ERR_NOERROR;
-}
-
-/*
- * pgmReceiverConfigTable
- *
- */
-
-static
-int
-initialize_table_pgmReceiverConfigTable(void)
-{
-	pgm_debug ("initialize_table_pgmReceiverConfigTable ()");
-
-	static const oid pgmReceiverConfigTable_oid[] = {1,3,6,1,3,112,1,3,100,3};
-	netsnmp_table_registration_info* table_info = NULL;
-	netsnmp_iterator_info* iinfo = NULL;
-	netsnmp_handler_registration* reg = NULL;
-
-	reg = netsnmp_create_handler_registration ("pgmReceiverConfigTable",	pgmReceiverConfigTable_handler,
-						   pgmReceiverConfigTable_oid,	OID_LENGTH(pgmReceiverConfigTable_oid),
-						   HANDLER_CAN_RONLY);
-	if (NULL == reg)
-		goto error;
-
-	table_info = SNMP_MALLOC_TYPEDEF( netsnmp_table_registration_info );
-	if (NULL == table_info)
-		goto error;
-
-	table_info->min_column = COLUMN_PGMRECEIVERNAKBACKOFFIVL;
-	table_info->max_column = COLUMN_PGMRECEIVERNAKFAILURETHRESHOLD;
-
-	netsnmp_table_helper_add_indexes (table_info,
-					  ASN_OCTET_STR, /* index: pgmReceiverConfigGlobalId */
-					  ASN_UNSIGNED,  /* index: pgmReceiverConfigSourcePort */
-					  ASN_UNSIGNED,  /* index: pgmReceiverInstance */
-					  0);
-
-	iinfo = SNMP_MALLOC_TYPEDEF( netsnmp_iterator_info );
-	if (NULL == iinfo)
-		goto error;
-
-	iinfo->get_first_data_point 	= pgmReceiverConfigTable_get_first_data_point;
-	iinfo->get_next_data_point  	= pgmReceiverConfigTable_get_next_data_point;
-	iinfo->free_loop_context_at_end = pgmReceiverConfigTable_free_loop_context;
-	iinfo->table_reginfo        	= table_info;
-
-	return netsnmp_register_table_iterator (reg, iinfo);
-
-error:
-	if (table_info && table_info->indexes)		/* table_data_free_func() is internal */
-		snmp_free_var (table_info->indexes);
-	SNMP_FREE( table_info );
-	SNMP_FREE( iinfo );
-	netsnmp_handler_registration_free (reg);
-
-	return -1;
-}
-
-/* called for first row of data in SNMP table
- *
- * goal is to cache all the relevant data for subsequent get_next_data_point (row) calls in my_loop_context,
- * optionally returns my_data_context.
- *
- * returns answer or NULL
- */
-
-static
-netsnmp_variable_list*
-pgmReceiverConfigTable_get_first_data_point(
-	void**			my_loop_context,	/* valid through one query of multiple "data points" */
-	void**			my_data_context,	/* answer blob which is passed to handler() */
-	netsnmp_variable_list*	put_index_data,		/* answer */
-	netsnmp_iterator_info*	mydata			/* iinfo on init() */
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-        pgm_assert (NULL != my_data_context);
-        pgm_assert (NULL != put_index_data);
-	pgm_assert (NULL != mydata);
-
-        pgm_debug ("pgmReceiverConfigTable_get_first_data_point (my_loop_context:%p my_data_context:%p put_index_data:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)my_data_context,
-		(const void*)put_index_data,
-		(const void*)mydata);
-
-	pgm_rwlock_reader_lock (&pgm_sock_list_lock);
-
-	if (NULL == pgm_sock_list) {
-		pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
-		return NULL;
-	}
-
-/* create our own context for this SNMP loop */
-	pgm_snmp_context_t* context = pgm_new0 (pgm_snmp_context_t, 1);
-
-/* hunt to find first node, through all socks */
-	for (context->list = pgm_sock_list;
-	     context->list;
-	     context->list = context->list->next)
-	{
-/* and through all peers for each sock */
-		pgm_sock_t* sock = (pgm_sock_t*)context->list->data;
-		pgm_rwlock_reader_lock (&sock->peers_lock);
-		context->node = sock->peers_list;
-		if (context->node)
-			break;
-
-		pgm_rwlock_reader_unlock (&sock->peers_lock);
-	}
-
-/* no node found */
-	if (NULL == context->node) {
-		pgm_free (context);
-		pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
-		return NULL;
-	}
-
-	*my_loop_context = context; 
-	*my_data_context = NULL;
-
-/* pass on for generic row access */
-	return pgmReceiverConfigTable_get_next_data_point (my_loop_context, my_data_context, put_index_data, mydata);
-}
-
-static
-netsnmp_variable_list*
-pgmReceiverConfigTable_get_next_data_point(
-	void**			my_loop_context,
-	void**			my_data_context,
-	netsnmp_variable_list*	put_index_data,
-	netsnmp_iterator_info*	mydata
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-        pgm_assert (NULL != my_data_context);
-        pgm_assert (NULL != put_index_data);
-	pgm_assert (NULL != mydata);
-
-        pgm_debug ("pgmReceiverConfigTable_get_first_data_point (my_loop_context:%p my_data_context:%p put_index_data:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)my_data_context,
-		(const void*)put_index_data,
-		(const void*)mydata);
-
-	pgm_snmp_context_t* context = (pgm_snmp_context_t*)*my_loop_context;
-	netsnmp_variable_list *idx = put_index_data;
-
-	if (NULL == context->list)
-		return NULL;
-
-	pgm_sock_t* sock = context->list->data;
-	*my_data_context = sock;
-
-	if (NULL == context->node)
-		return NULL;
-
-	pgm_peer_t* peer = context->node->data;
-
-/* pgmReceiverGlobalId */
-	char gsi[ PGM_GSISTRLEN ];
-	pgm_gsi_print_r (&peer->tsi.gsi, gsi, sizeof(gsi));
-	snmp_set_var_typed_value (idx, ASN_OCTET_STR, (const u_char*)&gsi, strlen (gsi));
-	idx = idx->next_variable;
-
-/* pgmReceiverSourcePort */
-	const unsigned sport = pgm_ntohs (peer->tsi.sport);
-	snmp_set_var_typed_value (idx, ASN_UNSIGNED, (const u_char*)&sport, sizeof(sport));
-	idx = idx->next_variable;
-
-/* pgmReceiverInstance */
-	const unsigned instance = context->instance++;
-	snmp_set_var_typed_value (idx, ASN_UNSIGNED, (const u_char*)&instance, sizeof(instance));
-
-/* hunt for next valid node */
-	if (context->node->next) {
-		context->node = context->node->next;
-	}
-	else
-	{
-		context->node = NULL;
-		while (context->list->next) {
-			pgm_rwlock_reader_unlock (&sock->peers_lock);
-			context->list = context->list->next;
-			sock = context->list->data;
-			pgm_rwlock_reader_lock (&sock->peers_lock);
-			context->node = sock->peers_list;
-			if (context->node) {
-/* keep lock */
-				break;
-			}
-		}
-	}
-
-	return put_index_data;
-}
-
-static
-void
-pgmReceiverConfigTable_free_loop_context (
-	void*			my_loop_context,
-	netsnmp_iterator_info*	mydata
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-	pgm_assert (NULL != mydata);
-
-        pgm_debug ("pgmReceiverConfigTable_free_loop_context (my_loop_context:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)mydata);
-
-	pgm_snmp_context_t* context = (pgm_snmp_context_t*)my_loop_context;
-
-/* check for intra-peer state */
-	if (context->list) {
-		pgm_sock_t* sock = context->list->data;
-		pgm_rwlock_reader_unlock (&sock->peers_lock);
-	}
-
-	pgm_free (context);
-	my_loop_context = NULL;
-
-	pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
-}
-
-static
-int
-pgmReceiverConfigTable_handler (
-	netsnmp_mib_handler*		handler,
-	netsnmp_handler_registration*	reginfo,
-	netsnmp_agent_request_info*	reqinfo,
-	netsnmp_request_info*		requests
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != handler);
-        pgm_assert (NULL != reginfo);
-        pgm_assert (NULL != reqinfo);
-        pgm_assert (NULL != requests);
-
-        pgm_debug ("pgmReceiverConfigTable_handler (handler:%p reginfo:%p reqinfo:%p requests:%p)",
-                (const void*)handler,
-		(const void*)reginfo,
-		(const void*)reqinfo,
-		(const void*)requests);
-
-	switch (reqinfo->mode) {
-
-/* Read-support (also covers GetNext requests) */
-
-	case MODE_GET:
-		for (netsnmp_request_info* request = requests;
-		     request;
-		     request = request->next)
-		{
-			const pgm_sock_t* sock = (pgm_sock_t*)netsnmp_extract_iterator_context(request);
-			if (NULL == sock) {
-				netsnmp_set_request_error (reqinfo, request, SNMP_NOSUCHINSTANCE);
-				continue;
-			}
-
-			netsnmp_variable_list *var = request->requestvb;
-			netsnmp_table_request_info* table_info = netsnmp_extract_table_info(request);
-
-			if (NULL == table_info) {
-				snmp_log (LOG_ERR, "pgmReceiverTable_handler: empty table request info.\n");
-				continue;
-			}
-
-			switch (table_info->colnum) {
-
-/* nak_bo_ivl from sock */
-			case COLUMN_PGMRECEIVERNAKBACKOFFIVL:
-				{
-					const unsigned nak_bo_ivl = sock->nak_bo_ivl;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&nak_bo_ivl, sizeof(nak_bo_ivl) );
-				}
-				break;
-
-/* nak_rpt_ivl from sock */
-			case COLUMN_PGMRECEIVERNAKREPEATIVL:
-				{
-					const unsigned nak_rpt_ivl = sock->nak_rpt_ivl;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&nak_rpt_ivl, sizeof(nak_rpt_ivl) );
-				}
-				break;
-
-/* nak_ncf_retries from sock */
-			case COLUMN_PGMRECEIVERNAKNCFRETRIES:
-				{
-					const unsigned nak_ncf_retries = sock->nak_ncf_retries;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&nak_ncf_retries, sizeof(nak_ncf_retries) );
-				}
-				break;
-
-/* nak_rdata_ivl from sock */
-			case COLUMN_PGMRECEIVERNAKRDATAIVL:
-				{
-					const unsigned nak_rdata_ivl = sock->nak_rdata_ivl;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&nak_rdata_ivl, sizeof(nak_rdata_ivl) );
-				}
-				break;
-
-/* nak_data_retries from sock */
-			case COLUMN_PGMRECEIVERNAKDATARETRIES:
-				{
-					const unsigned nak_data_retries = sock->nak_data_retries;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&nak_data_retries, sizeof(nak_data_retries) );
-				}
-				break;
-
-/* FIXED: pgmReceiverSendNaks = enabled(1) */
-			case COLUMN_PGMRECEIVERSENDNAKS:
-				{
-					const unsigned send_naks = PGMRECEIVERSENDNAKS_ENABLED;
-					snmp_set_var_typed_value (var, ASN_INTEGER,
-								  (const u_char*)&send_naks, sizeof(send_naks) );
-				}
-				break;
-
-/* FIXED: pgmReceiverLateJoin = disabled(2) */
-			case COLUMN_PGMRECEIVERLATEJOIN:
-				{
-					const unsigned late_join = PGMRECEIVERLATEJOIN_DISABLED;
-					snmp_set_var_typed_value (var, ASN_INTEGER,
-								  (const u_char*)&late_join, sizeof(late_join) );
-				}
-				break;
-
-/* FIXED: 1 for multicast */
-			case COLUMN_PGMRECEIVERNAKTTL:
-				{
-					const unsigned nak_hops = 1;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&nak_hops, sizeof(nak_hops) );
-				}
-				break;
-
-/* FIXED: pgmReceiverDeliveryOrder = ordered(2) */
-			case COLUMN_PGMRECEIVERDELIVERYORDER:
-				{
-					const unsigned delivery_order = PGMRECEIVERDELIVERYORDER_ORDERED;
-					snmp_set_var_typed_value (var, ASN_INTEGER,
-								  (const u_char*)&delivery_order, sizeof(delivery_order) );
-				}
-				break;
-
-/* FIXED: pgmReceiverMcastNaks = disabled(2) */
-			case COLUMN_PGMRECEIVERMCASTNAKS:
-				{
-					const unsigned mcast_naks = PGMRECEIVERMCASTNAKS_DISABLED;
-					snmp_set_var_typed_value (var, ASN_INTEGER,
-								  (const u_char*)&mcast_naks, sizeof(mcast_naks) );
-				}
-				break;
-
-/* TODO: traps */
-			case COLUMN_PGMRECEIVERNAKFAILURETHRESHOLDTIMER:
-			case COLUMN_PGMRECEIVERNAKFAILURETHRESHOLD:
-				{
-					const unsigned threshold = 0;
-					snmp_set_var_typed_value (var, ASN_UNSIGNED,
-								  (const u_char*)&threshold, sizeof(threshold) );
-				}
-				break;
-
-			default:
-				snmp_log (LOG_ERR, "pgmReceiverTable_handler: unknown column.\n");
-				break;
-			}
-		}
-		break;
-
-	case MODE_SET_RESERVE1:
-	default:
-		snmp_log (LOG_ERR, "pgmReceiverTable_handler: unsupported mode.\n");
-		break;
-
-	}
-
-	return SNMP_ERR_NOERROR;
-}
-
-/*
- * pgmReceiverPerformanceTable
- */
-
-static
-int
-initialize_table_pgmReceiverPerformanceTable (void)
-{
-	pgm_debug ("initialize_table_pgmReceiverPerformanceTable ()");
-
-	static const oid pgmReceiverPerformanceTable_oid[] = {1,3,6,1,3,112,1,3,100,4};
-	netsnmp_table_registration_info* table_info = NULL;
-	netsnmp_iterator_info* iinfo = NULL;
-	netsnmp_handler_registration* reg = NULL;
-
-	reg = netsnmp_create_handler_registration ("pgmReceiverPerformanceTable",	pgmReceiverPerformanceTable_handler,
-						   pgmReceiverPerformanceTable_oid,	OID_LENGTH( pgmReceiverPerformanceTable_oid ),
-						   HANDLER_CAN_RONLY);
-	if (NULL == reg)
-		goto error;
-
-	table_info = SNMP_MALLOC_TYPEDEF( netsnmp_table_registration_info );
-	if (NULL == table_info)
-		goto error;
-
-	table_info->min_column = COLUMN_PGMRECEIVERDATABYTESRECEIVED;
-	table_info->max_column = COLUMN_PGMRECEIVERLASTINTERVALNAKFAILURES;
-
-	netsnmp_table_helper_add_indexes (table_info,
-					  ASN_OCTET_STR,  /* index: pgmReceiverGlobalId */
-					  ASN_UNSIGNED,  /* index: pgmReceiverSourcePort */
-					  ASN_UNSIGNED,  /* index: pgmReceiverInstance */
-					  0);
-
-	iinfo = SNMP_MALLOC_TYPEDEF( netsnmp_iterator_info );
-	if (NULL == iinfo)
-		goto error;
-
-	iinfo->get_first_data_point 	= pgmReceiverPerformanceTable_get_first_data_point;
-	iinfo->get_next_data_point  	= pgmReceiverPerformanceTable_get_next_data_point;
-	iinfo->free_loop_context_at_end = pgmReceiverPerformanceTable_free_loop_context;
-	iinfo->table_reginfo        	= table_info;
-
-	return netsnmp_register_table_iterator (reg, iinfo);
-
-error:
-	if (table_info && table_info->indexes)		/* table_data_free_func() is internal */
-		snmp_free_var (table_info->indexes);
-	SNMP_FREE( table_info );
-	SNMP_FREE( iinfo );
-	netsnmp_handler_registration_free (reg);
-
-	return -1;
-}
-
-/* called for first row of data in SNMP table
- *
- * goal is to cache all the relevant data for subsequent get_next_data_point (row) calls in my_loop_context,
- * optionally returns my_data_context.
- *
- * returns answer or NULL
- */
-
-static
-netsnmp_variable_list*
-pgmReceiverPerformanceTable_get_first_data_point (
-	void**			my_loop_context,	/* valid through one query of multiple "data points" */
-	void**			my_data_context,	/* answer blob which is passed to handler() */
-	netsnmp_variable_list*	put_index_data,		/* answer */
-	netsnmp_iterator_info*	mydata			/* iinfo on init() */
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-        pgm_assert (NULL != my_data_context);
-        pgm_assert (NULL != put_index_data);
-	pgm_assert (NULL != mydata);
-
-        pgm_debug ("pgmReceiverPerformanceTable_get_first_data_point (my_loop_context:%p my_data_context:%p put_index_data:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)my_data_context,
-		(const void*)put_index_data,
-		(const void*)mydata);
-
-	pgm_rwlock_reader_lock (&pgm_sock_list_lock);
-
-	if (NULL == pgm_sock_list) {
-		pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
-		return NULL;
-	}
-
-/* create our own context for this SNMP loop */
-	pgm_snmp_context_t* context = pgm_new0 (pgm_snmp_context_t, 1);
-
-/* hunt to find first node, through all socks */
-	for (context->list = pgm_sock_list;
-	     context->list;
-	     context->list = context->list->next)
-	{
-/* and through all peers for each sock */
-		pgm_sock_t* sock = (pgm_sock_t*)context->list->data;
-		pgm_rwlock_reader_lock (&sock->peers_lock);
-		context->node = sock->peers_list;
-		if (context->node)
-			break;
-
-		pgm_rwlock_reader_unlock (&sock->peers_lock);
-	}
-
-/* no node found */
-	if (NULL == context->node) {
-		pgm_free (context);
-		pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
-		return NULL;
-	}
-
-	*my_loop_context = context; 
-	*my_data_context = &context->data_context;
-
-/* pass on for generic row access */
-	return pgmReceiverPerformanceTable_get_next_data_point (my_loop_context, my_data_context, put_index_data, mydata);
-}
-
-static
-netsnmp_variable_list*
-pgmReceiverPerformanceTable_get_next_data_point (
-	void**			my_loop_context,
-	void**			my_data_context,
-	netsnmp_variable_list*	put_index_data,
-	netsnmp_iterator_info*	mydata
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-        pgm_assert (NULL != my_data_context);
-        pgm_assert (NULL != put_index_data);
-	pgm_assert (NULL != mydata);
-
-        pgm_debug ("pgmReceiverPerformanceTable_get_first_data_point (my_loop_context:%p my_data_context:%p put_index_data:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)my_data_context,
-		(const void*)put_index_data,
-		(const void*)mydata);
-
-	pgm_snmp_context_t* context = (pgm_snmp_context_t*)*my_loop_context;
-	pgm_snmp_data_context_t* data_context = (pgm_snmp_data_context_t*)*my_data_context;
-	netsnmp_variable_list *idx = put_index_data;
-
-	if (NULL == context->list)
-		return NULL;
-
-	pgm_sock_t* sock = context->list->data;
-	data_context->sock = sock;
-
-	if (NULL == context->node)
-		return NULL;
-
-	pgm_peer_t* peer = context->node->data;
-	data_context->peer = peer;
-
-/* pgmReceiverGlobalId */
-	char gsi[ PGM_GSISTRLEN ];
-	pgm_gsi_print_r (&peer->tsi.gsi, gsi, sizeof(gsi));
-	snmp_set_var_typed_value (idx, ASN_OCTET_STR, (const u_char*)&gsi, strlen (gsi));
-	idx = idx->next_variable;
-
-/* pgmReceiverSourcePort */
-	const unsigned sport = pgm_ntohs (peer->tsi.sport);
-	snmp_set_var_typed_value (idx, ASN_UNSIGNED, (const u_char*)&sport, sizeof(sport));
-	idx = idx->next_variable;
-
-/* pgmReceiverInstance */
-	const unsigned instance = context->instance++;
-	snmp_set_var_typed_value (idx, ASN_UNSIGNED, (const u_char*)&instance, sizeof(instance));
-
-/* hunt for next valid node */
-	if (context->node->next) {
-		context->node = context->node->next;
-	}
-	else
-	{
-		context->node = NULL;
-		while (context->list->next) {
-			pgm_rwlock_reader_unlock (&sock->peers_lock);
-			context->list = context->list->next;
-			sock = context->list->data;
-			pgm_rwlock_reader_lock (&sock->peers_lock);
-			context->node = sock->peers_list;
-
-			if (context->node)
-				break;
+/* FIXED: 1 for multicast */
+	case COLUMN_PGMRECEIVERNAKTTL:
+		{
+			const unsigned nak_hops = 1;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&nak_hops, sizeof(nak_hops) );
 		}
-	}
-
-	return put_index_data;
-}
+		break;
 
-static
-void
-pgmReceiverPerformanceTable_free_loop_context (
-	void*			my_loop_context,
-	netsnmp_iterator_info*	mydata
-	)
-{
-/* pre-conditions */
-        pgm_assert (NULL != my_loop_context);
-	pgm_assert (NULL != mydata);
+/* FIXED: pgmReceiverDeliveryOrder = ordered(2) */
+	case COLUMN_PGMRECEIVERDELIVERYORDER:
+		{
+			const unsigned delivery_order = PGMRECEIVERDELIVERYORDER_ORDERED;
+			pgm_snmp_value_set (value, ASN_INTEGER,
+					    (const u_char*)&delivery_order, sizeof(delivery_order) );
+		}
+		break;
 
-        pgm_debug ("pgmReceiverPerformanceTable_free_loop_context (my_loop_context:%p mydata:%p)",
-                (const void*)my_loop_context,
-		(const void*)mydata);
+/* FIXED: pgmReceiverMcastNaks = disabled(2) */
+	case COLUMN_PGMRECEIVERMCASTNAKS:
+		{
+			const unsigned mcast_naks = PGMRECEIVERMCASTNAKS_DISABLED;
+			pgm_snmp_value_set (value, ASN_INTEGER,
+					    (const u_char*)&mcast_naks, sizeof(mcast_naks) );
+		}
+		break;
 
-	pgm_snmp_context_t* context = (pgm_snmp_context_t*)my_loop_context;
+/* TODO: traps */
+	case COLUMN_PGMRECEIVERNAKFAILURETHRESHOLDTIMER:
+	case COLUMN_PGMRECEIVERNAKFAILURETHRESHOLD:
+		{
+			const unsigned threshold = 0;
+			pgm_snmp_value_set (value, ASN_UNSIGNED,
+					    (const u_char*)&threshold, sizeof(threshold) );
+		}
+		break;
 
-/* check for intra-peer state */
-	if (context->list) {
-		pgm_sock_t* sock = context->list->data;
-		pgm_rwlock_reader_unlock (&sock->peers_lock);
+	default:
+		snmp_log (LOG_ERR, "pgmReceiverConfigTable_column: unknown column.\n");
+		break;
 	}
-
-	pgm_free (context);
-	my_loop_context = NULL;
-
-	pgm_rwlock_reader_unlock (&pgm_sock_list_lock);
 }
 
+/*
+ * pgmReceiverPerformanceTable
+ */
+
 static
-int
-pgmReceiverPerformanceTable_handler (
-	netsnmp_mib_handler*		handler,
-	netsnmp_handler_registration*	reginfo,
-	netsnmp_agent_request_info*	reqinfo,
-	netsnmp_request_info*		requests
+void
+pgmReceiverPerformanceTable_column (
+	const pgm_sock_t*	     const restrict sock,
+	const pgm_peer_t*	     const restrict peer,
+	const netsnmp_variable_list* const restrict indexes,
+	const unsigned				    colnum,
+	pgm_snmp_value_t*	     const restrict value
 	)
 {
 /* pre-conditions */
-        pgm_assert (NULL != handler);
-        pgm_assert (NULL != reginfo);
-        pgm_assert (NULL != reqinfo);
-        pgm_assert (NULL != requests);
-
-        pgm_debug ("pgmReceiverPerformanceTable_handler (handler:%p reginfo:%p reqinfo:%p requests:%p)",
-                (const void*)handler,
-		(const void*)reginfo,
-		(const void*)reqinfo,
-		(const void*)requests);
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != peer);
+	pgm_assert (NULL != indexes);
+	pgm_assert (NULL != value);
 
-	switch (reqinfo->mode) {
+	const pgm_rxw_t* window = peer->window;
 
-/* Read-support (also covers GetNext requests) */
+	switch (colnum) {
 
-	case MODE_GET:
-		for (netsnmp_request_info* request = requests;
-		     request;
-		     request = request->next)
+	case COLUMN_PGMRECEIVERDATABYTESRECEIVED:
 		{
-			const pgm_snmp_data_context_t* data_context = (pgm_snmp_data_context_t*)netsnmp_extract_iterator_context (request);
-			if (NULL == data_context) {
-				netsnmp_set_request_error (reqinfo, request, SNMP_NOSUCHINSTANCE);
-				continue;
-			}
-
-			const pgm_sock_t* sock = data_context->sock;
-			const pgm_peer_t* peer = data_context->peer;
-			const pgm_rxw_t* window = peer->window;
-
-			netsnmp_variable_list *var = request->requestvb;
-			netsnmp_table_request_info* table_info = netsnmp_extract_table_info (request);
-
-			if (NULL == table_info) {
-				snmp_log (LOG_ERR, "pgmReceiverTable_handler: empty table request info.\n");
-				continue;
-			}
+			const unsigned data_bytes = peer->cumulative_stats[PGM_PC_RECEIVER_DATA_BYTES_RECEIVED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&data_bytes, sizeof(data_bytes) );
+		}
+		break;
 
-			switch (table_info->colnum) {
-
-			case COLUMN_PGMRECEIVERDATABYTESRECEIVED:
-				{
-					const unsigned data_bytes = peer->cumulative_stats[PGM_PC_RECEIVER_DATA_BYTES_RECEIVED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&data_bytes, sizeof(data_bytes) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERDATAMSGSRECEIVED:
-				{
-					const unsigned data_msgs = peer->cumulative_stats[PGM_PC_RECEIVER_DATA_MSGS_RECEIVED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&data_msgs, sizeof(data_msgs) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERDATAMSGSRECEIVED:
+		{
+			const unsigned data_msgs = peer->cumulative_stats[PGM_PC_RECEIVER_DATA_MSGS_RECEIVED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&data_msgs, sizeof(data_msgs) );
+		}
+		break;
 
 /* total */
-			case COLUMN_PGMRECEIVERNAKSSENT:
-				{
-					const unsigned naks_sent = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SENT];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&naks_sent, sizeof(naks_sent) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERNAKSSENT:
+		{
+			const unsigned naks_sent = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SENT];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&naks_sent, sizeof(naks_sent) );
+		}
+		break;
 	
 /* total */	
-			case COLUMN_PGMRECEIVERNAKSRETRANSMITTED:
-				{
-					const unsigned naks_resent = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_RETRANSMITTED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&naks_resent, sizeof(naks_resent) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERNAKSRETRANSMITTED:
+		{
+			const unsigned naks_resent = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_RETRANSMITTED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&naks_resent, sizeof(naks_resent) );
+		}
+		break;
 	
 /* total */	
-			case COLUMN_PGMRECEIVERNAKFAILURES:
-				{
-					const unsigned nak_failures = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_FAILED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&nak_failures, sizeof(nak_failures) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERBYTESRECEIVED:
-				{
-					const unsigned bytes_received = peer->cumulative_stats[PGM_PC_RECEIVER_BYTES_RECEIVED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&bytes_received, sizeof(bytes_received) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERNAKFAILURES:
+		{
+			const unsigned nak_failures = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_FAILED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&nak_failures, sizeof(nak_failures) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERBYTESRECEIVED:
+		{
+			const unsigned bytes_received = peer->cumulative_stats[PGM_PC_RECEIVER_BYTES_RECEIVED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&bytes_received, sizeof(bytes_received) );
+		}
+		break;
 	
 /* total */	
-			case COLUMN_PGMRECEIVERNAKSSUPPRESSED:
-				{
-					const unsigned naks_suppressed = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SUPPRESSED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&naks_suppressed, sizeof(naks_suppressed) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERNAKSSUPPRESSED:
+		{
+			const unsigned naks_suppressed = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SUPPRESSED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&naks_suppressed, sizeof(naks_suppressed) );
+		}
+		break;
 	
 /* bogus: same as source checksum errors */	
-			case COLUMN_PGMRECEIVERCKSUMERRORS:
-				{
-					const unsigned cksum_errors = sock->cumulative_stats[PGM_PC_SOURCE_CKSUM_ERRORS];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&cksum_errors, sizeof(cksum_errors) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERMALFORMEDSPMS:
-				{
-					const unsigned malformed_spms = peer->cumulative_stats[PGM_PC_RECEIVER_MALFORMED_SPMS];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&malformed_spms, sizeof(malformed_spms) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERMALFORMEDODATA:
-				{
-					const unsigned malformed_odata = peer->cumulative_stats[PGM_PC_RECEIVER_MALFORMED_ODATA];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&malformed_odata, sizeof(malformed_odata) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERMALFORMEDRDATA:
-				{
-					const unsigned malformed_rdata = peer->cumulative_stats[PGM_PC_RECEIVER_MALFORMED_RDATA];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&malformed_rdata, sizeof(malformed_rdata) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERMALFORMEDNCFS:
-				{
-					const unsigned malformed_ncfs = peer->cumulative_stats[PGM_PC_RECEIVER_MALFORMED_NCFS];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&malformed_ncfs, sizeof(malformed_ncfs) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERPACKETSDISCARDED:
-				{
-					const unsigned packets_discarded = peer->cumulative_stats[PGM_PC_RECEIVER_PACKETS_DISCARDED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&packets_discarded, sizeof(packets_discarded) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERLOSSES:
-				{
-					const unsigned losses = window->cumulative_losses;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&losses, sizeof(losses) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERBYTESDELIVEREDTOAPP:
-				{
-					const unsigned bytes_delivered = window->bytes_delivered;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&bytes_delivered, sizeof(bytes_delivered) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERMSGSDELIVEREDTOAPP:
-				{
-					const unsigned msgs_delivered = window->msgs_delivered;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&msgs_delivered, sizeof(msgs_delivered) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERDUPSPMS:
-				{
-					const unsigned dup_spms = peer->cumulative_stats[PGM_PC_RECEIVER_DUP_SPMS];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&dup_spms, sizeof(dup_spms) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERDUPDATAS:
-				{
-					const unsigned dup_data = peer->cumulative_stats[PGM_PC_RECEIVER_DUP_DATAS];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&dup_data, sizeof(dup_data) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERCKSUMERRORS:
+		{
+			const unsigned cksum_errors = sock->cumulative_stats[PGM_PC_SOURCE_CKSUM_ERRORS];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&cksum_errors, sizeof(cksum_errors) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERMALFORMEDSPMS:
+		{
+			const unsigned malformed_spms = peer->cumulative_stats[PGM_PC_RECEIVER_MALFORMED_SPMS];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&malformed_spms, sizeof(malformed_spms) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERMALFORMEDODATA:
+		{
+			const unsigned malformed_odata = peer->cumulative_stats[PGM_PC_RECEIVER_MALFORMED_ODATA];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&malformed_odata, sizeof(malformed_odata) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERMALFORMEDRDATA:
+		{
+			const unsigned malformed_rdata = peer->cumulative_stats[PGM_PC_RECEIVER_MALFORMED_RDATA];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&malformed_rdata, sizeof(malformed_rdata) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERMALFORMEDNCFS:
+		{
+			const unsigned malformed_ncfs = peer->cumulative_stats[PGM_PC_RECEIVER_MALFORMED_NCFS];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&malformed_ncfs, sizeof(malformed_ncfs) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERPACKETSDISCARDED:
+		{
+			const unsigned packets_discarded = peer->cumulative_stats[PGM_PC_RECEIVER_PACKETS_DISCARDED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&packets_discarded, sizeof(packets_discarded) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERLOSSES:
+		{
+			const unsigned losses = window->cumulative_losses;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&losses, sizeof(losses) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERBYTESDELIVEREDTOAPP:
+		{
+			const unsigned bytes_delivered = window->bytes_delivered;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&bytes_delivered, sizeof(bytes_delivered) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERMSGSDELIVEREDTOAPP:
+		{
+			const unsigned msgs_delivered = window->msgs_delivered;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&msgs_delivered, sizeof(msgs_delivered) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERDUPSPMS:
+		{
+			const unsigned dup_spms = peer->cumulative_stats[PGM_PC_RECEIVER_DUP_SPMS];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&dup_spms, sizeof(dup_spms) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERDUPDATAS:
+		{
+			const unsigned dup_data = peer->cumulative_stats[PGM_PC_RECEIVER_DUP_DATAS];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&dup_data, sizeof(dup_data) );
+		}
+		break;
 	
 /* FIXED: 0 */	
-			case COLUMN_PGMRECEIVERDUPPARITIES:
-				{
-					const unsigned dup_parity = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&dup_parity, sizeof(dup_parity) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERDUPPARITIES:
+		{
+			const unsigned dup_parity = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&dup_parity, sizeof(dup_parity) );
+		}
+		break;
 	
 /* COLUMN_PGMRECEIVERPARITYNAKPACKETSSENT + COLUMN_PGMRECEIVERSELECTIVENAKPACKETSSENT */	
-			case COLUMN_PGMRECEIVERNAKPACKETSSENT:
-				{
-					const unsigned nak_packets = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAK_PACKETS_SENT];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&nak_packets, sizeof(nak_packets) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERNAKPACKETSSENT:
+		{
+			const unsigned nak_packets = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAK_PACKETS_SENT];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&nak_packets, sizeof(nak_packets) );
+		}
+		break;
 	
 /* FIXED: 0 */	
-			case COLUMN_PGMRECEIVERPARITYNAKPACKETSSENT:
-				{
-					const unsigned parity_naks = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&parity_naks, sizeof(parity_naks) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERSELECTIVENAKPACKETSSENT:
-				{
-					const unsigned nak_packets = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAK_PACKETS_SENT];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&nak_packets, sizeof(nak_packets) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERPARITYNAKPACKETSSENT:
+		{
+			const unsigned parity_naks = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&parity_naks, sizeof(parity_naks) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERSELECTIVENAKPACKETSSENT:
+		{
+			const unsigned nak_packets = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAK_PACKETS_SENT];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&nak_packets, sizeof(nak_packets) );
+		}
+		break;
 	
 /* FIXED: 0 */	
-			case COLUMN_PGMRECEIVERPARITYNAKSSENT:
-				{
-					const unsigned parity_naks = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&parity_naks, sizeof(parity_naks) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERSELECTIVENAKSSENT:
-				{
-					const unsigned naks_sent = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SENT];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&naks_sent, sizeof(naks_sent) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERPARITYNAKSSENT:
+		{
+			const unsigned parity_naks = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&parity_naks, sizeof(parity_naks) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERSELECTIVENAKSSENT:
+		{
+			const unsigned naks_sent = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SENT];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&naks_sent, sizeof(naks_sent) );
+		}
+		break;
 	
 /* FIXED: 0 */	
-			case COLUMN_PGMRECEIVERPARITYNAKSRETRANSMITTED:
-				{
-					const unsigned parity_resent = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&parity_resent, sizeof(parity_resent) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERSELECTIVENAKSRETRANSMITTED:
-				{
-					const unsigned naks_resent = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_RETRANSMITTED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&naks_resent, sizeof(naks_resent) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERPARITYNAKSRETRANSMITTED:
+		{
+			const unsigned parity_resent = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&parity_resent, sizeof(parity_resent) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERSELECTIVENAKSRETRANSMITTED:
+		{
+			const unsigned naks_resent = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_RETRANSMITTED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&naks_resent, sizeof(naks_resent) );
+		}
+		break;
 	
 /* COLUMN_PGMRECEIVERPARITYNAKSFAILED + COLUMN_PGMRECEIVERSELECTIVENAKSFAILED */	
-			case COLUMN_PGMRECEIVERNAKSFAILED:
-				{
-					const unsigned naks_failed = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_FAILED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&naks_failed, sizeof(naks_failed) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERNAKSFAILED:
+		{
+			const unsigned naks_failed = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_FAILED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&naks_failed, sizeof(naks_failed) );
+		}
+		break;
 	
 /* FIXED: 0 */	
-			case COLUMN_PGMRECEIVERPARITYNAKSFAILED:
-				{
-					const unsigned parity_failed = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&parity_failed, sizeof(parity_failed) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERSELECTIVENAKSFAILED:
-				{
-					const unsigned naks_failed = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_FAILED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&naks_failed, sizeof(naks_failed) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERNAKSFAILEDRXWADVANCED:
-				{
-					const unsigned rxw_failed = peer->cumulative_stats[PGM_PC_RECEIVER_NAKS_FAILED_RXW_ADVANCED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&rxw_failed, sizeof(rxw_failed) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERNAKSFALEDNCFRETRIESEXCEEDED:
-				{
-					const unsigned ncf_retries = peer->cumulative_stats[PGM_PC_RECEIVER_NAKS_FAILED_NCF_RETRIES_EXCEEDED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&ncf_retries, sizeof(ncf_retries) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERNAKSFAILEDDATARETRIESEXCEEDED:
-				{
-					const unsigned data_retries = peer->cumulative_stats[PGM_PC_RECEIVER_NAKS_FAILED_DATA_RETRIES_EXCEEDED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&data_retries, sizeof(data_retries) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERPARITYNAKSFAILED:
+		{
+			const unsigned parity_failed = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&parity_failed, sizeof(parity_failed) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERSELECTIVENAKSFAILED:
+		{
+			const unsigned naks_failed = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_FAILED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&naks_failed, sizeof(naks_failed) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERNAKSFAILEDRXWADVANCED:
+		{
+			const unsigned rxw_failed = peer->cumulative_stats[PGM_PC_RECEIVER_NAKS_FAILED_RXW_ADVANCED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&rxw_failed, sizeof(rxw_failed) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERNAKSFALEDNCFRETRIESEXCEEDED:
+		{
+			const unsigned ncf_retries = peer->cumulative_stats[PGM_PC_RECEIVER_NAKS_FAILED_NCF_RETRIES_EXCEEDED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&ncf_retries, sizeof(ncf_retries) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERNAKSFAILEDDATARETRIESEXCEEDED:
+		{
+			const unsigned data_retries = peer->cumulative_stats[PGM_PC_RECEIVER_NAKS_FAILED_DATA_RETRIES_EXCEEDED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&data_retries, sizeof(data_retries) );
+		}
+		break;
 	
 /* FIXED: 0 - absolutely no idea what this means */	
-			case COLUMN_PGMRECEIVERNAKSFAILEDGENEXPIRED:
-				{
-					const unsigned happy_pandas = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&happy_pandas, sizeof(happy_pandas) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERNAKFAILURESDELIVERED:
-				{
-					const unsigned delivered = peer->cumulative_stats[PGM_PC_RECEIVER_NAK_FAILURES_DELIVERED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&delivered, sizeof(delivered) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERNAKSFAILEDGENEXPIRED:
+		{
+			const unsigned happy_pandas = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&happy_pandas, sizeof(happy_pandas) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERNAKFAILURESDELIVERED:
+		{
+			const unsigned delivered = peer->cumulative_stats[PGM_PC_RECEIVER_NAK_FAILURES_DELIVERED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&delivered, sizeof(delivered) );
+		}
+		break;
 	
 /* FIXED: 0 */	
-			case COLUMN_PGMRECEIVERPARITYNAKSSUPPRESSED:
-				{
-					const unsigned suppressed = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&suppressed, sizeof(suppressed) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERSELECTIVENAKSSUPPRESSED:
-				{
-					const unsigned suppressed = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SUPPRESSED];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&suppressed, sizeof(suppressed) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERNAKERRORS:
-				{
-					const unsigned malformed_naks = peer->cumulative_stats[PGM_PC_RECEIVER_NAK_ERRORS];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&malformed_naks, sizeof(malformed_naks) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERPARITYNAKSSUPPRESSED:
+		{
+			const unsigned suppressed = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&suppressed, sizeof(suppressed) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERSELECTIVENAKSSUPPRESSED:
+		{
+			const unsigned suppressed = peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SUPPRESSED];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&suppressed, sizeof(suppressed) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERNAKERRORS:
+		{
+			const unsigned malformed_naks = peer->cumulative_stats[PGM_PC_RECEIVER_NAK_ERRORS];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&malformed_naks, sizeof(malformed_naks) );
+		}
+		break;
 	
 /* FIXED: 0 */	
-			case COLUMN_PGMRECEIVEROUTSTANDINGPARITYNAKS:
-				{
-					const unsigned outstanding_parity = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&outstanding_parity, sizeof(outstanding_parity) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVEROUTSTANDINGSELECTIVENAKS:
-				{
-					const unsigned outstanding_selective = window->nak_backoff_queue.length +
-										window->wait_ncf_queue.length +
-										window->wait_data_queue.length;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&outstanding_selective, sizeof(outstanding_selective) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERLASTACTIVITY:
-				{
-					union {
-						unsigned	uint_value;
-						time_t  	time_t_value;
-					} last_activity;
-					pgm_time_since_epoch (&peer->last_packet, &last_activity.time_t_value);
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&last_activity.uint_value, sizeof(last_activity.uint_value) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERNAKSVCTIMEMIN:
-				{
-					const unsigned min_repair_time = window->min_fill_time;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&min_repair_time, sizeof(min_repair_time) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERNAKSVCTIMEMEAN:
-				{
-					const unsigned mean_repair_time = peer->cumulative_stats[PGM_PC_RECEIVER_NAK_SVC_TIME_MEAN];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&mean_repair_time, sizeof(mean_repair_time) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERNAKSVCTIMEMAX:
-				{
-					const unsigned max_repair_time = window->max_fill_time;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&max_repair_time, sizeof(max_repair_time) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERNAKFAILTIMEMIN:
-				{
-					const unsigned min_fail_time = peer->min_fail_time;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&min_fail_time, sizeof(min_fail_time) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERNAKFAILTIMEMEAN:
-				{
-					const unsigned mean_fail_time = peer->cumulative_stats[PGM_PC_RECEIVER_NAK_FAIL_TIME_MEAN];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&mean_fail_time, sizeof(mean_fail_time) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERNAKFAILTIMEMAX:
-				{
-					const unsigned max_fail_time = peer->max_fail_time;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&max_fail_time, sizeof(max_fail_time) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERNAKTRANSMITMIN:
-				{
-					const unsigned min_transmit_count = window->min_nak_transmit_count;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&min_transmit_count, sizeof(min_transmit_count) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERNAKTRANSMITMEAN:
-				{
-					const unsigned mean_transmit_count = peer->cumulative_stats[PGM_PC_RECEIVER_TRANSMIT_MEAN];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&mean_transmit_count, sizeof(mean_transmit_count) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERNAKTRANSMITMAX:
-				{
-					const unsigned max_transmit_count = window->max_nak_transmit_count;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&max_transmit_count, sizeof(max_transmit_count) );
-				}
-				break;
+	case COLUMN_PGMRECEIVEROUTSTANDINGPARITYNAKS:
+		{
+			const unsigned outstanding_parity = 0;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&outstanding_parity, sizeof(outstanding_parity) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVEROUTSTANDINGSELECTIVENAKS:
+		{
+			const unsigned outstanding_selective = window->missing_count;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&outstanding_selective, sizeof(outstanding_selective) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERLASTACTIVITY:
+		{
+			union {
+				unsigned	uint_value;
+				time_t  	time_t_value;
+			} last_activity;
+			pgm_time_since_epoch (&peer->last_packet, &last_activity.time_t_value);
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&last_activity.uint_value, sizeof(last_activity.uint_value) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERNAKSVCTIMEMIN:
+		{
+			const unsigned min_repair_time = window->min_fill_time;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&min_repair_time, sizeof(min_repair_time) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERNAKSVCTIMEMEAN:
+		{
+			const unsigned mean_repair_time = peer->cumulative_stats[PGM_PC_RECEIVER_NAK_SVC_TIME_MEAN];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&mean_repair_time, sizeof(mean_repair_time) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERNAKSVCTIMEMAX:
+		{
+			const unsigned max_repair_time = window->max_fill_time;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&max_repair_time, sizeof(max_repair_time) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERNAKFAILTIMEMIN:
+		{
+			const unsigned min_fail_time = peer->min_fail_time;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&min_fail_time, sizeof(min_fail_time) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERNAKFAILTIMEMEAN:
+		{
+			const unsigned mean_fail_time = peer->cumulative_stats[PGM_PC_RECEIVER_NAK_FAIL_TIME_MEAN];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&mean_fail_time, sizeof(mean_fail_time) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERNAKFAILTIMEMAX:
+		{
+			const unsigned max_fail_time = peer->max_fail_time;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&max_fail_time, sizeof(max_fail_time) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERNAKTRANSMITMIN:
+		{
+			const unsigned min_transmit_count = window->min_nak_transmit_count;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&min_transmit_count, sizeof(min_transmit_count) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERNAKTRANSMITMEAN:
+		{
+			const unsigned mean_transmit_count = peer->cumulative_stats[PGM_PC_RECEIVER_TRANSMIT_MEAN];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&mean_transmit_count, sizeof(mean_transmit_count) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERNAKTRANSMITMAX:
+		{
+			const unsigned max_transmit_count = window->max_nak_transmit_count;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&max_transmit_count, sizeof(max_transmit_count) );
+		}
+		break;
 	
-			case COLUMN_PGMRECEIVERACKSSENT:
-				{
-					const unsigned acks_sent = peer->cumulative_stats[PGM_PC_RECEIVER_ACKS_SENT];
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&acks_sent, sizeof(acks_sent) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERRXWTRAIL:
-				{
-					const unsigned rxw_trail = window->rxw_trail;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&rxw_trail, sizeof(rxw_trail) );
-				}
-				break;
-		
-			case COLUMN_PGMRECEIVERRXWLEAD:
-				{
-					const unsigned rxw_lead = window->lead;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&rxw_lead, sizeof(rxw_lead) );
-				}
-				break;
+	case COLUMN_PGMRECEIVERACKSSENT:
+		{
+			const unsigned acks_sent = peer->cumulative_stats[PGM_PC_RECEIVER_ACKS_SENT];
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&acks_sent, sizeof(acks_sent) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERRXWTRAIL:
+		{
+			const unsigned rxw_trail = window->rxw_trail;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&rxw_trail, sizeof(rxw_trail) );
+		}
+		break;
+
+	case COLUMN_PGMRECEIVERRXWLEAD:
+		{
+			const unsigned rxw_lead = window->lead;
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&rxw_lead, sizeof(rxw_lead) );
+		}
+		break;
 	
 /* TODO: traps */	
-			case COLUMN_PGMRECEIVERNAKFAILURESLASTINTERVAL:
-			case COLUMN_PGMRECEIVERLASTINTERVALNAKFAILURES:
-				{
-					const unsigned failures = 0;
-					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
-								  (const u_char*)&failures, sizeof(failures) );
-				}
-				break;
-
-			default:
-				snmp_log (LOG_ERR, "pgmReceiverTable_handler: unknown column.\n");
-				break;
-			}
+/* unrecoverable losses over the sampled history, without a threshold reset */
+	case COLUMN_PGMRECEIVERNAKFAILURESLASTINTERVAL:
+		{
+			uint64_t rates[PGM_STATS_RATE_MAX];
+			const unsigned interval = pgm_stats_ring_rates (peer->rates, PGM_STATS_RING_LEN - 1, rates);
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&interval, sizeof(interval) );
 		}
 		break;
 
-	case MODE_SET_RESERVE1:
-	default:
-		snmp_log (LOG_ERR, "pgmReceiverTable_handler: unsupported mode.\n");
+	case COLUMN_PGMRECEIVERLASTINTERVALNAKFAILURES:
+		{
+			uint64_t rates[PGM_STATS_RATE_MAX];
+			const unsigned interval = pgm_stats_ring_rates (peer->rates, PGM_STATS_RING_LEN - 1, rates);
+			const unsigned failures = (unsigned)(rates[PGM_STATS_RATE_LOSSES] * interval);
+			pgm_snmp_value_set (value, ASN_COUNTER, /* ASN_COUNTER32 */
+					    (const u_char*)&failures, sizeof(failures) );
+		}
 		break;
 
+	default:
+		snmp_log (LOG_ERR, "pgmReceiverPerformanceTable_column: unknown column.\n");
+		break;
 	}
-
-	return SNMP_ERR_NOERROR;
 }
 
 /*
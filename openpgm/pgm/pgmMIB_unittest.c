@@ -31,15 +31,8 @@
 #include "impl/framework.h"
 
 
-/* mock state */
-static pgm_rwlock_t     mock_pgm_sock_list_lock;
-static pgm_slist_t*     mock_pgm_sock_list;
-
 /* mock functions for external references */
 
-#define pgm_sock_list_lock      mock_pgm_sock_list_lock
-#define pgm_sock_list           mock_pgm_sock_list
-
 static
 netsnmp_handler_registration*
 mock_netsnmp_create_handler_registration (
@@ -51,6 +44,7 @@ mock_netsnmp_create_handler_registration (
 	)
 {
 	netsnmp_handler_registration* handler = g_malloc0 (sizeof(netsnmp_handler_registration));
+	handler->handler = g_malloc0 (sizeof(netsnmp_mib_handler));
 	return handler;
 }
 
@@ -61,6 +55,7 @@ mock_netsnmp_handler_registration_free (
 	)
 {
 	g_assert (NULL != handler);
+	g_free (handler->handler);
 	g_free (handler);
 }
 
@@ -75,9 +70,9 @@ mock_netsnmp_table_helper_add_indexes (
 
 static
 int
-mock_netsnmp_register_table_iterator (
+mock_netsnmp_register_table (
 	netsnmp_handler_registration*	reginfo,
-	netsnmp_iterator_info*		iinfo
+	netsnmp_table_registration_info* tinfo
 	)
 {
 	return MIB_REGISTERED_OK;
@@ -85,22 +80,114 @@ mock_netsnmp_register_table_iterator (
 
 static
 int
-mock_netsnmp_set_request_error (
-	netsnmp_agent_request_info*	reqinfo,
-	netsnmp_request_info*		request,
-	int				error_value
+mock_netsnmp_inject_handler (
+	netsnmp_handler_registration*	reginfo,
+	netsnmp_mib_handler*		handler
+	)
+{
+	return SNMPERR_SUCCESS;
+}
+
+/* rows inserted into any table container */
+static unsigned mock_rows;
+
+static
+int
+mock_container_insert (
+	netsnmp_container*		container,
+	const void*			data
 	)
 {
+	mock_rows++;
+	g_free ((void*)data);
 	return 0;
 }
 
+static
+netsnmp_container*
+mock_netsnmp_container_find (
+	const char*			type
+	)
+{
+	netsnmp_container* container = g_malloc0 (sizeof(netsnmp_container));
+	container->insert = mock_container_insert;
+	return container;
+}
+
+static
+netsnmp_mib_handler*
+mock_netsnmp_container_table_handler_get (
+	netsnmp_table_registration_info* tinfo,
+	netsnmp_container*		container,
+	char				key_type
+	)
+{
+	return NULL;
+}
+
+static
+netsnmp_cache*
+mock_netsnmp_cache_create (
+	int				timeout,
+	NetsnmpCacheLoad*		load_hook,
+	NetsnmpCacheFree*		free_hook,
+	const oid*			rootoid,
+	int				rootoid_len
+	)
+{
+	return g_malloc0 (sizeof(netsnmp_cache));
+}
+
+static
+netsnmp_mib_handler*
+mock_netsnmp_cache_handler_get (
+	netsnmp_cache*			cache
+	)
+{
+	return NULL;
+}
+
 static
 void*
-mock_netsnmp_extract_iterator_context (
-	netsnmp_request_info*		reqinfo
+mock_netsnmp_container_table_row_extract (
+	netsnmp_request_info*		request
+	)
+{
+	return NULL;
+}
+
+static
+int
+mock_build_oid_noalloc (
+	oid*				in,
+	size_t				in_len,
+	size_t*				out_len,
+	oid*				prefix,
+	size_t				prefix_len,
+	netsnmp_variable_list*		indexes
+	)
+{
+	*out_len = 0;
+	return SNMPERR_SUCCESS;
+}
+
+static
+void
+mock_snmp_reset_var_buffers (
+	netsnmp_variable_list*		var
+	)
+{
+}
+
+static
+int
+mock_netsnmp_set_request_error (
+	netsnmp_agent_request_info*	reqinfo,
+	netsnmp_request_info*		request,
+	int				error_value
 	)
 {
-	return (void*)0x1;
+	return 0;
 }
 
 static
@@ -189,9 +276,16 @@ mock_pgm_time_since_epoch (
 #define netsnmp_create_handler_registration	mock_netsnmp_create_handler_registration
 #define netsnmp_handler_registration_free	mock_netsnmp_handler_registration_free
 #define netsnmp_table_helper_add_indexes	mock_netsnmp_table_helper_add_indexes
-#define netsnmp_register_table_iterator		mock_netsnmp_register_table_iterator
+#define netsnmp_register_table			mock_netsnmp_register_table
+#define netsnmp_inject_handler			mock_netsnmp_inject_handler
+#define netsnmp_container_find			mock_netsnmp_container_find
+#define netsnmp_container_table_handler_get	mock_netsnmp_container_table_handler_get
+#define netsnmp_cache_create			mock_netsnmp_cache_create
+#define netsnmp_cache_handler_get		mock_netsnmp_cache_handler_get
+#define netsnmp_container_table_row_extract	mock_netsnmp_container_table_row_extract
+#define build_oid_noalloc			mock_build_oid_noalloc
+#define snmp_reset_var_buffers			mock_snmp_reset_var_buffers
 #define netsnmp_set_request_error		mock_netsnmp_set_request_error
-#define netsnmp_extract_iterator_context	mock_netsnmp_extract_iterator_context
 #define netsnmp_extract_table_info		mock_netsnmp_extract_table_info
 #define snmp_set_var_typed_value		mock_snmp_set_var_typed_value
 #define snmp_varlist_add_variable		mock_snmp_varlist_add_variable
@@ -199,10 +293,23 @@ mock_pgm_time_since_epoch (
 #define snmp_free_var				mock_snmp_free_var
 #define snmp_log				mock_snmp_log
 #define send_v2trap				mock_send_v2trap
+#define pgm_stats_ring_rates			mock_pgm_stats_ring_rates
 
 #define PGMMIB_DEBUG
 #include "pgmMIB.c"
 
+PGM_GNUC_INTERNAL
+unsigned
+mock_pgm_stats_ring_rates (
+	const struct pgm_stats_ring_t* const restrict ring,
+	const unsigned				      interval,
+	uint64_t*		       const restrict rates
+	)
+{
+	memset (rates, 0, PGM_STATS_RATE_MAX * sizeof (uint64_t));
+	return 0;
+}
+
 PGM_GNUC_INTERNAL
 int
 pgm_get_nprocs (void)
@@ -224,6 +331,36 @@ START_TEST (test_init_pass_001)
 }
 END_TEST
 
+/* target:
+ *	int
+ *	pgm_snmp_table_load (
+ *		netsnmp_cache*		cache,
+ *		void*			magic
+ *	)
+ */
+
+/* one row per sock for source tables, per peer for receiver tables */
+START_TEST (test_load_pass_001)
+{
+	pgm_error_t* err = NULL;
+	fail_unless (TRUE == pgm_mib_init (&err), "mib_init failed");
+	pgm_sock_t* sock = g_new0 (pgm_sock_t, 1);
+	pgm_rwlock_init (&sock->peers_lock);
+	pgm_peer_t* peer = g_new0 (pgm_peer_t, 1);
+	peer->window = g_new0 (pgm_rxw_t, 1);
+	sock->peers_list = pgm_list_append (sock->peers_list, peer);
+	sock->peers_list = pgm_list_append (sock->peers_list, peer);
+	pgm_sock_registry_init ();
+	pgm_sock_registry_add (sock);
+	mock_rows = 0;
+	fail_unless (0 == pgm_snmp_table_load (NULL, &pgm_snmp_tables[0]), "load failed");
+	fail_unless (1 == mock_rows, "source rows");
+	mock_rows = 0;
+	fail_unless (0 == pgm_snmp_table_load (NULL, &pgm_snmp_tables[PGM_N_ELEMENTS(pgm_snmp_tables) - 1]), "load failed");
+	fail_unless (2 == mock_rows, "receiver rows");
+}
+END_TEST
+
 
 static
 Suite*
@@ -236,6 +373,10 @@ make_test_suite (void)
 	TCase* tc_init = tcase_create ("init");
 	suite_add_tcase (s, tc_init);
 	tcase_add_test (tc_init, test_init_pass_001);
+
+	TCase* tc_load = tcase_create ("load");
+	suite_add_tcase (s, tc_load);
+	tcase_add_test (tc_load, test_load_pass_001);
 	return s;
 }
 
@@ -59,6 +59,33 @@ pgm_queue_push_head_link (
 	queue->length++;
 }
 
+/* insert a link adjacent to sibling on the head side.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_queue_insert_before_link (
+	pgm_queue_t* restrict queue,
+	pgm_list_t*  restrict sibling,
+	pgm_list_t*  restrict link
+	)
+{
+	pgm_return_if_fail (queue != NULL);
+	pgm_return_if_fail (sibling != NULL);
+	pgm_return_if_fail (link != NULL);
+	pgm_return_if_fail (link->prev == NULL);
+	pgm_return_if_fail (link->next == NULL);
+
+	link->next = sibling;
+	link->prev = sibling->prev;
+	if (sibling->prev)
+		sibling->prev->next = link;
+	else
+		queue->head = link;
+	sibling->prev = link;
+	queue->length++;
+}
+
 PGM_GNUC_INTERNAL
 pgm_list_t*
 pgm_queue_pop_tail_link (
@@ -25,6 +25,281 @@
 #include <impl/framework.h>
 
 
+/* The bucket is a generic cell rate algorithm: rather than a byte count and
+ * the time of the last refill it holds the time at which the bucket will have
+ * drained empty.  Credit is the difference between now and that time, so a
+ * refill and debit is a single compare-and-swap and concurrent senders never
+ * serialise on a lock.  Times are microseconds scaled by 2^10 to keep the cost
+ * of small packets at high rates from rounding to zero.
+ *
+ * A paced bucket hands packets to the kernel with a launch time instead of
+ * holding them back, evaluating the bucket one capacity ahead of now so that
+ * up to one bucket of traffic is queued in the kernel awaiting launch.
+ */
+
+#define PGM_RATE_SHIFT		10
+
+static inline
+uint64_t
+_pgm_rate_now (void)
+{
+	return (uint64_t)pgm_time_update_now() << PGM_RATE_SHIFT;
+}
+
+/* fixed-point time to transmit data_size bytes, rounded up.
+ */
+
+static inline
+uint64_t
+_pgm_rate_cost (
+	const pgm_rate_t*	bucket,
+	const size_t		data_size
+	)
+{
+	const uint64_t scaled_bytes = (uint64_t)data_size << PGM_RATE_SHIFT;
+	return (scaled_bytes * 1000000UL + bucket->rate_per_sec - 1) / bucket->rate_per_sec;
+}
+
+/* look ahead of now for paced buckets.
+ */
+
+static inline
+uint64_t
+_pgm_rate_horizon (
+	const pgm_rate_t*	bucket
+	)
+{
+	return bucket->is_paced ? bucket->capacity : 0;
+}
+
+/* drain time after refilling to bucket capacity.
+ */
+
+static inline
+uint64_t
+_pgm_rate_refill (
+	const pgm_rate_t*	bucket,
+	const uint64_t		drain_time,
+	const uint64_t		now
+	)
+{
+	if (now > bucket->capacity && drain_time < now - bucket->capacity)
+		return now - bucket->capacity;
+	return drain_time;
+}
+
+/* account a stall of a bucket.  a blocking sender stalls for the wait, a
+ * non-blocking one from the first refused debit until the next permitted.
+ */
+
+static
+void
+_pgm_rate_stalled (
+	pgm_rate_t*		bucket,
+	const uint64_t		wait
+	)
+{
+	const uint64_t usecs = wait >> PGM_RATE_SHIFT;
+	pgm_atomic_add64 (&bucket->stall_stats[0], 1);
+	pgm_atomic_add64 (&bucket->stall_stats[1], usecs);
+	PGM_HISTOGRAM_COUNTS("Tx.RateStallUsecs", (int)MIN(usecs, INT_MAX));
+}
+
+static inline
+void
+_pgm_rate_stall_begin (
+	pgm_rate_t*		bucket,
+	const uint64_t		now
+	)
+{
+	if (NULL != bucket->stall_stats &&
+	    0 == pgm_atomic_read64 (&bucket->stall_start))
+		(void)pgm_atomic_compare_and_exchange64 (&bucket->stall_start, 0, now);
+}
+
+static inline
+void
+_pgm_rate_stall_end (
+	pgm_rate_t*		bucket,
+	const uint64_t		now,
+	const uint64_t		until
+	)
+{
+	if (PGM_LIKELY(NULL == bucket->stall_stats))
+		return;
+	const uint64_t stall_start = pgm_atomic_read64 (&bucket->stall_start);
+	if (0 != stall_start &&
+	    pgm_atomic_compare_and_exchange64 (&bucket->stall_start, stall_start, 0))
+		_pgm_rate_stalled (bucket, now > stall_start ? now - stall_start : 0);
+	if (until > now)
+		_pgm_rate_stalled (bucket, until - now);
+}
+
+/* debit bucket by cost, returns FALSE without debiting if the bucket would
+ * go negative and non-blocking flag is set.  until is set to the time the
+ * debit is paid off, launch to the time transmission may start.
+ */
+
+static
+bool
+_pgm_rate_debit (
+	pgm_rate_t*		bucket,
+	const uint64_t		cost,
+	const uint64_t		now,
+	const bool		is_nonblocking,
+	uint64_t*		until,
+	uint64_t*		launch
+	)
+{
+	const uint64_t horizon = _pgm_rate_horizon (bucket);
+	uint64_t drain_time, start_time;
+
+	do {
+		drain_time = pgm_atomic_read64 (&bucket->drain_time);
+		start_time = _pgm_rate_refill (bucket, drain_time, now + horizon);
+		if (is_nonblocking && start_time + cost > now + horizon) {
+			PGM_PROBE3 (rate_stall, bucket, TRUE, (start_time + cost - horizon - now) >> PGM_RATE_SHIFT);
+			_pgm_rate_stall_begin (bucket, now);
+			return FALSE;
+		}
+	} while (!pgm_atomic_compare_and_exchange64 (&bucket->drain_time, drain_time, start_time + cost));
+	*until = start_time + cost - horizon;
+	*launch = start_time;
+	if (*until > now)
+		PGM_PROBE3 (rate_stall, bucket, FALSE, (*until - now) >> PGM_RATE_SHIFT);
+	_pgm_rate_stall_end (bucket, now, *until);
+	return TRUE;
+}
+
+/* return an uncommitted debit.
+ */
+
+static
+void
+_pgm_rate_credit (
+	pgm_rate_t*		bucket,
+	const uint64_t		cost
+	)
+{
+	uint64_t drain_time;
+
+	do {
+		drain_time = pgm_atomic_read64 (&bucket->drain_time);
+	} while (!pgm_atomic_compare_and_exchange64 (&bucket->drain_time, drain_time, drain_time - cost));
+}
+
+/* charge bucket by cost without a check, a bucket may run into debt and
+ * holds back later debits until repaid.
+ */
+
+static
+void
+_pgm_rate_charge (
+	pgm_rate_t*		bucket,
+	const uint64_t		cost,
+	const uint64_t		now
+	)
+{
+	uint64_t drain_time;
+
+	do {
+		drain_time = pgm_atomic_read64 (&bucket->drain_time);
+	} while (!pgm_atomic_compare_and_exchange64 (&bucket->drain_time, drain_time, _pgm_rate_refill (bucket, drain_time, now) + cost));
+}
+
+/* debit the parent of bucket for data_size bytes.  traffic conforming to the
+ * guarantee of bucket is charged to the parent without waiting, such that the
+ * parent holds back the traffic of siblings borrowing beyond their own
+ * guarantees instead.
+ */
+
+static
+bool
+_pgm_rate_debit_parent (
+	pgm_rate_t*		bucket,
+	const size_t		data_size,
+	const uint64_t		now,
+	const bool		is_nonblocking,
+	uint64_t*		until,
+	uint64_t*		launch
+	)
+{
+	pgm_rate_t* parent = bucket->parent;
+	pgm_rate_t* guarantee = bucket->guarantee;
+	const uint64_t cost = _pgm_rate_cost (parent, bucket->iphdr_len + data_size);
+
+	if (NULL != guarantee &&
+	    _pgm_rate_debit (guarantee, _pgm_rate_cost (guarantee, bucket->iphdr_len + data_size), now, TRUE, until, launch))
+	{
+		_pgm_rate_charge (parent, cost, now);
+		return TRUE;
+	}
+	return _pgm_rate_debit (parent, cost, now, is_nonblocking, until, launch);
+}
+
+/* wait for outstanding debit to be paid off.
+ */
+
+static
+void
+_pgm_rate_wait (
+	uint64_t		now,
+	const uint64_t		until
+	)
+{
+	while (now < until) {
+		pgm_thread_yield();
+		now = _pgm_rate_now();
+	}
+}
+
+/* nanoseconds from now to launch time.
+ */
+
+static inline
+uint64_t
+_pgm_rate_delay_nsecs (
+	const uint64_t		now,
+	const uint64_t		launch
+	)
+{
+	return launch > now ? ((launch - now) * 1000) >> PGM_RATE_SHIFT : 0;
+}
+
+/* fixed-point time until n bytes may be sent.
+ */
+
+static inline
+uint64_t
+_pgm_rate_remaining (
+	const pgm_rate_t*	bucket,
+	const size_t		n,
+	const uint64_t		now
+	)
+{
+	const uint64_t horizon = _pgm_rate_horizon (bucket);
+	const uint64_t drain_time = _pgm_rate_refill (bucket, pgm_atomic_read64 (&bucket->drain_time), now + horizon) + _pgm_rate_cost (bucket, n);
+	return drain_time > now + horizon ? drain_time - now - horizon : 0;
+}
+
+/* fixed-point time until n bytes may be sent through the parent of bucket,
+ * immediately whilst within the guarantee.
+ */
+
+static inline
+uint64_t
+_pgm_rate_remaining_parent (
+	const pgm_rate_t*	bucket,
+	const size_t		n,
+	const uint64_t		now
+	)
+{
+	const uint64_t remaining = _pgm_rate_remaining (bucket->parent, n, now);
+	if (NULL == bucket->guarantee)
+		return remaining;
+	return MIN(remaining, _pgm_rate_remaining (bucket->guarantee, n, now));
+}
+
 /* create machinery for rate regulation.
  * the rate_per_sec is ammortized over millisecond time periods.
  *
@@ -40,21 +315,49 @@ pgm_rate_create (
 	const uint16_t		max_tpdu
 	)
 {
+	uint64_t now;
+
 /* pre-conditions */
 	pgm_assert (NULL != bucket);
 	pgm_assert (rate_per_sec >= max_tpdu);
 
 	bucket->rate_per_sec	= rate_per_sec;
 	bucket->iphdr_len	= iphdr_len;
-	bucket->last_rate_check	= pgm_time_update_now ();
-/* pre-fill bucket */
 	if ((rate_per_sec / 1000) >= max_tpdu) {
 		bucket->rate_per_msec	= bucket->rate_per_sec / 1000;
-		bucket->rate_limit	= bucket->rate_per_msec;
+		bucket->capacity	= (uint64_t)pgm_msecs(1) << PGM_RATE_SHIFT;
 	} else {
-		bucket->rate_limit	= bucket->rate_per_sec;
+		bucket->capacity	= (uint64_t)pgm_secs(1) << PGM_RATE_SHIFT;
 	}
-	pgm_spinlock_init (&bucket->spinlock);
+/* pre-fill bucket */
+	now = _pgm_rate_now();
+	bucket->drain_time = now > bucket->capacity ? now - bucket->capacity : 0;
+}
+
+/* change the rate of a created bucket, the fill level in time is kept.  a
+ * concurrent sender may charge one packet at the previous rate.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_rate_set (
+	pgm_rate_t*		bucket,
+	const ssize_t		rate_per_sec,
+	const uint16_t		max_tpdu
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != bucket);
+	pgm_assert (rate_per_sec >= max_tpdu);
+
+	if ((rate_per_sec / 1000) >= max_tpdu) {
+		bucket->rate_per_msec	= rate_per_sec / 1000;
+		bucket->capacity	= (uint64_t)pgm_msecs(1) << PGM_RATE_SHIFT;
+	} else {
+		bucket->rate_per_msec	= 0;
+		bucket->capacity	= (uint64_t)pgm_secs(1) << PGM_RATE_SHIFT;
+	}
+	bucket->rate_per_sec	= rate_per_sec;
 }
 
 PGM_GNUC_INTERNAL
@@ -66,141 +369,150 @@ pgm_rate_destroy (
 /* pre-conditions */
 	pgm_assert (NULL != bucket);
 
-	pgm_spinlock_free (&bucket->spinlock);
+/* nop */
 }
 
-/* check bit bucket whether an operation can proceed or should wait.
- *
- * returns TRUE when leaky bucket permits unless non-blocking flag is set.
- * returns FALSE if operation should block and non-blocking flag is set.
+/* debit one or both buckets, waiting for the debit to be paid off unless the
+ * non-blocking flag is set.  launch is set to the time transmission may start.
  */
 
-PGM_GNUC_INTERNAL
+static
 bool
-pgm_rate_check2 (
+_pgm_rate_check2 (
 	pgm_rate_t*		major_bucket,
 	pgm_rate_t*		minor_bucket,
 	const size_t		data_size,
-	const bool		is_nonblocking
+	const bool		is_nonblocking,
+	uint64_t*		launch
 	)
 {
-	int64_t new_major_limit, new_minor_limit;
-	pgm_time_t now;
-
-/* pre-conditions */
-	pgm_assert (NULL != major_bucket);
-	pgm_assert (NULL != minor_bucket);
-	pgm_assert (data_size > 0);
+	uint64_t now, major_cost = 0, minor_cost = 0, major_until = 0, minor_until = 0, parent_until = 0, major_launch = 0, minor_launch = 0, parent_launch = 0;
 
-	if (0 == major_bucket->rate_per_sec && 0 == minor_bucket->rate_per_sec)
+	if (0 == major_bucket->rate_per_sec && 0 == minor_bucket->rate_per_sec && NULL == major_bucket->parent) {
+		*launch = 0;
 		return TRUE;
+	}
+
+	now = _pgm_rate_now();
 
 	if (0 != major_bucket->rate_per_sec)
 	{
-		pgm_spinlock_lock (&major_bucket->spinlock);
-		now = pgm_time_update_now();
-
-		if (major_bucket->rate_per_msec)
-		{
-			const pgm_time_t time_since_last_rate_check = now - major_bucket->last_rate_check;
-			if (time_since_last_rate_check > pgm_msecs(1)) 
-				new_major_limit = major_bucket->rate_per_msec;
-			else {
-				new_major_limit = major_bucket->rate_limit + ((major_bucket->rate_per_msec * time_since_last_rate_check) / 1000UL);
-				if (new_major_limit > major_bucket->rate_per_msec)
-					new_major_limit = major_bucket->rate_per_msec;
-			}
-		}
-		else
-		{
-			const pgm_time_t time_since_last_rate_check = now - major_bucket->last_rate_check;
-			if (time_since_last_rate_check > pgm_secs(1)) 
-				new_major_limit = major_bucket->rate_per_sec;
-			else {
-				new_major_limit = major_bucket->rate_limit + ((major_bucket->rate_per_sec * time_since_last_rate_check) / 1000000UL);
-				if (new_major_limit > major_bucket->rate_per_sec)
-					new_major_limit = major_bucket->rate_per_sec;
-			}
-		}
-
-		new_major_limit -= ( major_bucket->iphdr_len + data_size );
-		if (is_nonblocking && new_major_limit < 0) {
-			pgm_spinlock_unlock (&major_bucket->spinlock);
+		major_cost = _pgm_rate_cost (major_bucket, major_bucket->iphdr_len + data_size);
+		if (!_pgm_rate_debit (major_bucket, major_cost, now, is_nonblocking, &major_until, &major_launch))
 			return FALSE;
-		}
-
-		if (new_major_limit < 0) {
-			const pgm_time_t wait_start = now;
-			ssize_t sleep_amount;
-			do {
-				pgm_thread_yield();
-				now = pgm_time_update_now();
-				sleep_amount = (ssize_t)pgm_to_secs (major_bucket->rate_per_sec * (now - wait_start));
-			} while (sleep_amount + new_major_limit < 0);
-			new_major_limit += sleep_amount;
-		} 
-	}
-	else
-	{
-/* ensure we have a timestamp */
-		now = pgm_time_update_now();
 	}
 
 	if (0 != minor_bucket->rate_per_sec)
 	{
-		if (minor_bucket->rate_per_msec)
-		{
-			const pgm_time_t time_since_last_rate_check = now - minor_bucket->last_rate_check;
-			if (time_since_last_rate_check > pgm_msecs(1)) 
-				new_minor_limit = minor_bucket->rate_per_msec;
-			else {
-				new_minor_limit = minor_bucket->rate_limit + ((minor_bucket->rate_per_msec * time_since_last_rate_check) / 1000UL);
-				if (new_minor_limit > minor_bucket->rate_per_msec)
-					new_minor_limit = minor_bucket->rate_per_msec;
-			}
-		}
-		else
-		{
-			const pgm_time_t time_since_last_rate_check = now - minor_bucket->last_rate_check;
-			if (time_since_last_rate_check > pgm_secs(1)) 
-				new_minor_limit = minor_bucket->rate_per_sec;
-			else {
-				new_minor_limit = minor_bucket->rate_limit + ((minor_bucket->rate_per_sec * time_since_last_rate_check) / 1000000UL);
-				if (new_minor_limit > minor_bucket->rate_per_sec)
-					new_minor_limit = minor_bucket->rate_per_sec;
-			}
-		}
-
-		new_minor_limit -= ( minor_bucket->iphdr_len + data_size );
-		if (is_nonblocking && new_minor_limit < 0) {
+		minor_cost = _pgm_rate_cost (minor_bucket, minor_bucket->iphdr_len + data_size);
+		if (!_pgm_rate_debit (minor_bucket, minor_cost, now, is_nonblocking, &minor_until, &minor_launch)) {
+/* both or neither buckets are debited */
 			if (0 != major_bucket->rate_per_sec)
-				pgm_spinlock_unlock (&major_bucket->spinlock);
+				_pgm_rate_credit (major_bucket, major_cost);
 			return FALSE;
 		}
+	}
 
-/* commit new rate limit */
-		minor_bucket->rate_limit = new_minor_limit;
-		minor_bucket->last_rate_check = now;
+	if (NULL != major_bucket->parent &&
+	    !_pgm_rate_debit_parent (major_bucket, data_size, now, is_nonblocking, &parent_until, &parent_launch))
+	{
+		if (0 != major_bucket->rate_per_sec)
+			_pgm_rate_credit (major_bucket, major_cost);
+		if (0 != minor_bucket->rate_per_sec)
+			_pgm_rate_credit (minor_bucket, minor_cost);
+		return FALSE;
 	}
 
-	if (0 != major_bucket->rate_per_sec) {
-		major_bucket->rate_limit = new_major_limit;
-		major_bucket->last_rate_check = now;
-		pgm_spinlock_unlock (&major_bucket->spinlock);
+	_pgm_rate_wait (now, MAX(MAX(major_until, minor_until), parent_until));
+	*launch = MAX(MAX(major_launch, minor_launch), parent_launch);
+	return TRUE;
+}
+
+static
+bool
+_pgm_rate_check (
+	pgm_rate_t*		bucket,
+	const size_t		data_size,
+	const bool		is_nonblocking,
+	uint64_t*		launch
+	)
+{
+	uint64_t now, cost = 0, until = 0, parent_until = 0, parent_launch = 0;
+
+	if (0 == bucket->rate_per_sec && NULL == bucket->parent) {
+		*launch = 0;
+		return TRUE;
 	}
 
-/* sleep on minor bucket outside of lock */
-	if (minor_bucket->rate_limit < 0) {
-		ssize_t sleep_amount;
-		do {
-			pgm_thread_yield();
-			now = pgm_time_update_now();
-			sleep_amount = (ssize_t)pgm_to_secs (minor_bucket->rate_per_sec * (now - minor_bucket->last_rate_check));
-		} while (sleep_amount + minor_bucket->rate_limit < 0);
-		minor_bucket->rate_limit += sleep_amount;
-		minor_bucket->last_rate_check = now;
-	} 
+	now = _pgm_rate_now();
+	*launch = 0;
+	if (0 != bucket->rate_per_sec) {
+		cost = _pgm_rate_cost (bucket, bucket->iphdr_len + data_size);
+		if (!_pgm_rate_debit (bucket, cost, now, is_nonblocking, &until, launch))
+			return FALSE;
+	}
+	if (NULL != bucket->parent &&
+	    !_pgm_rate_debit_parent (bucket, data_size, now, is_nonblocking, &parent_until, &parent_launch))
+	{
+		if (0 != bucket->rate_per_sec)
+			_pgm_rate_credit (bucket, cost);
+		return FALSE;
+	}
+	_pgm_rate_wait (now, MAX(until, parent_until));
+	*launch = MAX(*launch, parent_launch);
+	return TRUE;
+}
+
+/* check bit bucket whether an operation can proceed or should wait.
+ *
+ * returns TRUE when leaky bucket permits unless non-blocking flag is set.
+ * returns FALSE if operation should block and non-blocking flag is set.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_rate_check2 (
+	pgm_rate_t*		major_bucket,
+	pgm_rate_t*		minor_bucket,
+	const size_t		data_size,
+	const bool		is_nonblocking
+	)
+{
+	uint64_t launch;
+
+/* pre-conditions */
+	pgm_assert (NULL != major_bucket);
+	pgm_assert (NULL != minor_bucket);
+	pgm_assert (data_size > 0);
+
+	return _pgm_rate_check2 (major_bucket, minor_bucket, data_size, is_nonblocking, &launch);
+}
 
+/* check bit bucket and return the nanoseconds to the launch time of a
+ * packet on a paced socket.  non-paced buckets always return zero delay.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_rate_pace2 (
+	pgm_rate_t*		major_bucket,
+	pgm_rate_t*		minor_bucket,
+	const size_t		data_size,
+	const bool		is_nonblocking,
+	uint64_t*		delay
+	)
+{
+	uint64_t launch;
+
+/* pre-conditions */
+	pgm_assert (NULL != major_bucket);
+	pgm_assert (NULL != minor_bucket);
+	pgm_assert (data_size > 0);
+	pgm_assert (NULL != delay);
+
+	if (!_pgm_rate_check2 (major_bucket, minor_bucket, data_size, is_nonblocking, &launch))
+		return FALSE;
+	*delay = _pgm_rate_delay_nsecs (_pgm_rate_now(), launch);
 	return TRUE;
 }
 
@@ -212,60 +524,34 @@ pgm_rate_check (
 	const bool		is_nonblocking
 	)
 {
-	int64_t new_rate_limit;
+	uint64_t launch;
 
 /* pre-conditions */
 	pgm_assert (NULL != bucket);
 	pgm_assert (data_size > 0);
 
-	if (0 == bucket->rate_per_sec)
-		return TRUE;
+	return _pgm_rate_check (bucket, data_size, is_nonblocking, &launch);
+}
 
-	pgm_spinlock_lock (&bucket->spinlock);
-	pgm_time_t now = pgm_time_update_now();
+PGM_GNUC_INTERNAL
+bool
+pgm_rate_pace (
+	pgm_rate_t*		bucket,
+	const size_t		data_size,
+	const bool		is_nonblocking,
+	uint64_t*		delay
+	)
+{
+	uint64_t launch;
 
-	if (bucket->rate_per_msec)
-	{
-		const pgm_time_t time_since_last_rate_check = now - bucket->last_rate_check;
-		if (time_since_last_rate_check > pgm_msecs(1)) 
-			new_rate_limit = bucket->rate_per_msec;
-		else {
-			new_rate_limit = bucket->rate_limit + ((bucket->rate_per_msec * time_since_last_rate_check) / 1000UL);
-			if (new_rate_limit > bucket->rate_per_msec)
-				new_rate_limit = bucket->rate_per_msec;
-		}
-	}
-	else
-	{
-		const pgm_time_t time_since_last_rate_check = now - bucket->last_rate_check;
-		if (time_since_last_rate_check > pgm_secs(1)) 
-			new_rate_limit = bucket->rate_per_sec;
-		else {
-			new_rate_limit = bucket->rate_limit + ((bucket->rate_per_sec * time_since_last_rate_check) / 1000000UL);
-			if (new_rate_limit > bucket->rate_per_sec)
-				new_rate_limit = bucket->rate_per_sec;
-		}
-	}
+/* pre-conditions */
+	pgm_assert (NULL != bucket);
+	pgm_assert (data_size > 0);
+	pgm_assert (NULL != delay);
 
-	new_rate_limit -= ( bucket->iphdr_len + data_size );
-	if (is_nonblocking && new_rate_limit < 0) {
-		pgm_spinlock_unlock (&bucket->spinlock);
+	if (!_pgm_rate_check (bucket, data_size, is_nonblocking, &launch))
 		return FALSE;
-	}
-
-	bucket->rate_limit = new_rate_limit;
-	bucket->last_rate_check = now;
-	if (bucket->rate_limit < 0) {
-		ssize_t sleep_amount;
-		do {
-			pgm_thread_yield();
-			now = pgm_time_update_now();
-			sleep_amount = (ssize_t)pgm_to_secs (bucket->rate_per_sec * (now - bucket->last_rate_check));
-		} while (sleep_amount + bucket->rate_limit < 0);
-		bucket->rate_limit += sleep_amount;
-		bucket->last_rate_check = now;
-	} 
-	pgm_spinlock_unlock (&bucket->spinlock);
+	*delay = _pgm_rate_delay_nsecs (_pgm_rate_now(), launch);
 	return TRUE;
 }
 
@@ -278,47 +564,34 @@ pgm_rate_remaining2 (
 	)
 {
 	pgm_time_t remaining = 0;
-	pgm_time_t now;
+	uint64_t now;
 
 /* pre-conditions */
 	pgm_assert (NULL != major_bucket);
 	pgm_assert (NULL != minor_bucket);
 
-	if (PGM_UNLIKELY(0 == major_bucket->rate_per_sec && 0 == minor_bucket->rate_per_sec))
+	if (PGM_UNLIKELY(0 == major_bucket->rate_per_sec && 0 == minor_bucket->rate_per_sec && NULL == major_bucket->parent))
 		return remaining;
 
+	now = _pgm_rate_now();
+
 	if (0 != major_bucket->rate_per_sec)
 	{
-		pgm_spinlock_lock (&major_bucket->spinlock);
-		now = pgm_time_update_now();
-		const int64_t bucket_bytes = major_bucket->rate_limit + pgm_to_secs (major_bucket->rate_per_sec * (now - major_bucket->last_rate_check)) - n;
-
-		if (bucket_bytes < 0) {
-			const int64_t outstanding_bytes = -bucket_bytes;
-			const pgm_time_t major_remaining = (1000000UL * outstanding_bytes) / major_bucket->rate_per_sec;
-			remaining = major_remaining;
-		}
-	}
-	else
-	{
-/* ensure we have a timestamp */
-		now = pgm_time_update_now();
+		remaining = (pgm_time_t)(_pgm_rate_remaining (major_bucket, n, now) >> PGM_RATE_SHIFT);
 	}
 
 	if (0 != minor_bucket->rate_per_sec)
 	{
-		const int64_t bucket_bytes = minor_bucket->rate_limit + pgm_to_secs (minor_bucket->rate_per_sec * (now - minor_bucket->last_rate_check)) - n;
-
-		if (bucket_bytes < 0) {
-			const int64_t outstanding_bytes = -bucket_bytes;
-			const pgm_time_t minor_remaining = (1000000UL * outstanding_bytes) / minor_bucket->rate_per_sec;
+		const pgm_time_t minor_remaining = (pgm_time_t)(_pgm_rate_remaining (minor_bucket, n, now) >> PGM_RATE_SHIFT);
+		if (minor_remaining > 0)
 			remaining = remaining > 0 ? MIN(remaining, minor_remaining) : minor_remaining;
-		}
 	}
 
-	if (0 != major_bucket->rate_per_sec)
+/* the aggregate of the parent bounds every bucket below */
+	if (NULL != major_bucket->parent)
 	{
-		pgm_spinlock_unlock (&major_bucket->spinlock);
+		const pgm_time_t parent_remaining = (pgm_time_t)(_pgm_rate_remaining_parent (major_bucket, n, now) >> PGM_RATE_SHIFT);
+		remaining = MAX(remaining, parent_remaining);
 	}
 
 	return remaining;
@@ -334,22 +607,16 @@ pgm_rate_remaining (
 /* pre-conditions */
 	pgm_assert (NULL != bucket);
 
-	if (PGM_UNLIKELY(0 == bucket->rate_per_sec))
+	if (PGM_UNLIKELY(0 == bucket->rate_per_sec && NULL == bucket->parent))
 		return 0;
 
-	pgm_spinlock_lock (&bucket->spinlock);
-	const pgm_time_t now = pgm_time_update_now();
-	const pgm_time_t time_since_last_rate_check = now - bucket->last_rate_check;
-	const int64_t bucket_bytes = bucket->rate_limit + pgm_to_secs (bucket->rate_per_sec * time_since_last_rate_check) - n;
-	pgm_spinlock_unlock (&bucket->spinlock);
-
-	if (bucket_bytes >= 0)
-		return 0;
-
-	const int64_t outstanding_bytes = -bucket_bytes;
-	const pgm_time_t remaining = (1000000UL * outstanding_bytes) / bucket->rate_per_sec;
-
-	return remaining;
+	const uint64_t now = _pgm_rate_now();
+	uint64_t remaining = 0;
+	if (0 != bucket->rate_per_sec)
+		remaining = _pgm_rate_remaining (bucket, n, now);
+	if (NULL != bucket->parent)
+		remaining = MAX(remaining, _pgm_rate_remaining_parent (bucket, n, now));
+	return (pgm_time_t)(remaining >> PGM_RATE_SHIFT);
 }
 
 /* eof */
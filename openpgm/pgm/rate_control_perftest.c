@@ -0,0 +1,228 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * performance tests for rate regulation under contention.
+ *
+ * Copyright (c) 2010-2016 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <glib.h>
+#include <check.h>
+
+
+/* mock state */
+
+#define PERF_ITERATIONS		1000000
+#define PERF_MAX_THREADS	4
+
+static unsigned perf_threads	= 0;
+
+static
+void
+mock_setup_1thread (void)
+{
+	perf_threads	= 1;
+}
+
+static
+void
+mock_setup_2threads (void)
+{
+	perf_threads	= 2;
+}
+
+static
+void
+mock_setup_4threads (void)
+{
+	perf_threads	= 4;
+}
+
+#define RATE_CONTROL_DEBUG
+#include "rate_control.c"
+
+PGM_GNUC_INTERNAL
+int
+pgm_get_nprocs (void)
+{
+	return 1;
+}
+
+static
+void
+mock_setup (void)
+{
+	if (!g_thread_supported ()) g_thread_init (NULL);
+	g_assert (pgm_time_init (NULL));
+}
+
+static
+void
+mock_teardown (void)
+{
+	g_assert (pgm_time_shutdown ());
+}
+
+/* buckets large enough that every check passes, measuring only the cost of
+ * refill and debit.
+ */
+
+static pgm_rate_t perf_major, perf_minor;
+
+static
+gpointer
+check_thread (
+	gpointer	data
+	)
+{
+	for (unsigned i = PERF_ITERATIONS; i; i--)
+		pgm_rate_check (&perf_major, 100, TRUE);
+	return data;
+}
+
+static
+gpointer
+check2_thread (
+	gpointer	data
+	)
+{
+	for (unsigned i = PERF_ITERATIONS; i; i--)
+		pgm_rate_check2 (&perf_major, &perf_minor, 100, TRUE);
+	return data;
+}
+
+static
+void
+run_threads (
+	const char*	name,
+	GThreadFunc	func
+	)
+{
+	GThread* threads[ PERF_MAX_THREADS ];
+	pgm_time_t start, check;
+
+	start = pgm_time_update_now();
+	for (unsigned i = 0; i < perf_threads; i++) {
+		threads[i] = g_thread_create (func, NULL, TRUE, NULL);
+		fail_if (NULL == threads[i], "g_thread_create failed");
+	}
+	for (unsigned i = 0; i < perf_threads; i++)
+		g_thread_join (threads[i]);
+	check = pgm_time_update_now();
+	g_message ("%s/%u: elapsed time %" PGM_TIME_FORMAT " us, unit time %" PGM_TIME_FORMAT " ns, %" PGM_TIME_FORMAT " packets/s",
+		name, perf_threads,
+		(guint64)(check - start),
+		(guint64)((1000 * (check - start)) / ((guint64)PERF_ITERATIONS * perf_threads)),
+		(guint64)(check > start ? (1000000 * (guint64)PERF_ITERATIONS * perf_threads) / (check - start) : 0));
+}
+
+/* target:
+ *	bool
+ *	pgm_rate_check (
+ *		pgm_rate_t*		bucket,
+ *		const size_t		data_size,
+ *		const bool		is_nonblocking
+ *	)
+ */
+
+START_TEST (test_check)
+{
+	memset (&perf_major, 0, sizeof(perf_major));
+	pgm_rate_create (&perf_major, SSIZE_MAX, 10, 1500);
+	run_threads ("check", check_thread);
+	pgm_rate_destroy (&perf_major);
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_rate_check2 (
+ *		pgm_rate_t*		major_bucket,
+ *		pgm_rate_t*		minor_bucket,
+ *		const size_t		data_size,
+ *		const bool		is_nonblocking
+ *	)
+ */
+
+START_TEST (test_check2)
+{
+	memset (&perf_major, 0, sizeof(perf_major));
+	memset (&perf_minor, 0, sizeof(perf_minor));
+	pgm_rate_create (&perf_major, SSIZE_MAX, 10, 1500);
+	pgm_rate_create (&perf_minor, SSIZE_MAX, 10, 1500);
+	run_threads ("check2", check2_thread);
+	pgm_rate_destroy (&perf_major);
+	pgm_rate_destroy (&perf_minor);
+}
+END_TEST
+
+static
+Suite*
+make_rate_contention_suite (void)
+{
+	Suite* s;
+
+	s = suite_create ("Rate control contention");
+
+	TCase* tc_1thread = tcase_create ("1 thread");
+	suite_add_tcase (s, tc_1thread);
+	tcase_add_checked_fixture (tc_1thread, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_1thread, mock_setup_1thread, NULL);
+	tcase_add_test (tc_1thread, test_check);
+	tcase_add_test (tc_1thread, test_check2);
+
+	TCase* tc_2threads = tcase_create ("2 threads");
+	suite_add_tcase (s, tc_2threads);
+	tcase_add_checked_fixture (tc_2threads, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_2threads, mock_setup_2threads, NULL);
+	tcase_add_test (tc_2threads, test_check);
+	tcase_add_test (tc_2threads, test_check2);
+
+	TCase* tc_4threads = tcase_create ("4 threads");
+	suite_add_tcase (s, tc_4threads);
+	tcase_add_checked_fixture (tc_4threads, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_4threads, mock_setup_4threads, NULL);
+	tcase_add_test (tc_4threads, test_check);
+	tcase_add_test (tc_4threads, test_check2);
+
+	return s;
+}
+
+static
+Suite*
+make_master_suite (void)
+{
+	Suite* s = suite_create ("Master");
+	return s;
+}
+
+int
+main (void)
+{
+	SRunner* sr = srunner_create (make_master_suite ());
+	srunner_add_suite (sr, make_rate_contention_suite ());
+	srunner_run_all (sr, CK_ENV);
+	int number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* eof */
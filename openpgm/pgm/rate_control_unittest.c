@@ -145,6 +145,39 @@ START_TEST (test_check_pass_001)
 }
 END_TEST
 
+/* 005: siblings share a parent bucket, traffic within a guarantee passes
+ * whilst the parent is drained.
+ */
+
+START_TEST (test_check_pass_005)
+{
+	pgm_rate_t parent, a, b, guarantee;
+	memset (&parent, 0, sizeof(parent));
+	memset (&a, 0, sizeof(a));
+	memset (&b, 0, sizeof(b));
+	memset (&guarantee, 0, sizeof(guarantee));
+	mock_pgm_time_now = 1;
+	pgm_rate_create (&parent, 2*1010, 0, 1000);
+	pgm_rate_create (&guarantee, 1010, 10, 1000);
+	a.iphdr_len = b.iphdr_len = 10;
+	a.parent = b.parent = &parent;
+	b.guarantee = &guarantee;
+	mock_pgm_time_now += pgm_secs(2);
+	fail_unless (TRUE == pgm_rate_check (&a, 1000, TRUE), "rate_check failed");
+	fail_unless (TRUE == pgm_rate_check (&a, 1000, TRUE), "rate_check failed");
+	fail_unless (FALSE == pgm_rate_check (&a, 1000, TRUE), "rate_check failed");
+	fail_unless (TRUE == pgm_rate_check (&b, 1000, TRUE), "guaranteed rate_check failed");
+	fail_unless (FALSE == pgm_rate_check (&b, 1000, TRUE), "rate_check failed");
+/* parent in debt from the guaranteed packet */
+	mock_pgm_time_now += pgm_msecs(500);
+	fail_unless (FALSE == pgm_rate_check (&a, 1000, TRUE), "rate_check failed");
+	mock_pgm_time_now += pgm_msecs(500);
+	fail_unless (TRUE == pgm_rate_check (&a, 1000, TRUE), "rate_check failed");
+	pgm_rate_destroy (&guarantee);
+	pgm_rate_destroy (&parent);
+}
+END_TEST
+
 START_TEST (test_check_fail_001)
 {
 	pgm_rate_check (NULL, 1000, FALSE);
@@ -202,6 +235,32 @@ START_TEST (test_check_pass_003)
 }
 END_TEST
 
+/* 004: refused non-blocking checks count one stall lasting until the next
+ * permitted check.
+ */
+
+START_TEST (test_check_pass_004)
+{
+	pgm_rate_t rate;
+	uint64_t stall_stats[2] = { 0, 0 };
+	memset (&rate, 0, sizeof(rate));
+	pgm_rate_create (&rate, 2*1010*1000, 10, 1500);
+	rate.stall_stats = stall_stats;
+	mock_pgm_time_now += pgm_secs(2);
+	fail_unless (TRUE == pgm_rate_check (&rate, 1000, TRUE), "rate_check failed");
+	fail_unless (TRUE == pgm_rate_check (&rate, 1000, TRUE), "rate_check failed");
+	fail_unless (FALSE == pgm_rate_check (&rate, 1000, TRUE), "rate_check failed");
+	mock_pgm_time_now += pgm_usecs(100);
+	fail_unless (FALSE == pgm_rate_check (&rate, 1000, TRUE), "rate_check failed");
+	fail_unless (0 == stall_stats[1], "stall ended early");
+	mock_pgm_time_now += pgm_usecs(900);
+	fail_unless (TRUE == pgm_rate_check (&rate, 1000, TRUE), "rate_check failed");
+	fail_unless (1 == stall_stats[0], "stall count mismatch");
+	fail_unless (pgm_usecs(1000) == stall_stats[1], "stall time mismatch");
+	pgm_rate_destroy (&rate);
+}
+END_TEST
+
 /* target:
  *	bool
  *	pgm_rate_check2 (
@@ -520,6 +579,50 @@ START_TEST (test_check2_pass_003)
 END_TEST
 
 
+/* target:
+ *	bool
+ *	pgm_rate_pace (
+ *		pgm_rate_t*		bucket,
+ *		const size_t		data_size,
+ *		const bool		is_nonblocking,
+ *		uint64_t*		delay
+ *	)
+ *
+ * 001: paced bucket queues one bucket ahead with increasing launch delays.
+ */
+
+START_TEST (test_pace_pass_001)
+{
+	pgm_rate_t rate;
+	uint64_t delay;
+	memset (&rate, 0, sizeof(rate));
+	mock_pgm_time_now = 1;
+	pgm_rate_create (&rate, 2*1010*1000, 10, 1500);
+	rate.is_paced = TRUE;
+	mock_pgm_time_now += pgm_secs(2);
+	fail_unless (TRUE == pgm_rate_pace (&rate, 1000, TRUE, &delay), "rate_pace failed");
+	fail_unless (0 == delay, "delay failed");
+	fail_unless (TRUE == pgm_rate_pace (&rate, 1000, TRUE, &delay), "rate_pace failed");
+	fail_unless (500 * 1000 == delay, "delay failed");
+	fail_unless (FALSE == pgm_rate_pace (&rate, 1000, TRUE, &delay), "rate_pace failed");
+/* advance time to drain one packet */
+	mock_pgm_time_now += pgm_usecs(500);
+	fail_unless (TRUE == pgm_rate_pace (&rate, 1000, TRUE, &delay), "rate_pace failed");
+	fail_unless (500 * 1000 == delay, "delay failed");
+	fail_unless (FALSE == pgm_rate_check (&rate, 1000, TRUE), "rate_check failed");
+	pgm_rate_destroy (&rate);
+}
+END_TEST
+
+START_TEST (test_pace_fail_001)
+{
+	uint64_t delay;
+	pgm_rate_pace (NULL, 1000, FALSE, &delay);
+	fail ("reached");
+}
+END_TEST
+
+
 static
 Suite*
 make_test_suite (void)
@@ -547,6 +650,8 @@ make_test_suite (void)
 	tcase_add_test (tc_check, test_check_pass_001);
 	tcase_add_test (tc_check, test_check_pass_002);
 	tcase_add_test (tc_check, test_check_pass_003);
+	tcase_add_test (tc_check, test_check_pass_004);
+	tcase_add_test (tc_check, test_check_pass_005);
 #ifndef PGM_CHECK_NOFORK
 	tcase_add_test_raise_signal (tc_check, test_check_fail_001, SIGABRT);
 #endif
@@ -559,6 +664,13 @@ make_test_suite (void)
 #ifndef PGM_CHECK_NOFORK
 	tcase_add_test_raise_signal (tc_check2, test_check2_fail_001, SIGABRT);
 #endif
+
+	TCase* tc_pace = tcase_create ("pace");
+	suite_add_tcase (s, tc_pace);
+	tcase_add_test (tc_pace, test_pace_pass_001);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_pace, test_pace_fail_001, SIGABRT);
+#endif
 	return s;
 }
 
@@ -0,0 +1,173 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * aggregate rate limit shared by the sockets of a process.
+ *
+ * Sockets naming the same group with PGM_RATE_GROUP debit one parent bucket
+ * in addition to their own rate control, keeping the sum of their egress
+ * under a link or contract limit whilst a busy socket borrows the capacity
+ * left idle by others.  A socket may reserve a minimum rate that is sent
+ * regardless of the parent, charging the parent into debt such that the
+ * borrowing siblings are held back instead.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <string.h>
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/rate_group.h>
+
+
+//#define RATE_GROUP_DEBUG
+
+#ifndef RATE_GROUP_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+/* groups of the process, under pgm_sock_list_lock */
+static pgm_slist_t*	rate_group_list = NULL;
+
+
+/* join the named group, creating it at the rate of the first member.  Called
+ * from pgm_bind() after the rate control of the socket is set up.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error appropriately.
+ */
+
+bool
+pgm_rate_group_open (
+	pgm_sock_t*    const restrict sock,
+	pgm_error_t**	     restrict error
+	)
+{
+	struct pgm_rate_group_t* group = NULL;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->rate_group_name);
+	pgm_assert (NULL == sock->rate_group);
+
+	if (PGM_UNLIKELY('\0' == sock->rate_group_name[ 0 ])) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Rate group requires a name."));
+		return FALSE;
+	}
+	if (PGM_UNLIKELY(0 != sock->rate_group_min && sock->rate_group_min < sock->max_tpdu)) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Rate group guarantee of %" PRIzd " bytes per second is below one TPDU."),
+			       sock->rate_group_min);
+		return FALSE;
+	}
+
+	pgm_rwlock_writer_lock (&pgm_sock_list_lock);
+	for (pgm_slist_t* list = rate_group_list; NULL != list; list = list->next)
+	{
+		struct pgm_rate_group_t* candidate = list->data;
+		if (0 == strcmp (candidate->name, sock->rate_group_name)) {
+			group = candidate;
+			break;
+		}
+	}
+	if (NULL == group) {
+		if (PGM_UNLIKELY(sock->rate_group_max < sock->max_tpdu)) {
+			pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_SOCKET,
+				       PGM_ERROR_INVAL,
+				       _("Rate group %s requires a rate of at least one TPDU per second."),
+				       sock->rate_group_name);
+			return FALSE;
+		}
+		group = pgm_new0 (struct pgm_rate_group_t, 1);
+		group->name = pgm_strdup (sock->rate_group_name);
+/* member IP headers are charged with each debit */
+		pgm_rate_create (&group->bucket, sock->rate_group_max, 0, sock->max_tpdu);
+		rate_group_list = pgm_slist_prepend (rate_group_list, group);
+	} else if (PGM_UNLIKELY(0 != sock->rate_group_max && sock->rate_group_max != group->bucket.rate_per_sec)) {
+		pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Rate group %s already limited to %" PRIzd " bytes per second."),
+			       sock->rate_group_name, group->bucket.rate_per_sec);
+		return FALSE;
+	}
+	if (PGM_UNLIKELY(sock->rate_group_min > group->bucket.rate_per_sec)) {
+		pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Rate group guarantee exceeds the %" PRIzd " bytes per second of group %s."),
+			       group->bucket.rate_per_sec, sock->rate_group_name);
+		return FALSE;
+	}
+	group->ref_count++;
+	sock->rate_group = group;
+	pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+
+	sock->rate_control.iphdr_len = sock->iphdr_len;
+	sock->rate_control.parent = &group->bucket;
+	if (sock->rate_group_min > 0) {
+		pgm_rate_create (&sock->rate_guarantee, sock->rate_group_min, sock->iphdr_len, sock->max_tpdu);
+		sock->rate_control.guarantee = &sock->rate_guarantee;
+	}
+	sock->is_controlled_spm = TRUE;
+
+	pgm_trace (PGM_LOG_ROLE_RATE_CONTROL,_("Joined rate group %s of %" PRIzd " bytes per second with %" PRIzd " guaranteed."),
+		   group->name, group->bucket.rate_per_sec, sock->rate_group_min);
+	return TRUE;
+}
+
+/* leave the group, freeing it with the last member.
+ */
+
+void
+pgm_rate_group_close (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_rate_group_t* group;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	group = sock->rate_group;
+	if (NULL == group)
+		return;
+
+	sock->rate_control.parent = NULL;
+	sock->rate_control.guarantee = NULL;
+	pgm_rwlock_writer_lock (&pgm_sock_list_lock);
+	if (0 == --group->ref_count) {
+		rate_group_list = pgm_slist_remove (rate_group_list, group);
+		pgm_rate_destroy (&group->bucket);
+		pgm_free (group->name);
+		pgm_free (group);
+	}
+	sock->rate_group = NULL;
+	pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+}
+
+/* eof */
@@ -0,0 +1,416 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Thread per core event loops each owning a shard of PGM sockets.
+ *
+ * Every core runs one thread pinned to its CPU with its own selector, the
+ * sockets added on a core are serviced, and their timers run, on that core
+ * alone.  Cores share nothing on the data path: work for another core, such
+ * as creating or closing a session there, is posted to its task queue and the
+ * core woken through its notification.  A socket created and bound within a
+ * task allocates its windows and buffers on the owning CPU, and with
+ * PGM_EXCLUSIVE skips internal locking entirely.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+#include <errno.h>
+#include <string.h>
+#ifdef _WIN32
+#	include <process.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/selector.h>
+#include <pgm/reactor.h>
+
+
+//#define REACTOR_DEBUG
+
+#ifndef REACTOR_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+/* selector events handled per wakeup */
+#define PGM_REACTOR_EVENTS_MAX		64
+
+/* one message from another thread */
+struct pgm_reactor_task_t {
+	pgm_list_t			link;
+	pgm_reactor_task_func_t		func;
+	void*				arg;
+};
+
+struct pgm_reactor_core_t {
+	pgm_reactor_t*			reactor;
+	unsigned			index;
+#ifndef _WIN32
+	pthread_t			thread;
+#else
+	HANDLE				thread;
+#endif
+	pgm_selector_t*			selector;	/* owning thread only */
+	pgm_notify_t			notify;		/* tasks queued */
+	pgm_mutex_t			mutex;		/* of tasks and is_terminated */
+	pgm_queue_t			tasks;
+	volatile bool			is_terminated;
+};
+
+struct pgm_reactor_t {
+	pgm_reactor_event_func_t	event_func;
+	unsigned			n_cores;
+	struct pgm_reactor_core_t*	cores;
+};
+
+/* core of the calling thread, NULL off reactor threads */
+static PGM_THREAD_LOCAL struct pgm_reactor_core_t*	reactor_core_local = NULL;
+
+
+/* run the tasks queued for the core in the order posted.
+ */
+
+static
+void
+reactor_core_drain (
+	struct pgm_reactor_core_t* const	core
+	)
+{
+	pgm_queue_t tasks;
+	pgm_list_t* link;
+
+	pgm_mutex_lock (&core->mutex);
+	tasks = core->tasks;
+	memset (&core->tasks, 0, sizeof (pgm_queue_t));
+	pgm_notify_clear (&core->notify);
+	pgm_mutex_unlock (&core->mutex);
+
+	while (NULL != (link = pgm_queue_pop_tail_link (&tasks))) {
+		struct pgm_reactor_task_t* task = link->data;
+		task->func (task->arg);
+		pgm_free (task);
+	}
+}
+
+static
+#ifndef _WIN32
+void*
+#else
+unsigned
+__stdcall
+#endif
+reactor_routine (
+	void*		arg
+	)
+{
+	struct pgm_reactor_core_t* core = arg;
+	struct pgm_selector_event_t events[ PGM_REACTOR_EVENTS_MAX ];
+
+	pgm_thread_setup ("core");
+	pgm_thread_setup_nth ("core", core->index);
+	reactor_core_local = core;
+
+	while (!core->is_terminated)
+	{
+		pgm_error_t* error = NULL;
+		const int n = pgm_selector_wait (core->selector, events, PGM_N_ELEMENTS(events), -1, &error);
+		if (PGM_UNLIKELY(n < 0)) {
+			pgm_warn (_("Reactor core %u stopped: %s"), core->index, error->message);
+			pgm_error_free (error);
+			break;
+		}
+		for (int i = 0; i < n; i++)
+			core->reactor->event_func (events[ i ].sock, events[ i ].events, events[ i ].user_data);
+		reactor_core_drain (core);
+	}
+
+	reactor_core_local = NULL;
+#ifndef _WIN32
+	return NULL;
+#else
+	_endthread();
+	return 0;
+#endif
+}
+
+/* release a core whose thread is not running or has been joined, tasks not
+ * yet run are discarded.
+ */
+
+static
+void
+reactor_core_free (
+	struct pgm_reactor_core_t* const	core
+	)
+{
+	pgm_list_t* link;
+
+	while (NULL != (link = pgm_queue_pop_tail_link (&core->tasks)))
+		pgm_free (link->data);
+	pgm_selector_destroy (core->selector);
+	pgm_notify_destroy (&core->notify);
+	pgm_mutex_free (&core->mutex);
+}
+
+static
+void
+reactor_core_stop (
+	struct pgm_reactor_core_t* const	core
+	)
+{
+	pgm_mutex_lock (&core->mutex);
+	core->is_terminated = TRUE;
+	pgm_notify_send (&core->notify);
+	pgm_mutex_unlock (&core->mutex);
+#ifndef _WIN32
+	pthread_join (core->thread, NULL);
+#else
+	WaitForSingleObject (core->thread, INFINITE);
+	CloseHandle (core->thread);
+#endif
+}
+
+/* create a reactor of n_cores threads, one per CPU of the "core" thread role
+ * or of the process affinity when zero.  event_func is called on the owning
+ * core for every ready socket.
+ *
+ * on success, returns TRUE.  on failure returns FALSE and sets error
+ * appropriately.
+ */
+
+bool
+pgm_reactor_create (
+	pgm_reactor_t**	restrict	reactor,
+	const unsigned			n_cores,
+	pgm_reactor_event_func_t	event_func,
+	pgm_error_t**	restrict	error
+	)
+{
+	pgm_return_val_if_fail (NULL != reactor, FALSE);
+	pgm_return_val_if_fail (NULL != event_func, FALSE);
+
+	pgm_reactor_t* new_reactor = pgm_new0 (pgm_reactor_t, 1);
+	new_reactor->event_func = event_func;
+	new_reactor->n_cores    = n_cores > 0 ? n_cores : (unsigned)MAX(1, pgm_get_nprocs());
+	new_reactor->cores      = pgm_new0 (struct pgm_reactor_core_t, new_reactor->n_cores);
+
+	for (unsigned i = 0; i < new_reactor->n_cores; i++)
+	{
+		struct pgm_reactor_core_t* core = &new_reactor->cores[ i ];
+		core->reactor = new_reactor;
+		core->index   = i;
+		if (!pgm_selector_create (&core->selector, error))
+			goto err_cores;
+		if (0 != pgm_notify_init (&core->notify)) {
+			const int save_errno = errno;
+			char errbuf[1024];
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_SOCKET,
+				       pgm_error_from_errno (save_errno),
+				       _("Creating reactor notification channel: %s"),
+				       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+			pgm_selector_destroy (core->selector);
+			goto err_cores;
+		}
+		if (!pgm_selector_set_wake (core->selector, pgm_notify_get_socket (&core->notify))) {
+			const int save_errno = errno;
+			char errbuf[1024];
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_SOCKET,
+				       pgm_error_from_errno (save_errno),
+				       _("Registering reactor notification with selector: %s"),
+				       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+			pgm_notify_destroy (&core->notify);
+			pgm_selector_destroy (core->selector);
+			goto err_cores;
+		}
+		pgm_mutex_init (&core->mutex);
+
+#ifndef _WIN32
+		const int status = pthread_create (&core->thread, NULL, &reactor_routine, core);
+		if (0 != status) {
+			char errbuf[1024];
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_ENGINE,
+				       pgm_error_from_errno (status),
+				       _("Creating reactor core thread: %s"),
+				       pgm_strerror_s (errbuf, sizeof (errbuf), status));
+#else
+		core->thread = (HANDLE)_beginthreadex (NULL, 0, &reactor_routine, core, 0, NULL);
+		if (0 == core->thread) {
+			const int save_errno = errno;
+			char errbuf[1024];
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_ENGINE,
+				       pgm_error_from_errno (save_errno),
+				       _("Creating reactor core thread: %s"),
+				       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+#endif /* _WIN32 */
+			reactor_core_free (core);
+			goto err_cores;
+		}
+		continue;
+
+err_cores:
+		while (i-- > 0) {
+			reactor_core_stop (&new_reactor->cores[ i ]);
+			reactor_core_free (&new_reactor->cores[ i ]);
+		}
+		pgm_free (new_reactor->cores);
+		pgm_free (new_reactor);
+		return FALSE;
+	}
+
+	*reactor = new_reactor;
+	return TRUE;
+}
+
+/* number of cores, sessions are commonly placed on core hash % cores.
+ */
+
+unsigned
+pgm_reactor_cores (
+	const pgm_reactor_t* const	reactor
+	)
+{
+	pgm_return_val_if_fail (NULL != reactor, 0);
+	return reactor->n_cores;
+}
+
+/* returns the core of the calling thread, or -1 when not called from a core of
+ * this reactor.
+ */
+
+int
+pgm_reactor_self (
+	const pgm_reactor_t* const	reactor
+	)
+{
+	pgm_return_val_if_fail (NULL != reactor, -1);
+
+	const struct pgm_reactor_core_t* core = reactor_core_local;
+	if (NULL == core || reactor != core->reactor)
+		return -1;
+	return (int)core->index;
+}
+
+/* queue func to run on a core after its current events, from any thread
+ * including another core.  tasks of one poster run in order.
+ *
+ * returns TRUE on success, FALSE on invalid core.
+ */
+
+bool
+pgm_reactor_post (
+	pgm_reactor_t* const		reactor,
+	const unsigned			core_index,
+	pgm_reactor_task_func_t		func,
+	void*				arg
+	)
+{
+	pgm_return_val_if_fail (NULL != reactor, FALSE);
+	pgm_return_val_if_fail (NULL != func, FALSE);
+	if (PGM_UNLIKELY(core_index >= reactor->n_cores))
+		return FALSE;
+
+	struct pgm_reactor_core_t* core = &reactor->cores[ core_index ];
+	struct pgm_reactor_task_t* task = pgm_new (struct pgm_reactor_task_t, 1);
+	task->link.data = task;
+	task->link.next = task->link.prev = NULL;
+	task->func = func;
+	task->arg  = arg;
+
+/* one notification wakes the core for every task queued before it drains */
+	pgm_mutex_lock (&core->mutex);
+	const bool was_empty = pgm_queue_is_empty (&core->tasks);
+	pgm_queue_push_head_link (&core->tasks, &task->link);
+	if (was_empty)
+		pgm_notify_send (&core->notify);
+	pgm_mutex_unlock (&core->mutex);
+	return TRUE;
+}
+
+/* add a connected socket to the calling core, which thereafter owns it.  must
+ * be called on a core, from a task or event callback, and the socket removed
+ * on the same core before it is closed.
+ *
+ * on success, returns TRUE.  on failure returns FALSE and sets error
+ * appropriately.
+ */
+
+bool
+pgm_reactor_add (
+	pgm_reactor_t* const restrict	reactor,
+	pgm_sock_t*    const restrict	sock,
+	void*				user_data,
+	pgm_error_t**	     restrict	error
+	)
+{
+	pgm_return_val_if_fail (NULL != reactor, FALSE);
+	pgm_return_val_if_fail (NULL != sock, FALSE);
+
+	struct pgm_reactor_core_t* core = reactor_core_local;
+	if (PGM_UNLIKELY(NULL == core || reactor != core->reactor)) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Sockets may only be added on a reactor core."));
+		return FALSE;
+	}
+	return pgm_selector_add (core->selector, sock, user_data, error);
+}
+
+/* remove a socket from the calling core, returns FALSE if not owned by it.
+ */
+
+bool
+pgm_reactor_remove (
+	pgm_reactor_t* const restrict	reactor,
+	pgm_sock_t*    const restrict	sock
+	)
+{
+	pgm_return_val_if_fail (NULL != reactor, FALSE);
+	pgm_return_val_if_fail (NULL != sock, FALSE);
+
+	struct pgm_reactor_core_t* core = reactor_core_local;
+	if (PGM_UNLIKELY(NULL == core || reactor != core->reactor))
+		return FALSE;
+	return pgm_selector_remove (core->selector, sock);
+}
+
+/* stop every core and destroy the reactor, from a thread other than a core.
+ * queued tasks are discarded and sockets still added are left open.
+ */
+
+void
+pgm_reactor_destroy (
+	pgm_reactor_t*		reactor
+	)
+{
+	pgm_return_if_fail (NULL != reactor);
+	pgm_return_if_fail (-1 == pgm_reactor_self (reactor));
+
+	for (unsigned i = 0; i < reactor->n_cores; i++)
+		reactor_core_stop (&reactor->cores[ i ]);
+	for (unsigned i = 0; i < reactor->n_cores; i++)
+		reactor_core_free (&reactor->cores[ i ]);
+	pgm_free (reactor->cores);
+	pgm_free (reactor);
+}
+
+/* eof */
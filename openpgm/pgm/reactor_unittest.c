@@ -0,0 +1,438 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * unit tests for the thread-per-core reactor.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <glib.h>
+#include <check.h>
+
+
+/* mock state */
+
+#define TEST_CORES		2
+#define TEST_TIMEOUT_MS		5000
+
+#define REACTOR_DEBUG
+#include "reactor.c"
+#include <impl/timer.h>
+
+/* a task or event callback run on a core */
+struct test_task_t {
+	pgm_reactor_t*		reactor;
+	pgm_sock_t*		sock;
+	void*			user_data;
+	int			self;
+	unsigned		sequence;
+	unsigned		events;
+	bool			result;
+};
+
+static unsigned			mock_sequence = 0;
+static SOCKET			mock_done[2];	/* one datagram per callback run */
+static struct test_task_t*	mock_event_task = NULL;
+
+PGM_GNUC_INTERNAL
+int
+pgm_get_nprocs (void)
+{
+	return 1;
+}
+
+static
+void
+mock_setup (void)
+{
+	if (!g_thread_supported ()) g_thread_init (NULL);
+	mock_sequence = 0;
+	mock_event_task = NULL;
+	fail_unless (0 == socketpair (AF_UNIX, SOCK_DGRAM, 0, mock_done), "socketpair failed");
+}
+
+static
+void
+mock_teardown (void)
+{
+	close (mock_done[0]);
+	close (mock_done[1]);
+}
+
+/* signal from a core that a callback ran */
+static
+void
+signal_done (void)
+{
+	const char one = '1';
+	send (mock_done[1], &one, sizeof (one), 0);
+}
+
+/* block until a core signals done */
+static
+void
+wait_for_done (void)
+{
+	char buf;
+	struct pollfd fds = { .fd = mock_done[0], .events = POLLIN };
+	fail_unless (1 == poll (&fds, 1, TEST_TIMEOUT_MS), "core timed out");
+	recv (mock_done[0], &buf, sizeof (buf), 0);
+}
+
+/* connected socket, the receive descriptor one end of a datagram socket pair
+ * returned in peer.
+ */
+static
+pgm_sock_t*
+generate_sock (
+	SOCKET*			peer
+	)
+{
+	SOCKET sv[2];
+	pgm_sock_t* sock = g_new0 (pgm_sock_t, 1);
+	sock->is_connected	= TRUE;
+	sock->recv_shards	= 1;
+	fail_unless (0 == socketpair (AF_UNIX, SOCK_DGRAM, 0, sv), "socketpair failed");
+	sock->recv_sock		= sv[0];
+	*peer			= sv[1];
+	fail_unless (0 == pgm_notify_init (&sock->pending_notify), "notify_init failed");
+	return sock;
+}
+
+/* mock functions for external references */
+
+/* timers of the selector, none due */
+PGM_GNUC_INTERNAL
+pgm_time_t
+pgm_timer_expiration (
+	pgm_sock_t* const	sock
+	)
+{
+	(void)sock;
+	return pgm_secs (10);
+}
+
+/* services a ready socket, reading the pending datagram */
+static
+void
+mock_event_func (
+	pgm_sock_t*		sock,
+	unsigned		events,
+	void*			user_data
+	)
+{
+	struct test_task_t* task = mock_event_task;
+	char buf;
+	fail_if (NULL == task, "unexpected event");
+	recv (sock->recv_sock, &buf, sizeof (buf), 0);
+	task->sock	= sock;
+	task->events	= events;
+	task->user_data	= user_data;
+	task->self	= pgm_reactor_self (task->reactor);
+	signal_done ();
+}
+
+static
+void
+task_self (
+	void*			arg
+	)
+{
+	struct test_task_t* task = arg;
+	task->self	= pgm_reactor_self (task->reactor);
+	task->sequence	= mock_sequence++;
+	signal_done ();
+}
+
+static
+void
+task_add (
+	void*			arg
+	)
+{
+	struct test_task_t* task = arg;
+	task->result = pgm_reactor_add (task->reactor, task->sock, task->user_data, NULL);
+	signal_done ();
+}
+
+static
+void
+task_remove (
+	void*			arg
+	)
+{
+	struct test_task_t* task = arg;
+	task->result = pgm_reactor_remove (task->reactor, task->sock);
+	signal_done ();
+}
+
+static
+void
+mock_null_event_func (
+	pgm_sock_t*		sock,
+	unsigned		events,
+	void*			user_data
+	)
+{
+}
+
+
+/* target:
+ *	bool
+ *	pgm_reactor_create (
+ *		pgm_reactor_t**			reactor,
+ *		const unsigned			n_cores,
+ *		pgm_reactor_event_func_t	event_func,
+ *		pgm_error_t**			error
+ *		)
+ */
+
+START_TEST (test_create_pass_001)
+{
+	pgm_reactor_t* reactor = NULL;
+	pgm_error_t* err = NULL;
+	fail_unless (TRUE == pgm_reactor_create (&reactor, TEST_CORES, mock_event_func, &err), "create failed");
+	fail_if (NULL == reactor, "reactor not set");
+	fail_unless (NULL == err, "error raised");
+	fail_unless (TEST_CORES == pgm_reactor_cores (reactor), "cores failed");
+	fail_unless (-1 == pgm_reactor_self (reactor), "self failed");
+	pgm_reactor_destroy (reactor);
+}
+END_TEST
+
+/* one core per processor */
+START_TEST (test_create_pass_002)
+{
+	pgm_reactor_t* reactor = NULL;
+	fail_unless (TRUE == pgm_reactor_create (&reactor, 0, mock_event_func, NULL), "create failed");
+	fail_unless ((unsigned)pgm_get_nprocs() == pgm_reactor_cores (reactor), "cores failed");
+	pgm_reactor_destroy (reactor);
+}
+END_TEST
+
+START_TEST (test_create_fail_001)
+{
+	fail_unless (FALSE == pgm_reactor_create (NULL, TEST_CORES, mock_event_func, NULL), "create failed");
+}
+END_TEST
+
+START_TEST (test_create_fail_002)
+{
+	pgm_reactor_t* reactor = NULL;
+	fail_unless (FALSE == pgm_reactor_create (&reactor, TEST_CORES, NULL, NULL), "create failed");
+	fail_unless (NULL == reactor, "reactor set");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_reactor_post (
+ *		pgm_reactor_t*			reactor,
+ *		const unsigned			core_index,
+ *		pgm_reactor_task_func_t		func,
+ *		void*				arg
+ *		)
+ */
+
+/* tasks run on the core posted to, in order */
+START_TEST (test_post_pass_001)
+{
+	pgm_reactor_t* reactor = NULL;
+	struct test_task_t task[3];
+	fail_unless (TRUE == pgm_reactor_create (&reactor, TEST_CORES, mock_event_func, NULL), "create failed");
+	memset (task, 0, sizeof (task));
+	for (unsigned i = 0; i < G_N_ELEMENTS(task); i++) {
+		task[i].reactor = reactor;
+		fail_unless (TRUE == pgm_reactor_post (reactor, 1, task_self, &task[i]), "post failed");
+	}
+	for (unsigned i = 0; i < G_N_ELEMENTS(task); i++)
+		wait_for_done ();
+	for (unsigned i = 0; i < G_N_ELEMENTS(task); i++) {
+		fail_unless (1 == task[i].self, "self failed");
+		fail_unless (i == task[i].sequence, "sequence failed");
+	}
+	pgm_reactor_destroy (reactor);
+}
+END_TEST
+
+/* invalid core */
+START_TEST (test_post_fail_001)
+{
+	pgm_reactor_t* reactor = NULL;
+	struct test_task_t task;
+	fail_unless (TRUE == pgm_reactor_create (&reactor, TEST_CORES, mock_event_func, NULL), "create failed");
+	fail_unless (FALSE == pgm_reactor_post (reactor, TEST_CORES, task_self, &task), "post failed");
+	pgm_reactor_destroy (reactor);
+}
+END_TEST
+
+START_TEST (test_post_fail_002)
+{
+	pgm_reactor_t* reactor = NULL;
+	fail_unless (TRUE == pgm_reactor_create (&reactor, TEST_CORES, mock_event_func, NULL), "create failed");
+	fail_unless (FALSE == pgm_reactor_post (reactor, 0, NULL, NULL), "post failed");
+	pgm_reactor_destroy (reactor);
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_reactor_add (
+ *		pgm_reactor_t*		reactor,
+ *		pgm_sock_t*		sock,
+ *		void*			user_data,
+ *		pgm_error_t**		error
+ *		)
+ */
+
+/* socket added on a core is serviced on that core until removed */
+START_TEST (test_add_pass_001)
+{
+	pgm_reactor_t* reactor = NULL;
+	struct test_task_t task, event;
+	int user_data;
+	SOCKET peer;
+	const char one = '1';
+	fail_unless (TRUE == pgm_reactor_create (&reactor, TEST_CORES, mock_event_func, NULL), "create failed");
+	memset (&task, 0, sizeof (task));
+	memset (&event, 0, sizeof (event));
+	event.reactor = reactor;
+	event.self = -1;
+	mock_event_task = &event;
+	task.reactor = reactor;
+	task.sock = generate_sock (&peer);
+	task.user_data = &user_data;
+	fail_unless (TRUE == pgm_reactor_post (reactor, 1, task_add, &task), "post failed");
+	wait_for_done ();
+	fail_unless (TRUE == task.result, "add failed");
+	fail_unless (1 == send (peer, &one, sizeof (one), 0), "send failed");
+	wait_for_done ();
+	fail_unless (task.sock == event.sock, "sock failed");
+	fail_unless (PGM_SELECTOR_DATA == event.events, "events failed");
+	fail_unless (&user_data == event.user_data, "user_data failed");
+	fail_unless (1 == event.self, "self failed");
+	fail_unless (TRUE == pgm_reactor_post (reactor, 1, task_remove, &task), "post failed");
+	wait_for_done ();
+	fail_unless (TRUE == task.result, "remove failed");
+/* not owned by another core */
+	fail_unless (TRUE == pgm_reactor_post (reactor, 0, task_remove, &task), "post failed");
+	wait_for_done ();
+	fail_unless (FALSE == task.result, "remove failed");
+	pgm_reactor_destroy (reactor);
+}
+END_TEST
+
+/* not called on a core */
+START_TEST (test_add_fail_001)
+{
+	pgm_reactor_t* reactor = NULL;
+	pgm_error_t* err = NULL;
+	SOCKET peer;
+	fail_unless (TRUE == pgm_reactor_create (&reactor, TEST_CORES, mock_null_event_func, NULL), "create failed");
+	pgm_sock_t* sock = generate_sock (&peer);
+	fail_unless (FALSE == pgm_reactor_add (reactor, sock, NULL, &err), "add failed");
+	fail_if (NULL == err, "error not raised");
+	fail_unless (PGM_ERROR_INVAL == err->code, "error code failed");
+	fail_unless (FALSE == pgm_reactor_remove (reactor, sock), "remove failed");
+	pgm_error_free (err);
+	pgm_reactor_destroy (reactor);
+}
+END_TEST
+
+/* called on a core of another reactor */
+START_TEST (test_add_fail_002)
+{
+	pgm_reactor_t *reactor = NULL, *other = NULL;
+	struct test_task_t task;
+	SOCKET peer;
+	fail_unless (TRUE == pgm_reactor_create (&reactor, TEST_CORES, mock_null_event_func, NULL), "create failed");
+	fail_unless (TRUE == pgm_reactor_create (&other, 1, mock_null_event_func, NULL), "create failed");
+	memset (&task, 0, sizeof (task));
+	task.reactor = reactor;
+	task.sock = generate_sock (&peer);
+	task.result = TRUE;
+	fail_unless (TRUE == pgm_reactor_post (other, 0, task_add, &task), "post failed");
+	wait_for_done ();
+	fail_unless (FALSE == task.result, "add failed");
+	pgm_reactor_destroy (other);
+	pgm_reactor_destroy (reactor);
+}
+END_TEST
+
+
+static
+Suite*
+make_test_suite (void)
+{
+	Suite* s;
+
+	s = suite_create (__FILE__);
+
+	TCase* tc_create = tcase_create ("create");
+	suite_add_tcase (s, tc_create);
+	tcase_add_checked_fixture (tc_create, mock_setup, mock_teardown);
+	tcase_add_test (tc_create, test_create_pass_001);
+	tcase_add_test (tc_create, test_create_pass_002);
+	tcase_add_test (tc_create, test_create_fail_001);
+	tcase_add_test (tc_create, test_create_fail_002);
+
+	TCase* tc_post = tcase_create ("post");
+	suite_add_tcase (s, tc_post);
+	tcase_add_checked_fixture (tc_post, mock_setup, mock_teardown);
+	tcase_add_test (tc_post, test_post_pass_001);
+	tcase_add_test (tc_post, test_post_fail_001);
+	tcase_add_test (tc_post, test_post_fail_002);
+
+	TCase* tc_add = tcase_create ("add");
+	suite_add_tcase (s, tc_add);
+	tcase_add_checked_fixture (tc_add, mock_setup, mock_teardown);
+	tcase_add_test (tc_add, test_add_pass_001);
+	tcase_add_test (tc_add, test_add_fail_001);
+	tcase_add_test (tc_add, test_add_fail_002);
+	return s;
+}
+
+static
+Suite*
+make_master_suite (void)
+{
+	Suite* s = suite_create ("Master");
+	return s;
+}
+
+int
+main (void)
+{
+	g_assert (pgm_time_init (NULL));
+	SRunner* sr = srunner_create (make_master_suite ());
+	srunner_add_suite (sr, make_test_suite ());
+	srunner_run_all (sr, CK_ENV);
+	int number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	g_assert (pgm_time_shutdown ());
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* eof */
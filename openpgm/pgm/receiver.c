@@ -23,13 +23,22 @@
 #	include <config.h>
 #endif
 #include <errno.h>
+#include <math.h>
 #include <impl/i18n.h>
 #include <impl/framework.h>
 #include <impl/receiver.h>
 #include <impl/sqn_list.h>
+#include <impl/stats.h>
+#include <impl/dlr.h>
+#include <impl/relay.h>
 #include <impl/timer.h>
 #include <impl/packet_parse.h>
 #include <impl/net.h>
+#include <impl/shard.h>
+#include <impl/groups.h>
+#include <impl/flightrec.h>
+#include <impl/xdp_filter.h>
+#include <impl/checkpoint.h>
 
 
 //#define RECEIVER_DEBUG
@@ -39,15 +48,37 @@
 #	define PGM_DISABLE_ASSERT
 #endif
 
+/* receive fast path fields of a peer share its first cache line */
+PGM_STATIC_ASSERT(offsetof(struct pgm_peer_t, timer_index) + sizeof(unsigned) <= 64);
 
+/* socket locks do not share cache lines with configuration or send state */
+PGM_STATIC_ASSERT(offsetof(struct pgm_sock_t, lock) - offsetof(struct pgm_sock_t, sndbuf) >= PGM_CACHELINE_PAD);
+PGM_STATIC_ASSERT(offsetof(struct pgm_sock_t, window) - offsetof(struct pgm_sock_t, timer_mutex) >= PGM_CACHELINE_PAD);
+
+
+static bool nak_batch_push (pgm_sock_t*const restrict, struct pgm_rx_shard_t*const restrict, const bool, const void*const restrict, const size_t, const struct sockaddr*const restrict);
+static bool nak_batch_flush (pgm_sock_t*const restrict, struct pgm_rx_shard_t*const restrict);
 static bool send_spmr (pgm_sock_t*const restrict, pgm_peer_t*const restrict);
+static bool send_polr (pgm_sock_t*const restrict, pgm_peer_t*const restrict, const pgm_time_t);
 static bool send_nak (pgm_sock_t*const restrict, pgm_peer_t*const restrict, const uint32_t);
 static bool send_parity_nak (pgm_sock_t*const restrict, pgm_peer_t*const restrict, const unsigned, const unsigned);
 static bool send_nak_list (pgm_sock_t*const restrict, pgm_peer_t*const restrict, const struct pgm_sqn_list_t*const restrict);
+static bool send_nak_range (pgm_sock_t*const restrict, pgm_peer_t*const restrict, const struct pgm_sqn_range_list_t*const restrict);
+static void confirm_nak_range (pgm_peer_t*const restrict, const struct pgm_opt_header*const restrict, const uint32_t, const pgm_time_t, const pgm_time_t, const pgm_time_t);
 static bool nak_rb_state (pgm_sock_t*restrict, pgm_peer_t*restrict, const pgm_time_t);
 static void nak_rpt_state (pgm_sock_t*restrict, pgm_peer_t*restrict, const pgm_time_t);
 static void nak_rdata_state (pgm_sock_t*restrict, pgm_peer_t*restrict, const pgm_time_t);
+static void deadline_state (pgm_sock_t*restrict, pgm_peer_t*restrict, const pgm_time_t);
+static void peer_repair_schedule (pgm_sock_t*const restrict, pgm_peer_t*const restrict, const uint32_t, const pgm_time_t);
+static void peer_repair_cancel (pgm_peer_t*const, const uint32_t);
+static void peer_repair_state (pgm_sock_t*restrict, pgm_peer_t*restrict, const pgm_time_t);
 static inline pgm_peer_t* _pgm_peer_ref (pgm_peer_t*);
+static pgm_time_t peer_next_expiry (const pgm_sock_t*const restrict, const pgm_peer_t*const restrict);
+static void peer_heap_insert (struct pgm_rx_shard_t*const restrict, pgm_peer_t*const restrict);
+static void peer_heap_remove (struct pgm_rx_shard_t*const restrict, pgm_peer_t*const restrict);
+static void peer_heap_reschedule (struct pgm_rx_shard_t*const, const unsigned);
+static void late_join (pgm_sock_t*const restrict, pgm_peer_t*const restrict, const struct pgm_sk_buff_t*const restrict, const uint32_t);
+static void peer_latency_update (const pgm_sock_t*const restrict, pgm_peer_t*const restrict, const pgm_rxw_cursor_t*const restrict, const struct pgm_msgv_t*, uint32_t);
 static bool on_general_poll (pgm_sock_t*const restrict, pgm_peer_t*const restrict, struct pgm_sk_buff_t*const restrict);
 static bool on_dlr_poll (pgm_sock_t*const restrict, pgm_peer_t*const restrict, struct pgm_sk_buff_t*const restrict);
 
@@ -74,15 +105,13 @@ next_nak_rb_expiry (
 	const pgm_rxw_t*	window
 	)
 {
-	const struct pgm_sk_buff_t* skb;
-	const pgm_rxw_state_t* state;
+	const pgm_rxw_gap_t* gap;
 
 	pgm_assert (NULL != window);
 	pgm_assert (NULL != window->nak_backoff_queue.tail);
 
-	skb = (const struct pgm_sk_buff_t*)window->nak_backoff_queue.tail;
-	state = (const pgm_rxw_state_t*)&skb->cb;
-	return state->timer_expiry;
+	gap = (const pgm_rxw_gap_t*)window->nak_backoff_queue.tail;
+	return gap->state.timer_expiry;
 }
 
 static inline
@@ -91,15 +120,13 @@ next_nak_rpt_expiry (
 	const pgm_rxw_t*	window
 	)
 {
-	const struct pgm_sk_buff_t* skb;
-	const pgm_rxw_state_t* state;
+	const pgm_rxw_gap_t* gap;
 
 	pgm_assert (NULL != window);
 	pgm_assert (NULL != window->wait_ncf_queue.tail);
 
-	skb = (const struct pgm_sk_buff_t*)window->wait_ncf_queue.tail;
-	state = (const pgm_rxw_state_t*)&skb->cb;
-	return state->timer_expiry;
+	gap = (const pgm_rxw_gap_t*)window->wait_ncf_queue.tail;
+	return gap->state.timer_expiry;
 }
 
 static inline
@@ -108,15 +135,13 @@ next_nak_rdata_expiry (
 	const pgm_rxw_t*	window
 	)
 {
-	const struct pgm_sk_buff_t* skb;
-	const pgm_rxw_state_t* state;
+	const pgm_rxw_gap_t* gap;
 
 	pgm_assert (NULL != window);
 	pgm_assert (NULL != window->wait_data_queue.tail);
 
-	skb = (const struct pgm_sk_buff_t*)window->wait_data_queue.tail;
-	state = (const pgm_rxw_state_t*)&skb->cb;
-	return state->timer_expiry;
+	gap = (const pgm_rxw_gap_t*)window->wait_data_queue.tail;
+	return gap->state.timer_expiry;
 }
 
 /* calculate ACK_RB_IVL.
@@ -135,41 +160,104 @@ ack_rb_ivl (
 	return pgm_rand_int_range (&sock->rand_, 1 /* us */, (int32_t)sock->ack_bo_ivl);
 }
 
-/* calculate NAK_RB_IVL as random time interval 1 - NAK_BO_IVL.
+/* calculate NAK_RB_IVL as random time interval 1 - NAK_BO_IVL.  with
+ * PGM_NAK_ADAPTIVE NAK_BO_IVL follows the smoothed round-trip time of the peer.
+ *
+ * with PGM_NAK_POPULATION the interval is exponentially distributed over the
+ * same range for N receivers, λ = ln N + 1,
+ *
+ *   t = NAK_BO_IVL / λ · ln (1 + u (e^λ - 1))
+ *
+ * such that the NAKs sent before the first is heard stay few however many
+ * receivers share a loss, Nonnenmacher & Biersack.
  */
 static inline
 uint32_t
 nak_rb_ivl (
-	pgm_sock_t*		sock
+	pgm_sock_t*	    restrict sock,
+	const pgm_peer_t*   restrict peer
 	)	/* not const as rand() updates the seed */
 {
+	pgm_time_t nak_bo_ivl;
+
 /* pre-conditions */
 	pgm_assert (NULL != sock);
+	pgm_assert (NULL != peer);
 	pgm_assert_cmpuint (sock->nak_bo_ivl, >, 1);
 
-	return pgm_rand_int_range (&sock->rand_, 1 /* us */, (int32_t)sock->nak_bo_ivl);
+	nak_bo_ivl = sock->nak_bo_ivl;
+	if (sock->use_adaptive_nak && 0 != peer->nak_srtt)
+		nak_bo_ivl = MIN( nak_bo_ivl, MAX( PGM_NAK_ADAPTIVE_MIN_IVL, peer->nak_srtt ) );
+	if (0 != sock->nak_population) {
+		const uint32_t population = peer->population ? peer->population : sock->nak_population;
+		const double lambda = log ((double)population) + 1.0;
+		const double u = (double)pgm_rand_int_range (&sock->rand_, 1, INT32_MAX) / (double)INT32_MAX;
+		const double t = (double)nak_bo_ivl / lambda * log (1.0 + u * (exp (lambda) - 1.0));
+		return (uint32_t)MAX( 1.0 /* us */, t );
+	}
+	return pgm_rand_int_range (&sock->rand_, 1 /* us */, (int32_t)nak_bo_ivl);
+}
+
+/* NAK_RPT_IVL or NAK_RDATA_IVL of a peer.  with PGM_NAK_ADAPTIVE the
+ * retransmission timeout of the smoothed round-trip time and variance as
+ * RFC 6298, RTO = SRTT + 4 × RTTVAR, bounded by the socket interval.
+ */
+static inline
+pgm_time_t
+nak_peer_ivl (
+	const pgm_sock_t* restrict sock,
+	const pgm_peer_t* restrict peer,
+	const pgm_time_t	   ivl
+	)
+{
+	if (!sock->use_adaptive_nak || 0 == peer->nak_srtt)
+		return ivl;
+	const pgm_time_t rto = peer->nak_srtt + 4 * peer->nak_rttvar;
+	return MIN( ivl, MAX( PGM_NAK_ADAPTIVE_MIN_IVL, rto ) );
+}
+
+/* update the smoothed round-trip time of a peer with a sample of NAK to NCF or
+ * NAK to RDATA, gains α = 1/8 and β = 1/4.
+ */
+static
+void
+nak_rtt_update (
+	pgm_peer_t*		peer,
+	const pgm_time_t	rtt
+	)
+{
+	if (0 == rtt)
+		return;
+	if (0 == peer->nak_srtt) {
+		peer->nak_srtt   = rtt;
+		peer->nak_rttvar = rtt / 2;
+		return;
+	}
+	const pgm_time_t delta = (peer->nak_srtt > rtt) ? peer->nak_srtt - rtt : rtt - peer->nak_srtt;
+	peer->nak_rttvar = (3 * peer->nak_rttvar + delta) / 4;
+	peer->nak_srtt   = (7 * peer->nak_srtt + rtt) / 8;
 }
 
-/* mark sequence as recovery failed.
+/* mark gap of sequences as recovery failed.
  */
 
 static
 void
-cancel_skb (
-	pgm_sock_t*	    	    restrict sock,
-	pgm_peer_t*		    restrict peer,
-	const struct pgm_sk_buff_t* restrict skb,
-	const pgm_time_t		     now
+cancel_gap (
+	pgm_sock_t*	    restrict sock,
+	pgm_peer_t*	    restrict peer,
+	pgm_rxw_gap_t*	    restrict gap,
+	const pgm_time_t	     now
 	)
 {
 	pgm_assert (NULL != sock);
 	pgm_assert (NULL != peer);
-	pgm_assert (NULL != skb);
-	pgm_assert_cmpuint (now, >=, skb->tstamp);
+	pgm_assert (NULL != gap);
+	pgm_assert_cmpuint (now, >=, gap->tstamp);
 
-	pgm_trace (PGM_LOG_ROLE_RX_WINDOW, _("Lost data #%u due to cancellation."), skb->sequence);
+	pgm_trace (PGM_LOG_ROLE_RX_WINDOW, _("Lost data #%u-%u due to cancellation."), gap->sequence, gap->sequence + gap->len - 1);
 
-	const uint32_t fail_time = (uint32_t)(now - skb->tstamp);
+	const uint32_t fail_time = (uint32_t)(now - gap->tstamp);
 	if (!peer->max_fail_time)
 		peer->max_fail_time = peer->min_fail_time = fail_time;
 	else if (fail_time > peer->max_fail_time)
@@ -177,7 +265,7 @@ cancel_skb (
 	else if (fail_time < peer->min_fail_time)
 		peer->min_fail_time = fail_time;
 
-	pgm_rxw_lost (peer->window, skb->sequence);
+	pgm_rxw_state (peer->window, gap, PGM_PKT_STATE_LOST_DATA);
 	PGM_HISTOGRAM_TIMES("Rx.FailTime", fail_time);
 
 /* mark receiver window for flushing on next recv() */
@@ -302,17 +390,29 @@ pgm_peer_unref (
 		return;
 
 /* receive window */
+	pgm_xdp_filter_remove (peer->window->xdp_filter, &peer->tsi);
 	pgm_rxw_destroy (peer->window);
 	peer->window = NULL;
+	if (NULL != peer->dlr) {
+		pgm_dlr_destroy (peer->dlr);
+		peer->dlr = NULL;
+	}
+	if (NULL != peer->repair) {
+		pgm_mem_slab_free (peer->slab, peer->repair, PGM_PEER_REPAIR_MAX * sizeof (struct pgm_peer_repair_t));
+		peer->repair = NULL;
+	}
+	pgm_mem_slab_free (peer->slab, peer->rates, sizeof (struct pgm_stats_ring_t));
+	peer->rates = NULL;
 
 /* object */
-	pgm_free (peer);
+	pgm_mem_slab_free (peer->slab, peer, sizeof (pgm_peer_t));
 	peer = NULL;
 }
 
 /* find PGM options in received SKB.
  *
- * returns TRUE if opt_fragment is found, otherwise FALSE is returned.
+ * returns TRUE if opt_fragment, opt_pgmcc_data or opt_coalesce is found,
+ * otherwise FALSE is returned.
  */
 
 static
@@ -357,6 +457,36 @@ get_pgm_options (
 			found_opt = TRUE;
 			break;
 
+		case PGM_OPT_COALESCE:
+			skb->coalesced = 1;
+			found_opt = TRUE;
+			break;
+
+		case PGM_OPT_COMPRESS:
+			if (PGM_UNLIKELY(opt_header->opt_length != sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_compress)))
+				break;
+			skb->compressed = 1;
+			found_opt = TRUE;
+			break;
+
+		case PGM_OPT_UNRELIABLE:
+			if (PGM_UNLIKELY(opt_header->opt_length != sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_unreliable)))
+				break;
+			skb->unreliable = 1;
+			found_opt = TRUE;
+			break;
+
+		case PGM_OPT_TIMESTAMP:
+			if (PGM_UNLIKELY(opt_header->opt_length != sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_timestamp)))
+				break;
+			{
+				const struct pgm_opt_timestamp* opt_timestamp = (const struct pgm_opt_timestamp*)(opt_header + 1);
+				skb->send_tstamp = ((pgm_time_t)pgm_ntohl (opt_timestamp->opt_tstamp_hi) << 32) |
+						   pgm_ntohl (opt_timestamp->opt_tstamp_lo);
+			}
+			found_opt = TRUE;
+			break;
+
 		default: break;
 		}
 
@@ -364,11 +494,66 @@ get_pgm_options (
 	return found_opt;
 }
 
+/* receive window as configured on the socket, owned by tsi.
+ */
+
+static
+pgm_rxw_t*
+receiver_window_new (
+	pgm_sock_t*      const restrict sock,
+	const pgm_tsi_t* const restrict tsi
+	)
+{
+	pgm_rxw_t* window = pgm_rxw_create_from (sock->peer_slab,
+						 tsi,
+						 sock->max_tpdu,
+						 sock->rxw_sqns,
+						 sock->rxw_sqns ? 0 : sock->rxw_secs,	/* resized live */
+						 sock->rxw_sqns ? 0 : sock->rxw_max_rte,
+						 sock->ack_c_p);
+	if (sock->rxw_min_sqns)
+		pgm_rxw_set_min_length (window, sock->rxw_min_sqns, sock->use_rxw_shrink);
+	return window;
+}
+
+/* ready receive windows and peer table slots for the expected number of
+ * peers ahead of the first packets.  windows wait on sock->rxw_spare for
+ * pgm_new_peer() and are released with the socket when unclaimed.
+ *
+ * returns bytes touched.
+ */
+
+PGM_GNUC_INTERNAL
+size_t
+pgm_receiver_prewarm (
+	pgm_sock_t* const	sock
+	)
+{
+	size_t touched = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (sock->can_recv_data);
+	pgm_assert (sock->prewarm_peers > 0);
+	pgm_assert (NULL == sock->rxw_spare);
+
+	sock->rxw_spare = pgm_new (pgm_rxw_t*, sock->prewarm_peers);
+	while (sock->rxw_spare_len < sock->prewarm_peers) {
+		pgm_rxw_t* window = receiver_window_new (sock, &sock->tsi);
+		touched += pgm_rxw_prewarm (window);
+		sock->rxw_spare[ sock->rxw_spare_len++ ] = window;
+	}
+	const unsigned per_shard = (sock->prewarm_peers + sock->rx_shard_len - 1) / sock->rx_shard_len;
+	for (unsigned i = 0; i < sock->rx_shard_len; i++)
+		touched += pgm_peer_table_reserve (sock->rx_shard[ i ].peers_table, per_shard);
+	return touched;
+}
+
 /* a peer in the context of the sock is another party on the network sending PGM
  * packets.  for each peer we need a receive window and network layer address (nla) to
  * which nak requests can be forwarded to.
  *
- * on success, returns new peer object.
+ * on success, returns new peer object, returns NULL over the memory budget.
  */
 
 PGM_GNUC_INTERNAL
@@ -400,40 +585,209 @@ pgm_new_peer (
 		(void*)sock, pgm_tsi_print (tsi), saddr, (unsigned)src_addrlen, daddr, (unsigned)dst_addrlen);
 #endif
 
-	peer = pgm_new0 (pgm_peer_t, 1);
+/* shed new sources before existing ones */
+	if (PGM_UNLIKELY(pgm_mem_budget_is_exceeded (&sock->mem_budget))) {
+		pgm_trace (PGM_LOG_ROLE_SESSION,_("Refusing new peer %s over memory budget."),
+			   pgm_tsi_print (tsi));
+		return NULL;
+	}
+
+	peer = pgm_mem_slab_alloc0 (sock->peer_slab, sizeof (pgm_peer_t));
+	peer->slab = sock->peer_slab;
 	peer->expiry = now + sock->peer_expiry;
+	peer->rates = pgm_mem_slab_alloc0 (peer->slab, sizeof (struct pgm_stats_ring_t));
 	memcpy (&peer->tsi, tsi, sizeof(pgm_tsi_t));
 	memcpy (&peer->group_nla, dst_addr, dst_addrlen);
 	memcpy (&peer->local_nla, src_addr, src_addrlen);
 /* port at same location for sin/sin6 */
 	((struct sockaddr_in*)&peer->local_nla)->sin_port = pgm_htons (sock->udp_encap_ucast_port);
 	((struct sockaddr_in*)&peer->nla)->sin_port       = pgm_htons (sock->udp_encap_ucast_port);
+	if (AF_UNSPEC != sock->dlr_nla.ss_family) {
+		memcpy (&peer->redirect_nla, &sock->dlr_nla, pgm_sockaddr_len ((struct sockaddr*)&sock->dlr_nla));
+		((struct sockaddr_in*)&peer->redirect_nla)->sin_port = pgm_htons (sock->udp_encap_ucast_port);
+	}
 
-/* lock on rx window */
-	peer->window = pgm_rxw_create (&peer->tsi,
-					sock->max_tpdu,
-					sock->rxw_sqns,
-					sock->rxw_secs,
-					sock->rxw_max_rte,
-					sock->ack_c_p);
+/* lock on rx window, prewarmed by pgm_connect() while stock lasts */
+	peer->window = NULL;
+	if (NULL != sock->rxw_spare) {
+		pgm_rwlock_writer_lock (&sock->peers_lock);
+		if (sock->rxw_spare_len > 0) {
+			peer->window = sock->rxw_spare[ --sock->rxw_spare_len ];
+			peer->window->tsi = &peer->tsi;
+		}
+		pgm_rwlock_writer_unlock (&sock->peers_lock);
+	}
+	if (NULL == peer->window)
+		peer->window = receiver_window_new (sock, &peer->tsi);
+	peer->window->skb_pool = sock->skb_pool;
+	peer->window->is_unordered = sock->use_unordered;
+	peer->window->spill_max = sock->rxw_spill_bytes;
+	if (sock->rx_reasm_len > 0) {
+		peer->window->reasm_min = sock->rx_reasm_len;
+		peer->window->reasm_pool = sock->reasm_pool;
+	}
+	if (NULL != sock->inflate_pool[0])
+		peer->window->inflate_pool = sock->inflate_pool;
+	peer->window->budget = &sock->mem_budget;
+	peer->window->flightrec = sock->flightrec;
+	peer->window->xdp_filter = sock->xdp_filter;
+	peer->window->decode_pool = sock->decode_pool;
 	peer->spmr_expiry = now + sock->spmr_expiry;
+	pgm_peer_update_weight (sock, peer);
 
-/* add peer to hash table and linked list */
+/* add peer to hash table of the owning shard and linked list */
+	peer->shard = pgm_rx_shard_for (sock, &peer->tsi);
+	peer->window->decode_ready = &peer->shard->decode_ready;
 	pgm_rwlock_writer_lock (&sock->peers_lock);
-	pgm_hashtable_insert (sock->peers_hashtable, &peer->tsi, _pgm_peer_ref (peer));
+	if (NULL != sock->restore)
+		pgm_checkpoint_apply (sock, peer);
+	pgm_peer_table_insert (peer->shard->peers_table, &peer->tsi, _pgm_peer_ref (peer));
 	peer->peers_link.data = peer;
 	sock->peers_list = pgm_list_prepend_link (sock->peers_list, &peer->peers_link);
 	pgm_rwlock_writer_unlock (&sock->peers_lock);
 
-	pgm_timer_lock (sock);
-	if (pgm_time_after( sock->next_poll, peer->spmr_expiry ))
-		sock->next_poll = peer->spmr_expiry;
-	pgm_timer_unlock (sock);
+/* schedule state timers */
+	peer->timer_expiry = peer_next_expiry (sock, peer);
+	peer_heap_insert (peer->shard, peer);
+
+	pgm_timer_pull (sock, peer->shard, peer->spmr_expiry);
 	return peer;
 }
 
+/* limit a cursor to at most len further messages, restored by the caller.
+ */
+
+static inline
+void
+cursor_clamp (
+	pgm_rxw_cursor_t* const	cursor,
+	const unsigned		len
+	)
+{
+	if (NULL == cursor->skbv) {
+		if ((size_t)(cursor->msgv_end - cursor->msgv) >= len)
+			cursor->msgv_end = cursor->msgv + len - 1;
+	} else if (cursor->skbv->skbv_msg_len - cursor->skbv->skbv_msg_used > len) {
+		cursor->skbv->skbv_msg_len = cursor->skbv->skbv_msg_used + len;
+	}
+}
+
+/* slot of the PGM_CONFLATE key table of a shard */
+struct pgm_conflate_slot_t {
+	uint64_t		key;
+	uint32_t		gen;
+};
+
+/* size the key table for len messages at no more than half load and start a
+ * new generation, such that every slot reads as empty without clearing.
+ */
+
+static
+void
+conflate_table_reset (
+	struct pgm_rx_shard_t* const	shard,
+	const unsigned			len
+	)
+{
+	unsigned size = shard->conflate_size ? shard->conflate_size : 64;
+	while (size < 2 * len)
+		size <<= 1;
+	if (size != shard->conflate_size) {
+		pgm_free (shard->conflate_table);
+		shard->conflate_table = pgm_new0 (struct pgm_conflate_slot_t, size);
+		shard->conflate_size  = size;
+		shard->conflate_gen   = 0;
+	}
+	if (PGM_UNLIKELY(0 == ++(shard->conflate_gen))) {
+		memset (shard->conflate_table, 0, size * sizeof (struct pgm_conflate_slot_t));
+		shard->conflate_gen = 1;
+	}
+}
+
+/* returns TRUE if key is already in the table, otherwise adds key.
+ */
+
+static inline
+bool
+conflate_test_and_set (
+	struct pgm_rx_shard_t* const	shard,
+	const uint64_t			key
+	)
+{
+	struct pgm_conflate_slot_t* table = shard->conflate_table;
+	const unsigned mask = shard->conflate_size - 1;
+	unsigned i = (unsigned)((key * UINT64_C(0x9e3779b97f4a7c15)) >> 32) & mask;
+	while (shard->conflate_gen == table[ i ].gen) {
+		if (key == table[ i ].key)
+			return TRUE;
+		i = (i + 1) & mask;
+	}
+	table[ i ].key = key;
+	table[ i ].gen = shard->conflate_gen;
+	return FALSE;
+}
+
+/* keep only the last message of each key amongst those of one peer from msgv
+ * up to the cursor, closing the gaps in delivery order.  messages without a
+ * key are always kept.  superseded packets are committed in the window and
+ * released as usual on the next read.
+ *
+ * returns bytes of the superseded messages.
+ */
+
+static
+size_t
+peer_conflate (
+	pgm_sock_t*		 const restrict	sock,
+	struct pgm_rx_shard_t*	 const restrict	shard,
+	pgm_peer_t*		 const restrict	peer,
+	pgm_rxw_cursor_t*	 const restrict	cursor,
+	struct pgm_msgv_t*	 const restrict	msgv
+	)
+{
+	const unsigned len = (unsigned)(cursor->msgv - msgv);
+	unsigned conflated = 0;
+	size_t bytes = 0;
+
+	if (len < 2)
+		return 0;
+	conflate_table_reset (shard, len);
+/* newest first, superseded messages marked by an empty vector */
+	for (struct pgm_msgv_t* m = cursor->msgv; m-- > msgv; ) {
+		uint64_t key;
+		if (!sock->conflate_key (m, &key, sock->conflate_data) ||
+		    !conflate_test_and_set (shard, key))
+			continue;
+		for (unsigned j = 0; j < m->msgv_len; j++)
+			bytes += m->msgv_skb[ j ]->len;
+		m->msgv_len = 0;
+		conflated++;
+	}
+	if (0 == conflated)
+		return 0;
+	struct pgm_msgv_t* keep = msgv;
+	for (struct pgm_msgv_t* m = msgv; m < cursor->msgv; m++) {
+		if (0 == m->msgv_len)
+			continue;
+		if (keep != m) {
+			keep->msgv_len = m->msgv_len;
+			memcpy (keep->msgv_skb, m->msgv_skb, m->msgv_len * sizeof (struct pgm_sk_buff_t*));
+		}
+		keep++;
+	}
+	cursor->msgv = keep;
+	peer->cumulative_stats[PGM_PC_RECEIVER_MSGS_CONFLATED] += conflated;
+	shard->conflate_drops += conflated;
+	return bytes;
+}
+
 /* copy any contiguous buffers in the peer list to the provided 
- * message vector.
+ * message vector or compact vector.
+ *
+ * with a receive quantum each peer commits at most quantum × weight messages
+ * per turn before moving to the tail of the list, such that one busy source
+ * cannot fill every vector ahead of the others.
+ *
  * returns -PGM_SOCK_ENOBUFS if the vector is full, returns -PGM_SOCK_ECONNRESET if
  * data loss is detected, returns 0 when all peers flushed.
  */
@@ -442,8 +796,8 @@ PGM_GNUC_INTERNAL
 int
 pgm_flush_peers_pending (
 	pgm_sock_t* 	 	 const restrict	sock,
-	struct pgm_msgv_t**    	       restrict	pmsg,
-	const struct pgm_msgv_t* const		msg_end,	/* at least pmsg + 1, same object */
+	struct pgm_rx_shard_t*	 const restrict	shard,
+	pgm_rxw_cursor_t*	 const restrict	cursor,		/* not full */
 	size_t*		 	 const restrict	bytes_read,	/* added to, not set */
 	unsigned*	 	 const restrict	data_read
 	)
@@ -452,25 +806,59 @@ pgm_flush_peers_pending (
 
 /* pre-conditions */
 	pgm_assert (NULL != sock);
-	pgm_assert (NULL != pmsg);
-	pgm_assert (NULL != *pmsg);
-	pgm_assert (NULL != msg_end);
+	pgm_assert (NULL != shard);
+	pgm_assert (NULL != cursor);
 	pgm_assert (NULL != bytes_read);
 	pgm_assert (NULL != data_read);
 
-	pgm_debug ("pgm_flush_peers_pending (sock:%p pmsg:%p msg-end:%p bytes-read:%p data-read:%p)",
-		(const void*)sock, (const void*)pmsg, (const void*)msg_end, (const void*)bytes_read, (const void*)data_read);
+	const unsigned quantum = sock->recv_quantum;
 
-	while (sock->peers_pending)
+	pgm_debug ("pgm_flush_peers_pending (sock:%p shard:%u cursor:%p bytes-read:%p data-read:%p)",
+		(const void*)sock, shard->index, (const void*)cursor, (const void*)bytes_read, (const void*)data_read);
+
+	while (shard->peers_pending)
 	{
-		pgm_peer_t* peer = sock->peers_pending->data;
-		if (peer->last_commit && peer->last_commit < sock->last_commit)
+		pgm_peer_t* peer = shard->peers_pending->data;
+		if (peer->last_commit && peer->last_commit < shard->last_commit)
 			pgm_rxw_remove_commit (peer->window);
-		const ssize_t peer_bytes = pgm_rxw_readv (peer->window, pmsg, (unsigned)(msg_end - *pmsg + 1));
+		struct pgm_msgv_t* msgv = cursor->msgv;
+		const uint32_t skb_used = (NULL != cursor->skbv) ? cursor->skbv->skbv_skb_used : 0;
+/* clamp the cursor to the quantum of the peer */
+		const struct pgm_msgv_t* msgv_end = cursor->msgv_end;
+		const uint32_t msg_len = (NULL != cursor->skbv) ? cursor->skbv->skbv_msg_len : 0;
+		if (quantum)
+			cursor_clamp (cursor, quantum * peer->weight);
+		ssize_t peer_bytes = pgm_rxw_read (peer->window, cursor);
+/* refill the messages freed by conflation whilst the window holds more, until
+ * a pass frees under a quarter of those read, bounding the key extractions
+ * per message.
+ */
+		if (peer_bytes >= 0 && NULL != sock->conflate_key && NULL == cursor->skbv) {
+			for (;;) {
+				const bool was_full = pgm_rxw_cursor_is_full (cursor);
+				const struct pgm_msgv_t* read_end = cursor->msgv;
+				peer_bytes -= (ssize_t)peer_conflate (sock, shard, peer, cursor, msgv);
+				if (!was_full || 4 * (read_end - cursor->msgv) < read_end - msgv)
+					break;
+				const ssize_t more_bytes = pgm_rxw_read (peer->window, cursor);
+				if (more_bytes < 0)
+					break;
+				peer_bytes += more_bytes;
+			}
+		}
+		bool is_quantum_spent = FALSE;
+		if (quantum) {
+			is_quantum_spent = pgm_rxw_cursor_is_full (cursor);
+			cursor->msgv_end = msgv_end;
+			if (NULL != cursor->skbv)
+				cursor->skbv->skbv_msg_len = msg_len;
+		}
+		if (peer_bytes > 0 && (sock->use_rx_timestamp || peer->has_send_tstamp))
+			peer_latency_update (sock, peer, cursor, msgv, skb_used);
 
 		if (peer->last_cumulative_losses != ((pgm_rxw_t*)peer->window)->cumulative_losses)
 		{
-			sock->is_reset = TRUE;
+			shard->is_reset = TRUE;
 			peer->lost_count = ((pgm_rxw_t*)peer->window)->cumulative_losses - peer->last_cumulative_losses;
 			peer->last_cumulative_losses = ((pgm_rxw_t*)peer->window)->cumulative_losses;
 		}
@@ -479,24 +867,98 @@ pgm_flush_peers_pending (
 		{
 			(*bytes_read) += peer_bytes;
 			(*data_read)  ++;
-			peer->last_commit = sock->last_commit;
-			if (*pmsg > msg_end) {			/* commit full */
+			peer->last_commit = shard->last_commit;
+			if (pgm_rxw_cursor_is_full (cursor)) {	/* commit full */
 				retval = -PGM_SOCK_ENOBUFS;
 				break;
 			}
 		} else
 			peer->last_commit = 0;
-		if (PGM_UNLIKELY(sock->is_reset)) {
+		if (PGM_UNLIKELY(shard->is_reset)) {
 			retval = -PGM_SOCK_ECONNRESET;
 			break;
 		}
+/* quantum spent with data remaining, take another turn after the other peers */
+		if (is_quantum_spent && peer_bytes >= 0) {
+			if (NULL != shard->peers_pending->next) {
+				pgm_slist_t* link = shard->peers_pending;
+				shard->peers_pending = link->next;
+				link->next = NULL;
+				shard->peers_pending_tail->next = link;
+				shard->peers_pending_tail = link;
+			}
+			continue;
+		}
 /* clear this reference and move to next */
-		sock->peers_pending = pgm_slist_remove_first (sock->peers_pending);
+		shard->peers_pending = pgm_slist_remove_first (shard->peers_pending);
 	}
 
 	return retval;
 }
 
+static inline
+void
+latency_bucket_add (
+	uint32_t*		buckets,
+	const pgm_time_t	now,
+	const pgm_time_t	then
+	)
+{
+	pgm_time_t latency = pgm_time_after (now, then) ? now - then : 0;
+	unsigned bucket = 0;
+	while (latency && bucket < PGM_RX_LATENCY_BUCKETS - 1) {
+		latency >>= 1;
+		bucket++;
+	}
+	buckets[ bucket ]++;
+}
+
+static inline
+void
+peer_latency_add (
+	const pgm_sock_t*	     const restrict sock,
+	pgm_peer_t*		     const restrict peer,
+	const pgm_time_t			    now,
+	const struct pgm_sk_buff_t*  const restrict skb
+	)
+{
+#ifdef PGM_HAVE_RX_TIMESTAMP
+	if (sock->use_rx_timestamp && 0 != skb->rx_tstamp)
+		latency_bucket_add (peer->rx_latency, now, skb->rx_tstamp);
+#else
+	(void)sock;
+#endif
+	if (0 != skb->send_tstamp)
+		latency_bucket_add (peer->send_latency, now, skb->send_tstamp);
+}
+
+/* record the latencies of packets of the messages committed to the cursor by
+ * one window read, from msgv or skb_used onwards: NIC to application from
+ * arrival time stamps and publish to delivery from OPT_TIMESTAMP.
+ */
+
+static
+void
+peer_latency_update (
+	const pgm_sock_t*	    const restrict sock,
+	pgm_peer_t*		    const restrict peer,
+	const pgm_rxw_cursor_t*	    const restrict cursor,
+	const struct pgm_msgv_t*		   msgv,
+	uint32_t				   skb_used
+	)
+{
+	const pgm_time_t now = pgm_time_wall_now();
+
+	if (NULL != cursor->skbv) {
+		for (; skb_used < cursor->skbv->skbv_skb_used; skb_used++)
+			peer_latency_add (sock, peer, now, cursor->skbv->skbv_skb[ skb_used ]);
+		return;
+	}
+	for (; msgv < cursor->msgv; msgv++)
+		for (unsigned i = 0; i < msgv->msgv_len; i++)
+			peer_latency_add (sock, peer, now, msgv->msgv_skb[ i ]);
+}
+
 /* edge trigerred has receiver pending events
  */
 
@@ -532,7 +994,173 @@ pgm_peer_set_pending (
 
 	if (peer->pending_link.data) return;
 	peer->pending_link.data = peer;
-	sock->peers_pending = pgm_slist_prepend_link (sock->peers_pending, &peer->pending_link);
+	struct pgm_rx_shard_t* shard = peer->shard;
+/* with a receive quantum peers are flushed in arrival order, priority peers first */
+	if (NULL == shard->peers_pending) {
+		shard->peers_pending = pgm_slist_prepend_link (NULL, &peer->pending_link);
+		shard->peers_pending_tail = shard->peers_pending;
+	} else if (peer->is_priority || 0 == sock->recv_quantum) {
+		shard->peers_pending = pgm_slist_prepend_link (shard->peers_pending, &peer->pending_link);
+	} else {
+		peer->pending_link.next = NULL;
+		shard->peers_pending_tail->next = &peer->pending_link;
+		shard->peers_pending_tail = &peer->pending_link;
+	}
+}
+
+/* apply the delivery weight and priority configured for the TSI of a peer.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_peer_update_weight (
+	pgm_sock_t* const restrict sock,
+	pgm_peer_t* const restrict peer
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != peer);
+
+	peer->weight = 1;
+	peer->is_priority = 0;
+	for (unsigned i = 0; i < sock->peer_weight_len; i++) {
+		if (pgm_tsi_equal (&sock->peer_weight[ i ].tsi, &peer->tsi)) {
+			peer->weight = sock->peer_weight[ i ].weight;
+			peer->is_priority = sock->peer_weight[ i ].is_priority ? 1 : 0;
+			break;
+		}
+	}
+}
+
+/* upper bound in microseconds of the bucket of a fill time or residency
+ * histogram of len buckets holding percentile pct of count samples.
+ */
+
+static
+uint32_t
+fill_time_percentile (
+	const uint32_t*	hist,
+	const unsigned	len,
+	const uint64_t	count,
+	const unsigned	pct
+	)
+{
+	uint64_t sum = 0;
+	for (unsigned i = 0; i < len; i++) {
+		sum += hist[ i ];
+		if (hist[ i ] && sum * 100 >= count * pct)
+			return (uint32_t)((UINT64_C(1) << i) - 1);
+	}
+	return 0;
+}
+
+/* upper bound in microseconds of the latency bucket holding percentile pct
+ * of count samples.
+ */
+
+static
+uint32_t
+latency_percentile (
+	const uint32_t*	buckets,
+	const uint64_t	count,
+	const unsigned	pct
+	)
+{
+	uint64_t sum = 0;
+	for (unsigned i = 0; i < PGM_RX_LATENCY_BUCKETS; i++) {
+		sum += buckets[ i ];
+		if (buckets[ i ] && sum * 100 >= count * pct)
+			return PGM_RX_LATENCY_BUCKETS - 1 == i ? UINT32_MAX : (uint32_t)1 << i;
+	}
+	return 0;
+}
+
+/* metrics of a peer for PGM_PEER_STATS, called by monitoring readers with
+ * peers_lock.  rates are over the most recent second of samples.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_peer_get_stats (
+	pgm_peer_t*		    const restrict peer,
+	struct pgm_peerstatsinfo_t* const restrict info
+	)
+{
+	const pgm_rxw_t* window;
+	uint64_t data_bytes, data_msgs, count = 0;
+	uint64_t rates[PGM_STATS_RATE_MAX];
+
+/* pre-conditions */
+	pgm_assert (NULL != peer);
+	pgm_assert (NULL != info);
+
+	window = peer->window;
+	data_bytes = pgm_atomic_read64 (&peer->cumulative_stats[PGM_PC_RECEIVER_DATA_BYTES_RECEIVED]);
+	data_msgs  = pgm_atomic_read64 (&peer->cumulative_stats[PGM_PC_RECEIVER_DATA_MSGS_RECEIVED]);
+	info->data_bytes	= data_bytes;
+	info->data_msgs		= data_msgs;
+	info->losses		= pgm_atomic_read64 (&peer->cumulative_stats[PGM_PC_RECEIVER_LOSSES]);
+	info->naks_sent		= pgm_atomic_read64 (&peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SENT]) +
+				  pgm_atomic_read64 (&peer->cumulative_stats[PGM_PC_RECEIVER_PARITY_NAKS_SENT]);
+
+	pgm_stats_ring_rates (peer->rates, 1, rates);
+	info->bytes_per_sec	= rates[PGM_STATS_RATE_BYTES];
+	info->msgs_per_sec	= rates[PGM_STATS_RATE_PACKETS];
+
+/* data loss is fixed-point with 1 as 2^16 */
+	info->loss_rate		= (uint32_t)(((uint64_t)window->data_loss * 1000000) >> 16);
+	for (unsigned i = 0; i < PGM_RXW_FILL_TIME_BUCKETS; i++)
+		count += window->fill_time_hist[ i ];
+	info->repair_p50	= fill_time_percentile (window->fill_time_hist, PGM_RXW_FILL_TIME_BUCKETS, count, 50);
+	info->repair_p90	= fill_time_percentile (window->fill_time_hist, PGM_RXW_FILL_TIME_BUCKETS, count, 90);
+	info->repair_p99	= fill_time_percentile (window->fill_time_hist, PGM_RXW_FILL_TIME_BUCKETS, count, 99);
+	info->repair_max	= window->max_fill_time;
+	info->rtt		= (uint32_t)MIN(peer->nak_srtt, UINT32_MAX);
+	count = 0;
+	for (unsigned i = 0; i < PGM_RX_LATENCY_BUCKETS; i++)
+		count += peer->send_latency[ i ];
+	info->send_latency_p50	= latency_percentile (peer->send_latency, count, 50);
+	info->send_latency_p90	= latency_percentile (peer->send_latency, count, 90);
+	info->send_latency_p99	= latency_percentile (peer->send_latency, count, 99);
+	info->rxw_length	= pgm_rxw_length (window);
+	info->rxw_max_length	= pgm_rxw_max_length (window);
+	info->rxw_size		= pgm_rxw_size (window);
+	info->rxw_peak_length	= window->peak_length;
+	info->rxw_peak_size	= window->peak_size;
+	count = 0;
+	for (unsigned i = 0; i < PGM_RXW_RESIDENCY_BUCKETS; i++)
+		count += window->residency_hist[ i ];
+	info->residency_p50	= fill_time_percentile (window->residency_hist, PGM_RXW_RESIDENCY_BUCKETS, count, 50);
+	info->residency_p90	= fill_time_percentile (window->residency_hist, PGM_RXW_RESIDENCY_BUCKETS, count, 90);
+	info->residency_p99	= fill_time_percentile (window->residency_hist, PGM_RXW_RESIDENCY_BUCKETS, count, 99);
+	info->residency_max	= window->max_residency;
+}
+
+/* insert transmission groups reconstructed by decoder threads into the
+ * windows of the shard peers and queue windows with new data for flushing.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_collect_decoded (
+	pgm_sock_t*	       const restrict sock,
+	struct pgm_rx_shard_t* const restrict shard
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != shard);
+
+/* completions after the reset notify again */
+	pgm_atomic_write32 (&shard->decode_ready, 0);
+	for (unsigned i = 0; i < shard->peers_heap_len; i++)
+	{
+		pgm_peer_t* peer = shard->peers_heap[ i ];
+		if (pgm_rxw_decode_collect (peer->window) > 0 &&
+		    pgm_peer_has_pending (peer))
+			pgm_peer_set_pending (sock, peer);
+	}
 }
 
 /* Create a new error SKB detailing data loss.
@@ -543,7 +1171,7 @@ void
 pgm_set_reset_error (
 	pgm_sock_t*	   const restrict sock,
 	pgm_peer_t*	   const restrict source,
-	struct pgm_msgv_t* const restrict msgv
+	pgm_rxw_cursor_t*  const restrict cursor
 	)
 {
 	struct pgm_sk_buff_t* error_skb;
@@ -551,15 +1179,73 @@ pgm_set_reset_error (
 /* pre-conditions */
 	pgm_assert (NULL != sock);
 	pgm_assert (NULL != source);
-	pgm_assert (NULL != msgv);
+	pgm_assert (NULL != cursor);
 
 	error_skb = pgm_alloc_skb (0);
 	error_skb->sock	= sock;
 	error_skb->tstamp	= pgm_time_update_now ();
 	memcpy (&error_skb->tsi, &source->tsi, sizeof(pgm_tsi_t));
 	error_skb->sequence	= source->lost_count;
-	msgv->msgv_skb[0]	= error_skb;
-	msgv->msgv_len		= 1;
+	pgm_rxw_cursor_append (cursor, error_skb);
+	pgm_rxw_cursor_next (cursor);
+}
+
+/* place the receive window of a new source with the first SPM carrying
+ * OPT_JOIN, from the requested sequence bounded by the minimum offered and the
+ * receive window length, such that the update to the lead NAKs the run.
+ * without OPT_JOIN the window starts at the lead as usual.
+ */
+
+static
+void
+late_join (
+	pgm_sock_t*		    const restrict sock,
+	pgm_peer_t*		    const restrict source,
+	const struct pgm_sk_buff_t* const restrict skb,
+	const uint32_t				   spm_lead
+	)
+{
+	const struct pgm_opt_header* opt_header;
+	const struct pgm_opt_length* opt_len;
+	const struct pgm_opt_join* opt_join = NULL;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (sock->use_late_join);
+	pgm_assert (NULL != source);
+	pgm_assert (NULL != skb);
+
+	if (!(skb->pgm_header->pgm_options & PGM_OPT_PRESENT))
+		return;
+	opt_len = pgm_is_inet6 (source->nla.ss_family) ?
+			(const struct pgm_opt_length*)((const struct pgm_spm6*)skb->data + 1) :
+			(const struct pgm_opt_length*)((const struct pgm_spm *)skb->data + 1);
+	if (PGM_UNLIKELY(opt_len->opt_type != PGM_OPT_LENGTH ||
+			 opt_len->opt_length != sizeof(struct pgm_opt_length)))
+		return;
+	opt_header = (const struct pgm_opt_header*)opt_len;
+	do {
+		opt_header = (const struct pgm_opt_header*)((const char*)opt_header + opt_header->opt_length);
+		if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_JOIN) {
+			opt_join = (const struct pgm_opt_join*)(opt_header + 1);
+			break;
+		}
+	} while (!(opt_header->opt_type & PGM_OPT_END));
+	if (NULL == opt_join)
+		return;
+
+	const uint32_t join_min = pgm_ntohl (opt_join->opt_join_min);
+	uint32_t first_sqn = sock->late_join_is_oldest ? join_min : sock->late_join_sqn;
+	if (pgm_uint32_lt (first_sqn, join_min))
+		first_sqn = join_min;
+	if (pgm_uint32_gt (first_sqn, spm_lead))
+		return;
+	const uint32_t max_length = pgm_rxw_max_length (source->window);
+	if (spm_lead - first_sqn >= max_length)
+		first_sqn = spm_lead - max_length + 1;
+	pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Late join of %s from #%" PRIu32 " to #%" PRIu32 ", source offers from #%" PRIu32 "."),
+		   pgm_tsi_print (&source->tsi), first_sqn, spm_lead, join_min);
+	pgm_rxw_join (source->window, first_sqn);
 }
 
 /* SPM indicate start of a session, continued presence of a session, or flushing final packets
@@ -606,25 +1292,25 @@ pgm_on_spm (
 /* save sequence number */
 		source->spm_sqn = spm_sqn;
 
+/* first SPM of a source places the window of a late joining receiver */
+		if (sock->use_late_join && !source->window->is_defined)
+			late_join (sock, source, skb, pgm_ntohl (spm->spm_lead));
+
 /* update receive window */
-		const pgm_time_t nak_rb_expiry = skb->tstamp + nak_rb_ivl (sock);
+		const pgm_time_t nak_rb_expiry = skb->tstamp + nak_rb_ivl (sock, source);
 		const unsigned naks = pgm_rxw_update (source->window,
 						      pgm_ntohl (spm->spm_lead),
 						      pgm_ntohl (spm->spm_trail),
 						      skb->tstamp,
 						      nak_rb_expiry);
-		if (naks) {
-			pgm_timer_lock (sock);
-			if (pgm_time_after (sock->next_poll, nak_rb_expiry))
-				sock->next_poll = nak_rb_expiry;
-			pgm_timer_unlock (sock);
-		}
+		if (naks)
+			pgm_timer_pull (sock, source->shard, nak_rb_expiry);
 
 /* mark receiver window for flushing on next recv() */
 		if (source->window->cumulative_losses != source->last_cumulative_losses &&
 		    !source->pending_link.data)
 		{
-			sock->is_reset = TRUE;
+			source->shard->is_reset = TRUE;
 			source->lost_count = source->window->cumulative_losses - source->last_cumulative_losses;
 			source->last_cumulative_losses = source->window->cumulative_losses;
 			pgm_peer_set_pending (sock, source);
@@ -637,13 +1323,17 @@ pgm_on_spm (
 		return FALSE;
 	}
 
-/* check whether peer can generate parity packets */
+/* check whether peer can generate parity packets, accepts NAK ranges,
+ * advertises the receiver population, or sends CRC32C data trailers */
+	bool has_nak_range = FALSE;
+	bool has_crc32c = FALSE;
+	uint32_t population = 0;
 	if (skb->pgm_header->pgm_options & PGM_OPT_PRESENT)
 	{
 		const struct pgm_opt_header* opt_header;
 		const struct pgm_opt_length* opt_len;
 
-		opt_len = (AF_INET6 == source->nla.ss_family) ?
+		opt_len = pgm_is_inet6 (source->nla.ss_family) ?
 				(const struct pgm_opt_length*)(spm6 + 1) :
 				(const struct pgm_opt_length*)(spm  + 1);
 		if (PGM_UNLIKELY(opt_len->opt_type != PGM_OPT_LENGTH))
@@ -689,8 +1379,26 @@ pgm_on_spm (
 					pgm_rxw_update_fec (source->window, parity_prm_tgs);
 				}
 			}
+			else if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_NAK_RANGE)
+				has_nak_range = TRUE;
+			else if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_POPULATION)
+			{
+				const struct pgm_opt_population* opt_population;
+
+				opt_population = (const struct pgm_opt_population*)(opt_header + 1);
+				population = pgm_ntohl (opt_population->opt_population);
+			}
+			else if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_CRC32C)
+				has_crc32c = TRUE;
 		} while (!(opt_header->opt_type & PGM_OPT_END));
 	}
+	source->has_nak_range = has_nak_range;
+	source->population = population;
+	source->has_crc32c = has_crc32c;
+
+/* downstream receivers of a relay learn the session from it */
+	if (NULL != sock->relay)
+		pgm_relay_forward_spm (sock, skb);
 
 /* either way bump expiration timer */
 	source->expiry = skb->tstamp + sock->peer_expiry;
@@ -748,15 +1456,8 @@ pgm_on_peer_nak (
 	}
 
 /* NAK_GRP_NLA contains one of our sock receive multicast groups: the sources send multicast group */ 
-	pgm_nla_to_sockaddr ((AF_INET6 == nak_src_nla.ss_family) ? &nak6->nak6_grp_nla_afi : &nak->nak_grp_nla_afi, (struct sockaddr*)&nak_grp_nla);
-	for (unsigned i = 0; i < sock->recv_gsr_len; i++)
-	{
-		if (pgm_sockaddr_cmp ((struct sockaddr*)&nak_grp_nla, (struct sockaddr*)&sock->recv_gsr[i].gsr_group) == 0)
-		{
-			found_nak_grp = TRUE;
-			break;
-		}
-	}
+	pgm_nla_to_sockaddr (pgm_is_inet6 (nak_src_nla.ss_family) ? &nak6->nak6_grp_nla_afi : &nak->nak_grp_nla_afi, (struct sockaddr*)&nak_grp_nla);
+	found_nak_grp = pgm_groups_is_member (sock, (struct sockaddr*)&nak_grp_nla);
 
 	if (PGM_UNLIKELY(!found_nak_grp)) {
 		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded multicast NAK on multicast group mismatch."));
@@ -767,10 +1468,12 @@ pgm_on_peer_nak (
 	ncf_status = pgm_rxw_confirm (peer->window,
 				      pgm_ntohl (nak->nak_sqn),
 				      skb->tstamp,
-				      skb->tstamp + sock->nak_rdata_ivl,
-				      skb->tstamp + nak_rb_ivl(sock));
+				      skb->tstamp + nak_peer_ivl (sock, peer, sock->nak_rdata_ivl),
+				      skb->tstamp + nak_rb_ivl (sock, peer));
 	if (PGM_RXW_UPDATED == ncf_status || PGM_RXW_APPENDED == ncf_status)
 		peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SUPPRESSED]++;
+	if (sock->use_peer_repair && !(skb->pgm_header->pgm_options & PGM_OPT_PARITY))
+		peer_repair_schedule (sock, peer, pgm_ntohl (nak->nak_sqn), skb->tstamp);
 
 /* check NAK list */
 	if (skb->pgm_header->pgm_options & PGM_OPT_PRESENT)
@@ -780,7 +1483,7 @@ pgm_on_peer_nak (
 		const uint32_t* nak_list = NULL;
 		unsigned nak_list_len = 0;
 
-		opt_len = (AF_INET6 == nak_src_nla.ss_family) ?
+		opt_len = pgm_is_inet6 (nak_src_nla.ss_family) ?
 				(const struct pgm_opt_length*)(nak6 + 1) :
 				(const struct pgm_opt_length*)(nak + 1);
 		if (PGM_UNLIKELY(opt_len->opt_type != PGM_OPT_LENGTH))
@@ -805,16 +1508,28 @@ pgm_on_peer_nak (
 				nak_list_len = ( opt_header->opt_length - sizeof(struct pgm_opt_header) - sizeof(uint8_t) ) / sizeof(uint32_t);
 				break;
 			}
+			if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_NAK_RANGE)
+			{
+				confirm_nak_range (peer,
+						   opt_header,
+						   pgm_ntohl (nak->nak_sqn),
+						   skb->tstamp,
+						   skb->tstamp + nak_peer_ivl (sock, peer, sock->nak_rdata_ivl),
+						   skb->tstamp + nak_rb_ivl (sock, peer));
+				break;
+			}
 		} while (!(opt_header->opt_type & PGM_OPT_END));
 
 		while (nak_list_len) {
 			ncf_status = pgm_rxw_confirm (peer->window,
 						      pgm_ntohl (*nak_list),
 						      skb->tstamp,
-						      skb->tstamp + sock->nak_rdata_ivl,
-						      skb->tstamp + nak_rb_ivl(sock));
+						      skb->tstamp + nak_peer_ivl (sock, peer, sock->nak_rdata_ivl),
+						      skb->tstamp + nak_rb_ivl (sock, peer));
 			if (PGM_RXW_UPDATED == ncf_status || PGM_RXW_APPENDED == ncf_status)
 				peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SUPPRESSED]++;
+			if (sock->use_peer_repair && !(skb->pgm_header->pgm_options & PGM_OPT_PARITY))
+				peer_repair_schedule (sock, peer, pgm_ntohl (*nak_list), skb->tstamp);
 			nak_list++;
 			nak_list_len--;
 		}
@@ -824,7 +1539,7 @@ pgm_on_peer_nak (
 	if (peer->window->cumulative_losses != peer->last_cumulative_losses &&
 	    !peer->pending_link.data)
 	{
-		sock->is_reset = TRUE;
+		peer->shard->is_reset = TRUE;
 		peer->lost_count = peer->window->cumulative_losses - peer->last_cumulative_losses;
 		peer->last_cumulative_losses = peer->window->cumulative_losses;
 		pgm_peer_set_pending (sock, peer);
@@ -832,6 +1547,188 @@ pgm_on_peer_nak (
 	return TRUE;
 }
 
+/* confirm each sequence of the runs of an OPT_NAK_RANGE in a NCF or a NAK of
+ * another receiver, except NAK_SQN already confirmed.  runs are bounded by
+ * the receive window size.
+ */
+
+static
+void
+confirm_nak_range (
+	pgm_peer_t*		     const restrict peer,
+	const struct pgm_opt_header* const restrict opt_header,
+	const uint32_t				    nak_sqn,
+	const pgm_time_t			    now,
+	const pgm_time_t			    nak_rdata_expiry,	/* pre-calculated expiry times */
+	const pgm_time_t			    nak_rb_expiry
+	)
+{
+	const struct pgm_opt_nak_range* opt_nak_range = (const struct pgm_opt_nak_range*)(opt_header + 1);
+	const unsigned nak_range_len = ( opt_header->opt_length - sizeof(struct pgm_opt_header) - sizeof(uint8_t) ) / sizeof(struct pgm_nak_range);
+	const uint32_t max_length = (uint32_t)pgm_rxw_max_length (peer->window);
+
+	for (unsigned i = 0; i < MIN( nak_range_len, PGM_SQN_RANGE_MAX ); i++)
+	{
+		const uint32_t sqn   = pgm_ntohl (opt_nak_range->opt_range[i].range_sqn);
+		const uint32_t count = MIN( pgm_ntohl (opt_nak_range->opt_range[i].range_count), max_length );
+		for (uint32_t j = 0; j < count; j++)
+		{
+			if (sqn + j == nak_sqn)
+				continue;
+			const int status = pgm_rxw_confirm (peer->window,
+							    sqn + j,
+							    now,
+							    nak_rdata_expiry,
+							    nak_rb_expiry);
+			if (PGM_RXW_UPDATED == status || PGM_RXW_APPENDED == status)
+				peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SUPPRESSED]++;
+		}
+	}
+}
+
+/* repair of a sequence NAKed by another receiver whilst held intact in the
+ * receive window, after a random back-off so that one receiver of the segment
+ * answers first and the others cancel on its RDATA.
+ */
+
+static
+void
+peer_repair_schedule (
+	pgm_sock_t* const restrict	sock,
+	pgm_peer_t* const restrict	peer,
+	const uint32_t			sequence,
+	const pgm_time_t		now
+	)
+{
+	const struct pgm_sk_buff_t* skb;
+	const pgm_rxw_state_t* state;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != peer);
+
+	if (!sock->can_send_nak)
+		return;
+	skb = pgm_rxw_peek (peer->window, sequence);
+	if (NULL == skb)
+		return;
+	state = (const pgm_rxw_state_t*)&skb->cb;
+	if (PGM_PKT_STATE_HAVE_DATA != state->pkt_state &&
+	    PGM_PKT_STATE_COMMIT_DATA != state->pkt_state)
+		return;
+	for (unsigned i = 0; i < peer->repair_len; i++)
+		if (sequence == peer->repair[ i ].sequence)
+			return;
+	if (PGM_PEER_REPAIR_MAX == peer->repair_len)
+		return;
+	if (NULL == peer->repair)
+		peer->repair = pgm_mem_slab_alloc0 (peer->slab, PGM_PEER_REPAIR_MAX * sizeof (struct pgm_peer_repair_t));
+	peer->repair[ peer->repair_len ].sequence = sequence;
+	peer->repair[ peer->repair_len ].expiry   = now + nak_rb_ivl (sock, peer);
+	peer->repair_len++;
+}
+
+/* RDATA from the source or another receiver answered first.
+ */
+
+static
+void
+peer_repair_cancel (
+	pgm_peer_t* const		peer,
+	const uint32_t			sequence
+	)
+{
+	for (unsigned i = 0; i < peer->repair_len; i++)
+		if (sequence == peer->repair[ i ].sequence) {
+			peer->repair[ i ] = peer->repair[ --peer->repair_len ];
+			return;
+		}
+}
+
+/* re-send a window TPDU as RDATA to the source multicast group, the packet
+ * must still be intact: data delivered from a reassembled or parity
+ * reconstructed buffer is left to the source.
+ *
+ * returns TRUE on success, FALSE if the TPDU is unavailable or on failure.
+ */
+
+static
+bool
+send_peer_repair (
+	pgm_sock_t* const restrict	sock,
+	pgm_peer_t* const restrict	peer,
+	const uint32_t			sequence
+	)
+{
+	const struct pgm_sk_buff_t* skb;
+	const pgm_rxw_state_t* state;
+	struct pgm_header* header;
+	char* buf;
+	ssize_t sent;
+
+	skb = pgm_rxw_peek (peer->window, sequence);
+	if (NULL == skb)
+		return FALSE;
+	state = (const pgm_rxw_state_t*)&skb->cb;
+	if (PGM_PKT_STATE_HAVE_DATA != state->pkt_state &&
+	    PGM_PKT_STATE_COMMIT_DATA != state->pkt_state)
+		return FALSE;
+
+	const uint_fast16_t tsdu_length = pgm_ntohs (skb->pgm_header->pgm_tsdu_length);
+	const uint_fast16_t opt_total_length = (skb->pgm_header->pgm_options & PGM_OPT_PRESENT) ?
+		pgm_ntohs(*(const uint16_t*)( (const char*)( skb->pgm_data + 1 ) + sizeof(uint16_t))) :
+		0;
+	const size_t tpdu_length = sizeof(struct pgm_header) + sizeof(struct pgm_data) + opt_total_length + tsdu_length;
+	if ((size_t)((const char*)skb->tail - (const char*)skb->pgm_header) != tpdu_length)
+		return FALSE;
+
+	buf = pgm_alloca (tpdu_length);
+	memcpy (buf, skb->pgm_header, tpdu_length);
+	header = (struct pgm_header*)buf;
+	header->pgm_type	= PGM_RDATA;
+	header->pgm_checksum	= 0;
+	header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
+
+	sent = pgm_sendto (sock,
+			   FALSE,			/* not rate limited */
+			   NULL,
+			   FALSE,			/* regular socket */
+			   buf,
+			   tpdu_length,
+			   (struct sockaddr*)&peer->group_nla,
+			   pgm_sockaddr_len ((struct sockaddr*)&peer->group_nla));
+	if (sent < 0)
+		return FALSE;
+
+	peer->cumulative_stats[PGM_PC_RECEIVER_PEER_REPAIRS_SENT]++;
+	sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT] += tpdu_length + sock->iphdr_len;
+	return TRUE;
+}
+
+/* send all peer repairs with expired back-off, best effort.
+ */
+
+static
+void
+peer_repair_state (
+	pgm_sock_t*	 restrict	sock,
+	pgm_peer_t*	 restrict	peer,
+	const pgm_time_t		now
+	)
+{
+	unsigned i = 0;
+
+	while (i < peer->repair_len) {
+		if (!pgm_time_after_eq (now, peer->repair[ i ].expiry)) {
+			i++;
+			continue;
+		}
+		const uint32_t sequence = peer->repair[ i ].sequence;
+		peer->repair[ i ] = peer->repair[ --peer->repair_len ];
+		send_peer_repair (sock, peer, sequence);
+	}
+}
+
 /* NCF confirming receipt of a NAK from this sock or another on the LAN segment.
  *
  * Packet contents will match exactly the sent NAK, although not really that helpful.
@@ -882,35 +1779,38 @@ pgm_on_ncf (
 #endif
 
 /* NCF_GRP_NLA contains our sock multicast group */ 
-	pgm_nla_to_sockaddr ((AF_INET6 == ncf_src_nla.ss_family) ? &ncf6->nak6_grp_nla_afi : &ncf->nak_grp_nla_afi, (struct sockaddr*)&ncf_grp_nla);
+	pgm_nla_to_sockaddr (pgm_is_inet6 (ncf_src_nla.ss_family) ? &ncf6->nak6_grp_nla_afi : &ncf->nak_grp_nla_afi, (struct sockaddr*)&ncf_grp_nla);
 
 /* copy scope id from multicast socket */
-	if (AF_INET6 == sock->family)
+	if (pgm_is_inet6 (sock->family))
 	{
 		((struct sockaddr_in6*)&ncf_grp_nla)->sin6_scope_id = ((struct sockaddr_in6*)&sock->send_gsr.gsr_group)->sin6_scope_id;
 	}
 
-	if (PGM_UNLIKELY(pgm_sockaddr_cmp ((struct sockaddr*)&ncf_grp_nla, (struct sockaddr*)&sock->send_gsr.gsr_group) != 0))
+/* any joined group, a source with redundant paths confirms on each */
+	if (PGM_UNLIKELY(0 != pgm_sockaddr_cmp ((struct sockaddr*)&ncf_grp_nla, (struct sockaddr*)&sock->send_gsr.gsr_group) &&
+			 !pgm_groups_is_member (sock, (struct sockaddr*)&ncf_grp_nla)))
 	{
 		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded NCF on multicast group mismatch."));
 		return FALSE;
 	}
 
-	const pgm_time_t ncf_rdata_ivl = skb->tstamp + sock->nak_rdata_ivl;
-	const pgm_time_t ncf_rb_ivl    = skb->tstamp + nak_rb_ivl(sock);
+/* round-trip time of our own NAK */
+	if (sock->use_adaptive_nak)
+		nak_rtt_update (source, pgm_rxw_nak_rtt (source->window, pgm_ntohl (ncf->nak_sqn), skb->tstamp));
+
+	const pgm_time_t ncf_rdata_ivl = skb->tstamp + nak_peer_ivl (sock, source, sock->nak_rdata_ivl);
+	const pgm_time_t ncf_rb_ivl    = skb->tstamp + nak_rb_ivl (sock, source);
 	ncf_status = pgm_rxw_confirm (source->window,
 				      pgm_ntohl (ncf->nak_sqn),
 				      skb->tstamp,
 				      ncf_rdata_ivl,
 				      ncf_rb_ivl);
+	PGM_PROBE4 (ncf_receive, sock, source, pgm_ntohl (ncf->nak_sqn), ncf_status);
 	if (PGM_RXW_UPDATED == ncf_status || PGM_RXW_APPENDED == ncf_status)
 	{
 		const pgm_time_t ncf_ivl = (PGM_RXW_APPENDED == ncf_status) ? ncf_rb_ivl : ncf_rdata_ivl;
-		pgm_timer_lock (sock);
-		if (pgm_time_after (sock->next_poll, ncf_ivl)) {
-			sock->next_poll = ncf_ivl;
-		}
-		pgm_timer_unlock (sock);
+		pgm_timer_pull (sock, source->shard, ncf_ivl);
 		source->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SUPPRESSED]++;
 	}
 
@@ -922,7 +1822,7 @@ pgm_on_ncf (
 		const uint32_t* ncf_list = NULL;
 		unsigned ncf_list_len = 0;
 
-		opt_len = (AF_INET6 == ncf_src_nla.ss_family) ?
+		opt_len = pgm_is_inet6 (ncf_src_nla.ss_family) ?
 				(const struct pgm_opt_length*)(ncf6 + 1) :
 				(const struct pgm_opt_length*)(ncf  + 1);
 		if (PGM_UNLIKELY(opt_len->opt_type != PGM_OPT_LENGTH))
@@ -947,6 +1847,11 @@ pgm_on_ncf (
 				ncf_list_len = ( opt_header->opt_length - sizeof(struct pgm_opt_header) - sizeof(uint8_t) ) / sizeof(uint32_t);
 				break;
 			}
+			if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_NAK_RANGE)
+			{
+				confirm_nak_range (source, opt_header, pgm_ntohl (ncf->nak_sqn), skb->tstamp, ncf_rdata_ivl, ncf_rb_ivl);
+				break;
+			}
 		} while (!(opt_header->opt_type & PGM_OPT_END));
 
 		pgm_debug ("NCF contains 1+%d sequence numbers.", ncf_list_len);
@@ -968,7 +1873,7 @@ pgm_on_ncf (
 	if (source->window->cumulative_losses != source->last_cumulative_losses &&
 	    !source->pending_link.data)
 	{
-		sock->is_reset = TRUE;
+		source->shard->is_reset = TRUE;
 		source->lost_count = source->window->cumulative_losses - source->last_cumulative_losses;
 		source->last_cumulative_losses = source->window->cumulative_losses;
 		pgm_peer_set_pending (sock, source);
@@ -976,6 +1881,107 @@ pgm_on_ncf (
 	return TRUE;
 }
 
+/* transmit the NAKs and SPMRs queued by a timer sweep, one sendmmsg() per
+ * run of packets on the same socket.  packets that would block are kept for
+ * the next sweep.
+ *
+ * returns TRUE when the batch is empty, returns FALSE if operation would block.
+ */
+
+static
+bool
+nak_batch_flush (
+	pgm_sock_t*	       const restrict sock,
+	struct pgm_rx_shard_t* const restrict shard
+	)
+{
+	struct pgm_nak_batch_t* batch;
+	struct pgm_iovec vector[ PGM_NAK_BATCH_MAX ];
+	const struct sockaddr* to[ PGM_NAK_BATCH_MAX ];
+	unsigned i = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != shard);
+
+	batch = shard->nak_batch;
+	if (NULL == batch || 0 == batch->len)
+		return TRUE;
+
+	pgm_debug ("nak_batch_flush (sock:%p shard:%u len:%u)",
+		(const void*)sock, shard->index, batch->len);
+
+	while (i < batch->len)
+	{
+		const bool use_router_alert = batch->entry[ i ].use_router_alert;
+		unsigned count = 0;
+		while (i + count < batch->len &&
+		       use_router_alert == batch->entry[ i + count ].use_router_alert)
+		{
+			struct pgm_nak_batch_entry_t* entry = &batch->entry[ i + count ];
+			vector[ count ].iov_base = entry->tpdu;
+			vector[ count ].iov_len  = entry->tpdu_length;
+			to[ count ] = (const struct sockaddr*)&entry->to;
+			count++;
+		}
+		const int sent = pgm_sendmmsg_to (sock, use_router_alert, vector, to, count);
+		if (sent < 0)
+			break;
+		i += sent;
+		if ((unsigned)sent < count)
+			break;
+	}
+
+	if (i > 0) {
+		memmove (&batch->entry[ 0 ], &batch->entry[ i ], (batch->len - i) * sizeof(struct pgm_nak_batch_entry_t));
+		batch->len -= i;
+	}
+	return 0 == batch->len;
+}
+
+/* queue a NAK or SPMR for transmission at the end of the timer sweep, the
+ * random back-off of each peer is unchanged as only the send is deferred.
+ *
+ * returns TRUE when queued, returns FALSE if operation would block.
+ */
+
+static
+bool
+nak_batch_push (
+	pgm_sock_t*	       const restrict sock,
+	struct pgm_rx_shard_t* const restrict shard,
+	const bool			      use_router_alert,
+	const void*	       const restrict tpdu,
+	const size_t			      tpdu_length,
+	const struct sockaddr* const restrict to
+	)
+{
+	struct pgm_nak_batch_t* batch;
+	struct pgm_nak_batch_entry_t* entry;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != shard);
+	pgm_assert (NULL != tpdu);
+	pgm_assert_cmpuint (tpdu_length, <=, PGM_NAK_BATCH_TPDU_MAX);
+	pgm_assert (NULL != to);
+
+	if (PGM_UNLIKELY(NULL == shard->nak_batch))
+		shard->nak_batch = pgm_new0 (struct pgm_nak_batch_t, 1);
+	batch = shard->nak_batch;
+	if (PGM_NAK_BATCH_MAX == batch->len &&
+	    !nak_batch_flush (sock, shard) &&
+	    PGM_NAK_BATCH_MAX == batch->len)
+		return FALSE;
+
+	entry = &batch->entry[ batch->len++ ];
+	entry->use_router_alert	= use_router_alert;
+	entry->tpdu_length	= tpdu_length;
+	memcpy (&entry->to, to, pgm_sockaddr_len (to));
+	memcpy (entry->tpdu, tpdu, tpdu_length);
+	return TRUE;
+}
+
 /* send SPM-request to a new peer, this packet type has no contents
  *
  * on success, TRUE is returned, if operation would block FALSE is
@@ -992,6 +1998,7 @@ send_spmr (
 	char		  *buf;
 	struct pgm_header *header;
 	ssize_t		   sent;
+	size_t		   bytes_sent = 0;
 
 /* pre-conditions */
 	pgm_assert (NULL != sock);
@@ -1013,8 +2020,9 @@ send_spmr (
 	header->pgm_checksum	= 0;
 	header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
 
-/* send multicast SPMR TTL 1 to our peers listening on the same groups */
-	for (unsigned i = 0; i < sock->recv_gsr_len; i++)
+/* send multicast SPMR TTL 1 to our peers listening on the same groups, once per group */
+	for (pgm_slist_t* list = sock->recv_group_list; NULL != list; list = list->next) {
+		const struct pgm_group_t* group = list->data;
 		sent = pgm_sendto_hops (sock,
 					FALSE,			/* not rate limited */
 					NULL,
@@ -1022,26 +2030,145 @@ send_spmr (
 					1,
 					header,
 					tpdu_length,
-					(struct sockaddr*)&sock->recv_gsr[i].gsr_group,
-					pgm_sockaddr_len ((struct sockaddr*)&sock->recv_gsr[i].gsr_group));
+					(const struct sockaddr*)&group->group,
+					pgm_sockaddr_len ((const struct sockaddr*)&group->group));
 /* ignore errors on peer multicast */
+		if (sent > 0)
+			bytes_sent += sent;
+	}
 
 /* send unicast SPMR with regular TTL */
+	if (!nak_batch_push (sock, source->shard, FALSE, header, tpdu_length, (struct sockaddr*)&source->local_nla))
+		return FALSE;
+
+	sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT] += bytes_sent + tpdu_length;
+	return TRUE;
+}
+
+/* poll-response to a general POLL, reporting the receive window loss rate and
+ * a time stamp echo for round-trip time as per an ACK in OPT_PGMCC_FEEDBACK.
+ * the echo is zero before any OPT_PGMCC_DATA from the source.  with path MTU
+ * discovery OPT_PATH_MTU reports the receive interface MTU.  sent unicast to
+ * the path NLA of the poll.
+ *
+ * on success, TRUE is returned, if operation would block FALSE is returned.
+ */
+
+static
+bool
+send_polr (
+	pgm_sock_t*const restrict	sock,
+	pgm_peer_t*const restrict	source,
+	const pgm_time_t		now
+	)
+{
+	size_t			       tpdu_length, opt_feedback_length, opt_path_mtu_length;
+	char			      *buf;
+	struct pgm_header	      *header;
+	struct pgm_polr		      *polr;
+	struct pgm_opt_header	      *opt_header;
+	struct pgm_opt_length	      *opt_len;
+	struct pgm_opt_pgmcc_feedback *opt_pgmcc_feedback;
+	struct pgm_opt_path_mtu	      *opt_path_mtu;
+	struct sockaddr_storage	       poll_nla;
+	ssize_t			       sent;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != source);
+
+	pgm_debug ("send_polr (sock:%p source:%p now:%" PGM_TIME_FORMAT ")",
+		(void*)sock, (void*)source, now);
+
+	opt_feedback_length = pgm_is_inet6 (sock->send_addr.ss_family) ?
+					sizeof(struct pgm_opt6_pgmcc_feedback) :
+					sizeof(struct pgm_opt_pgmcc_feedback);
+	opt_path_mtu_length = sock->pmtu_report ? sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_path_mtu) : 0;
+	tpdu_length = sizeof(struct pgm_header) +
+			     sizeof(struct pgm_polr) +
+			     sizeof(struct pgm_opt_length) +
+			     sizeof(struct pgm_opt_header) +
+			     opt_feedback_length +
+			     opt_path_mtu_length;
+	buf = pgm_alloca (tpdu_length);
+	memset (buf, 0, tpdu_length);
+	header = (struct pgm_header*)buf;
+	polr = (struct pgm_polr*)(header + 1);
+	memcpy (header->pgm_gsi, &source->tsi.gsi, sizeof(pgm_gsi_t));
+/* dport & sport reversed communicating upstream */
+	header->pgm_sport	= sock->dport;
+	header->pgm_dport	= source->tsi.sport;
+	header->pgm_type	= PGM_POLR;
+	header->pgm_options	= PGM_OPT_PRESENT;
+	header->pgm_tsdu_length	= 0;
+
+	polr->polr_sqn		= pgm_htonl (source->last_poll_sqn);
+	polr->polr_round	= pgm_htons (source->last_poll_round);
+
+/* OPT_PGMCC_FEEDBACK */
+	opt_len = (struct pgm_opt_length*)(polr + 1);
+	opt_len->opt_type	= PGM_OPT_LENGTH;
+	opt_len->opt_length	= sizeof(struct pgm_opt_length);
+	opt_len->opt_total_length = pgm_htons ((uint16_t)(sizeof(struct pgm_opt_length) +
+							  sizeof(struct pgm_opt_header) +
+							  opt_feedback_length +
+							  opt_path_mtu_length));
+	opt_header = (struct pgm_opt_header*)(opt_len + 1);
+	opt_header->opt_type	= opt_path_mtu_length ? PGM_OPT_PGMCC_FEEDBACK : (PGM_OPT_PGMCC_FEEDBACK | PGM_OPT_END);
+	opt_header->opt_length	= (uint8_t)(sizeof(struct pgm_opt_header) + opt_feedback_length);
+	opt_pgmcc_feedback = (struct pgm_opt_pgmcc_feedback*)(opt_header + 1);
+	if (0 != source->last_data_tstamp) {
+		const uint32_t t = (uint32_t)(source->ack_last_tstamp + pgm_to_msecs( now - source->last_data_tstamp ));
+		opt_pgmcc_feedback->opt_tstamp = pgm_htonl (t);
+	}
+	pgm_sockaddr_to_nla ((struct sockaddr*)&sock->send_addr, (char*)&opt_pgmcc_feedback->opt_nla_afi);
+	opt_pgmcc_feedback->opt_loss_rate = pgm_htons ((uint16_t)source->window->data_loss);
+
+/* OPT_PATH_MTU */
+	if (opt_path_mtu_length) {
+		opt_header = (struct pgm_opt_header*)((char*)opt_header + opt_header->opt_length);
+		opt_header->opt_type	= PGM_OPT_PATH_MTU | PGM_OPT_END;
+		opt_header->opt_length	= (uint8_t)opt_path_mtu_length;
+		opt_path_mtu = (struct pgm_opt_path_mtu*)(opt_header + 1);
+		opt_path_mtu->opt_mtu	= pgm_htons (sock->pmtu_report);
+	}
+
+	header->pgm_checksum	= 0;
+	header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
+
+	memcpy (&poll_nla, &source->poll_nla, sizeof(poll_nla));
+/* port at same location for sin/sin6 */
+	((struct sockaddr_in*)&poll_nla)->sin_port = pgm_htons (sock->udp_encap_ucast_port);
 	sent = pgm_sendto (sock,
-			   FALSE,
+			   FALSE,			/* not rate limited */
 			   NULL,
-			   FALSE,
-			   header,
+			   FALSE,			/* regular socket */
+			   buf,
 			   tpdu_length,
-			   (struct sockaddr*)&source->local_nla,
-			   pgm_sockaddr_len ((struct sockaddr*)&source->local_nla));
+			   (struct sockaddr*)&poll_nla,
+			   pgm_sockaddr_len ((struct sockaddr*)&poll_nla));
 	if (sent < 0 && PGM_LIKELY(PGM_SOCK_EAGAIN == pgm_get_last_sock_error()))
 		return FALSE;
 
-	sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT] += tpdu_length * 2;
+	sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT] += tpdu_length + sock->iphdr_len;
 	return TRUE;
 }
 
+/* NAKs go to the source unless redirected to a Designated Local Repairer,
+ * the NAK keeps naming the source NLA for forwarding.
+ */
+
+static inline
+struct sockaddr*
+nak_nla (
+	pgm_peer_t* const	source
+	)
+{
+	if (AF_UNSPEC != source->redirect_nla.ss_family)
+		return (struct sockaddr*)&source->redirect_nla;
+	return (struct sockaddr*)&source->nla;
+}
+
 /* send selective NAK for one sequence number.
  *
  * on success, TRUE is returned, returns FALSE if would block on operation.
@@ -1060,7 +2187,6 @@ send_nak (
 	struct pgm_header *header;
 	struct pgm_nak	  *nak;
 	struct pgm_nak6   *nak6;
-	ssize_t		   sent;
 
 /* pre-conditions */
 	pgm_assert (NULL != sock);
@@ -1070,7 +2196,7 @@ send_nak (
 		(void*)sock, (void*)source, sequence);
 
 	tpdu_length = sizeof(struct pgm_header) + sizeof(struct pgm_nak);
-	if (AF_INET6 == source->nla.ss_family)
+	if (pgm_is_inet6 (source->nla.ss_family))
 		tpdu_length += sizeof(struct pgm_nak6) - sizeof(struct pgm_nak);
 	buf = pgm_alloca (tpdu_length);
 	header = (struct pgm_header*)buf;
@@ -1095,22 +2221,16 @@ send_nak (
  * be listening to multiple multicast groups
  */
 	pgm_sockaddr_to_nla ((struct sockaddr*)&source->group_nla,
-				(AF_INET6 == source->nla.ss_family) ? (char*)&nak6->nak6_grp_nla_afi : (char*)&nak->nak_grp_nla_afi);
+				pgm_is_inet6 (source->nla.ss_family) ? (char*)&nak6->nak6_grp_nla_afi : (char*)&nak->nak_grp_nla_afi);
 
         header->pgm_checksum    = 0;
         header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
 
-	sent = pgm_sendto (sock,
-			   FALSE,			/* not rate limited */
-			   NULL,
-			   TRUE,			/* with router alert */
-			   header,
-			   tpdu_length,
-			   (struct sockaddr*)&source->nla,
-			   pgm_sockaddr_len((struct sockaddr*)&source->nla));
-	if (sent < 0 && PGM_LIKELY(PGM_SOCK_EAGAIN == pgm_get_last_sock_error()))
+	if (!nak_batch_push (sock, source->shard, TRUE, header, tpdu_length, nak_nla (source)))
 		return FALSE;
 
+	PGM_PROBE4 (nak_send, sock, source, sequence, 1);
+	pgm_flightrec_add (sock->flightrec, PGM_FLIGHTREC_NAK_SEND, 0, source->tsi.sport, sequence, 1);
 	source->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAK_PACKETS_SENT]++;
 	source->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SENT]++;
 	return TRUE;
@@ -1135,7 +2255,6 @@ send_parity_nak (
 	struct pgm_header *header;
 	struct pgm_nak	  *nak;
 	struct pgm_nak6   *nak6;
-	ssize_t		   sent;
 
 /* pre-conditions */
 	pgm_assert (NULL != sock);
@@ -1146,7 +2265,7 @@ send_parity_nak (
 		(void*)sock, (void*)source, nak_tg_sqn, nak_pkt_cnt);
 
 	tpdu_length = sizeof(struct pgm_header) + sizeof(struct pgm_nak);
-	if (AF_INET6 == source->nla.ss_family)
+	if (pgm_is_inet6 (source->nla.ss_family))
 		tpdu_length += sizeof(struct pgm_nak6) - sizeof(struct pgm_nak);
 	buf = pgm_alloca (tpdu_length);
 	header = (struct pgm_header*)buf;
@@ -1171,21 +2290,15 @@ send_parity_nak (
  * be listening to multiple multicast groups
  */
 	pgm_sockaddr_to_nla ((struct sockaddr*)&source->group_nla,
-				(AF_INET6 == source->nla.ss_family) ? (char*)&nak6->nak6_grp_nla_afi : (char*)&nak->nak_grp_nla_afi );
+				pgm_is_inet6 (source->nla.ss_family) ? (char*)&nak6->nak6_grp_nla_afi : (char*)&nak->nak_grp_nla_afi );
         header->pgm_checksum    = 0;
         header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
 
-	sent = pgm_sendto (sock,
-			   FALSE,		/* not rate limited */
-			   NULL,
-			   TRUE,		/* with router alert */
-			   header,
-			   tpdu_length,
-			   (struct sockaddr*)&source->nla,
-			   pgm_sockaddr_len((struct sockaddr*)&source->nla));
-	if (sent < 0 && PGM_LIKELY(PGM_SOCK_EAGAIN == pgm_get_last_sock_error()))
+	if (!nak_batch_push (sock, source->shard, TRUE, header, tpdu_length, nak_nla (source)))
 		return FALSE;
 
+	PGM_PROBE4 (parity_nak_send, sock, source, nak_tg_sqn, nak_pkt_cnt);
+	pgm_flightrec_add (sock->flightrec, PGM_FLIGHTREC_NAK_SEND, PGM_OPT_PARITY, source->tsi.sport, nak_tg_sqn, nak_pkt_cnt);
 	source->cumulative_stats[PGM_PC_RECEIVER_PARITY_NAK_PACKETS_SENT]++;
 	source->cumulative_stats[PGM_PC_RECEIVER_PARITY_NAKS_SENT]++;
 	return TRUE;
@@ -1212,7 +2325,6 @@ send_nak_list (
 	struct pgm_opt_header	*opt_header;
 	struct pgm_opt_length	*opt_len;
 	struct pgm_opt_nak_list *opt_nak_list;
-	ssize_t			 sent;
 
 /* pre-conditions */
 	pgm_assert (NULL != sock);
@@ -1236,10 +2348,113 @@ send_nak_list (
 	tpdu_length = sizeof(struct pgm_header) +
 			    sizeof(struct pgm_nak) +
 			    sizeof(struct pgm_opt_length) +		/* includes header */
-			    sizeof(struct pgm_opt_header) +
-			    sizeof(uint8_t) +
-			    ( (sqn_list->len-1) * sizeof(uint32_t) );
-	if (AF_INET6 == source->nla.ss_family)
+			    sizeof(struct pgm_opt_header) +
+			    sizeof(uint8_t) +
+			    ( (sqn_list->len-1) * sizeof(uint32_t) );
+	if (pgm_is_inet6 (source->nla.ss_family))
+		tpdu_length += sizeof(struct pgm_nak6) - sizeof(struct pgm_nak);
+	buf = pgm_alloca (tpdu_length);
+	if (PGM_UNLIKELY(pgm_mem_gc_friendly))
+		memset (buf, 0, tpdu_length);
+	header = (struct pgm_header*)buf;
+	nak  = (struct pgm_nak *)(header + 1);
+	nak6 = (struct pgm_nak6*)(header + 1);
+	memcpy (header->pgm_gsi, &source->tsi.gsi, sizeof(pgm_gsi_t));
+
+/* dport & sport swap over for a nak */
+	header->pgm_sport	= sock->dport;
+	header->pgm_dport	= source->tsi.sport;
+	header->pgm_type        = PGM_NAK;
+        header->pgm_options     = PGM_OPT_PRESENT | PGM_OPT_NETWORK;
+        header->pgm_tsdu_length = 0;
+
+/* NAK */
+	nak->nak_sqn		= pgm_htonl (sqn_list->sqn[0]);
+
+/* source nla */
+	pgm_sockaddr_to_nla ((struct sockaddr*)&source->nla, (char*)&nak->nak_src_nla_afi);
+
+/* group nla */
+	pgm_sockaddr_to_nla ((struct sockaddr*)&source->group_nla,
+				pgm_is_inet6 (source->nla.ss_family) ?
+					(char*)&nak6->nak6_grp_nla_afi :
+					(char*)&nak->nak_grp_nla_afi);
+/* OPT_NAK_LIST */
+	opt_len = pgm_is_inet6 (source->nla.ss_family) ?
+			(struct pgm_opt_length*)(nak6 + 1) :
+			(struct pgm_opt_length*)(nak  + 1);
+	opt_len->opt_type	= PGM_OPT_LENGTH;
+	opt_len->opt_length	= sizeof(struct pgm_opt_length);
+	opt_len->opt_total_length = pgm_htons (	sizeof(struct pgm_opt_length) +
+						sizeof(struct pgm_opt_header) +
+						sizeof(uint8_t) +
+						( (sqn_list->len-1) * sizeof(uint32_t) ) );
+	opt_header = (struct pgm_opt_header*)(opt_len + 1);
+	opt_header->opt_type	= PGM_OPT_NAK_LIST | PGM_OPT_END;
+	opt_header->opt_length	= sizeof(struct pgm_opt_header) + sizeof(uint8_t)
+				+ ( (sqn_list->len-1) * sizeof(uint32_t) );
+	opt_nak_list = (struct pgm_opt_nak_list*)(opt_header + 1);
+	opt_nak_list->opt_reserved = 0;
+
+	for (unsigned i = 1; i < sqn_list->len; i++)
+		opt_nak_list->opt_sqn[i-1] = pgm_htonl (sqn_list->sqn[i]);
+
+        header->pgm_checksum    = 0;
+        header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
+
+	if (!nak_batch_push (sock, source->shard, FALSE, header, tpdu_length, nak_nla (source)))
+		return FALSE;
+
+	PGM_PROBE4 (nak_send, sock, source, sqn_list->sqn[0], sqn_list->len);
+	pgm_flightrec_add (sock->flightrec, PGM_FLIGHTREC_NAK_SEND, 0, source->tsi.sport, sqn_list->sqn[0], sqn_list->len);
+	source->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAK_PACKETS_SENT]++;
+	source->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SENT] += 1 + sqn_list->len;
+	return TRUE;
+}
+
+/* send a NAK with OPT_NAK_RANGE to a source advertising support, each gap
+ * of missing sequences as one run.
+ *
+ * on success, TRUE is returned.  if operation would block, FALSE is
+ * returned.
+ */
+
+static
+bool
+send_nak_range (
+	pgm_sock_t*		     	   const restrict sock,
+	pgm_peer_t*			   const restrict source,
+	const struct pgm_sqn_range_list_t* const restrict range_list
+	)
+{
+	size_t			  tpdu_length;
+	char			 *buf;
+	struct pgm_header	 *header;
+	struct pgm_nak		 *nak;
+	struct pgm_nak6		 *nak6;
+	struct pgm_opt_header	 *opt_header;
+	struct pgm_opt_length	 *opt_len;
+	struct pgm_opt_nak_range *opt_nak_range;
+	uint32_t		  nak_count = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != source);
+	pgm_assert (NULL != range_list);
+	pgm_assert_cmpuint (range_list->len, >, 0);
+	pgm_assert_cmpuint (range_list->len, <=, PGM_SQN_RANGE_MAX);
+
+	pgm_debug ("send_nak_range (sock:%p source:%p range-list:%p)",
+		(const void*)sock, (const void*)source, (const void*)range_list);
+
+	const uint16_t opt_range_length = sizeof(struct pgm_opt_header) +
+					  sizeof(uint8_t) +
+					  ( range_list->len * sizeof(struct pgm_nak_range) );
+	tpdu_length = sizeof(struct pgm_header) +
+			    sizeof(struct pgm_nak) +
+			    sizeof(struct pgm_opt_length) +		/* includes header */
+			    opt_range_length;
+	if (pgm_is_inet6 (source->nla.ss_family))
 		tpdu_length += sizeof(struct pgm_nak6) - sizeof(struct pgm_nak);
 	buf = pgm_alloca (tpdu_length);
 	if (PGM_UNLIKELY(pgm_mem_gc_friendly))
@@ -1257,52 +2472,45 @@ send_nak_list (
         header->pgm_tsdu_length = 0;
 
 /* NAK */
-	nak->nak_sqn		= pgm_htonl (sqn_list->sqn[0]);
+	nak->nak_sqn		= pgm_htonl (range_list->range[0].sqn);
 
 /* source nla */
 	pgm_sockaddr_to_nla ((struct sockaddr*)&source->nla, (char*)&nak->nak_src_nla_afi);
 
 /* group nla */
 	pgm_sockaddr_to_nla ((struct sockaddr*)&source->group_nla,
-				(AF_INET6 == source->nla.ss_family) ?
+				pgm_is_inet6 (source->nla.ss_family) ?
 					(char*)&nak6->nak6_grp_nla_afi :
 					(char*)&nak->nak_grp_nla_afi);
-/* OPT_NAK_LIST */
-	opt_len = (AF_INET6 == source->nla.ss_family) ?
+/* OPT_NAK_RANGE */
+	opt_len = pgm_is_inet6 (source->nla.ss_family) ?
 			(struct pgm_opt_length*)(nak6 + 1) :
 			(struct pgm_opt_length*)(nak  + 1);
 	opt_len->opt_type	= PGM_OPT_LENGTH;
 	opt_len->opt_length	= sizeof(struct pgm_opt_length);
-	opt_len->opt_total_length = pgm_htons (	sizeof(struct pgm_opt_length) +
-						sizeof(struct pgm_opt_header) +
-						sizeof(uint8_t) +
-						( (sqn_list->len-1) * sizeof(uint32_t) ) );
+	opt_len->opt_total_length = pgm_htons (sizeof(struct pgm_opt_length) + opt_range_length);
 	opt_header = (struct pgm_opt_header*)(opt_len + 1);
-	opt_header->opt_type	= PGM_OPT_NAK_LIST | PGM_OPT_END;
-	opt_header->opt_length	= sizeof(struct pgm_opt_header) + sizeof(uint8_t)
-				+ ( (sqn_list->len-1) * sizeof(uint32_t) );
-	opt_nak_list = (struct pgm_opt_nak_list*)(opt_header + 1);
-	opt_nak_list->opt_reserved = 0;
-
-	for (unsigned i = 1; i < sqn_list->len; i++)
-		opt_nak_list->opt_sqn[i-1] = pgm_htonl (sqn_list->sqn[i]);
+	opt_header->opt_type	= PGM_OPT_NAK_RANGE | PGM_OPT_END;
+	opt_header->opt_length	= (uint8_t)opt_range_length;
+	opt_nak_range = (struct pgm_opt_nak_range*)(opt_header + 1);
+	opt_nak_range->opt_reserved = 0;
+
+	for (unsigned i = 0; i < range_list->len; i++) {
+		opt_nak_range->opt_range[i].range_sqn   = pgm_htonl (range_list->range[i].sqn);
+		opt_nak_range->opt_range[i].range_count = pgm_htonl (range_list->range[i].count);
+		nak_count += range_list->range[i].count;
+	}
 
         header->pgm_checksum    = 0;
         header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
 
-	sent = pgm_sendto (sock,
-			   FALSE,			/* not rate limited */
-			   NULL,
-			   FALSE,			/* regular socket */
-			   header,
-			   tpdu_length,
-			   (struct sockaddr*)&source->nla,
-			   pgm_sockaddr_len((struct sockaddr*)&source->nla));
-	if (sent < 0 && PGM_LIKELY(PGM_SOCK_EAGAIN == pgm_get_last_sock_error()))
+	if (!nak_batch_push (sock, source->shard, FALSE, header, tpdu_length, nak_nla (source)))
 		return FALSE;
 
+	PGM_PROBE4 (nak_send, sock, source, range_list->range[0].sqn, nak_count);
+	pgm_flightrec_add (sock->flightrec, PGM_FLIGHTREC_NAK_SEND, 0, source->tsi.sport, range_list->range[0].sqn, nak_count);
 	source->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAK_PACKETS_SENT]++;
-	source->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SENT] += 1 + sqn_list->len;
+	source->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SENT] += nak_count;
 	return TRUE;
 }
 
@@ -1341,7 +2549,7 @@ send_ack (
 			     sizeof(struct pgm_opt_length) +		/* includes header */
 			     sizeof(struct pgm_opt_header) +
 			     sizeof(struct pgm_opt_pgmcc_feedback);
-	if (AF_INET6 == sock->send_addr.ss_family)
+	if (pgm_is_inet6 (sock->send_addr.ss_family))
 		tpdu_length += sizeof(struct pgm_opt6_pgmcc_feedback) - sizeof(struct pgm_opt_pgmcc_feedback);
 	buf = pgm_alloca (tpdu_length);
 	if (PGM_UNLIKELY(pgm_mem_gc_friendly))
@@ -1367,13 +2575,13 @@ send_ack (
 	opt_len->opt_length	= sizeof(struct pgm_opt_length);
 	opt_len->opt_total_length = pgm_htons (	sizeof(struct pgm_opt_length) +
 						sizeof(struct pgm_opt_header) +
-						(AF_INET6 == sock->send_addr.ss_family) ?
+						pgm_is_inet6 (sock->send_addr.ss_family) ?
 							sizeof(struct pgm_opt6_pgmcc_feedback) :
 							sizeof(struct pgm_opt_pgmcc_feedback) );
 	opt_header = (struct pgm_opt_header*)(opt_len + 1);
 	opt_header->opt_type	= PGM_OPT_PGMCC_FEEDBACK | PGM_OPT_END;
 	opt_header->opt_length	= sizeof(struct pgm_opt_header) +
-				  ( (AF_INET6 == sock->send_addr.ss_family) ?
+				  ( pgm_is_inet6 (sock->send_addr.ss_family) ?
 					sizeof(struct pgm_opt6_pgmcc_feedback) :
 					sizeof(struct pgm_opt_pgmcc_feedback) );
 	opt_pgmcc_feedback = (struct pgm_opt_pgmcc_feedback*)(opt_header + 1);
@@ -1534,6 +2742,7 @@ nak_rb_state (
 
 /* have not learned this peers NLA */
 	const bool is_valid_nla = 0 != peer->nla.ss_family;
+	const pgm_time_t nak_rpt_ivl = nak_peer_ivl (sock, peer, sock->nak_rpt_ivl);
 
 /* TODO: process BOTH selective and parity NAKs? */
 
@@ -1554,46 +2763,52 @@ nak_rb_state (
 		     NULL != it;
 		     it = prev)
 		{
-			struct pgm_sk_buff_t* skb	= (struct pgm_sk_buff_t*)it;
-			pgm_rxw_state_t* state		= (pgm_rxw_state_t*)&skb->cb;
+			pgm_rxw_gap_t* gap		= (pgm_rxw_gap_t*)it;
+			pgm_rxw_state_t* state		= &gap->state;
 
 			prev = it->prev;
 
-/* check this packet for state expiration */
+/* check this gap for state expiration */
 			if (pgm_time_after_eq (now, state->timer_expiry))
 			{
 				if (PGM_UNLIKELY(!is_valid_nla)) {
-					dropped_invalid++;
-					pgm_rxw_lost (peer->window, skb->sequence);
+					dropped_invalid += gap->len;
+					pgm_rxw_state (peer->window, gap, PGM_PKT_STATE_LOST_DATA);
 /* mark receiver window for flushing on next recv() */
 					pgm_peer_set_pending (sock, peer);
 					continue;
 				}
 
 /* TODO: parity nak lists */
-				const uint32_t tg_sqn = skb->sequence & tg_sqn_mask;
+				const uint32_t tg_sqn = gap->sequence & tg_sqn_mask;
 				if (	(  nak_pkt_cnt && tg_sqn == nak_tg_sqn ) ||
 					( !nak_pkt_cnt && tg_sqn != current_tg_sqn )	)
 				{
-					pgm_rxw_state (peer->window, skb, PGM_PKT_STATE_WAIT_NCF);
+/* remainder of gap in following transmission groups stays in back-off */
+					const uint32_t next_tg_sqn = tg_sqn + (1 << peer->window->tg_sqn_shift);
+					if (pgm_uint32_gt (gap->sequence + gap->len, next_tg_sqn)) {
+						(void)pgm_rxw_split (peer->window, gap, next_tg_sqn);
+						prev = it->prev;
+					}
+
+					pgm_rxw_state (peer->window, gap, PGM_PKT_STATE_WAIT_NCF);
 
-					if (!nak_pkt_cnt++)
+					if (!nak_pkt_cnt)
 						nak_tg_sqn = tg_sqn;
-					state->nak_transmit_count++;
+					nak_pkt_cnt += gap->len;
+					if (1 == ++state->nak_transmit_count)
+						gap->nak_tstamp = gap->nak_sent_tstamp = now;
 
 #ifdef PGM_ABSOLUTE_EXPIRY
-					state->timer_expiry += sock->nak_rpt_ivl;
+					state->timer_expiry += nak_rpt_ivl;
 					while (pgm_time_after_eq (now, state->timer_expiry)) {
-						state->timer_expiry += sock->nak_rpt_ivl;
+						state->timer_expiry += nak_rpt_ivl;
 						state->ncf_retry_count++;
 					}
 #else
-					state->timer_expiry = now + sock->nak_rpt_ivl;
+					state->timer_expiry = now + nak_rpt_ivl;
 #endif
-					pgm_timer_lock (sock);
-					if (pgm_time_after (sock->next_poll, state->timer_expiry))
-						sock->next_poll = state->timer_expiry;
-					pgm_timer_unlock (sock);
+					pgm_timer_pull (sock, peer->shard, state->timer_expiry);
 				}
 				else
 				{	/* different transmission group */
@@ -1609,6 +2824,66 @@ nak_rb_state (
 		if (nak_pkt_cnt && !send_parity_nak (sock, peer, nak_tg_sqn, nak_pkt_cnt))
 			return FALSE;
 	}
+	else if (sock->use_nak_range && peer->has_nak_range)
+	{
+		struct pgm_sqn_range_list_t range_list = { .len = 0 };
+
+/* range NAK generation, one run per gap */
+
+		for (pgm_list_t *it = nak_backoff_queue->tail, *prev = it->prev;
+		     NULL != it;
+		     it = prev)
+		{
+			pgm_rxw_gap_t* gap		= (pgm_rxw_gap_t*)it;
+			pgm_rxw_state_t* state		= &gap->state;
+
+			prev = it->prev;
+
+/* check this gap for state expiration */
+			if (pgm_time_after_eq(now, state->timer_expiry))
+			{
+				if (PGM_UNLIKELY(!is_valid_nla)) {
+					dropped_invalid += gap->len;
+					pgm_rxw_state (peer->window, gap, PGM_PKT_STATE_LOST_DATA);
+/* mark receiver window for flushing on next recv() */
+					pgm_peer_set_pending (sock, peer);
+					continue;
+				}
+
+				pgm_rxw_state (peer->window, gap, PGM_PKT_STATE_WAIT_NCF);
+				range_list.range[range_list.len].sqn   = gap->sequence;
+				range_list.range[range_list.len].count = gap->len;
+				range_list.len++;
+				if (1 == ++state->nak_transmit_count)
+					gap->nak_tstamp = gap->nak_sent_tstamp = now;
+
+#ifdef PGM_ABSOLUTE_EXPIRY
+				state->timer_expiry += nak_rpt_ivl;
+				while (pgm_time_after_eq(now, state->timer_expiry)){
+					state->timer_expiry += nak_rpt_ivl;
+					state->ncf_retry_count++;
+				}
+#else
+				state->timer_expiry = now + nak_rpt_ivl;
+#endif
+				pgm_timer_pull (sock, peer->shard, state->timer_expiry);
+
+				if (range_list.len == PGM_SQN_RANGE_MAX) {
+					if (sock->can_send_nak && !send_nak_range (sock, peer, &range_list))
+						return FALSE;
+					range_list.len = 0;
+				}
+			}
+			else
+			{	/* packet expires some time later */
+				break;
+			}
+		}
+
+		if (sock->can_send_nak && range_list.len &&
+		    !send_nak_range (sock, peer, &range_list))
+			return FALSE;
+	}
 	else
 	{
 		struct pgm_sqn_list_t nak_list = { .len = 0 };
@@ -1619,45 +2894,53 @@ nak_rb_state (
 		     NULL != it;
 		     it = prev)
 		{
-			struct pgm_sk_buff_t* skb	= (struct pgm_sk_buff_t*)it;
-			pgm_rxw_state_t* state		= (pgm_rxw_state_t*)&skb->cb;
+			pgm_rxw_gap_t* gap		= (pgm_rxw_gap_t*)it;
+			pgm_rxw_state_t* state		= &gap->state;
 
 			prev = it->prev;
 
-/* check this packet for state expiration */
+/* check this gap for state expiration */
 			if (pgm_time_after_eq(now, state->timer_expiry))
 			{
 				if (PGM_UNLIKELY(!is_valid_nla)) {
-					dropped_invalid++;
-					pgm_rxw_lost (peer->window, skb->sequence);
+					dropped_invalid += gap->len;
+					pgm_rxw_state (peer->window, gap, PGM_PKT_STATE_LOST_DATA);
 /* mark receiver window for flushing on next recv() */
 					pgm_peer_set_pending (sock, peer);
 					continue;
 				}
 
-				pgm_rxw_state (peer->window, skb, PGM_PKT_STATE_WAIT_NCF);
-				nak_list.sqn[nak_list.len++] = skb->sequence;
-				state->nak_transmit_count++;
+/* sequences beyond the free space of the NAK list wait for the next pass
+ * of the loop.
+ */
+				const uint32_t nak_space = PGM_N_ELEMENTS(nak_list.sqn) - nak_list.len;
+				if (gap->len > nak_space) {
+					(void)pgm_rxw_split (peer->window, gap, gap->sequence + nak_space);
+					prev = it->prev;
+				}
+
+				pgm_rxw_state (peer->window, gap, PGM_PKT_STATE_WAIT_NCF);
+				for (uint32_t i = 0; i < gap->len; i++)
+					nak_list.sqn[nak_list.len++] = gap->sequence + i;
+				if (1 == ++state->nak_transmit_count)
+					gap->nak_tstamp = gap->nak_sent_tstamp = now;
 
 /* we have two options here, calculate the expiry time in the new state relative to the current
  * state execution time, skipping missed expirations due to delay in state processing, or base
  * from the actual current time.
  */
 #ifdef PGM_ABSOLUTE_EXPIRY
-				state->timer_expiry += sock->nak_rpt_ivl;
+				state->timer_expiry += nak_rpt_ivl;
 				while (pgm_time_after_eq(now, state->timer_expiry)){
-					state->timer_expiry += sock->nak_rpt_ivl;
+					state->timer_expiry += nak_rpt_ivl;
 					state->ncf_retry_count++;
 				}
 #else
-				state->timer_expiry = now + sock->nak_rpt_ivl;
+				state->timer_expiry = now + nak_rpt_ivl;
 pgm_trace(PGM_LOG_ROLE_NETWORK,_("nak_rpt_expiry in %f seconds."),
 		pgm_to_secsf( state->timer_expiry - now ) );
 #endif
-				pgm_timer_lock (sock);
-				if (pgm_time_after (sock->next_poll, state->timer_expiry))
-					sock->next_poll = state->timer_expiry;
-				pgm_timer_unlock (sock);
+				pgm_timer_pull (sock, peer->shard, state->timer_expiry);
 
 				if (nak_list.len == PGM_N_ELEMENTS(nak_list.sqn)) {
 					if (sock->can_send_nak && !send_nak_list (sock, peer, &nak_list))
@@ -1689,7 +2972,7 @@ pgm_trace(PGM_LOG_ROLE_NETWORK,_("nak_rpt_expiry in %f seconds."),
 		if (peer->window->cumulative_losses != peer->last_cumulative_losses &&
 		    !peer->pending_link.data)
 		{
-			sock->is_reset = TRUE;
+			peer->shard->is_reset = TRUE;
 			peer->lost_count = peer->window->cumulative_losses - peer->last_cumulative_losses;
 			peer->last_cumulative_losses = peer->window->cumulative_losses;
 			pgm_peer_set_pending (sock, peer);
@@ -1719,8 +3002,232 @@ pgm_trace(PGM_LOG_ROLE_NETWORK,_("nak_rpt_expiry in %f seconds."),
 	return TRUE;
 }
 
-/* check this peer for NAK state timers, uses the tail of each queue for the nearest
+/* earliest expiration of any state timer of this peer, including the
+ * expiry of the peer itself, uses the tail of each queue for the nearest
  * timer execution.
+ */
+
+static
+pgm_time_t
+peer_next_expiry (
+	const pgm_sock_t* const restrict sock,
+	const pgm_peer_t* const restrict peer
+	)
+{
+	pgm_time_t expiration = peer->expiry;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != peer);
+	pgm_assert (NULL != peer->window);
+
+	if (peer->spmr_expiry)
+	{
+		if (pgm_time_after_eq (expiration, peer->spmr_expiry))
+			expiration = peer->spmr_expiry;
+	}
+
+	if (peer->polr_expiry)
+	{
+		if (pgm_time_after_eq (expiration, peer->polr_expiry))
+			expiration = peer->polr_expiry;
+	}
+
+	if (peer->window->ack_backoff_queue.tail)
+	{
+		pgm_assert (sock->use_pgmcc);
+		if (pgm_time_after_eq (expiration, next_ack_rb_expiry (peer->window)))
+			expiration = next_ack_rb_expiry (peer->window);
+	}
+
+	if (peer->window->nak_backoff_queue.tail)
+	{
+		if (pgm_time_after_eq (expiration, next_nak_rb_expiry (peer->window)))
+			expiration = next_nak_rb_expiry (peer->window);
+	}
+
+	if (peer->window->wait_ncf_queue.tail)
+	{
+		if (pgm_time_after_eq (expiration, next_nak_rpt_expiry (peer->window)))
+			expiration = next_nak_rpt_expiry (peer->window);
+	}
+
+	if (peer->window->wait_data_queue.tail)
+	{
+		if (pgm_time_after_eq (expiration, next_nak_rdata_expiry (peer->window)))
+			expiration = next_nak_rdata_expiry (peer->window);
+	}
+
+	for (unsigned i = 0; i < peer->repair_len; i++)
+	{
+		if (pgm_time_after_eq (expiration, peer->repair[ i ].expiry))
+			expiration = peer->repair[ i ].expiry;
+	}
+
+	if (sock->latency_budget && peer->window->missing_count)
+	{
+		const pgm_time_t deadline = pgm_rxw_gap_tstamp (peer->window) + sock->latency_budget;
+		if (pgm_time_after_eq (expiration, deadline))
+			expiration = deadline;
+	}
+
+	return expiration;
+}
+
+/* peers are kept in a binary min-heap keyed on pgm_peer_t::timer_expiry so
+ * that the timer sweep only visits peers with due timers.  each shard keeps
+ * its own heap, only modified by the receiver holding the shard mutex.  the
+ * keys are copied into a dense array parallel to the heap such that sifting
+ * and the due check compare without loading scattered peer objects.
+ */
+
+static
+void
+peer_heap_insert (
+	struct pgm_rx_shard_t* const restrict shard,
+	pgm_peer_t*	       const restrict peer
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != shard);
+	pgm_assert (NULL != peer);
+
+	if (shard->peers_heap_len == shard->peers_heap_size) {
+		shard->peers_heap_size = shard->peers_heap_size ? (2 * shard->peers_heap_size) : 16;
+		shard->peers_heap = pgm_realloc (shard->peers_heap, shard->peers_heap_size * sizeof(pgm_peer_t*));
+		shard->peers_heap_expiry = pgm_realloc (shard->peers_heap_expiry, shard->peers_heap_size * sizeof(pgm_time_t));
+	}
+	shard->peers_heap[ shard->peers_heap_len ] = peer;
+	peer->timer_index = shard->peers_heap_len++;
+	peer_heap_reschedule (shard, peer->timer_index);
+}
+
+static
+void
+peer_heap_remove (
+	struct pgm_rx_shard_t* const restrict shard,
+	pgm_peer_t*	       const restrict peer
+	)
+{
+	const unsigned index = peer->timer_index;
+
+/* pre-conditions */
+	pgm_assert (NULL != shard);
+	pgm_assert (NULL != peer);
+	pgm_assert_cmpuint (index, <, shard->peers_heap_len);
+	pgm_assert (peer == shard->peers_heap[ index ]);
+
+	if (index != --shard->peers_heap_len) {
+		shard->peers_heap[ index ] = shard->peers_heap[ shard->peers_heap_len ];
+		shard->peers_heap_expiry[ index ] = shard->peers_heap_expiry[ shard->peers_heap_len ];
+		shard->peers_heap[ index ]->timer_index = index;
+		peer_heap_reschedule (shard, index);
+	}
+}
+
+/* restore heap order after the key at index has changed in either direction.
+ */
+
+static
+void
+peer_heap_reschedule (
+	struct pgm_rx_shard_t* const	shard,
+	const unsigned			index
+	)
+{
+	pgm_peer_t** heap = shard->peers_heap;
+	pgm_time_t* key = shard->peers_heap_expiry;
+	pgm_peer_t* peer = heap[ index ];
+	const pgm_time_t expiry = peer->timer_expiry;
+	unsigned i = index;
+
+/* sift up */
+	while (i > 0) {
+		const unsigned parent = (i - 1) / 2;
+		if (!pgm_time_after (key[ parent ], expiry))
+			break;
+		heap[ i ] = heap[ parent ];
+		key[ i ] = key[ parent ];
+		heap[ i ]->timer_index = i;
+		i = parent;
+	}
+
+/* sift down */
+	if (i == index) {
+		for (;;) {
+			unsigned child = (2 * i) + 1;
+			if (child >= shard->peers_heap_len)
+				break;
+			if (child + 1 < shard->peers_heap_len &&
+			    pgm_time_after (key[ child ], key[ child + 1 ]))
+				child++;
+			if (!pgm_time_after (expiry, key[ child ]))
+				break;
+			heap[ i ] = heap[ child ];
+			key[ i ] = key[ child ];
+			heap[ i ]->timer_index = i;
+			i = child;
+		}
+	}
+
+	heap[ i ] = peer;
+	key[ i ] = expiry;
+	peer->timer_index = i;
+}
+
+/* recalculate the next state timer of a peer after any change to its
+ * receive window queues, SPMR timer, or expiry.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_peer_timer_update (
+	pgm_sock_t* const restrict sock,
+	pgm_peer_t* const restrict peer
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != peer);
+
+	peer->timer_expiry = peer_next_expiry (sock, peer);
+	peer_heap_reschedule (peer->shard, peer->timer_index);
+}
+
+/* declare lost the gaps of a peer exceeding the latency budget, such that
+ * delivery continues past them whatever their NAK state.
+ */
+
+static
+void
+deadline_state (
+	pgm_sock_t*restrict	sock,
+	pgm_peer_t*restrict	peer,
+	const pgm_time_t	now
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != peer);
+	pgm_assert (NULL != peer->window);
+	pgm_assert (sock->latency_budget > 0);
+
+	pgm_debug ("deadline_state (sock:%p peer:%p now:%" PGM_TIME_FORMAT ")",
+		(void*)sock, (void*)peer, now);
+
+	const uint32_t expired = pgm_rxw_expire (peer->window, now - sock->latency_budget);
+	if (0 == expired)
+		return;
+
+	pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Lost %" PRIu32 " sequences exceeding latency budget."), expired);
+	peer->cumulative_stats[PGM_PC_RECEIVER_DEADLINE_DROPS] += expired;
+
+/* mark receiver window for flushing on next recv() */
+	pgm_peer_set_pending (sock, peer);
+}
+
+/* check peers of a shard with due NAK state timers, uses the tail of each
+ * queue for the nearest timer execution.
  *
  * returns TRUE on complete sweep, returns FALSE if operation would block.
  */
@@ -1728,26 +3235,22 @@ pgm_trace(PGM_LOG_ROLE_NETWORK,_("nak_rpt_expiry in %f seconds."),
 PGM_GNUC_INTERNAL
 bool
 pgm_check_peer_state (
-	pgm_sock_t*const	sock,
-	const pgm_time_t	now
+	pgm_sock_t*	       const restrict sock,
+	struct pgm_rx_shard_t* const restrict shard,
+	const pgm_time_t		      now
 	)
 {
 /* pre-conditions */
 	pgm_assert (NULL != sock);
+	pgm_assert (NULL != shard);
 
-	pgm_debug ("pgm_check_peer_state (sock:%p now:%" PGM_TIME_FORMAT ")",
-		(const void*)sock, now);
-
-	if (!sock->peers_list)
-		return TRUE;
+	pgm_debug ("pgm_check_peer_state (sock:%p shard:%u now:%" PGM_TIME_FORMAT ")",
+		(const void*)sock, shard->index, now);
 
-	for (pgm_list_t *it = sock->peers_list, *next = it->next;
-	     NULL != it;
-	     it = next)
+	while (shard->peers_heap_len > 0 &&
+	       pgm_time_after_eq (now, shard->peers_heap_expiry[ 0 ]))
 	{
-		pgm_peer_t* peer = it->data;
-
-		next = it->next;
+		pgm_peer_t* peer = shard->peers_heap[ 0 ];
 
 		if (peer->spmr_expiry)
 		{
@@ -1755,6 +3258,7 @@ pgm_check_peer_state (
 			{
 				if (sock->can_send_nak) {
 					if (!send_spmr (sock, peer)) {
+						nak_batch_flush (sock, shard);
 						return FALSE;
 					}
 					peer->spmr_tstamp = now;
@@ -1763,20 +3267,45 @@ pgm_check_peer_state (
 			}
 		}
 
+		if (peer->polr_expiry)
+		{
+			if (pgm_time_after_eq (now, peer->polr_expiry))
+			{
+				if (sock->can_send_nak &&
+				    !send_polr (sock, peer, now))
+				{
+					nak_batch_flush (sock, shard);
+					return FALSE;
+				}
+				peer->polr_expiry = 0;
+			}
+		}
+
 		if (peer->window->ack_backoff_queue.tail)
 		{
 			pgm_assert (sock->use_pgmcc);
 
 			if (pgm_time_after_eq (now, next_ack_rb_expiry (peer->window)))
 				if (!ack_rb_state (sock, peer, now)) {
+					nak_batch_flush (sock, shard);
 					return FALSE;
 				}
 		}
 
+		if (peer->repair_len)
+			peer_repair_state (sock, peer, now);
+
+		if (sock->latency_budget && peer->window->missing_count)
+		{
+			if (pgm_time_after_eq (now, pgm_rxw_gap_tstamp (peer->window) + sock->latency_budget))
+				deadline_state (sock, peer, now);
+		}
+
 		if (peer->window->nak_backoff_queue.tail)
 		{
 			if (pgm_time_after_eq (now, next_nak_rb_expiry (peer->window)))
 				if (!nak_rb_state (sock, peer, now)) {
+					nak_batch_flush (sock, shard);
 					return FALSE;
 				}
 		}
@@ -1793,7 +3322,7 @@ pgm_check_peer_state (
 				nak_rdata_state (sock, peer, now);
 		}
 
-/* expired, remove from hash table and linked list */
+/* expired, remove from hash table, linked list, and timer heap */
 		if (pgm_time_after_eq (now, peer->expiry))
 		{
 			if (peer->pending_link.data)
@@ -1809,27 +3338,41 @@ pgm_check_peer_state (
 			else
 			{
 				pgm_trace (PGM_LOG_ROLE_SESSION,_("Peer expired, tsi %s"), pgm_tsi_print (&peer->tsi));
-				pgm_hashtable_remove (sock->peers_hashtable, &peer->tsi);
+				pgm_rwlock_writer_lock (&sock->peers_lock);
+				pgm_peer_table_remove (shard->peers_table, &peer->tsi);
 				sock->peers_list = pgm_list_remove_link (sock->peers_list, &peer->peers_link);
-				if (sock->last_hash_value == peer)
-					sock->last_hash_value = NULL;
+				pgm_rwlock_writer_unlock (&sock->peers_lock);
+				peer_heap_remove (shard, peer);
 				pgm_peer_unref (peer);
+				continue;
 			}
 		}
 
+/* reschedule, timers left due are deferred to the next sweep */
+		peer->timer_expiry = peer_next_expiry (sock, peer);
+		if (pgm_time_after_eq (now, peer->timer_expiry))
+			peer->timer_expiry = now + 1;
+		peer_heap_reschedule (shard, peer->timer_index);
 	}
 
+/* one transmit for all NAKs and SPMRs due this sweep */
+	const bool is_flushed = nak_batch_flush (sock, shard);
+
 /* check for waiting contiguous packets */
-	if (sock->peers_pending && !sock->is_pending_read)
+	if (shard->peers_pending)
 	{
-		pgm_debug ("prod rx thread");
-		pgm_notify_send (&sock->pending_notify);
-		sock->is_pending_read = TRUE;
+		pgm_rx_pending_lock (sock);
+		if (!sock->is_pending_read) {
+			pgm_debug ("prod rx thread");
+			pgm_notify_send (&sock->pending_notify);
+			sock->is_pending_read = TRUE;
+		}
+		pgm_rx_pending_unlock (sock);
 	}
-	return TRUE;
+	return is_flushed;
 }
 
-/* find the next state expiration time among the socks peers.
+/* find the next state expiration time among the peers of a shard.
  *
  * on success, returns the earliest of the expiration parameter or next
  * peer expiration time.
@@ -1838,59 +3381,21 @@ pgm_check_peer_state (
 PGM_GNUC_INTERNAL
 pgm_time_t
 pgm_min_receiver_expiry (
-	pgm_sock_t*	sock,
-	pgm_time_t	expiration		/* absolute time */
+	pgm_sock_t*		sock,
+	struct pgm_rx_shard_t*	shard,
+	pgm_time_t		expiration		/* absolute time */
 	)
 {
 /* pre-conditions */
 	pgm_assert (NULL != sock);
+	pgm_assert (NULL != shard);
 
-	pgm_debug ("pgm_min_receiver_expiry (sock:%p expiration:%" PGM_TIME_FORMAT ")",
-		(void*)sock, expiration);
-
-	if (!sock->peers_list)
-		return expiration;
-
-	for (pgm_list_t *it = sock->peers_list, *next = it->next;
-	     NULL != it;
-	     it = next)
-	{
-		pgm_peer_t* peer = it->data;
-
-		next = it->next;
-
-		if (peer->spmr_expiry)
-		{
-			if (pgm_time_after_eq (expiration, peer->spmr_expiry))
-				expiration = peer->spmr_expiry;
-		}
-
-		if (peer->window->ack_backoff_queue.tail)
-		{
-			pgm_assert (sock->use_pgmcc);
-			if (pgm_time_after_eq (expiration, next_ack_rb_expiry (peer->window)))
-				expiration = next_ack_rb_expiry (peer->window);
-		}
-
-		if (peer->window->nak_backoff_queue.tail)
-		{
-			if (pgm_time_after_eq (expiration, next_nak_rb_expiry (peer->window)))
-				expiration = next_nak_rb_expiry (peer->window);
-		}
-
-		if (peer->window->wait_ncf_queue.tail)
-		{
-			if (pgm_time_after_eq (expiration, next_nak_rpt_expiry (peer->window)))
-				expiration = next_nak_rpt_expiry (peer->window);
-		}
-
-		if (peer->window->wait_data_queue.tail)
-		{
-			if (pgm_time_after_eq (expiration, next_nak_rdata_expiry (peer->window)))
-				expiration = next_nak_rdata_expiry (peer->window);
-		}
+	pgm_debug ("pgm_min_receiver_expiry (sock:%p shard:%u expiration:%" PGM_TIME_FORMAT ")",
+		(void*)sock, shard->index, expiration);
 
-	}
+	if (shard->peers_heap_len > 0 &&
+	    pgm_time_after_eq (expiration, shard->peers_heap_expiry[ 0 ]))
+		expiration = shard->peers_heap_expiry[ 0 ];
 
 	return expiration;
 }
@@ -1928,18 +3433,18 @@ nak_rpt_state (
 	     NULL != it;
 	     it = prev)
 	{
-		struct pgm_sk_buff_t* skb	= (struct pgm_sk_buff_t*)it;
-		pgm_assert (NULL != skb);
-		pgm_rxw_state_t* state		= (pgm_rxw_state_t*)&skb->cb;
+		pgm_rxw_gap_t* gap		= (pgm_rxw_gap_t*)it;
+		pgm_assert (NULL != gap);
+		pgm_rxw_state_t* state		= &gap->state;
 
 		prev = it->prev;
 
-/* check this packet for state expiration */
+/* check this gap for state expiration */
 		if (pgm_time_after_eq (now, state->timer_expiry))
 		{
 			if (PGM_UNLIKELY(!is_valid_nla)) {
-				dropped_invalid++;
-				pgm_rxw_lost (peer->window, skb->sequence);
+				dropped_invalid += gap->len;
+				pgm_rxw_state (peer->window, gap, PGM_PKT_STATE_LOST_DATA);
 /* mark receiver window for flushing on next recv() */
 				pgm_peer_set_pending (sock, peer);
 				continue;
@@ -1947,24 +3452,24 @@ nak_rpt_state (
 
 			if (++state->ncf_retry_count >= sock->nak_ncf_retries)
 			{
-				dropped++;
-				cancel_skb (sock, peer, skb, now);
-				peer->cumulative_stats[PGM_PC_RECEIVER_NAKS_FAILED_NCF_RETRIES_EXCEEDED]++;
+				dropped += gap->len;
+				peer->cumulative_stats[PGM_PC_RECEIVER_NAKS_FAILED_NCF_RETRIES_EXCEEDED] += gap->len;
+				cancel_gap (sock, peer, gap, now);
 			}
 			else
 			{
 /* retry */
-//				state->timer_expiry += nak_rb_ivl(sock);
-				state->timer_expiry = now + nak_rb_ivl (sock);
-				pgm_rxw_state (peer->window, skb, PGM_PKT_STATE_BACK_OFF);
-				pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("NCF retry #%u attempt %u/%u."), skb->sequence, state->ncf_retry_count, sock->nak_ncf_retries);
+//				state->timer_expiry += nak_rb_ivl(sock, peer);
+				state->timer_expiry = now + nak_rb_ivl (sock, peer);
+				pgm_rxw_state (peer->window, gap, PGM_PKT_STATE_BACK_OFF);
+				pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("NCF retry #%u attempt %u/%u."), gap->sequence, state->ncf_retry_count, sock->nak_ncf_retries);
 			}
 		}
 		else
 		{
-/* packet expires some time later */
+/* gap expires some time later */
 			pgm_trace(PGM_LOG_ROLE_RX_WINDOW,_("NCF retry #%u is delayed %f seconds."),
-				skb->sequence, pgm_to_secsf (state->timer_expiry - now));
+				gap->sequence, pgm_to_secsf (state->timer_expiry - now));
 			break;
 		}
 	}
@@ -2005,7 +3510,7 @@ nak_rpt_state (
 	if (PGM_UNLIKELY(peer->window->cumulative_losses != peer->last_cumulative_losses &&
 	    !peer->pending_link.data))
 	{
-		sock->is_reset = TRUE;
+		peer->shard->is_reset = TRUE;
 		peer->lost_count = peer->window->cumulative_losses - peer->last_cumulative_losses;
 		peer->last_cumulative_losses = peer->window->cumulative_losses;
 		pgm_peer_set_pending (sock, peer);
@@ -2061,18 +3566,18 @@ nak_rdata_state (
 	     NULL != it;
 	     it = prev)
 	{
-		struct pgm_sk_buff_t* rdata_skb	= (struct pgm_sk_buff_t*)it;
-		pgm_assert (NULL != rdata_skb);
-		pgm_rxw_state_t* rdata_state	= (pgm_rxw_state_t*)&rdata_skb->cb;
+		pgm_rxw_gap_t* rdata_gap	= (pgm_rxw_gap_t*)it;
+		pgm_assert (NULL != rdata_gap);
+		pgm_rxw_state_t* rdata_state	= &rdata_gap->state;
 
 		prev = it->prev;
 
-/* check this packet for state expiration */
+/* check this gap for state expiration */
 		if (pgm_time_after_eq (now, rdata_state->timer_expiry))
 		{
 			if (PGM_UNLIKELY(!is_valid_nla)) {
-				dropped_invalid++;
-				pgm_rxw_lost (peer->window, rdata_skb->sequence);
+				dropped_invalid += rdata_gap->len;
+				pgm_rxw_state (peer->window, rdata_gap, PGM_PKT_STATE_LOST_DATA);
 /* mark receiver window for flushing on next recv() */
 				pgm_peer_set_pending (sock, peer);
 				continue;
@@ -2080,21 +3585,21 @@ nak_rdata_state (
 
 			if (++rdata_state->data_retry_count >= sock->nak_data_retries)
 			{
-				dropped++;
-				cancel_skb (sock, peer, rdata_skb, now);
-				peer->cumulative_stats[PGM_PC_RECEIVER_NAKS_FAILED_DATA_RETRIES_EXCEEDED]++;
+				dropped += rdata_gap->len;
+				peer->cumulative_stats[PGM_PC_RECEIVER_NAKS_FAILED_DATA_RETRIES_EXCEEDED] += rdata_gap->len;
+				cancel_gap (sock, peer, rdata_gap, now);
 				continue;
 			}
 
-//			rdata_state->timer_expiry += nak_rb_ivl(sock);
-			rdata_state->timer_expiry = now + nak_rb_ivl (sock);
-			pgm_rxw_state (peer->window, rdata_skb, PGM_PKT_STATE_BACK_OFF);
+//			rdata_state->timer_expiry += nak_rb_ivl(sock, peer);
+			rdata_state->timer_expiry = now + nak_rb_ivl (sock, peer);
+			pgm_rxw_state (peer->window, rdata_gap, PGM_PKT_STATE_BACK_OFF);
 
 /* retry back to back-off state */
-			pgm_trace(PGM_LOG_ROLE_RX_WINDOW,_("Data retry #%u attempt %u/%u."), rdata_skb->sequence, rdata_state->data_retry_count, sock->nak_data_retries);
+			pgm_trace(PGM_LOG_ROLE_RX_WINDOW,_("Data retry #%u attempt %u/%u."), rdata_gap->sequence, rdata_state->data_retry_count, sock->nak_data_retries);
 		}
 		else
-		{	/* packet expires some time later */
+		{	/* gap expires some time later */
 			break;
 		}
 		
@@ -2123,7 +3628,7 @@ nak_rdata_state (
 	if (PGM_UNLIKELY(peer->window->cumulative_losses != peer->last_cumulative_losses &&
 	    !peer->pending_link.data))
 	{
-		sock->is_reset = TRUE;
+		peer->shard->is_reset = TRUE;
 		peer->lost_count = peer->window->cumulative_losses - peer->last_cumulative_losses;
 		peer->last_cumulative_losses = peer->window->cumulative_losses;
 		pgm_peer_set_pending (sock, peer);
@@ -2140,6 +3645,9 @@ nak_rdata_state (
 /* ODATA or RDATA packet with any of the following options:
  *
  * OPT_FRAGMENT - this TPDU part of a larger APDU.
+ * OPT_COALESCE - this TPDU carries several length prefixed APDUs.
+ * OPT_COMPRESS - this TPDU part of an LZ4 compressed APDU.
+ * OPT_UNRELIABLE - preceding sequences sent without repair.
  *
  * Ownership of skb is taken and must be passed to the receive window or destroyed.
  *
@@ -2166,10 +3674,37 @@ pgm_on_data (
 	pgm_debug ("pgm_on_data (sock:%p source:%p skb:%p)",
 		(void*)sock, (void*)source, (void*)skb);
 
-	const pgm_time_t nak_rb_expiry = skb->tstamp + nak_rb_ivl (sock);
+/* late join waits on the solicited SPM of a new source to place the window */
+	if (sock->use_late_join && !source->window->is_defined) {
+		pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Discarded data of %s ahead of late join."), pgm_tsi_print (&source->tsi));
+		return FALSE;
+	}
+
+/* a source advertising CRC32C trailers never sends data without any check */
+	if (PGM_UNLIKELY(source->has_crc32c &&
+			 0 == skb->pgm_header->pgm_checksum &&
+			 !skb->crc32c))
+	{
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded %cDATA without CRC32C trailer."),
+			PGM_ODATA == skb->pgm_header->pgm_type ? 'O' : 'R');
+		sock->cumulative_stats[PGM_PC_SOURCE_CKSUM_ERRORS]++;
+		return FALSE;
+	}
+
+/* forward and copy for local repair whilst the TPDU is intact */
+	if (NULL != sock->relay)
+		pgm_relay_forward (sock, skb);
+	if (sock->dlr_sqns > 0)
+		pgm_dlr_cache (sock, source, skb);
+
+	const pgm_time_t nak_rb_expiry = skb->tstamp + nak_rb_ivl (sock, source);
 	const uint_fast16_t tsdu_length = pgm_ntohs (skb->pgm_header->pgm_tsdu_length);
 
 	skb->pgm_data = skb->data;
+	skb->coalesced = 0;
+	skb->compressed = 0;
+	skb->unreliable = 0;
+	skb->send_tstamp = 0;
 
 	const uint_fast16_t opt_total_length = (skb->pgm_header->pgm_options & PGM_OPT_PRESENT) ?
 		pgm_ntohs(*(uint16_t*)( (char*)( skb->pgm_data + 1 ) + sizeof(uint16_t))) :
@@ -2178,7 +3713,9 @@ pgm_on_data (
 /* advance data pointer to payload */
 	pgm_skb_pull (skb, (uint16_t)(sizeof(struct pgm_data) + opt_total_length));
 
+/* options of pre-parsed ODATA are already extracted */
 	if (opt_total_length > 0 &&			/* there are options */
+	    !skb->preparsed &&
 	    get_pgm_options (skb) &&			/* valid options */
 	    sock->use_pgmcc &&				/* PGMCC is enabled */
 	    NULL != skb->pgm_opt_pgmcc_data &&		/* PGMCC options */
@@ -2186,8 +3723,20 @@ pgm_on_data (
 	{
 		ack_rb_expiry = skb->tstamp + ack_rb_ivl (sock);
 	}
+	if (PGM_UNLIKELY(skb->send_tstamp))
+		source->has_send_tstamp = 1;
+
+	const uint32_t data_sqn = pgm_ntohl (skb->pgm_data->data_sqn);
+
+	if (source->repair_len && PGM_RDATA == skb->pgm_header->pgm_type)
+		peer_repair_cancel (source, data_sqn);
+
+/* round-trip time of our own NAK when no NCF was seen */
+	if (sock->use_adaptive_nak && PGM_RDATA == skb->pgm_header->pgm_type)
+		nak_rtt_update (source, pgm_rxw_nak_rtt (source->window, data_sqn, skb->tstamp));
 
 	const int add_status = pgm_rxw_add (source->window, skb, skb->tstamp, nak_rb_expiry);
+	PGM_PROBE4 (rxw_add, sock, source, data_sqn, add_status);
 
 /* skb reference is now invalid */
 	switch (add_status) {
@@ -2256,12 +3805,10 @@ discarded:
 
 	if (flush_naks || 0 != ack_rb_expiry) {
 /* flush out 1st time nak packets */
-		pgm_timer_lock (sock);
-		if (flush_naks && pgm_time_after (sock->next_poll, nak_rb_expiry))
-			sock->next_poll = nak_rb_expiry;
-		if (0 != ack_rb_expiry && pgm_time_after (sock->next_poll, ack_rb_expiry))
-			sock->next_poll = ack_rb_expiry;
-		pgm_timer_unlock (sock);
+		if (flush_naks)
+			pgm_timer_pull (sock, source->shard, nak_rb_expiry);
+		if (0 != ack_rb_expiry)
+			pgm_timer_pull (sock, source->shard, ack_rb_expiry);
 	}
 	return TRUE;
 }
@@ -2301,6 +3848,7 @@ pgm_on_poll (
 	memcpy (&poll_rand, (AFI_IP6 == pgm_ntohs (poll4->poll_nla_afi)) ?
 		poll6->poll6_rand :
 		poll4->poll_rand, sizeof(poll_rand));
+	poll_rand = pgm_ntohl (poll_rand);
 	const uint32_t poll_mask = (AFI_IP6 == pgm_ntohs (poll4->poll_nla_afi)) ?
 		pgm_ntohl (poll6->poll6_mask) :
 		pgm_ntohl (poll4->poll_mask);
@@ -2361,31 +3909,35 @@ on_general_poll (
 	struct pgm_poll*  poll4 = (struct pgm_poll *)skb->data;
 	struct pgm_poll6* poll6 = (struct pgm_poll6*)skb->data;
 
-/* TODO: cancel any pending poll-response */
-
-/* defer response based on provided back-off interval */
+/* defer response based on provided back-off interval, replacing any pending
+ * poll-response, sent by the peer timers.
+ */
 	const uint32_t poll_bo_ivl = (AFI_IP6 == pgm_ntohs (poll4->poll_nla_afi)) ?
 		pgm_ntohl (poll6->poll6_bo_ivl) :
 		pgm_ntohl (poll4->poll_bo_ivl);
-	source->polr_expiry = skb->tstamp + pgm_rand_int_range (&sock->rand_, 0, poll_bo_ivl);
+	source->polr_expiry = skb->tstamp + pgm_rand_int_range (&sock->rand_, 0, (int32_t)MIN(poll_bo_ivl, (uint32_t)INT32_MAX));
 	pgm_nla_to_sockaddr (&poll4->poll_nla_afi, (struct sockaddr*)&source->poll_nla);
-/* TODO: schedule poll-response */
-
 	return TRUE;
 }
 
-/* Used to count off-tree DLRs */
+/* Used to count off-tree DLRs, a DLR answers with its NLA in OPT_REDIRECT */
 
 static
 bool
 on_dlr_poll (
-	PGM_GNUC_UNUSED pgm_sock_t*	      const restrict sock,
-	PGM_GNUC_UNUSED pgm_peer_t*	      const restrict source,
-	PGM_GNUC_UNUSED struct pgm_sk_buff_t* const restrict skb
+	pgm_sock_t*	      const restrict sock,
+	pgm_peer_t*	      const restrict source,
+	struct pgm_sk_buff_t* const restrict skb
 	)
 {
+	const struct pgm_poll* poll4 = (const struct pgm_poll*)skb->data;
+
 /* we are not a DLR */
-	return FALSE;
+	if (0 == sock->dlr_sqns)
+		return FALSE;
+
+	pgm_nla_to_sockaddr (&poll4->poll_nla_afi, (struct sockaddr*)&source->poll_nla);
+	return pgm_dlr_send_polr (sock, source, source->last_poll_sqn, source->last_poll_round);
 }
 
 /* eof */
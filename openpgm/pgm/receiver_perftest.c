@@ -0,0 +1,723 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * performance tests for a receiver with many sources.
+ *
+ * Copyright (c) 2010-2016 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#ifdef __GLIBC__
+#	include <malloc.h>
+#endif
+#include <glib.h>
+#include <check.h>
+
+
+/* mock state */
+
+#define PERF_ITERATIONS		1000000
+#define PERF_MIN_ROUNDS		4
+#define PERF_TSDU_LENGTH	100
+#define PERF_RXW_SQNS		128
+#define PERF_PEER_EXPIRY	( pgm_secs(300) )
+#define PERF_SPMR_EXPIRY	( pgm_msecs(250) )
+#define PERF_NAK_BO_IVL		( pgm_msecs(50) )
+
+static unsigned perf_peers	= 0;
+
+static
+void
+mock_setup_10 (void)
+{
+	perf_peers	= 10;
+}
+
+static
+void
+mock_setup_1k (void)
+{
+	perf_peers	= 1000;
+}
+
+static
+void
+mock_setup_10k (void)
+{
+	perf_peers	= 10000;
+}
+
+static
+void
+mock_setup_100k (void)
+{
+	perf_peers	= 100000;
+}
+
+#define pgm_sendto_hops		mock_pgm_sendto_hops
+#define pgm_sendmmsg_to		mock_pgm_sendmmsg_to
+#define pgm_engine_timer_wake	mock_pgm_engine_timer_wake
+#define pgm_timer_event_arm	mock_pgm_timer_event_arm
+#define pgm_dlr_cache		mock_pgm_dlr_cache
+#define pgm_dlr_destroy		mock_pgm_dlr_destroy
+#define pgm_dlr_send_polr	mock_pgm_dlr_send_polr
+
+#include "receiver.c"
+
+static unsigned perf_sent	= 0;
+
+/** net module */
+PGM_GNUC_INTERNAL
+ssize_t
+mock_pgm_sendto_hops (
+	pgm_sock_t*			sock,
+	bool				use_rate_limit,
+	pgm_rate_t*			minor_rate_control,
+	bool				use_router_alert,
+	int				hops,
+	const void*			buf,
+	size_t				len,
+	const struct sockaddr*		to,
+	socklen_t			tolen
+	)
+{
+	return len;
+}
+
+PGM_GNUC_INTERNAL
+int
+mock_pgm_sendmmsg_to (
+	pgm_sock_t*			sock,
+	bool				use_router_alert,
+	const struct pgm_iovec*		vector,
+	const struct sockaddr*const*	to,
+	unsigned			count
+	)
+{
+	perf_sent += count;
+	return count;
+}
+
+/** engine module */
+PGM_GNUC_INTERNAL
+void
+mock_pgm_engine_timer_wake (
+	const pgm_time_t		expiration
+	)
+{
+}
+
+/** dlr module */
+PGM_GNUC_INTERNAL
+void
+mock_pgm_dlr_cache (
+	pgm_sock_t* const			sock,
+	pgm_peer_t* const			peer,
+	const struct pgm_sk_buff_t* const	skb
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_dlr_destroy (
+	struct pgm_dlr_t* const		dlr
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_dlr_send_polr (
+	pgm_sock_t* const		sock,
+	pgm_peer_t* const		peer,
+	const uint32_t			poll_sqn,
+	const uint16_t			poll_round
+	)
+{
+	return TRUE;
+}
+
+/** timer module */
+PGM_GNUC_INTERNAL
+void
+mock_pgm_timer_event_arm (
+	pgm_sock_t* const		sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+int
+pgm_get_nprocs (void)
+{
+	return 1;
+}
+
+static
+void
+mock_setup (void)
+{
+	pgm_cpu_t cpu;
+	pgm_cpuid (&cpu);
+	pgm_checksum_init (&cpu);
+	g_assert (pgm_time_init (NULL));
+}
+
+static
+void
+mock_teardown (void)
+{
+	g_assert (pgm_time_shutdown ());
+}
+
+static
+void
+perf_report (
+	const char*		name,
+	const pgm_time_t	elapsed,		/* μs */
+	const guint64		count
+	)
+{
+	g_message ("%s/%u: elapsed time %" PGM_TIME_FORMAT " us, unit time %" PGM_TIME_FORMAT " ns, %" PGM_TIME_FORMAT " packets/s",
+		name, perf_peers,
+		(guint64)elapsed,
+		(guint64)((1000 * elapsed) / count),
+		(guint64)(elapsed ? (1000000 * count) / elapsed : 0));
+}
+
+/* bytes allocated from the heap, zero where unsupported.
+ */
+static
+size_t
+heap_in_use (void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	return mallinfo2 ().uordblks;
+#else
+	return 0;
+#endif
+}
+
+/* receive-only socket with one shard as left by pgm_bind() and
+ * pgm_connect().
+ */
+static
+pgm_sock_t*
+generate_sock (void)
+{
+	pgm_sock_t* sock = g_malloc0 (sizeof(pgm_sock_t));
+	sock->can_recv_data	= TRUE;
+	sock->can_send_nak	= TRUE;
+	sock->dport		= g_htons (7500);
+	sock->max_tpdu		= 1500;
+	sock->rxw_sqns		= PERF_RXW_SQNS;
+	sock->peer_expiry	= PERF_PEER_EXPIRY;
+	sock->spmr_expiry	= PERF_SPMR_EXPIRY;
+	sock->nak_bo_ivl	= PERF_NAK_BO_IVL;
+/* no pending notification without a receiving thread */
+	sock->is_pending_read	= TRUE;
+	struct group_source_req gsr;
+	memset (&gsr, 0, sizeof(gsr));
+	struct sockaddr_in* group = (struct sockaddr_in*)&gsr.gsr_group;
+	group->sin_family	= AF_INET;
+	group->sin_addr.s_addr	= inet_addr ("239.192.0.1");
+	memcpy (&gsr.gsr_source, &gsr.gsr_group, sizeof(struct sockaddr_in));
+	pgm_groups_add (sock, &gsr);
+	pgm_rwlock_init (&sock->peers_lock);
+	sock->rx_shard		= g_malloc0 (sizeof(struct pgm_rx_shard_t));
+	sock->rx_shard_len	= 1;
+	sock->event_sock	= INVALID_SOCKET;
+	sock->event_timer_fd	= INVALID_SOCKET;
+	sock->rx_shard->peers_table = pgm_peer_table_new (0x0123456789abcdefULL);
+	fail_if (NULL == sock->rx_shard->peers_table, "peer_table_new failed");
+	return sock;
+}
+
+static
+void
+destroy_sock (
+	pgm_sock_t*	sock
+	)
+{
+	struct pgm_rx_shard_t* shard = sock->rx_shard;
+	while (shard->peers_heap_len > 0) {
+		pgm_peer_t* peer = shard->peers_heap[ shard->peers_heap_len - 1 ];
+		pgm_peer_table_remove (shard->peers_table, &peer->tsi);
+		shard->peers_heap_len--;
+		pgm_peer_unref (peer);
+	}
+	pgm_peer_table_destroy (shard->peers_table);
+	pgm_free (shard->peers_heap);
+	pgm_free (shard->peers_heap_expiry);
+	pgm_free (shard->nak_batch);
+	pgm_rwlock_free (&sock->peers_lock);
+	g_free (shard);
+	g_free (sock);
+}
+
+static
+void
+make_tsi (
+	pgm_tsi_t*	tsi,
+	unsigned	i
+	)
+{
+	memset (tsi, 0, sizeof (pgm_tsi_t));
+	tsi->gsi.identifier[0] = i & 0xff;
+	tsi->gsi.identifier[1] = (i >> 8) & 0xff;
+	tsi->gsi.identifier[2] = (i >> 16) & 0xff;
+	tsi->gsi.identifier[3] = 1;
+	tsi->sport = g_htons (1000 + (i % 7));
+}
+
+static
+pgm_tsi_t*
+generate_tsis (
+	const unsigned	count
+	)
+{
+	pgm_tsi_t* tsis = g_malloc0 (count * sizeof(pgm_tsi_t));
+	for (unsigned i = 0; i < count; i++)
+		make_tsi (&tsis[i], i);
+	return tsis;
+}
+
+/* packet as left by pgm_parse_raw(), data pointing to the PGM header.
+ */
+static
+struct pgm_sk_buff_t*
+generate_skb (
+	pgm_sock_t*		sock,
+	const pgm_tsi_t*	tsi,
+	const uint8_t		type,
+	const uint16_t		len,
+	const pgm_time_t	now
+	)
+{
+	struct pgm_sk_buff_t* skb = pgm_alloc_skb (sock->max_tpdu);
+	skb->sock = sock;
+	skb->tstamp = now;
+	memcpy (&skb->tsi, tsi, sizeof(pgm_tsi_t));
+	skb->pgm_header = (struct pgm_header*)skb->data;
+	pgm_skb_put (skb, len);
+	memset (skb->pgm_header, 0, sizeof(struct pgm_header));
+	memcpy (skb->pgm_header->pgm_gsi, &tsi->gsi, sizeof(pgm_gsi_t));
+	skb->pgm_header->pgm_sport = tsi->sport;
+	skb->pgm_header->pgm_dport = sock->dport;
+	skb->pgm_header->pgm_type  = type;
+	return skb;
+}
+
+static
+struct pgm_sk_buff_t*
+generate_spm (
+	pgm_sock_t*		sock,
+	const pgm_tsi_t*	tsi,
+	const uint32_t		spm_sqn,
+	const uint32_t		lead,
+	const pgm_time_t	now
+	)
+{
+	struct pgm_sk_buff_t* skb = generate_skb (sock, tsi, PGM_SPM, sizeof(struct pgm_header) + sizeof(struct pgm_spm), now);
+	struct pgm_spm* spm = (struct pgm_spm*)(skb->pgm_header + 1);
+	spm->spm_sqn		= g_htonl (spm_sqn);
+	spm->spm_trail		= g_htonl (lead + 1);
+	spm->spm_lead		= g_htonl (lead);
+	spm->spm_nla_afi	= g_htons (AFI_IP);
+	spm->spm_nla.s_addr	= inet_addr ("192.0.2.1");
+	return skb;
+}
+
+static
+struct pgm_sk_buff_t*
+generate_odata (
+	pgm_sock_t*		sock,
+	const pgm_tsi_t*	tsi,
+	const uint32_t		sequence,
+	const pgm_time_t	now
+	)
+{
+	struct pgm_sk_buff_t* skb = generate_skb (sock, tsi, PGM_ODATA, sizeof(struct pgm_header) + sizeof(struct pgm_data) + PERF_TSDU_LENGTH, now);
+	struct pgm_data* data = (struct pgm_data*)(skb->pgm_header + 1);
+	skb->pgm_header->pgm_tsdu_length = g_htons (PERF_TSDU_LENGTH);
+	data->data_sqn		= g_htonl (sequence);
+	data->data_trail	= g_htonl (0);
+	return skb;
+}
+
+/* the downstream path of one packet, mirrors on_downstream() in recv.c
+ * followed by the timer and pending updates of the receive loop.
+ */
+static
+pgm_peer_t*
+perf_receive (
+	pgm_sock_t*		sock,
+	struct pgm_sk_buff_t*	skb
+	)
+{
+	struct pgm_rx_shard_t* shard = pgm_rx_shard_for (sock, &skb->tsi);
+	struct sockaddr_in src, dst;
+	memset (&src, 0, sizeof(src));
+	src.sin_family = AF_INET;
+	src.sin_addr.s_addr = inet_addr ("192.0.2.1");
+	memcpy (&dst, &sock->recv_gsr[0].gsr_group, sizeof(dst));
+
+	pgm_peer_t* source = pgm_peer_table_lookup_mru (shard->peers_table, &skb->tsi);
+	if (NULL == source) {
+		source = pgm_peer_table_lookup (shard->peers_table, &skb->tsi);
+		if (NULL == source)
+			source = pgm_new_peer (sock,
+					       &skb->tsi,
+					       (struct sockaddr*)&src, sizeof(src),
+					       (struct sockaddr*)&dst, sizeof(dst),
+					       skb->tstamp);
+		pgm_peer_table_set_mru (shard->peers_table, &skb->tsi, source);
+	}
+	source->cumulative_stats[PGM_PC_RECEIVER_BYTES_RECEIVED] += skb->len;
+	source->last_packet = skb->tstamp;
+
+	skb->data = (void*)( skb->pgm_header + 1 );
+	skb->len -= sizeof(struct pgm_header);
+
+	bool is_valid;
+	if (PGM_SPM == skb->pgm_header->pgm_type) {
+		is_valid = pgm_on_spm (sock, source, skb);
+		pgm_free_skb (skb);
+	} else
+		is_valid = pgm_on_data (sock, source, skb);
+	fail_unless (is_valid, "packet discarded");
+
+	pgm_peer_timer_update (sock, source);
+	if (pgm_peer_has_pending (source))
+		pgm_peer_set_pending (sock, source);
+	return source;
+}
+
+/* read and commit all pending data as pgm_recv() would.
+ */
+static
+void
+perf_drain (
+	pgm_sock_t*	sock
+	)
+{
+	struct pgm_rx_shard_t* shard = sock->rx_shard;
+	struct pgm_msgv_t msgv[ PERF_RXW_SQNS ];
+	while (shard->peers_pending) {
+		pgm_peer_t* peer = shard->peers_pending->data;
+		struct pgm_msgv_t* pmsg = msgv;
+		fail_unless (pgm_rxw_readv (peer->window, &pmsg, G_N_ELEMENTS(msgv)) > 0, "readv failed");
+		pgm_rxw_remove_commit (peer->window);
+		peer->pending_link.data = NULL;
+		shard->peers_pending = pgm_slist_remove_first (shard->peers_pending);
+	}
+}
+
+/* one SPM from each source, creating every peer.
+ */
+static
+void
+generate_peers (
+	pgm_sock_t*		sock,
+	const pgm_tsi_t*	tsis,
+	const pgm_time_t	now
+	)
+{
+	for (unsigned i = 0; i < perf_peers; i++)
+		perf_receive (sock, generate_spm (sock, &tsis[i], 0, 0, now));
+	fail_unless (perf_peers == sock->rx_shard->peers_heap_len, "peers missing");
+}
+
+/* target:
+ *	pgm_peer_t*
+ *	pgm_new_peer (
+ *		pgm_sock_t*		sock,
+ *		const pgm_tsi_t*	tsi,
+ *		const struct sockaddr*	src_addr,
+ *		const socklen_t		src_addr_len,
+ *		const struct sockaddr*	dst_addr,
+ *		const socklen_t		dst_addr_len,
+ *		const pgm_time_t	now
+ *	)
+ *
+ * first SPM of each source, memory per peer includes the receive window of
+ * PERF_RXW_SQNS sequences, the table entry and the timer heap slot.
+ */
+
+START_TEST (test_new_peer)
+{
+	pgm_tsi_t* tsis = generate_tsis (perf_peers);
+	struct pgm_sk_buff_t** skbs = g_malloc (perf_peers * sizeof(struct pgm_sk_buff_t*));
+	const unsigned rounds = MAX((PERF_ITERATIONS / 10) / perf_peers, 1);
+	pgm_time_t elapsed = 0;
+	size_t memory = 0;
+
+	for (unsigned r = 0; r < rounds; r++) {
+		pgm_sock_t* sock = generate_sock ();
+/* skbs are freed by the receive, leaving only peer state */
+		const size_t heap = heap_in_use ();
+		const pgm_time_t now = pgm_time_update_now();
+		for (unsigned i = 0; i < perf_peers; i++)
+			skbs[i] = generate_spm (sock, &tsis[i], 0, 0, now);
+		const pgm_time_t start = pgm_time_update_now();
+		for (unsigned i = 0; i < perf_peers; i++)
+			perf_receive (sock, skbs[i]);
+		elapsed += pgm_time_update_now() - start;
+		memory = heap_in_use () - heap;
+		destroy_sock (sock);
+	}
+	perf_report ("new_peer", elapsed, (guint64)rounds * perf_peers);
+	g_message ("new_peer/%u: %zu bytes per peer", perf_peers, memory / perf_peers);
+	g_free (skbs);
+	g_free (tsis);
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_on_spm (
+ *		pgm_sock_t*		sock,
+ *		pgm_peer_t*		source,
+ *		struct pgm_sk_buff_t*	skb
+ *	)
+ *
+ * heartbeat SPMs from all sources interleaved, each packet a different peer.
+ */
+
+START_TEST (test_spm)
+{
+	pgm_tsi_t* tsis = generate_tsis (perf_peers);
+	struct pgm_sk_buff_t** skbs = g_malloc (perf_peers * sizeof(struct pgm_sk_buff_t*));
+	pgm_sock_t* sock = generate_sock ();
+	const unsigned rounds = MAX(PERF_ITERATIONS / perf_peers, PERF_MIN_ROUNDS);
+	pgm_time_t elapsed = 0;
+
+	generate_peers (sock, tsis, pgm_time_update_now());
+	for (unsigned r = 1; r <= rounds; r++) {
+		const pgm_time_t now = pgm_time_update_now();
+		for (unsigned i = 0; i < perf_peers; i++)
+			skbs[i] = generate_spm (sock, &tsis[i], r, 0, now);
+		const pgm_time_t start = pgm_time_update_now();
+		for (unsigned i = 0; i < perf_peers; i++)
+			perf_receive (sock, skbs[i]);
+		elapsed += pgm_time_update_now() - start;
+	}
+	perf_report ("spm", elapsed, (guint64)rounds * perf_peers);
+	destroy_sock (sock);
+	g_free (skbs);
+	g_free (tsis);
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_on_data (
+ *		pgm_sock_t*		sock,
+ *		pgm_peer_t*		source,
+ *		struct pgm_sk_buff_t*	skb
+ *	)
+ *
+ * one ODATA from every source per round, each packet a different peer, the
+ * windows are drained between rounds untimed.
+ */
+
+START_TEST (test_odata)
+{
+	pgm_tsi_t* tsis = generate_tsis (perf_peers);
+	struct pgm_sk_buff_t** skbs = g_malloc (perf_peers * sizeof(struct pgm_sk_buff_t*));
+	pgm_sock_t* sock = generate_sock ();
+	const unsigned rounds = MAX(PERF_ITERATIONS / perf_peers, PERF_MIN_ROUNDS);
+	pgm_time_t elapsed = 0;
+
+	generate_peers (sock, tsis, pgm_time_update_now());
+	for (unsigned r = 1; r <= rounds; r++) {
+		const pgm_time_t now = pgm_time_update_now();
+		for (unsigned i = 0; i < perf_peers; i++)
+			skbs[i] = generate_odata (sock, &tsis[i], r, now);
+		const pgm_time_t start = pgm_time_update_now();
+		for (unsigned i = 0; i < perf_peers; i++)
+			perf_receive (sock, skbs[i]);
+		elapsed += pgm_time_update_now() - start;
+		perf_drain (sock);
+	}
+	perf_report ("odata", elapsed, (guint64)rounds * perf_peers);
+	destroy_sock (sock);
+	g_free (skbs);
+	g_free (tsis);
+}
+END_TEST
+
+/* target:
+ *	pgm_time_t
+ *	pgm_min_receiver_expiry (
+ *		pgm_sock_t*		sock,
+ *		struct pgm_rx_shard_t*	shard,
+ *		pgm_time_t		expiration
+ *	)
+ *
+ * and pgm_check_peer_state() with no timer due, as run on every wake-up of
+ * the receive loop.
+ */
+
+START_TEST (test_idle_sweep)
+{
+	pgm_tsi_t* tsis = generate_tsis (perf_peers);
+	pgm_sock_t* sock = generate_sock ();
+	const pgm_time_t now = pgm_time_update_now();
+	pgm_time_t start, check;
+
+	generate_peers (sock, tsis, now);
+	pgm_time_t expiration = now + pgm_secs(3600);
+	start = pgm_time_update_now();
+	for (unsigned i = PERF_ITERATIONS; i; i--)
+		expiration = pgm_min_receiver_expiry (sock, sock->rx_shard, expiration + 1);
+	check = pgm_time_update_now();
+	fail_unless (expiration <= now + PERF_PEER_EXPIRY, "min_receiver_expiry failed");
+	perf_report ("min_receiver_expiry", check - start, PERF_ITERATIONS);
+
+	start = pgm_time_update_now();
+	for (unsigned i = PERF_ITERATIONS; i; i--)
+		pgm_check_peer_state (sock, sock->rx_shard, now);
+	check = pgm_time_update_now();
+	fail_unless (perf_peers == sock->rx_shard->peers_heap_len, "peers expired");
+	perf_report ("check_peer_state/idle", check - start, PERF_ITERATIONS);
+	destroy_sock (sock);
+	g_free (tsis);
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_check_peer_state (
+ *		pgm_sock_t*		sock,
+ *		struct pgm_rx_shard_t*	shard,
+ *		const pgm_time_t	now
+ *	)
+ *
+ * one sweep with the timer of every peer due, first the SPM-requests of
+ * sources only seen through ODATA, then the expiry of all peers.  unit time
+ * is per peer.
+ */
+
+START_TEST (test_due_sweep)
+{
+	pgm_tsi_t* tsis = generate_tsis (perf_peers);
+	const unsigned rounds = MAX((PERF_ITERATIONS / 10) / perf_peers, 1);
+	pgm_time_t spmr_elapsed = 0, expiry_elapsed = 0;
+
+	for (unsigned r = 0; r < rounds; r++) {
+		pgm_sock_t* sock = generate_sock ();
+		const pgm_time_t now = pgm_time_update_now();
+		for (unsigned i = 0; i < perf_peers; i++)
+			perf_receive (sock, generate_odata (sock, &tsis[i], 0, now));
+		perf_drain (sock);
+
+		perf_sent = 0;
+		pgm_time_t start = pgm_time_update_now();
+		fail_unless (pgm_check_peer_state (sock, sock->rx_shard, now + PERF_SPMR_EXPIRY), "check_peer_state failed");
+		spmr_elapsed += pgm_time_update_now() - start;
+		fail_unless (perf_peers == perf_sent, "SPMRs missing");
+
+		start = pgm_time_update_now();
+		fail_unless (pgm_check_peer_state (sock, sock->rx_shard, now + PERF_PEER_EXPIRY), "check_peer_state failed");
+		expiry_elapsed += pgm_time_update_now() - start;
+		fail_unless (0 == sock->rx_shard->peers_heap_len, "peers not expired");
+		destroy_sock (sock);
+	}
+	perf_report ("check_peer_state/spmr", spmr_elapsed, (guint64)rounds * perf_peers);
+	perf_report ("check_peer_state/expiry", expiry_elapsed, (guint64)rounds * perf_peers);
+	g_free (tsis);
+}
+END_TEST
+
+static
+Suite*
+make_receiver_suite (void)
+{
+	Suite* s;
+
+	s = suite_create ("Receiver");
+
+	TCase* tc_10 = tcase_create ("10 sources");
+	suite_add_tcase (s, tc_10);
+	tcase_add_checked_fixture (tc_10, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_10, mock_setup_10, NULL);
+	tcase_add_test (tc_10, test_new_peer);
+	tcase_add_test (tc_10, test_spm);
+	tcase_add_test (tc_10, test_odata);
+	tcase_add_test (tc_10, test_idle_sweep);
+	tcase_add_test (tc_10, test_due_sweep);
+
+	TCase* tc_1k = tcase_create ("1k sources");
+	suite_add_tcase (s, tc_1k);
+	tcase_add_checked_fixture (tc_1k, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_1k, mock_setup_1k, NULL);
+	tcase_add_test (tc_1k, test_new_peer);
+	tcase_add_test (tc_1k, test_spm);
+	tcase_add_test (tc_1k, test_odata);
+	tcase_add_test (tc_1k, test_idle_sweep);
+	tcase_add_test (tc_1k, test_due_sweep);
+
+	TCase* tc_10k = tcase_create ("10k sources");
+	suite_add_tcase (s, tc_10k);
+	tcase_add_checked_fixture (tc_10k, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_10k, mock_setup_10k, NULL);
+	tcase_add_test (tc_10k, test_new_peer);
+	tcase_add_test (tc_10k, test_spm);
+	tcase_add_test (tc_10k, test_odata);
+	tcase_add_test (tc_10k, test_idle_sweep);
+	tcase_add_test (tc_10k, test_due_sweep);
+
+	TCase* tc_100k = tcase_create ("100k sources");
+	suite_add_tcase (s, tc_100k);
+	tcase_add_checked_fixture (tc_100k, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_100k, mock_setup_100k, NULL);
+	tcase_set_timeout (tc_100k, 60);
+	tcase_add_test (tc_100k, test_new_peer);
+	tcase_add_test (tc_100k, test_spm);
+	tcase_add_test (tc_100k, test_odata);
+	tcase_add_test (tc_100k, test_idle_sweep);
+	tcase_add_test (tc_100k, test_due_sweep);
+
+	return s;
+}
+
+static
+Suite*
+make_master_suite (void)
+{
+	Suite* s = suite_create ("Master");
+	return s;
+}
+
+int
+main (void)
+{
+	SRunner* sr = srunner_create (make_master_suite ());
+	srunner_add_suite (sr, make_receiver_suite ());
+	srunner_run_all (sr, CK_ENV);
+	int number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* eof */
@@ -57,22 +57,41 @@
 #define pgm_verify_ncf		mock_pgm_verify_ncf
 #define pgm_verify_poll		mock_pgm_verify_poll
 #define pgm_sendto_hops		mock_pgm_sendto_hops
+#define pgm_sendmmsg_to		mock_pgm_sendmmsg_to
 #define pgm_time_now		mock_pgm_time_now
 #define pgm_time_update_now	mock_pgm_time_update_now
+#define pgm_time_wall_now	mock_pgm_time_wall_now
 #define pgm_rxw_destroy		mock_pgm_rxw_destroy
-#define pgm_rxw_create		mock_pgm_rxw_create
+#define pgm_rxw_create_from	mock_pgm_rxw_create_from
+#define pgm_rxw_set_min_length	mock_pgm_rxw_set_min_length
+#define pgm_rxw_prewarm		mock_pgm_rxw_prewarm
 #define pgm_rxw_update		mock_pgm_rxw_update
 #define pgm_rxw_update_fec	mock_pgm_rxw_update_fec
+#define pgm_rxw_join		mock_pgm_rxw_join
 #define pgm_rxw_confirm		mock_pgm_rxw_confirm
 #define pgm_rxw_lost		mock_pgm_rxw_lost
+#define pgm_rxw_nak_rtt		mock_pgm_rxw_nak_rtt
+#define pgm_rxw_expire		mock_pgm_rxw_expire
+#define pgm_rxw_gap_tstamp	mock_pgm_rxw_gap_tstamp
 #define pgm_rxw_state		mock_pgm_rxw_state
+#define pgm_rxw_split		mock_pgm_rxw_split
 #define pgm_rxw_add		mock_pgm_rxw_add
 #define pgm_rxw_remove_commit	mock_pgm_rxw_remove_commit
-#define pgm_rxw_readv		mock_pgm_rxw_readv
+#define pgm_rxw_read		mock_pgm_rxw_read
+#define pgm_rxw_peek		mock_pgm_rxw_peek
+#define pgm_rxw_decode_collect	mock_pgm_rxw_decode_collect
 #define pgm_csum_fold		mock_pgm_csum_fold
 #define pgm_compat_csum_partial	mock_pgm_compat_csum_partial
 #define pgm_histogram_init	mock_pgm_histogram_init
 #define pgm_setsockopt		mock_pgm_setsockopt
+#define pgm_dlr_cache		mock_pgm_dlr_cache
+#define pgm_dlr_destroy		mock_pgm_dlr_destroy
+#define pgm_dlr_send_polr	mock_pgm_dlr_send_polr
+#define pgm_relay_forward	mock_pgm_relay_forward
+#define pgm_relay_forward_spm	mock_pgm_relay_forward_spm
+#define pgm_xdp_filter_remove	mock_pgm_xdp_filter_remove
+#define pgm_stats_ring_rates	mock_pgm_stats_ring_rates
+#define pgm_checkpoint_apply	mock_pgm_checkpoint_apply
 
 
 #define RECEIVER_DEBUG
@@ -91,6 +110,10 @@ struct pgm_sock_t*
 generate_sock (void)
 {
 	struct pgm_sock_t* sock = g_malloc0 (sizeof(struct pgm_sock_t));
+	sock->rx_shard = g_malloc0 (sizeof(struct pgm_rx_shard_t));
+	sock->rx_shard_len = 1;
+	sock->event_sock = INVALID_SOCKET;
+	sock->event_timer_fd = INVALID_SOCKET;
 	return sock;
 }
 
@@ -121,6 +144,7 @@ static
 gboolean
 mock_pgm_on_nak (
 	pgm_sock_t* const		sock,
+	const struct sockaddr* const	src_addr,
 	struct pgm_sk_buff_t* const	skb
 	)
 {
@@ -166,6 +190,37 @@ mock_pgm_sendto_hops (
 	return len;
 }
 
+PGM_GNUC_INTERNAL
+int
+mock_pgm_sendmmsg_to (
+	pgm_sock_t*			sock,
+	bool				use_router_alert,
+	const struct pgm_iovec*		vector,
+	const struct sockaddr*const*	to,
+	unsigned			count
+	)
+{
+	return count;
+}
+
+/** engine module */
+PGM_GNUC_INTERNAL
+void
+pgm_engine_timer_wake (
+	const pgm_time_t		expiration
+	)
+{
+}
+
+/** timer module */
+PGM_GNUC_INTERNAL
+void
+pgm_timer_event_arm (
+	pgm_sock_t* const		sock
+	)
+{
+}
+
 /** time module */
 static pgm_time_t mock_pgm_time_now = 0x1;
 static pgm_time_t _mock_pgm_time_update_now (void);
@@ -177,6 +232,13 @@ _mock_pgm_time_update_now (void)
 	return mock_pgm_time_now;
 }
 
+PGM_GNUC_INTERNAL
+pgm_time_t
+mock_pgm_time_wall_now (void)
+{
+	return mock_pgm_time_now;
+}
+
 /* packet module */
 bool
 mock_pgm_verify_spm (
@@ -212,7 +274,8 @@ mock_pgm_verify_poll (
 
 /* receive window module */
 pgm_rxw_t*
-mock_pgm_rxw_create (
+mock_pgm_rxw_create_from (
+	pgm_mem_slab_t*		slab,
 	const pgm_tsi_t*	tsi,
 	const uint16_t		tpdu_size,
 	const unsigned		sqns,
@@ -224,6 +287,90 @@ mock_pgm_rxw_create (
 	return g_malloc0 (sizeof(pgm_rxw_t));
 }
 
+/** dlr module */
+PGM_GNUC_INTERNAL
+void
+mock_pgm_dlr_cache (
+	pgm_sock_t* const			sock,
+	pgm_peer_t* const			peer,
+	const struct pgm_sk_buff_t* const	skb
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_relay_forward (
+	pgm_sock_t* const			sock,
+	const struct pgm_sk_buff_t* const	skb
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_relay_forward_spm (
+	pgm_sock_t* const			sock,
+	const struct pgm_sk_buff_t* const	skb
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_dlr_destroy (
+	struct pgm_dlr_t* const		dlr
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_dlr_send_polr (
+	pgm_sock_t* const		sock,
+	pgm_peer_t* const		peer,
+	const uint32_t			poll_sqn,
+	const uint16_t			poll_round
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_xdp_filter_remove (
+	pgm_xdp_filter_t* const	filter,
+	const pgm_tsi_t* const	tsi
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+unsigned
+mock_pgm_stats_ring_rates (
+	const struct pgm_stats_ring_t* const restrict ring,
+	const unsigned				      interval,
+	uint64_t*		       const restrict rates
+	)
+{
+	memset (rates, 0, PGM_STATS_RATE_MAX * sizeof (uint64_t));
+	return 0;
+}
+
+/** checkpoint module */
+static pgm_peer_t* mock_checkpoint_peer = NULL;
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_checkpoint_apply (
+	pgm_sock_t* const	sock,
+	pgm_peer_t* const	peer
+	)
+{
+	g_assert (NULL != sock->restore);
+	mock_checkpoint_peer = peer;
+}
+
 void
 mock_pgm_rxw_destroy (
 	pgm_rxw_t* const	window
@@ -233,6 +380,25 @@ mock_pgm_rxw_destroy (
 	g_free (window);
 }
 
+void
+mock_pgm_rxw_set_min_length (
+	pgm_rxw_t* const	window,
+	const unsigned		min_sqns,
+	const bool		can_shrink
+	)
+{
+	g_assert (NULL != window);
+}
+
+size_t
+mock_pgm_rxw_prewarm (
+	pgm_rxw_t* const	window
+	)
+{
+	g_assert (NULL != window);
+	return 0;
+}
+
 int
 mock_pgm_rxw_confirm (
 	pgm_rxw_t* const	window,
@@ -253,15 +419,52 @@ mock_pgm_rxw_lost (
 {
 }
 
+pgm_time_t
+mock_pgm_rxw_nak_rtt (
+	pgm_rxw_t* const	window,
+	const uint32_t		sequence,
+	const pgm_time_t	now
+	)
+{
+	return 0;
+}
+
+uint32_t
+mock_pgm_rxw_expire (
+	pgm_rxw_t* const	window,
+	const pgm_time_t	deadline
+	)
+{
+	return 0;
+}
+
+pgm_time_t
+mock_pgm_rxw_gap_tstamp (
+	const pgm_rxw_t* const	window
+	)
+{
+	return 0;
+}
+
 void
 mock_pgm_rxw_state (
 	pgm_rxw_t* const		window,
-	struct pgm_sk_buff_t* const	skb,
+	pgm_rxw_gap_t* const		gap,
 	const int			new_state
 	)
 {
 }
 
+pgm_rxw_gap_t*
+mock_pgm_rxw_split (
+	pgm_rxw_t* const		window,
+	pgm_rxw_gap_t* const		gap,
+	const uint32_t			sequence
+	)
+{
+	return NULL;
+}
+
 unsigned
 mock_pgm_rxw_update (
 	pgm_rxw_t* const		window,
@@ -282,6 +485,14 @@ mock_pgm_rxw_update_fec (
 {
 }
 
+void
+mock_pgm_rxw_join (
+	pgm_rxw_t* const		window,
+	const uint32_t			first_sqn
+	)
+{
+}
+
 int
 mock_pgm_rxw_add (
 	pgm_rxw_t* const		window,
@@ -300,11 +511,58 @@ mock_pgm_rxw_remove_commit (
 {
 }
 
+/* messages held by every window, negative for more than any vector, each
+ * message one of mock_rxw_skb in turn.
+ */
+static int mock_rxw_msgs = -1;
+static unsigned mock_rxw_sequence = 0;
+static struct pgm_sk_buff_t mock_rxw_skb[4];
+
 ssize_t
-mock_pgm_rxw_readv (
+mock_pgm_rxw_read (
 	pgm_rxw_t* const		window,
-	struct pgm_msgv_t**		pmsg,
-	const unsigned			pmsglen
+	pgm_rxw_cursor_t* const		cursor
+	)
+{
+	ssize_t bytes_read = -1;
+	if (NULL == cursor->skbv)
+		while (!pgm_rxw_cursor_is_full (cursor) && 0 != mock_rxw_msgs) {
+			struct pgm_sk_buff_t* skb = &mock_rxw_skb[ mock_rxw_sequence++ % G_N_ELEMENTS(mock_rxw_skb) ];
+			cursor->msgv->msgv_len = 1;
+			cursor->msgv->msgv_skb[ 0 ] = skb;
+			cursor->msgv++;
+			bytes_read = MAX(bytes_read, 0) + skb->len;
+			if (mock_rxw_msgs > 0)
+				mock_rxw_msgs--;
+		}
+	return bytes_read;
+}
+
+static
+bool
+mock_conflate_key (
+	const struct pgm_msgv_t*	msgv,
+	uint64_t*			key,
+	void*				user_data
+	)
+{
+	*key = (uint64_t)(msgv->msgv_skb[ 0 ] - mock_rxw_skb);
+	return TRUE;
+}
+
+struct pgm_sk_buff_t*
+mock_pgm_rxw_peek (
+	pgm_rxw_t* const		window,
+	const uint32_t			sequence
+	)
+{
+	return NULL;
+}
+
+PGM_GNUC_INTERNAL
+unsigned
+mock_pgm_rxw_decode_collect (
+	pgm_rxw_t* const		window
 	)
 {
 	return 0;
@@ -376,6 +634,58 @@ mock_pgm_setsockopt (
         return TRUE;
 }
 
+/* target:
+ *	pgm_peer_t*
+ *	pgm_new_peer (
+ *		pgm_sock_t*		sock,
+ *		const pgm_tsi_t*	tsi,
+ *		const struct sockaddr*	src_addr,
+ *		const socklen_t		src_addr_len,
+ *		const struct sockaddr*	dst_addr,
+ *		const socklen_t		dst_addr_len,
+ *		const pgm_time_t	now
+ *		)
+ */
+
+/* source of a loaded checkpoint restored before it is shared */
+START_TEST (test_new_peer_pass_001)
+{
+	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	struct sockaddr_in addr = {
+		.sin_family		= AF_INET,
+		.sin_addr.s_addr	= inet_addr ("127.0.0.1")
+	};
+	pgm_sock_t* sock = generate_sock ();
+	pgm_rwlock_init (&sock->peers_lock);
+	sock->rx_shard->peers_table = pgm_peer_table_new (0);
+	sock->restore = g_malloc0 (sizeof(struct pgm_checkpoint_peer_t));
+	sock->restore_len = 1;
+	mock_checkpoint_peer = NULL;
+	pgm_peer_t* peer = pgm_new_peer (sock, &tsi, (struct sockaddr*)&addr, sizeof(addr), (struct sockaddr*)&addr, sizeof(addr), mock_pgm_time_now);
+	fail_if (NULL == peer, "new_peer failed");
+	fail_unless (peer == mock_checkpoint_peer, "checkpoint not applied");
+	fail_unless (peer == pgm_peer_table_lookup (sock->rx_shard->peers_table, &tsi), "peer not inserted");
+}
+END_TEST
+
+/* no checkpoint loaded */
+START_TEST (test_new_peer_pass_002)
+{
+	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	struct sockaddr_in addr = {
+		.sin_family		= AF_INET,
+		.sin_addr.s_addr	= inet_addr ("127.0.0.1")
+	};
+	pgm_sock_t* sock = generate_sock ();
+	pgm_rwlock_init (&sock->peers_lock);
+	sock->rx_shard->peers_table = pgm_peer_table_new (0);
+	mock_checkpoint_peer = NULL;
+	pgm_peer_t* peer = pgm_new_peer (sock, &tsi, (struct sockaddr*)&addr, sizeof(addr), (struct sockaddr*)&addr, sizeof(addr), mock_pgm_time_now);
+	fail_if (NULL == peer, "new_peer failed");
+	fail_unless (NULL == mock_checkpoint_peer, "checkpoint applied");
+}
+END_TEST
+
 /* target:
  *	void
  *	pgm_peer_unref (
@@ -411,6 +721,7 @@ END_TEST
  *	bool
  *	pgm_check_peer_state (
  *		pgm_sock_t*		sock,
+ *		struct pgm_rx_shard_t*	shard,
  *		const pgm_time_t	now
  *		)
  */
@@ -419,13 +730,13 @@ START_TEST (test_check_peer_state_pass_001)
 {
 	pgm_sock_t* sock = generate_sock();
 	sock->is_bound = TRUE;
-	pgm_check_peer_state (sock, mock_pgm_time_now);
+	pgm_check_peer_state (sock, sock->rx_shard, mock_pgm_time_now);
 }
 END_TEST
 
 START_TEST (test_check_peer_state_fail_001)
 {
-	pgm_check_peer_state (NULL, mock_pgm_time_now);
+	pgm_check_peer_state (NULL, NULL, mock_pgm_time_now);
 	fail ("reached");
 }
 END_TEST
@@ -434,6 +745,7 @@ END_TEST
  *	pgm_time_t
  *	pgm_min_receiver_expiry (
  *		pgm_sock_t*		sock,
+ *		struct pgm_rx_shard_t*	shard,
  *		pgm_time_t		expiration
  *		)
  */
@@ -443,14 +755,125 @@ START_TEST (test_min_receiver_expiry_pass_001)
 	pgm_sock_t* sock = generate_sock();
 	sock->is_bound = TRUE;
 	const pgm_time_t expiration = pgm_secs(1);
-	pgm_time_t next_expiration = pgm_min_receiver_expiry (sock, expiration);
+	pgm_time_t next_expiration = pgm_min_receiver_expiry (sock, sock->rx_shard, expiration);
 }
 END_TEST
 
 START_TEST (test_min_receiver_expiry_fail_001)
 {
 	const pgm_time_t expiration = pgm_secs(1);
-	pgm_min_receiver_expiry (NULL, expiration);
+	pgm_min_receiver_expiry (NULL, NULL, expiration);
+	fail ("reached");
+}
+END_TEST
+
+/* target:
+ *	int
+ *	pgm_flush_peers_pending (
+ *		pgm_sock_t*		sock,
+ *		struct pgm_rx_shard_t*	shard,
+ *		pgm_rxw_cursor_t*	cursor,
+ *		size_t*			bytes_read,
+ *		unsigned*		data_read
+ *		)
+ */
+
+/* without a quantum the first peer fills the vector */
+START_TEST (test_flush_peers_pending_pass_001)
+{
+	pgm_sock_t* sock = generate_sock();
+	pgm_peer_t* peer[2] = { generate_peer(), generate_peer() };
+	struct pgm_msgv_t msgv[8];
+	pgm_rxw_cursor_t cursor;
+	size_t bytes_read = 0;
+	unsigned data_read = 0;
+	for (unsigned i = 0; i < G_N_ELEMENTS(peer); i++) {
+		peer[i]->shard = sock->rx_shard;
+		peer[i]->weight = 1;
+		pgm_peer_set_pending (sock, peer[i]);
+	}
+	pgm_rxw_cursor_init_msgv (&cursor, msgv, G_N_ELEMENTS(msgv));
+	fail_unless (-PGM_SOCK_ENOBUFS == pgm_flush_peers_pending (sock, sock->rx_shard, &cursor, &bytes_read, &data_read), "flush_peers_pending failed");
+	fail_unless (1 == data_read, "data_read %u", data_read);
+	fail_unless (peer[1] == sock->rx_shard->peers_pending->data, "peer not drained first");
+}
+END_TEST
+
+/* with a quantum peers take turns in arrival order */
+START_TEST (test_flush_peers_pending_pass_002)
+{
+	pgm_sock_t* sock = generate_sock();
+	pgm_peer_t* peer[2] = { generate_peer(), generate_peer() };
+	struct pgm_msgv_t msgv[8];
+	pgm_rxw_cursor_t cursor;
+	size_t bytes_read = 0;
+	unsigned data_read = 0;
+	sock->recv_quantum = 2;
+	for (unsigned i = 0; i < G_N_ELEMENTS(peer); i++) {
+		peer[i]->shard = sock->rx_shard;
+		peer[i]->weight = 1;
+		pgm_peer_set_pending (sock, peer[i]);
+	}
+	fail_unless (peer[0] == sock->rx_shard->peers_pending->data, "not in arrival order");
+	pgm_rxw_cursor_init_msgv (&cursor, msgv, G_N_ELEMENTS(msgv));
+	fail_unless (-PGM_SOCK_ENOBUFS == pgm_flush_peers_pending (sock, sock->rx_shard, &cursor, &bytes_read, &data_read), "flush_peers_pending failed");
+	fail_unless (4 == data_read, "data_read %u", data_read);
+	fail_unless (peer[1] == sock->rx_shard->peers_pending->data, "peers not rotated");
+	fail_unless (peer[0] == sock->rx_shard->peers_pending_tail->data, "tail not maintained");
+}
+END_TEST
+
+/* priority peers are queued ahead */
+START_TEST (test_flush_peers_pending_pass_003)
+{
+	pgm_sock_t* sock = generate_sock();
+	pgm_peer_t* peer[2] = { generate_peer(), generate_peer() };
+	sock->recv_quantum = 2;
+	for (unsigned i = 0; i < G_N_ELEMENTS(peer); i++) {
+		peer[i]->shard = sock->rx_shard;
+		peer[i]->weight = 1;
+	}
+	peer[1]->is_priority = 1;
+	pgm_peer_set_pending (sock, peer[0]);
+	pgm_peer_set_pending (sock, peer[1]);
+	fail_unless (peer[1] == sock->rx_shard->peers_pending->data, "priority peer not first");
+}
+END_TEST
+
+/* conflation keeps the last message of each key, refilling freed messages */
+START_TEST (test_flush_peers_pending_pass_004)
+{
+	pgm_sock_t* sock = generate_sock();
+	pgm_peer_t* peer = generate_peer();
+	struct pgm_msgv_t msgv[8];
+	pgm_rxw_cursor_t cursor;
+	size_t bytes_read = 0;
+	unsigned data_read = 0;
+	for (unsigned i = 0; i < G_N_ELEMENTS(mock_rxw_skb); i++)
+		mock_rxw_skb[i].len = 1;
+	mock_rxw_msgs = 20;
+	mock_rxw_sequence = 0;
+	sock->conflate_key = mock_conflate_key;
+	peer->shard = sock->rx_shard;
+	peer->weight = 1;
+	pgm_peer_set_pending (sock, peer);
+	pgm_rxw_cursor_init_msgv (&cursor, msgv, G_N_ELEMENTS(msgv));
+	fail_unless (0 == pgm_flush_peers_pending (sock, sock->rx_shard, &cursor, &bytes_read, &data_read), "flush_peers_pending failed");
+	mock_rxw_msgs = -1;
+	fail_unless (4 == bytes_read, "bytes_read %zu", bytes_read);
+	fail_unless (&msgv[4] == cursor.msgv, "messages %td", cursor.msgv - msgv);
+	for (unsigned i = 0; i < 4; i++)
+		fail_unless (&mock_rxw_skb[i] == msgv[i].msgv_skb[0], "message %u out of order", i);
+	fail_unless (16 == peer->cumulative_stats[PGM_PC_RECEIVER_MSGS_CONFLATED], "conflated %" PRIu64, peer->cumulative_stats[PGM_PC_RECEIVER_MSGS_CONFLATED]);
+	fail_unless (16 == sock->rx_shard->conflate_drops, "shard conflated %" PRIu64, sock->rx_shard->conflate_drops);
+}
+END_TEST
+
+START_TEST (test_flush_peers_pending_fail_001)
+{
+	size_t bytes_read = 0;
+	unsigned data_read = 0;
+	pgm_flush_peers_pending (NULL, NULL, NULL, &bytes_read, &data_read);
 	fail ("reached");
 }
 END_TEST
@@ -810,6 +1233,12 @@ make_test_suite (void)
 
 	s = suite_create (__FILE__);
 
+	TCase* tc_new_peer = tcase_create ("new-peer");
+	suite_add_tcase (s, tc_new_peer);
+	tcase_add_checked_fixture (tc_new_peer, mock_setup, NULL);
+	tcase_add_test (tc_new_peer, test_new_peer_pass_001);
+	tcase_add_test (tc_new_peer, test_new_peer_pass_002);
+
 	TCase* tc_peer_unref = tcase_create ("peer_unref");
 	suite_add_tcase (s, tc_peer_unref);
 	tcase_add_checked_fixture (tc_peer_unref, mock_setup, NULL);
@@ -836,6 +1265,17 @@ make_test_suite (void)
 	tcase_add_test_raise_signal (tc_min_receiver_expiry, test_min_receiver_expiry_fail_001, SIGABRT);
 #endif
 
+	TCase* tc_flush_peers_pending = tcase_create ("flush-peers-pending");
+	suite_add_tcase (s, tc_flush_peers_pending);
+	tcase_add_checked_fixture (tc_flush_peers_pending, mock_setup, NULL);
+	tcase_add_test (tc_flush_peers_pending, test_flush_peers_pending_pass_001);
+	tcase_add_test (tc_flush_peers_pending, test_flush_peers_pending_pass_002);
+	tcase_add_test (tc_flush_peers_pending, test_flush_peers_pending_pass_003);
+	tcase_add_test (tc_flush_peers_pending, test_flush_peers_pending_pass_004);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_flush_peers_pending, test_flush_peers_pending_fail_001, SIGABRT);
+#endif
+
 	TCase* tc_set_rxw_sqns = tcase_create ("set-rxw_sqns");
 	suite_add_tcase (s, tc_set_rxw_sqns);
 	tcase_add_checked_fixture (tc_set_rxw_sqns, mock_setup, NULL);
@@ -32,16 +32,36 @@
 #	include <sys/types.h>
 #	include <sys/socket.h>
 #	include <netinet/in.h>		/* _GNU_SOURCE for in6_pktinfo */
+#	include <netinet/udp.h>		/* UDP_GRO */
 #else
 #	include <ws2tcpip.h>
 #	include <mswsock.h>
 #endif
+#ifdef HAVE_EPOLL_CTL
+#	include <sys/epoll.h>
+#elif defined(HAVE_KQUEUE)
+#	include <sys/event.h>
+#endif
 #include <impl/i18n.h>
 #include <impl/framework.h>
 #include <impl/source.h>
 #include <impl/packet_parse.h>
 #include <impl/timer.h>
 #include <impl/engine.h>
+#include <impl/net.h>
+#include <impl/recv.h>
+#include <impl/xdp.h>
+#include <impl/dpdk.h>
+#include <impl/uring.h>
+#include <impl/rio.h>
+#include <impl/replay.h>
+#include <impl/shm.h>
+#include <impl/loop.h>
+#include <impl/shard.h>
+#include <impl/demux.h>
+#include <impl/dlr.h>
+#include <impl/decode.h>
+#include <impl/flightrec.h>
 
 
 //#define RECV_DEBUG
@@ -75,6 +95,588 @@
 #	define pgm_cmsghdr			cmsghdr
 #endif
 
+/* timer deadlines are in microseconds, millisecond waits round up such that a
+ * sub-millisecond deadline does not spin, a negative timeout waits forever.
+ */
+#define WAIT_MSECS(usecs)		((usecs) > 0 ? ((usecs) + 999) / 1000 : (usecs))
+#define WAIT_TIMESPEC(usecs)		{ .tv_sec = (usecs) / 1000000L, .tv_nsec = ((usecs) % 1000000L) * 1000L }
+
+
+#ifndef _WIN32
+typedef struct msghdr			pgm_msghdr_t;
+#else
+typedef WSAMSG				pgm_msghdr_t;
+#endif
+
+/* one batch of messages handed to the application callback */
+struct pgm_recv_async_slot_t {
+	struct pgm_recv_async_t*	async;
+	size_t				len;		/* messages in msgv */
+	int				status;		/* PGM_IO_STATUS_* */
+	struct pgm_msgv_t*		msgv;
+};
+
+/* receive thread of pgm_recv_async_start(), batches in flight on an executor
+ * are counted by free slots and outlive the thread when orphaned by close.
+ */
+struct pgm_recv_async_t {
+#ifndef _WIN32
+	pthread_t			thread;
+#else
+	HANDLE				thread;
+#endif
+	pgm_sock_t*			sock;
+	pgm_recv_callback_t		callback;
+	void*				user_data;
+	pgm_executor_t			executor;
+	void*				executor_data;
+	unsigned			max_msgv;
+	unsigned			max_inflight;
+	pgm_notify_t			notify;		/* wakes thread on stop or returned slot */
+	pgm_mutex_t			mutex;
+	pgm_cond_t			cond;		/* running callbacks finished */
+	unsigned			running;	/* callbacks executing on the executor */
+	bool				is_terminated;
+	bool				is_orphaned;
+	unsigned			free_len;
+	struct pgm_recv_async_slot_t*	slots[];	/* free list */
+};
+
+/* one message or status of the drain ring, the status of a reset, finish or
+ * error passes its error to the reader.
+ */
+struct pgm_recv_drain_entry_t {
+	int				status;		/* PGM_IO_STATUS_NORMAL for a message */
+	pgm_error_t*			error;
+	struct pgm_msgv_t		msgv;		/* holding packet references */
+};
+
+/* kernel drain thread of pgm_recv_drain_start(), single producer of the ring
+ * whilst the application is the single consumer.  the consumer reads entries
+ * up to head and releases them to the producer on its next read, such that
+ * messages stay valid until then.
+ */
+struct pgm_recv_drain_t {
+#ifndef _WIN32
+	pthread_t			thread;
+#else
+	HANDLE				thread;
+#endif
+	pgm_sock_t*			sock;
+	pgm_notify_t			notify;		/* wakes thread on stop or released entries */
+	pgm_notify_t			ready;		/* wakes reader on published entries */
+	pgm_mutex_t			mutex;
+	pgm_cond_t			cond;		/* reader left on stop */
+	bool				is_reading;
+	volatile uint32_t		is_terminated;
+	uint32_t			len;		/* entries, power of two */
+	struct pgm_msgv_t*		batch;		/* of the thread, PGM_RECV_DRAIN_BATCH */
+	char				head_pad[PGM_CACHELINE_PAD];
+	volatile uint32_t		head;		/* published by the thread */
+	char				read_pad[PGM_CACHELINE_PAD - sizeof(uint32_t)];
+	volatile uint32_t		read;		/* read by the reader */
+	volatile uint32_t		tail;		/* released by the reader */
+	char				tail_pad[PGM_CACHELINE_PAD - (2 * sizeof(uint32_t))];
+	struct pgm_recv_drain_entry_t	entries[];
+};
+
+static void recv_thread_wait (pgm_sock_t*const restrict, pgm_notify_t*const restrict, const bool, const long);
+
+#ifdef HAVE_RECVMMSG
+/* size of control buffer per datagram, sufficient for IP_PKTINFO or IPV6_PKTINFO */
+#	define PGM_RECV_BATCH_AUXLEN	256
+
+/* vector of receive buffers filled by one recvmmsg() call and then released
+ * one datagram at a time into the receive buffer of the only shard.
+ */
+struct pgm_recv_batch_t {
+	unsigned			len;		/* datagrams returned by recvmmsg */
+	unsigned			index;		/* next datagram to dispatch */
+	pgm_time_t			tstamp;		/* time of recvmmsg return */
+	struct mmsghdr*			msgvec;
+	struct pgm_iovec*		iov;
+	struct sockaddr_storage*	src;
+	char*				aux;
+	struct pgm_sk_buff_t*		skb[];
+};
+
+static inline
+bool
+is_rx_batch_pending (
+	const pgm_sock_t* const	sock
+	)
+{
+	return (NULL != sock->rx_batch && sock->rx_batch->index < sock->rx_batch->len);
+}
+#else
+#	define is_rx_batch_pending(sock)	(FALSE)
+#endif /* HAVE_RECVMMSG */
+
+#ifdef UDP_GRO
+/* largest coalesced read, maximum UDP payload */
+#	define PGM_RECV_GRO_BUFLEN	65535
+
+/* one coalesced UDP_GRO read of equal sized datagrams from a single source,
+ * released one segment at a time into the receive buffer of the only shard.
+ */
+struct pgm_recv_gro_t {
+	size_t				len;		/* bytes returned by recvmsg */
+	size_t				offset;		/* next segment to dispatch */
+	size_t				segment_len;	/* final segment may be shorter */
+	pgm_time_t			tstamp;		/* time of recvmsg return */
+	pgm_time_t			rx_tstamp;	/* kernel or NIC arrival */
+	struct sockaddr_storage		src;
+	struct sockaddr_storage		dst;
+	char				buf[];
+};
+
+static inline
+bool
+is_rx_gro_pending (
+	const pgm_sock_t* const	sock
+	)
+{
+	return (NULL != sock->rx_gro && sock->rx_gro->offset < sock->rx_gro->len);
+}
+#else
+#	define is_rx_gro_pending(sock)		(FALSE)
+#endif /* UDP_GRO */
+
+#ifdef PGM_HAVE_IO_URING
+static inline
+bool
+is_rx_uring_pending (
+	const pgm_sock_t* const	sock
+	)
+{
+	return (NULL != sock->uring &&
+		*sock->uring->rx.cq_head != __atomic_load_n (sock->uring->rx.cq_tail, __ATOMIC_ACQUIRE));
+}
+#else
+#	define is_rx_uring_pending(sock)	(FALSE)
+#endif /* PGM_HAVE_IO_URING */
+
+#ifndef PGM_HAVE_RIO
+#	define pgm_rio_is_pending(sock)		(FALSE)
+#endif
+#ifndef PGM_HAVE_DPDK
+#	define pgm_dpdk_is_pending(sock)	(FALSE)
+#endif
+
+/* packets read from the socket but not yet dispatched, including those read
+ * by other sockets sharing the receive socket, packets of a same-host
+ * publisher in the shared memory ring, and packets queued by members of the
+ * loopback bus.  a replayed capture is always readable until its end.
+ */
+#define is_rx_pending(sock)	(is_rx_batch_pending (sock) || is_rx_gro_pending (sock) || is_rx_uring_pending (sock) || pgm_rio_is_pending (sock) || pgm_dpdk_is_pending (sock) || pgm_demux_is_pending (sock) || NULL != (sock)->replay || pgm_shm_is_readable ((sock)->shm) || pgm_loop_is_pending (sock))
+
+/* contiguous data waiting on any shard of a sharded receiver.  shards are read
+ * without their locks as a hint, each owner renews the notification under
+ * pending_mutex.
+ */
+static inline
+bool
+is_rx_shard_pending (
+	const pgm_sock_t* const	sock
+	)
+{
+	if (PGM_LIKELY(1 == sock->rx_shard_len))
+		return FALSE;
+	for (unsigned i = 0; i < sock->rx_shard_len; i++)
+		if (NULL != sock->rx_shard[ i ].peers_pending)
+			return TRUE;
+	return FALSE;
+}
+
+#ifdef PGM_LOSS_INJECTION
+/* simulated loss of pgm_loss_rate percent of received packets.  with
+ * pgm_loss_burst set losses follow a two-state Gilbert channel, bursts of
+ * that mean length entered often enough to keep the same long-run rate.
+ */
+static
+bool
+is_simulated_loss (
+	pgm_sock_t* const	sock
+	)
+{
+	if (PGM_LIKELY(0 == pgm_loss_rate))
+		return FALSE;
+	if (pgm_loss_burst > 1) {
+		if (sock->is_loss_burst) {
+			if (0 == pgm_rand_int_range (&sock->rand_, 0, pgm_loss_burst)) {
+				sock->is_loss_burst = FALSE;
+				return FALSE;
+			}
+		} else {
+			const uint32_t enter = (100 == pgm_loss_rate) ? UINT32_MAX :
+				(uint32_t)((pgm_loss_rate * 1000000U) / (pgm_loss_burst * (100 - pgm_loss_rate)));
+			if ((uint32_t)pgm_rand_int_range (&sock->rand_, 0, 1000000) >= enter)
+				return FALSE;
+			sock->is_loss_burst = TRUE;
+		}
+	} else {
+		const unsigned percent = pgm_rand_int_range (&sock->rand_, 0, 100);
+		if (percent > pgm_loss_rate)
+			return FALSE;
+	}
+	pgm_debug ("Simulated packet loss");
+	return TRUE;
+}
+#endif /* PGM_LOSS_INJECTION */
+
+/* allocate receive vector for batched reads, called from pgm_bind() after
+ * max_tpdu is final.  No-op without recvmmsg() or for batch sizes of one.
+ */
+
+void
+pgm_recv_batch_create (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL == sock->rx_batch);
+	pgm_assert_cmpuint (sock->rx_batch_size, <=, PGM_RECV_BATCH_MAX);
+
+#ifdef HAVE_RECVMMSG
+	if (sock->rx_batch_size <= 1)
+		return;
+
+	const unsigned n = sock->rx_batch_size;
+	struct pgm_recv_batch_t* batch = pgm_malloc0 (sizeof(struct pgm_recv_batch_t) + (n * sizeof(struct pgm_sk_buff_t*)));
+	batch->msgvec	= pgm_new0 (struct mmsghdr, n);
+	batch->iov	= pgm_new0 (struct pgm_iovec, n);
+	batch->src	= pgm_new0 (struct sockaddr_storage, n);
+	batch->aux	= pgm_malloc (n * PGM_RECV_BATCH_AUXLEN);
+	for (unsigned i = 0; i < n; i++)
+		batch->skb[i] = pgm_skb_pool_alloc (sock->skb_pool, sock->max_tpdu);
+	sock->rx_batch = batch;
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Receiving up to %u datagrams per system call."), n);
+#else
+	if (sock->rx_batch_size > 1)
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("recvmmsg() unavailable, ignoring receive batch size of %u."), sock->rx_batch_size);
+#endif /* HAVE_RECVMMSG */
+}
+
+void
+pgm_recv_batch_destroy (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+#ifdef HAVE_RECVMMSG
+	struct pgm_recv_batch_t* batch = sock->rx_batch;
+	if (NULL == batch)
+		return;
+	for (unsigned i = 0; i < sock->rx_batch_size; i++)
+		pgm_free_skb (batch->skb[i]);
+	pgm_free (batch->aux);
+	pgm_free (batch->src);
+	pgm_free (batch->iov);
+	pgm_free (batch->msgvec);
+	pgm_free (batch);
+	sock->rx_batch = NULL;
+#endif
+}
+
+/* enable UDP_GRO on the receive socket and allocate the coalescing buffer,
+ * called from pgm_bind().  Kernels without support fall back to reading one
+ * datagram per system call.
+ */
+
+void
+pgm_recv_gro_create (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL == sock->rx_gro);
+	pgm_assert (IPPROTO_UDP == sock->protocol);
+
+#ifdef UDP_GRO
+	const int v = 1;
+	if (SOCKET_ERROR == setsockopt (sock->recv_sock, SOL_UDP, UDP_GRO, (const char*)&v, sizeof (v))) {
+		const int save_errno = pgm_get_last_sock_error();
+		char errbuf[1024];
+		pgm_warn (_("Disabling UDP GRO: %s"),
+			  pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		sock->use_udp_gro = FALSE;
+		return;
+	}
+	sock->rx_gro = pgm_malloc0 (sizeof(struct pgm_recv_gro_t) + PGM_RECV_GRO_BUFLEN);
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Receiving coalesced datagrams with UDP GRO."));
+#else
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("UDP_GRO unavailable, ignoring UDP GRO request."));
+	sock->use_udp_gro = FALSE;
+#endif /* UDP_GRO */
+}
+
+/* request device polling from the kernel for the receive socket, called
+ * from pgm_bind().  Userspace spinning in wait_for_event() proceeds without,
+ * raising SO_BUSY_POLL above net.core.busy_read requires CAP_NET_ADMIN.
+ */
+
+void
+pgm_recv_busy_poll_create (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (sock->busy_poll_usecs > 0);
+
+#ifdef SO_BUSY_POLL
+	const int usecs = (int)sock->busy_poll_usecs;
+	if (SOCKET_ERROR == setsockopt (sock->recv_sock, SOL_SOCKET, SO_BUSY_POLL, (const char*)&usecs, sizeof (usecs))) {
+		const int save_errno = pgm_get_last_sock_error();
+		char errbuf[1024];
+		pgm_warn (_("SO_BUSY_POLL failed, spinning in userspace only: %s"),
+			  pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		return;
+	}
+#	ifdef SO_PREFER_BUSY_POLL
+	const int v = 1;
+	if (SOCKET_ERROR == setsockopt (sock->recv_sock, SOL_SOCKET, SO_PREFER_BUSY_POLL, (const char*)&v, sizeof (v))) {
+		const int save_errno = pgm_get_last_sock_error();
+		char errbuf[1024];
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("SO_PREFER_BUSY_POLL failed: %s"),
+			   pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+	}
+#	endif
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Busy polling receive socket for %u microseconds."), sock->busy_poll_usecs);
+#else
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("SO_BUSY_POLL unavailable, spinning in userspace only."));
+#endif /* SO_BUSY_POLL */
+}
+
+void
+pgm_recv_gro_destroy (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+#ifdef UDP_GRO
+	if (NULL == sock->rx_gro)
+		return;
+	pgm_free (sock->rx_gro);
+	sock->rx_gro = NULL;
+#endif
+}
+
+/* extract the destination address of a received datagram from socket
+ * control messages.
+ *
+ * returns TRUE on success or when no address is present, returns FALSE on
+ * invalid control data.
+ */
+
+static
+bool
+recvdstaddr (
+	pgm_msghdr_t*    const restrict msg,
+	struct sockaddr* const restrict dst_addr
+	)
+{
+	struct pgm_cmsghdr* cmsg;
+	for (cmsg = PGM_CMSG_FIRSTHDR(msg);
+	     cmsg != NULL;
+	     cmsg = PGM_CMSG_NXTHDR(msg, cmsg))
+	{
+/* both IP_PKTINFO and IP_RECVDSTADDR exist on OpenSolaris, so capture
+ * each type if defined.
+ */
+#ifdef IP_PKTINFO
+		if (IPPROTO_IP == cmsg->cmsg_level && 
+		    IP_PKTINFO == cmsg->cmsg_type)
+		{
+			const void* pktinfo		= PGM_CMSG_DATA(cmsg);
+/* discard on invalid address */
+			if (PGM_UNLIKELY(NULL == pktinfo)) {
+				pgm_debug ("in_pktinfo is NULL");
+				return FALSE;
+			}
+			const struct in_pktinfo* in	= pktinfo;
+			struct sockaddr_in s4;
+			memset (&s4, 0, sizeof(s4));
+			s4.sin_family			= AF_INET;
+			s4.sin_addr.s_addr		= in->ipi_addr.s_addr;
+			memcpy (dst_addr, &s4, sizeof(s4));
+			break;
+		}
+#endif
+#ifdef IP_RECVDSTADDR
+		if (IPPROTO_IP == cmsg->cmsg_level &&
+		    IP_RECVDSTADDR == cmsg->cmsg_type)
+		{
+			const void* recvdstaddr		= PGM_CMSG_DATA(cmsg);
+/* discard on invalid address */
+			if (PGM_UNLIKELY(NULL == recvdstaddr)) {
+				pgm_debug ("in_recvdstaddr is NULL");
+				return FALSE;
+			}
+			const struct in_addr* in	= recvdstaddr;
+			struct sockaddr_in s4;
+			memset (&s4, 0, sizeof(s4));
+			s4.sin_family			= AF_INET;
+			s4.sin_addr.s_addr		= in->s_addr;
+			memcpy (dst_addr, &s4, sizeof(s4));
+			break;
+		}
+#endif
+#if !defined(IP_PKTINFO) && !defined(IP_RECVDSTADDR)
+#	error "No defined CMSG type for IPv4 destination address."
+#endif
+
+		if (IPPROTO_IPV6 == cmsg->cmsg_level && 
+		    IPV6_PKTINFO == cmsg->cmsg_type)
+		{
+			const void* pktinfo		= PGM_CMSG_DATA(cmsg);
+/* discard on invalid address */
+			if (PGM_UNLIKELY(NULL == pktinfo)) {
+				pgm_debug ("in6_pktinfo is NULL");
+				return FALSE;
+			}
+			const struct in6_pktinfo* in6	= pktinfo;
+			struct sockaddr_in6 s6;
+			memset (&s6, 0, sizeof(s6));
+			s6.sin6_family			= AF_INET6;
+			s6.sin6_addr			= in6->ipi6_addr;
+			s6.sin6_scope_id		= in6->ipi6_ifindex;
+			memcpy (dst_addr, &s6, sizeof(s6));
+/* does not set flow id */
+			break;
+		}
+	}
+	return TRUE;
+}
+
+#ifdef PGM_HAVE_RX_TIMESTAMP
+/* back-date a local time stamp by the queueing delay since arrival such that
+ * NAK timers start from the wire, ignoring delays beyond a second as from an
+ * unsynchronized NIC clock.
+ */
+
+static inline
+pgm_time_t
+rx_tstamp_adjust (
+	const pgm_time_t	tstamp,
+	const pgm_time_t	rx_tstamp
+	)
+{
+	if (0 == rx_tstamp)
+		return tstamp;
+	const pgm_time_t delay = pgm_rx_wall_now() - rx_tstamp;
+	if (delay > pgm_secs(1) || delay >= tstamp)
+		return tstamp;
+	return tstamp - delay;
+}
+#endif
+
+#ifdef SO_INCOMING_CPU
+/* record the CPU on which the kernel received a recent packet of the shard,
+ * once per auto-tuning interval.  caller holds the shard mutex.
+ */
+
+static
+void
+rx_cpu_sample (
+	pgm_sock_t*		const restrict sock,
+	struct pgm_rx_shard_t*	const restrict shard
+	)
+{
+	const pgm_time_t now = pgm_time_coarse_now();
+	if (pgm_time_after (shard->rx_cpu_expiry, now))
+		return;
+	shard->rx_cpu_expiry = now + PGM_RX_TUNE_IVL;
+
+	const SOCKET s = sock->rx_shard_len > 1 ? pgm_recv_shard_sock (sock, shard->index) : pgm_recv_shard_sock (sock, sock->recv_shard_next);
+	int cpu;
+	socklen_t cpulen = sizeof (cpu);
+	if (0 == getsockopt (s, SOL_SOCKET, SO_INCOMING_CPU, (char*)&cpu, &cpulen))
+		shard->rx_cpu = cpu;
+}
+#endif /* SO_INCOMING_CPU */
+
+/* close a receive auto-tuning sample of a shard once per interval.  the
+ * kernel receive buffer doubles on drops and decays by an eighth while idle
+ * above the span of the observed rate, the receive windows of the shard's
+ * peers hold rx_tune_rxw_secs of that rate, both within the configured
+ * bounds.  the rate rises at once and falls by a quarter per sample.  caller
+ * holds the shard mutex.
+ */
+
+static
+void
+rx_tune (
+	pgm_sock_t*		const restrict sock,
+	struct pgm_rx_shard_t*	const restrict shard,
+	const size_t			       bytes_received
+	)
+{
+	const pgm_time_t now = pgm_time_coarse_now();
+
+	shard->rx_tune_bytes += bytes_received;
+	if (0 == shard->rx_tune_expiry) {
+		shard->rx_tune_expiry = now + PGM_RX_TUNE_IVL;
+		shard->rx_tune_bytes  = 0;
+		return;
+	}
+	if (pgm_time_after (shard->rx_tune_expiry, now))
+		return;
+
+	const pgm_time_t elapsed = PGM_RX_TUNE_IVL + (now - shard->rx_tune_expiry);
+	const uint64_t rate = ((uint64_t)shard->rx_tune_bytes * pgm_secs(1)) / elapsed;
+	const uint32_t drops = shard->rx_tune_ovfl - shard->rx_tune_ovfl_last;
+	shard->rx_tune_rate = (uint32_t)MIN(UINT32_MAX, rate > shard->rx_tune_rate ? rate : (3 * (uint64_t)shard->rx_tune_rate + rate) / 4);
+	shard->rx_tune_ovfl_last = shard->rx_tune_ovfl;
+	shard->rx_tune_drops += drops;
+	shard->rx_tune_bytes  = 0;
+	shard->rx_tune_expiry = now + PGM_RX_TUNE_IVL;
+
+/* kernel receive buffer */
+	size_t rcvbuf = shard->rx_tune_rcvbuf;
+	if (drops > 0) {
+		rcvbuf = MIN(2 * rcvbuf, sock->rx_tune_rcvbuf_max);
+	} else {
+		const size_t floor = MAX(sock->rx_tune_rcvbuf_min, shard->rx_tune_rate / 4);
+		if (rcvbuf > 2 * floor)
+			rcvbuf -= rcvbuf / 8;
+	}
+	if (rcvbuf != shard->rx_tune_rcvbuf &&
+	    pgm_rx_tune_rcvbuf (sock, shard, rcvbuf))
+	{
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Receive buffer tuned to %" PRIzu " bytes on %" PRIu32 " drops at %" PRIu32 " bytes per second."),
+			   rcvbuf, drops, shard->rx_tune_rate);
+		shard->rx_tune_rcvbuf = rcvbuf;
+	}
+
+/* receive windows, resized beyond an eighth of change */
+	if (0 == sock->rx_tune_rxw_max_sqns)
+		return;
+	uint64_t sqns = ((uint64_t)shard->rx_tune_rate * sock->rx_tune_rxw_secs) / sock->max_tpdu;
+	sqns = MIN(MAX(sqns, sock->rx_tune_rxw_min_sqns), sock->rx_tune_rxw_max_sqns);
+	const unsigned hysteresis = shard->rx_tune_sqns / 8;
+	if (0 != shard->rx_tune_sqns &&
+	    sqns + hysteresis >= shard->rx_tune_sqns &&
+	    sqns <= shard->rx_tune_sqns + hysteresis)
+		return;
+	shard->rx_tune_sqns = (unsigned)sqns;
+	sock->rxw_sqns = shard->rx_tune_sqns;		/* new peers */
+	pgm_rwlock_reader_lock (&sock->peers_lock);
+	for (pgm_list_t* list = sock->peers_list; NULL != list; list = list->next) {
+		pgm_peer_t* peer = list->data;
+		if (peer->shard == shard)
+			pgm_rxw_set_max_length (peer->window, shard->rx_tune_sqns);
+	}
+	pgm_rwlock_reader_unlock (&sock->peers_lock);
+	pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Receive window tuned to %u sequences at %" PRIu32 " bytes per second."),
+		   shard->rx_tune_sqns, shard->rx_tune_rate);
+}
 
 /* read a packet into a PGM skbuff
  * on success returns packet length, on closed socket returns 0,
@@ -86,6 +688,7 @@ ssize_t
 recvskb (
 	pgm_sock_t*           const restrict sock,
 	struct pgm_sk_buff_t* const restrict skb,
+	const unsigned			     shard,
 	const int			     flags,
 	struct sockaddr*      const restrict src_addr,
 	const socklen_t			     src_addrlen,
@@ -101,8 +704,8 @@ recvskb (
 	pgm_assert (NULL != dst_addr);
 	pgm_assert (dst_addrlen > 0);
 
-	pgm_debug ("recvskb (sock:%p skb:%p flags:%d src-addr:%p src-addrlen:%d dst-addr:%p dst-addrlen:%d)",
-		(void*)sock, (void*)skb, flags, (void*)src_addr, (int)src_addrlen, (void*)dst_addr, (int)dst_addrlen);
+	pgm_debug ("recvskb (sock:%p skb:%p shard:%u flags:%d src-addr:%p src-addrlen:%d dst-addr:%p dst-addrlen:%d)",
+		(void*)sock, (void*)skb, shard, flags, (void*)src_addr, (int)src_addrlen, (void*)dst_addr, (int)dst_addrlen);
 
 	if (PGM_UNLIKELY(sock->is_destroyed))
 		return 0;
@@ -122,7 +725,18 @@ recvskb (
 		.msg_controllen = sizeof(aux),
 		.msg_flags	= 0
 	};
+#ifdef PGM_HAVE_RECV_SHARDS
+/* a receiver per shard reads only its own socket, otherwise fan in */
+	ssize_t len;
+	if (sock->rx_shard_len > 1)
+		len = recvmsg (pgm_recv_shard_sock (sock, shard), &msg, flags);
+	else if (sock->recv_shards > 1)
+		len = pgm_recv_shards_recvmsg (sock, &msg, flags);
+	else
+		len = recvmsg (sock->recv_sock, &msg, flags);
+#else
 	ssize_t len = recvmsg (sock->recv_sock, &msg, flags);
+#endif
 	if (len <= 0)
 		return len;
 #else /* !_WIN32 */
@@ -141,128 +755,411 @@ recvskb (
 	}
 #endif /* !_WIN32 */
 
-#ifdef PGM_DEBUG
-	if (PGM_UNLIKELY(pgm_loss_rate > 0)) {
-		const unsigned percent = pgm_rand_int_range (&sock->rand_, 0, 100);
-		if (percent <= pgm_loss_rate) {
-			pgm_debug ("Simulated packet loss");
-			pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
-			return SOCKET_ERROR;
-		}
+#ifdef PGM_LOSS_INJECTION
+	if (PGM_UNLIKELY(is_simulated_loss (sock))) {
+		pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+		return SOCKET_ERROR;
 	}
 #endif
 
 	skb->sock		= sock;
-	skb->tstamp		= pgm_time_update_now();
+	skb->tstamp		= pgm_time_coarse_now();
+	skb->rx_tstamp		= 0;
 	skb->data		= skb->head;
 	skb->len		= (uint16_t)len;
 	skb->zero_padded	= 0;
 	skb->tail		= (char*)skb->data + len;
-
-	if (sock->udp_encap_ucast_port ||
-	    AF_INET6 == pgm_sockaddr_family (src_addr))
-	{
-		struct pgm_cmsghdr* cmsg;
-		for (cmsg = PGM_CMSG_FIRSTHDR(&msg);
-		     cmsg != NULL;
-		     cmsg = PGM_CMSG_NXTHDR(&msg, cmsg))
-		{
-/* both IP_PKTINFO and IP_RECVDSTADDR exist on OpenSolaris, so capture
- * each type if defined.
- */
-#ifdef IP_PKTINFO
-			if (IPPROTO_IP == cmsg->cmsg_level && 
-			    IP_PKTINFO == cmsg->cmsg_type)
-			{
-				const void* pktinfo		= PGM_CMSG_DATA(cmsg);
-/* discard on invalid address */
-				if (PGM_UNLIKELY(NULL == pktinfo)) {
-					pgm_debug ("in_pktinfo is NULL");
-					return -1;
-				}
-				const struct in_pktinfo* in	= pktinfo;
-				struct sockaddr_in s4;
-				memset (&s4, 0, sizeof(s4));
-				s4.sin_family			= AF_INET;
-				s4.sin_addr.s_addr		= in->ipi_addr.s_addr;
-				memcpy (dst_addr, &s4, sizeof(s4));
-				break;
-			}
-#endif
-#ifdef IP_RECVDSTADDR
-			if (IPPROTO_IP == cmsg->cmsg_level &&
-			    IP_RECVDSTADDR == cmsg->cmsg_type)
-			{
-				const void* recvdstaddr		= PGM_CMSG_DATA(cmsg);
-/* discard on invalid address */
-				if (PGM_UNLIKELY(NULL == recvdstaddr)) {
-					pgm_debug ("in_recvdstaddr is NULL");
-					return -1;
-				}
-				const struct in_addr* in	= recvdstaddr;
-				struct sockaddr_in s4;
-				memset (&s4, 0, sizeof(s4));
-				s4.sin_family			= AF_INET;
-				s4.sin_addr.s_addr		= in->s_addr;
-				memcpy (dst_addr, &s4, sizeof(s4));
-				break;
-			}
+#if defined(PGM_HAVE_RX_TIMESTAMP) && !defined(_WIN32)
+	if (sock->use_rx_timestamp) {
+		skb->rx_tstamp	= pgm_rx_timestamp (&msg);
+		skb->tstamp	= rx_tstamp_adjust (skb->tstamp, skb->rx_tstamp);
+	}
 #endif
-#if !defined(IP_PKTINFO) && !defined(IP_RECVDSTADDR)
-#	error "No defined CMSG type for IPv4 destination address."
+#if defined(PGM_HAVE_RXQ_OVFL) && !defined(_WIN32)
+	if (sock->use_rxq_ovfl)
+		pgm_rxq_ovfl (&msg, &sock->rx_shard[ shard ].rx_tune_ovfl);
 #endif
 
-			if (IPPROTO_IPV6 == cmsg->cmsg_level && 
-			    IPV6_PKTINFO == cmsg->cmsg_type)
-			{
-				const void* pktinfo		= PGM_CMSG_DATA(cmsg);
-/* discard on invalid address */
-				if (PGM_UNLIKELY(NULL == pktinfo)) {
-					pgm_debug ("in6_pktinfo is NULL");
-					return -1;
-				}
-				const struct in6_pktinfo* in6	= pktinfo;
-				struct sockaddr_in6 s6;
-				memset (&s6, 0, sizeof(s6));
-				s6.sin6_family			= AF_INET6;
-				s6.sin6_addr			= in6->ipi6_addr;
-				s6.sin6_scope_id		= in6->ipi6_ifindex;
-				memcpy (dst_addr, &s6, sizeof(s6));
-/* does not set flow id */
-				break;
-			}
-		}
+	if (sock->udp_encap_ucast_port ||
+	    pgm_is_inet6 (pgm_sockaddr_family (src_addr)))
+	{
+		if (PGM_UNLIKELY(!recvdstaddr (&msg, dst_addr)))
+			return -1;
 	}
 	return len;
 }
 
-/* upstream = receiver to source, peer-to-peer = receive to receiver
- *
- * NB: SPMRs can be upstream or peer-to-peer, if the packet is multicast then its
- *     a peer-to-peer message, if its unicast its an upstream message.
+#ifdef HAVE_RECVMMSG
+/* read the next packet of a receive batch into sock::rx_buffer, refilling
+ * the batch with one recvmmsg() call when exhausted.  The filled buffer is
+ * exchanged with the current sock::rx_buffer so that ownership semantics
+ * match recvskb(): a buffer taken by the receive window is replaced by
+ * on_downstream(), otherwise it is recycled on the next read.
  *
- * returns TRUE on valid processed packet, returns FALSE on discarded packet.
+ * on success returns packet length, on closed socket returns 0,
+ * on error returns -1.
  */
 
 static
-bool
-on_upstream (
+ssize_t
+recvmmskb (
 	pgm_sock_t*           const restrict sock,
-	struct pgm_sk_buff_t* const restrict skb
+	const int			     flags,
+	struct sockaddr*      const restrict src_addr,
+	const socklen_t			     src_addrlen,
+	struct sockaddr*      const restrict dst_addr,
+	const socklen_t			     dst_addrlen
 	)
 {
+	struct pgm_recv_batch_t* batch = sock->rx_batch;
+
 /* pre-conditions */
 	pgm_assert (NULL != sock);
-	pgm_assert (NULL != skb);
-	pgm_assert_cmpuint (skb->pgm_header->pgm_dport, ==, sock->tsi.sport);
+	pgm_assert (NULL != batch);
+	pgm_assert (NULL != src_addr);
+	pgm_assert (src_addrlen > 0);
+	pgm_assert (NULL != dst_addr);
+	pgm_assert (dst_addrlen > 0);
 
-	pgm_debug ("on_upstream (sock:%p skb:%p)",
-		(const void*)sock, (const void*)skb);
+	pgm_debug ("recvmmskb (sock:%p flags:%d src-addr:%p src-addrlen:%d dst-addr:%p dst-addrlen:%d)",
+		(void*)sock, flags, (void*)src_addr, (int)src_addrlen, (void*)dst_addr, (int)dst_addrlen);
 
-	if (PGM_UNLIKELY(!sock->can_send_data)) {
-		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded packet for muted source."));
-		goto out_discarded;
-	}
+	if (PGM_UNLIKELY(sock->is_destroyed))
+		return 0;
+
+#ifdef PGM_LOSS_INJECTION
+again:
+#endif
+	if (batch->index == batch->len)
+	{
+		for (unsigned i = 0; i < sock->rx_batch_size; i++) {
+			struct msghdr* msg	= &batch->msgvec[i].msg_hdr;
+			batch->iov[i].iov_base	= batch->skb[i]->head;
+			batch->iov[i].iov_len	= sock->max_tpdu;
+			msg->msg_name		= &batch->src[i];
+			msg->msg_namelen	= sizeof(struct sockaddr_storage);
+			msg->msg_iov		= (void*)&batch->iov[i];
+			msg->msg_iovlen		= 1;
+			msg->msg_control	= batch->aux + (i * PGM_RECV_BATCH_AUXLEN);
+			msg->msg_controllen	= PGM_RECV_BATCH_AUXLEN;
+			msg->msg_flags		= 0;
+		}
+		batch->len = batch->index = 0;
+		const int count = recvmmsg (sock->recv_sock, batch->msgvec, sock->rx_batch_size, flags, NULL);
+		if (count <= 0)
+			return count;
+		batch->len	= count;
+		batch->tstamp	= pgm_time_refresh();
+
+/* checksum the whole batch before dispatching the first datagram */
+		for (int j = 0; j < count; j++) {
+			batch->skb[j]->data = batch->skb[j]->head;
+			batch->skb[j]->len  = (uint16_t)batch->msgvec[j].msg_len;
+		}
+		pgm_parse_csum_batch (batch->skb, count, !(sock->udp_encap_ucast_port || pgm_is_inet6 (sock->family)));
+	}
+
+	const unsigned i = batch->index++;
+	struct msghdr* msg = &batch->msgvec[i].msg_hdr;
+	const ssize_t len  = batch->msgvec[i].msg_len;
+
+/* zero length datagram reads as a closed socket as per recvmsg() */
+	if (PGM_UNLIKELY(0 == len))
+		return 0;
+
+#ifdef PGM_LOSS_INJECTION
+	if (PGM_UNLIKELY(is_simulated_loss (sock)))
+		goto again;
+#endif
+
+	struct pgm_sk_buff_t* skb = batch->skb[i];
+	batch->skb[i]		= sock->rx_shard->rx_buffer;
+	sock->rx_shard->rx_buffer = skb;
+
+	memcpy (src_addr, msg->msg_name, MIN(src_addrlen, msg->msg_namelen));
+
+	skb->sock		= sock;
+	skb->tstamp		= batch->tstamp;
+	skb->rx_tstamp		= 0;
+	skb->data		= skb->head;
+	skb->len		= (uint16_t)len;
+	skb->zero_padded	= 0;
+	skb->tail		= (char*)skb->data + len;
+#ifdef PGM_HAVE_RX_TIMESTAMP
+	if (sock->use_rx_timestamp) {
+		skb->rx_tstamp	= pgm_rx_timestamp (msg);
+		skb->tstamp	= rx_tstamp_adjust (skb->tstamp, skb->rx_tstamp);
+	}
+#endif
+#ifdef PGM_HAVE_RXQ_OVFL
+	if (sock->use_rxq_ovfl)
+		pgm_rxq_ovfl (msg, &sock->rx_shard->rx_tune_ovfl);
+#endif
+
+	if (sock->udp_encap_ucast_port ||
+	    pgm_is_inet6 (pgm_sockaddr_family (src_addr)))
+	{
+		if (PGM_UNLIKELY(!recvdstaddr (msg, dst_addr)))
+			return -1;
+	}
+	return len;
+}
+#endif /* HAVE_RECVMMSG */
+
+#ifdef UDP_GRO
+/* read the next segment of a UDP_GRO coalesced buffer into sock::rx_buffer,
+ * refilling the buffer with one recvmsg() call when exhausted.  Without a
+ * UDP_GRO control message the read is a single datagram.  Segments longer
+ * than max_tpdu are truncated as per recvskb().
+ *
+ * on success returns packet length, on closed socket returns 0,
+ * on error returns -1.
+ */
+
+static
+ssize_t
+recvgroskb (
+	pgm_sock_t*           const restrict sock,
+	const int			     flags,
+	struct sockaddr*      const restrict src_addr,
+	const socklen_t			     src_addrlen,
+	struct sockaddr*      const restrict dst_addr,
+	const socklen_t			     dst_addrlen
+	)
+{
+	struct pgm_recv_gro_t* gro = sock->rx_gro;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != gro);
+	pgm_assert (NULL != src_addr);
+	pgm_assert (src_addrlen > 0);
+	pgm_assert (NULL != dst_addr);
+	pgm_assert (dst_addrlen > 0);
+
+	pgm_debug ("recvgroskb (sock:%p flags:%d src-addr:%p src-addrlen:%d dst-addr:%p dst-addrlen:%d)",
+		(void*)sock, flags, (void*)src_addr, (int)src_addrlen, (void*)dst_addr, (int)dst_addrlen);
+
+	if (PGM_UNLIKELY(sock->is_destroyed))
+		return 0;
+
+#ifdef PGM_LOSS_INJECTION
+again:
+#endif
+	if (gro->offset == gro->len)
+	{
+		struct pgm_iovec iov = {
+			.iov_base	= gro->buf,
+			.iov_len	= PGM_RECV_GRO_BUFLEN
+		};
+		char aux[ 1024 ];
+		struct msghdr msg = {
+			.msg_name	= &gro->src,
+			.msg_namelen	= sizeof(gro->src),
+			.msg_iov	= (void*)&iov,
+			.msg_iovlen	= 1,
+			.msg_control	= aux,
+			.msg_controllen = sizeof(aux),
+			.msg_flags	= 0
+		};
+		gro->len = gro->offset = 0;
+		const ssize_t len = recvmsg (sock->recv_sock, &msg, flags);
+		if (len <= 0)
+			return len;
+		gro->tstamp = pgm_time_refresh();
+
+		int segment_len = 0;
+		struct cmsghdr* cmsg;
+		for (cmsg = CMSG_FIRSTHDR(&msg);
+		     cmsg != NULL;
+		     cmsg = CMSG_NXTHDR(&msg, cmsg))
+		{
+			if (SOL_UDP == cmsg->cmsg_level &&
+			    UDP_GRO == cmsg->cmsg_type)
+			{
+				memcpy (&segment_len, CMSG_DATA(cmsg), sizeof (segment_len));
+				break;
+			}
+		}
+		if (segment_len <= 0 || segment_len > len)
+			segment_len = (int)len;
+
+		memset (&gro->dst, 0, sizeof(gro->dst));
+		if (sock->udp_encap_ucast_port ||
+		    pgm_is_inet6 (pgm_sockaddr_family ((struct sockaddr*)&gro->src)))
+		{
+			if (PGM_UNLIKELY(!recvdstaddr (&msg, (struct sockaddr*)&gro->dst)))
+				return -1;
+		}
+		gro->rx_tstamp = 0;
+#ifdef PGM_HAVE_RX_TIMESTAMP
+		if (sock->use_rx_timestamp) {
+			gro->rx_tstamp = pgm_rx_timestamp (&msg);
+			gro->tstamp    = rx_tstamp_adjust (gro->tstamp, gro->rx_tstamp);
+		}
+#endif
+#ifdef PGM_HAVE_RXQ_OVFL
+		if (sock->use_rxq_ovfl)
+			pgm_rxq_ovfl (&msg, &sock->rx_shard->rx_tune_ovfl);
+#endif
+		gro->segment_len = segment_len;
+		gro->len	 = len;
+	}
+
+	const char* segment = gro->buf + gro->offset;
+	const size_t segment_len = MIN(gro->segment_len, gro->len - gro->offset);
+	gro->offset += segment_len;
+
+#ifdef PGM_LOSS_INJECTION
+	if (PGM_UNLIKELY(is_simulated_loss (sock)))
+		goto again;
+#endif
+
+	const uint16_t len = (uint16_t)MIN(segment_len, sock->max_tpdu);
+	struct pgm_sk_buff_t* skb = sock->rx_shard->rx_buffer;
+	memcpy (skb->head, segment, len);
+
+	memcpy (src_addr, &gro->src, MIN(src_addrlen, sizeof(gro->src)));
+	memcpy (dst_addr, &gro->dst, MIN(dst_addrlen, sizeof(gro->dst)));
+
+	skb->sock		= sock;
+	skb->tstamp		= gro->tstamp;
+	skb->rx_tstamp		= gro->rx_tstamp;
+	skb->data		= skb->head;
+	skb->len		= len;
+	skb->zero_padded	= 0;
+	skb->tail		= (char*)skb->data + len;
+	return len;
+}
+#endif /* UDP_GRO */
+
+#ifdef PGM_HAVE_IO_URING
+/* read the next completion of the io_uring multishot receive into the
+ * receive buffer of the only shard, destination address as per recvskb().
+ *
+ * on success returns packet length, on closed socket returns 0,
+ * on error returns -1.
+ */
+
+static
+ssize_t
+recvuringskb (
+	pgm_sock_t*           const restrict sock,
+	struct sockaddr*      const restrict src_addr,
+	const socklen_t			     src_addrlen,
+	struct sockaddr*      const restrict dst_addr,
+	const socklen_t			     dst_addrlen
+	)
+{
+	struct msghdr ctl;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != dst_addr);
+	pgm_assert (dst_addrlen > 0);
+
+	const ssize_t len = pgm_uring_recvskb (sock, src_addr, src_addrlen, &ctl);
+	if (len <= 0)
+		return len;
+
+#ifdef PGM_LOSS_INJECTION
+	if (PGM_UNLIKELY(is_simulated_loss (sock))) {
+		pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+		return SOCKET_ERROR;
+	}
+#endif
+
+	if (sock->udp_encap_ucast_port ||
+	    pgm_is_inet6 (pgm_sockaddr_family (src_addr)))
+	{
+		if (PGM_UNLIKELY(!recvdstaddr (&ctl, dst_addr)))
+			return -1;
+	}
+	return len;
+}
+#endif /* PGM_HAVE_IO_URING */
+
+#ifdef PGM_HAVE_RIO
+/* read the next Registered I/O receive completion into the receive buffer of
+ * the only shard, destination address as per recvskb().
+ *
+ * on success returns packet length, on closed socket returns 0,
+ * on error returns -1.
+ */
+
+static
+ssize_t
+recvrioskb (
+	pgm_sock_t*           const restrict sock,
+	struct sockaddr*      const restrict src_addr,
+	const socklen_t			     src_addrlen,
+	struct sockaddr*      const restrict dst_addr,
+	const socklen_t			     dst_addrlen
+	)
+{
+	WSAMSG ctl;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != dst_addr);
+	pgm_assert (dst_addrlen > 0);
+
+	const ssize_t len = pgm_rio_recvskb (sock, src_addr, src_addrlen, &ctl);
+	if (len <= 0)
+		return len;
+
+#ifdef PGM_LOSS_INJECTION
+	if (PGM_UNLIKELY(is_simulated_loss (sock))) {
+		pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+		return SOCKET_ERROR;
+	}
+#endif
+
+	if (sock->udp_encap_ucast_port ||
+	    pgm_is_inet6 (pgm_sockaddr_family (src_addr)))
+	{
+		if (PGM_UNLIKELY(!recvdstaddr (&ctl, dst_addr)))
+			return -1;
+	}
+	return len;
+}
+#endif /* PGM_HAVE_RIO */
+
+/* upstream = receiver to source, peer-to-peer = receive to receiver
+ *
+ * NB: SPMRs can be upstream or peer-to-peer, if the packet is multicast then its
+ *     a peer-to-peer message, if its unicast its an upstream message.
+ *
+ * returns TRUE on valid processed packet, returns FALSE on discarded packet.
+ */
+
+static
+bool
+on_upstream (
+	pgm_sock_t*           const restrict sock,
+	struct pgm_sk_buff_t* const restrict skb,
+	struct sockaddr*      const restrict src_addr
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != skb);
+	pgm_assert (NULL != src_addr);
+	pgm_assert_cmpuint (skb->pgm_header->pgm_dport, ==, sock->tsi.sport);
+
+	pgm_debug ("on_upstream (sock:%p skb:%p)",
+		(const void*)sock, (const void*)skb);
+
+	if (PGM_UNLIKELY(!sock->can_send_data)) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded packet for muted source."));
+		goto out_discarded;
+	}
+
+/* the primary answers until takeover */
+	if (PGM_UNLIKELY(sock->is_standby)) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded packet for standby source."));
+		goto out_discarded;
+	}
 
 /* unicast upstream message, note that dport & sport are reversed */
 	if (PGM_UNLIKELY(skb->pgm_header->pgm_sport != sock->dport)) {
@@ -283,7 +1180,7 @@ on_upstream (
 
 	switch (skb->pgm_header->pgm_type) {
 	case PGM_NAK:
-		if (PGM_UNLIKELY(!pgm_on_nak (sock, skb)))
+		if (PGM_UNLIKELY(!pgm_on_nak (sock, src_addr, skb)))
 			goto out_discarded;
 		break;
 
@@ -303,6 +1200,10 @@ on_upstream (
 		break;
 
 	case PGM_POLR:
+		if (PGM_UNLIKELY(!pgm_on_polr (sock, skb)))
+			goto out_discarded;
+		break;
+
 	default:
 		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded unsupported PGM type packet."));
 		goto out_discarded;
@@ -322,13 +1223,17 @@ out_discarded:
 static
 bool
 on_peer (
-	pgm_sock_t*           const restrict sock,
-	struct pgm_sk_buff_t* const restrict skb,
-	pgm_peer_t**		    restrict source
+	pgm_sock_t*            const restrict sock,
+	struct pgm_rx_shard_t* const restrict shard,
+	struct pgm_sk_buff_t*  const restrict skb,
+	const struct sockaddr* const restrict src_addr,
+	const struct sockaddr* const restrict dst_addr,
+	pgm_peer_t**		     restrict source
 	)
 {
 /* pre-conditions */
 	pgm_assert (NULL != sock);
+	pgm_assert (NULL != shard);
 	pgm_assert (NULL != skb);
 	pgm_assert_cmpuint (skb->pgm_header->pgm_dport, !=, sock->tsi.sport);
 	pgm_assert (NULL != source);
@@ -354,9 +1259,7 @@ on_peer (
 	memcpy (&upstream_tsi.gsi, &skb->tsi.gsi, sizeof(pgm_gsi_t));
 	upstream_tsi.sport = skb->pgm_header->pgm_dport;
 
-	pgm_rwlock_reader_lock (&sock->peers_lock);
-	*source = pgm_hashtable_lookup (sock->peers_hashtable, &upstream_tsi);
-	pgm_rwlock_reader_unlock (&sock->peers_lock);
+	*source = pgm_peer_table_lookup (shard->peers_table, &upstream_tsi);
 	if (PGM_UNLIKELY(NULL == *source)) {
 /* this source is unknown, we don't care about messages about it */
 		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded peer packet about new source."));
@@ -369,6 +1272,14 @@ on_peer (
 
 	switch (skb->pgm_header->pgm_type) {
 	case PGM_NAK:
+/* unicast NAK redirected to this DLR */
+		if (sock->dlr_sqns > 0 &&
+		    !pgm_sockaddr_is_addr_multicast (dst_addr))
+		{
+			if (PGM_UNLIKELY(!pgm_on_dlr_nak (sock, *source, src_addr, skb)))
+				goto out_discarded;
+			break;
+		}
 		if (PGM_UNLIKELY(!pgm_on_peer_nak (sock, *source, skb)))
 			goto out_discarded;
 		break;
@@ -402,15 +1313,17 @@ out_discarded:
 static
 bool
 on_downstream (
-	pgm_sock_t*           const restrict sock,
-	struct pgm_sk_buff_t* const restrict skb,
-	struct sockaddr*      const restrict src_addr,
-	struct sockaddr*      const restrict dst_addr,
-	pgm_peer_t**	  	    restrict source
+	pgm_sock_t*            const restrict sock,
+	struct pgm_rx_shard_t* const restrict shard,
+	struct pgm_sk_buff_t*  const restrict skb,
+	struct sockaddr*       const restrict src_addr,
+	struct sockaddr*       const restrict dst_addr,
+	pgm_peer_t**		     restrict source
 	)
 {
 /* pre-conditions */
 	pgm_assert (NULL != sock);
+	pgm_assert (NULL != shard);
 	pgm_assert (NULL != skb);
 	pgm_assert (NULL != src_addr);
 	pgm_assert (NULL != dst_addr);
@@ -435,25 +1348,24 @@ on_downstream (
 		goto out_discarded;
 	}
 
-/* search for TSI peer context or create a new one */
-	if (PGM_LIKELY(pgm_tsi_hash (&skb->tsi) == sock->last_hash_key &&
-			NULL != sock->last_hash_value))
-	{
-		*source = sock->last_hash_value;
-	}
-	else
+/* search for TSI peer context or create a new one, the cache matches on the
+ * full TSI as different sources may share a hash value.
+ */
+	*source = pgm_peer_table_lookup_mru (shard->peers_table, &skb->tsi);
+	if (PGM_UNLIKELY(NULL == *source))
 	{
-		pgm_rwlock_reader_lock (&sock->peers_lock);
-		*source = pgm_hashtable_lookup_extended (sock->peers_hashtable, &skb->tsi, &sock->last_hash_key);
-		pgm_rwlock_reader_unlock (&sock->peers_lock);
+/* no peers_lock, table only changes under the shard mutex */
+		*source = pgm_peer_table_lookup (shard->peers_table, &skb->tsi);
 		if (PGM_UNLIKELY(NULL == *source)) {
 			*source = pgm_new_peer (sock,
 					       &skb->tsi,
 					       (struct sockaddr*)src_addr, pgm_sockaddr_len(src_addr),
 					       (struct sockaddr*)dst_addr, pgm_sockaddr_len(dst_addr),
 						skb->tstamp);
+			if (PGM_UNLIKELY(NULL == *source))
+				goto out_discarded;
 		}
-		sock->last_hash_value = *source;
+		pgm_peer_table_set_mru (shard->peers_table, &skb->tsi, *source);
 	}
 
 	(*source)->cumulative_stats[PGM_PC_RECEIVER_BYTES_RECEIVED] += skb->len;
@@ -466,9 +1378,25 @@ on_downstream (
 	switch (skb->pgm_header->pgm_type) {
 	case PGM_ODATA:
 	case PGM_RDATA:
+/* small TPDUs enter the window as a copy sized to the packet and the receive
+ * buffer is kept for the next read, parity reconstruction pads in place and
+ * requires the full buffer.
+ */
+		if (sock->rx_compact_len > 0 &&
+		    0 != skb->truesize &&
+		    !(*source)->window->is_fec_available &&
+		    ((char*)skb->tail - (char*)skb->head) <= (ptrdiff_t)sock->rx_compact_len)
+		{
+			struct pgm_sk_buff_t* compact_skb = pgm_skb_copy_compact (sock->compact_pool, skb);
+			if (PGM_UNLIKELY(!pgm_on_data (sock, *source, compact_skb))) {
+				pgm_free_skb (compact_skb);
+				goto out_discarded;
+			}
+			break;
+		}
 		if (PGM_UNLIKELY(!pgm_on_data (sock, *source, skb)))
 			goto out_discarded;
-		sock->rx_buffer = pgm_alloc_skb (sock->max_tpdu);
+		shard->rx_buffer = pgm_skb_pool_alloc (sock->skb_pool, sock->max_tpdu);
 		break;
 
 	case PGM_NCF:
@@ -513,15 +1441,17 @@ out_discarded:
 static
 bool
 on_pgm (
-	pgm_sock_t*           const restrict sock,
-	struct pgm_sk_buff_t* const restrict skb,
-	struct sockaddr*      const restrict src_addr,
-	struct sockaddr*      const restrict dst_addr,
-	pgm_peer_t**		    restrict source
+	pgm_sock_t*            const restrict sock,
+	struct pgm_rx_shard_t* const restrict shard,
+	struct pgm_sk_buff_t*  const restrict skb,
+	struct sockaddr*       const restrict src_addr,
+	struct sockaddr*       const restrict dst_addr,
+	pgm_peer_t**		     restrict source
 	)
 {
 /* pre-conditions */
 	pgm_assert (NULL != sock);
+	pgm_assert (NULL != shard);
 	pgm_assert (NULL != skb);
 	pgm_assert (NULL != src_addr);
 	pgm_assert (NULL != dst_addr);
@@ -535,18 +1465,24 @@ on_pgm (
 		(const void*)sock, (const void*)skb, saddr, daddr, (const void*)source);
 #endif
 
+	PGM_PROBE4 (receive, sock, skb->pgm_header->pgm_type, skb->len, skb->tstamp);
+/* every packet type leads with its sequence number */
+	pgm_flightrec_add (sock->flightrec, PGM_FLIGHTREC_RECEIVE, skb->pgm_header->pgm_type, skb->pgm_header->pgm_sport,
+			   skb->len >= sizeof (struct pgm_header) + sizeof (uint32_t) ? pgm_ntohl (*(const uint32_t*)(skb->pgm_header + 1)) : 0,
+			   skb->len);
+
 	if (PGM_IS_DOWNSTREAM (skb->pgm_header->pgm_type))
-		return on_downstream (sock, skb, src_addr, dst_addr, source);
+		return on_downstream (sock, shard, skb, src_addr, dst_addr, source);
 	if (skb->pgm_header->pgm_dport == sock->tsi.sport)
 	{
 		if (PGM_IS_UPSTREAM (skb->pgm_header->pgm_type) ||
 		    PGM_IS_PEER (skb->pgm_header->pgm_type))
 		{
-			return on_upstream (sock, skb);
+			return on_upstream (sock, skb, src_addr);
 		}
 	}
 	else if (PGM_IS_PEER (skb->pgm_header->pgm_type))
-		return on_peer (sock, skb, source);
+		return on_peer (sock, shard, skb, src_addr, dst_addr, source);
 
 	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded unknown PGM packet."));
 	if (sock->can_send_data)
@@ -554,84 +1490,324 @@ on_pgm (
 	return FALSE;
 }
 
-/* block on receiving socket whilst holding sock::waiting-mutex
- * returns EAGAIN for waiting data, returns EINTR for waiting timer event,
- * returns ENOENT on closed sock, and returns EFAULT for libc error.
+/* lock a receive shard, preferring one not held by another receiving thread
+ * and rotating the starting shard between calls.
+ *
+ * returns the locked shard.
  */
 
 static
-int
-wait_for_event (
+struct pgm_rx_shard_t*
+rx_shard_acquire (
 	pgm_sock_t* const	sock
 	)
 {
-	int n_fds = 3;
+	if (PGM_LIKELY(1 == sock->rx_shard_len)) {
+		pgm_sock_mutex_lock (sock, &sock->rx_shard->mutex);
+		return sock->rx_shard;
+	}
 
-/* pre-conditions */
-	pgm_assert (NULL != sock);
+#if defined(SO_INCOMING_CPU) && defined(__GLIBC__)
+/* prefer the shard whose traffic the kernel delivers on this CPU */
+	if (NULL != sock->incoming_cpu) {
+		const int cpu = sched_getcpu();
+		for (unsigned i = 0; i < sock->rx_shard_len; i++) {
+			if (cpu == sock->incoming_cpu[ i % sock->incoming_cpu_len ] &&
+			    pgm_sock_mutex_trylock (sock, &sock->rx_shard[ i ].mutex))
+				return &sock->rx_shard[ i ];
+		}
+	}
+#endif
 
-	pgm_debug ("wait_for_event (sock:%p)", (const void*)sock);
+	const unsigned start = pgm_atomic_exchange_and_add32 (&sock->rx_shard_next, 1);
+	for (unsigned i = 0; i < sock->rx_shard_len; i++) {
+		struct pgm_rx_shard_t* shard = &sock->rx_shard[ (start + i) % sock->rx_shard_len ];
+		if (pgm_sock_mutex_trylock (sock, &shard->mutex))
+			return shard;
+	}
+/* every shard in use, queue as per a single receiver */
+	struct pgm_rx_shard_t* shard = &sock->rx_shard[ start % sock->rx_shard_len ];
+	pgm_sock_mutex_lock (sock, &shard->mutex);
+	return shard;
+}
 
-	do {
-		if (PGM_UNLIKELY(sock->is_destroyed))
-			return ENOENT;
+/* move on to the next shard not held by another thread, such that a single
+ * receiving thread visits every shard.  hops counts shards passed over since
+ * the last wait.
+ *
+ * returns TRUE with the next shard locked and the previous unlocked, returns
+ * FALSE when every shard has been tried.
+ */
 
-		if (sock->can_send_data && !pgm_txw_retransmit_is_empty (sock->window))
-/* tight loop on blocked send */
-			pgm_on_deferred_nak (sock);
+static
+bool
+rx_shard_next (
+	pgm_sock_t*             const restrict sock,
+	struct pgm_rx_shard_t**	      restrict shard,
+	unsigned*		const restrict hops
+	)
+{
+	for (unsigned offset = 1; *hops + 1 < sock->rx_shard_len; offset++) {
+		struct pgm_rx_shard_t* next = &sock->rx_shard[ ((*shard)->index + offset) % sock->rx_shard_len ];
+		(*hops)++;
+		if (pgm_mutex_trylock (&next->mutex)) {
+			pgm_mutex_unlock (&(*shard)->mutex);
+			*shard = next;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
 
-#ifdef HAVE_POLL
-		struct pollfd fds[ n_fds ];
-		memset (fds, 0, sizeof(fds));
-		const int status = pgm_poll_info (sock, fds, &n_fds, POLLIN);
-		pgm_assert (-1 != status);
-#else
-		fd_set readfds;
-		FD_ZERO(&readfds);
-		const int status = pgm_select_info (sock, &readfds, NULL, &n_fds);
-		pgm_assert (-1 != status);
-#endif /* HAVE_POLL */
+/* take a packet read on one shard to the idle shard owning its source,
+ * exchanging receive buffers such that the owner consumes its own.  the owner
+ * holds the packet for its next reader and does not commit to this call.
+ *
+ * returns TRUE with the owner locked, returns FALSE if held by another thread.
+ */
 
-/* flush any waiting notifications */
-		if (sock->is_pending_read) {
-			pgm_notify_clear (&sock->pending_notify);
-			sock->is_pending_read = FALSE;
-		}
+static
+bool
+rx_shard_borrow (
+	struct pgm_rx_shard_t* const restrict shard,
+	struct pgm_rx_shard_t* const restrict owner
+	)
+{
+	if (!pgm_mutex_trylock (&owner->mutex))
+		return FALSE;
+	struct pgm_sk_buff_t* skb = owner->rx_buffer;
+	owner->rx_buffer = shard->rx_buffer;
+	shard->rx_buffer = skb;
+	return TRUE;
+}
+
+static
+void
+rx_shard_return (
+	pgm_sock_t*	       const restrict sock,
+	struct pgm_rx_shard_t* const restrict owner
+	)
+{
+	if (owner->peers_pending) {
+		pgm_rx_pending_lock (sock);
+		if (!sock->is_pending_read) {
+			pgm_notify_send (&sock->pending_notify);
+			sock->is_pending_read = TRUE;
+		}
+		pgm_rx_pending_unlock (sock);
+	}
+	pgm_mutex_unlock (&owner->mutex);
+}
+
+/* wait up to timeout microseconds for any receive descriptor to become
+ * readable, on the persistent sock::wait_fd instance when available
+ * otherwise rebuilding the descriptor set for poll() or select().  epoll and
+ * poll wait to the microsecond with epoll_pwait2() and ppoll() where present,
+ * kqueue on an EVFILT_TIMER for microsecond rather than timespec rounding,
+ * Registered I/O on the completion queue notification, DPDK by polling the
+ * shared port queue.
+ *
+ * returns number of ready descriptors, 0 on timeout, -1 on error.
+ */
+
+static
+int
+wait_for_readable (
+	pgm_sock_t* const	sock,
+	const int		timeout		/* μs */
+	)
+{
+#ifdef PGM_HAVE_RIO
+	if (NULL != sock->rio)
+		return pgm_rio_wait (sock, timeout);
+#endif
+#ifdef PGM_HAVE_DPDK
+	if (NULL != sock->dpdk)
+		return pgm_dpdk_wait (sock, timeout);
+#endif
+#if defined(HAVE_EPOLL_CTL)
+	if (INVALID_SOCKET != sock->wait_fd) {
+		struct epoll_event events[ 4 ];
+#	ifdef HAVE_EPOLL_PWAIT2
+/* the C library may carry the call ahead of the running kernel */
+		static bool has_epoll_pwait2 = TRUE;
+		if (has_epoll_pwait2 && timeout >= 0) {
+			const struct timespec ts = WAIT_TIMESPEC(timeout);
+			const int n = epoll_pwait2 (sock->wait_fd, events, PGM_N_ELEMENTS(events), &ts, NULL);
+			if (PGM_LIKELY(n >= 0 || ENOSYS != errno))
+				return n;
+			has_epoll_pwait2 = FALSE;
+		}
+#	endif
+		return epoll_wait (sock->wait_fd, events, PGM_N_ELEMENTS(events), WAIT_MSECS(timeout));
+	}
+#elif defined(HAVE_KQUEUE)
+	if (INVALID_SOCKET != sock->wait_fd) {
+		struct kevent events[ 4 ];
+		if (timeout <= 0) {
+			const struct timespec ts = { 0, 0 };
+			return kevent (sock->wait_fd, NULL, 0, events, PGM_N_ELEMENTS(events), &ts);
+		}
+/* one-shot EVFILT_TIMER of the next expiration, armed within the wait */
+		struct kevent timer;
+#	ifdef NOTE_USECONDS
+		EV_SET(&timer, (uintptr_t)sock, EVFILT_TIMER, EV_ADD | EV_ONESHOT, NOTE_USECONDS, timeout, sock);
+#	else
+		EV_SET(&timer, (uintptr_t)sock, EVFILT_TIMER, EV_ADD | EV_ONESHOT, 0, (timeout + 999) / 1000 /* to ms */, sock);
+#	endif
+		const int n = kevent (sock->wait_fd, &timer, 1, events, PGM_N_ELEMENTS(events), NULL);
+		int ready = 0;
+		for (int i = 0; i < n; i++) {
+			if (events[i].flags & EV_ERROR) {
+				errno = (int)events[i].data;
+				return SOCKET_ERROR;
+			}
+			if (EVFILT_TIMER != events[i].filter)
+				ready++;
+		}
+		return n < 0 ? n : ready;
+	}
+#endif
+	int n_fds = 3 + sock->recv_shards;
+#ifdef HAVE_POLL
+	struct pollfd fds[ n_fds ];
+	memset (fds, 0, sizeof(fds));
+	const int status = pgm_poll_info (sock, fds, &n_fds, POLLIN);
+	pgm_assert (-1 != status);
+#	ifdef HAVE_PPOLL
+	if (timeout >= 0) {
+		const struct timespec ts = WAIT_TIMESPEC(timeout);
+		return ppoll (fds, n_fds, &ts, NULL);
+	}
+#	endif
+	return poll (fds, n_fds, WAIT_MSECS(timeout));
+#else
+	fd_set readfds;
+	FD_ZERO(&readfds);
+	const int status = pgm_select_info (sock, &readfds, NULL, &n_fds);
+	pgm_assert (-1 != status);
+	struct timeval tv_timeout = {
+		.tv_sec		= timeout > 1000000L ? (timeout / 1000000L) : 0,
+		.tv_usec	= timeout > 1000000L ? (timeout % 1000000L) : timeout
+	};
+	return select (n_fds, &readfds, NULL, NULL, &tv_timeout);
+#endif /* HAVE_POLL */
+}
+
+/* block on receiving socket whilst holding sock::waiting-mutex
+ * returns EAGAIN for waiting data, returns EINTR for waiting timer event,
+ * returns ENOENT on closed sock, and returns EFAULT for libc error.
+ */
+
+static
+int
+wait_for_event (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	pgm_debug ("wait_for_event (sock:%p)", (const void*)sock);
+
+	do {
+		if (PGM_UNLIKELY(sock->is_destroyed))
+			return ENOENT;
+
+		const bool is_repair_pending = sock->can_send_data &&
+					       NULL == sock->rdata_thread &&
+					       !pgm_txw_retransmit_is_empty (sock->window);
+		if (is_repair_pending)
+/* tight loop on blocked send */
+			pgm_on_deferred_nak (sock);
+
+/* flush any waiting notifications */
+		pgm_rx_pending_lock (sock);
+		if (sock->is_pending_read && !is_rx_shard_pending (sock)) {
+			pgm_notify_clear (&sock->pending_notify);
+			sock->is_pending_read = FALSE;
+			if (NULL != sock->demux)
+				pgm_demux_rearm (sock);
+			if (NULL != sock->loop)
+				pgm_loop_rearm (sock);
+			if (NULL != sock->decode_pool)
+				pgm_decode_pool_rearm (sock);
+#ifdef PGM_HAVE_DPDK
+			if (NULL != sock->dpdk)
+				pgm_dpdk_rearm (sock);
+#endif
+		}
+		pgm_rx_pending_unlock (sock);
 
 		int timeout;
-		if (sock->can_send_data && !pgm_txw_retransmit_is_empty (sock->window))
+		if (is_repair_pending && !pgm_txw_retransmit_is_empty (sock->window))
 			timeout = 0;
 		else
 			timeout = (int)pgm_timer_expiration (sock);
-		
-#ifdef HAVE_POLL
-		const int ready = poll (fds, n_fds, timeout /* μs */ / 1000 /* to ms */);
-#else
-		struct timeval tv_timeout = {
-			.tv_sec		= timeout > 1000000L ? (timeout / 1000000L) : 0,
-			.tv_usec	= timeout > 1000000L ? (timeout % 1000000L) : timeout
-		};
-		const int ready = select (n_fds, &readfds, NULL, NULL, &tv_timeout);
-#endif /* HAVE_POLL */
+/* the shared memory ring is not a descriptor, poll it */
+		if (pgm_shm_is_reader (sock->shm))
+			timeout = MIN(timeout, (int)sock->shm->interval);
+
+/* spin no later than the next timer so NAK and SPM state is not starved */
+		int ready = 0;
+		if (sock->busy_poll_usecs > 0 && timeout > 0) {
+			const pgm_time_t spin_start = pgm_time_update_now();
+			const pgm_time_t spin_expiry = spin_start + MIN((unsigned)timeout, sock->busy_poll_usecs);
+			pgm_time_t now;
+			do {
+				ready = wait_for_readable (sock, 0);
+				now = pgm_time_update_now();
+			} while (0 == ready && pgm_time_after (spin_expiry, now));
+			if (0 == ready)
+				timeout -= (int)MIN((pgm_time_t)timeout, now - spin_start);
+		}
+
+		if (0 == ready)
+			ready = wait_for_readable (sock, timeout);
 		if (PGM_UNLIKELY(SOCKET_ERROR == ready)) {
 			pgm_debug ("block returned errno=%i",errno);
 			return EFAULT;
-		} else if (ready > 0) {
+		} else if (ready > 0 || pgm_shm_is_readable (sock->shm)) {
 			pgm_debug ("recv again on empty");
 			return EAGAIN;
 		}
-	} while (pgm_timer_check (sock));
+	} while (!pgm_timer_check (sock));
 	pgm_debug ("state generated event");
 	return EINTR;
 }
 
+/* record a reset reported to the application, logging the flight recorder
+ * leading up to it when configured.
+ */
+
+static
+void
+recv_flightrec_reset (
+	pgm_sock_t*	    const restrict sock,
+	const pgm_peer_t*   const restrict peer
+	)
+{
+	if (NULL == sock->flightrec)
+		return;
+	pgm_flightrec_add (sock->flightrec, PGM_FLIGHTREC_RESET, 0, peer->tsi.sport, peer->lost_count, 0);
+	if (sock->use_flightrec_dump) {
+		char tsi[PGM_TSISTRLEN];
+		pgm_tsi_print_r (&peer->tsi, tsi, sizeof(tsi));
+		pgm_warn (_("Reset on unrecoverable loss of %" PRIu32 " sequences from %s."), peer->lost_count, tsi);
+		pgm_flightrec_log (sock->flightrec);
+	}
+}
+
 /* data incoming on receive sockets, can be from a sender or receiver, or simply bogus.
  * for IPv4 we receive the IP header to handle fragmentation, for IPv6 we cannot, but the
  * underlying stack handles this for us.
  *
- * recvmsgv reads a vector of apdus each contained in a IO scatter/gather array.
+ * recvmsgv reads a vector of apdus each contained in a IO scatter/gather array,
+ * recvskbv the same into a compact vector, both appending at the cursor.
  *
  * can be called due to event from incoming socket(s) or timer induced data loss.
+ * now is a clock reading shared across sockets by pgm_recvmsgv_multi(), 0 to
+ * read the clock.
  *
  * On success, returns PGM_IO_STATUS_NORMAL and saves the count of bytes read
  * into _bytes_read.  With non-blocking sockets a block returns
@@ -642,54 +1818,61 @@ wait_for_event (
  * closed, returns PGM_IO_STATUS_EOF.  On error, returns PGM_IO_STATUS_ERROR.
  */
 
+static
 int
-pgm_recvmsgv (
+recvcursor (
 	pgm_sock_t*   	   const restrict sock,
-	struct pgm_msgv_t* const restrict msg_start,
-	const size_t			  msg_len,
-	const int			  flags,	/* MSG_DONTWAIT for non-blocking */
-	size_t*			 restrict _bytes_read,	/* may be NULL */
+	pgm_rxw_cursor_t*  const restrict cursor,
+	const int			  flags,
+	const pgm_time_t		  now,
+	size_t*			 restrict _bytes_read,
 	pgm_error_t**		 restrict error
 	)
 {
 	int status = PGM_IO_STATUS_WOULD_BLOCK;
 
-	pgm_debug ("pgm_recvmsgv (sock:%p msg-start:%p msg-len:%" PRIzu " flags:%d bytes-read:%p error:%p)",
-		(void*)sock, (void*)msg_start, msg_len, flags, (void*)_bytes_read, (void*)error);
-
-/* parameters */
-	pgm_return_val_if_fail (NULL != sock, PGM_IO_STATUS_ERROR);
-	if (PGM_LIKELY(msg_len)) pgm_return_val_if_fail (NULL != msg_start, PGM_IO_STATUS_ERROR);
-
 /* shutdown */
-	if (PGM_UNLIKELY(!pgm_rwlock_reader_trylock (&sock->lock)))
+	if (PGM_UNLIKELY(!pgm_sock_reader_trylock (sock)))
 		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
 
 /* state */
 	if (PGM_UNLIKELY(!sock->is_bound || sock->is_destroyed))
 	{
-		pgm_rwlock_reader_unlock (&sock->lock);
+		pgm_sock_reader_unlock (sock);
 		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
 	}
 
 /* pre-conditions */
-	pgm_assert (NULL != sock->rx_buffer);
+	pgm_assert (NULL != sock->rx_shard);
 	pgm_assert (sock->max_tpdu > 0);
 	if (sock->can_recv_data) {
-		pgm_assert (NULL != sock->peers_hashtable);
+		pgm_assert (NULL != sock->rx_shard->peers_table);
 		pgm_assert_cmpuint (sock->nak_bo_ivl, >, 1);
 		pgm_assert (pgm_notify_is_valid (&sock->pending_notify));
 	}
 
 /* receiver */
-	pgm_mutex_lock (&sock->receiver_mutex);
+	struct pgm_rx_shard_t* shard = rx_shard_acquire (sock);
+
+	size_t bytes_read = 0;
+	unsigned data_read = 0;
+	unsigned hops = 0;
+	struct sockaddr_storage src, dst;
+	ssize_t len;
+	size_t bytes_received = 0;
+	struct pgm_sk_buff_t* skb;
+	bool is_local;
 
-	if (PGM_UNLIKELY(sock->is_reset)) {
-		pgm_assert (NULL != sock->peers_pending);
-		pgm_assert (NULL != sock->peers_pending->data);
-		pgm_peer_t* peer = sock->peers_pending->data;
+shard_again:
+	pgm_assert (NULL != shard->rx_buffer);
+
+	if (PGM_UNLIKELY(shard->is_reset)) {
+		pgm_assert (NULL != shard->peers_pending);
+		pgm_assert (NULL != shard->peers_pending->data);
+		pgm_peer_t* peer = shard->peers_pending->data;
+		recv_flightrec_reset (sock, peer);
 		if (flags & MSG_ERRQUEUE)
-			pgm_set_reset_error (sock, peer, msg_start);
+			pgm_set_reset_error (sock, peer, cursor);
 		else if (error) {
 			char tsi[PGM_TSISTRLEN];
 			pgm_tsi_print_r (&peer->tsi, tsi, sizeof(tsi));
@@ -700,21 +1883,27 @@ pgm_recvmsgv (
 				     tsi);
 		}
 		if (!sock->is_abort_on_reset)
-			sock->is_reset = !sock->is_reset;
-		pgm_mutex_unlock (&sock->receiver_mutex);
-		pgm_rwlock_reader_unlock (&sock->lock);
+			shard->is_reset = !shard->is_reset;
+		pgm_sock_mutex_unlock (sock, &shard->mutex);
+		pgm_sock_reader_unlock (sock);
 		return PGM_IO_STATUS_RESET;
 	}
 
+/* one reading for the packets of this call in coarse mode */
+	const pgm_time_t call_now = now ? now : pgm_time_update_now();
+	if (pgm_time_is_coarse)
+		pgm_time_cached = call_now;
+
 /* timer status */
-	if (pgm_timer_check (sock) &&
-	    !pgm_timer_dispatch (sock))
+	if (pgm_timer_check_at (sock, call_now) &&
+	    !pgm_timer_dispatch (sock, shard))
 	{
 /* block on send-in-recv */
 		status = PGM_IO_STATUS_RATE_LIMITED;
 	}
-/* NAK status */
-	else if (sock->can_send_data)
+/* NAK status, unless served by the repair thread */
+	else if (sock->can_send_data &&
+		 NULL == sock->rdata_thread)
 	{
 		if (!pgm_txw_retransmit_is_empty (sock->window))
 		{
@@ -725,17 +1914,20 @@ pgm_recvmsgv (
 			pgm_notify_clear (&sock->rdata_notify);
 	}
 
-	size_t bytes_read = 0;
-	unsigned data_read = 0;
-	struct pgm_msgv_t* pmsg = msg_start;
-	const struct pgm_msgv_t* msg_end = msg_start + msg_len - 1;
+/* re-arm the event socket timer, clearing an expiry serviced above */
+	if (INVALID_SOCKET != sock->event_timer_fd)
+		pgm_timer_event_arm (sock);
 
-	if (PGM_UNLIKELY(0 == ++(sock->last_commit)))
-		++(sock->last_commit);
+	if (PGM_UNLIKELY(0 == ++(shard->last_commit)))
+		++(shard->last_commit);
+
+/* transmission groups reconstructed since the last call */
+	if (pgm_atomic_read32 (&shard->decode_ready))
+		pgm_collect_decoded (sock, shard);
 
 	/* second, flush any remaining contiguous messages from previous call(s) */
-	if (sock->peers_pending) {
-		if (0 != pgm_flush_peers_pending (sock, &pmsg, msg_end, &bytes_read, &data_read))
+	if (shard->peers_pending) {
+		if (0 != pgm_flush_peers_pending (sock, shard, cursor, &bytes_read, &data_read))
 			goto out;
 /* returns on: reset or full buffer */
 	}
@@ -744,19 +1936,124 @@ pgm_recvmsgv (
  *
  * We cannot actually block here as packets pushed by the timers need to be addressed too.
  */
-	struct sockaddr_storage src, dst;
-	ssize_t len;
-	size_t bytes_received = 0;
-
 recv_again:
 
+/* packets read by other sockets sharing the receive socket, already parsed */
+	if (NULL != sock->demux &&
+	    pgm_demux_pop (sock, shard, (struct sockaddr*)&src, (struct sockaddr*)&dst))
+	{
+		skb = shard->rx_buffer;
+		len = skb->len;
+		bytes_received += len;
+		goto demux_again;
+	}
+
+/* captured packets in place of the receive socket */
+	is_local = FALSE;
+	if (NULL != sock->replay)
+		len = pgm_replay_recvskb (sock,
+					  shard->rx_buffer,
+					  (struct sockaddr*)&src,
+					  sizeof(src),
+					  (struct sockaddr*)&dst,
+					  sizeof(dst));
+	else
+/* same-host publisher first, the network when the ring is empty */
+	if (NULL != sock->shm &&
+	    (len = pgm_shm_recvskb (sock,
+				    shard->rx_buffer,
+				    (struct sockaddr*)&src,
+				    sizeof(src),
+				    (struct sockaddr*)&dst,
+				    sizeof(dst))) > 0)
+		is_local = TRUE;
+	else
+/* in-process bus, the kernel sockets carry nothing */
+	if (NULL != sock->loop &&
+	    (len = pgm_loop_recvskb (sock,
+				     shard->rx_buffer,
+				     (struct sockaddr*)&src,
+				     sizeof(src),
+				     (struct sockaddr*)&dst,
+				     sizeof(dst))) > 0)
+		is_local = TRUE;
+	else
+#ifdef PGM_HAVE_IO_URING
+/* io_uring owns the receive socket, no direct reads */
+	if (NULL != sock->uring)
+		len = recvuringskb (sock,
+				    (struct sockaddr*)&src,
+				    sizeof(src),
+				    (struct sockaddr*)&dst,
+				    sizeof(dst));
+	else
+#endif
+#ifdef PGM_HAVE_RIO
+/* Registered I/O owns the receive socket, no direct reads */
+	if (NULL != sock->rio)
+		len = recvrioskb (sock,
+				  (struct sockaddr*)&src,
+				  sizeof(src),
+				  (struct sockaddr*)&dst,
+				  sizeof(dst));
+	else
+#endif
+#ifdef PGM_HAVE_DPDK
+/* DPDK port queue first, unicast traffic remains on the kernel socket */
+	if (NULL == sock->dpdk ||
+	    (len = pgm_dpdk_recvskb (sock,
+				     shard,
+				     (struct sockaddr*)&src,
+				     sizeof(src),
+				     (struct sockaddr*)&dst,
+				     sizeof(dst))) < 0)
+	{
+#endif
+#ifdef HAVE_LINUX_IF_XDP_H
+/* AF_XDP ring first, unicast and unredirected traffic remains on the kernel socket */
+	if (NULL == sock->xdp ||
+	    (len = pgm_xdp_recvskb (sock,
+				    shard->rx_buffer,
+				    (struct sockaddr*)&src,
+				    sizeof(src),
+				    (struct sockaddr*)&dst,
+				    sizeof(dst))) < 0)
+	{
+#endif
+#ifdef UDP_GRO
+	if (NULL != sock->rx_gro)
+		len = recvgroskb (sock,
+				  0,
+				  (struct sockaddr*)&src,
+				  sizeof(src),
+				  (struct sockaddr*)&dst,
+				  sizeof(dst));
+	else
+#endif
+#ifdef HAVE_RECVMMSG
+	if (NULL != sock->rx_batch)
+		len = recvmmskb (sock,
+				 0,
+				 (struct sockaddr*)&src,
+				 sizeof(src),
+				 (struct sockaddr*)&dst,
+				 sizeof(dst));
+	else
+#endif
 	len = recvskb (sock,
-		       sock->rx_buffer,		/* PGM skbuff */
+		       shard->rx_buffer,	/* PGM skbuff */
+		       shard->index,
 		       0,
 		       (struct sockaddr*)&src,
 		       sizeof(src),
 		       (struct sockaddr*)&dst,
 		       sizeof(dst));
+#ifdef HAVE_LINUX_IF_XDP_H
+	}
+#endif
+#ifdef PGM_HAVE_DPDK
+	}
+#endif
 	if (len < 0)
 	{
 		const int save_errno = pgm_get_last_sock_error();
@@ -764,6 +2061,12 @@ recv_again:
 		if (PGM_LIKELY(PGM_SOCK_EAGAIN == save_errno)) {
 			goto check_for_repeat;
 		}
+/* transient, retried on the next event without raising an error */
+		if (PGM_SOCK_EINTR == save_errno || PGM_SOCK_ENOBUFS == save_errno) {
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Transient receive error: %s"),
+				   pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+			goto check_for_repeat;
+		}
 		status = PGM_IO_STATUS_ERROR;
 		pgm_set_error (error,
 			     PGM_ERROR_DOMAIN_RECV,
@@ -783,40 +2086,83 @@ recv_again:
 		bytes_received += len;
 	}
 
-	pgm_error_t* err = NULL;
-	const bool is_valid = (sock->udp_encap_ucast_port || AF_INET6 == src.ss_family) ?
-					pgm_parse_udp_encap (sock->rx_buffer, &err) :
-					pgm_parse_raw (sock->rx_buffer, (struct sockaddr*)&dst, &err);
+	skb = shard->rx_buffer;
+	pgm_parse_error_t err = PGM_PARSE_ERROR_INIT;
+/* ring and bus packets carry the PGM header alone, ring packets no checksum */
+	const bool is_valid = is_local ?
+					pgm_parse_udp_encap (skb, TRUE, &err) :
+				(sock->udp_encap_ucast_port || pgm_is_inet6 (src.ss_family)) ?
+					pgm_parse_udp_encap (skb, sock->use_zero_checksum, &err) :
+					pgm_parse_raw (skb, (struct sockaddr*)&dst, &err);
 	if (PGM_UNLIKELY(!is_valid))
 	{
-/* inherently cannot determine PGM_PC_RECEIVER_CKSUM_ERRORS unless only one receiver */
+/* inherently cannot determine PGM_PC_RECEIVER_CKSUM_ERRORS unless only one receiver,
+ * reason only formatted when tracing.
+ */
+		char errbuf[1024];
 		pgm_trace (PGM_LOG_ROLE_NETWORK,
 				_("Discarded invalid packet: %s"),
-				(err && err->message) ? err->message : "(null)");
-		pgm_error_free (err);
+				pgm_parse_strerror_s (errbuf, sizeof (errbuf), &err));
 		if (sock->can_send_data) {
-			if (err && PGM_ERROR_CKSUM == err->code)
+			if (PGM_ERROR_CKSUM == err.code)
 				sock->cumulative_stats[PGM_PC_SOURCE_CKSUM_ERRORS]++;
 			sock->cumulative_stats[PGM_PC_SOURCE_PACKETS_DISCARDED]++;
 		}
 		goto recv_again;
 	}
 
+/* shared receive socket, packets of other sockets move to their owners */
+	if (NULL != sock->demux &&
+	    !pgm_demux_dispatch (sock, shard, (struct sockaddr*)&src, (struct sockaddr*)&dst))
+		goto recv_again;
+
+demux_again:
+/* data verified by the UDP checksum alone */
+	if (sock->use_zero_checksum &&
+	    0 == skb->pgm_header->pgm_checksum &&
+	    (PGM_ODATA == skb->pgm_header->pgm_type ||
+	     PGM_RDATA == skb->pgm_header->pgm_type))
+		sock->zero_checksum_received++;
+
+/* only unicast reaches a shard other than that owning the source */
+	struct pgm_rx_shard_t* owner = shard;
+	if (PGM_UNLIKELY(sock->rx_shard_len > 1)) {
+		owner = pgm_rx_shard_for (sock, &skb->tsi);
+		if (owner != shard && !rx_shard_borrow (shard, owner)) {
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded packet for busy receive shard."));
+			goto recv_again;
+		}
+	}
+
 	pgm_peer_t* source = NULL;
-	if (PGM_UNLIKELY(!on_pgm (sock, sock->rx_buffer, (struct sockaddr*)&src, (struct sockaddr*)&dst, &source)))
+	const bool is_processed = on_pgm (sock, owner, owner->rx_buffer, (struct sockaddr*)&src, (struct sockaddr*)&dst, &source);
+
+/* reschedule state timers of the source even for discarded packets */
+	if (source)
+		pgm_peer_timer_update (sock, source);
+	if (PGM_UNLIKELY(!is_processed)) {
+		if (owner != shard)
+			rx_shard_return (sock, owner);
 		goto recv_again;
+	}
 
 /* check whether this source has waiting data */
 	if (source && pgm_peer_has_pending (source)) {
 		pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("New pending data."));
 		pgm_peer_set_pending (sock, source);
 	}
+	if (PGM_UNLIKELY(owner != shard)) {
+		rx_shard_return (sock, owner);
+		goto check_for_repeat;
+	}
 
 flush_pending:
+	if (pgm_atomic_read32 (&shard->decode_ready))
+		pgm_collect_decoded (sock, shard);
 /* flush any congtiguous packets generated by the receipt of this packet */
-	if (sock->peers_pending)
+	if (shard->peers_pending)
 	{
-		if (0 != pgm_flush_peers_pending (sock, &pmsg, msg_end, &bytes_read, &data_read))
+		if (0 != pgm_flush_peers_pending (sock, shard, cursor, &bytes_read, &data_read))
 		{
 /* recv vector is now full */
 			goto out;
@@ -824,31 +2170,49 @@ flush_pending:
 	}
 
 check_for_repeat:
+/* NAKs of the burst once the receive socket drains */
+	if (NULL != sock->ncf_batch && len < 0)
+		pgm_ncf_batch_flush (sock);
 /* repeat if non-blocking and not full */
 	if (sock->is_nonblocking ||
 	    flags & MSG_DONTWAIT)
 	{
-		if (len > 0 && pmsg <= msg_end) {
+		if (len > 0 && !pgm_rxw_cursor_is_full (cursor)) {
 			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Recv again on not-full"));
 			goto recv_again;		/* \:D/ */
 		}
+/* other shards before reporting would-block */
+		if (0 == data_read && rx_shard_next (sock, &shard, &hops))
+			goto shard_again;
 	}
 	else
 	{
 /* repeat if blocking and empty, i.e. received non data packet.
  */
 		if (0 == data_read) {
+/* drain any batched packets before blocking on the socket */
+			if (is_rx_pending (sock))
+				goto recv_again;
+/* transmission groups completed by decoder threads meanwhile */
+			if (pgm_atomic_read32 (&shard->decode_ready))
+				goto flush_pending;
+/* other shards before blocking, readiness is waited on across all shards */
+			if (rx_shard_next (sock, &shard, &hops))
+				goto shard_again;
 			const int wait_status = wait_for_event (sock);
+			hops = 0;
+			if (pgm_time_is_coarse)
+				pgm_time_refresh ();
 			switch (wait_status) {
 			case EAGAIN:
 				goto recv_again;
 			case EINTR:
-				if (!pgm_timer_dispatch (sock))
+				if (!pgm_timer_dispatch (sock, shard))
 					goto check_for_repeat;
 				goto flush_pending;
 			case ENOENT:
-				pgm_mutex_unlock (&sock->receiver_mutex);
-				pgm_rwlock_reader_unlock (&sock->lock);
+				pgm_sock_mutex_unlock (sock, &shard->mutex);
+				pgm_sock_reader_unlock (sock);
 				return PGM_IO_STATUS_EOF;
 			case EFAULT: {
 				const int save_errno = pgm_get_last_sock_error();
@@ -859,8 +2223,8 @@ check_for_repeat:
 						_("Waiting for event: %s"),
 						pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno)
 						);
-				pgm_mutex_unlock (&sock->receiver_mutex);
-				pgm_rwlock_reader_unlock (&sock->lock);
+				pgm_sock_mutex_unlock (sock, &shard->mutex);
+				pgm_sock_reader_unlock (sock);
 				return PGM_IO_STATUS_ERROR;
 			}
 			default:
@@ -870,20 +2234,42 @@ check_for_repeat:
 	}
 
 out:
+	if (NULL != sock->ncf_batch)
+		pgm_ncf_batch_flush (sock);
+	if (sock->use_rx_tune)
+		rx_tune (sock, shard, bytes_received);
+#ifdef SO_INCOMING_CPU
+	if (bytes_received > 0)
+		rx_cpu_sample (sock, shard);
+#endif
+
 	if (0 == data_read)
 	{
 /* clear event notification */
-		if (sock->is_pending_read) {
+		pgm_rx_pending_lock (sock);
+		if (sock->is_pending_read && !is_rx_pending (sock) && !is_rx_shard_pending (sock)) {
 			pgm_notify_clear (&sock->pending_notify);
 			sock->is_pending_read = FALSE;
+			if (NULL != sock->demux)
+				pgm_demux_rearm (sock);
+			if (NULL != sock->loop)
+				pgm_loop_rearm (sock);
+			if (NULL != sock->decode_pool)
+				pgm_decode_pool_rearm (sock);
+#ifdef PGM_HAVE_DPDK
+			if (NULL != sock->dpdk)
+				pgm_dpdk_rearm (sock);
+#endif
 		}
+		pgm_rx_pending_unlock (sock);
 /* report data loss */
-		if (PGM_UNLIKELY(sock->is_reset)) {
-			pgm_assert (NULL != sock->peers_pending);
-			pgm_assert (NULL != sock->peers_pending->data);
-			pgm_peer_t* peer = sock->peers_pending->data;
+		if (PGM_UNLIKELY(shard->is_reset)) {
+			pgm_assert (NULL != shard->peers_pending);
+			pgm_assert (NULL != shard->peers_pending->data);
+			pgm_peer_t* peer = shard->peers_pending->data;
+			recv_flightrec_reset (sock, peer);
 			if (flags & MSG_ERRQUEUE)
-				pgm_set_reset_error (sock, peer, msg_start);
+				pgm_set_reset_error (sock, peer, cursor);
 			else if (error) {
 				char tsi[PGM_TSISTRLEN];
 				pgm_tsi_print_r (&peer->tsi, tsi, sizeof(tsi));
@@ -894,25 +2280,28 @@ out:
 					     tsi);
 			}
 			if (!sock->is_abort_on_reset)
-				sock->is_reset = !sock->is_reset;
-			pgm_mutex_unlock (&sock->receiver_mutex);
-			pgm_rwlock_reader_unlock (&sock->lock);
+				shard->is_reset = !shard->is_reset;
+			pgm_sock_mutex_unlock (sock, &shard->mutex);
+			pgm_sock_reader_unlock (sock);
 			return PGM_IO_STATUS_RESET;
 		}
-		pgm_mutex_unlock (&sock->receiver_mutex);
-		pgm_rwlock_reader_unlock (&sock->lock);
+		pgm_sock_mutex_unlock (sock, &shard->mutex);
+		pgm_sock_reader_unlock (sock);
 		if (PGM_IO_STATUS_WOULD_BLOCK == status &&
 		    ( sock->can_send_data ||
-		      ( sock->can_recv_data && NULL != sock->peers_list )))
+		      ( sock->can_recv_data && NULL != sock->peers_list ) ||
+		      pgm_shm_is_reader (sock->shm) ))
 		{
 			status = PGM_IO_STATUS_TIMER_PENDING;
 		}
 		return status;
 	}
 
-	if (sock->peers_pending)
+/* batched packets are invisible to the socket readiness */
+	if (shard->peers_pending || is_rx_pending (sock))
 	{
 /* set event notification for additional available data */
+		pgm_rx_pending_lock (sock);
 		if (sock->is_pending_read && sock->is_edge_triggered_recv)
 		{
 /* empty pending-pipe */
@@ -925,15 +2314,272 @@ out:
 			pgm_notify_send (&sock->pending_notify);
 			sock->is_pending_read = TRUE;
 		}
+		pgm_rx_pending_unlock (sock);
 	}
 
 	if (NULL != _bytes_read)
 		*_bytes_read = bytes_read;
-	pgm_mutex_unlock (&sock->receiver_mutex);
-	pgm_rwlock_reader_unlock (&sock->lock);
+	pgm_sock_mutex_unlock (sock, &shard->mutex);
+	pgm_sock_reader_unlock (sock);
 	return PGM_IO_STATUS_NORMAL;
 }
 
+/* release the entries read by the last call, waking the thread when it may be
+ * waiting on a full ring.
+ */
+
+static
+void
+recv_drain_release (
+	struct pgm_recv_drain_t* const	drain
+	)
+{
+	const uint32_t tail = drain->tail;
+	const uint32_t read = drain->read;
+
+	if (tail == read)
+		return;
+	for (uint32_t i = tail; i != read; i++) {
+		struct pgm_recv_drain_entry_t* entry = &drain->entries[ i & (drain->len - 1) ];
+		for (unsigned j = 0; j < entry->msgv.msgv_len; j++)
+			pgm_free_skb (entry->msgv.msgv_skb[ j ]);
+		entry->msgv.msgv_len = 0;
+	}
+	const bool was_full = (pgm_atomic_read32_acquire (&drain->head) - tail) >= drain->len - 1;
+	pgm_atomic_write32_release (&drain->tail, read);
+	if (was_full)
+		pgm_notify_send (&drain->notify);
+}
+
+/* read messages published by the drain thread as pgm_recvmsgv(), a status
+ * other than a message is returned on its own.
+ */
+
+static
+int
+recv_drain_read (
+	pgm_sock_t*   	   const restrict sock,
+	struct pgm_msgv_t* const restrict msg_start,
+	const size_t			  msg_len,
+	const int			  flags,
+	size_t*			 restrict _bytes_read,
+	pgm_error_t**		 restrict error
+	)
+{
+	struct pgm_recv_drain_t* drain;
+	int status = PGM_IO_STATUS_WOULD_BLOCK;
+	size_t bytes_read = 0;
+
+	if (PGM_UNLIKELY(!pgm_sock_reader_trylock (sock)))
+		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
+	drain = sock->recv_drain;
+	if (PGM_UNLIKELY(NULL == drain)) {
+		pgm_sock_reader_unlock (sock);
+		return pgm_recvmsgv (sock, msg_start, msg_len, flags, _bytes_read, error);
+	}
+	pgm_mutex_lock (&drain->mutex);
+	drain->is_reading = TRUE;
+	pgm_mutex_unlock (&drain->mutex);
+
+/* messages of the last call are no longer referenced by the application */
+	recv_drain_release (drain);
+
+	for (;;)
+	{
+		uint32_t read = drain->read;
+		const uint32_t head = pgm_atomic_read32_acquire (&drain->head);
+		if (head != read) {
+			struct pgm_recv_drain_entry_t* entry = &drain->entries[ read & (drain->len - 1) ];
+			if (PGM_IO_STATUS_NORMAL != entry->status) {
+				status = entry->status;
+				if (NULL != entry->error) {
+					pgm_propagate_error (error, entry->error);
+					entry->error = NULL;
+				}
+				read++;
+			} else {
+				size_t i = 0;
+				status = PGM_IO_STATUS_NORMAL;
+				while (i < msg_len && head != read && PGM_IO_STATUS_NORMAL == entry->status) {
+					msg_start[ i++ ] = entry->msgv;
+					for (unsigned j = 0; j < entry->msgv.msgv_len; j++)
+						bytes_read += entry->msgv.msgv_skb[ j ]->len;
+					entry = &drain->entries[ ++read & (drain->len - 1) ];
+				}
+			}
+			pgm_atomic_write32_release (&drain->read, read);
+			break;
+		}
+		if (PGM_UNLIKELY(pgm_atomic_read32 (&drain->is_terminated))) {
+			status = PGM_IO_STATUS_EOF;
+			break;
+		}
+		if (flags & MSG_DONTWAIT)
+			break;
+/* the thread notifies a reader caught up with head, check again once clear */
+		pgm_notify_clear (&drain->ready);
+		pgm_atomic_fence ();
+		if (pgm_atomic_read32_acquire (&drain->head) == read &&
+		    !pgm_atomic_read32 (&drain->is_terminated))
+			recv_thread_wait (sock, &drain->ready, FALSE, -1);
+	}
+
+	pgm_mutex_lock (&drain->mutex);
+	drain->is_reading = FALSE;
+	if (drain->is_terminated)
+		pgm_cond_signal (&drain->cond);
+	pgm_mutex_unlock (&drain->mutex);
+	pgm_sock_reader_unlock (sock);
+	if (NULL != _bytes_read)
+		*_bytes_read = bytes_read;
+	return status;
+}
+
+int
+pgm_recvmsgv (
+	pgm_sock_t*   	   const restrict sock,
+	struct pgm_msgv_t* const restrict msg_start,
+	const size_t			  msg_len,
+	const int			  flags,	/* MSG_DONTWAIT for non-blocking */
+	size_t*			 restrict _bytes_read,	/* may be NULL */
+	pgm_error_t**		 restrict error
+	)
+{
+	pgm_rxw_cursor_t cursor;
+
+	pgm_debug ("pgm_recvmsgv (sock:%p msg-start:%p msg-len:%" PRIzu " flags:%d bytes-read:%p error:%p)",
+		(void*)sock, (void*)msg_start, msg_len, flags, (void*)_bytes_read, (void*)error);
+
+/* parameters */
+	pgm_return_val_if_fail (NULL != sock, PGM_IO_STATUS_ERROR);
+	if (PGM_LIKELY(msg_len)) pgm_return_val_if_fail (NULL != msg_start, PGM_IO_STATUS_ERROR);
+
+	if (NULL != sock->recv_drain)
+		return recv_drain_read (sock, msg_start, msg_len, flags, _bytes_read, error);
+	pgm_rxw_cursor_init_msgv (&cursor, msg_start, (unsigned)msg_len);
+	return recvcursor (sock, &cursor, flags, 0, _bytes_read, error);
+}
+
+/* as pgm_recvmsgv() reading into a compact vector, one flat packet array with
+ * per-message offsets and counts in place of PGM_MAX_FRAGMENTS pointers per
+ * message.  reading stops with fewer than PGM_MAX_FRAGMENTS packets free.
+ */
+
+int
+pgm_recvskbv (
+	pgm_sock_t*   	   const restrict sock,
+	struct pgm_skbv_t* const restrict skbv,
+	const int			  flags,	/* MSG_DONTWAIT for non-blocking */
+	size_t*			 restrict _bytes_read,	/* may be NULL */
+	pgm_error_t**		 restrict error
+	)
+{
+	pgm_rxw_cursor_t cursor;
+
+	pgm_debug ("pgm_recvskbv (sock:%p skbv:%p flags:%d bytes-read:%p error:%p)",
+		(void*)sock, (void*)skbv, flags, (void*)_bytes_read, (void*)error);
+
+/* parameters */
+	pgm_return_val_if_fail (NULL != sock, PGM_IO_STATUS_ERROR);
+	pgm_return_val_if_fail (NULL != skbv, PGM_IO_STATUS_ERROR);
+	pgm_return_val_if_fail (NULL == sock->recv_drain, PGM_IO_STATUS_ERROR);
+	if (PGM_LIKELY(skbv->skbv_msg_len)) {
+		pgm_return_val_if_fail (NULL != skbv->skbv_skb, PGM_IO_STATUS_ERROR);
+		pgm_return_val_if_fail (NULL != skbv->skbv_offset, PGM_IO_STATUS_ERROR);
+		pgm_return_val_if_fail (NULL != skbv->skbv_count, PGM_IO_STATUS_ERROR);
+		pgm_return_val_if_fail (skbv->skbv_skb_len >= PGM_MAX_FRAGMENTS, PGM_IO_STATUS_ERROR);
+	}
+
+	pgm_rxw_cursor_init_skbv (&cursor, skbv);
+	return recvcursor (sock, &cursor, flags, 0, _bytes_read, error);
+}
+
+/* as pgm_recvmsgv() across several sockets into one message vector, without
+ * blocking.  the clock is read once for every socket, and msg_sock receives
+ * the socket of each message read.  sockets are read in turn until the vector
+ * is full.
+ *
+ * returns PGM_IO_STATUS_NORMAL when any messages are read, otherwise the most
+ * urgent of PGM_IO_STATUS_RATE_LIMITED, PGM_IO_STATUS_TIMER_PENDING and
+ * PGM_IO_STATUS_WOULD_BLOCK.  a reset, end of file or error of a socket ends
+ * the call with that status, the msgs_read messages before remain valid and
+ * msg_sock[ msgs_read ] is the failing socket.
+ */
+
+int
+pgm_recvmsgv_multi (
+	pgm_sock_t*const*  const restrict socks,
+	const size_t			  sock_len,
+	struct pgm_msgv_t* const restrict msg_start,
+	pgm_sock_t**	   const restrict msg_sock,	/* socket of each message */
+	const size_t			  msg_len,
+	const int			  flags,	/* MSG_DONTWAIT implied */
+	size_t*			 restrict _msgs_read,	/* may be NULL */
+	size_t*			 restrict _bytes_read,	/* may be NULL */
+	pgm_error_t**		 restrict error
+	)
+{
+	pgm_rxw_cursor_t cursor;
+	size_t bytes_read = 0;
+	int status = PGM_IO_STATUS_WOULD_BLOCK;
+
+	pgm_debug ("pgm_recvmsgv_multi (socks:%p sock-len:%" PRIzu " msg-start:%p msg-sock:%p msg-len:%" PRIzu " flags:%d msgs-read:%p bytes-read:%p error:%p)",
+		(const void*)socks, sock_len, (void*)msg_start, (void*)msg_sock, msg_len, flags, (void*)_msgs_read, (void*)_bytes_read, (void*)error);
+
+/* parameters */
+	pgm_return_val_if_fail (NULL != socks, PGM_IO_STATUS_ERROR);
+	pgm_return_val_if_fail (NULL != msg_start, PGM_IO_STATUS_ERROR);
+	pgm_return_val_if_fail (NULL != msg_sock, PGM_IO_STATUS_ERROR);
+	pgm_return_val_if_fail (msg_len > 0, PGM_IO_STATUS_ERROR);
+	for (size_t i = 0; i < sock_len; i++) {
+		pgm_return_val_if_fail (NULL != socks[ i ], PGM_IO_STATUS_ERROR);
+		pgm_return_val_if_fail (NULL == socks[ i ]->recv_drain, PGM_IO_STATUS_ERROR);
+	}
+
+	const pgm_time_t now = pgm_time_update_now();
+	pgm_rxw_cursor_init_msgv (&cursor, msg_start, (unsigned)msg_len);
+	for (size_t i = 0; i < sock_len && !pgm_rxw_cursor_is_full (&cursor); i++)
+	{
+		struct pgm_msgv_t* msgv = cursor.msgv;
+		const size_t msgs_read = msgv - msg_start;
+		size_t sock_bytes = 0;
+
+		const int sock_status = recvcursor (socks[ i ], &cursor, flags | MSG_DONTWAIT, now, &sock_bytes, error);
+		for (; msgv < cursor.msgv; msgv++)
+			msg_sock[ msgv - msg_start ] = socks[ i ];
+		switch (sock_status) {
+		case PGM_IO_STATUS_NORMAL:
+			bytes_read += sock_bytes;
+			status = PGM_IO_STATUS_NORMAL;
+			break;
+		case PGM_IO_STATUS_RATE_LIMITED:
+			if (PGM_IO_STATUS_NORMAL != status)
+				status = PGM_IO_STATUS_RATE_LIMITED;
+			break;
+		case PGM_IO_STATUS_TIMER_PENDING:
+			if (PGM_IO_STATUS_WOULD_BLOCK == status)
+				status = PGM_IO_STATUS_TIMER_PENDING;
+			break;
+		case PGM_IO_STATUS_WOULD_BLOCK:
+			break;
+		default:
+/* a reset with MSG_ERRQUEUE leaves its message at msgs_read */
+			msg_sock[ msgs_read ] = socks[ i ];
+			if (NULL != _msgs_read)
+				*_msgs_read = msgs_read;
+			if (NULL != _bytes_read)
+				*_bytes_read = bytes_read;
+			return sock_status;
+		}
+	}
+
+	if (NULL != _msgs_read)
+		*_msgs_read = cursor.msgv - msg_start;
+	if (NULL != _bytes_read)
+		*_bytes_read = bytes_read;
+	return status;
+}
+
 /* read one contiguous apdu and return as a IO scatter/gather array.  msgv is owned by
  * the caller, tpdu contents are owned by the receive window.
  *
@@ -1004,6 +2650,7 @@ pgm_recvfrom (
 		memcpy (&from->sa_addr.gsi, &pskb->tsi.gsi, sizeof(pgm_gsi_t));
 	}
 
+	const bool is_stream_copy = (0 != sock->stream_copy_len && bytes_read >= sock->stream_copy_len);
 	while (bytes_copied < bytes_read) {
 		size_t copy_len = pskb->len;
 		if (bytes_copied + copy_len > buflen) {
@@ -1012,7 +2659,10 @@ pgm_recvfrom (
 			copy_len = buflen - bytes_copied;
 			bytes_read = buflen;
 		}
-		memcpy ((char*)buf + bytes_copied, pskb->data, copy_len);
+		if (is_stream_copy)
+			pgm_memcpy_nt ((char*)buf + bytes_copied, pskb->data, copy_len);
+		else
+			memcpy ((char*)buf + bytes_copied, pskb->data, copy_len);
 		bytes_copied += copy_len;
 		pskb = *(++skb);
 	}
@@ -1021,14 +2671,78 @@ pgm_recvfrom (
 	return PGM_IO_STATUS_NORMAL;
 }
 
-/* Basic recv operation, copying data from window to application.
+/* read one contiguous apdu as a scatter list over its fragment payloads
+ * without copying.  the fragments are retained beyond the next read, the
+ * list is owned by the caller and released with pgm_apdu_free().
  *
  * on success, returns PGM_IO_STATUS_NORMAL.
  */
 
 int
-pgm_recv (
-	pgm_sock_t* const restrict sock,
+pgm_recvapdu (
+	pgm_sock_t*	 const restrict sock,
+	struct pgm_apdu_t**	  restrict apdu,
+	const int			   flags,		/* MSG_DONTWAIT for non-blocking */
+	size_t*			  restrict _bytes_read,	/* may be NULL */
+	pgm_error_t**		  restrict error
+	)
+{
+	struct pgm_msgv_t msgv;
+	size_t bytes_read = 0;
+
+	pgm_return_val_if_fail (NULL != sock, PGM_IO_STATUS_ERROR);
+	pgm_return_val_if_fail (NULL != apdu, PGM_IO_STATUS_ERROR);
+
+	pgm_debug ("pgm_recvapdu (sock:%p apdu:%p flags:%d bytes-read:%p error:%p)",
+		(const void*)sock, (const void*)apdu, flags, (const void*)_bytes_read, (const void*)error);
+
+	const int status = pgm_recvmsg (sock, &msgv, flags & ~(MSG_ERRQUEUE), &bytes_read, error);
+	if (PGM_IO_STATUS_NORMAL != status)
+		return status;
+
+/* one allocation for the list, vector and fragment references */
+	const unsigned count = msgv.msgv_len;
+	struct pgm_apdu_t* new_apdu = pgm_malloc (sizeof (struct pgm_apdu_t) +
+						  count * (sizeof (struct pgm_iovec) + sizeof (struct pgm_sk_buff_t*)));
+	new_apdu->apdu_len	= bytes_read;
+	new_apdu->apdu_iovlen	= count;
+	new_apdu->apdu_iov	= (struct pgm_iovec*)(new_apdu + 1);
+	new_apdu->apdu_skb	= (struct pgm_sk_buff_t**)(new_apdu->apdu_iov + count);
+	for (unsigned i = 0; i < count; i++) {
+		struct pgm_sk_buff_t* skb = pgm_skb_retain (msgv.msgv_skb[ i ]);
+		new_apdu->apdu_skb[ i ]			= skb;
+		new_apdu->apdu_iov[ i ].iov_base	= skb->data;
+		new_apdu->apdu_iov[ i ].iov_len		= skb->len;
+	}
+	*apdu = new_apdu;
+	if (_bytes_read)
+		*_bytes_read = bytes_read;
+	return PGM_IO_STATUS_NORMAL;
+}
+
+/* release every fragment of an apdu returned by pgm_recvapdu() and the list.
+ */
+
+void
+pgm_apdu_free (
+	struct pgm_apdu_t*	apdu
+	)
+{
+	if (NULL == apdu)
+		return;
+	for (unsigned i = 0; i < apdu->apdu_iovlen; i++)
+		pgm_free_skb (apdu->apdu_skb[ i ]);
+	pgm_free (apdu);
+}
+
+/* Basic recv operation, copying data from window to application.
+ *
+ * on success, returns PGM_IO_STATUS_NORMAL.
+ */
+
+int
+pgm_recv (
+	pgm_sock_t* const restrict sock,
 	void*		  restrict buf,
 	const size_t		   buflen,
 	const int		   flags,	/* MSG_DONTWAIT for non-blocking */
@@ -1045,4 +2759,701 @@ pgm_recv (
 	return pgm_recvfrom (sock, buf, buflen, flags, bytes_read, NULL, NULL, error);
 }
 
+/* release the slots and notification channel of an asynchronous receiver,
+ * every slot must be back on the free list.
+ */
+
+static
+void
+recv_async_free (
+	struct pgm_recv_async_t* const	async
+	)
+{
+	pgm_assert_cmpuint (async->free_len, ==, async->max_inflight);
+	for (unsigned i = 0; i < async->free_len; i++) {
+		pgm_free (async->slots[ i ]->msgv);
+		pgm_free (async->slots[ i ]);
+	}
+	pgm_notify_destroy (&async->notify);
+	pgm_cond_free (&async->cond);
+	pgm_mutex_free (&async->mutex);
+	pgm_free (async);
+}
+
+/* executor task: call back with a retained batch unless the receiver has
+ * stopped, then drop the packet references and return the slot.
+ */
+
+static
+void
+recv_async_run (
+	void*		arg
+	)
+{
+	struct pgm_recv_async_slot_t* slot = arg;
+	struct pgm_recv_async_t* async = slot->async;
+
+	pgm_mutex_lock (&async->mutex);
+	const bool is_live = !async->is_terminated;
+	if (is_live)
+		async->running++;
+	pgm_mutex_unlock (&async->mutex);
+
+	if (is_live)
+		async->callback (async->sock, slot->msgv, slot->len, slot->status, async->user_data);
+	for (size_t i = 0; i < slot->len; i++)
+		for (unsigned j = 0; j < slot->msgv[ i ].msgv_len; j++)
+			pgm_free_skb (slot->msgv[ i ].msgv_skb[ j ]);
+
+	pgm_mutex_lock (&async->mutex);
+	if (is_live && 0 == --async->running)
+		pgm_cond_signal (&async->cond);
+	async->slots[ async->free_len++ ] = slot;
+	const bool is_last = async->is_orphaned && async->free_len == async->max_inflight;
+	if (1 == async->free_len && !async->is_terminated)
+		pgm_notify_send (&async->notify);
+	pgm_mutex_unlock (&async->mutex);
+	if (is_last)
+		recv_async_free (async);
+}
+
+/* hand a batch to the application, directly on the receive thread or with
+ * packet references through the executor so the window may advance.
+ */
+
+static
+void
+recv_async_deliver (
+	struct pgm_recv_async_t*      const async,
+	struct pgm_recv_async_slot_t* const slot,
+	size_t				    bytes_read,
+	const int			    status
+	)
+{
+	slot->status = status;
+	slot->len = 0;
+	while (bytes_read > 0 && slot->len < async->max_msgv) {
+		const struct pgm_msgv_t* msgv = &slot->msgv[ slot->len++ ];
+		for (unsigned j = 0; j < msgv->msgv_len; j++)
+			bytes_read -= MIN(bytes_read, msgv->msgv_skb[ j ]->len);
+	}
+
+	if (NULL == async->executor) {
+		async->callback (async->sock, slot->msgv, slot->len, status, async->user_data);
+		pgm_mutex_lock (&async->mutex);
+		async->slots[ async->free_len++ ] = slot;
+		pgm_mutex_unlock (&async->mutex);
+		return;
+	}
+
+	for (size_t i = 0; i < slot->len; i++)
+		for (unsigned j = 0; j < slot->msgv[ i ].msgv_len; j++)
+			slot->msgv[ i ].msgv_skb[ j ] = pgm_skb_retain (slot->msgv[ i ].msgv_skb[ j ]);
+	async->executor (recv_async_run, slot, async->executor_data);
+}
+
+/* run due socket timers whilst every batch is in flight and the window is
+ * not being read, shards held by other readers are skipped.
+ */
+
+static
+void
+recv_async_timers (
+	pgm_sock_t* const	sock
+	)
+{
+	if (!pgm_rwlock_reader_trylock (&sock->lock))
+		return;
+	if (!sock->is_destroyed && pgm_timer_check (sock)) {
+		for (unsigned i = 0; i < sock->rx_shard_len; i++) {
+			struct pgm_rx_shard_t* shard = &sock->rx_shard[ i ];
+			if (pgm_mutex_trylock (&shard->mutex)) {
+				pgm_timer_dispatch (sock, shard);
+				pgm_mutex_unlock (&shard->mutex);
+				break;
+			}
+		}
+	}
+	pgm_rwlock_reader_unlock (&sock->lock);
+}
+
+/* wait up to timeout microseconds on the notification channel, and on the
+ * receive descriptors when a slot is free to read into.  a negative timeout
+ * waits on the channel alone.
+ */
+
+static
+void
+recv_thread_wait (
+	pgm_sock_t*	const restrict sock,
+	pgm_notify_t*	const restrict notify,
+	const bool		       is_readable,
+	const long		       timeout		/* μs */
+	)
+{
+	const SOCKET notify_fd = pgm_notify_get_socket (notify);
+#ifdef HAVE_POLL
+	int n_fds = 3 + sock->recv_shards;
+	struct pollfd fds[ 1 + n_fds ];
+	memset (fds, 0, sizeof(fds));
+	if (!is_readable || SOCKET_ERROR == pgm_poll_info (sock, fds, &n_fds, POLLIN))
+		n_fds = 0;
+	fds[ n_fds ].fd = notify_fd;
+	fds[ n_fds ].events = POLLIN;
+	poll (fds, 1 + n_fds, (int)WAIT_MSECS(timeout));
+#else
+	fd_set readfds;
+	FD_ZERO(&readfds);
+	FD_SET(notify_fd, &readfds);
+#	ifndef _WIN32
+	int n_fds = notify_fd + 1;	/* largest fd + 1 */
+#	else
+	int n_fds = 1;			/* count of fds */
+#	endif
+	if (is_readable)
+		pgm_select_info (sock, &readfds, NULL, &n_fds);
+	struct timeval tv = {
+		.tv_sec		= timeout / 1000000L,
+		.tv_usec	= timeout % 1000000L
+	};
+	select (n_fds, &readfds, NULL, NULL, timeout < 0 ? NULL : &tv);
+#endif /* HAVE_POLL */
+	pgm_notify_clear (notify);
+}
+
+static
+#ifndef _WIN32
+void*
+#else
+unsigned
+__stdcall
+#endif
+recv_async_routine (
+	void*		arg
+	)
+{
+	struct pgm_recv_async_t* async = arg;
+	pgm_sock_t* sock = async->sock;
+
+	if (sock->numa_node >= 0)
+		pgm_numa_bind_thread (sock->numa_node);
+	pgm_thread_setup ("recv");
+	for (;;)
+	{
+		pgm_mutex_lock (&async->mutex);
+		if (async->is_terminated) {
+			pgm_mutex_unlock (&async->mutex);
+			break;
+		}
+		struct pgm_recv_async_slot_t* slot = async->free_len ? async->slots[ --async->free_len ] : NULL;
+		pgm_mutex_unlock (&async->mutex);
+
+/* backpressure: leave data in the receive window until a batch returns */
+		if (NULL == slot) {
+			recv_async_timers (sock);
+			recv_thread_wait (sock, &async->notify, FALSE, (long)pgm_timer_expiration (sock));
+			continue;
+		}
+
+		size_t bytes_read = 0;
+		const int status = pgm_recvmsgv (sock, slot->msgv, async->max_msgv, MSG_DONTWAIT, &bytes_read, NULL);
+		long timeout;
+		switch (status) {
+		case PGM_IO_STATUS_NORMAL:
+		case PGM_IO_STATUS_RESET:
+		case PGM_IO_STATUS_FIN:
+			recv_async_deliver (async, slot, bytes_read, status);
+			continue;
+		case PGM_IO_STATUS_RATE_LIMITED:
+			timeout = (long)pgm_rate_remaining2 (&sock->rate_control, &sock->odata_rate_control, sock->blocklen);
+			break;
+		case PGM_IO_STATUS_TIMER_PENDING:
+		case PGM_IO_STATUS_WOULD_BLOCK:
+			timeout = (long)pgm_timer_expiration (sock);
+/* the shared memory ring is not a descriptor, poll it */
+			if (pgm_shm_is_reader (sock->shm))
+				timeout = MIN(timeout, (long)sock->shm->interval);
+			break;
+		default:
+/* closed socket, report once and stop reading */
+			recv_async_deliver (async, slot, 0, sock->is_destroyed ? PGM_IO_STATUS_EOF : status);
+			if (sock->is_destroyed || PGM_IO_STATUS_EOF == status)
+				goto out;
+			timeout = (long)pgm_timer_expiration (sock);
+			recv_thread_wait (sock, &async->notify, TRUE, timeout);
+			continue;
+		}
+		pgm_mutex_lock (&async->mutex);
+		async->slots[ async->free_len++ ] = slot;
+		pgm_mutex_unlock (&async->mutex);
+		recv_thread_wait (sock, &async->notify, TRUE, timeout);
+	}
+
+out:
+#ifndef _WIN32
+	return NULL;
+#else
+	_endthread();
+	return 0;
+#endif
+}
+
+/* Start delivering received messages to a callback from a library thread,
+ * with the socket connected.  Without an executor the callback runs on the
+ * receive thread and messages are valid until it returns.  With an executor
+ * each batch holds packet references until its callback returns, and reading
+ * pauses whilst max_inflight batches are queued.  Timers are serviced by the
+ * thread.  Do not read the socket elsewhere, nor close the socket or stop
+ * delivery from within the callback.
+ *
+ * on success, returns TRUE, on failure returns FALSE and sets error.
+ */
+
+bool
+pgm_recv_async_start (
+	pgm_sock_t*			const restrict sock,
+	const struct pgm_recvasyncinfo_t* const restrict info,
+	pgm_error_t**			      restrict error
+	)
+{
+	struct pgm_recv_async_t* async;
+
+	pgm_return_val_if_fail (NULL != sock, FALSE);
+	pgm_return_val_if_fail (NULL != info, FALSE);
+	pgm_return_val_if_fail (NULL != info->callback, FALSE);
+	if (PGM_UNLIKELY(!pgm_rwlock_writer_trylock (&sock->lock)))
+		pgm_return_val_if_reached (FALSE);
+/* an exclusive socket is read by the application thread alone */
+	if (PGM_UNLIKELY(!sock->is_connected || sock->is_destroyed || sock->is_exclusive || NULL != sock->recv_async || NULL != sock->recv_drain)) {
+		pgm_rwlock_writer_unlock (&sock->lock);
+		pgm_return_val_if_reached (FALSE);
+	}
+
+	pgm_debug ("pgm_recv_async_start (sock:%p info:%p error:%p)",
+		(const void*)sock, (const void*)info, (const void*)error);
+
+/* one slot suffices when the thread waits on the callback */
+	const unsigned max_inflight = NULL == info->executor ? 1 : (info->max_inflight ? info->max_inflight : PGM_RECV_ASYNC_INFLIGHT);
+	async = pgm_malloc0 (sizeof(struct pgm_recv_async_t) + (max_inflight * sizeof(struct pgm_recv_async_slot_t*)));
+	async->sock		= sock;
+	async->callback		= info->callback;
+	async->user_data	= info->user_data;
+	async->executor		= info->executor;
+	async->executor_data	= info->executor_data;
+	async->max_msgv		= info->max_msgv ? info->max_msgv : PGM_RECV_ASYNC_MSGV;
+	async->max_inflight	= max_inflight;
+	if (0 != pgm_notify_init (&async->notify)) {
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			     PGM_ERROR_DOMAIN_RECV,
+			     pgm_error_from_errno (save_errno),
+			     _("Creating receive thread notification channel: %s"),
+			     pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		pgm_free (async);
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	pgm_mutex_init (&async->mutex);
+	pgm_cond_init (&async->cond);
+	for (unsigned i = 0; i < max_inflight; i++) {
+		struct pgm_recv_async_slot_t* slot = pgm_new0 (struct pgm_recv_async_slot_t, 1);
+		slot->async = async;
+		slot->msgv = pgm_new0 (struct pgm_msgv_t, async->max_msgv);
+		async->slots[ async->free_len++ ] = slot;
+	}
+
+#ifndef _WIN32
+	const int status = pthread_create (&async->thread, NULL, &recv_async_routine, async);
+	if (0 != status) {
+		const int save_errno = status;
+#else
+	async->thread = (HANDLE)_beginthreadex (NULL, 0, &recv_async_routine, async, 0, NULL);
+	if (0 == async->thread) {
+		const int save_errno = errno;
+#endif /* _WIN32 */
+		char errbuf[1024];
+		pgm_set_error (error,
+			     PGM_ERROR_DOMAIN_RECV,
+			     pgm_error_from_errno (save_errno),
+			     _("Creating receive thread: %s"),
+			     pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		recv_async_free (async);
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	sock->recv_async = async;
+	pgm_rwlock_writer_unlock (&sock->lock);
+	return TRUE;
+}
+
+/* stop the receive thread and wait for running callbacks, batches still
+ * queued on the executor are released without calling back.  called by
+ * pgm_recv_async_stop() and pgm_close().
+ */
+
+void
+pgm_recv_async_destroy (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_recv_async_t* async;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->recv_async);
+
+	async = sock->recv_async;
+	pgm_mutex_lock (&async->mutex);
+	async->is_terminated = TRUE;
+	pgm_notify_send (&async->notify);
+	pgm_mutex_unlock (&async->mutex);
+#ifndef _WIN32
+	pthread_join (async->thread, NULL);
+#else
+	WaitForSingleObject (async->thread, INFINITE);
+	CloseHandle (async->thread);
+#endif
+	sock->recv_async = NULL;
+	pgm_mutex_lock (&async->mutex);
+	while (async->running > 0)
+#ifndef _WIN32
+		pgm_cond_wait (&async->cond, &async->mutex.pthread_mutex);
+#else
+		pgm_cond_wait (&async->cond, &async->mutex.win32_crit);
+#endif
+	async->is_orphaned = (async->free_len < async->max_inflight);
+	const bool is_idle = !async->is_orphaned;
+	pgm_mutex_unlock (&async->mutex);
+	if (is_idle)
+		recv_async_free (async);
+}
+
+/* stop asynchronous delivery, the socket may be read directly afterwards.
+ *
+ * on success, returns TRUE, returns FALSE if delivery was not started.
+ */
+
+bool
+pgm_recv_async_stop (
+	pgm_sock_t* const	sock
+	)
+{
+	pgm_return_val_if_fail (NULL != sock, FALSE);
+	if (PGM_UNLIKELY(!pgm_rwlock_reader_trylock (&sock->lock)))
+		pgm_return_val_if_reached (FALSE);
+	if (PGM_UNLIKELY(NULL == sock->recv_async || sock->is_destroyed)) {
+		pgm_rwlock_reader_unlock (&sock->lock);
+		return FALSE;
+	}
+	pgm_recv_async_destroy (sock);
+	pgm_rwlock_reader_unlock (&sock->lock);
+	return TRUE;
+}
+
+/* publish entries up to head, waking a reader caught up with the last head.
+ */
+
+static
+void
+recv_drain_publish (
+	struct pgm_recv_drain_t* const	drain,
+	const uint32_t			head
+	)
+{
+	const uint32_t last_head = drain->head;
+
+	if (head == last_head)
+		return;
+/* store head before loading read, pairs with the reader checking head once
+ * the notification is clear.
+ */
+	pgm_atomic_write32_release (&drain->head, head);
+	pgm_atomic_fence ();
+	if (pgm_atomic_read32 (&drain->read) == last_head)
+		pgm_notify_send (&drain->ready);
+}
+
+/* append a status for the reader at head, with the error of the read.
+ */
+
+static
+uint32_t
+recv_drain_status (
+	struct pgm_recv_drain_t* const restrict drain,
+	uint32_t				head,
+	const int				status,
+	pgm_error_t*		       restrict error
+	)
+{
+	struct pgm_recv_drain_entry_t* entry = &drain->entries[ head & (drain->len - 1) ];
+	entry->status		= status;
+	entry->error		= error;
+	entry->msgv.msgv_len	= 0;
+	return head + 1;
+}
+
+static
+#ifndef _WIN32
+void*
+#else
+unsigned
+__stdcall
+#endif
+recv_drain_routine (
+	void*		arg
+	)
+{
+	struct pgm_recv_drain_t* drain = arg;
+	pgm_sock_t* sock = drain->sock;
+
+	if (sock->numa_node >= 0)
+		pgm_numa_bind_thread (sock->numa_node);
+	pgm_thread_setup ("recv");
+	while (!pgm_atomic_read32 (&drain->is_terminated))
+	{
+		uint32_t head = drain->head;
+		const uint32_t space = drain->len - (head - pgm_atomic_read32_acquire (&drain->tail));
+
+/* backpressure: one entry kept for the status of a read */
+		if (space <= 1) {
+			recv_async_timers (sock);
+			recv_thread_wait (sock, &drain->notify, FALSE, (long)pgm_timer_expiration (sock));
+			continue;
+		}
+
+		pgm_rxw_cursor_t cursor;
+		pgm_error_t* error = NULL;
+		pgm_rxw_cursor_init_msgv (&cursor, drain->batch, MIN(space - 1, PGM_RECV_DRAIN_BATCH));
+		const int status = recvcursor (sock, &cursor, MSG_DONTWAIT, 0, NULL, &error);
+
+/* references let the window advance whilst the reader holds the messages */
+		for (const struct pgm_msgv_t* msgv = drain->batch; msgv < cursor.msgv; msgv++) {
+			struct pgm_recv_drain_entry_t* entry = &drain->entries[ head++ & (drain->len - 1) ];
+			entry->status		= PGM_IO_STATUS_NORMAL;
+			entry->error		= NULL;
+			entry->msgv.msgv_len	= msgv->msgv_len;
+			for (unsigned j = 0; j < msgv->msgv_len; j++)
+				entry->msgv.msgv_skb[ j ] = pgm_skb_retain (msgv->msgv_skb[ j ]);
+		}
+
+		long timeout;
+		switch (status) {
+		case PGM_IO_STATUS_NORMAL:
+			recv_drain_publish (drain, head);
+			continue;
+		case PGM_IO_STATUS_RESET:
+		case PGM_IO_STATUS_FIN:
+			recv_drain_publish (drain, recv_drain_status (drain, head, status, error));
+			continue;
+		case PGM_IO_STATUS_RATE_LIMITED:
+			timeout = (long)pgm_rate_remaining2 (&sock->rate_control, &sock->odata_rate_control, sock->blocklen);
+			break;
+		case PGM_IO_STATUS_TIMER_PENDING:
+		case PGM_IO_STATUS_WOULD_BLOCK:
+			timeout = (long)pgm_timer_expiration (sock);
+/* the shared memory ring is not a descriptor, poll it */
+			if (pgm_shm_is_reader (sock->shm))
+				timeout = MIN(timeout, (long)sock->shm->interval);
+			break;
+		default:
+/* closed socket, report once and stop reading */
+			recv_drain_publish (drain, recv_drain_status (drain, head, sock->is_destroyed ? PGM_IO_STATUS_EOF : status, error));
+			if (sock->is_destroyed || PGM_IO_STATUS_EOF == status)
+				goto out;
+			timeout = (long)pgm_timer_expiration (sock);
+			break;
+		}
+		if (NULL != error)
+			pgm_error_free (error);
+		recv_drain_publish (drain, head);
+		recv_thread_wait (sock, &drain->notify, TRUE, timeout);
+	}
+
+out:
+#ifndef _WIN32
+	return NULL;
+#else
+	_endthread();
+	return 0;
+#endif
+}
+
+/* Drain the receive sockets from a library thread into a ring of len
+ * messages, with the socket connected.  The thread parses packets, services
+ * timers and completes messages into the ring whilst pgm_recvmsgv() and the
+ * functions over it read from the ring on one application thread, such that
+ * the kernel buffers are emptied however slowly the application reads.
+ * Messages remain valid until the next read.  A full ring stops the thread
+ * reading and leaves data to the kernel.  Wait for messages on
+ * PGM_PENDING_SOCK.
+ *
+ * on success, returns TRUE, on failure returns FALSE and sets error.
+ */
+
+bool
+pgm_recv_drain_start (
+	pgm_sock_t*	const restrict sock,
+	const unsigned		       len,		/* messages, 0 = default */
+	pgm_error_t**	      restrict error
+	)
+{
+	struct pgm_recv_drain_t* drain;
+
+	pgm_return_val_if_fail (NULL != sock, FALSE);
+	if (PGM_UNLIKELY(!pgm_rwlock_writer_trylock (&sock->lock)))
+		pgm_return_val_if_reached (FALSE);
+/* an exclusive socket is read by the application thread alone */
+	if (PGM_UNLIKELY(!sock->is_connected || sock->is_destroyed || sock->is_exclusive || NULL != sock->recv_async || NULL != sock->recv_drain)) {
+		pgm_rwlock_writer_unlock (&sock->lock);
+		pgm_return_val_if_reached (FALSE);
+	}
+
+	pgm_debug ("pgm_recv_drain_start (sock:%p len:%u error:%p)",
+		(const void*)sock, len, (const void*)error);
+
+/* room for a batch and the status of its read */
+	const uint32_t drain_len = (uint32_t)pgm_nearest_power (1, MAX(len ? len : PGM_RECV_DRAIN_LEN, 2 * PGM_RECV_DRAIN_BATCH));
+	drain = pgm_malloc0 (sizeof(struct pgm_recv_drain_t) + (drain_len * sizeof(struct pgm_recv_drain_entry_t)));
+	drain->sock	= sock;
+	drain->len	= drain_len;
+	if (0 != pgm_notify_init (&drain->notify) ||
+	    0 != pgm_notify_init (&drain->ready))
+	{
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			     PGM_ERROR_DOMAIN_RECV,
+			     pgm_error_from_errno (save_errno),
+			     _("Creating drain thread notification channel: %s"),
+			     pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		if (pgm_notify_is_valid (&drain->notify))
+			pgm_notify_destroy (&drain->notify);
+		pgm_free (drain);
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	pgm_mutex_init (&drain->mutex);
+	pgm_cond_init (&drain->cond);
+	drain->batch = pgm_new (struct pgm_msgv_t, PGM_RECV_DRAIN_BATCH);
+
+#ifndef _WIN32
+	const int status = pthread_create (&drain->thread, NULL, &recv_drain_routine, drain);
+	if (0 != status) {
+		const int save_errno = status;
+#else
+	drain->thread = (HANDLE)_beginthreadex (NULL, 0, &recv_drain_routine, drain, 0, NULL);
+	if (0 == drain->thread) {
+		const int save_errno = errno;
+#endif /* _WIN32 */
+		char errbuf[1024];
+		pgm_set_error (error,
+			     PGM_ERROR_DOMAIN_RECV,
+			     pgm_error_from_errno (save_errno),
+			     _("Creating drain thread: %s"),
+			     pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		pgm_free (drain->batch);
+		pgm_cond_free (&drain->cond);
+		pgm_mutex_free (&drain->mutex);
+		pgm_notify_destroy (&drain->ready);
+		pgm_notify_destroy (&drain->notify);
+		pgm_free (drain);
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	sock->recv_drain = drain;
+	pgm_rwlock_writer_unlock (&sock->lock);
+	return TRUE;
+}
+
+/* stop the drain thread, wake and wait out a blocked reader, and release the
+ * messages left in the ring.  called by pgm_recv_drain_stop() and
+ * pgm_close().
+ */
+
+void
+pgm_recv_drain_destroy (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_recv_drain_t* drain;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->recv_drain);
+
+	drain = sock->recv_drain;
+	pgm_mutex_lock (&drain->mutex);
+	pgm_atomic_write32 (&drain->is_terminated, TRUE);
+	pgm_notify_send (&drain->notify);
+	pgm_notify_send (&drain->ready);
+	while (drain->is_reading)
+#ifndef _WIN32
+		pgm_cond_wait (&drain->cond, &drain->mutex.pthread_mutex);
+#else
+		pgm_cond_wait (&drain->cond, &drain->mutex.win32_crit);
+#endif
+	pgm_mutex_unlock (&drain->mutex);
+#ifndef _WIN32
+	pthread_join (drain->thread, NULL);
+#else
+	WaitForSingleObject (drain->thread, INFINITE);
+	CloseHandle (drain->thread);
+#endif
+	sock->recv_drain = NULL;
+
+/* read or not, every message still references its packets */
+	drain->read = drain->head;
+	recv_drain_release (drain);
+	pgm_free (drain->batch);
+	for (uint32_t i = 0; i < drain->len; i++)
+		if (NULL != drain->entries[ i ].error)
+			pgm_error_free (drain->entries[ i ].error);
+	pgm_cond_free (&drain->cond);
+	pgm_mutex_free (&drain->mutex);
+	pgm_notify_destroy (&drain->ready);
+	pgm_notify_destroy (&drain->notify);
+	pgm_free (drain);
+}
+
+/* descriptor readable whilst messages are waiting to be read, of the drain
+ * ring when draining.
+ */
+
+PGM_GNUC_INTERNAL
+SOCKET
+pgm_recv_pending_socket (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	if (NULL != sock->recv_drain)
+		return pgm_notify_get_socket (&sock->recv_drain->ready);
+	return pgm_notify_get_socket (&sock->pending_notify);
+}
+
+/* stop draining, the socket may be read directly afterwards.
+ *
+ * on success, returns TRUE, returns FALSE if draining was not started.
+ */
+
+bool
+pgm_recv_drain_stop (
+	pgm_sock_t* const	sock
+	)
+{
+	pgm_return_val_if_fail (NULL != sock, FALSE);
+	if (PGM_UNLIKELY(!pgm_rwlock_reader_trylock (&sock->lock)))
+		pgm_return_val_if_reached (FALSE);
+	if (PGM_UNLIKELY(NULL == sock->recv_drain || sock->is_destroyed)) {
+		pgm_rwlock_reader_unlock (&sock->lock);
+		return FALSE;
+	}
+	pgm_recv_drain_destroy (sock);
+	pgm_rwlock_reader_unlock (&sock->lock);
+	return TRUE;
+}
+
 /* eof */
@@ -83,6 +83,7 @@ static gboolean mock_data_on_spmr = FALSE;
 static struct pgm_peer_t* mock_peer = NULL;
 GList* mock_data_list = NULL;
 unsigned mock_pgm_loss_rate = 0;
+unsigned mock_pgm_loss_burst = 0;
 
 
 #ifndef _WIN32
@@ -93,15 +94,21 @@ static int mock_recvfrom (SOCKET, char*, int, int, struct sockaddr*, int*);
 
 #define pgm_parse_raw			mock_pgm_parse_raw
 #define pgm_parse_udp_encap		mock_pgm_parse_udp_encap
+#define pgm_parse_strerror_s		mock_pgm_parse_strerror_s
+#define pgm_parse_csum_batch		mock_pgm_parse_csum_batch
 #define pgm_verify_spm			mock_pgm_verify_spm
 #define pgm_verify_nak			mock_pgm_verify_nak
 #define pgm_verify_ncf			mock_pgm_verify_ncf
 #define pgm_select_info			mock_pgm_select_info
 #define pgm_poll_info			mock_pgm_poll_info
 #define pgm_set_reset_error		mock_pgm_set_reset_error
+#define pgm_flightrec_log		mock_pgm_flightrec_log
 #define pgm_flush_peers_pending		mock_pgm_flush_peers_pending
 #define pgm_peer_has_pending		mock_pgm_peer_has_pending
 #define pgm_peer_set_pending		mock_pgm_peer_set_pending
+#define pgm_collect_decoded		mock_pgm_collect_decoded
+#define pgm_decode_pool_rearm		mock_pgm_decode_pool_rearm
+#define pgm_peer_timer_update		mock_pgm_peer_timer_update
 #define pgm_txw_retransmit_is_empty	mock_pgm_txw_retransmit_is_empty
 #define pgm_rxw_create			mock_pgm_rxw_create
 #define pgm_rxw_readv			mock_pgm_rxw_readv
@@ -109,23 +116,46 @@ static int mock_recvfrom (SOCKET, char*, int, int, struct sockaddr*, int*);
 #define pgm_on_data			mock_pgm_on_data
 #define pgm_on_spm			mock_pgm_on_spm
 #define pgm_on_ack			mock_pgm_on_ack
+#define pgm_on_polr			mock_pgm_on_polr
 #define pgm_on_nak			mock_pgm_on_nak
 #define pgm_on_deferred_nak		mock_pgm_on_deferred_nak
+#define pgm_ncf_batch_flush		mock_pgm_ncf_batch_flush
 #define pgm_on_peer_nak			mock_pgm_on_peer_nak
+#define pgm_on_dlr_nak			mock_pgm_on_dlr_nak
 #define pgm_on_nnak			mock_pgm_on_nnak
 #define pgm_on_ncf			mock_pgm_on_ncf
 #define pgm_on_spmr			mock_pgm_on_spmr
-#define pgm_sendto			mock_pgm_sendto
+#define pgm_sendto_hops			mock_pgm_sendto_hops
+#define pgm_rx_timestamp		mock_pgm_rx_timestamp
+#define pgm_rxq_ovfl			mock_pgm_rxq_ovfl
+#define pgm_rx_tune_rcvbuf		mock_pgm_rx_tune_rcvbuf
+#define pgm_rxw_set_max_length		mock_pgm_rxw_set_max_length
+#define pgm_xdp_recvskb			mock_pgm_xdp_recvskb
+#define pgm_replay_recvskb		mock_pgm_replay_recvskb
+#define pgm_shm_recvskb			mock_pgm_shm_recvskb
+#define pgm_loop_recvskb		mock_pgm_loop_recvskb
+#define pgm_loop_rearm			mock_pgm_loop_rearm
+#define pgm_uring_recvskb		mock_pgm_uring_recvskb
+#define pgm_recv_shards_recvmsg		mock_pgm_recv_shards_recvmsg
+#define pgm_demux_dispatch		mock_pgm_demux_dispatch
+#define pgm_demux_pop			mock_pgm_demux_pop
+#define pgm_demux_rearm			mock_pgm_demux_rearm
 #define pgm_timer_prepare		mock_pgm_timer_prepare
 #define pgm_timer_check			mock_pgm_timer_check
+#define pgm_timer_check_at		mock_pgm_timer_check_at
 #define pgm_timer_expiration		mock_pgm_timer_expiration
 #define pgm_timer_dispatch		mock_pgm_timer_dispatch
+#define pgm_timer_event_arm		mock_pgm_timer_event_arm
+#define pgm_numa_bind_thread		mock_pgm_numa_bind_thread
 #define pgm_time_now			mock_pgm_time_now
 #define pgm_time_update_now		mock_pgm_time_update_now
+#define pgm_time_is_coarse		mock_pgm_time_is_coarse
+#define pgm_time_cached			mock_pgm_time_cached
 #define recvmsg				mock_recvmsg
 #define recvfrom			mock_recvfrom
 #define pgm_WSARecvMsg			mock_pgm_WSARecvMsg
 #define pgm_loss_rate			mock_pgm_loss_rate
+#define pgm_loss_burst			mock_pgm_loss_burst
 
 #define RECV_DEBUG
 #include "recv.c"
@@ -155,6 +185,7 @@ mock_teardown (void)
 	mock_peer = NULL;
 	mock_data_list = NULL;
 	mock_pgm_loss_rate = 0;
+	mock_pgm_loss_burst = 0;
 }
 
 static
@@ -168,20 +199,27 @@ generate_sock (void)
 	sock->is_nonblocking = TRUE;
 	sock->is_bound = TRUE;
 	sock->is_destroyed = FALSE;
-	sock->is_reset = FALSE;
-	sock->rx_buffer = pgm_alloc_skb (TEST_MAX_TPDU);
+	sock->rx_shard = g_new0 (struct pgm_rx_shard_t, 1);
+	sock->rx_shard_len = 1;
+	sock->rx_shard->is_reset = FALSE;
+	sock->rx_shard->rx_buffer = pgm_alloc_skb (TEST_MAX_TPDU);
 	sock->max_tpdu = TEST_MAX_TPDU;
+	sock->wait_fd = INVALID_SOCKET;
+	sock->event_sock = INVALID_SOCKET;
+	sock->event_timer_fd = INVALID_SOCKET;
 	sock->rxw_sqns = TEST_RXW_SQNS;
 	sock->dport = g_htons((guint16)TEST_DPORT);
 	sock->can_send_data = TRUE;
 	sock->can_send_nak = TRUE;
 	sock->can_recv_data = TRUE;
-	sock->peers_hashtable = pgm_hashtable_new (pgm_tsi_hash, pgm_tsi_equal);
+	sock->rx_shard->peers_table = pgm_peer_table_new (0);
+	sock->recv_shards = 1;
 	pgm_rand_create (&sock->rand_);
 	sock->nak_bo_ivl = 100*1000;
 	pgm_notify_init (&sock->pending_notify);
 	pgm_notify_init (&sock->rdata_notify);
-	pgm_mutex_init (&sock->receiver_mutex);
+	pgm_mutex_init (&sock->rx_shard->mutex);
+	pgm_mutex_init (&sock->pending_mutex);
 	pgm_rwlock_init (&sock->lock);
 	pgm_rwlock_init (&sock->peers_lock);
 	return sock;
@@ -560,7 +598,7 @@ bool
 mock_pgm_parse_raw (
 	struct pgm_sk_buff_t* const	skb,
 	struct sockaddr* const		dst,
-	pgm_error_t**			error
+	pgm_parse_error_t*		error
 	)
 {
 	const struct pgm_ip* ip = (struct pgm_ip*)skb->data;
@@ -579,7 +617,8 @@ mock_pgm_parse_raw (
 bool
 mock_pgm_parse_udp_encap (
 	struct pgm_sk_buff_t* const	skb,
-	pgm_error_t**			error
+	const bool			allow_zero_checksum,
+	pgm_parse_error_t*		error
 	)
 {
 	skb->pgm_header = skb->data;
@@ -588,6 +627,26 @@ mock_pgm_parse_udp_encap (
 	return TRUE;
 }
 
+char*
+mock_pgm_parse_strerror_s (
+	char*				buf,
+	size_t				buflen,
+	const pgm_parse_error_t*	error
+	)
+{
+	g_strlcpy (buf, NULL == error->format ? "(null)" : error->format, buflen);
+	return buf;
+}
+
+void
+mock_pgm_parse_csum_batch (
+	struct pgm_sk_buff_t*const*const	skbs,
+	const unsigned				count,
+	const bool				with_ip_header
+	)
+{
+}
+
 bool
 mock_pgm_verify_spm (
 	const struct pgm_sk_buff_t* const	skb
@@ -670,8 +729,9 @@ mock_pgm_new_peer (
 					    sock->rxw_max_rte,
 					    sock->ack_c_p);
 	peer->spmr_expiry = now + sock->spmr_expiry;
+	peer->shard = sock->rx_shard;
 	gpointer entry = mock__pgm_peer_ref(peer);
-	pgm_hashtable_insert (sock->peers_hashtable, &peer->tsi, entry);
+	pgm_peer_table_insert (sock->rx_shard->peers_table, &peer->tsi, entry);
 	peer->peers_link.next = sock->peers_list;
 	peer->peers_link.data = peer;
 	if (sock->peers_list)
@@ -685,7 +745,15 @@ void
 mock_pgm_set_reset_error (
 	pgm_sock_t* const          sock,
 	pgm_peer_t* const               source,
-	struct pgm_msgv_t* const	msgv
+	pgm_rxw_cursor_t* const		cursor
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_flightrec_log (
+	const pgm_flightrec_t* const	fr
 	)
 {
 }
@@ -694,8 +762,8 @@ PGM_GNUC_INTERNAL
 int
 mock_pgm_flush_peers_pending (
 	pgm_sock_t* const          sock,
-	struct pgm_msgv_t**		pmsg,
-	const struct pgm_msgv_t* const	msg_end,
+	struct pgm_rx_shard_t* const	shard,
+	pgm_rxw_cursor_t* const		cursor,
 	size_t* const			bytes_read,
 	unsigned* const			data_read
 	)
@@ -703,20 +771,19 @@ mock_pgm_flush_peers_pending (
 	if (mock_data_list) {
 		size_t len = 0;
 		unsigned count = 0;
-		while (mock_data_list && *pmsg <= msg_end) {
+		while (mock_data_list && !pgm_rxw_cursor_is_full (cursor)) {
 			 struct pgm_msgv_t* mock_msgv = mock_data_list->data;
-			(*pmsg)->msgv_len = mock_msgv->msgv_len;
 			for (unsigned i = 0; i < mock_msgv->msgv_len; i++) {
-				(*pmsg)->msgv_skb[i] = mock_msgv->msgv_skb[i];
+				pgm_rxw_cursor_append (cursor, mock_msgv->msgv_skb[i]);
 				len += mock_msgv->msgv_skb[i]->len;
 			}
+			pgm_rxw_cursor_next (cursor);
 			count++;
-			(*pmsg)++;
 			mock_data_list = g_list_delete_link (mock_data_list, mock_data_list);
 		}
 		*bytes_read = len;
 		*data_read = count;
-		if (*pmsg > msg_end)
+		if (pgm_rxw_cursor_is_full (cursor))
 			return -PGM_SOCK_ENOBUFS;
 	}
 	return 0;
@@ -731,6 +798,24 @@ mock_pgm_peer_has_pending (
 	return FALSE;
 }
 
+PGM_GNUC_INTERNAL
+void
+mock_pgm_collect_decoded (
+	pgm_sock_t* const		sock,
+	struct pgm_rx_shard_t* const	shard
+	)
+{
+	shard->decode_ready = 0;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_decode_pool_rearm (
+	pgm_sock_t* const		sock
+	)
+{
+}
+
 PGM_GNUC_INTERNAL
 void
 mock_pgm_peer_set_pending (
@@ -742,8 +827,19 @@ mock_pgm_peer_set_pending (
 	g_assert (NULL != peer);
 	if (peer->pending_link.data) return;
 	peer->pending_link.data = peer;
-	peer->pending_link.next = sock->peers_pending;
-	sock->peers_pending = &peer->pending_link;
+	peer->pending_link.next = peer->shard->peers_pending;
+	peer->shard->peers_pending = &peer->pending_link;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_peer_timer_update (
+	pgm_sock_t* const          sock,
+	pgm_peer_t* const               peer
+	)
+{
+	g_assert (NULL != sock);
+	g_assert (NULL != peer);
 }
 
 PGM_GNUC_INTERNAL
@@ -774,6 +870,19 @@ mock_pgm_on_ack (
 	return TRUE;
 }
 
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_on_polr (
+	pgm_sock_t* const		sock,
+	struct pgm_sk_buff_t* const	skb
+	)
+{
+	g_debug ("mock_pgm_on_polr (sock:%p skb:%p)",
+		(gpointer)sock, (gpointer)skb);
+	mock_pgm_type = PGM_POLR;
+	return TRUE;
+}
+
 PGM_GNUC_INTERNAL
 bool
 mock_pgm_on_deferred_nak (
@@ -783,15 +892,24 @@ mock_pgm_on_deferred_nak (
 	return TRUE;
 }
 
+PGM_GNUC_INTERNAL
+void
+mock_pgm_ncf_batch_flush (
+	pgm_sock_t* const		sock
+	)
+{
+}
+
 PGM_GNUC_INTERNAL
 bool
 mock_pgm_on_nak (
 	pgm_sock_t* const		sock,
+	const struct sockaddr* const	src_addr,
 	struct pgm_sk_buff_t* const	skb
 	)
 {
-	g_debug ("mock_pgm_on_nak (sock:%p skb:%p)",
-		(gpointer)sock, (gpointer)skb);
+	g_debug ("mock_pgm_on_nak (sock:%p src-addr:%p skb:%p)",
+		(gpointer)sock, (gpointer)src_addr, (gpointer)skb);
 	mock_pgm_type = PGM_NAK;
 	return TRUE;
 }
@@ -810,6 +928,21 @@ mock_pgm_on_peer_nak (
 	return TRUE;
 }
 
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_on_dlr_nak (
+	pgm_sock_t* const		sock,
+	pgm_peer_t* const		sender,
+	const struct sockaddr* const	nak_src,
+	struct pgm_sk_buff_t* const	skb
+	)
+{
+	g_debug ("mock_pgm_on_dlr_nak (sock:%p sender:%p skb:%p)",
+		(gpointer)sock, (gpointer)sender, (gpointer)skb);
+	mock_pgm_type = PGM_NAK;
+	return TRUE;
+}
+
 PGM_GNUC_INTERNAL
 bool
 mock_pgm_on_ncf (
@@ -863,7 +996,7 @@ mock_pgm_on_spmr (
 		(gpointer)sock, (gpointer)peer, (gpointer)skb);
 	mock_pgm_type = PGM_SPMR;
 	if (mock_reset_on_spmr) {
-		sock->is_reset = TRUE;
+		sock->rx_shard->is_reset = TRUE;
 		mock_pgm_peer_set_pending (sock, mock_peer);
 	}
 	if (mock_data_on_spmr) {
@@ -909,10 +1042,12 @@ mock_pgm_rxw_readv (
 /** net module */
 PGM_GNUC_INTERNAL
 ssize_t
-mock_pgm_sendto (
+mock_pgm_sendto_hops (
 	pgm_sock_t*		sock,
 	bool				use_rate_limit,
+	pgm_rate_t*			minor_rate_control,
 	bool				use_router_alert,
+	int				hops,
 	const void*			buf,
 	size_t				len,
 	const struct sockaddr*		to,
@@ -922,6 +1057,177 @@ mock_pgm_sendto (
 	return len;
 }
 
+PGM_GNUC_INTERNAL
+pgm_time_t
+mock_pgm_rx_timestamp (
+	const struct msghdr*		msg
+	)
+{
+	return 0;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_rxq_ovfl (
+	const struct msghdr*		msg,
+	uint32_t*			ovfl
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_rx_tune_rcvbuf (
+	pgm_sock_t*			sock,
+	const struct pgm_rx_shard_t*	shard,
+	const size_t			rcvbuf
+	)
+{
+	return TRUE;
+}
+
+/** receive window module */
+PGM_GNUC_INTERNAL
+void
+mock_pgm_rxw_set_max_length (
+	pgm_rxw_t* const		window,
+	const unsigned			max_sqns
+	)
+{
+}
+
+/** xdp module */
+PGM_GNUC_INTERNAL
+ssize_t
+mock_pgm_xdp_recvskb (
+	pgm_sock_t*		sock,
+	struct pgm_sk_buff_t*	skb,
+	struct sockaddr*	src_addr,
+	const socklen_t		src_addrlen,
+	struct sockaddr*	dst_addr,
+	const socklen_t		dst_addrlen
+	)
+{
+	pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+	return SOCKET_ERROR;
+}
+
+/** replay module */
+PGM_GNUC_INTERNAL
+ssize_t
+mock_pgm_replay_recvskb (
+	pgm_sock_t*		sock,
+	struct pgm_sk_buff_t*	skb,
+	struct sockaddr*	src_addr,
+	const socklen_t		src_addrlen,
+	struct sockaddr*	dst_addr,
+	const socklen_t		dst_addrlen
+	)
+{
+	pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+	return SOCKET_ERROR;
+}
+
+/** shm module */
+PGM_GNUC_INTERNAL
+ssize_t
+mock_pgm_shm_recvskb (
+	pgm_sock_t*		sock,
+	struct pgm_sk_buff_t*	skb,
+	struct sockaddr*	src_addr,
+	const socklen_t		src_addrlen,
+	struct sockaddr*	dst_addr,
+	const socklen_t		dst_addrlen
+	)
+{
+	pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+	return SOCKET_ERROR;
+}
+
+/** loop module */
+PGM_GNUC_INTERNAL
+ssize_t
+mock_pgm_loop_recvskb (
+	pgm_sock_t*		sock,
+	struct pgm_sk_buff_t*	skb,
+	struct sockaddr*	src_addr,
+	const socklen_t		src_addrlen,
+	struct sockaddr*	dst_addr,
+	const socklen_t		dst_addrlen
+	)
+{
+	pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+	return SOCKET_ERROR;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_loop_rearm (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+/** uring module */
+PGM_GNUC_INTERNAL
+ssize_t
+mock_pgm_uring_recvskb (
+	pgm_sock_t*		sock,
+	struct sockaddr*	src_addr,
+	const socklen_t		src_addrlen,
+	struct msghdr*		ctl
+	)
+{
+	pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+	return SOCKET_ERROR;
+}
+
+/** receive shard module */
+PGM_GNUC_INTERNAL
+ssize_t
+mock_pgm_recv_shards_recvmsg (
+	pgm_sock_t*		sock,
+	struct msghdr*		msg,
+	const int		flags
+	)
+{
+	pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+	return SOCKET_ERROR;
+}
+
+/** demux module */
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_demux_dispatch (
+	pgm_sock_t*const restrict		sock,
+	struct pgm_rx_shard_t*const restrict	shard,
+	const struct sockaddr*const restrict	src,
+	const struct sockaddr*const restrict	dst
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_demux_pop (
+	pgm_sock_t*const restrict		sock,
+	struct pgm_rx_shard_t*const restrict	shard,
+	struct sockaddr*const restrict		src,
+	struct sockaddr*const restrict		dst
+	)
+{
+	return FALSE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_demux_rearm (
+	pgm_sock_t*const	sock
+	)
+{
+}
+
 /** timer module */
 PGM_GNUC_INTERNAL
 bool
@@ -941,6 +1247,16 @@ mock_pgm_timer_check (
 	return FALSE;
 }
 
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_timer_check_at (
+	pgm_sock_t* const		sock,
+	const pgm_time_t		now
+	)
+{
+	return FALSE;
+}
+
 PGM_GNUC_INTERNAL
 pgm_time_t
 mock_pgm_timer_expiration (
@@ -953,14 +1269,34 @@ mock_pgm_timer_expiration (
 PGM_GNUC_INTERNAL
 bool
 mock_pgm_timer_dispatch (
+	pgm_sock_t* const		sock,
+	struct pgm_rx_shard_t* const	shard
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_timer_event_arm (
 	pgm_sock_t* const		sock
 	)
+{
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_numa_bind_thread (
+	int				node
+	)
 {
 	return TRUE;
 }
 
 /** time module */
 static pgm_time_t mock_pgm_time_now = 0x1;
+bool mock_pgm_time_is_coarse = FALSE;
+PGM_THREAD_LOCAL pgm_time_t mock_pgm_time_cached = 0;
 
 static
 pgm_time_t
@@ -1153,6 +1489,24 @@ START_TEST (test_block_pass_001)
 }
 END_TEST
 
+/* transient socket error treated as would block, no error raised */
+START_TEST (test_block_pass_002)
+{
+	pgm_sock_t* sock = generate_sock();
+	fail_if (NULL == sock, "generate_sock failed");
+	guint8 buffer[ TEST_TXW_SQNS * TEST_MAX_TPDU ];
+	struct mock_recvmsg_t* mr = g_malloc (sizeof(struct mock_recvmsg_t));
+	mr->mr_msg	= NULL;
+	mr->mr_errno	= PGM_SOCK_ENOBUFS;
+	mr->mr_retval	= SOCKET_ERROR;
+	mock_recvmsg_list = g_list_append (mock_recvmsg_list, mr);
+	gsize bytes_read;
+	pgm_error_t* err = NULL;
+	fail_unless (PGM_IO_STATUS_TIMER_PENDING == pgm_recv (sock, buffer, sizeof(buffer), MSG_DONTWAIT, &bytes_read, &err), "recv failed");
+	fail_unless (NULL == err, "error raised");
+}
+END_TEST
+
 /* recv -> on_data */
 START_TEST (test_data_pass_001)
 {
@@ -1295,7 +1649,7 @@ START_TEST (test_lost_pass_001)
 {
 	pgm_sock_t* sock = generate_sock();
 	fail_if (NULL == sock, "generate_sock failed");
-	sock->is_reset = TRUE;
+	sock->rx_shard->is_reset = TRUE;
 	const pgm_tsi_t peer_tsi = { { 9, 8, 7, 6, 5, 4 }, g_htons(9000) };
 	struct sockaddr_in grp_addr = {
 		.sin_family		= AF_INET,
@@ -1327,7 +1681,7 @@ START_TEST (test_abort_on_lost_pass_001)
 {
 	pgm_sock_t* sock = generate_sock();
 	fail_if (NULL == sock, "generate_sock failed");
-	sock->is_reset = TRUE;
+	sock->rx_shard->is_reset = TRUE;
 	sock->is_abort_on_reset = TRUE;
 	const pgm_tsi_t peer_tsi = { { 9, 8, 7, 6, 5, 4 }, g_htons(9000) };
 	struct sockaddr_in grp_addr = {
@@ -1636,6 +1990,312 @@ START_TEST (test_recvmsgv_fail_001)
 }
 END_TEST
 
+/* target:
+ *	int
+ *	pgm_recvmsgv_multi (
+ *		pgm_sock_t**		socks,
+ *		size_t			sock_len,
+ *		struct pgm_msgv_t*	msg_start,
+ *		pgm_sock_t**		msg_sock,
+ *		size_t			msg_len,
+ *		int			flags,
+ *		size_t*			msgs_read,
+ *		size_t*			bytes_read,
+ *		pgm_error_t**		error
+ *		)
+ */
+
+START_TEST (test_recvmsgv_multi_pass_001)
+{
+	const char source[] = "i am not a string";
+	pgm_sock_t* socks[2] = { generate_sock(), generate_sock() };
+	fail_if (NULL == socks[0] || NULL == socks[1], "generate_sock failed");
+	mock_data_on_spmr = TRUE;
+	gpointer packet; gsize packet_len;
+	generate_spmr (&packet, &packet_len);
+	generate_msghdr (packet, packet_len);
+	const pgm_tsi_t peer_tsi = { { 9, 8, 7, 6, 5, 4 }, g_htons(9000) };
+	struct sockaddr_in grp_addr = {
+		.sin_family		= AF_INET,
+		.sin_addr.s_addr	= inet_addr(TEST_GROUP_ADDR)
+	}, peer_addr = {
+		.sin_family		= AF_INET,
+		.sin_addr.s_addr	= inet_addr(TEST_END_ADDR)
+	};
+	mock_peer = mock_pgm_new_peer (socks[0], &peer_tsi, (struct sockaddr*)&grp_addr, sizeof(grp_addr), (struct sockaddr*)&peer_addr, sizeof(peer_addr), mock_pgm_time_now);
+	fail_if (NULL == mock_peer, "new_peer failed");
+	for (unsigned i = 0; i < 2; i++) {
+		struct pgm_sk_buff_t* skb = pgm_alloc_skb (TEST_MAX_TPDU);
+		pgm_skb_put (skb, sizeof(source));
+		memcpy (skb->data, source, sizeof(source));
+		struct pgm_msgv_t* msgv = g_new0 (struct pgm_msgv_t, 1);
+		msgv->msgv_len = 1;
+		msgv->msgv_skb[0] = skb;
+		mock_data_list = g_list_append (mock_data_list, msgv);
+	}
+	push_block_event ();
+	push_block_event ();
+	struct pgm_msgv_t msgv[4];
+	pgm_sock_t* msg_sock[4];
+	gsize msgs_read, bytes_read;
+	pgm_error_t* err = NULL;
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_recvmsgv_multi (socks, G_N_ELEMENTS(socks), msgv, msg_sock, G_N_ELEMENTS(msgv), 0, &msgs_read, &bytes_read, &err), "recvmsgv_multi failed");
+	fail_unless (NULL == err, "error raised");
+	fail_unless (2 == msgs_read, "unexpected message count");
+	fail_unless ((gsize)(2 * sizeof(source)) == bytes_read, "unexpected data length");
+	fail_unless (socks[0] == msg_sock[0] && socks[0] == msg_sock[1], "unexpected message socket");
+}
+END_TEST
+
+START_TEST (test_recvmsgv_multi_fail_001)
+{
+	pgm_sock_t* socks[1] = { NULL };
+	struct pgm_msgv_t msgv[1];
+	pgm_sock_t* msg_sock[1];
+	fail_unless (PGM_IO_STATUS_ERROR == pgm_recvmsgv_multi (socks, G_N_ELEMENTS(socks), msgv, msg_sock, G_N_ELEMENTS(msgv), 0, NULL, NULL, NULL), "recvmsgv_multi failed");
+	fail_unless (PGM_IO_STATUS_ERROR == pgm_recvmsgv_multi (NULL, 0, msgv, msg_sock, G_N_ELEMENTS(msgv), 0, NULL, NULL, NULL), "recvmsgv_multi failed");
+}
+END_TEST
+
+/* target:
+ *	int
+ *	pgm_recvskbv (
+ *		pgm_sock_t*		sock,
+ *		struct pgm_skbv_t*	skbv,
+ *		int			flags,
+ *		size_t*			bytes_read,
+ *		pgm_error_t**		error
+ *		)
+ */
+
+START_TEST (test_recvskbv_pass_001)
+{
+	const char source[] = "i am not a string";
+	pgm_sock_t* sock = generate_sock();
+	fail_if (NULL == sock, "generate_sock failed");
+	mock_data_on_spmr = TRUE;
+	gpointer packet; gsize packet_len;
+	generate_spmr (&packet, &packet_len);
+	generate_msghdr (packet, packet_len);
+	const pgm_tsi_t peer_tsi = { { 9, 8, 7, 6, 5, 4 }, g_htons(9000) };
+	struct sockaddr_in grp_addr = {
+		.sin_family		= AF_INET,
+		.sin_addr.s_addr	= inet_addr(TEST_GROUP_ADDR)
+	}, peer_addr = {
+		.sin_family		= AF_INET,
+		.sin_addr.s_addr	= inet_addr(TEST_END_ADDR)
+	};
+	mock_peer = mock_pgm_new_peer (sock, &peer_tsi, (struct sockaddr*)&grp_addr, sizeof(grp_addr), (struct sockaddr*)&peer_addr, sizeof(peer_addr), mock_pgm_time_now);
+	fail_if (NULL == mock_peer, "new_peer failed");
+	for (unsigned i = 0; i < 2; i++) {
+		struct pgm_sk_buff_t* skb = pgm_alloc_skb (TEST_MAX_TPDU);
+		pgm_skb_put (skb, sizeof(source));
+		memcpy (skb->data, source, sizeof(source));
+		struct pgm_msgv_t* msgv = g_new0 (struct pgm_msgv_t, 1);
+		msgv->msgv_len = 1;
+		msgv->msgv_skb[0] = skb;
+		mock_data_list = g_list_append (mock_data_list, msgv);
+	}
+	push_block_event ();
+	struct pgm_sk_buff_t* skbv_skb[ 2 * PGM_MAX_FRAGMENTS ];
+	uint32_t skbv_offset[ 4 ];
+	uint16_t skbv_count[ 4 ];
+	struct pgm_skbv_t skbv = {
+		.skbv_skb	= skbv_skb,
+		.skbv_offset	= skbv_offset,
+		.skbv_count	= skbv_count,
+		.skbv_skb_len	= G_N_ELEMENTS(skbv_skb),
+		.skbv_msg_len	= G_N_ELEMENTS(skbv_offset)
+	};
+	gsize bytes_read;
+	pgm_error_t* err = NULL;
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_recvskbv (sock, &skbv, MSG_DONTWAIT, &bytes_read, &err), "recvskbv failed");
+	fail_unless (NULL == err, "error raised");
+	fail_unless ((gsize)(2 * sizeof(source)) == bytes_read, "unexpected data length");
+	fail_unless (2 == skbv.skbv_msg_used, "unexpected message count");
+	fail_unless (2 == skbv.skbv_skb_used, "unexpected packet count");
+	fail_unless (0 == skbv_offset[0] && 1 == skbv_count[0], "unexpected first message");
+	fail_unless (1 == skbv_offset[1] && 1 == skbv_count[1], "unexpected second message");
+}
+END_TEST
+
+START_TEST (test_recvskbv_fail_001)
+{
+	struct pgm_sk_buff_t* skbv_skb[ PGM_MAX_FRAGMENTS ];
+	uint32_t skbv_offset[ 1 ];
+	uint16_t skbv_count[ 1 ];
+	struct pgm_skbv_t skbv = {
+		.skbv_skb	= skbv_skb,
+		.skbv_offset	= skbv_offset,
+		.skbv_count	= skbv_count,
+		.skbv_skb_len	= G_N_ELEMENTS(skbv_skb),
+		.skbv_msg_len	= G_N_ELEMENTS(skbv_offset)
+	};
+	fail_unless (PGM_IO_STATUS_ERROR == pgm_recvskbv (NULL, &skbv, 0, NULL, NULL), "recvskbv failed");
+}
+END_TEST
+
+/* target:
+ *	int
+ *	pgm_recvapdu (
+ *		pgm_sock_t*		sock,
+ *		struct pgm_apdu_t**	apdu,
+ *		int			flags,
+ *		size_t*			bytes_read,
+ *		pgm_error_t**		error
+ *		)
+ */
+
+START_TEST (test_recvapdu_pass_001)
+{
+	const char source[] = "i am not a string";
+	pgm_sock_t* sock = generate_sock();
+	fail_if (NULL == sock, "generate_sock failed");
+	mock_data_on_spmr = TRUE;
+	gpointer packet; gsize packet_len;
+	generate_spmr (&packet, &packet_len);
+	generate_msghdr (packet, packet_len);
+	const pgm_tsi_t peer_tsi = { { 9, 8, 7, 6, 5, 4 }, g_htons(9000) };
+	struct sockaddr_in grp_addr = {
+		.sin_family		= AF_INET,
+		.sin_addr.s_addr	= inet_addr(TEST_GROUP_ADDR)
+	}, peer_addr = {
+		.sin_family		= AF_INET,
+		.sin_addr.s_addr	= inet_addr(TEST_END_ADDR)
+	};
+	mock_peer = mock_pgm_new_peer (sock, &peer_tsi, (struct sockaddr*)&grp_addr, sizeof(grp_addr), (struct sockaddr*)&peer_addr, sizeof(peer_addr), mock_pgm_time_now);
+	fail_if (NULL == mock_peer, "new_peer failed");
+	struct pgm_sk_buff_t* skb = pgm_alloc_skb (TEST_MAX_TPDU);
+	pgm_skb_put (skb, sizeof(source));
+	memcpy (skb->data, source, sizeof(source));
+	struct pgm_msgv_t* msgv = g_new0 (struct pgm_msgv_t, 1);
+	msgv->msgv_len = 1;
+	msgv->msgv_skb[0] = skb;
+	mock_data_list = g_list_append (mock_data_list, msgv);
+	push_block_event ();
+	struct pgm_apdu_t* apdu = NULL;
+	gsize bytes_read;
+	pgm_error_t* err = NULL;
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_recvapdu (sock, &apdu, MSG_DONTWAIT, &bytes_read, &err), "recvapdu failed");
+	fail_unless (NULL == err, "error raised");
+	fail_unless ((gsize)sizeof(source) == bytes_read, "unexpected data length");
+	fail_if (NULL == apdu, "apdu not set");
+	fail_unless (sizeof(source) == apdu->apdu_len, "unexpected apdu length");
+	fail_unless (1 == apdu->apdu_iovlen, "unexpected fragment count");
+	fail_unless (skb->data == apdu->apdu_iov[0].iov_base, "payload copied");
+	fail_unless (0 == memcmp (source, apdu->apdu_iov[0].iov_base, apdu->apdu_iov[0].iov_len), "payload mismatch");
+	fail_unless (2 == pgm_atomic_read32 (&skb->users), "fragment not retained");
+	pgm_apdu_free (apdu);
+	fail_unless (1 == pgm_atomic_read32 (&skb->users), "fragment not released");
+}
+END_TEST
+
+START_TEST (test_recvapdu_fail_001)
+{
+	struct pgm_apdu_t* apdu = NULL;
+	fail_unless (PGM_IO_STATUS_ERROR == pgm_recvapdu (NULL, &apdu, 0, NULL, NULL), "recvapdu failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_recv_async_start (
+ *		pgm_sock_t*				sock,
+ *		const struct pgm_recvasyncinfo_t*	info,
+ *		pgm_error_t**				error
+ *		)
+ */
+
+static
+void
+on_async_msgv (
+	pgm_sock_t*			sock,
+	const struct pgm_msgv_t*	msgv,
+	size_t				len,
+	int				status,
+	void*				user_data
+	)
+{
+}
+
+/* unconnected socket */
+START_TEST (test_recv_async_start_fail_001)
+{
+	const struct pgm_recvasyncinfo_t info = { .callback = on_async_msgv };
+	pgm_sock_t* sock = generate_sock();
+	fail_if (NULL == sock, "generate_sock failed");
+	fail_unless (FALSE == pgm_recv_async_start (NULL, &info, NULL), "recv_async_start failed");
+	fail_unless (FALSE == pgm_recv_async_start (sock, NULL, NULL), "recv_async_start failed");
+	fail_unless (FALSE == pgm_recv_async_start (sock, &info, NULL), "recv_async_start failed");
+	fail_unless (NULL == sock->recv_async, "recv_async set");
+}
+END_TEST
+
+/* exclusive socket */
+START_TEST (test_recv_async_start_fail_002)
+{
+	const struct pgm_recvasyncinfo_t info = { .callback = on_async_msgv };
+	pgm_sock_t* sock = generate_sock();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->is_connected = TRUE;
+	sock->is_exclusive = TRUE;
+	fail_unless (FALSE == pgm_recv_async_start (sock, &info, NULL), "recv_async_start failed");
+	fail_unless (NULL == sock->recv_async, "recv_async set");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_recv_async_stop (
+ *		pgm_sock_t*		sock
+ *		)
+ */
+
+START_TEST (test_recv_async_stop_fail_001)
+{
+	pgm_sock_t* sock = generate_sock();
+	fail_if (NULL == sock, "generate_sock failed");
+	fail_unless (FALSE == pgm_recv_async_stop (NULL), "recv_async_stop failed");
+	fail_unless (FALSE == pgm_recv_async_stop (sock), "recv_async_stop failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_recv_drain_start (
+ *		pgm_sock_t*		sock,
+ *		const unsigned		len,
+ *		pgm_error_t**		error
+ *		)
+ */
+
+/* unconnected socket */
+START_TEST (test_recv_drain_start_fail_001)
+{
+	pgm_sock_t* sock = generate_sock();
+	fail_if (NULL == sock, "generate_sock failed");
+	fail_unless (FALSE == pgm_recv_drain_start (NULL, 0, NULL), "recv_drain_start failed");
+	fail_unless (FALSE == pgm_recv_drain_start (sock, 0, NULL), "recv_drain_start failed");
+	fail_unless (NULL == sock->recv_drain, "recv_drain set");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_recv_drain_stop (
+ *		pgm_sock_t*		sock
+ *		)
+ */
+
+START_TEST (test_recv_drain_stop_fail_001)
+{
+	pgm_sock_t* sock = generate_sock();
+	fail_if (NULL == sock, "generate_sock failed");
+	fail_unless (FALSE == pgm_recv_drain_stop (NULL), "recv_drain_stop failed");
+	fail_unless (FALSE == pgm_recv_drain_stop (sock), "recv_drain_stop failed");
+}
+END_TEST
+
 
 static
 Suite*
@@ -1649,6 +2309,7 @@ make_test_suite (void)
 	suite_add_tcase (s, tc_block);
 	tcase_add_checked_fixture (tc_block, mock_setup, mock_teardown);
 	tcase_add_test (tc_block, test_block_pass_001);
+	tcase_add_test (tc_block, test_block_pass_002);
 
 	TCase* tc_data = tcase_create ("data");
 	suite_add_tcase (s, tc_data);
@@ -1745,6 +2406,37 @@ make_test_suite (void)
 	tcase_add_checked_fixture (tc_recvmsgv, mock_setup, mock_teardown);
 	tcase_add_test (tc_recvmsgv, test_recvmsgv_fail_001);
 
+	TCase* tc_recvmsgv_multi = tcase_create ("recvmsgv-multi");
+	suite_add_tcase (s, tc_recvmsgv_multi);
+	tcase_add_checked_fixture (tc_recvmsgv_multi, mock_setup, mock_teardown);
+	tcase_add_test (tc_recvmsgv_multi, test_recvmsgv_multi_pass_001);
+	tcase_add_test (tc_recvmsgv_multi, test_recvmsgv_multi_fail_001);
+
+	TCase* tc_recvskbv = tcase_create ("recvskbv");
+	suite_add_tcase (s, tc_recvskbv);
+	tcase_add_checked_fixture (tc_recvskbv, mock_setup, mock_teardown);
+	tcase_add_test (tc_recvskbv, test_recvskbv_pass_001);
+	tcase_add_test (tc_recvskbv, test_recvskbv_fail_001);
+
+	TCase* tc_recvapdu = tcase_create ("recvapdu");
+	suite_add_tcase (s, tc_recvapdu);
+	tcase_add_checked_fixture (tc_recvapdu, mock_setup, mock_teardown);
+	tcase_add_test (tc_recvapdu, test_recvapdu_pass_001);
+	tcase_add_test (tc_recvapdu, test_recvapdu_fail_001);
+
+	TCase* tc_recv_async = tcase_create ("recv-async");
+	suite_add_tcase (s, tc_recv_async);
+	tcase_add_checked_fixture (tc_recv_async, mock_setup, mock_teardown);
+	tcase_add_test (tc_recv_async, test_recv_async_start_fail_001);
+	tcase_add_test (tc_recv_async, test_recv_async_start_fail_002);
+	tcase_add_test (tc_recv_async, test_recv_async_stop_fail_001);
+
+	TCase* tc_recv_drain = tcase_create ("recv-drain");
+	suite_add_tcase (s, tc_recv_drain);
+	tcase_add_checked_fixture (tc_recv_drain, mock_setup, mock_teardown);
+	tcase_add_test (tc_recv_drain, test_recv_drain_start_fail_001);
+	tcase_add_test (tc_recv_drain, test_recv_drain_stop_fail_001);
+
 	return s;
 }
 
@@ -29,8 +29,67 @@
 #endif
 #include <impl/framework.h>
 
-#ifdef USE_GALOIS_SSE3
+/* Vector kernels are compiled with per-function target attributes and
+ * selected at run-time by pgm_rs_init().
+ */
+#if defined(_MSC_VER) && (defined(_M_AMD64) || defined(_M_X64))
+#	include <intrin.h>
+#	define GF_TARGET(x)
+#	define USE_GALOIS_SIMD
+#	if (_MSC_VER >= 1910)
+#		define USE_GALOIS_AVX512
+#	endif
+#	if (_MSC_VER >= 1920)
+#		define USE_GALOIS_GFNI
+#	endif
+#elif (defined(__i386__) || defined(__x86_64__)) && \
+      ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || defined(__clang__))
 #	include <x86intrin.h>
+#	define GF_TARGET(x)		__attribute__((__target__(x)))
+#	define USE_GALOIS_SIMD
+#	if (__GNUC__ >= 5) || defined(__clang__)
+#		define USE_GALOIS_AVX512
+#	endif
+#	if (defined(__clang__) && (__clang_major__ >= 7)) || (!defined(__clang__) && (__GNUC__ >= 8))
+#		define USE_GALOIS_GFNI
+#	endif
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#	include <arm_neon.h>
+#	define USE_GALOIS_NEON
+#endif
+
+static void _pgm_gf_vec_addmul_generic (pgm_gf8_t*restrict, const pgm_gf8_t, const pgm_gf8_t*restrict, uint16_t);
+#ifdef USE_GALOIS_SIMD
+static void _pgm_gf_vec_addmul_ssse3 (pgm_gf8_t*restrict, const pgm_gf8_t, const pgm_gf8_t*restrict, uint16_t);
+static void _pgm_gf_vec_addmul_avx2 (pgm_gf8_t*restrict, const pgm_gf8_t, const pgm_gf8_t*restrict, uint16_t);
+#endif
+#ifdef USE_GALOIS_AVX512
+static void _pgm_gf_vec_addmul_avx512bw (pgm_gf8_t*restrict, const pgm_gf8_t, const pgm_gf8_t*restrict, uint16_t);
+#endif
+#ifdef USE_GALOIS_GFNI
+static void _pgm_gf_vec_addmul_gfni_avx (pgm_gf8_t*restrict, const pgm_gf8_t, const pgm_gf8_t*restrict, uint16_t);
+static void _pgm_gf_vec_addmul_gfni_avx512 (pgm_gf8_t*restrict, const pgm_gf8_t, const pgm_gf8_t*restrict, uint16_t);
+#endif
+#ifdef USE_GALOIS_NEON
+static void _pgm_gf_vec_addmul_neon (pgm_gf8_t*restrict, const pgm_gf8_t, const pgm_gf8_t*restrict, uint16_t);
+#endif
+
+static void (*gf_vec_addmul) (pgm_gf8_t*restrict, const pgm_gf8_t, const pgm_gf8_t*restrict, uint16_t) = _pgm_gf_vec_addmul_generic;
+
+#if defined(USE_GALOIS_SIMD) || defined(USE_GALOIS_NEON)
+/* nibble size lookup tables for feeding into PSHUFB or TBL, product of each element
+ * with the high and low nibbles of the multiplicand.
+ */
+static pgm_gf8_t gf_nibble_hi[PGM_GF_NO_ELEMENTS][16];
+static pgm_gf8_t gf_nibble_lo[PGM_GF_NO_ELEMENTS][16];
+#endif
+#ifdef USE_GALOIS_GFNI
+/* GF2P8MULB is fixed to the AES polynomial x⁸ + x⁴ + x³ + x + 1, multiplication
+ * by a constant in GF(2⁸) with generator 0x11d is instead a linear map over
+ * GF(2) applied by GF2P8AFFINEQB with an 8×8 bit matrix per element.
+ */
+static uint64_t gf_affine[PGM_GF_NO_ELEMENTS];
 #endif
 
 /* Vector GF(2⁸) plus-equals multiplication.
@@ -38,7 +97,7 @@
  * d[] += b • s[]
  */
 
-static
+static inline
 void
 _pgm_gf_vec_addmul (
 	pgm_gf8_t*	 restrict d,
@@ -47,65 +106,33 @@ _pgm_gf_vec_addmul (
 	uint16_t		  len	/* length of vectors */
 	)
 {
-	uint_fast16_t i;
-#ifdef USE_GALOIS_SSE3
-	uint_fast16_t count16;
-#else
-	uint_fast16_t count8;
-#endif
-
 	if (PGM_UNLIKELY(b == 0))
 		return;
+	gf_vec_addmul (d, b, s, len);
+}
+
+static
+void
+_pgm_gf_vec_addmul_generic (
+	pgm_gf8_t*	 restrict d,
+	const pgm_gf8_t		  b,
+	const pgm_gf8_t* restrict s,
+	uint16_t		  len	/* length of vectors */
+	)
+{
+	uint_fast16_t i;
+	uint_fast16_t count8;
 
 #ifdef USE_GALOIS_MUL_LUT
         const pgm_gf8_t* gfmul_b = &pgm_gftable[ (uint16_t)b << 8 ];
 #endif
 
-/* Implementation per the Intel IPP whitepaper
- * The Use of Finite Field GF(256) in the Performance Primitives (2008)
- */
-#ifdef USE_GALOIS_SSE3
-	i = 0;
-	count16 = len >> 4;		/* 16-way unrolls */
-	if (count16)
-	{
-/* generate nibble size lookup table for feeding into SSE3 instruction PSHUFB */
-		struct {
-			pgm_gf8_t hi[PGM_GF_NO_ELEMENTS][16];
-			pgm_gf8_t lo[PGM_GF_NO_ELEMENTS][16];
-		} nibble_gftable;
-		for (int i = 0; i < PGM_GF_NO_ELEMENTS; i++) {
-			for (int j = 0; j < 16; j++) {
-				nibble_gftable.hi[i][j] = pgm_gfmul (i, j << 4);
-				nibble_gftable.lo[i][j] = pgm_gfmul (i, j);
-			}
-		}
-
-/* operate on GF((2^4)^2) */
-		const __m128i hi = _mm_loadu_si128 ((const __m128i*)nibble_gftable.hi[ b ]);
-		const __m128i lo = _mm_loadu_si128 ((const __m128i*)nibble_gftable.lo[ b ]);
-		const __m128i nibble_mask = _mm_set1_epi8 (0x0f);
-		while (count16--) {
-			const __m128i dst = _mm_load_si128 ((__m128i *)(&d[i]));
-			const __m128i src = _mm_load_si128 ((__m128i *)(&s[i]));
-			__m128i tmp = _mm_shuffle_epi8 (lo, _mm_and_si128 (nibble_mask, src));
-			tmp = _mm_xor_si128 (tmp, _mm_shuffle_epi8 (hi, _mm_and_si128 (nibble_mask, _mm_srli_epi64 (src, 4))));
-
-			tmp = _mm_xor_si128 (dst, tmp);
-			_mm_store_si128 ((__m128i *)(&d[i]), tmp);
-			i += 16;
-		}
-
-/* remaining */
-		len %= 16;
-	}
-#else
 	i = 0;
 	count8 = len >> 3;		/* 8-way unrolls */
 	if (count8)
 	{
 		while (count8--) {
-#	ifdef USE_GALOIS_MUL_LUT
+#ifdef USE_GALOIS_MUL_LUT
 			d[i  ] ^= gfmul_b[ s[i  ] ];
 			d[i+1] ^= gfmul_b[ s[i+1] ];
 			d[i+2] ^= gfmul_b[ s[i+2] ];
@@ -114,7 +141,7 @@ _pgm_gf_vec_addmul (
 			d[i+5] ^= gfmul_b[ s[i+5] ];
 			d[i+6] ^= gfmul_b[ s[i+6] ];
 			d[i+7] ^= gfmul_b[ s[i+7] ];
-#	else
+#else
 			d[i  ] ^= gfmul( b, s[i  ] );
 			d[i+1] ^= gfmul( b, s[i+1] );
 			d[i+2] ^= gfmul( b, s[i+2] );
@@ -123,14 +150,13 @@ _pgm_gf_vec_addmul (
 			d[i+5] ^= gfmul( b, s[i+5] );
 			d[i+6] ^= gfmul( b, s[i+6] );
 			d[i+7] ^= gfmul( b, s[i+7] );
-#	endif
+#endif
 			i += 8;
 		}
 
 /* remaining */
 		len %= 8;
 	}
-#endif
 
 	while (len--) {
 #ifdef USE_GALOIS_MUL_LUT
@@ -142,6 +168,276 @@ _pgm_gf_vec_addmul (
 	}
 }
 
+/* Implementation per the Intel IPP whitepaper
+ * The Use of Finite Field GF(256) in the Performance Primitives (2008)
+ *
+ * operate on GF((2⁴)²), 16 bytes per PSHUFB.
+ */
+
+#ifdef USE_GALOIS_SIMD
+GF_TARGET("ssse3")
+static
+void
+_pgm_gf_vec_addmul_ssse3 (
+	pgm_gf8_t*	 restrict d,
+	const pgm_gf8_t		  b,
+	const pgm_gf8_t* restrict s,
+	uint16_t		  len	/* length of vectors */
+	)
+{
+	const __m128i hi = _mm_loadu_si128 ((const __m128i*)gf_nibble_hi[ b ]);
+	const __m128i lo = _mm_loadu_si128 ((const __m128i*)gf_nibble_lo[ b ]);
+	const __m128i nibble_mask = _mm_set1_epi8 (0x0f);
+	uint_fast16_t i = 0;
+
+	for (; i + 16 <= len; i += 16) {
+		const __m128i dst = _mm_loadu_si128 ((const __m128i*)&d[i]);
+		const __m128i src = _mm_loadu_si128 ((const __m128i*)&s[i]);
+		__m128i tmp = _mm_shuffle_epi8 (lo, _mm_and_si128 (nibble_mask, src));
+		tmp = _mm_xor_si128 (tmp, _mm_shuffle_epi8 (hi, _mm_and_si128 (nibble_mask, _mm_srli_epi64 (src, 4))));
+		_mm_storeu_si128 ((__m128i*)&d[i], _mm_xor_si128 (dst, tmp));
+	}
+
+/* remaining */
+	if (i < len)
+		_pgm_gf_vec_addmul_generic (&d[i], b, &s[i], (uint16_t)(len - i));
+}
+
+/* 32 bytes per VPSHUFB, tables broadcast to both 128-bit lanes.
+ */
+
+GF_TARGET("avx2")
+static
+void
+_pgm_gf_vec_addmul_avx2 (
+	pgm_gf8_t*	 restrict d,
+	const pgm_gf8_t		  b,
+	const pgm_gf8_t* restrict s,
+	uint16_t		  len	/* length of vectors */
+	)
+{
+	const __m256i hi = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i*)gf_nibble_hi[ b ]));
+	const __m256i lo = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i*)gf_nibble_lo[ b ]));
+	const __m256i nibble_mask = _mm256_set1_epi8 (0x0f);
+	uint_fast16_t i = 0;
+
+	for (; i + 32 <= len; i += 32) {
+		const __m256i dst = _mm256_loadu_si256 ((const __m256i*)&d[i]);
+		const __m256i src = _mm256_loadu_si256 ((const __m256i*)&s[i]);
+		__m256i tmp = _mm256_shuffle_epi8 (lo, _mm256_and_si256 (nibble_mask, src));
+		tmp = _mm256_xor_si256 (tmp, _mm256_shuffle_epi8 (hi, _mm256_and_si256 (nibble_mask, _mm256_srli_epi64 (src, 4))));
+		_mm256_storeu_si256 ((__m256i*)&d[i], _mm256_xor_si256 (dst, tmp));
+	}
+
+/* remaining */
+	if (i < len)
+		_pgm_gf_vec_addmul_ssse3 (&d[i], b, &s[i], (uint16_t)(len - i));
+}
+#endif /* USE_GALOIS_SIMD */
+
+/* 64 bytes per VPSHUFB, AVX-512BW is required for byte shuffles.
+ */
+
+#ifdef USE_GALOIS_AVX512
+GF_TARGET("avx512f,avx512bw")
+static
+void
+_pgm_gf_vec_addmul_avx512bw (
+	pgm_gf8_t*	 restrict d,
+	const pgm_gf8_t		  b,
+	const pgm_gf8_t* restrict s,
+	uint16_t		  len	/* length of vectors */
+	)
+{
+	const __m512i hi = _mm512_broadcast_i32x4 (_mm_loadu_si128 ((const __m128i*)gf_nibble_hi[ b ]));
+	const __m512i lo = _mm512_broadcast_i32x4 (_mm_loadu_si128 ((const __m128i*)gf_nibble_lo[ b ]));
+	const __m512i nibble_mask = _mm512_set1_epi8 (0x0f);
+	uint_fast16_t i = 0;
+
+	for (; i + 64 <= len; i += 64) {
+		const __m512i dst = _mm512_loadu_si512 ((const void*)&d[i]);
+		const __m512i src = _mm512_loadu_si512 ((const void*)&s[i]);
+		__m512i tmp = _mm512_shuffle_epi8 (lo, _mm512_and_si512 (nibble_mask, src));
+		tmp = _mm512_xor_si512 (tmp, _mm512_shuffle_epi8 (hi, _mm512_and_si512 (nibble_mask, _mm512_srli_epi64 (src, 4))));
+		_mm512_storeu_si512 ((void*)&d[i], _mm512_xor_si512 (dst, tmp));
+	}
+
+/* remaining */
+	if (i < len)
+		_pgm_gf_vec_addmul_avx2 (&d[i], b, &s[i], (uint16_t)(len - i));
+}
+#endif /* USE_GALOIS_AVX512 */
+
+/* one GF2P8AFFINEQB per vector, no nibble split.
+ */
+
+#ifdef USE_GALOIS_GFNI
+GF_TARGET("gfni,avx2")
+static
+void
+_pgm_gf_vec_addmul_gfni_avx (
+	pgm_gf8_t*	 restrict d,
+	const pgm_gf8_t		  b,
+	const pgm_gf8_t* restrict s,
+	uint16_t		  len	/* length of vectors */
+	)
+{
+	const __m256i matrix = _mm256_set1_epi64x ((long long)gf_affine[ b ]);
+	uint_fast16_t i = 0;
+
+	for (; i + 32 <= len; i += 32) {
+		const __m256i dst = _mm256_loadu_si256 ((const __m256i*)&d[i]);
+		const __m256i src = _mm256_loadu_si256 ((const __m256i*)&s[i]);
+		const __m256i tmp = _mm256_gf2p8affine_epi64_epi8 (src, matrix, 0);
+		_mm256_storeu_si256 ((__m256i*)&d[i], _mm256_xor_si256 (dst, tmp));
+	}
+
+/* remaining */
+	if (i < len)
+		_pgm_gf_vec_addmul_ssse3 (&d[i], b, &s[i], (uint16_t)(len - i));
+}
+
+GF_TARGET("gfni,avx512f,avx512bw")
+static
+void
+_pgm_gf_vec_addmul_gfni_avx512 (
+	pgm_gf8_t*	 restrict d,
+	const pgm_gf8_t		  b,
+	const pgm_gf8_t* restrict s,
+	uint16_t		  len	/* length of vectors */
+	)
+{
+	const __m512i matrix = _mm512_set1_epi64 ((long long)gf_affine[ b ]);
+	uint_fast16_t i = 0;
+
+	for (; i + 64 <= len; i += 64) {
+		const __m512i dst = _mm512_loadu_si512 ((const void*)&d[i]);
+		const __m512i src = _mm512_loadu_si512 ((const void*)&s[i]);
+		const __m512i tmp = _mm512_gf2p8affine_epi64_epi8 (src, matrix, 0);
+		_mm512_storeu_si512 ((void*)&d[i], _mm512_xor_si512 (dst, tmp));
+	}
+
+/* remaining */
+	if (i < len)
+		_pgm_gf_vec_addmul_gfni_avx (&d[i], b, &s[i], (uint16_t)(len - i));
+}
+#endif /* USE_GALOIS_GFNI */
+
+/* TBL is the AArch64 PSHUFB, 32 bytes per iteration over two registers.
+ */
+
+#ifdef USE_GALOIS_NEON
+static
+void
+_pgm_gf_vec_addmul_neon (
+	pgm_gf8_t*	 restrict d,
+	const pgm_gf8_t		  b,
+	const pgm_gf8_t* restrict s,
+	uint16_t		  len	/* length of vectors */
+	)
+{
+	const uint8x16_t hi = vld1q_u8 (gf_nibble_hi[ b ]);
+	const uint8x16_t lo = vld1q_u8 (gf_nibble_lo[ b ]);
+	const uint8x16_t nibble_mask = vdupq_n_u8 (0x0f);
+	uint_fast16_t i = 0;
+
+	for (; i + 32 <= len; i += 32) {
+		const uint8x16_t src0 = vld1q_u8 (&s[i]);
+		const uint8x16_t src1 = vld1q_u8 (&s[i + 16]);
+		const uint8x16_t tmp0 = veorq_u8 (vqtbl1q_u8 (lo, vandq_u8 (src0, nibble_mask)),
+						  vqtbl1q_u8 (hi, vshrq_n_u8 (src0, 4)));
+		const uint8x16_t tmp1 = veorq_u8 (vqtbl1q_u8 (lo, vandq_u8 (src1, nibble_mask)),
+						  vqtbl1q_u8 (hi, vshrq_n_u8 (src1, 4)));
+		vst1q_u8 (&d[i], veorq_u8 (vld1q_u8 (&d[i]), tmp0));
+		vst1q_u8 (&d[i + 16], veorq_u8 (vld1q_u8 (&d[i + 16]), tmp1));
+	}
+	if (i + 16 <= len) {
+		const uint8x16_t src = vld1q_u8 (&s[i]);
+		const uint8x16_t tmp = veorq_u8 (vqtbl1q_u8 (lo, vandq_u8 (src, nibble_mask)),
+						 vqtbl1q_u8 (hi, vshrq_n_u8 (src, 4)));
+		vst1q_u8 (&d[i], veorq_u8 (vld1q_u8 (&d[i]), tmp));
+		i += 16;
+	}
+
+/* remaining */
+	if (i < len)
+		_pgm_gf_vec_addmul_generic (&d[i], b, &s[i], (uint16_t)(len - i));
+}
+#endif /* USE_GALOIS_NEON */
+
+/* build lookup tables and select the widest vector kernel supported by the
+ * processor, called once from pgm_init().
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_rs_init (const pgm_cpu_t* cpu)
+{
+/* pre-conditions */
+	pgm_assert (NULL != cpu);
+
+#if defined(USE_GALOIS_SIMD) || defined(USE_GALOIS_NEON)
+	for (unsigned i = 0; i < PGM_GF_NO_ELEMENTS; i++) {
+		for (unsigned j = 0; j < 16; j++) {
+			gf_nibble_hi[i][j] = pgm_gfmul ((pgm_gf8_t)i, (pgm_gf8_t)(j << 4));
+			gf_nibble_lo[i][j] = pgm_gfmul ((pgm_gf8_t)i, (pgm_gf8_t)j);
+		}
+	}
+#endif
+#ifdef USE_GALOIS_GFNI
+/* row i of the matrix, byte 7 - i, selects the bits of x contributing to bit i of b • x */
+	for (unsigned i = 0; i < PGM_GF_NO_ELEMENTS; i++) {
+		uint64_t matrix = 0;
+		for (unsigned k = 0; k < 8; k++) {
+			const pgm_gf8_t column = pgm_gfmul ((pgm_gf8_t)i, (pgm_gf8_t)(1 << k));
+			for (unsigned j = 0; j < 8; j++)
+				if (column & (1 << j))
+					matrix |= (uint64_t)1 << ((8 * (7 - j)) + k);
+		}
+		gf_affine[i] = matrix;
+	}
+
+	if (cpu->has_gfni && cpu->has_avx512bw) {
+		pgm_minor (_("Using GFNI and AVX-512 instructions for Reed-Solomon coding."));
+		gf_vec_addmul = _pgm_gf_vec_addmul_gfni_avx512;
+		return;
+	}
+	if (cpu->has_gfni && cpu->has_avx2) {
+		pgm_minor (_("Using GFNI and AVX2 instructions for Reed-Solomon coding."));
+		gf_vec_addmul = _pgm_gf_vec_addmul_gfni_avx;
+		return;
+	}
+#endif
+#ifdef USE_GALOIS_AVX512
+	if (cpu->has_avx512bw) {
+		pgm_minor (_("Using AVX-512BW instructions for Reed-Solomon coding."));
+		gf_vec_addmul = _pgm_gf_vec_addmul_avx512bw;
+		return;
+	}
+#endif
+#ifdef USE_GALOIS_SIMD
+	if (cpu->has_avx2) {
+		pgm_minor (_("Using AVX2 instructions for Reed-Solomon coding."));
+		gf_vec_addmul = _pgm_gf_vec_addmul_avx2;
+		return;
+	}
+	if (cpu->has_ssse3) {
+		pgm_minor (_("Using SSSE3 instructions for Reed-Solomon coding."));
+		gf_vec_addmul = _pgm_gf_vec_addmul_ssse3;
+		return;
+	}
+#endif
+#ifdef USE_GALOIS_NEON
+	if (cpu->has_neon) {
+		pgm_minor (_("Using NEON instructions for Reed-Solomon coding."));
+		gf_vec_addmul = _pgm_gf_vec_addmul_neon;
+		return;
+	}
+#endif
+
+	gf_vec_addmul = _pgm_gf_vec_addmul_generic;
+}
+
 /* Basic matrix multiplication.
  *
  * C = AB
@@ -425,7 +721,8 @@ pgm_rs_create (
 	rs->n	= n;
 	rs->k	= k;
 	rs->GM	= pgm_new0 (pgm_gf8_t, n * k);
-	rs->RM	= pgm_new0 (pgm_gf8_t, k * k);
+	memset (rs->matrix_cache, 0, sizeof(rs->matrix_cache));
+	rs->matrix_clock = rs->matrix_hits = rs->matrix_misses = 0;
 
 /* alpha = root of primitive polynomial of degree m
  *                 ( 1 + x² + x³ + x⁴ + x⁸ )
@@ -492,9 +789,14 @@ pgm_rs_destroy (
 {
 	pgm_assert (NULL != rs);
 
-	if (rs->RM) {
-		pgm_free (rs->RM);
-		rs->RM = NULL;
+	for (unsigned i = 0; i < PGM_RS_MATRIX_CACHE; i++)
+	{
+		struct pgm_rs_matrix_t* entry = &rs->matrix_cache[ i ];
+		if (entry->RM) {
+			pgm_free (entry->RM);
+			entry->RM = NULL;
+			entry->offsets = NULL;
+		}
 	}
 
 	if (rs->GM) {
@@ -531,38 +833,128 @@ pgm_rs_encode (
 	}
 }
 
-/* original data block of packets with missing packet entries replaced
- * with on-demand parity packets.
+/* Fused encode of several parity packets of one transmission group in a
+ * single pass over the source packets.  The vectors are processed in strips
+ * sized so that one strip of every output and of the current source stay
+ * resident in the L1 data cache.
  */
 
 PGM_GNUC_INTERNAL
 void
-pgm_rs_decode_parity_inline (
-	pgm_rs_t*      restrict rs,
-	pgm_gf8_t**    restrict block,		/* length rs_t::k */
-	const uint8_t* restrict	offsets,	/* offsets within FEC block, 0 < offset < n */
-	const uint16_t	        len		/* packet length */
+pgm_rs_encode_multi (
+	pgm_rs_t*	  restrict rs,
+	const pgm_gf8_t** restrict src,		/* length rs_t::k */
+	const uint8_t*	  restrict offsets,	/* length count */
+	pgm_gf8_t**	  restrict dst,		/* length count */
+	const uint8_t		   count,
+	const uint16_t		   len
 	)
 {
 	pgm_assert (NULL != rs);
-	pgm_assert (NULL != block);
+	pgm_assert (NULL != src);
 	pgm_assert (NULL != offsets);
+	pgm_assert (NULL != dst);
+	pgm_assert (count > 0);
 	pgm_assert (len > 0);
 
+	const uint16_t strip = (uint16_t)MAX(PGM_RS_STRIP_MIN, (PGM_RS_STRIP_CACHE / (count + 1)) & ~63);
+
+	for (uint_fast8_t j = 0; j < count; j++) {
+		pgm_assert (offsets[j] >= rs->k && offsets[j] < rs->n);	/* parity packet */
+		pgm_assert (NULL != dst[j]);
+		memset (dst[j], 0, len);
+	}
+	for (unsigned offset = 0; offset < len; offset += strip)
+	{
+		const uint16_t strip_len = (uint16_t)MIN(strip, len - offset);
+		for (uint_fast8_t i = 0; i < rs->k; i++)
+		{
+			for (uint_fast8_t j = 0; j < count; j++)
+			{
+				const pgm_gf8_t c = rs->GM[ (offsets[j] * rs->k) + i ];
+				_pgm_gf_vec_addmul (&dst[j][offset], c, &src[i][offset], strip_len);
+			}
+		}
+	}
+}
+
+/* return the inverted recovery matrix for an erasure pattern, re-using a
+ * previous inversion when the same packets are missing and the same parity
+ * packets take their place.  The least recently used entry is replaced on a
+ * miss.
+ */
+
+static
+const pgm_gf8_t*
+_pgm_rs_recovery_matrix (
+	pgm_rs_t*      restrict rs,
+	const uint8_t* restrict	offsets		/* length rs_t::k */
+	)
+{
+	struct pgm_rs_matrix_t* victim = &rs->matrix_cache[ 0 ];
+
+	for (unsigned i = 0; i < PGM_RS_MATRIX_CACHE; i++)
+	{
+		struct pgm_rs_matrix_t* entry = &rs->matrix_cache[ i ];
+		if (NULL == entry->RM) {
+			victim = entry;
+			break;
+		}
+		if (0 == memcmp (entry->offsets, offsets, rs->k)) {
+			entry->last_use = ++rs->matrix_clock;
+			rs->matrix_hits++;
+			return entry->RM;
+		}
+		if (pgm_uint32_lt (entry->last_use, victim->last_use))
+			victim = entry;
+	}
+
+	rs->matrix_misses++;
+	if (NULL == victim->RM) {
+/* single allocation for matrix and key */
+		victim->RM = pgm_malloc ((rs->k * rs->k) + rs->k);
+		victim->offsets = victim->RM + (rs->k * rs->k);
+	}
+
 /* create new recovery matrix from generator
  */
 	for (uint_fast8_t i = 0; i < rs->k; i++)
 	{
 		if (offsets[i] < rs->k) {
-			memset (&rs->RM[ i * rs->k ], 0, rs->k * sizeof(pgm_gf8_t));
-			rs->RM[ (i * rs->k) + i ] = 1;
+			memset (&victim->RM[ i * rs->k ], 0, rs->k * sizeof(pgm_gf8_t));
+			victim->RM[ (i * rs->k) + i ] = 1;
 			continue;
 		}
-		memcpy (&rs->RM[ i * rs->k ], &rs->GM[ offsets[ i ] * rs->k ], rs->k * sizeof(pgm_gf8_t));
+		memcpy (&victim->RM[ i * rs->k ], &rs->GM[ offsets[ i ] * rs->k ], rs->k * sizeof(pgm_gf8_t));
 	}
 
 /* invert */
-	_pgm_matinv (rs->RM, rs->k);
+	_pgm_matinv (victim->RM, rs->k);
+
+	memcpy (victim->offsets, offsets, rs->k);
+	victim->last_use = ++rs->matrix_clock;
+	return victim->RM;
+}
+
+/* original data block of packets with missing packet entries replaced
+ * with on-demand parity packets.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_rs_decode_parity_inline (
+	pgm_rs_t*      restrict rs,
+	pgm_gf8_t**    restrict block,		/* length rs_t::k */
+	const uint8_t* restrict	offsets,	/* offsets within FEC block, 0 < offset < n */
+	const uint16_t	        len		/* packet length */
+	)
+{
+	pgm_assert (NULL != rs);
+	pgm_assert (NULL != block);
+	pgm_assert (NULL != offsets);
+	pgm_assert (len > 0);
+
+	const pgm_gf8_t* RM = _pgm_rs_recovery_matrix (rs, offsets);
 
 #ifndef _MSC_VER
 	pgm_gf8_t* repairs[ rs->k ];
@@ -585,7 +977,7 @@ pgm_rs_decode_parity_inline (
 		for (uint_fast8_t i = 0; i < rs->k; i++)
 		{
 			pgm_gf8_t* src = block[ i ];
-			pgm_gf8_t c = rs->RM[ (j * rs->k) + i ];
+			pgm_gf8_t c = RM[ (j * rs->k) + i ];
 			_pgm_gf_vec_addmul (erasure, c, src, len);
 		}
 	}
@@ -622,20 +1014,7 @@ pgm_rs_decode_parity_appended (
 	pgm_assert (NULL != offsets);
 	pgm_assert (len > 0);
 
-/* create new recovery matrix from generator
- */
-	for (uint_fast8_t i = 0; i < rs->k; i++)
-	{
-		if (offsets[i] < rs->k) {
-			memset (&rs->RM[ i * rs->k ], 0, rs->k * sizeof(pgm_gf8_t));
-			rs->RM[ (i * rs->k) + i ] = 1;
-			continue;
-		}
-		memcpy (&rs->RM[ i * rs->k ], &rs->GM[ offsets[ i ] * rs->k ], rs->k * sizeof(pgm_gf8_t));
-	}
-
-/* invert */
-	_pgm_matinv (rs->RM, rs->k);
+	const pgm_gf8_t* RM = _pgm_rs_recovery_matrix (rs, offsets);
 
 /* multiply out, through the length of erasures[] */
 	for (uint_fast8_t j = 0; j < rs->k; j++)
@@ -652,7 +1031,7 @@ pgm_rs_decode_parity_appended (
 				src = block[ i ];
 			else
 				src = block[ p++ ];
-			const pgm_gf8_t c = rs->RM[ (j * rs->k) + i ];
+			const pgm_gf8_t c = RM[ (j * rs->k) + i ];
 			_pgm_gf_vec_addmul (erasure, c, src, len);
 		}
 	}
@@ -0,0 +1,313 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * performance tests for Reed-Solomon forward error correction.
+ *
+ * Copyright (c) 2010-2016 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <glib.h>
+#include <check.h>
+
+
+/* mock state */
+
+#define PERF_ITERATIONS		10000
+#define PERF_PACKET_LENGTH	1500
+
+static unsigned perf_n		= 0;
+static unsigned perf_k		= 0;
+
+static
+void
+mock_setup_18_16 (void)
+{
+	perf_n		= 18;
+	perf_k		= 16;
+}
+
+static
+void
+mock_setup_72_64 (void)
+{
+	perf_n		= 72;
+	perf_k		= 64;
+}
+
+static
+void
+mock_setup_255_223 (void)
+{
+	perf_n		= 255;
+	perf_k		= 223;
+}
+
+/* mock functions for external references */
+
+size_t
+pgm_transport_pkt_offset2 (
+        const bool                      can_fragment,
+        const bool                      use_pgmcc
+        )
+{
+        return 0;
+}
+
+#define REED_SOLOMON_DEBUG
+#include "reed_solomon.c"
+
+PGM_GNUC_INTERNAL
+int
+pgm_get_nprocs (void)
+{
+	return 1;
+}
+
+static
+void
+mock_setup (void)
+{
+	pgm_cpu_t cpu;
+	pgm_cpuid (&cpu);
+	pgm_rs_init (&cpu);
+	g_assert (pgm_time_init (NULL));
+}
+
+static
+void
+mock_teardown (void)
+{
+	g_assert (pgm_time_shutdown ());
+}
+
+static
+void
+perf_report (
+	const char*		name,
+	const pgm_time_t	elapsed,		/* μs */
+	const guint64		count
+	)
+{
+	g_message ("%s/(%u,%u): elapsed time %" PGM_TIME_FORMAT " us, unit time %" PGM_TIME_FORMAT " ns, %" PGM_TIME_FORMAT " packets/s",
+		name, perf_n, perf_k,
+		(guint64)elapsed,
+		(guint64)((1000 * elapsed) / count),
+		(guint64)(elapsed ? (1000000 * count) / elapsed : 0));
+}
+
+/* a transmission group of k source packets followed by n - k parity packets.
+ */
+static
+pgm_gf8_t**
+generate_block (void)
+{
+	pgm_gf8_t** block = g_malloc0 (perf_n * sizeof(pgm_gf8_t*));
+	for (unsigned i = 0; i < perf_n; i++) {
+		block[i] = g_malloc0 (PERF_PACKET_LENGTH);
+		if (i < perf_k)
+			for (unsigned j = 0; j < PERF_PACKET_LENGTH; j++)
+				block[i][j] = (pgm_gf8_t)((i * 31) + (j * 7));
+	}
+	return block;
+}
+
+static
+void
+free_block (
+	pgm_gf8_t**		block
+	)
+{
+	for (unsigned i = 0; i < perf_n; i++)
+		g_free (block[i]);
+	g_free (block);
+}
+
+/* target:
+ *	void
+ *	pgm_rs_encode (
+ *		pgm_rs_t*		rs,
+ *		const pgm_gf8_t**	src,
+ *		const uint8_t		offset,
+ *		pgm_gf8_t*		dst,
+ *		const uint16_t		len
+ *	)
+ *
+ * one parity packet per call, as on-demand parity services a NAK.
+ */
+
+START_TEST (test_encode)
+{
+	pgm_rs_t rs;
+	pgm_gf8_t** block = generate_block ();
+	pgm_time_t start, check;
+
+	pgm_rs_create (&rs, perf_n, perf_k);
+	start = pgm_time_update_now();
+	for (unsigned i = 0; i < PERF_ITERATIONS; i++) {
+		const uint8_t offset = perf_k + (i % (perf_n - perf_k));
+		pgm_rs_encode (&rs, (const pgm_gf8_t**)block, offset, block[offset], PERF_PACKET_LENGTH);
+	}
+	check = pgm_time_update_now();
+	perf_report ("encode", check - start, PERF_ITERATIONS);
+	pgm_rs_destroy (&rs);
+	free_block (block);
+}
+END_TEST
+
+/* target:
+ *	void
+ *	pgm_rs_encode_multi (
+ *		pgm_rs_t*		rs,
+ *		const pgm_gf8_t**	src,
+ *		const uint8_t*		offsets,
+ *		pgm_gf8_t**		dst,
+ *		const uint8_t		count,
+ *		const uint16_t		len
+ *	)
+ *
+ * all n - k parity packets of a transmission group in one pass, as proactive
+ * parity.  iterations are scaled so each test produces the same count of parity
+ * packets.
+ */
+
+START_TEST (test_encode_multi)
+{
+	pgm_rs_t rs;
+	pgm_gf8_t** block = generate_block ();
+	const uint8_t h = perf_n - perf_k;
+	uint8_t offsets[h];
+	pgm_time_t start, check;
+
+	for (unsigned j = 0; j < h; j++)
+		offsets[j] = perf_k + j;
+	pgm_rs_create (&rs, perf_n, perf_k);
+	start = pgm_time_update_now();
+	for (unsigned i = PERF_ITERATIONS / h; i; i--)
+		pgm_rs_encode_multi (&rs, (const pgm_gf8_t**)block, offsets, &block[perf_k], h, PERF_PACKET_LENGTH);
+	check = pgm_time_update_now();
+	perf_report ("encode_multi", check - start, (PERF_ITERATIONS / h) * h);
+	pgm_rs_destroy (&rs);
+	free_block (block);
+}
+END_TEST
+
+/* target:
+ *	void
+ *	pgm_rs_decode_parity_appended (
+ *		pgm_rs_t*		rs,
+ *		pgm_gf8_t**		block,
+ *		const uint8_t*		offsets,
+ *		const uint16_t		len
+ *	)
+ *
+ * recover the most erasures the group allows, n - k, spread through the group.
+ * erased packets are cleared on each pass as the receive window does.
+ */
+
+START_TEST (test_decode_parity_appended)
+{
+	pgm_rs_t rs;
+	pgm_gf8_t** block = generate_block ();
+	const uint8_t h = perf_n - perf_k;
+	uint8_t offsets[perf_k];
+	pgm_time_t start, check;
+
+	pgm_rs_create (&rs, perf_n, perf_k);
+	for (unsigned j = 0; j < h; j++)
+		pgm_rs_encode (&rs, (const pgm_gf8_t**)block, perf_k + j, block[perf_k + j], PERF_PACKET_LENGTH);
+	for (unsigned i = 0; i < perf_k; i++)
+		offsets[i] = i;
+	const unsigned stride = perf_k / h;
+	for (unsigned j = 0; j < h; j++)
+		offsets[j * stride] = perf_k + j;
+	pgm_gf8_t expected[PERF_PACKET_LENGTH];
+	memcpy (expected, block[0], PERF_PACKET_LENGTH);
+
+	start = pgm_time_update_now();
+	for (unsigned i = PERF_ITERATIONS / h; i; i--) {
+		for (unsigned j = 0; j < h; j++)
+			memset (block[j * stride], 0, PERF_PACKET_LENGTH);
+		pgm_rs_decode_parity_appended (&rs, block, offsets, PERF_PACKET_LENGTH);
+	}
+	check = pgm_time_update_now();
+	fail_unless (0 == memcmp (expected, block[0], PERF_PACKET_LENGTH), "decode failed");
+	perf_report ("decode_parity_appended", check - start, (PERF_ITERATIONS / h) * h);
+	pgm_rs_destroy (&rs);
+	free_block (block);
+}
+END_TEST
+
+static
+Suite*
+make_rs_suite (void)
+{
+	Suite* s;
+
+	s = suite_create ("Reed-Solomon");
+
+	TCase* tc_18_16 = tcase_create ("(18,16)");
+	suite_add_tcase (s, tc_18_16);
+	tcase_add_checked_fixture (tc_18_16, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_18_16, mock_setup_18_16, NULL);
+	tcase_add_test (tc_18_16, test_encode);
+	tcase_add_test (tc_18_16, test_encode_multi);
+	tcase_add_test (tc_18_16, test_decode_parity_appended);
+
+	TCase* tc_72_64 = tcase_create ("(72,64)");
+	suite_add_tcase (s, tc_72_64);
+	tcase_add_checked_fixture (tc_72_64, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_72_64, mock_setup_72_64, NULL);
+	tcase_add_test (tc_72_64, test_encode);
+	tcase_add_test (tc_72_64, test_encode_multi);
+	tcase_add_test (tc_72_64, test_decode_parity_appended);
+
+	TCase* tc_255_223 = tcase_create ("(255,223)");
+	suite_add_tcase (s, tc_255_223);
+	tcase_add_checked_fixture (tc_255_223, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_255_223, mock_setup_255_223, NULL);
+	tcase_add_test (tc_255_223, test_encode);
+	tcase_add_test (tc_255_223, test_encode_multi);
+	tcase_add_test (tc_255_223, test_decode_parity_appended);
+
+	return s;
+}
+
+static
+Suite*
+make_master_suite (void)
+{
+	Suite* s = suite_create ("Master");
+	return s;
+}
+
+int
+main (void)
+{
+	SRunner* sr = srunner_create (make_master_suite ());
+	srunner_add_suite (sr, make_rs_suite ());
+	srunner_run_all (sr, CK_ENV);
+	int number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* eof */
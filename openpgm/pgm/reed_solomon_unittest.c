@@ -56,6 +56,40 @@ pgm_get_nprocs (void)
 	return 1;
 }
 
+/* target:
+ *	void
+ *	pgm_rs_init (
+ *		const pgm_cpu_t*	cpu
+ *	)
+ */
+
+START_TEST (test_init_pass_001)
+{
+	pgm_cpu_t cpu;
+	pgm_gf8_t s[1500], d[1500], e[1500];
+	pgm_cpuid (&cpu);
+	pgm_rs_init (&cpu);
+/* odd length and offset to cover vector tails and unaligned access */
+	for (unsigned i = 0; i < sizeof(s); i++) {
+		s[i] = (pgm_gf8_t)(i * 7);
+		d[i] = e[i] = (pgm_gf8_t)(i * 13);
+	}
+	for (unsigned b = 1; b < PGM_GF_NO_ELEMENTS; b++) {
+		_pgm_gf_vec_addmul (&d[1], (pgm_gf8_t)b, &s[1], 1499);
+		for (unsigned i = 1; i < sizeof(e); i++)
+			e[i] ^= pgm_gfmul ((pgm_gf8_t)b, s[i]);
+	}
+	fail_unless (0 == memcmp (d, e, sizeof(d)), "vector kernel mismatch");
+}
+END_TEST
+
+START_TEST (test_init_fail_001)
+{
+	pgm_rs_init (NULL);
+	fail ("reached");
+}
+END_TEST
+
 /* target:
  *	void
  *	pgm_rs_create (
@@ -141,6 +175,54 @@ START_TEST (test_encode_fail_001)
 }
 END_TEST
 
+/* target:
+ *	void
+ *	pgm_rs_encode_multi (
+ *		pgm_rs_t*		rs,
+ *		const pgm_gf8_t**	src,
+ *		const uint8_t*		offsets,
+ *		pgm_gf8_t**		dst,
+ *		const uint8_t		count,
+ *		const uint16_t		len
+ *	)
+ */
+
+START_TEST (test_encode_multi_pass_001)
+{
+	pgm_rs_t rs;
+	const uint8_t n = 255, k = 64, count = 4;
+	const uint16_t len = 1500;
+	pgm_gf8_t* data = g_malloc0 (k * len);
+	const pgm_gf8_t* src[k];
+	pgm_gf8_t parity[count][len], expected[len];
+	pgm_gf8_t* dst[count];
+	uint8_t offsets[count];
+	pgm_rs_create (&rs, n, k);
+	for (unsigned i = 0; i < (unsigned)(k * len); i++)
+		data[i] = (pgm_gf8_t)(i * 31);
+	for (unsigned i = 0; i < k; i++)
+		src[i] = &data[i * len];
+	for (unsigned j = 0; j < count; j++) {
+		offsets[j] = k + (2 * j);
+		dst[j] = parity[j];
+	}
+	pgm_rs_encode_multi (&rs, src, offsets, dst, count, len);
+	for (unsigned j = 0; j < count; j++) {
+		pgm_rs_encode (&rs, src, offsets[j], expected, len);
+		fail_unless (0 == memcmp (parity[j], expected, len), "parity mismatch");
+	}
+	pgm_rs_destroy (&rs);
+	g_free (data);
+}
+END_TEST
+
+START_TEST (test_encode_multi_fail_001)
+{
+	pgm_rs_encode_multi (NULL, NULL, NULL, NULL, 0, 0);
+	fail ("reached");
+}
+END_TEST
+
 /* target:
  *	void
  *	pgm_rs_decode_parity_inline (
@@ -257,6 +339,40 @@ START_TEST (test_decode_parity_appended_fail_001)
 END_TEST
 
 
+/* repeated erasure pattern re-uses the inverted recovery matrix */
+START_TEST (test_decode_parity_appended_pass_002)
+{
+	pgm_rs_t rs;
+	const guint8 k = 8;
+	const guint16 packet_len = 100;
+	pgm_gf8_t* source_packets[k];
+	pgm_gf8_t* block[k+1];		/* include 1 appended parity packet */
+	pgm_gf8_t* parity_packet = g_malloc0 (packet_len);
+	guint8 offsets[k];
+	const guint erased_index = k - 1;
+	pgm_rs_create (&rs, 255, k);
+	for (unsigned i = 0; i < k; i++) {
+		source_packets[i] = g_malloc0 (packet_len);
+		memset (source_packets[i], 'a' + i, packet_len);
+		block[i] = g_malloc0 (packet_len);
+		offsets[i] = i;
+	}
+	offsets[erased_index] = k;
+	pgm_rs_encode (&rs, (const pgm_gf8_t**)source_packets, k, parity_packet, packet_len);
+	block[k] = parity_packet;
+	for (unsigned round = 0; round < 2; round++) {
+		for (unsigned i = 0; i < k; i++)
+			memcpy (block[i], source_packets[i], packet_len);
+		memset (block[erased_index], 0, packet_len);
+		pgm_rs_decode_parity_appended (&rs, block, offsets, packet_len);
+		fail_unless (0 == memcmp (block[erased_index], source_packets[erased_index], packet_len), "decode failed");
+	}
+	fail_unless (1 == rs.matrix_misses, "matrix_misses");
+	fail_unless (1 == rs.matrix_hits, "matrix_hits");
+	pgm_rs_destroy (&rs);
+}
+END_TEST
+
 static
 Suite*
 make_test_suite (void)
@@ -265,6 +381,13 @@ make_test_suite (void)
 
 	s = suite_create (__FILE__);
 
+	TCase* tc_init = tcase_create ("init");
+	suite_add_tcase (s, tc_init);
+	tcase_add_test (tc_init, test_init_pass_001);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_init, test_init_fail_001, SIGABRT);
+#endif
+
 	TCase* tc_create = tcase_create ("create");
 	suite_add_tcase (s, tc_create);
 	tcase_add_test (tc_create, test_create_pass_001);
@@ -286,6 +409,13 @@ make_test_suite (void)
 	tcase_add_test_raise_signal (tc_encode, test_encode_fail_001, SIGABRT);
 #endif
 
+	TCase* tc_encode_multi = tcase_create ("encode-multi");
+	suite_add_tcase (s, tc_encode_multi);
+	tcase_add_test (tc_encode_multi, test_encode_multi_pass_001);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_encode_multi, test_encode_multi_fail_001, SIGABRT);
+#endif
+
 	TCase* tc_decode_parity_inline = tcase_create ("decode-parity-inline");
 	suite_add_tcase (s, tc_decode_parity_inline);
 	tcase_add_test (tc_decode_parity_inline, test_decode_parity_inline_pass_001);
@@ -296,6 +426,7 @@ make_test_suite (void)
 	TCase* tc_decode_parity_appended = tcase_create ("decode-parity-appended");
 	suite_add_tcase (s, tc_decode_parity_appended);
 	tcase_add_test (tc_decode_parity_appended, test_decode_parity_appended_pass_001);
+	tcase_add_test (tc_decode_parity_appended, test_decode_parity_appended_pass_002);
 #ifndef PGM_CHECK_NOFORK
 	tcase_add_test_raise_signal (tc_decode_parity_appended, test_decode_parity_appended_fail_001, SIGABRT);
 #endif
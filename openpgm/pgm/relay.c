@@ -0,0 +1,484 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * PGM relay, forwarding the sessions of a receiving socket to a multicast
+ * group of another network or to unicast subscribers.
+ *
+ * A receiving socket with PGM_RELAY sends every ODATA and RDATA TPDU it
+ * receives, unchanged and straight from the receive buffer, to the relay
+ * group on the relay interface.  TSI and sequence numbers are those of the
+ * source, nothing is reassembled or re-fragmented.  SPMs are forwarded with
+ * the path NLA replaced by the relay interface address such that receivers
+ * of the downstream network NAK the relay.  The relay is a DLR for these
+ * receivers: NAKs are repaired from the PGM_DLR cache with RDATA on the
+ * relay group, and a NAK naming any sequence number no longer cached is
+ * forwarded to the source with source and group NLA of the upstream session.
+ *
+ * As a gateway the relay also sends every TPDU to a list of unicast
+ * subscribers, UDP-encapsulated receivers of networks without multicast,
+ * with one sendmmsg() call for the group and all subscribers.  Each
+ * subscriber has its own rate limit, a TPDU over the limit is not sent to
+ * that subscriber and recovered by NAK as any other loss.  The NAK of a
+ * subscriber is repaired from the shared DLR cache to that subscriber alone.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <string.h>
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/relay.h>
+#include <impl/net.h>
+
+
+//#define RELAY_DEBUG
+
+#ifndef RELAY_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+/* open the downstream send socket whilst privileges permit, called by
+ * pgm_setsockopt() with the relay group, or NULL for a gateway of unicast
+ * subscribers only.
+ *
+ * returns the relay, or NULL if the socket cannot be opened.
+ */
+
+PGM_GNUC_INTERNAL
+struct pgm_relay_t*
+pgm_relay_create (
+	pgm_sock_t*		const restrict sock,
+	const struct group_req*	const restrict gr
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	const SOCKET send_sock = socket (sock->family,
+					 IPPROTO_UDP == sock->protocol ? SOCK_DGRAM : SOCK_RAW,
+					 sock->protocol);
+	if (INVALID_SOCKET == send_sock)
+		return NULL;
+	struct pgm_relay_t* relay = pgm_new0 (struct pgm_relay_t, 1);
+	relay->send_sock = send_sock;
+	relay->gr.gr_group.ss_family = AF_UNSPEC;
+	sock->relay = relay;
+	if (NULL != gr)
+		pgm_relay_set_group (sock, gr);
+	return relay;
+}
+
+PGM_GNUC_INTERNAL
+void
+pgm_relay_destroy (
+	struct pgm_relay_t* const	relay
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != relay);
+
+	if (INVALID_SOCKET != relay->send_sock) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Closing relay send socket."));
+		closesocket (relay->send_sock);
+	}
+	for (unsigned i = 0; i < relay->subscriber_len; i++)
+		if (relay->subscribers[ i ].rate > 0)
+			pgm_rate_destroy (&relay->subscribers[ i ].rate_control);
+	pgm_free (relay);
+}
+
+PGM_GNUC_INTERNAL
+void
+pgm_relay_set_group (
+	pgm_sock_t*		const restrict sock,
+	const struct group_req*	const restrict gr
+	)
+{
+	struct pgm_relay_t* relay = sock->relay;
+
+/* pre-conditions */
+	pgm_assert (NULL != relay);
+	pgm_assert (NULL != gr);
+
+	memcpy (&relay->gr, gr, sizeof(struct group_req));
+	if (sock->udp_encap_mcast_port)
+		((struct sockaddr_in*)&relay->gr.gr_group)->sin_port = htons (sock->udp_encap_mcast_port);
+}
+
+/* append a unicast subscriber, called by pgm_setsockopt().
+ *
+ * returns TRUE on success, FALSE if the list is full or the address is listed.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_relay_add_subscriber (
+	struct pgm_relay_t*		      const restrict relay,
+	const struct pgm_relaysubinfo_t* const restrict info
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != relay);
+	pgm_assert (NULL != info);
+
+	if (PGM_UNLIKELY(relay->subscriber_len >= PGM_RELAY_SUBSCRIBERS_MAX))
+		return FALSE;
+	for (unsigned i = 0; i < relay->subscriber_len; i++)
+		if (0 == pgm_sockaddr_cmp ((const struct sockaddr*)&info->addr,
+					   (const struct sockaddr*)&relay->subscribers[ i ].addr))
+			return FALSE;
+	struct pgm_relay_subscriber_t* subscriber = &relay->subscribers[ relay->subscriber_len++ ];
+	memcpy (&subscriber->addr, &info->addr, sizeof(struct sockaddr_storage));
+	subscriber->rate = info->rate;
+	return TRUE;
+}
+
+/* bind the downstream send socket to the address of the relay interface,
+ * the NLA of forwarded SPMs, and apply the multicast hop limit of the
+ * socket.  a gateway without relay group uses the send interface of the
+ * socket.  the relay never blocks, a packet refused is recovered by NAK.
+ *
+ * returns TRUE on success, or FALSE on error and sets error appropriately.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_relay_bind (
+	pgm_sock_t*    const restrict sock,
+	pgm_error_t**	     restrict error
+	)
+{
+	struct pgm_relay_t* relay = sock->relay;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != relay);
+
+	const bool has_group = (AF_UNSPEC != relay->gr.gr_group.ss_family);
+	if (!has_group) {
+		memcpy (&relay->nla, &sock->send_addr, sizeof(struct sockaddr_storage));
+		((struct sockaddr_in*)&relay->nla)->sin_port = 0;
+	} else if (!pgm_if_indextoaddr (relay->gr.gr_interface,
+					sock->family,
+					0,
+					(struct sockaddr*)&relay->nla,
+					error))
+		return FALSE;
+
+/* subscribers receive on the UDP encapsulation port of the session */
+	for (unsigned i = 0; i < relay->subscriber_len; i++) {
+		struct pgm_relay_subscriber_t* subscriber = &relay->subscribers[ i ];
+		if (0 == ((struct sockaddr_in*)&subscriber->addr)->sin_port)
+			((struct sockaddr_in*)&subscriber->addr)->sin_port = htons (sock->udp_encap_mcast_port);
+		if (0 == subscriber->rate)
+			continue;
+		if (PGM_UNLIKELY(subscriber->rate < sock->max_tpdu)) {
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_SOCKET,
+				       PGM_ERROR_INVAL,
+				       _("Relay subscriber rate of %u bytes per second is below the maximum TPDU size."),
+				       (unsigned)subscriber->rate);
+			return FALSE;
+		}
+		pgm_rate_create (&subscriber->rate_control, subscriber->rate, sock->iphdr_len, sock->max_tpdu);
+	}
+
+	if (SOCKET_ERROR == bind (relay->send_sock,
+				  (struct sockaddr*)&relay->nla,
+				  pgm_sockaddr_len ((struct sockaddr*)&relay->nla)))
+	{
+		const int save_errno = pgm_get_last_sock_error();
+		char errbuf[1024];
+		char addr[INET6_ADDRSTRLEN];
+		pgm_sockaddr_ntop ((struct sockaddr*)&relay->nla, addr, sizeof(addr));
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_sock_errno (save_errno),
+			       _("Binding relay send socket to address %s: %s"),
+			       addr,
+			       pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		return FALSE;
+	}
+	pgm_sockaddr_nonblocking (relay->send_sock, TRUE);
+	if (has_group &&
+	    (SOCKET_ERROR == pgm_sockaddr_multicast_if (relay->send_sock,
+							(struct sockaddr*)&relay->nla,
+							relay->gr.gr_interface) ||
+	     SOCKET_ERROR == pgm_sockaddr_multicast_loop (relay->send_sock, sock->family, FALSE) ||
+	     (sock->hops > 0 &&
+	      SOCKET_ERROR == pgm_sockaddr_multicast_hops (relay->send_sock, sock->family, sock->hops))))
+	{
+		const int save_errno = pgm_get_last_sock_error();
+		char errbuf[1024];
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_sock_errno (save_errno),
+			       _("Setting multicast options of relay send socket: %s"),
+			       pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		return FALSE;
+	}
+	if (PGM_UNLIKELY(pgm_log_mask & PGM_LOG_ROLE_NETWORK))
+	{
+		char s[INET6_ADDRSTRLEN], group[INET6_ADDRSTRLEN];
+		pgm_sockaddr_ntop ((struct sockaddr*)&relay->nla, s, sizeof(s));
+		if (has_group) {
+			pgm_sockaddr_ntop ((struct sockaddr*)&relay->gr.gr_group, group, sizeof(group));
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Relaying to group %s from %s index %u"),
+				   group, s, (unsigned)relay->gr.gr_interface);
+		}
+		if (relay->subscriber_len > 0)
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Relaying to %u unicast subscribers from %s"),
+				   relay->subscriber_len, s);
+	}
+	return TRUE;
+}
+
+/* send one TPDU to count destinations with one sendmmsg() call where
+ * available, a destination refusing the packet is skipped.
+ *
+ * returns number of destinations sent to.
+ */
+
+static
+unsigned
+relay_sendmmsg (
+	const SOCKET			send_sock,
+	const void*		restrict tpdu,
+	const size_t			tpdu_length,
+	const struct sockaddr*const*restrict to,
+	const unsigned			count
+	)
+{
+	unsigned sent = 0;
+#ifdef HAVE_SENDMMSG
+	struct iovec iov = { .iov_base = (void*)tpdu, .iov_len = tpdu_length };
+	struct mmsghdr* msgvec = pgm_newa (struct mmsghdr, count);
+	for (unsigned i = 0; i < count; i++) {
+		memset (&msgvec[i], 0, sizeof(struct mmsghdr));
+		msgvec[i].msg_hdr.msg_name	= (void*)to[i];
+		msgvec[i].msg_hdr.msg_namelen	= pgm_sockaddr_len (to[i]);
+		msgvec[i].msg_hdr.msg_iov	= &iov;
+		msgvec[i].msg_hdr.msg_iovlen	= 1;
+	}
+	for (unsigned i = 0; i < count;) {
+		const int result = sendmmsg (send_sock, &msgvec[i], count - i, 0);
+		if (result > 0) {
+			i    += result;
+			sent += result;
+			continue;
+		}
+/* first remaining destination refused */
+		i++;
+	}
+#else
+	for (unsigned i = 0; i < count; i++)
+		if (sendto (send_sock, tpdu, tpdu_length, 0, to[i], pgm_sockaddr_len (to[i])) >= 0)
+			sent++;
+#endif /* HAVE_SENDMMSG */
+	return sent;
+}
+
+/* send one TPDU from the PGM header to the relay group and every unicast
+ * subscriber within its rate limit.
+ *
+ * returns TRUE on success, FALSE if the packet is refused by all.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_relay_send (
+	pgm_sock_t* const restrict	sock,
+	const void* restrict		tpdu,
+	const size_t			tpdu_length
+	)
+{
+	struct pgm_relay_t* relay = sock->relay;
+	const struct sockaddr* to[ 1 + PGM_RELAY_SUBSCRIBERS_MAX ];
+	unsigned count = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != relay);
+	pgm_assert (NULL != tpdu);
+
+	if (AF_UNSPEC != relay->gr.gr_group.ss_family)
+		to[ count++ ] = (const struct sockaddr*)&relay->gr.gr_group;
+	for (unsigned i = 0; i < relay->subscriber_len; i++) {
+		struct pgm_relay_subscriber_t* subscriber = &relay->subscribers[ i ];
+		if (subscriber->rate > 0 &&
+		    !pgm_rate_check (&subscriber->rate_control, tpdu_length, TRUE))
+			continue;
+		to[ count++ ] = (const struct sockaddr*)&subscriber->addr;
+	}
+	if (PGM_UNLIKELY(0 == count))
+		return FALSE;
+	const unsigned sent = relay_sendmmsg (relay->send_sock, tpdu, tpdu_length, to, count);
+	if (PGM_UNLIKELY(0 == sent))
+		return FALSE;
+	sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT] += sent * (tpdu_length + sock->iphdr_len);
+	return TRUE;
+}
+
+/* send one repair TPDU in answer to a NAK from nak_src: to that subscriber
+ * alone if it is one, otherwise to the relay group.
+ *
+ * returns TRUE on success, FALSE if the repair is not sent.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_relay_repair (
+	pgm_sock_t*	       const restrict sock,
+	const struct sockaddr* const restrict nak_src,
+	const void*		     restrict tpdu,
+	const size_t			      tpdu_length
+	)
+{
+	struct pgm_relay_t* relay = sock->relay;
+	const struct sockaddr* to = NULL;
+
+/* pre-conditions */
+	pgm_assert (NULL != relay);
+	pgm_assert (NULL != tpdu);
+
+	if (NULL != nak_src) {
+		for (unsigned i = 0; i < relay->subscriber_len; i++) {
+			struct pgm_relay_subscriber_t* subscriber = &relay->subscribers[ i ];
+			if (0 != pgm_sockaddr_cmp (nak_src, (const struct sockaddr*)&subscriber->addr))
+				continue;
+			if (subscriber->rate > 0 &&
+			    !pgm_rate_check (&subscriber->rate_control, tpdu_length, TRUE))
+				return FALSE;
+			to = (const struct sockaddr*)&subscriber->addr;
+			break;
+		}
+	}
+	if (NULL == to) {
+		if (AF_UNSPEC == relay->gr.gr_group.ss_family)
+			return FALSE;
+		to = (const struct sockaddr*)&relay->gr.gr_group;
+	}
+	const ssize_t sent = sendto (relay->send_sock,
+				     tpdu,
+				     tpdu_length,
+				     0,
+				     to,
+				     pgm_sockaddr_len (to));
+	if (PGM_UNLIKELY(sent < 0))
+		return FALSE;
+	sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT] += tpdu_length + sock->iphdr_len;
+	return TRUE;
+}
+
+/* forward original data or a repair as received, before the receive window
+ * takes the buffer.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_relay_forward (
+	pgm_sock_t*		    const restrict sock,
+	const struct pgm_sk_buff_t* const restrict skb
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != skb);
+
+	pgm_relay_send (sock, skb->pgm_header, sizeof(struct pgm_header) + skb->len);
+}
+
+/* forward an SPM naming the relay interface as path NLA, such that NAKs of
+ * downstream receivers reach the relay.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_relay_forward_spm (
+	pgm_sock_t*		    const restrict sock,
+	const struct pgm_sk_buff_t* const restrict skb
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != skb);
+
+	const struct pgm_spm* spm = skb->data;
+	if (PGM_UNLIKELY(pgm_ntohs (spm->spm_nla_afi) != (AF_INET6 == sock->family ? AFI_IP6 : AFI_IP))) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Unable to relay SPM of another address family."));
+		return;
+	}
+	const size_t tpdu_length = sizeof(struct pgm_header) + skb->len;
+	char* buf = pgm_alloca (tpdu_length);
+	memcpy (buf, skb->pgm_header, tpdu_length);
+	struct pgm_header* header = (struct pgm_header*)buf;
+	pgm_sockaddr_to_nla ((struct sockaddr*)&sock->relay->nla,
+			     (char*)&((struct pgm_spm*)(header + 1))->spm_nla_afi);
+	header->pgm_checksum	= 0;
+	header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
+	pgm_relay_send (sock, buf, tpdu_length);
+}
+
+/* forward a NAK of a downstream receiver to the source, source and group NLA
+ * replaced by those of the upstream session.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_relay_forward_nak (
+	pgm_sock_t*		    const restrict sock,
+	pgm_peer_t*		    const restrict peer,
+	const struct pgm_sk_buff_t* const restrict skb
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != peer);
+	pgm_assert (NULL != skb);
+
+	const struct pgm_nak* nak = skb->data;
+	const uint16_t afi = AF_INET6 == peer->nla.ss_family ? AFI_IP6 : AFI_IP;
+	if (PGM_UNLIKELY(pgm_ntohs (nak->nak_src_nla_afi) != afi ||
+			 peer->group_nla.ss_family != peer->nla.ss_family))
+	{
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Unable to forward relayed NAK of another address family."));
+		return;
+	}
+	const size_t tpdu_length = sizeof(struct pgm_header) + skb->len;
+	char* buf = pgm_alloca (tpdu_length);
+	memcpy (buf, skb->pgm_header, tpdu_length);
+	struct pgm_header* header = (struct pgm_header*)buf;
+	struct pgm_nak*  upstream  = (struct pgm_nak *)(header + 1);
+	struct pgm_nak6* upstream6 = (struct pgm_nak6*)(header + 1);
+	pgm_sockaddr_to_nla ((struct sockaddr*)&peer->nla, (char*)&upstream->nak_src_nla_afi);
+	pgm_sockaddr_to_nla ((struct sockaddr*)&peer->group_nla,
+			     (AFI_IP6 == afi) ? (char*)&upstream6->nak6_grp_nla_afi : (char*)&upstream->nak_grp_nla_afi);
+	header->pgm_checksum	= 0;
+	header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
+	pgm_sendto (sock,
+		    FALSE,			/* not rate limited */
+		    NULL,
+		    FALSE,			/* regular socket */
+		    buf,
+		    tpdu_length,
+		    (struct sockaddr*)&peer->nla,
+		    pgm_sockaddr_len ((struct sockaddr*)&peer->nla));
+}
+
+/* eof */
@@ -0,0 +1,451 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * replay of a packet capture through the receive path in place of the
+ * network, for comparing receive cost of builds on identical input.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#	include <time.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/replay.h>
+
+
+//#define REPLAY_DEBUG
+
+#ifndef REPLAY_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+/* libpcap file format, microsecond and nanosecond variants */
+#define PCAP_MAGIC		0xa1b2c3d4
+#define PCAP_MAGIC_NSEC		0xa1b23c4d
+#define PCAP_HEADER_LEN		24
+#define PCAP_RECORD_LEN		16
+
+/* link-layer header types */
+#define LINKTYPE_NULL		0
+#define LINKTYPE_ETHERNET	1
+#define LINKTYPE_RAW		101
+#define LINKTYPE_LOOP		108
+#define LINKTYPE_LINUX_SLL	113
+#define LINKTYPE_IPV4		228
+#define LINKTYPE_IPV6		229
+#define LINKTYPE_LINUX_SLL2	276
+
+#define ETHERTYPE_IPV4		0x0800
+#define ETHERTYPE_IPV6		0x86dd
+#define ETHERTYPE_VLAN		0x8100
+#define ETHERTYPE_QINQ		0x88a8
+
+static inline
+uint32_t
+read_u32 (
+	const struct pgm_replay_t*	replay,
+	const char*			p
+	)
+{
+	uint32_t v;
+	memcpy (&v, p, sizeof(v));
+	return replay->is_swapped ? ((v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24)) : v;
+}
+
+static inline
+uint16_t
+read_be16 (
+	const char*			p
+	)
+{
+	return (uint16_t)(((uint8_t)p[0] << 8) | (uint8_t)p[1]);
+}
+
+/* skip the link-layer header of a captured frame.
+ *
+ * returns the network header, or NULL when the frame carries neither IPv4
+ * nor IPv6.
+ */
+
+static
+const char*
+link_payload (
+	const struct pgm_replay_t*	replay,
+	const char*			frame,
+	size_t*				len
+	)
+{
+	size_t hdrlen;
+	uint16_t ethertype;
+
+	switch (replay->linktype) {
+	case LINKTYPE_RAW:
+	case LINKTYPE_IPV4:
+	case LINKTYPE_IPV6:
+		return frame;
+
+	case LINKTYPE_NULL:
+	case LINKTYPE_LOOP:
+		hdrlen = 4;
+		break;
+
+	case LINKTYPE_ETHERNET:
+		hdrlen = 14;
+		if (*len < hdrlen)
+			return NULL;
+		ethertype = read_be16 (frame + 12);
+		while ((ETHERTYPE_VLAN == ethertype || ETHERTYPE_QINQ == ethertype) && *len >= hdrlen + 4) {
+			ethertype = read_be16 (frame + hdrlen + 2);
+			hdrlen += 4;
+		}
+		if (ETHERTYPE_IPV4 != ethertype && ETHERTYPE_IPV6 != ethertype)
+			return NULL;
+		break;
+
+	case LINKTYPE_LINUX_SLL:
+		hdrlen = 16;
+		if (*len < hdrlen)
+			return NULL;
+		ethertype = read_be16 (frame + 14);
+		if (ETHERTYPE_IPV4 != ethertype && ETHERTYPE_IPV6 != ethertype)
+			return NULL;
+		break;
+
+	case LINKTYPE_LINUX_SLL2:
+		hdrlen = 20;
+		if (*len < hdrlen)
+			return NULL;
+		ethertype = read_be16 (frame);
+		if (ETHERTYPE_IPV4 != ethertype && ETHERTYPE_IPV6 != ethertype)
+			return NULL;
+		break;
+
+	default:
+		return NULL;
+	}
+
+	if (*len < hdrlen)
+		return NULL;
+	*len -= hdrlen;
+	return frame + hdrlen;
+}
+
+/* wait until the capture offset of the next packet at the replay speed.
+ */
+
+static
+void
+replay_pace (
+	struct pgm_replay_t*		replay,
+	const pgm_time_t		tstamp
+	)
+{
+	const pgm_time_t now = pgm_time_update_now();
+	if (0 == replay->packets) {
+		replay->first_tstamp = tstamp;
+		replay->start	     = now;
+		return;
+	}
+	if (pgm_time_after_eq (replay->first_tstamp, tstamp))
+		return;
+	const pgm_time_t due = replay->start + ((tstamp - replay->first_tstamp) * 100) / replay->speed;
+	if (pgm_time_after_eq (now, due))
+		return;
+	const pgm_time_t usecs = due - now;
+#ifndef _WIN32
+	struct timespec req = {
+		.tv_sec	 = (time_t)(usecs / 1000000),
+		.tv_nsec = (long)((usecs % 1000000) * 1000)
+	};
+	while (-1 == nanosleep (&req, &req) && EINTR == errno);
+#else
+	Sleep ((DWORD)(usecs / 1000));
+#endif
+}
+
+/* read a capture file into memory and validate the file header, called from
+ * pgm_bind() with sock::replay_path set.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error appropriately.
+ */
+
+bool
+pgm_replay_open (
+	pgm_sock_t*    const restrict sock,
+	pgm_error_t**	     restrict error
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->replay_path);
+	pgm_assert (NULL == sock->replay);
+
+	char errbuf[1024];
+	FILE* fp;
+	const errno_t err = pgm_fopen_s (&fp, sock->replay_path, "rb");
+	if (0 != err) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_errno (err),
+			       _("Opening capture %s: %s"),
+			       sock->replay_path,
+			       pgm_strerror_s (errbuf, sizeof (errbuf), err));
+		return FALSE;
+	}
+
+	struct pgm_replay_t* replay = pgm_new0 (struct pgm_replay_t, 1);
+	size_t size = 0;
+	for (;;) {
+		if (replay->len == size) {
+			size = size ? size * 2 : 1024 * 1024;
+			replay->buf = pgm_realloc (replay->buf, size);
+		}
+		const size_t bytes = fread (replay->buf + replay->len, 1, size - replay->len, fp);
+		if (0 == bytes)
+			break;
+		replay->len += bytes;
+	}
+	const bool is_error = (0 != ferror (fp));
+	const int save_errno = errno;
+	fclose (fp);
+	sock->replay = replay;
+	if (is_error) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_errno (save_errno),
+			       _("Reading capture %s: %s"),
+			       sock->replay_path,
+			       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		pgm_replay_close (sock);
+		return FALSE;
+	}
+
+	uint32_t magic = 0;
+	if (replay->len >= PCAP_HEADER_LEN)
+		memcpy (&magic, replay->buf, sizeof(magic));
+	switch (magic) {
+	case PCAP_MAGIC:
+	case PCAP_MAGIC_NSEC:
+		break;
+	default:
+		replay->is_swapped = TRUE;
+		magic = read_u32 (replay, replay->buf);
+		if (PCAP_MAGIC == magic || PCAP_MAGIC_NSEC == magic)
+			break;
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Capture %s is not in pcap format."),
+			       sock->replay_path);
+		pgm_replay_close (sock);
+		return FALSE;
+	}
+	replay->is_nsec	 = (PCAP_MAGIC_NSEC == magic);
+	replay->linktype = read_u32 (replay, replay->buf + 20) & 0xffff;
+	switch (replay->linktype) {
+	case LINKTYPE_NULL:
+	case LINKTYPE_ETHERNET:
+	case LINKTYPE_RAW:
+	case LINKTYPE_LOOP:
+	case LINKTYPE_LINUX_SLL:
+	case LINKTYPE_IPV4:
+	case LINKTYPE_IPV6:
+	case LINKTYPE_LINUX_SLL2:
+		break;
+	default:
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Capture %s has unsupported link type %u."),
+			       sock->replay_path,
+			       (unsigned)replay->linktype);
+		pgm_replay_close (sock);
+		return FALSE;
+	}
+	replay->offset = PCAP_HEADER_LEN;
+	replay->speed  = sock->replay_speed;
+
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Replaying %zu bytes of capture %s at %s."),
+		   replay->len, sock->replay_path,
+		   sock->replay_speed ? _("captured timing") : _("maximum speed"));
+	return TRUE;
+}
+
+void
+pgm_replay_close (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	struct pgm_replay_t* replay = sock->replay;
+	if (NULL == replay)
+		return;
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Replayed %" PRIu64 " packets, skipped %" PRIu64 "."),
+		   replay->packets, replay->skipped);
+	pgm_free (replay->buf);
+	pgm_free (replay);
+	sock->replay = NULL;
+}
+
+/* read the next PGM packet of the capture into a PGM skbuff as recvskb() would
+ * from the receive socket: with IPv4 header for a raw IPv4 socket, otherwise
+ * the PGM header onwards with the destination address from the IP header.
+ * PGM over UDP is re-framed as raw PGM and vice versa to match the socket.
+ *
+ * on success returns packet length, at end of capture returns 0.
+ */
+
+ssize_t
+pgm_replay_recvskb (
+	pgm_sock_t*           const restrict sock,
+	struct pgm_sk_buff_t* const restrict skb,
+	struct sockaddr*      const restrict src_addr,
+	const socklen_t			     src_addrlen,
+	struct sockaddr*      const restrict dst_addr,
+	const socklen_t			     dst_addrlen
+	)
+{
+	struct pgm_replay_t* replay = sock->replay;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != replay);
+	pgm_assert (NULL != skb);
+	pgm_assert (NULL != src_addr);
+	pgm_assert (src_addrlen >= sizeof(struct sockaddr_storage));
+	pgm_assert (NULL != dst_addr);
+	pgm_assert (dst_addrlen >= sizeof(struct sockaddr_storage));
+
+	while (replay->offset + PCAP_RECORD_LEN <= replay->len)
+	{
+		const char* record = replay->buf + replay->offset;
+		const uint32_t ts_sec  = read_u32 (replay, record);
+		const uint32_t ts_frac = read_u32 (replay, record + 4);
+		size_t caplen	       = read_u32 (replay, record + 8);
+		if (replay->offset + PCAP_RECORD_LEN + caplen > replay->len)
+			break;
+		replay->offset += PCAP_RECORD_LEN + caplen;
+
+		size_t len = caplen;
+		const char* nh = link_payload (replay, record + PCAP_RECORD_LEN, &len);
+		if (NULL == nh || 0 == len)
+			goto skip;
+
+/* network and transport headers */
+		const struct pgm_ip* ip = NULL;
+		const char* pgm;
+		size_t pgm_len;
+		uint8_t protocol;
+		const uint8_t version = (uint8_t)nh[0] >> 4;
+		if (4 == version) {
+			ip = (const struct pgm_ip*)nh;
+			const size_t ip_hl = ip->ip_hl * 4;
+			const size_t ip_len = pgm_ntohs (ip->ip_len);
+			if (len < sizeof(struct pgm_ip) || ip_hl < sizeof(struct pgm_ip) || ip_len < ip_hl || len < ip_len)
+				goto skip;
+			if (0 != (pgm_ntohs (ip->ip_off) & 0x3fff))		/* more-fragments or offset */
+				goto skip;
+			protocol = ip->ip_p;
+			pgm	 = nh + ip_hl;
+			pgm_len	 = ip_len - ip_hl;
+			struct sockaddr_in* sin = (struct sockaddr_in*)src_addr;
+			memset (sin, 0, sizeof(struct sockaddr_in));
+			sin->sin_family	= AF_INET;
+			sin->sin_addr	= ip->ip_src;
+			sin = (struct sockaddr_in*)dst_addr;
+			memset (sin, 0, sizeof(struct sockaddr_in));
+			sin->sin_family	= AF_INET;
+			sin->sin_addr	= ip->ip_dst;
+		} else if (6 == version) {
+			const struct pgm_ip6_hdr* ip6 = (const struct pgm_ip6_hdr*)nh;
+			if (len < sizeof(struct pgm_ip6_hdr))
+				goto skip;
+			protocol = ip6->ip6_nxt;
+			pgm	 = nh + sizeof(struct pgm_ip6_hdr);
+			pgm_len	 = pgm_ntohs (ip6->ip6_plen);
+			if (len - sizeof(struct pgm_ip6_hdr) < pgm_len)
+				goto skip;
+			struct sockaddr_in6* sin6 = (struct sockaddr_in6*)src_addr;
+			memset (sin6, 0, sizeof(struct sockaddr_in6));
+			sin6->sin6_family = AF_INET6;
+			sin6->sin6_addr	  = ip6->ip6_src;
+			sin6 = (struct sockaddr_in6*)dst_addr;
+			memset (sin6, 0, sizeof(struct sockaddr_in6));
+			sin6->sin6_family = AF_INET6;
+			sin6->sin6_addr	  = ip6->ip6_dst;
+		} else
+			goto skip;
+
+		if (IPPROTO_UDP == protocol) {
+			if (pgm_len < sizeof(struct pgm_udphdr))
+				goto skip;
+			pgm	+= sizeof(struct pgm_udphdr);
+			pgm_len -= sizeof(struct pgm_udphdr);
+		} else if (pgm_ipproto_pgm != protocol)
+			goto skip;
+
+/* raw IPv4 sockets read the IP header, the UDP header is replaced */
+		const bool has_ip_header = (NULL != ip && 0 == sock->udp_encap_ucast_port);
+		const size_t ip_hl = has_ip_header ? ip->ip_hl * 4 : 0;
+		if (ip_hl + pgm_len > sock->max_tpdu)
+			goto skip;
+		char* data = skb->head;
+		if (has_ip_header) {
+			memcpy (data, ip, ip_hl);
+			struct pgm_ip* skb_ip = (struct pgm_ip*)data;
+			skb_ip->ip_p = (uint8_t)pgm_ipproto_pgm;
+#ifndef HAVE_HOST_ORDER_IP_LEN
+			skb_ip->ip_len = pgm_htons ((uint16_t)(ip_hl + pgm_len));
+#else
+			skb_ip->ip_len = (uint16_t)(ip_hl + pgm_len);
+#endif
+#ifdef HAVE_HOST_ORDER_IP_OFF
+			skb_ip->ip_off = pgm_ntohs (skb_ip->ip_off);
+#endif
+		}
+		memcpy (data + ip_hl, pgm, pgm_len);
+
+		if (replay->speed > 0)
+			replay_pace (replay, (pgm_time_t)ts_sec * 1000000 + (replay->is_nsec ? ts_frac / 1000 : ts_frac));
+		replay->packets++;
+
+		skb->sock		= sock;
+		skb->tstamp		= pgm_time_coarse_now();
+		skb->rx_tstamp		= 0;
+		skb->data		= skb->head;
+		skb->len		= (uint16_t)(ip_hl + pgm_len);
+		skb->zero_padded	= 0;
+		skb->tail		= (char*)skb->data + skb->len;
+		return skb->len;
+
+skip:
+		replay->skipped++;
+	}
+	return 0;
+}
+
+/* eof */
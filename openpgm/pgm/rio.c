@@ -0,0 +1,668 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Windows Registered I/O packet I/O: receives posted over the registered
+ * packet buffer pool, batched deferred transmit, and completion by event or
+ * an application I/O completion port.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/rio.h>
+
+
+//#define RIO_DEBUG
+
+#ifndef RIO_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+#ifdef PGM_HAVE_RIO
+
+/* one in-flight datagram of the transmit queues */
+struct pgm_rio_send_t {
+	struct pgm_sk_buff_t*		skb;		/* reference held until completion, NULL when copied */
+};
+
+/* locate a buffer within a registered region.
+ *
+ * returns TRUE and fills buf when registered, otherwise returns FALSE.
+ */
+
+static
+bool
+rio_buffer (
+	const pgm_sock_t* const	sock,
+	const void*		addr,
+	const size_t		len,
+	RIO_BUF*		buf
+	)
+{
+	const struct pgm_rio_t* rio = sock->rio;
+	const char* p = addr;
+	const char* pool = sock->skb_pool->region.addr;
+	if (p >= pool && p + len <= pool + sock->skb_pool->region.len) {
+		buf->BufferId	= rio->pool_id;
+		buf->Offset	= (ULONG)(p - pool);
+		buf->Length	= (ULONG)len;
+		return TRUE;
+	}
+	if (RIO_INVALID_BUFFERID != rio->window_id &&
+	    p >= rio->window_addr && p + len <= rio->window_addr + rio->window_len)
+	{
+		buf->BufferId	= rio->window_id;
+		buf->Offset	= (ULONG)(p - rio->window_addr);
+		buf->Length	= (ULONG)len;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/* post receives for slots awaiting a buffer, buffers outside the registered
+ * pool are replaced from the pool and slots stay unposted while it is
+ * exhausted.
+ */
+
+static
+void
+rio_post_receives (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_rio_t* rio = sock->rio;
+	while (rio->rx_unposted_len > 0)
+	{
+		const unsigned slot = rio->rx_unposted[ rio->rx_unposted_len - 1 ];
+		struct pgm_sk_buff_t* skb = rio->rx_skb[ slot ];
+		RIO_BUF data;
+		if (NULL == skb ||
+		    !rio_buffer (sock, skb->head, sock->max_tpdu, &data))
+		{
+			if (NULL != skb)
+				pgm_free_skb (skb);
+			skb = pgm_skb_pool_alloc (sock->skb_pool, sock->max_tpdu);
+			if (!rio_buffer (sock, skb->head, sock->max_tpdu, &data)) {
+				pgm_free_skb (skb);
+				rio->rx_skb[ slot ] = NULL;
+				return;
+			}
+			rio->rx_skb[ slot ] = skb;
+		}
+		RIO_BUF name, control;
+		name.BufferId		= rio->rx_name_id;
+		name.Offset		= (ULONG)(slot * sizeof(struct pgm_rio_name_t) + offsetof(struct pgm_rio_name_t, addr));
+		name.Length		= sizeof(SOCKADDR_INET);
+		control.BufferId	= rio->rx_name_id;
+		control.Offset		= (ULONG)(slot * sizeof(struct pgm_rio_name_t) + offsetof(struct pgm_rio_name_t, control));
+		control.Length		= PGM_RIO_AUXLEN;
+		if (!rio->fn.RIOReceiveEx (rio->rx_rq, &data, 1, NULL, &name, &control, NULL, 0, (PVOID)(ULONG_PTR)slot)) {
+			char errbuf[1024];
+			const int save_errno = WSAGetLastError();
+			pgm_debug ("RIOReceiveEx failed: %s",
+				   pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+			return;
+		}
+		rio->rx_unposted_len--;
+	}
+}
+
+/* dequeue receive completions when none are buffered.
+ *
+ * returns number of buffered completions, or -1 on corrupt completion queue.
+ */
+
+static
+int
+rio_fill (
+	struct pgm_rio_t*	rio
+	)
+{
+	if (rio->results_head < rio->results_len)
+		return (int)(rio->results_len - rio->results_head);
+	const ULONG n = rio->fn.RIODequeueCompletion (rio->rx_cq, rio->results, rio->entries);
+	if (PGM_UNLIKELY(RIO_CORRUPT_CQ == n))
+		return -1;
+	rio->results_head = 0;
+	rio->results_len  = n;
+	return (int)n;
+}
+
+/* release completed transmissions, caller holds tx_mutex */
+
+static
+void
+rio_reap_sends (
+	struct pgm_rio_t*	rio
+	)
+{
+	RIORESULT results[ 64 ];
+	ULONG n;
+	do {
+		n = rio->fn.RIODequeueCompletion (rio->tx_cq, results, PGM_N_ELEMENTS(results));
+		if (PGM_UNLIKELY(RIO_CORRUPT_CQ == n))
+			return;
+		for (ULONG i = 0; i < n; i++) {
+			const unsigned index = (unsigned)results[i].RequestContext;
+			struct pgm_rio_send_t* slot = &rio->tx_slot[ index ];
+			if (PGM_UNLIKELY(0 != results[i].Status)) {
+				char errbuf[1024];
+				pgm_debug ("RIOSendEx completion failed: %s",
+					   pgm_sock_strerror_s (errbuf, sizeof (errbuf), results[i].Status));
+			}
+			if (NULL != slot->skb) {
+				pgm_free_skb (slot->skb);
+				slot->skb = NULL;
+			}
+			rio->tx_free[ rio->tx_free_len++ ] = index;
+		}
+	} while (PGM_N_ELEMENTS(results) == n);
+}
+
+static
+RIO_BUFFERID
+rio_register (
+	struct pgm_rio_t*	rio,
+	void*			addr,
+	const size_t		len
+	)
+{
+	return rio->fn.RIORegisterBuffer ((PCHAR)addr, (DWORD)len);
+}
+#endif /* PGM_HAVE_RIO */
+
+/* register the packet buffer pool, create completion and request queues on
+ * each socket and post the receives, called from pgm_bind() after sockets
+ * are bound.  Receive completions signal an internal event for blocking
+ * waits, or the application completion port of PGM_RIO_IOCP.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error appropriately.
+ */
+
+bool
+pgm_rio_open (
+	pgm_sock_t*    const restrict sock,
+	pgm_error_t**	     restrict error
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL == sock->rio);
+	pgm_assert (sock->rio_entries > 0);
+	pgm_assert_cmpuint (sock->rio_entries, <=, PGM_RIO_ENTRIES_MAX);
+
+#ifdef PGM_HAVE_RIO
+	char errbuf[1024];
+	int save_errno;
+	const char* what;
+
+	if (NULL == sock->skb_pool || NULL == sock->skb_pool->region.addr) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Registered I/O requires a reserved packet buffer pool."));
+		return FALSE;
+	}
+
+	const unsigned n = sock->rio_entries;
+	struct pgm_rio_t* rio = pgm_new0 (struct pgm_rio_t, 1);
+	rio->entries		= n;
+	rio->pool_id		= RIO_INVALID_BUFFERID;
+	rio->window_id		= RIO_INVALID_BUFFERID;
+	rio->rx_name_id		= RIO_INVALID_BUFFERID;
+	rio->tx_name_id		= RIO_INVALID_BUFFERID;
+	rio->tx_bounce_id	= RIO_INVALID_BUFFERID;
+	rio->rx_cq		= RIO_INVALID_CQ;
+	rio->tx_cq		= RIO_INVALID_CQ;
+	rio->notify_event	= WSA_INVALID_EVENT;
+	pgm_mutex_init (&rio->tx_mutex);
+	sock->rio		= rio;
+
+	GUID guid = WSAID_MULTIPLE_RIO;
+	DWORD bytes;
+	what = "SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER";
+	rio->fn.cbSize = sizeof(RIO_EXTENSION_FUNCTION_TABLE);
+	if (SOCKET_ERROR == WSAIoctl (sock->recv_sock,
+				      SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER,
+				      &guid, sizeof(guid),
+				      &rio->fn, sizeof(rio->fn),
+				      &bytes, NULL, NULL))
+		goto err_errno;
+
+/* packet buffers, and transmit window slots held in place */
+	what = "RIORegisterBuffer";
+	rio->pool_id = rio_register (rio, sock->skb_pool->region.addr, sock->skb_pool->region.len);
+	if (RIO_INVALID_BUFFERID == rio->pool_id)
+		goto err_errno;
+	if (NULL != sock->window && NULL != sock->window->slots) {
+		rio->window_addr = sock->window->slots->region.addr;
+		rio->window_len  = sock->window->slots->region.len;
+		rio->window_id   = rio_register (rio, rio->window_addr, rio->window_len);
+		if (RIO_INVALID_BUFFERID == rio->window_id)
+			goto err_errno;
+	}
+	rio->rx_name = pgm_new0 (struct pgm_rio_name_t, n);
+	rio->rx_name_id = rio_register (rio, rio->rx_name, n * sizeof(struct pgm_rio_name_t));
+	if (RIO_INVALID_BUFFERID == rio->rx_name_id)
+		goto err_errno;
+	rio->tx_name = pgm_new0 (SOCKADDR_INET, n);
+	rio->tx_name_id = rio_register (rio, rio->tx_name, n * sizeof(SOCKADDR_INET));
+	if (RIO_INVALID_BUFFERID == rio->tx_name_id)
+		goto err_errno;
+	rio->tx_bounce = pgm_malloc ((size_t)n * sock->max_tpdu);
+	rio->tx_bounce_id = rio_register (rio, rio->tx_bounce, (size_t)n * sock->max_tpdu);
+	if (RIO_INVALID_BUFFERID == rio->tx_bounce_id)
+		goto err_errno;
+
+	RIO_NOTIFICATION_COMPLETION notification;
+	memset (&notification, 0, sizeof(notification));
+	if (NULL != sock->rio_port) {
+		rio->is_iocp = TRUE;
+		notification.Type			= RIO_IOCP_COMPLETION;
+		notification.Iocp.IocpHandle		= sock->rio_port;
+		notification.Iocp.CompletionKey		= (PVOID)sock->rio_key;
+		notification.Iocp.Overlapped		= &rio->overlapped;
+	} else {
+		what = "CreateEvent";
+		rio->event = CreateEvent (NULL, FALSE, FALSE, NULL);
+		if (NULL == rio->event) {
+			WSASetLastError ((int)GetLastError());
+			goto err_errno;
+		}
+		notification.Type			= RIO_EVENT_COMPLETION;
+		notification.Event.EventHandle		= rio->event;
+		notification.Event.NotifyReset		= FALSE;
+	}
+
+/* every outstanding receive and send, plus the minimum of the unused direction */
+	what = "RIOCreateCompletionQueue";
+	rio->rx_cq = rio->fn.RIOCreateCompletionQueue (n + 2, &notification);
+	if (RIO_INVALID_CQ == rio->rx_cq)
+		goto err_errno;
+	rio->tx_cq = rio->fn.RIOCreateCompletionQueue ((2 * n) + 1, NULL);
+	if (RIO_INVALID_CQ == rio->tx_cq)
+		goto err_errno;
+
+	what = "RIOCreateRequestQueue";
+	rio->rx_rq = rio->fn.RIOCreateRequestQueue (sock->recv_sock, n, 1, 1, 1, rio->rx_cq, rio->tx_cq, sock);
+	if (RIO_INVALID_RQ == rio->rx_rq)
+		goto err_errno;
+	rio->tx_rq = rio->fn.RIOCreateRequestQueue (sock->send_sock, 1, 1, n, 1, rio->rx_cq, rio->tx_cq, sock);
+	if (RIO_INVALID_RQ == rio->tx_rq)
+		goto err_errno;
+	rio->tx_ra_rq = rio->fn.RIOCreateRequestQueue (sock->send_with_router_alert_sock, 1, 1, n, 1, rio->rx_cq, rio->tx_cq, sock);
+	if (RIO_INVALID_RQ == rio->tx_ra_rq)
+		goto err_errno;
+
+/* blocking waits also wake on pending data and repair notifications */
+	if (!rio->is_iocp) {
+		what = "WSAEventSelect";
+		rio->notify_event = WSACreateEvent();
+		if (WSA_INVALID_EVENT == rio->notify_event ||
+		    SOCKET_ERROR == WSAEventSelect (pgm_notify_get_socket (&sock->pending_notify), rio->notify_event, FD_READ))
+			goto err_errno;
+		if (sock->can_send_data &&
+		    SOCKET_ERROR == WSAEventSelect (pgm_notify_get_socket (&sock->rdata_notify), rio->notify_event, FD_READ))
+			goto err_errno;
+	}
+
+	rio->tx_slot	= pgm_new0 (struct pgm_rio_send_t, n);
+	rio->tx_free	= pgm_new (unsigned, n);
+	for (unsigned i = 0; i < n; i++)
+		rio->tx_free[ i ] = n - 1 - i;
+	rio->tx_free_len = n;
+
+	rio->results	 = pgm_new (RIORESULT, n);
+	rio->rx_skb	 = pgm_new0 (struct pgm_sk_buff_t*, n);
+	rio->rx_unposted = pgm_new (unsigned, n);
+	for (unsigned i = 0; i < n; i++)
+		rio->rx_unposted[ i ] = n - 1 - i;
+	rio->rx_unposted_len = n;
+
+/* failed posts are retried on each read, the queue is armed for the first completion */
+	rio_post_receives (sock);
+	rio->fn.RIONotify (rio->rx_cq);
+
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Using Registered I/O with %u outstanding receives%s."),
+		   n, rio->is_iocp ? _(" on application completion port") : "");
+	return TRUE;
+
+err_errno:
+	save_errno = WSAGetLastError();
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       pgm_error_from_wsa_errno (save_errno),
+		       _("Registered I/O %s: %s"),
+		       what,
+		       pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+	pgm_rio_close (sock);
+	return FALSE;
+#else
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       PGM_ERROR_NOSYS,
+		       _("Registered I/O unavailable on this platform."));
+	return FALSE;
+#endif /* PGM_HAVE_RIO */
+}
+
+/* release queues and registrations.  Request queues close with their sockets,
+ * called after the sockets so outstanding operations have been aborted.
+ */
+
+void
+pgm_rio_close (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+#ifdef PGM_HAVE_RIO
+	struct pgm_rio_t* rio = sock->rio;
+	if (NULL == rio)
+		return;
+
+	if (WSA_INVALID_EVENT != rio->notify_event) {
+		WSAEventSelect (pgm_notify_get_socket (&sock->pending_notify), NULL, 0);
+		if (sock->can_send_data)
+			WSAEventSelect (pgm_notify_get_socket (&sock->rdata_notify), NULL, 0);
+		WSACloseEvent (rio->notify_event);
+	}
+	if (NULL != rio->tx_slot) {
+		pgm_mutex_lock (&rio->tx_mutex);
+		if (RIO_INVALID_CQ != rio->tx_cq)
+			rio_reap_sends (rio);
+		for (unsigned i = 0; i < rio->entries; i++)
+			if (NULL != rio->tx_slot[ i ].skb)
+				pgm_free_skb (rio->tx_slot[ i ].skb);
+		pgm_mutex_unlock (&rio->tx_mutex);
+		pgm_free (rio->tx_free);
+		pgm_free (rio->tx_slot);
+	}
+	if (RIO_INVALID_CQ != rio->tx_cq)
+		rio->fn.RIOCloseCompletionQueue (rio->tx_cq);
+	if (RIO_INVALID_CQ != rio->rx_cq)
+		rio->fn.RIOCloseCompletionQueue (rio->rx_cq);
+	if (NULL != rio->event)
+		CloseHandle (rio->event);
+	if (NULL != rio->rx_skb) {
+		for (unsigned i = 0; i < rio->entries; i++)
+			if (NULL != rio->rx_skb[ i ])
+				pgm_free_skb (rio->rx_skb[ i ]);
+		pgm_free (rio->rx_skb);
+	}
+	if (NULL != rio->rx_unposted)
+		pgm_free (rio->rx_unposted);
+	if (NULL != rio->results)
+		pgm_free (rio->results);
+	if (RIO_INVALID_BUFFERID != rio->tx_bounce_id)
+		rio->fn.RIODeregisterBuffer (rio->tx_bounce_id);
+	if (RIO_INVALID_BUFFERID != rio->tx_name_id)
+		rio->fn.RIODeregisterBuffer (rio->tx_name_id);
+	if (RIO_INVALID_BUFFERID != rio->rx_name_id)
+		rio->fn.RIODeregisterBuffer (rio->rx_name_id);
+	if (RIO_INVALID_BUFFERID != rio->window_id)
+		rio->fn.RIODeregisterBuffer (rio->window_id);
+	if (RIO_INVALID_BUFFERID != rio->pool_id)
+		rio->fn.RIODeregisterBuffer (rio->pool_id);
+	if (NULL != rio->tx_bounce)
+		pgm_free (rio->tx_bounce);
+	if (NULL != rio->tx_name)
+		pgm_free (rio->tx_name);
+	if (NULL != rio->rx_name)
+		pgm_free (rio->rx_name);
+	pgm_mutex_free (&rio->tx_mutex);
+	pgm_free (rio);
+	sock->rio = NULL;
+#endif
+}
+
+#ifdef PGM_HAVE_RIO
+/* completions dequeued but not yet read */
+
+bool
+pgm_rio_is_pending (
+	const pgm_sock_t* const	sock
+	)
+{
+	return (NULL != sock->rio && sock->rio->results_head < sock->rio->results_len);
+}
+
+/* read the next completed receive.  The filled buffer is exchanged with the
+ * shard receive buffer as per recvmmskb(), the previous buffer is posted in its
+ * place on the next read once the address and control buffers are consumed.
+ * An empty completion queue is re-armed for notification.
+ *
+ * on success returns packet length, on empty completion queue returns -1 with
+ * EAGAIN, on error returns -1.
+ */
+
+ssize_t
+pgm_rio_recvskb (
+	pgm_sock_t*           const restrict sock,
+	struct sockaddr*      const restrict src_addr,
+	const socklen_t			     src_addrlen,
+	WSAMSG*		      const restrict ctl
+	)
+{
+	struct pgm_rio_t* rio = sock->rio;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != rio);
+	pgm_assert (NULL != src_addr);
+	pgm_assert (src_addrlen > 0);
+	pgm_assert (NULL != ctl);
+
+	if (PGM_UNLIKELY(sock->is_destroyed))
+		return 0;
+
+	rio_post_receives (sock);
+	for (;;)
+	{
+		const int filled = rio_fill (rio);
+		if (PGM_UNLIKELY(filled < 0)) {
+			pgm_set_last_sock_error (WSAEINVAL);
+			return SOCKET_ERROR;
+		}
+		if (0 == filled) {
+			rio->fn.RIONotify (rio->rx_cq);
+			pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+			return SOCKET_ERROR;
+		}
+
+		const RIORESULT* result = &rio->results[ rio->results_head++ ];
+		const unsigned slot = (unsigned)result->RequestContext;
+		struct pgm_sk_buff_t* skb = rio->rx_skb[ slot ];
+		rio->rx_unposted[ rio->rx_unposted_len++ ] = slot;
+		if (PGM_UNLIKELY(0 != result->Status)) {
+			char errbuf[1024];
+			pgm_debug ("RIOReceiveEx completion failed: %s",
+				   pgm_sock_strerror_s (errbuf, sizeof (errbuf), result->Status));
+			continue;
+		}
+		const size_t len = MIN((size_t)result->BytesTransferred, sock->max_tpdu);
+		if (0 == len)
+			continue;
+
+/* the previous receive buffer takes the slot */
+		rio->rx_skb[ slot ] = sock->rx_shard->rx_buffer;
+		sock->rx_shard->rx_buffer = skb;
+
+		const struct pgm_rio_name_t* name = &rio->rx_name[ slot ];
+		const socklen_t namelen = (AF_INET6 == name->addr.si_family) ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+		memcpy (src_addr, &name->addr, MIN(src_addrlen, namelen));
+		const RIO_CMSG_BUFFER* cmsg = (const RIO_CMSG_BUFFER*)name->control;
+		memset (ctl, 0, sizeof(WSAMSG));
+		ctl->Control.buf	= (char*)name->control + RIO_CMSG_BASE_SIZE;
+		ctl->Control.len	= cmsg->TotalLength > RIO_CMSG_BASE_SIZE ? MIN(cmsg->TotalLength, PGM_RIO_AUXLEN) - RIO_CMSG_BASE_SIZE : 0;
+
+		skb->sock		= sock;
+		skb->tstamp		= pgm_time_coarse_now();
+		skb->rx_tstamp		= 0;
+		skb->data		= skb->head;
+		skb->len		= (uint16_t)len;
+		skb->zero_padded	= 0;
+		skb->tail		= (char*)skb->data + len;
+		return len;
+	}
+}
+
+/* queue a vector of packets to one destination as deferred RIOSendEx()
+ * requests committed together.  Packets within a registered region are
+ * referenced until completion, others are copied to a registered slot.
+ * Blocking sockets spin on the completion queue when all slots are in
+ * flight.
+ *
+ * on success, returns number of packets queued.  on error, -1 is returned
+ * and the socket error set appropriately.
+ */
+
+int
+pgm_rio_sendv (
+	pgm_sock_t*	       const restrict sock,
+	const bool			      use_router_alert,
+	struct pgm_sk_buff_t*const* const restrict skbs,
+	const unsigned			      count,
+	const struct sockaddr* const restrict to,
+	const socklen_t			      tolen
+	)
+{
+	struct pgm_rio_t* rio = sock->rio;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != rio);
+	pgm_assert (NULL != skbs);
+	pgm_assert (count > 0);
+	pgm_assert (NULL != to);
+	pgm_assert (tolen <= sizeof(SOCKADDR_INET));
+
+	const RIO_RQ rq = use_router_alert ? rio->tx_ra_rq : rio->tx_rq;
+	bool is_deferred = FALSE;
+	int save_errno = 0;
+	unsigned i;
+
+	pgm_mutex_lock (&rio->tx_mutex);
+	rio_reap_sends (rio);
+	for (i = 0; i < count; i++)
+	{
+		while (0 == rio->tx_free_len) {
+			if (is_deferred) {
+				rio->fn.RIOCommitSends (rq);
+				is_deferred = FALSE;
+			}
+			rio_reap_sends (rio);
+			if (rio->tx_free_len > 0 || sock->is_nonblocking)
+				break;
+			SwitchToThread();
+		}
+		if (0 == rio->tx_free_len)
+			break;
+		const unsigned index = rio->tx_free[ --rio->tx_free_len ];
+		struct pgm_rio_send_t* slot = &rio->tx_slot[ index ];
+		const size_t len = (char*)skbs[i]->tail - (char*)skbs[i]->head;
+		RIO_BUF data, name;
+		if (rio_buffer (sock, skbs[i]->head, len, &data)) {
+			slot->skb = pgm_skb_get (skbs[i]);
+		} else {
+			char* bounce = rio->tx_bounce + ((size_t)index * sock->max_tpdu);
+			memcpy (bounce, skbs[i]->head, len);
+			data.BufferId	= rio->tx_bounce_id;
+			data.Offset	= (ULONG)((size_t)index * sock->max_tpdu);
+			data.Length	= (ULONG)len;
+			slot->skb	= NULL;
+		}
+		memcpy (&rio->tx_name[ index ], to, tolen);
+		name.BufferId	= rio->tx_name_id;
+		name.Offset	= (ULONG)(index * sizeof(SOCKADDR_INET));
+		name.Length	= sizeof(SOCKADDR_INET);
+
+		const DWORD flags = (i + 1 < count) ? RIO_MSG_DEFER : 0;
+		if (!rio->fn.RIOSendEx (rq, &data, 1, NULL, &name, NULL, NULL, flags, (PVOID)(ULONG_PTR)index)) {
+			save_errno = WSAGetLastError();
+			if (NULL != slot->skb) {
+				pgm_free_skb (slot->skb);
+				slot->skb = NULL;
+			}
+			rio->tx_free[ rio->tx_free_len++ ] = index;
+			break;
+		}
+		is_deferred = (0 != flags);
+	}
+	if (is_deferred)
+		rio->fn.RIOCommitSends (rq);
+	pgm_mutex_unlock (&rio->tx_mutex);
+
+	if (0 == i) {
+		pgm_set_last_sock_error (save_errno ? save_errno : PGM_SOCK_EAGAIN);
+		return -1;
+	}
+	return (int)i;
+}
+
+/* wait up to timeout microseconds for a receive completion or notification.
+ * With an application completion port the port carries receive completions,
+ * the queue is polled between waits on the notifications.
+ *
+ * returns 1 when ready, 0 on timeout, -1 on error.
+ */
+
+int
+pgm_rio_wait (
+	pgm_sock_t* const	sock,
+	const int		timeout		/* μs */
+	)
+{
+	struct pgm_rio_t* rio = sock->rio;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != rio);
+
+	int filled = rio_fill (rio);
+	if (0 != filled)
+		return filled < 0 ? SOCKET_ERROR : 1;
+
+	const DWORD ms = timeout > 0 ? (DWORD)((timeout + 999) / 1000) : 0;
+	if (rio->is_iocp) {
+		Sleep (MIN(ms, 1));
+		filled = rio_fill (rio);
+		return filled < 0 ? SOCKET_ERROR : (filled > 0);
+	}
+/* signals immediately when completions are already queued */
+	rio->fn.RIONotify (rio->rx_cq);
+	WSAEVENT events[ 2 ] = { rio->event, rio->notify_event };
+	const DWORD status = WSAWaitForMultipleEvents (PGM_N_ELEMENTS(events), events, FALSE, ms, FALSE);
+	if (WSA_WAIT_TIMEOUT == status)
+		return 0;
+	if (WSA_WAIT_FAILED == status)
+		return SOCKET_ERROR;
+	if (WSA_WAIT_EVENT_0 + 1 == status)
+		WSAResetEvent (rio->notify_event);
+	return 1;
+}
+#endif /* PGM_HAVE_RIO */
+
+/* eof */
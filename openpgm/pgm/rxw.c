@@ -25,6 +25,9 @@
 #include <impl/i18n.h>
 #include <impl/framework.h>
 #include <impl/rxw.h>
+#include <impl/decode.h>
+#include <impl/flightrec.h>
+#include <impl/xdp_filter.h>
 
 
 //#define RXW_DEBUG
@@ -71,16 +74,41 @@ static int _pgm_rxw_append (pgm_rxw_t*const restrict, struct pgm_sk_buff_t*const
 static int _pgm_rxw_add_placeholder_range (pgm_rxw_t*const, const uint32_t, const pgm_time_t, const pgm_time_t);
 static void _pgm_rxw_unlink (pgm_rxw_t*const restrict, struct pgm_sk_buff_t*const restrict);
 static uint32_t _pgm_rxw_remove_trail (pgm_rxw_t*const);
+static uint32_t _pgm_rxw_spill (pgm_rxw_t*const, const uint32_t);
+static void _pgm_rxw_apply_max_length (pgm_rxw_t*const);
+static inline ssize_t _pgm_rxw_spill_read (pgm_rxw_t*const restrict, pgm_rxw_cursor_t*const restrict);
+static inline void _pgm_rxw_spill_free (pgm_queue_t*const);
+static void _pgm_rxw_reassemble (pgm_rxw_t*const restrict, const struct pgm_sk_buff_t*const restrict);
+static struct pgm_sk_buff_t* _pgm_rxw_reasm_take (pgm_rxw_t*const, const uint32_t);
+static void _pgm_rxw_reasm_free (pgm_rxw_t*const restrict, pgm_queue_t*const restrict);
+static void _pgm_rxw_reasm_purge (pgm_rxw_t*const);
+static void _pgm_rxw_decode_release (pgm_rxw_t*const);
 static void _pgm_rxw_state (pgm_rxw_t*const restrict, struct pgm_sk_buff_t*const restrict, const int);
-static inline void _pgm_rxw_shuffle_parity (pgm_rxw_t*const restrict, struct pgm_sk_buff_t*const restrict);
-static inline ssize_t _pgm_rxw_incoming_read (pgm_rxw_t*const restrict, struct pgm_msgv_t**restrict, uint32_t);
+static inline void _pgm_rxw_stamp_insert (struct pgm_sk_buff_t*const);
+static inline void _pgm_rxw_residency_add (pgm_rxw_t*const restrict, const struct pgm_sk_buff_t*const restrict, const pgm_time_t);
+static inline void _pgm_rxw_peak_update (pgm_rxw_t*const);
+static inline struct pgm_sk_buff_t* _pgm_rxw_shuffle_parity (pgm_rxw_t*const restrict, struct pgm_sk_buff_t*const restrict, pgm_rxw_gap_t*const restrict);
+static inline ssize_t _pgm_rxw_incoming_read (pgm_rxw_t*const restrict, pgm_rxw_cursor_t*const restrict);
+static ssize_t _pgm_rxw_read (pgm_rxw_t*const restrict, pgm_rxw_cursor_t*const restrict);
+static inline bool _pgm_rxw_find_missing (pgm_rxw_t*const, const uint32_t, const uint32_t, uint32_t*const);
+static bool _pgm_rxw_has_parity (pgm_rxw_t*const, const uint32_t, const uint32_t);
+static bool _pgm_rxw_try_reconstruct (pgm_rxw_t*const, const uint32_t);
 static bool _pgm_rxw_is_apdu_complete (pgm_rxw_t*const, const uint32_t);
-static inline ssize_t _pgm_rxw_incoming_read_apdu (pgm_rxw_t*const restrict, struct pgm_msgv_t**restrict);
+static inline ssize_t _pgm_rxw_incoming_read_apdu (pgm_rxw_t*const restrict, pgm_rxw_cursor_t*const restrict, const uint32_t);
+static struct pgm_sk_buff_t* _pgm_rxw_inflate (pgm_rxw_t*const restrict, const struct pgm_sk_buff_t*const restrict, struct pgm_sk_buff_t*const restrict);
+static ssize_t _pgm_rxw_incoming_read_unordered (pgm_rxw_t*const restrict, pgm_rxw_cursor_t*const restrict);
+static inline void _pgm_rxw_skip_committed (pgm_rxw_t*const);
+static inline ssize_t _pgm_rxw_incoming_read_records (pgm_rxw_t*const restrict, pgm_rxw_cursor_t*const restrict, size_t*restrict);
+static bool _pgm_rxw_is_coalesce_valid (const struct pgm_sk_buff_t*const);
 static inline int _pgm_rxw_recovery_update (pgm_rxw_t*const, const uint32_t, const pgm_time_t);
 static inline int _pgm_rxw_recovery_append (pgm_rxw_t*const, const pgm_time_t, const pgm_time_t);
+static int _pgm_rxw_add (pgm_rxw_t*const restrict, struct pgm_sk_buff_t*const restrict, const pgm_time_t, const pgm_time_t);
+static void _pgm_rxw_unreliable (pgm_rxw_t*const, const uint32_t, uint32_t);
+static const void* _pgm_rxw_opt (const struct pgm_sk_buff_t*const, const uint8_t);
 
 
-/* returns the pointer at the given index of the window.
+/* returns the pointer at the given index of the window, NULL for a missing
+ * sequence.
  */
 
 static
@@ -98,7 +126,7 @@ _pgm_rxw_peek (
 
 	if (pgm_uint32_gte (sequence, window->trail) && pgm_uint32_lte (sequence, window->lead))
 	{
-		const uint_fast32_t index_ = sequence % pgm_rxw_max_length (window);
+		const uint_fast32_t index_ = sequence & window->mask;
 		struct pgm_sk_buff_t* skb = window->pdata[index_];
 /* availability only guaranteed inside commit window */
 		if (pgm_uint32_lt (sequence, window->commit_lead)) {
@@ -165,6 +193,454 @@ _pgm_rxw_incoming_is_empty (
 	return (_pgm_rxw_incoming_length (window) == 0);
 }
 
+/* pointer slots to hold sqns sequences, rounded up to a power of two such
+ * that a sequence is indexed by mask.
+ */
+
+static inline
+unsigned
+_pgm_rxw_slots (
+	const unsigned		sqns
+	)
+{
+	return (unsigned)pgm_nearest_power (1, sqns);
+}
+
+/* move the pointer array to alloc_sqns slots, re-indexing every sequence in
+ * the window.
+ */
+
+static
+void
+_pgm_rxw_resize (
+	pgm_rxw_t* const	window,
+	const unsigned		alloc_sqns
+	)
+{
+	struct pgm_sk_buff_t** pdata;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert_cmpuint (alloc_sqns, >=, pgm_rxw_length (window));
+	pgm_assert_cmpuint (alloc_sqns, <=, _pgm_rxw_slots (window->max_alloc));
+	pgm_assert_cmpuint (alloc_sqns & (alloc_sqns - 1), ==, 0);
+
+	if (alloc_sqns == window->alloc)
+		return;
+
+	pdata = pgm_mem_slab_alloc0 (window->slab, alloc_sqns * sizeof(struct pgm_sk_buff_t*));
+	if (!pgm_rxw_is_empty (window))
+	{
+		for (uint32_t sequence = window->trail; pgm_uint32_lte (sequence, window->lead); sequence++)
+			pdata[ sequence & (alloc_sqns - 1) ] = window->pdata[ sequence & window->mask ];
+	}
+	pgm_mem_slab_free (window->slab, window->pdata, window->alloc * sizeof(struct pgm_sk_buff_t*));
+	window->pdata = pdata;
+	window->alloc = alloc_sqns;
+	window->mask = alloc_sqns - 1;
+}
+
+/* grow the pointer array geometrically to hold count more sequences.
+ */
+
+static inline
+void
+_pgm_rxw_reserve (
+	pgm_rxw_t* const	window,
+	const uint32_t		count
+	)
+{
+	const uint32_t length = pgm_rxw_length (window) + count;
+
+/* pre-conditions */
+	pgm_assert_cmpuint (length, <=, window->max_alloc);
+
+	if (PGM_LIKELY(length <= window->alloc))
+		return;
+
+	unsigned alloc_sqns = window->alloc;
+	while (alloc_sqns < length)
+		alloc_sqns *= 2;
+	_pgm_rxw_resize (window, alloc_sqns);
+}
+
+/* halve the pointer array while at most a quarter is in use, not below the
+ * minimum length.
+ */
+
+static inline
+void
+_pgm_rxw_shrink (
+	pgm_rxw_t* const	window
+	)
+{
+	const uint32_t length = pgm_rxw_length (window);
+	unsigned alloc_sqns = window->alloc;
+
+	while (alloc_sqns / 2 >= window->min_alloc && length <= alloc_sqns / 4)
+		alloc_sqns /= 2;
+	_pgm_rxw_resize (window, alloc_sqns);
+}
+
+/* missing sequences of the window have no skb, each is held by exactly one
+ * gap of the gap queue.  a gap is split when part of it changes state and
+ * freed once empty, such that a burst of loss costs one gap rather than one
+ * placeholder per sequence.
+ */
+
+static inline
+bool
+_pgm_rxw_is_in_window (
+	const pgm_rxw_t* const	window,
+	const uint32_t		sequence
+	)
+{
+	pgm_assert (NULL != window);
+	return !pgm_rxw_is_empty (window) &&
+	       pgm_uint32_gte (sequence, window->trail) &&
+	       pgm_uint32_lte (sequence, window->lead);
+}
+
+/* returns the gap holding a missing sequence of the window, walking the gap
+ * queue from the last gap found as repairs tend to arrive in order.
+ */
+
+static
+pgm_rxw_gap_t*
+_pgm_rxw_find_gap (
+	pgm_rxw_t* const	window,
+	const uint32_t		sequence
+	)
+{
+	pgm_list_t* link;
+	pgm_rxw_gap_t* gap;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (_pgm_rxw_is_in_window (window, sequence));
+	pgm_assert (!pgm_queue_is_empty (&window->gap_queue));
+
+	link = window->gap_hint ? &window->gap_hint->order_link : window->gap_queue.head;
+	gap = link->data;
+	if (pgm_uint32_lt (sequence, gap->sequence))
+	{
+		do {
+			link = link->next;		/* towards trail */
+			pgm_assert (NULL != link);
+			gap = link->data;
+		} while (pgm_uint32_lt (sequence, gap->sequence));
+	}
+	else
+	{
+		while (sequence - gap->sequence >= gap->len) {
+			link = link->prev;		/* towards lead */
+			pgm_assert (NULL != link);
+			gap = link->data;
+		}
+	}
+
+/* post-conditions */
+	pgm_assert_cmpuint (sequence - gap->sequence, <, gap->len);
+
+	window->gap_hint = gap;
+	return gap;
+}
+
+/* returns the state queue of a recovery state, NULL if not queued.
+ */
+
+static inline
+pgm_queue_t*
+_pgm_rxw_gap_queue (
+	pgm_rxw_t* const	window,
+	const int		pkt_state
+	)
+{
+	switch (pkt_state) {
+	case PGM_PKT_STATE_BACK_OFF:	return &window->nak_backoff_queue;
+	case PGM_PKT_STATE_WAIT_NCF:	return &window->wait_ncf_queue;
+	case PGM_PKT_STATE_WAIT_DATA:	return &window->wait_data_queue;
+	default: return NULL;
+	}
+}
+
+/* create a gap without state, the caller links it into the gap queue.  gaps
+ * are recycled most recent first from the chunks of the window.
+ */
+
+static
+pgm_rxw_gap_t*
+_pgm_rxw_gap_new (
+	pgm_rxw_t* const	window,
+	const uint32_t		sequence,
+	const uint32_t		len,
+	const pgm_time_t	tstamp
+	)
+{
+	pgm_rxw_gap_t* gap;
+
+	if (PGM_UNLIKELY(NULL == window->gap_free)) {
+		struct pgm_rxw_gaps_t* gaps = pgm_mem_slab_alloc0 (window->slab, sizeof(struct pgm_rxw_gaps_t));
+		gaps->next = window->gaps;
+		window->gaps = gaps;
+		for (unsigned i = PGM_RXW_GAPS_LEN; i > 0; i--) {
+			gaps->gap[ i - 1 ].link.next = window->gap_free;
+			window->gap_free = &gaps->gap[ i - 1 ].link;
+		}
+	}
+	gap = (pgm_rxw_gap_t*)window->gap_free;		/* link is first */
+	window->gap_free = window->gap_free->next;
+	memset (gap, 0, sizeof(pgm_rxw_gap_t));
+	gap->link.data		= gap;
+	gap->order_link.data	= gap;
+	gap->sequence		= sequence;
+	gap->len		= len;
+	gap->tstamp		= tstamp;
+	gap->state.pkt_state	= PGM_PKT_STATE_ERROR;
+	return gap;
+}
+
+/* remove current state from gap.
+ */
+
+static
+void
+_pgm_rxw_gap_unlink (
+	pgm_rxw_t*     const restrict window,
+	pgm_rxw_gap_t* const restrict gap
+	)
+{
+	pgm_queue_t* queue;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != gap);
+
+	switch (gap->state.pkt_state) {
+	case PGM_PKT_STATE_BACK_OFF:
+	case PGM_PKT_STATE_WAIT_NCF:
+	case PGM_PKT_STATE_WAIT_DATA:
+		queue = _pgm_rxw_gap_queue (window, gap->state.pkt_state);
+		pgm_assert (!pgm_queue_is_empty (queue));
+		pgm_queue_unlink (queue, &gap->link);
+		pgm_assert_cmpuint (window->missing_count, >=, gap->len);
+		window->missing_count -= gap->len;
+		break;
+
+	case PGM_PKT_STATE_LOST_DATA:
+		pgm_assert_cmpuint (window->lost_count, >=, gap->len);
+		window->lost_count -= gap->len;
+		break;
+
+	case PGM_PKT_STATE_ERROR:
+		break;
+
+	default: pgm_assert_not_reached(); break;
+	}
+
+	gap->state.pkt_state = PGM_PKT_STATE_ERROR;
+}
+
+/* set gap to new FSM state, every sequence of the gap follows.
+ */
+
+static
+void
+_pgm_rxw_gap_state (
+	pgm_rxw_t*     const restrict window,
+	pgm_rxw_gap_t* const restrict gap,
+	const int		      new_pkt_state
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != gap);
+	pgm_assert_cmpuint (gap->len, >, 0);
+
+	_pgm_rxw_gap_unlink (window, gap);
+
+	switch (new_pkt_state) {
+	case PGM_PKT_STATE_BACK_OFF:
+	case PGM_PKT_STATE_WAIT_NCF:
+	case PGM_PKT_STATE_WAIT_DATA:
+		pgm_queue_push_head_link (_pgm_rxw_gap_queue (window, new_pkt_state), &gap->link);
+		window->missing_count += gap->len;
+		pgm_assert_cmpuint (window->missing_count, <=, pgm_rxw_length (window));
+		break;
+
+	case PGM_PKT_STATE_LOST_DATA:
+		window->lost_count += gap->len;
+		window->cumulative_losses += gap->len;
+		window->has_event = 1;
+		pgm_assert_cmpuint (window->lost_count, <=, pgm_rxw_length (window));
+		break;
+
+	default: pgm_assert_not_reached(); break;
+	}
+
+	gap->state.pkt_state = new_pkt_state;
+	pgm_flightrec_add (window->flightrec, PGM_FLIGHTREC_GAP_STATE, new_pkt_state, window->tsi->sport, gap->sequence, gap->len);
+}
+
+/* release an empty or departing gap.
+ */
+
+static
+void
+_pgm_rxw_gap_free (
+	pgm_rxw_t*     const restrict window,
+	pgm_rxw_gap_t* const restrict gap
+	)
+{
+	_pgm_rxw_gap_unlink (window, gap);
+	pgm_queue_unlink (&window->gap_queue, &gap->order_link);
+	if (window->gap_hint == gap)
+		window->gap_hint = NULL;
+	gap->link.next = window->gap_free;
+	window->gap_free = &gap->link;
+}
+
+/* split a gap at sequence, the new upper gap inherits the recovery state and
+ * takes the adjacent position in the state queue.
+ *
+ * returns the gap starting at sequence.
+ */
+
+static
+pgm_rxw_gap_t*
+_pgm_rxw_gap_split (
+	pgm_rxw_t*     const restrict window,
+	pgm_rxw_gap_t* const restrict gap,
+	const uint32_t		      sequence
+	)
+{
+	pgm_rxw_gap_t* upper;
+	pgm_queue_t* queue;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != gap);
+	pgm_assert (pgm_uint32_gt (sequence, gap->sequence));
+	pgm_assert_cmpuint (sequence - gap->sequence, <, gap->len);
+
+	const uint32_t len = sequence - gap->sequence;
+	upper = _pgm_rxw_gap_new (window, sequence, gap->len - len, gap->tstamp);
+	upper->nak_tstamp = gap->nak_tstamp;
+	upper->nak_sent_tstamp = gap->nak_sent_tstamp;
+	upper->state = gap->state;
+	gap->len = len;
+
+	pgm_queue_insert_before_link (&window->gap_queue, &gap->order_link, &upper->order_link);
+	queue = _pgm_rxw_gap_queue (window, gap->state.pkt_state);
+	if (NULL != queue)
+		pgm_queue_insert_before_link (queue, &gap->link, &upper->link);
+	return upper;
+}
+
+/* drop count sequences from the leading or trailing end of a gap.
+ */
+
+static
+void
+_pgm_rxw_gap_trim (
+	pgm_rxw_t*     const restrict window,
+	pgm_rxw_gap_t* const restrict gap,
+	const uint32_t		      count,
+	const bool		      is_front
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != gap);
+	pgm_assert_cmpuint (count, <=, gap->len);
+
+	if (count == gap->len) {
+		_pgm_rxw_gap_free (window, gap);
+		return;
+	}
+
+	switch (gap->state.pkt_state) {
+	case PGM_PKT_STATE_BACK_OFF:
+	case PGM_PKT_STATE_WAIT_NCF:
+	case PGM_PKT_STATE_WAIT_DATA:
+		window->missing_count -= count;
+		break;
+
+	case PGM_PKT_STATE_LOST_DATA:
+		window->lost_count -= count;
+		break;
+
+	default: break;
+	}
+
+	if (is_front)
+		gap->sequence += count;
+	gap->len -= count;
+}
+
+/* isolate one sequence of a gap.
+ *
+ * returns gap of length one holding sequence.
+ */
+
+static
+pgm_rxw_gap_t*
+_pgm_rxw_gap_isolate (
+	pgm_rxw_t*     const restrict window,
+	pgm_rxw_gap_t*	     restrict gap,
+	const uint32_t		      sequence
+	)
+{
+	if (sequence != gap->sequence)
+		gap = _pgm_rxw_gap_split (window, gap, sequence);
+	if (gap->len > 1)
+		(void)_pgm_rxw_gap_split (window, gap, sequence + 1);
+	return gap;
+}
+
+/* remove one sequence from its gap on arrival of data or parity, copying
+ * the recovery details of the sequence to hole.
+ */
+
+static
+void
+_pgm_rxw_gap_fill (
+	pgm_rxw_t*     const restrict window,
+	pgm_rxw_gap_t*	     restrict gap,
+	const uint32_t		      sequence,
+	pgm_rxw_gap_t* const restrict hole
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != gap);
+	pgm_assert (NULL != hole);
+
+	*hole = *gap;
+	if (sequence == gap->sequence)
+		_pgm_rxw_gap_trim (window, gap, 1, TRUE);
+	else if (sequence == gap->sequence + gap->len - 1)
+		_pgm_rxw_gap_trim (window, gap, 1, FALSE);
+	else
+		_pgm_rxw_gap_free (window, _pgm_rxw_gap_isolate (window, gap, sequence));
+}
+
+/* returns the FSM state of a sequence inside the window.
+ */
+
+static inline
+int
+_pgm_rxw_pkt_state (
+	pgm_rxw_t* const	window,
+	const uint32_t		sequence
+	)
+{
+	const struct pgm_sk_buff_t* skb = _pgm_rxw_peek (window, sequence);
+	if (NULL != skb)
+		return ((const pgm_rxw_state_t*)&skb->cb)->pkt_state;
+	return _pgm_rxw_find_gap (window, sequence)->state.pkt_state;
+}
+
 /* constructor for receive window.  zero-length windows are not permitted.
  *
  * returns pointer to window.
@@ -180,6 +656,25 @@ pgm_rxw_create (
 	const ssize_t		max_rte,	/* max bandwidth */
 	const uint32_t		ack_c_p
 	)
+{
+	return pgm_rxw_create_from (NULL, tsi, tpdu_size, sqns, secs, max_rte, ack_c_p);
+}
+
+/* constructor of a window whose structure, pointer array and chunks are
+ * blocks of slab, returned to the slab on destruction.
+ */
+
+PGM_GNUC_INTERNAL
+pgm_rxw_t*
+pgm_rxw_create_from (
+	pgm_mem_slab_t*const	slab,		/* optional */
+	const pgm_tsi_t*const	tsi,
+	const uint16_t		tpdu_size,
+	const unsigned		sqns,
+	const unsigned		secs,
+	const ssize_t		max_rte,
+	const uint32_t		ack_c_p
+	)
 {
 	pgm_rxw_t* window;
 
@@ -202,8 +697,9 @@ pgm_rxw_create (
 /* calculate receive window parameters */
 	pgm_assert (sqns || (secs && max_rte));
 	const unsigned alloc_sqns = sqns ? sqns : (unsigned)( (secs * max_rte) / tpdu_size );
-	window = pgm_malloc0 (sizeof(pgm_rxw_t) + ( alloc_sqns * sizeof(struct pgm_sk_buff_t*) ));
+	window = pgm_mem_slab_alloc0 (slab, sizeof(pgm_rxw_t));
 
+	window->slab		= slab;
 	window->tsi		= tsi;
 	window->max_tpdu	= tpdu_size;
 
@@ -226,7 +722,10 @@ pgm_rxw_create (
 	window->bitmap = 0xffffffff;
 
 /* pointer array */
-	window->alloc = alloc_sqns;
+	window->alloc = _pgm_rxw_slots (alloc_sqns);
+	window->mask = window->alloc - 1;
+	window->pdata = pgm_mem_slab_alloc0 (slab, window->alloc * sizeof(struct pgm_sk_buff_t*));
+	window->min_alloc = window->max_alloc = alloc_sqns;
 
 /* post-conditions */
 	pgm_assert_cmpuint (pgm_rxw_max_length (window), ==, alloc_sqns);
@@ -238,49 +737,178 @@ pgm_rxw_create (
 	return window;
 }
 
-/* destructor for receive window.  must not be called more than once for same window.
+/* destructor for receive window.  must not be called more than once for same window.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_rxw_destroy (
+	pgm_rxw_t* const	window
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert_cmpuint (window->alloc, >, 0);
+
+	pgm_debug ("destroy (window:%p)", (const void*)window);
+
+/* transmission groups on decoder threads reference packets of the window */
+	_pgm_rxw_decode_release (window);
+
+/* contents of window */
+	while (!pgm_rxw_is_empty (window)) {
+		_pgm_rxw_remove_trail (window);
+	}
+
+/* window must now be empty */
+	pgm_assert_cmpuint (pgm_rxw_length (window), ==, 0);
+	pgm_assert_cmpuint (pgm_rxw_size (window), ==, 0);
+	pgm_assert (pgm_rxw_is_empty (window));
+	pgm_assert (!pgm_rxw_is_full (window));
+
+/* spilled APDUs, read or not */
+	_pgm_rxw_spill_free (&window->spill_queue);
+	_pgm_rxw_spill_free (&window->spill_commit_queue);
+
+/* reassembled APDUs, complete or not */
+	_pgm_rxw_reasm_free (window, &window->reasm_queue);
+	_pgm_rxw_reasm_free (window, &window->reasm_commit_queue);
+
+/* record chunks of coalesced TPDUs */
+	while (window->records) {
+		struct pgm_rxw_records_t* next = window->records->next;
+		pgm_mem_slab_free (window->slab, window->records, sizeof(struct pgm_rxw_records_t));
+		window->records = next;
+	}
+
+/* gap chunks, every gap idle with the window empty */
+	while (window->gaps) {
+		struct pgm_rxw_gaps_t* next = window->gaps->next;
+		pgm_mem_slab_free (window->slab, window->gaps, sizeof(struct pgm_rxw_gaps_t));
+		window->gaps = next;
+	}
+
+/* window */
+	pgm_mem_slab_t* slab = window->slab;
+	pgm_mem_slab_free (slab, window->pdata, window->alloc * sizeof(struct pgm_sk_buff_t*));
+	pgm_mem_slab_free (slab, window, sizeof(pgm_rxw_t));
+}
+
+/* start an empty window with min_sqns pointer slots, growing on demand up to
+ * the configured window size.  with can_shrink the slots are released again
+ * as the occupied span falls.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_rxw_set_min_length (
+	pgm_rxw_t* const	window,
+	const unsigned		min_sqns,
+	const bool		can_shrink
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (pgm_rxw_is_empty (window));
+	pgm_assert_cmpuint (min_sqns, >, 0);
+
+	pgm_debug ("set_min_length (window:%p min-sqns:%u can-shrink:%s)",
+		(const void*)window, min_sqns, can_shrink ? "TRUE" : "FALSE");
+
+	window->min_alloc  = MIN(min_sqns, window->max_alloc);
+	window->can_shrink = can_shrink;
+	_pgm_rxw_resize (window, _pgm_rxw_slots (window->min_alloc));
+}
+
+/* touch the pointer array and stock one chunk of gaps ahead of the first
+ * loss, returns bytes made resident.
+ */
+
+PGM_GNUC_INTERNAL
+size_t
+pgm_rxw_prewarm (
+	pgm_rxw_t* const	window
+	)
+{
+	size_t bytes;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+
+	bytes = pgm_mem_prefault (window->pdata, window->alloc * sizeof(struct pgm_sk_buff_t*));
+	if (NULL == window->gap_free) {
+		struct pgm_rxw_gaps_t* gaps = pgm_mem_slab_alloc0 (window->slab, sizeof(struct pgm_rxw_gaps_t));
+		gaps->next = window->gaps;
+		window->gaps = gaps;
+		for (unsigned i = PGM_RXW_GAPS_LEN; i > 0; i--) {
+			gaps->gap[ i - 1 ].link.next = window->gap_free;
+			window->gap_free = &gaps->gap[ i - 1 ].link;
+		}
+		bytes += pgm_mem_prefault (gaps, sizeof(struct pgm_rxw_gaps_t));
+	}
+	return bytes;
+}
+
+/* resize the window limit of a live window.  growing takes effect immediately
+ * with the pointer array following on demand, shrinking below the occupied
+ * span is deferred until the trail has advanced, such that no sequence is
+ * dropped to resize.
  */
 
 PGM_GNUC_INTERNAL
 void
-pgm_rxw_destroy (
-	pgm_rxw_t* const	window
+pgm_rxw_set_max_length (
+	pgm_rxw_t* const	window,
+	const unsigned		max_sqns
 	)
 {
 /* pre-conditions */
 	pgm_assert (NULL != window);
-	pgm_assert_cmpuint (window->alloc, >, 0);
+	pgm_assert_cmpuint (max_sqns, >, 0);
+	pgm_assert_cmpuint (max_sqns & PGM_UINT32_SIGN_BIT, ==, 0);
 
-	pgm_debug ("destroy (window:%p)", (const void*)window);
+	pgm_debug ("set_max_length (window:%p max-sqns:%u)", (const void*)window, max_sqns);
 
-/* contents of window */
-	while (!pgm_rxw_is_empty (window)) {
-		_pgm_rxw_remove_trail (window);
-	}
+	window->resize_alloc = max_sqns;
+	_pgm_rxw_apply_max_length (window);
+}
 
-/* window must now be empty */
-	pgm_assert_cmpuint (pgm_rxw_length (window), ==, 0);
-	pgm_assert_cmpuint (pgm_rxw_size (window), ==, 0);
-	pgm_assert (pgm_rxw_is_empty (window));
-	pgm_assert (!pgm_rxw_is_full (window));
+/* move the window limit toward a pending resize, not below the occupied span.
+ */
 
-/* window */
-	pgm_free (window);
+static
+void
+_pgm_rxw_apply_max_length (
+	pgm_rxw_t* const	window
+	)
+{
+	const unsigned max_sqns = MAX(window->resize_alloc, pgm_rxw_length (window));
+
+	if (max_sqns == window->max_alloc)
+		return;
+	window->max_alloc = max_sqns;
+	window->min_alloc = MIN(window->min_alloc, max_sqns);
+	if (window->alloc > _pgm_rxw_slots (max_sqns))
+		_pgm_rxw_resize (window, _pgm_rxw_slots (max_sqns));
+	if (max_sqns == window->resize_alloc)
+		window->resize_alloc = 0;
 }
 
-/* add skb to receive window.  window has fixed size and will not grow.
+/* add skb to receive window.  window has fixed maximum size, the pointer
+ * array grows towards it as the span of sequences increases.
  * PGM skbuff data/tail pointers must point to the PGM payload, and hence skb->len
  * is allowed to be zero.
  *
- * if the skb sequence number indicates lost packets placeholders will be defined
- * for each missing entry in the window.
+ * if the skb sequence number indicates lost packets a gap will be defined
+ * holding the missing entries of the window.
  *
  * side effects:
  *
  * 1) sequence number is set in skb from PGM header value.
  * 2) window may be updated with new skb.
- * 3) placeholders may be created for detected lost packets.
+ * 3) a gap may be created for detected lost packets.
  * 4) parity skbs may be shuffled to accomodate original data.
+ * 5) gaps of sequences marked by OPT_UNRELIABLE are lost immediately.
  *
  * returns:
  * PGM_RXW_INSERTED - packet filled a waiting placeholder, skb consumed.
@@ -301,6 +929,63 @@ pgm_rxw_add (
 	const pgm_time_t		     now,
 	const pgm_time_t		     nak_rb_expiry	/* calculated expiry time for this skb */
 	)
+{
+	const struct pgm_opt_unreliable* opt_unreliable;
+	int status;
+
+/* pre-conditions */
+	pgm_assert (NULL != skb);
+
+/* read ahead as the window takes ownership of skb */
+	if (PGM_LIKELY(!skb->unreliable) ||
+	    NULL == (opt_unreliable = _pgm_rxw_opt (skb, PGM_OPT_UNRELIABLE)))
+	{
+		status = _pgm_rxw_add (window, skb, now, nak_rb_expiry);
+	}
+	else
+	{
+		const uint32_t sequence = pgm_ntohl (skb->pgm_data->data_sqn);
+		const uint32_t bitmap = pgm_ntohl (opt_unreliable->opt_bitmap);
+		status = _pgm_rxw_add (window, skb, now, nak_rb_expiry);
+		if (PGM_RXW_MALFORMED != status && PGM_RXW_BOUNDS != status)
+			_pgm_rxw_unreliable (window, sequence, bitmap);
+	}
+	_pgm_rxw_peak_update (window);
+	return status;
+}
+
+/* declare preceding sequences of the bitmap lost without repair, each bit
+ * naming sequence - 1 - i and applying only to gaps of the incoming window.
+ */
+
+static
+void
+_pgm_rxw_unreliable (
+	pgm_rxw_t* const	window,
+	const uint32_t		sequence,
+	uint32_t		bitmap
+	)
+{
+	for (uint32_t sqn = sequence - 1; bitmap; bitmap >>= 1, sqn--)
+	{
+		if (!(bitmap & 1) ||
+		    !_pgm_rxw_is_in_window (window, sqn) ||
+		    pgm_uint32_lt (sqn, window->commit_lead) ||
+		    NULL != _pgm_rxw_peek (window, sqn))
+			continue;
+		pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Unreliable sequence #%" PRIu32 " lost without repair."), sqn);
+		pgm_rxw_lost (window, sqn);
+	}
+}
+
+static
+int
+_pgm_rxw_add (
+	pgm_rxw_t*	      const restrict window,
+	struct pgm_sk_buff_t* const restrict skb,
+	const pgm_time_t		     now,
+	const pgm_time_t		     nak_rb_expiry
+	)
 {
 	pgm_rxw_state_t* const state = (pgm_rxw_state_t*)&skb->cb;
 	int status;
@@ -321,6 +1006,14 @@ pgm_rxw_add (
 	pgm_debug ("add (window:%p skb:%p nak_rb_expiry:%" PGM_TIME_FORMAT ")",
 		(const void*)window, (const void*)skb, nak_rb_expiry);
 
+/* transmission groups completed by decoder threads */
+	if (!pgm_queue_is_empty (&window->decode_queue))
+		pgm_rxw_decode_collect (window);
+
+/* tsdu size, trail and fragment header of pre-parsed ODATA are verified by the parser */
+	if (skb->preparsed)
+		goto verified;
+
 	skb->sequence = pgm_ntohl (skb->pgm_data->data_sqn);
 
 /* protocol sanity check: tsdu size */
@@ -354,6 +1047,46 @@ pgm_rxw_add (
 			return PGM_RXW_MALFORMED;
 	}
 
+/* protocol sanity check: compressed APDUs are neither parity nor coalesced */
+	if (skb->compressed)
+	{
+		if (PGM_UNLIKELY(skb->pgm_header->pgm_options & PGM_OPT_PARITY ||
+				 skb->coalesced))
+			return PGM_RXW_MALFORMED;
+	}
+
+/* protocol sanity check: coalesced APDUs are whole and exactly fill the original data */
+	if (skb->coalesced)
+	{
+		if (PGM_UNLIKELY(skb->pgm_header->pgm_options & PGM_OPT_PARITY ||
+				 skb->pgm_opt_fragment ||
+				 !_pgm_rxw_is_coalesce_valid (skb)))
+			return PGM_RXW_MALFORMED;
+	}
+
+/* protocol sanity check: parity requires FEC parameters, packet number within parity range */
+	if (skb->pgm_header->pgm_options & PGM_OPT_PARITY)
+	{
+		if (PGM_UNLIKELY(!window->is_fec_available ||
+				 _pgm_rxw_pkt_sqn (window, skb->sequence) >= (uint32_t)(window->rs.n - window->rs.k)))
+			return PGM_RXW_MALFORMED;
+
+/* protocol sanity check: partial group of variable length packets within the group size */
+		const struct pgm_opt_curr_tgsize* opt_curr_tgsize = (skb->pgm_header->pgm_options & PGM_OPT_PRESENT) ?
+								    _pgm_rxw_opt (skb, PGM_OPT_CURR_TGSIZE) : NULL;
+		state->tg_size = 0;
+		if (NULL != opt_curr_tgsize)
+		{
+			const uint32_t tg_size = pgm_ntohl (opt_curr_tgsize->prm_atgsize);
+			if (PGM_UNLIKELY(0 == tg_size || tg_size > window->tg_size ||
+					 !(skb->pgm_header->pgm_options & PGM_OPT_VAR_PKTLEN)))
+				return PGM_RXW_MALFORMED;
+			if (tg_size < window->tg_size)
+				state->tg_size = (uint8_t)tg_size;
+		}
+	}
+
+verified:
 /* first packet of a session defines the window */
 	if (PGM_UNLIKELY(!window->is_defined))
 		_pgm_rxw_define (window, skb->sequence - 1);	/* previous_lead needed for append to occur */
@@ -366,24 +1099,51 @@ pgm_rxw_add (
 		if (pgm_uint32_lt (_pgm_rxw_tg_sqn (window, skb->sequence), _pgm_rxw_tg_sqn (window, window->commit_lead)))
 			return PGM_RXW_DUPLICATE;
 
+/* same parity packet, i.e. proactive and on-demand, must not be used twice */
+		if (_pgm_rxw_has_parity (window, _pgm_rxw_tg_sqn (window, skb->sequence), skb->sequence))
+			return PGM_RXW_DUPLICATE;
+
+/* parity of a partial group announces its original packets, losses ahead of a
+ * source pause are detected and only their gaps are filled.
+ */
+		if (0 != state->tg_size)
+		{
+			const uint32_t last_sqn = _pgm_rxw_tg_sqn (window, skb->sequence) + state->tg_size - 1;
+			if (pgm_uint32_gt (last_sqn, window->lead)) {
+				status = _pgm_rxw_add_placeholder_range (window, last_sqn + 1, now, nak_rb_expiry);
+				if (PGM_RXW_APPENDED != status)
+					return status;
+			}
+			uint32_t missing;
+			if (!_pgm_rxw_find_missing (window, _pgm_rxw_tg_sqn (window, skb->sequence), state->tg_size, &missing))
+				return PGM_RXW_DUPLICATE;
+			window->has_event = 1;
+			return _pgm_rxw_insert (window, skb);
+		}
+
 		if (pgm_uint32_lt (_pgm_rxw_tg_sqn (window, skb->sequence), _pgm_rxw_tg_sqn (window, window->lead))) {
 			window->has_event = 1;
 			return _pgm_rxw_insert (window, skb);
 		}
 
 		const struct pgm_sk_buff_t* const first_skb = _pgm_rxw_peek (window, _pgm_rxw_tg_sqn (window, skb->sequence));
-		const pgm_rxw_state_t* const first_state = (pgm_rxw_state_t*)&first_skb->cb;
+		const pgm_rxw_state_t* const first_state = first_skb ? (pgm_rxw_state_t*)&first_skb->cb : NULL;
 
 		if (_pgm_rxw_tg_sqn (window, skb->sequence) == _pgm_rxw_tg_sqn (window, window->lead)) {
 			window->has_event = 1;
-			if (NULL == first_state || first_state->is_contiguous) {
-				state->is_contiguous = 1;
-				return _pgm_rxw_append (window, skb, now);
-			} else
+/* transmission group complete in window */
+			if (_pgm_rxw_is_last_of_tg_sqn (window, window->lead))
 				return _pgm_rxw_insert (window, skb);
+/* fill a gap, otherwise stand in for the next packet of the group */
+			uint32_t missing;
+			if (_pgm_rxw_find_missing (window, _pgm_rxw_tg_sqn (window, skb->sequence), window->tg_size, &missing))
+				return _pgm_rxw_insert (window, skb);
+			if (NULL == first_state ? !_pgm_rxw_is_in_window (window, _pgm_rxw_tg_sqn (window, skb->sequence))
+						: first_state->is_contiguous)
+				state->is_contiguous = 1;
+			return _pgm_rxw_append (window, skb, now);
 		}
 
-		pgm_assert (NULL != first_state);
 		status = _pgm_rxw_add_placeholder_range (window, _pgm_rxw_tg_sqn (window, skb->sequence), now, nak_rb_expiry);
 	}
 	else
@@ -397,6 +1157,12 @@ pgm_rxw_add (
 
 		if (pgm_uint32_lte (skb->sequence, window->lead)) {
 			window->has_event = 1;
+/* repair may complete an APDU passed over by unordered delivery */
+			if (window->is_unordered) {
+				const uint32_t first_sqn = skb->pgm_opt_fragment ? pgm_ntohl (skb->of_apdu_first_sqn) : skb->sequence;
+				if (pgm_uint32_lt (first_sqn, window->unordered_lead))
+					window->unordered_lead = first_sqn;
+			}
 			return _pgm_rxw_insert (window, skb);
 		}
 
@@ -412,8 +1178,12 @@ pgm_rxw_add (
 
 	if (PGM_RXW_APPENDED == status) {
 		status = _pgm_rxw_append (window, skb, now);
-		if (PGM_RXW_APPENDED == status)
+		if (PGM_RXW_APPENDED == status) {
+/* readable ahead of the gap */
+			if (window->is_unordered)
+				window->has_event = 1;
 			status = PGM_RXW_MISSING;
+		}
 	}
 	return status;
 }
@@ -442,6 +1212,7 @@ _pgm_rxw_define (
 
 	window->lead = lead;
 	window->commit_lead = window->rxw_trail = window->rxw_trail_init = window->trail = window->lead + 1;
+	window->unordered_lead = window->commit_lead;
 	window->is_constrained = window->is_defined = TRUE;
 
 /* post-conditions */
@@ -454,7 +1225,7 @@ _pgm_rxw_define (
 
 /* update window with latest transmitted parameters.
  *
- * returns count of placeholders added into window, used to start sending naks.
+ * returns count of lost sequences added into window, used to start sending naks.
  */
 
 PGM_GNUC_INTERNAL
@@ -483,6 +1254,29 @@ pgm_rxw_update (
 	return _pgm_rxw_update_lead (window, txw_lead, now, nak_rb_expiry);
 }
 
+/* define an empty window to start at first_sqn ahead of the first update,
+ * such that a late joining receiver recovers the sequences up to the
+ * advertised lead.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_rxw_join (
+	pgm_rxw_t* const	window,
+	const uint32_t		first_sqn
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+
+	pgm_debug ("pgm_rxw_join (window:%p first-sqn:%" PRIu32 ")",
+		(void*)window, first_sqn);
+
+	if (window->is_defined)
+		return;
+	_pgm_rxw_define (window, first_sqn - 1);
+}
+
 /* update trailing edge of receive window
  */
 
@@ -549,31 +1343,26 @@ _pgm_rxw_update_trail (
 		return;
 	}
 
-/* remove all buffers between commit lead and advertised rxw_trail */
+/* mark lost all gaps between commit lead and advertised rxw_trail */
 	for (uint32_t sequence = window->commit_lead;
 	     pgm_uint32_gt (window->rxw_trail, sequence) && pgm_uint32_gte (window->lead, sequence);
 	     sequence++)
 	{
-		struct pgm_sk_buff_t* skb;
-		pgm_rxw_state_t* state;
-
-		skb = _pgm_rxw_peek (window, sequence);
-		pgm_assert (NULL != skb);
-		state = (pgm_rxw_state_t*)&skb->cb;
-
-		switch (state->pkt_state) {
-		case PGM_PKT_STATE_HAVE_DATA:
-		case PGM_PKT_STATE_HAVE_PARITY:
-		case PGM_PKT_STATE_LOST_DATA:
-			break;
+		pgm_rxw_gap_t* gap;
 
-		case PGM_PKT_STATE_ERROR:
-			pgm_assert_not_reached();
+		if (NULL != _pgm_rxw_peek (window, sequence))
+			continue;
 
-		default:
-			pgm_rxw_lost (window, sequence);
-			break;
+		gap = _pgm_rxw_find_gap (window, sequence);
+		if (PGM_PKT_STATE_LOST_DATA != gap->state.pkt_state)
+		{
+			if (sequence != gap->sequence)
+				gap = _pgm_rxw_gap_split (window, gap, sequence);
+			if (pgm_uint32_gt (gap->sequence + gap->len, window->rxw_trail))
+				(void)_pgm_rxw_gap_split (window, gap, window->rxw_trail);
+			_pgm_rxw_gap_state (window, gap, PGM_PKT_STATE_LOST_DATA);
 		}
+		sequence = gap->sequence + gap->len - 1;
 	}
 
 /* post-conditions: only after flush */
@@ -607,57 +1396,114 @@ pgm_rxw_update_fec (
 	window->tg_size = window->rs.k;
 }
 
-/* add one placeholder to leading edge due to detected lost packet.
+/* remove up to count sequences from the trailing edge of a window with an
+ * empty commit window, a gap at the trail leaves in one step.
+ */
+
+static
+void
+_pgm_rxw_remove_trail_range (
+	pgm_rxw_t* const	window,
+	uint32_t		count
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (_pgm_rxw_commit_is_empty (window));
+	pgm_assert_cmpuint (count, <=, pgm_rxw_length (window));
+
+	while (count > 0)
+	{
+		if (NULL != _pgm_rxw_peek (window, window->trail)) {
+			const uint32_t spilled = _pgm_rxw_spill (window, count);
+			if (spilled > 0) {
+				count -= MIN(count, spilled);
+				continue;
+			}
+			_pgm_rxw_remove_trail (window);
+			count--;
+			continue;
+		}
+
+		pgm_rxw_gap_t* gap = window->gap_queue.tail->data;
+		pgm_assert (window->trail == gap->sequence);
+		const uint32_t n = MIN(count, gap->len);
+		_pgm_rxw_gap_trim (window, gap, n, TRUE);
+/* data-loss */
+		window->commit_lead = window->trail += n;
+		window->cumulative_losses += n;
+		count -= n;
+		pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Data loss due to pulled trailing edge, fragment count %" PRIu32 "."),window->fragment_count);
+	}
+}
+
+/* advance the leading edge over count lost packets as one gap in BACK-OFF
+ * state, pulling the trailing edge while the window is full.  sequences
+ * beyond the capacity of the window are lost without entering it.
  */
 
 static
 void
-_pgm_rxw_add_placeholder (
+_pgm_rxw_add_gap (
 	pgm_rxw_t* const	window,
+	const uint32_t		count,
 	const pgm_time_t	now,
 	const pgm_time_t	nak_rb_expiry
 	)
 {
-	struct pgm_sk_buff_t* skb;
-	pgm_rxw_state_t* state;
+	pgm_rxw_gap_t* gap;
+	uint32_t len = count;
 
 /* pre-conditions */
 	pgm_assert (NULL != window);
-	pgm_assert (!pgm_rxw_is_full (window));
 
-/* advance lead */
-	window->lead++;
+	if (0 == count)
+		return;
 
 /* add loss to bitmap */
-	window->bitmap <<= 1;
+	if (count >= 32)	window->bitmap = 0;
+	else			window->bitmap <<= count;
 
-/* update the Exponential Moving Average (EMA) data loss with loss:
- *     s_t = α × x_{t-1} + (1 - α) × s_{t-1}
- * x_{t-1} = 1
- *   ∴ s_t = α + (1 - α) × s_{t-1}
+/* update the Exponential Moving Average (EMA) data loss with count losses:
+ *     s_t = α + (1 - α) × s_{t-1}
+ *   ∴ 1 - s_t = (1 - α) × (1 - s_{t-1})
+ *   ∴ s_{t+k-1} = 1 - (1 - α)^^k × (1 - s_{t-1})
  */
-	window->data_loss = window->ack_c_p + pgm_fp16mul ((pgm_fp16 (1) - window->ack_c_p), window->data_loss);
+	window->data_loss = pgm_fp16 (1) - pgm_fp16mul (pgm_fp16pow (pgm_fp16 (1) - window->ack_c_p, count),
+							pgm_fp16 (1) - window->data_loss);
 
-	skb			= pgm_alloc_skb (window->max_tpdu);
-	state			= (pgm_rxw_state_t*)&skb->cb;
-	skb->tstamp		= now;
-	skb->sequence		= window->lead;
-	state->timer_expiry	= nak_rb_expiry;
+/* slow consumer or fast producer */
+	if (pgm_rxw_length (window) + count > pgm_rxw_max_length (window))
+	{
+		pgm_assert (_pgm_rxw_commit_is_empty (window));
+		pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Receive window full on placeholder sequence."));
+		_pgm_rxw_remove_trail_range (window, MIN(pgm_rxw_length (window),
+							 pgm_rxw_length (window) + count - pgm_rxw_max_length (window)));
+		if (count > pgm_rxw_max_length (window)) {
+			const uint32_t skip = count - pgm_rxw_max_length (window);
+			window->lead += skip;
+			window->commit_lead = window->trail = window->lead + 1;
+			window->cumulative_losses += skip;
+			len = pgm_rxw_max_length (window);
+		}
+	}
 
-	if (!_pgm_rxw_is_first_of_tg_sqn (window, skb->sequence))
+	_pgm_rxw_reserve (window, len);
+	gap = _pgm_rxw_gap_new (window, pgm_rxw_next_lead (window), len, now);
+	gap->state.timer_expiry = nak_rb_expiry;
+	pgm_queue_push_head_link (&window->gap_queue, &gap->order_link);
+	window->lead += len;
+
+	if (!_pgm_rxw_is_first_of_tg_sqn (window, gap->sequence))
 	{
-		struct pgm_sk_buff_t* first_skb = _pgm_rxw_peek (window, _pgm_rxw_tg_sqn (window, skb->sequence));
+		struct pgm_sk_buff_t* first_skb = _pgm_rxw_peek (window, _pgm_rxw_tg_sqn (window, gap->sequence));
 		if (first_skb) {
 			pgm_rxw_state_t* first_state = (pgm_rxw_state_t*)&first_skb->cb;
 			first_state->is_contiguous = 0;
 		}
 	}
 
-/* add skb to window */
-	const uint_fast32_t index_	= skb->sequence % pgm_rxw_max_length (window);
-	window->pdata[index_]		= skb;
-
-	pgm_rxw_state (window, skb, PGM_PKT_STATE_BACK_OFF);
+	_pgm_rxw_gap_state (window, gap, PGM_PKT_STATE_BACK_OFF);
 
 /* post-conditions */
 	pgm_assert_cmpuint (pgm_rxw_length (window), >, 0);
@@ -665,7 +1511,7 @@ _pgm_rxw_add_placeholder (
 	pgm_assert_cmpuint (_pgm_rxw_incoming_length (window), >, 0);
 }
 
-/* add a range of placeholders to the window.
+/* add a gap for the sequences preceding sequence to the window.
  */
 
 static
@@ -690,23 +1536,13 @@ _pgm_rxw_add_placeholder_range (
 		return PGM_RXW_BOUNDS;		/* effectively a slow consumer */
         }
 
+/* if packet is non-contiguous to current leading edge add a gap */
+	_pgm_rxw_add_gap (window, sequence - pgm_rxw_next_lead (window), now, nak_rb_expiry);
 	if (pgm_rxw_is_full (window)) {
 		pgm_assert (_pgm_rxw_commit_is_empty (window));
 		pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Receive window full on placeholder sequence."));
-		_pgm_rxw_remove_trail (window);
-	}
-
-/* if packet is non-contiguous to current leading edge add place holders
- * TODO: can be rather inefficient on packet loss looping through dropped sequence numbers
- */
-	while (pgm_rxw_next_lead (window) != sequence)
-	{
-		_pgm_rxw_add_placeholder (window, now, nak_rb_expiry);
-		if (pgm_rxw_is_full (window)) {
-			pgm_assert (_pgm_rxw_commit_is_empty (window));
-			pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Receive window full on placeholder sequence."));
+		if (0 == _pgm_rxw_spill (window, 1))
 			_pgm_rxw_remove_trail (window);
-		}
 	}
 
 /* post-conditions */
@@ -717,7 +1553,7 @@ _pgm_rxw_add_placeholder_range (
 
 /* update leading edge of receive window.
  *
- * returns number of place holders added.
+ * returns number of lost sequences added.
  */
 
 static
@@ -730,7 +1566,6 @@ _pgm_rxw_update_lead (
 	)
 {
 	uint32_t lead;
-	unsigned lost = 0;
 
 /* pre-conditions */
 	pgm_assert (NULL != window);
@@ -750,19 +1585,8 @@ _pgm_rxw_update_lead (
 	else
 		lead = txw_lead;
 
-/* count lost sequences */
-	while (window->lead != lead)
-	{
-/* slow consumer or fast producer */
-		if (pgm_rxw_is_full (window)) {
-			pgm_assert (_pgm_rxw_commit_is_empty (window));
-			pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Receive window full on window lead advancement."));
-			_pgm_rxw_remove_trail (window);
-		}
-		_pgm_rxw_add_placeholder (window, now, nak_rb_expiry);
-		lost++;
-	}
-
+	const uint32_t lost = lead - window->lead;
+	_pgm_rxw_add_gap (window, lost, now, nak_rb_expiry);
 	return lost;
 }
 
@@ -796,55 +1620,133 @@ _pgm_rxw_is_apdu_lost (
 	if (apdu_first_sqn == skb->sequence)
 		return FALSE;
 
-	const struct pgm_sk_buff_t* const first_skb = _pgm_rxw_peek (window, apdu_first_sqn);
 /* first fragment out-of-bounds */
-	if (NULL == first_skb)
+	if (!_pgm_rxw_is_in_window (window, apdu_first_sqn))
 		return TRUE;
 
-	const pgm_rxw_state_t* first_state = (pgm_rxw_state_t*)&first_skb->cb;
-	if (PGM_PKT_STATE_LOST_DATA == first_state->pkt_state)
+	if (PGM_PKT_STATE_LOST_DATA == _pgm_rxw_pkt_state (window, apdu_first_sqn))
 		return TRUE;
 
 	return FALSE;
 }
 
-/* return the first missing packet sequence in the specified transmission
- * group or NULL if not required.
+/* returns the original packets of the transmission group covered by parity
+ * skb, fewer than the group for parity of a partial group.
  */
 
 static inline
-struct pgm_sk_buff_t*
+uint32_t
+_pgm_rxw_parity_tg_size (
+	const pgm_rxw_t*	    const restrict window,
+	const struct pgm_sk_buff_t* const restrict skb
+	)
+{
+	const pgm_rxw_state_t* state = (const pgm_rxw_state_t*)&skb->cb;
+	return 0 == state->tg_size ? window->tg_size : state->tg_size;
+}
+
+/* find the first missing packet sequence in the first tg_size packets of the
+ * specified transmission group.
+ *
+ * returns TRUE with sequence set, or FALSE if not required.
+ */
+
+static inline
+bool
 _pgm_rxw_find_missing (
 	pgm_rxw_t* const		window,
-	const uint32_t			tg_sqn		/* tg_sqn | pkt_sqn */
+	const uint32_t			tg_sqn,		/* tg_sqn | pkt_sqn */
+	const uint32_t			tg_size,
+	uint32_t* const			sequence
 	)
 {
-	struct pgm_sk_buff_t* skb;
-	pgm_rxw_state_t* state;
-
 /* pre-conditions */
 	pgm_assert (NULL != window);
+	pgm_assert (NULL != sequence);
+	pgm_assert_cmpuint (tg_size, <=, window->tg_size);
 
-	for (uint32_t i = tg_sqn, j = 0; j < window->tg_size; i++, j++)
+	pgm_assert_cmpuint (_pgm_rxw_pkt_sqn (window, tg_sqn), ==, 0);
+
+	for (uint32_t i = tg_sqn, j = 0; j < tg_size; i++, j++)
 	{
-		skb = _pgm_rxw_peek (window, i);
-		pgm_assert (NULL != skb);
-		state = (pgm_rxw_state_t*)&skb->cb;
-		switch (state->pkt_state) {
+/* remainder of group beyond window lead */
+		if (!_pgm_rxw_is_in_window (window, i))
+			break;
+		switch (_pgm_rxw_pkt_state (window, i)) {
 		case PGM_PKT_STATE_BACK_OFF:
 		case PGM_PKT_STATE_WAIT_NCF:
 		case PGM_PKT_STATE_WAIT_DATA:
 		case PGM_PKT_STATE_LOST_DATA:
-			return skb;
+			*sequence = i;
+			return TRUE;
 
 		case PGM_PKT_STATE_HAVE_DATA:
 		case PGM_PKT_STATE_HAVE_PARITY:
+		case PGM_PKT_STATE_COMMIT_DATA:
 			break;
 
 		default: pgm_assert_not_reached(); break;
 		}
 	}
 
+	return FALSE;
+}
+
+/* returns TRUE if the parity packet with original sequence data_sqn is already
+ * held in the transmission group.
+ */
+
+static
+bool
+_pgm_rxw_has_parity (
+	pgm_rxw_t* const		window,
+	const uint32_t			tg_sqn,
+	const uint32_t			data_sqn	/* tg_sqn | parity packet number */
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+
+	if (0 == window->parity_count)
+		return FALSE;
+
+	for (uint32_t i = tg_sqn, j = 0; j < window->tg_size; i++, j++)
+	{
+		const struct pgm_sk_buff_t* skb = _pgm_rxw_peek (window, i);
+		if (NULL == skb)
+			continue;
+		const pgm_rxw_state_t* state = (const pgm_rxw_state_t*)&skb->cb;
+		if (PGM_PKT_STATE_HAVE_PARITY == state->pkt_state &&
+		    data_sqn == pgm_ntohl (skb->pgm_data->data_sqn))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* returns the first original data packet held for a transmission group,
+ * or NULL if none have arrived.
+ */
+
+static
+const struct pgm_sk_buff_t*
+_pgm_rxw_first_data (
+	pgm_rxw_t* const		window,
+	const uint32_t			tg_sqn
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+
+	for (uint32_t i = tg_sqn, j = 0; j < window->tg_size; i++, j++)
+	{
+		const struct pgm_sk_buff_t* skb = _pgm_rxw_peek (window, i);
+		if (NULL == skb)
+			continue;
+		const pgm_rxw_state_t* state = (const pgm_rxw_state_t*)&skb->cb;
+		if (PGM_PKT_STATE_HAVE_DATA == state->pkt_state ||
+		    PGM_PKT_STATE_COMMIT_DATA == state->pkt_state)
+			return skb;
+	}
 	return NULL;
 }
 
@@ -868,16 +1770,13 @@ _pgm_rxw_is_invalid_var_pktlen (
 	if (!window->is_fec_available)
 		return FALSE;
 
-	if (skb->pgm_header->pgm_options & PGM_OPT_VAR_PKTLEN)
-		return FALSE;
-
-	const uint32_t tg_sqn = _pgm_rxw_tg_sqn (window, skb->sequence);
-	if (tg_sqn == skb->sequence)
+	if (!(skb->pgm_header->pgm_options & PGM_OPT_PARITY) ||
+	    skb->pgm_header->pgm_options & PGM_OPT_VAR_PKTLEN)
 		return FALSE;
 
-	first_skb = _pgm_rxw_peek (window, tg_sqn);
+	first_skb = _pgm_rxw_first_data (window, _pgm_rxw_tg_sqn (window, skb->sequence));
 	if (NULL == first_skb)
-		return TRUE;	/* transmission group unrecoverable */
+		return FALSE;	/* nothing to compare */
 
 	if (first_skb->len == skb->len)
 		return FALSE;
@@ -917,13 +1816,9 @@ _pgm_rxw_is_invalid_payload_op (
 	if (!window->is_fec_available)
 		return FALSE;
 
-	const uint32_t tg_sqn = _pgm_rxw_tg_sqn (window, skb->sequence);
-	if (tg_sqn == skb->sequence)
-		return FALSE;
-
-	first_skb = _pgm_rxw_peek (window, tg_sqn);
-	if (NULL == first_skb)
-		return TRUE;	/* transmission group unrecoverable */
+	first_skb = _pgm_rxw_first_data (window, _pgm_rxw_tg_sqn (window, skb->sequence));
+	if (NULL == first_skb || first_skb == skb)
+		return FALSE;	/* nothing to compare */
 
 	if (_pgm_rxw_has_payload_op (first_skb) == _pgm_rxw_has_payload_op (skb))
 		return FALSE;
@@ -950,6 +1845,8 @@ _pgm_rxw_insert (
 {
 	struct pgm_sk_buff_t* skb;
 	pgm_rxw_state_t* state;
+	pgm_rxw_gap_t hole;
+	pgm_time_t tstamp, nak_sent_tstamp = 0;
 
 /* pre-conditions */
 	pgm_assert (NULL != window);
@@ -962,50 +1859,73 @@ _pgm_rxw_insert (
 
 	if (new_skb->pgm_header->pgm_options & PGM_OPT_PARITY)
 	{
-		skb = _pgm_rxw_find_missing (window, new_skb->sequence);
-		if (NULL == skb)
+		uint32_t missing;
+		if (!_pgm_rxw_find_missing (window, _pgm_rxw_tg_sqn (window, new_skb->sequence), _pgm_rxw_parity_tg_size (window, new_skb), &missing))
 			return PGM_RXW_DUPLICATE;
-		state = (pgm_rxw_state_t*)&skb->cb;
+/* parity takes the place of the missing sequence, original sequence remains in the header */
+		new_skb->sequence = missing;
+		skb = _pgm_rxw_peek (window, new_skb->sequence);
 	}
 	else
 	{
+		pgm_assert (_pgm_rxw_is_in_window (window, new_skb->sequence));
 		skb = _pgm_rxw_peek (window, new_skb->sequence);
-		pgm_assert (NULL != skb);
-		state = (pgm_rxw_state_t*)&skb->cb;
-
-		if (state->pkt_state == PGM_PKT_STATE_HAVE_DATA)
+		if (NULL != skb &&
+		    (PGM_PKT_STATE_HAVE_DATA == ((const pgm_rxw_state_t*)&skb->cb)->pkt_state ||
+		     PGM_PKT_STATE_COMMIT_DATA == ((const pgm_rxw_state_t*)&skb->cb)->pkt_state))	/* delivered out of order */
 			return PGM_RXW_DUPLICATE;
 	}
 
 /* APDU fragments are already declared lost */
 	if (new_skb->pgm_opt_fragment &&
+	    !(new_skb->pgm_header->pgm_options & PGM_OPT_PARITY) &&
 	    _pgm_rxw_is_apdu_lost (window, new_skb))
 	{
-		pgm_rxw_lost (window, skb->sequence);
+		pgm_rxw_lost (window, new_skb->sequence);
 		return PGM_RXW_BOUNDS;
 	}
 
-/* verify placeholder state */
-	switch (state->pkt_state) {
-	case PGM_PKT_STATE_BACK_OFF:
-	case PGM_PKT_STATE_WAIT_NCF:
-	case PGM_PKT_STATE_WAIT_DATA:
-	case PGM_PKT_STATE_LOST_DATA:
-		break;
+/* verify placeholder state, a missing sequence is taken from its gap */
+	if (NULL == skb)
+	{
+		_pgm_rxw_gap_fill (window, _pgm_rxw_find_gap (window, new_skb->sequence), new_skb->sequence, &hole);
+		state = &hole.state;
+		tstamp = hole.tstamp;
+		nak_sent_tstamp = hole.nak_sent_tstamp;
+	}
+	else
+	{
+		state = (pgm_rxw_state_t*)&skb->cb;
+		switch (state->pkt_state) {
+		case PGM_PKT_STATE_LOST_DATA:
+			break;
 
-	case PGM_PKT_STATE_HAVE_PARITY:
-		_pgm_rxw_shuffle_parity (window, skb);
-		break;
+		case PGM_PKT_STATE_HAVE_PARITY:
+			skb = _pgm_rxw_shuffle_parity (window, skb, &hole);
+			state = skb ? (pgm_rxw_state_t*)&skb->cb : &hole.state;
+			break;
 
-	default: pgm_assert_not_reached(); break;
+		default: pgm_assert_not_reached(); break;
+		}
+		tstamp = skb ? skb->tstamp : hole.tstamp;
+		if (NULL == skb)
+			nak_sent_tstamp = hole.nak_sent_tstamp;
 	}
 
 /* statistics */
-	const uint32_t fill_time = (uint32_t)(new_skb->tstamp - skb->tstamp);
+	const uint32_t fill_time = (uint32_t)(new_skb->tstamp - tstamp);
 	PGM_HISTOGRAM_TIMES("Rx.RepairTime", fill_time);
 	PGM_HISTOGRAM_COUNTS("Rx.NakTransmits", state->nak_transmit_count);
 	PGM_HISTOGRAM_COUNTS("Rx.NcfRetries", state->ncf_retry_count);
 	PGM_HISTOGRAM_COUNTS("Rx.DataRetries", state->data_retry_count);
+	if (nak_sent_tstamp)
+		pgm_latency_record (PGM_LATENCY_NAK_RDATA, nak_sent_tstamp, new_skb->tstamp);
+	{
+		unsigned bucket = 0;
+		for (uint32_t t = fill_time; t && bucket < PGM_RXW_FILL_TIME_BUCKETS - 1; t >>= 1)
+			bucket++;
+		window->fill_time_hist[ bucket ]++;
+	}
 	if (!window->max_fill_time) {
 		window->max_fill_time = window->min_fill_time = fill_time;
 	}
@@ -1041,53 +1961,72 @@ _pgm_rxw_insert (
 	if (s > window->data_loss)	window->data_loss = 0;
 	else				window->data_loss -= s;
 
-/* replace place holder skb with incoming skb */
-	memcpy (new_skb->cb, skb->cb, sizeof(skb->cb));
+/* replace place holder with incoming skb */
+	const uint8_t tg_size = ((const pgm_rxw_state_t*)&new_skb->cb)->tg_size;
+	memset (new_skb->cb, 0, sizeof(new_skb->cb));
+	memcpy (new_skb->cb, state, sizeof(pgm_rxw_state_t));
 	state = (void*)new_skb->cb;
 	state->pkt_state = PGM_PKT_STATE_ERROR;
-	_pgm_rxw_unlink (window, skb);
-	pgm_free_skb (skb);
-	const uint_fast32_t index_ = new_skb->sequence % pgm_rxw_max_length (window);
+	state->tg_size = (new_skb->pgm_header->pgm_options & PGM_OPT_PARITY) ? tg_size : 0;
+	if (NULL != skb) {
+		_pgm_rxw_unlink (window, skb);
+		window->size -= skb->len;	/* superseded parity */
+		pgm_mem_budget_charge (window->budget, -(int64_t)skb->truesize);
+		pgm_free_skb (skb);
+	}
+	const uint_fast32_t index_ = new_skb->sequence & window->mask;
 	window->pdata[index_] = new_skb;
 	if (new_skb->pgm_header->pgm_options & PGM_OPT_PARITY)
 		_pgm_rxw_state (window, new_skb, PGM_PKT_STATE_HAVE_PARITY);
-	else
+	else {
 		_pgm_rxw_state (window, new_skb, PGM_PKT_STATE_HAVE_DATA);
+		_pgm_rxw_reassemble (window, new_skb);
+	}
+	_pgm_rxw_stamp_insert (new_skb);
 	window->size += new_skb->len;
+	pgm_mem_budget_charge (window->budget, new_skb->truesize);
 
 	return PGM_RXW_INSERTED;
 }
 
-/* shuffle parity packet at skb->sequence to any other needed spot.
+/* shuffle parity packet at skb->sequence to any other needed spot.  a parity
+ * packet moved into a gap leaves the recovery state of that sequence in hole.
+ *
+ * returns the skb now at the original sequence, NULL if none.
  */
 
 static inline
-void
+struct pgm_sk_buff_t*
 _pgm_rxw_shuffle_parity (
 	pgm_rxw_t*	      const restrict window,
-	struct pgm_sk_buff_t* const restrict skb
+	struct pgm_sk_buff_t* const restrict skb,
+	pgm_rxw_gap_t*	      const restrict hole
 	)
 {
-	struct pgm_sk_buff_t* restrict missing;
-	char cb[48];
+	struct pgm_sk_buff_t* missing_skb;
+	uint32_t missing;
 
 /* pre-conditions */
 	pgm_assert (NULL != window);
 	pgm_assert (NULL != skb);
+	pgm_assert (NULL != hole);
 
-	missing = _pgm_rxw_find_missing (window, skb->sequence);
-	if (NULL == missing)
-		return;
+	if (!_pgm_rxw_find_missing (window, _pgm_rxw_tg_sqn (window, skb->sequence), _pgm_rxw_parity_tg_size (window, skb), &missing))
+		return skb;
 
-/* replace place holder skb with parity skb */
-	_pgm_rxw_unlink (window, missing);
-	memcpy (cb, skb->cb, sizeof(skb->cb));
-	memcpy (skb->cb, missing->cb, sizeof(skb->cb));
-	memcpy (missing->cb, cb, sizeof(skb->cb));
-	const uint32_t parity_index = skb->sequence % pgm_rxw_max_length (window);
+/* exchange places, each skb retains its own state */
+	const uint32_t sequence = skb->sequence;
+	missing_skb = _pgm_rxw_peek (window, missing);
+	if (NULL == missing_skb)
+		_pgm_rxw_gap_fill (window, _pgm_rxw_find_gap (window, missing), missing, hole);
+	else
+		missing_skb->sequence = sequence;
+	skb->sequence = missing;
+	const uint32_t parity_index = skb->sequence & window->mask;
 	window->pdata[parity_index] = skb;
-	const uint32_t missing_index = missing->sequence % pgm_rxw_max_length (window);
-	window->pdata[missing_index] = missing;
+	const uint32_t missing_index = sequence & window->mask;
+	window->pdata[missing_index] = missing_skb;
+	return missing_skb;
 }
 
 /* skb advances the window lead.
@@ -1110,7 +2049,7 @@ _pgm_rxw_append (
 	pgm_assert (NULL != window);
 	pgm_assert (NULL != skb);
 	if (skb->pgm_header->pgm_options & PGM_OPT_PARITY) {
-		pgm_assert (_pgm_rxw_tg_sqn (window, skb->sequence) == _pgm_rxw_tg_sqn (window, pgm_rxw_lead (window)));
+		pgm_assert (_pgm_rxw_tg_sqn (window, skb->sequence) == _pgm_rxw_tg_sqn (window, pgm_rxw_next_lead (window)));
 	} else {
 		pgm_assert (skb->sequence == pgm_rxw_next_lead (window));
 	}
@@ -1122,13 +2061,28 @@ _pgm_rxw_append (
 	if (pgm_rxw_is_full (window)) {
 		if (_pgm_rxw_commit_is_empty (window)) {
 			pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Receive window full on new data."));
-			_pgm_rxw_remove_trail (window);
+			if (0 == _pgm_rxw_spill (window, 1))
+				_pgm_rxw_remove_trail (window);
 		} else {
 			return PGM_RXW_BOUNDS;		/* constrained by commit window */
 		}
 	}
+/* over the memory budget the trail is released as if the window were full,
+ * without spilling.
+ */
+	else if (PGM_UNLIKELY(!pgm_rxw_is_empty (window) &&
+			      pgm_mem_budget_is_exceeded (window->budget)))
+	{
+		if (_pgm_rxw_commit_is_empty (window)) {
+			pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Memory budget exceeded on new data."));
+			_pgm_rxw_remove_trail (window);
+		} else {
+			return PGM_RXW_BOUNDS;
+		}
+	}
 
 /* advance leading edge */
+	_pgm_rxw_reserve (window, 1);
 	window->lead++;
 
 /* add packet to bitmap */
@@ -1143,36 +2097,37 @@ _pgm_rxw_append (
 
 /* APDU fragments are already declared lost */
 	if (PGM_UNLIKELY(skb->pgm_opt_fragment &&
+	    !(skb->pgm_header->pgm_options & PGM_OPT_PARITY) &&
 	    _pgm_rxw_is_apdu_lost (window, skb)))
 	{
-		struct pgm_sk_buff_t* lost_skb	= pgm_alloc_skb (window->max_tpdu);
-		lost_skb->tstamp		= now;
-		lost_skb->sequence		= skb->sequence;
-
-/* add lost-placeholder skb to window */
-		const uint_fast32_t index_	= lost_skb->sequence % pgm_rxw_max_length (window);
-		window->pdata[index_]		= lost_skb;
-
-		_pgm_rxw_state (window, lost_skb, PGM_PKT_STATE_LOST_DATA);
+/* add lost gap to window */
+		pgm_rxw_gap_t* gap = _pgm_rxw_gap_new (window, skb->sequence, 1, now);
+		pgm_queue_push_head_link (&window->gap_queue, &gap->order_link);
+		_pgm_rxw_gap_state (window, gap, PGM_PKT_STATE_LOST_DATA);
 		return PGM_RXW_BOUNDS;
 	}
 
 /* add skb to window */
 	if (skb->pgm_header->pgm_options & PGM_OPT_PARITY)
 	{
-		const uint_fast32_t index_	= skb->sequence % pgm_rxw_max_length (window);
+/* parity takes the place of the next missing sequence */
+		skb->sequence			= window->lead;
+		const uint_fast32_t index_	= skb->sequence & window->mask;
 		window->pdata[index_]		= skb;
 		_pgm_rxw_state (window, skb, PGM_PKT_STATE_HAVE_PARITY);
 	}
 	else
 	{
-		const uint_fast32_t index_	= skb->sequence % pgm_rxw_max_length (window);
+		const uint_fast32_t index_	= skb->sequence & window->mask;
 		window->pdata[index_]		= skb;
 		_pgm_rxw_state (window, skb, PGM_PKT_STATE_HAVE_DATA);
+		_pgm_rxw_reassemble (window, skb);
 	}
+	_pgm_rxw_stamp_insert (skb);
 
 /* statistics */
 	window->size += skb->len;
+	pgm_mem_budget_charge (window->budget, skb->truesize);
 
 	return PGM_RXW_APPENDED;
 }
@@ -1191,12 +2146,40 @@ pgm_rxw_remove_commit (
 	pgm_assert (NULL != window);
 
 	const uint32_t tg_sqn_of_commit_lead = _pgm_rxw_tg_sqn (window, window->commit_lead);
+	const pgm_time_t now = pgm_time_coarse_now();
 
 	while (!_pgm_rxw_commit_is_empty (window) &&
 	       tg_sqn_of_commit_lead != _pgm_rxw_tg_sqn (window, window->trail))
 	{
+		const struct pgm_sk_buff_t* skb = _pgm_rxw_peek (window, window->trail);
+		if (NULL != skb)
+			_pgm_rxw_residency_add (window, skb, now);
 		_pgm_rxw_remove_trail (window);
 	}
+
+/* spilled APDUs are only valid until the next read */
+	_pgm_rxw_spill_free (&window->spill_commit_queue);
+
+/* as are reassembled APDUs, those left behind the trail are never read */
+	_pgm_rxw_reasm_free (window, &window->reasm_commit_queue);
+	_pgm_rxw_reasm_purge (window);
+
+/* records of coalesced TPDUs are only valid until the next read */
+	if (NULL != window->records_tail) {
+		struct pgm_rxw_records_t* records = window->records;
+		do {
+			records->len = 0;
+		} while (records != window->records_tail && NULL != (records = records->next));
+		window->records_tail = NULL;
+	}
+
+/* shrink deferred by the occupied span */
+	if (window->resize_alloc)
+		_pgm_rxw_apply_max_length (window);
+
+/* release idle pointer slots */
+	if (window->can_shrink && window->alloc / 2 >= window->min_alloc)
+		_pgm_rxw_shrink (window);
 }
 
 /* flush packets but instead of calling on_data append the contiguous data packets
@@ -1220,96 +2203,498 @@ pgm_rxw_readv (
 	const unsigned		     pmsglen		/* number of items in pmsg */
 	)
 {
-	const struct pgm_msgv_t* msg_end;
-	struct pgm_sk_buff_t* skb;
-	pgm_rxw_state_t* state;
-	ssize_t bytes_read;
+	pgm_rxw_cursor_t cursor;
+	ssize_t bytes_read;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != pmsg);
+	pgm_assert_cmpuint (pmsglen, >, 0);
+
+	pgm_debug ("readv (window:%p pmsg:%p pmsglen:%u)",
+		(void*)window, (void*)pmsg, pmsglen);
+
+	pgm_rxw_cursor_init_msgv (&cursor, *pmsg, pmsglen);
+	bytes_read = pgm_rxw_read (window, &cursor);
+	*pmsg = cursor.msgv;
+	return bytes_read;
+}
+
+/* as pgm_rxw_readv() appending messages at the cursor, either an array of
+ * message vectors or a compact vector.
+ *
+ * returns -1 on nothing read, returns length of bytes read.
+ */
+
+PGM_GNUC_INTERNAL
+ssize_t
+pgm_rxw_read (
+	pgm_rxw_t*	   const restrict window,
+	pgm_rxw_cursor_t*  const restrict cursor
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != cursor);
+	pgm_assert (!pgm_rxw_cursor_is_full (cursor));
+
+	pgm_debug ("read (window:%p cursor:%p)",
+		(void*)window, (void*)cursor);
+
+	const ssize_t bytes_read = _pgm_rxw_read (window, cursor);
+/* later copies of committed sequences are dropped ahead of the stack */
+	pgm_xdp_filter_publish (window->xdp_filter, window->tsi, &window->xdp_filter_lead, window->commit_lead);
+	return bytes_read;
+}
+
+static
+ssize_t
+_pgm_rxw_read (
+	pgm_rxw_t*	   const restrict window,
+	pgm_rxw_cursor_t*  const restrict cursor
+	)
+{
+	ssize_t bytes_read, spill_read = -1;
+
+	window->read_tstamp = pgm_time_coarse_now();
+
+	if (!pgm_queue_is_empty (&window->decode_queue))
+		pgm_rxw_decode_collect (window);
+
+/* spilled APDUs precede the trailing edge */
+	if (!pgm_queue_is_empty (&window->spill_queue)) {
+		spill_read = _pgm_rxw_spill_read (window, cursor);
+		if (pgm_rxw_cursor_is_full (cursor))
+			return spill_read;
+	}
+
+	if (window->is_unordered)
+		_pgm_rxw_skip_committed (window);
+
+	if (_pgm_rxw_incoming_is_empty (window))
+		return spill_read;
+
+	switch (_pgm_rxw_pkt_state (window, window->commit_lead)) {
+	case PGM_PKT_STATE_HAVE_DATA:
+		bytes_read = _pgm_rxw_incoming_read (window, cursor);
+		break;
+
+	case PGM_PKT_STATE_LOST_DATA:
+/* do not purge in situ sequence */
+		if (_pgm_rxw_commit_is_empty (window)) {
+			pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Removing lost trail from window"));
+			_pgm_rxw_remove_trail (window);
+		} else {
+			pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Locking trail at commit window"));
+		}
+		bytes_read = -1;
+		break;
+
+	case PGM_PKT_STATE_BACK_OFF:
+	case PGM_PKT_STATE_WAIT_NCF:
+	case PGM_PKT_STATE_WAIT_DATA:
+	case PGM_PKT_STATE_HAVE_PARITY:
+/* leading packet recoverable from parity */
+		if (_pgm_rxw_try_reconstruct (window, window->commit_lead))
+			bytes_read = _pgm_rxw_incoming_read (window, cursor);
+		else
+			bytes_read = -1;
+		break;
+
+	case PGM_PKT_STATE_COMMIT_DATA:
+	case PGM_PKT_STATE_ERROR:
+	default:
+		pgm_assert_not_reached();
+		break;
+	}
+
+/* complete APDUs beyond the first gap */
+	if (window->is_unordered && !pgm_rxw_cursor_is_full (cursor)) {
+		const ssize_t unordered_read = _pgm_rxw_incoming_read_unordered (window, cursor);
+		if (unordered_read >= 0)
+			bytes_read = (bytes_read >= 0 ? bytes_read : 0) + unordered_read;
+	}
+
+	if (spill_read >= 0)
+		bytes_read = (bytes_read >= 0 ? bytes_read : 0) + spill_read;
+	return bytes_read;
+}
+
+/* advance the commit lead over APDUs already delivered out of order.
+ */
+
+static inline
+void
+_pgm_rxw_skip_committed (
+	pgm_rxw_t* const	window
+	)
+{
+	const struct pgm_sk_buff_t* skb;
+
+	while (!_pgm_rxw_incoming_is_empty (window) &&
+	       NULL != (skb = _pgm_rxw_peek (window, window->commit_lead)) &&
+	       PGM_PKT_STATE_COMMIT_DATA == ((const pgm_rxw_state_t*)&skb->cb)->pkt_state)
+	{
+		window->commit_lead++;
+	}
+	if (pgm_uint32_lt (window->unordered_lead, window->commit_lead))
+		window->unordered_lead = window->commit_lead;
+}
+
+/* read complete APDUs between gaps, leaving them in place tagged committed
+ * such that repairs are discarded as duplicates.  coalesced TPDUs and
+ * recovery from parity are left to in order delivery.
+ *
+ * returns count of bytes read, or -1 on nothing read.
+ */
+
+static
+ssize_t
+_pgm_rxw_incoming_read_unordered (
+	pgm_rxw_t*	   const restrict window,
+	pgm_rxw_cursor_t*  const restrict cursor	/* updated as messages appended */
+	)
+{
+	ssize_t bytes_read = 0;
+	size_t  data_read  = 0;
+	uint32_t sequence;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != cursor);
+	pgm_assert (window->is_unordered);
+
+	pgm_debug ("_pgm_rxw_incoming_read_unordered (window:%p cursor:%p)",
+		(void*)window, (void*)cursor);
+
+	sequence = pgm_uint32_lt (window->unordered_lead, window->commit_lead) ? window->commit_lead : window->unordered_lead;
+	while (!pgm_rxw_cursor_is_full (cursor) && pgm_uint32_lte (sequence, window->lead))
+	{
+		const struct pgm_sk_buff_t* skb = _pgm_rxw_peek (window, sequence);
+		if (NULL == skb) {
+			const pgm_rxw_gap_t* gap = _pgm_rxw_find_gap (window, sequence);
+			sequence = gap->sequence + gap->len;
+			continue;
+		}
+		if (PGM_PKT_STATE_HAVE_DATA != ((const pgm_rxw_state_t*)&skb->cb)->pkt_state ||
+		    skb->coalesced ||
+		    skb->compressed ||
+		    (skb->pgm_opt_fragment && pgm_ntohl (skb->of_apdu_first_sqn) != sequence) ||
+		    !_pgm_rxw_is_apdu_complete (window, sequence))
+		{
+			sequence++;
+			continue;
+		}
+		bytes_read += _pgm_rxw_incoming_read_apdu (window, cursor, sequence);
+		data_read  ++;
+		sequence += cursor->last_len;
+	}
+	window->unordered_lead = sequence;
+
+	window->bytes_delivered += bytes_read;
+	window->msgs_delivered  += data_read;
+	return data_read > 0 ? bytes_read : -1;
+}
+
+/* remove lost sequences from the trailing edge of the window.  lost sequence
+ * at lead of commit window invalidates all parity-data packets as any 
+ * transmission group is now unrecoverable.
+ *
+ * returns number of sequences purged.
+ */
+
+static
+unsigned
+_pgm_rxw_remove_trail (
+	pgm_rxw_t* const	window
+	)
+{
+	struct pgm_sk_buff_t* skb;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (!pgm_rxw_is_empty (window));
+
+	skb = _pgm_rxw_peek (window, window->trail);
+	const bool is_committed = (NULL != skb && PGM_PKT_STATE_COMMIT_DATA == ((const pgm_rxw_state_t*)&skb->cb)->pkt_state);
+	if (NULL != skb) {
+		_pgm_rxw_unlink (window, skb);
+		window->size -= skb->len;
+		pgm_mem_budget_charge (window->budget, -(int64_t)skb->truesize);
+/* remove reference to skb, a missing sequence must read NULL */
+		const uint_fast32_t index_ = skb->sequence & window->mask;
+		window->pdata[index_] = NULL;
+		pgm_free_skb (skb);
+	} else {
+		pgm_rxw_gap_t* gap = window->gap_queue.tail->data;
+		pgm_assert (window->trail == gap->sequence);
+		_pgm_rxw_gap_trim (window, gap, 1, TRUE);
+	}
+	if (window->trail++ == window->commit_lead) {
+		window->commit_lead++;
+/* delivered out of order */
+		if (is_committed)
+			return 0;
+/* data-loss */
+		window->cumulative_losses++;
+		pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Data loss due to pulled trailing edge, fragment count %" PRIu32 "."),window->fragment_count);
+		return 1;
+	}
+	return 0;
+}
+
+/* move complete unread APDUs at the trailing edge of a full window with an
+ * empty commit window to the spill queue, until count sequences have left or
+ * the spill budget is exhausted.  spilled sequences are neither lost nor
+ * committed, they are read ahead of the window.
+ *
+ * returns number of sequences spilled.
+ */
+
+static
+uint32_t
+_pgm_rxw_spill (
+	pgm_rxw_t* const	window,
+	const uint32_t		count
+	)
+{
+	uint32_t spilled = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+
+	if (0 == window->spill_max)
+		return 0;
+
+	while (spilled < count &&
+	       !pgm_rxw_is_empty (window) &&
+	       _pgm_rxw_commit_is_empty (window))
+	{
+		struct pgm_sk_buff_t* skb = _pgm_rxw_peek (window, window->trail);
+		if (NULL == skb ||
+		    PGM_PKT_STATE_HAVE_DATA != ((const pgm_rxw_state_t*)&skb->cb)->pkt_state ||
+		    skb->coalesced ||
+		    skb->compressed ||
+		    (skb->pgm_opt_fragment && pgm_ntohl (skb->of_apdu_first_sqn) != window->trail))
+			break;
+
+		const size_t apdu_len = skb->pgm_opt_fragment ? pgm_ntohl (skb->of_apdu_len) : skb->len;
+		if (window->spill_size + apdu_len > window->spill_max ||
+		    !_pgm_rxw_is_apdu_complete (window, window->trail))
+			break;
+
+		size_t contiguous_len = 0;
+		do {
+			skb = _pgm_rxw_peek (window, window->trail);
+			pgm_assert (NULL != skb);
+			_pgm_rxw_unlink (window, skb);
+			window->size -= skb->len;
+/* bounded by spill_max instead */
+			pgm_mem_budget_charge (window->budget, -(int64_t)skb->truesize);
+			const uint_fast32_t index_ = skb->sequence & window->mask;
+			window->pdata[index_] = NULL;
+			pgm_queue_push_head_link (&window->spill_queue, (pgm_list_t*)skb);
+			contiguous_len += skb->len;
+			window->commit_lead = ++window->trail;
+			spilled++;
+		} while (apdu_len > contiguous_len);
+		window->spill_size += apdu_len;
+	}
+
+	if (spilled > 0) {
+		window->cumulative_spilled += spilled;
+		pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Spilled %" PRIu32 " sequences from trailing edge, spill size %" PRIzu " bytes."),
+			spilled, window->spill_size);
+	}
+	return spilled;
+}
+
+/* read spilled APDUs in sequence order, the skbs remain valid until the next
+ * commit.
+ *
+ * returns count of bytes read, or -1 on nothing read.
+ */
+
+static inline
+ssize_t
+_pgm_rxw_spill_read (
+	pgm_rxw_t*	   const restrict window,
+	pgm_rxw_cursor_t*  const restrict cursor	/* updated as messages appended */
+	)
+{
+	ssize_t bytes_read = 0;
+	size_t  data_read  = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != cursor);
+
+	while (!pgm_rxw_cursor_is_full (cursor) &&
+	       !pgm_queue_is_empty (&window->spill_queue))
+	{
+		struct pgm_sk_buff_t* skb = (struct pgm_sk_buff_t*)pgm_queue_peek_tail_link (&window->spill_queue);
+		const size_t apdu_len = skb->pgm_opt_fragment ? pgm_ntohl (skb->of_apdu_len) : skb->len;
+		size_t contiguous_len = 0;
+		do {
+			skb = (struct pgm_sk_buff_t*)pgm_queue_pop_tail_link (&window->spill_queue);
+			pgm_assert (NULL != skb);
+			pgm_queue_push_head_link (&window->spill_commit_queue, (pgm_list_t*)skb);
+			pgm_rxw_cursor_append (cursor, skb);
+			contiguous_len += skb->len;
+		} while (apdu_len > contiguous_len);
+		pgm_rxw_cursor_next (cursor);
+		window->spill_size -= apdu_len;
+		bytes_read += contiguous_len;
+		data_read  ++;
+	}
+
+	window->bytes_delivered += bytes_read;
+	window->msgs_delivered  += data_read;
+	return data_read > 0 ? bytes_read : -1;
+}
+
+static inline
+void
+_pgm_rxw_spill_free (
+	pgm_queue_t* const	queue
+	)
+{
+	while (!pgm_queue_is_empty (queue)) {
+		struct pgm_sk_buff_t* skb = (struct pgm_sk_buff_t*)pgm_queue_pop_tail_link (queue);
+		pgm_free_skb (skb);
+	}
+}
+
+/* returns the pool of the smallest size class holding len bytes, or NULL for
+ * none.
+ */
+
+static inline
+pgm_skb_pool_t*
+_pgm_rxw_class_pool (
+	pgm_skb_pool_t** const	pools,		/* PGM_RXW_REASM_CLASSES, optional */
+	const uint32_t		len
+	)
+{
+	unsigned class_ = 0;
+
+	if (NULL == pools)
+		return NULL;
+	while (pgm_rxw_reasm_class_size (class_) < len)
+		class_++;
+	return pools[ class_ ];
+}
+
+/* copy the payload of a fragment of a large or compressed APDU to its offset
+ * in one buffer for the whole APDU, the first fragment to arrive allocating
+ * the buffer from the pool of its size class.  the fragment stays in the window for repair
+ * state, inconsistent fragments are left to _pgm_rxw_is_apdu_complete() and
+ * the APDU is then read from the fragments as before.
+ */
+
+static
+void
+_pgm_rxw_reassemble (
+	pgm_rxw_t*		    const restrict window,
+	const struct pgm_sk_buff_t* const restrict skb
+	)
+{
+	struct pgm_sk_buff_t* apdu = NULL;
 
-/* pre-conditions */
-	pgm_assert (NULL != window);
-	pgm_assert (NULL != pmsg);
-	pgm_assert_cmpuint (pmsglen, >, 0);
+/* compressed APDUs are always reassembled to be decompressed */
+	if ((0 == window->reasm_min && !skb->compressed) || NULL == skb->pgm_opt_fragment)
+		return;
 
-	pgm_debug ("readv (window:%p pmsg:%p pmsglen:%u)",
-		(void*)window, (void*)pmsg, pmsglen);
+	const uint32_t first_sequence = pgm_ntohl (skb->of_apdu_first_sqn);
+	const uint32_t apdu_len	      = pgm_ntohl (skb->of_apdu_len);
+	const uint32_t frag_offset    = pgm_ntohl (skb->of_frag_offset);
+	if ((apdu_len < window->reasm_min && !skb->compressed) ||
+	    PGM_UNLIKELY(apdu_len > PGM_MAX_APDU ||
+			 frag_offset > apdu_len ||
+			 skb->len > apdu_len - frag_offset))
+		return;
 
-	msg_end = *pmsg + pmsglen - 1;
+	for (pgm_list_t* link = window->reasm_queue.head; NULL != link; link = link->next) {
+		if (((struct pgm_sk_buff_t*)link)->sequence == first_sequence) {
+			apdu = (struct pgm_sk_buff_t*)link;
+			break;
+		}
+	}
 
-	if (_pgm_rxw_incoming_is_empty (window))
-		return -1;
+	if (NULL == apdu) {
+		pgm_skb_pool_t* pool = _pgm_rxw_class_pool (window->reasm_pool, apdu_len);
+		if (NULL == pool && skb->compressed)
+			pool = _pgm_rxw_class_pool (window->inflate_pool, apdu_len);
+		apdu = pgm_skb_pool_alloc (pool, (uint16_t)apdu_len);
+		apdu->sock	= skb->sock;
+		memcpy (&apdu->tsi, &skb->tsi, sizeof(pgm_tsi_t));
+		apdu->sequence	= first_sequence;
+		apdu->tail	= (char*)apdu->data + apdu_len;
+		apdu->len	= 0;		/* bytes filled */
+		pgm_queue_push_head_link (&window->reasm_queue, (pgm_list_t*)apdu);
+		pgm_mem_budget_charge (window->budget, apdu->truesize);
+	}
+	else if (PGM_UNLIKELY((char*)apdu->tail - (char*)apdu->data != (ptrdiff_t)apdu_len))
+		return;
 
-	skb = _pgm_rxw_peek (window, window->commit_lead);
-	pgm_assert (NULL != skb);
+	memcpy ((char*)apdu->data + frag_offset, skb->data, skb->len);
+	apdu->len += skb->len;
+}
 
-	state = (pgm_rxw_state_t*)&skb->cb;
-	switch (state->pkt_state) {
-	case PGM_PKT_STATE_HAVE_DATA:
-		bytes_read = _pgm_rxw_incoming_read (window, pmsg, (unsigned)(msg_end - *pmsg + 1));
-		break;
+/* returns the reassembled APDU of first_sequence removed from the queue, or
+ * NULL if none.
+ */
 
-	case PGM_PKT_STATE_LOST_DATA:
-/* do not purge in situ sequence */
-		if (_pgm_rxw_commit_is_empty (window)) {
-			pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Removing lost trail from window"));
-			_pgm_rxw_remove_trail (window);
-		} else {
-			pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Locking trail at commit window"));
+static
+struct pgm_sk_buff_t*
+_pgm_rxw_reasm_take (
+	pgm_rxw_t* const	window,
+	const uint32_t		first_sequence
+	)
+{
+	for (pgm_list_t* link = window->reasm_queue.head; NULL != link; link = link->next) {
+		if (((struct pgm_sk_buff_t*)link)->sequence == first_sequence) {
+			pgm_queue_unlink (&window->reasm_queue, link);
+			return (struct pgm_sk_buff_t*)link;
 		}
-/* fall through */
-	case PGM_PKT_STATE_BACK_OFF:
-	case PGM_PKT_STATE_WAIT_NCF:
-	case PGM_PKT_STATE_WAIT_DATA:
-	case PGM_PKT_STATE_HAVE_PARITY:
-		bytes_read = -1;
-		break;
-
-	case PGM_PKT_STATE_COMMIT_DATA:
-	case PGM_PKT_STATE_ERROR:
-	default:
-		pgm_assert_not_reached();
-		break;
 	}
+	return NULL;
+}
 
-	return bytes_read;
+static
+void
+_pgm_rxw_reasm_free (
+	pgm_rxw_t*   const restrict window,
+	pgm_queue_t* const restrict queue
+	)
+{
+	while (!pgm_queue_is_empty (queue)) {
+		struct pgm_sk_buff_t* apdu = (struct pgm_sk_buff_t*)pgm_queue_pop_tail_link (queue);
+		pgm_mem_budget_charge (window->budget, -(int64_t)apdu->truesize);
+		pgm_free_skb (apdu);
+	}
 }
 
-/* remove lost sequences from the trailing edge of the window.  lost sequence
- * at lead of commit window invalidates all parity-data packets as any 
- * transmission group is now unrecoverable.
- *
- * returns number of sequences purged.
+/* release APDUs being filled whose first sequence has left the window, lost
+ * or read as fragments.
  */
 
 static
-unsigned
-_pgm_rxw_remove_trail (
+void
+_pgm_rxw_reasm_purge (
 	pgm_rxw_t* const	window
 	)
 {
-	struct pgm_sk_buff_t* skb;
-
-/* pre-conditions */
-	pgm_assert (NULL != window);
-	pgm_assert (!pgm_rxw_is_empty (window));
-
-	skb = _pgm_rxw_peek (window, window->trail);
-	pgm_assert (NULL != skb);
-	_pgm_rxw_unlink (window, skb);
-	window->size -= skb->len;
-/* remove reference to skb */
-	if (PGM_UNLIKELY(pgm_mem_gc_friendly)) {
-		const uint_fast32_t index_ = skb->sequence % pgm_rxw_max_length (window);
-		window->pdata[index_] = NULL;
-	}
-	pgm_free_skb (skb);
-	if (window->trail++ == window->commit_lead) {
-/* data-loss */
-		window->commit_lead++;
-		window->cumulative_losses++;
-		pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Data loss due to pulled trailing edge, fragment count %" PRIu32 "."),window->fragment_count);
-		return 1;
+	pgm_list_t* link = window->reasm_queue.head;
+	while (NULL != link) {
+		struct pgm_sk_buff_t* apdu = (struct pgm_sk_buff_t*)link;
+		link = link->next;
+		if (pgm_uint32_lt (apdu->sequence, window->trail)) {
+			pgm_queue_unlink (&window->reasm_queue, (pgm_list_t*)apdu);
+			pgm_mem_budget_charge (window->budget, -(int64_t)apdu->truesize);
+			pgm_free_skb (apdu);
+		}
 	}
-	return 0;
 }
 
 PGM_GNUC_INTERNAL
@@ -1334,40 +2719,46 @@ pgm_rxw_remove_trail (
 static inline
 ssize_t
 _pgm_rxw_incoming_read (
-	pgm_rxw_t*    const restrict window,
-	struct pgm_msgv_t** restrict pmsg,		/* message array, updated as messages appended */
-	unsigned		     pmsglen		/* number of items in pmsg */
+	pgm_rxw_t*	   const restrict window,
+	pgm_rxw_cursor_t*  const restrict cursor	/* updated as messages appended */
 	)
 {
-	const struct pgm_msgv_t* msg_end;
 	struct pgm_sk_buff_t* skb;
 	ssize_t bytes_read = 0;
 	size_t  data_read  = 0;
 
 /* pre-conditions */
 	pgm_assert (NULL != window);
-	pgm_assert (NULL != pmsg);
-	pgm_assert_cmpuint (pmsglen, >, 0);
+	pgm_assert (NULL != cursor);
+	pgm_assert (!pgm_rxw_cursor_is_full (cursor));
 	pgm_assert (!_pgm_rxw_incoming_is_empty (window));
 
-	pgm_debug ("_pgm_rxw_incoming_read (window:%p pmsg:%p pmsglen:%u)",
-		 (void*)window, (void*)pmsg, pmsglen);
+	pgm_debug ("_pgm_rxw_incoming_read (window:%p cursor:%p)",
+		 (void*)window, (void*)cursor);
 
-	msg_end = *pmsg + pmsglen - 1;
 	do {
 		skb = _pgm_rxw_peek (window, window->commit_lead);
-		pgm_assert (NULL != skb);
 		if (_pgm_rxw_is_apdu_complete (window,
+					      NULL == skb ? window->commit_lead :
 					      skb->pgm_opt_fragment ? pgm_ntohl (skb->of_apdu_first_sqn) : skb->sequence))
 		{
-			bytes_read += _pgm_rxw_incoming_read_apdu (window, pmsg);
-			data_read  ++;
+			if (NULL != skb && skb->coalesced) {
+				bytes_read += _pgm_rxw_incoming_read_records (window, cursor, &data_read);
+			} else {
+				const ssize_t apdu_read = _pgm_rxw_incoming_read_apdu (window, cursor, window->commit_lead);
+				if (apdu_read >= 0) {
+					bytes_read += apdu_read;
+					data_read  ++;
+				}
+			}
+			if (window->is_unordered)
+				_pgm_rxw_skip_committed (window);
 		}
 		else
 		{
 			break;
 		}
-	} while (*pmsg <= msg_end && !_pgm_rxw_incoming_is_empty (window));
+	} while (!pgm_rxw_cursor_is_full (cursor) && !_pgm_rxw_incoming_is_empty (window));
 
 	window->bytes_delivered += bytes_read;
 	window->msgs_delivered  += data_read;
@@ -1399,69 +2790,110 @@ _pgm_rxw_is_tg_sqn_lost (
 	return FALSE;
 }
 
-/* reconstruct missing sequences in a transmission group using embedded parity data.
+/* gather the transmission group of tg_sqn for decoding: original data padded
+ * to the parity length, a zeroed packet for each missing sequence and the
+ * parity packets standing in for them.  original and parity packets are
+ * referenced by the job such that it survives the window moving on.
  */
 
 static
 void
-_pgm_rxw_reconstruct (
-	pgm_rxw_t* const	window,
-	const uint32_t		tg_sqn		/* transmission group sequence */
+_pgm_rxw_reconstruct_prepare (
+	pgm_rxw_t*		const restrict window,
+	const uint32_t			       tg_sqn,		/* transmission group sequence */
+	struct pgm_decode_job_t* const restrict job
 	)
 {
-	struct pgm_sk_buff_t	*skb;
+	struct pgm_sk_buff_t	*skb, *parity_skb = NULL;
 	pgm_rxw_state_t		*state;
-	struct pgm_sk_buff_t   **tg_skbs;
-	pgm_gf8_t	       **tg_data, **tg_opts;
-	uint8_t			*offsets;
 	uint8_t			 rs_h = 0;
 
 /* pre-conditions */
 	pgm_assert (NULL != window);
+	pgm_assert (NULL != job);
 	pgm_assert (1 == window->is_fec_available);
 	pgm_assert_cmpuint (_pgm_rxw_pkt_sqn (window, tg_sqn), ==, 0);
 
-/* use stack memory */
-	tg_skbs = pgm_newa (struct pgm_sk_buff_t*, window->rs.n);
-	tg_data = pgm_newa (pgm_gf8_t*, window->rs.n);
-	tg_opts = pgm_newa (pgm_gf8_t*, window->rs.n);
-	offsets = pgm_newa (uint8_t, window->rs.k);
-
-	skb = _pgm_rxw_peek (window, tg_sqn);
-	pgm_assert (NULL != skb);
-
-	const bool is_var_pktlen = skb->pgm_header->pgm_options & PGM_OPT_VAR_PKTLEN;
-	const bool is_op_encoded = skb->pgm_header->pgm_options & PGM_OPT_PRESENT;
-	const uint16_t parity_length = pgm_ntohs (skb->pgm_header->pgm_tsdu_length);
+/* parity packets define the encoded length and options */
+	for (uint32_t i = tg_sqn; i != (tg_sqn + window->rs.k); i++)
+	{
+		skb = _pgm_rxw_peek (window, i);
+		if (NULL == skb)
+			continue;
+		state = (pgm_rxw_state_t*)&skb->cb;
+		if (PGM_PKT_STATE_HAVE_PARITY == state->pkt_state) {
+			parity_skb = skb;
+			break;
+		}
+	}
+	pgm_assert (NULL != parity_skb);
+
+	const bool is_var_pktlen = parity_skb->pgm_header->pgm_options & PGM_OPT_VAR_PKTLEN;
+	const bool is_op_encoded = (NULL != parity_skb->pgm_opt_fragment);
+	const uint16_t parity_length = pgm_ntohs (parity_skb->pgm_header->pgm_tsdu_length);
+	const uint32_t tg_size = _pgm_rxw_parity_tg_size (window, parity_skb);
+
+	job->tg_sqn		= tg_sqn;
+	job->n			= window->rs.n;
+	job->k			= window->rs.k;
+	job->parity_length	= parity_length;
+	job->is_var_pktlen	= is_var_pktlen;
+	job->is_op_encoded	= is_op_encoded;
+	job->is_done		= 0;
+	job->ready		= NULL;
+
+/* original data without a fragment header encoded as a null option */
+	memset (&job->null_opt_fragment, 0, sizeof(job->null_opt_fragment));
+	*(uint8_t*)&job->null_opt_fragment |= PGM_OP_ENCODED_NULL;
 
 	for (uint32_t i = tg_sqn, j = 0; i != (tg_sqn + window->rs.k); i++, j++)
 	{
+/* beyond a partial group the source encoded zero length packets */
+		if (j >= tg_size) {
+			skb = pgm_skb_pool_alloc (window->skb_pool, window->max_tpdu);
+			pgm_skb_put (skb, parity_length);
+			memset (skb->data, 0, parity_length);
+			skb->zero_padded = 1;
+			job->skbs[ j ] = skb;
+			job->data[ j ] = skb->data;
+			job->opts[ j ] = (pgm_gf8_t*)&job->null_opt_fragment;
+			job->offsets[ j ] = j;
+			continue;
+		}
+
 		skb = _pgm_rxw_peek (window, i);
-		pgm_assert (NULL != skb);
-		state = (pgm_rxw_state_t*)&skb->cb;
-		switch (state->pkt_state) {
+		switch (_pgm_rxw_pkt_state (window, i)) {
 		case PGM_PKT_STATE_HAVE_DATA:
-			tg_skbs[ j ] = skb;
-			tg_data[ j ] = skb->data;
-			tg_opts[ j ] = (pgm_gf8_t*)skb->pgm_opt_fragment;
-			offsets[ j ] = j;
+		case PGM_PKT_STATE_COMMIT_DATA:
+			job->skbs[ j ] = pgm_skb_get (skb);
+			job->data[ j ] = skb->data;
+			job->opts[ j ] = skb->pgm_opt_fragment ? (pgm_gf8_t*)skb->pgm_opt_fragment : (pgm_gf8_t*)&job->null_opt_fragment;
+			job->offsets[ j ] = j;
 			break;
 
 		case PGM_PKT_STATE_HAVE_PARITY:
-			tg_skbs[ window->rs.k + rs_h ] = skb;
-			tg_data[ window->rs.k + rs_h ] = skb->data;
-			tg_opts[ window->rs.k + rs_h ] = (pgm_gf8_t*)skb->pgm_opt_fragment;
-			offsets[ j ] = window->rs.k + rs_h;
+			job->skbs[ window->rs.k + rs_h ] = pgm_skb_get (skb);
+			job->data[ window->rs.k + rs_h ] = skb->data;
+			job->opts[ window->rs.k + rs_h ] = skb->pgm_opt_fragment ? (pgm_gf8_t*)skb->pgm_opt_fragment : (pgm_gf8_t*)&job->null_opt_fragment;
+/* generator row from parity packet number of the original sequence */
+			job->offsets[ j ] = window->rs.k + _pgm_rxw_pkt_sqn (window, pgm_ntohl (skb->pgm_data->data_sqn));
 			++rs_h;
 /* fall through and alloc new skb for reconstructed data */
 		case PGM_PKT_STATE_BACK_OFF:
 		case PGM_PKT_STATE_WAIT_NCF:
 		case PGM_PKT_STATE_WAIT_DATA:
 		case PGM_PKT_STATE_LOST_DATA:
-			skb = pgm_alloc_skb (window->max_tpdu);
+			skb = pgm_skb_pool_alloc (window->skb_pool, window->max_tpdu);
+			skb->tstamp   = parity_skb->tstamp;
+			skb->sequence = i;
+			memcpy (&skb->tsi, &parity_skb->tsi, sizeof(pgm_tsi_t));
 			pgm_skb_reserve (skb, sizeof(struct pgm_header) + sizeof(struct pgm_data));
 			skb->pgm_header = skb->head;
 			skb->pgm_data = (void*)( skb->pgm_header + 1 );
+			memcpy (skb->pgm_header, parity_skb->pgm_header, sizeof(struct pgm_header));
+			skb->pgm_header->pgm_options = is_op_encoded ? PGM_OPT_PRESENT : 0;
+			skb->pgm_data->data_sqn   = pgm_htonl (i);
+			skb->pgm_data->data_trail = parity_skb->pgm_data->data_trail;
 			if (is_op_encoded) {
 				const uint16_t opt_total_length = sizeof(struct pgm_opt_length) +
 								 sizeof(struct pgm_opt_header) +
@@ -1474,69 +2906,290 @@ _pgm_rxw_reconstruct (
 				pgm_skb_put (skb, parity_length);
 				memset (skb->data, 0, parity_length);
 			}
-			tg_skbs[ j ] = skb;
-			tg_data[ j ] = skb->data;
-			tg_opts[ j ] = (void*)skb->pgm_opt_fragment;
+			skb->zero_padded = 1;
+			job->skbs[ j ] = skb;
+			job->data[ j ] = skb->data;
+			job->opts[ j ] = (void*)skb->pgm_opt_fragment;
 			break;
 
 		default: pgm_assert_not_reached(); break;
 		}
 
+/* original data is zero padded to the parity length, with the true length
+ * appended for variable sized packets.
+ */
 		if (!skb->zero_padded) {
-			memset (skb->tail, 0, parity_length - skb->len);
+			if (is_var_pktlen) {
+				memset (skb->tail, 0, parity_length - sizeof(uint16_t) - skb->len);
+				*(uint16_t*)((char*)skb->data + parity_length - sizeof(uint16_t)) = (uint16_t)skb->len;
+			} else {
+				memset (skb->tail, 0, parity_length - skb->len);
+			}
 			skb->zero_padded = 1;
 		}
-
 	}
+	job->rs_h = rs_h;
+}
 
-/* reconstruct payload */
-	pgm_rs_decode_parity_appended (&window->rs,
-				       tg_data,
-				       offsets,
-				       parity_length);
+/* swap parity packets with the reconstructed packets of a decoded job and
+ * release the references of the job.  a job decoded by a decoder thread may
+ * find the window moved on or repair data received meanwhile, such packets
+ * are discarded.
+ */
 
-/* reconstruct opt_fragment option */
-	if (is_op_encoded)
-		pgm_rs_decode_parity_appended (&window->rs,
-					       tg_opts,
-					       offsets,
-					       sizeof(struct pgm_opt_fragment));
+static
+void
+_pgm_rxw_reconstruct_finish (
+	pgm_rxw_t*		const restrict window,
+	struct pgm_decode_job_t* const restrict job,
+	const bool			       is_async
+	)
+{
+	bool is_discarded = FALSE;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != job);
 
-/* swap parity skbs with reconstructed skbs */
-	for (uint_fast8_t i = 0; i < window->rs.k; i++)
+	for (uint_fast8_t i = 0; i < job->k; i++)
 	{
-		struct pgm_sk_buff_t* repair_skb;
+		struct pgm_sk_buff_t* repair_skb = job->skbs[i];
 
-		if (offsets[i] < window->rs.k)
+		if (job->offsets[i] < job->k) {
+			pgm_free_skb (repair_skb);		/* original data */
 			continue;
+		}
 
-		repair_skb = tg_skbs[i];
+		if (is_discarded) {
+			pgm_free_skb (repair_skb);
+			continue;
+		}
 
-		if (is_var_pktlen)
+		if (job->is_var_pktlen)
 		{
 			const uint16_t pktlen = *(uint16_t*)( (char*)repair_skb->tail - sizeof(uint16_t));
-			if (pktlen > parity_length) {
+			if (pktlen > job->parity_length - sizeof(uint16_t)) {
 				pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Invalid encoded variable packet length in reconstructed packet, dropping entire transmission group."));
 				pgm_free_skb (repair_skb);
-				for (uint_fast8_t j = i; j < window->rs.k; j++)
-				{
-					if (offsets[j] < window->rs.k)
-						continue;
-					pgm_rxw_lost (window, tg_skbs[offsets[j]]->sequence);
+				if (!is_async) {
+					for (uint_fast8_t j = i; j < job->k; j++)
+						if (job->offsets[j] >= job->k)
+							pgm_rxw_lost (window, job->tg_sqn + j);
 				}
-				break;
+				is_discarded = TRUE;
+				continue;
 			}
-			const uint16_t padding = parity_length - pktlen;
+			const uint16_t padding = job->parity_length - pktlen;
 			repair_skb->len -= padding;
 			repair_skb->tail = (char*)repair_skb->tail - padding;
 		}
-
+		repair_skb->pgm_header->pgm_tsdu_length = pgm_htons (repair_skb->len);
+
+		if (is_async) {
+			const uint32_t sequence = repair_skb->sequence;
+			if (pgm_uint32_gte (sequence, window->commit_lead) &&
+			    pgm_uint32_lte (sequence, window->lead) &&
+			    PGM_RXW_INSERTED == _pgm_rxw_insert (window, repair_skb))
+				window->has_event = 1;
+			else
+				pgm_free_skb (repair_skb);
+			continue;
+		}
 #ifdef PGM_DISABLE_ASSERT
 		_pgm_rxw_insert (window, repair_skb);
 #else
 		pgm_assert_cmpint (_pgm_rxw_insert (window, repair_skb), ==, PGM_RXW_INSERTED);
 #endif
 	}
+
+/* parity packets */
+	for (uint_fast8_t h = 0; h < job->rs_h; h++)
+		pgm_free_skb (job->skbs[ job->k + h ]);
+}
+
+/* reconstruct missing sequences in a transmission group using embedded parity
+ * data, on a decoder thread when the socket has them.
+ */
+
+static
+void
+_pgm_rxw_reconstruct (
+	pgm_rxw_t* const	window,
+	const uint32_t		tg_sqn		/* transmission group sequence */
+	)
+{
+	struct pgm_decode_job_t* job;
+	const bool is_async = (NULL != window->decode_pool &&
+			       window->decode_queue.length < PGM_DECODE_WINDOW_MAX);
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (1 == window->is_fec_available);
+
+	if (is_async)
+	{
+		job = pgm_new (struct pgm_decode_job_t, 1);
+		_pgm_rxw_reconstruct_prepare (window, tg_sqn, job);
+		job->ready = window->decode_ready;
+		if (pgm_decode_pool_submit (window->decode_pool, job, (uintptr_t)window / sizeof(pgm_rxw_t))) {
+			pgm_queue_push_head_link (&window->decode_queue, &job->link_);
+			return;
+		}
+	}
+	else
+	{
+/* use stack memory, decoded inline */
+		job = pgm_newa (struct pgm_decode_job_t, 1);
+		_pgm_rxw_reconstruct_prepare (window, tg_sqn, job);
+	}
+
+/* reconstruct payload */
+	pgm_rs_decode_parity_appended (&window->rs,
+				       job->data,
+				       job->offsets,
+				       job->parity_length);
+
+/* reconstruct opt_fragment option */
+	if (job->is_op_encoded)
+		pgm_rs_decode_parity_appended (&window->rs,
+					       job->opts,
+					       job->offsets,
+					       sizeof(struct pgm_opt_fragment));
+
+	_pgm_rxw_reconstruct_finish (window, job, FALSE);
+	if (is_async)
+		pgm_free (job);		/* decoder threads are full */
+}
+
+/* insert the reconstructed packets of transmission groups decoded by the
+ * decoder threads, in submission order and stopping at the first group still
+ * being decoded.
+ *
+ * returns number of transmission groups collected.
+ */
+
+PGM_GNUC_INTERNAL
+unsigned
+pgm_rxw_decode_collect (
+	pgm_rxw_t* const	window
+	)
+{
+	unsigned count = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+
+	while (!pgm_queue_is_empty (&window->decode_queue))
+	{
+		struct pgm_decode_job_t* job = (struct pgm_decode_job_t*)pgm_queue_peek_tail_link (&window->decode_queue);
+		if (0 == pgm_atomic_read32 (&job->is_done))
+			break;
+		pgm_queue_pop_tail_link (&window->decode_queue);
+		_pgm_rxw_reconstruct_finish (window, job, TRUE);
+		pgm_free (job);
+		count++;
+	}
+	return count;
+}
+
+/* wait for the transmission groups of the window still being decoded and
+ * release them without inserting their reconstructed packets.
+ */
+
+static
+void
+_pgm_rxw_decode_release (
+	pgm_rxw_t* const	window
+	)
+{
+	while (!pgm_queue_is_empty (&window->decode_queue))
+	{
+		struct pgm_decode_job_t* job = (struct pgm_decode_job_t*)pgm_queue_peek_tail_link (&window->decode_queue);
+		if (0 == pgm_atomic_read32 (&job->is_done)) {
+			pgm_thread_yield ();
+			continue;
+		}
+		pgm_queue_pop_tail_link (&window->decode_queue);
+		for (unsigned i = 0; i < (unsigned)job->k + job->rs_h; i++)
+			pgm_free_skb (job->skbs[i]);
+		pgm_free (job);
+	}
+}
+
+/* reconstruct the transmission group of sequence when every packet of the
+ * group, or of the partial group covered by its parity, is either original
+ * data or a parity packet standing in for it.
+ *
+ * returns TRUE if missing packets have been recovered.
+ */
+
+static
+bool
+_pgm_rxw_try_reconstruct (
+	pgm_rxw_t* const	window,
+	const uint32_t		sequence
+	)
+{
+	const struct pgm_sk_buff_t* skb;
+	const pgm_rxw_state_t* state;
+	unsigned parity_count = 0;
+	uint32_t tg_size = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+
+	if (!window->is_fec_available || 0 == window->parity_count)
+		return FALSE;
+
+	const uint32_t tg_sqn = _pgm_rxw_tg_sqn (window, sequence);
+	if (_pgm_rxw_is_tg_sqn_lost (window, tg_sqn))
+		return FALSE;
+
+/* already on a decoder thread */
+	for (const pgm_list_t* link = window->decode_queue.head; NULL != link; link = link->next)
+		if (((const struct pgm_decode_job_t*)link)->tg_sqn == tg_sqn)
+			return FALSE;
+
+/* parity of a partial group and of the whole group cannot be decoded together */
+	for (uint32_t i = tg_sqn, j = 0; j < window->tg_size; i++, j++)
+	{
+		skb = _pgm_rxw_peek (window, i);
+		if (NULL == skb)
+			break;
+		state = (const pgm_rxw_state_t*)&skb->cb;
+		if (PGM_PKT_STATE_HAVE_PARITY != state->pkt_state)
+			continue;
+		if (0 != tg_size && tg_size != _pgm_rxw_parity_tg_size (window, skb))
+			return FALSE;
+		tg_size = _pgm_rxw_parity_tg_size (window, skb);
+	}
+	if (0 == tg_size)
+		return FALSE;
+
+	for (uint32_t i = tg_sqn, j = 0; j < tg_size; i++, j++)
+	{
+		skb = _pgm_rxw_peek (window, i);
+		if (NULL == skb)
+			return FALSE;
+		state = (const pgm_rxw_state_t*)&skb->cb;
+		switch (state->pkt_state) {
+		case PGM_PKT_STATE_HAVE_PARITY:
+			parity_count++;
+/* fall through */
+		case PGM_PKT_STATE_HAVE_DATA:
+		case PGM_PKT_STATE_COMMIT_DATA:
+			break;
+
+		default:
+			return FALSE;
+		}
+	}
+
+	if (0 == parity_count)
+		return FALSE;
+
+	_pgm_rxw_reconstruct (window, tg_sqn);
+	return TRUE;
 }
 
 /* check every TPDU in an APDU and verify that the data has arrived
@@ -1562,9 +3215,10 @@ _pgm_rxw_is_apdu_complete (
 	)
 {
 	struct pgm_sk_buff_t	*skb;
+	pgm_rxw_state_t		*state;
+	uint32_t		 sequence;
 	unsigned		 contiguous_tpdus = 0;
 	size_t			 contiguous_size = 0;
-	bool			 check_parity = FALSE;
 
 /* pre-conditions */
 	pgm_assert (NULL != window);
@@ -1574,11 +3228,14 @@ _pgm_rxw_is_apdu_complete (
 
 	skb = _pgm_rxw_peek (window, first_sequence);
 	if (PGM_UNLIKELY(NULL == skb)) {
+/* first sequence missing, may be recoverable from parity */
+		if (_pgm_rxw_is_in_window (window, first_sequence) &&
+		    _pgm_rxw_try_reconstruct (window, first_sequence))
+			return _pgm_rxw_is_apdu_complete (window, first_sequence);
 		return FALSE;
 	}
 
 	const size_t apdu_size = skb->pgm_opt_fragment ? pgm_ntohl (skb->of_apdu_len) : skb->len;
-	const uint32_t  tg_sqn = _pgm_rxw_tg_sqn (window, first_sequence);
 
 	pgm_assert_cmpuint (apdu_size, >=, skb->len);
 
@@ -1588,127 +3245,352 @@ _pgm_rxw_is_apdu_complete (
 		return FALSE;
 	}
 
-	for (uint32_t sequence = first_sequence;
-	     skb;
+/* resume after the fragments verified by an earlier call, each fragment of the
+ * APDU is then visited once however often completeness is asked.
+ */
+	state = (pgm_rxw_state_t*)&skb->cb;
+	sequence = first_sequence;
+	if (PGM_PKT_STATE_HAVE_DATA == state->pkt_state && state->apdu_tpdus > 0) {
+		contiguous_tpdus = state->apdu_tpdus;
+		contiguous_size  = state->apdu_size;
+		sequence += contiguous_tpdus;
+		skb = _pgm_rxw_peek (window, sequence);
+	}
+
+	for (;
+	     _pgm_rxw_is_in_window (window, sequence);
 	     skb = _pgm_rxw_peek (window, ++sequence))
 	{
-		pgm_rxw_state_t* state = (pgm_rxw_state_t*)&skb->cb;
-
-		if (!check_parity &&
-		    PGM_PKT_STATE_HAVE_DATA != state->pkt_state)
-		{
-			if (window->is_fec_available &&
-			    !_pgm_rxw_is_tg_sqn_lost (window, tg_sqn) )
-			{
-				check_parity = TRUE;
-/* pre-seed committed sequence count */
-				if (pgm_uint32_lte (tg_sqn, window->commit_lead))
-					contiguous_tpdus += window->commit_lead - tg_sqn;
-			}
-			else
-			{
-				return FALSE;
-			}
-		}
-
-		if (check_parity)
+		if (NULL == skb ||
+		    PGM_PKT_STATE_HAVE_DATA != ((const pgm_rxw_state_t*)&skb->cb)->pkt_state)
 		{
-			if (PGM_PKT_STATE_HAVE_DATA == state->pkt_state ||
-			    PGM_PKT_STATE_HAVE_PARITY == state->pkt_state)
-				++contiguous_tpdus;
-
 /* have sufficient been received for reconstruction */
-			if (contiguous_tpdus >= window->tg_size) {
-				_pgm_rxw_reconstruct (window, tg_sqn);
+			if (_pgm_rxw_try_reconstruct (window, sequence))
 				return _pgm_rxw_is_apdu_complete (window, first_sequence);
-			}
+			return FALSE;
 		}
-		else
-		{
+
 /* single packet APDU, already complete */
-			if (PGM_PKT_STATE_HAVE_DATA == state->pkt_state &&
-			    !skb->pgm_opt_fragment)
-				return TRUE;
+		if (!skb->pgm_opt_fragment)
+			return TRUE;
 
 /* protocol sanity check: matching first sequence reference */
-			if (PGM_UNLIKELY(pgm_ntohl (skb->of_apdu_first_sqn) != first_sequence)) {
-				pgm_rxw_lost (window, first_sequence);
-				return FALSE;
-			}
+		if (PGM_UNLIKELY(pgm_ntohl (skb->of_apdu_first_sqn) != first_sequence)) {
+			pgm_rxw_lost (window, first_sequence);
+			return FALSE;
+		}
 
 /* protocol sanity check: matching apdu length */
-			if (PGM_UNLIKELY(pgm_ntohl (skb->of_apdu_len) != apdu_size)) {
-				pgm_rxw_lost (window, first_sequence);
-				return FALSE;
-			}
+		if (PGM_UNLIKELY(pgm_ntohl (skb->of_apdu_len) != apdu_size)) {
+			pgm_rxw_lost (window, first_sequence);
+			return FALSE;
+		}
 
 /* protocol sanity check: maximum number of fragments per apdu */
-			if (PGM_UNLIKELY(++contiguous_tpdus > PGM_MAX_FRAGMENTS)) {
-				pgm_rxw_lost (window, first_sequence);
-				return FALSE;
-			}
+		if (PGM_UNLIKELY(++contiguous_tpdus > PGM_MAX_FRAGMENTS)) {
+			pgm_rxw_lost (window, first_sequence);
+			return FALSE;
+		}
 
-			contiguous_size += skb->len;
-			if (apdu_size == contiguous_size)
-				return TRUE;
-			else if (PGM_UNLIKELY(apdu_size < contiguous_size)) {
-				pgm_rxw_lost (window, first_sequence);
-				return FALSE;
-			}
+		contiguous_size += skb->len;
+		if (apdu_size == contiguous_size)
+			return TRUE;
+		else if (PGM_UNLIKELY(apdu_size < contiguous_size)) {
+			pgm_rxw_lost (window, first_sequence);
+			return FALSE;
 		}
+		state->apdu_tpdus = contiguous_tpdus;
+		state->apdu_size  = (uint32_t)contiguous_size;
 	}
 
 /* pending */
 	return FALSE;
 }
 
-/* read one APDU consisting of one or more TPDUs.  target array is guaranteed
- * to be big enough to store complete APDU.
+/* read one APDU consisting of one or more TPDUs starting at first_sequence,
+ * the commit lead or with unordered delivery any sequence beyond.  target
+ * array is guaranteed to be big enough to store complete APDU.  a compressed
+ * APDU that cannot be decompressed is committed unread as lost.
+ *
+ * returns count of bytes read, or -1 on nothing read.
  */
 
 static inline
 ssize_t
 _pgm_rxw_incoming_read_apdu (
-	pgm_rxw_t*    const restrict window,
-	struct pgm_msgv_t** restrict pmsg		/* message array, updated as messages appended */
+	pgm_rxw_t*	   const restrict window,
+	pgm_rxw_cursor_t*  const restrict cursor,	/* updated as messages appended */
+	const uint32_t			  first_sequence
 	)
 {
-	struct pgm_sk_buff_t *skb;
+	struct pgm_sk_buff_t *skb, *apdu = NULL;
 	size_t		      contiguous_len = 0;
-	unsigned	      count = 0;
+	uint32_t	      sequence = first_sequence;
 
 /* pre-conditions */
 	pgm_assert (NULL != window);
-	pgm_assert (NULL != pmsg);
+	pgm_assert (NULL != cursor);
+	pgm_assert (first_sequence == window->commit_lead || window->is_unordered);
 
-	pgm_debug ("_pgm_rxw_incoming_read_apdu (window:%p pmsg:%p)",
-		(const void*)window, (const void*)pmsg);
+	pgm_debug ("_pgm_rxw_incoming_read_apdu (window:%p cursor:%p first-sequence:%" PRIu32 ")",
+		(const void*)window, (const void*)cursor, first_sequence);
 
-	skb = _pgm_rxw_peek (window, window->commit_lead);
+	skb = _pgm_rxw_peek (window, first_sequence);
 	pgm_assert (NULL != skb);
 
 	const size_t apdu_len = skb->pgm_opt_fragment ? pgm_ntohl (skb->of_apdu_len) : skb->len;
+	const bool is_compressed = skb->compressed;
 	pgm_assert_cmpuint (apdu_len, >=, skb->len);
 
+/* a fully reassembled copy replaces the fragments as one packet */
+	if ((window->reasm_min || is_compressed) && skb->pgm_opt_fragment) {
+		apdu = _pgm_rxw_reasm_take (window, first_sequence);
+		if (NULL != apdu && apdu->len != apdu_len) {
+			pgm_queue_push_head_link (&window->reasm_commit_queue, (pgm_list_t*)apdu);
+			apdu = NULL;
+		}
+	}
+
+/* as does the decompressed copy of a compressed APDU */
+	if (is_compressed)
+		apdu = _pgm_rxw_inflate (window, skb, apdu);
+
 	do {
 		_pgm_rxw_state (window, skb, PGM_PKT_STATE_COMMIT_DATA);
-		(*pmsg)->msgv_skb[ count++ ] = skb;
+		if (NULL == apdu && !is_compressed)
+			pgm_rxw_cursor_append (cursor, skb);
 		contiguous_len += skb->len;
-		window->commit_lead++;
+		sequence++;
 		if (apdu_len == contiguous_len)
 			break;
-		skb = _pgm_rxw_peek (window, window->commit_lead);
+		skb = _pgm_rxw_peek (window, sequence);
 	} while (apdu_len > contiguous_len);
 
-	(*pmsg)->msgv_len = count;
-	(*pmsg)++;
+	if (NULL != apdu) {
+		skb = _pgm_rxw_peek (window, first_sequence);
+		apdu->tstamp	= skb->tstamp;
+		apdu->rx_tstamp	= skb->rx_tstamp;
+		pgm_rxw_cursor_append (cursor, apdu);
+		pgm_queue_push_head_link (&window->reasm_commit_queue, (pgm_list_t*)apdu);
+		if (is_compressed) {
+			window->cumulative_inflated++;
+			contiguous_len = apdu->len;
+		} else
+			window->cumulative_reassembled++;
+	}
 
+	if (first_sequence == window->commit_lead) {
+		window->commit_lead = sequence;
 /* post-conditions */
-	pgm_assert (!_pgm_rxw_commit_is_empty (window));
+		pgm_assert (!_pgm_rxw_commit_is_empty (window));
+	}
+
+	if (PGM_UNLIKELY(is_compressed && NULL == apdu)) {
+		window->cumulative_losses++;
+		pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Data loss due to undecodable compressed APDU #%" PRIu32 "."), first_sequence);
+		return -1;
+	}
 
+	pgm_rxw_cursor_next (cursor);
+	PGM_PROBE3 (apdu_deliver, window, first_sequence, contiguous_len);
 	return contiguous_len;
 }
 
+/* returns the body of the first option of opt_type in a TPDU, or NULL if none.
+ */
+
+static
+const void*
+_pgm_rxw_opt (
+	const struct pgm_sk_buff_t* const skb,
+	const uint8_t			  opt_type
+	)
+{
+	const struct pgm_opt_header* opt_header = (const struct pgm_opt_header*)(skb->pgm_data + 1);
+
+/* first option is always opt_length */
+	do {
+		opt_header = (const struct pgm_opt_header*)((const char*)opt_header + opt_header->opt_length);
+		if (PGM_UNLIKELY((const char*)opt_header >= (const char*)skb->data))
+			return NULL;
+		if (opt_type == (opt_header->opt_type & PGM_OPT_MASK))
+			return opt_header + 1;
+	} while (!(opt_header->opt_type & PGM_OPT_END));
+	return NULL;
+}
+
+/* decompress the APDU of first skb into a buffer from the pool of its size
+ * class, from the payload of a single TPDU or the reassembled fragments,
+ * which are released with the next commit.
+ *
+ * returns the decompressed APDU, or NULL on an undecodable APDU.
+ */
+
+static
+struct pgm_sk_buff_t*
+_pgm_rxw_inflate (
+	pgm_rxw_t*		    const restrict window,
+	const struct pgm_sk_buff_t* const restrict skb,		/* first TPDU */
+	struct pgm_sk_buff_t*	    const restrict reasm	/* reassembled fragments, optional */
+	)
+{
+	const struct pgm_opt_compress* opt_compress;
+	const struct pgm_sk_buff_t* block = skb;
+	struct pgm_sk_buff_t* apdu;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != skb);
+	pgm_assert (skb->compressed);
+
+	if (NULL != reasm) {
+		pgm_queue_push_head_link (&window->reasm_commit_queue, (pgm_list_t*)reasm);
+		block = reasm;
+	} else if (NULL != skb->pgm_opt_fragment)
+		return NULL;
+
+	opt_compress = _pgm_rxw_opt (skb, PGM_OPT_COMPRESS);
+	if (PGM_UNLIKELY(NULL == opt_compress))
+		return NULL;
+	const uint32_t apdu_len = pgm_ntohl (opt_compress->opt_apdu_len);
+	if (PGM_UNLIKELY(0 == apdu_len || apdu_len > PGM_MAX_APDU))
+		return NULL;
+
+	apdu = pgm_skb_pool_alloc (_pgm_rxw_class_pool (window->inflate_pool, apdu_len), (uint16_t)apdu_len);
+	if (PGM_UNLIKELY(!pgm_decompress (block->data, block->len, apdu->data, apdu_len))) {
+		pgm_free_skb (apdu);
+		return NULL;
+	}
+	apdu->sock	= skb->sock;
+	memcpy (&apdu->tsi, &skb->tsi, sizeof(pgm_tsi_t));
+	apdu->sequence	= skb->sequence;
+	apdu->tail	= (char*)apdu->data + apdu_len;
+	apdu->len	= (uint16_t)apdu_len;
+	pgm_mem_budget_charge (window->budget, apdu->truesize);
+	return apdu;
+}
+
+/* returns TRUE if the payload of a coalesced TPDU is a non-empty sequence of
+ * length prefixed APDUs ending at the end of the payload.
+ */
+
+static
+bool
+_pgm_rxw_is_coalesce_valid (
+	const struct pgm_sk_buff_t* const skb
+	)
+{
+	const char* frame = (const char*)skb->data;
+	const char* end   = frame + skb->len;
+	uint16_t    apdu_len;
+
+	if (PGM_UNLIKELY(frame == end))
+		return FALSE;
+	while (frame < end) {
+		if (PGM_UNLIKELY(end - frame < (ptrdiff_t)sizeof(apdu_len)))
+			return FALSE;
+		memcpy (&apdu_len, frame, sizeof(apdu_len));
+		frame += sizeof(apdu_len) + pgm_ntohs (apdu_len);
+	}
+	return (frame == end);
+}
+
+/* returns a record skb valid until the next pgm_rxw_remove_commit().
+ */
+
+static
+struct pgm_sk_buff_t*
+_pgm_rxw_record_alloc (
+	pgm_rxw_t* const	window
+	)
+{
+	struct pgm_rxw_records_t* records = window->records_tail;
+
+	if (NULL == records) {
+		if (NULL == window->records)
+			window->records = pgm_mem_slab_alloc0 (window->slab, sizeof(struct pgm_rxw_records_t));
+		records = window->records_tail = window->records;
+	} else if (PGM_RXW_RECORDS_LEN == records->len) {
+		if (NULL == records->next)
+			records->next = pgm_mem_slab_alloc0 (window->slab, sizeof(struct pgm_rxw_records_t));
+		records = window->records_tail = records->next;
+	}
+	return &records->skb[ records->len++ ];
+}
+
+/* read the APDUs of one coalesced TPDU as one message each, each message an
+ * skb referencing the payload of the TPDU.  a TPDU with more APDUs than
+ * messages remaining is resumed on the next read.
+ */
+
+static inline
+ssize_t
+_pgm_rxw_incoming_read_records (
+	pgm_rxw_t*	   const restrict window,
+	pgm_rxw_cursor_t*  const restrict cursor,	/* updated as messages appended */
+	size_t*			 restrict data_read	/* added to, not set */
+	)
+{
+	struct pgm_sk_buff_t *skb;
+	size_t		      records_len = 0;
+	uint_fast16_t	      offset;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != cursor);
+	pgm_assert (!pgm_rxw_cursor_is_full (cursor));
+	pgm_assert (NULL != data_read);
+
+	pgm_debug ("_pgm_rxw_incoming_read_records (window:%p cursor:%p data-read:%p)",
+		(const void*)window, (const void*)cursor, (const void*)data_read);
+
+	skb = _pgm_rxw_peek (window, window->commit_lead);
+	pgm_assert (NULL != skb);
+	pgm_assert (skb->coalesced);
+
+	offset = (window->coalesce_offset && skb->sequence == window->coalesce_sqn) ? window->coalesce_offset : 0;
+	while (!pgm_rxw_cursor_is_full (cursor) && offset < skb->len)
+	{
+		const char* frame = (const char*)skb->data + offset;
+		struct pgm_sk_buff_t* record;
+		uint16_t apdu_len;
+
+		memcpy (&apdu_len, frame, sizeof(apdu_len));
+		apdu_len = pgm_ntohs (apdu_len);
+
+		record = _pgm_rxw_record_alloc (window);
+		memset (record, 0, sizeof(struct pgm_sk_buff_t));
+		record->sock		= skb->sock;
+		record->tstamp		= skb->tstamp;
+		memcpy (&record->tsi, &skb->tsi, sizeof(pgm_tsi_t));
+		record->sequence	= skb->sequence;
+		record->pgm_header	= skb->pgm_header;
+		record->pgm_data	= skb->pgm_data;
+		record->head		= skb->head;
+		record->data		= (char*)frame + sizeof(apdu_len);
+		record->tail = record->end = (char*)record->data + apdu_len;
+		record->len		= apdu_len;
+		pgm_atomic_write32 (&record->users, 1);
+
+		pgm_rxw_cursor_append (cursor, record);
+		pgm_rxw_cursor_next (cursor);
+		PGM_PROBE3 (apdu_deliver, window, skb->sequence, apdu_len);
+		(*data_read)++;
+		records_len += apdu_len;
+		offset += sizeof(apdu_len) + apdu_len;
+	}
+
+	if (offset == skb->len) {
+		_pgm_rxw_state (window, skb, PGM_PKT_STATE_COMMIT_DATA);
+		window->commit_lead++;
+		window->coalesce_offset = 0;
+	} else {
+		window->coalesce_sqn	= skb->sequence;
+		window->coalesce_offset	= (uint16_t)offset;
+	}
+	return records_len;
+}
+
 /* returns transmission group sequence (TG_SQN) from sequence (SQN).
  */
 
@@ -1775,6 +3657,63 @@ _pgm_rxw_is_last_of_tg_sqn (
 	return _pgm_rxw_pkt_sqn (window, sequence) == window->tg_size - 1;
 }
 
+/* stamp skb with the time it entered the window, reconstructed data carries
+ * the receive time of its parity packet.
+ */
+
+static inline
+void
+_pgm_rxw_stamp_insert (
+	struct pgm_sk_buff_t* const	skb
+	)
+{
+	pgm_rxw_state_t* state = (pgm_rxw_state_t*)&skb->cb;
+
+	state->insert_tstamp = pgm_time_coarse_now();
+	pgm_latency_record (PGM_LATENCY_RX_INSERT, skb->tstamp, state->insert_tstamp);
+}
+
+/* record the time skb was held by the window as it leaves the trailing edge.
+ */
+
+static inline
+void
+_pgm_rxw_residency_add (
+	pgm_rxw_t*		    const restrict window,
+	const struct pgm_sk_buff_t* const restrict skb,
+	const pgm_time_t			   now
+	)
+{
+	const pgm_rxw_state_t* state = (const pgm_rxw_state_t*)&skb->cb;
+	unsigned bucket = 0;
+
+	if (PGM_UNLIKELY(0 == state->insert_tstamp || pgm_time_after (state->insert_tstamp, now)))
+		return;
+	const uint32_t residency = (uint32_t)MIN(now - state->insert_tstamp, UINT32_MAX);
+	for (uint32_t t = residency; t && bucket < PGM_RXW_RESIDENCY_BUCKETS - 1; t >>= 1)
+		bucket++;
+	window->residency_hist[ bucket ]++;
+	if (residency > window->max_residency)
+		window->max_residency = residency;
+}
+
+/* raise the occupancy high-water marks after an add.
+ */
+
+static inline
+void
+_pgm_rxw_peak_update (
+	pgm_rxw_t* const	window
+	)
+{
+	const uint32_t length = pgm_rxw_length (window);
+
+	if (length > window->peak_length)
+		window->peak_length = length;
+	if (window->size > window->peak_size)
+		window->peak_size = window->size;
+}
+
 /* set PGM skbuff to new FSM state.
  */
 
@@ -1799,21 +3738,11 @@ _pgm_rxw_state (
 		_pgm_rxw_unlink (window, skb);
 
 	switch (new_pkt_state) {
-	case PGM_PKT_STATE_BACK_OFF:
-		pgm_queue_push_head_link (&window->nak_backoff_queue, (pgm_list_t*)skb);
-		break;
-
-	case PGM_PKT_STATE_WAIT_NCF:
-		pgm_queue_push_head_link (&window->wait_ncf_queue, (pgm_list_t*)skb);
-		break;
-
-	case PGM_PKT_STATE_WAIT_DATA:
-		pgm_queue_push_head_link (&window->wait_data_queue, (pgm_list_t*)skb);
-		break;
-
 	case PGM_PKT_STATE_HAVE_DATA:
 		window->fragment_count++;
 		pgm_assert_cmpuint (window->fragment_count, <=, pgm_rxw_length (window));
+		state->apdu_tpdus = 0;
+		state->apdu_size  = 0;
 		break;
 
 	case PGM_PKT_STATE_HAVE_PARITY:
@@ -1824,6 +3753,7 @@ _pgm_rxw_state (
 	case PGM_PKT_STATE_COMMIT_DATA:
 		window->committed_count++;
 		pgm_assert_cmpuint (window->committed_count, <=, pgm_rxw_length (window));
+		pgm_latency_record (PGM_LATENCY_RX_DELIVER, state->insert_tstamp, window->read_tstamp);
 		break;
 
 	case PGM_PKT_STATE_LOST_DATA:
@@ -1842,17 +3772,38 @@ _pgm_rxw_state (
 	state->pkt_state = new_pkt_state;
 }
 
+/* set gap of missing sequences to new FSM state.
+ */
+
 PGM_GNUC_INTERNAL
 void
 pgm_rxw_state (
-	pgm_rxw_t*	      const restrict window,
-	struct pgm_sk_buff_t* const restrict skb,
-	const int			     new_pkt_state
+	pgm_rxw_t*     const restrict window,
+	pgm_rxw_gap_t* const restrict gap,
+	const int		      new_pkt_state
+	)
+{
+	pgm_debug ("state (window:%p gap:%p new_pkt_state:%s)",
+		(const void*)window, (const void*)gap, pgm_pkt_state_string (new_pkt_state));
+	_pgm_rxw_gap_state (window, gap, new_pkt_state);
+}
+
+/* split a gap at sequence for separate recovery of the sequences above.
+ *
+ * returns the new gap starting at sequence.
+ */
+
+PGM_GNUC_INTERNAL
+pgm_rxw_gap_t*
+pgm_rxw_split (
+	pgm_rxw_t*     const restrict window,
+	pgm_rxw_gap_t* const restrict gap,
+	const uint32_t		      sequence
 	)
 {
-	pgm_debug ("state (window:%p skb:%p new_pkt_state:%s)",
-		(const void*)window, (const void*)skb, pgm_pkt_state_string (new_pkt_state));
-	_pgm_rxw_state (window, skb, new_pkt_state);
+	pgm_debug ("split (window:%p gap:%p sequence:%" PRIu32 ")",
+		(const void*)window, (const void*)gap, sequence);
+	return _pgm_rxw_gap_split (window, gap, sequence);
 }
 
 /* remove current state from sequence.
@@ -1866,7 +3817,6 @@ _pgm_rxw_unlink (
 	)
 {
 	pgm_rxw_state_t* state;
-	pgm_queue_t* queue;
 
 /* pre-conditions */
 	pgm_assert (NULL != window);
@@ -1875,23 +3825,6 @@ _pgm_rxw_unlink (
 	state = (pgm_rxw_state_t*)&skb->cb;
 
 	switch (state->pkt_state) {
-	case PGM_PKT_STATE_BACK_OFF:
-		pgm_assert (!pgm_queue_is_empty (&window->nak_backoff_queue));
-		queue = &window->nak_backoff_queue;
-		goto unlink_queue;
-
-	case PGM_PKT_STATE_WAIT_NCF:
-		pgm_assert (!pgm_queue_is_empty (&window->wait_ncf_queue));
-		queue = &window->wait_ncf_queue;
-		goto unlink_queue;
-
-	case PGM_PKT_STATE_WAIT_DATA:
-		pgm_assert (!pgm_queue_is_empty (&window->wait_data_queue));
-		queue = &window->wait_data_queue;
-unlink_queue:
-		pgm_queue_unlink (queue, (pgm_list_t*)skb);
-		break;
-
 	case PGM_PKT_STATE_HAVE_DATA:
 		pgm_assert_cmpuint (window->fragment_count, >, 0);
 		window->fragment_count--;
@@ -1937,6 +3870,100 @@ pgm_rxw_peek (
 	return _pgm_rxw_peek (window, sequence);
 }
 
+/* round-trip time from the first NAK of a missing sequence to a reply, NCF or
+ * RDATA, taken once per NAK.  as Karn's algorithm no sample is taken once the
+ * NAK is repeated, as the reply is ambiguous.
+ *
+ * returns elapsed time, or 0 when no sample is available.
+ */
+
+PGM_GNUC_INTERNAL
+pgm_time_t
+pgm_rxw_nak_rtt (
+	pgm_rxw_t* const	window,
+	const uint32_t		sequence,
+	const pgm_time_t	now
+	)
+{
+	pgm_rxw_gap_t* gap;
+	pgm_time_t rtt;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+
+	if (!window->is_defined ||
+	    pgm_uint32_lt (sequence, window->commit_lead) ||
+	    pgm_uint32_gt (sequence, window->lead) ||
+	    NULL != _pgm_rxw_peek (window, sequence))
+		return 0;
+
+	gap = _pgm_rxw_find_gap (window, sequence);
+	if (0 == gap->nak_tstamp ||
+	    1 != gap->state.nak_transmit_count ||
+	    pgm_time_after (gap->nak_tstamp, now))
+		return 0;
+	rtt = now - gap->nak_tstamp;
+	gap->nak_tstamp = 0;
+	return rtt;
+}
+
+/* declare lost every gap detected at or before deadline whatever its
+ * recovery state, gaps are detected in sequence order so the walk ends at
+ * the first gap within the deadline.
+ *
+ * returns count of sequences marked lost.
+ */
+
+PGM_GNUC_INTERNAL
+uint32_t
+pgm_rxw_expire (
+	pgm_rxw_t* const	window,
+	const pgm_time_t	deadline
+	)
+{
+	uint32_t expired = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+
+	pgm_debug ("expire (window:%p deadline:%" PGM_TIME_FORMAT ")",
+		 (const void*)window, deadline);
+
+	for (pgm_list_t *it = window->gap_queue.tail, *prev; NULL != it; it = prev)
+	{
+		pgm_rxw_gap_t* gap = it->data;
+		prev = it->prev;
+		if (PGM_PKT_STATE_LOST_DATA == gap->state.pkt_state)
+			continue;
+		if (pgm_time_after (gap->tstamp, deadline))
+			break;
+		expired += gap->len;
+		_pgm_rxw_gap_state (window, gap, PGM_PKT_STATE_LOST_DATA);
+	}
+	return expired;
+}
+
+/* returns detection time of the oldest gap still in recovery, or 0 if none.
+ */
+
+PGM_GNUC_INTERNAL
+pgm_time_t
+pgm_rxw_gap_tstamp (
+	const pgm_rxw_t* const	window
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+
+	for (const pgm_list_t* it = window->gap_queue.tail; NULL != it; it = it->prev)
+	{
+		const pgm_rxw_gap_t* gap = it->data;
+		if (PGM_PKT_STATE_LOST_DATA != gap->state.pkt_state)
+			return gap->tstamp;
+	}
+	return 0;
+}
+
 /* mark an existing sequence lost due to failed recovery.
  */
 
@@ -1958,14 +3985,18 @@ pgm_rxw_lost (
 		 (const void*)window, sequence);
 
 	skb = _pgm_rxw_peek (window, sequence);
-	pgm_assert (NULL != skb);
+	if (NULL == skb)
+	{
+		pgm_rxw_gap_t* gap = _pgm_rxw_find_gap (window, sequence);
+		if (PGM_PKT_STATE_LOST_DATA == gap->state.pkt_state)
+			return;
+		_pgm_rxw_gap_state (window, _pgm_rxw_gap_isolate (window, gap, sequence), PGM_PKT_STATE_LOST_DATA);
+		return;
+	}
 
 	state = (pgm_rxw_state_t*)&skb->cb;
 
-	if (PGM_UNLIKELY(!(state->pkt_state == PGM_PKT_STATE_BACK_OFF  ||
-	                 state->pkt_state == PGM_PKT_STATE_WAIT_NCF  ||
-	                 state->pkt_state == PGM_PKT_STATE_WAIT_DATA ||
-			 state->pkt_state == PGM_PKT_STATE_HAVE_DATA ||	/* fragments */
+	if (PGM_UNLIKELY(!(state->pkt_state == PGM_PKT_STATE_HAVE_DATA ||	/* fragments */
 			 state->pkt_state == PGM_PKT_STATE_HAVE_PARITY)))
 	{
 		pgm_fatal (_("Unexpected state %s(%u)"), pgm_pkt_state_string (state->pkt_state), state->pkt_state);
@@ -2039,39 +4070,57 @@ _pgm_rxw_recovery_update (
 	const pgm_time_t	nak_rdata_expiry		/* pre-calculated expiry times */
 	)
 {
-	pgm_rxw_state_t* state;
-	struct pgm_sk_buff_t* skb;
+	pgm_rxw_gap_t* gap;
 
 /* pre-conditions */
 	pgm_assert (NULL != window);
 
-/* fetch skb from window and bump expiration times */
-	skb = _pgm_rxw_peek (window, sequence);
-	pgm_assert (NULL != skb);
-	state = (pgm_rxw_state_t*)&skb->cb;
-	switch (state->pkt_state) {
+/* data, parity, or a lost placeholder already exists at sequence */
+	if (NULL != _pgm_rxw_peek (window, sequence))
+		return PGM_RXW_DUPLICATE;
+
+/* fetch gap from window and bump expiration times */
+	gap = _pgm_rxw_find_gap (window, sequence);
+	switch (gap->state.pkt_state) {
 	case PGM_PKT_STATE_BACK_OFF:
 	case PGM_PKT_STATE_WAIT_NCF:
-		pgm_rxw_state (window, skb, PGM_PKT_STATE_WAIT_DATA);
-
-/* fall through */
 	case PGM_PKT_STATE_WAIT_DATA:
-		state->timer_expiry = nak_rdata_expiry;
-		return PGM_RXW_UPDATED;
+		break;
 
-	case PGM_PKT_STATE_HAVE_DATA:
-	case PGM_PKT_STATE_HAVE_PARITY:
-	case PGM_PKT_STATE_COMMIT_DATA:
 	case PGM_PKT_STATE_LOST_DATA:
-		break;
+		return PGM_RXW_DUPLICATE;
 
 	default: pgm_assert_not_reached(); break;
 	}
 
-	return PGM_RXW_DUPLICATE;
+/* confirmations tend to arrive in order, extend the preceding gap when it
+ * was confirmed with the same expiration and retries.
+ */
+	if (sequence == gap->sequence && NULL != gap->order_link.next)
+	{
+		pgm_rxw_gap_t* lower = gap->order_link.next->data;
+		if (lower->sequence + lower->len == sequence &&
+		    PGM_PKT_STATE_WAIT_DATA == lower->state.pkt_state &&
+		    nak_rdata_expiry == lower->state.timer_expiry &&
+		    gap->state.nak_transmit_count == lower->state.nak_transmit_count &&
+		    gap->state.ncf_retry_count == lower->state.ncf_retry_count &&
+		    gap->state.data_retry_count == lower->state.data_retry_count)
+		{
+			_pgm_rxw_gap_trim (window, gap, 1, TRUE);
+			lower->len++;
+			window->missing_count++;
+			return PGM_RXW_UPDATED;
+		}
+	}
+
+	gap = _pgm_rxw_gap_isolate (window, gap, sequence);
+	if (PGM_PKT_STATE_WAIT_DATA != gap->state.pkt_state)
+		_pgm_rxw_gap_state (window, gap, PGM_PKT_STATE_WAIT_DATA);
+	gap->state.timer_expiry = nak_rdata_expiry;
+	return PGM_RXW_UPDATED;
 }
 
-/* append an skb to the incoming window with WAIT-DATA state.
+/* append a gap to the incoming window with WAIT-DATA state.
  *
  * returns:
  * PGM_RXW_APPENDED - lead is extended with state set waiting for data.
@@ -2086,8 +4135,7 @@ _pgm_rxw_recovery_append (
 	const pgm_time_t	nak_rdata_expiry		/* pre-calculated expiry times */
 	)
 {
-	struct pgm_sk_buff_t* skb;
-	pgm_rxw_state_t* state;
+	pgm_rxw_gap_t* gap;
 
 /* pre-conditions */
 	pgm_assert (NULL != window);
@@ -2102,6 +4150,7 @@ _pgm_rxw_recovery_append (
 	}
 
 /* advance leading edge */
+	_pgm_rxw_reserve (window, 1);
 	window->lead++;
 
 /* add loss to bitmap */
@@ -2114,15 +4163,10 @@ _pgm_rxw_recovery_append (
  */
 	window->data_loss = window->ack_c_p + pgm_fp16mul (pgm_fp16 (1) - window->ack_c_p, window->data_loss);
 
-	skb			= pgm_alloc_skb (window->max_tpdu);
-	state			= (pgm_rxw_state_t*)&skb->cb;
-	skb->tstamp		= now;
-	skb->sequence		= window->lead;
-	state->timer_expiry	= nak_rdata_expiry;
-
-	const uint_fast32_t index_	= pgm_rxw_lead (window) % pgm_rxw_max_length (window);
-	window->pdata[index_]		= skb;
-	_pgm_rxw_state (window, skb, PGM_PKT_STATE_WAIT_DATA);
+	gap			= _pgm_rxw_gap_new (window, window->lead, 1, now);
+	gap->state.timer_expiry	= nak_rdata_expiry;
+	pgm_queue_push_head_link (&window->gap_queue, &gap->order_link);
+	_pgm_rxw_gap_state (window, gap, PGM_PKT_STATE_WAIT_DATA);
 
 	return PGM_RXW_APPENDED;
 }
@@ -2141,6 +4185,8 @@ pgm_rxw_dump (
 		"nak_backoff_queue = {head = %p, tail = %p, length = %u}, "
 		"wait_ncf_queue = {head = %p, tail = %p, length = %u}, "
 		"wait_data_queue = {head = %p, tail = %p, length = %u}, "
+		"gap_queue = {head = %p, tail = %p, length = %u}, "
+		"missing_count = %" PRIu32 ", "
 		"lost_count = %" PRIu32 ", "
 		"fragment_count = %" PRIu32 ", "
 		"parity_count = %" PRIu32 ", "
@@ -2166,6 +4212,8 @@ pgm_rxw_dump (
 		"msgs_delivered = %" PRIu32 ", "
 		"size = %" PRIzu ", "
 		"alloc = %" PRIu32 ", "
+		"min_alloc = %" PRIu32 ", "
+		"max_alloc = %" PRIu32 ", "
 		"pdata = []"
 		"}",
 		window->tsi->gsi.identifier[0], 
@@ -2184,6 +4232,10 @@ pgm_rxw_dump (
 		(void*)window->wait_data_queue.head,
 			(void*)window->wait_data_queue.tail,
 			window->wait_data_queue.length,
+		(void*)window->gap_queue.head,
+			(void*)window->gap_queue.tail,
+			window->gap_queue.length,
+		window->missing_count,
 		window->lost_count,
 		window->fragment_count,
 		window->parity_count,
@@ -2208,7 +4260,9 @@ pgm_rxw_dump (
 		window->bytes_delivered,
 		window->msgs_delivered,
 		window->size,
-		window->alloc
+		window->alloc,
+		window->min_alloc,
+		window->max_alloc
 	);
 }
 
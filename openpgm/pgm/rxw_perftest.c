@@ -0,0 +1,376 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * performance tests for receive window.
+ *
+ * Copyright (c) 2010-2016 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <glib.h>
+#include <check.h>
+
+
+/* mock state */
+
+#define PERF_ROUNDS		1000
+#define PERF_ROUND_LENGTH	1000
+#define PERF_TSDU_LENGTH	1000
+#define PERF_GAP_INTERVAL	10		/* one in ten sequences lost and repaired */
+
+static unsigned perf_sqns	= 0;
+
+static
+void
+mock_setup_1k (void)
+{
+	perf_sqns	= 1024;
+}
+
+/* not a power of two, the pointer array is rounded up */
+static
+void
+mock_setup_1000 (void)
+{
+	perf_sqns	= 1000;
+}
+
+static
+void
+mock_setup_64k (void)
+{
+	perf_sqns	= 65536;
+}
+
+/* mock global */
+
+#define pgm_histogram_add		mock_pgm_histogram_add
+#define pgm_histogram_init		mock_pgm_histogram_init
+#define pgm_rs_create			mock_pgm_rs_create
+#define pgm_rs_destroy			mock_pgm_rs_destroy
+#define pgm_rs_decode_parity_appended	mock_pgm_rs_decode_parity_appended
+#define pgm_decode_pool_submit		mock_pgm_decode_pool_submit
+
+#define RXW_DEBUG
+#include "rxw.c"
+
+/* mock functions for external references */
+
+size_t
+pgm_pkt_offset (
+        const bool                      can_fragment,
+        const sa_family_t		pgmcc_family	/* 0 = disable */
+        )
+{
+        return 0;
+}
+
+PGM_GNUC_INTERNAL
+int
+pgm_get_nprocs (void)
+{
+	return 1;
+}
+
+/** reed-solomon module */
+void
+mock_pgm_rs_create (
+	pgm_rs_t*		rs,
+	uint8_t			n,
+	uint8_t			k
+	)
+{
+}
+
+void
+mock_pgm_rs_destroy (
+	pgm_rs_t*		rs
+	)
+{
+}
+
+void
+mock_pgm_rs_decode_parity_appended (
+	pgm_rs_t*		rs,
+	pgm_gf8_t**		block,
+	const uint8_t*		offsets,
+	uint16_t		len
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_decode_pool_submit (
+	struct pgm_decode_pool_t* const	pool,
+	struct pgm_decode_job_t* const	job,
+	const uintptr_t			hint
+	)
+{
+	return FALSE;
+}
+
+void
+mock_pgm_histogram_init (
+	pgm_histogram_t*	histogram
+	)
+{
+}
+
+void
+mock_pgm_histogram_add (
+	pgm_histogram_t*	histogram,
+	int			value
+	)
+{
+}
+
+static
+void
+mock_setup (void)
+{
+	g_assert (pgm_time_init (NULL));
+}
+
+static
+void
+mock_teardown (void)
+{
+	g_assert (pgm_time_shutdown ());
+}
+
+static
+void
+perf_report (
+	const char*		name,
+	const pgm_time_t	elapsed,		/* μs */
+	const guint64		count
+	)
+{
+	g_message ("%s/%u: elapsed time %" PGM_TIME_FORMAT " us, unit time %" PGM_TIME_FORMAT " ns, %" PGM_TIME_FORMAT " packets/s",
+		name, perf_sqns,
+		(guint64)elapsed,
+		(guint64)((1000 * elapsed) / count),
+		(guint64)(elapsed ? (1000000 * count) / elapsed : 0));
+}
+
+/* generate valid skb, data pointer pointing to PGM payload
+ */
+static
+struct pgm_sk_buff_t*
+generate_valid_skb (
+	const uint32_t		sequence
+	)
+{
+	const pgm_tsi_t tsi = { { 200, 202, 203, 204, 205, 206 }, 2000 };
+	const guint16 header_length = sizeof(struct pgm_header) + sizeof(struct pgm_data);
+	struct pgm_sk_buff_t* skb = pgm_alloc_skb (1500);
+	memcpy (&skb->tsi, &tsi, sizeof(tsi));
+/* fake but valid socket and timestamp */
+	skb->sock = (pgm_sock_t*)0x1;
+	skb->tstamp = pgm_time_update_now();
+/* header */
+	pgm_skb_reserve (skb, header_length);
+	memset (skb->head, 0, header_length);
+	skb->pgm_header = (struct pgm_header*)skb->head;
+	skb->pgm_data   = (struct pgm_data*)(skb->pgm_header + 1);
+	skb->pgm_header->pgm_type = PGM_ODATA;
+	skb->pgm_header->pgm_tsdu_length = g_htons (PERF_TSDU_LENGTH);
+	skb->pgm_data->data_sqn = g_htonl (sequence);
+/* DATA */
+	pgm_skb_put (skb, PERF_TSDU_LENGTH);
+	return skb;
+}
+
+/* arrival order of the offsets of one round of sequences.
+ */
+enum {
+	PERF_IN_ORDER,
+	PERF_REORDERED,		/* adjacent pairs swapped */
+	PERF_GAPPED		/* every interval lost, repairs arrive at the end of the round */
+};
+
+static
+unsigned
+perf_offset (
+	const int		pattern,
+	const unsigned		i
+	)
+{
+	switch (pattern) {
+	case PERF_REORDERED:
+		return i ^ 1;
+	case PERF_GAPPED: {
+		const unsigned lost = PERF_ROUND_LENGTH / PERF_GAP_INTERVAL;
+		if (i >= PERF_ROUND_LENGTH - lost)
+			return ((i - (PERF_ROUND_LENGTH - lost)) * PERF_GAP_INTERVAL) + PERF_GAP_INTERVAL - 1;
+		return i + (i / (PERF_GAP_INTERVAL - 1));
+	}
+	default:
+		return i;
+	}
+}
+
+/* each round adds one window-sized batch of sequences in the pattern order
+ * and then drains it through pgm_rxw_readv() and pgm_rxw_remove_commit(),
+ * only the add and read phases are timed.
+ */
+static
+void
+perf_receive (
+	const char*		name,
+	const int		pattern
+	)
+{
+	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	pgm_rxw_t* window = pgm_rxw_create (&tsi, 1500, perf_sqns, 0, 0, 0);
+	fail_if (NULL == window, "create failed");
+	struct pgm_sk_buff_t* skbs[PERF_ROUND_LENGTH];
+	struct pgm_msgv_t msgv[PERF_ROUND_LENGTH];
+	pgm_time_t add_elapsed = 0, read_elapsed = 0;
+	uint32_t sequence = 0;
+
+/* the first sequence defines the window trail, later sequences may then arrive in any order */
+	struct pgm_msgv_t* pmsg = msgv;
+	pgm_rxw_add (window, generate_valid_skb (sequence++), pgm_time_update_now(), pgm_time_update_now() + pgm_secs(1));
+	fail_unless (PERF_TSDU_LENGTH == pgm_rxw_readv (window, &pmsg, G_N_ELEMENTS(msgv)), "readv failed");
+	pgm_rxw_remove_commit (window);
+
+	for (unsigned round = 0; round < PERF_ROUNDS; round++, sequence += PERF_ROUND_LENGTH)
+	{
+		for (unsigned i = 0; i < PERF_ROUND_LENGTH; i++)
+			skbs[ i ] = generate_valid_skb (sequence + perf_offset (pattern, i));
+
+		pgm_time_t start = pgm_time_update_now();
+		for (unsigned i = 0; i < PERF_ROUND_LENGTH; i++) {
+			const int status = pgm_rxw_add (window, skbs[ i ], start, start + pgm_secs(1));
+			fail_unless (PGM_RXW_APPENDED == status || PGM_RXW_INSERTED == status || PGM_RXW_MISSING == status, "add failed");
+		}
+		pgm_time_t check = pgm_time_update_now();
+		add_elapsed += check - start;
+
+		pmsg = msgv;
+		start = check;
+		const ssize_t len = pgm_rxw_readv (window, &pmsg, G_N_ELEMENTS(msgv));
+		pgm_rxw_remove_commit (window);
+		check = pgm_time_update_now();
+		read_elapsed += check - start;
+		fail_unless (PERF_ROUND_LENGTH * PERF_TSDU_LENGTH == len, "readv failed");
+	}
+
+	char label[64];
+	snprintf (label, sizeof(label), "add/%s", name);
+	perf_report (label, add_elapsed, PERF_ROUNDS * PERF_ROUND_LENGTH);
+	snprintf (label, sizeof(label), "readv/%s", name);
+	perf_report (label, read_elapsed, PERF_ROUNDS * PERF_ROUND_LENGTH);
+	pgm_rxw_destroy (window);
+}
+
+/* target:
+ *	int
+ *	pgm_rxw_add (
+ *		pgm_rxw_t* const		window,
+ *		struct pgm_sk_buff_t* const	skb,
+ *		const pgm_time_t		now,
+ *		const pgm_time_t		nak_rb_expiry
+ *		)
+ *
+ *	ssize_t
+ *	pgm_rxw_readv (
+ *		pgm_rxw_t* const		window,
+ *		struct pgm_msgv_t**		pmsg,
+ *		const unsigned			msg_len
+ *		)
+ */
+
+START_TEST (test_in_order)
+{
+	perf_receive ("in-order", PERF_IN_ORDER);
+}
+END_TEST
+
+START_TEST (test_reordered)
+{
+	perf_receive ("reordered", PERF_REORDERED);
+}
+END_TEST
+
+START_TEST (test_gapped)
+{
+	perf_receive ("gapped", PERF_GAPPED);
+}
+END_TEST
+
+static
+Suite*
+make_rxw_suite (void)
+{
+	Suite* s;
+
+	s = suite_create ("Receive window");
+
+	TCase* tc_1k = tcase_create ("1k sequences");
+	suite_add_tcase (s, tc_1k);
+	tcase_add_checked_fixture (tc_1k, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_1k, mock_setup_1k, NULL);
+	tcase_add_test (tc_1k, test_in_order);
+	tcase_add_test (tc_1k, test_reordered);
+	tcase_add_test (tc_1k, test_gapped);
+
+	TCase* tc_1000 = tcase_create ("1000 sequences");
+	suite_add_tcase (s, tc_1000);
+	tcase_add_checked_fixture (tc_1000, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_1000, mock_setup_1000, NULL);
+	tcase_add_test (tc_1000, test_in_order);
+	tcase_add_test (tc_1000, test_reordered);
+	tcase_add_test (tc_1000, test_gapped);
+
+	TCase* tc_64k = tcase_create ("64k sequences");
+	suite_add_tcase (s, tc_64k);
+	tcase_add_checked_fixture (tc_64k, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_64k, mock_setup_64k, NULL);
+	tcase_add_test (tc_64k, test_in_order);
+	tcase_add_test (tc_64k, test_reordered);
+	tcase_add_test (tc_64k, test_gapped);
+
+	return s;
+}
+
+static
+Suite*
+make_master_suite (void)
+{
+	Suite* s = suite_create ("Master");
+	return s;
+}
+
+int
+main (void)
+{
+	SRunner* sr = srunner_create (make_master_suite ());
+	srunner_add_suite (sr, make_rxw_suite ());
+	srunner_run_all (sr, CK_ENV);
+	int number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* eof */
@@ -36,10 +36,13 @@
 
 #define pgm_histogram_add		mock_pgm_histogram_add
 #define pgm_time_now			mock_pgm_time_now
+#define pgm_time_update_now		mock_pgm_time_update_now
 #define pgm_rs_create			mock_pgm_rs_create
 #define pgm_rs_destroy			mock_pgm_rs_destroy
 #define pgm_rs_decode_parity_appended	mock_pgm_rs_decode_parity_appended
 #define pgm_histogram_init		mock_pgm_histogram_init
+#define pgm_decode_pool_submit		mock_pgm_decode_pool_submit
+#define pgm_xdp_filter_update		mock_pgm_xdp_filter_update
 
 #define RXW_DEBUG
 #include "rxw.c"
@@ -49,10 +52,18 @@
 #endif
 
 static pgm_time_t mock_pgm_time_now = 0x1;
+static pgm_time_t _mock_pgm_time_update_now (void);
+pgm_time_update_func mock_pgm_time_update_now = _mock_pgm_time_update_now;
 
 
 /* mock functions for external references */
 
+pgm_time_t
+_mock_pgm_time_update_now (void)
+{
+	return mock_pgm_time_now;
+}
+
 size_t
 pgm_pkt_offset (
         const bool                      can_fragment,
@@ -97,6 +108,27 @@ mock_pgm_rs_decode_parity_appended (
 // null
 }
 
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_decode_pool_submit (
+	struct pgm_decode_pool_t* const	pool,
+	struct pgm_decode_job_t* const	job,
+	const uintptr_t			hint
+	)
+{
+	return FALSE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_xdp_filter_update (
+	pgm_xdp_filter_t* const	filter,
+	const pgm_tsi_t* const	tsi,
+	const uint32_t		commit_lead
+	)
+{
+}
+
 void
 mock_pgm_histogram_init (
 	pgm_histogram_t*	histogram
@@ -139,6 +171,52 @@ generate_valid_skb (void)
 	return skb;
 }
 
+/* generate valid fragment of an APDU, payload filled with fill
+ */
+static
+struct pgm_sk_buff_t*
+generate_fragment_skb (
+	const guint32		sequence,
+	const guint32		first_sequence,
+	const guint32		frag_offset,
+	const guint32		apdu_length,
+	const guint16		tsdu_length,
+	const int		fill
+	)
+{
+	const pgm_tsi_t tsi = { { 200, 202, 203, 204, 205, 206 }, 2000 };
+	const guint16 opt_total_length = sizeof(struct pgm_opt_length) + sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_fragment);
+	const guint16 header_length = sizeof(struct pgm_header) + sizeof(struct pgm_data) + opt_total_length;
+	struct pgm_sk_buff_t* skb = pgm_alloc_skb (1500);
+	memcpy (&skb->tsi, &tsi, sizeof(tsi));
+	skb->sock = (pgm_sock_t*)0x1;
+	skb->tstamp = pgm_time_now;
+/* header */
+	pgm_skb_reserve (skb, header_length);
+	memset (skb->head, 0, header_length);
+	skb->pgm_header = (struct pgm_header*)skb->head;
+	skb->pgm_data   = (struct pgm_data*)(skb->pgm_header + 1);
+	skb->pgm_header->pgm_type = PGM_ODATA;
+	skb->pgm_header->pgm_options = PGM_OPT_PRESENT;
+	skb->pgm_header->pgm_tsdu_length = g_htons (tsdu_length);
+	skb->pgm_data->data_sqn = g_htonl (sequence);
+	struct pgm_opt_length* opt_len = (struct pgm_opt_length*)(skb->pgm_data + 1);
+	opt_len->opt_type = PGM_OPT_LENGTH;
+	opt_len->opt_length = sizeof(struct pgm_opt_length);
+	opt_len->opt_total_length = g_htons (opt_total_length);
+	struct pgm_opt_header* opt_header = (struct pgm_opt_header*)(opt_len + 1);
+	opt_header->opt_type = PGM_OPT_FRAGMENT | PGM_OPT_END;
+	opt_header->opt_length = sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_fragment);
+	skb->pgm_opt_fragment = (struct pgm_opt_fragment*)(opt_header + 1);
+	skb->pgm_opt_fragment->opt_sqn = g_htonl (first_sequence);
+	skb->pgm_opt_fragment->opt_frag_off = g_htonl (frag_offset);
+	skb->pgm_opt_fragment->opt_frag_len = g_htonl (apdu_length);
+/* DATA */
+	pgm_skb_put (skb, tsdu_length);
+	memset (skb->data, fill, tsdu_length);
+	return skb;
+}
+
 /* target:
  *	pgm_rxw_t*
  *	pgm_rxw_create (
@@ -409,6 +487,92 @@ START_TEST (test_add_pass_005)
 }
 END_TEST
 
+/* gap of an unreliable sequence lost on OPT_UNRELIABLE */
+START_TEST (test_add_pass_006)
+{
+	pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	const uint32_t ack_c_p = 500;
+	pgm_rxw_t* window = pgm_rxw_create (&tsi, 1500, 100, 0, 0, ack_c_p);
+	fail_if (NULL == window, "create failed");
+/* #1 */
+	struct pgm_sk_buff_t* skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (0);
+	const pgm_time_t now = 1;
+	const pgm_time_t nak_rb_expiry = 2;
+	fail_unless (PGM_RXW_APPENDED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not appended");
+/* #3 marking #2 unreliable, #1 already received */
+	const guint16 tsdu_length = 100;
+	const guint16 opt_total_length = sizeof(struct pgm_opt_length) + sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_unreliable);
+	const guint16 header_length = sizeof(struct pgm_header) + sizeof(struct pgm_data) + opt_total_length;
+	skb = pgm_alloc_skb (1500);
+	memcpy (&skb->tsi, &tsi, sizeof(tsi));
+	skb->sock = (pgm_sock_t*)0x1;
+	skb->tstamp = pgm_time_now;
+	pgm_skb_reserve (skb, header_length);
+	memset (skb->head, 0, header_length);
+	skb->pgm_header = (struct pgm_header*)skb->head;
+	skb->pgm_data   = (struct pgm_data*)(skb->pgm_header + 1);
+	skb->pgm_header->pgm_type = PGM_ODATA;
+	skb->pgm_header->pgm_options = PGM_OPT_PRESENT;
+	skb->pgm_header->pgm_tsdu_length = g_htons (tsdu_length);
+	skb->pgm_data->data_sqn = g_htonl (2);
+	struct pgm_opt_length* opt_len = (struct pgm_opt_length*)(skb->pgm_data + 1);
+	opt_len->opt_type = PGM_OPT_LENGTH;
+	opt_len->opt_length = sizeof(struct pgm_opt_length);
+	opt_len->opt_total_length = g_htons (opt_total_length);
+	struct pgm_opt_header* opt_header = (struct pgm_opt_header*)(opt_len + 1);
+	opt_header->opt_type = PGM_OPT_UNRELIABLE | PGM_OPT_END;
+	opt_header->opt_length = sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_unreliable);
+	struct pgm_opt_unreliable* opt_unreliable = (struct pgm_opt_unreliable*)(opt_header + 1);
+	opt_unreliable->opt_bitmap = g_htonl (0x3);
+	skb->unreliable = 1;
+	pgm_skb_put (skb, tsdu_length);
+	fail_unless (PGM_RXW_MISSING == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not missing");
+	fail_unless (1 == window->lost_count, "lost count not 1");
+	fail_unless (0 == window->missing_count, "missing count not 0");
+	pgm_rxw_destroy (window);
+}
+END_TEST
+
+/* gaps recycled without allocation */
+START_TEST (test_add_pass_007)
+{
+	pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	const uint32_t ack_c_p = 500;
+	pgm_rxw_t* window = pgm_rxw_create (&tsi, 1500, 100, 0, 0, ack_c_p);
+	fail_if (NULL == window, "create failed");
+	const pgm_time_t now = 1;
+	const pgm_time_t nak_rb_expiry = 2;
+/* #1 */
+	struct pgm_sk_buff_t* skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (0);
+	fail_unless (PGM_RXW_APPENDED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not appended");
+/* #3, missing #2 */
+	skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (2);
+	fail_unless (PGM_RXW_MISSING == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not missing");
+	fail_if (NULL == window->gaps, "gap chunk not allocated");
+	const pgm_rxw_gap_t* gap = _pgm_rxw_find_gap (window, 1);
+/* #2 repaired, gap idle */
+	skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (1);
+	fail_unless (PGM_RXW_INSERTED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not inserted");
+	fail_unless (&gap->link == window->gap_free, "gap not recycled");
+/* #5, missing #4 reuses the gap */
+	skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (4);
+	fail_unless (PGM_RXW_MISSING == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not missing");
+	fail_unless (gap == _pgm_rxw_find_gap (window, 3), "gap not reused");
+	fail_unless (NULL == window->gaps->next, "gap chunk not reused");
+	pgm_rxw_destroy (window);
+}
+END_TEST
+
 /* null skb */
 START_TEST (test_add_fail_001)
 {
@@ -976,6 +1140,182 @@ START_TEST (test_readv_pass_006)
 }
 END_TEST
 
+/* coalesced skb split across two reads */
+START_TEST (test_readv_pass_010)
+{
+	pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	const uint32_t ack_c_p = 500;
+	pgm_rxw_t* window = pgm_rxw_create (&tsi, 1500, 100, 0, 0, ack_c_p);
+	fail_if (NULL == window, "create failed");
+	struct pgm_msgv_t msgv[2], *pmsg;
+	struct pgm_sk_buff_t* skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+/* three records of 10, 20, and 30 bytes */
+	const guint16 record_length[] = { 10, 20, 30 };
+	guint8* p = skb->data;
+	for (unsigned i = 0; i < G_N_ELEMENTS(record_length); i++) {
+		const guint16 netlen = g_htons (record_length[i]);
+		memcpy (p, &netlen, sizeof(netlen));
+		memset (p + sizeof(netlen), 'a' + i, record_length[i]);
+		p += sizeof(netlen) + record_length[i];
+	}
+	const guint16 tsdu_length = (guint16)(p - (guint8*)skb->data);
+	skb->pgm_header->pgm_tsdu_length = g_htons (tsdu_length);
+	skb->tail = (guint8*)skb->data + tsdu_length;
+	skb->len = tsdu_length;
+	skb->coalesced = 1;
+	skb->pgm_data->data_sqn = g_htonl (0);
+	const pgm_time_t now = 1;
+	const pgm_time_t nak_rb_expiry = 2;
+	fail_unless (PGM_RXW_APPENDED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not appended");
+/* first two records */
+	pmsg = msgv;
+	fail_unless (30 == pgm_rxw_readv (window, &pmsg, G_N_ELEMENTS(msgv)), "readv failed");
+	fail_unless (10 == msgv[0].msgv_skb[0]->len, "record length failed");
+	fail_unless ('a' == ((guint8*)msgv[0].msgv_skb[0]->data)[0], "record data failed");
+	fail_unless (20 == msgv[1].msgv_skb[0]->len, "record length failed");
+	fail_unless ('b' == ((guint8*)msgv[1].msgv_skb[0]->data)[0], "record data failed");
+	fail_unless (_pgm_rxw_commit_is_empty (window), "commit_is_empty failed");
+/* remaining record */
+	pmsg = msgv;
+	fail_unless (30 == pgm_rxw_readv (window, &pmsg, G_N_ELEMENTS(msgv)), "readv failed");
+	fail_unless ('c' == ((guint8*)msgv[0].msgv_skb[0]->data)[0], "record data failed");
+	fail_unless (1 == _pgm_rxw_commit_length (window), "commit_length failed");
+/* end-of-window */
+	pmsg = msgv;
+	fail_unless (-1 == pgm_rxw_readv (window, &pmsg, G_N_ELEMENTS(msgv)), "readv failed");
+	pgm_rxw_remove_commit (window);
+	pgm_rxw_destroy (window);
+}
+END_TEST
+
+/* coalesced skb with framing overrunning the payload */
+START_TEST (test_readv_pass_011)
+{
+	pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	const uint32_t ack_c_p = 500;
+	pgm_rxw_t* window = pgm_rxw_create (&tsi, 1500, 100, 0, 0, ack_c_p);
+	fail_if (NULL == window, "create failed");
+	struct pgm_sk_buff_t* skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	const guint16 netlen = g_htons (skb->len);
+	memcpy (skb->data, &netlen, sizeof(netlen));
+	skb->coalesced = 1;
+	skb->pgm_data->data_sqn = g_htonl (0);
+	const pgm_time_t now = 1;
+	const pgm_time_t nak_rb_expiry = 2;
+	fail_unless (PGM_RXW_MALFORMED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not malformed");
+	fail_unless (0 == pgm_rxw_length (window), "length failed");
+	pgm_rxw_destroy (window);
+}
+END_TEST
+
+/* unordered delivery beyond a gap, repair and duplicate */
+START_TEST (test_readv_pass_012)
+{
+	pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	const uint32_t ack_c_p = 500;
+	pgm_rxw_t* window = pgm_rxw_create (&tsi, 1500, 100, 0, 0, ack_c_p);
+	fail_if (NULL == window, "create failed");
+	window->is_unordered = TRUE;
+	struct pgm_msgv_t msgv[4], *pmsg;
+	const pgm_time_t now = 1;
+	const pgm_time_t nak_rb_expiry = 2;
+/* #1 in order */
+	struct pgm_sk_buff_t* skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (0);
+	fail_unless (PGM_RXW_APPENDED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not appended");
+	pmsg = msgv;
+	fail_unless (1000 == pgm_rxw_readv (window, &pmsg, G_N_ELEMENTS(msgv)), "readv failed");
+/* #3 beyond missing #2 */
+	skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (2);
+	fail_unless (PGM_RXW_MISSING == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not missing");
+	pmsg = msgv;
+	fail_unless (1000 == pgm_rxw_readv (window, &pmsg, G_N_ELEMENTS(msgv)), "readv failed");
+	fail_unless (&msgv[1] == pmsg, "unordered read failed");
+	pmsg = msgv;
+	fail_unless (-1 == pgm_rxw_readv (window, &pmsg, G_N_ELEMENTS(msgv)), "readv failed");
+	fail_unless (1 == window->missing_count, "missing_count failed");
+/* repeated #3 */
+	skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (2);
+	fail_unless (PGM_RXW_DUPLICATE == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not duplicate");
+/* repair #2, commit lead passes #3 */
+	skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (1);
+	fail_unless (PGM_RXW_INSERTED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not inserted");
+	pmsg = msgv;
+	fail_unless (1000 == pgm_rxw_readv (window, &pmsg, G_N_ELEMENTS(msgv)), "readv failed");
+	fail_unless (&msgv[1] == pmsg, "readv failed");
+	fail_unless (3 == window->commit_lead, "commit_lead failed");
+	pmsg = msgv;
+	fail_unless (-1 == pgm_rxw_readv (window, &pmsg, G_N_ELEMENTS(msgv)), "readv failed");
+	fail_unless (0 == window->cumulative_losses, "cumulative_losses failed");
+	pgm_rxw_destroy (window);
+}
+END_TEST
+
+/* large APDU reassembled in place from fragments out of order, then the buffer
+ * of an APDU with a lost fragment released once the trail passes it
+ */
+START_TEST (test_readv_pass_013)
+{
+	pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	const uint32_t ack_c_p = 500;
+	pgm_rxw_t* window = pgm_rxw_create (&tsi, 1500, 100, 0, 0, ack_c_p);
+	fail_if (NULL == window, "create failed");
+	window->reasm_min = 2000;
+	struct pgm_msgv_t msgv[4], *pmsg;
+	struct pgm_sk_buff_t* skb;
+	const pgm_time_t now = 1;
+	const pgm_time_t nak_rb_expiry = 2;
+/* #0, #2 then #1 of a 3,000 byte APDU */
+	skb = generate_fragment_skb (0, 0, 0, 3000, 1000, 'a');
+	fail_unless (PGM_RXW_APPENDED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not appended");
+	skb = generate_fragment_skb (2, 0, 2000, 3000, 1000, 'c');
+	fail_unless (PGM_RXW_MISSING == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not missing");
+	pmsg = msgv;
+	fail_unless (-1 == pgm_rxw_readv (window, &pmsg, G_N_ELEMENTS(msgv)), "readv failed");
+	fail_unless (1 == window->reasm_queue.length, "reasm_queue failed");
+	skb = generate_fragment_skb (1, 0, 1000, 3000, 1000, 'b');
+	fail_unless (PGM_RXW_INSERTED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not inserted");
+	pmsg = msgv;
+	fail_unless (3000 == pgm_rxw_readv (window, &pmsg, G_N_ELEMENTS(msgv)), "readv failed");
+	fail_unless (&msgv[1] == pmsg, "readv failed");
+	fail_unless (1 == msgv[0].msgv_len, "msgv_len failed");
+	skb = msgv[0].msgv_skb[0];
+	fail_unless (3000 == skb->len, "apdu length failed");
+	fail_unless ('a' == ((guint8*)skb->data)[0] && 'a' == ((guint8*)skb->data)[999], "fragment #0 failed");
+	fail_unless ('b' == ((guint8*)skb->data)[1000] && 'b' == ((guint8*)skb->data)[1999], "fragment #1 failed");
+	fail_unless ('c' == ((guint8*)skb->data)[2000] && 'c' == ((guint8*)skb->data)[2999], "fragment #2 failed");
+	fail_unless (1 == window->cumulative_reassembled, "cumulative_reassembled failed");
+	fail_unless (0 == window->reasm_queue.length, "reasm_queue failed");
+	pgm_rxw_remove_commit (window);
+	fail_unless (0 == window->reasm_commit_queue.length, "reasm_commit_queue failed");
+/* #3 and #5 of a second APDU, #4 lost */
+	skb = generate_fragment_skb (3, 3, 0, 3000, 1000, 'd');
+	fail_unless (PGM_RXW_APPENDED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not appended");
+	skb = generate_fragment_skb (5, 3, 2000, 3000, 1000, 'f');
+	fail_unless (PGM_RXW_MISSING == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not missing");
+	fail_unless (1 == window->reasm_queue.length, "reasm_queue failed");
+	pgm_rxw_lost (window, 4);
+	pmsg = msgv;
+	fail_unless (-1 == pgm_rxw_readv (window, &pmsg, G_N_ELEMENTS(msgv)), "readv failed");
+	fail_unless (1 == window->cumulative_reassembled, "cumulative_reassembled failed");
+/* trail pushed past the incomplete APDU */
+	fail_unless (3 == pgm_rxw_remove_trail (window) + pgm_rxw_remove_trail (window) + pgm_rxw_remove_trail (window), "remove_trail failed");
+	fail_unless (6 == window->trail, "trail failed");
+	pgm_rxw_remove_commit (window);
+	fail_unless (0 == window->reasm_queue.length, "reasm_queue failed");
+	pgm_rxw_destroy (window);
+}
+END_TEST
+
 /* NULL window */
 START_TEST (test_readv_fail_001)
 {
@@ -1109,6 +1449,40 @@ START_TEST (test_remove_commit_pass_001)
 }
 END_TEST
 
+/* window grown from a minimum length shrinks back once committed */
+START_TEST (test_remove_commit_pass_002)
+{
+	pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	const uint32_t ack_c_p = 500;
+	pgm_rxw_t* window = pgm_rxw_create (&tsi, 1500, 100, 0, 0, ack_c_p);
+	fail_if (NULL == window, "create failed");
+	pgm_rxw_set_min_length (window, 4, TRUE);
+	fail_unless (4 == window->alloc, "set_min_length failed");
+	fail_unless (100 == pgm_rxw_max_length (window), "max_length failed");
+	struct pgm_msgv_t msgv[40], *pmsg;
+	struct pgm_sk_buff_t* skb;
+	for (unsigned i = 0; i < 40; i++)
+	{
+		skb = generate_valid_skb ();
+		fail_if (NULL == skb, "generate_valid_skb failed");
+		skb->pgm_data->data_sqn = g_htonl (i);
+		const pgm_time_t now = 1;
+		const pgm_time_t nak_rb_expiry = 2;
+		fail_unless (PGM_RXW_APPENDED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not appended");
+		fail_unless ((1 + i) == pgm_rxw_length (window), "length failed");
+		fail_unless (window->alloc >= pgm_rxw_length (window), "alloc failed");
+	}
+	fail_unless (64 == window->alloc, "alloc failed");
+	fail_if (pgm_rxw_is_full (window), "is_full failed");
+	pmsg = msgv;
+	fail_unless ((40 * 1000) == pgm_rxw_readv (window, &pmsg, G_N_ELEMENTS(msgv)), "readv failed");
+	pgm_rxw_remove_commit (window);
+	fail_unless (pgm_rxw_is_empty (window), "is_empty failed");
+	fail_unless (4 == window->alloc, "shrink failed");
+	pgm_rxw_destroy (window);
+}
+END_TEST
+
 START_TEST (test_remove_commit_fail_001)
 {
 	pgm_rxw_remove_commit (NULL);
@@ -1201,6 +1575,45 @@ START_TEST (test_update_pass_001)
 }
 END_TEST
 
+/* burst loss is held as one gap, confirmations split and coalesce it */
+START_TEST (test_update_pass_002)
+{
+	pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	const uint32_t ack_c_p = 500;
+	pgm_rxw_t* window = pgm_rxw_create (&tsi, 1500, 100, 0, 0, ack_c_p);
+	fail_if (NULL == window, "create failed");
+	const pgm_time_t now = 1;
+	const pgm_time_t nak_rdata_expiry = 3;
+	const pgm_time_t nak_rb_expiry = 2;
+	fail_unless (0 == pgm_rxw_update (window, 100, 99, now, nak_rb_expiry), "update failed");
+	fail_unless (50 == pgm_rxw_update (window, 150, 99, now, nak_rb_expiry), "update failed");
+	fail_unless (50 == pgm_rxw_length (window), "length failed");
+	fail_unless (1 == window->nak_backoff_queue.length, "nak_backoff_queue.length failed");
+	fail_unless (50 == window->missing_count, "missing_count failed");
+/* #1 confirm at 120 */
+	fail_unless (PGM_RXW_UPDATED == pgm_rxw_confirm (window, 120, now, nak_rdata_expiry, nak_rb_expiry), "confirm not updated");
+	fail_unless (2 == window->nak_backoff_queue.length, "nak_backoff_queue.length failed");
+	fail_unless (1 == window->wait_data_queue.length, "wait_data_queue.length failed");
+/* #2 confirm at 121 extends gap of #1 */
+	fail_unless (PGM_RXW_UPDATED == pgm_rxw_confirm (window, 121, now, nak_rdata_expiry, nak_rb_expiry), "confirm not updated");
+	fail_unless (1 == window->wait_data_queue.length, "wait_data_queue.length failed");
+	fail_unless (2 == ((pgm_rxw_gap_t*)window->wait_data_queue.tail)->len, "gap length failed");
+	fail_unless (50 == window->missing_count, "missing_count failed");
+/* #3 data at 121 */
+	struct pgm_sk_buff_t* skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (121);
+	fail_unless (PGM_RXW_INSERTED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not inserted");
+	fail_unless (49 == window->missing_count, "missing_count failed");
+/* #4 jump beyond window capacity */
+	fail_unless (250 == pgm_rxw_update (window, 400, 99, now, nak_rb_expiry), "update failed");
+	fail_unless (pgm_rxw_is_full (window), "is_full failed");
+	fail_unless (100 == window->missing_count, "missing_count failed");
+	fail_unless (0 == window->fragment_count, "fragment_count failed");
+	pgm_rxw_destroy (window);
+}
+END_TEST
+
 START_TEST (test_update_fail_001)
 {
 	guint count = pgm_rxw_update (NULL, 0, 0, 0, 0);
@@ -1309,6 +1722,118 @@ START_TEST (test_confirm_fail_001)
 }
 END_TEST
 
+/* target:
+ *	pgm_time_t
+ *	pgm_rxw_nak_rtt (
+ *		pgm_rxw_t* const	window,
+ *		const uint32_t		sequence,
+ *		const pgm_time_t	now
+ *		)
+ */
+
+START_TEST (test_nak_rtt_pass_001)
+{
+	pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	const uint32_t ack_c_p = 500;
+	pgm_rxw_t* window = pgm_rxw_create (&tsi, 1500, 100, 0, 0, ack_c_p);
+	fail_if (NULL == window, "create failed");
+	const pgm_time_t now = 1;
+	const pgm_time_t nak_rb_expiry = 2;
+	fail_unless (0 == pgm_rxw_nak_rtt (window, 100, now), "nak_rtt not zero");
+/* #1 at 100 */
+	struct pgm_sk_buff_t* skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (100);
+	fail_unless (PGM_RXW_APPENDED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not appended");
+/* #2 at 102, missing 101 */
+	skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (102);
+	fail_unless (PGM_RXW_MISSING == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add not missing");
+/* no NAK sent */
+	fail_unless (0 == pgm_rxw_nak_rtt (window, 101, 25), "nak_rtt not zero");
+/* one NAK sent, sampled once */
+	pgm_rxw_gap_t* gap = _pgm_rxw_find_gap (window, 101);
+	gap->state.nak_transmit_count = 1;
+	gap->nak_tstamp = 10;
+	fail_unless (0 == pgm_rxw_nak_rtt (window, 100, 25), "nak_rtt not zero");
+	fail_unless (0 == pgm_rxw_nak_rtt (window, 103, 25), "nak_rtt not zero");
+	fail_unless (15 == pgm_rxw_nak_rtt (window, 101, 25), "nak_rtt failed");
+	fail_unless (0 == pgm_rxw_nak_rtt (window, 101, 25), "nak_rtt not zero");
+/* repeated NAK is ambiguous */
+	gap->state.nak_transmit_count = 2;
+	gap->nak_tstamp = 10;
+	fail_unless (0 == pgm_rxw_nak_rtt (window, 101, 25), "nak_rtt not zero");
+	pgm_rxw_destroy (window);
+}
+END_TEST
+
+START_TEST (test_nak_rtt_fail_001)
+{
+	const pgm_time_t rtt = pgm_rxw_nak_rtt (NULL, 0, 0);
+	fail ("reached");
+}
+END_TEST
+
+/* target:
+ *	uint32_t
+ *	pgm_rxw_expire (
+ *		pgm_rxw_t* const	window,
+ *		const pgm_time_t	deadline
+ *		)
+ */
+
+START_TEST (test_expire_pass_001)
+{
+	pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	const uint32_t ack_c_p = 500;
+	pgm_rxw_t* window = pgm_rxw_create (&tsi, 1500, 100, 0, 0, ack_c_p);
+	fail_if (NULL == window, "create failed");
+	const pgm_time_t nak_rb_expiry = 50;
+	fail_unless (0 == pgm_rxw_expire (window, 100), "expire not zero");
+	fail_unless (0 == pgm_rxw_gap_tstamp (window), "gap_tstamp not zero");
+/* #1 at 100 */
+	struct pgm_sk_buff_t* skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (100);
+	fail_unless (PGM_RXW_APPENDED == pgm_rxw_add (window, skb, 1, nak_rb_expiry), "add not appended");
+/* #2 at 102, missing 101 detected at 10 */
+	skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (102);
+	fail_unless (PGM_RXW_MISSING == pgm_rxw_add (window, skb, 10, nak_rb_expiry), "add not missing");
+/* #3 at 105, missing 103-104 detected at 20 */
+	skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (105);
+	fail_unless (PGM_RXW_MISSING == pgm_rxw_add (window, skb, 20, nak_rb_expiry), "add not missing");
+	fail_unless (3 == window->missing_count, "missing_count failed");
+	fail_unless (10 == pgm_rxw_gap_tstamp (window), "gap_tstamp failed");
+/* within budget */
+	fail_unless (0 == pgm_rxw_expire (window, 5), "expire not zero");
+	fail_unless (3 == window->missing_count, "missing_count failed");
+/* oldest gap only */
+	fail_unless (1 == pgm_rxw_expire (window, 15), "expire failed");
+	fail_unless (2 == window->missing_count, "missing_count failed");
+	fail_unless (1 == window->lost_count, "lost_count failed");
+	fail_unless (20 == pgm_rxw_gap_tstamp (window), "gap_tstamp failed");
+/* remaining gap, lost gaps are skipped */
+	fail_unless (2 == pgm_rxw_expire (window, 20), "expire failed");
+	fail_unless (0 == window->missing_count, "missing_count failed");
+	fail_unless (3 == window->lost_count, "lost_count failed");
+	fail_unless (0 == pgm_rxw_gap_tstamp (window), "gap_tstamp not zero");
+	fail_unless (0 == pgm_rxw_expire (window, 100), "expire not zero");
+	pgm_rxw_destroy (window);
+}
+END_TEST
+
+START_TEST (test_expire_fail_001)
+{
+	pgm_rxw_expire (NULL, 0);
+	fail ("reached");
+}
+END_TEST
+
 /* target:
  *	void
  *	pgm_rxw_lost (
@@ -1361,7 +1886,7 @@ END_TEST
  *	void
  *	pgm_rxw_state (
  *		pgm_rxw_t* const	window,
- *		struct pgm_sk_buff_t*	skb,
+ *		pgm_rxw_gap_t*		gap,
  *		int			new_state
  *		)
  */
@@ -1377,19 +1902,23 @@ START_TEST (test_state_pass_001)
 	const pgm_time_t nak_rb_expiry = 2;
 	fail_unless (0 == pgm_rxw_update (window, 100, 99, now, nak_rb_expiry), "update failed");
 	fail_unless (PGM_RXW_APPENDED == pgm_rxw_confirm (window, 101, now, nak_rdata_expiry, nak_rb_expiry), "confirm not appended");
-	struct pgm_sk_buff_t* skb = pgm_rxw_peek (window, 101);
-	pgm_rxw_state (window, skb, PGM_PKT_STATE_WAIT_NCF);
-	pgm_rxw_state (window, skb, PGM_PKT_STATE_WAIT_DATA);
+	fail_unless (NULL == pgm_rxw_peek (window, 101), "peek failed");
+	pgm_rxw_gap_t* gap = (pgm_rxw_gap_t*)window->wait_data_queue.tail;
+	fail_if (NULL == gap, "no gap");
+	fail_unless (101 == gap->sequence && 1 == gap->len, "gap mismatch");
+	pgm_rxw_state (window, gap, PGM_PKT_STATE_WAIT_NCF);
+	fail_unless (1 == window->wait_ncf_queue.length, "wait_ncf_queue.length failed");
+	pgm_rxw_state (window, gap, PGM_PKT_STATE_WAIT_DATA);
+	fail_unless (1 == window->wait_data_queue.length, "wait_data_queue.length failed");
+	fail_unless (1 == window->missing_count, "missing_count failed");
 	pgm_rxw_destroy (window);
 }
 END_TEST
 
 START_TEST (test_state_fail_001)
 {
-	struct pgm_sk_buff_t* skb = generate_valid_skb ();
-	fail_if (NULL == skb, "generate_valid_skb failed");
-	skb->pgm_data->data_sqn = g_htonl (0);
-	pgm_rxw_state (NULL, skb, PGM_PKT_STATE_BACK_OFF);
+	pgm_rxw_gap_t gap = { .sequence = 0, .len = 1 };
+	pgm_rxw_state (NULL, &gap, PGM_PKT_STATE_BACK_OFF);
 	fail ("reached");
 }
 END_TEST
@@ -1411,10 +1940,13 @@ START_TEST (test_state_fail_003)
 	const uint32_t ack_c_p = 500;
 	pgm_rxw_t* window = pgm_rxw_create (&tsi, 1500, 100, 0, 0, ack_c_p);
 	fail_if (NULL == window, "create failed");
-	struct pgm_sk_buff_t* skb = generate_valid_skb ();
-	fail_if (NULL == skb, "generate_valid_skb failed");
-	skb->pgm_data->data_sqn = g_htonl (0);
-	pgm_rxw_state (window, skb, -1);
+	const pgm_time_t now = 1;
+	const pgm_time_t nak_rb_expiry = 2;
+	fail_unless (0 == pgm_rxw_update (window, 100, 99, now, nak_rb_expiry), "update failed");
+	fail_unless (1 == pgm_rxw_update (window, 101, 99, now, nak_rb_expiry), "update failed");
+	pgm_rxw_gap_t* gap = (pgm_rxw_gap_t*)window->nak_backoff_queue.tail;
+	fail_if (NULL == gap, "no gap");
+	pgm_rxw_state (window, gap, -1);
 	fail ("reached");
 }
 END_TEST
@@ -1472,6 +2004,36 @@ START_TEST (test_has_pending_pass_001)
 }
 END_TEST
 
+/* over the memory budget new data releases the trail */
+START_TEST (test_budget_pass_001)
+{
+	pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	const uint32_t ack_c_p = 500;
+	pgm_mem_budget_t budget = { 0, 0, NULL };
+	pgm_rxw_t* window = pgm_rxw_create (&tsi, 1500, 100, 0, 0, ack_c_p);
+	fail_if (NULL == window, "create failed");
+	window->budget = &budget;
+	const pgm_time_t now = 1;
+	const pgm_time_t nak_rb_expiry = 2;
+	struct pgm_sk_buff_t* skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	const uint32_t truesize = skb->truesize;
+	skb->pgm_data->data_sqn = g_htonl (0);
+	fail_unless (PGM_RXW_APPENDED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add failed");
+	fail_unless (truesize == budget.used, "used failed");
+/* limit below one packet */
+	budget.max = truesize - 1;
+	skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	skb->pgm_data->data_sqn = g_htonl (1);
+	fail_unless (PGM_RXW_APPENDED == pgm_rxw_add (window, skb, now, nak_rb_expiry), "add failed");
+	fail_unless (1 == pgm_rxw_length (window), "length failed");
+	fail_unless (truesize == budget.used, "used failed");
+	pgm_rxw_destroy (window);
+	fail_unless (0 == budget.used, "used failed");
+}
+END_TEST
+
 static
 Suite*
 make_basic_test_suite (void)
@@ -1507,12 +2069,18 @@ make_basic_test_suite (void)
 	tcase_add_test (tc_add, test_add_pass_003);
 	tcase_add_test (tc_add, test_add_pass_004);
 	tcase_add_test (tc_add, test_add_pass_005);
+	tcase_add_test (tc_add, test_add_pass_006);
+	tcase_add_test (tc_add, test_add_pass_007);
 #ifndef PGM_CHECK_NOFORK
 	tcase_add_test_raise_signal (tc_add, test_add_fail_001, SIGABRT);
 	tcase_add_test_raise_signal (tc_add, test_add_fail_002, SIGABRT);
 	tcase_add_test_raise_signal (tc_add, test_add_fail_003, SIGABRT);
 #endif
 
+	TCase* tc_budget = tcase_create ("budget");
+	suite_add_tcase (s, tc_budget);
+	tcase_add_test (tc_budget, test_budget_pass_001);
+
 	TCase* tc_peek = tcase_create ("peek");
 	suite_add_tcase (s, tc_peek);
 	tcase_add_test (tc_peek, test_peek_pass_001);
@@ -1577,6 +2145,10 @@ make_basic_test_suite (void)
 	tcase_add_test (tc_readv, test_readv_pass_004);
 	tcase_add_test (tc_readv, test_readv_pass_005);
 	tcase_add_test (tc_readv, test_readv_pass_006);
+	tcase_add_test (tc_readv, test_readv_pass_010);
+	tcase_add_test (tc_readv, test_readv_pass_011);
+	tcase_add_test (tc_readv, test_readv_pass_012);
+	tcase_add_test (tc_readv, test_readv_pass_013);
 #ifndef PGM_CHECK_NOFORK
 	tcase_add_test_raise_signal (tc_readv, test_readv_fail_001, SIGABRT);
 	tcase_add_test_raise_signal (tc_readv, test_readv_fail_002, SIGABRT);
@@ -1586,6 +2158,7 @@ make_basic_test_suite (void)
 	TCase* tc_remove_commit = tcase_create ("remove-commit");
 	suite_add_tcase (s, tc_remove_commit);
 	tcase_add_test (tc_remove_commit, test_remove_commit_pass_001);
+	tcase_add_test (tc_remove_commit, test_remove_commit_pass_002);
 #ifndef PGM_CHECK_NOFORK
 	tcase_add_test_raise_signal (tc_remove_commit, test_remove_commit_fail_001, SIGABRT);
 #endif
@@ -1594,6 +2167,7 @@ make_basic_test_suite (void)
 	TCase* tc_update = tcase_create ("update");
 	suite_add_tcase (s, tc_update);
 	tcase_add_test (tc_update, test_update_pass_001);
+	tcase_add_test (tc_update, test_update_pass_002);
 #ifndef PGM_CHECK_NOFORK
 	tcase_add_test_raise_signal (tc_update, test_update_fail_001, SIGABRT);
 #endif
@@ -1606,6 +2180,20 @@ make_basic_test_suite (void)
 	tcase_add_test_raise_signal (tc_confirm, test_confirm_fail_001, SIGABRT);
 #endif
 
+        TCase* tc_nak_rtt = tcase_create ("nak-rtt");
+	suite_add_tcase (s, tc_nak_rtt);
+	tcase_add_test (tc_nak_rtt, test_nak_rtt_pass_001);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_nak_rtt, test_nak_rtt_fail_001, SIGABRT);
+#endif
+
+	TCase* tc_expire = tcase_create ("expire");
+	suite_add_tcase (s, tc_expire);
+	tcase_add_test (tc_expire, test_expire_pass_001);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_expire, test_expire_fail_001, SIGABRT);
+#endif
+
         TCase* tc_lost = tcase_create ("lost");
 	suite_add_tcase (s, tc_lost);
 	tcase_add_test (tc_lost, test_lost_pass_001);
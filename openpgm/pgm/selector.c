@@ -0,0 +1,616 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * PGM socket selector, readiness and timers across many sockets.
+ *
+ * One epoll or kqueue instance watches the receive, repair, pending and ACK
+ * descriptors of every added socket, each registration pointing back at its
+ * socket and the reason it signals.  A binary heap orders the sockets by next
+ * timer expiration, such that a wait costs in proportion to the ready sockets
+ * rather than all of them.  Timers of a socket move only while the application
+ * services it, or raise its pending notification, so deadlines are refreshed
+ * for the sockets returned by the previous wait.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+#include <errno.h>
+#include <limits.h>
+#ifdef HAVE_EPOLL_CTL
+#	include <sys/epoll.h>
+#elif defined(HAVE_KQUEUE)
+#	include <sys/types.h>
+#	include <sys/event.h>
+#	include <sys/time.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/socket.h>
+#include <impl/timer.h>
+#include <impl/shard.h>
+#include <impl/uring.h>
+#include <impl/xdp.h>
+#include <impl/selector.h>
+
+
+//#define SELECTOR_DEBUG
+
+#ifndef SELECTOR_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+/* descriptor events read per system call */
+#define PGM_SELECTOR_EVENTS_MAX		256
+
+/* receive shards, XDP, pending, repair and ACK descriptors */
+#define PGM_SELECTOR_FDS(sock)		((sock)->recv_shards + 4)
+
+#define PGM_SELECTOR_NOT_IN_HEAP	UINT_MAX
+
+struct pgm_selector_entry_t;
+
+/* one registered descriptor */
+struct pgm_selector_fd_t {
+	struct pgm_selector_entry_t*	entry;
+	SOCKET				fd;
+	unsigned			events;		/* PGM_SELECTOR_* signalled */
+};
+
+/* one added socket */
+struct pgm_selector_entry_t {
+	pgm_sock_t*			sock;
+	void*				user_data;
+	pgm_time_t			deadline;	/* next timer expiration */
+	unsigned			heap_index;
+	unsigned			ready;		/* events of the current wait */
+	unsigned			n_fds;
+	struct pgm_selector_fd_t*	fds;
+};
+
+struct pgm_selector_t {
+	SOCKET				poll_fd;	/* epoll or kqueue instance */
+	pgm_hashtable_t*		entries;	/* pgm_sock_t* → entry */
+	struct pgm_selector_entry_t**	heap;		/* earliest deadline first */
+	unsigned			heap_len;
+	unsigned			heap_size;
+	struct pgm_selector_entry_t**	ready;		/* returned by the last wait */
+	unsigned			ready_len;
+	unsigned			ready_size;
+	struct pgm_selector_fd_t	wake;		/* no entry, only ends a wait */
+#if defined(HAVE_EPOLL_CTL)
+	struct epoll_event		poll_events[ PGM_SELECTOR_EVENTS_MAX ];
+#elif defined(HAVE_KQUEUE)
+	struct kevent			poll_events[ PGM_SELECTOR_EVENTS_MAX ];
+#endif
+};
+
+
+static
+pgm_hash_t
+selector_sock_hash (
+	const void*	p
+	)
+{
+	const uintptr_t key = (uintptr_t)p;
+	return (pgm_hash_t)(key >> 4) ^ (pgm_hash_t)(key >> 16);
+}
+
+static
+bool
+selector_sock_equal (
+	const void* restrict	p1,
+	const void* restrict	p2
+	)
+{
+	return p1 == p2;
+}
+
+/* binary heap ordered by deadline, each entry tracking its index.
+ */
+
+static inline
+void
+heap_set (
+	pgm_selector_t*		     const restrict selector,
+	const unsigned				    index,
+	struct pgm_selector_entry_t* const restrict entry
+	)
+{
+	selector->heap[ index ] = entry;
+	entry->heap_index = index;
+}
+
+static
+void
+heap_sift_up (
+	pgm_selector_t* const	selector,
+	unsigned		index
+	)
+{
+	struct pgm_selector_entry_t* entry = selector->heap[ index ];
+	while (index > 0) {
+		const unsigned parent = (index - 1) / 2;
+		if (!pgm_time_after (selector->heap[ parent ]->deadline, entry->deadline))
+			break;
+		heap_set (selector, index, selector->heap[ parent ]);
+		index = parent;
+	}
+	heap_set (selector, index, entry);
+}
+
+static
+void
+heap_sift_down (
+	pgm_selector_t* const	selector,
+	unsigned		index
+	)
+{
+	struct pgm_selector_entry_t* entry = selector->heap[ index ];
+	for (;;) {
+		unsigned child = 2 * index + 1;
+		if (child >= selector->heap_len)
+			break;
+		if (child + 1 < selector->heap_len &&
+		    pgm_time_after (selector->heap[ child ]->deadline, selector->heap[ child + 1 ]->deadline))
+			child++;
+		if (!pgm_time_after (entry->deadline, selector->heap[ child ]->deadline))
+			break;
+		heap_set (selector, index, selector->heap[ child ]);
+		index = child;
+	}
+	heap_set (selector, index, entry);
+}
+
+static
+void
+heap_insert (
+	pgm_selector_t*		     const restrict selector,
+	struct pgm_selector_entry_t* const restrict entry
+	)
+{
+	pgm_assert (PGM_SELECTOR_NOT_IN_HEAP == entry->heap_index);
+	if (selector->heap_len == selector->heap_size) {
+		selector->heap_size = selector->heap_size ? selector->heap_size * 2 : 64;
+		selector->heap = pgm_realloc (selector->heap, selector->heap_size * sizeof (struct pgm_selector_entry_t*));
+	}
+	heap_set (selector, selector->heap_len++, entry);
+	heap_sift_up (selector, entry->heap_index);
+}
+
+static
+void
+heap_remove (
+	pgm_selector_t*		     const restrict selector,
+	struct pgm_selector_entry_t* const restrict entry
+	)
+{
+	const unsigned index = entry->heap_index;
+	pgm_assert (index < selector->heap_len);
+	entry->heap_index = PGM_SELECTOR_NOT_IN_HEAP;
+	if (index == --selector->heap_len)
+		return;
+	heap_set (selector, index, selector->heap[ selector->heap_len ]);
+	heap_sift_up (selector, index);
+	heap_sift_down (selector, selector->heap[ index ]->heap_index);
+}
+
+/* read the next timer expiration of the socket and re-order the heap.
+ */
+
+static
+void
+selector_refresh_deadline (
+	pgm_selector_t*		     const restrict selector,
+	struct pgm_selector_entry_t* const restrict entry
+	)
+{
+	entry->deadline = pgm_time_update_now() + pgm_timer_expiration (entry->sock);
+	if (PGM_SELECTOR_NOT_IN_HEAP == entry->heap_index) {
+		heap_insert (selector, entry);
+	} else {
+		heap_sift_up (selector, entry->heap_index);
+		heap_sift_down (selector, entry->heap_index);
+	}
+}
+
+/* register or unregister one descriptor, returns 0 on success or -1 setting
+ * errno.
+ */
+
+#ifdef PGM_HAVE_SELECTOR
+static
+int
+selector_ctl (
+	pgm_selector_t*		  const restrict selector,
+	struct pgm_selector_fd_t* const restrict fd,
+	const bool				 is_add
+	)
+{
+#	if defined(HAVE_EPOLL_CTL)
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.ptr = fd;
+	return epoll_ctl (selector->poll_fd, is_add ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, fd->fd, &event);
+#	else
+	struct kevent change;
+	EV_SET(&change, fd->fd, EVFILT_READ, is_add ? EV_ADD : EV_DELETE, 0, 0, fd);
+	return kevent (selector->poll_fd, &change, 1, NULL, 0, NULL);
+#	endif
+}
+#endif /* PGM_HAVE_SELECTOR */
+
+static
+void
+selector_entry_add_fd (
+	struct pgm_selector_entry_t* const	entry,
+	const SOCKET				fd,
+	const unsigned				events
+	)
+{
+	struct pgm_selector_fd_t* rec = &entry->fds[ entry->n_fds++ ];
+	rec->entry  = entry;
+	rec->fd     = fd;
+	rec->events = events;
+}
+
+/* create a selector.
+ *
+ * on success, returns TRUE.  on failure returns FALSE and sets error
+ * appropriately.
+ */
+
+bool
+pgm_selector_create (
+	pgm_selector_t** restrict selector,
+	pgm_error_t**	 restrict error
+	)
+{
+	pgm_return_val_if_fail (NULL != selector, FALSE);
+
+#ifdef PGM_HAVE_SELECTOR
+#	if defined(HAVE_EPOLL_CTL)
+	const SOCKET poll_fd = epoll_create1 (EPOLL_CLOEXEC);
+#	else
+	const SOCKET poll_fd = kqueue ();
+#	endif
+	if (INVALID_SOCKET == poll_fd) {
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_errno (save_errno),
+			       _("Creating selector poll instance: %s"),
+			       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		return FALSE;
+	}
+	pgm_selector_t* new_selector = pgm_new0 (pgm_selector_t, 1);
+	new_selector->poll_fd = poll_fd;
+	new_selector->entries = pgm_hashtable_new (selector_sock_hash, selector_sock_equal);
+	new_selector->wake.fd = INVALID_SOCKET;
+	*selector = new_selector;
+	return TRUE;
+#else
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       PGM_ERROR_NOSYS,
+		       _("Selector requires epoll or kqueue support."));
+	return FALSE;
+#endif
+}
+
+/* add a connected socket with application data returned alongside its
+ * events.  the socket must be removed before it is closed.
+ *
+ * on success, returns TRUE.  on failure returns FALSE and sets error
+ * appropriately.
+ */
+
+bool
+pgm_selector_add (
+	pgm_selector_t* const restrict selector,
+	pgm_sock_t*	const restrict sock,
+	void*			       user_data,
+	pgm_error_t**	      restrict error
+	)
+{
+	pgm_return_val_if_fail (NULL != selector, FALSE);
+	pgm_return_val_if_fail (NULL != sock, FALSE);
+
+	if (PGM_UNLIKELY(!sock->is_connected || sock->is_destroyed)) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Socket is not connected."));
+		return FALSE;
+	}
+	if (PGM_UNLIKELY(NULL != pgm_hashtable_lookup (selector->entries, sock))) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Socket already added to selector."));
+		return FALSE;
+	}
+
+#ifdef PGM_HAVE_SELECTOR
+	struct pgm_selector_entry_t* entry = pgm_new0 (struct pgm_selector_entry_t, 1);
+	entry->sock	  = sock;
+	entry->user_data  = user_data;
+	entry->heap_index = PGM_SELECTOR_NOT_IN_HEAP;
+	entry->fds	  = pgm_new0 (struct pgm_selector_fd_t, PGM_SELECTOR_FDS(sock));
+
+	selector_entry_add_fd (entry, pgm_recv_event_sock (sock), PGM_SELECTOR_DATA);
+	for (unsigned i = 1; i < sock->recv_shards; i++)
+		selector_entry_add_fd (entry, pgm_recv_shard_sock (sock, i), PGM_SELECTOR_DATA);
+#	ifdef HAVE_LINUX_IF_XDP_H
+	if (sock->xdp)
+		selector_entry_add_fd (entry, sock->xdp->fd, PGM_SELECTOR_DATA);
+#	endif
+	selector_entry_add_fd (entry, pgm_notify_get_socket (&sock->pending_notify), PGM_SELECTOR_DATA);
+	if (sock->can_send_data) {
+		selector_entry_add_fd (entry, pgm_notify_get_socket (&sock->rdata_notify), PGM_SELECTOR_REPAIR);
+		if (sock->use_pgmcc)
+			selector_entry_add_fd (entry, pgm_notify_get_socket (&sock->ack_notify), PGM_SELECTOR_ACK);
+	}
+
+	for (unsigned i = 0; i < entry->n_fds; i++)
+	{
+		if (0 == selector_ctl (selector, &entry->fds[ i ], TRUE))
+			continue;
+/* a receive socket shared with another added socket signals through that
+ * socket, packets for this one raise its pending notification.
+ */
+		if (EEXIST == errno && PGM_SELECTOR_DATA == entry->fds[ i ].events && NULL != sock->demux) {
+			entry->fds[ i ].fd = INVALID_SOCKET;
+			continue;
+		}
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_errno (save_errno),
+			       _("Registering socket with selector: %s"),
+			       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		while (i-- > 0)
+			if (INVALID_SOCKET != entry->fds[ i ].fd)
+				selector_ctl (selector, &entry->fds[ i ], FALSE);
+		pgm_free (entry->fds);
+		pgm_free (entry);
+		return FALSE;
+	}
+
+	pgm_hashtable_insert (selector->entries, sock, entry);
+	selector_refresh_deadline (selector, entry);
+	return TRUE;
+#else
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       PGM_ERROR_NOSYS,
+		       _("Selector requires epoll or kqueue support."));
+	return FALSE;
+#endif
+}
+
+/* remove a socket, returns FALSE if not added.
+ */
+
+bool
+pgm_selector_remove (
+	pgm_selector_t* const restrict selector,
+	pgm_sock_t*	const restrict sock
+	)
+{
+	pgm_return_val_if_fail (NULL != selector, FALSE);
+	pgm_return_val_if_fail (NULL != sock, FALSE);
+
+	struct pgm_selector_entry_t* entry = pgm_hashtable_lookup (selector->entries, sock);
+	if (NULL == entry)
+		return FALSE;
+
+#ifdef PGM_HAVE_SELECTOR
+	for (unsigned i = 0; i < entry->n_fds; i++)
+		if (INVALID_SOCKET != entry->fds[ i ].fd)
+			selector_ctl (selector, &entry->fds[ i ], FALSE);
+#endif
+	for (unsigned i = 0; i < selector->ready_len; i++)
+		if (entry == selector->ready[ i ])
+			selector->ready[ i ] = NULL;
+	if (PGM_SELECTOR_NOT_IN_HEAP != entry->heap_index)
+		heap_remove (selector, entry);
+	pgm_hashtable_remove (selector->entries, sock);
+	pgm_free (entry->fds);
+	pgm_free (entry);
+	return TRUE;
+}
+
+/* wait up to timeout milliseconds, or indefinitely when negative, for added
+ * sockets to become ready or their timers to expire.  each socket appears once
+ * with the union of its events, the application services it with a receive
+ * call, and its deadline is read again on the next wait.
+ *
+ * returns the number of events, 0 on timeout, or -1 on failure setting error
+ * appropriately.
+ */
+
+int
+pgm_selector_wait (
+	pgm_selector_t*		     const restrict selector,
+	struct pgm_selector_event_t* const restrict events,
+	const unsigned				    max_events,
+	const int				    timeout,
+	pgm_error_t**			   restrict error
+	)
+{
+	pgm_return_val_if_fail (NULL != selector, -1);
+	pgm_return_val_if_fail (NULL != events, -1);
+	pgm_return_val_if_fail (max_events > 0, -1);
+
+#ifdef PGM_HAVE_SELECTOR
+/* timers of sockets serviced since the last wait */
+	for (unsigned i = 0; i < selector->ready_len; i++)
+		if (NULL != selector->ready[ i ])
+			selector_refresh_deadline (selector, selector->ready[ i ]);
+	selector->ready_len = 0;
+	if (max_events > selector->ready_size) {
+		selector->ready_size = max_events;
+		selector->ready = pgm_realloc (selector->ready, max_events * sizeof (struct pgm_selector_entry_t*));
+	}
+
+/* sleep no later than the earliest deadline, rounded up to avoid early wakeups */
+	int wait_ms = timeout;
+	if (selector->heap_len > 0) {
+		const pgm_time_t now = pgm_time_update_now();
+		const pgm_time_t deadline = selector->heap[0]->deadline;
+		const int heap_ms = pgm_time_after (deadline, now) ? (int)MIN((uint64_t)INT_MAX, pgm_to_msecs (deadline - now + 999)) : 0;
+		if (wait_ms < 0 || heap_ms < wait_ms)
+			wait_ms = heap_ms;
+	}
+
+#	if defined(HAVE_EPOLL_CTL)
+	const int n = epoll_wait (selector->poll_fd, selector->poll_events, PGM_SELECTOR_EVENTS_MAX, wait_ms);
+#	else
+	struct timespec ts, *tsp = NULL;
+	if (wait_ms >= 0) {
+		ts.tv_sec  = wait_ms / 1000;
+		ts.tv_nsec = (long)(wait_ms % 1000) * 1000000L;
+		tsp = &ts;
+	}
+	const int n = kevent (selector->poll_fd, NULL, 0, selector->poll_events, PGM_SELECTOR_EVENTS_MAX, tsp);
+#	endif
+	if (n < 0 && EINTR != errno) {
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_errno (save_errno),
+			       _("Waiting on selector: %s"),
+			       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		return -1;
+	}
+
+/* readiness, descriptors beyond a full list are level triggered and signal again */
+	for (int i = 0; i < n; i++)
+	{
+#	if defined(HAVE_EPOLL_CTL)
+		const struct pgm_selector_fd_t* fd = selector->poll_events[ i ].data.ptr;
+#	else
+		const struct pgm_selector_fd_t* fd = (const struct pgm_selector_fd_t*)selector->poll_events[ i ].udata;
+#	endif
+		struct pgm_selector_entry_t* entry = fd->entry;
+		if (NULL == entry)
+			continue;
+		if (0 == entry->ready) {
+			if (selector->ready_len == max_events)
+				continue;
+			selector->ready[ selector->ready_len++ ] = entry;
+		}
+		entry->ready |= fd->events;
+	}
+
+/* expired timers, leaving the heap until refreshed */
+	const pgm_time_t now = pgm_time_update_now();
+	while (selector->heap_len > 0 &&
+	       pgm_time_after_eq (now, selector->heap[0]->deadline))
+	{
+		struct pgm_selector_entry_t* entry = selector->heap[0];
+		if (0 == entry->ready) {
+			if (selector->ready_len == max_events)
+				break;
+			selector->ready[ selector->ready_len++ ] = entry;
+		}
+		entry->ready |= PGM_SELECTOR_TIMER;
+		heap_remove (selector, entry);
+	}
+
+	for (unsigned i = 0; i < selector->ready_len; i++)
+	{
+		struct pgm_selector_entry_t* entry = selector->ready[ i ];
+		events[ i ].sock      = entry->sock;
+		events[ i ].user_data = entry->user_data;
+		events[ i ].events    = entry->ready;
+		entry->ready = 0;
+	}
+	return (int)selector->ready_len;
+#else
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       PGM_ERROR_NOSYS,
+		       _("Selector requires epoll or kqueue support."));
+	return -1;
+#endif
+}
+
+/* register a descriptor that returns a wait early without an event, the
+ * caller drains it.  one per selector, for an owning thread woken by others.
+ *
+ * returns TRUE on success, FALSE on failure setting errno.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_selector_set_wake (
+	pgm_selector_t* const	selector,
+	const SOCKET		fd
+	)
+{
+	pgm_return_val_if_fail (NULL != selector, FALSE);
+	pgm_return_val_if_fail (INVALID_SOCKET == selector->wake.fd, FALSE);
+
+#ifdef PGM_HAVE_SELECTOR
+	selector->wake.fd = fd;
+	if (0 == selector_ctl (selector, &selector->wake, TRUE))
+		return TRUE;
+	selector->wake.fd = INVALID_SOCKET;
+#else
+	errno = ENOSYS;
+#endif
+	return FALSE;
+}
+
+/* destroy a selector, added sockets are left open.
+ */
+
+void
+pgm_selector_destroy (
+	pgm_selector_t*		selector
+	)
+{
+	pgm_return_if_fail (NULL != selector);
+
+	for (unsigned i = 0; i < selector->heap_len; i++) {
+		pgm_free (selector->heap[ i ]->fds);
+		pgm_free (selector->heap[ i ]);
+	}
+/* expired timers not yet refreshed */
+	for (unsigned i = 0; i < selector->ready_len; i++) {
+		struct pgm_selector_entry_t* entry = selector->ready[ i ];
+		if (NULL == entry || PGM_SELECTOR_NOT_IN_HEAP != entry->heap_index)
+			continue;
+		pgm_free (entry->fds);
+		pgm_free (entry);
+	}
+#ifdef PGM_HAVE_SELECTOR
+	close (selector->poll_fd);
+#endif
+	pgm_hashtable_destroy (selector->entries);
+	pgm_free (selector->heap);
+	pgm_free (selector->ready);
+	pgm_free (selector);
+}
+
+/* eof */
@@ -0,0 +1,455 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * unit tests for the PGM socket selector.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <glib.h>
+#include <check.h>
+
+
+/* mock state */
+
+#define pgm_time_update_now	mock_pgm_time_update_now
+#define pgm_timer_expiration	mock_pgm_timer_expiration
+
+#define SELECTOR_DEBUG
+#include "selector.c"
+
+static pgm_time_t mock_pgm_time_now = 0x1;
+static pgm_sock_t* mock_expired_sock = NULL;
+static pgm_time_t _mock_pgm_time_update_now (void);
+pgm_time_update_func mock_pgm_time_update_now = _mock_pgm_time_update_now;
+
+PGM_GNUC_INTERNAL
+int
+pgm_get_nprocs (void)
+{
+	return 1;
+}
+
+static
+void
+mock_setup (void)
+{
+	if (!g_thread_supported ()) g_thread_init (NULL);
+	mock_pgm_time_now = 0x1;
+	mock_expired_sock = NULL;
+}
+
+/* connected socket, the receive descriptor one end of a datagram socket pair
+ * returned in peer.
+ */
+static
+pgm_sock_t*
+generate_sock (
+	const bool		can_send_data,
+	SOCKET*			peer
+	)
+{
+	SOCKET sv[2];
+	pgm_sock_t* sock = g_new0 (pgm_sock_t, 1);
+	sock->is_connected	= TRUE;
+	sock->can_send_data	= can_send_data;
+	sock->recv_shards	= 1;
+	fail_unless (0 == socketpair (AF_UNIX, SOCK_DGRAM, 0, sv), "socketpair failed");
+	sock->recv_sock		= sv[0];
+	*peer			= sv[1];
+	fail_unless (0 == pgm_notify_init (&sock->pending_notify), "notify_init failed");
+	if (can_send_data)
+		fail_unless (0 == pgm_notify_init (&sock->rdata_notify), "notify_init failed");
+	return sock;
+}
+
+static
+void
+send_datagram (
+	const SOCKET		peer
+	)
+{
+	const char one = '1';
+	fail_unless (1 == send (peer, &one, sizeof (one), 0), "send failed");
+}
+
+static
+void
+recv_datagram (
+	const pgm_sock_t*	sock
+	)
+{
+	char buf;
+	fail_unless (1 == recv (sock->recv_sock, &buf, sizeof (buf), 0), "recv failed");
+}
+
+/* mock functions for external references */
+
+static
+pgm_time_t
+_mock_pgm_time_update_now (void)
+{
+	return mock_pgm_time_now;
+}
+
+/* expired socket due now, otherwise ten seconds */
+PGM_GNUC_INTERNAL
+pgm_time_t
+mock_pgm_timer_expiration (
+	pgm_sock_t* const	sock
+	)
+{
+	return sock == mock_expired_sock ? 0 : pgm_secs (10);
+}
+
+
+/* target:
+ *	bool
+ *	pgm_selector_create (
+ *		pgm_selector_t**	selector,
+ *		pgm_error_t**		error
+ *		)
+ */
+
+START_TEST (test_create_pass_001)
+{
+	pgm_selector_t* selector = NULL;
+	pgm_error_t* err = NULL;
+	fail_unless (TRUE == pgm_selector_create (&selector, &err), "create failed");
+	fail_if (NULL == selector, "selector not set");
+	fail_unless (NULL == err, "error raised");
+	pgm_selector_destroy (selector);
+}
+END_TEST
+
+START_TEST (test_create_fail_001)
+{
+	fail_unless (FALSE == pgm_selector_create (NULL, NULL), "create failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_selector_add (
+ *		pgm_selector_t*		selector,
+ *		pgm_sock_t*		sock,
+ *		void*			user_data,
+ *		pgm_error_t**		error
+ *		)
+ */
+
+/* receive, pending and repair descriptors registered with a deadline */
+START_TEST (test_add_pass_001)
+{
+	pgm_selector_t* selector = NULL;
+	pgm_error_t* err = NULL;
+	SOCKET peer;
+	fail_unless (TRUE == pgm_selector_create (&selector, NULL), "create failed");
+	pgm_sock_t* sock = generate_sock (TRUE, &peer);
+	fail_unless (TRUE == pgm_selector_add (selector, sock, NULL, &err), "add failed");
+	fail_unless (NULL == err, "error raised");
+	const struct pgm_selector_entry_t* entry = pgm_hashtable_lookup (selector->entries, sock);
+	fail_if (NULL == entry, "entry not found");
+	fail_unless (3 == entry->n_fds, "n_fds failed");
+	fail_unless (1 == selector->heap_len, "heap_len failed");
+	fail_unless (mock_pgm_time_now + pgm_secs (10) == entry->deadline, "deadline failed");
+	pgm_selector_destroy (selector);
+}
+END_TEST
+
+/* socket not connected */
+START_TEST (test_add_fail_001)
+{
+	pgm_selector_t* selector = NULL;
+	pgm_error_t* err = NULL;
+	SOCKET peer;
+	fail_unless (TRUE == pgm_selector_create (&selector, NULL), "create failed");
+	pgm_sock_t* sock = generate_sock (FALSE, &peer);
+	sock->is_connected = FALSE;
+	fail_unless (FALSE == pgm_selector_add (selector, sock, NULL, &err), "add failed");
+	fail_if (NULL == err, "error not raised");
+	fail_unless (PGM_ERROR_INVAL == err->code, "error code failed");
+	pgm_error_free (err);
+	pgm_selector_destroy (selector);
+}
+END_TEST
+
+/* socket already added */
+START_TEST (test_add_fail_002)
+{
+	pgm_selector_t* selector = NULL;
+	pgm_error_t* err = NULL;
+	SOCKET peer;
+	fail_unless (TRUE == pgm_selector_create (&selector, NULL), "create failed");
+	pgm_sock_t* sock = generate_sock (FALSE, &peer);
+	fail_unless (TRUE == pgm_selector_add (selector, sock, NULL, NULL), "add failed");
+	fail_unless (FALSE == pgm_selector_add (selector, sock, NULL, &err), "add failed");
+	fail_if (NULL == err, "error not raised");
+	fail_unless (PGM_ERROR_INVAL == err->code, "error code failed");
+	fail_unless (1 == selector->heap_len, "heap_len failed");
+	pgm_error_free (err);
+	pgm_selector_destroy (selector);
+}
+END_TEST
+
+/* target:
+ *	int
+ *	pgm_selector_wait (
+ *		pgm_selector_t*			selector,
+ *		struct pgm_selector_event_t*	events,
+ *		const unsigned			max_events,
+ *		const int			timeout,
+ *		pgm_error_t**			error
+ *		)
+ */
+
+/* nothing ready */
+START_TEST (test_wait_pass_001)
+{
+	pgm_selector_t* selector = NULL;
+	struct pgm_selector_event_t events[4];
+	SOCKET peer;
+	fail_unless (TRUE == pgm_selector_create (&selector, NULL), "create failed");
+	pgm_sock_t* sock = generate_sock (TRUE, &peer);
+	fail_unless (TRUE == pgm_selector_add (selector, sock, NULL, NULL), "add failed");
+	fail_unless (0 == pgm_selector_wait (selector, events, G_N_ELEMENTS(events), 0, NULL), "wait failed");
+	pgm_selector_destroy (selector);
+}
+END_TEST
+
+/* data and repair of one socket returned as one event with user data */
+START_TEST (test_wait_pass_002)
+{
+	pgm_selector_t* selector = NULL;
+	struct pgm_selector_event_t events[4];
+	int user_data;
+	SOCKET peer;
+	fail_unless (TRUE == pgm_selector_create (&selector, NULL), "create failed");
+	pgm_sock_t* sock = generate_sock (TRUE, &peer);
+	fail_unless (TRUE == pgm_selector_add (selector, sock, &user_data, NULL), "add failed");
+	send_datagram (peer);
+	pgm_notify_send (&sock->rdata_notify);
+	fail_unless (1 == pgm_selector_wait (selector, events, G_N_ELEMENTS(events), 0, NULL), "wait failed");
+	fail_unless (sock == events[0].sock, "sock failed");
+	fail_unless (&user_data == events[0].user_data, "user_data failed");
+	fail_unless ((PGM_SELECTOR_DATA | PGM_SELECTOR_REPAIR) == events[0].events, "events failed");
+/* serviced */
+	recv_datagram (sock);
+	pgm_notify_clear (&sock->rdata_notify);
+	fail_unless (0 == pgm_selector_wait (selector, events, G_N_ELEMENTS(events), 0, NULL), "wait failed");
+	pgm_selector_destroy (selector);
+}
+END_TEST
+
+/* expired timer leaves the heap until the next wait */
+START_TEST (test_wait_pass_003)
+{
+	pgm_selector_t* selector = NULL;
+	struct pgm_selector_event_t events[4];
+	SOCKET peer[2];
+	fail_unless (TRUE == pgm_selector_create (&selector, NULL), "create failed");
+	pgm_sock_t* sock = generate_sock (FALSE, &peer[0]);
+	pgm_sock_t* idle = generate_sock (FALSE, &peer[1]);
+	mock_expired_sock = sock;
+	fail_unless (TRUE == pgm_selector_add (selector, idle, NULL, NULL), "add failed");
+	fail_unless (TRUE == pgm_selector_add (selector, sock, NULL, NULL), "add failed");
+	fail_unless (sock == selector->heap[0]->sock, "heap order failed");
+	fail_unless (1 == pgm_selector_wait (selector, events, G_N_ELEMENTS(events), -1, NULL), "wait failed");
+	fail_unless (sock == events[0].sock, "sock failed");
+	fail_unless (PGM_SELECTOR_TIMER == events[0].events, "events failed");
+	fail_unless (1 == selector->heap_len, "heap_len failed");
+/* serviced, next timer in ten seconds */
+	mock_expired_sock = NULL;
+	fail_unless (0 == pgm_selector_wait (selector, events, G_N_ELEMENTS(events), 0, NULL), "wait failed");
+	fail_unless (2 == selector->heap_len, "heap_len failed");
+	mock_pgm_time_now += pgm_secs (10);
+	fail_unless (2 == pgm_selector_wait (selector, events, G_N_ELEMENTS(events), 0, NULL), "wait failed");
+	fail_unless (PGM_SELECTOR_TIMER == events[0].events && PGM_SELECTOR_TIMER == events[1].events, "events failed");
+	pgm_selector_destroy (selector);
+}
+END_TEST
+
+/* ready sockets beyond max_events returned by the next wait */
+START_TEST (test_wait_pass_004)
+{
+	pgm_selector_t* selector = NULL;
+	struct pgm_selector_event_t events[1];
+	SOCKET peer[2];
+	fail_unless (TRUE == pgm_selector_create (&selector, NULL), "create failed");
+	pgm_sock_t* sock[2];
+	for (unsigned i = 0; i < G_N_ELEMENTS(sock); i++) {
+		sock[i] = generate_sock (FALSE, &peer[i]);
+		fail_unless (TRUE == pgm_selector_add (selector, sock[i], NULL, NULL), "add failed");
+		send_datagram (peer[i]);
+	}
+	fail_unless (1 == pgm_selector_wait (selector, events, G_N_ELEMENTS(events), 0, NULL), "wait failed");
+	pgm_sock_t* first = events[0].sock;
+	recv_datagram (first);
+	fail_unless (1 == pgm_selector_wait (selector, events, G_N_ELEMENTS(events), 0, NULL), "wait failed");
+	fail_if (first == events[0].sock, "sock failed");
+	fail_unless (PGM_SELECTOR_DATA == events[0].events, "events failed");
+	pgm_selector_destroy (selector);
+}
+END_TEST
+
+/* wake descriptor ends a wait without an event */
+START_TEST (test_wait_pass_005)
+{
+	pgm_selector_t* selector = NULL;
+	struct pgm_selector_event_t events[4];
+	pgm_notify_t wake;
+	fail_unless (TRUE == pgm_selector_create (&selector, NULL), "create failed");
+	fail_unless (0 == pgm_notify_init (&wake), "notify_init failed");
+	fail_unless (TRUE == pgm_selector_set_wake (selector, pgm_notify_get_socket (&wake)), "set_wake failed");
+	fail_unless (FALSE == pgm_selector_set_wake (selector, pgm_notify_get_socket (&wake)), "set_wake failed");
+	pgm_notify_send (&wake);
+	fail_unless (0 == pgm_selector_wait (selector, events, G_N_ELEMENTS(events), -1, NULL), "wait failed");
+	pgm_selector_destroy (selector);
+	pgm_notify_destroy (&wake);
+}
+END_TEST
+
+START_TEST (test_wait_fail_001)
+{
+	struct pgm_selector_event_t events[4];
+	fail_unless (-1 == pgm_selector_wait (NULL, events, G_N_ELEMENTS(events), 0, NULL), "wait failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_selector_remove (
+ *		pgm_selector_t*		selector,
+ *		pgm_sock_t*		sock
+ *		)
+ */
+
+/* removed socket no longer signals */
+START_TEST (test_remove_pass_001)
+{
+	pgm_selector_t* selector = NULL;
+	struct pgm_selector_event_t events[4];
+	SOCKET peer;
+	fail_unless (TRUE == pgm_selector_create (&selector, NULL), "create failed");
+	pgm_sock_t* sock = generate_sock (FALSE, &peer);
+	fail_unless (TRUE == pgm_selector_add (selector, sock, NULL, NULL), "add failed");
+	fail_unless (TRUE == pgm_selector_remove (selector, sock), "remove failed");
+	fail_unless (0 == selector->heap_len, "heap_len failed");
+	send_datagram (peer);
+	fail_unless (0 == pgm_selector_wait (selector, events, G_N_ELEMENTS(events), 0, NULL), "wait failed");
+	fail_unless (FALSE == pgm_selector_remove (selector, sock), "remove failed");
+/* and may be added again */
+	fail_unless (TRUE == pgm_selector_add (selector, sock, NULL, NULL), "add failed");
+	fail_unless (1 == pgm_selector_wait (selector, events, G_N_ELEMENTS(events), 0, NULL), "wait failed");
+	pgm_selector_destroy (selector);
+}
+END_TEST
+
+/* removed after a wait returned it, before the refresh */
+START_TEST (test_remove_pass_002)
+{
+	pgm_selector_t* selector = NULL;
+	struct pgm_selector_event_t events[4];
+	SOCKET peer;
+	fail_unless (TRUE == pgm_selector_create (&selector, NULL), "create failed");
+	pgm_sock_t* sock = generate_sock (FALSE, &peer);
+	mock_expired_sock = sock;
+	fail_unless (TRUE == pgm_selector_add (selector, sock, NULL, NULL), "add failed");
+	fail_unless (1 == pgm_selector_wait (selector, events, G_N_ELEMENTS(events), 0, NULL), "wait failed");
+	fail_unless (TRUE == pgm_selector_remove (selector, sock), "remove failed");
+	fail_unless (0 == pgm_selector_wait (selector, events, G_N_ELEMENTS(events), 0, NULL), "wait failed");
+	fail_unless (0 == selector->heap_len, "heap_len failed");
+	pgm_selector_destroy (selector);
+}
+END_TEST
+
+START_TEST (test_remove_fail_001)
+{
+	SOCKET peer;
+	pgm_sock_t* sock = generate_sock (FALSE, &peer);
+	fail_unless (FALSE == pgm_selector_remove (NULL, sock), "remove failed");
+}
+END_TEST
+
+
+static
+Suite*
+make_test_suite (void)
+{
+	Suite* s;
+
+	s = suite_create (__FILE__);
+
+	TCase* tc_create = tcase_create ("create");
+	suite_add_tcase (s, tc_create);
+	tcase_add_checked_fixture (tc_create, mock_setup, NULL);
+	tcase_add_test (tc_create, test_create_pass_001);
+	tcase_add_test (tc_create, test_create_fail_001);
+
+	TCase* tc_add = tcase_create ("add");
+	suite_add_tcase (s, tc_add);
+	tcase_add_checked_fixture (tc_add, mock_setup, NULL);
+	tcase_add_test (tc_add, test_add_pass_001);
+	tcase_add_test (tc_add, test_add_fail_001);
+	tcase_add_test (tc_add, test_add_fail_002);
+
+	TCase* tc_wait = tcase_create ("wait");
+	suite_add_tcase (s, tc_wait);
+	tcase_add_checked_fixture (tc_wait, mock_setup, NULL);
+	tcase_add_test (tc_wait, test_wait_pass_001);
+	tcase_add_test (tc_wait, test_wait_pass_002);
+	tcase_add_test (tc_wait, test_wait_pass_003);
+	tcase_add_test (tc_wait, test_wait_pass_004);
+	tcase_add_test (tc_wait, test_wait_pass_005);
+	tcase_add_test (tc_wait, test_wait_fail_001);
+
+	TCase* tc_remove = tcase_create ("remove");
+	suite_add_tcase (s, tc_remove);
+	tcase_add_checked_fixture (tc_remove, mock_setup, NULL);
+	tcase_add_test (tc_remove, test_remove_pass_001);
+	tcase_add_test (tc_remove, test_remove_pass_002);
+	tcase_add_test (tc_remove, test_remove_fail_001);
+	return s;
+}
+
+static
+Suite*
+make_master_suite (void)
+{
+	Suite* s = suite_create ("Master");
+	return s;
+}
+
+int
+main (void)
+{
+	SRunner* sr = srunner_create (make_master_suite ());
+	srunner_add_suite (sr, make_test_suite ());
+	srunner_run_all (sr, CK_ENV);
+	int number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* eof */
@@ -0,0 +1,371 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * receive fan-out over SO_REUSEPORT sockets, sharded by source GSI.
+ *
+ * Linux delivers a multicast datagram to every socket bound to the group
+ * port regardless of SO_REUSEPORT, each shard socket therefore carries a
+ * classic BPF filter keeping only the sources it owns, such that the kernel
+ * discards the rest before queueing.  Unicast datagrams are balanced by the
+ * SO_REUSEPORT hash and accepted on any shard.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/shard.h>
+
+
+//#define SHARD_DEBUG
+
+#ifndef SHARD_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+#ifdef PGM_HAVE_RECV_SHARDS
+/* offset of the GSI in a UDP encapsulated packet as seen by a socket filter */
+#define SHARD_GSI_OFFSET	(sizeof(struct pgm_udphdr) + offsetof(struct pgm_header, pgm_gsi))
+
+/* accept unicast, or multicast from a source owned by the shard */
+static
+int
+attach_filter (
+	const SOCKET		s,
+	const unsigned		shard,
+	const unsigned		shards
+	)
+{
+	struct sock_filter code[] = {
+/* IP version */
+		BPF_STMT(BPF_LD  | BPF_B   | BPF_ABS, (uint32_t)SKF_NET_OFF),
+		BPF_STMT(BPF_ALU | BPF_RSH | BPF_K,   4),
+		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,   4, 0, 3),
+/* IPv4 destination in 224.0.0.0/4 */
+		BPF_STMT(BPF_LD  | BPF_B   | BPF_ABS, (uint32_t)(SKF_NET_OFF + 16)),
+		BPF_STMT(BPF_ALU | BPF_AND | BPF_K,   0xf0),
+		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,   0xe0, 3, 9),
+/* IPv6 destination in ff00::/8 */
+		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,   6, 0, 8),
+		BPF_STMT(BPF_LD  | BPF_B   | BPF_ABS, (uint32_t)(SKF_NET_OFF + 24)),
+		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,   0xff, 0, 6),
+/* as pgm_recv_shard_of() */
+		BPF_STMT(BPF_LD  | BPF_W   | BPF_ABS, SHARD_GSI_OFFSET),
+		BPF_STMT(BPF_MISC| BPF_TAX,	      0),
+		BPF_STMT(BPF_LD  | BPF_H   | BPF_ABS, SHARD_GSI_OFFSET + 4),
+		BPF_STMT(BPF_ALU | BPF_XOR | BPF_X,   0),
+		BPF_STMT(BPF_ALU | BPF_MOD | BPF_K,   shards),
+		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,   shard, 0, 1),
+		BPF_STMT(BPF_RET | BPF_K,	      0xffffffff),
+		BPF_STMT(BPF_RET | BPF_K,	      0)
+	};
+	const struct sock_fprog prog = {
+		.len	= PGM_N_ELEMENTS(code),
+		.filter	= code
+	};
+	return setsockopt (s, SOL_SOCKET, SO_ATTACH_FILTER, (const char*)&prog, sizeof(prog));
+}
+#endif /* PGM_HAVE_RECV_SHARDS */
+
+/* open the additional receive sockets of a shard count, replacing any previous
+ * set.  called from pgm_setsockopt() before any group is joined so that later
+ * membership changes apply to every shard.
+ *
+ * returns TRUE on success, returns FALSE on error and sets the last socket error.
+ */
+
+bool
+pgm_recv_shards_create (
+	pgm_sock_t* const	sock,
+	const unsigned		shards
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (!sock->is_bound);
+	pgm_assert_cmpuint (shards, >, 0);
+	pgm_assert_cmpuint (shards, <=, PGM_RECV_SHARDS_MAX);
+
+	pgm_recv_shards_close (sock);
+	if (1 == shards)
+		return TRUE;
+
+#ifdef PGM_HAVE_RECV_SHARDS
+	int rcvbuf = 0;
+	socklen_t rcvbuflen = sizeof (rcvbuf);
+	if (SOCKET_ERROR == getsockopt (sock->recv_sock, SOL_SOCKET, SO_RCVBUF, (char*)&rcvbuf, &rcvbuflen))
+		return FALSE;
+/* Linux reports twice the requested size */
+	rcvbuf /= 2;
+
+	sock->recv_shard_sock = pgm_new (SOCKET, shards - 1);
+	for (unsigned i = 0; i < shards - 1; i++)
+	{
+		const int v = 1;
+		const SOCKET s = socket (sock->family, SOCK_DGRAM, sock->protocol);
+		if (INVALID_SOCKET == s)
+			goto err_close;
+		sock->recv_shard_sock[ i ] = s;
+		sock->recv_shards++;
+		if (SOCKET_ERROR == setsockopt (s, SOL_SOCKET, SO_REUSEADDR, (const char*)&v, sizeof(v)) ||
+		    SOCKET_ERROR == setsockopt (s, SOL_SOCKET, SO_REUSEPORT, (const char*)&v, sizeof(v)) ||
+		    SOCKET_ERROR == setsockopt (s, SOL_SOCKET, SO_RCVBUF, (const char*)&rcvbuf, sizeof(rcvbuf)) ||
+		    SOCKET_ERROR == pgm_sockaddr_pktinfo (s, sock->family, TRUE))
+			goto err_close;
+#if defined(DISABLE_IP_MULTICAST_ALL)
+		const int ip_mcast_all = 0;
+		if (SOCKET_ERROR == setsockopt (s, IPPROTO_IP, IP_MULTICAST_ALL, (const char*)&ip_mcast_all, sizeof(ip_mcast_all)))
+			goto err_close;
+#endif
+		pgm_sockaddr_nonblocking (s, TRUE);
+	}
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Receiving on %u sharded sockets."), shards);
+	return TRUE;
+
+err_close: {
+		const int save_errno = pgm_get_last_sock_error();
+		pgm_recv_shards_close (sock);
+		pgm_set_last_sock_error (save_errno);
+	}
+	return FALSE;
+#else
+	pgm_set_last_sock_error (PGM_SOCK_EINVAL);
+	return FALSE;
+#endif /* PGM_HAVE_RECV_SHARDS */
+}
+
+/* bind the additional receive sockets to the address of the receive socket
+ * and install the steering filter on every shard.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error appropriately.
+ */
+
+bool
+pgm_recv_shards_bind (
+	pgm_sock_t*            const restrict sock,
+	const struct sockaddr* const restrict addr,
+	pgm_error_t**		     restrict error
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != addr);
+
+#ifdef PGM_HAVE_RECV_SHARDS
+	char errbuf[1024];
+	for (unsigned i = 1; i < sock->recv_shards; i++)
+	{
+		if (SOCKET_ERROR == bind (pgm_recv_shard_sock (sock, i), addr, pgm_sockaddr_len (addr)))
+		{
+			const int save_errno = pgm_get_last_sock_error();
+			char s[INET6_ADDRSTRLEN];
+			pgm_sockaddr_ntop (addr, s, sizeof(s));
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_SOCKET,
+				       pgm_error_from_sock_errno (save_errno),
+				       _("Binding receive shard %u to address %s: %s"),
+				       i, s,
+				       pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+			return FALSE;
+		}
+	}
+	for (unsigned i = 0; i < sock->recv_shards; i++)
+	{
+		if (SOCKET_ERROR == attach_filter (pgm_recv_shard_sock (sock, i), i, sock->recv_shards))
+		{
+			const int save_errno = pgm_get_last_sock_error();
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_SOCKET,
+				       pgm_error_from_sock_errno (save_errno),
+				       _("Attaching steering filter to receive shard %u: %s"),
+				       i,
+				       pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+			return FALSE;
+		}
+	}
+	return TRUE;
+#else
+	pgm_assert_cmpuint (sock->recv_shards, ==, 1);
+	return TRUE;
+#endif /* PGM_HAVE_RECV_SHARDS */
+}
+
+/* ask the kernel to deliver the traffic of each receive socket on the CPU
+ * configured for its shard, the list repeating for more shards than entries.
+ * steers unicast SO_REUSEPORT selection and keeps softirq processing on the
+ * core of the thread reading the shard.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error appropriately.
+ */
+
+bool
+pgm_recv_shards_set_cpu (
+	pgm_sock_t*   const restrict sock,
+	pgm_error_t**	    restrict error
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->incoming_cpu);
+	pgm_assert_cmpuint (sock->incoming_cpu_len, >, 0);
+
+#ifdef SO_INCOMING_CPU
+	char errbuf[1024];
+	for (unsigned i = 0; i < sock->recv_shards; i++)
+	{
+		const int cpu = sock->incoming_cpu[ i % sock->incoming_cpu_len ];
+		if (SOCKET_ERROR == setsockopt (pgm_recv_shard_sock (sock, i), SOL_SOCKET, SO_INCOMING_CPU, (const char*)&cpu, sizeof(cpu)))
+		{
+			const int save_errno = pgm_get_last_sock_error();
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_SOCKET,
+				       pgm_error_from_sock_errno (save_errno),
+				       _("Setting incoming CPU %d of receive shard %u: %s"),
+				       cpu, i,
+				       pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+			return FALSE;
+		}
+	}
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Receive shards steered to %u CPUs."), sock->incoming_cpu_len);
+	return TRUE;
+#else
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       PGM_ERROR_NOSYS,
+		       _("SO_INCOMING_CPU not supported."));
+	return FALSE;
+#endif /* SO_INCOMING_CPU */
+}
+
+void
+pgm_recv_shards_close (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	if (NULL == sock->recv_shard_sock)
+		return;
+	for (unsigned i = 1; i < sock->recv_shards; i++)
+		closesocket (pgm_recv_shard_sock (sock, i));
+	pgm_free (sock->recv_shard_sock);
+	sock->recv_shard_sock = NULL;
+	sock->recv_shards = 1;
+	sock->recv_shard_next = 0;
+}
+
+/* allocate the receiver state of shards, each with their own mutex.  peer
+ * tables and receive buffers are added on bind.
+ */
+
+void
+pgm_rx_shards_create (
+	pgm_sock_t* const	sock,
+	const unsigned		shards
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL == sock->rx_shard);
+	pgm_assert_cmpuint (shards, >, 0);
+	pgm_assert_cmpuint (shards, <=, PGM_RECV_SHARDS_MAX);
+
+	sock->rx_shard = pgm_new0 (struct pgm_rx_shard_t, shards);
+	for (unsigned i = 0; i < shards; i++) {
+		pgm_mutex_init (&sock->rx_shard[ i ].mutex);
+		pgm_mutex_set_name (&sock->rx_shard[ i ].mutex, "rx_shard_mutex");
+		sock->rx_shard[ i ].index = i;
+		sock->rx_shard[ i ].rx_cpu = -1;
+	}
+	sock->rx_shard_len  = shards;
+	sock->rx_shard_next = 0;
+}
+
+/* peers referenced by the tables are released by the caller through peers_list.
+ */
+
+void
+pgm_rx_shards_destroy (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	if (NULL == sock->rx_shard)
+		return;
+	for (unsigned i = 0; i < sock->rx_shard_len; i++)
+	{
+		struct pgm_rx_shard_t* shard = &sock->rx_shard[ i ];
+		if (shard->peers_table)
+			pgm_peer_table_destroy (shard->peers_table);
+		if (shard->peers_heap) {
+			pgm_free (shard->peers_heap);
+			pgm_free (shard->peers_heap_expiry);
+		}
+		if (shard->rx_buffer)
+			pgm_free_skb (shard->rx_buffer);
+		if (shard->nak_batch)
+			pgm_free (shard->nak_batch);
+		if (shard->conflate_table)
+			pgm_free (shard->conflate_table);
+		pgm_mutex_free (&shard->mutex);
+	}
+	pgm_free (sock->rx_shard);
+	sock->rx_shard = NULL;
+	sock->rx_shard_len = 0;
+}
+
+#ifdef PGM_HAVE_RECV_SHARDS
+/* read one datagram from the current shard, moving to the next shard when it
+ * is drained, such that a busy shard is read in runs.
+ *
+ * returns as per recvmsg(), failing with EAGAIN only when all shards are empty.
+ */
+
+ssize_t
+pgm_recv_shards_recvmsg (
+	pgm_sock_t*    const restrict sock,
+	struct msghdr* const restrict msg,
+	const int		      flags
+	)
+{
+	const socklen_t namelen	  = msg->msg_namelen;
+	const size_t controllen	  = msg->msg_controllen;
+	ssize_t len = SOCKET_ERROR;
+
+	for (unsigned i = 0; i < sock->recv_shards; i++)
+	{
+		len = recvmsg (pgm_recv_shard_sock (sock, sock->recv_shard_next), msg, flags);
+		if (len >= 0 || PGM_SOCK_EAGAIN != pgm_get_last_sock_error())
+			break;
+		if (++sock->recv_shard_next == sock->recv_shards)
+			sock->recv_shard_next = 0;
+		msg->msg_namelen    = namelen;
+		msg->msg_controllen = controllen;
+	}
+	return len;
+}
+#endif /* PGM_HAVE_RECV_SHARDS */
+
+/* eof */
@@ -0,0 +1,424 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * same-host transport through a shared memory ring.
+ *
+ * A publishing socket copies every packet it sends to the multicast group
+ * into a named ring, receiving sockets on the host read the ring ahead of the
+ * network such that the kernel UDP/IP path, multicast loopback and the PGM
+ * checksum are skipped.  Packets keep their PGM headers and pass through the
+ * regular receive path, TSI, sequence numbers, NAKs and loss reporting are
+ * unchanged.  A receiver lapped by the publisher loses the overwritten
+ * packets as it would drop them on a full socket buffer.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#ifndef _WIN32
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/shm.h>
+
+
+//#define SHM_DEBUG
+
+#ifndef SHM_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+#ifdef PGM_HAVE_SHM
+
+/* map an existing ring of a publisher, a missing ring is not an error as the
+ * publisher may start later.
+ *
+ * returns TRUE when mapped.
+ */
+
+static
+bool
+shm_attach (
+	struct pgm_shm_t*	shm
+	)
+{
+	struct stat st;
+	const int fd = shm_open (shm->name, O_RDONLY, 0);
+	if (-1 == fd)
+		return FALSE;
+	if (0 != fstat (fd, &st) || (size_t)st.st_size < PGM_SHM_HEADER_LEN) {
+		close (fd);
+		return FALSE;
+	}
+	struct pgm_shm_ring_t* ring = mmap (NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close (fd);
+	if (MAP_FAILED == ring)
+		return FALSE;
+/* magic is published last */
+	if (PGM_SHM_MAGIC != __atomic_load_n (&ring->magic, __ATOMIC_ACQUIRE) ||
+	    PGM_SHM_VERSION != ring->version ||
+	    0 == ring->slots ||
+	    PGM_SHM_HEADER_LEN + (size_t)ring->slots * ring->slot_len > (size_t)st.st_size ||
+	    __atomic_load_n (&ring->is_closed, __ATOMIC_ACQUIRE))
+	{
+		munmap (ring, (size_t)st.st_size);
+		return FALSE;
+	}
+	shm->ring    = ring;
+	shm->map_len = (size_t)st.st_size;
+/* join at the current head as a multicast receiver joins mid-stream */
+	shm->cursor  = __atomic_load_n (&ring->head, __ATOMIC_ACQUIRE);
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Attached to shared memory ring %s of publisher %" PRIu32 "."),
+		   shm->name, ring->pid);
+	return TRUE;
+}
+
+static
+void
+shm_detach (
+	struct pgm_shm_t*	shm
+	)
+{
+	if (NULL == shm->ring)
+		return;
+	munmap (shm->ring, shm->map_len);
+	shm->ring = NULL;
+	shm->map_len = 0;
+}
+
+/* create the ring of a publishing socket, replacing any left by a publisher
+ * that did not close.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error appropriately.
+ */
+
+static
+bool
+shm_create (
+	pgm_sock_t*	    const restrict sock,
+	struct pgm_shm_t*   const restrict shm,
+	pgm_error_t**		  restrict error
+	)
+{
+	char errbuf[1024];
+	struct stat st;
+	const char* what;
+	unsigned slots = sock->shm_slots ? sock->shm_slots : PGM_SHM_SLOTS_DEFAULT;
+/* round up to a power of two for the slot mask */
+	while (0 != (slots & (slots - 1)))
+		slots = (slots | (slots - 1)) + 1;
+	const size_t slot_len = (sizeof (struct pgm_shm_slot_t) + sock->max_tpdu + 63) & ~(size_t)63;	/* cache line */
+	const size_t len = PGM_SHM_HEADER_LEN + slots * slot_len;
+
+	shm_unlink (shm->name);
+	const int fd = shm_open (shm->name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (-1 == fd) {
+		what = _("Creating");
+		goto err_errno;
+	}
+	if (0 != ftruncate (fd, len) || 0 != fstat (fd, &st)) {
+		what = _("Sizing");
+		const int save_errno = errno;
+		close (fd);
+		shm_unlink (shm->name);
+		errno = save_errno;
+		goto err_errno;
+	}
+	struct pgm_shm_ring_t* ring = mmap (NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close (fd);
+	if (MAP_FAILED == ring) {
+		what = _("Mapping");
+		const int save_errno = errno;
+		shm_unlink (shm->name);
+		errno = save_errno;
+		goto err_errno;
+	}
+
+	ring->version	= PGM_SHM_VERSION;
+	ring->slots	= slots;
+	ring->slot_len	= (uint32_t)slot_len;
+	ring->pid	= (uint32_t)getpid();
+	memcpy (&ring->src, &sock->send_addr, pgm_sockaddr_len ((const struct sockaddr*)&sock->send_addr));
+	__atomic_store_n (&ring->magic, PGM_SHM_MAGIC, __ATOMIC_RELEASE);
+
+	shm->ring    = ring;
+	shm->map_len = len;
+	shm->ino     = st.st_ino;
+	pgm_minor (_("Publishing to shared memory ring %s of %u packets."), shm->name, slots);
+	return TRUE;
+
+err_errno:
+	{
+		const int save_errno = errno;
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_errno (save_errno),
+			       _("%s shared memory ring %s: %s"),
+			       what, shm->name,
+			       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+	}
+	return FALSE;
+}
+
+#endif /* PGM_HAVE_SHM */
+
+/* create the ring of a socket that sends data, otherwise attach a receiving
+ * socket to the ring when present.  Called from pgm_bind() with sock::shm_name
+ * set.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error appropriately.
+ */
+
+bool
+pgm_shm_open (
+	pgm_sock_t*    const restrict sock,
+	pgm_error_t**	     restrict error
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->shm_name);
+	pgm_assert (NULL == sock->shm);
+
+#ifdef PGM_HAVE_SHM
+	struct pgm_shm_t* shm = pgm_new0 (struct pgm_shm_t, 1);
+	shm->name	= pgm_strdup (sock->shm_name);
+	shm->is_writer	= sock->can_send_data;
+	shm->interval	= sock->shm_interval ? sock->shm_interval : PGM_SHM_INTERVAL_DEFAULT;
+	pgm_mutex_init (&shm->mutex);
+	sock->shm = shm;
+
+	if (shm->is_writer) {
+		if (!shm_create (sock, shm, error)) {
+			pgm_shm_close (sock);
+			return FALSE;
+		}
+	} else if (!shm_attach (shm)) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Shared memory ring %s not yet published."), shm->name);
+		shm->next_attach = pgm_time_update_now() + PGM_SHM_ATTACH_INTERVAL;
+	}
+	return TRUE;
+#else
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       PGM_ERROR_NOSYS,
+		       _("Shared memory transport unavailable on this platform."));
+	return FALSE;
+#endif /* PGM_HAVE_SHM */
+}
+
+void
+pgm_shm_close (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+#ifdef PGM_HAVE_SHM
+	struct pgm_shm_t* shm = sock->shm;
+	if (NULL == shm)
+		return;
+	if (shm->is_writer && NULL != shm->ring) {
+/* readers return to waiting for a publisher */
+		__atomic_store_n (&shm->ring->is_closed, 1, __ATOMIC_RELEASE);
+		struct stat st;
+		const int fd = shm_open (shm->name, O_RDONLY, 0);
+		if (-1 != fd) {
+			if (0 == fstat (fd, &st) && st.st_ino == shm->ino)
+				shm_unlink (shm->name);
+			close (fd);
+		}
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Published %" PRIu64 " packets to shared memory ring %s."),
+			   __atomic_load_n (&shm->ring->head, __ATOMIC_RELAXED), shm->name);
+	} else if (!shm->is_writer) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Read %" PRIu64 " packets from shared memory ring %s, %" PRIu64 " overrun."),
+			   shm->packets, shm->name, shm->overruns);
+	}
+	shm_detach (shm);
+	pgm_mutex_free (&shm->mutex);
+	pgm_free (shm->name);
+	pgm_free (shm);
+	sock->shm = NULL;
+#endif
+}
+
+/* copy a packet sent to the multicast group into the ring, packets of other
+ * destinations or larger than a slot are network only.  The copy carries no
+ * PGM checksum, the ring is not subject to corruption in transit.
+ */
+
+void
+pgm_shm_write (
+	pgm_sock_t*	       const restrict sock,
+	const void*		     restrict buf,
+	const size_t			      len,
+	const struct sockaddr* const restrict to
+	)
+{
+	struct pgm_shm_t* shm = sock->shm;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != shm);
+	pgm_assert (NULL != buf);
+	pgm_assert (len >= sizeof (struct pgm_header));
+	pgm_assert (NULL != to);
+
+#ifdef PGM_HAVE_SHM
+	struct pgm_shm_ring_t* ring = shm->ring;
+	if (!shm->is_writer || NULL == ring)
+		return;
+	if (PGM_UNLIKELY(len > ring->slot_len - sizeof (struct pgm_shm_slot_t)))
+		return;
+	if (to != (const struct sockaddr*)&sock->send_gsr.gsr_group &&
+	    0 != pgm_sockaddr_cmp (to, (const struct sockaddr*)&sock->send_gsr.gsr_group))
+		return;
+
+	pgm_mutex_lock (&shm->mutex);
+/* the send group is set after pgm_bind(), readers see it with the first packet */
+	if (PGM_UNLIKELY(AF_UNSPEC == ring->dst.ss_family))
+		memcpy (&ring->dst, to, pgm_sockaddr_len (to));
+	const uint64_t n = ring->head;
+	struct pgm_shm_slot_t* slot = pgm_shm_slot (ring, n);
+	__atomic_store_n (&slot->seq, 2 * n + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence (__ATOMIC_RELEASE);
+	memcpy (slot->data, buf, len);
+	((struct pgm_header*)slot->data)->pgm_checksum = 0;
+	slot->len = (uint16_t)len;
+	__atomic_store_n (&slot->seq, 2 * n + 2, __ATOMIC_RELEASE);
+	__atomic_store_n (&ring->head, n + 1, __ATOMIC_RELEASE);
+	pgm_mutex_unlock (&shm->mutex);
+#else
+	(void)buf;
+	(void)len;
+	(void)to;
+#endif
+}
+
+/* read the next packet of the ring into a PGM skbuff, the PGM header onwards
+ * with the publisher and group addresses, as recvskb() would from a UDP
+ * encapsulated socket.
+ *
+ * on success returns packet length, when the ring is empty or not attached
+ * returns -1 for the caller to read the network.
+ */
+
+ssize_t
+pgm_shm_recvskb (
+	pgm_sock_t*           const restrict sock,
+	struct pgm_sk_buff_t* const restrict skb,
+	struct sockaddr*      const restrict src_addr,
+	const socklen_t			     src_addrlen,
+	struct sockaddr*      const restrict dst_addr,
+	const socklen_t			     dst_addrlen
+	)
+{
+	struct pgm_shm_t* shm = sock->shm;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != shm);
+	pgm_assert (NULL != skb);
+	pgm_assert (NULL != src_addr);
+	pgm_assert (src_addrlen >= sizeof(struct sockaddr_storage));
+	pgm_assert (NULL != dst_addr);
+	pgm_assert (dst_addrlen >= sizeof(struct sockaddr_storage));
+
+#ifdef PGM_HAVE_SHM
+	if (shm->is_writer)
+		return -1;
+	if (NULL == shm->ring) {
+		const pgm_time_t now = pgm_time_update_now();
+		if (pgm_time_after (shm->next_attach, now))
+			return -1;
+		shm->next_attach = now + PGM_SHM_ATTACH_INTERVAL;
+		if (!shm_attach (shm))
+			return -1;
+	}
+
+	const struct pgm_shm_ring_t* ring = shm->ring;
+	for (;;)
+	{
+		const uint64_t head = __atomic_load_n (&ring->head, __ATOMIC_ACQUIRE);
+		if (shm->cursor == head) {
+/* publisher gone, wait for the next one */
+			if (__atomic_load_n (&ring->is_closed, __ATOMIC_ACQUIRE)) {
+				pgm_trace (PGM_LOG_ROLE_NETWORK,_("Shared memory ring %s closed by publisher."), shm->name);
+				shm_detach (shm);
+				shm->next_attach = pgm_time_update_now() + PGM_SHM_ATTACH_INTERVAL;
+			}
+			return -1;
+		}
+/* lapped, skip to the oldest packet still held */
+		if (PGM_UNLIKELY(head - shm->cursor > ring->slots)) {
+			shm->overruns += head - ring->slots - shm->cursor;
+			shm->cursor = head - ring->slots;
+		}
+
+		const struct pgm_shm_slot_t* slot = pgm_shm_slot (ring, shm->cursor);
+		const uint64_t seq = __atomic_load_n (&slot->seq, __ATOMIC_ACQUIRE);
+		const uint16_t len = slot->len;
+		if (PGM_UNLIKELY(seq != 2 * shm->cursor + 2) ||
+		    PGM_UNLIKELY(len > sock->max_tpdu) ||
+		    PGM_UNLIKELY(len < sizeof (struct pgm_header)))
+		{
+			shm->overruns++;
+			shm->cursor++;
+			continue;
+		}
+		memcpy (skb->head, slot->data, len);
+/* re-written whilst copying */
+		__atomic_thread_fence (__ATOMIC_ACQUIRE);
+		if (PGM_UNLIKELY(__atomic_load_n (&slot->seq, __ATOMIC_RELAXED) != seq)) {
+			shm->overruns++;
+			shm->cursor++;
+			continue;
+		}
+		shm->cursor++;
+		shm->packets++;
+
+		memcpy (src_addr, &ring->src, pgm_sockaddr_len ((const struct sockaddr*)&ring->src));
+		memcpy (dst_addr, &ring->dst, pgm_sockaddr_len ((const struct sockaddr*)&ring->dst));
+		skb->sock		= sock;
+		skb->tstamp		= pgm_time_coarse_now();
+		skb->rx_tstamp		= 0;
+		skb->data		= skb->head;
+		skb->len		= len;
+		skb->zero_padded	= 0;
+		skb->tail		= (char*)skb->data + skb->len;
+		return skb->len;
+	}
+#else
+	(void)skb;
+	(void)src_addr;
+	(void)src_addrlen;
+	(void)dst_addr;
+	(void)dst_addrlen;
+	return -1;
+#endif /* PGM_HAVE_SHM */
+}
+
+/* eof */
@@ -0,0 +1,467 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * unit tests for the same-host shared memory transport.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib.h>
+#include <check.h>
+
+
+/* mock state */
+
+#define TEST_MAX_TPDU		1500
+#define TEST_SLOTS		8
+#define TEST_PACKET_LEN		100
+
+static char		mock_shm_name[ 64 ];
+
+#define pgm_time_update_now	mock_pgm_time_update_now
+
+#define SHM_DEBUG
+#include "shm.c"
+
+static pgm_time_t mock_pgm_time_now = 0x1;
+static pgm_time_t _mock_pgm_time_update_now (void);
+pgm_time_update_func mock_pgm_time_update_now = _mock_pgm_time_update_now;
+
+PGM_GNUC_INTERNAL
+int
+pgm_get_nprocs (void)
+{
+	return 1;
+}
+
+static
+void
+mock_setup (void)
+{
+	if (!g_thread_supported ()) g_thread_init (NULL);
+	mock_pgm_time_now = 0x1;
+	snprintf (mock_shm_name, sizeof (mock_shm_name), "/pgm-shm-unittest-%d", (int)getpid());
+	shm_unlink (mock_shm_name);
+}
+
+static
+void
+mock_teardown (void)
+{
+	shm_unlink (mock_shm_name);
+}
+
+static
+pgm_sock_t*
+generate_sock (
+	const bool		can_send_data
+	)
+{
+	pgm_sock_t* sock = g_new0 (pgm_sock_t, 1);
+	sock->can_send_data	= can_send_data;
+	sock->max_tpdu		= TEST_MAX_TPDU;
+	sock->shm_name		= mock_shm_name;
+	sock->shm_slots		= TEST_SLOTS - 3;
+	struct sockaddr_in* src = (struct sockaddr_in*)&sock->send_addr;
+	src->sin_family		= AF_INET;
+	src->sin_addr.s_addr	= inet_addr ("172.16.0.1");
+	struct sockaddr_in* group = (struct sockaddr_in*)&sock->send_gsr.gsr_group;
+	group->sin_family	= AF_INET;
+	group->sin_addr.s_addr	= inet_addr ("239.192.0.1");
+	return sock;
+}
+
+/* PGM header of an ODATA packet stamped with sequence in the payload */
+static
+void
+generate_packet (
+	char*			buf,
+	const uint32_t		sequence
+	)
+{
+	memset (buf, 0, TEST_PACKET_LEN);
+	struct pgm_header* header = (struct pgm_header*)buf;
+	header->pgm_type	= PGM_ODATA;
+	header->pgm_checksum	= 0xffff;
+	memcpy (buf + sizeof (struct pgm_header), &sequence, sizeof (sequence));
+}
+
+/* mock functions for external references */
+
+static
+pgm_time_t
+_mock_pgm_time_update_now (void)
+{
+	return mock_pgm_time_now;
+}
+
+
+/* target:
+ *	bool
+ *	pgm_shm_open (
+ *		pgm_sock_t*		sock,
+ *		pgm_error_t**		error
+ *		)
+ */
+
+/* publisher creates the ring rounded up to a power of two slots */
+START_TEST (test_open_pass_001)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = generate_sock (TRUE);
+	fail_unless (TRUE == pgm_shm_open (sock, &err), "open failed");
+	fail_unless (NULL == err, "error raised");
+	fail_if (NULL == sock->shm, "shm not set");
+	fail_unless (sock->shm->is_writer, "is_writer failed");
+	const struct pgm_shm_ring_t* ring = sock->shm->ring;
+	fail_if (NULL == ring, "ring not mapped");
+	fail_unless (PGM_SHM_MAGIC == ring->magic, "magic failed");
+	fail_unless (PGM_SHM_VERSION == ring->version, "version failed");
+	fail_unless (TEST_SLOTS == ring->slots, "slots failed");
+	fail_unless (0 == ring->slot_len % 64, "slot_len failed");
+	fail_unless (ring->slot_len >= sizeof (struct pgm_shm_slot_t) + TEST_MAX_TPDU, "slot_len failed");
+	fail_unless (0 == pgm_sockaddr_cmp ((const struct sockaddr*)&ring->src, (const struct sockaddr*)&sock->send_addr), "src failed");
+	fail_unless (AF_UNSPEC == ring->dst.ss_family, "dst failed");
+	pgm_shm_close (sock);
+	fail_unless (NULL == sock->shm, "shm not cleared");
+/* segment unlinked */
+	fail_unless (-1 == shm_open (mock_shm_name, O_RDONLY, 0), "ring not unlinked");
+}
+END_TEST
+
+/* receiver waits for a publisher that has not started */
+START_TEST (test_open_pass_002)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = generate_sock (FALSE);
+	fail_unless (TRUE == pgm_shm_open (sock, &err), "open failed");
+	fail_unless (NULL == err, "error raised");
+	fail_unless (pgm_shm_is_reader (sock->shm), "is_reader failed");
+	fail_unless (NULL == sock->shm->ring, "ring mapped");
+	fail_unless (mock_pgm_time_now + PGM_SHM_ATTACH_INTERVAL == sock->shm->next_attach, "next_attach failed");
+	fail_if (pgm_shm_is_readable (sock->shm), "is_readable failed");
+	mock_pgm_time_now += PGM_SHM_ATTACH_INTERVAL;
+	fail_unless (pgm_shm_is_readable (sock->shm), "is_readable failed");
+	pgm_shm_close (sock);
+}
+END_TEST
+
+/* receiver joins at the head of a published ring */
+START_TEST (test_open_pass_003)
+{
+	char buf[ TEST_PACKET_LEN ];
+	pgm_sock_t* publisher = generate_sock (TRUE);
+	fail_unless (TRUE == pgm_shm_open (publisher, NULL), "open failed");
+	generate_packet (buf, 1);
+	pgm_shm_write (publisher, buf, sizeof (buf), (const struct sockaddr*)&publisher->send_gsr.gsr_group);
+	pgm_sock_t* sock = generate_sock (FALSE);
+	fail_unless (TRUE == pgm_shm_open (sock, NULL), "open failed");
+	fail_if (NULL == sock->shm->ring, "ring not mapped");
+	fail_unless (1 == sock->shm->cursor, "cursor failed");
+	fail_if (pgm_shm_is_readable (sock->shm), "is_readable failed");
+	pgm_shm_close (sock);
+	pgm_shm_close (publisher);
+}
+END_TEST
+
+START_TEST (test_open_fail_001)
+{
+	pgm_shm_open (NULL, NULL);
+	fail ("reached");
+}
+END_TEST
+
+/* target:
+ *	void
+ *	pgm_shm_write (
+ *		pgm_sock_t*		sock,
+ *		const void*		buf,
+ *		const size_t		len,
+ *		const struct sockaddr*	to
+ *		)
+ */
+
+/* packets to the group only, checksum cleared */
+START_TEST (test_write_pass_001)
+{
+	char buf[ TEST_PACKET_LEN ];
+	pgm_sock_t* sock = generate_sock (TRUE);
+	fail_unless (TRUE == pgm_shm_open (sock, NULL), "open failed");
+	const struct pgm_shm_ring_t* ring = sock->shm->ring;
+	struct sockaddr_in unicast = {
+		.sin_family		= AF_INET,
+		.sin_addr.s_addr	= inet_addr ("172.16.0.2")
+	};
+	generate_packet (buf, 1);
+	pgm_shm_write (sock, buf, sizeof (buf), (const struct sockaddr*)&unicast);
+	fail_unless (0 == ring->head, "unicast written");
+	fail_unless (AF_UNSPEC == ring->dst.ss_family, "dst failed");
+	pgm_shm_write (sock, buf, sizeof (buf), (const struct sockaddr*)&sock->send_gsr.gsr_group);
+	fail_unless (1 == ring->head, "head failed");
+	fail_unless (0 == pgm_sockaddr_cmp ((const struct sockaddr*)&ring->dst, (const struct sockaddr*)&sock->send_gsr.gsr_group), "dst failed");
+	const struct pgm_shm_slot_t* slot = pgm_shm_slot (ring, 0);
+	fail_unless (2 == slot->seq, "slot seq failed");
+	fail_unless (TEST_PACKET_LEN == slot->len, "slot len failed");
+	fail_unless (0 == ((const struct pgm_header*)slot->data)->pgm_checksum, "checksum not cleared");
+	fail_unless (0 == memcmp (slot->data + sizeof (struct pgm_header), buf + sizeof (struct pgm_header), TEST_PACKET_LEN - sizeof (struct pgm_header)), "payload failed");
+	pgm_shm_close (sock);
+}
+END_TEST
+
+/* packets larger than a slot are network only */
+START_TEST (test_write_pass_002)
+{
+	char* buf = g_malloc0 (TEST_MAX_TPDU * 2);
+	pgm_sock_t* sock = generate_sock (TRUE);
+	fail_unless (TRUE == pgm_shm_open (sock, NULL), "open failed");
+	const struct pgm_shm_ring_t* ring = sock->shm->ring;
+	const size_t len = ring->slot_len - sizeof (struct pgm_shm_slot_t) + 1;
+	pgm_shm_write (sock, buf, len, (const struct sockaddr*)&sock->send_gsr.gsr_group);
+	fail_unless (0 == ring->head, "oversized written");
+	pgm_shm_close (sock);
+	g_free (buf);
+}
+END_TEST
+
+START_TEST (test_write_fail_001)
+{
+	pgm_sock_t* sock = generate_sock (TRUE);
+	fail_unless (TRUE == pgm_shm_open (sock, NULL), "open failed");
+	pgm_shm_write (sock, NULL, TEST_PACKET_LEN, (const struct sockaddr*)&sock->send_gsr.gsr_group);
+	fail ("reached");
+}
+END_TEST
+
+/* target:
+ *	ssize_t
+ *	pgm_shm_recvskb (
+ *		pgm_sock_t*		sock,
+ *		struct pgm_sk_buff_t*	skb,
+ *		struct sockaddr*	src_addr,
+ *		const socklen_t		src_addrlen,
+ *		struct sockaddr*	dst_addr,
+ *		const socklen_t		dst_addrlen
+ *		)
+ */
+
+/* packets read in order with publisher and group addresses */
+START_TEST (test_recvskb_pass_001)
+{
+	char buf[ TEST_PACKET_LEN ];
+	struct sockaddr_storage src, dst;
+	uint32_t sequence;
+	pgm_sock_t* publisher = generate_sock (TRUE);
+	fail_unless (TRUE == pgm_shm_open (publisher, NULL), "open failed");
+	pgm_sock_t* sock = generate_sock (FALSE);
+	fail_unless (TRUE == pgm_shm_open (sock, NULL), "open failed");
+	struct pgm_sk_buff_t* skb = pgm_alloc_skb (TEST_MAX_TPDU);
+	fail_unless (-1 == pgm_shm_recvskb (sock, skb, (struct sockaddr*)&src, sizeof (src), (struct sockaddr*)&dst, sizeof (dst)), "recvskb failed");
+	for (uint32_t i = 0; i < 2; i++) {
+		generate_packet (buf, i);
+		pgm_shm_write (publisher, buf, sizeof (buf), (const struct sockaddr*)&publisher->send_gsr.gsr_group);
+	}
+	fail_unless (pgm_shm_is_readable (sock->shm), "is_readable failed");
+	for (uint32_t i = 0; i < 2; i++) {
+		memset (&src, 0, sizeof (src));
+		memset (&dst, 0, sizeof (dst));
+		fail_unless (TEST_PACKET_LEN == pgm_shm_recvskb (sock, skb, (struct sockaddr*)&src, sizeof (src), (struct sockaddr*)&dst, sizeof (dst)), "recvskb failed");
+		fail_unless (sock == skb->sock, "sock failed");
+		fail_unless (TEST_PACKET_LEN == skb->len, "len failed");
+		fail_unless (skb->head == skb->data, "data failed");
+		memcpy (&sequence, (char*)skb->data + sizeof (struct pgm_header), sizeof (sequence));
+		fail_unless (i == sequence, "sequence failed");
+		fail_unless (0 == pgm_sockaddr_cmp ((struct sockaddr*)&src, (const struct sockaddr*)&publisher->send_addr), "src failed");
+		fail_unless (0 == pgm_sockaddr_cmp ((struct sockaddr*)&dst, (const struct sockaddr*)&publisher->send_gsr.gsr_group), "dst failed");
+	}
+	fail_unless (-1 == pgm_shm_recvskb (sock, skb, (struct sockaddr*)&src, sizeof (src), (struct sockaddr*)&dst, sizeof (dst)), "recvskb failed");
+	fail_unless (2 == sock->shm->packets, "packets failed");
+	fail_unless (0 == sock->shm->overruns, "overruns failed");
+	pgm_free_skb (skb);
+	pgm_shm_close (sock);
+	pgm_shm_close (publisher);
+}
+END_TEST
+
+/* lapped reader skips to the oldest packet held */
+START_TEST (test_recvskb_pass_002)
+{
+	char buf[ TEST_PACKET_LEN ];
+	struct sockaddr_storage src, dst;
+	uint32_t sequence;
+	pgm_sock_t* publisher = generate_sock (TRUE);
+	fail_unless (TRUE == pgm_shm_open (publisher, NULL), "open failed");
+	pgm_sock_t* sock = generate_sock (FALSE);
+	fail_unless (TRUE == pgm_shm_open (sock, NULL), "open failed");
+	struct pgm_sk_buff_t* skb = pgm_alloc_skb (TEST_MAX_TPDU);
+	for (uint32_t i = 0; i < TEST_SLOTS + 3; i++) {
+		generate_packet (buf, i);
+		pgm_shm_write (publisher, buf, sizeof (buf), (const struct sockaddr*)&publisher->send_gsr.gsr_group);
+	}
+	fail_unless (TEST_PACKET_LEN == pgm_shm_recvskb (sock, skb, (struct sockaddr*)&src, sizeof (src), (struct sockaddr*)&dst, sizeof (dst)), "recvskb failed");
+	memcpy (&sequence, (char*)skb->data + sizeof (struct pgm_header), sizeof (sequence));
+	fail_unless (3 == sequence, "sequence failed");
+	fail_unless (3 == sock->shm->overruns, "overruns failed");
+	pgm_free_skb (skb);
+	pgm_shm_close (sock);
+	pgm_shm_close (publisher);
+}
+END_TEST
+
+/* reader detaches when the publisher closes and attaches to the next */
+START_TEST (test_recvskb_pass_003)
+{
+	char buf[ TEST_PACKET_LEN ];
+	struct sockaddr_storage src, dst;
+	pgm_sock_t* publisher = generate_sock (TRUE);
+	fail_unless (TRUE == pgm_shm_open (publisher, NULL), "open failed");
+	pgm_sock_t* sock = generate_sock (FALSE);
+	fail_unless (TRUE == pgm_shm_open (sock, NULL), "open failed");
+	struct pgm_sk_buff_t* skb = pgm_alloc_skb (TEST_MAX_TPDU);
+	pgm_shm_close (publisher);
+	fail_unless (-1 == pgm_shm_recvskb (sock, skb, (struct sockaddr*)&src, sizeof (src), (struct sockaddr*)&dst, sizeof (dst)), "recvskb failed");
+	fail_unless (NULL == sock->shm->ring, "ring not detached");
+	publisher = generate_sock (TRUE);
+	fail_unless (TRUE == pgm_shm_open (publisher, NULL), "open failed");
+/* attach not yet due */
+	fail_unless (-1 == pgm_shm_recvskb (sock, skb, (struct sockaddr*)&src, sizeof (src), (struct sockaddr*)&dst, sizeof (dst)), "recvskb failed");
+	fail_unless (NULL == sock->shm->ring, "ring attached");
+	mock_pgm_time_now += PGM_SHM_ATTACH_INTERVAL;
+	fail_unless (-1 == pgm_shm_recvskb (sock, skb, (struct sockaddr*)&src, sizeof (src), (struct sockaddr*)&dst, sizeof (dst)), "recvskb failed");
+	fail_if (NULL == sock->shm->ring, "ring not attached");
+	generate_packet (buf, 0);
+	pgm_shm_write (publisher, buf, sizeof (buf), (const struct sockaddr*)&publisher->send_gsr.gsr_group);
+	fail_unless (TEST_PACKET_LEN == pgm_shm_recvskb (sock, skb, (struct sockaddr*)&src, sizeof (src), (struct sockaddr*)&dst, sizeof (dst)), "recvskb failed");
+	pgm_free_skb (skb);
+	pgm_shm_close (sock);
+	pgm_shm_close (publisher);
+}
+END_TEST
+
+START_TEST (test_recvskb_fail_001)
+{
+	struct sockaddr_storage src, dst;
+	pgm_sock_t* sock = generate_sock (FALSE);
+	fail_unless (TRUE == pgm_shm_open (sock, NULL), "open failed");
+	pgm_shm_recvskb (sock, NULL, (struct sockaddr*)&src, sizeof (src), (struct sockaddr*)&dst, sizeof (dst));
+	fail ("reached");
+}
+END_TEST
+
+/* target:
+ *	void
+ *	pgm_shm_close (
+ *		pgm_sock_t*		sock
+ *		)
+ */
+
+/* closing a publisher leaves a replacement ring in place */
+START_TEST (test_close_pass_001)
+{
+	pgm_sock_t* publisher = generate_sock (TRUE);
+	fail_unless (TRUE == pgm_shm_open (publisher, NULL), "open failed");
+	pgm_sock_t* replacement = generate_sock (TRUE);
+	fail_unless (TRUE == pgm_shm_open (replacement, NULL), "open failed");
+	pgm_shm_close (publisher);
+	const int fd = shm_open (mock_shm_name, O_RDONLY, 0);
+	fail_if (-1 == fd, "replacement unlinked");
+	close (fd);
+	pgm_shm_close (replacement);
+	fail_unless (-1 == shm_open (mock_shm_name, O_RDONLY, 0), "ring not unlinked");
+}
+END_TEST
+
+START_TEST (test_close_fail_001)
+{
+	pgm_shm_close (NULL);
+	fail ("reached");
+}
+END_TEST
+
+
+static
+Suite*
+make_test_suite (void)
+{
+	Suite* s;
+
+	s = suite_create (__FILE__);
+
+	TCase* tc_open = tcase_create ("open");
+	suite_add_tcase (s, tc_open);
+	tcase_add_checked_fixture (tc_open, mock_setup, mock_teardown);
+	tcase_add_test (tc_open, test_open_pass_001);
+	tcase_add_test (tc_open, test_open_pass_002);
+	tcase_add_test (tc_open, test_open_pass_003);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_open, test_open_fail_001, SIGABRT);
+#endif
+
+	TCase* tc_write = tcase_create ("write");
+	suite_add_tcase (s, tc_write);
+	tcase_add_checked_fixture (tc_write, mock_setup, mock_teardown);
+	tcase_add_test (tc_write, test_write_pass_001);
+	tcase_add_test (tc_write, test_write_pass_002);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_write, test_write_fail_001, SIGABRT);
+#endif
+
+	TCase* tc_recvskb = tcase_create ("recvskb");
+	suite_add_tcase (s, tc_recvskb);
+	tcase_add_checked_fixture (tc_recvskb, mock_setup, mock_teardown);
+	tcase_add_test (tc_recvskb, test_recvskb_pass_001);
+	tcase_add_test (tc_recvskb, test_recvskb_pass_002);
+	tcase_add_test (tc_recvskb, test_recvskb_pass_003);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_recvskb, test_recvskb_fail_001, SIGABRT);
+#endif
+
+	TCase* tc_close = tcase_create ("close");
+	suite_add_tcase (s, tc_close);
+	tcase_add_checked_fixture (tc_close, mock_setup, mock_teardown);
+	tcase_add_test (tc_close, test_close_pass_001);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_close, test_close_fail_001, SIGABRT);
+#endif
+	return s;
+}
+
+static
+Suite*
+make_master_suite (void)
+{
+	Suite* s = suite_create ("Master");
+	return s;
+}
+
+int
+main (void)
+{
+	SRunner* sr = srunner_create (make_master_suite ());
+	srunner_add_suite (sr, make_test_suite ());
+	srunner_run_all (sr, CK_ENV);
+	int number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* eof */
@@ -23,6 +23,7 @@
 #	include <config.h>
 #endif
 #include <impl/framework.h>
+#include <impl/mem.h>
 #include "pgm/skbuff.h"
 
 
@@ -48,6 +49,469 @@ pgm_skb_under_panic (
 	pgm_assert_not_reached();
 }
 
+/* take every buffer pushed onto the return list, safe against ABA as the list
+ * is only ever swapped for NULL.
+ */
+
+static
+pgm_list_t*
+take_return_list (
+	pgm_skb_pool_t*const	pool
+	)
+{
+	void* head;
+	do {
+		head = pool->return_list;
+	} while (NULL != head &&
+		 !pgm_atomic_compare_and_exchange_pointer (&pool->return_list, head, NULL));
+	return (pgm_list_t*)head;
+}
+
+/* buffer carved from the mapped region of the pool rather than the heap.
+ */
+
+static inline
+bool
+pool_owns_skb (
+	const pgm_skb_pool_t*const	pool,
+	const void*const		skb
+	)
+{
+	return (const char*)skb >= (const char*)pool->region.addr &&
+	       (const char*)skb <  (const char*)pool->region.addr + pool->region.len;
+}
+
+static
+void
+free_skb_list (
+	pgm_skb_pool_t*const	pool,
+	pgm_list_t*		list
+	)
+{
+	while (list) {
+		pgm_list_t* next = list->next;
+		if (!pool_owns_skb (pool, list))
+			pgm_free (list);
+		list = next;
+	}
+}
+
+static
+void
+pgm_skb_pool_free (
+	pgm_skb_pool_t*const	pool
+	)
+{
+	pgm_debug ("freeing skb pool (hits:%" PRIu32 " misses:%" PRIu32 ").",
+		   pool->hits, pool->misses);
+	free_skb_list (pool, pool->free_list);
+	free_skb_list (pool, take_return_list (pool));
+	if (!pool->is_external)
+		pgm_mem_region_unmap (&pool->region);
+	pgm_spinlock_free (&pool->lock);
+	pgm_free (pool);
+}
+
+/* push count buffers of the mapped region onto the free list.
+ */
+
+static
+void
+pool_carve (
+	pgm_skb_pool_t*const	pool,
+	const unsigned		count
+	)
+{
+	pgm_spinlock_lock (&pool->lock);
+	for (unsigned i = 0; i < count; i++) {
+		pgm_list_t* link = (pgm_list_t*)((char*)pool->region.addr + i * pool->slot_size);
+		link->next = pool->free_list;
+		pool->free_list = link;
+	}
+	pgm_spinlock_unlock (&pool->lock);
+	pgm_atomic_add32 (&pool->cached, count);
+}
+
+/* create slab of fixed size buffers of size payload bytes, holding at most
+ * max_cached idle buffers for re-use.
+ */
+
+PGM_GNUC_INTERNAL
+pgm_skb_pool_t*
+pgm_skb_pool_create (
+	const uint16_t		size,
+	const unsigned		max_cached
+	)
+{
+	pgm_skb_pool_t* pool;
+
+	pgm_debug ("pgm_skb_pool_create (size:%" PRIu16 " max-cached:%u)",
+		   size, max_cached);
+
+	pool = pgm_new0 (pgm_skb_pool_t, 1);
+	pool->size = size;
+	pool->slot_size = (sizeof(struct pgm_sk_buff_t) + size + 63) & ~(size_t)63;
+	pgm_atomic_write32 (&pool->max_cached, max_cached);
+	pgm_atomic_write32 (&pool->ref_count, 1);
+	pgm_spinlock_init (&pool->lock);
+	pgm_spinlock_set_name (&pool->lock, "skb_pool");
+	return pool;
+}
+
+/* carve count idle buffers from one mapped region, on huge pages of page_size
+ * bytes when non-zero and prefaulted and locked with use_mlock.  region
+ * buffers always return to the slab and are released with it.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_skb_pool_reserve (
+	pgm_skb_pool_t*const	pool,
+	const unsigned		count,
+	const size_t		page_size,
+	const bool		use_mlock,
+	const int		numa_node
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != pool);
+	pgm_assert_cmpuint (count, >, 0);
+	pgm_assert (NULL == pool->region.addr);
+
+	pgm_debug ("pgm_skb_pool_reserve (pool:%p count:%u page-size:%" PRIzu " use-mlock:%s numa-node:%d)",
+		   (const void*)pool, count, page_size, use_mlock ? "YES" : "NO", numa_node);
+
+	pgm_mem_region_map (&pool->region, count * pool->slot_size, page_size, use_mlock, numa_node);
+	pool_carve (pool, count);
+}
+
+/* fault in the pool ahead of the data path, the region of reserved or
+ * attached buffers, otherwise up to count heap buffers onto the free list
+ * within the cache limit.  rings are left alone.
+ *
+ * returns bytes touched.
+ */
+
+PGM_GNUC_INTERNAL
+size_t
+pgm_skb_pool_prewarm (
+	pgm_skb_pool_t*const	pool,
+	const unsigned		count
+	)
+{
+	size_t touched = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != pool);
+
+	if (NULL != pool->region.addr)
+		return pgm_mem_prefault (pool->region.addr, pool->region.len);
+	if (0 != pool->ring_len || NULL != pool->release)
+		return 0;
+
+	const size_t len = pool->size + sizeof(struct pgm_sk_buff_t);
+	pgm_spinlock_lock (&pool->lock);
+	for (unsigned i = 0;
+	     i < count && pgm_atomic_read32 (&pool->cached) < pgm_atomic_read32 (&pool->max_cached);
+	     i++)
+	{
+		pgm_list_t* link = pgm_malloc (len);
+		memset (link, 0, len);
+		link->next = pool->free_list;
+		pool->free_list = link;
+		pgm_atomic_inc32 (&pool->cached);
+		touched += len;
+	}
+	pgm_spinlock_unlock (&pool->lock);
+	return touched;
+}
+
+/* carve idle buffers from memory supplied by the application, for example
+ * registered with a NIC or on huge pages, aligned to a cache line.  the
+ * memory must remain valid until the last buffer is released, which may be
+ * after the owning socket is closed while the application retains packets.
+ *
+ * returns count of buffers carved, 0 when the memory cannot hold one.
+ */
+
+PGM_GNUC_INTERNAL
+unsigned
+pgm_skb_pool_attach (
+	pgm_skb_pool_t*const	pool,
+	void*const		addr,
+	const size_t		len
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != pool);
+	pgm_assert (NULL != addr);
+	pgm_assert (NULL == pool->region.addr);
+
+	pgm_debug ("pgm_skb_pool_attach (pool:%p addr:%p len:%" PRIzu ")",
+		   (const void*)pool, addr, len);
+
+	const size_t pad = (64 - ((uintptr_t)addr & 63)) & 63;
+	const unsigned count = (len > pad) ? (unsigned)((len - pad) / pool->slot_size) : 0;
+	if (0 == count) {
+		pgm_trace (PGM_LOG_ROLE_MEMORY,_("%" PRIzu " bytes of packet memory cannot hold one %" PRIzu " byte buffer."),
+			   len, pool->slot_size);
+		return 0;
+	}
+	pool->region.addr	= (char*)addr + pad;
+	pool->region.len	= count * pool->slot_size;
+	pool->is_external	= TRUE;
+	pool_carve (pool, count);
+	return count;
+}
+
+/* create ring of slots buffers of size payload bytes, taken in place by
+ * index through pgm_skb_ring_alloc().  the ring is mapped as by
+ * pgm_skb_pool_reserve().
+ */
+
+PGM_GNUC_INTERNAL
+pgm_skb_pool_t*
+pgm_skb_ring_create (
+	const uint16_t		size,
+	const unsigned		slots,
+	const size_t		page_size,
+	const bool		use_mlock,
+	const int		numa_node
+	)
+{
+	pgm_skb_pool_t* pool;
+
+/* pre-conditions */
+	pgm_assert_cmpuint (slots, >, 0);
+
+	pgm_debug ("pgm_skb_ring_create (size:%" PRIu16 " slots:%u page-size:%" PRIzu " use-mlock:%s numa-node:%d)",
+		   size, slots, page_size, use_mlock ? "YES" : "NO", numa_node);
+
+	pool = pgm_skb_pool_create (size, 0);
+	pool->ring_len = slots;
+/* zeroed slots have no users */
+	pgm_mem_region_map (&pool->region, pool->ring_len * pool->slot_size, page_size, use_mlock, numa_node);
+	return pool;
+}
+
+/* take the slot at index modulo the ring length.  slots are taken by a single
+ * thread, any thread may drop the last reference.
+ *
+ * returns pointer to skb, or NULL if the slot is still referenced.
+ */
+
+PGM_GNUC_INTERNAL
+struct pgm_sk_buff_t*
+pgm_skb_ring_alloc (
+	pgm_skb_pool_t*const	pool,
+	const uint32_t		index_
+	)
+{
+	struct pgm_sk_buff_t* skb;
+
+/* pre-conditions */
+	pgm_assert (NULL != pool);
+	pgm_assert_cmpuint (pool->ring_len, >, 0);
+
+	skb = (struct pgm_sk_buff_t*)((char*)pool->region.addr + (index_ % pool->ring_len) * pool->slot_size);
+	if (PGM_UNLIKELY(0 != pgm_atomic_read32 (&skb->users))) {
+		pool->misses++;
+		return NULL;
+	}
+	pool->hits++;
+	pgm_atomic_inc32 (&pool->ref_count);
+
+	if (PGM_UNLIKELY(pgm_mem_gc_friendly)) {
+		memset (skb, 0, pool->slot_size);
+		skb->zero_padded = 1;
+	} else {
+		memset (skb, 0, sizeof(struct pgm_sk_buff_t));
+	}
+	skb->truesize = pool->size + sizeof(struct pgm_sk_buff_t);
+	pgm_atomic_write32 (&skb->users, 1);
+	skb->head = skb + 1;
+	skb->data = skb->tail = skb->head;
+	skb->end  = (char*)skb->data + pool->size;
+	skb->pool = pool;
+	return skb;
+}
+
+/* release owner reference, idle buffers are freed immediately and outstanding
+ * buffers return to the heap as their last reference drops.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_skb_pool_destroy (
+	pgm_skb_pool_t*const	pool
+	)
+{
+	pgm_assert (NULL != pool);
+
+	pgm_spinlock_lock (&pool->lock);
+	pgm_atomic_write32 (&pool->max_cached, 0);
+	free_skb_list (pool, pool->free_list);
+	pool->free_list = NULL;
+	free_skb_list (pool, take_return_list (pool));
+	pgm_spinlock_unlock (&pool->lock);
+
+	if (1 == pgm_atomic_exchange_and_add32 (&pool->ref_count, (uint32_t)-1))
+		pgm_skb_pool_free (pool);
+}
+
+/* allocate a buffer of at least size bytes of payload, from the slab when the
+ * size fits otherwise from the heap.  Slab buffers always span the pool size.
+ */
+
+PGM_GNUC_INTERNAL
+struct pgm_sk_buff_t*
+pgm_skb_pool_alloc (
+	pgm_skb_pool_t*const	pool,
+	const uint16_t		size
+	)
+{
+	struct pgm_sk_buff_t* skb;
+
+	if (NULL == pool || size > pool->size)
+		return pgm_alloc_skb (size);
+
+	pgm_spinlock_lock (&pool->lock);
+	if (NULL == pool->free_list)
+		pool->free_list = take_return_list (pool);
+	if (PGM_LIKELY(NULL != pool->free_list)) {
+		skb = (struct pgm_sk_buff_t*)pool->free_list;
+		pool->free_list = pool->free_list->next;
+		pool->hits++;
+		pgm_spinlock_unlock (&pool->lock);
+		pgm_atomic_dec32 (&pool->cached);
+	} else {
+		pool->misses++;
+		pgm_spinlock_unlock (&pool->lock);
+		skb = (struct pgm_sk_buff_t*)pgm_malloc (pool->size + sizeof(struct pgm_sk_buff_t));
+	}
+	pgm_atomic_inc32 (&pool->ref_count);
+
+	if (PGM_UNLIKELY(pgm_mem_gc_friendly)) {
+		memset (skb, 0, pool->size + sizeof(struct pgm_sk_buff_t));
+		skb->zero_padded = 1;
+	} else {
+		memset (skb, 0, sizeof(struct pgm_sk_buff_t));
+	}
+	skb->truesize = pool->size + sizeof(struct pgm_sk_buff_t);
+	pgm_atomic_write32 (&skb->users, 1);
+	skb->head = skb + 1;
+	skb->data = skb->tail = skb->head;
+	skb->end  = (char*)skb->data + pool->size;
+	skb->pool = pool;
+	return skb;
+}
+
+/* return buffer to owning slab on last reference, called from pgm_free_skb()
+ * on any thread.
+ */
+
+void
+pgm_skb_pool_release (
+	struct pgm_sk_buff_t*const skb
+	)
+{
+	pgm_skb_pool_t*const pool = skb->pool;
+
+/* ring slots stay in place, free again at zero users */
+	if (NULL != pool->release)
+		pool->release (skb);
+	else if (0 == pool->ring_len)
+	{
+		const bool is_reserved = pool_owns_skb (pool, skb);
+		if (is_reserved ||
+		    pgm_atomic_exchange_and_add32 (&pool->cached, 1) < pgm_atomic_read32 (&pool->max_cached))
+		{
+			void* head;
+			if (is_reserved)
+				pgm_atomic_inc32 (&pool->cached);
+			do {
+				head = pool->return_list;
+				skb->link_.next = (pgm_list_t*)head;
+			} while (!pgm_atomic_compare_and_exchange_pointer (&pool->return_list, head, skb));
+		}
+		else
+		{
+			pgm_atomic_dec32 (&pool->cached);
+			pgm_free (skb);
+		}
+	}
+
+/* last outstanding buffer of a destroyed slab */
+	if (1 == pgm_atomic_exchange_and_add32 (&pool->ref_count, (uint32_t)-1))
+		pgm_skb_pool_free (pool);
+}
+
+/* copy a received packet into a buffer of pool sized to its content, such
+ * that small TPDUs held in a receive window do not pin a max_tpdu slab buffer
+ * each.  without a pool, or content larger than its buffers, the copy is taken
+ * from the heap with no tailroom.  header pointers are rebased onto the copy.
+ */
+
+PGM_GNUC_INTERNAL
+struct pgm_sk_buff_t*
+pgm_skb_copy_compact (
+	pgm_skb_pool_t*const		 pool,
+	const struct pgm_sk_buff_t*const skb
+	)
+{
+	struct pgm_sk_buff_t* newskb;
+	size_t content;
+
+/* pre-conditions */
+	pgm_assert (NULL != skb);
+
+	content = (char*)skb->tail - (char*)skb->head;
+	newskb = pgm_skb_pool_alloc (pool, (uint16_t)content);
+	memcpy (newskb, skb, PGM_OFFSETOF(struct pgm_sk_buff_t, pgm_header));
+	newskb->zero_padded = 0;
+	newskb->data = (char*)newskb->head + ((char*)skb->data - (char*)skb->head);
+	newskb->tail = (char*)newskb->head + content;
+#define REBASE(p)	((p) ? (void*)((char*)newskb->head + ((char*)(p) - (char*)skb->head)) : NULL)
+	newskb->pgm_header		= REBASE(skb->pgm_header);
+	newskb->pgm_opt_fragment	= REBASE(skb->pgm_opt_fragment);
+	newskb->pgm_opt_pgmcc_data	= REBASE(skb->pgm_opt_pgmcc_data);
+	newskb->pgm_data		= REBASE(skb->pgm_data);
+#undef REBASE
+	memcpy (newskb->head, skb->head, content);
+	return newskb;
+}
+
+/* take a reference on a received packet such that it remains valid beyond
+ * the next read, independent of the receive window.  records of coalesced
+ * TPDUs carry no buffer of their own and are copied instead.  release with
+ * pgm_free_skb().
+ *
+ * returns pointer to the retained skb, which may differ from skb.
+ */
+
+struct pgm_sk_buff_t*
+pgm_skb_retain (
+	struct pgm_sk_buff_t*const skb
+	)
+{
+	struct pgm_sk_buff_t* newskb;
+
+/* pre-conditions */
+	pgm_assert (NULL != skb);
+
+	if (PGM_LIKELY(0 != skb->truesize))
+		return pgm_skb_get (skb);
+
+	newskb = pgm_alloc_skb (skb->len);
+	newskb->sock		= skb->sock;
+	newskb->tstamp		= skb->tstamp;
+	newskb->rx_tstamp	= skb->rx_tstamp;
+	memcpy (&newskb->tsi, &skb->tsi, sizeof(pgm_tsi_t));
+	newskb->sequence	= skb->sequence;
+	memcpy (pgm_skb_put (newskb, skb->len), skb->data, skb->len);
+	return newskb;
+}
+
 #ifndef SKB_DEBUG
 bool
 pgm_skb_is_valid (
@@ -73,6 +537,7 @@ pgm_skb_is_valid (
 /* cb can be any value */
 /* len can be any value */
 /* zero_padded can be any value */
+/* coalesced can be any value */
 /* gpointers */
 	pgm_return_val_if_fail (NULL != skb->head, FALSE);
 	pgm_return_val_if_fail ((const char*)skb->head > (const char*)&skb->users, FALSE);
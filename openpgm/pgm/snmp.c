@@ -194,6 +194,7 @@ snmp_routine (
 {
 	const SOCKET notify_fd = pgm_notify_get_socket (&snmp_notify);
 
+	pgm_thread_setup ("snmp");
 	for (;;)
 	{
 		int fds = 0, block = 1;
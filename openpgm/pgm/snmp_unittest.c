@@ -29,8 +29,6 @@
 
 
 /* mock state */
-static pgm_rwlock_t     mock_pgm_sock_list_lock;
-static pgm_slist_t*     mock_pgm_sock_list;
 
 PGM_GNUC_INTERNAL
 bool
@@ -43,8 +41,6 @@ mock_pgm_mib_init (
 
 /* mock functions for external references */
 
-#define pgm_sock_list_lock      mock_pgm_sock_list_lock
-#define pgm_sock_list           mock_pgm_sock_list
 #define pgm_mib_init		mock_pgm_mib_init
 
 #define SNMP_DEBUG
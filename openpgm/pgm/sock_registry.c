@@ -0,0 +1,321 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * registry of open sockets for the admin interfaces, indexed by TSI.
+ *
+ * Readers never lock: each enters a read section by counting itself against
+ * the current epoch and follows the published snapshot.  Writers, serialised
+ * by a mutex, copy the snapshot with the change applied and publish the copy
+ * in one pointer store.  A replaced snapshot is retired until two epoch flips
+ * have each found the readers of the previous epoch drained, after which no
+ * reader can still hold it.  Adding a socket only polls for flips and so never
+ * waits on readers; removing one waits for the grace period such that the
+ * socket may be freed afterwards.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <string.h>
+#include <impl/framework.h>
+#include <impl/sock_registry.h>
+
+
+//#define SOCK_REGISTRY_DEBUG
+
+#ifndef SOCK_REGISTRY_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+/* minimum index slots, power of two */
+#define SOCK_REGISTRY_MIN_SLOTS		8
+
+static pgm_mutex_t			registry_mutex;
+static pgm_sock_registry_t*		registry_current = NULL;
+static pgm_sock_registry_t*		registry_retired = NULL;	/* under registry_mutex */
+static unsigned				registry_grace = 0;		/* epoch flips, under registry_mutex */
+static volatile uint32_t		registry_epoch = 0;
+static volatile uint32_t		registry_readers[2];
+
+
+/* MurmurHash3 64-bit finaliser over the TSI packed as a 64-bit key.
+ */
+
+static inline
+unsigned
+sock_registry_hash (
+	const pgm_tsi_t*	tsi
+	)
+{
+	uint64_t key = pgm_peer_table_key (tsi);
+	key ^= key >> 33;
+	key *= UINT64_C(0xff51afd7ed558ccd);
+	key ^= key >> 33;
+	key *= UINT64_C(0xc4ceb9fe1a85ec53);
+	key ^= key >> 33;
+	return (unsigned)key;
+}
+
+/* returns new snapshot of the len sockets in socks, index built from their
+ * present TSIs.
+ */
+
+static
+pgm_sock_registry_t*
+sock_registry_new (
+	pgm_sock_t*const*	socks,
+	const unsigned		len
+	)
+{
+	unsigned slots = SOCK_REGISTRY_MIN_SLOTS;
+	while (slots < 2 * len)
+		slots <<= 1;
+	pgm_sock_registry_t* registry = pgm_malloc0 (sizeof (pgm_sock_registry_t) + (len + slots) * sizeof (pgm_sock_t*));
+	registry->len   = len;
+	registry->mask  = slots - 1;
+	registry->index = &registry->socks[ len ];
+	for (unsigned i = 0; i < len; i++) {
+		pgm_sock_t* sock = socks[ i ];
+		unsigned slot = sock_registry_hash (&sock->tsi) & registry->mask;
+		while (NULL != registry->index[ slot ])
+			slot = (slot + 1) & registry->mask;
+		registry->socks[ i ]    = sock;
+		registry->index[ slot ] = sock;
+	}
+	return registry;
+}
+
+/* replace the current snapshot and retire the previous one.  caller holds
+ * registry_mutex.
+ */
+
+static
+void
+sock_registry_publish (
+	pgm_sock_registry_t*	registry
+	)
+{
+	pgm_sock_registry_t* old = registry_current;
+	pgm_atomic_write_pointer_release ((void*volatile*)&registry_current, registry);
+	if (NULL != old) {
+		old->retired_at  = registry_grace;
+		old->next        = registry_retired;
+		registry_retired = old;
+	}
+}
+
+/* flip the epoch when readers of the previous epoch have drained, every
+ * reader that entered before the last flip has then left.  caller holds
+ * registry_mutex.
+ *
+ * returns TRUE on flip, returns FALSE if a reader remains.
+ */
+
+static
+bool
+sock_registry_flip (void)
+{
+	const uint32_t epoch = pgm_atomic_read32 (&registry_epoch);
+	pgm_atomic_fence ();
+	if (0 != pgm_atomic_read32 (&registry_readers[ epoch ^ 1 ]))
+		return FALSE;
+	pgm_atomic_fence ();
+	pgm_atomic_write32 (&registry_epoch, epoch ^ 1);
+	registry_grace++;
+	return TRUE;
+}
+
+/* free retired snapshots two flips past their retirement.  caller holds
+ * registry_mutex.
+ */
+
+static
+void
+sock_registry_reclaim (void)
+{
+	pgm_sock_registry_t** link = &registry_retired;
+	while (NULL != *link) {
+		pgm_sock_registry_t* registry = *link;
+		if (registry_grace - registry->retired_at >= 2) {
+			*link = registry->next;
+			pgm_free (registry);
+		} else
+			link = &registry->next;
+	}
+}
+
+void
+pgm_sock_registry_init (void)
+{
+	pgm_mutex_init (&registry_mutex);
+	registry_epoch = 0;
+	registry_readers[ 0 ] = registry_readers[ 1 ] = 0;
+	registry_grace = 0;
+	registry_current = sock_registry_new (NULL, 0);
+}
+
+/* all sockets are closed and no readers remain.
+ */
+
+void
+pgm_sock_registry_shutdown (void)
+{
+	while (NULL != registry_retired) {
+		pgm_sock_registry_t* next = registry_retired->next;
+		pgm_free (registry_retired);
+		registry_retired = next;
+	}
+	if (NULL != registry_current) {
+		pgm_assert (0 == registry_current->len);
+		pgm_free (registry_current);
+		registry_current = NULL;
+	}
+	pgm_mutex_free (&registry_mutex);
+}
+
+void
+pgm_sock_registry_add (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	pgm_mutex_lock (&registry_mutex);
+	const pgm_sock_registry_t* old = registry_current;
+	pgm_sock_t** socks = pgm_newa (pgm_sock_t*, old->len + 1);
+	memcpy (socks, old->socks, old->len * sizeof (pgm_sock_t*));
+	socks[ old->len ] = sock;
+	sock_registry_publish (sock_registry_new (socks, old->len + 1));
+	if (sock_registry_flip())
+		sock_registry_reclaim();
+	pgm_mutex_unlock (&registry_mutex);
+}
+
+/* unpublish the socket and wait until no reader can hold it.
+ */
+
+void
+pgm_sock_registry_remove (
+	pgm_sock_t* const	sock
+	)
+{
+	unsigned i;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	pgm_mutex_lock (&registry_mutex);
+	const pgm_sock_registry_t* old = registry_current;
+	for (i = 0; i < old->len; i++)
+		if (sock == old->socks[ i ])
+			break;
+	if (i == old->len) {
+		pgm_mutex_unlock (&registry_mutex);
+		return;
+	}
+	pgm_sock_t** socks = pgm_newa (pgm_sock_t*, old->len);
+	memcpy (socks, old->socks, i * sizeof (pgm_sock_t*));
+	memcpy (&socks[ i ], &old->socks[ i + 1 ], (old->len - i - 1) * sizeof (pgm_sock_t*));
+	sock_registry_publish (sock_registry_new (socks, old->len - 1));
+	const unsigned grace = registry_grace + 2;
+
+/* release the mutex between attempts such that sockets may still be added */
+	for (;;) {
+		sock_registry_flip();
+		sock_registry_reclaim();
+		if ((int)(registry_grace - grace) >= 0)
+			break;
+		pgm_mutex_unlock (&registry_mutex);
+		pgm_thread_yield();
+		pgm_mutex_lock (&registry_mutex);
+	}
+	pgm_mutex_unlock (&registry_mutex);
+}
+
+/* rebuild the index after a socket TSI changes on bind.
+ */
+
+void
+pgm_sock_registry_rekey (void)
+{
+	pgm_mutex_lock (&registry_mutex);
+	const pgm_sock_registry_t* old = registry_current;
+	sock_registry_publish (sock_registry_new (old->socks, old->len));
+	if (sock_registry_flip())
+		sock_registry_reclaim();
+	pgm_mutex_unlock (&registry_mutex);
+}
+
+/* enter a read section, the snapshot and its sockets remain valid until
+ * pgm_sock_registry_leave() with the stored epoch.  read sections must not
+ * nest a socket close.
+ *
+ * returns current snapshot.
+ */
+
+const pgm_sock_registry_t*
+pgm_sock_registry_enter (
+	unsigned* const		epoch
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != epoch);
+
+	*epoch = pgm_atomic_read32 (&registry_epoch);
+	pgm_atomic_inc32 (&registry_readers[ *epoch ]);
+	pgm_atomic_fence ();
+	return pgm_atomic_read_pointer_acquire ((void*const volatile*)&registry_current);
+}
+
+void
+pgm_sock_registry_leave (
+	const unsigned		epoch
+	)
+{
+/* pre-conditions */
+	pgm_assert (epoch < 2);
+
+	pgm_atomic_fence_release ();
+	pgm_atomic_dec32 (&registry_readers[ epoch ]);
+}
+
+/* returns socket of matching TSI, returns NULL if not found.
+ */
+
+pgm_sock_t*
+pgm_sock_registry_lookup (
+	const pgm_sock_registry_t* const restrict registry,
+	const pgm_tsi_t*	   const restrict tsi
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != registry);
+	pgm_assert (NULL != tsi);
+
+	unsigned slot = sock_registry_hash (tsi) & registry->mask;
+	while (NULL != registry->index[ slot ]) {
+		if (pgm_tsi_equal (tsi, &registry->index[ slot ]->tsi))
+			return registry->index[ slot ];
+		slot = (slot + 1) & registry->mask;
+	}
+	return NULL;
+}
+
+/* eof */
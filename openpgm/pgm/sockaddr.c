@@ -550,7 +550,7 @@ pgm_sockaddr_router_alert (
 	return retval;
 }
 
-/* Type-of-service and precedence.
+/* Type-of-service and precedence, or the IPv6 traffic class.
  *
  * If no error occurs, pgm_sockaddr_tos returns zero.  Otherwise, a value of
  * SOCKET_ERROR is returned, and a specific error code can be retrieved by
@@ -591,8 +591,68 @@ pgm_sockaddr_tos (
 		break;
 	}
 
-	case AF_INET6:  /* TRAFFIC_CLASS not implemented */
+	case AF_INET6: {
+#ifdef IPV6_TCLASS
+/* Linux:ipv6(7) "IPV6_TCLASS ... an integer" */
+		const int optval = tos;
+		retval = setsockopt (s, IPPROTO_IPV6, IPV6_TCLASS, (const char*)&optval, sizeof(optval));
+#endif
+		break;
+	}
+
+	default: break;
+	}
+	return retval;
+}
+
+/* Don't fragment: with v set datagrams leave with DF and sends larger than the
+ * known path MTU fail with EMSGSIZE, the path MTU lowering on ICMP
+ * fragmentation needed or packet too big.  Without, the stack fragments.
+ *
+ * If no error occurs, pgm_sockaddr_dontfrag returns zero.  Otherwise, a value
+ * of SOCKET_ERROR is returned, and a specific error code can be retrieved by
+ * calling pgm_get_last_sock_error().
+ */
+
+PGM_GNUC_INTERNAL
+int
+pgm_sockaddr_dontfrag (
+	const SOCKET		s,
+	const sa_family_t	sa_family,
+	const bool		v
+	)
+{
+	int retval = SOCKET_ERROR;
+
+	switch (sa_family) {
+	case AF_INET: {
+#if defined( IP_MTU_DISCOVER )
+/* Linux:ip(7) "IP_PMTUDISC_DO: Always do Path MTU Discovery." */
+		const int optval = v ? IP_PMTUDISC_DO : IP_PMTUDISC_DONT;
+		retval = setsockopt (s, IPPROTO_IP, IP_MTU_DISCOVER, (const char*)&optval, sizeof(optval));
+#elif defined( IP_DONTFRAG )
+/* FreeBSD:ip(4) "IP_DONTFRAG ... int" */
+		const int optval = v ? 1 : 0;
+		retval = setsockopt (s, IPPROTO_IP, IP_DONTFRAG, (const char*)&optval, sizeof(optval));
+#elif defined( IP_DONTFRAGMENT )
+/* WinSock2:MSDN(IPPROTO_IP Socket Options) "DWORD (boolean)" */
+		const DWORD optval = v ? 1 : 0;
+		retval = setsockopt (s, IPPROTO_IP, IP_DONTFRAGMENT, (const char*)&optval, sizeof(optval));
+#endif
 		break;
+	}
+
+	case AF_INET6: {
+#if defined( IPV6_MTU_DISCOVER )
+		const int optval = v ? IPV6_PMTUDISC_DO : IPV6_PMTUDISC_DONT;
+		retval = setsockopt (s, IPPROTO_IPV6, IPV6_MTU_DISCOVER, (const char*)&optval, sizeof(optval));
+#elif defined( IPV6_DONTFRAG )
+/* RFC 3542 "IPV6_DONTFRAG ... int" */
+		const int optval = v ? 1 : 0;
+		retval = setsockopt (s, IPPROTO_IPV6, IPV6_DONTFRAG, (const char*)&optval, sizeof(optval));
+#endif
+		break;
+	}
 
 	default: break;
 	}
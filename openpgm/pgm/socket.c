@@ -30,13 +30,45 @@
 #ifdef HAVE_EPOLL_CTL
 #	include <sys/epoll.h>
 #endif
+#ifdef HAVE_KQUEUE
+#	include <sys/types.h>
+#	include <sys/event.h>
+#endif
+#ifdef HAVE_TIMERFD_CREATE
+#	include <sys/timerfd.h>
+#endif
 #include <stdio.h>
 #include <impl/i18n.h>
 #include <impl/framework.h>
 #include <impl/socket.h>
 #include <impl/receiver.h>
+#include <impl/recv.h>
 #include <impl/source.h>
 #include <impl/timer.h>
+#include <impl/net.h>
+#include <impl/xdp.h>
+#include <impl/xdp_filter.h>
+#include <impl/dpdk.h>
+#include <impl/uring.h>
+#include <impl/rio.h>
+#include <impl/replay.h>
+#include <impl/shm.h>
+#include <impl/loop.h>
+#include <impl/rate_group.h>
+#include <impl/txlog.h>
+#include <impl/checkpoint.h>
+#include <impl/shard.h>
+#include <impl/demux.h>
+#include <impl/sock_registry.h>
+#include <impl/stats.h>
+#include <impl/filter.h>
+#include <impl/groups.h>
+#include <impl/dlr.h>
+#include <impl/tfmcc.h>
+#include <impl/decode.h>
+#include <impl/relay.h>
+#include <impl/standby.h>
+#include <impl/flightrec.h>
 
 
 #define SOCK_DEBUG
@@ -44,12 +76,26 @@
 
 
 /* global locals */
-pgm_rwlock_t pgm_sock_list_lock;		/* list of all sockets for admin interfaces */
-pgm_slist_t* pgm_sock_list = NULL;
+pgm_rwlock_t pgm_sock_list_lock;		/* shared receive socket, ethdev and loopback bus members */
 
 
 static const char* pgm_sock_type_string (const int) PGM_GNUC_CONST;
 static const char* pgm_protocol_string (const int) PGM_GNUC_CONST;
+static void pgm_wait_create (pgm_sock_t*const);
+static bool pgm_event_sock_create (pgm_sock_t*const restrict, pgm_error_t**restrict);
+static void pgm_opt_log_record (pgm_sock_t*const restrict, const int, const int, const void*restrict, const socklen_t);
+static void pgm_opt_log_free (pgm_sock_t*const);
+
+/* a socket option applied before bind, replayed onto clones of the socket.
+ */
+
+struct pgm_opt_log_t {
+	int		level;
+	int		optname;
+	socklen_t	optlen;
+	uint32_t	__padding;		/* align optval for 64-bit values */
+	char		optval[];
+};
 
 
 size_t
@@ -71,6 +117,123 @@ pgm_pkt_offset (
 	return pkt_size;
 }
 
+/* header length of an original data packet with coalesced APDUs.
+ */
+
+size_t
+pgm_coalesce_pkt_offset (
+	sa_family_t	pgmcc_family		/* 0 = disable */
+	)
+{
+	size_t pkt_size = pgm_pkt_offset (FALSE, pgmcc_family);
+	if (0 == pgmcc_family)
+		pkt_size += sizeof(struct pgm_opt_length);
+	pkt_size += sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_coalesce);
+	return pkt_size;
+}
+
+/* segment sizes for TPDUs of path_mtu bytes.  path_mtu is at most the value
+ * at pgm_bind() such that buffers sized then remain large enough.  the source
+ * applies changes between APDUs, under source_mutex.
+ */
+
+void
+pgm_sock_set_path_mtu (
+	pgm_sock_t* const	sock,
+	const uint16_t		path_mtu
+	)
+{
+	const sa_family_t pgmcc_family = sock->use_pgmcc ? sock->family : 0;
+	const size_t trailer_len = pgm_data_trailer_len (sock);
+	const unsigned max_fragments = sock->txw_sqns ? MIN( PGM_MAX_FRAGMENTS, sock->txw_sqns ) : PGM_MAX_FRAGMENTS;
+
+	sock->path_mtu = path_mtu;
+	sock->max_tsdu = (uint16_t)(path_mtu - sock->iphdr_len - pgm_pkt_offset (FALSE, pgmcc_family) - trailer_len);
+	sock->max_tsdu_fragment = (uint16_t)(path_mtu - sock->iphdr_len - pgm_pkt_offset (TRUE, pgmcc_family) - trailer_len);
+	sock->max_tsdu_coalesce = (uint16_t)(path_mtu - sock->iphdr_len - pgm_coalesce_pkt_offset (pgmcc_family) - trailer_len);
+	sock->max_apdu = MIN( PGM_MAX_APDU, max_fragments * sock->max_tsdu_fragment );
+}
+
+/* set the TOS of the send sockets to the classes most of their packets carry,
+ * ODATA on the regular socket and RDATA with IP Router Alert, other classes
+ * of a different TOS are marked per packet.
+ *
+ * returns TRUE on success, returns FALSE if a socket refuses the TOS.
+ */
+
+static
+bool
+socket_set_tos (
+	pgm_sock_t* const	sock
+	)
+{
+	const int send_tos = pgm_tx_class_tos (sock, PGM_TX_CLASS_ODATA);
+	const int router_alert_tos = pgm_tx_class_tos (sock, PGM_TX_CLASS_RDATA);
+	if (SOCKET_ERROR == pgm_sockaddr_tos (sock->send_sock, sock->family, send_tos) ||
+	    SOCKET_ERROR == pgm_sockaddr_tos (sock->send_with_router_alert_sock, sock->family, router_alert_tos))
+	{
+		pgm_warn (_("ToS/DSCP setting requires CAP_NET_ADMIN or ADMIN capability."));
+		return FALSE;
+	}
+	sock->send_sock_tos = send_tos;
+	sock->router_alert_sock_tos = router_alert_tos;
+	sock->use_class_dscp = FALSE;
+	for (unsigned i = 0; i < PGM_TX_CLASS_MAX; i++)
+		if (sock->class_dscp[ i ] >= 0)
+			sock->use_class_dscp = TRUE;
+	return TRUE;
+}
+
+/* resize the receive window of every peer, holding the mutex of one receive
+ * shard at a time such that each receiver is only briefly excluded.
+ */
+
+static
+void
+peers_set_rxw_sqns (
+	pgm_sock_t* const	sock,
+	const unsigned		rxw_sqns
+	)
+{
+	for (unsigned i = 0; i < sock->rx_shard_len; i++)
+	{
+		struct pgm_rx_shard_t* shard = &sock->rx_shard[ i ];
+		pgm_mutex_lock (&shard->mutex);
+		pgm_rwlock_reader_lock (&sock->peers_lock);
+		for (pgm_list_t* list = sock->peers_list; NULL != list; list = list->next) {
+			pgm_peer_t* peer = list->data;
+			if (peer->shard == shard)
+				pgm_rxw_set_max_length (peer->window, rxw_sqns);
+		}
+		pgm_rwlock_reader_unlock (&sock->peers_lock);
+		pgm_mutex_unlock (&shard->mutex);
+	}
+}
+
+/* apply the delivery weights to every peer, as peers_set_rxw_sqns().
+ */
+
+static
+void
+peers_set_weight (
+	pgm_sock_t* const	sock
+	)
+{
+	for (unsigned i = 0; i < sock->rx_shard_len; i++)
+	{
+		struct pgm_rx_shard_t* shard = &sock->rx_shard[ i ];
+		pgm_mutex_lock (&shard->mutex);
+		pgm_rwlock_reader_lock (&sock->peers_lock);
+		for (pgm_list_t* list = sock->peers_list; NULL != list; list = list->next) {
+			pgm_peer_t* peer = list->data;
+			if (peer->shard == shard)
+				pgm_peer_update_weight (sock, peer);
+		}
+		pgm_rwlock_reader_unlock (&sock->peers_lock);
+		pgm_mutex_unlock (&shard->mutex);
+	}
+}
+
 #ifdef _MSC_VER
 /* How to Determine Whether a Process or Thread Is Running As an Administrator
  * http://msdn.microsoft.com/en-us/windows/ff420334.aspx
@@ -209,7 +372,7 @@ CLEANUP:
  *
  * outstanding locks:
  * 1) pgm_sock_t::lock
- * 2) pgm_sock_t::receiver_mutex
+ * 2) pgm_rx_shard_t::mutex
  * 3) pgm_sock_t::source_mutex
  * 4) pgm_sock_t::txw_spinlock
  * 5) pgm_sock_t::timer_mutex
@@ -233,10 +396,32 @@ pgm_close (
 	pgm_debug ("pgm_sock_destroy (sock:%p flush:%s)",
 		(const void*)sock,
 		flush ? "TRUE":"FALSE");
+/* abandon an APDU left open by pgm_send_begin() on this thread, the fragments
+ * sent remain in the transmit window.
+ */
+	if (sock->stream_state.is_open) {
+		if (NULL != sock->stream_state.skb && !sock->stream_state.is_eagain)
+			pgm_free_skb (sock->stream_state.skb);
+		sock->stream_state.skb = NULL;
+		sock->stream_state.is_open = FALSE;
+		pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+	}
+/* send APDUs still waiting to be coalesced */
+	if (sock->coalesce_len && flush) {
+		pgm_mutex_lock (&sock->source_mutex);
+		if (PGM_IO_STATUS_NORMAL != pgm_coalesce_flush (sock))
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Failed to send coalesced data."));
+		pgm_mutex_unlock (&sock->source_mutex);
+	}
 /* flag existing calls */
 	sock->is_destroyed = TRUE;
 /* cancel running blocking operations */
-	if (INVALID_SOCKET != sock->recv_sock) {
+	if (NULL != sock->demux) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Leaving shared receive socket."));
+		pgm_demux_detach (sock);
+/* the receive socket stays open for other members, wake blocked readers */
+		pgm_notify_send (&sock->pending_notify);
+	} else if (INVALID_SOCKET != sock->recv_sock) {
 		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Closing receive socket."));
 		closesocket (sock->recv_sock);
 		sock->recv_sock = INVALID_SOCKET;
@@ -246,14 +431,28 @@ pgm_close (
 		closesocket (sock->send_sock);
 		sock->send_sock = INVALID_SOCKET;
 	}
+	for (unsigned i = 0; i < sock->send_path_len; i++) {
+		if (INVALID_SOCKET != sock->send_path_sock[ i ]) {
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Closing redundant path send socket."));
+			closesocket (sock->send_path_sock[ i ]);
+			sock->send_path_sock[ i ] = INVALID_SOCKET;
+		}
+	}
+/* stop callback delivery whilst readers may still finish */
+	if (NULL != sock->recv_async) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Stopping asynchronous receive thread."));
+		pgm_recv_async_destroy (sock);
+	}
+	if (NULL != sock->recv_drain) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Stopping receive drain thread."));
+		pgm_recv_drain_destroy (sock);
+	}
 	pgm_rwlock_reader_unlock (&sock->lock);
 	pgm_debug ("blocking on destroy lock ...");
 	pgm_rwlock_writer_lock (&sock->lock);
 
 	pgm_debug ("removing sock from inventory.");
-	pgm_rwlock_writer_lock (&pgm_sock_list_lock);
-	pgm_sock_list = pgm_slist_remove (pgm_sock_list, sock);
-	pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+	pgm_sock_registry_remove (sock);
 
 /* flush source side by sending heartbeat SPMs */
 	if (sock->can_send_data &&
@@ -269,11 +468,6 @@ pgm_close (
 		}
 	}
 
-	if (sock->peers_hashtable) {
-		pgm_debug ("destroying peer lookup table.");
-		pgm_hashtable_destroy (sock->peers_hashtable);
-		sock->peers_hashtable = NULL;
-	}
 	if (sock->peers_list) {
 		pgm_debug ("destroying peer list.");
 		do {
@@ -283,12 +477,65 @@ pgm_close (
 			sock->peers_list = next;
 		} while (sock->peers_list);
 	}
+	if (sock->rxw_spare) {
+		while (sock->rxw_spare_len > 0)
+			pgm_rxw_destroy (sock->rxw_spare[ --sock->rxw_spare_len ]);
+		pgm_free (sock->rxw_spare);
+		sock->rxw_spare = NULL;
+	}
+	if (sock->peer_slab) {
+		pgm_trace (PGM_LOG_ROLE_SESSION,_("Releasing %zu bytes of peer slab."), sock->peer_slab->len);
+		pgm_mem_slab_destroy (sock->peer_slab);
+		sock->peer_slab = NULL;
+	}
 
+	if (sock->async_thread) {
+		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Stopping sender thread."));
+		pgm_async_thread_destroy (sock);
+	}
+	if (sock->rdata_thread) {
+		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Stopping repair thread."));
+		pgm_rdata_thread_destroy (sock);
+	}
+	if (sock->fec_thread) {
+		pgm_trace (PGM_LOG_ROLE_FEC,_("Stopping FEC encoder thread."));
+		pgm_fec_thread_destroy (sock);
+	}
+	if (sock->decode_pool) {
+		pgm_trace (PGM_LOG_ROLE_FEC,_("Stopping FEC decoder threads."));
+		pgm_decode_pool_destroy (sock->decode_pool);
+		sock->decode_pool = NULL;
+	}
+	if (sock->standby) {
+		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Stopping hot standby."));
+		pgm_standby_destroy (sock->standby);
+		sock->standby = NULL;
+	}
 	if (sock->window) {
 		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Destroying transmit window."));
 		pgm_txw_shutdown (sock->window);
 		sock->window = NULL;
 	}
+	if (sock->txlog) {
+		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Destroying transmit log."));
+		pgm_txlog_destroy (sock->txlog);
+		sock->txlog = NULL;
+	}
+	if (sock->txlog_path) {
+		pgm_free (sock->txlog_path);
+		sock->txlog_path = NULL;
+	}
+	if (sock->restore)
+		pgm_checkpoint_free (sock);
+	if (sock->rate_group) {
+		pgm_trace (PGM_LOG_ROLE_RATE_CONTROL,_("Leaving rate group."));
+		pgm_rate_group_close (sock);
+		pgm_rate_destroy (&sock->rate_guarantee);
+	}
+	if (sock->rate_group_name) {
+		pgm_free (sock->rate_group_name);
+		sock->rate_group_name = NULL;
+	}
 	pgm_trace (PGM_LOG_ROLE_RATE_CONTROL,_("Destroying rate control."));
 	pgm_rate_destroy (&sock->rate_control);
 	if (INVALID_SOCKET != sock->send_with_router_alert_sock) {
@@ -301,10 +548,163 @@ pgm_close (
 		pgm_free (sock->spm_heartbeat_interval);
 		sock->spm_heartbeat_interval = NULL;
 	}
-	if (sock->rx_buffer) {
-		pgm_debug ("freeing receive buffer.");
-		pgm_free_skb (sock->rx_buffer);
-		sock->rx_buffer = NULL;
+	pgm_debug ("destroying peer lookup tables and receive buffers.");
+	pgm_rx_shards_destroy (sock);
+	if (sock->rx_batch) {
+		pgm_debug ("freeing receive batch.");
+		pgm_recv_batch_destroy (sock);
+	}
+	if (sock->rx_gro) {
+		pgm_debug ("freeing receive coalescing buffer.");
+		pgm_recv_gro_destroy (sock);
+	}
+	if (sock->xdp) {
+		pgm_debug ("closing AF_XDP socket.");
+		pgm_xdp_close (sock);
+	}
+	if (sock->xdp_filter) {
+		pgm_debug ("detaching XDP filter.");
+		pgm_xdp_filter_detach (sock);
+	}
+	if (sock->dpdk) {
+		pgm_debug ("detaching DPDK port queue.");
+		pgm_dpdk_close (sock);
+	}
+	if (sock->uring) {
+		pgm_debug ("closing io_uring.");
+		pgm_uring_close (sock);
+	}
+	if (sock->rio) {
+		pgm_debug ("closing Registered I/O.");
+		pgm_rio_close (sock);
+	}
+	if (sock->replay) {
+		pgm_debug ("closing capture replay.");
+		pgm_replay_close (sock);
+	}
+	if (sock->replay_path) {
+		pgm_free (sock->replay_path);
+		sock->replay_path = NULL;
+	}
+	if (sock->shm) {
+		pgm_debug ("closing shared memory ring.");
+		pgm_shm_close (sock);
+	}
+	if (sock->shm_name) {
+		pgm_free (sock->shm_name);
+		sock->shm_name = NULL;
+	}
+	if (sock->loop) {
+		pgm_debug ("leaving loopback bus.");
+		pgm_loop_close (sock);
+	}
+	if (sock->loop_name) {
+		pgm_free (sock->loop_name);
+		sock->loop_name = NULL;
+	}
+	if (sock->recv_shard_sock) {
+		pgm_debug ("closing receive shards.");
+		pgm_recv_shards_close (sock);
+	}
+	if (sock->incoming_cpu) {
+		pgm_free (sock->incoming_cpu);
+		sock->incoming_cpu = NULL;
+	}
+	if (sock->opt_log) {
+		pgm_opt_log_free (sock);
+	}
+	if (sock->zerocopy_skb) {
+		pgm_debug ("releasing zero-copy transmit packets.");
+		pgm_zerocopy_destroy (sock);
+	}
+	if (sock->tx_batch) {
+		pgm_debug ("freeing transmit batch.");
+/* release references of packets still pending a blocked send */
+		for (unsigned i = sock->pkt_dontwait_state.batch_index; i < sock->pkt_dontwait_state.batch_len; i++)
+			pgm_free_skb (sock->tx_batch[i]);
+		pgm_free (sock->tx_batch);
+		sock->tx_batch = NULL;
+	}
+	if (sock->mp_ring) {
+		for (unsigned i = 0; i < PGM_MP_RING_LEN; i++)
+			if (NULL != sock->mp_ring[ i ])
+				pgm_free_skb (sock->mp_ring[ i ]);
+		pgm_free ((void*)sock->mp_ring);
+		sock->mp_ring = NULL;
+	}
+	if (sock->send_stripe) {
+		pgm_free (sock->send_stripe);
+		sock->send_stripe = NULL;
+	}
+	if (sock->relay) {
+		pgm_relay_destroy (sock->relay);
+		sock->relay = NULL;
+	}
+	if (sock->send_path) {
+		pgm_free (sock->send_path);
+		pgm_free (sock->send_path_sock);
+		sock->send_path = NULL;
+		sock->send_path_sock = NULL;
+	}
+	if (sock->ack_peers) {
+		pgm_free (sock->ack_peers);
+		sock->ack_peers = NULL;
+	}
+	if (sock->nak_peers) {
+		pgm_free (sock->nak_peers);
+		sock->nak_peers = NULL;
+	}
+	if (sock->ncf_batch) {
+		pgm_free (sock->ncf_batch);
+		sock->ncf_batch = NULL;
+	}
+	if (sock->coalesce_buf) {
+		pgm_debug ("freeing coalescing buffer.");
+		pgm_free (sock->coalesce_buf);
+		sock->coalesce_buf = NULL;
+	}
+	if (sock->compress_buf) {
+		pgm_debug ("freeing compression buffers.");
+		pgm_free (sock->compress_buf);
+		pgm_free (sock->compress_gather);
+		sock->compress_buf = sock->compress_gather = NULL;
+	}
+	if (sock->flightrec) {
+		pgm_flightrec_destroy (sock->flightrec);
+		sock->flightrec = NULL;
+	}
+	if (sock->skb_pool) {
+		pgm_debug ("releasing socket buffer pool.");
+		pgm_skb_pool_destroy (sock->skb_pool);
+		sock->skb_pool = NULL;
+	}
+	if (sock->compact_pool) {
+		pgm_skb_pool_destroy (sock->compact_pool);
+		sock->compact_pool = NULL;
+	}
+	for (unsigned i = 0; i < PGM_RXW_REASM_CLASSES; i++) {
+		if (sock->reasm_pool[i]) {
+			pgm_skb_pool_destroy (sock->reasm_pool[i]);
+			sock->reasm_pool[i] = NULL;
+		}
+		if (sock->inflate_pool[i]) {
+			pgm_skb_pool_destroy (sock->inflate_pool[i]);
+			sock->inflate_pool[i] = NULL;
+		}
+	}
+	if (INVALID_SOCKET != sock->wait_fd) {
+		pgm_debug ("closing receive wait instance.");
+		close (sock->wait_fd);
+		sock->wait_fd = INVALID_SOCKET;
+	}
+	if (INVALID_SOCKET != sock->event_sock) {
+		pgm_debug ("closing event socket.");
+		close (sock->event_sock);
+		sock->event_sock = INVALID_SOCKET;
+	}
+	if (INVALID_SOCKET != sock->event_timer_fd) {
+		close (sock->event_timer_fd);
+		sock->event_timer_fd = INVALID_SOCKET;
 	}
 	pgm_debug ("destroying notification channels.");
 	if (sock->can_send_data) {
@@ -320,15 +720,35 @@ pgm_close (
 	pgm_mutex_free (&sock->send_mutex);
 	pgm_mutex_free (&sock->timer_mutex);
 	pgm_mutex_free (&sock->source_mutex);
-	pgm_mutex_free (&sock->receiver_mutex);
+	pgm_mutex_free (&sock->pending_mutex);
 	pgm_rwlock_writer_unlock (&sock->lock);
 	pgm_rwlock_free (&sock->lock);
 	pgm_debug ("freeing sock data.");
+	pgm_groups_destroy (sock);
+	pgm_free (sock->rates);
 	pgm_free (sock);
 	pgm_debug ("finished.");
 	return TRUE;
 }
 
+/* sockets are created able to use Registered I/O, selected at pgm_bind().
+ */
+
+static inline
+SOCKET
+open_socket (
+	const int	family,
+	const int	type,
+	const int	protocol
+	)
+{
+#ifdef PGM_HAVE_RIO
+	return WSASocket (family, type, protocol, NULL, 0, WSA_FLAG_OVERLAPPED | WSA_FLAG_REGISTERED_IO);
+#else
+	return socket (family, type, protocol);
+#endif
+}
+
 /* Create a pgm_sock object.  Create sockets that require superuser
  * priviledges.  If interface ports are specified then UDP encapsulation will
  * be used instead of raw protocol.
@@ -367,6 +787,16 @@ pgm_socket (
 	pgm_debug ("socket (sock:%p family:%s sock-type:%s protocol:%s error:%p)",
 		 (const void*)sock, pgm_family_string(family), pgm_sock_type_string(pgm_sock_type), pgm_protocol_string(protocol), (const void*)error);
 
+#ifdef PGM_DISABLE_IPV6
+	if (AF_INET6 == family) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_AFNOSUPPORT,
+			       _("IPv6 is not supported by this build."));
+		return FALSE;
+	}
+#endif
+
 	new_sock = pgm_new0 (pgm_sock_t, 1);
 	new_sock->family	= family;
 	new_sock->socket_type	= pgm_sock_type;
@@ -377,24 +807,50 @@ pgm_socket (
 	new_sock->dport		= DEFAULT_DATA_DESTINATION_PORT;
 	new_sock->tsi.sport	= DEFAULT_DATA_SOURCE_PORT;
 	new_sock->adv_mode	= 0;	/* advance with time */
+	new_sock->rx_batch_size	= 1;	/* one datagram per system call */
+	new_sock->recv_shards	= 1;
+	new_sock->tx_batch_size	= 1;
+	new_sock->mem_budget.parent = &pgm_mem_global_budget;
+	new_sock->peer_slab	= pgm_mem_slab_new();
+	new_sock->skb_pool_size	= PGM_SKB_POOL_DEFAULT_SIZE;
+	new_sock->parity_cache	= PGM_TXW_PARITY_CACHE_DEFAULT;
+	new_sock->xdp_xskmap_fd	= -1;
+	new_sock->dpdk_port_id	= -1;
+	new_sock->numa_node	= PGM_NUMA_NODE_NONE;
+	new_sock->coalesce_ivl	= PGM_COALESCE_DEFAULT_IVL;
+	new_sock->rdata_share	= 100;
+	new_sock->flightrec_len	= PGM_FLIGHTREC_DEFAULT_LEN;
+	new_sock->wait_fd	= INVALID_SOCKET;
+	new_sock->event_sock	= INVALID_SOCKET;
+	new_sock->event_timer_fd = INVALID_SOCKET;
+	for (unsigned i = 0; i < PGM_TX_CLASS_MAX; i++)
+		new_sock->class_dscp[ i ] = -1;
 
 /* PGMCC */
 	new_sock->acker_nla.ss_family = family;
 
 /* source-side */
 	pgm_mutex_init (&new_sock->source_mutex);
+	pgm_mutex_set_name (&new_sock->source_mutex, "source_mutex");
 /* transmit window */
 	pgm_spinlock_init (&new_sock->txw_spinlock);
+	pgm_spinlock_set_name (&new_sock->txw_spinlock, "txw_spinlock");
 /* send socket */
 	pgm_mutex_init (&new_sock->send_mutex);
+	pgm_mutex_set_name (&new_sock->send_mutex, "send_mutex");
 /* next timer & spm expiration */
 	pgm_mutex_init (&new_sock->timer_mutex);
+	pgm_mutex_set_name (&new_sock->timer_mutex, "timer_mutex");
 /* receiver-side */
-	pgm_mutex_init (&new_sock->receiver_mutex);
+	pgm_rx_shards_create (new_sock, 1);
+	pgm_mutex_init (&new_sock->pending_mutex);
+	pgm_mutex_set_name (&new_sock->pending_mutex, "pending_mutex");
 /* peer hash map & list lock */
 	pgm_rwlock_init (&new_sock->peers_lock);
+	pgm_rwlock_set_name (&new_sock->peers_lock, "peers_lock");
 /* destroy lock */
 	pgm_rwlock_init (&new_sock->lock);
+	pgm_rwlock_set_name (&new_sock->lock, "sock_lock");
 
 /* open sockets to implement PGM */
 	if (IPPROTO_UDP == new_sock->protocol) {
@@ -407,9 +863,9 @@ pgm_socket (
 		socket_type = SOCK_RAW;
 	}
 
-	if ((new_sock->recv_sock = socket (new_sock->family,
-					   socket_type,
-					   new_sock->protocol)) == INVALID_SOCKET)
+	if ((new_sock->recv_sock = open_socket (new_sock->family,
+						socket_type,
+						new_sock->protocol)) == INVALID_SOCKET)
 	{
 		const int save_errno = pgm_get_last_sock_error();
 		char errbuf[1024];
@@ -444,9 +900,9 @@ pgm_socket (
 /* receive socket must always be non-blocking */
 	pgm_sockaddr_nonblocking (new_sock->recv_sock, TRUE);
 
-	if ((new_sock->send_sock = socket (new_sock->family,
-					   socket_type,
-					   new_sock->protocol)) == INVALID_SOCKET)
+	if ((new_sock->send_sock = open_socket (new_sock->family,
+						socket_type,
+						new_sock->protocol)) == INVALID_SOCKET)
 	{
 		const int save_errno = pgm_get_last_sock_error();
 		char errbuf[1024];
@@ -458,9 +914,9 @@ pgm_socket (
 		goto err_destroy;
 	}
 
-	if ((new_sock->send_with_router_alert_sock = socket (new_sock->family,
-							     socket_type,
-							     new_sock->protocol)) == INVALID_SOCKET)
+	if ((new_sock->send_with_router_alert_sock = open_socket (new_sock->family,
+								  socket_type,
+								  new_sock->protocol)) == INVALID_SOCKET)
 	{
 		const int save_errno = pgm_get_last_sock_error();
 		char errbuf[1024];
@@ -567,11 +1023,11 @@ pgm_socket (
 		}
 	}
 
+/* sampled by the statistics thread once listed */
+	new_sock->rates = pgm_new0 (struct pgm_stats_ring_t, 1);
 	*sock = new_sock;
 
-	pgm_rwlock_writer_lock (&pgm_sock_list_lock);
-	pgm_sock_list = pgm_slist_append (pgm_sock_list, *sock);
-	pgm_rwlock_writer_unlock (&pgm_sock_list_lock);
+	pgm_sock_registry_add (*sock);
 	pgm_debug ("PGM socket successfully created.");
 	return TRUE;
 
@@ -695,7 +1151,19 @@ pgm_getsockopt (
 			break;
 		if (PGM_UNLIKELY(*optlen != sizeof (SOCKET)))
 			break;
-		*(SOCKET*restrict)optval = sock->recv_sock;
+		*(SOCKET*restrict)optval = pgm_recv_event_sock (sock);
+		status = TRUE;
+		break;
+
+/* receive shard sockets, shard 0 first */
+	case PGM_RECV_SHARD_SOCKS:
+		if (PGM_UNLIKELY(!sock->is_connected))
+			break;
+		if (PGM_UNLIKELY(*optlen < (socklen_t)(sock->recv_shards * sizeof (SOCKET))))
+			break;
+		for (unsigned i = 0; i < sock->recv_shards; i++)
+			((SOCKET*restrict)optval)[ i ] = pgm_recv_shard_sock (sock, i);
+		*optlen = (socklen_t)(sock->recv_shards * sizeof (SOCKET));
 		status = TRUE;
 		break;
 
@@ -715,7 +1183,7 @@ pgm_getsockopt (
 			break;
 		if (PGM_UNLIKELY(*optlen != sizeof (SOCKET)))
 			break;
-		*(SOCKET*restrict)optval = pgm_notify_get_socket (&sock->pending_notify);
+		*(SOCKET*restrict)optval = pgm_recv_pending_socket (sock);
 		status = TRUE;
 		break;
 
@@ -732,6 +1200,18 @@ pgm_getsockopt (
 		break;
 
 
+/* aggregated readiness socket */
+	case PGM_EVENT_SOCK:
+		if (PGM_UNLIKELY(!sock->is_connected))
+			break;
+		if (PGM_UNLIKELY(*optlen != sizeof (SOCKET)))
+			break;
+		if (PGM_UNLIKELY(INVALID_SOCKET == sock->event_sock))
+			break;
+		*(SOCKET*restrict)optval = sock->event_sock;
+		status = TRUE;
+		break;
+
 /* timeout for pending timer */
 	case PGM_TIME_REMAIN:
 		if (PGM_UNLIKELY(!sock->is_connected))
@@ -740,7 +1220,10 @@ pgm_getsockopt (
 			break;
 		{
 			struct timeval* tv = optval;
-			const long usecs = (long)pgm_timer_expiration (sock);
+			long usecs = (long)pgm_timer_expiration (sock);
+/* idle ring readers poll no later than the ring interval */
+			if (pgm_shm_is_reader (sock->shm))
+				usecs = MIN(usecs, (long)sock->shm->interval);
 			tv->tv_sec  = usecs / 1000000L;
 			tv->tv_usec = usecs % 1000000L;
 		}
@@ -762,6 +1245,79 @@ pgm_getsockopt (
 		status = TRUE;
 		break;
 
+/* socket buffer pool allocation counters */
+	case PGM_SKB_POOL_HITS:
+		if (PGM_UNLIKELY(NULL == sock->skb_pool))
+			break;
+		if (PGM_UNLIKELY(*optlen != sizeof (uint32_t)))
+			break;
+		*(uint32_t*restrict)optval = sock->skb_pool->hits;
+		status = TRUE;
+		break;
+
+	case PGM_SKB_POOL_MISSES:
+		if (PGM_UNLIKELY(NULL == sock->skb_pool))
+			break;
+		if (PGM_UNLIKELY(*optlen != sizeof (uint32_t)))
+			break;
+		*(uint32_t*restrict)optval = sock->skb_pool->misses;
+		status = TRUE;
+		break;
+
+/* on-demand parity cache counters */
+	case PGM_PARITY_CACHE_HITS:
+		if (PGM_UNLIKELY(NULL == sock->window || !sock->use_ondemand_parity))
+			break;
+		if (PGM_UNLIKELY(*optlen != sizeof (uint32_t)))
+			break;
+		*(uint32_t*restrict)optval = sock->window->parity_cache_hits;
+		status = TRUE;
+		break;
+
+	case PGM_PARITY_CACHE_MISSES:
+		if (PGM_UNLIKELY(NULL == sock->window || !sock->use_ondemand_parity))
+			break;
+		if (PGM_UNLIKELY(*optlen != sizeof (uint32_t)))
+			break;
+		*(uint32_t*restrict)optval = sock->window->parity_cache_misses;
+		status = TRUE;
+		break;
+
+/* zero checksum data packets */
+	case PGM_ZERO_CHECKSUM_SENT:
+		if (PGM_UNLIKELY(*optlen != sizeof (uint32_t)))
+			break;
+		*(uint32_t*restrict)optval = sock->zero_checksum_sent;
+		status = TRUE;
+		break;
+
+	case PGM_ZERO_CHECKSUM_RECEIVED:
+		if (PGM_UNLIKELY(*optlen != sizeof (uint32_t)))
+			break;
+		*(uint32_t*restrict)optval = sock->zero_checksum_received;
+		status = TRUE;
+		break;
+
+/* bytes of slot ring and buffer pool locked in memory */
+	case PGM_PINNED_BYTES:
+		if (PGM_UNLIKELY(!sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(*optlen != sizeof (uint64_t)))
+			break;
+		*(uint64_t*restrict)optval = sock->pinned_bytes;
+		status = TRUE;
+		break;
+
+/* bytes touched ahead of traffic by PGM_PREWARM */
+	case PGM_PREWARM_BYTES:
+		if (PGM_UNLIKELY(!sock->is_connected))
+			break;
+		if (PGM_UNLIKELY(*optlen != sizeof (uint64_t)))
+			break;
+		*(uint64_t*restrict)optval = sock->prewarm_bytes;
+		status = TRUE;
+		break;
+
 /** read-write options **/
 /* maximum transmission packet size */
 	case PGM_MTU:
@@ -809,6 +1365,13 @@ pgm_getsockopt (
 		status = TRUE;
 		break;
 
+	case PGM_TXW_MAX_SQNS:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->txw_max_sqns;
+		status = TRUE;
+		break;
+
 	case PGM_TXW_SECS:
 		if (PGM_UNLIKELY(*optlen != sizeof (int)))
 			break;
@@ -871,6 +1434,20 @@ pgm_getsockopt (
 		status = TRUE;
 		break;
 
+	case PGM_DLR:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->dlr_sqns;
+		status = TRUE;
+		break;
+
+	case PGM_DLR_REDIRECT:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct sockaddr_storage)))
+			break;
+		memcpy (optval, &sock->dlr_nla, sizeof (struct sockaddr_storage));
+		status = TRUE;
+		break;
+
 	case PGM_RXW_BYTES:
 		if (PGM_UNLIKELY(*optlen != sizeof (int)))
 			break;
@@ -985,6 +1562,74 @@ pgm_getsockopt (
 		status = TRUE;
 		break;
 
+	case PGM_USE_TFMCC:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_tfmcc ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_TXW_ACK_RELEASE:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)pgm_to_usecs (sock->txw_ack_hold);
+		status = TRUE;
+		break;
+
+	case PGM_TXW_ACK_QUORUM:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->txw_ack_quorum;
+		status = TRUE;
+		break;
+
+	case PGM_XDP:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_xdpinfo_t)))
+			break;
+		{
+			struct pgm_xdpinfo_t*restrict xdpinfo = optval;
+			xdpinfo->queue_id  = sock->xdp_queue_id;
+			xdpinfo->xskmap_fd = sock->xdp_xskmap_fd;
+		}
+		status = TRUE;
+		break;
+
+	case PGM_IO_URING:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->uring_entries;
+		status = TRUE;
+		break;
+
+	case PGM_RIO:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->rio_entries;
+		status = TRUE;
+		break;
+
+	case PGM_RIO_IOCP:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_iocpinfo_t)))
+			break;
+		{
+			struct pgm_iocpinfo_t*restrict iocpinfo = optval;
+			iocpinfo->port = sock->rio_port;
+			iocpinfo->key  = sock->rio_key;
+		}
+		status = TRUE;
+		break;
+
+	case PGM_DPDK:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_dpdkinfo_t)))
+			break;
+		{
+			struct pgm_dpdkinfo_t*restrict dpdkinfo = optval;
+			dpdkinfo->port_id  = sock->dpdk_port_id;
+			dpdkinfo->queue_id = sock->dpdk_queue_id;
+		}
+		status = TRUE;
+		break;
+
 	case PGM_SEND_ONLY:
 		if (PGM_UNLIKELY(*optlen != sizeof (int)))
 			break;
@@ -1041,837 +1686,3070 @@ pgm_getsockopt (
 		status = TRUE;
 		break;
 
-/** write-only options **/
-	case PGM_IP_ROUTER_ALERT:
-	case PGM_MULTICAST_LOOP:
-	case PGM_MULTICAST_HOPS:
-	case PGM_TOS:
-	case PGM_JOIN_GROUP:
-	case PGM_LEAVE_GROUP:
-	case PGM_BLOCK_SOURCE:
-	case PGM_UNBLOCK_SOURCE:
-	case PGM_JOIN_SOURCE_GROUP:
-	case PGM_LEAVE_SOURCE_GROUP:
-	case PGM_MSFILTER:
-	default:
+	case PGM_UDP_GSO:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_udp_gso ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_UDP_GRO:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_udp_gro ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_UDP_ENCAP_ZERO_CHECKSUM:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_zero_checksum ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_RECV_SHARDS:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->recv_shards;
+		status = TRUE;
+		break;
+
+	case PGM_INCOMING_CPU:
+		if (PGM_UNLIKELY(*optlen < (socklen_t)(sock->incoming_cpu_len * sizeof (int))))
+			break;
+		*optlen = (socklen_t)(sock->incoming_cpu_len * sizeof (int));
+		for (unsigned i = 0; i < sock->incoming_cpu_len; i++)
+			((int*restrict)optval)[i] = sock->incoming_cpu[i];
+		status = TRUE;
+		break;
+
+/* kernel receive CPU last sampled on each receive shard, -1 for none yet */
+	case PGM_RX_CPU:
+		if (PGM_UNLIKELY(!sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(*optlen < (socklen_t)(sock->rx_shard_len * sizeof (int))))
+			break;
+		*optlen = (socklen_t)(sock->rx_shard_len * sizeof (int));
+		for (unsigned i = 0; i < sock->rx_shard_len; i++)
+			((int*restrict)optval)[i] = sock->rx_shard[i].rx_cpu;
+		status = TRUE;
+		break;
+
+	case PGM_BUSY_POLL:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->busy_poll_usecs;
+		status = TRUE;
+		break;
+
+	case PGM_FEC_THREAD:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_fec_thread ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_RDATA_THREAD:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_rdata_thread ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_RXW_MIN_SQNS:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->rxw_min_sqns;
+		status = TRUE;
+		break;
+
+	case PGM_RXW_SHRINK:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_rxw_shrink ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_RXW_SPILL:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->rxw_spill_bytes;
+		status = TRUE;
+		break;
+
+	case PGM_MEM_BUDGET:
+		if (PGM_UNLIKELY(*optlen != sizeof (uint64_t)))
+			break;
+		*(uint64_t*restrict)optval = sock->mem_budget.max;
+		status = TRUE;
+		break;
+
+	case PGM_MEM_USED:
+		if (PGM_UNLIKELY(*optlen != sizeof (uint64_t)))
+			break;
+		*(uint64_t*restrict)optval = pgm_atomic_read64 (&sock->mem_budget.used);
+		status = TRUE;
+		break;
+
+	case PGM_EXCLUSIVE:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->is_exclusive ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_RX_COMPACT:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->rx_compact_len;
+		status = TRUE;
+		break;
+
+	case PGM_RX_REASSEMBLE:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->rx_reasm_len;
+		status = TRUE;
+		break;
+
+	case PGM_DECODE_THREADS:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->decode_threads;
+		status = TRUE;
+		break;
+
+	case PGM_TXW_SLOTS:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_txw_slots ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_HUGETLB:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->hugetlb_size;
+		status = TRUE;
+		break;
+
+	case PGM_MLOCK:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_mlock ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_NUMA_NODE:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->numa_node;
+		status = TRUE;
+		break;
+
+	case PGM_COALESCE:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->coalesce_threshold;
+		status = TRUE;
+		break;
+
+	case PGM_COALESCE_IVL:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)pgm_to_usecs (sock->coalesce_ivl);
+		status = TRUE;
+		break;
+
+	case PGM_FEC_IDLE_IVL:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)pgm_to_usecs (sock->fec_idle_ivl);
+		status = TRUE;
+		break;
+
+	case PGM_SPM_SUPPRESS_IVL:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->spm_suppress_ivl;
+		status = TRUE;
+		break;
+
+	case PGM_MULTI_PRODUCER:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_multi_producer ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_SEND_ASYNC:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->async_len;
+		status = TRUE;
+		break;
+
+	case PGM_CONFLATE:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_conflateinfo_t)))
+			break;
+		{
+			struct pgm_conflateinfo_t*restrict conflateinfo = optval;
+			conflateinfo->key	 = sock->conflate_key;
+			conflateinfo->user_data	 = sock->conflate_data;
+			conflateinfo->conflated	 = 0;
+			for (unsigned i = 0; i < sock->rx_shard_len; i++)
+				conflateinfo->conflated += sock->rx_shard[ i ].conflate_drops;
+		}
+		status = TRUE;
+		break;
+
+	case PGM_COMPRESS:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->compress_accel;
+		status = TRUE;
+		break;
+
+	case PGM_TXTIME:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->txtime_mode;
+		status = TRUE;
+		break;
+
+	case PGM_TX_PRIORITY:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_tx_priority ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_RDATA_SHARE:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->rdata_share;
+		status = TRUE;
+		break;
+
+	case PGM_NAK_ADAPTIVE:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_adaptive_nak ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_NAK_POPULATION:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)MIN(sock->nak_population, (uint32_t)INT_MAX);
+		status = TRUE;
+		break;
+
+	case PGM_NAK_RECEIVER_RATE:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)MIN(sock->nak_receiver_rate, (uint32_t)INT_MAX);
+		status = TRUE;
+		break;
+
+	case PGM_NAK_BATCH:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_nak_batch ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_CRC32C:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_crc32c ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_XDP_FILTER:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_xdp_filter ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_PREWARM:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->prewarm_peers;
+		status = TRUE;
+		break;
+
+	case PGM_PMTU_DISCOVERY:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_pmtud ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_ODATA_DSCP:
+	case PGM_RDATA_DSCP:
+	case PGM_SPM_DSCP:
+	case PGM_NAK_DSCP:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->class_dscp[ (PGM_ODATA_DSCP == optname) ? PGM_TX_CLASS_ODATA :
+							 (PGM_RDATA_DSCP == optname) ? PGM_TX_CLASS_RDATA :
+							 (PGM_SPM_DSCP == optname)   ? PGM_TX_CLASS_SPM : PGM_TX_CLASS_NAK ];
+		status = TRUE;
+		break;
+
+/* TPDU size in use, max_tpdu unless lowered by path MTU discovery */
+	case PGM_PATH_MTU:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->is_bound ? sock->path_mtu : sock->max_tpdu;
+		status = TRUE;
+		break;
+
+	case PGM_NAK_RANGE:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_nak_range ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_LATENCY_BUDGET:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->latency_budget;
+		status = TRUE;
+		break;
+
+	case PGM_UNORDERED:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_unordered ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_RECV_QUANTUM:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->recv_quantum;
+		status = TRUE;
+		break;
+
+	case PGM_STREAM_COPY:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->stream_copy_len;
+		status = TRUE;
+		break;
+
+	case PGM_SEND_TIMESTAMP:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_send_timestamp ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_FLIGHTREC:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_flightrecinfo_t)))
+			break;
+		{
+			struct pgm_flightrecinfo_t*restrict flightrecinfo = optval;
+			const pgm_flightrec_t* flightrec = sock->flightrec;
+			flightrecinfo->len		= flightrec ? flightrec->mask + 1 : (sock->is_bound ? 0 : sock->flightrec_len);
+			flightrecinfo->dump_on_reset	= sock->use_flightrec_dump ? 1 : 0;
+			flightrecinfo->events		= flightrec ? pgm_atomic_read32 (&flightrec->head) : 0;
+		}
+		status = TRUE;
+		break;
+
+	case PGM_PEER_REPAIR:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_peer_repair ? 1 : 0;
+		status = TRUE;
+		break;
+
+/* TSIs of current sources, a shorter buffer fails with optlen set to the
+ * length required.
+ */
+	case PGM_PEERS:
+		if (PGM_UNLIKELY(!sock->is_connected || !sock->can_recv_data))
+			break;
+		pgm_rwlock_reader_lock (&sock->peers_lock);
+		{
+			const socklen_t len = (socklen_t)(pgm_list_length (sock->peers_list) * sizeof (pgm_tsi_t));
+			if (*optlen >= len) {
+				pgm_tsi_t*restrict tsi = optval;
+				for (pgm_list_t* list = sock->peers_list; list; list = list->next)
+					*tsi++ = ((const pgm_peer_t*)list->data)->tsi;
+				status = TRUE;
+			}
+			*optlen = len;
+		}
+		pgm_rwlock_reader_unlock (&sock->peers_lock);
+		break;
+
+/* metrics of the source with the TSI of the argument */
+	case PGM_PEER_STATS:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_peerstatsinfo_t)))
+			break;
+		if (PGM_UNLIKELY(!sock->is_connected || !sock->can_recv_data))
+			break;
+		pgm_rwlock_reader_lock (&sock->peers_lock);
+		for (pgm_list_t* list = sock->peers_list; list; list = list->next)
+		{
+			pgm_peer_t* peer = list->data;
+			if (pgm_tsi_equal (&peer->tsi, &((const struct pgm_peerstatsinfo_t*)optval)->tsi)) {
+				pgm_peer_get_stats (peer, optval);
+				status = TRUE;
+				break;
+			}
+		}
+		pgm_rwlock_reader_unlock (&sock->peers_lock);
+		break;
+
+/* transmit window metrics of the socket as a source */
+	case PGM_SOURCE_STATS:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_sourcestatsinfo_t)))
+			break;
+		if (PGM_UNLIKELY(!sock->is_bound || !sock->can_send_data))
+			break;
+		pgm_source_get_stats (sock, optval);
+		status = TRUE;
+		break;
+
+/* counter rates of the socket as a source, or of the source with the TSI of
+ * the argument.
+ */
+	case PGM_RATES:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_rateinfo_t)))
+			break;
+		{
+			struct pgm_rateinfo_t*restrict info = optval;
+			uint64_t rates[PGM_STATS_RATE_MAX];
+			if (PGM_UNLIKELY(0 == info->interval || info->interval >= PGM_STATS_RING_LEN))
+				break;
+			if (pgm_tsi_equal (&info->tsi, &sock->tsi)) {
+				info->interval = pgm_stats_ring_rates (sock->rates, info->interval, rates);
+				status = TRUE;
+			} else if (sock->is_connected && sock->can_recv_data) {
+				pgm_rwlock_reader_lock (&sock->peers_lock);
+				const pgm_peer_t* peer = pgm_peer_table_lookup (pgm_rx_shard_for (sock, &info->tsi)->peers_table, &info->tsi);
+				if (NULL != peer) {
+					info->interval = pgm_stats_ring_rates (peer->rates, info->interval, rates);
+					status = TRUE;
+				}
+				pgm_rwlock_reader_unlock (&sock->peers_lock);
+			}
+			if (status) {
+				info->packets_per_sec = rates[PGM_STATS_RATE_PACKETS];
+				info->bytes_per_sec   = rates[PGM_STATS_RATE_BYTES];
+				info->naks_per_sec    = rates[PGM_STATS_RATE_NAKS];
+				info->losses_per_sec  = rates[PGM_STATS_RATE_LOSSES];
+			}
+		}
+		break;
+
+	case PGM_POLL_IVL:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->poll_ivl;
+		status = TRUE;
+		break;
+
+/* receivers estimated from the last closed general POLL round */
+	case PGM_POLL_POPULATION:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)MIN(sock->poll_population, (uint32_t)INT_MAX);
+		status = TRUE;
+		break;
+
+	case PGM_ZEROCOPY:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_zerocopy ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_PARITY_CACHE:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = (int)sock->parity_cache;
+		status = TRUE;
+		break;
+
+	case PGM_ADAPTIVE_FEC:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_adaptivefecinfo_t)))
+			break;
+		if (PGM_UNLIKELY(!sock->use_adaptive_parity))
+			break;
+		{
+			struct pgm_adaptivefecinfo_t*restrict adaptivefecinfo = optval;
+			adaptivefecinfo->min_proactive_packets = sock->rs_proactive_h_min;
+			adaptivefecinfo->max_proactive_packets = sock->rs_proactive_h_max;
+		}
+		status = TRUE;
+		break;
+
+	case PGM_RECV_BATCH:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->rx_batch_size;
+		status = TRUE;
+		break;
+
+	case PGM_SEND_BATCH:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->tx_batch_size;
+		status = TRUE;
+		break;
+
+	case PGM_SKB_POOL:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->skb_pool_size;
+		status = TRUE;
+		break;
+
+	case PGM_SKB_POOL_MEMORY:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_skbmeminfo_t)))
+			break;
+		{
+			struct pgm_skbmeminfo_t*restrict skbmeminfo = optval;
+			skbmeminfo->addr = sock->skb_pool_addr;
+			skbmeminfo->len  = sock->skb_pool_len;
+		}
+		status = TRUE;
+		break;
+
+	case PGM_SHARED_RECV:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->use_shared_recv ? 1 : 0;
+		status = TRUE;
+		break;
+
+	case PGM_RX_TIMESTAMP:
+		if (PGM_UNLIKELY(*optlen != sizeof (int)))
+			break;
+		*(int*restrict)optval = sock->rx_timestamp_mode;
+		status = TRUE;
+		break;
+
+	case PGM_REPLAY:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_replayinfo_t)))
+			break;
+		{
+			struct pgm_replayinfo_t*restrict replayinfo = optval;
+			replayinfo->path    = sock->replay_path;
+			replayinfo->speed   = sock->replay_speed;
+			replayinfo->packets = sock->replay ? sock->replay->packets : 0;
+		}
+		status = TRUE;
+		break;
+
+	case PGM_SHM:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_shminfo_t)))
+			break;
+		{
+			struct pgm_shminfo_t*restrict shminfo = optval;
+			const struct pgm_shm_t* shm = sock->shm;
+			shminfo->name	  = sock->shm_name;
+			shminfo->slots	  = (NULL != shm && NULL != shm->ring) ? shm->ring->slots : sock->shm_slots;
+			shminfo->interval = sock->shm_interval;
+			if (NULL == shm)
+				shminfo->packets = 0;
+			else if (shm->is_writer)
+				shminfo->packets = (NULL != shm->ring) ? shm->ring->head : 0;
+			else
+				shminfo->packets = shm->packets;
+			shminfo->overruns = (NULL != shm) ? shm->overruns : 0;
+		}
+		status = TRUE;
+		break;
+
+	case PGM_LOOPBACK:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_loopinfo_t)))
+			break;
+		{
+			struct pgm_loopinfo_t*restrict loopinfo = optval;
+			const struct pgm_loop_member_t* loop = sock->loop;
+			loopinfo->name	       = sock->loop_name;
+			loopinfo->loss_rate    = sock->loop_loss_rate;
+			loopinfo->reorder_rate = sock->loop_reorder_rate;
+			loopinfo->seed	       = sock->loop_seed;
+			loopinfo->packets      = (NULL != loop) ? loop->packets : 0;
+			loopinfo->overruns     = (NULL != loop) ? loop->overruns : 0;
+			loopinfo->losses       = (NULL != loop) ? loop->losses : 0;
+		}
+		status = TRUE;
+		break;
+
+	case PGM_RATE_GROUP:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_rategroupinfo_t)))
+			break;
+		{
+			struct pgm_rategroupinfo_t*restrict rategroupinfo = optval;
+			const struct pgm_rate_group_t* group = sock->rate_group;
+			rategroupinfo->name    = sock->rate_group_name;
+			rategroupinfo->max_rte = (NULL != group) ? group->bucket.rate_per_sec : sock->rate_group_max;
+			rategroupinfo->min_rte = sock->rate_group_min;
+			rategroupinfo->members = (NULL != group) ? group->ref_count : 0;
+		}
+		status = TRUE;
+		break;
+
+	case PGM_TXLOG:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_txloginfo_t)))
+			break;
+		{
+			struct pgm_txloginfo_t*restrict txloginfo = optval;
+			const pgm_txlog_t* txlog = sock->txlog;
+			txloginfo->path		= sock->txlog_path;
+			txloginfo->segment_sqns	= txlog ? txlog->segment_sqns : sock->txlog_segment_sqns;
+			txloginfo->segments	= txlog ? txlog->segments_max : sock->txlog_segments;
+			txloginfo->trail	= txlog ? pgm_atomic_read32 (&txlog->trail) : 0;
+			txloginfo->packets	= txlog ? txlog->packets : 0;
+			txloginfo->retransmits	= txlog ? txlog->retransmits : 0;
+		}
+		status = TRUE;
+		break;
+
+	case PGM_STANDBY:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_standbyinfo_t)))
+			break;
+		if (PGM_UNLIKELY(NULL == sock->standby))
+			break;
+		{
+			struct pgm_standbyinfo_t*restrict standbyinfo = optval;
+			const struct pgm_standby_t* standby = sock->standby;
+			memcpy (&standbyinfo->addr, &standby->addr, sizeof (struct sockaddr_storage));
+			memcpy (&standbyinfo->peer, &standby->peer, sizeof (struct sockaddr_storage));
+			standbyinfo->is_standby	= standby->is_mirror ? 0 : 1;
+			standbyinfo->timeout	= (uint32_t)standby->timeout;
+			standbyinfo->is_active	= sock->is_standby ? 0 : 1;
+			standbyinfo->packets	= standby->packets;
+			standbyinfo->gaps	= standby->gaps;
+			standbyinfo->refused	= standby->refused;
+		}
+		status = TRUE;
+		break;
+
+	case PGM_LATE_JOIN:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_joininfo_t)))
+			break;
+		if (PGM_UNLIKELY(!sock->use_late_join))
+			break;
+		{
+			struct pgm_joininfo_t*restrict joininfo = optval;
+			joininfo->sequence  = sock->late_join_sqn;
+			joininfo->is_oldest = sock->late_join_is_oldest;
+		}
+		status = TRUE;
+		break;
+
+	case PGM_RX_TUNE:
+		if (PGM_UNLIKELY(*optlen != sizeof (struct pgm_rxtuneinfo_t)))
+			break;
+		if (PGM_UNLIKELY(!sock->use_rx_tune))
+			break;
+		{
+			struct pgm_rxtuneinfo_t*restrict rxtuneinfo = optval;
+			rxtuneinfo->rcvbuf_min	 = (uint32_t)sock->rx_tune_rcvbuf_min;
+			rxtuneinfo->rcvbuf_max	 = (uint32_t)sock->rx_tune_rcvbuf_max;
+			rxtuneinfo->rxw_min_sqns = sock->rx_tune_rxw_min_sqns;
+			rxtuneinfo->rxw_max_sqns = sock->rx_tune_rxw_max_sqns;
+			rxtuneinfo->rxw_secs	 = sock->rx_tune_rxw_secs;
+			rxtuneinfo->rate	 = 0;
+			rxtuneinfo->drops	 = 0;
+			rxtuneinfo->rcvbuf	 = 0;
+			rxtuneinfo->rxw_sqns	 = sock->rxw_sqns;
+			if (sock->is_bound) {
+				for (unsigned i = 0; i < sock->rx_shard_len; i++) {
+					const struct pgm_rx_shard_t* shard = &sock->rx_shard[ i ];
+					rxtuneinfo->rate   += shard->rx_tune_rate;
+					rxtuneinfo->drops  += shard->rx_tune_drops;
+					rxtuneinfo->rcvbuf  = MAX(rxtuneinfo->rcvbuf, (uint32_t)shard->rx_tune_rcvbuf);
+				}
+			}
+		}
+		status = TRUE;
+		break;
+
+/** write-only options **/
+	case PGM_IP_ROUTER_ALERT:
+	case PGM_MULTICAST_LOOP:
+	case PGM_MULTICAST_HOPS:
+	case PGM_TOS:
+	case PGM_JOIN_GROUP:
+	case PGM_LEAVE_GROUP:
+	case PGM_BLOCK_SOURCE:
+	case PGM_UNBLOCK_SOURCE:
+	case PGM_JOIN_SOURCE_GROUP:
+	case PGM_LEAVE_SOURCE_GROUP:
+	case PGM_MSFILTER:
+	default:
+		break;
+	}
+	break;
+
+	default:
+	break;
+	}
+
+	pgm_rwlock_reader_unlock (&sock->lock);
+	return status;
+}
+
+bool
+pgm_setsockopt (
+	pgm_sock_t* const restrict sock,
+	const int		   level,		/* IPPROTO_PGM or SOL_SOCKET */
+	const int		   optname,
+	const void*	  restrict optval,
+	const socklen_t		   optlen
+	)
+{
+	bool status = FALSE;
+	pgm_return_val_if_fail (sock != NULL, status);
+	pgm_return_val_if_fail (IPPROTO_PGM == level || SOL_SOCKET == level, status);
+	if (PGM_UNLIKELY(!pgm_rwlock_reader_trylock (&sock->lock)))
+		pgm_return_val_if_reached (status);
+/* window sizes may be changed on a connected socket */
+	const bool is_live = (IPPROTO_PGM == level && (PGM_TXW_SQNS == optname || PGM_RXW_SQNS == optname));
+	if (PGM_UNLIKELY((sock->is_connected && !is_live) || sock->is_destroyed)) {
+		pgm_rwlock_reader_unlock (&sock->lock);
+		return status;
+	}
+
+	switch (level) {
+	case SOL_SOCKET:
+	switch (optname) {
+
+/* 0 < wmem < wmem_max (user)
+ *
+ * operating system and sysctl dependent maximum, minimum on Linux 256 (doubled).
+ */
+	case SO_SNDBUF:
+		if (SOCKET_ERROR == setsockopt (sock->send_sock, SOL_SOCKET, SO_SNDBUF, (const char*)optval, optlen) ||
+		    SOCKET_ERROR == setsockopt (sock->send_with_router_alert_sock, SOL_SOCKET, SO_SNDBUF, (const char*)optval, optlen))
+			break;
+		status = TRUE;
+		break;
+
+/* 0 < rmem < rmem_max (user)
+ *
+ * minimum on Linux is 2048 (doubled).
+ */
+	case SO_RCVBUF:
+		{
+			unsigned i;
+			for (i = 0; i < sock->recv_shards; i++)
+				if (SOCKET_ERROR == setsockopt (pgm_recv_shard_sock (sock, i), SOL_SOCKET, SO_RCVBUF, (const char*)optval, optlen))
+					break;
+			if (i < sock->recv_shards)
+				break;
+		}
+		status = TRUE;
 		break;
-	}
-	break;
 
 	default:
+		break;
+	}
 	break;
+
+	case IPPROTO_PGM:
+	switch (optname) {
+
+/* RFC2113 IP Router Alert 
+ */
+	case PGM_IP_ROUTER_ALERT:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		{
+			const bool v = (0 != *(const int*)optval);
+			if (SOCKET_ERROR == pgm_sockaddr_router_alert (sock->send_with_router_alert_sock, sock->family, v))
+				break;
+		}
+		status = TRUE;
+		break;
+
+/* IPv4:   68 <= tpdu < 65536		(RFC 2765)
+ * IPv6: 1280 <= tpdu < 65536		(RFC 2460)
+ */
+	case PGM_MTU:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < (int)(sizeof(struct pgm_ip) + sizeof(struct pgm_header))))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval > UINT16_MAX))
+			break;
+		sock->max_tpdu = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* 1 = enable multicast loopback.
+ * 0 = default, to disable.
+ */
+	case PGM_MULTICAST_LOOP:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		{
+			const bool v = (0 != *(const int*)optval);
+#if !defined(_WIN32) && !defined(__CYGWIN__)	/* loop on send */
+			if (SOCKET_ERROR == pgm_sockaddr_multicast_loop (sock->send_sock, sock->family, v) ||
+			    SOCKET_ERROR == pgm_sockaddr_multicast_loop (sock->send_with_router_alert_sock, sock->family, v))
+				break;
+			for (unsigned i = 0; i < sock->send_path_len; i++)
+				pgm_sockaddr_multicast_loop (sock->send_path_sock[ i ], sock->family, v);
+#else		/* loop on receive */
+			if (SOCKET_ERROR == pgm_sockaddr_multicast_loop (sock->recv_sock, sock->family, v))
+				break;
+#endif
+		}
+		status = TRUE;
+		break;
+
+/* 0 < hops < 256, hops == -1 use kernel default (ignored).
+ */
+	case PGM_MULTICAST_HOPS:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval > UINT8_MAX))
+			break;
+		{
+			sock->hops = *(const int*)optval;
+			if (SOCKET_ERROR == pgm_sockaddr_multicast_hops (sock->send_sock, sock->family, sock->hops) ||
+			    SOCKET_ERROR == pgm_sockaddr_multicast_hops (sock->send_with_router_alert_sock, sock->family, sock->hops))
+				break;
+			for (unsigned i = 0; i < sock->send_path_len; i++)
+				pgm_sockaddr_multicast_hops (sock->send_path_sock[ i ], sock->family, sock->hops);
+		}
+		status = TRUE;
+		break;
+
+/* IP Type of Service (ToS) or RFC 3246, differentiated services (DSCP)
+ */
+	case PGM_TOS:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		{
+			const int tos = sock->tos;
+			sock->tos = *(const int*)optval;
+			if (!socket_set_tos (sock)) {
+				sock->tos = tos;
+				break;
+			}
+		}
+		status = TRUE;
+		break;
+
+/* RFC 2474 differentiated services code point of one packet class in place of
+ * PGM_TOS, such that repairs and session messages may take a switch queue of
+ * higher priority than original data.  0 <= dscp < 64, -1 for PGM_TOS.
+ */
+	case PGM_ODATA_DSCP:
+	case PGM_RDATA_DSCP:
+	case PGM_SPM_DSCP:
+	case PGM_NAK_DSCP:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < -1 || *(const int*)optval > 63))
+			break;
+		{
+			const unsigned tx_class = (PGM_ODATA_DSCP == optname) ? PGM_TX_CLASS_ODATA :
+						  (PGM_RDATA_DSCP == optname) ? PGM_TX_CLASS_RDATA :
+						  (PGM_SPM_DSCP == optname)   ? PGM_TX_CLASS_SPM : PGM_TX_CLASS_NAK;
+			const int dscp = sock->class_dscp[ tx_class ];
+			sock->class_dscp[ tx_class ] = *(const int*)optval;
+			if (!socket_set_tos (sock)) {
+				sock->class_dscp[ tx_class ] = dscp;
+				break;
+			}
+		}
+		status = TRUE;
+		break;
+
+/* periodic ambient broadcast SPM interval in milliseconds.
+ */
+	case PGM_AMBIENT_SPM:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->spm_ambient_interval = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* longest interval in microseconds between ambient SPMs whilst original data
+ * carries the window trail, 0 to send every ambient SPM.  receivers bump peer
+ * expiry only on SPMs, such that PGM_PEER_EXPIRY must cover twice this.
+ */
+	case PGM_SPM_SUPPRESS_IVL:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
+			break;
+		sock->spm_suppress_ivl = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* sequence of heartbeat broadcast SPMS to flush out original 
+ */
+	case PGM_HEARTBEAT_SPM:
+		if (PGM_UNLIKELY(0 != optlen % sizeof (int)))
+			break;
+		{
+			sock->spm_heartbeat_len = optlen / sizeof (int);
+			sock->spm_heartbeat_interval = pgm_new (unsigned, sock->spm_heartbeat_len + 1);
+			sock->spm_heartbeat_interval[0] = 0;
+			for (unsigned i = 0; i < sock->spm_heartbeat_len; i++)
+				sock->spm_heartbeat_interval[i + 1] = ((const int*)optval)[i];
+		}
+		status = TRUE;
+		break;
+
+/* size of transmit window in sequence numbers.
+ * 0 < txw_sqns < one less than half sequence space
+ *
+ * after pgm_bind() the window is resized in place up to PGM_TXW_MAX_SQNS, a
+ * smaller window drains from the trail as data is sent.
+ */
+	case PGM_TXW_SQNS:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval >= (int)((UINT32_MAX/2)-1)))
+			break;
+		if (sock->is_bound) {
+			if (PGM_UNLIKELY(NULL == sock->window))
+				break;
+			pgm_mutex_lock (&sock->source_mutex);
+			const bool is_resized = pgm_txw_set_max_length (sock->window, *(const int*)optval);
+			pgm_mutex_unlock (&sock->source_mutex);
+			if (PGM_UNLIKELY(!is_resized))
+				break;
+		}
+		sock->txw_sqns = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* transmit window allocation in sequence numbers, the limit of resizing
+ * PGM_TXW_SQNS after pgm_bind().  zero for the initial window, must be set
+ * before pgm_bind().
+ */
+	case PGM_TXW_MAX_SQNS:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0 ||
+				 *(const int*)optval >= (int)((UINT32_MAX/2)-1)))
+			break;
+		sock->txw_max_sqns = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* size of transmit window in seconds.
+ * 0 < secs < ( txw_sqns / txw_max_rte )
+ */
+	case PGM_TXW_SECS:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->txw_secs = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* maximum transmit rate.
+ * 0 < txw_max_rte < interface capacity
+ *  10mb :   1250000
+ * 100mb :  12500000
+ *   1gb : 125000000
+ */
+	case PGM_TXW_MAX_RTE:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->txw_max_rte = *(const int*)optval;
+/* default to controlling SPM, ODATA, and RDATA packets. */
+		sock->is_controlled_odata = TRUE;
+		sock->is_controlled_rdata = TRUE;
+		status = TRUE;
+		break;
+
+/* maximum original data rate.
+ * 0 < odata_max_rte < txw_max_rte
+ */
+	case PGM_ODATA_MAX_RTE:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->odata_max_rte = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* maximum repair data rate.
+ * 0 < rdata_max_rte < txw_max_rte
+ */
+	case PGM_RDATA_MAX_RTE:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->rdata_max_rte = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* ignore rate limit for original data packets, i.e. only apply to repairs.
+ */
+	case PGM_UNCONTROLLED_ODATA:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->is_controlled_odata = (0 == *(const int*)optval);
+		status = TRUE;
+		break;
+
+/* ignore rate limit for repair data packets, i.e. only apply to original data.
+ */
+	case PGM_UNCONTROLLED_RDATA:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->is_controlled_rdata = (0 == *(const int*)optval);
+		status = TRUE;
+		break;
+
+/* timeout for peers.
+ * 0 < 2 * spm_ambient_interval <= peer_expiry
+ */
+	case PGM_PEER_EXPIRY:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->peer_expiry = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* maximum back off range for listening for multicast SPMR.
+ * 0 < spmr_expiry < spm_ambient_interval
+ */
+	case PGM_SPMR_EXPIRY:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->spmr_expiry = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* act as Designated Local Repairer for the site, caching the most recent
+ * sequence numbers of each source to repair redirected NAKs locally.
+ * 0 = disabled, 0 < dlr_sqns <= PGM_DLR_SQNS_MAX, before pgm_bind().
+ */
+	case PGM_DLR:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0 || *(const int*)optval > PGM_DLR_SQNS_MAX))
+			break;
+		sock->dlr_sqns = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* unicast address of the site DLR, NAKs of new sources are sent there in
+ * place of the source.  AF_UNSPEC to disable.
+ */
+	case PGM_DLR_REDIRECT:
+		if (PGM_UNLIKELY(optlen != sizeof (struct sockaddr_storage)))
+			break;
+		{
+			const struct sockaddr* dlr_nla = optval;
+			if (AF_UNSPEC != dlr_nla->sa_family &&
+			    (PGM_UNLIKELY(sock->family != dlr_nla->sa_family) ||
+			     PGM_UNLIKELY(pgm_sockaddr_is_addr_multicast (dlr_nla))))
+				break;
+			memcpy (&sock->dlr_nla, optval, sizeof (struct sockaddr_storage));
+		}
+		status = TRUE;
+		break;
+
+/* relay the sessions received to a multicast group of another network,
+ * forwarding data unchanged with the TSI and sequence numbers of the source.
+ * the relay answers NAKs of that network from the PGM_DLR cache, required.
+ * the send socket is opened here whilst privileges permit, bound to the
+ * interface by pgm_bind().
+ */
+	case PGM_RELAY:
+		if (PGM_UNLIKELY(optlen != sizeof(struct group_req)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(NULL != sock->relay && AF_UNSPEC != sock->relay->gr.gr_group.ss_family))
+			break;
+		{
+			const struct group_req* gr = optval;
+			if (PGM_UNLIKELY(sock->family != gr->gr_group.ss_family))
+				break;
+			if (PGM_UNLIKELY(!pgm_sockaddr_is_addr_multicast ((const struct sockaddr*)&gr->gr_group)))
+				break;
+			if (NULL != sock->relay)
+				pgm_relay_set_group (sock, gr);
+			else if (NULL == pgm_relay_create (sock, gr))
+				break;
+		}
+		status = TRUE;
+		break;
+
+/* add a unicast subscriber of the relay, a gateway to receivers without
+ * multicast using UDP encapsulation, required.  every TPDU relayed is sent
+ * to all subscribers with one sendmmsg() call, each within its own rate
+ * limit, and NAKs of a subscriber are repaired to it alone.  without
+ * PGM_RELAY the relay serves subscribers only.
+ */
+	case PGM_RELAY_SUBSCRIBER:
+		if (PGM_UNLIKELY(optlen != sizeof(struct pgm_relaysubinfo_t)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		{
+			const struct pgm_relaysubinfo_t* info = optval;
+			if (PGM_UNLIKELY(sock->family != info->addr.ss_family))
+				break;
+			if (PGM_UNLIKELY(pgm_sockaddr_is_addr_multicast ((const struct sockaddr*)&info->addr)))
+				break;
+			if (NULL == sock->relay &&
+			    NULL == pgm_relay_create (sock, NULL))
+				break;
+			if (!pgm_relay_add_subscriber (sock->relay, info))
+				break;
+		}
+		status = TRUE;
+		break;
+
+/* size of receive window in sequence numbers.
+ * 0 < rxw_sqns < one less than half sequence space
+ *
+ * after pgm_bind() the windows of new and existing peers are resized, a
+ * window is not shrunk below its occupied span until the trail advances.
+ */
+	case PGM_RXW_SQNS:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval >= (int)((UINT32_MAX/2)-1)))
+			break;
+		sock->rxw_sqns = *(const int*)optval;
+		if (sock->is_bound && sock->can_recv_data)
+			peers_set_rxw_sqns (sock, sock->rxw_sqns);
+		status = TRUE;
+		break;
+
+/* size of receive window in seconds.
+ * 0 < secs < ( rxw_sqns / rxw_max_rte )
+ */
+	case PGM_RXW_SECS:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->rxw_secs = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* maximum receive rate, for determining window size with txw_secs.
+ * 0 < rxw_max_rte < interface capacity
+ */
+	case PGM_RXW_MAX_RTE:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->rxw_max_rte = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* maximum NAK back-off value nak_rb_ivl in milliseconds.
+ * 0 < nak_rb_ivl <= nak_bo_ivl
+ */
+	case PGM_NAK_BO_IVL:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->nak_bo_ivl = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* repeat interval prior to re-sending a NAK, in milliseconds.
+ */
+	case PGM_NAK_RPT_IVL:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->nak_rpt_ivl = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* interval waiting for repair data, in milliseconds.
+ */
+	case PGM_NAK_RDATA_IVL:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->nak_rdata_ivl = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* limit for data.
+ * 0 < nak_data_retries < 256
+ */
+	case PGM_NAK_DATA_RETRIES:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval > UINT8_MAX))
+			break;
+		sock->nak_data_retries = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* limit for NAK confirms.
+ * 0 < nak_ncf_retries < 256
+ */
+	case PGM_NAK_NCF_RETRIES:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval > UINT8_MAX))
+			break;
+		sock->nak_ncf_retries = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* Enable FEC for this sock, specifically Reed Solmon encoding RS(n,k), common
+ * setting is RS(255, 223).
+ *
+ * inputs:
+ *
+ * n = FEC Block size = [k+1, 255]
+ * k = original data packets == transmission group size = [2, 4, 8, 16, 32, 64, 128]
+ * m = symbol size = 8 bits
+ *
+ * outputs:
+ *
+ * h = 2t = n - k = parity packets
+ *
+ * when h > k parity packets can be lost.
+ */
+	case PGM_USE_FEC:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_fecinfo_t)))
+			break;
+		{
+			const struct pgm_fecinfo_t* fecinfo = optval;
+			if (PGM_UNLIKELY(0 != (fecinfo->group_size & (fecinfo->group_size - 1))))
+				break;
+			if (PGM_UNLIKELY(fecinfo->group_size < 2 || fecinfo->group_size > 128))
+				break;
+			if (PGM_UNLIKELY(fecinfo->group_size > fecinfo->block_size))
+				break;
+			const uint8_t parity_packets = fecinfo->block_size - fecinfo->group_size;
+/* technically could re-send previous packets */
+			if (PGM_UNLIKELY(fecinfo->proactive_packets > parity_packets))
+				break;
+/* check validity of parameters */
+			if (PGM_UNLIKELY(fecinfo->group_size > 223 && ((parity_packets * 223.0) / fecinfo->group_size) < 1.0))
+			{
+				pgm_error (_("k/h ratio too low to generate parity data."));
+				break;
+			}
+			sock->use_proactive_parity	= (fecinfo->proactive_packets > 0);
+			sock->use_ondemand_parity	= fecinfo->ondemand_parity_enabled;
+			sock->use_var_pktlen		= fecinfo->var_pktlen_enabled;
+			sock->rs_n			= fecinfo->block_size;
+			sock->rs_k			= fecinfo->group_size;
+			sock->rs_proactive_h		= fecinfo->proactive_packets;
+			sock->rs_proactive_h_min	= fecinfo->proactive_packets;
+			sock->rs_proactive_h_max	= fecinfo->proactive_packets;
+			sock->use_adaptive_parity	= FALSE;
+			sock->tg_sqn_shift		= pgm_power2_log2 (fecinfo->group_size);
+		}
+		status = TRUE;
+		break;
+
+/* vary proactive parity packets per transmission group between bounds
+ * following NAK rates and PGMCC loss reports.  must be set after PGM_USE_FEC
+ * and before pgm_bind().
+ */
+	case PGM_ADAPTIVE_FEC:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_adaptivefecinfo_t)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(0 == sock->rs_k))
+			break;
+		{
+			const struct pgm_adaptivefecinfo_t* adaptivefecinfo = optval;
+			if (PGM_UNLIKELY(0 == adaptivefecinfo->max_proactive_packets))
+				break;
+			if (PGM_UNLIKELY(adaptivefecinfo->min_proactive_packets > adaptivefecinfo->max_proactive_packets))
+				break;
+			if (PGM_UNLIKELY(adaptivefecinfo->max_proactive_packets > (sock->rs_n - sock->rs_k)))
+				break;
+			sock->use_adaptive_parity	= TRUE;
+			sock->use_proactive_parity	= TRUE;
+			sock->rs_proactive_h_min	= adaptivefecinfo->min_proactive_packets;
+			sock->rs_proactive_h_max	= adaptivefecinfo->max_proactive_packets;
+			sock->rs_proactive_h		= MAX(sock->rs_proactive_h_min, MIN(sock->rs_proactive_h, sock->rs_proactive_h_max));
+		}
+		status = TRUE;
+		break;
+
+/* microseconds without original data after which proactive parity covers the
+ * partial transmission group sent so far, 0 to wait for the group to fill.
+ * requires proactive parity with variable packet lengths, must be set after
+ * PGM_USE_FEC and before pgm_bind().
+ */
+	case PGM_FEC_IDLE_IVL:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
+			break;
+		if (PGM_UNLIKELY(0 != *(const int*)optval &&
+				 (!sock->use_proactive_parity || !sock->use_var_pktlen)))
+			break;
+		sock->fec_idle_ivl = pgm_usecs (*(const int*)optval);
+		status = TRUE;
+		break;
+
+/* congestion reporting */
+	case PGM_USE_CR:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		sock->crqst_ivl = *(const int*)optval;
+		sock->use_cr    = (sock->crqst_ivl > 0);
+		status = TRUE;
+		break;
+
+/* congestion control */
+	case PGM_USE_PGMCC:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_pgmccinfo_t)))
+			break;
+		{
+			const struct pgm_pgmccinfo_t* pgmccinfo = optval;
+			sock->ack_bo_ivl = pgmccinfo->ack_bo_ivl;
+			sock->ack_c      = pgmccinfo->ack_c;
+			sock->ack_c_p    = pgmccinfo->ack_c_p;
+			sock->use_pgmcc  = (sock->ack_c > 0);
+		}
+		status = TRUE;
+		break;
+
+/* source rate from the TCP throughput equation of the worst receiver in
+ * place of the PGMCC window, receivers keep PGM_USE_PGMCC.  requires
+ * PGM_USE_PGMCC and PGM_TXW_MAX_RTE as the ceiling rate, set before
+ * pgm_connect().
+ */
+	case PGM_USE_TFMCC:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_connected))
+			break;
+		sock->use_tfmcc = (0 != *(const int*)optval);
+		status = TRUE;
+		break;
+
+/* release the transmit window trail once acknowledged by PGMCC receivers and
+ * held for at least the given microseconds, 0 = release only when full.
+ * requires PGM_USE_PGMCC, must be set before pgm_bind().
+ */
+	case PGM_TXW_ACK_RELEASE:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		sock->txw_ack_hold = pgm_usecs (*(const int*)optval);
+		status = TRUE;
+		break;
+
+/* receivers that must acknowledge before release, 0 = all known receivers.
+ */
+	case PGM_TXW_ACK_QUORUM:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
+			break;
+		sock->txw_ack_quorum = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* AF_XDP packet I/O for multicast traffic on one queue of the send
+ * interface, packets are steered by an externally loaded XDP program
+ * redirecting into the supplied XSKMAP.  IPv4 only, must be set before
+ * pgm_bind().
+ */
+	case PGM_XDP:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_xdpinfo_t)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		{
+			const struct pgm_xdpinfo_t* xdpinfo = optval;
+			sock->xdp_queue_id  = xdpinfo->queue_id;
+			sock->xdp_xskmap_fd = xdpinfo->xskmap_fd;
+		}
+		status = TRUE;
+		break;
+
+/* io_uring receive and transmit with the provided number of packet buffers
+ * and in-flight sends, a power of two.  Zero disables, must be set before
+ * pgm_bind().
+ */
+	case PGM_IO_URING:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		{
+			const int entries = *(const int*)optval;
+			if (PGM_UNLIKELY(entries < 0 || entries > PGM_URING_ENTRIES_MAX))
+				break;
+			if (PGM_UNLIKELY(entries & (entries - 1)))
+				break;
+			sock->uring_entries = (unsigned)entries;
+		}
+		status = TRUE;
+		break;
+
+/* Windows Registered I/O receive and transmit with the provided number of
+ * outstanding receives and in-flight sends, a power of two.  Zero disables,
+ * must be set before pgm_bind().
+ */
+	case PGM_RIO:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		{
+			const int entries = *(const int*)optval;
+			if (PGM_UNLIKELY(entries < 0 || entries > PGM_RIO_ENTRIES_MAX))
+				break;
+			if (PGM_UNLIKELY(entries & (entries - 1)))
+				break;
+			sock->rio_entries = (unsigned)entries;
+		}
+		status = TRUE;
+		break;
+
+/* post Registered I/O receive completions to an application completion port
+ * under the provided key in place of the internal event.  Each notification
+ * is followed by reads until PGM_IO_STATUS_WOULD_BLOCK, which re-arms it.
+ * Must be set before pgm_bind().
+ */
+	case PGM_RIO_IOCP:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_iocpinfo_t)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		{
+			const struct pgm_iocpinfo_t* iocpinfo = optval;
+			sock->rio_port = iocpinfo->port;
+			sock->rio_key  = iocpinfo->key;
+		}
+		status = TRUE;
+		break;
+
+/* DPDK poll-mode driver packet I/O for multicast traffic on one queue pair
+ * of an ethdev port configured and started by the application, shared by
+ * every socket naming the same queue.  IPv4 only, must be set before
+ * pgm_bind().
+ */
+	case PGM_DPDK:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_dpdkinfo_t)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		{
+			const struct pgm_dpdkinfo_t* dpdkinfo = optval;
+			sock->dpdk_port_id  = dpdkinfo->port_id < 0 ? -1 : dpdkinfo->port_id;
+			sock->dpdk_queue_id = dpdkinfo->queue_id;
+		}
+		status = TRUE;
+		break;
+
+/* declare socket only for sending, discard any incoming SPM, ODATA,
+ * RDATA, etc, packets.
+ */
+	case PGM_SEND_ONLY:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		sock->can_recv_data = (0 == *(const int*)optval);
+		status = TRUE;
+		break;
+
+/* declare socket only for receiving, no transmit window will be created
+ * and no SPM broadcasts sent.
+ */
+	case PGM_RECV_ONLY:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		sock->can_send_data = (0 == *(const int*)optval);
+		status = TRUE;
+		break;
+
+/* passive receiving socket, i.e. no back channel to source
+ */
+	case PGM_PASSIVE:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		sock->can_send_nak = (0 == *(const int*)optval);
+		status = TRUE;
+		break;
+
+/* on unrecoverable data loss stop socket from further transmission and
+ * receiving.
+ */
+	case PGM_ABORT_ON_RESET:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		sock->is_abort_on_reset = (0 != *(const int*)optval);
+		status = TRUE;
+		break;
+
+/* default non-blocking operation on send and receive sockets.
+ */
+	case PGM_NOBLOCK:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY((sock->use_multi_producer || 0 != sock->async_len) && 0 != *(const int*)optval))
+			break;
+		sock->is_nonblocking = (0 != *(const int*)optval);
+		pgm_sockaddr_nonblocking (sock->send_sock, sock->is_nonblocking);
+		pgm_sockaddr_nonblocking (sock->send_with_router_alert_sock, sock->is_nonblocking);
+		status = TRUE;
+		break;
+
+/* sending group, singular.  note that the address is only stored and used
+ * later in sendto() calls, this routine only considers the interface.
+ */
+	case PGM_SEND_GROUP:
+	{
+		void*     restrict tmp_optval = optval; 
+		socklen_t          tmp_optlen = optlen; 
+
+/* Use OpenPGM enhanced struct with support for multiple IP addresses per interface. */
+		if (tmp_optlen == sizeof(struct pgm_group_source_req))
+		{
+			const struct pgm_group_source_req* gsr = tmp_optval;
+			struct group_req* gr = pgm_alloca (sizeof (struct group_req));
+/* copy contents to bypass byte packing differences */
+			gr->gr_interface = gsr->gsr_interface;
+			memcpy (&gr->gr_group, &gsr->gsr_group, sizeof (struct sockaddr_storage));
+			tmp_optval = gr;
+			tmp_optlen = sizeof(struct group_req);
+		}
+		if (tmp_optlen == sizeof(struct group_req))
+		{
+			memcpy (&sock->send_gsr, tmp_optval, sizeof(struct group_req));
+			if (PGM_UNLIKELY(sock->family != sock->send_gsr.gsr_group.ss_family))
+				break;
+/* multicast group for later usage with sendto() */
+			if (sock->udp_encap_mcast_port)
+				((struct sockaddr_in*)&sock->send_gsr.gsr_group)->sin_port = htons (sock->udp_encap_mcast_port);
+/* interface */
+			if ((SOCKET_ERROR == pgm_sockaddr_multicast_if (sock->send_sock,
+									   (const struct sockaddr*)&sock->send_addr,
+									   sock->send_gsr.gsr_interface)) ||
+			    (SOCKET_ERROR == pgm_sockaddr_multicast_if (sock->send_with_router_alert_sock,
+									   (const struct sockaddr*)&sock->send_addr,
+									   sock->send_gsr.gsr_interface)))
+			{
+				break;
+			}
+			else if (PGM_UNLIKELY(pgm_log_mask & PGM_LOG_ROLE_NETWORK))
+			{
+				char addr[INET6_ADDRSTRLEN];
+				pgm_sockaddr_ntop ((const struct sockaddr*)&sock->send_addr, addr, sizeof(addr));
+				pgm_trace (PGM_LOG_ROLE_NETWORK,_("Multicast send interface set to %s index %u"),
+					addr,
+					(unsigned)sock->send_gsr.gsr_interface);
+			}
+		}
+	}
+		status = TRUE;
+		break;
+
+/* add a multicast group striping original data of the session with the
+ * send group, in units of the transmit batch by sequence number.  repairs,
+ * SPMs and NCFs stay on the send group, receivers join every stripe and
+ * the receive window merges by sequence number.  must be set before
+ * pgm_connect().
+ */
+	case PGM_SEND_STRIPE:
+		if (PGM_UNLIKELY(optlen != sizeof(struct group_req)))
+			break;
+		if (PGM_UNLIKELY(sock->is_connected))
+			break;
+		if (PGM_UNLIKELY(sock->send_stripe_len >= PGM_SEND_STRIPES_MAX))
+			break;
+		{
+			const struct group_req* gr = optval;
+			if (PGM_UNLIKELY(sock->family != gr->gr_group.ss_family))
+				break;
+			if (PGM_UNLIKELY(!pgm_sockaddr_is_addr_multicast ((const struct sockaddr*)&gr->gr_group)))
+				break;
+			if (NULL == sock->send_stripe)
+				sock->send_stripe = pgm_new0 (struct sockaddr_storage, PGM_SEND_STRIPES_MAX);
+			struct sockaddr_storage* stripe = &sock->send_stripe[ sock->send_stripe_len ];
+			memcpy (stripe, &gr->gr_group, pgm_sockaddr_len ((const struct sockaddr*)&gr->gr_group));
+			if (sock->udp_encap_mcast_port)
+				((struct sockaddr_in*)stripe)->sin_port = htons (sock->udp_encap_mcast_port);
+			sock->send_stripe_len++;
+		}
+		status = TRUE;
+		break;
+
+/* add a redundant interface duplicating every multicast packet of the socket,
+ * for independent A/B networks.  packets to the send group are sent to the
+ * group of the request, other groups unchanged.  receivers join the groups
+ * of each interface on one socket, the receive window keeps the first
+ * arrival and counts later copies as duplicates.  the send socket is opened
+ * here whilst privileges permit, bound to the interface by pgm_bind().
+ */
+	case PGM_SEND_PATH:
+		if (PGM_UNLIKELY(optlen != sizeof(struct group_req)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(sock->send_path_len >= PGM_SEND_PATHS_MAX))
+			break;
+		{
+			const struct group_req* gr = optval;
+			if (PGM_UNLIKELY(sock->family != gr->gr_group.ss_family))
+				break;
+			if (PGM_UNLIKELY(!pgm_sockaddr_is_addr_multicast ((const struct sockaddr*)&gr->gr_group)))
+				break;
+			const SOCKET path_sock = open_socket (sock->family,
+							      IPPROTO_UDP == sock->protocol ? SOCK_DGRAM : SOCK_RAW,
+							      sock->protocol);
+			if (INVALID_SOCKET == path_sock)
+				break;
+			if (NULL == sock->send_path) {
+				sock->send_path      = pgm_new0 (struct group_req, PGM_SEND_PATHS_MAX);
+				sock->send_path_sock = pgm_new (SOCKET, PGM_SEND_PATHS_MAX);
+			}
+			struct group_req* path = &sock->send_path[ sock->send_path_len ];
+			memcpy (path, gr, sizeof(struct group_req));
+			if (sock->udp_encap_mcast_port)
+				((struct sockaddr_in*)&path->gr_group)->sin_port = htons (sock->udp_encap_mcast_port);
+			sock->send_path_sock[ sock->send_path_len++ ] = path_sock;
+		}
+		status = TRUE;
+		break;
+
+/* for any-source applications (ASM), join a new group
+ */
+	case PGM_JOIN_GROUP:
+	{
+		void*	  restrict tmp_optval = optval;
+		socklen_t	   tmp_optlen = optlen;
+
+/* Use OpenPGM enhanced struct with support for multiple IP addresses per interface. */
+		if (tmp_optlen == sizeof(struct pgm_group_source_req))
+		{
+			const struct pgm_group_source_req* gsr = tmp_optval;
+			struct group_req* gr = pgm_alloca (sizeof (struct group_req));
+/* copy contents to bypass byte packing differences */
+			gr->gr_interface = gsr->gsr_interface;
+			memcpy (&gr->gr_group, &gsr->gsr_group, sizeof (struct sockaddr_storage));
+			tmp_optval = gr;
+			tmp_optlen = sizeof(struct group_req);
+		}
+/* Use OS native RFC 3678 group request struct */
+		if (tmp_optlen == sizeof(struct group_req))
+		{
+			const struct group_req* gr = tmp_optval;
+/* any-source membership recorded with the group as source */
+			struct group_source_req gsr;
+			memset (&gsr, 0, sizeof(gsr));
+			gsr.gsr_interface = gr->gr_interface;
+			memcpy (&gsr.gsr_group, &gr->gr_group, pgm_sockaddr_len ((const struct sockaddr*)&gr->gr_group));
+			if (sock->udp_encap_mcast_port)
+				((struct sockaddr_in*)&gsr.gsr_group)->sin_port = htons (sock->udp_encap_mcast_port);
+			memcpy (&gsr.gsr_source, &gr->gr_group, pgm_sockaddr_len ((const struct sockaddr*)&gr->gr_group));
+/* verify not duplicate group/interface pairing */
+			if (pgm_groups_is_joined (sock, &gsr))
+			{
+#ifdef SOCK_DEBUG
+				char s[INET6_ADDRSTRLEN];
+				pgm_sockaddr_ntop ((const struct sockaddr*)&gr->gr_group, s, sizeof(s));
+				pgm_warn(_("Socket has already joined group %s on interface %u"), s, gr->gr_interface);
+#endif
+				break;
+			}
+/* Resolved address family gr->gr_group.ss_family can be different from sock->family = AF_UNSPEC */
+			unsigned shard;
+			for (shard = 0; shard < sock->recv_shards; shard++)
+				if (SOCKET_ERROR == pgm_sockaddr_join_group (pgm_recv_shard_sock (sock, shard), gr->gr_group.ss_family, gr) &&
+/* another socket sharing the receive socket joined first */
+				    !(NULL != sock->demux && PGM_SOCK_EADDRINUSE == pgm_get_last_sock_error()))
+					break;
+			if (shard < sock->recv_shards) {
+#ifdef SOCK_DEBUG
+				const int save_errno = pgm_get_last_sock_error();
+				char errbuf[1024];
+				char s[INET6_ADDRSTRLEN];
+				pgm_sockaddr_ntop ((const struct sockaddr*)&gr->gr_group, s, sizeof(s));
+				pgm_error(_("Join multicast group { .gr_interface = %u, .gr_group = \"%s\" } failed: %s(%d)"),
+					gr->gr_interface, s,
+					pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno), save_errno);
+#endif
+				break;
+			}
+			else if (PGM_UNLIKELY(pgm_log_mask & PGM_LOG_ROLE_NETWORK))
+			{
+				char addr[INET6_ADDRSTRLEN];
+				pgm_sockaddr_ntop ((const struct sockaddr*)&gr->gr_group, addr, sizeof(addr));
+				pgm_trace (PGM_LOG_ROLE_NETWORK,_("Join multicast group %s on interface index %u"),
+					addr,
+					(unsigned)gr->gr_interface);
+			}
+			pgm_groups_add (sock, &gsr);
+		}
 	}
+		pgm_filter_update (sock);
+#ifdef PGM_HAVE_DPDK
+		if (NULL != sock->dpdk)
+			pgm_dpdk_update_groups (sock);
+#endif
+		status = TRUE;
+		break;
+
+/* for any-source applications (ASM), leave a joined group.
+ */
+	case PGM_LEAVE_GROUP:
+		if (PGM_UNLIKELY(optlen != sizeof(struct group_req)))
+			break;
+		if (PGM_UNLIKELY(0 == sock->recv_gsr_len))
+			break;
+		{
+			const struct group_req* gr = optval;
+/* drop all sources of the group on the interface, on every interface for zero */
+			struct group_source_req gsr;
+			memset (&gsr, 0, sizeof(gsr));
+			gsr.gsr_interface = gr->gr_interface;
+			memcpy (&gsr.gsr_group, &gr->gr_group, pgm_sockaddr_len ((const struct sockaddr*)&gr->gr_group));
+			(void)pgm_groups_remove (sock, &gsr, TRUE);
+			if (PGM_UNLIKELY(sock->family != gr->gr_group.ss_family))
+				break;
+/* membership of a shared receive socket stays for the other sockets */
+			if (pgm_demux_is_shared (sock)) {
+				status = TRUE;
+				break;
+			}
+			unsigned shard;
+			for (shard = 0; shard < sock->recv_shards; shard++)
+				if (SOCKET_ERROR == pgm_sockaddr_leave_group (pgm_recv_shard_sock (sock, shard), sock->family, gr))
+					break;
+			if (shard < sock->recv_shards)
+				break;
+			else if (PGM_UNLIKELY(pgm_log_mask & PGM_LOG_ROLE_NETWORK))
+			{
+				char addr[INET6_ADDRSTRLEN];
+				pgm_sockaddr_ntop ((const struct sockaddr*)&gr->gr_group, addr, sizeof(addr));
+				pgm_trace (PGM_LOG_ROLE_NETWORK,_("Leave multicast group %s on interface index %u"),
+					addr,
+					(unsigned)gr->gr_interface);
+			}
+		}
+		pgm_filter_update (sock);
+#ifdef PGM_HAVE_DPDK
+		if (NULL != sock->dpdk)
+			pgm_dpdk_update_groups (sock);
+#endif
+		status = TRUE;
+		break;
+
+/* for any-source applications (ASM), turn off a given source
+ */
+	case PGM_BLOCK_SOURCE:
+		if (PGM_UNLIKELY(optlen != sizeof(struct group_source_req)))
+			break;
+		{
+			const struct group_source_req* gsr = optval;
+			if (PGM_UNLIKELY(sock->family != gsr->gsr_group.ss_family))
+				break;
+			unsigned shard;
+			for (shard = 0; shard < sock->recv_shards; shard++)
+				if (SOCKET_ERROR == pgm_sockaddr_block_source (pgm_recv_shard_sock (sock, shard), sock->family, gsr))
+					break;
+			if (shard < sock->recv_shards)
+				break;
+			pgm_filter_block_source (sock, (const struct sockaddr*)&gsr->gsr_source);
+		}
+		pgm_filter_update (sock);
+		status = TRUE;
+		break;
+
+/* for any-source applications (ASM), re-allow a blocked source
+ */
+	case PGM_UNBLOCK_SOURCE:
+		if (PGM_UNLIKELY(optlen != sizeof(struct group_source_req)))
+			break;
+		{
+			const struct group_source_req* gsr = optval;
+			if (PGM_UNLIKELY(sock->family != gsr->gsr_group.ss_family))
+				break;
+			unsigned shard;
+			for (shard = 0; shard < sock->recv_shards; shard++)
+				if (SOCKET_ERROR == pgm_sockaddr_unblock_source (pgm_recv_shard_sock (sock, shard), sock->family, gsr))
+					break;
+			if (shard < sock->recv_shards)
+				break;
+			pgm_filter_unblock_source (sock, (const struct sockaddr*)&gsr->gsr_source);
+		}
+		pgm_filter_update (sock);
+		status = TRUE;
+		break;
+
+/* for controlled-source applications (SSM), join each group/source pair.
+ *
+ * SSM joins are allowed on top of ASM in order to merge a remote source onto the local segment.
+ */
+	case PGM_JOIN_SOURCE_GROUP:
+		if (PGM_UNLIKELY(optlen != sizeof(struct group_source_req)))
+			break;
+		{
+			const struct group_source_req* gsr = optval;
+/* verify not duplicate group/source/interface */
+			if (pgm_groups_is_joined (sock, gsr))
+			{
+#ifdef SOCK_DEBUG
+				char s1[INET6_ADDRSTRLEN], s2[INET6_ADDRSTRLEN];
+				pgm_sockaddr_ntop ((const struct sockaddr*)&gsr->gsr_group, s1, sizeof(s1));
+				pgm_sockaddr_ntop ((const struct sockaddr*)&gsr->gsr_source, s2, sizeof(s2));
+				pgm_warn(_("Socket has already joined group %s from source %s on interface %u"),
+					s1, s2, (unsigned)gsr->gsr_interface);
+#endif
+				break;
+			}
+			if (PGM_UNLIKELY(sock->family != gsr->gsr_group.ss_family))
+				break;
+			if (PGM_UNLIKELY(sock->family != gsr->gsr_source.ss_family))
+				break;
+			unsigned shard;
+			for (shard = 0; shard < sock->recv_shards; shard++)
+				if (SOCKET_ERROR == pgm_sockaddr_join_source_group (pgm_recv_shard_sock (sock, shard), sock->family, gsr))
+					break;
+			if (shard < sock->recv_shards)
+				break;
+			pgm_groups_add (sock, gsr);
+		}
+		pgm_filter_update (sock);
+#ifdef PGM_HAVE_DPDK
+		if (NULL != sock->dpdk)
+			pgm_dpdk_update_groups (sock);
+#endif
+		status = TRUE;
+		break;
+
+/* for controlled-source applications (SSM), leave each group/source pair
+ */
+	case PGM_LEAVE_SOURCE_GROUP:
+		if (PGM_UNLIKELY(optlen != sizeof(struct group_source_req)))
+			break;
+		if (PGM_UNLIKELY(0 == sock->recv_gsr_len))
+			break;
+		{
+			const struct group_source_req* gsr = optval;
+			(void)pgm_groups_remove (sock, gsr, FALSE);
+			if (PGM_UNLIKELY(sock->family != gsr->gsr_group.ss_family))
+				break;
+			if (PGM_UNLIKELY(sock->family != gsr->gsr_source.ss_family))
+				break;
+			unsigned shard;
+			for (shard = 0; shard < sock->recv_shards; shard++)
+				if (SOCKET_ERROR == pgm_sockaddr_leave_source_group (pgm_recv_shard_sock (sock, shard), sock->family, gsr))
+					break;
+			if (shard < sock->recv_shards)
+				break;
+		}
+		pgm_filter_update (sock);
+#ifdef PGM_HAVE_DPDK
+		if (NULL != sock->dpdk)
+			pgm_dpdk_update_groups (sock);
+#endif
+		status = TRUE;
+		break;
+
+/* batch block and unblock sources */
+	case PGM_MSFILTER:
+#if defined(MCAST_MSFILTER) || defined(SIOCSMSFILTER)
+		if (PGM_UNLIKELY(optlen < (socklen_t)sizeof(struct group_filter)))
+			break;
+		{
+			const struct group_filter* gf_list = optval;
+			if ((socklen_t)GROUP_FILTER_SIZE( gf_list->gf_numsrc ) != optlen)
+				break;
+			if (PGM_UNLIKELY(sock->family != gf_list->gf_group.ss_family))
+				break;
+/* check only first */
+			if (PGM_UNLIKELY(sock->family != gf_list->gf_slist[0].ss_family))
+				break;
+			unsigned shard;
+			for (shard = 0; shard < sock->recv_shards; shard++)
+				if (SOCKET_ERROR == pgm_sockaddr_msfilter (pgm_recv_shard_sock (sock, shard), sock->family, gf_list))
+					break;
+			if (shard < sock->recv_shards)
+				break;
+		}
+		status = TRUE;
+#endif
+		break;
+
+/* UDP encapsulation ports */
+	case PGM_UDP_ENCAP_UCAST_PORT:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		sock->udp_encap_ucast_port = *(const int*)optval;
+		status = TRUE;
+		break;
+
+	case PGM_UDP_ENCAP_MCAST_PORT:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		sock->udp_encap_mcast_port = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* UDP generic segmentation offload of equal sized packets of a transmit
+ * batch, requires UDP encapsulation and PGM_SEND_BATCH > 1, ignored where
+ * UDP_SEGMENT is unavailable.  disabled at run-time on kernels without support.
+ */
+	case PGM_UDP_GSO:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(IPPROTO_UDP != sock->protocol))
+			break;
+		sock->use_udp_gso = (0 != *(const int*)optval);
+		status = TRUE;
+		break;
+
+/* UDP generic receive offload, coalesced datagrams are split into packet
+ * buffers before parsing.  requires UDP encapsulation, ignored where UDP_GRO
+ * is unavailable.  must be set before pgm_bind().
+ */
+	case PGM_UDP_GRO:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(IPPROTO_UDP != sock->protocol))
+			break;
+		sock->use_udp_gro = (0 != *(const int*)optval);
+		status = TRUE;
+		break;
+
+/* trusted UDP encapsulated links, transmit ODATA and RDATA with PGM checksum
+ * zero and accept the same from peers, relying upon the UDP checksum.  peers
+ * sending checksums are still verified.  must be set before pgm_bind().
+ */
+	case PGM_UDP_ENCAP_ZERO_CHECKSUM:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(IPPROTO_UDP != sock->protocol))
+			break;
+		sock->use_zero_checksum = (0 != *(const int*)optval);
+		status = TRUE;
+		break;
+
+/* fan reception out over SO_REUSEPORT sockets, each keeping only the sources
+ * whose GSI hashes to it, so packets of one source always queue on the same
+ * socket.  requires UDP encapsulation and Linux socket filters.  must be set
+ * before pgm_bind() and before joining any group.
+ */
+	case PGM_RECV_SHARDS:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(IPPROTO_UDP != sock->protocol))
+			break;
+		if (PGM_UNLIKELY(sock->recv_gsr_len > 0))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval > PGM_RECV_SHARDS_MAX))
+			break;
+		if (!pgm_recv_shards_create (sock, *(const int*)optval))
+			break;
+		status = TRUE;
+		break;
+
+/* CPU of each receive shard for SO_INCOMING_CPU, the list repeats across the
+ * shards.  a receiving thread prefers the shard of the CPU it runs on.  must
+ * be set before pgm_bind().
+ */
+	case PGM_INCOMING_CPU:
+#ifdef SO_INCOMING_CPU
+		if (PGM_UNLIKELY(0 == optlen || 0 != optlen % sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(optlen / sizeof (int) > PGM_RECV_SHARDS_MAX))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		{
+			const unsigned len = optlen / sizeof (int);
+			bool is_valid = TRUE;
+			for (unsigned i = 0; i < len; i++)
+				if (((const int*)optval)[i] < 0)
+					is_valid = FALSE;
+			if (PGM_UNLIKELY(!is_valid))
+				break;
+			if (sock->incoming_cpu)
+				pgm_free (sock->incoming_cpu);
+			sock->incoming_cpu = pgm_new (int, len);
+			sock->incoming_cpu_len = len;
+			for (unsigned i = 0; i < len; i++)
+				sock->incoming_cpu[i] = ((const int*)optval)[i];
+		}
+		status = TRUE;
+#endif
+		break;
+
+/* busy-poll receive, spin for up to the given microseconds waiting for
+ * packets before blocking, with SO_BUSY_POLL on the receive socket where
+ * available.  zero disables, must be set before pgm_bind().
+ */
+	case PGM_BUSY_POLL:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
+			break;
+		sock->busy_poll_usecs = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* generate proactive parity on a dedicated encoder thread as each transmission
+ * group closes, instead of in the timer processing of the next receive call.
+ * must be set before pgm_bind().
+ */
+	case PGM_FEC_THREAD:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		sock->use_fec_thread = (0 != *(const int*)optval);
+		status = TRUE;
+		break;
+
+/* send repair data on a dedicated thread as NAKs arrive, instead of on the
+ * next receive call of the application.  must be set before pgm_bind().
+ */
+	case PGM_RDATA_THREAD:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		sock->use_rdata_thread = (0 != *(const int*)optval);
+		status = TRUE;
+		break;
 
-	pgm_rwlock_reader_unlock (&sock->lock);
-	return status;
-}
+/* initial receive window size in sequence numbers of each new peer, growing
+ * geometrically to the configured window as the sequence span requires.
+ * zero for a fully sized window, must be set before pgm_bind().
+ */
+	case PGM_RXW_MIN_SQNS:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0 ||
+				 *(const int*)optval >= (int)((UINT32_MAX/2)-1)))
+			break;
+		sock->rxw_min_sqns = *(const int*)optval;
+		status = TRUE;
+		break;
 
-bool
-pgm_setsockopt (
-	pgm_sock_t* const restrict sock,
-	const int		   level,		/* IPPROTO_PGM or SOL_SOCKET */
-	const int		   optname,
-	const void*	  restrict optval,
-	const socklen_t		   optlen
-	)
-{
-	bool status = FALSE;
-	pgm_return_val_if_fail (sock != NULL, status);
-	pgm_return_val_if_fail (IPPROTO_PGM == level || SOL_SOCKET == level, status);
-	if (PGM_UNLIKELY(!pgm_rwlock_reader_trylock (&sock->lock)))
-		pgm_return_val_if_reached (status);
-	if (PGM_UNLIKELY(sock->is_connected || sock->is_destroyed)) {
-		pgm_rwlock_reader_unlock (&sock->lock);
-		return status;
-	}
+/* shrink a grown receive window back toward PGM_RXW_MIN_SQNS as the
+ * sequence span drains.  must be set before pgm_bind().
+ */
+	case PGM_RXW_SHRINK:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		sock->use_rxw_shrink = (0 != *(const int*)optval);
+		status = TRUE;
+		break;
 
-	switch (level) {
-	case SOL_SOCKET:
-	switch (optname) {
+/* bytes of complete unread APDUs of each peer held beyond the receive window
+ * when a slow consumer would otherwise lose the trailing edge, delivered in
+ * order ahead of the window.  zero to disable, must be set before pgm_bind().
+ */
+	case PGM_RXW_SPILL:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
+			break;
+		sock->rxw_spill_bytes = *(const int*)optval;
+		status = TRUE;
+		break;
 
-/* 0 < wmem < wmem_max (user)
- *
- * operating system and sysctl dependent maximum, minimum on Linux 256 (doubled).
+/* limit of packet buffer bytes held by the transmit and all receive windows,
+ * 0 = unlimited.  over the limit new peers are refused and the window trails
+ * are released as if full, declaring unrepaired sequences lost.  the process
+ * limit is taken from the PGM_MEM_BUDGET environment variable.
  */
-	case SO_SNDBUF:
-		if (SOCKET_ERROR == setsockopt (sock->send_sock, SOL_SOCKET, SO_SNDBUF, (const char*)optval, optlen) ||
-		    SOCKET_ERROR == setsockopt (sock->send_with_router_alert_sock, SOL_SOCKET, SO_SNDBUF, (const char*)optval, optlen))
+	case PGM_MEM_BUDGET:
+		if (PGM_UNLIKELY(optlen != sizeof (uint64_t)))
 			break;
+		sock->mem_budget.max = *(const uint64_t*)optval;
 		status = TRUE;
 		break;
 
-/* 0 < rmem < rmem_max (user)
- *
- * minimum on Linux is 2048 (doubled).
+/* the application promises a single thread calls the send, receive and close
+ * functions of the socket, which then skip the per-call reader lock against a
+ * concurrent pgm_close() and every internal lock of the data path.  timers run
+ * only from that thread's calls.  incompatible with pgm_recv_async_start() and
+ * the parity, repair and sender threads.  must be set before pgm_bind().
  */
-	case SO_RCVBUF:
-		if (SOCKET_ERROR == setsockopt (sock->recv_sock, SOL_SOCKET, SO_RCVBUF, (const char*)optval, optlen))
+	case PGM_EXCLUSIVE:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		sock->is_exclusive = (0 != *(const int*)optval);
 		status = TRUE;
 		break;
 
-	default:
+/* hold received TPDUs up to this many bytes in a buffer sized to the packet
+ * rather than a max_tpdu slab buffer, pooled when set before pgm_bind().
+ * 0 = disabled.
+ */
+	case PGM_RX_COMPACT:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0 || *(const int*)optval > UINT16_MAX))
+			break;
+		sock->rx_compact_len = *(const int*)optval;
+		status = TRUE;
 		break;
-	}
-	break;
 
-	case IPPROTO_PGM:
-	switch (optname) {
+/* copy each fragment of a received APDU of at least this many bytes to its
+ * offset in one buffer as it arrives, such that the APDU is read as a single
+ * packet.  buffers are pooled by size class.  0 = disabled, must be set before
+ * pgm_bind().
+ */
+	case PGM_RX_REASSEMBLE:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0 || *(const int*)optval > PGM_MAX_APDU))
+			break;
+		sock->rx_reasm_len = *(const int*)optval;
+		status = TRUE;
+		break;
 
-/* RFC2113 IP Router Alert 
+/* reconstruct transmission groups from parity on this many threads instead of
+ * the receiving thread, groups of all peers share the threads.  0 = disabled,
+ * must be set before pgm_bind().
  */
-	case PGM_IP_ROUTER_ALERT:
+	case PGM_DECODE_THREADS:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0 || *(const int*)optval > PGM_DECODE_THREADS_MAX))
+			break;
+		sock->decode_threads = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* back the transmit window with one contiguous ring of max_tpdu sized packet
+ * slots indexed by sequence number, such that sending does not allocate a
+ * buffer per packet.  must be set before pgm_bind().
+ */
+	case PGM_TXW_SLOTS:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		sock->use_txw_slots = (0 != *(const int*)optval);
+		status = TRUE;
+		break;
+
+/* map the transmit window slot ring and packet buffer pool on huge pages of
+ * the given size, 2MB or 1GB, falling back to regular pages when none are
+ * reserved.  0 for regular pages.  must be set before pgm_bind().
+ */
+	case PGM_HUGETLB:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
 		{
-			const bool v = (0 != *(const int*)optval);
-			if (SOCKET_ERROR == pgm_sockaddr_router_alert (sock->send_with_router_alert_sock, sock->family, v))
+			const int page_size = *(const int*)optval;
+			if (PGM_UNLIKELY(0 != page_size &&
+					 PGM_HUGEPAGE_2MB != page_size &&
+					 PGM_HUGEPAGE_1GB != page_size))
 				break;
+			sock->hugetlb_size = (size_t)page_size;
 		}
 		status = TRUE;
 		break;
 
-/* IPv4:   68 <= tpdu < 65536		(RFC 2765)
- * IPv6: 1280 <= tpdu < 65536		(RFC 2460)
+/* prefault and lock the slot ring and packet buffer pool at pgm_bind() such
+ * that the data path does not page fault.  must be set before pgm_bind().
  */
-	case PGM_MTU:
+	case PGM_MLOCK:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval < (int)(sizeof(struct pgm_ip) + sizeof(struct pgm_header))))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval > UINT16_MAX))
+		sock->use_mlock = (0 != *(const int*)optval);
+		status = TRUE;
+		break;
+
+/* place the slot ring, packet buffer pool and encoder and repair threads on
+ * a NUMA node, PGM_NUMA_NODE_INTERFACE for the node of the bound interface.
+ * must be set before pgm_bind().
+ */
+	case PGM_NUMA_NODE:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		sock->max_tpdu = *(const int*)optval;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < PGM_NUMA_NODE_INTERFACE))
+			break;
+		sock->numa_node = *(const int*)optval;
 		status = TRUE;
 		break;
 
-/* 1 = enable multicast loopback.
- * 0 = default, to disable.
+/* pack APDUs sent with pgm_send() that fit alongside others into one original
+ * data packet, each preceded by a 16-bit length, sending the packet once this
+ * many bytes are pending.  limited to the largest packet at bind, 0 to send
+ * each APDU in its own packet.  unavailable with FEC.  must be set before
+ * pgm_bind().
  */
-	case PGM_MULTICAST_LOOP:
+	case PGM_COALESCE:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		{
-			const bool v = (0 != *(const int*)optval);
-#if !defined(_WIN32) && !defined(__CYGWIN__)	/* loop on send */
-			if (SOCKET_ERROR == pgm_sockaddr_multicast_loop (sock->send_sock, sock->family, v) ||
-			    SOCKET_ERROR == pgm_sockaddr_multicast_loop (sock->send_with_router_alert_sock, sock->family, v))
-				break;
-#else		/* loop on receive */
-			if (SOCKET_ERROR == pgm_sockaddr_multicast_loop (sock->recv_sock, sock->family, v))
-				break;
-#endif
-		}
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0 || *(const int*)optval > UINT16_MAX))
+			break;
+		sock->coalesce_threshold = (uint16_t)*(const int*)optval;
 		status = TRUE;
 		break;
 
-/* 0 < hops < 256, hops == -1 use kernel default (ignored).
+/* longest wait in microseconds of coalesced APDUs below the threshold, sent by
+ * the timer of the next receive call or with the next send.
  */
-	case PGM_MULTICAST_HOPS:
+	case PGM_COALESCE_IVL:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
 		if (PGM_UNLIKELY(*(const int*)optval <= 0))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval > UINT8_MAX))
+		sock->coalesce_ivl = pgm_usecs (*(const int*)optval);
+		status = TRUE;
+		break;
+
+/* pace data packets in the kernel with SO_TXTIME launch times derived from
+ * PGM_TXW_MAX_RTE, requiring a fq or etf qdisc on the outgoing interface.
+ * falls back to userspace regulation where unavailable.  must be set before
+ * pgm_bind().
+ */
+	case PGM_TXTIME:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		{
-			sock->hops = *(const int*)optval;
-			if (SOCKET_ERROR == pgm_sockaddr_multicast_hops (sock->send_sock, sock->family, sock->hops) ||
-			    SOCKET_ERROR == pgm_sockaddr_multicast_hops (sock->send_with_router_alert_sock, sock->family, sock->hops))
-				break;
-		}
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(PGM_TXTIME_NONE != *(const int*)optval &&
+				 PGM_TXTIME_FQ   != *(const int*)optval &&
+				 PGM_TXTIME_ETF  != *(const int*)optval))
+			break;
+		sock->txtime_mode = *(const int*)optval;
 		status = TRUE;
 		break;
 
-/* IP Type of Service (ToS) or RFC 3246, differentiated services (DSCP)
+/* schedule transmit by strict priority of SPM, then RDATA, then ODATA: SPMs
+ * bypass rate regulation and pending repairs are sent ahead of each new APDU.
+ * must be set before pgm_bind().
  */
-	case PGM_TOS:
+	case PGM_TX_PRIORITY:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (SOCKET_ERROR == pgm_sockaddr_tos (sock->send_sock, sock->family, *(const int*)optval) ||
-		    SOCKET_ERROR == pgm_sockaddr_tos (sock->send_with_router_alert_sock, sock->family, *(const int*)optval))
-		{
-			pgm_warn (_("ToS/DSCP setting requires CAP_NET_ADMIN or ADMIN capability."));
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-		}
+		sock->use_tx_priority = (0 != *(const int*)optval);
 		status = TRUE;
 		break;
 
-/* periodic ambient broadcast SPM interval in milliseconds.
+/* percentage of payload bytes for repairs whilst original data is waiting
+ * with PGM_TX_PRIORITY, 100 for repairs always first.  must be set before
+ * pgm_bind().
  */
-	case PGM_AMBIENT_SPM:
+	case PGM_RDATA_SHARE:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-		sock->spm_ambient_interval = *(const int*)optval;
+		if (PGM_UNLIKELY(*(const int*)optval <= 0 || *(const int*)optval > 100))
+			break;
+		sock->rdata_share = (unsigned)*(const int*)optval;
 		status = TRUE;
 		break;
 
-/* sequence of heartbeat broadcast SPMS to flush out original 
+/* derive NAK_BO_IVL, NAK_RPT_IVL and NAK_RDATA_IVL of each peer from the
+ * round-trip time of NAKs to NCF or RDATA, bounded by the socket intervals.
  */
-	case PGM_HEARTBEAT_SPM:
-		if (PGM_UNLIKELY(0 != optlen % sizeof (int)))
+	case PGM_NAK_ADAPTIVE:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		{
-			sock->spm_heartbeat_len = optlen / sizeof (int);
-			sock->spm_heartbeat_interval = pgm_new (unsigned, sock->spm_heartbeat_len + 1);
-			sock->spm_heartbeat_interval[0] = 0;
-			for (unsigned i = 0; i < sock->spm_heartbeat_len; i++)
-				sock->spm_heartbeat_interval[i + 1] = ((const int*)optval)[i];
-		}
+		sock->use_adaptive_nak = (0 != *(const int*)optval);
 		status = TRUE;
 		break;
 
-/* size of transmit window in sequence numbers.
- * 0 < txw_sqns < one less than half sequence space
+/* exponentially distributed NAK_RB_IVL scaled by the receiver population a
+ * source advertises in SPMs with OPT_POPULATION, otherwise the population
+ * given, such that few of many receivers NAK a common loss before the NCF.
+ * 0 restores the uniform back-off.
  */
-	case PGM_TXW_SQNS:
+	case PGM_NAK_POPULATION:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval >= (int)((UINT32_MAX/2)-1)))
+		sock->nak_population = (uint32_t)*(const int*)optval;
+		status = TRUE;
+		break;
+
+/* as a source accept at most this many NAKed sequences per second from each
+ * receiver address with one second of burst, such that one receiver cannot
+ * take the repair rate of the others.  0 = unlimited.  must be set before
+ * pgm_bind().
+ */
+	case PGM_NAK_RECEIVER_RATE:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		sock->txw_sqns = *(const int*)optval;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
+			break;
+		sock->nak_receiver_rate = (uint32_t)*(const int*)optval;
 		status = TRUE;
 		break;
 
-/* size of transmit window in seconds.
- * 0 < secs < ( txw_sqns / txw_max_rte )
+/* as a source merge the NAKs read in one burst, confirming each distinct
+ * sequence once when the receive socket drains.  OPT_NAK_RANGE NAKs are
+ * confirmed on arrival.  must be set before pgm_bind().
  */
-	case PGM_TXW_SECS:
+	case PGM_NAK_BATCH:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-		sock->txw_secs = *(const int*)optval;
+		sock->use_nak_batch = (0 != *(const int*)optval);
 		status = TRUE;
 		break;
 
-/* maximum transmit rate.
- * 0 < txw_max_rte < interface capacity
- *  10mb :   1250000
- * 100mb :  12500000
- *   1gb : 125000000
+/* send ODATA and RDATA with a CRC32C trailer, computed with SSE4.2 or ARMv8
+ * instructions where available, in place of the PGM checksum and advertise
+ * so with OPT_CRC32C in SPMs.  receivers verify trailers regardless of this
+ * option.  ignored with FEC.  must be set before pgm_bind().
  */
-	case PGM_TXW_MAX_RTE:
+	case PGM_CRC32C:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-		sock->txw_max_rte = *(const int*)optval;
-/* default to controlling SPM, ODATA, and RDATA packets. */
-		sock->is_controlled_odata = TRUE;
-		sock->is_controlled_rdata = TRUE;
+		sock->use_crc32c = (0 != *(const int*)optval);
 		status = TRUE;
 		break;
 
-/* maximum original data rate.
- * 0 < odata_max_rte < txw_max_rte
+/* drop ODATA and RDATA already held by the receive window, and upstream
+ * packets for a source on a receive-only socket, with an XDP program on the
+ * receive interface ahead of the network stack.  IPv4 only, requires an
+ * explicit interface and CAP_BPF, excludes PGM_XDP and relaying.  must be set
+ * before pgm_bind().
  */
-	case PGM_ODATA_MAX_RTE:
+	case PGM_XDP_FILTER:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-		sock->odata_max_rte = *(const int*)optval;
+		sock->use_xdp_filter = (0 != *(const int*)optval);
 		status = TRUE;
 		break;
 
-/* maximum repair data rate.
- * 0 < rdata_max_rte < txw_max_rte
+/* fault in packet buffers, the transmit window and receive windows with peer
+ * table capacity for the given number of peers in pgm_connect(), rather than
+ * on the first packets.  the footprint is reported by PGM_PREWARM_BYTES.  0 to
+ * allocate on demand.  must be set before pgm_bind().
  */
-	case PGM_RDATA_MAX_RTE:
+	case PGM_PREWARM:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-		sock->rdata_max_rte = *(const int*)optval;
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
+			break;
+		sock->prewarm_peers = *(const int*)optval;
 		status = TRUE;
 		break;
 
-/* ignore rate limit for original data packets, i.e. only apply to repairs.
+/* treat PGM_MTU as an upper bound of the TPDU size: bounded by the send
+ * interface MTU at pgm_bind(), as a source lowered to the smallest MTU that
+ * receivers report in POLRs of general POLL rounds and on EMSGSIZE from the
+ * don't fragment UDP encapsulated send socket, raised again after ten minutes.
+ * PGM_MSSS, PGM_MSS and PGM_PDU follow, PGM_PATH_MTU reads the TPDU size.  as
+ * a receiver report the receive interface MTU.  must be set before pgm_bind().
  */
-	case PGM_UNCONTROLLED_ODATA:
+	case PGM_PMTU_DISCOVERY:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-		sock->is_controlled_odata = (0 == *(const int*)optval);
+		sock->use_pmtud = (0 != *(const int*)optval);
 		status = TRUE;
 		break;
 
-/* ignore rate limit for repair data packets, i.e. only apply to original data.
+/* NAK a gap of missing sequences as one run with OPT_NAK_RANGE where the
+ * source advertises support in SPMs, and as a source accept and advertise
+ * such NAKs.  must be set before pgm_bind().
  */
-	case PGM_UNCONTROLLED_RDATA:
+	case PGM_NAK_RANGE:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-		sock->is_controlled_rdata = (0 == *(const int*)optval);
+		sock->use_nak_range = (0 != *(const int*)optval);
 		status = TRUE;
 		break;
 
-/* timeout for peers.
- * 0 < 2 * spm_ambient_interval <= peer_expiry
+/* latency budget in microseconds from detection of a gap, after which the
+ * missing sequences are declared lost regardless of NAK retries.  0 to wait
+ * for recovery to complete or fail.
  */
-	case PGM_PEER_EXPIRY:
+	case PGM_LATENCY_BUDGET:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
 			break;
-		sock->peer_expiry = *(const int*)optval;
+		sock->latency_budget = *(const int*)optval;
 		status = TRUE;
 		break;
 
-/* maximum back off range for listening for multicast SPMR.
- * 0 < spmr_expiry < spm_ambient_interval
+/* deliver complete APDUs as they arrive instead of in sequence order, the
+ * receive window continues repair of gaps and discards duplicates.  must be
+ * set before pgm_bind().
  */
-	case PGM_SPMR_EXPIRY:
+	case PGM_UNORDERED:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-		sock->spmr_expiry = *(const int*)optval;
+		sock->use_unordered = (0 != *(const int*)optval);
 		status = TRUE;
 		break;
 
-/* size of receive window in sequence numbers.
- * 0 < rxw_sqns < one less than half sequence space
+/* weighted fair delivery: each pending peer commits at most quantum messages
+ * times its weight to one receive call before the next peer, and newly
+ * pending peers are queued in arrival order.  0 drains each peer in turn.
  */
-	case PGM_RXW_SQNS:
+	case PGM_RECV_QUANTUM:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(*(const int*)optval < 0 || *(const int*)optval > UINT16_MAX))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval >= (int)((UINT32_MAX/2)-1)))
+		sock->recv_quantum = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* copy APDUs of at least this many bytes with non-temporal stores, into the
+ * transmit window on send and the application buffer of pgm_recvfrom(), such
+ * that payload not read again by the processor does not evict the
+ * application's working set.  0 = disabled.
+ */
+	case PGM_STREAM_COPY:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		sock->rxw_sqns = *(const int*)optval;
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
+			break;
+		sock->stream_copy_len = *(const int*)optval;
 		status = TRUE;
 		break;
 
-/* size of receive window in seconds.
- * 0 < secs < ( rxw_sqns / rxw_max_rte )
+/* carry the system time of each send in OPT_TIMESTAMP of original data that
+ * fits a single TPDU, receivers record the publish to delivery latency of
+ * each source and present the time as pgm_sk_buff_t::send_tstamp.  the
+ * latency is one-way only between hosts with synchronized clocks.
  */
-	case PGM_RXW_SECS:
+	case PGM_SEND_TIMESTAMP:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		sock->use_send_timestamp = (0 != *(const int*)optval);
+		status = TRUE;
+		break;
+
+/* delivery weight of a source with PGM_RECV_QUANTUM, and priority ahead of
+ * sources without.  a weight of 1 without priority removes the entry, up to
+ * PGM_PEER_WEIGHT_MAX sources.  applies to existing peers after pgm_bind().
+ */
+	case PGM_PEER_WEIGHT:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_peerweightinfo_t)))
 			break;
-		sock->rxw_secs = *(const int*)optval;
+		{
+			const struct pgm_peerweightinfo_t* info = optval;
+			const uint32_t weight = info->weight ? info->weight : 1;
+			const bool is_default = (1 == weight && !info->is_priority);
+			unsigned i;
+			if (PGM_UNLIKELY(weight > UINT16_MAX))
+				break;
+			for (i = 0; i < sock->peer_weight_len; i++)
+				if (pgm_tsi_equal (&sock->peer_weight[ i ].tsi, &info->tsi))
+					break;
+			if (is_default) {
+				if (i < sock->peer_weight_len)
+					sock->peer_weight[ i ] = sock->peer_weight[ --sock->peer_weight_len ];
+			} else {
+				if (i == sock->peer_weight_len) {
+					if (PGM_UNLIKELY(PGM_PEER_WEIGHT_MAX == sock->peer_weight_len))
+						break;
+					sock->peer_weight_len++;
+				}
+				sock->peer_weight[ i ].tsi	   = info->tsi;
+				sock->peer_weight[ i ].weight	   = weight;
+				sock->peer_weight[ i ].is_priority = info->is_priority ? 1 : 0;
+			}
+			if (sock->is_bound && sock->can_recv_data)
+				peers_set_weight (sock);
+		}
+		status = TRUE;
+		break;
+
+/* flight recorder of recent NAK, NCF, RDATA, receive window and reset events
+ * shown on the transport page of the HTTP interface, and logged on a reset
+ * with dump_on_reset.  on by default, a length of 0 disables.  the length
+ * must be set before pgm_bind().
+ */
+	case PGM_FLIGHTREC:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_flightrecinfo_t)))
+			break;
+		{
+			const struct pgm_flightrecinfo_t* flightrecinfo = optval;
+			if (PGM_UNLIKELY(flightrecinfo->len > (1U << 24)))
+				break;
+			if (sock->is_bound) {
+				const unsigned len = sock->flightrec ? sock->flightrec->mask + 1 : 0;
+				if (PGM_UNLIKELY(flightrecinfo->len != sock->flightrec_len && flightrecinfo->len != len))
+					break;
+			}
+			sock->flightrec_len	 = flightrecinfo->len;
+			sock->use_flightrec_dump = (0 != flightrecinfo->dump_on_reset);
+		}
 		status = TRUE;
 		break;
 
-/* maximum receive rate, for determining window size with txw_secs.
- * 0 < rxw_max_rte < interface capacity
+/* answer multicast NAKs of other receivers with RDATA from the receive window
+ * after a random back-off of up to NAK_BO_IVL, cancelled by any RDATA seen
+ * first.
  */
-	case PGM_RXW_MAX_RTE:
+	case PGM_PEER_REPAIR:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
-			break;
-		sock->rxw_max_rte = *(const int*)optval;
+		sock->use_peer_repair = (0 != *(const int*)optval);
 		status = TRUE;
 		break;
 
-/* maximum NAK back-off value nak_rb_ivl in milliseconds.
- * 0 < nak_rb_ivl <= nak_bo_ivl
+/* interval in microseconds of general POLLs sizing the receiver population,
+ * receivers answer within half the interval.  0 disables polling.
  */
-	case PGM_NAK_BO_IVL:
+	case PGM_POLL_IVL:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
 			break;
-		sock->nak_bo_ivl = *(const int*)optval;
+		sock->poll_ivl = *(const int*)optval;
 		status = TRUE;
 		break;
 
-/* repeat interval prior to re-sending a NAK, in milliseconds.
+/* transmit original data by reference with MSG_ZEROCOPY, each packet held
+ * until the kernel reports completion.  falls back to copying where
+ * unavailable.  must be set before pgm_bind().
  */
-	case PGM_NAK_RPT_IVL:
+	case PGM_ZEROCOPY:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-		sock->nak_rpt_ivl = *(const int*)optval;
+		sock->use_zerocopy = (0 != *(const int*)optval);
 		status = TRUE;
 		break;
 
-/* interval waiting for repair data, in milliseconds.
+/* memory budget in bytes for on-demand parity packets kept for repeated
+ * parity requests of a transmission group, 0 to encode every request.
+ * must be set before pgm_bind().
  */
-	case PGM_NAK_RDATA_IVL:
+	case PGM_PARITY_CACHE:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-		sock->nak_rdata_ivl = *(const int*)optval;
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
+			break;
+		sock->parity_cache = *(const int*)optval;
 		status = TRUE;
 		break;
 
-/* limit for data.
- * 0 < nak_data_retries < 256
+/* maximum datagrams read per system call with recvmmsg().
+ * 1 <= rx_batch_size <= PGM_RECV_BATCH_MAX, ignored where recvmmsg() is unavailable.
+ * must be set before pgm_bind().
  */
-	case PGM_NAK_DATA_RETRIES:
+	case PGM_RECV_BATCH:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
 		if (PGM_UNLIKELY(*(const int*)optval <= 0))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval > UINT8_MAX))
+		if (PGM_UNLIKELY(*(const int*)optval > PGM_RECV_BATCH_MAX))
 			break;
-		sock->nak_data_retries = *(const int*)optval;
+		sock->rx_batch_size = *(const int*)optval;
 		status = TRUE;
 		break;
 
-/* limit for NAK confirms.
- * 0 < nak_ncf_retries < 256
+/* maximum datagrams written per system call with sendmmsg(), applies to
+ * fragments of one APDU and to queued selective repairs.
+ * 1 <= tx_batch_size <= PGM_SEND_BATCH_MAX, emulated with sendto() where
+ * sendmmsg() is unavailable.
+ * must be set before pgm_bind().
  */
-	case PGM_NAK_NCF_RETRIES:
+	case PGM_SEND_BATCH:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
 		if (PGM_UNLIKELY(*(const int*)optval <= 0))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval > UINT8_MAX))
+		if (PGM_UNLIKELY(*(const int*)optval > PGM_SEND_BATCH_MAX))
 			break;
-		sock->nak_ncf_retries = *(const int*)optval;
+		sock->tx_batch_size = *(const int*)optval;
 		status = TRUE;
 		break;
 
-/* Enable FEC for this sock, specifically Reed Solmon encoding RS(n,k), common
- * setting is RS(255, 223).
- *
- * inputs:
- *
- * n = FEC Block size = [k+1, 255]
- * k = original data packets == transmission group size = [2, 4, 8, 16, 32, 64, 128]
- * m = symbol size = 8 bits
- *
- * outputs:
- *
- * h = 2t = n - k = parity packets
- *
- * when h > k parity packets can be lost.
+/* concurrent pgm_send() calls from several threads build and checksum their
+ * packets in parallel, committing them to the transmit window in sequence
+ * order.  other send calls are refused, producers block on the rate limit.
+ * must be set before pgm_bind().
  */
-	case PGM_USE_FEC:
-		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_fecinfo_t)))
+	case PGM_MULTI_PRODUCER:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		{
-			const struct pgm_fecinfo_t* fecinfo = optval;
-			if (PGM_UNLIKELY(0 != (fecinfo->group_size & (fecinfo->group_size - 1))))
-				break;
-			if (PGM_UNLIKELY(fecinfo->group_size < 2 || fecinfo->group_size > 128))
-				break;
-			if (PGM_UNLIKELY(fecinfo->group_size > fecinfo->block_size))
-				break;
-			const uint8_t parity_packets = fecinfo->block_size - fecinfo->group_size;
-/* technically could re-send previous packets */
-			if (PGM_UNLIKELY(fecinfo->proactive_packets > parity_packets))
-				break;
-/* check validity of parameters */
-			if (PGM_UNLIKELY(fecinfo->group_size > 223 && ((parity_packets * 223.0) / fecinfo->group_size) < 1.0))
-			{
-				pgm_error (_("k/h ratio too low to generate parity data."));
-				break;
-			}
-			sock->use_proactive_parity	= (fecinfo->proactive_packets > 0);
-			sock->use_ondemand_parity	= fecinfo->ondemand_parity_enabled;
-			sock->use_var_pktlen		= fecinfo->var_pktlen_enabled;
-			sock->rs_n			= fecinfo->block_size;
-			sock->rs_k			= fecinfo->group_size;
-			sock->rs_proactive_h		= fecinfo->proactive_packets;
-		}
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		sock->use_multi_producer = (0 != *(const int*)optval);
 		status = TRUE;
 		break;
 
-/* congestion reporting */
-	case PGM_USE_CR:
+/* pgm_send() copies the APDU into a ring of the given length, rounded up to a
+ * power of two, for a sender thread and returns without blocking, refusing
+ * with PGM_IO_STATUS_WOULD_BLOCK only when the ring is full.  other send calls
+ * are refused.  zero sends on the calling thread.  must be set before
+ * pgm_bind().
+ */
+	case PGM_SEND_ASYNC:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		if (PGM_UNLIKELY(*(const int*)optval <= 0))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-		sock->crqst_ivl = *(const int*)optval;
-		sock->use_cr    = (sock->crqst_ivl > 0);
+		if (PGM_UNLIKELY(*(const int*)optval < 0 || *(const int*)optval > PGM_SEND_ASYNC_MAX))
+			break;
+		sock->async_len = *(const int*)optval;
 		status = TRUE;
 		break;
 
-/* congestion control */
-	case PGM_USE_PGMCC:
-		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_pgmccinfo_t)))
+/* deliver only the last message of each key per source amongst those read
+ * together, the key returned by the callback on the receiving thread.  a
+ * lagging reader reading full vectors skips superseded messages, looking
+ * ahead no further than the vector.  compact vectors are not conflated.  must
+ * be set before pgm_connect().
+ */
+	case PGM_CONFLATE:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_conflateinfo_t)))
+			break;
+		if (PGM_UNLIKELY(sock->is_connected))
 			break;
 		{
-			const struct pgm_pgmccinfo_t* pgmccinfo = optval;
-			sock->ack_bo_ivl = pgmccinfo->ack_bo_ivl;
-			sock->ack_c      = pgmccinfo->ack_c;
-			sock->ack_c_p    = pgmccinfo->ack_c_p;
-			sock->use_pgmcc  = (sock->ack_c > 0);
+			const struct pgm_conflateinfo_t* conflateinfo = optval;
+			sock->conflate_key  = conflateinfo->key;
+			sock->conflate_data = conflateinfo->user_data;
 		}
 		status = TRUE;
 		break;
 
-/* declare socket only for sending, discard any incoming SPM, ODATA,
- * RDATA, etc, packets.
+/* maximum idle packet buffers held for re-use, 0 to allocate every packet
+ * from the heap.  must be set before pgm_bind().
  */
-	case PGM_SEND_ONLY:
+	case PGM_SKB_POOL:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		sock->can_recv_data = (0 == *(const int*)optval);
-		status = TRUE;
-		break;
-
-/* declare socket only for receiving, no transmit window will be created
- * and no SPM broadcasts sent.
- */
-	case PGM_RECV_ONLY:
-		if (PGM_UNLIKELY(optlen != sizeof (int)))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-		sock->can_send_data = (0 == *(const int*)optval);
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
+			break;
+		sock->skb_pool_size = *(const int*)optval;
 		status = TRUE;
 		break;
 
-/* passive receiving socket, i.e. no back channel to source
+/* carve the packet buffers from application supplied memory, which must stay
+ * valid until every retained packet has been released.  buffers beyond the
+ * memory come from the heap.  must be set before pgm_bind().
  */
-	case PGM_PASSIVE:
-		if (PGM_UNLIKELY(optlen != sizeof (int)))
+	case PGM_SKB_POOL_MEMORY:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_skbmeminfo_t)))
 			break;
-		sock->can_send_nak = (0 == *(const int*)optval);
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		{
+			const struct pgm_skbmeminfo_t* skbmeminfo = optval;
+			if (PGM_UNLIKELY(NULL != skbmeminfo->addr && 0 == skbmeminfo->len))
+				break;
+			sock->skb_pool_addr = skbmeminfo->addr;
+			sock->skb_pool_len  = skbmeminfo->len;
+		}
 		status = TRUE;
 		break;
 
-/* on unrecoverable data loss stop socket from further transmission and
- * receiving.
+/* share one receive socket between PGM sockets bound to the same protocol,
+ * port and interface address, each packet read and parsed once by any of
+ * them and handed to the socket owning its data-destination port or TSI.
+ * sockets sharing a receive path need distinct data-destination ports and
+ * source filters apply to all of them.  must be set before pgm_bind().
  */
-	case PGM_ABORT_ON_RESET:
+	case PGM_SHARED_RECV:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		sock->is_abort_on_reset = (0 != *(const int*)optval);
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		sock->use_shared_recv = (0 != *(const int*)optval);
 		status = TRUE;
 		break;
 
-/* default non-blocking operation on send and receive sockets.
+/* stamp each packet with its arrival time from the kernel or NIC, NAK timers
+ * then start from arrival and the NIC to application latency of each source
+ * is recorded.  hardware time stamps require the NIC clock be synchronized to
+ * the system clock, e.g. by phc2sys, and fall back to kernel time stamps when
+ * unsupported.  reads back the mode in effect after pgm_bind().  must be set
+ * before pgm_bind().
  */
-	case PGM_NOBLOCK:
+	case PGM_RX_TIMESTAMP:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		sock->is_nonblocking = (0 != *(const int*)optval);
-		pgm_sockaddr_nonblocking (sock->send_sock, sock->is_nonblocking);
-		pgm_sockaddr_nonblocking (sock->send_with_router_alert_sock, sock->is_nonblocking);
-		status = TRUE;
-		break;
-
-/* sending group, singular.  note that the address is only stored and used
- * later in sendto() calls, this routine only considers the interface.
- */
-	case PGM_SEND_GROUP:
-	{
-		void*     restrict tmp_optval = optval; 
-		socklen_t          tmp_optlen = optlen; 
-
-/* Use OpenPGM enhanced struct with support for multiple IP addresses per interface. */
-		if (tmp_optlen == sizeof(struct pgm_group_source_req))
-		{
-			const struct pgm_group_source_req* gsr = tmp_optval;
-			struct group_req* gr = pgm_alloca (sizeof (struct group_req));
-/* copy contents to bypass byte packing differences */
-			gr->gr_interface = gsr->gsr_interface;
-			memcpy (&gr->gr_group, &gsr->gsr_group, sizeof (struct sockaddr_storage));
-			tmp_optval = gr;
-			tmp_optlen = sizeof(struct group_req);
-		}
-		if (tmp_optlen == sizeof(struct group_req))
-		{
-			memcpy (&sock->send_gsr, tmp_optval, sizeof(struct group_req));
-			if (PGM_UNLIKELY(sock->family != sock->send_gsr.gsr_group.ss_family))
-				break;
-/* multicast group for later usage with sendto() */
-			if (sock->udp_encap_mcast_port)
-				((struct sockaddr_in*)&sock->send_gsr.gsr_group)->sin_port = htons (sock->udp_encap_mcast_port);
-/* interface */
-			if ((SOCKET_ERROR == pgm_sockaddr_multicast_if (sock->send_sock,
-									   (const struct sockaddr*)&sock->send_addr,
-									   sock->send_gsr.gsr_interface)) ||
-			    (SOCKET_ERROR == pgm_sockaddr_multicast_if (sock->send_with_router_alert_sock,
-									   (const struct sockaddr*)&sock->send_addr,
-									   sock->send_gsr.gsr_interface)))
-			{
-				break;
-			}
-			else if (PGM_UNLIKELY(pgm_log_mask & PGM_LOG_ROLE_NETWORK))
-			{
-				char addr[INET6_ADDRSTRLEN];
-				pgm_sockaddr_ntop ((const struct sockaddr*)&sock->send_addr, addr, sizeof(addr));
-				pgm_trace (PGM_LOG_ROLE_NETWORK,_("Multicast send interface set to %s index %u"),
-					addr,
-					(unsigned)sock->send_gsr.gsr_interface);
-			}
-		}
-	}
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(PGM_RX_TIMESTAMP_NONE     != *(const int*)optval &&
+				 PGM_RX_TIMESTAMP_SOFTWARE != *(const int*)optval &&
+				 PGM_RX_TIMESTAMP_HARDWARE != *(const int*)optval))
+			break;
+		sock->rx_timestamp_mode = *(const int*)optval;
 		status = TRUE;
 		break;
 
-/* for any-source applications (ASM), join a new group
+/* read packets from a pcap capture in place of the receive socket, PGM over
+ * IP or UDP from any interface, re-framed to match the socket.  speed is the
+ * percent of captured timing, zero replays as fast as packets are consumed.
+ * the end of the capture reads as a closed socket.  must be set before
+ * pgm_bind().
  */
-	case PGM_JOIN_GROUP:
-		if (PGM_UNLIKELY(sock->recv_gsr_len >= IP_MAX_MEMBERSHIPS))
+	case PGM_REPLAY:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_replayinfo_t)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
-	{
-		void*	  restrict tmp_optval = optval;
-		socklen_t	   tmp_optlen = optlen;
-
-/* Use OpenPGM enhanced struct with support for multiple IP addresses per interface. */
-		if (tmp_optlen == sizeof(struct pgm_group_source_req))
-		{
-			const struct pgm_group_source_req* gsr = tmp_optval;
-			struct group_req* gr = pgm_alloca (sizeof (struct group_req));
-/* copy contents to bypass byte packing differences */
-			gr->gr_interface = gsr->gsr_interface;
-			memcpy (&gr->gr_group, &gsr->gsr_group, sizeof (struct sockaddr_storage));
-			tmp_optval = gr;
-			tmp_optlen = sizeof(struct group_req);
-		}
-/* Use OS native RFC 3678 group request struct */
-		if (tmp_optlen == sizeof(struct group_req))
 		{
-			const struct group_req* gr = tmp_optval;
-/* verify not duplicate group/interface pairing */
-			for (unsigned i = 0; i < sock->recv_gsr_len; i++)
-			{
-				if (pgm_sockaddr_cmp ((const struct sockaddr*)&gr->gr_group, (struct sockaddr*)&sock->recv_gsr[i].gsr_group)  == 0 &&
-				    pgm_sockaddr_cmp ((const struct sockaddr*)&gr->gr_group, (struct sockaddr*)&sock->recv_gsr[i].gsr_source) == 0 &&
-					(gr->gr_interface == sock->recv_gsr[i].gsr_interface ||
-					                0 == sock->recv_gsr[i].gsr_interface   ))
-				{
-#ifdef SOCK_DEBUG
-					char s[INET6_ADDRSTRLEN];
-					pgm_sockaddr_ntop ((const struct sockaddr*)&gr->gr_group, s, sizeof(s));
-					if (sock->recv_gsr[i].gsr_interface) {
-						pgm_warn(_("Socket has already joined group %s on interface %u"), s, gr->gr_interface);
-					} else {
-						pgm_warn(_("Socket has already joined group %s on all interfaces."), s);
-					}
-#endif
-					break;
-				}
-			}
-			sock->recv_gsr[sock->recv_gsr_len].gsr_interface = gr->gr_interface;
-			memcpy (&sock->recv_gsr[sock->recv_gsr_len].gsr_group, &gr->gr_group, pgm_sockaddr_len ((const struct sockaddr*)&gr->gr_group));
-			if (sock->udp_encap_mcast_port)
-				((struct sockaddr_in*)&sock->recv_gsr[sock->recv_gsr_len].gsr_group)->sin_port = htons (sock->udp_encap_mcast_port);
-			memcpy (&sock->recv_gsr[sock->recv_gsr_len].gsr_source, &gr->gr_group, pgm_sockaddr_len ((const struct sockaddr*)&gr->gr_group));
-/* Resolved address family gr->gr_group.ss_family can be different from sock->family = AF_UNSPEC */
-			if (SOCKET_ERROR == pgm_sockaddr_join_group (sock->recv_sock, gr->gr_group.ss_family, gr)) {
-#ifdef SOCK_DEBUG
-				const int save_errno = pgm_get_last_sock_error();
-				char errbuf[1024];
-				char s[INET6_ADDRSTRLEN];
-				pgm_sockaddr_ntop ((const struct sockaddr*)&gr->gr_group, s, sizeof(s));
-				pgm_error(_("Join multicast group { .gr_interface = %u, .gr_group = \"%s\" } failed: %s(%d)"),
-					gr->gr_interface, s,
-					pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno), save_errno);
-#endif
-				break;
-			}
-			else if (PGM_UNLIKELY(pgm_log_mask & PGM_LOG_ROLE_NETWORK))
-			{
-				char addr[INET6_ADDRSTRLEN];
-				pgm_sockaddr_ntop ((const struct sockaddr*)&gr->gr_group, addr, sizeof(addr));
-				pgm_trace (PGM_LOG_ROLE_NETWORK,_("Join multicast group %s on interface index %u"),
-					addr,
-					(unsigned)gr->gr_interface);
-			}
-			sock->recv_gsr_len++;
+			const struct pgm_replayinfo_t* replayinfo = optval;
+			if (sock->replay_path)
+				pgm_free (sock->replay_path);
+			sock->replay_path  = replayinfo->path ? pgm_strdup (replayinfo->path) : NULL;
+			sock->replay_speed = replayinfo->speed;
 		}
-	}
 		status = TRUE;
 		break;
 
-/* for any-source applications (ASM), leave a joined group.
+/* same-host transport: a socket that sends data publishes every packet for
+ * the multicast group to the named shared memory ring, a receive-only socket
+ * reads the ring ahead of the network and skips the kernel path and the PGM
+ * checksum.  the receiver re-attaches when a publisher restarts.  the
+ * publisher should disable PGM_MULTICAST_LOOP, duplicates from both paths
+ * are otherwise discarded by the receive window.  slots is rounded up to a
+ * power of two, a receiver lapped by the publisher sees the lost packets as
+ * on the network.  must be set before pgm_bind().
  */
-	case PGM_LEAVE_GROUP:
-		if (PGM_UNLIKELY(optlen != sizeof(struct group_req)))
+	case PGM_SHM:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_shminfo_t)))
 			break;
-		if (PGM_UNLIKELY(0 == sock->recv_gsr_len))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
 		{
-			const struct group_req* gr = optval;
-			for (unsigned i = 0; i < sock->recv_gsr_len;)
-			{
-				if ((pgm_sockaddr_cmp ((const struct sockaddr*)&gr->gr_group, (struct sockaddr*)&sock->recv_gsr[i].gsr_group) == 0) &&
-/* drop all matching receiver entries */
-				            (gr->gr_interface == 0 ||
-/* drop all sources with matching interface */
-					     gr->gr_interface == sock->recv_gsr[i].gsr_interface) )
-				{
-					sock->recv_gsr_len--;
-					if (i < (IP_MAX_MEMBERSHIPS - 1))
-					{
-						memmove (&sock->recv_gsr[i], &sock->recv_gsr[i+1], (sock->recv_gsr_len - i) * sizeof(struct group_source_req));
-						continue;
-					}
-				}
-				i++;
-			}
-			if (PGM_UNLIKELY(sock->family != gr->gr_group.ss_family))
-				break;
-			if (SOCKET_ERROR == pgm_sockaddr_leave_group (sock->recv_sock, sock->family, gr))
+			const struct pgm_shminfo_t* shminfo = optval;
+			if (PGM_UNLIKELY(shminfo->slots > PGM_SHM_SLOTS_MAX))
 				break;
-			else if (PGM_UNLIKELY(pgm_log_mask & PGM_LOG_ROLE_NETWORK))
-			{
-				char addr[INET6_ADDRSTRLEN];
-				pgm_sockaddr_ntop ((const struct sockaddr*)&gr->gr_group, addr, sizeof(addr));
-				pgm_trace (PGM_LOG_ROLE_NETWORK,_("Leave multicast group %s on interface index %u"),
-					addr,
-					(unsigned)gr->gr_interface);
-			}
+			if (sock->shm_name)
+				pgm_free (sock->shm_name);
+			sock->shm_name	   = shminfo->name ? pgm_strdup (shminfo->name) : NULL;
+			sock->shm_slots	   = shminfo->slots;
+			sock->shm_interval = shminfo->interval;
 		}
 		status = TRUE;
 		break;
 
-/* for any-source applications (ASM), turn off a given source
+/* in-process bus: sockets of the process naming the same bus exchange packets
+ * through memory in place of the network, the kernel sockets are bound but
+ * carry nothing, for measuring protocol cost without the network path.  each
+ * sending socket may drop or reorder its packets at rates in parts per
+ * million from a generator of seed, a packet reordered is delivered behind
+ * the next.  packets reach the sending socket itself with
+ * PGM_MULTICAST_LOOP.  must be set before pgm_bind().
  */
-	case PGM_BLOCK_SOURCE:
-		if (PGM_UNLIKELY(optlen != sizeof(struct group_source_req)))
+	case PGM_LOOPBACK:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_loopinfo_t)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
 		{
-			const struct group_source_req* gsr = optval;
-			if (PGM_UNLIKELY(sock->family != gsr->gsr_group.ss_family))
-				break;
-			if (SOCKET_ERROR == pgm_sockaddr_block_source (sock->recv_sock, sock->family, gsr))
+			const struct pgm_loopinfo_t* loopinfo = optval;
+			if (PGM_UNLIKELY(loopinfo->loss_rate > 1000000 || loopinfo->reorder_rate > 1000000))
 				break;
+			if (sock->loop_name)
+				pgm_free (sock->loop_name);
+			sock->loop_name		= loopinfo->name ? pgm_strdup (loopinfo->name) : NULL;
+			sock->loop_loss_rate	= loopinfo->loss_rate;
+			sock->loop_reorder_rate	= loopinfo->reorder_rate;
+			sock->loop_seed		= loopinfo->seed;
 		}
 		status = TRUE;
 		break;
 
-/* for any-source applications (ASM), re-allow a blocked source
+/* rate group: sent packets are further debited from a token bucket of max_rte
+ * bytes per second shared by every socket of the process naming the group,
+ * idle capacity of one member is borrowed by the others.  the first member to
+ * bind sets the group rate, later members pass the same rate or zero.  up to
+ * min_rte bytes per second are sent regardless of the other members, which
+ * absorb the excess.  stacks with PGM_TXW_MAX_RTE.  must be set before
+ * pgm_bind().
  */
-	case PGM_UNBLOCK_SOURCE:
-		if (PGM_UNLIKELY(optlen != sizeof(struct group_source_req)))
+	case PGM_RATE_GROUP:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_rategroupinfo_t)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
 		{
-			const struct group_source_req* gsr = optval;
-			if (PGM_UNLIKELY(sock->family != gsr->gsr_group.ss_family))
+			const struct pgm_rategroupinfo_t* rategroupinfo = optval;
+			if (PGM_UNLIKELY(rategroupinfo->max_rte < 0 || rategroupinfo->min_rte < 0))
 				break;
-			if (SOCKET_ERROR == pgm_sockaddr_unblock_source (sock->recv_sock, sock->family, gsr))
+			if (PGM_UNLIKELY(0 != rategroupinfo->max_rte && rategroupinfo->min_rte > rategroupinfo->max_rte))
 				break;
+			if (sock->rate_group_name)
+				pgm_free (sock->rate_group_name);
+			sock->rate_group_name	= rategroupinfo->name ? pgm_strdup (rategroupinfo->name) : NULL;
+			sock->rate_group_max	= (ssize_t)rategroupinfo->max_rte;
+			sock->rate_group_min	= (ssize_t)rategroupinfo->min_rte;
 		}
 		status = TRUE;
 		break;
 
-/* for controlled-source applications (SSM), join each group/source pair.
- *
- * SSM joins are allowed on top of ASM in order to merge a remote source onto the local segment.
+/* transmit log: packets leaving the trailing edge of the transmit window are
+ * appended to memory-mapped segment files of path and the sequence number,
+ * repairs of sequences beyond the window are read back through the page
+ * cache.  the advertised trail, and OPT_JOIN of SPMs, follow the oldest
+ * logged sequence.  segment files are removed as they retire and on close.
+ * must be set before pgm_bind().
  */
-	case PGM_JOIN_SOURCE_GROUP:
-		if (PGM_UNLIKELY(optlen != sizeof(struct group_source_req)))
+	case PGM_TXLOG:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_txloginfo_t)))
 			break;
-		if (PGM_UNLIKELY(sock->recv_gsr_len >= IP_MAX_MEMBERSHIPS))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
 		{
-			const struct group_source_req* gsr = optval;
-/* verify if existing group/interface pairing */
-			for (unsigned i = 0; i < sock->recv_gsr_len; i++)
-			{
-				if (pgm_sockaddr_cmp ((const struct sockaddr*)&gsr->gsr_group, (struct sockaddr*)&sock->recv_gsr[i].gsr_group) == 0 &&
-					(gsr->gsr_interface == sock->recv_gsr[i].gsr_interface ||
-					                  0 == sock->recv_gsr[i].gsr_interface   ))
-				{
-					if (pgm_sockaddr_cmp ((const struct sockaddr*)&gsr->gsr_source, (struct sockaddr*)&sock->recv_gsr[i].gsr_source) == 0)
-					{
-#ifdef SOCK_DEBUG
-						char s1[INET6_ADDRSTRLEN], s2[INET6_ADDRSTRLEN];
-						pgm_sockaddr_ntop ((const struct sockaddr*)&gsr->gsr_group, s1, sizeof(s1));
-						pgm_sockaddr_ntop ((const struct sockaddr*)&gsr->gsr_source, s2, sizeof(s2));
-						if (sock->recv_gsr[i].gsr_interface) {
-							pgm_warn(_("Socket has already joined group %s from source %s on interface %d"),
-								s1, s2, (unsigned)gsr->gsr_interface);
-						} else {
-							pgm_warn(_("Socket has already joined group %s from source %s on all interfaces"),
-								s1, s2);
-						}
-#endif
-						break;
-					}
-					break;
-				}
-			}
-			if (PGM_UNLIKELY(sock->family != gsr->gsr_group.ss_family))
-				break;
-			if (PGM_UNLIKELY(sock->family != gsr->gsr_source.ss_family))
+			const struct pgm_txloginfo_t* txloginfo = optval;
+			if (PGM_UNLIKELY(txloginfo->segment_sqns & PGM_UINT32_SIGN_BIT))
 				break;
-			if (SOCKET_ERROR == pgm_sockaddr_join_source_group (sock->recv_sock, sock->family, gsr))
+			if (PGM_UNLIKELY(txloginfo->segments > PGM_TXLOG_SEGMENTS_MAX))
 				break;
-			memcpy (&sock->recv_gsr[sock->recv_gsr_len], gsr, sizeof(struct group_source_req));
-			sock->recv_gsr_len++;
+			if (sock->txlog_path)
+				pgm_free (sock->txlog_path);
+			sock->txlog_path	 = txloginfo->path ? pgm_strdup (txloginfo->path) : NULL;
+			sock->txlog_segment_sqns = txloginfo->segment_sqns;
+			sock->txlog_segments	 = txloginfo->segments;
 		}
 		status = TRUE;
 		break;
 
-/* for controlled-source applications (SSM), leave each group/source pair
+/* late join: on the first SPM of a new source carrying OPT_JOIN, start the
+ * receive window at the requested sequence, or the oldest offered, and NAK
+ * forward to the lead.  data preceding that SPM is discarded and recovered,
+ * the request is bounded by OPT_JOIN and the receive window length.  must be
+ * set before pgm_bind().
  */
-	case PGM_LEAVE_SOURCE_GROUP:
-		if (PGM_UNLIKELY(optlen != sizeof(struct group_source_req)))
+	case PGM_LATE_JOIN:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_joininfo_t)))
 			break;
-		if (PGM_UNLIKELY(0 == sock->recv_gsr_len))
+		if (PGM_UNLIKELY(sock->is_bound))
 			break;
 		{
-			const struct group_source_req* gsr = optval;
-/* verify if existing group/interface pairing */
-			for (unsigned i = 0; i < sock->recv_gsr_len; i++)
-			{
-				if (pgm_sockaddr_cmp ((const struct sockaddr*)&gsr->gsr_group, (struct sockaddr*)&sock->recv_gsr[i].gsr_group)   == 0 &&
-				    pgm_sockaddr_cmp ((const struct sockaddr*)&gsr->gsr_source, (struct sockaddr*)&sock->recv_gsr[i].gsr_source) == 0 &&
-				    gsr->gsr_interface == sock->recv_gsr[i].gsr_interface)
-				{
-					sock->recv_gsr_len--;
-					if (i < (IP_MAX_MEMBERSHIPS - 1))
-					{
-						memmove (&sock->recv_gsr[i], &sock->recv_gsr[i+1], (sock->recv_gsr_len - i) * sizeof(struct group_source_req));
-						break;
-					}
-				}
-			}
-			if (PGM_UNLIKELY(sock->family != gsr->gsr_group.ss_family))
-				break;
-			if (PGM_UNLIKELY(sock->family != gsr->gsr_source.ss_family))
-				break;
-			if (SOCKET_ERROR == pgm_sockaddr_leave_source_group (sock->recv_sock, sock->family, gsr))
-				break;
+			const struct pgm_joininfo_t* joininfo = optval;
+			sock->use_late_join	  = TRUE;
+			sock->late_join_sqn	  = joininfo->sequence;
+			sock->late_join_is_oldest = (0 != joininfo->is_oldest);
 		}
 		status = TRUE;
 		break;
 
-/* batch block and unblock sources */
-	case PGM_MSFILTER:
-#if defined(MCAST_MSFILTER) || defined(SIOCSMSFILTER)
-		if (PGM_UNLIKELY(optlen < (socklen_t)sizeof(struct group_filter)))
+/* hot standby: a primary mirrors its transmit window and SPMs to the side
+ * channel address of a standby binding the same TSI, a standby follows the
+ * primary from its side channel address without sending until it takes over
+ * the session, on PGM_STANDBY_TAKEOVER or after timeout usecs without
+ * mirrored packets.  a standby requires the side channel address of the
+ * primary as peer and discards anything else, the side channel is not
+ * authenticated.  the side channel socket is opened here, must be set before
+ * pgm_bind().
+ */
+	case PGM_STANDBY:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_standbyinfo_t)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(NULL != sock->standby))
 			break;
 		{
-			const struct group_filter* gf_list = optval;
-			if ((socklen_t)GROUP_FILTER_SIZE( gf_list->gf_numsrc ) != optlen)
+			const struct pgm_standbyinfo_t* standbyinfo = optval;
+			if (PGM_UNLIKELY(AF_INET != standbyinfo->addr.ss_family && AF_INET6 != standbyinfo->addr.ss_family))
 				break;
-			if (PGM_UNLIKELY(sock->family != gf_list->gf_group.ss_family))
+			if (PGM_UNLIKELY(!standbyinfo->is_standby && 0 == ((const struct sockaddr_in*)&standbyinfo->addr)->sin_port))
 				break;
-/* check only first */
-			if (PGM_UNLIKELY(sock->family != gf_list->gf_slist[0].ss_family))
+			if (PGM_UNLIKELY(standbyinfo->is_standby && AF_UNSPEC == standbyinfo->peer.ss_family))
+				break;
+			if (PGM_UNLIKELY(AF_UNSPEC != standbyinfo->peer.ss_family && standbyinfo->addr.ss_family != standbyinfo->peer.ss_family))
 				break;
-			if (SOCKET_ERROR == pgm_sockaddr_msfilter (sock->recv_sock, sock->family, gf_list))
+			sock->standby = pgm_standby_create (sock, standbyinfo);
+			if (NULL == sock->standby)
 				break;
+			sock->is_standby = (0 != standbyinfo->is_standby);
 		}
 		status = TRUE;
-#endif
 		break;
 
-/* UDP encapsulation ports */
-	case PGM_UDP_ENCAP_UCAST_PORT:
+/* take over the session of the primary on a standby socket.
+ */
+	case PGM_STANDBY_TAKEOVER:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		sock->udp_encap_ucast_port = *(const int*)optval;
+		if (PGM_UNLIKELY(!sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(0 == *(const int*)optval))
+			break;
+		if (!pgm_standby_takeover (sock))
+			break;
 		status = TRUE;
 		break;
 
-	case PGM_UDP_ENCAP_MCAST_PORT:
+/* compress APDUs of at least PGM_COMPRESS_MIN_APDU bytes as LZ4 blocks with
+ * the given acceleration, 1 for the best ratio, sent with OPT_COMPRESS where
+ * smaller.  receivers decompress regardless.  0 to disable, unavailable
+ * without LZ4 and with FEC.  must be set before pgm_bind().
+ */
+	case PGM_COMPRESS:
 		if (PGM_UNLIKELY(optlen != sizeof (int)))
 			break;
-		sock->udp_encap_mcast_port = *(const int*)optval;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval < 0))
+			break;
+		if (PGM_UNLIKELY(*(const int*)optval > 0 && !pgm_compress_is_available()))
+			break;
+		sock->compress_accel = *(const int*)optval;
+		status = TRUE;
+		break;
+
+/* receive auto-tuning: once a second each receive shard samples its received
+ * rate and, where available, SO_RXQ_OVFL kernel drops.  the kernel receive
+ * buffer doubles on drops up to rcvbuf_max and decays while idle, receive
+ * windows of new and existing peers hold rxw_secs of the observed rate within
+ * the window bounds, overriding PGM_RXW_SQNS.  must be set before pgm_bind().
+ */
+	case PGM_RX_TUNE:
+		if (PGM_UNLIKELY(optlen != sizeof (struct pgm_rxtuneinfo_t)))
+			break;
+		if (PGM_UNLIKELY(sock->is_bound))
+			break;
+		{
+			const struct pgm_rxtuneinfo_t* rxtuneinfo = optval;
+			const uint32_t rcvbuf_min   = rxtuneinfo->rcvbuf_min ? rxtuneinfo->rcvbuf_min : MIN(PGM_RX_TUNE_RCVBUF_MIN, rxtuneinfo->rcvbuf_max);
+			const uint32_t rxw_min_sqns = rxtuneinfo->rxw_min_sqns ? rxtuneinfo->rxw_min_sqns : MIN(PGM_RX_TUNE_RXW_MIN_SQNS, rxtuneinfo->rxw_max_sqns);
+			if (PGM_UNLIKELY(rxtuneinfo->rcvbuf_max > INT_MAX ||
+					 rcvbuf_min > rxtuneinfo->rcvbuf_max ||
+					 rxw_min_sqns > rxtuneinfo->rxw_max_sqns ||
+					 rxtuneinfo->rxw_max_sqns >= ((UINT32_MAX/2)-1)))
+				break;
+			sock->use_rx_tune	   = (rxtuneinfo->rcvbuf_max > 0);
+			sock->rx_tune_rcvbuf_min   = rcvbuf_min;
+			sock->rx_tune_rcvbuf_max   = rxtuneinfo->rcvbuf_max;
+			sock->rx_tune_rxw_min_sqns = rxw_min_sqns;
+			sock->rx_tune_rxw_max_sqns = rxtuneinfo->rxw_max_sqns;
+			sock->rx_tune_rxw_secs	   = rxtuneinfo->rxw_secs ? rxtuneinfo->rxw_secs : PGM_RX_TUNE_RXW_SECS;
+		}
+		status = TRUE;
+		break;
+
+/* expose one epoll descriptor readable whenever the socket needs servicing:
+ * received data, repairs, pending messages, ACKs, and through an internal
+ * timerfd the next timer or rate limit expiry.  call a receive function each
+ * time it is readable, which also clears an expired timer.  must be set
+ * before pgm_connect().
+ */
+	case PGM_EVENT_SOCK:
+		if (PGM_UNLIKELY(optlen != sizeof (int)))
+			break;
+		if (PGM_UNLIKELY(sock->is_connected))
+			break;
+#if !defined(HAVE_EPOLL_CTL) || !defined(HAVE_TIMERFD_CREATE)
+		if (PGM_UNLIKELY(0 != *(const int*)optval))
+			break;
+#endif
+		sock->use_event_sock = (0 != *(const int*)optval);
 		status = TRUE;
 		break;
 
@@ -1886,6 +4764,17 @@ pgm_setsockopt (
 	case PGM_ACK_SOCK:
 	case PGM_TIME_REMAIN:
 	case PGM_RATE_REMAIN:
+	case PGM_SKB_POOL_HITS:
+	case PGM_SKB_POOL_MISSES:
+	case PGM_PARITY_CACHE_HITS:
+	case PGM_PARITY_CACHE_MISSES:
+	case PGM_ZERO_CHECKSUM_SENT:
+	case PGM_ZERO_CHECKSUM_RECEIVED:
+	case PGM_RECV_SHARD_SOCKS:
+	case PGM_PINNED_BYTES:
+	case PGM_PREWARM_BYTES:
+	case PGM_RATES:
+	case PGM_PATH_MTU:
 	default:
 		break;
 	}
@@ -1895,10 +4784,216 @@ pgm_setsockopt (
 	break;
 	}
 
+	if (status && !sock->is_bound)
+		pgm_opt_log_record (sock, level, optname, optval, optlen);
 	pgm_rwlock_reader_unlock (&sock->lock);
 	return status;
 }
 
+/* group membership and source filters name the session rather than configure
+ * the socket and so are not carried over to clones.
+ */
+
+static
+bool
+pgm_opt_log_is_session (
+	const int	level,
+	const int	optname
+	)
+{
+	if (IPPROTO_PGM != level)
+		return FALSE;
+	switch (optname) {
+	case PGM_SEND_GROUP:
+	case PGM_JOIN_GROUP:
+	case PGM_LEAVE_GROUP:
+	case PGM_BLOCK_SOURCE:
+	case PGM_UNBLOCK_SOURCE:
+	case PGM_JOIN_SOURCE_GROUP:
+	case PGM_LEAVE_SOURCE_GROUP:
+	case PGM_MSFILTER:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+/* record a successful option, replacing any earlier value of the same option
+ * so that the log replays in the order the values were last applied.
+ */
+
+static
+void
+pgm_opt_log_record (
+	pgm_sock_t* const restrict sock,
+	const int		   level,
+	const int		   optname,
+	const void*	  restrict optval,
+	const socklen_t		   optlen
+	)
+{
+	struct pgm_opt_log_t* entry;
+	pgm_list_t* list;
+
+	if (pgm_opt_log_is_session (level, optname))
+		return;
+	list = sock->opt_log;
+	while (list) {
+		pgm_list_t* next = list->next;
+		entry = list->data;
+		if (entry->level == level && entry->optname == optname) {
+			pgm_free (entry);
+			sock->opt_log = pgm_list_delete_link (sock->opt_log, list);
+			break;
+		}
+		list = next;
+	}
+	entry = pgm_malloc (sizeof(struct pgm_opt_log_t) + optlen);
+	entry->level	 = level;
+	entry->optname	 = optname;
+	entry->optlen	 = optlen;
+	entry->__padding = 0;
+	if (optlen > 0)
+		memcpy (entry->optval, optval, optlen);
+	sock->opt_log = pgm_list_append (sock->opt_log, entry);
+}
+
+static
+void
+pgm_opt_log_free (
+	pgm_sock_t* const sock
+	)
+{
+	while (sock->opt_log) {
+		pgm_free (sock->opt_log->data);
+		sock->opt_log = pgm_list_delete_link (sock->opt_log, sock->opt_log);
+	}
+}
+
+/* create a new unbound socket configured as the template socket, each option
+ * applied to the template before bind is applied again in the same order so
+ * that operating system socket state, receive shards and buffer pools are
+ * set up exactly as for the template.  group membership is not copied.
+ *
+ * returns TRUE on success, or FALSE on error and sets error appropriately.
+ */
+
+bool
+pgm_socket_clone (
+	pgm_sock_t**	    restrict sock,
+	pgm_sock_t* const   restrict template_sock,
+	pgm_error_t**	    restrict error
+	)
+{
+	pgm_sock_t* new_sock;
+	pgm_list_t* list;
+
+	pgm_return_val_if_fail (NULL != sock, FALSE);
+	pgm_return_val_if_fail (NULL != template_sock, FALSE);
+	if (PGM_UNLIKELY(!pgm_rwlock_reader_trylock (&template_sock->lock)))
+		pgm_return_val_if_reached (FALSE);
+	if (PGM_UNLIKELY(template_sock->is_destroyed)) {
+		pgm_rwlock_reader_unlock (&template_sock->lock);
+		pgm_set_error (error,
+			     PGM_ERROR_DOMAIN_SOCKET,
+			     PGM_ERROR_BADF,
+			     _("Template socket is closed."));
+		return FALSE;
+	}
+
+	if (!pgm_socket (&new_sock, template_sock->family, template_sock->socket_type, template_sock->protocol, error)) {
+		pgm_rwlock_reader_unlock (&template_sock->lock);
+		return FALSE;
+	}
+
+	for (list = template_sock->opt_log; list; list = list->next)
+	{
+		const struct pgm_opt_log_t* entry = list->data;
+		if (!pgm_setsockopt (new_sock, entry->level, entry->optname, entry->optval, entry->optlen)) {
+			pgm_rwlock_reader_unlock (&template_sock->lock);
+			pgm_set_error (error,
+				     PGM_ERROR_DOMAIN_SOCKET,
+				     PGM_ERROR_INVAL,
+				     _("Applying template socket option %d at level %d failed."),
+				     entry->optname, entry->level);
+			pgm_close (new_sock, FALSE);
+			return FALSE;
+		}
+	}
+
+	pgm_rwlock_reader_unlock (&template_sock->lock);
+	*sock = new_sock;
+	return TRUE;
+}
+
+/* bind each redundant path send socket to the address of its interface and
+ * apply the multicast hop limit of the send socket.  path sockets never block,
+ * a copy refused is left to the other paths.
+ *
+ * returns TRUE on success, or FALSE on error and sets error appropriately.
+ */
+
+static
+bool
+bind_send_paths (
+	pgm_sock_t*    const restrict sock,
+	pgm_error_t**	     restrict error
+	)
+{
+	for (unsigned i = 0; i < sock->send_path_len; i++)
+	{
+		const SOCKET path_sock = sock->send_path_sock[ i ];
+		struct sockaddr_storage path_addr;
+		memset (&path_addr, 0, sizeof(path_addr));
+		if (!pgm_if_indextoaddr (sock->send_path[ i ].gr_interface,
+					 sock->family,
+					 0,
+					 (struct sockaddr*)&path_addr,
+					 error))
+			return FALSE;
+		if (SOCKET_ERROR == bind (path_sock,
+					  (struct sockaddr*)&path_addr,
+					  pgm_sockaddr_len ((struct sockaddr*)&path_addr)))
+		{
+			const int save_errno = pgm_get_last_sock_error();
+			char errbuf[1024];
+			char addr[INET6_ADDRSTRLEN];
+			pgm_sockaddr_ntop ((struct sockaddr*)&path_addr, addr, sizeof(addr));
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_SOCKET,
+				       pgm_error_from_sock_errno (save_errno),
+				       _("Binding redundant path send socket to address %s: %s"),
+				       addr,
+				       pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+			return FALSE;
+		}
+		pgm_sockaddr_nonblocking (path_sock, TRUE);
+		if (SOCKET_ERROR == pgm_sockaddr_multicast_if (path_sock,
+							       (struct sockaddr*)&path_addr,
+							       sock->send_path[ i ].gr_interface) ||
+		    (sock->hops > 0 &&
+		     SOCKET_ERROR == pgm_sockaddr_multicast_hops (path_sock, sock->family, sock->hops)))
+		{
+			const int save_errno = pgm_get_last_sock_error();
+			char errbuf[1024];
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_SOCKET,
+				       pgm_error_from_sock_errno (save_errno),
+				       _("Setting multicast options of redundant path send socket: %s"),
+				       pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+			return FALSE;
+		}
+		if (PGM_UNLIKELY(pgm_log_mask & PGM_LOG_ROLE_NETWORK))
+		{
+			char s[INET6_ADDRSTRLEN];
+			pgm_sockaddr_ntop ((struct sockaddr*)&path_addr, s, sizeof(s));
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Redundant path send socket bound to %s index %u"),
+				   s, (unsigned)sock->send_path[ i ].gr_interface);
+		}
+	}
+	return TRUE;
+}
+
 bool
 pgm_bind (
 	pgm_sock_t*                       restrict sock,
@@ -1956,6 +5051,49 @@ pgm_bind3 (
 		pgm_rwlock_writer_unlock (&sock->lock);
 		return FALSE;
 	}
+	if (PGM_UNLIKELY(NULL != sock->relay && (!sock->can_recv_data || 0 == sock->dlr_sqns))) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_FAILED,
+			       _("Relay requires a receiving socket with PGM_DLR."));
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	if (PGM_UNLIKELY(NULL != sock->standby && (!sock->can_send_data || sock->use_proactive_parity || sock->use_ondemand_parity))) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_FAILED,
+			       _("Hot standby requires a sending socket without FEC."));
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	if (PGM_UNLIKELY(NULL != sock->relay && sock->relay->subscriber_len > 0 && 0 == sock->udp_encap_ucast_port)) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_FAILED,
+			       _("Relay subscribers require UDP encapsulation."));
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	if (PGM_UNLIKELY(sock->use_xdp_filter && (!sock->can_recv_data || NULL != sock->relay || sock->xdp_xskmap_fd >= 0))) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_FAILED,
+			       _("XDP filter requires a receiving socket without relay or AF_XDP."));
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+/* a standby reads the side channel of the primary on its own thread */
+	if (PGM_UNLIKELY(sock->is_exclusive && (sock->use_fec_thread || sock->use_rdata_thread || sock->decode_threads > 0 || 0 != sock->async_len ||
+						(NULL != sock->standby && !sock->standby->is_mirror))))
+	{
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_FAILED,
+			       _("Exclusive socket cannot service parity, repair, sender or standby threads."));
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
 	if (sock->can_send_data) {
 		if (PGM_UNLIKELY(0 == sock->spm_ambient_interval)) {
 			pgm_set_error (error,
@@ -1965,6 +5103,39 @@ pgm_bind3 (
 			pgm_rwlock_writer_unlock (&sock->lock);
 			return FALSE;
 		}
+		if (PGM_UNLIKELY(0 != sock->spm_suppress_ivl && sock->spm_suppress_ivl < sock->spm_ambient_interval)) {
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_SOCKET,
+				       PGM_ERROR_INVAL,
+				       _("SPM suppression interval shorter than ambient interval."));
+			pgm_rwlock_writer_unlock (&sock->lock);
+			return FALSE;
+		}
+/* producers build from the ODATA templates alone and may not block */
+		if (PGM_UNLIKELY(sock->use_multi_producer &&
+				 (sock->is_nonblocking || sock->use_pgmcc || sock->coalesce_threshold ||
+				  sock->compress_accel || sock->use_send_timestamp || sock->use_pmtud ||
+				  NULL != sock->standby)))
+		{
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_SOCKET,
+				       PGM_ERROR_INVAL,
+				       _("Multiple producers exclude non-blocking sends, congestion control, coalescing, compression, send timestamps, path MTU discovery and hot-standby."));
+			pgm_rwlock_writer_unlock (&sock->lock);
+			return FALSE;
+		}
+/* the sender thread blocks on rate control in place of the application */
+		if (PGM_UNLIKELY(0 != sock->async_len &&
+				 (sock->is_nonblocking || sock->use_multi_producer || sock->use_pmtud ||
+				  NULL != sock->standby)))
+		{
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_SOCKET,
+				       PGM_ERROR_INVAL,
+				       _("Asynchronous sends exclude non-blocking sends, multiple producers, path MTU discovery and hot-standby."));
+			pgm_rwlock_writer_unlock (&sock->lock);
+			return FALSE;
+		}
 		if (PGM_UNLIKELY(0 == sock->spm_heartbeat_len)) {
 			pgm_set_error (error,
 				       PGM_ERROR_DOMAIN_SOCKET,
@@ -2077,6 +5248,7 @@ pgm_bind3 (
 			sock->tsi.sport = htons (pgm_random_int_range (0, UINT16_MAX));
 		} while (sock->tsi.sport == sock->dport);
 	}
+	pgm_sock_registry_rekey ();
 
 /* pseudo-random number generator for back-off intervals */
 	pgm_rand_create (&sock->rand_);
@@ -2140,24 +5312,96 @@ pgm_bind3 (
 		sock->iphdr_len += udphdr_len;
 	}
 
+/* NUMA node of the device receiving the traffic */
+	if (PGM_NUMA_NODE_INTERFACE == sock->numa_node) {
+		const unsigned ifindex = recv_req->ir_interface ? recv_req->ir_interface : send_req->ir_interface;
+		sock->numa_node = pgm_numa_node_of_interface (ifindex);
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Interface #%u on NUMA node %d."), ifindex, sock->numa_node);
+	}
+
+/* CRC32C trailers would be overlaid by the padding of variable length parity */
+	if (sock->use_crc32c &&
+	    (!sock->can_send_data || sock->use_proactive_parity || sock->use_ondemand_parity))
+	{
+		if (sock->can_send_data)
+			pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("CRC32C disabled with FEC."));
+		sock->use_crc32c = FALSE;
+	}
+	const size_t trailer_len = pgm_data_trailer_len (sock);
+
 	const sa_family_t pgmcc_family = sock->use_pgmcc ? sock->family : 0;
-	sock->max_tsdu = (uint16_t)(sock->max_tpdu - sock->iphdr_len - pgm_pkt_offset (FALSE, pgmcc_family));
-	sock->max_tsdu_fragment = (uint16_t)(sock->max_tpdu - sock->iphdr_len - pgm_pkt_offset (TRUE, pgmcc_family));
-	const unsigned max_fragments = sock->txw_sqns ? MIN( PGM_MAX_FRAGMENTS, sock->txw_sqns ) : PGM_MAX_FRAGMENTS;
-	sock->max_apdu = MIN( PGM_MAX_APDU, max_fragments * sock->max_tsdu_fragment );
+
+/* path MTU discovery starts from max_tpdu bounded by the send interface and
+ * reports the receive interface to sources in POLRs.
+ */
+	uint16_t path_mtu = sock->max_tpdu;
+	if (sock->use_pmtud) {
+		const size_t min_tpdu = sock->iphdr_len + pgm_pkt_offset (TRUE, pgmcc_family) + trailer_len + 1;
+		const unsigned send_mtu = pgm_if_indextomtu (send_req->ir_interface);
+		const unsigned recv_mtu = pgm_if_indextomtu (recv_req->ir_interface);
+		if (send_mtu >= min_tpdu && send_mtu < path_mtu) {
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("TPDU bounded by interface #%u MTU of %u bytes."),
+				   send_req->ir_interface, send_mtu);
+			path_mtu = (uint16_t)send_mtu;
+		}
+		sock->pmtu_report = (recv_mtu > 0 && recv_mtu < sock->max_tpdu) ? (uint16_t)recv_mtu : sock->max_tpdu;
+	}
+	sock->pmtu_ceiling = sock->pmtu_probed = path_mtu;
+	sock->pmtu_target  = path_mtu;
+	pgm_sock_set_path_mtu (sock, path_mtu);
+
+/* coalesced APDUs cannot be recovered from parity */
+	if (sock->coalesce_threshold &&
+	    (!sock->can_send_data || sock->use_proactive_parity || sock->use_ondemand_parity))
+	{
+		if (sock->can_send_data)
+			pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Coalescing disabled with FEC."));
+		sock->coalesce_threshold = 0;
+	}
+	if (sock->coalesce_threshold) {
+		sock->coalesce_threshold = MIN( sock->coalesce_threshold, sock->max_tsdu_coalesce );
+		sock->coalesce_buf = pgm_malloc (sock->max_tsdu_coalesce);
+	}
+
+/* as are compressed APDUs, the flag is not carried by parity */
+	if (sock->compress_accel &&
+	    (!sock->can_send_data || sock->use_proactive_parity || sock->use_ondemand_parity))
+	{
+		if (sock->can_send_data)
+			pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Compression disabled with FEC."));
+		sock->compress_accel = 0;
+	}
+	if (sock->compress_accel) {
+		sock->compress_buf = pgm_malloc (sock->max_apdu);
+		sock->compress_gather = pgm_malloc (sock->max_apdu);
+	}
+
+	sock->flightrec = pgm_flightrec_create (sock->flightrec_len);
 
 	if (sock->can_send_data)
 	{
 		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Create transmit window."));
-		sock->window = sock->txw_sqns ?
+		const unsigned txw_sqns = sock->txw_sqns ? sock->txw_sqns : (unsigned)( (sock->txw_secs * sock->txw_max_rte) / sock->max_tpdu );
+		sock->window = sock->txw_max_sqns > txw_sqns ?
+					pgm_txw_create (&sock->tsi,
+							sock->max_tpdu,		/* parity buffers */
+							sock->txw_max_sqns,	/* TXW_MAX_SQNS */
+							0,			/* TXW_SECS */
+							0,			/* TXW_MAX_RTE */
+							sock->use_ondemand_parity || sock->use_proactive_parity,
+							sock->rs_n,
+							sock->rs_k,
+							sock->use_ondemand_parity ? sock->parity_cache : 0) :
+			       sock->txw_sqns ?
 					pgm_txw_create (&sock->tsi,
-							0,			/* MAX_TPDU */
+							sock->max_tpdu,		/* parity buffers */
 							sock->txw_sqns,		/* TXW_SQNS */
 							0,			/* TXW_SECS */
 							0,			/* TXW_MAX_RTE */
 							sock->use_ondemand_parity || sock->use_proactive_parity,
 							sock->rs_n,
-							sock->rs_k) :
+							sock->rs_k,
+							sock->use_ondemand_parity ? sock->parity_cache : 0) :
 					pgm_txw_create (&sock->tsi,
 							sock->max_tpdu,		/* MAX_TPDU */
 							0,			/* TXW_SQNS */
@@ -2165,14 +5409,52 @@ pgm_bind3 (
 							sock->txw_max_rte,	/* TXW_MAX_RTE */
 							sock->use_ondemand_parity || sock->use_proactive_parity,
 							sock->rs_n,
-							sock->rs_k);
+							sock->rs_k,
+							sock->use_ondemand_parity ? sock->parity_cache : 0);
 		pgm_assert (NULL != sock->window);
+		if (sock->txw_max_sqns > txw_sqns)
+			pgm_txw_set_max_length (sock->window, txw_sqns);
+		if (sock->use_txw_slots)
+			pgm_txw_set_slots (sock->window, sock->max_tpdu, sock->hugetlb_size, sock->use_mlock, sock->numa_node);
+		if (NULL != sock->txlog_path) {
+			sock->txlog = pgm_txlog_create (&sock->tsi,
+							sock->txlog_path,
+							sock->max_tpdu,
+							sock->txlog_segment_sqns,
+							sock->txlog_segments,
+							error);
+			if (NULL == sock->txlog) {
+				pgm_rwlock_writer_unlock (&sock->lock);
+				return FALSE;
+			}
+			pgm_txw_set_log (sock->window, sock->txlog);
+		}
+		sock->window->budget = &sock->mem_budget;
+		if (sock->txw_ack_hold && sock->use_pgmcc) {
+			sock->ack_peers = pgm_new0 (struct pgm_ack_peer_t, PGM_ACK_PEERS_MAX);
+			pgm_txw_set_ack_release (sock->window, sock->txw_ack_hold);
+		}
+		if (sock->nak_receiver_rate)
+			sock->nak_peers = pgm_new0 (struct pgm_nak_peer_t, PGM_NAK_PEERS_LEN);
+		if (sock->use_nak_batch)
+			sock->ncf_batch = pgm_new0 (struct pgm_ncf_batch_t, 1);
+	}
+
+/* receive-only sockets keep receiver state per shard for concurrent readers,
+ * a source handles repair requests with one receiver.
+ */
+	if (sock->recv_shards > 1 && !sock->can_send_data) {
+		pgm_rx_shards_destroy (sock);
+		pgm_rx_shards_create (sock, sock->recv_shards);
 	}
 
 /* create peer list */
 	if (sock->can_recv_data) {
-		sock->peers_hashtable = pgm_hashtable_new (pgm_tsi_hash, pgm_tsi_equal);
-		pgm_assert (NULL != sock->peers_hashtable);
+		const uint64_t seed = ((uint64_t)pgm_rand_int (&sock->rand_) << 32) | pgm_rand_int (&sock->rand_);
+		for (unsigned i = 0; i < sock->rx_shard_len; i++) {
+			sock->rx_shard[ i ].peers_table = pgm_peer_table_new (seed);
+			pgm_assert (NULL != sock->rx_shard[ i ].peers_table);
+		}
 	}
 
 /* Bind UDP sockets to interfaces, note multicast on a bound interface is
@@ -2240,7 +5522,24 @@ pgm_bind3 (
 /* UDP port */
 	((struct sockaddr_in*)&recv_addr)->sin_port = htons (sock->udp_encap_mcast_port);
 
-	if (SOCKET_ERROR == bind (sock->recv_sock,
+	if (sock->use_shared_recv &&
+	    (sock->recv_shards > 1 || sock->uring_entries > 0 || sock->rio_entries > 0 || sock->xdp_xskmap_fd >= 0 || sock->dpdk_port_id >= 0 || NULL != sock->skb_pool_addr || NULL != sock->replay_path || NULL != sock->shm_name))
+	{
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Shared receive cannot be combined with receive shards, io_uring, Registered I/O, AF_XDP, DPDK, capture replay, shared memory transport, or application packet memory."));
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+
+/* an existing shared receive socket is already bound */
+	if (sock->use_shared_recv &&
+	    pgm_demux_attach (sock, &recv_addr.sa))
+	{
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Joined shared receive socket."));
+	}
+	else if (SOCKET_ERROR == bind (sock->recv_sock,
 				      &recv_addr.sa,
 				      pgm_sockaddr_len (&recv_addr.sa)))
 	{
@@ -2265,6 +5564,23 @@ pgm_bind3 (
 		pgm_debug ("bind succeeded on recv_gsr[0] interface %s", s);
 	}
 
+	if (sock->use_shared_recv && NULL == sock->demux)
+		pgm_demux_create (sock, &recv_addr.sa);
+
+	if (sock->recv_shards > 1 &&
+	    !pgm_recv_shards_bind (sock, &recv_addr.sa, error))
+	{
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	if (NULL != sock->incoming_cpu &&
+	    !pgm_recv_shards_set_cpu (sock, error))
+	{
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	pgm_filter_update (sock);
+
 /* keep a copy of the original address source to re-use for router alert bind */
 	memset (&send_addr, 0, sizeof(send_addr));
 
@@ -2333,6 +5649,18 @@ pgm_bind3 (
 		pgm_debug ("bind succeeded on send_gsr interface %s", s);
 	}
 
+/* data leaves with DF set such that the stack reports a smaller path MTU as
+ * EMSGSIZE rather than fragmenting, UDP encapsulation only.
+ */
+	if (sock->use_pmtud && sock->udp_encap_ucast_port &&
+	    SOCKET_ERROR == pgm_sockaddr_dontfrag (sock->send_sock, sock->family, TRUE))
+	{
+		const int save_errno = pgm_get_last_sock_error();
+		char errbuf[1024];
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Cannot set don't fragment on send socket: %s"),
+			   pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+	}
+
 	if (SOCKET_ERROR == bind (sock->send_with_router_alert_sock,
 				      (struct sockaddr*)&send_with_router_alert_addr,
 				      pgm_sockaddr_len((struct sockaddr*)&send_with_router_alert_addr)))
@@ -2361,6 +5689,23 @@ pgm_bind3 (
 /* save send side address for broadcasting as source nla */
 	memcpy (&sock->send_addr, &send_addr, pgm_sockaddr_len ((struct sockaddr*)&send_addr));
 
+	if (!bind_send_paths (sock, error)) {
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	if (NULL != sock->relay &&
+	    !pgm_relay_bind (sock, error))
+	{
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	if (NULL != sock->standby &&
+	    !pgm_standby_bind (sock, error))
+	{
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+
 /* rx to nak processor notify channel */
 	if (sock->can_send_data)
 	{
@@ -2369,6 +5714,7 @@ pgm_bind3 (
 			pgm_trace (PGM_LOG_ROLE_RATE_CONTROL,_("Setting rate regulation to %" PRIzd " bytes per second."),
 					sock->txw_max_rte);
 			pgm_rate_create (&sock->rate_control, sock->txw_max_rte, sock->iphdr_len, sock->max_tpdu);
+			sock->rate_control.stall_stats = &sock->cumulative_stats[PGM_PC_SOURCE_RATE_STALLS];
 			sock->is_controlled_spm   = TRUE;	/* must always be set */
 		} else
 			sock->is_controlled_spm   = FALSE;
@@ -2377,6 +5723,7 @@ pgm_bind3 (
 			pgm_trace (PGM_LOG_ROLE_RATE_CONTROL,_("Setting ODATA rate regulation to %" PRIzd " bytes per second."),
 					sock->odata_max_rte);
 			pgm_rate_create (&sock->odata_rate_control, sock->odata_max_rte, sock->iphdr_len, sock->max_tpdu);
+			sock->odata_rate_control.stall_stats = &sock->cumulative_stats[PGM_PC_SOURCE_ODATA_RATE_STALLS];
 			sock->is_controlled_odata = TRUE;
 		}
 		if (sock->rdata_max_rte > 0) {
@@ -2385,14 +5732,235 @@ pgm_bind3 (
 			pgm_rate_create (&sock->rdata_rate_control, sock->rdata_max_rte, sock->iphdr_len, sock->max_tpdu);
 			sock->is_controlled_rdata = TRUE;
 		}
+		if (NULL != sock->rate_group_name &&
+		    !pgm_rate_group_open (sock, error))
+		{
+			pgm_rwlock_writer_unlock (&sock->lock);
+			return FALSE;
+		}
+	}
+
+/* Registered I/O receives into buffers of one registered region, sized for
+ * outstanding receives and those held by the receive window.
+ */
+	if (sock->rio_entries > 0 && 0 == sock->skb_pool_size && NULL == sock->skb_pool_addr)
+		sock->skb_pool_size = 4 * sock->rio_entries;
+
+/* fixed size packet buffers for both send and receive paths */
+	if (sock->skb_pool_size || NULL != sock->skb_pool_addr) {
+		sock->skb_pool = pgm_skb_pool_create (pgm_uring_buffer_len (sock), sock->skb_pool_size);
+		if (NULL != sock->skb_pool_addr)
+			(void)pgm_skb_pool_attach (sock->skb_pool, sock->skb_pool_addr, sock->skb_pool_len);
+		else if (sock->hugetlb_size || sock->use_mlock || sock->numa_node >= 0 || sock->rio_entries > 0)
+			pgm_skb_pool_reserve (sock->skb_pool, sock->skb_pool_size, sock->hugetlb_size, sock->use_mlock, sock->numa_node);
+	}
+
+/* right-sized copies of small TPDUs held by receive windows */
+	if (sock->rx_compact_len > 0 && sock->can_recv_data)
+		sock->compact_pool = pgm_skb_pool_create ((uint16_t)sock->rx_compact_len, PGM_SKB_POOL_DEFAULT_SIZE);
+
+/* reassembly buffers of large APDUs, one pool per size class in use */
+	if (sock->rx_reasm_len > 0 && sock->can_recv_data) {
+		for (unsigned i = 0; i < PGM_RXW_REASM_CLASSES; i++)
+			if (pgm_rxw_reasm_class_size (i) >= sock->rx_reasm_len)
+				sock->reasm_pool[i] = pgm_skb_pool_create (pgm_rxw_reasm_class_size (i), PGM_RXW_REASM_POOL_SIZE);
+	}
+
+/* decompressed APDUs, buffers cached on first use */
+	if (pgm_compress_is_available() && sock->can_recv_data) {
+		for (unsigned i = 0; i < PGM_RXW_REASM_CLASSES; i++)
+			sock->inflate_pool[i] = pgm_skb_pool_create (pgm_rxw_reasm_class_size (i), PGM_RXW_REASM_POOL_SIZE);
+	}
+
+/* memory pinned for the data path */
+	sock->pinned_bytes = 0;
+	if (NULL != sock->skb_pool)
+		sock->pinned_bytes += sock->skb_pool->region.locked;
+	if (NULL != sock->window && NULL != sock->window->slots)
+		sock->pinned_bytes += sock->window->slots->region.locked;
+	if (sock->use_mlock)
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Locked %" PRIu64 " bytes of packet memory."),
+			   sock->pinned_bytes);
+
+/* receive shards are read through the kernel sockets */
+	if (sock->recv_shards > 1 &&
+	    (sock->uring_entries > 0 || sock->rio_entries > 0 || sock->xdp_xskmap_fd >= 0 || sock->dpdk_port_id >= 0 || NULL != sock->replay_path || NULL != sock->shm_name))
+	{
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Receive shards cannot be combined with io_uring, Registered I/O, AF_XDP, DPDK, capture replay, or shared memory transport."));
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	if (NULL != sock->replay_path &&
+	    (sock->uring_entries > 0 || sock->rio_entries > 0 || sock->xdp_xskmap_fd >= 0 || sock->dpdk_port_id >= 0))
+	{
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Capture replay cannot be combined with io_uring, Registered I/O, AF_XDP or DPDK."));
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	if (sock->dpdk_port_id >= 0 &&
+	    (sock->uring_entries > 0 || sock->rio_entries > 0 || sock->xdp_xskmap_fd >= 0))
+	{
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("DPDK cannot be combined with io_uring, Registered I/O or AF_XDP."));
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	if (NULL != sock->shm_name &&
+	    (sock->uring_entries > 0 || sock->rio_entries > 0 || NULL != sock->replay_path))
+	{
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Shared memory transport cannot be combined with io_uring, Registered I/O or capture replay."));
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	if (NULL != sock->loop_name &&
+	    (sock->recv_shards > 1 || sock->uring_entries > 0 || sock->rio_entries > 0 || sock->xdp_xskmap_fd >= 0 || sock->dpdk_port_id >= 0 || NULL != sock->replay_path || NULL != sock->shm_name))
+	{
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Loopback bus cannot be combined with receive shards, io_uring, Registered I/O, AF_XDP, DPDK, capture replay or shared memory transport."));
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
 	}
 
 /* allocate first incoming packet buffer */
-	sock->rx_buffer = pgm_alloc_skb (sock->max_tpdu);
+	for (unsigned i = 0; i < sock->rx_shard_len; i++)
+		sock->rx_shard[ i ].rx_buffer = pgm_skb_pool_alloc (sock->skb_pool, pgm_uring_buffer_len (sock));
+	if (sock->uring_entries > 0 &&
+	    !pgm_uring_open (sock, error))
+	{
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	if (sock->rio_entries > 0 &&
+	    !pgm_rio_open (sock, error))
+	{
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+/* captured packets replace the receive socket */
+	if (NULL != sock->replay_path &&
+	    !pgm_replay_open (sock, error))
+	{
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+/* same-host ring, published or read alongside the network */
+	if (NULL != sock->shm_name &&
+	    !pgm_shm_open (sock, error))
+	{
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+/* in-process bus, in place of the network in both directions */
+	if (NULL != sock->loop_name &&
+	    !pgm_loop_open (sock, error))
+	{
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+/* io_uring and Registered I/O read the receive socket exclusively, shards read one datagram per call,
+ * coalesced datagrams would reach sharing sockets without GRO.
+ */
+	if (NULL == sock->uring && NULL == sock->rio && NULL == sock->replay && 1 == sock->recv_shards) {
+		pgm_recv_batch_create (sock);
+		if (sock->can_recv_data && sock->use_udp_gro && NULL == sock->demux)
+			pgm_recv_gro_create (sock);
+	}
+	if (sock->busy_poll_usecs > 0)
+		pgm_recv_busy_poll_create (sock);
+
+/* early drop ahead of the network stack */
+	if (sock->use_xdp_filter &&
+	    !pgm_xdp_filter_attach (sock, recv_req->ir_interface, error))
+	{
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+
+/* kernel bypass packet I/O */
+	if (sock->xdp_xskmap_fd >= 0 &&
+	    !pgm_xdp_open (sock, send_req->ir_interface, error))
+	{
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+	if (sock->dpdk_port_id >= 0 &&
+	    !pgm_dpdk_open (sock, error))
+	{
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+
+/* kernel transmit pacing */
+	if (sock->can_send_data && PGM_TXTIME_NONE != sock->txtime_mode)
+		pgm_txtime_create (sock);
+
+/* arrival time stamps */
+	if (PGM_RX_TIMESTAMP_NONE != sock->rx_timestamp_mode)
+		pgm_rx_timestamp_create (sock);
+
+/* kernel receive buffer and receive windows following the received rate */
+	if (sock->can_recv_data && sock->use_rx_tune)
+		pgm_rx_tune_create (sock);
+
+/* transmit by reference, after pacing which excludes it */
+	if (sock->can_send_data && sock->use_zerocopy)
+		pgm_zerocopy_create (sock);
+
+/* ODATA headers fixed by the bound TSI and data-destination port */
+	if (sock->can_send_data)
+		pgm_odata_template_init (sock);
+
+/* outgoing packet references for batched transmit */
+	if (sock->can_send_data && sock->tx_batch_size > 1)
+		sock->tx_batch = pgm_new0 (struct pgm_sk_buff_t*, sock->tx_batch_size);
+
+/* sequences reserved by producers continue the window */
+	if (sock->can_send_data && sock->use_multi_producer) {
+		sock->mp_ring = (struct pgm_sk_buff_t* volatile*)pgm_new0 (struct pgm_sk_buff_t*, PGM_MP_RING_LEN);
+		sock->mp_reserve_sqn = sock->mp_commit_sqn = pgm_txw_next_lead (sock->window);
+	}
+
+/* pipelined proactive parity */
+	if (sock->can_send_data &&
+	    sock->use_fec_thread &&
+	    sock->use_proactive_parity)
+		pgm_fec_thread_create (sock);
+
+/* repair data independent of application calls */
+	if (sock->can_send_data &&
+	    sock->use_rdata_thread)
+		pgm_rdata_thread_create (sock);
+
+/* original data independent of application calls */
+	if (sock->can_send_data &&
+	    0 != sock->async_len &&
+	    !pgm_async_thread_create (sock))
+		sock->async_len = 0;
+
+/* parity reconstruction off the receive path */
+	if (sock->can_recv_data &&
+	    sock->decode_threads > 0)
+		sock->decode_pool = pgm_decode_pool_create (sock, sock->decode_threads);
 
 /* bind complete */
 	sock->is_bound = TRUE;
 
+/* persistent readiness instance for blocking receives */
+	pgm_wait_create (sock);
+
 /* cleanup */
 	pgm_rwlock_writer_unlock (&sock->lock);
 	pgm_debug ("PGM socket successfully bound.");
@@ -2425,9 +5993,38 @@ pgm_connect (
 	pgm_debug ("connect (sock:%p error:%p)",
 		 (const void*)sock, (const void*)error);
 
+/* single readiness descriptor for event loops */
+	if (sock->use_event_sock &&
+	    INVALID_SOCKET == sock->event_sock &&
+	    !pgm_event_sock_create (sock, error))
+	{
+		pgm_rwlock_writer_unlock (&sock->lock);
+		return FALSE;
+	}
+
+/* fault in memory ahead of the first packets */
+	if (sock->prewarm_peers > 0)
+	{
+		uint64_t touched = 0;
+		if (NULL != sock->skb_pool)
+			touched += pgm_skb_pool_prewarm (sock->skb_pool, sock->skb_pool_size);
+		if (NULL != sock->compact_pool)
+			touched += pgm_skb_pool_prewarm (sock->compact_pool, PGM_SKB_POOL_DEFAULT_SIZE);
+		if (sock->can_send_data)
+			touched += pgm_txw_prewarm (sock->window);
+		if (sock->can_recv_data)
+			touched += pgm_receiver_prewarm (sock);
+		sock->prewarm_bytes = touched;
+		pgm_trace (PGM_LOG_ROLE_MEMORY,_("Prewarmed %" PRIu64 " bytes for %u peers."),
+			   touched, sock->prewarm_peers);
+	}
+
 /* rx to nak processor notify channel */
 	if (sock->can_send_data)
 	{
+/* SPM options are fixed once connected */
+		pgm_spm_template_init (sock);
+
 /* announce new sock by sending out SPMs */
 		if (!pgm_send_spm (sock, PGM_OPT_SYN) ||
 		    !pgm_send_spm (sock, PGM_OPT_SYN) ||
@@ -2449,6 +6046,14 @@ pgm_connect (
 /* start PGMCC with one token */
 		sock->tokens = sock->cwnd_size = pgm_fp8 (1);
 
+/* TFMCC holds the token and regulates the rate instead */
+		if (sock->use_tfmcc && (!sock->use_pgmcc || 0 == sock->txw_max_rte)) {
+			pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("TFMCC disabled without PGMCC and a maximum transmit rate."));
+			sock->use_tfmcc = FALSE;
+		}
+		if (sock->use_tfmcc)
+			pgm_tfmcc_init (sock, pgm_time_update_now());
+
 /* slow start threshold */
 		sock->ssthresh = pgm_fp8 (4);
 
@@ -2462,12 +6067,18 @@ pgm_connect (
 	{
 		pgm_assert (sock->can_recv_data);
 		sock->next_poll = pgm_time_update_now() + pgm_secs( 30 );
+		for (unsigned i = 0; i < sock->rx_shard_len; i++)
+			sock->rx_shard[ i ].next_poll = sock->next_poll;
 	}
 
 	sock->is_connected = TRUE;
 
 /* cleanup */
+	const pgm_time_t next_poll = sock->next_poll;
 	pgm_rwlock_writer_unlock (&sock->lock);
+	pgm_engine_timer_wake (next_poll);
+	if (INVALID_SOCKET != sock->event_timer_fd)
+		pgm_timer_event_arm (sock);
 	pgm_debug ("PGM socket successfully connected.");
 	return TRUE;
 }
@@ -2524,11 +6135,26 @@ pgm_select_info (
 
 	if (readfds)
 	{
-		FD_SET(sock->recv_sock, readfds);
+		FD_SET(pgm_recv_event_sock (sock), readfds);
 #ifndef _WIN32
-		fds = sock->recv_sock + 1;
+		fds = pgm_recv_event_sock (sock) + 1;
 #else
 		fds = 1;
+#endif
+		for (unsigned i = 1; i < sock->recv_shards; i++) {
+			const SOCKET shard_fd = pgm_recv_shard_sock (sock, i);
+			FD_SET(shard_fd, readfds);
+#ifndef _WIN32
+			fds = MAX(fds, shard_fd + 1);
+#else
+			fds++;
+#endif
+		}
+#ifdef HAVE_LINUX_IF_XDP_H
+		if (sock->xdp) {
+			FD_SET(sock->xdp->fd, readfds);
+			fds = MAX(fds, sock->xdp->fd + 1);
+		}
 #endif
 		if (sock->can_send_data) {
 			const SOCKET rdata_fd = pgm_notify_get_socket (&sock->rdata_notify);
@@ -2624,13 +6250,27 @@ pgm_wsapoll_info (
 		return SOCKET_ERROR;
 	}
 
-/* we currently only support one incoming socket */
+/* receive socket and any receive shards */
 	if (events & PGM_POLLIN)
 	{
 		pgm_assert ( (1 + nfds) <= *n_fds );
-		fds[nfds].fd = sock->recv_sock;
+		fds[nfds].fd = pgm_recv_event_sock (sock);
 		fds[nfds].events = PGM_POLLIN;
 		nfds++;
+		for (unsigned i = 1; i < sock->recv_shards; i++) {
+			pgm_assert ( (1 + nfds) <= *n_fds );
+			fds[nfds].fd = pgm_recv_shard_sock (sock, i);
+			fds[nfds].events = PGM_POLLIN;
+			nfds++;
+		}
+#ifdef HAVE_LINUX_IF_XDP_H
+		if (sock->xdp) {
+			pgm_assert ( (1 + nfds) <= *n_fds );
+			fds[nfds].fd = sock->xdp->fd;
+			fds[nfds].events = PGM_POLLIN;
+			nfds++;
+		}
+#endif
 		if (sock->can_send_data) {
 			pgm_assert ( (1 + nfds) <= *n_fds );
 			fds[nfds].fd = pgm_notify_get_socket (&sock->rdata_notify);
@@ -2696,9 +6336,21 @@ pgm_epoll_ctl (
 	{
 		event.events = events & (EPOLLIN | EPOLLET | EPOLLONESHOT);
 		event.data.ptr = sock;
-		retval = epoll_ctl (epfd, op, sock->recv_sock, &event);
+		retval = epoll_ctl (epfd, op, pgm_recv_event_sock (sock), &event);
 		if (retval)
 			goto out;
+		for (unsigned i = 1; i < sock->recv_shards; i++) {
+			retval = epoll_ctl (epfd, op, pgm_recv_shard_sock (sock, i), &event);
+			if (retval)
+				goto out;
+		}
+#ifdef HAVE_LINUX_IF_XDP_H
+		if (sock->xdp) {
+			retval = epoll_ctl (epfd, op, sock->xdp->fd, &event);
+			if (retval)
+				goto out;
+		}
+#endif
 		if (sock->can_send_data) {
 			retval = epoll_ctl (epfd, op, pgm_notify_get_socket (&sock->rdata_notify), &event);
 			if (retval)
@@ -2749,6 +6401,193 @@ out:
 }
 #endif /* HAVE_EPOLL_CTL */
 
+/* add kqueue filters for the receive socket(s), filter should be EVFILT_READ
+ * to wait for incoming events (data), and EVFILT_WRITE to wait for
+ * non-blocking write.  flags are those of EV_SET(), such as EV_ADD, EV_DELETE
+ * or EV_CLEAR for edge triggered reads.
+ *
+ * returns 0 on success, -1 on failure and sets errno appropriately.
+ */
+#ifdef HAVE_KQUEUE
+int
+pgm_kqueue_ctl (
+	pgm_sock_t* const	sock,
+	const SOCKET		kq,
+	const int		filter,		/* EVFILT_READ, EVFILT_WRITE */
+	const int		flags		/* EV_ADD, EV_DELETE, ... */
+	)
+{
+	struct kevent changes[ PGM_RECV_SHARDS_MAX + 3 ];
+	int nchanges = 0;
+	const int ev_flags = flags & (EV_ADD | EV_DELETE | EV_ENABLE | EV_DISABLE | EV_CLEAR | EV_ONESHOT);
+
+	if (!(EVFILT_READ == filter || EVFILT_WRITE == filter) ||
+	    !(ev_flags & (EV_ADD | EV_DELETE | EV_ENABLE | EV_DISABLE)))
+	{
+		pgm_set_last_sock_error (PGM_SOCK_EINVAL);
+		return SOCKET_ERROR;
+	}
+	else if (!sock->is_bound || sock->is_destroyed)
+	{
+		pgm_set_last_sock_error (PGM_SOCK_EINVAL);
+		return SOCKET_ERROR;
+	}
+
+	if (EVFILT_READ == filter)
+	{
+		EV_SET(&changes[nchanges++], pgm_recv_event_sock (sock), EVFILT_READ, ev_flags, 0, 0, sock);
+		for (unsigned i = 1; i < sock->recv_shards; i++)
+			EV_SET(&changes[nchanges++], pgm_recv_shard_sock (sock, i), EVFILT_READ, ev_flags, 0, 0, sock);
+		if (sock->can_send_data)
+			EV_SET(&changes[nchanges++], pgm_notify_get_socket (&sock->rdata_notify), EVFILT_READ, ev_flags, 0, 0, sock);
+		EV_SET(&changes[nchanges++], pgm_notify_get_socket (&sock->pending_notify), EVFILT_READ, ev_flags, 0, 0, sock);
+
+		if (ev_flags & EV_CLEAR)
+			sock->is_edge_triggered_recv = TRUE;
+	}
+	else if (sock->can_send_data)
+	{
+/* both sockets need to be added when PGMCC is enabled */
+		bool enable_ack_socket = FALSE;
+		bool enable_send_socket = FALSE;
+		if (sock->use_pgmcc && (ev_flags & (EV_ADD | EV_DELETE))) {
+			enable_ack_socket = enable_send_socket = TRUE;
+		} else {
+/* automagically switch socket when congestion stall occurs */
+			if (sock->use_pgmcc && sock->tokens < pgm_fp8 (1))
+				enable_ack_socket = TRUE;
+			else
+				enable_send_socket = TRUE;
+		}
+
+/* rx thread poll for ACK */
+		if (enable_ack_socket)
+			EV_SET(&changes[nchanges++], pgm_notify_get_socket (&sock->ack_notify), EVFILT_READ, ev_flags & ~EV_CLEAR, 0, 0, sock);
+/* kernel resource poll */
+		if (enable_send_socket)
+			EV_SET(&changes[nchanges++], sock->send_sock, EVFILT_WRITE, ev_flags, 0, 0, sock);
+	}
+
+	if (0 == nchanges)
+		return 0;
+	return kevent (kq, changes, nchanges, NULL, 0, NULL);
+}
+#endif /* HAVE_KQUEUE */
+
+/* create an epoll or kqueue instance watching the receive descriptors of
+ * pgm_poll_info(), reused by every blocking wait of the receive path.  On
+ * failure blocking receives fall back to rebuilding a descriptor set.
+ */
+
+static
+void
+pgm_wait_create (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (sock->is_bound);
+	pgm_assert (INVALID_SOCKET == sock->wait_fd);
+
+#if defined(HAVE_EPOLL_CTL)
+	const int epfd = epoll_create1 (EPOLL_CLOEXEC);
+	if (-1 == epfd)
+		goto err_errno;
+	if (0 != pgm_epoll_ctl (sock, epfd, EPOLL_CTL_ADD, EPOLLIN)) {
+		const int save_errno = errno;
+		close (epfd);
+		errno = save_errno;
+		goto err_errno;
+	}
+	sock->wait_fd = epfd;
+	return;
+#elif defined(HAVE_KQUEUE)
+	const int kq = kqueue ();
+	if (-1 == kq)
+		goto err_errno;
+	if (0 != pgm_kqueue_ctl (sock, kq, EVFILT_READ, EV_ADD)) {
+		const int save_errno = errno;
+		close (kq);
+		errno = save_errno;
+		goto err_errno;
+	}
+	sock->wait_fd = kq;
+	return;
+#endif
+
+#if defined(HAVE_EPOLL_CTL) || defined(HAVE_KQUEUE)
+err_errno:
+	{
+		char errbuf[1024];
+		pgm_warn (_("Creating receive wait instance failed, blocking receives use poll: %s"),
+			  pgm_strerror_s (errbuf, sizeof (errbuf), errno));
+	}
+#endif
+}
+
+/* create the PGM_EVENT_SOCK epoll instance over the receive, repair, pending
+ * and ACK descriptors together with a timerfd of the next socket deadline.
+ */
+
+static
+bool
+pgm_event_sock_create (
+	pgm_sock_t*   const restrict sock,
+	pgm_error_t**       restrict error
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (sock->is_bound);
+	pgm_assert (INVALID_SOCKET == sock->event_sock);
+
+#if defined(HAVE_EPOLL_CTL) && defined(HAVE_TIMERFD_CREATE)
+	struct epoll_event event;
+	const int epfd = epoll_create1 (EPOLL_CLOEXEC);
+	if (-1 == epfd)
+		goto err_errno;
+	sock->event_sock = epfd;
+	if (0 != pgm_epoll_ctl (sock, epfd, EPOLL_CTL_ADD, EPOLLIN))
+		goto err_errno;
+	event.events = EPOLLIN;
+	event.data.ptr = sock;
+	if (sock->can_send_data && sock->use_pgmcc &&
+	    0 != epoll_ctl (epfd, EPOLL_CTL_ADD, pgm_notify_get_socket (&sock->ack_notify), &event))
+		goto err_errno;
+	sock->event_timer_fd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (-1 == sock->event_timer_fd)
+		goto err_errno;
+	if (0 != epoll_ctl (epfd, EPOLL_CTL_ADD, sock->event_timer_fd, &event))
+		goto err_errno;
+	return TRUE;
+
+err_errno:
+	{
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_errno (save_errno),
+			       _("Creating event socket: %s"),
+			       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		if (INVALID_SOCKET != sock->event_timer_fd) {
+			close (sock->event_timer_fd);
+			sock->event_timer_fd = INVALID_SOCKET;
+		}
+		close (sock->event_sock);
+		sock->event_sock = INVALID_SOCKET;
+		return FALSE;
+	}
+#else
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       PGM_ERROR_NOSYS,
+		       _("Event socket requires epoll and timerfd support."));
+	return FALSE;
+#endif
+}
+
 static
 const char*
 pgm_sock_type_string (
@@ -56,20 +56,97 @@
 
 #define pgm_ipproto_pgm		mock_pgm_ipproto_pgm
 #define pgm_peer_unref		mock_pgm_peer_unref
+#define pgm_receiver_prewarm	mock_pgm_receiver_prewarm
+#define pgm_peer_update_weight	mock_pgm_peer_update_weight
+#define pgm_peer_get_stats	mock_pgm_peer_get_stats
+#define pgm_source_get_stats	mock_pgm_source_get_stats
+#define pgm_stats_ring_rates	mock_pgm_stats_ring_rates
 #define pgm_on_nak_notify	mock_pgm_on_nak_notify
 #define pgm_send_spm		mock_pgm_send_spm
+#define pgm_coalesce_flush	mock_pgm_coalesce_flush
+#define pgm_fec_thread_create	mock_pgm_fec_thread_create
+#define pgm_fec_thread_destroy	mock_pgm_fec_thread_destroy
+#define pgm_rdata_thread_create	mock_pgm_rdata_thread_create
+#define pgm_rdata_thread_destroy	mock_pgm_rdata_thread_destroy
+#define pgm_async_thread_create		mock_pgm_async_thread_create
+#define pgm_async_thread_destroy	mock_pgm_async_thread_destroy
+#define pgm_decode_pool_create	mock_pgm_decode_pool_create
+#define pgm_decode_pool_destroy	mock_pgm_decode_pool_destroy
+#define pgm_relay_create	mock_pgm_relay_create
+#define pgm_relay_destroy	mock_pgm_relay_destroy
+#define pgm_relay_bind		mock_pgm_relay_bind
+#define pgm_relay_set_group	mock_pgm_relay_set_group
+#define pgm_relay_add_subscriber	mock_pgm_relay_add_subscriber
+#define pgm_standby_create	mock_pgm_standby_create
+#define pgm_standby_destroy	mock_pgm_standby_destroy
+#define pgm_standby_bind	mock_pgm_standby_bind
+#define pgm_standby_takeover	mock_pgm_standby_takeover
+#define pgm_flightrec_create	mock_pgm_flightrec_create
+#define pgm_flightrec_destroy	mock_pgm_flightrec_destroy
+#define pgm_odata_template_init	mock_pgm_odata_template_init
+#define pgm_spm_template_init	mock_pgm_spm_template_init
 #define pgm_timer_prepare	mock_pgm_timer_prepare
 #define pgm_timer_check		mock_pgm_timer_check
 #define pgm_timer_expiration	mock_pgm_timer_expiration
 #define pgm_timer_dispatch	mock_pgm_timer_dispatch
+#define pgm_timer_event_arm	mock_pgm_timer_event_arm
 #define pgm_txw_create		mock_pgm_txw_create
 #define pgm_txw_shutdown	mock_pgm_txw_shutdown
+#define pgm_txw_set_slots	mock_pgm_txw_set_slots
+#define pgm_txw_set_log		mock_pgm_txw_set_log
+#define pgm_txlog_create	mock_pgm_txlog_create
+#define pgm_txlog_destroy	mock_pgm_txlog_destroy
+#define pgm_txw_set_max_length	mock_pgm_txw_set_max_length
+#define pgm_txw_set_ack_release	mock_pgm_txw_set_ack_release
+#define pgm_txw_prewarm		mock_pgm_txw_prewarm
+#define pgm_rxw_set_max_length	mock_pgm_rxw_set_max_length
+#define pgm_rxw_destroy		mock_pgm_rxw_destroy
 #define pgm_rate_create		mock_pgm_rate_create
 #define pgm_rate_destroy	mock_pgm_rate_destroy
+#define pgm_rate_group_open	mock_pgm_rate_group_open
+#define pgm_rate_group_close	mock_pgm_rate_group_close
+#define pgm_tfmcc_init		mock_pgm_tfmcc_init
 #define pgm_rate_remaining	mock_pgm_rate_remaining
 #define pgm_rs_create		mock_pgm_rs_create
 #define pgm_rs_destroy		mock_pgm_rs_destroy
+#define pgm_recv_batch_create	mock_pgm_recv_batch_create
+#define pgm_recv_batch_destroy	mock_pgm_recv_batch_destroy
+#define pgm_recv_gro_create	mock_pgm_recv_gro_create
+#define pgm_recv_gro_destroy	mock_pgm_recv_gro_destroy
+#define pgm_recv_async_destroy	mock_pgm_recv_async_destroy
+#define pgm_recv_drain_destroy	mock_pgm_recv_drain_destroy
+#define pgm_recv_pending_socket	mock_pgm_recv_pending_socket
+#define pgm_recv_busy_poll_create	mock_pgm_recv_busy_poll_create
+#define pgm_txtime_create	mock_pgm_txtime_create
+#define pgm_rx_timestamp_create	mock_pgm_rx_timestamp_create
+#define pgm_rx_tune_create	mock_pgm_rx_tune_create
+#define pgm_zerocopy_create	mock_pgm_zerocopy_create
+#define pgm_zerocopy_destroy	mock_pgm_zerocopy_destroy
+#define pgm_xdp_open		mock_pgm_xdp_open
+#define pgm_xdp_close		mock_pgm_xdp_close
+#define pgm_replay_open		mock_pgm_replay_open
+#define pgm_replay_close	mock_pgm_replay_close
+#define pgm_shm_open		mock_pgm_shm_open
+#define pgm_shm_close		mock_pgm_shm_close
+#define pgm_loop_open		mock_pgm_loop_open
+#define pgm_loop_close		mock_pgm_loop_close
+#define pgm_xdp_filter_attach	mock_pgm_xdp_filter_attach
+#define pgm_xdp_filter_detach	mock_pgm_xdp_filter_detach
+#define pgm_uring_buffer_len	mock_pgm_uring_buffer_len
+#define pgm_uring_open		mock_pgm_uring_open
+#define pgm_uring_close		mock_pgm_uring_close
+#define pgm_rio_open		mock_pgm_rio_open
+#define pgm_rio_close		mock_pgm_rio_close
+#define pgm_dpdk_open		mock_pgm_dpdk_open
+#define pgm_dpdk_close		mock_pgm_dpdk_close
+#define pgm_recv_shards_create	mock_pgm_recv_shards_create
+#define pgm_recv_shards_bind	mock_pgm_recv_shards_bind
+#define pgm_recv_shards_set_cpu	mock_pgm_recv_shards_set_cpu
+#define pgm_recv_shards_close	mock_pgm_recv_shards_close
+#define pgm_rx_shards_create	mock_pgm_rx_shards_create
+#define pgm_rx_shards_destroy	mock_pgm_rx_shards_destroy
 #define pgm_time_update_now	mock_pgm_time_update_now
+#define pgm_checkpoint_free	mock_pgm_checkpoint_free
 
 #define SOCK_DEBUG
 #include "socket.c"
@@ -154,11 +231,11 @@ preconnect_socket (
 	((struct sockaddr_in*)&sock->send_gsr.gsr_group)->sin_addr.s_addr = inet_addr ("239.192.0.1");
 
 /* rx */
-	sock->recv_gsr_len = 1;
-	((struct sockaddr*)&sock->recv_gsr[0].gsr_group)->sa_family = ((struct sockaddr*)&sock->send_gsr.gsr_group)->sa_family;
-	((struct sockaddr*)&sock->recv_gsr[0].gsr_source)->sa_family = ((struct sockaddr*)&sock->send_gsr.gsr_group)->sa_family;
-	((struct sockaddr_in*)&sock->recv_gsr[0].gsr_group)->sin_addr.s_addr = ((struct sockaddr_in*)&sock->send_gsr.gsr_group)->sin_addr.s_addr;
-	((struct sockaddr_in*)&sock->recv_gsr[0].gsr_source)->sin_addr.s_addr = ((struct sockaddr_in*)&sock->send_gsr.gsr_group)->sin_addr.s_addr;
+	struct group_source_req gsr;
+	memset (&gsr, 0, sizeof(gsr));
+	memcpy (&gsr.gsr_group, &sock->send_gsr.gsr_group, sizeof(struct sockaddr_in));
+	memcpy (&gsr.gsr_source, &sock->send_gsr.gsr_group, sizeof(struct sockaddr_in));
+	pgm_groups_add (sock, &gsr);
 }
 
 /* stock create unconnected socket for pgm_setsockopt(), etc.
@@ -174,12 +251,18 @@ generate_sock (void)
 	sock->is_bound = FALSE;
 	sock->is_connected = FALSE;
 	sock->is_destroyed = FALSE;
-	sock->is_reset = FALSE;
+	sock->rx_shard = g_new0 (struct pgm_rx_shard_t, 1);
+	sock->rx_shard_len = 1;
 	sock->family = AF_INET;
 	sock->protocol = IPPROTO_IP;
 	sock->recv_sock = socket (AF_INET, SOCK_RAW, 113);
+	sock->recv_shards = 1;
 	sock->send_sock = socket (AF_INET, SOCK_RAW, 113);
 	sock->send_with_router_alert_sock = socket (AF_INET, SOCK_RAW, 113);
+	sock->wait_fd = INVALID_SOCKET;
+	sock->event_sock = INVALID_SOCKET;
+	sock->event_timer_fd = INVALID_SOCKET;
+	sock->numa_node = PGM_NUMA_NODE_NONE;
 	((struct sockaddr*)&sock->send_addr)->sa_family = AF_INET;
 	((struct sockaddr_in*)&sock->send_addr)->sin_addr.s_addr = inet_addr ("127.0.0.2");
 	sock->dport = g_htons(TEST_PORT);
@@ -199,6 +282,54 @@ mock_pgm_peer_unref (
 {
 }
 
+PGM_GNUC_INTERNAL
+size_t
+mock_pgm_receiver_prewarm (
+	pgm_sock_t* const	sock
+	)
+{
+	return 0;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_peer_update_weight (
+	pgm_sock_t*		sock,
+	pgm_peer_t*		peer
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_peer_get_stats (
+	pgm_peer_t*			peer,
+	struct pgm_peerstatsinfo_t*	info
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_source_get_stats (
+	pgm_sock_t*			sock,
+	struct pgm_sourcestatsinfo_t*	info
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+unsigned
+mock_pgm_stats_ring_rates (
+	const struct pgm_stats_ring_t* const restrict ring,
+	const unsigned				      interval,
+	uint64_t*		       const restrict rates
+	)
+{
+	memset (rates, 0, PGM_STATS_RATE_MAX * sizeof (uint64_t));
+	return 0;
+}
+
 /** source module */
 static
 bool
@@ -221,6 +352,202 @@ mock_pgm_send_spm (
 	return TRUE;
 }
 
+PGM_GNUC_INTERNAL
+int
+mock_pgm_coalesce_flush (
+	pgm_sock_t*		sock
+	)
+{
+	return PGM_IO_STATUS_NORMAL;
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_fec_thread_create (
+	pgm_sock_t* const	sock
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_fec_thread_destroy (
+	pgm_sock_t* const	sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_rdata_thread_create (
+	pgm_sock_t* const	sock
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_rdata_thread_destroy (
+	pgm_sock_t* const	sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_async_thread_create (
+	pgm_sock_t* const	sock
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_async_thread_destroy (
+	pgm_sock_t* const	sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+struct pgm_decode_pool_t*
+mock_pgm_decode_pool_create (
+	pgm_sock_t* const	sock,
+	const unsigned		count
+	)
+{
+	return NULL;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_decode_pool_destroy (
+	struct pgm_decode_pool_t* const	pool
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+struct pgm_relay_t*
+mock_pgm_relay_create (
+	pgm_sock_t* const		sock,
+	const struct group_req* const	gr
+	)
+{
+	return NULL;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_relay_destroy (
+	struct pgm_relay_t* const	relay
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_relay_bind (
+	pgm_sock_t* const		sock,
+	pgm_error_t**			error
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_relay_set_group (
+	pgm_sock_t* const		sock,
+	const struct group_req* const	gr
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_relay_add_subscriber (
+	struct pgm_relay_t* const		relay,
+	const struct pgm_relaysubinfo_t* const	info
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+struct pgm_standby_t*
+mock_pgm_standby_create (
+	pgm_sock_t* const			sock,
+	const struct pgm_standbyinfo_t* const	info
+	)
+{
+	return NULL;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_standby_destroy (
+	struct pgm_standby_t* const	standby
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_standby_bind (
+	pgm_sock_t* const		sock,
+	pgm_error_t**			error
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_standby_takeover (
+	pgm_sock_t* const		sock
+	)
+{
+	return FALSE;
+}
+
+/** flight recorder module */
+PGM_GNUC_INTERNAL
+pgm_flightrec_t*
+mock_pgm_flightrec_create (
+	const unsigned		len
+	)
+{
+	return NULL;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_flightrec_destroy (
+	pgm_flightrec_t*	fr
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_odata_template_init (
+	pgm_sock_t* const	sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_spm_template_init (
+	pgm_sock_t* const	sock
+	)
+{
+}
+
 /** timer module */
 PGM_GNUC_INTERNAL
 bool
@@ -252,12 +579,21 @@ mock_pgm_timer_expiration (
 PGM_GNUC_INTERNAL
 bool
 mock_pgm_timer_dispatch (
-	pgm_sock_t* const		sock
+	pgm_sock_t* const		sock,
+	struct pgm_rx_shard_t* const	shard
 	)
 {
 	return TRUE;
 }
 
+PGM_GNUC_INTERNAL
+void
+mock_pgm_timer_event_arm (
+	pgm_sock_t* const		sock
+	)
+{
+}
+
 /** transmit window module */
 pgm_txw_t*
 mock_pgm_txw_create (
@@ -268,7 +604,8 @@ mock_pgm_txw_create (
 	const ssize_t		max_rte,
 	const bool		use_fec,
 	const uint8_t		rs_n,
-	const uint8_t		rs_k
+	const uint8_t		rs_k,
+	const size_t		parity_cache
 	)
 {
 	pgm_txw_t* window = g_new0 (pgm_txw_t, 1);
@@ -283,6 +620,98 @@ mock_pgm_txw_shutdown (
 	g_free (window);
 }
 
+void
+mock_pgm_txw_set_slots (
+	pgm_txw_t* const	window,
+	const uint16_t		tpdu_size,
+	const size_t		page_size,
+	const bool		use_mlock,
+	const int		numa_node
+	)
+{
+	g_assert (NULL != window);
+}
+
+bool
+mock_pgm_txw_set_max_length (
+	pgm_txw_t* const	window,
+	const uint32_t		sqns
+	)
+{
+	g_assert (NULL != window);
+	return TRUE;
+}
+
+void
+mock_pgm_txw_set_ack_release (
+	pgm_txw_t* const	window,
+	const pgm_time_t	hold
+	)
+{
+	g_assert (NULL != window);
+}
+
+size_t
+mock_pgm_txw_prewarm (
+	pgm_txw_t* const	window
+	)
+{
+	g_assert (NULL != window);
+	return 0;
+}
+
+/** receive window module */
+void
+mock_pgm_rxw_set_max_length (
+	pgm_rxw_t* const	window,
+	const unsigned		max_sqns
+	)
+{
+	g_assert (NULL != window);
+}
+
+void
+mock_pgm_rxw_destroy (
+	pgm_rxw_t* const	window
+	)
+{
+	g_assert (NULL != window);
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_txw_set_log (
+	pgm_txw_t* const	window,
+	pgm_txlog_t* const	txlog
+	)
+{
+	g_assert (NULL != window);
+}
+
+/** transmit log module */
+PGM_GNUC_INTERNAL
+pgm_txlog_t*
+mock_pgm_txlog_create (
+	const pgm_tsi_t* const	tsi,
+	const char* const	path,
+	const uint16_t		tpdu_size,
+	const uint32_t		segment_sqns,
+	const unsigned		segments,
+	pgm_error_t**		error
+	)
+{
+	return g_new0 (pgm_txlog_t, 1);
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_txlog_destroy (
+	pgm_txlog_t* const	txlog
+	)
+{
+	g_free (txlog);
+}
+
 /** rate control module */
 PGM_GNUC_INTERNAL
 void
@@ -303,6 +732,34 @@ mock_pgm_rate_destroy (
 {
 }
 
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_rate_group_open (
+	pgm_sock_t*		sock,
+	pgm_error_t**		error
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_rate_group_close (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+/** tfmcc module */
+PGM_GNUC_INTERNAL
+void
+mock_pgm_tfmcc_init (
+	pgm_sock_t* const	sock,
+	const pgm_time_t	now
+	)
+{
+}
+
 PGM_GNUC_INTERNAL
 pgm_time_t
 mock_pgm_rate_remaining (
@@ -330,121 +787,2112 @@ mock_pgm_rs_destroy (
 {
 }
 
-/** time module */
-static pgm_time_t _mock_pgm_time_update_now (void);
-pgm_time_update_func mock_pgm_time_update_now = _mock_pgm_time_update_now;
-
-static
-pgm_time_t
-_mock_pgm_time_update_now (void)
+/** recv module */
+PGM_GNUC_INTERNAL
+void
+mock_pgm_recv_batch_create (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_recv_batch_destroy (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_recv_async_destroy (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_recv_drain_destroy (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+SOCKET
+mock_pgm_recv_pending_socket (
+	pgm_sock_t*		sock
+	)
+{
+	return pgm_notify_get_socket (&sock->pending_notify);
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_recv_gro_create (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_recv_gro_destroy (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_recv_busy_poll_create (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+/** net module */
+PGM_GNUC_INTERNAL
+void
+mock_pgm_txtime_create (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_rx_timestamp_create (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_rx_tune_create (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_zerocopy_create (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_zerocopy_destroy (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+/** xdp module */
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_xdp_open (
+	pgm_sock_t*		sock,
+	const unsigned		ifindex,
+	pgm_error_t**		error
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_xdp_close (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+/** xdp_filter module */
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_xdp_filter_attach (
+	pgm_sock_t*		sock,
+	const unsigned		ifindex,
+	pgm_error_t**		error
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_xdp_filter_detach (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+/** replay module */
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_replay_open (
+	pgm_sock_t*		sock,
+	pgm_error_t**		error
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_replay_close (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+/** shm module */
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_shm_open (
+	pgm_sock_t*		sock,
+	pgm_error_t**		error
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_shm_close (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+/** loop module */
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_loop_open (
+	pgm_sock_t*		sock,
+	pgm_error_t**		error
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_loop_close (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+/** uring module */
+PGM_GNUC_INTERNAL
+uint16_t
+mock_pgm_uring_buffer_len (
+	const pgm_sock_t*	sock
+	)
+{
+	return sock->max_tpdu;
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_uring_open (
+	pgm_sock_t*		sock,
+	pgm_error_t**		error
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_uring_close (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+/** rio module */
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_rio_open (
+	pgm_sock_t*		sock,
+	pgm_error_t**		error
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_rio_close (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+/** dpdk module */
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_dpdk_open (
+	pgm_sock_t*		sock,
+	pgm_error_t**		error
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_dpdk_close (
+	pgm_sock_t*		sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_recv_shards_create (
+	pgm_sock_t*		sock,
+	const unsigned		shards
+	)
+{
+	sock->recv_shards = shards;
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_recv_shards_bind (
+	pgm_sock_t*		sock,
+	const struct sockaddr*	addr,
+	pgm_error_t**		error
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_recv_shards_set_cpu (
+	pgm_sock_t*		sock,
+	pgm_error_t**		error
+	)
+{
+	return TRUE;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_recv_shards_close (
+	pgm_sock_t*		sock
+	)
+{
+	sock->recv_shards = 1;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_rx_shards_create (
+	pgm_sock_t*		sock,
+	const unsigned		shards
+	)
+{
+	sock->rx_shard = g_new0 (struct pgm_rx_shard_t, shards);
+	sock->rx_shard_len = shards;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_rx_shards_destroy (
+	pgm_sock_t*		sock
+	)
+{
+	g_free (sock->rx_shard);
+	sock->rx_shard = NULL;
+	sock->rx_shard_len = 0;
+}
+
+/** engine module */
+PGM_GNUC_INTERNAL
+void
+pgm_engine_timer_wake (
+	const pgm_time_t		expiration
+	)
+{
+}
+
+/** demux module */
+PGM_GNUC_INTERNAL
+bool
+pgm_demux_attach (
+	pgm_sock_t*const restrict		sock,
+	const struct sockaddr*const restrict	addr
+	)
+{
+	return FALSE;
+}
+
+PGM_GNUC_INTERNAL
+void
+pgm_demux_create (
+	pgm_sock_t*const restrict		sock,
+	const struct sockaddr*const restrict	addr
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+pgm_demux_detach (
+	pgm_sock_t*const	sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+bool
+pgm_demux_is_shared (
+	pgm_sock_t*const	sock
+	)
+{
+	return FALSE;
+}
+
+/** checkpoint module */
+PGM_GNUC_INTERNAL
+void
+mock_pgm_checkpoint_free (
+	pgm_sock_t* const	sock
+	)
+{
+}
+
+/** filter module */
+PGM_GNUC_INTERNAL
+void
+pgm_filter_update (
+	pgm_sock_t*const	sock
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+pgm_filter_block_source (
+	pgm_sock_t*const restrict		sock,
+	const struct sockaddr*const restrict	source
+	)
+{
+}
+
+PGM_GNUC_INTERNAL
+void
+pgm_filter_unblock_source (
+	pgm_sock_t*const restrict		sock,
+	const struct sockaddr*const restrict	source
+	)
+{
+}
+
+/** time module */
+static pgm_time_t _mock_pgm_time_update_now (void);
+pgm_time_update_func mock_pgm_time_update_now = _mock_pgm_time_update_now;
+
+static
+pgm_time_t
+_mock_pgm_time_update_now (void)
+{
+	return 0x1;
+}
+
+PGM_GNUC_INTERNAL
+int
+pgm_get_nprocs (void)
+{
+	return 1;
+}
+
+/* mock functions for external references */
+
+
+/* target:
+ *	bool
+ *	pgm_socket (
+ *		pgm_sock_t**		sock,
+ *		const sa_family_t	family,
+ *		const int		pgm_sock_type,
+ *		const int		protocol,
+ *		pgm_error_t**		error
+ *	)
+ */
+
+START_TEST (test_create_pass_001)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock;
+/* only one type currently implemented */
+	const int pgm_sock_type = SOCK_SEQPACKET;
+/* PGM/IPv4 */
+	sock = NULL;
+	fail_unless (TRUE == pgm_socket (&sock, AF_INET, pgm_sock_type, IPPROTO_PGM, &err), "create/1 failed");
+/* PGM/UDP over IPv4 */
+	sock = NULL;
+	fail_unless (TRUE == pgm_socket (&sock, AF_INET, pgm_sock_type, IPPROTO_UDP, &err), "create/2 failed");
+/* PGM/IPv6 */
+	sock = NULL;
+	fail_unless (TRUE == pgm_socket (&sock, AF_INET6, pgm_sock_type, IPPROTO_PGM, &err), "create6/1 failed");
+/* PGM/UDP over IPv6 */
+	sock = NULL;
+	fail_unless (TRUE == pgm_socket (&sock, AF_INET6, pgm_sock_type, IPPROTO_UDP, &err), "create6/2 failed");
+	fail_unless (NULL == err, "error raised");
+}
+END_TEST
+
+/* NULL socket */
+START_TEST (test_create_fail_002)
+{
+	pgm_error_t* err = NULL;
+	fail_unless (FALSE == pgm_socket (NULL, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
+}
+END_TEST
+
+/* invalid protocol family */
+START_TEST (test_create_fail_003)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = NULL;
+	fail_unless (FALSE == pgm_socket (&sock, AF_UNSPEC, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
+}
+END_TEST
+
+/* invalid socket type */
+START_TEST (test_create_fail_004)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = NULL;
+	fail_unless (FALSE == pgm_socket (&sock, AF_INET, SOCK_STREAM, IPPROTO_PGM, &err), "create failed");
+	fail_unless (FALSE == pgm_socket (&sock, AF_INET, SOCK_DGRAM, IPPROTO_PGM, &err), "create failed");
+}
+END_TEST
+
+/* invalid protocol */
+START_TEST (test_create_fail_005)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = NULL;
+	fail_unless (FALSE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_TCP, &err), "create failed");
+}
+END_TEST
+
+
+/* target:
+ *	bool
+ *	pgm_socket_clone (
+ *		pgm_sock_t**		sock,
+ *		pgm_sock_t* const	template_sock,
+ *		pgm_error_t**		error
+ *	)
+ */
+
+static
+pgm_sock_t*
+generate_template (void)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = NULL;
+	const int max_tpdu = 1400;
+	const int txw_sqns = 100;
+	if (!pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_UDP, &err))
+		return NULL;
+	if (!pgm_setsockopt (sock, IPPROTO_PGM, PGM_MTU, &max_tpdu, sizeof(max_tpdu)) ||
+	    !pgm_setsockopt (sock, IPPROTO_PGM, PGM_TXW_SQNS, &txw_sqns, sizeof(txw_sqns)))
+		return NULL;
+	return sock;
+}
+
+/* logged options are applied to the new socket */
+START_TEST (test_socket_clone_pass_001)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* template_sock = generate_template ();
+	fail_if (NULL == template_sock, "generate_template failed");
+	fail_unless (2 == pgm_list_length (template_sock->opt_log), "unexpected template option log");
+	pgm_sock_t* sock = NULL;
+	fail_unless (TRUE == pgm_socket_clone (&sock, template_sock, &err), "socket_clone failed");
+	fail_if (NULL == sock, "no socket returned");
+	fail_unless (NULL == err, "error raised");
+	fail_if (template_sock == sock, "template socket returned");
+	fail_unless (template_sock->family == sock->family, "family not copied");
+	fail_unless (template_sock->protocol == sock->protocol, "protocol not copied");
+	fail_unless (1400 == sock->max_tpdu, "max_tpdu not copied");
+	fail_unless (100 == sock->txw_sqns, "txw_sqns not copied");
+	fail_unless (FALSE == sock->is_bound, "clone is bound");
+	fail_unless (2 == pgm_list_length (sock->opt_log), "unexpected clone option log");
+}
+END_TEST
+
+/* a repeated option replays only the last value, and after bind and session
+ * options are not logged.
+ */
+START_TEST (test_socket_clone_pass_002)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* template_sock = generate_template ();
+	fail_if (NULL == template_sock, "generate_template failed");
+	const int max_tpdu = 1300;
+	fail_unless (TRUE == pgm_setsockopt (template_sock, IPPROTO_PGM, PGM_MTU, &max_tpdu, sizeof(max_tpdu)), "set_mtu failed");
+	fail_unless (2 == pgm_list_length (template_sock->opt_log), "repeated option logged twice");
+	const struct pgm_opt_log_t* entry = pgm_list_last (template_sock->opt_log)->data;
+	fail_unless (PGM_MTU == entry->optname, "repeated option not moved to tail");
+	struct group_req gr;
+	memset (&gr, 0, sizeof(gr));
+	pgm_opt_log_record (template_sock, IPPROTO_PGM, PGM_JOIN_GROUP, &gr, sizeof(gr));
+	fail_unless (2 == pgm_list_length (template_sock->opt_log), "session option logged");
+	pgm_sock_t* sock = NULL;
+	fail_unless (TRUE == pgm_socket_clone (&sock, template_sock, &err), "socket_clone failed");
+	fail_unless (1300 == sock->max_tpdu, "last max_tpdu not copied");
+	const int txw_sqns = 200;
+	sock->is_bound = TRUE;
+	fail_unless (TRUE == pgm_setsockopt (sock, IPPROTO_PGM, PGM_MTU, &max_tpdu, sizeof(max_tpdu)), "set_mtu failed");
+	fail_unless (2 == pgm_list_length (sock->opt_log), "option after bind logged");
+	sock->is_bound = FALSE;
+	fail_unless (TRUE == pgm_setsockopt (template_sock, IPPROTO_PGM, PGM_TXW_SQNS, &txw_sqns, sizeof(txw_sqns)), "set_txw_sqns failed");
+	fail_unless (100 == sock->txw_sqns, "clone shares template configuration");
+}
+END_TEST
+
+START_TEST (test_socket_clone_fail_001)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* template_sock = generate_template ();
+	fail_if (NULL == template_sock, "generate_template failed");
+	pgm_sock_t* sock = NULL;
+	fail_unless (FALSE == pgm_socket_clone (NULL, template_sock, &err), "socket_clone failed");
+	fail_unless (FALSE == pgm_socket_clone (&sock, NULL, &err), "socket_clone failed");
+	fail_unless (NULL == sock, "socket returned");
+}
+END_TEST
+
+/* closed template */
+START_TEST (test_socket_clone_fail_002)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* template_sock = generate_template ();
+	fail_if (NULL == template_sock, "generate_template failed");
+	template_sock->is_destroyed = TRUE;
+	pgm_sock_t* sock = NULL;
+	fail_unless (FALSE == pgm_socket_clone (&sock, template_sock, &err), "socket_clone failed");
+	fail_unless (NULL == sock, "socket returned");
+	fail_if (NULL == err, "error not raised");
+	fail_unless (PGM_ERROR_BADF == err->code, "unexpected error code");
+	pgm_error_free (err);
+}
+END_TEST
+
+/* logged option refused by the new socket */
+START_TEST (test_socket_clone_fail_003)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* template_sock = generate_template ();
+	fail_if (NULL == template_sock, "generate_template failed");
+	const int max_tpdu = 1;
+	pgm_opt_log_record (template_sock, IPPROTO_PGM, PGM_MTU, &max_tpdu, sizeof(max_tpdu));
+	pgm_sock_t* sock = NULL;
+	fail_unless (FALSE == pgm_socket_clone (&sock, template_sock, &err), "socket_clone failed");
+	fail_unless (NULL == sock, "socket returned");
+	fail_if (NULL == err, "error not raised");
+	fail_unless (PGM_ERROR_INVAL == err->code, "unexpected error code");
+	pgm_error_free (err);
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_bind (
+ *		pgm_sock_t*			sock,
+ *		const struct pgm_sockaddr_t*	sockaddr,
+ *		const socklen_t			sockaddrlen,
+ *		pgm_error_t**			error
+ *		)
+ */
+
+START_TEST (test_bind_pass_001)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = NULL;
+	struct pgm_sockaddr_t* pgmsa = generate_asm_sockaddr ();
+	fail_if (NULL == pgmsa, "generate_asm_sockaddr failed");
+	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
+	fail_unless (NULL == err, "error raised");
+	fail_unless (TRUE == pgm_bind (sock, pgmsa, sizeof(*pgmsa), &err), "bind failed");
+}
+END_TEST
+
+/* fail on unset options */
+START_TEST (test_bind_fail_001)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = NULL;
+	struct pgm_sockaddr_t* pgmsa = generate_asm_sockaddr ();
+	fail_if (NULL == pgmsa, "generate_asm_sockaddr failed");
+	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
+	fail_unless (NULL == err, "error raised");
+	fail_unless (FALSE == pgm_bind (sock, pgmsa, sizeof(*pgmsa), &err), "bind failed");
+}
+END_TEST
+
+/* invalid parameters */
+START_TEST (test_bind_fail_002)
+{
+	pgm_error_t* err = NULL;
+	fail_unless (FALSE == pgm_bind (NULL, NULL, 0, &err), "bind failed");
+}
+END_TEST
+
+/* exclusive socket with a standby thread */
+START_TEST (test_bind_fail_003)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = NULL;
+	struct pgm_sockaddr_t* pgmsa = generate_asm_sockaddr ();
+	fail_if (NULL == pgmsa, "generate_asm_sockaddr failed");
+	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
+	fail_unless (NULL == err, "error raised");
+	sock->max_tpdu = 1500;
+	sock->can_send_data = TRUE;
+	sock->is_exclusive = TRUE;
+	sock->standby = g_new0 (struct pgm_standby_t, 1);
+	sock->standby->is_mirror = FALSE;
+	fail_unless (FALSE == pgm_bind (sock, pgmsa, sizeof(*pgmsa), &err), "bind failed");
+	fail_if (NULL == err, "error not raised");
+	fail_if (NULL == strstr (err->message, "Exclusive"), "wrong error raised");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_bind3 (
+ *		pgm_sock_t*				sock,
+ *		const struct pgm_sockaddr_t*		sockaddr,
+ *		const socklen_t				sockaddrlen,
+ *		const struct pgm_interface_req_t*	send_req,
+ *		const socklen_t				send_req_len,
+ *		const struct pgm_interface_req_t*	recv_req,
+ *		const socklen_t				recv_req_len,
+ *		pgm_error_t**				error
+ *		)
+ */
+
+/* fail on unset options */
+START_TEST (test_bind3_fail_001)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = NULL;
+	struct pgm_sockaddr_t* pgmsa = generate_asm_sockaddr ();
+	fail_if (NULL == pgmsa, "generate_asm_sockaddr failed");
+	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
+	fail_unless (NULL == err, "error raised");
+	struct pgm_interface_req_t send_req = { .ir_interface = 0, .ir_scope_id = 0 },
+				   recv_req = { .ir_interface = 0, .ir_scope_id = 0 };
+	fail_unless (FALSE == pgm_bind3 (sock,
+					 pgmsa, sizeof(*pgmsa),
+					 &send_req, sizeof(send_req),
+					 &recv_req, sizeof(recv_req),
+					 &err), "bind failed");
+}
+END_TEST
+
+/* invalid parameters */
+START_TEST (test_bind3_fail_002)
+{
+	pgm_error_t* err = NULL;
+	fail_unless (FALSE == pgm_bind3 (NULL, NULL, 0, NULL, 0, NULL, 0, &err), "bind failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_connect (
+ *		pgm_sock_t*		sock,
+ *		pgm_error_t**		error
+ *		)
+ */
+
+START_TEST (test_connect_pass_001)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = NULL;
+	struct pgm_sockaddr_t* pgmsa = generate_asm_sockaddr ();
+	fail_if (NULL == pgmsa, "generate_asm_sockaddr failed");
+	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
+	fail_unless (NULL == err, "error raised");
+	prebind_socket (sock);
+	fail_unless (TRUE == pgm_bind (sock, pgmsa, sizeof(*pgmsa), &err), "bind failed");
+	preconnect_socket (sock);
+	fail_unless (TRUE == pgm_connect (sock, &err), "connect failed");
+}
+END_TEST
+
+/* invalid parameters */
+START_TEST (test_connect_fail_001)
+{
+	pgm_error_t* err = NULL;
+	fail_unless (FALSE == pgm_connect (NULL, &err), "connect failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_close (
+ *		pgm_sock_t*		sock,
+ *		bool			flush
+ *		)
+ */
+
+/* socket > close */
+START_TEST (test_destroy_pass_001)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = NULL;
+	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
+	fail_unless (TRUE == pgm_close (sock, FALSE), "destroy failed");
+}
+END_TEST
+
+/* socket > bind > close */
+START_TEST (test_destroy_pass_002)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = NULL;
+	struct pgm_sockaddr_t* pgmsa = generate_asm_sockaddr ();
+	fail_if (NULL == pgmsa, "generate_asm_sockaddr failed");
+	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
+	fail_unless (NULL == err, "error raised");
+	fail_unless (TRUE == pgm_bind (sock, pgmsa, sizeof(*pgmsa), &err), "bind failed");
+	fail_unless (TRUE == pgm_close (sock, FALSE), "destroy failed");
+}
+END_TEST
+
+/* socket > bind > connect > close */
+START_TEST (test_destroy_pass_003)
+{
+	pgm_error_t* err = NULL;
+	pgm_sock_t* sock = NULL;
+	struct pgm_sockaddr_t* pgmsa = generate_asm_sockaddr ();
+	fail_if (NULL == pgmsa, "generate_asm_sockaddr failed");
+	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
+	fail_unless (NULL == err, "error raised");
+	fail_unless (TRUE == pgm_bind (sock, pgmsa, sizeof(*pgmsa), &err), "bind failed");
+	fail_unless (TRUE == pgm_connect (sock, &err), "connect failed");
+	fail_unless (TRUE == pgm_close (sock, FALSE), "destroy failed");
+}
+END_TEST
+
+/* invalid parameters */
+START_TEST (test_destroy_fail_001)
+{
+	fail_unless (FALSE == pgm_close (NULL, FALSE), "destroy failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_MAX_TPDU,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *		)
+ */
+
+START_TEST (test_set_max_tpdu_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_MTU;
+	const int max_tpdu	= 1500;
+	const void* optval	= &max_tpdu;
+	const socklen_t optlen	= sizeof(max_tpdu);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_max_tpdu failed");
+}
+END_TEST
+
+/* invalid parameters */
+START_TEST (test_set_max_tpdu_fail_001)
+{
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_MTU;
+	const int max_tpdu	= 1500;
+	const void* optval	= &max_tpdu;
+	const socklen_t optlen	= sizeof(max_tpdu);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_max_tpdu failed");
+}
+END_TEST
+
+/* too small */
+START_TEST (test_set_max_tpdu_fail_002)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_MTU;
+	const int max_tpdu	= 1;
+	const void* optval	= &max_tpdu;
+	const socklen_t optlen	= sizeof(max_tpdu);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_max_tpdu failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_MULTICAST_LOOP,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *		)
+ */
+
+START_TEST (test_set_multicast_loop_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_MULTICAST_LOOP;
+	const int loop_enabled	= 1;
+	const void* optval	= &loop_enabled;
+	const socklen_t optlen	= sizeof(loop_enabled);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_multicast_loop failed");
+}
+END_TEST
+
+START_TEST (test_set_multicast_loop_fail_001)
+{
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_MULTICAST_LOOP;
+	const int loop_enabled	= 1;
+	const void* optval	= &loop_enabled;
+	const socklen_t optlen	= sizeof(loop_enabled);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_multicast_loop failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_MULTICAST_HOPS,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_hops_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_MULTICAST_HOPS;
+	const int hops		= 16;
+	const void* optval	= &hops;
+	const socklen_t optlen	= sizeof(hops);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_hops failed");
+}
+END_TEST
+
+START_TEST (test_set_hops_fail_001)
+{
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_MULTICAST_HOPS;
+	const int hops		= 16;
+	const void* optval	= &hops;
+	const socklen_t optlen	= sizeof(hops);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_hops failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = SOL_SOCKET,
+ *		const int		optname = SO_SNDBUF,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_sndbuf_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= SOL_SOCKET;
+	const int optname	= SO_SNDBUF;
+	const int bufsize	= 131071;	/* 128kB */
+	const void* optval	= &bufsize;
+	const socklen_t optlen	= sizeof(bufsize);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_sndbuf failed");
+}
+END_TEST
+
+START_TEST (test_set_sndbuf_fail_001)
+{
+	const int level		= SOL_SOCKET;
+	const int optname	= SO_SNDBUF;
+	const int bufsize	= 131071;	/* 128kB */
+	const void* optval	= &bufsize;
+	const socklen_t optlen	= sizeof(bufsize);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_sndbuf failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = SOL_SOCKET,
+ *		const int		optname = PGM_RCVBUF,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_rcvbuf_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= SOL_SOCKET;
+	const int optname	= SO_RCVBUF;
+	const int bufsize	= 131071;	/* 128kB */
+	const void* optval	= &bufsize;
+	const socklen_t optlen	= sizeof(bufsize);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rcvbuf failed");
+}
+END_TEST
+
+START_TEST (test_set_rcvbuf_fail_001)
+{
+	const int level		= SOL_SOCKET;
+	const int optname	= SO_RCVBUF;
+	const int bufsize	= 131071;	/* 128kB */
+	const void* optval	= &bufsize;
+	const socklen_t optlen	= sizeof(bufsize);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_rcvbuf failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_USE_FEC,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(struct pgm_fecinfo_t)
+ *	)
+ */
+
+START_TEST (test_set_fec_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_USE_FEC;
+	const struct pgm_fecinfo_t fecinfo = {
+		.ondemand_parity_enabled	= TRUE,
+		.proactive_packets		= 16,
+		.var_pktlen_enabled		= TRUE,
+		.block_size			= 255,
+		.group_size			= 64
+	};
+	const void* optval	= &fecinfo;
+	const socklen_t optlen	= sizeof(fecinfo);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_fec failed");
+}
+END_TEST
+
+START_TEST (test_set_fec_fail_001)
+{
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_USE_FEC;
+	const struct pgm_fecinfo_t fecinfo = {
+		.ondemand_parity_enabled	= TRUE,
+		.proactive_packets		= 16,
+		.var_pktlen_enabled		= TRUE,
+		.block_size			= 255,
+		.group_size			= 64
+	};
+	const void* optval	= &fecinfo;
+	const socklen_t optlen	= sizeof(fecinfo);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_fec failed");
+}
+END_TEST
+
+/* TODO: invalid Reed-Solomon parameters
+ */
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_ADAPTIVE_FEC,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(struct pgm_adaptivefecinfo_t)
+ *	)
+ */
+
+START_TEST (test_set_adaptive_fec_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const struct pgm_fecinfo_t fecinfo = {
+		.ondemand_parity_enabled	= TRUE,
+		.proactive_packets		= 0,
+		.var_pktlen_enabled		= FALSE,
+		.block_size			= 255,
+		.group_size			= 64
+	};
+	fail_unless (TRUE == pgm_setsockopt (sock, level, PGM_USE_FEC, &fecinfo, sizeof(fecinfo)), "set_fec failed");
+	const struct pgm_adaptivefecinfo_t adaptivefecinfo = {
+		.min_proactive_packets		= 1,
+		.max_proactive_packets		= 16
+	};
+	fail_unless (TRUE == pgm_setsockopt (sock, level, PGM_ADAPTIVE_FEC, &adaptivefecinfo, sizeof(adaptivefecinfo)), "set_adaptive_fec failed");
+	fail_unless (TRUE == sock->use_proactive_parity, "use_proactive_parity");
+	fail_unless (1 == sock->rs_proactive_h, "rs_proactive_h");
+}
+END_TEST
+
+/* without PGM_USE_FEC, and bounds exceeding parity packets per block */
+START_TEST (test_set_adaptive_fec_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const struct pgm_adaptivefecinfo_t adaptivefecinfo = {
+		.min_proactive_packets		= 1,
+		.max_proactive_packets		= 16
+	};
+	fail_unless (FALSE == pgm_setsockopt (sock, level, PGM_ADAPTIVE_FEC, &adaptivefecinfo, sizeof(adaptivefecinfo)), "set_adaptive_fec failed");
+	const struct pgm_fecinfo_t fecinfo = {
+		.ondemand_parity_enabled	= TRUE,
+		.proactive_packets		= 0,
+		.var_pktlen_enabled		= FALSE,
+		.block_size			= 72,
+		.group_size			= 64
+	};
+	fail_unless (TRUE == pgm_setsockopt (sock, level, PGM_USE_FEC, &fecinfo, sizeof(fecinfo)), "set_fec failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, PGM_ADAPTIVE_FEC, &adaptivefecinfo, sizeof(adaptivefecinfo)), "set_adaptive_fec failed");
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, PGM_ADAPTIVE_FEC, &adaptivefecinfo, sizeof(adaptivefecinfo)), "set_adaptive_fec failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_USE_PGMCC,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(struct pgm_pgmccinfo_t)
+ *	)
+ */
+
+START_TEST (test_set_pgmcc_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_USE_PGMCC;
+	const struct pgm_pgmccinfo_t pgmccinfo = {
+		.ack_bo_ivl	= pgm_msecs(100),
+		.ack_c		= 123,
+		.ack_c_p	= 456
+	};
+	const void* optval	= &pgmccinfo;
+	const socklen_t optlen	= sizeof(pgmccinfo);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_pgmcc failed");
+}
+END_TEST
+
+START_TEST (test_set_pgmcc_fail_001)
+{
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_USE_PGMCC;
+	const struct pgm_pgmccinfo_t pgmccinfo = {
+		.ack_bo_ivl	= pgm_msecs(100),
+		.ack_c		= 123,
+		.ack_c_p	= 456
+	};
+	const void* optval	= &pgmccinfo;
+	const socklen_t optlen	= sizeof(pgmccinfo);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_pgmcc failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_USE_CR,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_cr_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_USE_CR;
+	const int magic_bunny	= 1;
+	const void* optval	= &magic_bunny;
+	const socklen_t optlen	= sizeof(magic_bunny);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_cr failed");
+}
+END_TEST
+
+START_TEST (test_set_cr_fail_001)
+{
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_USE_CR;
+	const int magic_bunny	= 1;
+	const void* optval	= &magic_bunny;
+	const socklen_t optlen	= sizeof(magic_bunny);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_cr failed");
+}
+END_TEST
+
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_SEND_ONLY,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_send_only_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_SEND_ONLY;
+	const int send_only	= 1;
+	const void* optval	= &send_only;
+	const socklen_t optlen	= sizeof(send_only);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_send_only failed");
+}
+END_TEST
+
+START_TEST (test_set_send_only_fail_001)
+{
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_SEND_ONLY;
+	const int send_only	= 1;
+	const void* optval	= &send_only;
+	const socklen_t optlen	= sizeof(send_only);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_send_only failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_RECV_ONLY,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_recv_only_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RECV_ONLY;
+	const int recv_only	= 1;
+	const void* optval	= &recv_only;
+	const socklen_t optlen	= sizeof(recv_only);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_recv_only failed");
+}
+END_TEST
+
+START_TEST (test_set_recv_only_fail_001)
+{
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RECV_ONLY;
+	const int recv_only	= 1;
+	const void* optval	= &recv_only;
+	const socklen_t optlen	= sizeof(recv_only);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_recv_only failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_PASSIVE,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_recv_only_pass_002)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_PASSIVE;
+	const int passive	= 1;
+	const void* optval	= &passive;
+	const socklen_t optlen	= sizeof(passive);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_passive failed");
+}
+END_TEST
+
+START_TEST (test_set_recv_only_fail_002)
+{
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_PASSIVE;
+	const int passive	= 1;
+	const void* optval	= &passive;
+	const socklen_t optlen	= sizeof(passive);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_passive failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_ABORT_ON_RESET,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_abort_on_reset_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_ABORT_ON_RESET;
+	const int abort_on_reset= 1;
+	const void* optval	= &abort_on_reset;
+	const socklen_t optlen	= sizeof(abort_on_reset);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_abort_on_reset failed");
+}
+END_TEST
+
+START_TEST (test_set_abort_on_reset_fail_001)
+{
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_ABORT_ON_RESET;
+	const int abort_on_reset= 1;
+	const void* optval	= &abort_on_reset;
+	const socklen_t optlen	= sizeof(abort_on_reset);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_abort_on_reset failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_NOBLOCK,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_noblock_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_NOBLOCK;
+	const int noblock       = 1;
+	const void* optval	= &noblock;
+	const socklen_t optlen	= sizeof(noblock);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_noblock failed");
+}
+END_TEST
+
+START_TEST (test_set_noblock_fail_001)
+{
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_NOBLOCK;
+	const int noblock       = 1;
+	const void* optval	= &noblock;
+	const socklen_t optlen	= sizeof(noblock);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_noblock failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_UDP_ENCAP_UCAST_PORT,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_udp_unicast_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_NOBLOCK;
+	const int unicast_port  = 10001;
+	const void* optval	= &unicast_port;
+	const socklen_t optlen	= sizeof(unicast_port);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_udp_unicast failed");
+}
+END_TEST
+
+START_TEST (test_set_udp_unicast_fail_001)
+{
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_NOBLOCK;
+	const int unicast_port  = 10001;
+	const void* optval	= &unicast_port;
+	const socklen_t optlen	= sizeof(unicast_port);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_udp_unicast failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_UDP_ENCAP_MCAST_PORT,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_udp_multicast_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_NOBLOCK;
+	const int multicast_port= 10001;
+	const void* optval	= &multicast_port;
+	const socklen_t optlen	= sizeof(multicast_port);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_udp_multicast failed");
+}
+END_TEST
+
+START_TEST (test_set_udp_multicast_fail_001)
+{
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_NOBLOCK;
+	const int multicast_port= 10002;
+	const void* optval	= &multicast_port;
+	const socklen_t optlen	= sizeof(multicast_port);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_udp_multicast failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_RECV_BATCH,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_recv_batch_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RECV_BATCH;
+	const int batch_size	= 32;
+	const void* optval	= &batch_size;
+	const socklen_t optlen	= sizeof(batch_size);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_recv_batch failed");
+}
+END_TEST
+
+/* invalid batch sizes */
+START_TEST (test_set_recv_batch_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RECV_BATCH;
+	const int batch_size	= 32;
+	const void* optval	= &batch_size;
+	const socklen_t optlen	= sizeof(batch_size);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_recv_batch failed");
+	const int zero_size	= 0;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, &zero_size, sizeof(zero_size)), "set_recv_batch failed");
+	const int huge_size	= PGM_RECV_BATCH_MAX + 1;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, &huge_size, sizeof(huge_size)), "set_recv_batch failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_SEND_BATCH,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_send_batch_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_SEND_BATCH;
+	const int batch_size	= 32;
+	const void* optval	= &batch_size;
+	const socklen_t optlen	= sizeof(batch_size);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_send_batch failed");
+}
+END_TEST
+
+/* invalid batch sizes */
+START_TEST (test_set_send_batch_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_SEND_BATCH;
+	const int batch_size	= 32;
+	const void* optval	= &batch_size;
+	const socklen_t optlen	= sizeof(batch_size);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_send_batch failed");
+	const int zero_size	= 0;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, &zero_size, sizeof(zero_size)), "set_send_batch failed");
+	const int huge_size	= PGM_SEND_BATCH_MAX + 1;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, &huge_size, sizeof(huge_size)), "set_send_batch failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_SKB_POOL,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_skb_pool_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_SKB_POOL;
+	const int pool_size	= 256;
+	const void* optval	= &pool_size;
+	const socklen_t optlen	= sizeof(pool_size);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_skb_pool failed");
+	const int zero_size	= 0;
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, &zero_size, sizeof(zero_size)), "set_skb_pool failed");
+}
+END_TEST
+
+/* invalid pool size */
+START_TEST (test_set_skb_pool_fail_001)
 {
-	return 0x1;
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_SKB_POOL;
+	const int pool_size	= 256;
+	const void* optval	= &pool_size;
+	const socklen_t optlen	= sizeof(pool_size);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_skb_pool failed");
+	const int negative_size	= -1;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, &negative_size, sizeof(negative_size)), "set_skb_pool failed");
 }
+END_TEST
 
-PGM_GNUC_INTERNAL
-int
-pgm_get_nprocs (void)
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_UDP_GSO,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_udp_gso_pass_001)
 {
-	return 1;
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->protocol = IPPROTO_UDP;
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_UDP_GSO;
+	const int use_gso	= 1;
+	const void* optval	= &use_gso;
+	const socklen_t optlen	= sizeof(use_gso);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_udp_gso failed");
 }
+END_TEST
 
-/* mock functions for external references */
+/* requires UDP encapsulation */
+START_TEST (test_set_udp_gso_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_UDP_GSO;
+	const int use_gso	= 1;
+	const void* optval	= &use_gso;
+	const socklen_t optlen	= sizeof(use_gso);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_udp_gso failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_udp_gso failed");
+}
+END_TEST
+
+START_TEST (test_set_udp_gro_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->protocol = IPPROTO_UDP;
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_UDP_GRO;
+	const int use_gro	= 1;
+	const void* optval	= &use_gro;
+	const socklen_t optlen	= sizeof(use_gro);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_udp_gro failed");
+}
+END_TEST
+
+/* requires UDP encapsulation and unbound socket */
+START_TEST (test_set_udp_gro_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_UDP_GRO;
+	const int use_gro	= 1;
+	const void* optval	= &use_gro;
+	const socklen_t optlen	= sizeof(use_gro);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_udp_gro failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_udp_gro failed");
+	sock->protocol = IPPROTO_UDP;
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_udp_gro failed");
+}
+END_TEST
+
+START_TEST (test_set_zero_checksum_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->protocol = IPPROTO_UDP;
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_UDP_ENCAP_ZERO_CHECKSUM;
+	const int use_zero	= 1;
+	const void* optval	= &use_zero;
+	const socklen_t optlen	= sizeof(use_zero);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_zero_checksum failed");
+	fail_unless (TRUE == sock->use_zero_checksum, "use_zero_checksum");
+}
+END_TEST
+
+/* requires UDP encapsulation and unbound socket */
+START_TEST (test_set_zero_checksum_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_UDP_ENCAP_ZERO_CHECKSUM;
+	const int use_zero	= 1;
+	const void* optval	= &use_zero;
+	const socklen_t optlen	= sizeof(use_zero);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_zero_checksum failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_zero_checksum failed");
+	sock->protocol = IPPROTO_UDP;
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_zero_checksum failed");
+}
+END_TEST
+
+START_TEST (test_set_crc32c_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_CRC32C;
+	const int use_crc32c	= 1;
+	const void* optval	= &use_crc32c;
+	const socklen_t optlen	= sizeof(use_crc32c);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_crc32c failed");
+	fail_unless (TRUE == sock->use_crc32c, "use_crc32c");
+}
+END_TEST
+
+/* requires unbound socket */
+START_TEST (test_set_crc32c_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_CRC32C;
+	const int use_crc32c	= 1;
+	const void* optval	= &use_crc32c;
+	const socklen_t optlen	= sizeof(use_crc32c);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_crc32c failed");
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_crc32c failed");
+}
+END_TEST
+
+START_TEST (test_set_xdp_filter_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_XDP_FILTER;
+	const int use_filter	= 1;
+	const void* optval	= &use_filter;
+	const socklen_t optlen	= sizeof(use_filter);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_xdp_filter failed");
+	fail_unless (TRUE == sock->use_xdp_filter, "use_xdp_filter");
+}
+END_TEST
+
+/* requires unbound socket */
+START_TEST (test_set_xdp_filter_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_XDP_FILTER;
+	const int use_filter	= 1;
+	const void* optval	= &use_filter;
+	const socklen_t optlen	= sizeof(use_filter);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_xdp_filter failed");
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_xdp_filter failed");
+}
+END_TEST
+
+START_TEST (test_set_prewarm_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_PREWARM;
+	const int peers		= 32;
+	const void* optval	= &peers;
+	const socklen_t optlen	= sizeof(peers);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_prewarm failed");
+	fail_unless (32 == sock->prewarm_peers, "prewarm_peers");
+}
+END_TEST
 
+/* requires unbound socket and a non-negative count */
+START_TEST (test_set_prewarm_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_PREWARM;
+	int peers		= -1;
+	const void* optval	= &peers;
+	const socklen_t optlen	= sizeof(peers);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_prewarm failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_prewarm failed");
+	peers = 32;
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_prewarm failed");
+}
+END_TEST
 
 /* target:
  *	bool
- *	pgm_socket (
- *		pgm_sock_t**		sock,
- *		const sa_family_t	family,
- *		const int		pgm_sock_type,
- *		const int		protocol,
- *		pgm_error_t**		error
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_RECV_SHARDS,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
  *	)
  */
 
-START_TEST (test_create_pass_001)
+START_TEST (test_set_recv_shards_pass_001)
 {
-	pgm_error_t* err = NULL;
-	pgm_sock_t* sock;
-/* only one type currently implemented */
-	const int pgm_sock_type = SOCK_SEQPACKET;
-/* PGM/IPv4 */
-	sock = NULL;
-	fail_unless (TRUE == pgm_socket (&sock, AF_INET, pgm_sock_type, IPPROTO_PGM, &err), "create/1 failed");
-/* PGM/UDP over IPv4 */
-	sock = NULL;
-	fail_unless (TRUE == pgm_socket (&sock, AF_INET, pgm_sock_type, IPPROTO_UDP, &err), "create/2 failed");
-/* PGM/IPv6 */
-	sock = NULL;
-	fail_unless (TRUE == pgm_socket (&sock, AF_INET6, pgm_sock_type, IPPROTO_PGM, &err), "create6/1 failed");
-/* PGM/UDP over IPv6 */
-	sock = NULL;
-	fail_unless (TRUE == pgm_socket (&sock, AF_INET6, pgm_sock_type, IPPROTO_UDP, &err), "create6/2 failed");
-	fail_unless (NULL == err, "error raised");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->protocol = IPPROTO_UDP;
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RECV_SHARDS;
+	const int shards	= 4;
+	const void* optval	= &shards;
+	const socklen_t optlen	= sizeof(shards);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_recv_shards failed");
+	fail_unless (4 == sock->recv_shards, "recv_shards");
 }
 END_TEST
 
-/* NULL socket */
-START_TEST (test_create_fail_002)
+/* requires UDP encapsulation, unbound socket without groups, and bounded count */
+START_TEST (test_set_recv_shards_fail_001)
 {
-	pgm_error_t* err = NULL;
-	fail_unless (FALSE == pgm_socket (NULL, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RECV_SHARDS;
+	int shards		= 4;
+	const void* optval	= &shards;
+	const socklen_t optlen	= sizeof(shards);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_recv_shards failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_recv_shards failed");
+	sock->protocol = IPPROTO_UDP;
+	shards = 0;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_recv_shards failed");
+	shards = PGM_RECV_SHARDS_MAX + 1;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_recv_shards failed");
+	shards = 4;
+	sock->recv_gsr_len = 1;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_recv_shards failed");
+	sock->recv_gsr_len = 0;
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_recv_shards failed");
+	fail_unless (1 == sock->recv_shards, "recv_shards");
 }
 END_TEST
 
-/* invalid protocol family */
-START_TEST (test_create_fail_003)
+START_TEST (test_set_xdp_pass_001)
 {
-	pgm_error_t* err = NULL;
-	pgm_sock_t* sock = NULL;
-	fail_unless (FALSE == pgm_socket (&sock, AF_UNSPEC, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_XDP;
+	const struct pgm_xdpinfo_t xdpinfo = {
+		.queue_id	= 0,
+		.xskmap_fd	= 3
+	};
+	const void* optval	= &xdpinfo;
+	const socklen_t optlen	= sizeof(xdpinfo);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_xdp failed");
+}
+END_TEST
+
+/* must be set before bind */
+START_TEST (test_set_xdp_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_XDP;
+	const struct pgm_xdpinfo_t xdpinfo = {
+		.queue_id	= 0,
+		.xskmap_fd	= 3
+	};
+	const void* optval	= &xdpinfo;
+	const socklen_t optlen	= sizeof(xdpinfo);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_xdp failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, sizeof(int)), "set_xdp failed");
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_xdp failed");
+}
+END_TEST
+
+START_TEST (test_set_io_uring_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_IO_URING;
+	const int entries	= 256;
+	const void* optval	= &entries;
+	const socklen_t optlen	= sizeof(entries);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_io_uring failed");
+}
+END_TEST
+
+/* power of two, must be set before bind */
+START_TEST (test_set_io_uring_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_IO_URING;
+	int entries		= 100;
+	const void* optval	= &entries;
+	const socklen_t optlen	= sizeof(entries);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_io_uring failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_io_uring failed");
+	entries = 2 * PGM_URING_ENTRIES_MAX;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_io_uring failed");
+	entries = 256;
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_io_uring failed");
+}
+END_TEST
+
+START_TEST (test_set_rio_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RIO;
+	const int entries	= 256;
+	const void* optval	= &entries;
+	const socklen_t optlen	= sizeof(entries);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rio failed");
+}
+END_TEST
+
+/* power of two, must be set before bind */
+START_TEST (test_set_rio_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RIO;
+	int entries		= 100;
+	const void* optval	= &entries;
+	const socklen_t optlen	= sizeof(entries);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_rio failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rio failed");
+	entries = 2 * PGM_RIO_ENTRIES_MAX;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rio failed");
+	entries = 256;
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rio failed");
+}
+END_TEST
+
+START_TEST (test_set_rio_iocp_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RIO_IOCP;
+	int port;
+	const struct pgm_iocpinfo_t iocpinfo = { .port = &port, .key = 1 };
+	const void* optval	= &iocpinfo;
+	const socklen_t optlen	= sizeof(iocpinfo);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rio_iocp failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, sizeof(int)), "set_rio_iocp failed");
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rio_iocp failed");
+}
+END_TEST
+
+START_TEST (test_set_dpdk_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_DPDK;
+	const struct pgm_dpdkinfo_t dpdkinfo = { .port_id = 0, .queue_id = 1 };
+	const void* optval	= &dpdkinfo;
+	const socklen_t optlen	= sizeof(dpdkinfo);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_dpdk failed");
+	fail_unless (0 == sock->dpdk_port_id, "dpdk_port_id not set");
+	fail_unless (1 == sock->dpdk_queue_id, "dpdk_queue_id not set");
+}
+END_TEST
+
+START_TEST (test_set_dpdk_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_DPDK;
+	const struct pgm_dpdkinfo_t dpdkinfo = { .port_id = 0, .queue_id = 0 };
+	const void* optval	= &dpdkinfo;
+	const socklen_t optlen	= sizeof(dpdkinfo);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_dpdk failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, sizeof(int)), "set_dpdk failed");
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_dpdk failed");
+}
+END_TEST
+
+START_TEST (test_set_busy_poll_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_BUSY_POLL;
+	const int usecs		= 50;
+	const void* optval	= &usecs;
+	const socklen_t optlen	= sizeof(usecs);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_busy_poll failed");
+}
+END_TEST
+
+/* must be set before bind */
+START_TEST (test_set_busy_poll_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_BUSY_POLL;
+	int usecs		= -1;
+	const void* optval	= &usecs;
+	const socklen_t optlen	= sizeof(usecs);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_busy_poll failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_busy_poll failed");
+	usecs = 50;
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_busy_poll failed");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_RDATA_THREAD,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_rdata_thread_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RDATA_THREAD;
+	const int enabled	= 1;
+	const void* optval	= &enabled;
+	const socklen_t optlen	= sizeof(enabled);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rdata_thread failed");
+	fail_unless (TRUE == sock->use_rdata_thread, "use_rdata_thread not set");
+}
+END_TEST
+
+/* must be set before bind */
+START_TEST (test_set_rdata_thread_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RDATA_THREAD;
+	const int enabled	= 1;
+	const void* optval	= &enabled;
+	const socklen_t optlen	= sizeof(enabled);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_rdata_thread failed");
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rdata_thread failed");
 }
 END_TEST
 
-/* invalid socket type */
-START_TEST (test_create_fail_004)
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_EXCLUSIVE,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_exclusive_pass_001)
 {
-	pgm_error_t* err = NULL;
-	pgm_sock_t* sock = NULL;
-	fail_unless (FALSE == pgm_socket (&sock, AF_INET, SOCK_STREAM, IPPROTO_PGM, &err), "create failed");
-	fail_unless (FALSE == pgm_socket (&sock, AF_INET, SOCK_DGRAM, IPPROTO_PGM, &err), "create failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_EXCLUSIVE;
+	const int enabled	= 1;
+	const void* optval	= &enabled;
+	const socklen_t optlen	= sizeof(enabled);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_exclusive failed");
+	fail_unless (TRUE == sock->is_exclusive, "is_exclusive not set");
+	int value = 0;
+	socklen_t valuelen = sizeof(value);
+	fail_unless (TRUE == pgm_getsockopt (sock, level, optname, &value, &valuelen), "get_exclusive failed");
+	fail_unless (1 == value, "get_exclusive value failed");
 }
 END_TEST
 
-/* invalid protocol */
-START_TEST (test_create_fail_005)
+/* must be set before bind */
+START_TEST (test_set_exclusive_fail_001)
 {
-	pgm_error_t* err = NULL;
-	pgm_sock_t* sock = NULL;
-	fail_unless (FALSE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_TCP, &err), "create failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_EXCLUSIVE;
+	const int enabled	= 1;
+	const void* optval	= &enabled;
+	const socklen_t optlen	= sizeof(enabled);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_exclusive failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen - 1), "set_exclusive failed");
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_exclusive failed");
+	fail_unless (FALSE == sock->is_exclusive, "is_exclusive set");
 }
 END_TEST
 
-
 /* target:
  *	bool
- *	pgm_bind (
- *		pgm_sock_t*			sock,
- *		const struct pgm_sockaddr_t*	sockaddr,
- *		const socklen_t			sockaddrlen,
- *		pgm_error_t**			error
- *		)
+ *	pgm_sock_reader_trylock (
+ *		pgm_sock_t* const	sock
+ *	)
  */
 
-START_TEST (test_bind_pass_001)
+/* exclusive socket skips the reader lock held against pgm_close() */
+START_TEST (test_exclusive_pass_001)
 {
-	pgm_error_t* err = NULL;
-	pgm_sock_t* sock = NULL;
-	struct pgm_sockaddr_t* pgmsa = generate_asm_sockaddr ();
-	fail_if (NULL == pgmsa, "generate_asm_sockaddr failed");
-	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
-	fail_unless (NULL == err, "error raised");
-	fail_unless (TRUE == pgm_bind (sock, pgmsa, sizeof(*pgmsa), &err), "bind failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	pgm_rwlock_writer_lock (&sock->lock);
+	fail_unless (FALSE == pgm_sock_reader_trylock (sock), "reader_trylock failed");
+	sock->is_exclusive = TRUE;
+	fail_unless (TRUE == pgm_sock_reader_trylock (sock), "reader_trylock failed");
+	pgm_sock_reader_unlock (sock);
+	pgm_rwlock_writer_unlock (&sock->lock);
 }
 END_TEST
 
-/* fail on unset options */
-START_TEST (test_bind_fail_001)
+/* exclusive socket with a repair thread */
+START_TEST (test_exclusive_fail_001)
 {
 	pgm_error_t* err = NULL;
 	pgm_sock_t* sock = NULL;
@@ -452,141 +2900,218 @@ START_TEST (test_bind_fail_001)
 	fail_if (NULL == pgmsa, "generate_asm_sockaddr failed");
 	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
 	fail_unless (NULL == err, "error raised");
+	sock->max_tpdu = 1500;
+	sock->can_send_data = TRUE;
+	sock->is_exclusive = TRUE;
+	sock->use_rdata_thread = TRUE;
 	fail_unless (FALSE == pgm_bind (sock, pgmsa, sizeof(*pgmsa), &err), "bind failed");
+	fail_if (NULL == err, "error not raised");
+	fail_if (NULL == strstr (err->message, "Exclusive"), "wrong error raised");
 }
 END_TEST
 
-/* invalid parameters */
-START_TEST (test_bind_fail_002)
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_RXW_MIN_SQNS,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_rxw_min_sqns_pass_001)
 {
-	pgm_error_t* err = NULL;
-	fail_unless (FALSE == pgm_bind (NULL, NULL, 0, &err), "bind failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RXW_MIN_SQNS;
+	const int rxw_min_sqns	= 64;
+	const void* optval	= &rxw_min_sqns;
+	const socklen_t optlen	= sizeof(rxw_min_sqns);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rxw_min_sqns failed");
+	fail_unless (64 == sock->rxw_min_sqns, "rxw_min_sqns not set");
+}
+END_TEST
+
+START_TEST (test_set_rxw_min_sqns_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RXW_MIN_SQNS;
+	const int rxw_min_sqns	= -1;
+	const void* optval	= &rxw_min_sqns;
+	const socklen_t optlen	= sizeof(rxw_min_sqns);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_rxw_min_sqns failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rxw_min_sqns failed");
 }
 END_TEST
 
 /* target:
  *	bool
- *	pgm_bind3 (
- *		pgm_sock_t*				sock,
- *		const struct pgm_sockaddr_t*		sockaddr,
- *		const socklen_t				sockaddrlen,
- *		const struct pgm_interface_req_t*	send_req,
- *		const socklen_t				send_req_len,
- *		const struct pgm_interface_req_t*	recv_req,
- *		const socklen_t				recv_req_len,
- *		pgm_error_t**				error
- *		)
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_RXW_SHRINK,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
  */
 
-/* fail on unset options */
-START_TEST (test_bind3_fail_001)
+START_TEST (test_set_rxw_shrink_pass_001)
 {
-	pgm_error_t* err = NULL;
-	pgm_sock_t* sock = NULL;
-	struct pgm_sockaddr_t* pgmsa = generate_asm_sockaddr ();
-	fail_if (NULL == pgmsa, "generate_asm_sockaddr failed");
-	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
-	fail_unless (NULL == err, "error raised");
-	struct pgm_interface_req_t send_req = { .ir_interface = 0, .ir_scope_id = 0 },
-				   recv_req = { .ir_interface = 0, .ir_scope_id = 0 };
-	fail_unless (FALSE == pgm_bind3 (sock,
-					 pgmsa, sizeof(*pgmsa),
-					 &send_req, sizeof(send_req),
-					 &recv_req, sizeof(recv_req),
-					 &err), "bind failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RXW_SHRINK;
+	const int enabled	= 1;
+	const void* optval	= &enabled;
+	const socklen_t optlen	= sizeof(enabled);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rxw_shrink failed");
+	fail_unless (TRUE == sock->use_rxw_shrink, "use_rxw_shrink not set");
 }
 END_TEST
 
-/* invalid parameters */
-START_TEST (test_bind3_fail_002)
+/* must be set before bind */
+START_TEST (test_set_rxw_shrink_fail_001)
 {
-	pgm_error_t* err = NULL;
-	fail_unless (FALSE == pgm_bind3 (NULL, NULL, 0, NULL, 0, NULL, 0, &err), "bind failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RXW_SHRINK;
+	const int enabled	= 1;
+	const void* optval	= &enabled;
+	const socklen_t optlen	= sizeof(enabled);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_rxw_shrink failed");
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rxw_shrink failed");
 }
 END_TEST
 
 /* target:
  *	bool
- *	pgm_connect (
- *		pgm_sock_t*		sock,
- *		pgm_error_t**		error
- *		)
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_TXW_SLOTS,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
  */
 
-START_TEST (test_connect_pass_001)
+START_TEST (test_set_txw_slots_pass_001)
 {
-	pgm_error_t* err = NULL;
-	pgm_sock_t* sock = NULL;
-	struct pgm_sockaddr_t* pgmsa = generate_asm_sockaddr ();
-	fail_if (NULL == pgmsa, "generate_asm_sockaddr failed");
-	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
-	fail_unless (NULL == err, "error raised");
-	prebind_socket (sock);
-	fail_unless (TRUE == pgm_bind (sock, pgmsa, sizeof(*pgmsa), &err), "bind failed");
-	preconnect_socket (sock);
-	fail_unless (TRUE == pgm_connect (sock, &err), "connect failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_TXW_SLOTS;
+	const int enabled	= 1;
+	const void* optval	= &enabled;
+	const socklen_t optlen	= sizeof(enabled);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_txw_slots failed");
+	fail_unless (TRUE == sock->use_txw_slots, "use_txw_slots not set");
 }
 END_TEST
 
-/* invalid parameters */
-START_TEST (test_connect_fail_001)
+/* must be set before bind */
+START_TEST (test_set_txw_slots_fail_001)
 {
-	pgm_error_t* err = NULL;
-	fail_unless (FALSE == pgm_connect (NULL, &err), "connect failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_TXW_SLOTS;
+	const int enabled	= 1;
+	const void* optval	= &enabled;
+	const socklen_t optlen	= sizeof(enabled);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_txw_slots failed");
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_txw_slots failed");
 }
 END_TEST
 
 /* target:
  *	bool
- *	pgm_close (
- *		pgm_sock_t*		sock,
- *		bool			flush
- *		)
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_HUGETLB,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
  */
 
-/* socket > close */
-START_TEST (test_destroy_pass_001)
+START_TEST (test_set_hugetlb_pass_001)
 {
-	pgm_error_t* err = NULL;
-	pgm_sock_t* sock = NULL;
-	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
-	fail_unless (TRUE == pgm_close (sock, FALSE), "destroy failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_HUGETLB;
+	const int page_size	= PGM_HUGEPAGE_2MB;
+	const void* optval	= &page_size;
+	const socklen_t optlen	= sizeof(page_size);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_hugetlb failed");
+	fail_unless (PGM_HUGEPAGE_2MB == sock->hugetlb_size, "hugetlb_size not set");
 }
 END_TEST
 
-/* socket > bind > close */
-START_TEST (test_destroy_pass_002)
+/* unsupported page size, or after bind */
+START_TEST (test_set_hugetlb_fail_001)
 {
-	pgm_error_t* err = NULL;
-	pgm_sock_t* sock = NULL;
-	struct pgm_sockaddr_t* pgmsa = generate_asm_sockaddr ();
-	fail_if (NULL == pgmsa, "generate_asm_sockaddr failed");
-	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
-	fail_unless (NULL == err, "error raised");
-	fail_unless (TRUE == pgm_bind (sock, pgmsa, sizeof(*pgmsa), &err), "bind failed");
-	fail_unless (TRUE == pgm_close (sock, FALSE), "destroy failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_HUGETLB;
+	int page_size		= 4096;
+	const void* optval	= &page_size;
+	const socklen_t optlen	= sizeof(page_size);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_hugetlb failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_hugetlb failed");
+	page_size = PGM_HUGEPAGE_1GB;
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_hugetlb failed");
 }
 END_TEST
 
-/* socket > bind > connect > close */
-START_TEST (test_destroy_pass_003)
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_MLOCK,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_mlock_pass_001)
 {
-	pgm_error_t* err = NULL;
-	pgm_sock_t* sock = NULL;
-	struct pgm_sockaddr_t* pgmsa = generate_asm_sockaddr ();
-	fail_if (NULL == pgmsa, "generate_asm_sockaddr failed");
-	fail_unless (TRUE == pgm_socket (&sock, AF_INET, SOCK_SEQPACKET, IPPROTO_PGM, &err), "create failed");
-	fail_unless (NULL == err, "error raised");
-	fail_unless (TRUE == pgm_bind (sock, pgmsa, sizeof(*pgmsa), &err), "bind failed");
-	fail_unless (TRUE == pgm_connect (sock, &err), "connect failed");
-	fail_unless (TRUE == pgm_close (sock, FALSE), "destroy failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_MLOCK;
+	const int enabled	= 1;
+	const void* optval	= &enabled;
+	const socklen_t optlen	= sizeof(enabled);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_mlock failed");
+	fail_unless (TRUE == sock->use_mlock, "use_mlock not set");
 }
 END_TEST
 
-/* invalid parameters */
-START_TEST (test_destroy_fail_001)
+/* must be set before bind */
+START_TEST (test_set_mlock_fail_001)
 {
-	fail_unless (FALSE == pgm_close (NULL, FALSE), "destroy failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_MLOCK;
+	const int enabled	= 1;
+	const void* optval	= &enabled;
+	const socklen_t optlen	= sizeof(enabled);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_mlock failed");
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_mlock failed");
 }
 END_TEST
 
@@ -595,48 +3120,87 @@ END_TEST
  *	pgm_setsockopt (
  *		pgm_sock_t* const	sock,
  *		const int		level = IPPROTO_PGM,
- *		const int		optname = PGM_MAX_TPDU,
+ *		const int		optname = PGM_NUMA_NODE,
  *		const void*		optval,
  *		const socklen_t		optlen = sizeof(int)
- *		)
+ *	)
  */
 
-START_TEST (test_set_max_tpdu_pass_001)
+START_TEST (test_set_numa_node_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_MTU;
-	const int max_tpdu	= 1500;
-	const void* optval	= &max_tpdu;
-	const socklen_t optlen	= sizeof(max_tpdu);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_max_tpdu failed");
+	const int optname	= PGM_NUMA_NODE;
+	int node		= 1;
+	const void* optval	= &node;
+	const socklen_t optlen	= sizeof(node);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_numa_node failed");
+	fail_unless (1 == sock->numa_node, "numa_node not set");
+	node = PGM_NUMA_NODE_INTERFACE;
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_numa_node failed");
+	fail_unless (PGM_NUMA_NODE_INTERFACE == sock->numa_node, "numa_node not set");
 }
 END_TEST
 
-/* invalid parameters */
-START_TEST (test_set_max_tpdu_fail_001)
+/* invalid node, or after bind */
+START_TEST (test_set_numa_node_fail_001)
 {
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_MTU;
-	const int max_tpdu	= 1500;
-	const void* optval	= &max_tpdu;
-	const socklen_t optlen	= sizeof(max_tpdu);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_max_tpdu failed");
+	const int optname	= PGM_NUMA_NODE;
+	int node		= -3;
+	const void* optval	= &node;
+	const socklen_t optlen	= sizeof(node);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_numa_node failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_numa_node failed");
+	node = 0;
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_numa_node failed");
 }
 END_TEST
 
-/* too small */
-START_TEST (test_set_max_tpdu_fail_002)
+/* target:
+ *	bool
+ *	pgm_setsockopt (
+ *		pgm_sock_t* const	sock,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_COALESCE,
+ *		const void*		optval,
+ *		const socklen_t		optlen = sizeof(int)
+ *	)
+ */
+
+START_TEST (test_set_coalesce_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_MTU;
-	const int max_tpdu	= 1;
-	const void* optval	= &max_tpdu;
-	const socklen_t optlen	= sizeof(max_tpdu);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_max_tpdu failed");
+	const int optname	= PGM_COALESCE;
+	const int threshold	= 1000;
+	const void* optval	= &threshold;
+	const socklen_t optlen	= sizeof(threshold);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_coalesce failed");
+	fail_unless (1000 == sock->coalesce_threshold, "coalesce_threshold not set");
+}
+END_TEST
+
+/* invalid threshold, or after bind */
+START_TEST (test_set_coalesce_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_COALESCE;
+	int threshold		= -1;
+	const void* optval	= &threshold;
+	const socklen_t optlen	= sizeof(threshold);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_coalesce failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_coalesce failed");
+	threshold = 1000;
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_coalesce failed");
 }
 END_TEST
 
@@ -645,33 +3209,44 @@ END_TEST
  *	pgm_setsockopt (
  *		pgm_sock_t* const	sock,
  *		const int		level = IPPROTO_PGM,
- *		const int		optname = PGM_MULTICAST_LOOP,
+ *		const int		optname = PGM_TXTIME,
  *		const void*		optval,
  *		const socklen_t		optlen = sizeof(int)
- *		)
+ *	)
  */
 
-START_TEST (test_set_multicast_loop_pass_001)
+START_TEST (test_set_txtime_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_MULTICAST_LOOP;
-	const int loop_enabled	= 1;
-	const void* optval	= &loop_enabled;
-	const socklen_t optlen	= sizeof(loop_enabled);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_multicast_loop failed");
+	const int optname	= PGM_TXTIME;
+	int mode		= PGM_TXTIME_FQ;
+	const void* optval	= &mode;
+	const socklen_t optlen	= sizeof(mode);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_txtime failed");
+	fail_unless (PGM_TXTIME_FQ == sock->txtime_mode, "txtime_mode not set");
+	mode = PGM_TXTIME_ETF;
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_txtime failed");
+	fail_unless (PGM_TXTIME_ETF == sock->txtime_mode, "txtime_mode not set");
 }
 END_TEST
 
-START_TEST (test_set_multicast_loop_fail_001)
+/* invalid mode, or after bind */
+START_TEST (test_set_txtime_fail_001)
 {
-	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_MULTICAST_LOOP;
-	const int loop_enabled	= 1;
-	const void* optval	= &loop_enabled;
-	const socklen_t optlen	= sizeof(loop_enabled);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_multicast_loop failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_TXTIME;
+	int mode		= 3;
+	const void* optval	= &mode;
+	const socklen_t optlen	= sizeof(mode);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_txtime failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_txtime failed");
+	mode = PGM_TXTIME_FQ;
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_txtime failed");
 }
 END_TEST
 
@@ -680,33 +3255,39 @@ END_TEST
  *	pgm_setsockopt (
  *		pgm_sock_t* const	sock,
  *		const int		level = IPPROTO_PGM,
- *		const int		optname = PGM_MULTICAST_HOPS,
+ *		const int		optname = PGM_TX_PRIORITY,
  *		const void*		optval,
  *		const socklen_t		optlen = sizeof(int)
  *	)
  */
 
-START_TEST (test_set_hops_pass_001)
+START_TEST (test_set_tx_priority_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_MULTICAST_HOPS;
-	const int hops		= 16;
-	const void* optval	= &hops;
-	const socklen_t optlen	= sizeof(hops);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_hops failed");
+	const int optname	= PGM_TX_PRIORITY;
+	const int is_priority	= 1;
+	const void* optval	= &is_priority;
+	const socklen_t optlen	= sizeof(is_priority);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_tx_priority failed");
+	fail_unless (TRUE == sock->use_tx_priority, "use_tx_priority not set");
 }
 END_TEST
 
-START_TEST (test_set_hops_fail_001)
+/* after bind */
+START_TEST (test_set_tx_priority_fail_001)
 {
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_MULTICAST_HOPS;
-	const int hops		= 16;
-	const void* optval	= &hops;
-	const socklen_t optlen	= sizeof(hops);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_hops failed");
+	const int optname	= PGM_TX_PRIORITY;
+	const int is_priority	= 1;
+	const void* optval	= &is_priority;
+	const socklen_t optlen	= sizeof(is_priority);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_tx_priority failed");
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_tx_priority failed");
 }
 END_TEST
 
@@ -714,34 +3295,44 @@ END_TEST
  *	bool
  *	pgm_setsockopt (
  *		pgm_sock_t* const	sock,
- *		const int		level = SOL_SOCKET,
- *		const int		optname = SO_SNDBUF,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_RDATA_SHARE,
  *		const void*		optval,
  *		const socklen_t		optlen = sizeof(int)
  *	)
  */
 
-START_TEST (test_set_sndbuf_pass_001)
+START_TEST (test_set_rdata_share_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
-	const int level		= SOL_SOCKET;
-	const int optname	= SO_SNDBUF;
-	const int bufsize	= 131071;	/* 128kB */
-	const void* optval	= &bufsize;
-	const socklen_t optlen	= sizeof(bufsize);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_sndbuf failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RDATA_SHARE;
+	const int share		= 25;
+	const void* optval	= &share;
+	const socklen_t optlen	= sizeof(share);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rdata_share failed");
+	fail_unless (25 == sock->rdata_share, "rdata_share not set");
 }
 END_TEST
 
-START_TEST (test_set_sndbuf_fail_001)
+/* out of range, or after bind */
+START_TEST (test_set_rdata_share_fail_001)
 {
-	const int level		= SOL_SOCKET;
-	const int optname	= SO_SNDBUF;
-	const int bufsize	= 131071;	/* 128kB */
-	const void* optval	= &bufsize;
-	const socklen_t optlen	= sizeof(bufsize);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_sndbuf failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_RDATA_SHARE;
+	int share		= 0;
+	const void* optval	= &share;
+	const socklen_t optlen	= sizeof(share);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_rdata_share failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rdata_share failed");
+	share = 101;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rdata_share failed");
+	share = 50;
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rdata_share failed");
 }
 END_TEST
 
@@ -749,34 +3340,35 @@ END_TEST
  *	bool
  *	pgm_setsockopt (
  *		pgm_sock_t* const	sock,
- *		const int		level = SOL_SOCKET,
- *		const int		optname = PGM_RCVBUF,
+ *		const int		level = IPPROTO_PGM,
+ *		const int		optname = PGM_NAK_ADAPTIVE,
  *		const void*		optval,
  *		const socklen_t		optlen = sizeof(int)
  *	)
  */
 
-START_TEST (test_set_rcvbuf_pass_001)
+START_TEST (test_set_nak_adaptive_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
-	const int level		= SOL_SOCKET;
-	const int optname	= SO_RCVBUF;
-	const int bufsize	= 131071;	/* 128kB */
-	const void* optval	= &bufsize;
-	const socklen_t optlen	= sizeof(bufsize);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_rcvbuf failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_NAK_ADAPTIVE;
+	const int is_adaptive	= 1;
+	const void* optval	= &is_adaptive;
+	const socklen_t optlen	= sizeof(is_adaptive);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_nak_adaptive failed");
+	fail_unless (TRUE == sock->use_adaptive_nak, "use_adaptive_nak not set");
 }
 END_TEST
 
-START_TEST (test_set_rcvbuf_fail_001)
+START_TEST (test_set_nak_adaptive_fail_001)
 {
-	const int level		= SOL_SOCKET;
-	const int optname	= SO_RCVBUF;
-	const int bufsize	= 131071;	/* 128kB */
-	const void* optval	= &bufsize;
-	const socklen_t optlen	= sizeof(bufsize);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_rcvbuf failed");
+	const int level		= IPPROTO_PGM;
+	const int optname	= PGM_NAK_ADAPTIVE;
+	const int is_adaptive	= 1;
+	const void* optval	= &is_adaptive;
+	const socklen_t optlen	= sizeof(is_adaptive);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_nak_adaptive failed");
 }
 END_TEST
 
@@ -785,91 +3377,77 @@ END_TEST
  *	pgm_setsockopt (
  *		pgm_sock_t* const	sock,
  *		const int		level = IPPROTO_PGM,
- *		const int		optname = PGM_USE_FEC,
+ *		const int		optname = PGM_NAK_POPULATION,
  *		const void*		optval,
- *		const socklen_t		optlen = sizeof(struct pgm_fecinfo_t)
+ *		const socklen_t		optlen = sizeof(int)
  *	)
  */
 
-START_TEST (test_set_fec_pass_001)
+START_TEST (test_set_nak_population_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_USE_FEC;
-	const struct pgm_fecinfo_t fecinfo = {
-		.ondemand_parity_enabled	= TRUE,
-		.proactive_packets		= 16,
-		.var_pktlen_enabled		= TRUE,
-		.block_size			= 255,
-		.group_size			= 64
-	};
-	const void* optval	= &fecinfo;
-	const socklen_t optlen	= sizeof(fecinfo);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_fec failed");
+	const int optname	= PGM_NAK_POPULATION;
+	const int population	= 10000;
+	const void* optval	= &population;
+	const socklen_t optlen	= sizeof(population);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_nak_population failed");
+	fail_unless (10000 == sock->nak_population, "nak_population not set");
 }
 END_TEST
 
-START_TEST (test_set_fec_fail_001)
+/* negative population */
+START_TEST (test_set_nak_population_fail_001)
 {
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_USE_FEC;
-	const struct pgm_fecinfo_t fecinfo = {
-		.ondemand_parity_enabled	= TRUE,
-		.proactive_packets		= 16,
-		.var_pktlen_enabled		= TRUE,
-		.block_size			= 255,
-		.group_size			= 64
-	};
-	const void* optval	= &fecinfo;
-	const socklen_t optlen	= sizeof(fecinfo);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_fec failed");
+	const int optname	= PGM_NAK_POPULATION;
+	int population		= 10000;
+	const socklen_t optlen	= sizeof(population);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, &population, optlen), "set_nak_population failed");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	population = -1;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, &population, optlen), "set_nak_population failed");
 }
 END_TEST
 
-/* TODO: invalid Reed-Solomon parameters
- */
-
 /* target:
  *	bool
  *	pgm_setsockopt (
  *		pgm_sock_t* const	sock,
  *		const int		level = IPPROTO_PGM,
- *		const int		optname = PGM_USE_PGMCC,
+ *		const int		optname = PGM_LATENCY_BUDGET,
  *		const void*		optval,
- *		const socklen_t		optlen = sizeof(struct pgm_pgmccinfo_t)
+ *		const socklen_t		optlen = sizeof(int)
  *	)
  */
 
-START_TEST (test_set_pgmcc_pass_001)
+START_TEST (test_set_latency_budget_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_USE_PGMCC;
-	const struct pgm_pgmccinfo_t pgmccinfo = {
-		.ack_bo_ivl	= pgm_msecs(100),
-		.ack_c		= 123,
-		.ack_c_p	= 456
-	};
-	const void* optval	= &pgmccinfo;
-	const socklen_t optlen	= sizeof(pgmccinfo);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_pgmcc failed");
+	const int optname	= PGM_LATENCY_BUDGET;
+	const int budget	= 50*1000;
+	const void* optval	= &budget;
+	const socklen_t optlen	= sizeof(budget);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_latency_budget failed");
+	fail_unless (50*1000 == sock->latency_budget, "latency_budget not set");
 }
 END_TEST
 
-START_TEST (test_set_pgmcc_fail_001)
+/* invalid budget */
+START_TEST (test_set_latency_budget_fail_001)
 {
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_USE_PGMCC;
-	const struct pgm_pgmccinfo_t pgmccinfo = {
-		.ack_bo_ivl	= pgm_msecs(100),
-		.ack_c		= 123,
-		.ack_c_p	= 456
-	};
-	const void* optval	= &pgmccinfo;
-	const socklen_t optlen	= sizeof(pgmccinfo);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_pgmcc failed");
+	const int optname	= PGM_LATENCY_BUDGET;
+	const int budget	= -1;
+	const void* optval	= &budget;
+	const socklen_t optlen	= sizeof(budget);
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_latency_budget failed");
 }
 END_TEST
 
@@ -878,69 +3456,78 @@ END_TEST
  *	pgm_setsockopt (
  *		pgm_sock_t* const	sock,
  *		const int		level = IPPROTO_PGM,
- *		const int		optname = PGM_USE_CR,
+ *		const int		optname = PGM_UNORDERED,
  *		const void*		optval,
  *		const socklen_t		optlen = sizeof(int)
  *	)
  */
 
-START_TEST (test_set_cr_pass_001)
+START_TEST (test_set_unordered_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_USE_CR;
-	const int magic_bunny	= 1;
-	const void* optval	= &magic_bunny;
-	const socklen_t optlen	= sizeof(magic_bunny);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_cr failed");
+	const int optname	= PGM_UNORDERED;
+	const int is_unordered	= 1;
+	const void* optval	= &is_unordered;
+	const socklen_t optlen	= sizeof(is_unordered);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_unordered failed");
+	fail_unless (TRUE == sock->use_unordered, "use_unordered not set");
 }
 END_TEST
 
-START_TEST (test_set_cr_fail_001)
+/* after bind */
+START_TEST (test_set_unordered_fail_001)
 {
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_USE_CR;
-	const int magic_bunny	= 1;
-	const void* optval	= &magic_bunny;
-	const socklen_t optlen	= sizeof(magic_bunny);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_cr failed");
+	const int optname	= PGM_UNORDERED;
+	const int is_unordered	= 1;
+	const void* optval	= &is_unordered;
+	const socklen_t optlen	= sizeof(is_unordered);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_unordered failed");
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_unordered failed");
 }
 END_TEST
 
-
 /* target:
  *	bool
  *	pgm_setsockopt (
  *		pgm_sock_t* const	sock,
  *		const int		level = IPPROTO_PGM,
- *		const int		optname = PGM_SEND_ONLY,
+ *		const int		optname = PGM_RECV_QUANTUM,
  *		const void*		optval,
  *		const socklen_t		optlen = sizeof(int)
  *	)
  */
 
-START_TEST (test_set_send_only_pass_001)
+START_TEST (test_set_recv_quantum_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_SEND_ONLY;
-	const int send_only	= 1;
-	const void* optval	= &send_only;
-	const socklen_t optlen	= sizeof(send_only);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_send_only failed");
+	const int optname	= PGM_RECV_QUANTUM;
+	const int quantum	= 4;
+	const void* optval	= &quantum;
+	const socklen_t optlen	= sizeof(quantum);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_recv_quantum failed");
+	fail_unless (4 == sock->recv_quantum, "recv_quantum not set");
 }
 END_TEST
 
-START_TEST (test_set_send_only_fail_001)
+START_TEST (test_set_recv_quantum_fail_001)
 {
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_SEND_ONLY;
-	const int send_only	= 1;
-	const void* optval	= &send_only;
-	const socklen_t optlen	= sizeof(send_only);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_send_only failed");
+	const int optname	= PGM_RECV_QUANTUM;
+	const int quantum	= -1;
+	const void* optval	= &quantum;
+	const socklen_t optlen	= sizeof(quantum);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_recv_quantum failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_recv_quantum failed");
 }
 END_TEST
 
@@ -949,33 +3536,56 @@ END_TEST
  *	pgm_setsockopt (
  *		pgm_sock_t* const	sock,
  *		const int		level = IPPROTO_PGM,
- *		const int		optname = PGM_RECV_ONLY,
+ *		const int		optname = PGM_PEER_WEIGHT,
  *		const void*		optval,
- *		const socklen_t		optlen = sizeof(int)
+ *		const socklen_t		optlen = sizeof(struct pgm_peerweightinfo_t)
  *	)
  */
 
-START_TEST (test_set_recv_only_pass_001)
+START_TEST (test_set_peer_weight_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_RECV_ONLY;
-	const int recv_only	= 1;
-	const void* optval	= &recv_only;
-	const socklen_t optlen	= sizeof(recv_only);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_recv_only failed");
+	const int optname	= PGM_PEER_WEIGHT;
+	struct pgm_peerweightinfo_t info = {
+		.tsi		= { { 1, 2, 3, 4, 5, 6 }, 1000 },
+		.weight		= 4,
+		.is_priority	= 1
+	};
+	const void* optval	= &info;
+	const socklen_t optlen	= sizeof(info);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_peer_weight failed");
+	fail_unless (1 == sock->peer_weight_len, "peer_weight not added");
+	fail_unless (4 == sock->peer_weight[0].weight, "weight not set");
+/* default weight removes */
+	info.weight = 0;
+	info.is_priority = 0;
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_peer_weight failed");
+	fail_unless (0 == sock->peer_weight_len, "peer_weight not removed");
 }
 END_TEST
 
-START_TEST (test_set_recv_only_fail_001)
+/* table full */
+START_TEST (test_set_peer_weight_fail_001)
 {
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_RECV_ONLY;
-	const int recv_only	= 1;
-	const void* optval	= &recv_only;
-	const socklen_t optlen	= sizeof(recv_only);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_recv_only failed");
+	const int optname	= PGM_PEER_WEIGHT;
+	struct pgm_peerweightinfo_t info = {
+		.tsi		= { { 1, 2, 3, 4, 5, 6 }, 1000 },
+		.weight		= 2
+	};
+	const void* optval	= &info;
+	const socklen_t optlen	= sizeof(info);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_peer_weight failed");
+	for (unsigned i = 0; i < PGM_PEER_WEIGHT_MAX; i++) {
+		info.tsi.sport = pgm_htons (1000 + i);
+		fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_peer_weight failed");
+	}
+	info.tsi.sport = pgm_htons (1000 + PGM_PEER_WEIGHT_MAX);
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_peer_weight failed");
 }
 END_TEST
 
@@ -984,103 +3594,113 @@ END_TEST
  *	pgm_setsockopt (
  *		pgm_sock_t* const	sock,
  *		const int		level = IPPROTO_PGM,
- *		const int		optname = PGM_PASSIVE,
+ *		const int		optname = PGM_FLIGHTREC,
  *		const void*		optval,
- *		const socklen_t		optlen = sizeof(int)
+ *		const socklen_t		optlen = sizeof(struct pgm_flightrecinfo_t)
  *	)
  */
 
-START_TEST (test_set_recv_only_pass_002)
+START_TEST (test_set_flightrec_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_PASSIVE;
-	const int passive	= 1;
-	const void* optval	= &passive;
-	const socklen_t optlen	= sizeof(passive);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_passive failed");
+	const int optname	= PGM_FLIGHTREC;
+	const struct pgm_flightrecinfo_t info = {
+		.len		= 4096,
+		.dump_on_reset	= 1
+	};
+	const void* optval	= &info;
+	const socklen_t optlen	= sizeof(info);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_flightrec failed");
+	fail_unless (4096 == sock->flightrec_len, "flightrec_len not set");
+	fail_unless (sock->use_flightrec_dump, "use_flightrec_dump not set");
 }
 END_TEST
 
-START_TEST (test_set_recv_only_fail_002)
+START_TEST (test_set_flightrec_fail_001)
 {
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_PASSIVE;
-	const int passive	= 1;
-	const void* optval	= &passive;
-	const socklen_t optlen	= sizeof(passive);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_passive failed");
+	const int optname	= PGM_FLIGHTREC;
+	const struct pgm_flightrecinfo_t info = {
+		.len		= (1U << 24) + 1
+	};
+	const void* optval	= &info;
+	const socklen_t optlen	= sizeof(info);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_flightrec failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_flightrec failed");
 }
 END_TEST
 
 /* target:
  *	bool
- *	pgm_setsockopt (
+ *	pgm_getsockopt (
  *		pgm_sock_t* const	sock,
  *		const int		level = IPPROTO_PGM,
- *		const int		optname = PGM_ABORT_ON_RESET,
- *		const void*		optval,
- *		const socklen_t		optlen = sizeof(int)
+ *		const int		optname = PGM_PEERS,
+ *		void*			optval,
+ *		socklen_t*		optlen
  *	)
  */
 
-START_TEST (test_set_abort_on_reset_pass_001)
+START_TEST (test_get_peers_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
+	pgm_rwlock_init (&sock->peers_lock);
+	sock->is_connected = TRUE;
+	sock->can_recv_data = TRUE;
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_ABORT_ON_RESET;
-	const int abort_on_reset= 1;
-	const void* optval	= &abort_on_reset;
-	const socklen_t optlen	= sizeof(abort_on_reset);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_abort_on_reset failed");
+	const int optname	= PGM_PEERS;
+	pgm_tsi_t tsi[ 2 ];
+	socklen_t optlen	= sizeof(tsi);
+	fail_unless (TRUE == pgm_getsockopt (sock, level, optname, tsi, &optlen), "get_peers failed");
+	fail_unless (0 == optlen, "optlen not zero");
 }
 END_TEST
 
-START_TEST (test_set_abort_on_reset_fail_001)
+START_TEST (test_get_peers_fail_001)
 {
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_ABORT_ON_RESET;
-	const int abort_on_reset= 1;
-	const void* optval	= &abort_on_reset;
-	const socklen_t optlen	= sizeof(abort_on_reset);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_abort_on_reset failed");
+	const int optname	= PGM_PEERS;
+	pgm_tsi_t tsi[ 2 ];
+	socklen_t optlen	= sizeof(tsi);
+	fail_unless (FALSE == pgm_getsockopt (NULL, level, optname, tsi, &optlen), "get_peers failed");
+	fail_unless (FALSE == pgm_getsockopt (sock, level, optname, tsi, &optlen), "get_peers failed");
 }
 END_TEST
 
 /* target:
  *	bool
- *	pgm_setsockopt (
+ *	pgm_getsockopt (
  *		pgm_sock_t* const	sock,
  *		const int		level = IPPROTO_PGM,
- *		const int		optname = PGM_NOBLOCK,
- *		const void*		optval,
- *		const socklen_t		optlen = sizeof(int)
+ *		const int		optname = PGM_PEER_STATS,
+ *		void*			optval,
+ *		socklen_t*		optlen = sizeof(struct pgm_peerstatsinfo_t)
  *	)
  */
 
-START_TEST (test_set_noblock_pass_001)
+/* unknown source */
+START_TEST (test_get_peer_stats_fail_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
+	pgm_rwlock_init (&sock->peers_lock);
+	sock->is_connected = TRUE;
+	sock->can_recv_data = TRUE;
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_NOBLOCK;
-	const int noblock       = 1;
-	const void* optval	= &noblock;
-	const socklen_t optlen	= sizeof(noblock);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_noblock failed");
-}
-END_TEST
-
-START_TEST (test_set_noblock_fail_001)
-{
-	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_NOBLOCK;
-	const int noblock       = 1;
-	const void* optval	= &noblock;
-	const socklen_t optlen	= sizeof(noblock);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_noblock failed");
+	const int optname	= PGM_PEER_STATS;
+	struct pgm_peerstatsinfo_t info;
+	memset (&info, 0, sizeof(info));
+	socklen_t optlen	= sizeof(info);
+	fail_unless (FALSE == pgm_getsockopt (sock, level, optname, &info, &optlen), "get_peer_stats failed");
+	optlen = sizeof(info) - 1;
+	fail_unless (FALSE == pgm_getsockopt (sock, level, optname, &info, &optlen), "get_peer_stats failed");
 }
 END_TEST
 
@@ -1089,33 +3709,39 @@ END_TEST
  *	pgm_setsockopt (
  *		pgm_sock_t* const	sock,
  *		const int		level = IPPROTO_PGM,
- *		const int		optname = PGM_UDP_ENCAP_UCAST_PORT,
+ *		const int		optname = PGM_ZEROCOPY,
  *		const void*		optval,
  *		const socklen_t		optlen = sizeof(int)
  *	)
  */
 
-START_TEST (test_set_udp_unicast_pass_001)
+START_TEST (test_set_zerocopy_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_NOBLOCK;
-	const int unicast_port  = 10001;
-	const void* optval	= &unicast_port;
-	const socklen_t optlen	= sizeof(unicast_port);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_udp_unicast failed");
+	const int optname	= PGM_ZEROCOPY;
+	const int is_zerocopy	= 1;
+	const void* optval	= &is_zerocopy;
+	const socklen_t optlen	= sizeof(is_zerocopy);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_zerocopy failed");
+	fail_unless (TRUE == sock->use_zerocopy, "use_zerocopy not set");
 }
 END_TEST
 
-START_TEST (test_set_udp_unicast_fail_001)
+/* after bind */
+START_TEST (test_set_zerocopy_fail_001)
 {
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_NOBLOCK;
-	const int unicast_port  = 10001;
-	const void* optval	= &unicast_port;
-	const socklen_t optlen	= sizeof(unicast_port);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_udp_unicast failed");
+	const int optname	= PGM_ZEROCOPY;
+	const int is_zerocopy	= 1;
+	const void* optval	= &is_zerocopy;
+	const socklen_t optlen	= sizeof(is_zerocopy);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_zerocopy failed");
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_zerocopy failed");
 }
 END_TEST
 
@@ -1124,33 +3750,44 @@ END_TEST
  *	pgm_setsockopt (
  *		pgm_sock_t* const	sock,
  *		const int		level = IPPROTO_PGM,
- *		const int		optname = PGM_UDP_ENCAP_MCAST_PORT,
+ *		const int		optname = PGM_SKB_POOL_MEMORY,
  *		const void*		optval,
- *		const socklen_t		optlen = sizeof(int)
+ *		const socklen_t		optlen = sizeof(struct pgm_skbmeminfo_t)
  *	)
  */
 
-START_TEST (test_set_udp_multicast_pass_001)
+START_TEST (test_set_skb_pool_memory_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
+	static char memory[ 65536 ];
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_NOBLOCK;
-	const int multicast_port= 10001;
-	const void* optval	= &multicast_port;
-	const socklen_t optlen	= sizeof(multicast_port);
-	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_udp_multicast failed");
+	const int optname	= PGM_SKB_POOL_MEMORY;
+	const struct pgm_skbmeminfo_t skbmeminfo = { .addr = memory, .len = sizeof(memory) };
+	const void* optval	= &skbmeminfo;
+	const socklen_t optlen	= sizeof(skbmeminfo);
+	fail_unless (TRUE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_skb_pool_memory failed");
+	fail_unless (memory == sock->skb_pool_addr, "skb_pool_addr not set");
+	fail_unless (sizeof(memory) == sock->skb_pool_len, "skb_pool_len not set");
 }
 END_TEST
 
-START_TEST (test_set_udp_multicast_fail_001)
+/* zero length, after bind */
+START_TEST (test_set_skb_pool_memory_fail_001)
 {
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	static char memory[ 65536 ];
 	const int level		= IPPROTO_PGM;
-	const int optname	= PGM_NOBLOCK;
-	const int multicast_port= 10002;
-	const void* optval	= &multicast_port;
-	const socklen_t optlen	= sizeof(multicast_port);
-	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_udp_multicast failed");
+	const int optname	= PGM_SKB_POOL_MEMORY;
+	const struct pgm_skbmeminfo_t skbmeminfo = { .addr = memory, .len = sizeof(memory) };
+	const struct pgm_skbmeminfo_t empty = { .addr = memory, .len = 0 };
+	const void* optval	= &skbmeminfo;
+	const socklen_t optlen	= sizeof(skbmeminfo);
+	fail_unless (FALSE == pgm_setsockopt (NULL, level, optname, optval, optlen), "set_skb_pool_memory failed");
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, &empty, sizeof(empty)), "set_skb_pool_memory failed");
+	sock->is_bound = TRUE;
+	fail_unless (FALSE == pgm_setsockopt (sock, level, optname, optval, optlen), "set_skb_pool_memory failed");
 }
 END_TEST
 
@@ -1171,11 +3808,21 @@ make_test_suite (void)
 	tcase_add_test (tc_create, test_create_fail_004);
 	tcase_add_test (tc_create, test_create_fail_005);
 
+	TCase* tc_socket_clone = tcase_create ("socket-clone");
+	suite_add_tcase (s, tc_socket_clone);
+	tcase_add_checked_fixture (tc_socket_clone, mock_setup, mock_teardown);
+	tcase_add_test (tc_socket_clone, test_socket_clone_pass_001);
+	tcase_add_test (tc_socket_clone, test_socket_clone_pass_002);
+	tcase_add_test (tc_socket_clone, test_socket_clone_fail_001);
+	tcase_add_test (tc_socket_clone, test_socket_clone_fail_002);
+	tcase_add_test (tc_socket_clone, test_socket_clone_fail_003);
+
 	TCase* tc_bind = tcase_create ("bind");
 	suite_add_tcase (s, tc_bind);
 	tcase_add_checked_fixture (tc_bind, mock_setup, mock_teardown);
 	tcase_add_test (tc_bind, test_bind_fail_001);
 	tcase_add_test (tc_bind, test_bind_fail_002);
+	tcase_add_test (tc_bind, test_bind_fail_003);
 
 	TCase* tc_connect = tcase_create ("connect");
 	suite_add_tcase (s, tc_connect);
@@ -1225,6 +3872,12 @@ make_test_suite (void)
 	tcase_add_test (tc_set_fec, test_set_fec_pass_001);
 	tcase_add_test (tc_set_fec, test_set_fec_fail_001);
 
+	TCase* tc_set_adaptive_fec = tcase_create ("set-adaptive-fec");
+	suite_add_tcase (s, tc_set_adaptive_fec);
+	tcase_add_checked_fixture (tc_set_adaptive_fec, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_adaptive_fec, test_set_adaptive_fec_pass_001);
+	tcase_add_test (tc_set_adaptive_fec, test_set_adaptive_fec_fail_001);
+
 	TCase* tc_set_pgmcc = tcase_create ("set-pgmcc");
 	suite_add_tcase (s, tc_set_pgmcc);
 	tcase_add_checked_fixture (tc_set_pgmcc, mock_setup, mock_teardown);
@@ -1275,6 +3928,240 @@ make_test_suite (void)
 	tcase_add_test (tc_set_udp_multicast, test_set_udp_multicast_pass_001);
 	tcase_add_test (tc_set_udp_multicast, test_set_udp_multicast_fail_001);
 
+	TCase* tc_set_recv_batch = tcase_create ("set-recv-batch");
+	suite_add_tcase (s, tc_set_recv_batch);
+	tcase_add_checked_fixture (tc_set_recv_batch, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_recv_batch, test_set_recv_batch_pass_001);
+	tcase_add_test (tc_set_recv_batch, test_set_recv_batch_fail_001);
+
+	TCase* tc_set_send_batch = tcase_create ("set-send-batch");
+	suite_add_tcase (s, tc_set_send_batch);
+	tcase_add_checked_fixture (tc_set_send_batch, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_send_batch, test_set_send_batch_pass_001);
+	tcase_add_test (tc_set_send_batch, test_set_send_batch_fail_001);
+
+	TCase* tc_set_skb_pool = tcase_create ("set-skb-pool");
+	suite_add_tcase (s, tc_set_skb_pool);
+	tcase_add_checked_fixture (tc_set_skb_pool, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_skb_pool, test_set_skb_pool_pass_001);
+	tcase_add_test (tc_set_skb_pool, test_set_skb_pool_fail_001);
+
+	TCase* tc_set_udp_gso = tcase_create ("set-udp-gso");
+	suite_add_tcase (s, tc_set_udp_gso);
+	tcase_add_checked_fixture (tc_set_udp_gso, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_udp_gso, test_set_udp_gso_pass_001);
+	tcase_add_test (tc_set_udp_gso, test_set_udp_gso_fail_001);
+
+	TCase* tc_set_udp_gro = tcase_create ("set-udp-gro");
+	suite_add_tcase (s, tc_set_udp_gro);
+	tcase_add_checked_fixture (tc_set_udp_gro, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_udp_gro, test_set_udp_gro_pass_001);
+	tcase_add_test (tc_set_udp_gro, test_set_udp_gro_fail_001);
+
+	TCase* tc_set_zero_checksum = tcase_create ("set-zero-checksum");
+	suite_add_tcase (s, tc_set_zero_checksum);
+	tcase_add_checked_fixture (tc_set_zero_checksum, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_zero_checksum, test_set_zero_checksum_pass_001);
+	tcase_add_test (tc_set_zero_checksum, test_set_zero_checksum_fail_001);
+
+	TCase* tc_set_crc32c = tcase_create ("set-crc32c");
+	suite_add_tcase (s, tc_set_crc32c);
+	tcase_add_checked_fixture (tc_set_crc32c, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_crc32c, test_set_crc32c_pass_001);
+	tcase_add_test (tc_set_crc32c, test_set_crc32c_fail_001);
+
+	TCase* tc_set_xdp_filter = tcase_create ("set-xdp-filter");
+	suite_add_tcase (s, tc_set_xdp_filter);
+	tcase_add_checked_fixture (tc_set_xdp_filter, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_xdp_filter, test_set_xdp_filter_pass_001);
+	tcase_add_test (tc_set_xdp_filter, test_set_xdp_filter_fail_001);
+
+	TCase* tc_set_prewarm = tcase_create ("set-prewarm");
+	suite_add_tcase (s, tc_set_prewarm);
+	tcase_add_checked_fixture (tc_set_prewarm, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_prewarm, test_set_prewarm_pass_001);
+	tcase_add_test (tc_set_prewarm, test_set_prewarm_fail_001);
+
+	TCase* tc_set_recv_shards = tcase_create ("set-recv-shards");
+	suite_add_tcase (s, tc_set_recv_shards);
+	tcase_add_checked_fixture (tc_set_recv_shards, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_recv_shards, test_set_recv_shards_pass_001);
+	tcase_add_test (tc_set_recv_shards, test_set_recv_shards_fail_001);
+
+	TCase* tc_set_xdp = tcase_create ("set-xdp");
+	suite_add_tcase (s, tc_set_xdp);
+	tcase_add_checked_fixture (tc_set_xdp, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_xdp, test_set_xdp_pass_001);
+	tcase_add_test (tc_set_xdp, test_set_xdp_fail_001);
+
+	TCase* tc_set_io_uring = tcase_create ("set-io-uring");
+	suite_add_tcase (s, tc_set_io_uring);
+	tcase_add_checked_fixture (tc_set_io_uring, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_io_uring, test_set_io_uring_pass_001);
+	tcase_add_test (tc_set_io_uring, test_set_io_uring_fail_001);
+
+	TCase* tc_set_rio = tcase_create ("set-rio");
+	suite_add_tcase (s, tc_set_rio);
+	tcase_add_checked_fixture (tc_set_rio, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_rio, test_set_rio_pass_001);
+	tcase_add_test (tc_set_rio, test_set_rio_fail_001);
+	tcase_add_test (tc_set_rio, test_set_rio_iocp_pass_001);
+
+	TCase* tc_set_dpdk = tcase_create ("set-dpdk");
+	suite_add_tcase (s, tc_set_dpdk);
+	tcase_add_checked_fixture (tc_set_dpdk, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_dpdk, test_set_dpdk_pass_001);
+	tcase_add_test (tc_set_dpdk, test_set_dpdk_fail_001);
+
+	TCase* tc_set_busy_poll = tcase_create ("set-busy-poll");
+	suite_add_tcase (s, tc_set_busy_poll);
+	tcase_add_checked_fixture (tc_set_busy_poll, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_busy_poll, test_set_busy_poll_pass_001);
+	tcase_add_test (tc_set_busy_poll, test_set_busy_poll_fail_001);
+
+	TCase* tc_set_rdata_thread = tcase_create ("set-rdata-thread");
+	suite_add_tcase (s, tc_set_rdata_thread);
+	tcase_add_checked_fixture (tc_set_rdata_thread, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_rdata_thread, test_set_rdata_thread_pass_001);
+	tcase_add_test (tc_set_rdata_thread, test_set_rdata_thread_fail_001);
+
+	TCase* tc_set_exclusive = tcase_create ("set-exclusive");
+	suite_add_tcase (s, tc_set_exclusive);
+	tcase_add_checked_fixture (tc_set_exclusive, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_exclusive, test_set_exclusive_pass_001);
+	tcase_add_test (tc_set_exclusive, test_set_exclusive_fail_001);
+
+	TCase* tc_exclusive = tcase_create ("exclusive");
+	suite_add_tcase (s, tc_exclusive);
+	tcase_add_checked_fixture (tc_exclusive, mock_setup, mock_teardown);
+	tcase_add_test (tc_exclusive, test_exclusive_pass_001);
+	tcase_add_test (tc_exclusive, test_exclusive_fail_001);
+
+	TCase* tc_set_rxw_min_sqns = tcase_create ("set-rxw-min-sqns");
+	suite_add_tcase (s, tc_set_rxw_min_sqns);
+	tcase_add_checked_fixture (tc_set_rxw_min_sqns, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_rxw_min_sqns, test_set_rxw_min_sqns_pass_001);
+	tcase_add_test (tc_set_rxw_min_sqns, test_set_rxw_min_sqns_fail_001);
+
+	TCase* tc_set_rxw_shrink = tcase_create ("set-rxw-shrink");
+	suite_add_tcase (s, tc_set_rxw_shrink);
+	tcase_add_checked_fixture (tc_set_rxw_shrink, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_rxw_shrink, test_set_rxw_shrink_pass_001);
+	tcase_add_test (tc_set_rxw_shrink, test_set_rxw_shrink_fail_001);
+
+	TCase* tc_set_txw_slots = tcase_create ("set-txw-slots");
+	suite_add_tcase (s, tc_set_txw_slots);
+	tcase_add_checked_fixture (tc_set_txw_slots, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_txw_slots, test_set_txw_slots_pass_001);
+	tcase_add_test (tc_set_txw_slots, test_set_txw_slots_fail_001);
+
+	TCase* tc_set_hugetlb = tcase_create ("set-hugetlb");
+	suite_add_tcase (s, tc_set_hugetlb);
+	tcase_add_checked_fixture (tc_set_hugetlb, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_hugetlb, test_set_hugetlb_pass_001);
+	tcase_add_test (tc_set_hugetlb, test_set_hugetlb_fail_001);
+
+	TCase* tc_set_mlock = tcase_create ("set-mlock");
+	suite_add_tcase (s, tc_set_mlock);
+	tcase_add_checked_fixture (tc_set_mlock, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_mlock, test_set_mlock_pass_001);
+	tcase_add_test (tc_set_mlock, test_set_mlock_fail_001);
+
+	TCase* tc_set_numa_node = tcase_create ("set-numa-node");
+	suite_add_tcase (s, tc_set_numa_node);
+	tcase_add_checked_fixture (tc_set_numa_node, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_numa_node, test_set_numa_node_pass_001);
+	tcase_add_test (tc_set_numa_node, test_set_numa_node_fail_001);
+
+	TCase* tc_set_coalesce = tcase_create ("set-coalesce");
+	suite_add_tcase (s, tc_set_coalesce);
+	tcase_add_checked_fixture (tc_set_coalesce, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_coalesce, test_set_coalesce_pass_001);
+	tcase_add_test (tc_set_coalesce, test_set_coalesce_fail_001);
+
+	TCase* tc_set_txtime = tcase_create ("set-txtime");
+	suite_add_tcase (s, tc_set_txtime);
+	tcase_add_checked_fixture (tc_set_txtime, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_txtime, test_set_txtime_pass_001);
+	tcase_add_test (tc_set_txtime, test_set_txtime_fail_001);
+
+	TCase* tc_set_tx_priority = tcase_create ("set-tx-priority");
+	suite_add_tcase (s, tc_set_tx_priority);
+	tcase_add_checked_fixture (tc_set_tx_priority, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_tx_priority, test_set_tx_priority_pass_001);
+	tcase_add_test (tc_set_tx_priority, test_set_tx_priority_fail_001);
+
+	TCase* tc_set_rdata_share = tcase_create ("set-rdata-share");
+	suite_add_tcase (s, tc_set_rdata_share);
+	tcase_add_checked_fixture (tc_set_rdata_share, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_rdata_share, test_set_rdata_share_pass_001);
+	tcase_add_test (tc_set_rdata_share, test_set_rdata_share_fail_001);
+
+	TCase* tc_set_nak_adaptive = tcase_create ("set-nak-adaptive");
+	suite_add_tcase (s, tc_set_nak_adaptive);
+	tcase_add_checked_fixture (tc_set_nak_adaptive, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_nak_adaptive, test_set_nak_adaptive_pass_001);
+	tcase_add_test (tc_set_nak_adaptive, test_set_nak_adaptive_fail_001);
+
+	TCase* tc_set_nak_population = tcase_create ("set-nak-population");
+	suite_add_tcase (s, tc_set_nak_population);
+	tcase_add_checked_fixture (tc_set_nak_population, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_nak_population, test_set_nak_population_pass_001);
+	tcase_add_test (tc_set_nak_population, test_set_nak_population_fail_001);
+
+	TCase* tc_set_latency_budget = tcase_create ("set-latency-budget");
+	suite_add_tcase (s, tc_set_latency_budget);
+	tcase_add_checked_fixture (tc_set_latency_budget, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_latency_budget, test_set_latency_budget_pass_001);
+	tcase_add_test (tc_set_latency_budget, test_set_latency_budget_fail_001);
+
+	TCase* tc_set_unordered = tcase_create ("set-unordered");
+	suite_add_tcase (s, tc_set_unordered);
+	tcase_add_checked_fixture (tc_set_unordered, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_unordered, test_set_unordered_pass_001);
+	tcase_add_test (tc_set_unordered, test_set_unordered_fail_001);
+
+	TCase* tc_set_recv_quantum = tcase_create ("set-recv-quantum");
+	suite_add_tcase (s, tc_set_recv_quantum);
+	tcase_add_checked_fixture (tc_set_recv_quantum, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_recv_quantum, test_set_recv_quantum_pass_001);
+	tcase_add_test (tc_set_recv_quantum, test_set_recv_quantum_fail_001);
+
+	TCase* tc_set_peer_weight = tcase_create ("set-peer-weight");
+	suite_add_tcase (s, tc_set_peer_weight);
+	tcase_add_checked_fixture (tc_set_peer_weight, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_peer_weight, test_set_peer_weight_pass_001);
+	tcase_add_test (tc_set_peer_weight, test_set_peer_weight_fail_001);
+
+	TCase* tc_set_flightrec = tcase_create ("set-flightrec");
+	suite_add_tcase (s, tc_set_flightrec);
+	tcase_add_checked_fixture (tc_set_flightrec, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_flightrec, test_set_flightrec_pass_001);
+	tcase_add_test (tc_set_flightrec, test_set_flightrec_fail_001);
+
+	TCase* tc_get_peers = tcase_create ("get-peers");
+	suite_add_tcase (s, tc_get_peers);
+	tcase_add_checked_fixture (tc_get_peers, mock_setup, mock_teardown);
+	tcase_add_test (tc_get_peers, test_get_peers_pass_001);
+	tcase_add_test (tc_get_peers, test_get_peers_fail_001);
+
+	TCase* tc_get_peer_stats = tcase_create ("get-peer-stats");
+	suite_add_tcase (s, tc_get_peer_stats);
+	tcase_add_checked_fixture (tc_get_peer_stats, mock_setup, mock_teardown);
+	tcase_add_test (tc_get_peer_stats, test_get_peer_stats_fail_001);
+
+	TCase* tc_set_zerocopy = tcase_create ("set-zerocopy");
+	suite_add_tcase (s, tc_set_zerocopy);
+	tcase_add_checked_fixture (tc_set_zerocopy, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_zerocopy, test_set_zerocopy_pass_001);
+	tcase_add_test (tc_set_zerocopy, test_set_zerocopy_fail_001);
+
+	TCase* tc_set_skb_pool_memory = tcase_create ("set-skb-pool-memory");
+	suite_add_tcase (s, tc_set_skb_pool_memory);
+	tcase_add_checked_fixture (tc_set_skb_pool_memory, mock_setup, mock_teardown);
+	tcase_add_test (tc_set_skb_pool_memory, test_set_skb_pool_memory_pass_001);
+	tcase_add_test (tc_set_skb_pool_memory, test_set_skb_pool_memory_fail_001);
+
 	return s;
 }
 
@@ -1305,11 +4192,13 @@ main (void)
 	pgm_rand_init();
 	pgm_thread_init();
 	pgm_rwlock_init (&pgm_sock_list_lock);
+	pgm_sock_registry_init();
 	SRunner* sr = srunner_create (make_master_suite ());
 	srunner_add_suite (sr, make_test_suite ());
 	srunner_run_all (sr, CK_ENV);
 	int number_failed = srunner_ntests_failed (sr);
 	srunner_free (sr);
+	pgm_sock_registry_shutdown();
 	pgm_rwlock_free (&pgm_sock_list_lock);
 	pgm_thread_shutdown();
 	pgm_rand_shutdown();
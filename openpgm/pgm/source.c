@@ -23,13 +23,26 @@
 #	include <config.h>
 #endif
 #include <errno.h>
+#ifndef _WIN32
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#else
+#	include <io.h>
+#endif
 #include <impl/i18n.h>
 #include <impl/framework.h>
+#include <impl/engine.h>
 #include <impl/socket.h>
 #include <impl/source.h>
+#include <impl/timer.h>
 #include <impl/sqn_list.h>
 #include <impl/packet_parse.h>
 #include <impl/net.h>
+#include <impl/txlog.h>
+#include <impl/standby.h>
+#include <impl/flightrec.h>
+#include <impl/tfmcc.h>
 
 
 //#define SOURCE_DEBUG
@@ -45,30 +58,99 @@ static inline bool peer_is_peer (const pgm_peer_t*) PGM_GNUC_CONST;
 static void reset_heartbeat_spm (pgm_sock_t*const, const pgm_time_t);
 static bool send_ncf (pgm_sock_t*const restrict, const struct sockaddr*const restrict, const struct sockaddr*const restrict, const uint32_t, const bool);
 static bool send_ncf_list (pgm_sock_t*const restrict, const struct sockaddr*const restrict, const struct sockaddr*const restrict, struct pgm_sqn_list_t*const restrict, const bool);
+static bool send_ncf_range (pgm_sock_t*const restrict, const struct sockaddr*const restrict, const struct sockaddr*const restrict, const struct pgm_sqn_range_list_t*const restrict);
+static void ncf_batch_push (pgm_sock_t*const restrict, const struct sockaddr*const restrict, const struct pgm_sqn_list_t*const restrict, const bool);
+static bool on_nak_range (pgm_sock_t*const restrict, const struct sockaddr*const restrict, const struct sockaddr*const restrict, const struct sockaddr*const restrict, const struct pgm_nak_range*restrict, const unsigned, const pgm_time_t);
 static int send_odata (pgm_sock_t*const restrict, struct pgm_sk_buff_t*const restrict, size_t*restrict);
-static int send_odata_copy (pgm_sock_t*const restrict, const void*restrict, const uint16_t, size_t*restrict);
+static struct pgm_sk_buff_t* build_odata_copy (pgm_sock_t*const restrict, const void*restrict, const uint16_t, const bool, uint32_t*restrict);
+static int send_odata_copy (pgm_sock_t*const restrict, const void*restrict, const uint16_t, const bool, size_t*restrict);
 static int send_odatav (pgm_sock_t*const restrict, const struct pgm_iovec*const restrict, const unsigned, size_t*restrict);
-static bool send_rdata (pgm_sock_t*restrict, struct pgm_sk_buff_t*restrict);
+static bool send_odata_batch (pgm_sock_t*const restrict, const bool, size_t*restrict, unsigned*restrict, size_t*restrict);
+static bool send_rdata (pgm_sock_t*restrict, struct pgm_sk_buff_t*restrict, const bool);
+static unsigned send_rdatav (pgm_sock_t*restrict, struct pgm_sk_buff_t**restrict, unsigned, const bool);
+static bool send_deferred_rdata (pgm_sock_t*const, const bool);
+static bool send_scheduled_rdata (pgm_sock_t*const, const bool);
+static void tx_sched_credit (pgm_sock_t*const, const int32_t);
+static void tx_sched_odata (pgm_sock_t*const, const size_t);
+static void adapt_proactive_parity (pgm_sock_t*);
+static bool fec_thread_push (pgm_sock_t*const, const uint32_t);
+static void source_timer_add (pgm_sock_t*const, pgm_time_t*const, const pgm_time_t);
+static void rdata_thread_notify (pgm_sock_t*const);
+static int send_locked (pgm_sock_t*const restrict, const void*restrict, const size_t, size_t*restrict);
+#ifndef _WIN32
+static void* fec_routine (void*);
+static void* rdata_routine (void*);
+static void* async_routine (void*);
+#else
+static unsigned __stdcall fec_routine (void*);
+static unsigned __stdcall rdata_routine (void*);
+static unsigned __stdcall async_routine (void*);
+#endif
 
 
-static inline
-unsigned
-_pgm_popcount (
-	uint32_t		n
-	)
-{
-#if (__GNUC__ > 3) || (__GNUC__ == 3 && __GNUC_MINOR__ >= 4)
-	return __builtin_popcount (n);
-#elif defined(_MSC_VER)
-#	include <intrin.h>
-	return __popcnt (n);
+/* pipelined proactive parity, transmission groups closed by the send path
+ * queued for the encoder thread.
+ */
+
+struct pgm_fec_thread_t {
+#ifndef _WIN32
+	pthread_t		thread;
 #else
-/* MIT HAKMEM 169 */
-	const uint32_t t = n - ((n >> 1) & 033333333333)
-			     - ((n >> 2) & 011111111111);
-	return ((t + (t >> 3) & 030707070707)) % 63;
+	HANDLE			thread;
 #endif
-}
+	pgm_mutex_t		mutex;
+	pgm_cond_t		cond;
+	bool			is_terminated;
+	unsigned		head;
+	unsigned		len;
+	uint32_t		tg_sqns[ PGM_FEC_THREAD_QUEUE_MAX ];
+	struct pgm_sk_buff_t**	odata_skbs;		/* k references */
+	struct pgm_sk_buff_t**	parity_skbs;		/* proactive h packets */
+};
+
+/* repair data sent as NAKs arrive, independent of the application calling
+ * into the receive path.
+ */
+
+struct pgm_rdata_thread_t {
+#ifndef _WIN32
+	pthread_t		thread;
+#else
+	HANDLE			thread;
+#endif
+	pgm_mutex_t		mutex;
+	pgm_cond_t		cond;
+	bool			is_terminated;
+	bool			is_pending;		/* retransmit requests queued */
+};
+
+/* APDUs of pgm_send() with PGM_SEND_ASYNC, copied into a bounded ring by the
+ * application threads and sent in order by one sender thread.  a producer
+ * reserves a slot by advancing head and publishes the APDU into it, the
+ * sender empties the slot before advancing tail.
+ */
+
+struct pgm_async_apdu_t {
+	size_t			length;
+	char			data[];
+};
+
+struct pgm_async_thread_t {
+#ifndef _WIN32
+	pthread_t		thread;
+#else
+	HANDLE			thread;
+#endif
+	pgm_mutex_t		mutex;
+	pgm_cond_t		cond;
+	bool			is_terminated;
+	volatile uint32_t	is_idle;		/* sender waiting on cond */
+	volatile uint32_t	head;			/* next slot reserved */
+	volatile uint32_t	tail;			/* next slot sent */
+	uint32_t		mask;			/* ring length minus one */
+	struct pgm_async_apdu_t* volatile* ring;
+};
+
 
 static inline
 bool
@@ -97,6 +179,110 @@ reset_spmr_timer (
 	peer->spmr_expiry = 0;
 }
 
+/* record the length of an original data send stopped by the rate limit for
+ * PGM_RATE_REMAIN, and wake the event socket once the limit has passed.
+ */
+
+static inline
+void
+odata_rate_limited (
+	pgm_sock_t* const	sock,
+	const size_t		blocklen
+	)
+{
+	sock->blocklen = blocklen;
+	if (INVALID_SOCKET != sock->event_timer_fd)
+		pgm_timer_event_rate (sock, pgm_time_update_now() + pgm_rate_remaining2 (&sock->rate_control, &sock->odata_rate_control, blocklen));
+}
+
+/* a send held up for PGMCC tokens, the stall lasts until a token is next
+ * taken.  original and repair data may stall concurrently.
+ */
+
+static inline
+void
+congestion_stall_begin (
+	pgm_sock_t* const	sock
+	)
+{
+	if (0 == pgm_atomic_read64 (&sock->congestion_stall_start) &&
+	    pgm_atomic_compare_and_exchange64 (&sock->congestion_stall_start, 0, pgm_time_update_now()))
+		pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_CONGESTION_STALLS], 1);
+}
+
+static inline
+void
+congestion_stall_end (
+	pgm_sock_t* const	sock
+	)
+{
+	const pgm_time_t stall_start = pgm_atomic_read64 (&sock->congestion_stall_start);
+	if (PGM_LIKELY(0 == stall_start) ||
+	    !pgm_atomic_compare_and_exchange64 (&sock->congestion_stall_start, stall_start, 0))
+		return;
+	const pgm_time_t now = pgm_time_update_now();
+	const pgm_time_t stalled = now > stall_start ? now - stall_start : 0;
+	pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_CONGESTION_STALL_USECS], stalled);
+	PGM_HISTOGRAM_COUNTS("Tx.CongestionStallUsecs", (int)MIN(stalled, INT_MAX));
+}
+
+/* oldest sequence available for repair, the trail of the transmit log when
+ * spilling, otherwise of the transmit window.
+ */
+
+static inline
+uint32_t
+source_trail (
+	const pgm_sock_t*	sock
+	)
+{
+	if (NULL != sock->txlog && !pgm_txlog_is_empty (sock->txlog))
+		return pgm_atomic_read32 (&sock->txlog->trail);
+	return pgm_txw_trail_atomic (sock->window);
+}
+
+/* destination group of original data, with PGM_SEND_STRIPE runs of one
+ * transmit batch rotate across the send group and each stripe group.
+ */
+
+static inline
+const struct sockaddr*
+odata_group (
+	const pgm_sock_t*	 const restrict sock,
+	const struct pgm_sk_buff_t* const restrict skb
+	)
+{
+	if (PGM_LIKELY(0 == sock->send_stripe_len))
+		return (const struct sockaddr*)&sock->send_gsr.gsr_group;
+	const uint32_t run = pgm_ntohl (skb->pgm_data->data_sqn) / sock->tx_batch_size;
+	const unsigned stripe = run % (sock->send_stripe_len + 1);
+	if (0 == stripe)
+		return (const struct sockaddr*)&sock->send_gsr.gsr_group;
+	return (const struct sockaddr*)&sock->send_stripe[ stripe - 1 ];
+}
+
+/* NAKs and NNAKs may name any group carrying original data, including the
+ * group of a redundant path.
+ */
+
+static
+bool
+is_send_group (
+	const pgm_sock_t*      const restrict sock,
+	const struct sockaddr* const restrict group
+	)
+{
+	if (0 == pgm_sockaddr_cmp (group, (const struct sockaddr*)&sock->send_gsr.gsr_group))
+		return TRUE;
+	for (unsigned i = 0; i < sock->send_stripe_len; i++)
+		if (0 == pgm_sockaddr_cmp (group, (const struct sockaddr*)&sock->send_stripe[ i ]))
+			return TRUE;
+	for (unsigned i = 0; i < sock->send_path_len; i++)
+		if (0 == pgm_sockaddr_cmp (group, (const struct sockaddr*)&sock->send_path[ i ].gr_group))
+			return TRUE;
+	return FALSE;
+}
+
 static inline
 size_t
 source_max_tsdu (
@@ -107,9 +293,45 @@ source_max_tsdu (
 	size_t max_tsdu = can_fragment ? sock->max_tsdu_fragment : sock->max_tsdu;
 	if (sock->use_var_pktlen /* OPT_VAR_PKT_LEN */)
 		max_tsdu -= sizeof (uint16_t);
+	if (sock->fec_idle_ivl /* OPT_CURR_TGSIZE of partial parity */)
+		max_tsdu -= sizeof (struct pgm_opt_length) + sizeof (struct pgm_opt_header) + sizeof (struct pgm_opt_curr_tgsize);
 	return max_tsdu;
 }
 
+/* apply a path MTU from the last closed POLL round or lowered on EMSGSIZE,
+ * between APDUs and not within a transmission group of parity.  a TPDU is
+ * kept large enough for one byte of a fragment.
+ */
+
+static
+void
+source_update_path_mtu (
+	pgm_sock_t* const	sock
+	)
+{
+	if (PGM_LIKELY(!sock->use_pmtud) ||
+	    PGM_LIKELY(sock->pmtu_target == sock->path_mtu) ||
+	    !sock->is_bound ||
+	    sock->use_proactive_parity || sock->use_ondemand_parity)
+		return;
+
+	pgm_sock_mutex_lock (sock, &sock->source_mutex);
+	if (!sock->is_apdu_eagain && 0 == sock->coalesce_len)
+	{
+		const sa_family_t pgmcc_family = sock->use_pgmcc ? sock->family : 0;
+		const size_t min_tpdu = sock->iphdr_len + pgm_data_trailer_len (sock) + 1 +
+					MAX(pgm_pkt_offset (TRUE, pgmcc_family), pgm_coalesce_pkt_offset (pgmcc_family));
+		const uint16_t path_mtu = (uint16_t)MIN(MAX((size_t)sock->pmtu_target, min_tpdu), (size_t)sock->pmtu_ceiling);
+		if (path_mtu != sock->path_mtu) {
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Path MTU %u bytes, was %u bytes."),
+				   (unsigned)path_mtu, (unsigned)sock->path_mtu);
+			pgm_sock_set_path_mtu (sock, path_mtu);
+		}
+		sock->pmtu_target = sock->path_mtu;
+	}
+	pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+}
+
 /* prototype of function to send pro-active parity NAKs.
  */
 
@@ -121,13 +343,90 @@ pgm_schedule_proactive_nak (
 	)
 {
 	pgm_return_val_if_fail (NULL != sock, FALSE);
+	if (sock->use_adaptive_parity)
+		adapt_proactive_parity (sock);
+	const uint8_t rs_h = sock->rs_proactive_h;
+	if (0 == rs_h)
+		return TRUE;
+/* packet count encoded as per parity NAKs, count minus one */
+	nak_tg_sqn |= rs_h - 1;
+/* hand off to encoder thread, inline on the next timer pass when saturated */
+	if (NULL != sock->fec_thread &&
+	    fec_thread_push (sock, nak_tg_sqn))
+		return TRUE;
 	const bool status = pgm_txw_retransmit_push (sock->window,
-						     nak_tg_sqn | sock->rs_proactive_h,
+						     nak_tg_sqn,
 						     TRUE /* is_parity */,
 						     sock->tg_sqn_shift);
+	if (status && NULL != sock->rdata_thread)
+		rdata_thread_notify (sock);
 	return status;
 }
 
+/* original data skb has been sent, proactive parity follows the last packet of
+ * a transmission group.  a partial group is covered by the timer once the
+ * source idles for PGM_FEC_IDLE_IVL, armed by the first packet after each
+ * flush and pushed back by the timer whilst data continues.  caller holds
+ * source_mutex.
+ */
+
+static inline
+void
+source_odata_sent (
+	pgm_sock_t*		    const restrict sock,
+	const struct pgm_sk_buff_t* const restrict skb
+	)
+{
+	const uint32_t odata_sqn = pgm_ntohl (skb->pgm_data->data_sqn);
+	const uint32_t tg_sqn_mask = 0xffffffff << sock->tg_sqn_shift;
+	if (!((odata_sqn + 1) & ~tg_sqn_mask))
+		pgm_schedule_proactive_nak (sock, odata_sqn & tg_sqn_mask);
+	else if (sock->fec_idle_ivl && 0 == sock->fec_idle_expiry)
+		source_timer_add (sock, &sock->fec_idle_expiry, skb->tstamp + sock->fec_idle_ivl);
+}
+
+/* re-evaluate proactive parity packets per transmission group once every
+ * interval of groups.  NAKs arriving despite proactive parity raise the count by
+ * the residual loss per group, the loss rate of the elected ACKer or of the
+ * worst receiver from general polling sets a floor, and
+ * each quiet interval decays the count by one packet.
+ */
+
+static
+void
+adapt_proactive_parity (
+	pgm_sock_t*		sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (sock->use_adaptive_parity);
+
+	if (++sock->adaptive_tg_count < PGM_ADAPTIVE_PARITY_INTERVAL)
+		return;
+
+	const uint32_t naks = sock->adaptive_nak_count;
+	const uint32_t tgs  = sock->adaptive_tg_count;
+	sock->adaptive_nak_count = sock->adaptive_tg_count = 0;
+
+/* expected losses per transmission group reported by ACKer or the worst
+ * POLR of the last poll round, rounded up */
+	const uint32_t loss_rate = MAX(sock->acker_loss_rate, sock->poll_loss_rate);
+	const uint32_t acker_h = (loss_rate * sock->rs_k + UINT16_MAX - 1) / UINT16_MAX;
+	uint32_t rs_h;
+	if (naks > 0)
+		rs_h = MAX(sock->rs_proactive_h + (naks + tgs - 1) / tgs, acker_h);
+	else
+		rs_h = MAX(sock->rs_proactive_h > 0 ? sock->rs_proactive_h - 1 : 0, acker_h);
+	rs_h = MAX(sock->rs_proactive_h_min, MIN(rs_h, sock->rs_proactive_h_max));
+
+	if (rs_h != sock->rs_proactive_h) {
+		pgm_trace (PGM_LOG_ROLE_FEC,_("Proactive parity adjusted from %u to %u packets per transmission group."),
+			   (unsigned)sock->rs_proactive_h, (unsigned)rs_h);
+		sock->rs_proactive_h = (uint8_t)rs_h;
+	}
+}
+
 /* a deferred request for RDATA, now processing in the timer thread, we check the transmit
  * window to see if the packet exists and forward on, maintaining a lock until the queue is
  * empty.
@@ -141,11 +440,119 @@ pgm_on_deferred_nak (
 	pgm_sock_t* const	sock
 	)
 {
-	struct pgm_sk_buff_t* skb;
-
 /* pre-conditions */
 	pgm_assert (NULL != sock);
 
+	if (!send_scheduled_rdata (sock, sock->is_nonblocking)) {
+		pgm_notify_send (&sock->rdata_notify);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* transmit scheduler with PGM_TX_PRIORITY, SPM ahead of RDATA ahead of ODATA.
+ * repairs are sent by one thread at a time, whether the receive path, the
+ * repair thread, or the send path draining the retransmit queue before new
+ * original data.  with PGM_RDATA_SHARE below 100 repairs yield to waiting
+ * original data once their share of the payload bytes is spent.
+ *
+ * returns TRUE on success, returns FALSE if operation would block or repairs
+ * are deferred to another thread.
+ */
+
+static
+bool
+send_scheduled_rdata (
+	pgm_sock_t* const	sock,
+	const bool		is_nonblocking
+	)
+{
+	bool is_sent;
+
+	if (!sock->use_tx_priority)
+		return send_deferred_rdata (sock, is_nonblocking);
+
+/* original data waiting beyond its share drains repairs on the send path */
+	if (sock->rdata_share < 100 &&
+	    sock->is_apdu_eagain &&
+	    (int32_t)pgm_atomic_read32 (&sock->rdata_credit) <= 0)
+		return FALSE;
+	if (!pgm_atomic_compare_and_exchange32 (&sock->is_rdata_busy, 0, 1))
+		return FALSE;
+	is_sent = send_deferred_rdata (sock, is_nonblocking);
+	pgm_atomic_write32 (&sock->is_rdata_busy, 0);
+	return is_sent;
+}
+
+/* adjust the signed byte credit of repair data against original data, bound
+ * to a burst of PGM_TX_SCHED_BURST packets either way.
+ */
+
+static
+void
+tx_sched_credit (
+	pgm_sock_t* const	sock,
+	const int32_t		delta
+	)
+{
+	const int32_t bound = (int32_t)(PGM_TX_SCHED_BURST * sock->max_tpdu);
+	uint32_t credit;
+	int32_t value;
+
+	if (sock->rdata_share >= 100)
+		return;
+	do {
+		credit = pgm_atomic_read32 (&sock->rdata_credit);
+		value = (int32_t)credit + delta;
+		value = MAX( -bound, MIN( value, bound ) );
+	} while (!pgm_atomic_compare_and_exchange32 (&sock->rdata_credit, credit, (uint32_t)value));
+}
+
+/* called by the send path ahead of each APDU, under the source mutex, earning
+ * repair credit in proportion to the original data and sending pending repairs
+ * first without blocking.
+ */
+
+static
+void
+tx_sched_odata (
+	pgm_sock_t* const	sock,
+	const size_t		apdu_length
+	)
+{
+	if (sock->rdata_share < 100) {
+		const uint64_t earned = (uint64_t)apdu_length * sock->rdata_share / (100 - sock->rdata_share);
+		tx_sched_credit (sock, (int32_t)MIN( earned, (uint64_t)INT32_MAX ));
+	}
+	if (pgm_txw_retransmit_is_empty (sock->window) ||
+	    !pgm_atomic_compare_and_exchange32 (&sock->is_rdata_busy, 0, 1))
+		return;
+	while (!pgm_txw_retransmit_is_empty (sock->window) &&
+	       (sock->rdata_share >= 100 || (int32_t)pgm_atomic_read32 (&sock->rdata_credit) > 0))
+	{
+		if (!send_deferred_rdata (sock, TRUE)) {
+			pgm_notify_send (&sock->rdata_notify);
+			break;
+		}
+	}
+	pgm_atomic_write32 (&sock->is_rdata_busy, 0);
+}
+
+/* send repair data of the oldest retransmit request, or a run of selective
+ * requests when batching.
+ *
+ * returns TRUE on success, returns FALSE if operation would block.
+ */
+
+static
+bool
+send_deferred_rdata (
+	pgm_sock_t* const	sock,
+	const bool		is_nonblocking
+	)
+{
+	struct pgm_sk_buff_t* skb;
+
 /* We can flush queue and block all odata, or process one set, or process each
  * sequence number individually.
  */
@@ -158,1022 +565,3547 @@ pgm_on_deferred_nak (
 /* peek from the retransmit queue so we can eliminate duplicate NAKs up until the repair packet
  * has been retransmitted.
  */
-	pgm_spinlock_lock (&sock->txw_spinlock);
+	pgm_sock_spinlock_lock (sock, &sock->txw_spinlock);
+/* drain a run of selective requests with one system call */
+	if (sock->tx_batch_size > 1) {
+		struct pgm_sk_buff_t** skbs = pgm_newa (struct pgm_sk_buff_t*, sock->tx_batch_size);
+		const unsigned count = pgm_txw_retransmit_try_peekv (sock->window, skbs, sock->tx_batch_size);
+		if (count > 1) {
+			for (unsigned i = 0; i < count; i++)
+				pgm_skb_get (skbs[i]);
+			pgm_sock_spinlock_unlock (sock, &sock->txw_spinlock);
+			const unsigned sent = send_rdatav (sock, skbs, count, is_nonblocking);
+			for (unsigned i = 0; i < count; i++)
+				pgm_free_skb (skbs[i]);
+			for (unsigned i = 0; i < sent; i++)
+				pgm_txw_retransmit_remove_head (sock->window);
+			return (sent == count);
+		}
+	}
 	skb = pgm_txw_retransmit_try_peek (sock->window);
 	if (skb) {
 		skb = pgm_skb_get (skb);
-		pgm_spinlock_unlock (&sock->txw_spinlock);
-		if (!send_rdata (sock, skb)) {
+		pgm_sock_spinlock_unlock (sock, &sock->txw_spinlock);
+		if (!send_rdata (sock, skb, is_nonblocking)) {
 			pgm_free_skb (skb);
-			pgm_notify_send (&sock->rdata_notify);
 			return FALSE;
 		}
 		pgm_free_skb (skb);
 /* now remove sequence number from retransmit queue, re-enabling NAK processing for this sequence number */
 		pgm_txw_retransmit_remove_head (sock->window);
 	} else
-		pgm_spinlock_unlock (&sock->txw_spinlock);
+		pgm_sock_spinlock_unlock (sock, &sock->txw_spinlock);
 	return TRUE;
 }
 
-/* SPMR indicates if multicast to cancel own SPMR, or unicast to send SPM.
- *
- * rate limited to 1/IHB_MIN per TSI (13.4).
+/* start encoder thread for proactive parity, called by pgm_bind() after the
+ * transmit window is created.
  *
- * if SPMR was valid, returns TRUE, if invalid returns FALSE.
+ * returns TRUE on success, returns FALSE if the thread cannot be created and
+ * parity remains generated by the timer thread.
  */
 
 PGM_GNUC_INTERNAL
 bool
-pgm_on_spmr (
-	pgm_sock_t*           const restrict sock,
-	pgm_peer_t*	      const restrict peer,	/* maybe NULL if socket is source */
-	struct pgm_sk_buff_t* const restrict skb
+pgm_fec_thread_create (
+	pgm_sock_t* const	sock
 	)
 {
+	struct pgm_fec_thread_t* fec;
+
 /* pre-conditions */
 	pgm_assert (NULL != sock);
-	pgm_assert (NULL != skb);
-
-	pgm_debug ("pgm_on_spmr (sock:%p peer:%p skb:%p)",
-		(void*)sock, (void*)peer, (void*)skb);
-
-	if (PGM_UNLIKELY(!pgm_verify_spmr (skb))) {
-		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed SPMR rejected."));
+	pgm_assert (NULL != sock->window);
+	pgm_assert (sock->use_proactive_parity);
+	pgm_assert (sock->rs_proactive_h_max > 0);
+	pgm_assert (NULL == sock->fec_thread);
+
+	fec = pgm_new0 (struct pgm_fec_thread_t, 1);
+	pgm_mutex_init (&fec->mutex);
+	pgm_cond_init (&fec->cond);
+	fec->odata_skbs = pgm_new0 (struct pgm_sk_buff_t*, sock->rs_k);
+	fec->parity_skbs = pgm_new (struct pgm_sk_buff_t*, sock->rs_proactive_h_max);
+	for (unsigned i = 0; i < sock->rs_proactive_h_max; i++)
+		fec->parity_skbs[i] = pgm_alloc_skb (sock->max_tpdu);
+	sock->fec_thread = fec;
+
+#ifndef _WIN32
+	const int status = pthread_create (&fec->thread, NULL, &fec_routine, sock);
+	if (0 != status) {
+#else
+	fec->thread = (HANDLE)_beginthreadex (NULL, 0, &fec_routine, sock, 0, NULL);
+	if (0 == fec->thread) {
+#endif /* _WIN32 */
+		pgm_trace (PGM_LOG_ROLE_FEC,_("Creating FEC encoder thread failed, parity remains on timer thread."));
+		sock->fec_thread = NULL;
+		for (unsigned i = 0; i < sock->rs_proactive_h_max; i++)
+			pgm_free_skb (fec->parity_skbs[i]);
+		pgm_free (fec->parity_skbs);
+		pgm_free (fec->odata_skbs);
+		pgm_cond_free (&fec->cond);
+		pgm_mutex_free (&fec->mutex);
+		pgm_free (fec);
 		return FALSE;
 	}
-
-	if (peer_is_source (peer)) {
-		const bool send_status = pgm_send_spm (sock, 0);
-		if (PGM_UNLIKELY(!send_status)) {
-			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Failed to send SPM on SPM-Request."));
-		}
-	} else {
-		pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Suppressing SPMR due to peer multicast SPMR."));
-		reset_spmr_timer (peer);
-	}
 	return TRUE;
 }
 
-/* Process opt_pgmcc_feedback PGM option that ships attached to ACK or NAK.
- * Contents use to elect best ACKer.
- *
- * returns TRUE if peer is the elected ACKer.
+/* stop encoder thread, pending transmission groups are discarded.  called by
+ * pgm_close() before the transmit window is destroyed.
  */
 
-static
-bool
-on_opt_pgmcc_feedback (
-	pgm_sock_t*           	       const restrict sock,
-	const struct pgm_sk_buff_t*    const restrict skb,
-	const struct pgm_opt_pgmcc_feedback* restrict opt_pgmcc_feedback
+PGM_GNUC_INTERNAL
+void
+pgm_fec_thread_destroy (
+	pgm_sock_t* const	sock
 	)
 {
-	struct sockaddr_storage peer_nla;
+	struct pgm_fec_thread_t* fec;
 
 /* pre-conditions */
 	pgm_assert (NULL != sock);
-	pgm_assert (NULL != skb);
-	pgm_assert (NULL != opt_pgmcc_feedback);
+	pgm_assert (NULL != sock->fec_thread);
+
+	fec = sock->fec_thread;
+	pgm_mutex_lock (&fec->mutex);
+	fec->is_terminated = TRUE;
+	pgm_cond_signal (&fec->cond);
+	pgm_mutex_unlock (&fec->mutex);
+#ifndef _WIN32
+	pthread_join (fec->thread, NULL);
+#else
+	WaitForSingleObject (fec->thread, INFINITE);
+	CloseHandle (fec->thread);
+#endif
+	sock->fec_thread = NULL;
+	for (unsigned i = 0; i < sock->rs_proactive_h_max; i++)
+		pgm_free_skb (fec->parity_skbs[i]);
+	pgm_free (fec->parity_skbs);
+	pgm_free (fec->odata_skbs);
+	pgm_cond_free (&fec->cond);
+	pgm_mutex_free (&fec->mutex);
+	pgm_free (fec);
+}
 
-	const uint32_t opt_tstamp = pgm_ntohl (opt_pgmcc_feedback->opt_tstamp);
-	const uint16_t opt_loss_rate = pgm_ntohs (opt_pgmcc_feedback->opt_loss_rate);
+/* queue a closed transmission group for the encoder thread, parity packet
+ * count minus one encoded in the sequence number as per parity NAKs.
+ *
+ * returns TRUE on success, returns FALSE if the queue is full.
+ */
 
-	const uint32_t rtt = (uint32_t)(pgm_to_msecs (skb->tstamp) - opt_tstamp);
-	const uint64_t peer_loss = rtt * rtt * opt_loss_rate;
+static
+bool
+fec_thread_push (
+	pgm_sock_t* const	sock,
+	const uint32_t		nak_tg_sqn
+	)
+{
+	struct pgm_fec_thread_t* fec = sock->fec_thread;
+	bool status = FALSE;
+
+	pgm_mutex_lock (&fec->mutex);
+	if (fec->len < PGM_FEC_THREAD_QUEUE_MAX) {
+		fec->tg_sqns[ (fec->head + fec->len++) % PGM_FEC_THREAD_QUEUE_MAX ] = nak_tg_sqn;
+		pgm_cond_signal (&fec->cond);
+		status = TRUE;
+	}
+	pgm_mutex_unlock (&fec->mutex);
+	return status;
+}
 
-	pgm_nla_to_sockaddr (&opt_pgmcc_feedback->opt_nla_afi, (struct sockaddr*)&peer_nla);
+/* encode and transmit proactive parity of one transmission group.  original
+ * packets are referenced so the group survives advancement of the window
+ * trail while encoding, the window lock serialises with the repair path.
+ */
 
-/* ACKer elections */
-	if (PGM_UNLIKELY(pgm_sockaddr_is_addr_unspecified ((const struct sockaddr*)&sock->acker_nla)))
-	{
-		pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("Elected first ACKer"));
-		memcpy (&sock->acker_nla, &peer_nla, pgm_sockaddr_storage_len (&peer_nla));
-	}
-	else if (peer_loss > sock->acker_loss &&
-		 0 != pgm_sockaddr_cmp ((const struct sockaddr*)&peer_nla, (const struct sockaddr*)&sock->acker_nla))
-	{
-		pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("Elected new ACKer"));
-		memcpy (&sock->acker_nla, &peer_nla, pgm_sockaddr_storage_len (&peer_nla));
+static
+void
+fec_send_parity (
+	pgm_sock_t* const	sock,
+	const uint32_t		nak_tg_sqn
+	)
+{
+	struct pgm_fec_thread_t* fec = sock->fec_thread;
+	const uint32_t tg_sqn_mask = 0xffffffff << sock->tg_sqn_shift;
+	const uint32_t tg_sqn = nak_tg_sqn & tg_sqn_mask;
+	const uint8_t count = 1 + (nak_tg_sqn & ~tg_sqn_mask);
+
+	pgm_sock_spinlock_lock (sock, &sock->txw_spinlock);
+	for (unsigned i = 0; i < sock->rs_k; i++) {
+		struct pgm_sk_buff_t* skb = pgm_txw_peek_get (sock->window, tg_sqn + i);
+		if (PGM_UNLIKELY(NULL == skb)) {
+			pgm_sock_spinlock_unlock (sock, &sock->txw_spinlock);
+			pgm_trace (PGM_LOG_ROLE_FEC,_("Transmission group #%" PRIu32 " left transmit window before parity encoding."), tg_sqn);
+			while (i--)
+				pgm_free_skb (fec->odata_skbs[i]);
+			return;
+		}
+		fec->odata_skbs[i] = skb;
 	}
-
-/* update ACKer state */
-	if (0 == pgm_sockaddr_cmp ((const struct sockaddr*)&peer_nla, (const struct sockaddr*)&sock->acker_nla))
-	{
-		sock->acker_loss = peer_loss;
-		return TRUE;
+/* on-demand parity of the group continues after the proactive packets */
+	const uint8_t rs_h = pgm_txw_parity_reserve (sock->window, fec->odata_skbs[0], count);
+	pgm_sock_spinlock_unlock (sock, &sock->txw_spinlock);
+
+	pgm_txw_parity_encode (sock->window, fec->odata_skbs, rs_h, count, fec->parity_skbs);
+	for (unsigned i = 0; i < sock->rs_k; i++)
+		pgm_free_skb (fec->odata_skbs[i]);
+
+/* block on rate regulation, retry on congestion control or full send buffers */
+	for (unsigned j = 0; j < count; j++) {
+		while (!send_rdata (sock, fec->parity_skbs[j], FALSE)) {
+			if (fec->is_terminated)
+				return;
+			pgm_thread_yield ();
+		}
 	}
-
-	return FALSE;
 }
 
-/* NAK requesting RDATA transmission for a sending sock, only valid if
- * sequence number(s) still in transmission window.
- *
- * we can potentially have different IP versions for the NAK packet to the send group.
- *
- * TODO: fix IPv6 AFIs
- *
- * take in a NAK and pass off to an asynchronous queue for another thread to process
+static
+#ifndef _WIN32
+void*
+#else
+unsigned
+__stdcall
+#endif
+fec_routine (
+	void*		arg
+	)
+{
+	pgm_sock_t* sock = arg;
+	struct pgm_fec_thread_t* fec = sock->fec_thread;
+
+	if (sock->numa_node >= 0)
+		pgm_numa_bind_thread (sock->numa_node);
+	pgm_thread_setup ("fec");
+	pgm_mutex_lock (&fec->mutex);
+	for (;;)
+	{
+		while (0 == fec->len && !fec->is_terminated)
+#ifndef _WIN32
+			pgm_cond_wait (&fec->cond, &fec->mutex.pthread_mutex);
+#else
+			pgm_cond_wait (&fec->cond, &fec->mutex.win32_crit);
+#endif
+		if (fec->is_terminated)
+			break;
+		const uint32_t nak_tg_sqn = fec->tg_sqns[ fec->head ];
+		fec->head = (fec->head + 1) % PGM_FEC_THREAD_QUEUE_MAX;
+		fec->len--;
+		pgm_mutex_unlock (&fec->mutex);
+		fec_send_parity (sock, nak_tg_sqn);
+		pgm_mutex_lock (&fec->mutex);
+	}
+	pgm_mutex_unlock (&fec->mutex);
+
+#ifndef _WIN32
+	return NULL;
+#else
+	_endthread();
+	return 0;
+#endif
+}
+
+/* start repair thread, called by pgm_bind() after the transmit window is
+ * created.  the thread becomes the only consumer of the retransmit queue.
  *
- * if NAK is valid, returns TRUE.  on error, FALSE is returned.
+ * returns TRUE on success, returns FALSE if the thread cannot be created and
+ * repairs remain sent from the receive path.
  */
 
 PGM_GNUC_INTERNAL
 bool
-pgm_on_nak (
-	pgm_sock_t*           const restrict sock,
-	struct pgm_sk_buff_t* const restrict skb
+pgm_rdata_thread_create (
+	pgm_sock_t* const	sock
 	)
 {
-	const struct pgm_nak	*nak;
-	const struct pgm_nak6	*nak6;
-	struct sockaddr_storage	 nak_src_nla, nak_grp_nla;
-	const uint32_t		*nak_list = NULL;
-	uint_fast8_t		 nak_list_len = 0;
-	struct pgm_sqn_list_t	 sqn_list;
+	struct pgm_rdata_thread_t* rdata;
 
 /* pre-conditions */
 	pgm_assert (NULL != sock);
-	pgm_assert (NULL != skb);
-
-	pgm_debug ("pgm_on_nak (sock:%p skb:%p)",
-		(const void*)sock, (const void*)skb);
+	pgm_assert (NULL != sock->window);
+	pgm_assert (NULL == sock->rdata_thread);
 
-	const bool is_parity = skb->pgm_header->pgm_options & PGM_OPT_PARITY;
-	if (is_parity) {
-		sock->cumulative_stats[PGM_PC_SOURCE_PARITY_NAKS_RECEIVED]++;
-		if (!sock->use_ondemand_parity) {
-			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Parity NAK rejected as on-demand parity is not enabled."));
-			sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS]++;
-			return FALSE;
-		}
-	} else
-		sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED]++;
+	rdata = pgm_new0 (struct pgm_rdata_thread_t, 1);
+	pgm_mutex_init (&rdata->mutex);
+	pgm_cond_init (&rdata->cond);
+	sock->rdata_thread = rdata;
 
-	if (PGM_UNLIKELY(!pgm_verify_nak (skb))) {
-		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed NAK rejected on verification."));
-		sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS]++;
+#ifndef _WIN32
+	const int status = pthread_create (&rdata->thread, NULL, &rdata_routine, sock);
+	if (0 != status) {
+#else
+	rdata->thread = (HANDLE)_beginthreadex (NULL, 0, &rdata_routine, sock, 0, NULL);
+	if (0 == rdata->thread) {
+#endif /* _WIN32 */
+		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Creating repair thread failed, repairs remain on receive path."));
+		sock->rdata_thread = NULL;
+		pgm_cond_free (&rdata->cond);
+		pgm_mutex_free (&rdata->mutex);
+		pgm_free (rdata);
 		return FALSE;
 	}
+	return TRUE;
+}
 
-	nak  = (struct pgm_nak *)skb->data;
-	nak6 = (struct pgm_nak6*)skb->data;
-		
-/* NAK_SRC_NLA contains our sock unicast NLA */
-	pgm_nla_to_sockaddr (&nak->nak_src_nla_afi, (struct sockaddr*)&nak_src_nla);
+/* stop repair thread, outstanding requests are discarded with the transmit
+ * window.  called by pgm_close() before the transmit window is destroyed.
+ */
 
-/* copy scope id from socket */
-	if (AF_INET6 == sock->family)
-	{
-		((struct sockaddr_in6*)&nak_src_nla)->sin6_scope_id = ((struct sockaddr_in6*)&sock->send_addr)->sin6_scope_id;
-	}
+PGM_GNUC_INTERNAL
+void
+pgm_rdata_thread_destroy (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_rdata_thread_t* rdata;
 
-	if (PGM_UNLIKELY(pgm_sockaddr_cmp ((struct sockaddr*)&nak_src_nla, (struct sockaddr*)&sock->send_addr) != 0))
-	{
-		char saddr[INET6_ADDRSTRLEN];
-		pgm_sockaddr_ntop ((struct sockaddr*)&nak_src_nla, saddr, sizeof(saddr));
-		pgm_trace (PGM_LOG_ROLE_NETWORK,_("NAK rejected for unmatched NLA: %s"), saddr);
-		sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS]++;
-		return FALSE;
-	}
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->rdata_thread);
+
+	rdata = sock->rdata_thread;
+	pgm_mutex_lock (&rdata->mutex);
+	rdata->is_terminated = TRUE;
+	pgm_cond_signal (&rdata->cond);
+	pgm_mutex_unlock (&rdata->mutex);
+#ifndef _WIN32
+	pthread_join (rdata->thread, NULL);
+#else
+	WaitForSingleObject (rdata->thread, INFINITE);
+	CloseHandle (rdata->thread);
+#endif
+	sock->rdata_thread = NULL;
+	pgm_cond_free (&rdata->cond);
+	pgm_mutex_free (&rdata->mutex);
+	pgm_free (rdata);
+}
 
-/* NAK_GRP_NLA containers our sock multicast group */ 
-	pgm_nla_to_sockaddr ((AF_INET6 == nak_src_nla.ss_family) ? &nak6->nak6_grp_nla_afi : &nak->nak_grp_nla_afi, (struct sockaddr*)&nak_grp_nla);
+/* wake the repair thread for newly queued retransmit requests.
+ */
 
-/* copy scope id from multicast socket */
-	if (AF_INET6 == sock->family)
-	{
-		((struct sockaddr_in6*)&nak_grp_nla)->sin6_scope_id = ((struct sockaddr_in6*)&sock->send_gsr.gsr_group)->sin6_scope_id;
-	}
+static
+void
+rdata_thread_notify (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_rdata_thread_t* rdata = sock->rdata_thread;
 
-	if (PGM_UNLIKELY(pgm_sockaddr_cmp ((struct sockaddr*)&nak_grp_nla, (struct sockaddr*)&sock->send_gsr.gsr_group) != 0))
-	{
-		char sgroup[INET6_ADDRSTRLEN];
-		pgm_sockaddr_ntop ((struct sockaddr*)&nak_src_nla, sgroup, sizeof(sgroup));
-		pgm_trace (PGM_LOG_ROLE_NETWORK,_("NAK rejected as targeted for different multicast group: %s"), sgroup);
-		sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS]++;
-		return FALSE;
+	pgm_mutex_lock (&rdata->mutex);
+	if (!rdata->is_pending) {
+		rdata->is_pending = TRUE;
+		pgm_cond_signal (&rdata->cond);
 	}
+	pgm_mutex_unlock (&rdata->mutex);
+}
 
-/* create queue object */
-	sqn_list.sqn[0] = pgm_ntohl (nak->nak_sqn);
-	sqn_list.len = 1;
-
-	pgm_debug ("nak_sqn %" PRIu32, sqn_list.sqn[0]);
+/* drain the retransmit queue with blocking rate regulation, retry on
+ * congestion control or full send buffers.
+ */
 
-/* check NAK list */
-	if (skb->pgm_header->pgm_options & PGM_OPT_PRESENT)
+static
+#ifndef _WIN32
+void*
+#else
+unsigned
+__stdcall
+#endif
+rdata_routine (
+	void*		arg
+	)
+{
+	pgm_sock_t* sock = arg;
+	struct pgm_rdata_thread_t* rdata = sock->rdata_thread;
+
+	if (sock->numa_node >= 0)
+		pgm_numa_bind_thread (sock->numa_node);
+	pgm_thread_setup ("rdata");
+	pgm_mutex_lock (&rdata->mutex);
+	for (;;)
 	{
-		const struct pgm_opt_header *opt_header;
-		const struct pgm_opt_length *opt_len;
-
-		opt_len = (AF_INET6 == nak_src_nla.ss_family) ?
-				(const struct pgm_opt_length*)(nak6 + 1) :
-				(const struct pgm_opt_length*)(nak  + 1);
-		if (PGM_UNLIKELY(opt_len->opt_type != PGM_OPT_LENGTH)) {
-			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed NAK rejected on unexpected primary PGM option type."));
-			sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS]++;
-			return FALSE;
-		}
-		if (PGM_UNLIKELY(opt_len->opt_length != sizeof(struct pgm_opt_length))) {
-			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed NAK rejected on length of length option header."));
-			sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS]++;
-			return FALSE;
+		while (!rdata->is_pending && !rdata->is_terminated)
+#ifndef _WIN32
+			pgm_cond_wait (&rdata->cond, &rdata->mutex.pthread_mutex);
+#else
+			pgm_cond_wait (&rdata->cond, &rdata->mutex.win32_crit);
+#endif
+		if (rdata->is_terminated)
+			break;
+		rdata->is_pending = FALSE;
+		pgm_mutex_unlock (&rdata->mutex);
+		while (!pgm_txw_retransmit_is_empty (sock->window) &&
+		       !rdata->is_terminated)
+		{
+			if (!send_scheduled_rdata (sock, FALSE))
+				pgm_thread_yield ();
 		}
-/* TODO: check for > 16 options & past packet end */
-		opt_header = (const struct pgm_opt_header*)opt_len;
-		do {
-			opt_header = (const struct pgm_opt_header*)((const char*)opt_header + opt_header->opt_length);
-			if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_NAK_LIST) {
-				nak_list = ((const struct pgm_opt_nak_list*)(opt_header + 1))->opt_sqn;
-				nak_list_len = ( opt_header->opt_length - sizeof(struct pgm_opt_header) - sizeof(uint8_t) ) / sizeof(uint32_t);
-				break;
-			}
-		} while (!(opt_header->opt_type & PGM_OPT_END));
-	}
-
-/* nak list numbers */
-	if (PGM_UNLIKELY(nak_list_len > 62)) {
-		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed NAK rejected on sequence list overrun, %d reported NAKs."), nak_list_len);
-		return FALSE;
-	}
-		
-	for (uint_fast8_t i = 0; i < nak_list_len; i++)
-	{
-		sqn_list.sqn[sqn_list.len++] = pgm_ntohl (*nak_list);
-		nak_list++;
+		pgm_mutex_lock (&rdata->mutex);
 	}
+	pgm_mutex_unlock (&rdata->mutex);
 
-/* send NAK confirm packet immediately, then defer to timer thread for a.s.a.p
- * delivery of the actual RDATA packets.  blocking send for NCF is ignored as RDATA
- * broadcast will be sent later.
- */
-	if (nak_list_len)
-		send_ncf_list (sock, (struct sockaddr*)&nak_src_nla, (struct sockaddr*)&nak_grp_nla, &sqn_list, is_parity);
-	else
-		send_ncf (sock, (struct sockaddr*)&nak_src_nla, (struct sockaddr*)&nak_grp_nla, sqn_list.sqn[0], is_parity);
-
-/* queue retransmit requests */
-	for (uint_fast8_t i = 0; i < sqn_list.len; i++) {
-		const bool push_status = pgm_txw_retransmit_push (sock->window, sqn_list.sqn[i], is_parity, sock->tg_sqn_shift);
-		if (PGM_UNLIKELY(!push_status)) {
-			pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Failed to push retransmit request for #%" PRIu32), sqn_list.sqn[i]);
-		}
-	}
-	return TRUE;
+#ifndef _WIN32
+	return NULL;
+#else
+	_endthread();
+	return 0;
+#endif
 }
 
-/* Null-NAK, or N-NAK propogated by a DLR for hand waving excitement
+/* start sender thread of PGM_SEND_ASYNC, called by pgm_bind() after the
+ * transmit window is created.
  *
- * if NNAK is valid, returns TRUE.  on error, FALSE is returned.
+ * returns TRUE on success, returns FALSE if the thread cannot be created and
+ * pgm_send() remains synchronous.
  */
 
 PGM_GNUC_INTERNAL
 bool
-pgm_on_nnak (
-	pgm_sock_t*           const restrict sock,
-	struct pgm_sk_buff_t* const restrict skb
+pgm_async_thread_create (
+	pgm_sock_t* const	sock
 	)
 {
-	const struct pgm_nak	*nnak;
-	const struct pgm_nak6	*nnak6;
-	struct sockaddr_storage	 nnak_src_nla, nnak_grp_nla;
-	uint_fast8_t		 nnak_list_len = 0;
+	struct pgm_async_thread_t* async;
+	unsigned len = 1;
 
 /* pre-conditions */
 	pgm_assert (NULL != sock);
-	pgm_assert (NULL != skb);
-
-	pgm_debug ("pgm_on_nnak (sock:%p skb:%p)",
-		(void*)sock, (void*)skb);
-
-	sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NNAK_PACKETS_RECEIVED]++;
-
-	if (PGM_UNLIKELY(!pgm_verify_nnak (skb))) {
-		sock->cumulative_stats[PGM_PC_SOURCE_NNAK_ERRORS]++;
-		return FALSE;
-	}
-
-	nnak  = (struct pgm_nak *)skb->data;
-	nnak6 = (struct pgm_nak6*)skb->data;
-		
-/* NAK_SRC_NLA contains our sock unicast NLA */
-	pgm_nla_to_sockaddr (&nnak->nak_src_nla_afi, (struct sockaddr*)&nnak_src_nla);
-
-	if (PGM_UNLIKELY(pgm_sockaddr_cmp ((struct sockaddr*)&nnak_src_nla, (struct sockaddr*)&sock->send_addr) != 0))
-	{
-		sock->cumulative_stats[PGM_PC_SOURCE_NNAK_ERRORS]++;
-		return FALSE;
-	}
-
-/* NAK_GRP_NLA containers our sock multicast group */ 
-	pgm_nla_to_sockaddr ((AF_INET6 == nnak_src_nla.ss_family) ? &nnak6->nak6_grp_nla_afi : &nnak->nak_grp_nla_afi, (struct sockaddr*)&nnak_grp_nla);
-	if (PGM_UNLIKELY(pgm_sockaddr_cmp ((struct sockaddr*)&nnak_grp_nla, (struct sockaddr*)&sock->send_gsr.gsr_group) != 0))
-	{
-		sock->cumulative_stats[PGM_PC_SOURCE_NNAK_ERRORS]++;
+	pgm_assert (NULL != sock->window);
+	pgm_assert (sock->async_len > 0);
+	pgm_assert (NULL == sock->async_thread);
+
+	while (len < sock->async_len)
+		len <<= 1;
+	async = pgm_new0 (struct pgm_async_thread_t, 1);
+	pgm_mutex_init (&async->mutex);
+	pgm_cond_init (&async->cond);
+	async->mask = len - 1;
+	async->ring = (struct pgm_async_apdu_t* volatile*)pgm_new0 (struct pgm_async_apdu_t*, len);
+	sock->async_thread = async;
+
+#ifndef _WIN32
+	const int status = pthread_create (&async->thread, NULL, &async_routine, sock);
+	if (0 != status) {
+#else
+	async->thread = (HANDLE)_beginthreadex (NULL, 0, &async_routine, sock, 0, NULL);
+	if (0 == async->thread) {
+#endif /* _WIN32 */
+		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Creating sender thread failed, sends remain on the application thread."));
+		sock->async_thread = NULL;
+		pgm_free ((void*)async->ring);
+		pgm_cond_free (&async->cond);
+		pgm_mutex_free (&async->mutex);
+		pgm_free (async);
 		return FALSE;
 	}
-
-/* check NNAK list */
-	if (skb->pgm_header->pgm_options & PGM_OPT_PRESENT)
-	{
-		const struct pgm_opt_length* opt_len = (AF_INET6 == nnak_src_nla.ss_family) ?
-							(const struct pgm_opt_length*)(nnak6 + 1) :
-							(const struct pgm_opt_length*)(nnak + 1);
-		if (PGM_UNLIKELY(opt_len->opt_type != PGM_OPT_LENGTH)) {
-			sock->cumulative_stats[PGM_PC_SOURCE_NNAK_ERRORS]++;
-			return FALSE;
-		}
-		if (PGM_UNLIKELY(opt_len->opt_length != sizeof(struct pgm_opt_length))) {
-			sock->cumulative_stats[PGM_PC_SOURCE_NNAK_ERRORS]++;
-			return FALSE;
-		}
-/* TODO: check for > 16 options & past packet end */
-		const struct pgm_opt_header* opt_header = (const struct pgm_opt_header*)opt_len;
-		do {
-			opt_header = (const struct pgm_opt_header*)((const char*)opt_header + opt_header->opt_length);
-			if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_NAK_LIST) {
-				nnak_list_len = ( opt_header->opt_length - sizeof(struct pgm_opt_header) - sizeof(uint8_t) ) / sizeof(uint32_t);
-				break;
-			}
-		} while (!(opt_header->opt_type & PGM_OPT_END));
-	}
-
-	sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NNAKS_RECEIVED] += 1 + nnak_list_len;
 	return TRUE;
 }
 
-/* ACK, sent upstream by one selected ACKER for congestion control feedback.
- *
- * if ACK is valid, returns TRUE.  on error, FALSE is returned.
+/* stop sender thread once queued APDUs are sent, APDUs held up by congestion
+ * control or full send buffers are discarded.  called by pgm_close() before
+ * the transmit window is destroyed.
  */
 
 PGM_GNUC_INTERNAL
-bool
-pgm_on_ack (
-	pgm_sock_t*           const restrict sock,
-	struct pgm_sk_buff_t* const restrict skb
+void
+pgm_async_thread_destroy (
+	pgm_sock_t* const	sock
 	)
 {
-	const struct pgm_ack	*ack;
-	bool			 is_acker = FALSE;
-	uint32_t		 ack_bitmap;
-	unsigned		 new_acks;
+	struct pgm_async_thread_t* async;
 
 /* pre-conditions */
 	pgm_assert (NULL != sock);
-	pgm_assert (NULL != skb);
-
-	pgm_debug ("pgm_on_ack (sock:%p skb:%p)",
-		(const void*)sock, (const void*)skb);
+	pgm_assert (NULL != sock->async_thread);
+
+	async = sock->async_thread;
+	pgm_mutex_lock (&async->mutex);
+	async->is_terminated = TRUE;
+	pgm_atomic_write32 (&async->is_idle, 0);
+	pgm_cond_signal (&async->cond);
+	pgm_mutex_unlock (&async->mutex);
+#ifndef _WIN32
+	pthread_join (async->thread, NULL);
+#else
+	WaitForSingleObject (async->thread, INFINITE);
+	CloseHandle (async->thread);
+#endif
+	sock->async_thread = NULL;
+	for (unsigned i = 0; i <= async->mask; i++)
+		if (NULL != async->ring[ i ])
+			pgm_free (async->ring[ i ]);
+	pgm_free ((void*)async->ring);
+	pgm_cond_free (&async->cond);
+	pgm_mutex_free (&async->mutex);
+	pgm_free (async);
+}
 
-	sock->cumulative_stats[PGM_PC_SOURCE_ACK_PACKETS_RECEIVED]++;
+/* copy an APDU into the ring and wake an idle sender thread, never blocking.
+ *
+ * returns PGM_IO_STATUS_NORMAL when queued, returns PGM_IO_STATUS_WOULD_BLOCK
+ * when the ring is full.
+ */
 
-	if (PGM_UNLIKELY(!pgm_verify_ack (skb))) {
-		sock->cumulative_stats[PGM_PC_SOURCE_ACK_ERRORS]++;
-		return FALSE;
+static
+int
+async_push (
+	pgm_sock_t*	 const restrict sock,
+	const void*	       restrict	apdu,
+	const size_t			apdu_length,
+	size_t*	       	       restrict	bytes_written
+	)
+{
+	struct pgm_async_thread_t* async = sock->async_thread;
+	uint32_t head;
+
+	do {
+		head = pgm_atomic_read32 (&async->head);
+		if (PGM_UNLIKELY((uint32_t)(head - pgm_atomic_read32 (&async->tail)) > async->mask)) {
+			pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_ASYNC_QUEUE_FULL], 1);
+			return PGM_IO_STATUS_WOULD_BLOCK;
+		}
+	} while (!pgm_atomic_compare_and_exchange32 (&async->head, head, head + 1));
+
+	struct pgm_async_apdu_t* entry = pgm_malloc (sizeof (struct pgm_async_apdu_t) + apdu_length);
+	entry->length = apdu_length;
+	if (apdu_length)
+		memcpy (entry->data, apdu, apdu_length);
+/* slot emptied by the sender before tail passed it */
+	pgm_atomic_compare_and_exchange_pointer ((void*volatile*)&async->ring[ head & async->mask ], NULL, entry);
+	if (pgm_atomic_read32 (&async->is_idle) &&
+	    pgm_atomic_compare_and_exchange32 (&async->is_idle, 1, 0))
+	{
+		pgm_mutex_lock (&async->mutex);
+		pgm_cond_signal (&async->cond);
+		pgm_mutex_unlock (&async->mutex);
 	}
+	if (bytes_written)
+		*bytes_written = apdu_length;
+	return PGM_IO_STATUS_NORMAL;
+}
 
-	if (!sock->use_pgmcc)
-		return FALSE;
+/* send queued APDUs in order with blocking rate regulation, retry on
+ * congestion control or full send buffers.  an empty ring is re-checked
+ * after marking the thread idle such that a concurrent push is not missed.
+ */
 
-	ack = (struct pgm_ack*)skb->data;
+static
+#ifndef _WIN32
+void*
+#else
+unsigned
+__stdcall
+#endif
+async_routine (
+	void*		arg
+	)
+{
+	pgm_sock_t* sock = arg;
+	struct pgm_async_thread_t* async = sock->async_thread;
 
-/* check PGMCC feedback option for new elections */
-	if (skb->pgm_header->pgm_options & PGM_OPT_PRESENT)
+	if (sock->numa_node >= 0)
+		pgm_numa_bind_thread (sock->numa_node);
+	pgm_thread_setup ("async");
+	for (;;)
 	{
-		const struct pgm_opt_header *opt_header;
-		const struct pgm_opt_length *opt_len;
-
-		opt_len = (const struct pgm_opt_length*)(ack + 1);
-		if (PGM_UNLIKELY(opt_len->opt_type != PGM_OPT_LENGTH)) {
-			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed ACK rejected."));
-			return FALSE;
+		const uint32_t tail = pgm_atomic_read32 (&async->tail);
+		struct pgm_async_apdu_t* entry = async->ring[ tail & async->mask ];
+		if (NULL == entry) {
+			if (async->is_terminated)
+				break;
+			pgm_atomic_compare_and_exchange32 (&async->is_idle, 0, 1);
+			if (NULL != async->ring[ tail & async->mask ]) {
+				pgm_atomic_compare_and_exchange32 (&async->is_idle, 1, 0);
+				continue;
+			}
+			pgm_mutex_lock (&async->mutex);
+			while (pgm_atomic_read32 (&async->is_idle) && !async->is_terminated)
+#ifndef _WIN32
+				pgm_cond_wait (&async->cond, &async->mutex.pthread_mutex);
+#else
+				pgm_cond_wait (&async->cond, &async->mutex.win32_crit);
+#endif
+			pgm_mutex_unlock (&async->mutex);
+			continue;
 		}
-		if (PGM_UNLIKELY(opt_len->opt_length != sizeof(struct pgm_opt_length))) {
-			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed ACK rejected."));
-			return FALSE;
+		for (;;) {
+			const int status = send_locked (sock, entry->data, entry->length, NULL);
+			if (PGM_IO_STATUS_CONGESTION != status &&
+			    PGM_IO_STATUS_WOULD_BLOCK != status &&
+			    PGM_IO_STATUS_RATE_LIMITED != status)
+				break;
+			if (async->is_terminated)
+				break;
+			pgm_thread_yield ();
 		}
-		opt_header = (const struct pgm_opt_header*)opt_len;
-		do {
-			opt_header = (const struct pgm_opt_header*)((const char*)opt_header + opt_header->opt_length);
-			if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_PGMCC_FEEDBACK) {
-				const struct pgm_opt_pgmcc_feedback* opt_pgmcc_feedback = (const struct pgm_opt_pgmcc_feedback*)(opt_header + 1);
-				is_acker = on_opt_pgmcc_feedback (sock, skb, opt_pgmcc_feedback);
-				break;	/* ignore other options */
-			}
-		} while (!(opt_header->opt_type & PGM_OPT_END));
+		pgm_atomic_compare_and_exchange_pointer ((void*volatile*)&async->ring[ tail & async->mask ], entry, NULL);
+		pgm_atomic_write32 (&async->tail, tail + 1);
+		pgm_free (entry);
 	}
 
-/* ignore ACKs from other receivers or sessions */
-	if (!is_acker)
-		return TRUE;
+#ifndef _WIN32
+	return NULL;
+#else
+	_endthread();
+	return 0;
+#endif
+}
 
-/* reset ACK expiration */
-	sock->next_crqst = 0;
+/* upper bound of the bucket holding percentile pct of a histogram, bucket n
+ * counting values from 2^(n-1) up to 2^n, the last unbounded.
+ */
 
-/* count new ACK sequences */
-	const uint32_t ack_rx_max = pgm_ntohl (ack->ack_rx_max);
-	const int32_t delta = ack_rx_max - sock->ack_rx_max;
-/* ignore older ACKs when multiple active ACKers */
-	if (pgm_uint32_gt (ack_rx_max, sock->ack_rx_max))
-		sock->ack_rx_max = ack_rx_max;
-	ack_bitmap = pgm_ntohl (ack->ack_bitmap);
-	if (delta > 32)		sock->ack_bitmap = 0;		/* sequence jump ahead beyond past bitmap */
-	else if (delta > 0)	sock->ack_bitmap <<= delta;	/* immediate sequence */
-	else if (delta > -32)	ack_bitmap <<= -delta;		/* repair sequence scoped by bitmap */
-	else			ack_bitmap = 0;			/* old sequence */
-	new_acks = _pgm_popcount (ack_bitmap & ~sock->ack_bitmap);
-	sock->ack_bitmap |= ack_bitmap;
+static
+uint32_t
+log2_percentile (
+	const uint32_t*	hist,
+	const unsigned	len,
+	const unsigned	pct
+	)
+{
+	uint64_t count = 0, sum = 0;
+	for (unsigned i = 0; i < len; i++)
+		count += hist[ i ];
+	for (unsigned i = 0; i < len; i++) {
+		sum += hist[ i ];
+		if (hist[ i ] && sum * 100 >= count * pct)
+			return len - 1 == i ? UINT32_MAX : (uint32_t)((UINT64_C(1) << i) - 1);
+	}
+	return 0;
+}
 
-	if (0 == new_acks)
-		return TRUE;
+/* transmit window metrics for PGM_SOURCE_STATS, read without locks whilst
+ * the sending thread and repair path write them.
+ */
 
-	const bool is_congestion_limited = (sock->tokens < pgm_fp8 (1));
+PGM_GNUC_INTERNAL
+void
+pgm_source_get_stats (
+	pgm_sock_t*		      const restrict sock,
+	struct pgm_sourcestatsinfo_t* const restrict info
+	)
+{
+	const pgm_txw_t* window;
 
-/* after loss detection cancel any further manipulation of the window
- * until feedback is received for the next transmitted packet.
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->window);
+	pgm_assert (NULL != info);
+
+	window = sock->window;
+	info->txw_size		= pgm_txw_size (window);
+	info->txw_peak_size	= window->peak_size;
+	info->txw_length	= pgm_txw_length (window);
+	info->txw_peak_length	= window->peak_length;
+	info->txw_max_length	= (uint32_t)pgm_txw_max_length (window);
+	info->residency_p50	= log2_percentile (window->residency_hist, PGM_TXW_RESIDENCY_BUCKETS, 50);
+	info->residency_p90	= log2_percentile (window->residency_hist, PGM_TXW_RESIDENCY_BUCKETS, 90);
+	info->residency_p99	= log2_percentile (window->residency_hist, PGM_TXW_RESIDENCY_BUCKETS, 99);
+	info->residency_max	= window->max_residency;
+	info->rdata_age_p50	= log2_percentile (sock->rdata_age_hist, PGM_RDATA_AGE_BUCKETS, 50);
+	info->rdata_age_p90	= log2_percentile (sock->rdata_age_hist, PGM_RDATA_AGE_BUCKETS, 90);
+	info->rdata_age_p99	= log2_percentile (sock->rdata_age_hist, PGM_RDATA_AGE_BUCKETS, 99);
+	info->rdata_age_max	= sock->max_rdata_age;
+}
+
+/* SPMR indicates if multicast to cancel own SPMR, or unicast to send SPM.
+ *
+ * rate limited to 1/IHB_MIN per TSI (13.4).
+ *
+ * if SPMR was valid, returns TRUE, if invalid returns FALSE.
  */
-	if (sock->is_congested)
-	{
-		if (pgm_uint32_lte (ack_rx_max, sock->suspended_sqn))
-		{
-			pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("PGMCC window token manipulation suspended due to congestion (T:%u W:%u)"),
-				   pgm_fp8tou (sock->tokens), pgm_fp8tou (sock->cwnd_size));
-			const uint_fast32_t token_inc = pgm_fp8mul (pgm_fp8 (new_acks), pgm_fp8 (1) + pgm_fp8div (pgm_fp8 (1), sock->cwnd_size));
-			sock->tokens = MIN( sock->tokens + token_inc, sock->cwnd_size );
-			goto notify_tx;
+
+PGM_GNUC_INTERNAL
+bool
+pgm_on_spmr (
+	pgm_sock_t*           const restrict sock,
+	pgm_peer_t*	      const restrict peer,	/* maybe NULL if socket is source */
+	struct pgm_sk_buff_t* const restrict skb
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != skb);
+
+	pgm_debug ("pgm_on_spmr (sock:%p peer:%p skb:%p)",
+		(void*)sock, (void*)peer, (void*)skb);
+
+	if (PGM_UNLIKELY(!pgm_verify_spmr (skb))) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed SPMR rejected."));
+		return FALSE;
+	}
+
+	if (peer_is_source (peer)) {
+		const bool send_status = pgm_send_spm (sock, 0);
+		if (PGM_UNLIKELY(!send_status)) {
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Failed to send SPM on SPM-Request."));
 		}
-		sock->is_congested = FALSE;
+	} else {
+		pgm_trace (PGM_LOG_ROLE_RX_WINDOW,_("Suppressing SPMR due to peer multicast SPMR."));
+		reset_spmr_timer (peer);
 	}
+	return TRUE;
+}
 
-/* count outstanding lost sequences */
-	const unsigned total_lost = _pgm_popcount (~sock->ack_bitmap);
+/* Process opt_pgmcc_feedback PGM option that ships attached to ACK or NAK.
+ * Contents use to elect best ACKer.
+ *
+ * returns TRUE if peer is the elected ACKer.
+ */
 
-/* no detected data loss at ACKer, increase congestion window size */
-	if (0 == total_lost)
-	{
-		uint_fast32_t n, token_inc;
+static
+bool
+on_opt_pgmcc_feedback (
+	pgm_sock_t*           	       const restrict sock,
+	const struct pgm_sk_buff_t*    const restrict skb,
+	const struct pgm_opt_pgmcc_feedback* restrict opt_pgmcc_feedback
+	)
+{
+	struct sockaddr_storage peer_nla;
 
-		new_acks += sock->acks_after_loss;
-		sock->acks_after_loss = 0;
-		n = pgm_fp8 (new_acks);
-		token_inc = 0;
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != skb);
+	pgm_assert (NULL != opt_pgmcc_feedback);
 
-/* slow-start phase, exponential increase to SSTHRESH */
-		if (sock->cwnd_size < sock->ssthresh) {
-			const uint_fast32_t d = MIN( n, sock->ssthresh - sock->cwnd_size );
-			n -= d;
-			token_inc	 = d + d;
-			sock->cwnd_size += d;
-		}
+	const uint32_t opt_tstamp = pgm_ntohl (opt_pgmcc_feedback->opt_tstamp);
+	const uint16_t opt_loss_rate = pgm_ntohs (opt_pgmcc_feedback->opt_loss_rate);
 
-		const uint_fast32_t iw = pgm_fp8div (pgm_fp8 (1), sock->cwnd_size);
+	const uint32_t rtt = (uint32_t)(pgm_to_msecs (skb->tstamp) - opt_tstamp);
+	const uint64_t peer_loss = rtt * rtt * opt_loss_rate;
 
-/* linear window increase */
-		token_inc	+= pgm_fp8mul (n, pgm_fp8 (1) + iw);
-		sock->cwnd_size += pgm_fp8mul (n, iw);
-		sock->tokens	 = MIN( sock->tokens + token_inc, sock->cwnd_size );
-//		pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("PGMCC++ (T:%u W:%u)"),
-//			   pgm_fp8tou (sock->tokens), pgm_fp8tou (sock->cwnd_size));
+	pgm_nla_to_sockaddr (&opt_pgmcc_feedback->opt_nla_afi, (struct sockaddr*)&peer_nla);
+
+/* ACKer elections */
+	if (PGM_UNLIKELY(pgm_sockaddr_is_addr_unspecified ((const struct sockaddr*)&sock->acker_nla)))
+	{
+		pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("Elected first ACKer"));
+		memcpy (&sock->acker_nla, &peer_nla, pgm_sockaddr_storage_len (&peer_nla));
 	}
-	else
+	else if (peer_loss > sock->acker_loss &&
+		 0 != pgm_sockaddr_cmp ((const struct sockaddr*)&peer_nla, (const struct sockaddr*)&sock->acker_nla))
 	{
-/* Look for an unacknowledged data packet which is followed by at least three
- * acknowledged data packets, then the packet is assumed to be lost and PGMCC
- * reacts by halving the window.
- *
- * Common value will be 0xfffffff7.
- */
-		sock->acks_after_loss += new_acks;
-		if (sock->acks_after_loss >= 3)
-		{
-			sock->acks_after_loss = 0;
-			sock->suspended_sqn = ack_rx_max;
-			sock->is_congested = TRUE;
-			sock->cwnd_size = pgm_fp8div (sock->cwnd_size, pgm_fp8 (2));
-			if (sock->cwnd_size > sock->tokens)
-				sock->tokens = 0;
-			else
-				sock->tokens -= sock->cwnd_size;
-			sock->ack_bitmap = 0xffffffff;
-			pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("PGMCC congestion, half window size (T:%u W:%u)"),
-				   pgm_fp8tou (sock->tokens), pgm_fp8tou (sock->cwnd_size));
-		}
+		pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("Elected new ACKer"));
+		memcpy (&sock->acker_nla, &peer_nla, pgm_sockaddr_storage_len (&peer_nla));
 	}
 
-/* token is now available so notify tx thread that transmission time is available */
-notify_tx:
-	if (is_congestion_limited &&
-	    sock->tokens >= pgm_fp8 (1))
+/* update ACKer state */
+	if (0 == pgm_sockaddr_cmp ((const struct sockaddr*)&peer_nla, (const struct sockaddr*)&sock->acker_nla))
 	{
-		pgm_notify_send (&sock->ack_notify);
+		sock->acker_loss = peer_loss;
+		sock->acker_loss_rate = opt_loss_rate;
+/* the ACKer is the current limiting receiver of TFMCC */
+		if (sock->use_tfmcc)
+			pgm_tfmcc_feedback (sock, rtt, opt_loss_rate, skb->tstamp);
+		return TRUE;
 	}
-	return TRUE;
+
+	return FALSE;
 }
 
-/* ambient/heartbeat SPM's
- *
- * heartbeat: ihb_tmr decaying between ihb_min and ihb_max 2x after last packet
- *
- * on success, TRUE is returned, if operation would block, FALSE is returned.
+/* track the sequence each ACKing receiver holds without a gap in its ACK
+ * bitmap and publish the release point of the transmit window trail: the
+ * lowest across all receivers ACKing within the peer expiry, or the highest
+ * reached by a quorum of them.  losses older than the bitmap remain
+ * recoverable by NAK for the window hold time.
  */
 
-PGM_GNUC_INTERNAL
-bool
-pgm_send_spm (
-	pgm_sock_t* const	sock,
-	const int		flags
+static
+void
+ack_release_update (
+	pgm_sock_t*	      const restrict sock,
+	const struct sockaddr*const restrict peer_nla,
+	const uint32_t			     ack_rx_max,
+	const uint32_t			     ack_bitmap,
+	const pgm_time_t		     now
 	)
 {
-	size_t		   tpdu_length;
-	char		  *buf;
-	struct pgm_header *header;
-	struct pgm_spm	  *spm;
-	struct pgm_spm6	  *spm6;
-	ssize_t		   sent;
+	struct pgm_ack_peer_t* peer = NULL;
+	uint32_t acked_sqn = ack_rx_max;
+	uint32_t release_sqn = 0;
+	bool has_release = FALSE;
+	unsigned i, j, need;
 
 /* pre-conditions */
 	pgm_assert (NULL != sock);
-	pgm_assert (NULL != sock->window);
+	pgm_assert (NULL != sock->ack_peers);
+	pgm_assert (NULL != peer_nla);
+
+/* bit n marks ack_rx_max - n received, the oldest gap bounds the release */
+	for (i = 31; i > 0; i--) {
+		if (!(ack_bitmap & (1U << i))) {
+			acked_sqn = ack_rx_max - i - 1;
+			break;
+		}
+	}
 
-	pgm_debug ("pgm_send_spm (sock:%p flags:%d)",
-		(const void*)sock, flags);
+/* expire silent receivers and find this one */
+	for (i = 0; i < sock->ack_peers_len;) {
+		if (pgm_time_after_eq (now, sock->ack_peers[i].expiry)) {
+			sock->ack_peers[i] = sock->ack_peers[ --sock->ack_peers_len ];
+			continue;
+		}
+		if (0 == pgm_sockaddr_cmp ((const struct sockaddr*)&sock->ack_peers[i].nla, peer_nla))
+			peer = &sock->ack_peers[i];
+		i++;
+	}
+	if (NULL == peer) {
+		if (PGM_UNLIKELY(sock->ack_peers_len == PGM_ACK_PEERS_MAX))
+			return;
+		peer = &sock->ack_peers[ sock->ack_peers_len++ ];
+		memcpy (&peer->nla, peer_nla, pgm_sockaddr_len (peer_nla));
+		peer->acked_sqn = acked_sqn;
+	} else if (pgm_uint32_gt (acked_sqn, peer->acked_sqn))
+		peer->acked_sqn = acked_sqn;
+	peer->expiry = now + sock->peer_expiry;
+
+/* highest sequence acknowledged by at least need receivers */
+	need = (0 == sock->txw_ack_quorum || sock->txw_ack_quorum > sock->ack_peers_len) ? sock->ack_peers_len : sock->txw_ack_quorum;
+	for (i = 0; i < sock->ack_peers_len; i++) {
+		unsigned count = 0;
+		for (j = 0; j < sock->ack_peers_len; j++)
+			if (pgm_uint32_lte (sock->ack_peers[i].acked_sqn, sock->ack_peers[j].acked_sqn))
+				count++;
+		if (count >= need &&
+		    (!has_release || pgm_uint32_gt (sock->ack_peers[i].acked_sqn, release_sqn)))
+		{
+			release_sqn = sock->ack_peers[i].acked_sqn;
+			has_release = TRUE;
+		}
+	}
+	pgm_txw_ack (sock->window, release_sqn);
+}
 
-	tpdu_length = sizeof(struct pgm_header);
-	if (AF_INET == sock->send_gsr.gsr_group.ss_family)
-		tpdu_length += sizeof(struct pgm_spm);
+/* slot of a receiver in the NAK intake table, FNV-1a of the address.
+ */
+
+static inline
+unsigned
+nak_peer_index (
+	const struct sockaddr* const	addr
+	)
+{
+	const uint8_t* p;
+	size_t len;
+	uint32_t hash = 2166136261U;
+
+	if (AF_INET6 == addr->sa_family) {
+		p   = (const uint8_t*)&((const struct sockaddr_in6*)addr)->sin6_addr;
+		len = sizeof(struct in6_addr);
+	} else {
+		p   = (const uint8_t*)&((const struct sockaddr_in*)addr)->sin_addr;
+		len = sizeof(struct in_addr);
+	}
+	while (len--)
+		hash = (hash ^ *p++) * 16777619U;
+	return hash % PGM_NAK_PEERS_LEN;
+}
+
+/* token bucket of NAKed sequences per receiver, refilled at the receiver rate
+ * up to one second of burst.  a receiver refused in consecutive seconds is
+ * reported once as pathological.
+ *
+ * returns sequences of count to accept, 0 to drop the NAK.
+ */
+
+static
+uint32_t
+nak_peer_admit (
+	pgm_sock_t*	       const restrict sock,
+	const struct sockaddr* const restrict addr,
+	const uint32_t			      count,
+	const pgm_time_t		      now
+	)
+{
+	struct pgm_nak_peer_t* peer;
+	uint32_t accepted;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->nak_peers);
+	pgm_assert (NULL != addr);
+	pgm_assert (count > 0);
+
+	peer = &sock->nak_peers[ nak_peer_index (addr) ];
+	if (PGM_UNLIKELY(0 != pgm_sockaddr_cmp ((const struct sockaddr*)&peer->nla, addr))) {
+		memset (peer, 0, sizeof(struct pgm_nak_peer_t));
+		memcpy (&peer->nla, addr, pgm_sockaddr_len (addr));
+		peer->tstamp = peer->period_start = now;
+		peer->tokens = sock->nak_receiver_rate;
+	} else {
+		const uint64_t earned = (uint64_t)(now - peer->tstamp) * sock->nak_receiver_rate / pgm_secs(1);
+		if (earned > 0) {
+			peer->tokens = (uint32_t)MIN((uint64_t)sock->nak_receiver_rate, peer->tokens + earned);
+			peer->tstamp = now;
+		}
+	}
+
+	if (pgm_time_after_eq (now, peer->period_start + pgm_secs(1))) {
+		peer->strikes = peer->period_refused ? peer->strikes + 1 : 0;
+		peer->period_refused = 0;
+		peer->period_start = now;
+		if (PGM_UNLIKELY(PGM_NAK_PATHOLOGICAL_SECS == peer->strikes && !peer->is_pathological)) {
+			char saddr[INET6_ADDRSTRLEN];
+			pgm_sockaddr_ntop (addr, saddr, sizeof(saddr));
+			pgm_warn (_("Receiver %s NAKing beyond %" PRIu32 " sequences per second for %u seconds."),
+				  saddr, sock->nak_receiver_rate, peer->strikes);
+			peer->is_pathological = TRUE;
+			sock->cumulative_stats[PGM_PC_SOURCE_PATHOLOGICAL_NAKERS]++;
+		}
+	}
+
+	accepted = MIN(count, peer->tokens);
+	peer->tokens -= accepted;
+	if (accepted < count) {
+		peer->period_refused += count - accepted;
+		sock->cumulative_stats[PGM_PC_SOURCE_NAKS_RATE_LIMITED] += count - accepted;
+	}
+	return accepted;
+}
+
+/* NAK requesting RDATA transmission for a sending sock, only valid if
+ * sequence number(s) still in transmission window.
+ *
+ * we can potentially have different IP versions for the NAK packet to the send group.
+ *
+ * TODO: fix IPv6 AFIs
+ *
+ * take in a NAK and pass off to an asynchronous queue for another thread to process
+ *
+ * if NAK is valid, returns TRUE.  on error, FALSE is returned.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_on_nak (
+	pgm_sock_t*            const restrict sock,
+	const struct sockaddr* const restrict src_addr,	/* receiver */
+	struct pgm_sk_buff_t*  const restrict skb
+	)
+{
+	const struct pgm_nak	*nak;
+	const struct pgm_nak6	*nak6;
+	struct sockaddr_storage	 nak_src_nla, nak_grp_nla;
+	const uint32_t		*nak_list = NULL;
+	uint_fast8_t		 nak_list_len = 0;
+	struct pgm_sqn_list_t	 sqn_list;
+	const struct pgm_opt_nak_range *opt_nak_range = NULL;
+	unsigned		 nak_range_len = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != src_addr);
+	pgm_assert (NULL != skb);
+
+	pgm_debug ("pgm_on_nak (sock:%p src-addr:%p skb:%p)",
+		(const void*)sock, (const void*)src_addr, (const void*)skb);
+
+	const bool is_parity = skb->pgm_header->pgm_options & PGM_OPT_PARITY;
+	if (is_parity) {
+		sock->cumulative_stats[PGM_PC_SOURCE_PARITY_NAKS_RECEIVED]++;
+		if (!sock->use_ondemand_parity) {
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Parity NAK rejected as on-demand parity is not enabled."));
+			sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS]++;
+			return FALSE;
+		}
+	} else
+		sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED]++;
+
+	if (PGM_UNLIKELY(!pgm_verify_nak (skb))) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed NAK rejected on verification."));
+		sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS]++;
+		return FALSE;
+	}
+
+	nak  = (struct pgm_nak *)skb->data;
+	nak6 = (struct pgm_nak6*)skb->data;
+		
+/* NAK_SRC_NLA contains our sock unicast NLA */
+	pgm_nla_to_sockaddr (&nak->nak_src_nla_afi, (struct sockaddr*)&nak_src_nla);
+
+/* copy scope id from socket */
+	if (pgm_is_inet6 (sock->family))
+	{
+		((struct sockaddr_in6*)&nak_src_nla)->sin6_scope_id = ((struct sockaddr_in6*)&sock->send_addr)->sin6_scope_id;
+	}
+
+	if (PGM_UNLIKELY(pgm_sockaddr_cmp ((struct sockaddr*)&nak_src_nla, (struct sockaddr*)&sock->send_addr) != 0))
+	{
+		char saddr[INET6_ADDRSTRLEN];
+		pgm_sockaddr_ntop ((struct sockaddr*)&nak_src_nla, saddr, sizeof(saddr));
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("NAK rejected for unmatched NLA: %s"), saddr);
+		sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS]++;
+		return FALSE;
+	}
+
+/* NAK_GRP_NLA containers our sock multicast group */ 
+	pgm_nla_to_sockaddr (pgm_is_inet6 (nak_src_nla.ss_family) ? &nak6->nak6_grp_nla_afi : &nak->nak_grp_nla_afi, (struct sockaddr*)&nak_grp_nla);
+
+/* copy scope id from multicast socket */
+	if (pgm_is_inet6 (sock->family))
+	{
+		((struct sockaddr_in6*)&nak_grp_nla)->sin6_scope_id = ((struct sockaddr_in6*)&sock->send_gsr.gsr_group)->sin6_scope_id;
+	}
+
+	if (PGM_UNLIKELY(!is_send_group (sock, (struct sockaddr*)&nak_grp_nla)))
+	{
+		char sgroup[INET6_ADDRSTRLEN];
+		pgm_sockaddr_ntop ((struct sockaddr*)&nak_src_nla, sgroup, sizeof(sgroup));
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("NAK rejected as targeted for different multicast group: %s"), sgroup);
+		sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS]++;
+		return FALSE;
+	}
+
+/* create queue object */
+	sqn_list.sqn[0] = pgm_ntohl (nak->nak_sqn);
+	sqn_list.len = 1;
+
+	pgm_debug ("nak_sqn %" PRIu32, sqn_list.sqn[0]);
+
+/* check NAK list */
+	if (skb->pgm_header->pgm_options & PGM_OPT_PRESENT)
+	{
+		const struct pgm_opt_header *opt_header;
+		const struct pgm_opt_length *opt_len;
+
+		opt_len = pgm_is_inet6 (nak_src_nla.ss_family) ?
+				(const struct pgm_opt_length*)(nak6 + 1) :
+				(const struct pgm_opt_length*)(nak  + 1);
+		if (PGM_UNLIKELY(opt_len->opt_type != PGM_OPT_LENGTH)) {
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed NAK rejected on unexpected primary PGM option type."));
+			sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS]++;
+			return FALSE;
+		}
+		if (PGM_UNLIKELY(opt_len->opt_length != sizeof(struct pgm_opt_length))) {
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed NAK rejected on length of length option header."));
+			sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS]++;
+			return FALSE;
+		}
+/* TODO: check for > 16 options & past packet end */
+		opt_header = (const struct pgm_opt_header*)opt_len;
+		do {
+			opt_header = (const struct pgm_opt_header*)((const char*)opt_header + opt_header->opt_length);
+			if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_NAK_LIST) {
+				nak_list = ((const struct pgm_opt_nak_list*)(opt_header + 1))->opt_sqn;
+				nak_list_len = ( opt_header->opt_length - sizeof(struct pgm_opt_header) - sizeof(uint8_t) ) / sizeof(uint32_t);
+				break;
+			}
+			if (sock->use_nak_range && !is_parity &&
+			    (opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_NAK_RANGE) {
+				opt_nak_range = (const struct pgm_opt_nak_range*)(opt_header + 1);
+				nak_range_len = ( opt_header->opt_length - sizeof(struct pgm_opt_header) - sizeof(uint8_t) ) / sizeof(struct pgm_nak_range);
+				break;
+			}
+		} while (!(opt_header->opt_type & PGM_OPT_END));
+	}
+
+/* runs of sequence numbers replace NAK_SQN */
+	if (NULL != opt_nak_range)
+		return on_nak_range (sock, src_addr, (struct sockaddr*)&nak_src_nla, (struct sockaddr*)&nak_grp_nla, opt_nak_range->opt_range, nak_range_len, skb->tstamp);
+
+/* nak list numbers */
+	if (PGM_UNLIKELY(nak_list_len > 62)) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed NAK rejected on sequence list overrun, %d reported NAKs."), nak_list_len);
+		return FALSE;
+	}
+		
+	for (uint_fast8_t i = 0; i < nak_list_len; i++)
+	{
+		sqn_list.sqn[sqn_list.len++] = pgm_ntohl (*nak_list);
+		nak_list++;
+	}
+
+/* sequences beyond the receiver's share are neither confirmed nor repaired,
+ * the receiver NAKs them again after NAK_RPT_IVL.
+ */
+	if (NULL != sock->nak_peers) {
+		const uint32_t accepted = nak_peer_admit (sock, src_addr, sqn_list.len, skb->tstamp);
+		if (0 == accepted) {
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("NAK rejected on receiver rate limit."));
+			return TRUE;
+		}
+		sqn_list.len = (uint8_t)accepted;
+		nak_list_len = (uint_fast8_t)(accepted - 1);
+	}
+
+	PGM_PROBE4 (nak_receive, sock, sqn_list.sqn[0], sqn_list.len, is_parity);
+
+/* merge with other NAKs of the burst, confirmed when the receive socket drains */
+	if (NULL != sock->ncf_batch)
+	{
+		ncf_batch_push (sock, (struct sockaddr*)&nak_grp_nla, &sqn_list, is_parity);
+	}
 	else
-		tpdu_length += sizeof(struct pgm_spm6);
-	if (sock->use_proactive_parity ||
-	    sock->use_ondemand_parity ||
-	    sock->is_pending_crqst ||
-	    PGM_OPT_FIN == flags)
 	{
-		tpdu_length += sizeof(struct pgm_opt_length);
-/* forward error correction */
-		if (sock->use_proactive_parity ||
-		    sock->use_ondemand_parity)
-			tpdu_length += sizeof(struct pgm_opt_header) +
-				       sizeof(struct pgm_opt_parity_prm);
-/* congestion report request */
-		if (sock->is_pending_crqst)
-			tpdu_length += sizeof(struct pgm_opt_header) +
-				       sizeof(struct pgm_opt_crqst);
-/* end of session */
-		if (PGM_OPT_FIN == flags)
-			tpdu_length += sizeof(struct pgm_opt_header) +
-				       sizeof(struct pgm_opt_fin);
+/* send NAK confirm packet immediately, then defer to timer thread for a.s.a.p
+ * delivery of the actual RDATA packets.  blocking send for NCF is ignored as RDATA
+ * broadcast will be sent later.
+ */
+		if (nak_list_len)
+			send_ncf_list (sock, (struct sockaddr*)&nak_src_nla, (struct sockaddr*)&nak_grp_nla, &sqn_list, is_parity);
+		else
+			send_ncf (sock, (struct sockaddr*)&nak_src_nla, (struct sockaddr*)&nak_grp_nla, sqn_list.sqn[0], is_parity);
+
+/* queue retransmit requests */
+		for (uint_fast8_t i = 0; i < sqn_list.len; i++) {
+			const bool push_status = pgm_txw_retransmit_push (sock->window, sqn_list.sqn[i], is_parity, sock->tg_sqn_shift);
+			if (PGM_UNLIKELY(!push_status)) {
+				pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Failed to push retransmit request for #%" PRIu32), sqn_list.sqn[i]);
+			}
+		}
+		if (NULL != sock->rdata_thread)
+			rdata_thread_notify (sock);
+	}
+
+/* loss observed by receivers, parity NAKs request count minus one packets */
+	if (sock->use_adaptive_parity) {
+		const uint32_t tg_sqn_mask = 0xffffffff << sock->tg_sqn_shift;
+		for (uint_fast8_t i = 0; i < sqn_list.len; i++)
+			sock->adaptive_nak_count += is_parity ? 1 + (sqn_list.sqn[i] & ~tg_sqn_mask) : 1;
+	}
+	return TRUE;
+}
+
+/* add the sequences of one NAK to the batch, a NAK for another group or
+ * beyond the batch capacity confirms the batch first.
+ */
+
+static
+void
+ncf_batch_push (
+	pgm_sock_t*		     const restrict sock,
+	const struct sockaddr*	     const restrict nak_grp_nla,
+	const struct pgm_sqn_list_t* const restrict sqn_list,
+	const bool				    is_parity
+	)
+{
+	struct pgm_ncf_batch_t* batch = sock->ncf_batch;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != batch);
+	pgm_assert (NULL != nak_grp_nla);
+	pgm_assert (NULL != sqn_list);
+
+	if ((batch->len[0] || batch->len[1]) &&
+	    0 != pgm_sockaddr_cmp ((const struct sockaddr*)&batch->grp_nla, nak_grp_nla))
+		pgm_ncf_batch_flush (sock);
+	if (0 == batch->len[0] && 0 == batch->len[1])
+		memcpy (&batch->grp_nla, nak_grp_nla, pgm_sockaddr_len (nak_grp_nla));
+
+	uint32_t* sqn = batch->sqn[ is_parity ? 1 : 0 ];
+	unsigned* len = &batch->len[ is_parity ? 1 : 0 ];
+	for (unsigned i = 0; i < sqn_list->len; i++)
+	{
+		unsigned j;
+		for (j = 0; j < *len; j++)
+			if (sqn[ j ] == sqn_list->sqn[ i ])
+				break;
+		if (j < *len)
+			continue;
+		if (PGM_UNLIKELY(PGM_NCF_BATCH_MAX == *len)) {
+			pgm_ncf_batch_flush (sock);
+			memcpy (&batch->grp_nla, nak_grp_nla, pgm_sockaddr_len (nak_grp_nla));
+		}
+		sqn[ (*len)++ ] = sqn_list->sqn[ i ];
+	}
+}
+
+/* confirm the batched NAKs with one NCF list per 63 distinct sequences of each
+ * kind and queue each sequence for repair once.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_ncf_batch_flush (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_ncf_batch_t* batch = sock->ncf_batch;
+	struct pgm_sqn_list_t sqn_list;
+	bool is_pushed = FALSE;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	if (NULL == batch)
+		return;
+	for (unsigned k = 0; k < 2; k++)
+	{
+		const bool is_parity = (1 == k);
+		for (unsigned i = 0; i < batch->len[ k ]; i += sqn_list.len)
+		{
+			sqn_list.len = (uint8_t)MIN(batch->len[ k ] - i, 63);
+			memcpy (sqn_list.sqn, &batch->sqn[ k ][ i ], sqn_list.len * sizeof(uint32_t));
+			if (sqn_list.len > 1)
+				send_ncf_list (sock, (struct sockaddr*)&sock->send_addr, (struct sockaddr*)&batch->grp_nla, &sqn_list, is_parity);
+			else
+				send_ncf (sock, (struct sockaddr*)&sock->send_addr, (struct sockaddr*)&batch->grp_nla, sqn_list.sqn[0], is_parity);
+		}
+		for (unsigned i = 0; i < batch->len[ k ]; i++) {
+			if (PGM_UNLIKELY(!pgm_txw_retransmit_push (sock->window, batch->sqn[ k ][ i ], is_parity, sock->tg_sqn_shift))) {
+				pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Failed to push retransmit request for #%" PRIu32), batch->sqn[ k ][ i ]);
+			}
+			is_pushed = TRUE;
+		}
+		batch->len[ k ] = 0;
+	}
+	if (is_pushed && NULL != sock->rdata_thread)
+		rdata_thread_notify (sock);
+}
+
+/* NAK with OPT_NAK_RANGE, each run is confirmed with one NCF and every
+ * sequence number queued for repair.  a run beyond the transmit window is
+ * rejected as malformed.
+ *
+ * if NAK is valid, returns TRUE.  on error, FALSE is returned.
+ */
+
+static
+bool
+on_nak_range (
+	pgm_sock_t*		    const restrict sock,
+	const struct sockaddr*	    const restrict src_addr,
+	const struct sockaddr*	    const restrict nak_src_nla,
+	const struct sockaddr*	    const restrict nak_grp_nla,
+	const struct pgm_nak_range*	  restrict nak_range,
+	const unsigned				   nak_range_len,
+	const pgm_time_t			   now
+	)
+{
+	struct pgm_sqn_range_list_t range_list;
+	const uint32_t max_length = (uint32_t)pgm_txw_max_length (sock->window);
+	uint32_t nak_count = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != nak_range);
+
+	if (PGM_UNLIKELY(0 == nak_range_len || nak_range_len > PGM_SQN_RANGE_MAX)) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed NAK rejected on %u sequence runs."), nak_range_len);
+		sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS]++;
+		return FALSE;
+	}
+	for (unsigned i = 0; i < nak_range_len; i++)
+	{
+		const uint32_t count = pgm_ntohl (nak_range[i].range_count);
+		if (PGM_UNLIKELY(0 == count || count > max_length - nak_count)) {
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed NAK rejected on sequence run overrun."));
+			sock->cumulative_stats[PGM_PC_SOURCE_MALFORMED_NAKS]++;
+			return FALSE;
+		}
+		range_list.range[i].sqn   = pgm_ntohl (nak_range[i].range_sqn);
+		range_list.range[i].count = count;
+		nak_count += count;
+	}
+	range_list.len = (uint8_t)nak_range_len;
+
+/* trailing sequences beyond the receiver's share are dropped */
+	if (NULL != sock->nak_peers) {
+		uint32_t accepted = nak_peer_admit (sock, src_addr, nak_count, now);
+		if (0 == accepted) {
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("NAK rejected on receiver rate limit."));
+			return TRUE;
+		}
+		nak_count = accepted;
+		for (unsigned i = 0; i < range_list.len; i++) {
+			if (range_list.range[i].count >= accepted) {
+				range_list.range[i].count = accepted;
+				range_list.len = (uint8_t)(i + 1);
+				break;
+			}
+			accepted -= range_list.range[i].count;
+		}
+	}
+	PGM_PROBE4 (nak_receive, sock, range_list.range[0].sqn, nak_count, FALSE);
+
+	send_ncf_range (sock, nak_src_nla, nak_grp_nla, &range_list);
+
+/* queue retransmit requests */
+	for (unsigned i = 0; i < range_list.len; i++) {
+		for (uint32_t j = 0; j < range_list.range[i].count; j++) {
+			const uint32_t sqn = range_list.range[i].sqn + j;
+			if (PGM_UNLIKELY(!pgm_txw_retransmit_push (sock->window, sqn, FALSE, sock->tg_sqn_shift))) {
+				pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Failed to push retransmit request for #%" PRIu32), sqn);
+			}
+		}
+	}
+	if (NULL != sock->rdata_thread)
+		rdata_thread_notify (sock);
+
+	if (sock->use_adaptive_parity)
+		sock->adaptive_nak_count += nak_count;
+	return TRUE;
+}
+
+/* Null-NAK, or N-NAK propogated by a DLR for hand waving excitement
+ *
+ * if NNAK is valid, returns TRUE.  on error, FALSE is returned.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_on_nnak (
+	pgm_sock_t*           const restrict sock,
+	struct pgm_sk_buff_t* const restrict skb
+	)
+{
+	const struct pgm_nak	*nnak;
+	const struct pgm_nak6	*nnak6;
+	struct sockaddr_storage	 nnak_src_nla, nnak_grp_nla;
+	uint_fast8_t		 nnak_list_len = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != skb);
+
+	pgm_debug ("pgm_on_nnak (sock:%p skb:%p)",
+		(void*)sock, (void*)skb);
+
+	sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NNAK_PACKETS_RECEIVED]++;
+
+	if (PGM_UNLIKELY(!pgm_verify_nnak (skb))) {
+		sock->cumulative_stats[PGM_PC_SOURCE_NNAK_ERRORS]++;
+		return FALSE;
+	}
+
+	nnak  = (struct pgm_nak *)skb->data;
+	nnak6 = (struct pgm_nak6*)skb->data;
+		
+/* NAK_SRC_NLA contains our sock unicast NLA */
+	pgm_nla_to_sockaddr (&nnak->nak_src_nla_afi, (struct sockaddr*)&nnak_src_nla);
+
+	if (PGM_UNLIKELY(pgm_sockaddr_cmp ((struct sockaddr*)&nnak_src_nla, (struct sockaddr*)&sock->send_addr) != 0))
+	{
+		sock->cumulative_stats[PGM_PC_SOURCE_NNAK_ERRORS]++;
+		return FALSE;
+	}
+
+/* NAK_GRP_NLA containers our sock multicast group */ 
+	pgm_nla_to_sockaddr (pgm_is_inet6 (nnak_src_nla.ss_family) ? &nnak6->nak6_grp_nla_afi : &nnak->nak_grp_nla_afi, (struct sockaddr*)&nnak_grp_nla);
+	if (PGM_UNLIKELY(!is_send_group (sock, (struct sockaddr*)&nnak_grp_nla)))
+	{
+		sock->cumulative_stats[PGM_PC_SOURCE_NNAK_ERRORS]++;
+		return FALSE;
+	}
+
+/* check NNAK list */
+	if (skb->pgm_header->pgm_options & PGM_OPT_PRESENT)
+	{
+		const struct pgm_opt_length* opt_len = pgm_is_inet6 (nnak_src_nla.ss_family) ?
+							(const struct pgm_opt_length*)(nnak6 + 1) :
+							(const struct pgm_opt_length*)(nnak + 1);
+		if (PGM_UNLIKELY(opt_len->opt_type != PGM_OPT_LENGTH)) {
+			sock->cumulative_stats[PGM_PC_SOURCE_NNAK_ERRORS]++;
+			return FALSE;
+		}
+		if (PGM_UNLIKELY(opt_len->opt_length != sizeof(struct pgm_opt_length))) {
+			sock->cumulative_stats[PGM_PC_SOURCE_NNAK_ERRORS]++;
+			return FALSE;
+		}
+/* TODO: check for > 16 options & past packet end */
+		const struct pgm_opt_header* opt_header = (const struct pgm_opt_header*)opt_len;
+		do {
+			opt_header = (const struct pgm_opt_header*)((const char*)opt_header + opt_header->opt_length);
+			if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_NAK_LIST) {
+				nnak_list_len = ( opt_header->opt_length - sizeof(struct pgm_opt_header) - sizeof(uint8_t) ) / sizeof(uint32_t);
+				break;
+			}
+		} while (!(opt_header->opt_type & PGM_OPT_END));
+	}
+
+	sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NNAKS_RECEIVED] += 1 + nnak_list_len;
+/* losses repaired by a DLR still count towards proactive parity */
+	if (sock->use_adaptive_parity)
+		sock->adaptive_nak_count += 1 + nnak_list_len;
+	return TRUE;
+}
+
+/* ACK, sent upstream by one selected ACKER for congestion control feedback.
+ *
+ * if ACK is valid, returns TRUE.  on error, FALSE is returned.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_on_ack (
+	pgm_sock_t*           const restrict sock,
+	struct pgm_sk_buff_t* const restrict skb
+	)
+{
+	const struct pgm_ack	*ack;
+	bool			 is_acker = FALSE;
+	uint32_t		 ack_bitmap;
+	unsigned		 new_acks;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != skb);
+
+	pgm_debug ("pgm_on_ack (sock:%p skb:%p)",
+		(const void*)sock, (const void*)skb);
+
+	sock->cumulative_stats[PGM_PC_SOURCE_ACK_PACKETS_RECEIVED]++;
+
+	if (PGM_UNLIKELY(!pgm_verify_ack (skb))) {
+		sock->cumulative_stats[PGM_PC_SOURCE_ACK_ERRORS]++;
+		return FALSE;
+	}
+
+	if (!sock->use_pgmcc)
+		return FALSE;
+
+	ack = (struct pgm_ack*)skb->data;
+
+/* check PGMCC feedback option for new elections */
+	if (skb->pgm_header->pgm_options & PGM_OPT_PRESENT)
+	{
+		const struct pgm_opt_header *opt_header;
+		const struct pgm_opt_length *opt_len;
+
+		opt_len = (const struct pgm_opt_length*)(ack + 1);
+		if (PGM_UNLIKELY(opt_len->opt_type != PGM_OPT_LENGTH)) {
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed ACK rejected."));
+			return FALSE;
+		}
+		if (PGM_UNLIKELY(opt_len->opt_length != sizeof(struct pgm_opt_length))) {
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed ACK rejected."));
+			return FALSE;
+		}
+		opt_header = (const struct pgm_opt_header*)opt_len;
+		do {
+			opt_header = (const struct pgm_opt_header*)((const char*)opt_header + opt_header->opt_length);
+			if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_PGMCC_FEEDBACK) {
+				const struct pgm_opt_pgmcc_feedback* opt_pgmcc_feedback = (const struct pgm_opt_pgmcc_feedback*)(opt_header + 1);
+				is_acker = on_opt_pgmcc_feedback (sock, skb, opt_pgmcc_feedback);
+				if (NULL != sock->ack_peers) {
+					struct sockaddr_storage peer_nla;
+					pgm_nla_to_sockaddr (&opt_pgmcc_feedback->opt_nla_afi, (struct sockaddr*)&peer_nla);
+					ack_release_update (sock, (const struct sockaddr*)&peer_nla, pgm_ntohl (ack->ack_rx_max), pgm_ntohl (ack->ack_bitmap), skb->tstamp);
+				}
+				break;	/* ignore other options */
+			}
+		} while (!(opt_header->opt_type & PGM_OPT_END));
+	}
+
+/* ignore ACKs from other receivers or sessions */
+	if (!is_acker)
+		return TRUE;
+
+/* TFMCC rate follows the feedback alone */
+	if (sock->use_tfmcc)
+		return TRUE;
+
+/* reset ACK expiration */
+	sock->next_crqst = 0;
+
+/* count new ACK sequences */
+	const uint32_t ack_rx_max = pgm_ntohl (ack->ack_rx_max);
+	const int32_t delta = ack_rx_max - sock->ack_rx_max;
+/* ignore older ACKs when multiple active ACKers */
+	if (pgm_uint32_gt (ack_rx_max, sock->ack_rx_max))
+		sock->ack_rx_max = ack_rx_max;
+	ack_bitmap = pgm_ntohl (ack->ack_bitmap);
+	if (delta > 32)		sock->ack_bitmap = 0;		/* sequence jump ahead beyond past bitmap */
+	else if (delta > 0)	sock->ack_bitmap <<= delta;	/* immediate sequence */
+	else if (delta > -32)	ack_bitmap <<= -delta;		/* repair sequence scoped by bitmap */
+	else			ack_bitmap = 0;			/* old sequence */
+	new_acks = pgm_popcount32 (ack_bitmap & ~sock->ack_bitmap);
+	sock->ack_bitmap |= ack_bitmap;
+
+	if (0 == new_acks)
+		return TRUE;
+
+	const bool is_congestion_limited = (sock->tokens < pgm_fp8 (1));
+
+/* after loss detection cancel any further manipulation of the window
+ * until feedback is received for the next transmitted packet.
+ */
+	if (sock->is_congested)
+	{
+		if (pgm_uint32_lte (ack_rx_max, sock->suspended_sqn))
+		{
+			pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("PGMCC window token manipulation suspended due to congestion (T:%u W:%u)"),
+				   pgm_fp8tou (sock->tokens), pgm_fp8tou (sock->cwnd_size));
+			const uint_fast32_t token_inc = pgm_fp8mul (pgm_fp8 (new_acks), pgm_fp8 (1) + pgm_fp8div (pgm_fp8 (1), sock->cwnd_size));
+			sock->tokens = MIN( sock->tokens + token_inc, sock->cwnd_size );
+			goto notify_tx;
+		}
+		sock->is_congested = FALSE;
+	}
+
+/* count outstanding lost sequences */
+	const unsigned total_lost = pgm_popcount32 (~sock->ack_bitmap);
+
+/* no detected data loss at ACKer, increase congestion window size */
+	if (0 == total_lost)
+	{
+		uint_fast32_t n, token_inc;
+
+		new_acks += sock->acks_after_loss;
+		sock->acks_after_loss = 0;
+		n = pgm_fp8 (new_acks);
+		token_inc = 0;
+
+/* slow-start phase, exponential increase to SSTHRESH */
+		if (sock->cwnd_size < sock->ssthresh) {
+			const uint_fast32_t d = MIN( n, sock->ssthresh - sock->cwnd_size );
+			n -= d;
+			token_inc	 = d + d;
+			sock->cwnd_size += d;
+		}
+
+		const uint_fast32_t iw = pgm_fp8div (pgm_fp8 (1), sock->cwnd_size);
+
+/* linear window increase */
+		token_inc	+= pgm_fp8mul (n, pgm_fp8 (1) + iw);
+		sock->cwnd_size += pgm_fp8mul (n, iw);
+		sock->tokens	 = MIN( sock->tokens + token_inc, sock->cwnd_size );
+//		pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("PGMCC++ (T:%u W:%u)"),
+//			   pgm_fp8tou (sock->tokens), pgm_fp8tou (sock->cwnd_size));
+	}
+	else
+	{
+/* Look for an unacknowledged data packet which is followed by at least three
+ * acknowledged data packets, then the packet is assumed to be lost and PGMCC
+ * reacts by halving the window.
+ *
+ * Common value will be 0xfffffff7.
+ */
+		sock->acks_after_loss += new_acks;
+		if (sock->acks_after_loss >= 3)
+		{
+			sock->acks_after_loss = 0;
+			sock->suspended_sqn = ack_rx_max;
+			sock->is_congested = TRUE;
+			sock->cwnd_size = pgm_fp8div (sock->cwnd_size, pgm_fp8 (2));
+			if (sock->cwnd_size > sock->tokens)
+				sock->tokens = 0;
+			else
+				sock->tokens -= sock->cwnd_size;
+			sock->ack_bitmap = 0xffffffff;
+			pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("PGMCC congestion, half window size (T:%u W:%u)"),
+				   pgm_fp8tou (sock->tokens), pgm_fp8tou (sock->cwnd_size));
+		}
+	}
+
+/* token is now available so notify tx thread that transmission time is available */
+notify_tx:
+	if (is_congestion_limited &&
+	    sock->tokens >= pgm_fp8 (1))
+	{
+		pgm_notify_send (&sock->ack_notify);
+	}
+	return TRUE;
+}
+
+/* general POLL to the send group opening a new round, closing the previous:
+ * its responses scale by the matching probability into an estimate of the
+ * receiver population and the bit-mask of the new round is widened or
+ * narrowed to solicit about PGM_POLR_TARGET responses.
+ *
+ * on success, TRUE is returned, if operation would block, FALSE is returned.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_send_poll (
+	pgm_sock_t* const	sock
+	)
+{
+	size_t		   tpdu_length;
+	char		  *buf;
+	struct pgm_header *header;
+	struct pgm_poll	  *poll4;
+	struct pgm_poll6  *poll6;
+	ssize_t		   sent;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (sock->poll_ivl > 0);
+
+	pgm_debug ("pgm_send_poll (sock:%p)", (const void*)sock);
+
+	if (sock->is_poll_open)
+	{
+		const uint64_t population = (uint64_t)sock->polr_count << sock->poll_mask_bits;
+		sock->poll_population = (uint32_t)MIN(population, (uint64_t)UINT32_MAX);
+		sock->poll_loss_rate  = sock->polr_loss_rate;
+		sock->poll_rtt        = sock->polr_rtt;
+/* the smallest receiver MTU of the round bounds the TPDU, a path MTU lowered
+ * on EMSGSIZE is raised after PGM_PMTU_RAISE_IVL.
+ */
+		if (sock->use_pmtud) {
+			if (sock->pmtu_probed < sock->pmtu_ceiling &&
+			    pgm_time_after_eq (pgm_time_update_now(), sock->pmtu_probed_expiry))
+				sock->pmtu_probed = sock->pmtu_ceiling;
+			uint16_t path_mtu = sock->pmtu_probed;
+			if (0 != sock->polr_path_mtu && sock->polr_path_mtu < path_mtu)
+				path_mtu = sock->polr_path_mtu;
+			sock->pmtu_target = path_mtu;
+		}
+		unsigned mask_bits = 0;
+		while (mask_bits < 31 && (sock->poll_population >> mask_bits) > PGM_POLR_TARGET)
+			mask_bits++;
+		if (mask_bits != sock->poll_mask_bits) {
+			pgm_trace (PGM_LOG_ROLE_SESSION,_("Estimated %" PRIu32 " receivers, polling one in %u."),
+				   sock->poll_population, 1u << mask_bits);
+			sock->poll_mask_bits = mask_bits;
+		}
+		sock->is_poll_open = FALSE;
+	}
+	sock->polr_count     = 0;
+	sock->polr_loss_rate = 0;
+	sock->polr_rtt       = 0;
+	sock->polr_path_mtu  = 0;
+
+	const bool is_ip6 = pgm_is_inet6 (sock->send_addr.ss_family);
+	tpdu_length = sizeof(struct pgm_header) + (is_ip6 ? sizeof(struct pgm_poll6) : sizeof(struct pgm_poll));
+	buf = pgm_alloca (tpdu_length);
+	memset (buf, 0, tpdu_length);
+	header = (struct pgm_header*)buf;
+	poll4  = (struct pgm_poll *)(header + 1);
+	poll6  = (struct pgm_poll6*)(header + 1);
+	memcpy (header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
+	header->pgm_sport	= sock->tsi.sport;
+	header->pgm_dport	= sock->dport;
+	header->pgm_type	= PGM_POLL;
+	header->pgm_options	= 0;
+	header->pgm_tsdu_length	= 0;
+
+	const uint32_t poll_sqn   = sock->poll_sqn + 1;
+	const uint32_t poll_mask  = sock->poll_mask_bits ? (uint32_t)((1ULL << sock->poll_mask_bits) - 1) : 0;
+	const uint32_t poll_rand  = pgm_htonl (pgm_rand_int (&sock->rand_) & poll_mask);
+	const uint32_t poll_bo_ivl = (uint32_t)(sock->poll_ivl / 2);
+	poll4->poll_sqn		= pgm_htonl (poll_sqn);
+	poll4->poll_round	= 0;
+	poll4->poll_s_type	= pgm_htons (PGM_POLL_GENERAL);
+/* path nla, afi at the same offset for both families */
+	pgm_sockaddr_to_nla ((struct sockaddr*)&sock->send_addr, (char*)&poll4->poll_nla_afi);
+	if (is_ip6) {
+		poll6->poll6_bo_ivl	= pgm_htonl (poll_bo_ivl);
+		memcpy (poll6->poll6_rand, &poll_rand, sizeof(poll_rand));
+		poll6->poll6_mask	= pgm_htonl (poll_mask);
+	} else {
+		poll4->poll_bo_ivl	= pgm_htonl (poll_bo_ivl);
+		memcpy (poll4->poll_rand, &poll_rand, sizeof(poll_rand));
+		poll4->poll_mask	= pgm_htonl (poll_mask);
+	}
+	header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
+
+	sent = pgm_sendto (sock,
+			   FALSE,		/* not rate limited */
+			   NULL,
+			   TRUE,		/* with router alert */
+			   buf,
+			   tpdu_length,
+			   (struct sockaddr*)&sock->send_gsr.gsr_group,
+			   pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
+	if (sent < 0) {
+		const int save_errno = pgm_get_last_sock_error();
+		if (PGM_LIKELY(PGM_SOCK_EAGAIN == save_errno || PGM_SOCK_ENOBUFS == save_errno))
+		{
+			sock->blocklen = tpdu_length + sock->iphdr_len;
+			return FALSE;
+		}
+/* fall through silently on other errors */
+	}
+
+	sock->poll_sqn     = poll_sqn;
+	sock->is_poll_open = TRUE;
+	pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)tpdu_length);
+	return TRUE;
+}
+
+/* POLR answering a general POLL of this source.  OPT_PGMCC_FEEDBACK carries
+ * the loss rate and a time stamp echo of the receiver, aggregated into the
+ * worst of the round and offered to PGMCC ACKer election.  OPT_PATH_MTU
+ * carries the receiver interface MTU, aggregated into the smallest.
+ *
+ * returns TRUE on valid POLR of the open round, FALSE otherwise.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_on_polr (
+	pgm_sock_t*           const restrict sock,
+	struct pgm_sk_buff_t* const restrict skb
+	)
+{
+	const struct pgm_polr	*polr;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != skb);
+
+	pgm_debug ("pgm_on_polr (sock:%p skb:%p)",
+		(const void*)sock, (const void*)skb);
+
+	if (PGM_UNLIKELY(!pgm_verify_polr (skb))) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed POLR rejected."));
+		return FALSE;
+	}
+
+	polr = (const struct pgm_polr*)skb->data;
+	if (!sock->is_poll_open ||
+	    pgm_ntohl (polr->polr_sqn) != sock->poll_sqn)
+	{
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded POLR of closed poll round."));
+		return FALSE;
+	}
+	sock->polr_count++;
+
+	if (skb->pgm_header->pgm_options & PGM_OPT_PRESENT)
+	{
+		const struct pgm_opt_header *opt_header;
+		const struct pgm_opt_length *opt_len;
+
+		opt_len = (const struct pgm_opt_length*)(polr + 1);
+		if (PGM_UNLIKELY(opt_len->opt_type != PGM_OPT_LENGTH ||
+				 opt_len->opt_length != sizeof(struct pgm_opt_length)))
+		{
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Malformed POLR rejected."));
+			return FALSE;
+		}
+		opt_header = (const struct pgm_opt_header*)opt_len;
+		do {
+			opt_header = (const struct pgm_opt_header*)((const char*)opt_header + opt_header->opt_length);
+			if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_PGMCC_FEEDBACK) {
+				const struct pgm_opt_pgmcc_feedback* opt_pgmcc_feedback = (const struct pgm_opt_pgmcc_feedback*)(opt_header + 1);
+				const uint16_t opt_loss_rate = pgm_ntohs (opt_pgmcc_feedback->opt_loss_rate);
+				const uint32_t opt_tstamp = pgm_ntohl (opt_pgmcc_feedback->opt_tstamp);
+				sock->polr_loss_rate = MAX(sock->polr_loss_rate, opt_loss_rate);
+/* time stamp echo only from receivers of OPT_PGMCC_DATA */
+				if (0 != opt_tstamp) {
+					const uint32_t rtt = (uint32_t)(pgm_to_msecs (skb->tstamp) - opt_tstamp);
+					sock->polr_rtt = MAX(sock->polr_rtt, rtt);
+					if (sock->use_pgmcc)
+						on_opt_pgmcc_feedback (sock, skb, opt_pgmcc_feedback);
+				}
+			}
+			else if ((opt_header->opt_type & PGM_OPT_MASK) == PGM_OPT_PATH_MTU) {
+				const struct pgm_opt_path_mtu* opt_path_mtu = (const struct pgm_opt_path_mtu*)(opt_header + 1);
+				const uint16_t opt_mtu = pgm_ntohs (opt_path_mtu->opt_mtu);
+				if (0 != opt_mtu && (0 == sock->polr_path_mtu || opt_mtu < sock->polr_path_mtu))
+					sock->polr_path_mtu = opt_mtu;
+			}
+		} while (!(opt_header->opt_type & PGM_OPT_END));
+	}
+	return TRUE;
+}
+
+/* length of an SPM with the socket options and flags.
+ */
+
+static
+size_t
+spm_length (
+	const pgm_sock_t* const	sock,
+	const int		flags
+	)
+{
+	size_t tpdu_length = sizeof(struct pgm_header);
+	if (AF_INET == sock->send_gsr.gsr_group.ss_family)
+		tpdu_length += sizeof(struct pgm_spm);
+	else
+		tpdu_length += sizeof(struct pgm_spm6);
+	if (sock->use_proactive_parity ||
+	    sock->use_ondemand_parity ||
+	    sock->use_nak_range ||
+	    sock->use_crc32c ||
+	    NULL != sock->txlog ||
+	    sock->is_pending_crqst ||
+	    0 != sock->poll_population ||
+	    PGM_OPT_FIN == flags)
+	{
+		tpdu_length += sizeof(struct pgm_opt_length);
+/* late join */
+		if (NULL != sock->txlog)
+			tpdu_length += sizeof(struct pgm_opt_header) +
+				       sizeof(struct pgm_opt_join);
+/* forward error correction */
+		if (sock->use_proactive_parity ||
+		    sock->use_ondemand_parity)
+			tpdu_length += sizeof(struct pgm_opt_header) +
+				       sizeof(struct pgm_opt_parity_prm);
+/* range encoded NAKs */
+		if (sock->use_nak_range)
+			tpdu_length += sizeof(struct pgm_opt_header) +
+				       sizeof(uint8_t);
+/* receiver population */
+		if (0 != sock->poll_population)
+			tpdu_length += sizeof(struct pgm_opt_header) +
+				       sizeof(struct pgm_opt_population);
+/* CRC32C data trailers */
+		if (sock->use_crc32c)
+			tpdu_length += sizeof(struct pgm_opt_header) +
+				       sizeof(struct pgm_opt_crc32c);
+/* congestion report request */
+		if (sock->is_pending_crqst)
+			tpdu_length += sizeof(struct pgm_opt_header) +
+				       sizeof(struct pgm_opt_crqst);
+/* end of session */
+		if (PGM_OPT_FIN == flags)
+			tpdu_length += sizeof(struct pgm_opt_header) +
+				       sizeof(struct pgm_opt_fin);
+	}
+	return tpdu_length;
+}
+
+/* build an SPM into buf of spm_length() bytes, checksum field zero.  a pending
+ * congestion report request is consumed.
+ */
+
+static
+void
+spm_build (
+	pgm_sock_t* const restrict	sock,
+	char*	    const restrict	buf,
+	const int			flags
+	)
+{
+	struct pgm_header *header = (struct pgm_header*)buf;
+	struct pgm_spm	  *spm  = (struct pgm_spm *)(header + 1);
+	struct pgm_spm6	  *spm6 = (struct pgm_spm6*)(header + 1);
+	memcpy (header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
+	header->pgm_sport       = sock->tsi.sport;
+	header->pgm_dport       = sock->dport;
+	header->pgm_type        = PGM_SPM;
+	header->pgm_options     = 0;
+	header->pgm_checksum    = 0;
+	header->pgm_tsdu_length = 0;
+
+/* SPM */
+	spm->spm_sqn		= pgm_htonl (sock->spm_sqn);
+	spm->spm_trail		= pgm_htonl (source_trail (sock));
+	spm->spm_lead		= pgm_htonl (pgm_txw_lead_atomic (sock->window));
+	spm->spm_reserved	= 0;
+/* our nla */
+	pgm_sockaddr_to_nla ((struct sockaddr*)&sock->send_addr, (char*)&spm->spm_nla_afi);
+
+/* PGM options */
+	if (sock->use_proactive_parity ||
+	    sock->use_ondemand_parity ||
+	    sock->use_nak_range ||
+	    sock->use_crc32c ||
+	    NULL != sock->txlog ||
+	    sock->is_pending_crqst ||
+	    0 != sock->poll_population ||
+	    PGM_OPT_FIN == flags)
+	{
+		struct pgm_opt_header *opt_header, *last_opt_header;
+		struct pgm_opt_length* opt_len;
+		uint16_t opt_total_length;
+
+		if (AF_INET == sock->send_gsr.gsr_group.ss_family)
+			opt_header = (struct pgm_opt_header*)(spm + 1);
+		else
+			opt_header = (struct pgm_opt_header*)(spm6 + 1);
+		header->pgm_options |= PGM_OPT_PRESENT;
+		opt_len			= (struct pgm_opt_length*)opt_header;
+		opt_len->opt_type	= PGM_OPT_LENGTH;
+		opt_len->opt_length	= sizeof(struct pgm_opt_length);
+		opt_total_length	= sizeof(struct pgm_opt_length);
+		last_opt_header = opt_header = (struct pgm_opt_header*)(opt_len + 1);
+
+/* OPT_JOIN, first option at a fixed offset for stamping */
+		if (NULL != sock->txlog)
+		{
+			struct pgm_opt_join *opt_join;
+
+			opt_total_length += sizeof(struct pgm_opt_header) +
+					    sizeof(struct pgm_opt_join);
+			opt_header->opt_type	= PGM_OPT_JOIN;
+			opt_header->opt_length	= sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_join);
+			opt_join = (struct pgm_opt_join*)(opt_header + 1);
+			opt_join->opt_reserved = 0;
+			opt_join->opt_join_min = spm->spm_trail;
+			last_opt_header = opt_header;
+			opt_header = (struct pgm_opt_header*)(opt_join + 1);
+		}
+
+/* OPT_PARITY_PRM */
+		if (sock->use_proactive_parity ||
+		    sock->use_ondemand_parity)
+		{
+			struct pgm_opt_parity_prm *opt_parity_prm;
+
+			header->pgm_options |= PGM_OPT_NETWORK;
+			opt_total_length += sizeof(struct pgm_opt_header) +
+					    sizeof(struct pgm_opt_parity_prm);
+			opt_header->opt_type	= PGM_OPT_PARITY_PRM;
+			opt_header->opt_length	= sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_parity_prm);
+			opt_parity_prm = (struct pgm_opt_parity_prm*)(opt_header + 1);
+			opt_parity_prm->opt_reserved = (sock->use_proactive_parity ? PGM_PARITY_PRM_PRO : 0) |
+						       (sock->use_ondemand_parity ? PGM_PARITY_PRM_OND : 0);
+			opt_parity_prm->parity_prm_tgs = pgm_htonl (sock->rs_k);
+			last_opt_header = opt_header;
+			opt_header = (struct pgm_opt_header*)(opt_parity_prm + 1);
+		}
+
+/* OPT_NAK_RANGE */
+		if (sock->use_nak_range)
+		{
+			struct pgm_opt_nak_range *opt_nak_range;
+
+			opt_total_length += sizeof(struct pgm_opt_header) +
+					    sizeof(uint8_t);
+			opt_header->opt_type	= PGM_OPT_NAK_RANGE;
+			opt_header->opt_length	= sizeof(struct pgm_opt_header) + sizeof(uint8_t);
+			opt_nak_range = (struct pgm_opt_nak_range*)(opt_header + 1);
+			opt_nak_range->opt_reserved = 0;
+			last_opt_header = opt_header;
+			opt_header = (struct pgm_opt_header*)((char*)opt_header + opt_header->opt_length);
+		}
+
+/* OPT_POPULATION */
+		if (0 != sock->poll_population)
+		{
+			struct pgm_opt_population *opt_population;
+
+			opt_total_length += sizeof(struct pgm_opt_header) +
+					    sizeof(struct pgm_opt_population);
+			opt_header->opt_type	= PGM_OPT_POPULATION;
+			opt_header->opt_length	= sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_population);
+			opt_population = (struct pgm_opt_population*)(opt_header + 1);
+			opt_population->opt_reserved = 0;
+			opt_population->opt_population = pgm_htonl (sock->poll_population);
+			last_opt_header = opt_header;
+			opt_header = (struct pgm_opt_header*)(opt_population + 1);
+		}
+
+/* OPT_CRC32C */
+		if (sock->use_crc32c)
+		{
+			struct pgm_opt_crc32c *opt_crc32c;
+
+			opt_total_length += sizeof(struct pgm_opt_header) +
+					    sizeof(struct pgm_opt_crc32c);
+			opt_header->opt_type	= PGM_OPT_CRC32C;
+			opt_header->opt_length	= sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_crc32c);
+			opt_crc32c = (struct pgm_opt_crc32c*)(opt_header + 1);
+			opt_crc32c->opt_reserved = 0;
+			last_opt_header = opt_header;
+			opt_header = (struct pgm_opt_header*)(opt_crc32c + 1);
+		}
+
+/* OPT_CRQST */
+		if (sock->is_pending_crqst)
+		{
+			struct pgm_opt_crqst *opt_crqst;
+
+			header->pgm_options |= PGM_OPT_NETWORK;
+			opt_total_length += sizeof(struct pgm_opt_header) +
+					    sizeof(struct pgm_opt_crqst);
+			opt_header->opt_type	= PGM_OPT_CRQST;
+			opt_header->opt_length	= sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_crqst);
+			opt_crqst = (struct pgm_opt_crqst*)(opt_header + 1);
+/* request receiver worst path report, OPT_CR_RX_WP */
+			opt_crqst->opt_reserved = PGM_OPT_CRQST_RXP;
+			sock->is_pending_crqst = FALSE;
+			last_opt_header = opt_header;
+			opt_header = (struct pgm_opt_header*)(opt_crqst + 1);
+		}
+
+/* OPT_FIN */
+		if (PGM_OPT_FIN == flags)
+		{
+			struct pgm_opt_fin *opt_fin;
+
+			opt_total_length += sizeof(struct pgm_opt_header) +
+					    sizeof(struct pgm_opt_fin);
+			opt_header->opt_type	= PGM_OPT_FIN;
+			opt_header->opt_length	= sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_fin);
+			opt_fin = (struct pgm_opt_fin*)(opt_header + 1);
+			opt_fin->opt_reserved = 0;
+			last_opt_header = opt_header;
+			opt_header = (struct pgm_opt_header*)(opt_fin + 1);
+		}
+
+		last_opt_header->opt_type |= PGM_OPT_END;
+		opt_len->opt_total_length = pgm_htons (opt_total_length);
+	}
+}
+
+/* build the SPM template of a connecting socket, the NLA and FEC and NAK range
+ * options do not change once connected, OPT_JOIN follows the trail.  the
+ * template is rebuilt when a POLL round changes the advertised population.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_spm_template_init (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (!sock->is_pending_crqst);
+
+	struct pgm_spm* spm = (struct pgm_spm*)(sock->spm_template.header + sizeof(struct pgm_header));
+
+	memset (&sock->spm_template, 0, sizeof(struct pgm_spm_template_t));
+	sock->spm_template.header_length = (uint16_t)spm_length (sock, 0);
+	pgm_assert (sock->spm_template.header_length <= sizeof(sock->spm_template.header));
+	spm_build (sock, sock->spm_template.header, 0);
+	sock->spm_template.population = sock->poll_population;
+/* sequence number and window edges stamped per packet */
+	spm->spm_sqn = spm->spm_trail = spm->spm_lead = 0;
+	if (NULL != sock->txlog) {
+		sock->spm_template.join_offset = (uint16_t)(sizeof(struct pgm_header) +
+							    (AF_INET == sock->send_gsr.gsr_group.ss_family ? sizeof(struct pgm_spm) : sizeof(struct pgm_spm6)) +
+							    sizeof(struct pgm_opt_length) +
+							    sizeof(struct pgm_opt_header) +
+							    offsetof(struct pgm_opt_join, opt_join_min));
+		memset (sock->spm_template.header + sock->spm_template.join_offset, 0, sizeof(uint32_t));
+	}
+	sock->spm_template.unfolded_header = pgm_csum_partial (sock->spm_template.header, sock->spm_template.header_length, 0);
+}
+
+/* ambient/heartbeat SPM's
+ *
+ * heartbeat: ihb_tmr decaying between ihb_min and ihb_max 2x after last packet
+ *
+ * once connected heartbeat and ambient SPMs copy the socket template patching
+ * the sequence number and window edges.
+ *
+ * on success, TRUE is returned, if operation would block, FALSE is returned.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_send_spm (
+	pgm_sock_t* const	sock,
+	const int		flags
+	)
+{
+	size_t		   tpdu_length;
+	char		  *buf;
+	ssize_t		   sent;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->window);
+
+	pgm_debug ("pgm_send_spm (sock:%p flags:%d)",
+		(const void*)sock, flags);
+
+/* the primary announces the session until takeover */
+	if (PGM_UNLIKELY(sock->is_standby))
+		return TRUE;
+
+	if (PGM_LIKELY(sock->is_connected &&
+		       PGM_OPT_FIN != flags &&
+		       !sock->is_pending_crqst))
+	{
+		struct pgm_header *header;
+		struct pgm_spm	  *spm;
+
+		if (PGM_UNLIKELY(sock->spm_template.population != sock->poll_population))
+			pgm_spm_template_init (sock);
+		tpdu_length = sock->spm_template.header_length;
+		buf = pgm_alloca (tpdu_length);
+		memcpy (buf, sock->spm_template.header, tpdu_length);
+		header = (struct pgm_header*)buf;
+		spm = (struct pgm_spm*)(header + 1);
+		spm->spm_sqn	= pgm_htonl (sock->spm_sqn);
+		spm->spm_trail	= pgm_htonl (source_trail (sock));
+		spm->spm_lead	= pgm_htonl (pgm_txw_lead_atomic (sock->window));
+/* sequence number, trail and lead are contiguous at an even offset */
+		uint32_t unfolded_stamp = pgm_csum_block_add (sock->spm_template.unfolded_header,
+							      pgm_csum_partial (&spm->spm_sqn, 3 * sizeof(uint32_t), 0),
+							      sizeof(struct pgm_header));
+/* OPT_JOIN minimum is the advertised trail, at an odd offset */
+		if (sock->spm_template.join_offset) {
+			memcpy (buf + sock->spm_template.join_offset, &spm->spm_trail, sizeof(uint32_t));
+			unfolded_stamp = pgm_csum_block_add (unfolded_stamp,
+							     pgm_csum_partial (&spm->spm_trail, sizeof(uint32_t), 0),
+							     sock->spm_template.join_offset);
+		}
+		header->pgm_checksum = pgm_csum_fold (unfolded_stamp);
+	}
+	else
+	{
+		tpdu_length = spm_length (sock, flags);
+		buf = pgm_alloca (tpdu_length);
+		spm_build (sock, buf, flags);
+/* checksum optional for SPMs */
+		((struct pgm_header*)buf)->pgm_checksum = pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
+	}
+
+	sent = pgm_sendto (sock,
+			   flags != PGM_OPT_SYN && sock->is_controlled_spm && !sock->use_tx_priority,	/* rate limited */
+			   NULL,
+			   TRUE,		/* with router alert */
+			   buf,
+			   tpdu_length,
+			   (struct sockaddr*)&sock->send_gsr.gsr_group,
+			   pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
+	if (sent < 0) {
+		const int save_errno = pgm_get_last_sock_error();
+		if (PGM_LIKELY(PGM_SOCK_EAGAIN == save_errno || PGM_SOCK_ENOBUFS == save_errno))
+		{
+			sock->blocklen = tpdu_length + sock->iphdr_len;
+			return FALSE;
+		}
+/* fall through silently on other errors */
+	}
+
+/* sequence state of the standby */
+	if (NULL != sock->standby && sock->standby->is_mirror)
+		pgm_standby_mirror (sock->standby, buf, tpdu_length);
+
+/* advance SPM sequence only on successful transmission */
+	sock->spm_sqn++;
+	pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)tpdu_length);
+	pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_SPMS_SENT], 1);
+	return TRUE;
+}
+
+/* original data carries the window trail making ambient SPMs redundant whilst
+ * it flows, they are skipped until spm_suppress_ivl has passed since the last
+ * SPM.  an ambient interval without data restores them, as does the heartbeat
+ * following the last packet which is never suppressed.
+ *
+ * returns TRUE if the ambient SPM due at now is to be skipped.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_spm_is_suppressed (
+	pgm_sock_t* const	sock,
+	const pgm_time_t	now
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	if (0 == sock->spm_suppress_ivl)
+		return FALSE;
+
+	pgm_sock_mutex_lock (sock, &sock->timer_mutex);
+	const pgm_time_t spm_data_tstamp = sock->spm_data_tstamp;
+	pgm_sock_mutex_unlock (sock, &sock->timer_mutex);
+
+	if (0 == spm_data_tstamp ||
+	    pgm_time_after_eq (now, spm_data_tstamp + sock->spm_ambient_interval) ||
+	    pgm_time_after_eq (now, sock->spm_tstamp + sock->spm_suppress_ivl))
+		return FALSE;
+
+	pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_SPMS_SUPPRESSED], 1);
+	return TRUE;
+}
+
+/* send a NAK confirm (NCF) message with provided sequence number list.
+ *
+ * on success, TRUE is returned, returns FALSE if operation would block.
+ */
+
+static
+bool
+send_ncf (
+	pgm_sock_t*            const restrict sock,
+	const struct sockaddr* const restrict nak_src_nla,
+	const struct sockaddr* const restrict nak_grp_nla,
+	const uint32_t			      sequence,
+	const bool			      is_parity		/* send parity NCF */
+	)
+{
+	size_t		   tpdu_length;
+	char		  *buf;
+	struct pgm_header *header;
+	struct pgm_nak	  *ncf;
+	struct pgm_nak6	  *ncf6;
+	ssize_t		   sent;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != nak_src_nla);
+	pgm_assert (NULL != nak_grp_nla);
+	pgm_assert (nak_src_nla->sa_family == nak_grp_nla->sa_family);
+
+#ifdef SOURCE_DEBUG
+	char saddr[INET6_ADDRSTRLEN], gaddr[INET6_ADDRSTRLEN];
+	pgm_sockaddr_ntop (nak_src_nla, saddr, sizeof(saddr));
+	pgm_sockaddr_ntop (nak_grp_nla, gaddr, sizeof(gaddr));
+	pgm_debug ("send_ncf (sock:%p nak-src-nla:%s nak-grp-nla:%s sequence:%" PRIu32" is-parity:%s)",
+		(void*)sock,
+		saddr,
+		gaddr,
+		sequence,
+		is_parity ? "TRUE": "FALSE"
+		);
+#endif
+
+	tpdu_length = sizeof(struct pgm_header);
+	tpdu_length += (AF_INET == nak_src_nla->sa_family) ?
+				sizeof(struct pgm_nak) :
+				sizeof(struct pgm_nak6);
+	buf = pgm_alloca (tpdu_length);
+	header = (struct pgm_header*)buf;
+	ncf  = (struct pgm_nak *)(header + 1);
+	ncf6 = (struct pgm_nak6*)(header + 1);
+	memcpy (header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
+	header->pgm_sport	= sock->tsi.sport;
+	header->pgm_dport	= sock->dport;
+	header->pgm_type        = PGM_NCF;
+        header->pgm_options     = is_parity ? PGM_OPT_PARITY : 0;
+        header->pgm_tsdu_length = 0;
+
+/* NCF */
+	ncf->nak_sqn		= pgm_htonl (sequence);
+
+/* source nla */
+	pgm_sockaddr_to_nla (nak_src_nla, (char*)&ncf->nak_src_nla_afi);
+
+/* group nla */
+	pgm_sockaddr_to_nla (nak_grp_nla, pgm_is_inet6 (nak_src_nla->sa_family) ?
+						(char*)&ncf6->nak6_grp_nla_afi :
+						(char*)&ncf->nak_grp_nla_afi );
+        header->pgm_checksum = 0;
+        header->pgm_checksum = pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
+
+	sent = pgm_sendto (sock,
+			   FALSE,			/* not rate limited */
+			   NULL,
+			   TRUE,			/* with router alert */
+			   buf,
+			   tpdu_length,
+			   (struct sockaddr*)&sock->send_gsr.gsr_group,
+			   pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
+	if (sent < 0 && PGM_LIKELY(PGM_SOCK_EAGAIN == pgm_get_last_sock_error()))
+		return FALSE;
+/* fall through silently on other errors */
+			
+	PGM_PROBE4 (ncf_send, sock, sequence, 1, is_parity);
+	pgm_flightrec_add (sock->flightrec, PGM_FLIGHTREC_NCF_SEND, is_parity ? PGM_OPT_PARITY : 0, sock->tsi.sport, sequence, 1);
+	pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)tpdu_length);
+	return TRUE;
+}
+
+/* A NCF packet with a OPT_NAK_LIST option extension
+ *
+ * on success, TRUE is returned.  on error, FALSE is returned.
+ */
+
+static
+bool
+send_ncf_list (
+	pgm_sock_t*            const restrict sock,
+	const struct sockaddr* const restrict nak_src_nla,
+	const struct sockaddr* const restrict nak_grp_nla,
+	struct pgm_sqn_list_t* const restrict sqn_list,		/* will change to network-order */
+	const bool			      is_parity		/* send parity NCF */
+	)
+{
+	size_t			 tpdu_length;
+	char			*buf;
+	struct pgm_header	*header;
+	struct pgm_nak		*ncf;
+	struct pgm_nak6		*ncf6;
+	struct pgm_opt_header	*opt_header;
+	struct pgm_opt_length	*opt_len;
+	struct pgm_opt_nak_list	*opt_nak_list;
+	ssize_t			 sent;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != nak_src_nla);
+	pgm_assert (NULL != nak_grp_nla);
+	pgm_assert (sqn_list->len > 1);
+	pgm_assert (sqn_list->len <= 63);
+	pgm_assert (nak_src_nla->sa_family == nak_grp_nla->sa_family);
+
+#ifdef SOURCE_DEBUG
+	char saddr[INET6_ADDRSTRLEN], gaddr[INET6_ADDRSTRLEN];
+	char list[1024];
+	pgm_sockaddr_ntop (nak_src_nla, saddr, sizeof(saddr));
+	pgm_sockaddr_ntop (nak_grp_nla, gaddr, sizeof(gaddr));
+	sprintf (list, "%" PRIu32, sqn_list->sqn[0]);
+	for (uint_fast8_t i = 1; i < sqn_list->len; i++) {
+		char sequence[ 2 + strlen("4294967295") ];
+		sprintf (sequence, " %" PRIu32, sqn_list->sqn[i]);
+		strcat (list, sequence);
+	}
+	pgm_debug ("send_ncf_list (sock:%p nak-src-nla:%s nak-grp-nla:%s sqn-list:[%s] is-parity:%s)",
+		(void*)sock,
+		saddr,
+		gaddr,
+		list,
+		is_parity ? "TRUE": "FALSE"
+		);
+#endif
+
+	tpdu_length = sizeof(struct pgm_header) +
+			     sizeof(struct pgm_opt_length) +		/* includes header */
+			     sizeof(struct pgm_opt_header) + sizeof(uint8_t) +
+			     ( (sqn_list->len-1) * sizeof(uint32_t) );
+	tpdu_length += (AF_INET == nak_src_nla->sa_family) ? sizeof(struct pgm_nak) : sizeof(struct pgm_nak6);
+	buf = pgm_alloca (tpdu_length);
+	header = (struct pgm_header*)buf;
+	ncf  = (struct pgm_nak *)(header + 1);
+	ncf6 = (struct pgm_nak6*)(header + 1);
+	memcpy (header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
+	header->pgm_sport	= sock->tsi.sport;
+	header->pgm_dport	= sock->dport;
+	header->pgm_type        = PGM_NCF;
+        header->pgm_options     = is_parity ? (PGM_OPT_PRESENT | PGM_OPT_NETWORK | PGM_OPT_PARITY) : (PGM_OPT_PRESENT | PGM_OPT_NETWORK);
+        header->pgm_tsdu_length = 0;
+/* NCF */
+	ncf->nak_sqn		= pgm_htonl (sqn_list->sqn[0]);
+
+/* source nla */
+	pgm_sockaddr_to_nla (nak_src_nla, (char*)&ncf->nak_src_nla_afi);
+
+/* group nla */
+	pgm_sockaddr_to_nla (nak_grp_nla, pgm_is_inet6 (nak_src_nla->sa_family) ? (char*)&ncf6->nak6_grp_nla_afi : (char*)&ncf->nak_grp_nla_afi );
+
+/* OPT_NAK_LIST */
+	opt_len = pgm_is_inet6 (nak_src_nla->sa_family) ? (struct pgm_opt_length*)(ncf6 + 1) : (struct pgm_opt_length*)(ncf + 1);
+	opt_len->opt_type	= PGM_OPT_LENGTH;
+	opt_len->opt_length	= sizeof(struct pgm_opt_length);
+	opt_len->opt_total_length = pgm_htons ((uint16_t)(sizeof(struct pgm_opt_length) +
+						sizeof(struct pgm_opt_header) +
+						sizeof(uint8_t) +
+						( (sqn_list->len-1) * sizeof(uint32_t) )));
+	opt_header = (struct pgm_opt_header*)(opt_len + 1);
+	opt_header->opt_type	= PGM_OPT_NAK_LIST | PGM_OPT_END;
+	opt_header->opt_length	= sizeof(struct pgm_opt_header) +
+				  sizeof(uint8_t) +
+				  ( (sqn_list->len-1) * sizeof(uint32_t) );
+	opt_nak_list = (struct pgm_opt_nak_list*)(opt_header + 1);
+	opt_nak_list->opt_reserved = 0;
+/* to network-order */
+	for (uint_fast8_t i = 1; i < sqn_list->len; i++)
+		opt_nak_list->opt_sqn[i-1] = pgm_htonl (sqn_list->sqn[i]);
+
+        header->pgm_checksum    = 0;
+        header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
+
+	sent = pgm_sendto (sock,
+			   FALSE,			/* not rate limited */
+			   NULL,
+			   TRUE,			/* with router alert */
+			   buf,
+			   tpdu_length,
+			   (struct sockaddr*)&sock->send_gsr.gsr_group,
+			   pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
+	if (sent < 0 && PGM_LIKELY(PGM_SOCK_EAGAIN == pgm_get_last_sock_error()))
+		return FALSE;
+/* fall through silently on other errors */
+
+	PGM_PROBE4 (ncf_send, sock, sqn_list->sqn[0], sqn_list->len, is_parity);
+	pgm_flightrec_add (sock->flightrec, PGM_FLIGHTREC_NCF_SEND, is_parity ? PGM_OPT_PARITY : 0, sock->tsi.sport, sqn_list->sqn[0], sqn_list->len);
+	pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)tpdu_length);
+	return TRUE;
+}
+
+/* A NCF packet with a OPT_NAK_RANGE option extension, mirroring the NAK.
+ *
+ * on success, TRUE is returned.  on error, FALSE is returned.
+ */
+
+static
+bool
+send_ncf_range (
+	pgm_sock_t*		       const restrict sock,
+	const struct sockaddr*	       const restrict nak_src_nla,
+	const struct sockaddr*	       const restrict nak_grp_nla,
+	const struct pgm_sqn_range_list_t* const restrict range_list
+	)
+{
+	size_t			  tpdu_length;
+	char			 *buf;
+	struct pgm_header	 *header;
+	struct pgm_nak		 *ncf;
+	struct pgm_nak6		 *ncf6;
+	struct pgm_opt_header	 *opt_header;
+	struct pgm_opt_length	 *opt_len;
+	struct pgm_opt_nak_range *opt_nak_range;
+	ssize_t			  sent;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != nak_src_nla);
+	pgm_assert (NULL != nak_grp_nla);
+	pgm_assert (range_list->len > 0);
+	pgm_assert (range_list->len <= PGM_SQN_RANGE_MAX);
+	pgm_assert (nak_src_nla->sa_family == nak_grp_nla->sa_family);
+
+	pgm_debug ("send_ncf_range (sock:%p nak-src-nla:%p nak-grp-nla:%p range-list:%p)",
+		(void*)sock, (const void*)nak_src_nla, (const void*)nak_grp_nla, (const void*)range_list);
+
+	const uint16_t opt_range_length = sizeof(struct pgm_opt_header) +
+					  sizeof(uint8_t) +
+					  ( range_list->len * sizeof(struct pgm_nak_range) );
+	tpdu_length = sizeof(struct pgm_header) +
+			     sizeof(struct pgm_opt_length) +
+			     opt_range_length;
+	tpdu_length += (AF_INET == nak_src_nla->sa_family) ? sizeof(struct pgm_nak) : sizeof(struct pgm_nak6);
+	buf = pgm_alloca (tpdu_length);
+	header = (struct pgm_header*)buf;
+	ncf  = (struct pgm_nak *)(header + 1);
+	ncf6 = (struct pgm_nak6*)(header + 1);
+	memcpy (header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
+	header->pgm_sport	= sock->tsi.sport;
+	header->pgm_dport	= sock->dport;
+	header->pgm_type        = PGM_NCF;
+        header->pgm_options     = PGM_OPT_PRESENT | PGM_OPT_NETWORK;
+        header->pgm_tsdu_length = 0;
+/* NCF */
+	ncf->nak_sqn		= pgm_htonl (range_list->range[0].sqn);
+
+/* source nla */
+	pgm_sockaddr_to_nla (nak_src_nla, (char*)&ncf->nak_src_nla_afi);
+
+/* group nla */
+	pgm_sockaddr_to_nla (nak_grp_nla, pgm_is_inet6 (nak_src_nla->sa_family) ? (char*)&ncf6->nak6_grp_nla_afi : (char*)&ncf->nak_grp_nla_afi );
+
+/* OPT_NAK_RANGE */
+	opt_len = pgm_is_inet6 (nak_src_nla->sa_family) ? (struct pgm_opt_length*)(ncf6 + 1) : (struct pgm_opt_length*)(ncf + 1);
+	opt_len->opt_type	= PGM_OPT_LENGTH;
+	opt_len->opt_length	= sizeof(struct pgm_opt_length);
+	opt_len->opt_total_length = pgm_htons ((uint16_t)(sizeof(struct pgm_opt_length) + opt_range_length));
+	opt_header = (struct pgm_opt_header*)(opt_len + 1);
+	opt_header->opt_type	= PGM_OPT_NAK_RANGE | PGM_OPT_END;
+	opt_header->opt_length	= (uint8_t)opt_range_length;
+	opt_nak_range = (struct pgm_opt_nak_range*)(opt_header + 1);
+	opt_nak_range->opt_reserved = 0;
+/* to network-order */
+	for (uint_fast8_t i = 0; i < range_list->len; i++) {
+		opt_nak_range->opt_range[i].range_sqn   = pgm_htonl (range_list->range[i].sqn);
+		opt_nak_range->opt_range[i].range_count = pgm_htonl (range_list->range[i].count);
+	}
+
+        header->pgm_checksum    = 0;
+        header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
+
+	sent = pgm_sendto (sock,
+			   FALSE,			/* not rate limited */
+			   NULL,
+			   TRUE,			/* with router alert */
+			   buf,
+			   tpdu_length,
+			   (struct sockaddr*)&sock->send_gsr.gsr_group,
+			   pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
+	if (sent < 0 && PGM_LIKELY(PGM_SOCK_EAGAIN == pgm_get_last_sock_error()))
+		return FALSE;
+/* fall through silently on other errors */
+
+	PGM_PROBE4 (ncf_send, sock, range_list->range[0].sqn, range_list->len, FALSE);
+	pgm_flightrec_add (sock->flightrec, PGM_FLIGHTREC_NCF_SEND, 0, sock->tsi.sport, range_list->range[0].sqn, range_list->len);
+	pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)tpdu_length);
+	return TRUE;
+}
+
+/* cancel any pending heartbeat SPM and schedule a new one
+ */
+
+static
+void
+reset_heartbeat_spm (
+	pgm_sock_t*const	sock,
+	const pgm_time_t	now
+	)
+{
+	bool is_pulled = FALSE;
+	pgm_sock_mutex_lock (sock, &sock->timer_mutex);
+	const pgm_time_t next_poll = sock->next_poll;
+	const pgm_time_t spm_heartbeat_interval = sock->spm_heartbeat_interval[ sock->spm_heartbeat_state = 1 ];
+	sock->next_heartbeat_spm = now + spm_heartbeat_interval;
+	sock->spm_data_tstamp = now;
+	if (pgm_time_after( next_poll, sock->next_heartbeat_spm ))
+	{
+		sock->next_poll = sock->next_heartbeat_spm;
+		if (!sock->is_pending_read) {
+			pgm_notify_send (&sock->pending_notify);
+			sock->is_pending_read = TRUE;
+		}
+		is_pulled = TRUE;
+	}
+	pgm_sock_mutex_unlock (sock, &sock->timer_mutex);
+	if (is_pulled)
+		pgm_engine_timer_wake (now + spm_heartbeat_interval);
+}
+
+/* partial checksum of ODATA payload, skipped on zero checksum sockets where the
+ * UDP checksum already covers the packet, or the CRC32C of the payload with
+ * trailers.
+ */
+
+static inline
+uint32_t
+odata_csum_partial (
+	const pgm_sock_t* const restrict sock,
+	const void*		restrict data,
+	const uint16_t			 len
+	)
+{
+	if (sock->use_crc32c)
+		return pgm_crc32c (0, data, len);
+	if (sock->use_zero_checksum)
+		return 0;
+	return pgm_csum_partial (data, len, 0);
+}
+
+static inline
+uint32_t
+odata_csum_partial_copy (
+	const pgm_sock_t* const restrict sock,
+	const void*		restrict src,
+	void*			restrict dst,
+	const uint16_t			 len
+	)
+{
+	if (sock->use_crc32c) {
+		memcpy (dst, src, len);
+		return pgm_crc32c (0, src, len);
+	}
+	if (sock->use_zero_checksum) {
+		memcpy (dst, src, len);
+		return 0;
+	}
+	return pgm_csum_partial_copy (src, dst, len, 0);
+}
+
+/* copy a fragment of an APDU, streaming past the cache when the APDU is at
+ * least PGM_STREAM_COPY bytes.  the CRC is taken of the source, as the
+ * destination is no longer cached.
+ */
+
+static inline
+uint32_t
+odata_csum_partial_copy_apdu (
+	const pgm_sock_t* const restrict sock,
+	const void*		restrict src,
+	void*			restrict dst,
+	const uint16_t			 len,
+	const size_t			 apdu_length
+	)
+{
+	if (0 == sock->stream_copy_len || apdu_length < sock->stream_copy_len)
+		return odata_csum_partial_copy (sock, src, dst, len);
+	if (sock->use_crc32c) {
+		pgm_memcpy_nt (dst, src, len);
+		return pgm_crc32c (0, src, len);
+	}
+	if (sock->use_zero_checksum) {
+		pgm_memcpy_nt (dst, src, len);
+		return 0;
+	}
+	return pgm_csum_partial_copy_nt (src, dst, len, 0);
+}
+
+/* continue the payload checksum csum of a scatter/gather copy with the next
+ * element at offset, the CRC32C continues over the element itself.
+ */
+
+static inline
+uint32_t
+odata_csum_partial_copy_next (
+	const pgm_sock_t* const restrict sock,
+	const void*		restrict src,
+	void*			restrict dst,
+	const uint16_t			 len,
+	const size_t			 apdu_length,
+	const uint32_t			 csum,
+	const uint16_t			 offset
+	)
+{
+	if (sock->use_crc32c) {
+		const uint32_t crc = pgm_crc32c (csum, src, len);
+		if (0 == sock->stream_copy_len || apdu_length < sock->stream_copy_len)
+			memcpy (dst, src, len);
+		else
+			pgm_memcpy_nt (dst, src, len);
+		return crc;
+	}
+	const uint32_t unfolded_element = odata_csum_partial_copy_apdu (sock, src, dst, len, apdu_length);
+	return pgm_csum_block_add (csum, unfolded_element, offset);
+}
+
+/* write the CRC32C trailer after the TSDU, covering the payload CRC crc_odata
+ * and then the header with a zero checksum field.  tail is extended on first
+ * use, repairs rewrite the trailer in place.
+ */
+
+static inline
+void
+data_crc32c_trailer (
+	pgm_sock_t*		 const restrict sock,
+	struct pgm_sk_buff_t*	 const restrict skb,
+	const uint16_t				header_length,
+	const uint32_t				crc_odata
+	)
+{
+	char* trailer = (char*)skb->pgm_header + header_length + pgm_ntohs (skb->pgm_header->pgm_tsdu_length);
+	const uint32_t crc = pgm_htonl (pgm_crc32c (crc_odata, skb->pgm_header, header_length));
+	if (!skb->crc32c) {
+		pgm_assert (trailer == (char*)skb->tail);
+		pgm_assert ((char*)skb->tail + sizeof(uint32_t) <= (char*)skb->end);
+		skb->tail = trailer + sizeof(uint32_t);
+		skb->crc32c = 1;
+	}
+	memcpy (trailer, &crc, sizeof(crc));
+}
+
+/* fold header and unfolded payload checksums of an ODATA or RDATA packet,
+ * header checksum field must be zero.
+ *
+ * returns zero, no transmitted checksum, on zero checksum sockets and with
+ * CRC32C trailers.
+ */
+
+static inline
+uint16_t
+data_csum_fold (
+	pgm_sock_t*		 const restrict sock,
+	struct pgm_sk_buff_t*	 const restrict skb,
+	const uint16_t				header_length,
+	const uint32_t				unfolded_odata
+	)
+{
+	if (sock->use_crc32c) {
+		data_crc32c_trailer (sock, skb, header_length, unfolded_odata);
+		return 0;
+	}
+	if (sock->use_zero_checksum) {
+		sock->zero_checksum_sent++;
+		return 0;
+	}
+	const uint32_t unfolded_header = pgm_csum_partial (skb->pgm_header, header_length, 0);
+	return pgm_csum_fold (pgm_csum_block_add (unfolded_header, unfolded_odata, header_length));
+}
+
+/* fold an unfolded header checksum with the unfolded payload checksum, as
+ * data_csum_fold() for headers stamped from a template.
+ */
+
+static inline
+uint16_t
+data_csum_fold_unfolded (
+	pgm_sock_t*		 const restrict sock,
+	struct pgm_sk_buff_t*	 const restrict skb,
+	const uint32_t				unfolded_header,
+	const uint16_t				header_length,
+	const uint32_t				unfolded_odata
+	)
+{
+	if (sock->use_crc32c) {
+		data_crc32c_trailer (sock, skb, header_length, unfolded_odata);
+		return 0;
+	}
+	if (sock->use_zero_checksum) {
+		sock->zero_checksum_sent++;
+		return 0;
+	}
+	return pgm_csum_fold (pgm_csum_block_add (unfolded_header, unfolded_odata, header_length));
+}
+
+/* build the ODATA header templates of a bound socket, the TSI, port and option
+ * layout do not change for the lifetime of the socket.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_odata_template_init (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	for (unsigned i = 0; i < PGM_ODATA_TEMPLATE_MAX; i++)
+	{
+		struct pgm_odata_template_t* template_ = &sock->odata_template[ i ];
+		struct pgm_header* header = (struct pgm_header*)template_->header;
+		struct pgm_data* odata = (struct pgm_data*)(header + 1);
+
+		memset (template_, 0, sizeof(struct pgm_odata_template_t));
+		memcpy (header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
+		header->pgm_sport	= sock->tsi.sport;
+		header->pgm_dport	= sock->dport;
+		header->pgm_type	= PGM_ODATA;
+		template_->header_length = sizeof(struct pgm_header) + sizeof(struct pgm_data);
+
+		if (PGM_ODATA_TEMPLATE_DATA != i) {
+			struct pgm_opt_length* opt_len = (struct pgm_opt_length*)(odata + 1);
+			struct pgm_opt_header* opt_header = (struct pgm_opt_header*)(opt_len + 1);
+			uint16_t opt_total_length = sizeof(struct pgm_opt_length) +
+						    sizeof(struct pgm_opt_header) +
+						    sizeof(struct pgm_opt_fragment);
+			header->pgm_options	= PGM_OPT_PRESENT;
+			opt_len->opt_type	= PGM_OPT_LENGTH;
+			opt_len->opt_length	= sizeof(struct pgm_opt_length);
+			opt_header->opt_type	= PGM_OPT_FRAGMENT | PGM_OPT_END;
+			opt_header->opt_length	= sizeof(struct pgm_opt_header) +
+						  sizeof(struct pgm_opt_fragment);
+/* compressed APDU, decompressed length stamped per APDU */
+			if (PGM_ODATA_TEMPLATE_COMPRESS == i) {
+				opt_header->opt_type	= PGM_OPT_FRAGMENT;
+				opt_header = (struct pgm_opt_header*)((char*)opt_header + opt_header->opt_length);
+				opt_header->opt_type	= PGM_OPT_COMPRESS | PGM_OPT_END;
+				opt_header->opt_length	= sizeof(struct pgm_opt_header) +
+							  sizeof(struct pgm_opt_compress);
+				opt_total_length += sizeof(struct pgm_opt_header) +
+						    sizeof(struct pgm_opt_compress);
+			}
+			opt_len->opt_total_length = pgm_htons (opt_total_length);
+			template_->header_length += opt_total_length;
+		}
+		template_->unfolded_header = pgm_csum_partial (template_->header, template_->header_length, 0);
+	}
+}
+
+/* copy an ODATA header template into the head of skb and stamp the length,
+ * sequence number and window trail, adjusting the template checksum by only
+ * the stamped fields.  sequence is the next lead of the window, or reserved
+ * ahead of it with PGM_MULTI_PRODUCER.
+ *
+ * returns the unfolded header checksum, zero on zero checksum sockets.
+ */
+
+static inline
+uint32_t
+odata_template_stamp (
+	pgm_sock_t*	      const restrict sock,
+	struct pgm_sk_buff_t* const restrict skb,
+	const unsigned			     template_index,
+	const uint16_t			     tsdu_length,
+	const uint32_t			     sequence
+	)
+{
+	const struct pgm_odata_template_t* template_ = &sock->odata_template[ template_index ];
+
+	skb->pgm_header	= (struct pgm_header*)skb->head;
+	skb->pgm_data	= (struct pgm_data*)(skb->pgm_header + 1);
+	memcpy (skb->pgm_header, template_->header, template_->header_length);
+	skb->pgm_header->pgm_tsdu_length = pgm_htons (tsdu_length);
+	skb->pgm_data->data_sqn		= pgm_htonl (sequence);
+	skb->pgm_data->data_trail	= pgm_htonl (source_trail (sock));
+	if (sock->use_zero_checksum || sock->use_crc32c)
+		return 0;
+/* TSDU length, sequence number and trail are contiguous at an even offset */
+	const uint32_t unfolded_stamp = pgm_csum_partial (&skb->pgm_header->pgm_tsdu_length,
+							  sizeof(uint16_t) + sizeof(struct pgm_data),
+							  0);
+	return pgm_csum_block_add (template_->unfolded_header,
+				   unfolded_stamp,
+				   offsetof(struct pgm_header, pgm_tsdu_length));
+}
+
+/* as odata_template_stamp() with the fragment option of one APDU, and the
+ * compress option when orig_length is non-zero.
+ */
+
+static inline
+uint32_t
+odata_template_stamp_fragment (
+	pgm_sock_t*	      const restrict sock,
+	struct pgm_sk_buff_t* const restrict skb,
+	const uint16_t			     tsdu_length,
+	const uint32_t			     sequence,
+	const uint32_t			     first_sqn,
+	const uint32_t			     frag_off,
+	const uint32_t			     apdu_length,
+	const uint32_t			     orig_length	/* decompressed, 0 for none */
+	)
+{
+	const unsigned template_index = orig_length ? PGM_ODATA_TEMPLATE_COMPRESS : PGM_ODATA_TEMPLATE_FRAGMENT;
+	uint32_t unfolded_header = odata_template_stamp (sock, skb, template_index, tsdu_length, sequence);
+	const struct pgm_opt_length* opt_len = (const struct pgm_opt_length*)(skb->pgm_data + 1);
+	const struct pgm_opt_header* opt_header = (const struct pgm_opt_header*)(opt_len + 1);
+	struct pgm_opt_compress* opt_compress = NULL;
+
+	skb->pgm_opt_fragment			= (struct pgm_opt_fragment*)(opt_header + 1);
+	skb->pgm_opt_fragment->opt_sqn		= pgm_htonl (first_sqn);
+	skb->pgm_opt_fragment->opt_frag_off	= pgm_htonl (frag_off);
+	skb->pgm_opt_fragment->opt_frag_len	= pgm_htonl (apdu_length);
+	if (orig_length) {
+		opt_header = (const struct pgm_opt_header*)(skb->pgm_opt_fragment + 1);
+		opt_compress = (struct pgm_opt_compress*)(opt_header + 1);
+		opt_compress->opt_apdu_len = pgm_htonl (orig_length);
+	}
+	if (sock->use_zero_checksum || sock->use_crc32c)
+		return 0;
+/* option body from the zero reserved byte to keep an even offset */
+	const uint32_t unfolded_stamp = pgm_csum_partial (skb->pgm_opt_fragment,
+							  sizeof(struct pgm_opt_fragment),
+							  0);
+	unfolded_header = pgm_csum_block_add (unfolded_header,
+					      unfolded_stamp,
+					      (uint16_t)((char*)skb->pgm_opt_fragment - (char*)skb->pgm_header));
+	if (NULL == opt_compress)
+		return unfolded_header;
+	const uint32_t unfolded_compress = pgm_csum_partial (opt_compress,
+							     sizeof(struct pgm_opt_compress),
+							     0);
+	return pgm_csum_block_add (unfolded_header,
+				   unfolded_compress,
+				   (uint16_t)((char*)opt_compress - (char*)skb->pgm_header));
+}
+
+/* state helper for resuming sends
+ */
+#define STATE(x)	(sock->pkt_dontwait_state.x)
+
+/* send one PGM data packet, transmit window owned memory.
+ *
+ * On success, returns PGM_IO_STATUS_NORMAL and the number of data bytes pushed
+ * into the transmit window and attempted to send to the socket layer is saved 
+ * into bytes_written.  On non-blocking sockets, PGM_IO_STATUS_WOULD_BLOCK is 
+ * returned if the send would block.  PGM_IO_STATUS_RATE_LIMITED is returned if
+ * the packet sizes would exceed the current rate limit.
+ *
+ * ! always returns successful if data is pushed into the transmit window, even if
+ * sendto() double fails ¡  we don't want the application to try again as that is the
+ * reliable socks role.
+ */
+
+static
+int
+send_odata (
+	pgm_sock_t*           const restrict sock,
+	struct pgm_sk_buff_t* const restrict skb,
+	size_t*			    restrict bytes_written
+	)
+{
+	void	*data;
+	ssize_t	 sent;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != skb);
+	pgm_assert (skb->len <= sock->max_tsdu);
+
+	pgm_debug ("send_odata (sock:%p skb:%p bytes-written:%p)",
+		(void*)sock, (void*)skb, (void*)bytes_written);
+
+	const uint16_t    tsdu_length  = skb->len;
+	const sa_family_t pgmcc_family = sock->use_pgmcc ? sock->family : 0;
+	const size_t      tpdu_length  = tsdu_length + pgm_pkt_offset (FALSE, pgmcc_family) + pgm_data_trailer_len (sock);
+
+/* continue if send would block */
+	if (sock->is_apdu_eagain) {
+		STATE(skb)->tstamp = pgm_time_update_now();
+		goto retry_send;
+	}
+
+/* add PGM header to skbuff */
+	STATE(skb) = pgm_skb_get(skb);
+	STATE(skb)->sock = sock;
+	STATE(skb)->tstamp = pgm_time_update_now();
+
+	if (PGM_LIKELY(!sock->use_pgmcc)) {
+		const uint32_t unfolded_header		= odata_template_stamp (sock, STATE(skb), PGM_ODATA_TEMPLATE_DATA, tsdu_length, pgm_txw_next_lead (sock->window));
+		data					= STATE(skb)->pgm_data + 1;
+		STATE(unfolded_odata)			= odata_csum_partial (sock, data, (uint16_t)tsdu_length);
+		STATE(skb)->pgm_header->pgm_checksum	= data_csum_fold_unfolded (sock, STATE(skb), unfolded_header, sock->odata_template[ PGM_ODATA_TEMPLATE_DATA ].header_length, STATE(unfolded_odata));
+	} else {
+		struct pgm_opt_header	   *opt_header;
+		struct pgm_opt_length	   *opt_len;
+		struct pgm_opt_pgmcc_data  *pgmcc_data;
+		const size_t opt_pgmcc_data_len = (pgm_is_inet6 (sock->acker_nla.ss_family) ?
+							sizeof (struct pgm_opt6_pgmcc_data) :
+							sizeof (struct pgm_opt_pgmcc_data));
+
+		STATE(skb)->pgm_header = (struct pgm_header*)STATE(skb)->head;
+		STATE(skb)->pgm_data   = (struct pgm_data*)(STATE(skb)->pgm_header + 1);
+		memcpy (STATE(skb)->pgm_header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
+		STATE(skb)->pgm_header->pgm_sport	= sock->tsi.sport;
+		STATE(skb)->pgm_header->pgm_dport	= sock->dport;
+		STATE(skb)->pgm_header->pgm_type	= PGM_ODATA;
+		STATE(skb)->pgm_header->pgm_options	= PGM_OPT_PRESENT;
+		STATE(skb)->pgm_header->pgm_tsdu_length = pgm_htons (tsdu_length);
+
+/* ODATA */
+		STATE(skb)->pgm_data->data_sqn		= pgm_htonl (pgm_txw_next_lead(sock->window));
+		STATE(skb)->pgm_data->data_trail	= pgm_htonl (source_trail (sock));
+
+		STATE(skb)->pgm_header->pgm_checksum	= 0;
+		data = STATE(skb)->pgm_data + 1;
+/* congestion control option header indicating elected peer for ACKs. */
+		opt_len = data;
+		opt_len->opt_type	= PGM_OPT_LENGTH;
+		opt_len->opt_length	= sizeof(struct pgm_opt_length);
+		opt_len->opt_total_length = pgm_htons ((uint16_t)(sizeof (struct pgm_opt_length) +
+							sizeof (struct pgm_opt_header) +
+							opt_pgmcc_data_len));
+		opt_header = (struct pgm_opt_header*)(opt_len + 1);
+		opt_header->opt_type	= PGM_OPT_PGMCC_DATA | PGM_OPT_END;
+		opt_header->opt_length	= sizeof (struct pgm_opt_header) +
+						opt_pgmcc_data_len;
+		pgmcc_data  = (struct pgm_opt_pgmcc_data *)(opt_header + 1);
+		pgmcc_data->opt_tstamp = pgm_htonl ((uint32_t)pgm_to_msecs (STATE(skb)->tstamp));
+/* acker nla */
+		pgm_sockaddr_to_nla ((struct sockaddr*)&sock->acker_nla, (char*)&pgmcc_data->opt_nla_afi);
+		data = (char*)opt_header + opt_header->opt_length;
+
+		const size_t   pgm_header_len		= (char*)data - (char*)STATE(skb)->pgm_header;
+		STATE(unfolded_odata)			= odata_csum_partial (sock, data, (uint16_t)tsdu_length);
+		STATE(skb)->pgm_header->pgm_checksum	= data_csum_fold (sock, STATE(skb), (uint16_t)pgm_header_len, STATE(unfolded_odata));
+	}
+
+/* add to transmit window, skb::data set to payload */
+	pgm_txw_add (sock->window, STATE(skb));
+
+/* check rate limit at last moment */
+	STATE(is_rate_limited) = FALSE;
+	if (sock->is_nonblocking && sock->is_controlled_odata)
+	{
+		if (!pgm_rate_check2 (&sock->rate_control,		/* total rate limit */
+				      &sock->odata_rate_control,	/* original data limit */
+				      tpdu_length,			/* excludes IP header len */
+				      sock->is_nonblocking))
+		{
+			sock->is_apdu_eagain = TRUE;
+			odata_rate_limited (sock, tpdu_length + sock->iphdr_len);
+			return PGM_IO_STATUS_RATE_LIMITED;
+		}
+		STATE(is_rate_limited) = TRUE;
 	}
-	buf = pgm_alloca (tpdu_length);
-	header = (struct pgm_header*)buf;
-	spm  = (struct pgm_spm *)(header + 1);
-	spm6 = (struct pgm_spm6*)(header + 1);
-	memcpy (header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
-	header->pgm_sport       = sock->tsi.sport;
-	header->pgm_dport       = sock->dport;
-	header->pgm_type        = PGM_SPM;
-	header->pgm_options     = 0;
-	header->pgm_tsdu_length = 0;
 
-/* SPM */
-	spm->spm_sqn		= pgm_htonl (sock->spm_sqn);
-	spm->spm_trail		= pgm_htonl (pgm_txw_trail_atomic (sock->window));
-	spm->spm_lead		= pgm_htonl (pgm_txw_lead_atomic (sock->window));
-	spm->spm_reserved	= 0;
-/* our nla */
-	pgm_sockaddr_to_nla ((struct sockaddr*)&sock->send_addr, (char*)&spm->spm_nla_afi);
+/* the transmit window MUST check the user count to ensure it does not 
+ * attempt to send a repair-data packet based on in transit original data.
+ */
+retry_send:
 
-/* PGM options */
-	if (sock->use_proactive_parity ||
-	    sock->use_ondemand_parity ||
-	    sock->is_pending_crqst ||
-	    PGM_OPT_FIN == flags)
+/* congestion control: early exit on empty token bucket */
+	if (sock->use_pgmcc &&
+	    sock->tokens < pgm_fp8 (1))
 	{
-		struct pgm_opt_header *opt_header, *last_opt_header;
-		struct pgm_opt_length* opt_len;
-		uint16_t opt_total_length;
+//		pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("Token limit reached."));
+		sock->is_apdu_eagain = TRUE;
+		sock->blocklen = tpdu_length + sock->iphdr_len;
+		congestion_stall_begin (sock);
+		return PGM_IO_STATUS_CONGESTION;	/* peer expiration to re-elect ACKer */
+	}
 
-		if (AF_INET == sock->send_gsr.gsr_group.ss_family)
-			opt_header = (struct pgm_opt_header*)(spm + 1);
+	sent = pgm_sendskb (sock,
+			   !STATE(is_rate_limited),	/* rate limit on blocking */
+			   &sock->odata_rate_control,
+			   STATE(skb),
+			   odata_group (sock, STATE(skb)),
+			   pgm_sockaddr_len (odata_group (sock, STATE(skb))));
+	if (sent < 0) {
+		const int save_errno = pgm_get_last_sock_error();
+		if (PGM_LIKELY(PGM_SOCK_EAGAIN == save_errno || PGM_SOCK_ENOBUFS == save_errno))
+		{
+			sock->is_apdu_eagain = TRUE;
+			sock->blocklen = tpdu_length + sock->iphdr_len;
+			if (PGM_SOCK_ENOBUFS == save_errno)
+				return PGM_IO_STATUS_RATE_LIMITED;
+			if (sock->use_pgmcc)
+				pgm_notify_clear (&sock->ack_notify);
+			return PGM_IO_STATUS_WOULD_BLOCK;
+		}
+/* fall through silently on other errors */
+	}
+
+/* success */
+	sock->is_apdu_eagain = FALSE;
+/* SPM heartbeats decay from last sent data packet */
+	reset_heartbeat_spm (sock, STATE(skb)->tstamp);
+/* time from the send call, stamped on the skb, to return of the socket send */
+	pgm_latency_record (PGM_LATENCY_TX_WIRE, STATE(skb)->tstamp, pgm_time_update_now());
+/* congestion control: remove token from bucket */
+	if (sock->use_pgmcc) {
+		if (!sock->use_tfmcc)
+			sock->tokens -= pgm_fp8 (1);
+		congestion_stall_end (sock);
+		sock->ack_expiry = STATE(skb)->tstamp + sock->ack_expiry_ivl;
+	}
+/* save unfolded odata for retransmissions */
+	pgm_txw_set_unfolded_checksum (STATE(skb), STATE(unfolded_odata));
+/* increment socket statistics */
+	if (PGM_LIKELY((size_t)sent == tpdu_length)) {
+		sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += tsdu_length;
+		sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  ++;
+		pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)(tpdu_length + sock->iphdr_len));
+	}
+/* check for end of transmission group for pro-active packets */
+	if (sock->use_proactive_parity)
+		source_odata_sent (sock, STATE(skb));
+/* remove applications reference to skbuff */
+	pgm_free_skb (STATE(skb));
+	if (bytes_written)
+		*bytes_written = tsdu_length;
+	return PGM_IO_STATUS_NORMAL;
+}
+
+/* build one non-fragment ODATA packet from callee owned memory and add it to
+ * the transmit window, with is_coalesced the TSDU is length prefixed APDUs
+ * marked by OPT_COALESCE.  OPT_UNRELIABLE follows unreliable packets and
+ * OPT_TIMESTAMP is added with PGM_SEND_TIMESTAMP where each fits the TPDU.
+ * the unfolded payload checksum is returned for the caller to
+ * save once the packet is sent.
+ *
+ * packets of pgm_send_unreliable() enter the window by header alone and the
+ * returned skb is owned by the caller.
+ */
+
+static
+struct pgm_sk_buff_t*
+build_odata_copy (
+	pgm_sock_t*      const restrict	sock,
+	const void*	       restrict	tsdu,
+	const uint16_t			tsdu_length,
+	const bool			is_coalesced,
+	uint32_t*	       restrict	unfolded_odata
+	)
+{
+	struct pgm_sk_buff_t* skb;
+	struct pgm_opt_length* opt_len = NULL;
+	struct pgm_opt_header* opt_header = NULL;
+	void* data;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (tsdu_length <= (is_coalesced ? sock->max_tsdu_coalesce : sock->max_tsdu));
+	if (PGM_LIKELY(tsdu_length)) pgm_assert (NULL != tsdu);
+	pgm_assert (NULL != unfolded_odata);
+
+	const sa_family_t pgmcc_family = sock->use_pgmcc ? sock->family : 0;
+	size_t header_length = is_coalesced ? pgm_coalesce_pkt_offset (pgmcc_family) : pgm_pkt_offset (FALSE, pgmcc_family);
+
+/* unreliable sequences preceding this packet, dropped when the TPDU is full */
+	uint32_t unreliable_bitmap = pgm_txw_unreliable_recent (sock->window);
+	if (PGM_UNLIKELY(unreliable_bitmap)) {
+		const size_t opt_unreliable_len = (sock->use_pgmcc || is_coalesced ? 0 : sizeof (struct pgm_opt_length)) +
+						  sizeof (struct pgm_opt_header) + sizeof (struct pgm_opt_unreliable);
+		if (header_length + opt_unreliable_len + tsdu_length + pgm_data_trailer_len (sock) <= sock->path_mtu)
+			header_length += opt_unreliable_len;
 		else
-			opt_header = (struct pgm_opt_header*)(spm6 + 1);
-		header->pgm_options |= PGM_OPT_PRESENT;
-		opt_len			= (struct pgm_opt_length*)opt_header;
-		opt_len->opt_type	= PGM_OPT_LENGTH;
-		opt_len->opt_length	= sizeof(struct pgm_opt_length);
-		opt_total_length	= sizeof(struct pgm_opt_length);
-		last_opt_header = opt_header = (struct pgm_opt_header*)(opt_len + 1);
+			unreliable_bitmap = 0;
+	}
+/* send time for one-way latency, likewise dropped */
+	bool is_timestamped = sock->use_send_timestamp;
+	if (PGM_UNLIKELY(is_timestamped)) {
+		const size_t opt_timestamp_len = (sock->use_pgmcc || is_coalesced || unreliable_bitmap ? 0 : sizeof (struct pgm_opt_length)) +
+						 sizeof (struct pgm_opt_header) + sizeof (struct pgm_opt_timestamp);
+		if (sock->iphdr_len + header_length + opt_timestamp_len + tsdu_length <= sock->path_mtu)
+			header_length += opt_timestamp_len;
+		else
+			is_timestamped = FALSE;
+	}
 
-/* OPT_PARITY_PRM */
-		if (sock->use_proactive_parity ||
-		    sock->use_ondemand_parity)
-		{
-			struct pgm_opt_parity_prm *opt_parity_prm;
+	skb = STATE(is_unreliable) ? pgm_skb_pool_alloc (sock->skb_pool, sock->max_tpdu)
+				   : pgm_txw_alloc_skb (sock->window, sock->skb_pool, sock->max_tpdu);
+	skb->sock = sock;
+	skb->tstamp = pgm_time_update_now();
+	pgm_skb_reserve (skb, (uint16_t)header_length);
+	pgm_skb_put (skb, (uint16_t)tsdu_length);
+
+/* single packet without options from the socket template */
+	if (PGM_LIKELY(!sock->use_pgmcc && !is_coalesced && !unreliable_bitmap && !is_timestamped)) {
+		const uint32_t unfolded_header	= odata_template_stamp (sock, skb, PGM_ODATA_TEMPLATE_DATA, tsdu_length, pgm_txw_next_lead (sock->window));
+		data				= skb->pgm_data + 1;
+		*unfolded_odata			= odata_csum_partial_copy (sock, tsdu, data, tsdu_length);
+		skb->pgm_header->pgm_checksum	= data_csum_fold_unfolded (sock, skb, unfolded_header, sock->odata_template[ PGM_ODATA_TEMPLATE_DATA ].header_length, *unfolded_odata);
+		goto add;
+	}
 
-			header->pgm_options |= PGM_OPT_NETWORK;
-			opt_total_length += sizeof(struct pgm_opt_header) +
-					    sizeof(struct pgm_opt_parity_prm);
-			opt_header->opt_type	= PGM_OPT_PARITY_PRM;
-			opt_header->opt_length	= sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_parity_prm);
-			opt_parity_prm = (struct pgm_opt_parity_prm*)(opt_header + 1);
-			opt_parity_prm->opt_reserved = (sock->use_proactive_parity ? PGM_PARITY_PRM_PRO : 0) |
-						       (sock->use_ondemand_parity ? PGM_PARITY_PRM_OND : 0);
-			opt_parity_prm->parity_prm_tgs = pgm_htonl (sock->rs_k);
-			last_opt_header = opt_header;
-			opt_header = (struct pgm_opt_header*)(opt_parity_prm + 1);
-		}
+	skb->pgm_header	= (struct pgm_header*)skb->head;
+	skb->pgm_data	= (struct pgm_data*)(skb->pgm_header + 1);
+	memcpy (skb->pgm_header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
+	skb->pgm_header->pgm_sport	= sock->tsi.sport;
+	skb->pgm_header->pgm_dport	= sock->dport;
+	skb->pgm_header->pgm_type	= PGM_ODATA;
+	skb->pgm_header->pgm_options	= PGM_OPT_PRESENT;
+	skb->pgm_header->pgm_tsdu_length = pgm_htons (tsdu_length);
 
-/* OPT_CRQST */
-		if (sock->is_pending_crqst)
-		{
-			struct pgm_opt_crqst *opt_crqst;
+/* ODATA */
+	skb->pgm_data->data_sqn		= pgm_htonl (pgm_txw_next_lead(sock->window));
+	skb->pgm_data->data_trail	= pgm_htonl (source_trail (sock));
 
-			header->pgm_options |= PGM_OPT_NETWORK;
-			opt_total_length += sizeof(struct pgm_opt_header) +
-					    sizeof(struct pgm_opt_crqst);
-			opt_header->opt_type	= PGM_OPT_CRQST;
-			opt_header->opt_length	= sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_crqst);
-			opt_crqst = (struct pgm_opt_crqst*)(opt_header + 1);
-/* request receiver worst path report, OPT_CR_RX_WP */
-			opt_crqst->opt_reserved = PGM_OPT_CRQST_RXP;
-			sock->is_pending_crqst = FALSE;
-			last_opt_header = opt_header;
-			opt_header = (struct pgm_opt_header*)(opt_crqst + 1);
-		}
+	skb->pgm_header->pgm_checksum	= 0;
+	opt_len = (struct pgm_opt_length*)(skb->pgm_data + 1);
+	opt_len->opt_type	= PGM_OPT_LENGTH;
+	opt_len->opt_length	= sizeof (struct pgm_opt_length);
+	data = opt_len + 1;
+/* congestion control option header indicating elected peer for ACKs. */
+	if (sock->use_pgmcc) {
+		struct pgm_opt_pgmcc_data	*pgmcc_data;
+		const size_t opt_pgmcc_data_len = (pgm_is_inet6 (sock->acker_nla.ss_family) ?
+							sizeof (struct pgm_opt6_pgmcc_data) :
+							sizeof (struct pgm_opt_pgmcc_data));
+		opt_header = data;
+		opt_header->opt_type	= PGM_OPT_PGMCC_DATA;
+		opt_header->opt_length	= sizeof (struct pgm_opt_header) +
+						opt_pgmcc_data_len;
+		pgmcc_data  = (struct pgm_opt_pgmcc_data *)(opt_header + 1);
+		pgmcc_data->opt_reserved = 0;
+		pgmcc_data->opt_tstamp = pgm_htonl ((uint32_t)pgm_to_msecs (skb->tstamp));
+/* acker nla */
+		pgm_sockaddr_to_nla ((struct sockaddr*)&sock->acker_nla, (char*)&pgmcc_data->opt_nla_afi);
+		data = (char*)opt_header + opt_header->opt_length;
+	}
+/* coalesced APDUs, appended to any congestion control option */
+	if (is_coalesced) {
+		struct pgm_opt_coalesce		*opt_coalesce;
+		opt_header = data;
+		opt_header->opt_type	= PGM_OPT_COALESCE;
+		opt_header->opt_length	= sizeof (struct pgm_opt_header) + sizeof (struct pgm_opt_coalesce);
+		opt_coalesce = (struct pgm_opt_coalesce*)(opt_header + 1);
+		opt_coalesce->opt_reserved = 0;
+		data = opt_coalesce + 1;
+	}
+/* preceding unreliable sequences */
+	if (unreliable_bitmap) {
+		struct pgm_opt_unreliable	*opt_unreliable;
+		opt_header = data;
+		opt_header->opt_type	= PGM_OPT_UNRELIABLE;
+		opt_header->opt_length	= sizeof (struct pgm_opt_header) + sizeof (struct pgm_opt_unreliable);
+		opt_unreliable = (struct pgm_opt_unreliable*)(opt_header + 1);
+		opt_unreliable->opt_reserved = 0;
+		opt_unreliable->opt_bitmap = pgm_htonl (unreliable_bitmap);
+		data = opt_unreliable + 1;
+	}
+/* source send time, repairs carry the original */
+	if (is_timestamped) {
+		struct pgm_opt_timestamp	*opt_timestamp;
+		const pgm_time_t send_tstamp = pgm_time_wall_now();
+		opt_header = data;
+		opt_header->opt_type	= PGM_OPT_TIMESTAMP;
+		opt_header->opt_length	= sizeof (struct pgm_opt_header) + sizeof (struct pgm_opt_timestamp);
+		opt_timestamp = (struct pgm_opt_timestamp*)(opt_header + 1);
+		opt_timestamp->opt_reserved = 0;
+		opt_timestamp->opt_tstamp_hi = pgm_htonl ((uint32_t)(send_tstamp >> 32));
+		opt_timestamp->opt_tstamp_lo = pgm_htonl ((uint32_t)send_tstamp);
+		data = opt_timestamp + 1;
+	}
+	opt_header->opt_type	|= PGM_OPT_END;
+	opt_len->opt_total_length = pgm_htons ((uint16_t)((char*)data - (char*)opt_len));
+	pgm_assert (data == skb->data);
 
-/* OPT_FIN */
-		if (PGM_OPT_FIN == flags)
-		{
-			struct pgm_opt_fin *opt_fin;
+	const size_t   pgm_header_len		= (char*)data - (char*)skb->pgm_header;
+	*unfolded_odata			= odata_csum_partial_copy (sock, tsdu, data, (uint16_t)tsdu_length);
+	skb->pgm_header->pgm_checksum	= data_csum_fold (sock, skb, (uint16_t)pgm_header_len, *unfolded_odata);
 
-			opt_total_length += sizeof(struct pgm_opt_header) +
-					    sizeof(struct pgm_opt_fin);
-			opt_header->opt_type	= PGM_OPT_FIN;
-			opt_header->opt_length	= sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_fin);
-			opt_fin = (struct pgm_opt_fin*)(opt_header + 1);
-			opt_fin->opt_reserved = 0;
-			last_opt_header = opt_header;
-			opt_header = (struct pgm_opt_header*)(opt_fin + 1);
-		}
+/* add to transmit window, skb::data set to payload */
+add:
+	if (PGM_UNLIKELY(STATE(is_unreliable)))
+		pgm_txw_add_unreliable (sock->window, skb);
+	else
+		pgm_txw_add (sock->window, skb);
+	return skb;
+}
 
-		last_opt_header->opt_type |= PGM_OPT_END;
-		opt_len->opt_total_length = pgm_htons (opt_total_length);
+/* send one PGM original data packet, callee owned memory.
+ *
+ * on success, returns PGM_IO_STATUS_NORMAL, on block for non-blocking sockets
+ * returns PGM_IO_STATUS_WOULD_BLOCK, returns PGM_IO_STATUS_RATE_LIMITED if
+ * packet size exceeds the current rate limit.
+ */
+
+static
+int
+send_odata_copy (
+	pgm_sock_t*      const restrict	sock,
+	const void*	       restrict	tsdu,
+	const uint16_t			tsdu_length,
+	const bool			is_coalesced,
+	size_t*		       restrict	bytes_written
+	)
+{
+	size_t	 tpdu_length;
+	ssize_t	 sent;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (tsdu_length <= (is_coalesced ? sock->max_tsdu_coalesce : sock->max_tsdu));
+	if (PGM_LIKELY(tsdu_length)) pgm_assert (NULL != tsdu);
+
+	pgm_debug ("send_odata_copy (sock:%p tsdu:%p tsdu_length:%u is-coalesced:%s bytes-written:%p)",
+		(void*)sock, tsdu, tsdu_length, is_coalesced ? "TRUE" : "FALSE", (void*)bytes_written);
+
+/* continue if blocked mid-apdu, updating timestamp */
+	if (sock->is_apdu_eagain) {
+		STATE(skb)->tstamp = pgm_time_update_now();
+		tpdu_length = (char*)STATE(skb)->tail - (char*)STATE(skb)->head;
+		goto retry_send;
 	}
 
-/* checksum optional for SPMs */
-	header->pgm_checksum = 0;
-	header->pgm_checksum = pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
+	STATE(skb) = build_odata_copy (sock, tsdu, tsdu_length, is_coalesced, &STATE(unfolded_odata));
+	tpdu_length = (char*)STATE(skb)->tail - (char*)STATE(skb)->head;
 
-	sent = pgm_sendto (sock,
-			   flags != PGM_OPT_SYN && sock->is_controlled_spm,	/* rate limited */
-			   NULL,
-			   TRUE,		/* with router alert */
-			   buf,
-			   tpdu_length,
-			   (struct sockaddr*)&sock->send_gsr.gsr_group,
-			   pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
+/* check rate limit at last moment */
+	STATE(is_rate_limited) = FALSE;
+	if (sock->is_nonblocking && sock->is_controlled_odata)
+	{
+		if (!pgm_rate_check2 (&sock->rate_control,		/* total rate limit */
+				      &sock->odata_rate_control,	/* original data limit */
+				      tpdu_length,			/* excludes IP header len */
+				      sock->is_nonblocking))
+		{
+			sock->is_apdu_eagain = TRUE;
+			odata_rate_limited (sock, tpdu_length + sock->iphdr_len);
+			return PGM_IO_STATUS_RATE_LIMITED;
+		}
+		STATE(is_rate_limited) = TRUE;
+	}
+retry_send:
+
+/* congestion control: early exit on empty token bucket */
+	if (sock->use_pgmcc && 
+	    sock->tokens < pgm_fp8 (1))
+	{
+//		pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("Token limit reached."));
+		sock->is_apdu_eagain = TRUE;
+		sock->blocklen = tpdu_length + sock->iphdr_len;
+		congestion_stall_begin (sock);
+		return PGM_IO_STATUS_CONGESTION;
+	}
+
+	sent = pgm_sendskb (sock,
+			   !STATE(is_rate_limited),	/* rate limit on blocking */
+			   &sock->odata_rate_control,
+			   STATE(skb),
+			   odata_group (sock, STATE(skb)),
+			   pgm_sockaddr_len (odata_group (sock, STATE(skb))));
 	if (sent < 0) {
 		const int save_errno = pgm_get_last_sock_error();
 		if (PGM_LIKELY(PGM_SOCK_EAGAIN == save_errno || PGM_SOCK_ENOBUFS == save_errno))
 		{
+			sock->is_apdu_eagain = TRUE;
 			sock->blocklen = tpdu_length + sock->iphdr_len;
-			return FALSE;
+			if (PGM_SOCK_ENOBUFS == save_errno)
+				return PGM_IO_STATUS_RATE_LIMITED;
+			if (sock->use_pgmcc)
+				pgm_notify_clear (&sock->ack_notify);
+			return PGM_IO_STATUS_WOULD_BLOCK;
 		}
 /* fall through silently on other errors */
 	}
 
-/* advance SPM sequence only on successful transmission */
-	sock->spm_sqn++;
-	pgm_atomic_add32 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint32_t)tpdu_length);
-	return TRUE;
+/* success */
+	sock->is_apdu_eagain = FALSE;
+/* SPM heartbeats decay from last sent data packet */
+	reset_heartbeat_spm (sock, STATE(skb)->tstamp);
+/* time from the send call, stamped on the skb, to return of the socket send */
+	pgm_latency_record (PGM_LATENCY_TX_WIRE, STATE(skb)->tstamp, pgm_time_update_now());
+/* congestion control: remove token from bucket */
+	if (sock->use_pgmcc) {
+		if (!sock->use_tfmcc)
+			sock->tokens -= pgm_fp8 (1);
+		congestion_stall_end (sock);
+		pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("PGMCC tokens-- (T:%u W:%u)"),
+		 	   pgm_fp8tou (sock->tokens), pgm_fp8tou (sock->cwnd_size));
+		sock->ack_expiry = STATE(skb)->tstamp + sock->ack_expiry_ivl;
+	}
+/* save unfolded odata for retransmissions */
+	pgm_txw_set_unfolded_checksum (STATE(skb), STATE(unfolded_odata));
+/* increment socket statistics */
+	if (PGM_LIKELY((size_t)sent == tpdu_length)) {
+		sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += tsdu_length;
+		sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  ++;
+		pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)(tpdu_length + sock->iphdr_len));
+	}
+/* check for end of transmission group for pro-active packets */
+	if (sock->use_proactive_parity)
+		source_odata_sent (sock, STATE(skb));
+/* unreliable payload is not retained by the window */
+	if (STATE(is_unreliable)) {
+		STATE(is_unreliable) = FALSE;
+		pgm_free_skb (STATE(skb));
+	}
+
+/* return data payload length sent */
+	if (bytes_written)
+		*bytes_written = tsdu_length;
+	return PGM_IO_STATUS_NORMAL;
 }
 
-/* send a NAK confirm (NCF) message with provided sequence number list.
- *
- * on success, TRUE is returned, returns FALSE if operation would block.
+/* start a wait of the source, coalesced APDUs or an idle partial transmission
+ * group, pulling in the next timer expiration.
  */
 
 static
-bool
-send_ncf (
-	pgm_sock_t*            const restrict sock,
-	const struct sockaddr* const restrict nak_src_nla,
-	const struct sockaddr* const restrict nak_grp_nla,
-	const uint32_t			      sequence,
-	const bool			      is_parity		/* send parity NCF */
+void
+source_timer_add (
+	pgm_sock_t*const	sock,
+	pgm_time_t*const	expiry_,	/* under timer_mutex */
+	const pgm_time_t	expiry
 	)
 {
-	size_t		   tpdu_length;
-	char		  *buf;
-	struct pgm_header *header;
-	struct pgm_nak	  *ncf;
-	struct pgm_nak6	  *ncf6;
-	ssize_t		   sent;
-
-/* pre-conditions */
-	pgm_assert (NULL != sock);
-	pgm_assert (NULL != nak_src_nla);
-	pgm_assert (NULL != nak_grp_nla);
-	pgm_assert (nak_src_nla->sa_family == nak_grp_nla->sa_family);
+	bool is_pulled = FALSE;
+	pgm_sock_mutex_lock (sock, &sock->timer_mutex);
+	*expiry_ = expiry;
+	if (pgm_time_after( sock->next_poll, expiry ))
+	{
+		sock->next_poll = expiry;
+		if (!sock->is_pending_read) {
+			pgm_notify_send (&sock->pending_notify);
+			sock->is_pending_read = TRUE;
+		}
+		is_pulled = TRUE;
+	}
+	pgm_sock_mutex_unlock (sock, &sock->timer_mutex);
+	if (is_pulled)
+		pgm_engine_timer_wake (expiry);
+}
 
-#ifdef SOURCE_DEBUG
-	char saddr[INET6_ADDRSTRLEN], gaddr[INET6_ADDRSTRLEN];
-	pgm_sockaddr_ntop (nak_src_nla, saddr, sizeof(saddr));
-	pgm_sockaddr_ntop (nak_grp_nla, gaddr, sizeof(gaddr));
-	pgm_debug ("send_ncf (sock:%p nak-src-nla:%s nak-grp-nla:%s sequence:%" PRIu32" is-parity:%s)",
-		(void*)sock,
-		saddr,
-		gaddr,
-		sequence,
-		is_parity ? "TRUE": "FALSE"
-		);
-#endif
+/* send the pending coalesced APDUs as one original data packet, resuming the
+ * packet if blocked before.  caller holds source_mutex.
+ *
+ * on success or nothing pending, returns PGM_IO_STATUS_NORMAL, on block for
+ * non-blocking sockets returns PGM_IO_STATUS_WOULD_BLOCK, returns
+ * PGM_IO_STATUS_RATE_LIMITED if packet size exceeds the current rate limit.
+ */
 
-	tpdu_length = sizeof(struct pgm_header);
-	tpdu_length += (AF_INET == nak_src_nla->sa_family) ?
-				sizeof(struct pgm_nak) :
-				sizeof(struct pgm_nak6);
-	buf = pgm_alloca (tpdu_length);
-	header = (struct pgm_header*)buf;
-	ncf  = (struct pgm_nak *)(header + 1);
-	ncf6 = (struct pgm_nak6*)(header + 1);
-	memcpy (header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
-	header->pgm_sport	= sock->tsi.sport;
-	header->pgm_dport	= sock->dport;
-	header->pgm_type        = PGM_NCF;
-        header->pgm_options     = is_parity ? PGM_OPT_PARITY : 0;
-        header->pgm_tsdu_length = 0;
+PGM_GNUC_INTERNAL
+int
+pgm_coalesce_flush (
+	pgm_sock_t* const	sock
+	)
+{
+	int status;
 
-/* NCF */
-	ncf->nak_sqn		= pgm_htonl (sequence);
+/* pre-conditions */
+	pgm_assert (NULL != sock);
 
-/* source nla */
-	pgm_sockaddr_to_nla (nak_src_nla, (char*)&ncf->nak_src_nla_afi);
+	if (!sock->is_coalesce_eagain && 0 == sock->coalesce_len)
+		return PGM_IO_STATUS_NORMAL;
 
-/* group nla */
-	pgm_sockaddr_to_nla (nak_grp_nla, (AF_INET6 == nak_src_nla->sa_family) ?
-						(char*)&ncf6->nak6_grp_nla_afi :
-						(char*)&ncf->nak_grp_nla_afi );
-        header->pgm_checksum = 0;
-        header->pgm_checksum = pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
+	pgm_debug ("pgm_coalesce_flush (sock:%p)", (void*)sock);
 
-	sent = pgm_sendto (sock,
-			   FALSE,			/* not rate limited */
-			   NULL,
-			   TRUE,			/* with router alert */
-			   buf,
-			   tpdu_length,
-			   (struct sockaddr*)&sock->send_gsr.gsr_group,
-			   pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
-	if (sent < 0 && PGM_LIKELY(PGM_SOCK_EAGAIN == pgm_get_last_sock_error()))
-		return FALSE;
-/* fall through silently on other errors */
-			
-	pgm_atomic_add32 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint32_t)tpdu_length);
-	return TRUE;
+	status = send_odata_copy (sock, sock->coalesce_buf, sock->coalesce_len, TRUE, NULL);
+	if (PGM_IO_STATUS_NORMAL != status) {
+		sock->is_coalesce_eagain = TRUE;
+		return status;
+	}
+	sock->is_coalesce_eagain = FALSE;
+	sock->coalesce_len = 0;
+	sock->coalesce_expiry = 0;
+	return PGM_IO_STATUS_NORMAL;
 }
 
-/* A NCF packet with a OPT_NAK_LIST option extension
- *
- * on success, TRUE is returned.  on error, FALSE is returned.
+/* send proactive parity of the partial transmission group at the window lead
+ * once the source has been idle for PGM_FEC_IDLE_IVL, such that losses ahead
+ * of a pause are recovered without waiting for the group to fill.  packets
+ * missing from the group are encoded as zero length with OPT_CURR_TGSIZE,
+ * parity indices are reserved such that the parity of the filled group
+ * follows on.  caller holds source_mutex.
  */
 
-static
-bool
-send_ncf_list (
-	pgm_sock_t*            const restrict sock,
-	const struct sockaddr* const restrict nak_src_nla,
-	const struct sockaddr* const restrict nak_grp_nla,
-	struct pgm_sqn_list_t* const restrict sqn_list,		/* will change to network-order */
-	const bool			      is_parity		/* send parity NCF */
+PGM_GNUC_INTERNAL
+void
+pgm_fec_idle_flush (
+	pgm_sock_t* const	sock,
+	const pgm_time_t	now
 	)
 {
-	size_t			 tpdu_length;
-	char			*buf;
-	struct pgm_header	*header;
-	struct pgm_nak		*ncf;
-	struct pgm_nak6		*ncf6;
-	struct pgm_opt_header	*opt_header;
-	struct pgm_opt_length	*opt_len;
-	struct pgm_opt_nak_list	*opt_nak_list;
-	ssize_t			 sent;
+	struct pgm_sk_buff_t	**odata_skbs, **parity_skbs;
 
 /* pre-conditions */
 	pgm_assert (NULL != sock);
-	pgm_assert (NULL != nak_src_nla);
-	pgm_assert (NULL != nak_grp_nla);
-	pgm_assert (sqn_list->len > 1);
-	pgm_assert (sqn_list->len <= 63);
-	pgm_assert (nak_src_nla->sa_family == nak_grp_nla->sa_family);
-
-#ifdef SOURCE_DEBUG
-	char saddr[INET6_ADDRSTRLEN], gaddr[INET6_ADDRSTRLEN];
-	char list[1024];
-	pgm_sockaddr_ntop (nak_src_nla, saddr, sizeof(saddr));
-	pgm_sockaddr_ntop (nak_grp_nla, gaddr, sizeof(gaddr));
-	sprintf (list, "%" PRIu32, sqn_list->sqn[0]);
-	for (uint_fast8_t i = 1; i < sqn_list->len; i++) {
-		char sequence[ 2 + strlen("4294967295") ];
-		sprintf (sequence, " %" PRIu32, sqn_list->sqn[i]);
-		strcat (list, sequence);
-	}
-	pgm_debug ("send_ncf_list (sock:%p nak-src-nla:%s nak-grp-nla:%s sqn-list:[%s] is-parity:%s)",
-		(void*)sock,
-		saddr,
-		gaddr,
-		list,
-		is_parity ? "TRUE": "FALSE"
-		);
-#endif
+	pgm_assert (sock->fec_idle_ivl > 0);
 
-	tpdu_length = sizeof(struct pgm_header) +
-			     sizeof(struct pgm_opt_length) +		/* includes header */
-			     sizeof(struct pgm_opt_header) + sizeof(uint8_t) +
-			     ( (sqn_list->len-1) * sizeof(uint32_t) );
-	tpdu_length += (AF_INET == nak_src_nla->sa_family) ? sizeof(struct pgm_nak) : sizeof(struct pgm_nak6);
-	buf = pgm_alloca (tpdu_length);
-	header = (struct pgm_header*)buf;
-	ncf  = (struct pgm_nak *)(header + 1);
-	ncf6 = (struct pgm_nak6*)(header + 1);
-	memcpy (header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
-	header->pgm_sport	= sock->tsi.sport;
-	header->pgm_dport	= sock->dport;
-	header->pgm_type        = PGM_NCF;
-        header->pgm_options     = is_parity ? (PGM_OPT_PRESENT | PGM_OPT_NETWORK | PGM_OPT_PARITY) : (PGM_OPT_PRESENT | PGM_OPT_NETWORK);
-        header->pgm_tsdu_length = 0;
-/* NCF */
-	ncf->nak_sqn		= pgm_htonl (sqn_list->sqn[0]);
+	const uint32_t tg_sqn_mask = 0xffffffff << sock->tg_sqn_shift;
 
-/* source nla */
-	pgm_sockaddr_to_nla (nak_src_nla, (char*)&ncf->nak_src_nla_afi);
+	pgm_sock_mutex_lock (sock, &sock->timer_mutex);
+	sock->fec_idle_expiry = 0;
+	pgm_sock_mutex_unlock (sock, &sock->timer_mutex);
 
-/* group nla */
-	pgm_sockaddr_to_nla (nak_grp_nla, (AF_INET6 == nak_src_nla->sa_family) ? (char*)&ncf6->nak6_grp_nla_afi : (char*)&ncf->nak_grp_nla_afi );
+/* re-armed by the next packet of a blocked APDU */
+	if (sock->is_apdu_eagain || pgm_txw_is_empty (sock->window))
+		return;
 
-/* OPT_NAK_LIST */
-	opt_len = (AF_INET6 == nak_src_nla->sa_family) ? (struct pgm_opt_length*)(ncf6 + 1) : (struct pgm_opt_length*)(ncf + 1);
-	opt_len->opt_type	= PGM_OPT_LENGTH;
-	opt_len->opt_length	= sizeof(struct pgm_opt_length);
-	opt_len->opt_total_length = pgm_htons ((uint16_t)(sizeof(struct pgm_opt_length) +
-						sizeof(struct pgm_opt_header) +
-						sizeof(uint8_t) +
-						( (sqn_list->len-1) * sizeof(uint32_t) )));
-	opt_header = (struct pgm_opt_header*)(opt_len + 1);
-	opt_header->opt_type	= PGM_OPT_NAK_LIST | PGM_OPT_END;
-	opt_header->opt_length	= sizeof(struct pgm_opt_header) +
-				  sizeof(uint8_t) +
-				  ( (sqn_list->len-1) * sizeof(uint32_t) );
-	opt_nak_list = (struct pgm_opt_nak_list*)(opt_header + 1);
-	opt_nak_list->opt_reserved = 0;
-/* to network-order */
-	for (uint_fast8_t i = 1; i < sqn_list->len; i++)
-		opt_nak_list->opt_sqn[i-1] = pgm_htonl (sqn_list->sqn[i]);
+	const uint32_t lead = pgm_txw_lead (sock->window);
+	const uint32_t tg_sqn = lead & tg_sqn_mask;
+	const uint8_t tg_size = (uint8_t)(1 + (lead & ~tg_sqn_mask));
+	if (tg_size == sock->rs_k)
+		return;
 
-        header->pgm_checksum    = 0;
-        header->pgm_checksum	= pgm_csum_fold (pgm_csum_partial (buf, (uint16_t)tpdu_length, 0));
+	pgm_debug ("pgm_fec_idle_flush (sock:%p now:%" PGM_TIME_FORMAT ")", (void*)sock, now);
 
-	sent = pgm_sendto (sock,
-			   FALSE,			/* not rate limited */
-			   NULL,
-			   TRUE,			/* with router alert */
-			   buf,
-			   tpdu_length,
-			   (struct sockaddr*)&sock->send_gsr.gsr_group,
-			   pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
-	if (sent < 0 && PGM_LIKELY(PGM_SOCK_EAGAIN == pgm_get_last_sock_error()))
-		return FALSE;
-/* fall through silently on other errors */
+	odata_skbs = pgm_newa (struct pgm_sk_buff_t*, sock->rs_k);
+	memset (odata_skbs, 0, sock->rs_k * sizeof (struct pgm_sk_buff_t*));
 
-	pgm_atomic_add32 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint32_t)tpdu_length);
-	return TRUE;
+	pgm_sock_spinlock_lock (sock, &sock->txw_spinlock);
+	const struct pgm_sk_buff_t* lead_skb = pgm_txw_peek (sock->window, lead);
+	const pgm_time_t idle_expiry = NULL != lead_skb ? lead_skb->tstamp + sock->fec_idle_ivl : now;
+	if (pgm_time_after (idle_expiry, now)) {
+		pgm_sock_spinlock_unlock (sock, &sock->txw_spinlock);
+		source_timer_add (sock, &sock->fec_idle_expiry, idle_expiry);
+		return;
+	}
+	for (unsigned i = 0; i < tg_size; i++) {
+		odata_skbs[i] = pgm_txw_peek_get (sock->window, tg_sqn + i);
+		if (PGM_UNLIKELY(NULL == odata_skbs[i])) {
+			pgm_sock_spinlock_unlock (sock, &sock->txw_spinlock);
+			pgm_trace (PGM_LOG_ROLE_FEC,_("Transmission group #%" PRIu32 " left transmit window before partial parity encoding."), tg_sqn);
+			while (i--)
+				pgm_free_skb (odata_skbs[i]);
+			return;
+		}
+	}
+	const uint8_t count = MAX(1, sock->rs_proactive_h);
+	const uint8_t rs_h = pgm_txw_parity_reserve (sock->window, odata_skbs[0], count);
+	pgm_sock_spinlock_unlock (sock, &sock->txw_spinlock);
+
+	parity_skbs = pgm_newa (struct pgm_sk_buff_t*, count);
+	for (unsigned j = 0; j < count; j++)
+		parity_skbs[j] = pgm_alloc_skb (sock->max_tpdu);
+	pgm_txw_parity_encode (sock->window, odata_skbs, rs_h, count, parity_skbs);
+	for (unsigned i = 0; i < tg_size; i++)
+		pgm_free_skb (odata_skbs[i]);
+
+	pgm_trace (PGM_LOG_ROLE_FEC,_("Partial transmission group #%" PRIu32 " of %u packets idle, sending %u parity packets."),
+		   tg_sqn, (unsigned)tg_size, (unsigned)count);
+
+/* the timer does not wait on rate regulation, losses beyond fall back to NAKs */
+	for (unsigned j = 0; j < count; j++) {
+		if (!send_rdata (sock, parity_skbs[j], TRUE))
+			break;
+	}
+	for (unsigned j = 0; j < count; j++)
+		pgm_free_skb (parity_skbs[j]);
 }
 
-/* cancel any pending heartbeat SPM and schedule a new one
+/* append one APDU to the coalesced packet with a 16-bit length prefix.  the
+ * packet is sent first when the APDU does not fit, and after once the
+ * threshold or the wait is reached.
+ *
+ *    ⎢ APDU₀ ⎢
+ *    ⎢ APDU₁ ⎢ → send_odata_coalesce() →  ⎢ ⋯ LEN₁ APDU₁ LEN₀ APDU₀ ⎢ → libc
+ *    ⎢   ⋮   ⎢
+ *
+ * on success, returns PGM_IO_STATUS_NORMAL, on block for non-blocking sockets
+ * returns PGM_IO_STATUS_WOULD_BLOCK, returns PGM_IO_STATUS_RATE_LIMITED if
+ * packet size exceeds the current rate limit.  once appended the APDU is
+ * accepted, a blocked packet is resumed by the next send or timer.
  */
 
 static
-void
-reset_heartbeat_spm (
-	pgm_sock_t*const	sock,
-	const pgm_time_t	now
+int
+send_odata_coalesce (
+	pgm_sock_t*      const restrict	sock,
+	const void*	       restrict	apdu,
+	const uint16_t			apdu_length,
+	size_t*		       restrict	bytes_written
 	)
 {
-	pgm_mutex_lock (&sock->timer_mutex);
-	const pgm_time_t next_poll = sock->next_poll;
-	const pgm_time_t spm_heartbeat_interval = sock->spm_heartbeat_interval[ sock->spm_heartbeat_state = 1 ];
-	sock->next_heartbeat_spm = now + spm_heartbeat_interval;
-	if (pgm_time_after( next_poll, sock->next_heartbeat_spm ))
+	uint16_t prefix;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->coalesce_buf);
+	pgm_assert (sizeof(prefix) + apdu_length <= sock->max_tsdu_coalesce);
+	if (PGM_LIKELY(apdu_length)) pgm_assert (NULL != apdu);
+
+	pgm_debug ("send_odata_coalesce (sock:%p apdu:%p apdu-length:%u bytes-written:%p)",
+		(void*)sock, apdu, apdu_length, (void*)bytes_written);
+
+/* resume a blocked packet or make room */
+	if (sock->is_coalesce_eagain ||
+	    sock->coalesce_len + sizeof(prefix) + apdu_length > sock->max_tsdu_coalesce)
 	{
-		sock->next_poll = sock->next_heartbeat_spm;
-		if (!sock->is_pending_read) {
-			pgm_notify_send (&sock->pending_notify);
-			sock->is_pending_read = TRUE;
-		}
+		const int status = pgm_coalesce_flush (sock);
+		if (PGM_IO_STATUS_NORMAL != status)
+			return status;
 	}
-	pgm_mutex_unlock (&sock->timer_mutex);
-}
 
-/* state helper for resuming sends
- */
-#define STATE(x)	(sock->pkt_dontwait_state.x)
+	const pgm_time_t now = pgm_time_update_now();
+	if (0 == sock->coalesce_len)
+		source_timer_add (sock, &sock->coalesce_expiry, now + sock->coalesce_ivl);
 
-/* send one PGM data packet, transmit window owned memory.
- *
- * On success, returns PGM_IO_STATUS_NORMAL and the number of data bytes pushed
- * into the transmit window and attempted to send to the socket layer is saved 
- * into bytes_written.  On non-blocking sockets, PGM_IO_STATUS_WOULD_BLOCK is 
- * returned if the send would block.  PGM_IO_STATUS_RATE_LIMITED is returned if
- * the packet sizes would exceed the current rate limit.
+	prefix = pgm_htons (apdu_length);
+	memcpy (sock->coalesce_buf + sock->coalesce_len, &prefix, sizeof(prefix));
+	if (PGM_LIKELY(apdu_length))
+		memcpy (sock->coalesce_buf + sock->coalesce_len + sizeof(prefix), apdu, apdu_length);
+	sock->coalesce_len += (uint16_t)(sizeof(prefix) + apdu_length);
+
+	if (sock->coalesce_len >= sock->coalesce_threshold ||
+	    pgm_time_after_eq (now, sock->coalesce_expiry))
+	{
+		pgm_coalesce_flush (sock);
+	}
+
+	if (bytes_written)
+		*bytes_written = apdu_length;
+	return PGM_IO_STATUS_NORMAL;
+}
+
+/* send one PGM original data packet, callee owned scatter/gather io vector
  *
- * ! always returns successful if data is pushed into the transmit window, even if
- * sendto() double fails ¡  we don't want the application to try again as that is the
- * reliable socks role.
+ *    ⎢ DATA₀ ⎢
+ *    ⎢ DATA₁ ⎢ → send_odatav() →  ⎢ TSDU₀ ⎢ → libc
+ *    ⎢   ⋮   ⎢
+ *
+ * on success, returns PGM_IO_STATUS_NORMAL, on block for non-blocking sockets
+ * returns PGM_IO_STATUS_WOULD_BLOCK, returns PGM_IO_STATUS_RATE_LIMITED if
+ * packet size exceeds the current rate limit.
  */
 
 static
 int
-send_odata (
-	pgm_sock_t*           const restrict sock,
-	struct pgm_sk_buff_t* const restrict skb,
-	size_t*			    restrict bytes_written
+send_odatav (
+	pgm_sock_t*		const restrict sock,
+	const struct pgm_iovec* const restrict vector,
+	const unsigned			       count,		/* number of items in vector */
+	size_t*		 	      restrict bytes_written
 	)
 {
-	void	*data;
-	ssize_t	 sent;
+	char		*dst;
+	size_t		 tpdu_length;
+	ssize_t		 sent;
 
 /* pre-conditions */
 	pgm_assert (NULL != sock);
-	pgm_assert (NULL != skb);
-	pgm_assert (skb->len <= sock->max_tsdu);
+	pgm_assert (count <= PGM_MAX_FRAGMENTS);
+	if (PGM_LIKELY(count)) pgm_assert (NULL != vector);
 
-	pgm_debug ("send_odata (sock:%p skb:%p bytes-written:%p)",
-		(void*)sock, (void*)skb, (void*)bytes_written);
+	pgm_debug ("send_odatav (sock:%p vector:%p count:%u bytes-written:%p)",
+		(const void*)sock, (const void*)vector, count, (const void*)bytes_written);
 
-	const uint16_t    tsdu_length  = skb->len;
-	const sa_family_t pgmcc_family = sock->use_pgmcc ? sock->family : 0;
-	const size_t      tpdu_length  = tsdu_length + pgm_pkt_offset (FALSE, pgmcc_family);
+	if (PGM_UNLIKELY(0 == count))
+		return send_odata_copy (sock, NULL, 0, FALSE, bytes_written);
 
-/* continue if send would block */
+/* continue if blocked on send */
 	if (sock->is_apdu_eagain) {
-		STATE(skb)->tstamp = pgm_time_update_now();
+		pgm_assert ((char*)STATE(skb)->tail > (char*)STATE(skb)->head);
+		tpdu_length = (char*)STATE(skb)->tail - (char*)STATE(skb)->head;
 		goto retry_send;
 	}
 
-/* add PGM header to skbuff */
-	STATE(skb) = pgm_skb_get(skb);
+	STATE(tsdu_length) = 0;
+	for (unsigned i = 0; i < count; i++)
+	{
+#ifdef TRANSPORT_DEBUG
+		if (PGM_LIKELY(vector[i].iov_len)) {
+			pgm_assert( vector[i].iov_base );
+		}
+#endif
+		STATE(tsdu_length) += vector[i].iov_len;
+	}
+	pgm_return_val_if_fail (STATE(tsdu_length) <= sock->max_tsdu, PGM_IO_STATUS_ERROR);
+
+	STATE(skb) = pgm_txw_alloc_skb (sock->window, sock->skb_pool, sock->max_tpdu);
 	STATE(skb)->sock = sock;
 	STATE(skb)->tstamp = pgm_time_update_now();
+	const sa_family_t pgmcc_family = sock->use_pgmcc ? sock->family : 0;
+	pgm_skb_reserve (STATE(skb), (uint16_t)pgm_pkt_offset (FALSE, pgmcc_family));
+	pgm_skb_put (STATE(skb), (uint16_t)STATE(tsdu_length));
 
-	STATE(skb)->pgm_header = (struct pgm_header*)STATE(skb)->head;
-	STATE(skb)->pgm_data   = (struct pgm_data*)(STATE(skb)->pgm_header + 1);
-	memcpy (STATE(skb)->pgm_header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
-	STATE(skb)->pgm_header->pgm_sport	= sock->tsi.sport;
-	STATE(skb)->pgm_header->pgm_dport	= sock->dport;
-	STATE(skb)->pgm_header->pgm_type        = PGM_ODATA;
-        STATE(skb)->pgm_header->pgm_options     = sock->use_pgmcc ? PGM_OPT_PRESENT : 0;
-        STATE(skb)->pgm_header->pgm_tsdu_length = pgm_htons (tsdu_length);
+	const uint32_t unfolded_header		= odata_template_stamp (sock, STATE(skb), PGM_ODATA_TEMPLATE_DATA, (uint16_t)STATE(tsdu_length), pgm_txw_next_lead (sock->window));
 
-/* ODATA */
-        STATE(skb)->pgm_data->data_sqn		= pgm_htonl (pgm_txw_next_lead(sock->window));
-        STATE(skb)->pgm_data->data_trail	= pgm_htonl (pgm_txw_trail(sock->window));
+/* unroll first iteration to make friendly branch prediction */
+	dst			= (char*)(STATE(skb)->pgm_data + 1);
+	STATE(unfolded_odata)	= odata_csum_partial_copy (sock, (const char*)vector[0].iov_base, dst, (uint16_t)vector[0].iov_len);
 
-        STATE(skb)->pgm_header->pgm_checksum    = 0;
-	data = STATE(skb)->pgm_data + 1;
-/* congestion control option header indicating elected peer for ACKs. */
-	if (sock->use_pgmcc) {
-		struct pgm_opt_header	   *opt_header;
-		struct pgm_opt_length	   *opt_len;
-		struct pgm_opt_pgmcc_data  *pgmcc_data;
-		const size_t opt_pgmcc_data_len = ((AF_INET6 == sock->acker_nla.ss_family) ?
-							sizeof (struct pgm_opt6_pgmcc_data) :
-							sizeof (struct pgm_opt_pgmcc_data));
-		opt_len = data;
-		opt_len->opt_type	= PGM_OPT_LENGTH;
-		opt_len->opt_length	= sizeof(struct pgm_opt_length);
-		opt_len->opt_total_length = pgm_htons ((uint16_t)(sizeof (struct pgm_opt_length) +
-							sizeof (struct pgm_opt_header) +
-							opt_pgmcc_data_len));
-		opt_header = (struct pgm_opt_header*)(opt_len + 1);
-		opt_header->opt_type	= PGM_OPT_PGMCC_DATA | PGM_OPT_END;
-		opt_header->opt_length	= sizeof (struct pgm_opt_header) +
-						opt_pgmcc_data_len;
-		pgmcc_data  = (struct pgm_opt_pgmcc_data *)(opt_header + 1);
-		pgmcc_data->opt_tstamp = pgm_htonl ((uint32_t)pgm_to_msecs (STATE(skb)->tstamp));
-/* acker nla */
-		pgm_sockaddr_to_nla ((struct sockaddr*)&sock->acker_nla, (char*)&pgmcc_data->opt_nla_afi);
-		data = (char*)opt_header + opt_header->opt_length;
+/* iterate over one or more vector elements to perform scatter/gather checksum & copy */
+	for (unsigned i = 1; i < count; i++) {
+		dst += vector[i-1].iov_len;
+		STATE(unfolded_odata) = odata_csum_partial_copy_next (sock, (const char*)vector[i].iov_base, dst, (uint16_t)vector[i].iov_len, 0, STATE(unfolded_odata), (uint16_t)vector[i-1].iov_len);
 	}
-	const size_t   pgm_header_len		= (char*)data - (char*)STATE(skb)->pgm_header;
-	const uint32_t unfolded_header		= pgm_csum_partial (STATE(skb)->pgm_header, (uint16_t)pgm_header_len, 0);
-	STATE(unfolded_odata)			= pgm_csum_partial (data, (uint16_t)tsdu_length, 0);
-        STATE(skb)->pgm_header->pgm_checksum	= pgm_csum_fold (pgm_csum_block_add (unfolded_header, STATE(unfolded_odata), (uint16_t)pgm_header_len));
+
+	STATE(skb)->pgm_header->pgm_checksum	= data_csum_fold_unfolded (sock, STATE(skb), unfolded_header, sock->odata_template[ PGM_ODATA_TEMPLATE_DATA ].header_length, STATE(unfolded_odata));
 
 /* add to transmit window, skb::data set to payload */
-	pgm_spinlock_lock (&sock->txw_spinlock);
 	pgm_txw_add (sock->window, STATE(skb));
-	pgm_spinlock_unlock (&sock->txw_spinlock);
+
+	pgm_assert ((char*)STATE(skb)->tail > (char*)STATE(skb)->head);
+	tpdu_length = (char*)STATE(skb)->tail - (char*)STATE(skb)->head;
 
 /* check rate limit at last moment */
 	STATE(is_rate_limited) = FALSE;
@@ -1185,35 +4117,19 @@ send_odata (
 				      sock->is_nonblocking))
 		{
 			sock->is_apdu_eagain = TRUE;
-			sock->blocklen = tpdu_length + sock->iphdr_len;
+			odata_rate_limited (sock, tpdu_length + sock->iphdr_len);
 			return PGM_IO_STATUS_RATE_LIMITED;
 		}
 		STATE(is_rate_limited) = TRUE;
 	}
 
-/* the transmit window MUST check the user count to ensure it does not 
- * attempt to send a repair-data packet based on in transit original data.
- */
 retry_send:
-
-/* congestion control: early exit on empty token bucket */
-	if (sock->use_pgmcc &&
-	    sock->tokens < pgm_fp8 (1))
-	{
-//		pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("Token limit reached."));
-		sock->is_apdu_eagain = TRUE;
-		sock->blocklen = tpdu_length + sock->iphdr_len;
-		return PGM_IO_STATUS_CONGESTION;	/* peer expiration to re-elect ACKer */
-	}
-
-	sent = pgm_sendto (sock,
+	sent = pgm_sendskb (sock,
 			   !STATE(is_rate_limited),	/* rate limit on blocking */
 			   &sock->odata_rate_control,
-			   FALSE,			/* regular socket */
-			   STATE(skb)->head,
-			   tpdu_length,
-			   (struct sockaddr*)&sock->send_gsr.gsr_group,
-			   pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
+			   STATE(skb),
+			   odata_group (sock, STATE(skb)),
+			   pgm_sockaddr_len (odata_group (sock, STATE(skb))));
 	if (sent < 0) {
 		const int save_errno = pgm_get_last_sock_error();
 		if (PGM_LIKELY(PGM_SOCK_EAGAIN == save_errno || PGM_SOCK_ENOBUFS == save_errno))
@@ -1233,337 +4149,757 @@ retry_send:
 	sock->is_apdu_eagain = FALSE;
 /* SPM heartbeats decay from last sent data packet */
 	reset_heartbeat_spm (sock, STATE(skb)->tstamp);
-/* congestion control: remove token from bucket */
-	if (sock->use_pgmcc) {
-		sock->tokens -= pgm_fp8 (1);
-		sock->ack_expiry = STATE(skb)->tstamp + sock->ack_expiry_ivl;
-	}
-/* save unfolded odata for retransmissions */
-	pgm_txw_set_unfolded_checksum (STATE(skb), STATE(unfolded_odata));
+/* time from the send call, stamped on the skb, to return of the socket send */
+	pgm_latency_record (PGM_LATENCY_TX_WIRE, STATE(skb)->tstamp, pgm_time_update_now());
+/* save unfolded odata for retransmissions */
+	pgm_txw_set_unfolded_checksum (STATE(skb), STATE(unfolded_odata));
+/* increment socket statistics */
+	if (PGM_LIKELY((size_t)sent == STATE(skb)->len)) {
+		sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += STATE(tsdu_length);
+		sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  ++;
+		pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)(tpdu_length + sock->iphdr_len));
+	}
+/* check for end of transmission group */
+	if (sock->use_proactive_parity)
+		source_odata_sent (sock, STATE(skb));
+
+/* return data payload length sent */
+	if (bytes_written)
+		*bytes_written = STATE(tsdu_length);
+	return PGM_IO_STATUS_NORMAL;
+}
+
+/* flush pending fragments of the transmit batch with one system call.
+ *
+ * on success, returns TRUE and accumulates statistics of sent packets.  on
+ * block returns FALSE with socket error set, remaining packets stay in the
+ * batch for a subsequent call.
+ */
+
+static
+bool
+send_odata_batch (
+	pgm_sock_t* const restrict	sock,
+	const bool			use_rate_limit,
+	size_t*		  restrict	bytes_sent,
+	unsigned*	  restrict	packets_sent,
+	size_t*		  restrict	data_bytes_sent
+	)
+{
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != sock->tx_batch);
+
+	while (STATE(batch_index) < STATE(batch_len))
+	{
+		struct pgm_sk_buff_t**const skbs = &sock->tx_batch[STATE(batch_index)];
+/* one destination per call, a stripe boundary splits the batch */
+		const struct sockaddr* to = odata_group (sock, skbs[0]);
+		unsigned run_len = 1;
+		while (STATE(batch_index) + run_len < STATE(batch_len) &&
+		       to == odata_group (sock, skbs[run_len]))
+			run_len++;
+		const int sent = pgm_sendmmsg (sock,
+					       use_rate_limit,
+					       &sock->odata_rate_control,
+					       FALSE,			/* regular socket */
+					       skbs,
+					       run_len,
+					       to,
+					       pgm_sockaddr_len (to));
+		if (sent < 0) {
+			sock->blocklen = (char*)skbs[0]->tail - (char*)skbs[0]->head + sock->iphdr_len;
+			return FALSE;
+		}
+
+		for (int i = 0; i < sent; i++)
+		{
+			struct pgm_sk_buff_t* skb = skbs[i];
+			*bytes_sent += (char*)skb->tail - (char*)skb->head + sock->iphdr_len;
+			(*packets_sent)++;
+			*data_bytes_sent += pgm_ntohs (skb->pgm_header->pgm_tsdu_length);
+
+/* check for end of transmission group */
+			if (sock->use_proactive_parity)
+				source_odata_sent (sock, skb);
+			pgm_free_skb (skb);
+		}
+		STATE(batch_index) += sent;
+	}
+	STATE(batch_len) = STATE(batch_index) = 0;
+	return TRUE;
+}
+
+/* send PGM original data, callee owned memory.  if larger than maximum TPDU
+ * size will be fragmented.  with a non-zero orig_length the APDU is an LZ4
+ * block and every fragment carries OPT_COMPRESS.
+ *
+ * on success, returns PGM_IO_STATUS_NORMAL, on block for non-blocking sockets
+ * returns PGM_IO_STATUS_WOULD_BLOCK, returns PGM_IO_STATUS_RATE_LIMITED if
+ * packet size exceeds the current rate limit.
+ */
+
+static
+int
+send_fragments (
+	pgm_sock_t* 	 const restrict	sock,
+	const void*	       restrict	apdu,
+	const size_t			apdu_length,
+	const uint32_t			orig_length,	/* decompressed, 0 for none */
+	size_t*		       restrict	bytes_written
+	)
+{
+	size_t		bytes_sent = 0;		/* counted at IP layer */
+	unsigned	packets_sent = 0;	/* IP packets */
+	size_t		data_bytes_sent = 0;
+	int		save_errno;
+
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != apdu);
+
+	const sa_family_t pgmcc_family = sock->use_pgmcc ? sock->family : 0;
+	const unsigned template_index = orig_length ? PGM_ODATA_TEMPLATE_COMPRESS : PGM_ODATA_TEMPLATE_FRAGMENT;
+	const size_t opt_compress_length = orig_length ? sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_compress) : 0;
+
+/* continue if blocked mid-apdu */
+	if (sock->is_apdu_eagain) {
+		if (STATE(batch_len))
+			goto retry_batch;
+		goto retry_send;
+	}
+
+/* if non-blocking calculate total wire size and check rate limit */
+	STATE(is_rate_limited) = FALSE;
+	if (sock->is_nonblocking && sock->is_controlled_odata)
+	{
+		const size_t header_length = pgm_pkt_offset (TRUE, pgmcc_family) + opt_compress_length + pgm_data_trailer_len (sock);
+		size_t tpdu_length = 0;
+		size_t offset_	   = 0;
+
+		do {
+			const uint_fast16_t tsdu_length = (uint_fast16_t)MIN( source_max_tsdu (sock, TRUE) - opt_compress_length, apdu_length - offset_ );
+			tpdu_length += sock->iphdr_len + header_length + tsdu_length;
+			offset_ += tsdu_length;
+		} while (offset_ < apdu_length);
+
+		if (!pgm_rate_check2 (&sock->rate_control,
+				      &sock->odata_rate_control,
+				      tpdu_length - sock->iphdr_len,	/* includes 1 × IP header len */
+				      sock->is_nonblocking))
+		{
+			odata_rate_limited (sock, tpdu_length);
+			return PGM_IO_STATUS_RATE_LIMITED;
+		}
+		STATE(is_rate_limited) = TRUE;
+	}
+
+	STATE(data_bytes_offset)	= 0;
+	STATE(first_sqn)		= pgm_txw_next_lead(sock->window);
+
+	do {
+		size_t			 tpdu_length, header_length;
+		ssize_t			 sent;
+
+/* retrieve packet storage from transmit window */
+		header_length = pgm_pkt_offset (TRUE, pgmcc_family) + opt_compress_length;
+		STATE(tsdu_length) = MIN( source_max_tsdu (sock, TRUE) - opt_compress_length, apdu_length - STATE(data_bytes_offset) );
+
+		STATE(skb) = pgm_txw_alloc_skb (sock->window, sock->skb_pool, sock->max_tpdu);
+		STATE(skb)->sock = sock;
+		STATE(skb)->tstamp = pgm_time_update_now();
+		pgm_skb_reserve (STATE(skb), (uint16_t)header_length);
+		pgm_skb_put (STATE(skb), (uint16_t)STATE(tsdu_length));
+
+/* ODATA with OPT_FRAGMENT from the socket template */
+		const uint32_t unfolded_header		= odata_template_stamp_fragment (sock,
+											 STATE(skb),
+											 (uint16_t)STATE(tsdu_length),
+											 pgm_txw_next_lead (sock->window),
+											 STATE(first_sqn),
+											 (uint32_t)STATE(data_bytes_offset),
+											 (uint32_t)apdu_length,
+											 orig_length);
+
+/* TODO: the assembly checksum & copy routine is faster than memcpy & pgm_cksum on >= opteron hardware */
+		STATE(unfolded_odata)			= odata_csum_partial_copy_apdu (sock, (const char*)apdu + STATE(data_bytes_offset), (char*)(STATE(skb)->pgm_opt_fragment + 1) + opt_compress_length, (uint16_t)STATE(tsdu_length), apdu_length);
+		STATE(skb)->pgm_header->pgm_checksum	= data_csum_fold_unfolded (sock, STATE(skb), unfolded_header, sock->odata_template[ template_index ].header_length, STATE(unfolded_odata));
+
+/* add to transmit window, skb::data set to payload */
+		pgm_txw_add (sock->window, STATE(skb));
+
+/* defer transmit until batch is full or APDU complete */
+		if (sock->tx_batch) {
+			pgm_txw_set_unfolded_checksum (STATE(skb), STATE(unfolded_odata));
+			sock->tx_batch[STATE(batch_len)++] = pgm_skb_get (STATE(skb));
+			STATE(data_bytes_offset) += STATE(tsdu_length);
+			if (STATE(batch_len) < sock->tx_batch_size &&
+			    STATE(data_bytes_offset) < apdu_length)
+				continue;
+retry_batch:
+			if (!send_odata_batch (sock, !STATE(is_rate_limited), &bytes_sent, &packets_sent, &data_bytes_sent)) {
+				save_errno = pgm_get_last_sock_error();
+				sock->is_apdu_eagain = TRUE;
+				goto blocked;
+			}
+			continue;
+		}
+
+retry_send:
+		pgm_assert ((char*)STATE(skb)->tail > (char*)STATE(skb)->head);
+		tpdu_length = (char*)STATE(skb)->tail - (char*)STATE(skb)->head;
+		sent = pgm_sendskb (sock,
+				   !STATE(is_rate_limited),	/* rate limit on blocking */
+				   &sock->odata_rate_control,
+				   STATE(skb),
+				   odata_group (sock, STATE(skb)),
+				   pgm_sockaddr_len (odata_group (sock, STATE(skb))));
+		if (sent < 0) {
+			save_errno = pgm_get_last_sock_error();
+			if (PGM_LIKELY(PGM_SOCK_EAGAIN == save_errno || PGM_SOCK_ENOBUFS == save_errno))
+			{
+				sock->is_apdu_eagain = TRUE;
+				sock->blocklen = tpdu_length + sock->iphdr_len;
+				goto blocked;
+			}
+/* fall through silently on other errors */
+		}
+
+/* save unfolded odata for retransmissions */
+		pgm_txw_set_unfolded_checksum (STATE(skb), STATE(unfolded_odata));
+
+		if (PGM_LIKELY((size_t)sent == tpdu_length)) {
+			bytes_sent += tpdu_length + sock->iphdr_len;	/* as counted at IP layer */
+			packets_sent++;					/* IP packets */
+			data_bytes_sent += STATE(tsdu_length);
+		}
+
+		STATE(data_bytes_offset) += STATE(tsdu_length);
+
+/* check for end of transmission group */
+		if (sock->use_proactive_parity)
+			source_odata_sent (sock, STATE(skb));
+
+	} while ( STATE(data_bytes_offset)  < apdu_length);
+	pgm_assert( STATE(data_bytes_offset) == apdu_length );
+
+/* success */
+	sock->is_apdu_eagain = FALSE;
+/* SPM heartbeats decay from last sent data packet */
+	reset_heartbeat_spm (sock, STATE(skb)->tstamp);
 /* increment socket statistics */
-	if (PGM_LIKELY((size_t)sent == tpdu_length)) {
-		sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += tsdu_length;
-		sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  ++;
-		pgm_atomic_add32 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint32_t)(tpdu_length + sock->iphdr_len));
-	}
-/* check for end of transmission group for pro-active packets */
-	if (sock->use_proactive_parity) {
-		const uint32_t odata_sqn = pgm_ntohl (STATE(skb)->pgm_data->data_sqn);
-		const uint32_t tg_sqn_mask = 0xffffffff << sock->tg_sqn_shift;
-		if (!((odata_sqn + 1) & ~tg_sqn_mask))
-			pgm_schedule_proactive_nak (sock, odata_sqn & tg_sqn_mask);
-	}
-/* remove applications reference to skbuff */
-	pgm_free_skb (STATE(skb));
+	pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)bytes_sent);
+	sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  += packets_sent;
+	sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += data_bytes_sent;
 	if (bytes_written)
-		*bytes_written = tsdu_length;
+		*bytes_written = orig_length ? orig_length : apdu_length;
 	return PGM_IO_STATUS_NORMAL;
+
+blocked:
+	if (bytes_sent) {
+		reset_heartbeat_spm (sock, STATE(skb)->tstamp);
+		pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)bytes_sent);
+		sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  += packets_sent;
+		sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += data_bytes_sent;
+	}
+	if (PGM_SOCK_ENOBUFS == save_errno)
+		return PGM_IO_STATUS_RATE_LIMITED;
+	if (sock->use_pgmcc)
+		pgm_notify_clear (&sock->ack_notify);
+	return PGM_IO_STATUS_WOULD_BLOCK;
 }
 
-/* send one PGM original data packet, callee owned memory.
+/* send one APDU as fragments, first compressed into sock::compress_buf when
+ * enabled and the LZ4 block is smaller.  a blocked APDU resumes from the
+ * saved block.
  *
- * on success, returns PGM_IO_STATUS_NORMAL, on block for non-blocking sockets
- * returns PGM_IO_STATUS_WOULD_BLOCK, returns PGM_IO_STATUS_RATE_LIMITED if
- * packet size exceeds the current rate limit.
+ * returns as send_fragments().
  */
 
 static
 int
-send_odata_copy (
+send_apdu (
+	pgm_sock_t* 	 const restrict	sock,
+	const void*	       restrict	apdu,
+	const size_t			apdu_length,
+	size_t*		       restrict	bytes_written
+	)
+{
+	if (sock->compress_accel && apdu_length >= PGM_COMPRESS_MIN_APDU)
+	{
+		if (!sock->is_apdu_eagain)
+			STATE(compress_len) = pgm_compress (apdu, apdu_length, sock->compress_buf, apdu_length - 1, sock->compress_accel);
+		if (STATE(compress_len))
+			return send_fragments (sock, sock->compress_buf, STATE(compress_len), (uint32_t)apdu_length, bytes_written);
+	}
+	return send_fragments (sock, apdu, apdu_length, 0, bytes_written);
+}
+
+/* multi-producer original data with PGM_MULTI_PRODUCER.  each pgm_send()
+ * reserves the sequence numbers of its APDU with one fetch-and-add, builds and
+ * checksums its packets from the ODATA templates without a lock, and publishes
+ * them into sock::mp_ring by sequence.  whichever thread finds the next
+ * sequence to commit published drains the contiguous run into the transmit
+ * window and onto the wire under the source mutex, such that packets leave in
+ * sequence order however the producers interleave.
+ */
+
+/* build one ODATA packet of a reserved sequence, a fragment of an APDU when
+ * apdu_length is non-zero.  the window trail is read at build time and may lag
+ * the trail at commit, which receivers accept.
+ *
+ * returns the packet with checksum, ready for the window.
+ */
+
+static
+struct pgm_sk_buff_t*
+mp_build_odata (
 	pgm_sock_t*      const restrict	sock,
 	const void*	       restrict	tsdu,
 	const uint16_t			tsdu_length,
-	size_t*		       restrict	bytes_written
+	const uint32_t			sequence,
+	const uint32_t			first_sqn,	/* of the APDU */
+	const size_t			frag_off,
+	const size_t			apdu_length	/* 0 for a single packet */
 	)
 {
-	void	*data;
-	ssize_t	 sent;
+	struct pgm_sk_buff_t* skb;
+	uint32_t unfolded_header, unfolded_odata;
 
-/* pre-conditions */
-	pgm_assert (NULL != sock);
-	pgm_assert (tsdu_length <= sock->max_tsdu);
-	if (PGM_LIKELY(tsdu_length)) pgm_assert (NULL != tsdu);
+	const unsigned template_index = apdu_length ? PGM_ODATA_TEMPLATE_FRAGMENT : PGM_ODATA_TEMPLATE_DATA;
+	const uint16_t header_length = sock->odata_template[ template_index ].header_length;
 
-	pgm_debug ("send_odata_copy (sock:%p tsdu:%p tsdu_length:%u bytes-written:%p)",
-		(void*)sock, tsdu, tsdu_length, (void*)bytes_written);
+	skb = pgm_skb_pool_alloc (sock->skb_pool, sock->max_tpdu);
+	skb->sock = sock;
+	skb->tstamp = pgm_time_update_now();
+	pgm_skb_reserve (skb, header_length);
+	pgm_skb_put (skb, tsdu_length);
 
-	const sa_family_t pgmcc_family = sock->use_pgmcc ? sock->family : 0;
-	const size_t      tpdu_length  = tsdu_length + pgm_pkt_offset (FALSE, pgmcc_family);
+	if (apdu_length) {
+		unfolded_header = odata_template_stamp_fragment (sock, skb, tsdu_length, sequence, first_sqn, (uint32_t)frag_off, (uint32_t)apdu_length, 0);
+		unfolded_odata  = odata_csum_partial_copy_apdu (sock, tsdu, skb->data, tsdu_length, apdu_length);
+	} else {
+		unfolded_header = odata_template_stamp (sock, skb, PGM_ODATA_TEMPLATE_DATA, tsdu_length, sequence);
+		unfolded_odata  = odata_csum_partial_copy (sock, tsdu, skb->data, tsdu_length);
+	}
+/* as data_csum_fold_unfolded() with zero checksums counted at commit */
+	if (sock->use_crc32c)
+		data_crc32c_trailer (sock, skb, header_length, unfolded_odata);
+	else if (!sock->use_zero_checksum)
+		skb->pgm_header->pgm_checksum = pgm_csum_fold (pgm_csum_block_add (unfolded_header, unfolded_odata, header_length));
+	pgm_txw_set_unfolded_checksum (skb, unfolded_odata);
+	return skb;
+}
 
-/* continue if blocked mid-apdu, updating timestamp */
-	if (sock->is_apdu_eagain) {
-		STATE(skb)->tstamp = pgm_time_update_now();
-		goto retry_send;
+/* send the transmit batch filled by mp_commit_run(), packets the socket
+ * refuses are left to repair as they are already in the window.
+ */
+
+static
+void
+mp_send_batch (
+	pgm_sock_t* const restrict	sock,
+	size_t*		  restrict	bytes_sent,
+	unsigned*	  restrict	packets_sent,
+	size_t*		  restrict	data_bytes_sent
+	)
+{
+	if (send_odata_batch (sock, TRUE, bytes_sent, packets_sent, data_bytes_sent))
+		return;
+	for (unsigned i = STATE(batch_index); i < STATE(batch_len); i++) {
+		if (sock->use_proactive_parity)
+			source_odata_sent (sock, sock->tx_batch[ i ]);
+		pgm_free_skb (sock->tx_batch[ i ]);
 	}
+	STATE(batch_len) = STATE(batch_index) = 0;
+}
 
-	STATE(skb) = pgm_alloc_skb (sock->max_tpdu);
-	STATE(skb)->sock = sock;
-	STATE(skb)->tstamp = pgm_time_update_now();
-	pgm_skb_reserve (STATE(skb), (uint16_t)pgm_pkt_offset (FALSE, pgmcc_family));
-	pgm_skb_put (STATE(skb), (uint16_t)tsdu_length);
+/* add the contiguous run of published packets from sock::mp_commit_sqn to the
+ * window and send them, under the source mutex.
+ */
 
-	STATE(skb)->pgm_header	= (struct pgm_header*)STATE(skb)->head;
-	STATE(skb)->pgm_data	= (struct pgm_data*)(STATE(skb)->pgm_header + 1);
-	memcpy (STATE(skb)->pgm_header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
-	STATE(skb)->pgm_header->pgm_sport	= sock->tsi.sport;
-	STATE(skb)->pgm_header->pgm_dport	= sock->dport;
-	STATE(skb)->pgm_header->pgm_type	= PGM_ODATA;
-	STATE(skb)->pgm_header->pgm_options	= sock->use_pgmcc ? PGM_OPT_PRESENT : 0;
-	STATE(skb)->pgm_header->pgm_tsdu_length = pgm_htons (tsdu_length);
+static
+void
+mp_commit_run (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_sk_buff_t* skb = NULL;
+	pgm_time_t tstamp = 0;
+	size_t bytes_sent = 0, data_bytes_sent = 0;
+	unsigned packets_sent = 0;
 
-/* ODATA */
-	STATE(skb)->pgm_data->data_sqn		= pgm_htonl (pgm_txw_next_lead(sock->window));
-	STATE(skb)->pgm_data->data_trail	= pgm_htonl (pgm_txw_trail(sock->window));
+	for (;;)
+	{
+		const uint32_t sequence = pgm_atomic_read32 (&sock->mp_commit_sqn);
+		skb = sock->mp_ring[ sequence & (PGM_MP_RING_LEN - 1) ];
+		if (NULL == skb)
+			break;
+		sock->mp_ring[ sequence & (PGM_MP_RING_LEN - 1) ] = NULL;
+
+/* pending repairs ahead of new original data */
+		if (sock->use_tx_priority)
+			tx_sched_odata (sock, skb->len);
+
+		pgm_assert_cmpuint (sequence, ==, pgm_txw_next_lead (sock->window));
+		pgm_txw_add (sock->window, skb);
+/* slot released to the producer of sequence + PGM_MP_RING_LEN */
+		pgm_atomic_inc32 (&sock->mp_commit_sqn);
+		if (sock->use_zero_checksum && !sock->use_crc32c)
+			sock->zero_checksum_sent++;
+		tstamp = skb->tstamp;
+
+/* defer transmit until batch is full or the run ends */
+		if (sock->tx_batch) {
+			sock->tx_batch[STATE(batch_len)++] = pgm_skb_get (skb);
+			if (STATE(batch_len) == sock->tx_batch_size)
+				mp_send_batch (sock, &bytes_sent, &packets_sent, &data_bytes_sent);
+			continue;
+		}
 
-	STATE(skb)->pgm_header->pgm_checksum	= 0;
-	data = STATE(skb)->pgm_data + 1;
-/* congestion control option header indicating elected peer for ACKs. */
-	if (sock->use_pgmcc) {
-		struct pgm_opt_header		*opt_header;
-		struct pgm_opt_length		*opt_len;
-		struct pgm_opt_pgmcc_data	*pgmcc_data;
-		const size_t opt_pgmcc_data_len = ((AF_INET6 == sock->acker_nla.ss_family) ?
-							sizeof (struct pgm_opt6_pgmcc_data) :
-							sizeof (struct pgm_opt_pgmcc_data));
-		opt_len = data;
-		opt_len->opt_type	= PGM_OPT_LENGTH;
-		opt_len->opt_length	= sizeof (struct pgm_opt_length);
-		opt_len->opt_total_length = pgm_htons ((uint16_t)(sizeof (struct pgm_opt_length) +
-							sizeof (struct pgm_opt_header) +
-							opt_pgmcc_data_len));
-		opt_header = (struct pgm_opt_header*)(opt_len + 1);
-		opt_header->opt_type	= PGM_OPT_PGMCC_DATA | PGM_OPT_END;
-		opt_header->opt_length	= sizeof (struct pgm_opt_header) +
-						opt_pgmcc_data_len;
-		pgmcc_data  = (struct pgm_opt_pgmcc_data *)(opt_header + 1);
-		pgmcc_data->opt_reserved = 0;
-		pgmcc_data->opt_tstamp = pgm_htonl ((uint32_t)pgm_to_msecs (STATE(skb)->tstamp));
-/* acker nla */
-		pgm_sockaddr_to_nla ((struct sockaddr*)&sock->acker_nla, (char*)&pgmcc_data->opt_nla_afi);
-		data = (char*)opt_header + opt_header->opt_length;
+		const size_t tpdu_length = (char*)skb->tail - (char*)skb->head;
+		const ssize_t sent = pgm_sendskb (sock,
+						  TRUE,			/* rate limit */
+						  &sock->odata_rate_control,
+						  skb,
+						  odata_group (sock, skb),
+						  pgm_sockaddr_len (odata_group (sock, skb)));
+/* fall through silently on errors, the packet is in the window */
+		if (PGM_LIKELY((size_t)sent == tpdu_length)) {
+			bytes_sent += tpdu_length + sock->iphdr_len;
+			packets_sent++;
+			data_bytes_sent += skb->len;
+		}
+		if (sock->use_proactive_parity)
+			source_odata_sent (sock, skb);
 	}
-	const size_t   pgm_header_len		= (char*)data - (char*)STATE(skb)->pgm_header;
-	const uint32_t unfolded_header		= pgm_csum_partial (STATE(skb)->pgm_header, (uint16_t)pgm_header_len, 0);
-	STATE(unfolded_odata)			= pgm_csum_partial_copy (tsdu, data, (uint16_t)tsdu_length, 0);
-	STATE(skb)->pgm_header->pgm_checksum	= pgm_csum_fold (pgm_csum_block_add (unfolded_header, STATE(unfolded_odata), (uint16_t)pgm_header_len));
+	if (sock->tx_batch && STATE(batch_len))
+		mp_send_batch (sock, &bytes_sent, &packets_sent, &data_bytes_sent);
+	if (0 == tstamp)
+		return;
 
-/* add to transmit window, skb::data set to payload */
-	pgm_spinlock_lock (&sock->txw_spinlock);
-	pgm_txw_add (sock->window, STATE(skb));
-	pgm_spinlock_unlock (&sock->txw_spinlock);
+/* SPM heartbeats decay from last sent data packet */
+	reset_heartbeat_spm (sock, tstamp);
+	pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)bytes_sent);
+	sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  += packets_sent;
+	sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += data_bytes_sent;
+}
 
-/* check rate limit at last moment */
-	STATE(is_rate_limited) = FALSE;
-	if (sock->is_nonblocking && sock->is_controlled_odata)
+/* drain published packets unless another thread is already draining.  the
+ * drainer looks again after letting go, such that a packet published whilst
+ * it held on is never left behind.
+ */
+
+static
+void
+mp_commit (
+	pgm_sock_t* const	sock
+	)
+{
+	for (;;)
 	{
-		if (!pgm_rate_check2 (&sock->rate_control,		/* total rate limit */
-				      &sock->odata_rate_control,	/* original data limit */
-				      tpdu_length,			/* excludes IP header len */
-				      sock->is_nonblocking))
-		{
-			sock->is_apdu_eagain = TRUE;
-			sock->blocklen = tpdu_length + sock->iphdr_len;
-			return PGM_IO_STATUS_RATE_LIMITED;
-		}
-		STATE(is_rate_limited) = TRUE;
+		const uint32_t sequence = pgm_atomic_read32 (&sock->mp_commit_sqn);
+		if (NULL == sock->mp_ring[ sequence & (PGM_MP_RING_LEN - 1) ] ||
+		    !pgm_atomic_compare_and_exchange32 (&sock->is_mp_committing, 0, 1))
+			return;
+		pgm_sock_mutex_lock (sock, &sock->source_mutex);
+		mp_commit_run (sock);
+		pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+		pgm_atomic_compare_and_exchange32 (&sock->is_mp_committing, 1, 0);
 	}
-retry_send:
+}
 
-/* congestion control: early exit on empty token bucket */
-	if (sock->use_pgmcc && 
-	    sock->tokens < pgm_fp8 (1))
+/* send one APDU as a producer, fragmented as by send_fragments() without
+ * compression.
+ *
+ * returns PGM_IO_STATUS_NORMAL, the APDU is committed by this or a later
+ * producer.
+ */
+
+static
+int
+send_multi_producer (
+	pgm_sock_t* 	 const restrict	sock,
+	const void*	       restrict	apdu,
+	const size_t			apdu_length,
+	size_t*		       restrict	bytes_written
+	)
+{
+	const bool is_fragmented = apdu_length > sock->max_tsdu;
+	const size_t max_tsdu = is_fragmented ? source_max_tsdu (sock, TRUE) : sock->max_tsdu;
+	const uint32_t count = is_fragmented ? (uint32_t)((apdu_length + max_tsdu - 1) / max_tsdu) : 1;
+	const uint32_t first_sqn = pgm_atomic_exchange_and_add32 (&sock->mp_reserve_sqn, count);
+	size_t offset = 0;
+
+	for (uint32_t i = 0; i < count; i++)
 	{
-//		pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("Token limit reached."));
-		sock->is_apdu_eagain = TRUE;
-		sock->blocklen = tpdu_length + sock->iphdr_len;
-		return PGM_IO_STATUS_CONGESTION;
+		const uint32_t sequence = first_sqn + i;
+		const uint16_t tsdu_length = (uint16_t)MIN( max_tsdu, apdu_length - offset );
+		struct pgm_sk_buff_t* skb = mp_build_odata (sock,
+							    (const char*)apdu + offset,
+							    tsdu_length,
+							    sequence,
+							    first_sqn,
+							    offset,
+							    is_fragmented ? apdu_length : 0);
+		offset += tsdu_length;
+
+/* wait for the slot, that of the oldest reserved sequence is always free */
+		while ((uint32_t)(sequence - pgm_atomic_read32 (&sock->mp_commit_sqn)) >= PGM_MP_RING_LEN) {
+			mp_commit (sock);
+			pgm_thread_yield ();
+		}
+#ifdef PGM_DISABLE_ASSERT
+		pgm_atomic_compare_and_exchange_pointer ((void*volatile*)&sock->mp_ring[ sequence & (PGM_MP_RING_LEN - 1) ], NULL, skb);
+#else
+		pgm_assert (pgm_atomic_compare_and_exchange_pointer ((void*volatile*)&sock->mp_ring[ sequence & (PGM_MP_RING_LEN - 1) ], NULL, skb));
+#endif
+		mp_commit (sock);
 	}
 
-	sent = pgm_sendto (sock,
-			   !STATE(is_rate_limited),	/* rate limit on blocking */
-			   &sock->odata_rate_control,
-			   FALSE,			/* regular socket */
-			   STATE(skb)->head,
-			   tpdu_length,
-			   (struct sockaddr*)&sock->send_gsr.gsr_group,
-			   pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
-	if (sent < 0) {
-		const int save_errno = pgm_get_last_sock_error();
-		if (PGM_LIKELY(PGM_SOCK_EAGAIN == save_errno || PGM_SOCK_ENOBUFS == save_errno))
+	if (bytes_written)
+		*bytes_written = apdu_length;
+	return PGM_IO_STATUS_NORMAL;
+}
+
+/* send one APDU under the source mutex, as pgm_send() from the application
+ * thread or the sender thread of PGM_SEND_ASYNC.
+ */
+
+static
+int
+send_locked (
+	pgm_sock_t*	 const restrict sock,
+	const void*	       restrict	apdu,
+	const size_t			apdu_length,
+	size_t*	       	       restrict	bytes_written
+	)
+{
+	int status;
+
+	pgm_sock_mutex_lock (sock, &sock->source_mutex);
+
+/* pending repairs ahead of new original data */
+	if (sock->use_tx_priority)
+		tx_sched_odata (sock, apdu_length);
+
+/* pack with other small APDUs */
+	if (sock->coalesce_threshold)
+	{
+		if (sizeof(uint16_t) + apdu_length <= sock->max_tsdu_coalesce)
 		{
-			sock->is_apdu_eagain = TRUE;
-			sock->blocklen = tpdu_length + sock->iphdr_len;
-			if (PGM_SOCK_ENOBUFS == save_errno)
-				return PGM_IO_STATUS_RATE_LIMITED;
-			if (sock->use_pgmcc)
-				pgm_notify_clear (&sock->ack_notify);
-			return PGM_IO_STATUS_WOULD_BLOCK;
+			status = send_odata_coalesce (sock, apdu, (uint16_t)apdu_length, bytes_written);
+			pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+			return status;
+		}
+/* preserve order with APDUs already coalesced */
+		status = pgm_coalesce_flush (sock);
+		if (PGM_IO_STATUS_NORMAL != status) {
+			pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+			return status;
 		}
-/* fall through silently on other errors */
 	}
 
-/* success */
-	sock->is_apdu_eagain = FALSE;
-/* SPM heartbeats decay from last sent data packet */
-	reset_heartbeat_spm (sock, STATE(skb)->tstamp);
-/* congestion control: remove token from bucket */
-	if (sock->use_pgmcc) {
-		sock->tokens -= pgm_fp8 (1);
-		pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("PGMCC tokens-- (T:%u W:%u)"),
-		 	   pgm_fp8tou (sock->tokens), pgm_fp8tou (sock->cwnd_size));
-		sock->ack_expiry = STATE(skb)->tstamp + sock->ack_expiry_ivl;
-	}
-/* save unfolded odata for retransmissions */
-	pgm_txw_set_unfolded_checksum (STATE(skb), STATE(unfolded_odata));
-/* increment socket statistics */
-	if (PGM_LIKELY((size_t)sent == tpdu_length)) {
-		sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += tsdu_length;
-		sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  ++;
-		pgm_atomic_add32 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint32_t)(tpdu_length + sock->iphdr_len));
+/* pass on non-fragment calls, unless to be compressed */
+	if (apdu_length <= sock->max_tsdu &&
+	    !(sock->compress_accel && apdu_length >= PGM_COMPRESS_MIN_APDU))
+		status = send_odata_copy (sock, apdu, (uint16_t)apdu_length, FALSE, bytes_written);
+	else
+		status = send_apdu (sock, apdu, apdu_length, bytes_written);
+	pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+	return status;
+}
+
+/* Send one APDU, whether it fits within one TPDU or more.
+ *
+ * on success, returns PGM_IO_STATUS_NORMAL, on block for non-blocking sockets
+ * returns PGM_IO_STATUS_WOULD_BLOCK, returns PGM_IO_STATUS_RATE_LIMITED if
+ * packet size exceeds the current rate limit.
+ */
+
+int
+pgm_send (
+	pgm_sock_t* 	 const restrict sock,
+	const void*	       restrict	apdu,
+	const size_t			apdu_length,
+	size_t*	       	       restrict	bytes_written
+	)
+{
+	pgm_debug ("pgm_send (sock:%p apdu:%p apdu-length:%" PRIzu " bytes-written:%p)",
+		(void*)sock, apdu, apdu_length, (void*)bytes_written);
+
+/* parameters */
+	pgm_return_val_if_fail (NULL != sock, PGM_IO_STATUS_ERROR);
+	if (PGM_LIKELY(apdu_length)) pgm_return_val_if_fail (NULL != apdu, PGM_IO_STATUS_ERROR);
+
+/* shutdown */
+	if (PGM_UNLIKELY(!pgm_sock_reader_trylock (sock)))
+		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
+
+	source_update_path_mtu (sock);
+
+/* state */
+	if (PGM_UNLIKELY(!sock->is_bound ||
+	    sock->is_destroyed ||
+	    sock->is_standby ||
+	    apdu_length > sock->max_apdu))
+	{
+		pgm_sock_reader_unlock (sock);
+		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
 	}
-/* check for end of transmission group for pro-active packets */
-	if (sock->use_proactive_parity) {
-		const uint32_t odata_sqn = pgm_ntohl (STATE(skb)->pgm_data->data_sqn);
-		const uint32_t tg_sqn_mask = 0xffffffff << sock->tg_sqn_shift;
-		if (!((odata_sqn + 1) & ~tg_sqn_mask))
-			pgm_schedule_proactive_nak (sock, odata_sqn & tg_sqn_mask);
+
+/* producers build in parallel, committing in sequence order */
+	if (sock->use_multi_producer) {
+		const int status = send_multi_producer (sock, apdu, apdu_length, bytes_written);
+		pgm_sock_reader_unlock (sock);
+		return status;
 	}
 
-/* return data payload length sent */
-	if (bytes_written)
-		*bytes_written = tsdu_length;
-	return PGM_IO_STATUS_NORMAL;
+/* queued for the sender thread, refused only when the ring is full */
+	if (NULL != sock->async_thread) {
+		const int status = async_push (sock, apdu, apdu_length, bytes_written);
+		pgm_sock_reader_unlock (sock);
+		return status;
+	}
+
+	const int status = send_locked (sock, apdu, apdu_length, bytes_written);
+	pgm_sock_reader_unlock (sock);
+	return status;
 }
 
-/* send one PGM original data packet, callee owned scatter/gather io vector
+/* Send length bytes of a file from offset as one APDU.  The region is mapped
+ * rather than read into a buffer such that the only copy is the checksum copy
+ * into the transmit window, from which RDATA is served.  A blocked call is
+ * resumed with the same arguments as pgm_send().
  *
- *    ⎢ DATA₀ ⎢
- *    ⎢ DATA₁ ⎢ → send_odatav() →  ⎢ TSDU₀ ⎢ → libc
- *    ⎢   ⋮   ⎢
+ * The file must not be truncated during the call.
  *
- * on success, returns PGM_IO_STATUS_NORMAL, on block for non-blocking sockets
- * returns PGM_IO_STATUS_WOULD_BLOCK, returns PGM_IO_STATUS_RATE_LIMITED if
- * packet size exceeds the current rate limit.
+ * returns as pgm_send(), returns PGM_IO_STATUS_ERROR if the region cannot be
+ * mapped.
  */
 
-static
 int
-send_odatav (
-	pgm_sock_t*		const restrict sock,
-	const struct pgm_iovec* const restrict vector,
-	const unsigned			       count,		/* number of items in vector */
-	size_t*		 	      restrict bytes_written
+pgm_sendfile (
+	pgm_sock_t* 	 const restrict sock,
+	const int			fd,
+	const uint64_t			offset,
+	const size_t			length,
+	size_t*	       	       restrict	bytes_written
 	)
 {
-	char		*dst;
-	size_t		 tpdu_length;
-	ssize_t		 sent;
+	char errbuf[1024];
+	void* map;
+	size_t map_length;
+	uint64_t map_offset;
 
-/* pre-conditions */
-	pgm_assert (NULL != sock);
-	pgm_assert (count <= PGM_MAX_FRAGMENTS);
-	if (PGM_LIKELY(count)) pgm_assert (NULL != vector);
+	pgm_debug ("pgm_sendfile (sock:%p fd:%d offset:%" PRIu64 " length:%" PRIzu " bytes-written:%p)",
+		(void*)sock, fd, offset, length, (void*)bytes_written);
 
-	pgm_debug ("send_odatav (sock:%p vector:%p count:%u bytes-written:%p)",
-		(const void*)sock, (const void*)vector, count, (const void*)bytes_written);
+/* parameters */
+	pgm_return_val_if_fail (NULL != sock, PGM_IO_STATUS_ERROR);
+	pgm_return_val_if_fail (fd >= 0, PGM_IO_STATUS_ERROR);
 
-	if (PGM_UNLIKELY(0 == count))
-		return send_odata_copy (sock, NULL, 0, bytes_written);
+	if (PGM_UNLIKELY(0 == length))
+		return pgm_send (sock, NULL, 0, bytes_written);
+	if (PGM_UNLIKELY(length > sock->max_apdu))
+		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
 
-/* continue if blocked on send */
-	if (sock->is_apdu_eagain) {
-		pgm_assert ((char*)STATE(skb)->tail > (char*)STATE(skb)->head);
-		tpdu_length = (char*)STATE(skb)->tail - (char*)STATE(skb)->head;
-		goto retry_send;
+#ifndef _WIN32
+/* a region past the end of the file would fault on access */
+	struct stat st;
+	if (0 != fstat (fd, &st) || offset + length > (uint64_t)st.st_size) {
+		pgm_warn (_("File descriptor %d has no %" PRIzu " bytes at offset %" PRIu64 " to send."),
+			  fd, length, offset);
+		return PGM_IO_STATUS_ERROR;
 	}
-
-	STATE(tsdu_length) = 0;
-	for (unsigned i = 0; i < count; i++)
-	{
-#ifdef TRANSPORT_DEBUG
-		if (PGM_LIKELY(vector[i].iov_len)) {
-			pgm_assert( vector[i].iov_base );
-		}
-#endif
-		STATE(tsdu_length) += vector[i].iov_len;
+	const long page_size = sysconf (_SC_PAGESIZE);
+	map_offset = offset & ~(uint64_t)(page_size - 1);
+	map_length = (size_t)(offset - map_offset) + length;
+	map = mmap (NULL, map_length, PROT_READ, MAP_SHARED, fd, (off_t)map_offset);
+	if (MAP_FAILED == map) {
+		const int save_errno = errno;
+		pgm_warn (_("Mapping file descriptor %d for send: %s"),
+			  fd, pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		return PGM_IO_STATUS_ERROR;
 	}
-	pgm_return_val_if_fail (STATE(tsdu_length) <= sock->max_tsdu, PGM_IO_STATUS_ERROR);
-
-	STATE(skb) = pgm_alloc_skb (sock->max_tpdu);
-	STATE(skb)->sock = sock;
-	STATE(skb)->tstamp = pgm_time_update_now();
-	const sa_family_t pgmcc_family = sock->use_pgmcc ? sock->family : 0;
-	pgm_skb_reserve (STATE(skb), (uint16_t)pgm_pkt_offset (FALSE, pgmcc_family));
-	pgm_skb_put (STATE(skb), (uint16_t)STATE(tsdu_length));
-
-	STATE(skb)->pgm_header  = (struct pgm_header*)STATE(skb)->data;
-	STATE(skb)->pgm_data    = (struct pgm_data*)(STATE(skb)->pgm_header + 1);
-	memcpy (STATE(skb)->pgm_header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
-	STATE(skb)->pgm_header->pgm_sport	= sock->tsi.sport;
-	STATE(skb)->pgm_header->pgm_dport	= sock->dport;
-	STATE(skb)->pgm_header->pgm_type	= PGM_ODATA;
-	STATE(skb)->pgm_header->pgm_options	= 0;
-	STATE(skb)->pgm_header->pgm_tsdu_length = pgm_htons ((uint16_t)STATE(tsdu_length));
-
-/* ODATA */
-	STATE(skb)->pgm_data->data_sqn		= pgm_htonl (pgm_txw_next_lead(sock->window));
-	STATE(skb)->pgm_data->data_trail	= pgm_htonl (pgm_txw_trail(sock->window));
-
-	STATE(skb)->pgm_header->pgm_checksum	= 0;
-	const size_t   pgm_header_len		= (char*)(STATE(skb)->pgm_data + 1) - (char*)STATE(skb)->pgm_header;
-	const uint32_t unfolded_header		= pgm_csum_partial (STATE(skb)->pgm_header, (uint16_t)pgm_header_len, 0);
+#	ifdef MADV_SEQUENTIAL
+	madvise (map, map_length, MADV_SEQUENTIAL);
+#	endif
+#else
+	SYSTEM_INFO si;
+	GetSystemInfo (&si);
+	map_offset = offset & ~(uint64_t)(si.dwAllocationGranularity - 1);
+	map_length = (size_t)(offset - map_offset) + length;
+	const HANDLE mapping = CreateFileMapping ((HANDLE)_get_osfhandle (fd), NULL, PAGE_READONLY, 0, 0, NULL);
+	map = (NULL == mapping) ? NULL : MapViewOfFile (mapping, FILE_MAP_READ, (DWORD)(map_offset >> 32), (DWORD)map_offset, map_length);
+	if (NULL == map) {
+		const DWORD save_errno = GetLastError();
+		if (NULL != mapping)
+			CloseHandle (mapping);
+		pgm_warn (_("Mapping file descriptor %d for send: %s"),
+			  fd, pgm_win_strerror (errbuf, sizeof (errbuf), save_errno));
+		return PGM_IO_STATUS_ERROR;
+	}
+	CloseHandle (mapping);
+#endif
 
-/* unroll first iteration to make friendly branch prediction */
-	dst			= (char*)(STATE(skb)->pgm_data + 1);
-	STATE(unfolded_odata)	= pgm_csum_partial_copy ((const char*)vector[0].iov_base, dst, (uint16_t)vector[0].iov_len, 0);
+	const int status = pgm_send (sock, (const char*)map + (offset - map_offset), length, bytes_written);
+#ifndef _WIN32
+	munmap (map, map_length);
+#else
+	UnmapViewOfFile (map);
+#endif
+	return status;
+}
 
-/* iterate over one or more vector elements to perform scatter/gather checksum & copy */
-	for (unsigned i = 1; i < count; i++) {
-		dst += vector[i-1].iov_len;
-		const uint32_t unfolded_element = pgm_csum_partial_copy ((const char*)vector[i].iov_base, dst, (uint16_t)vector[i].iov_len, 0);
-		STATE(unfolded_odata) = pgm_csum_block_add (STATE(unfolded_odata), unfolded_element, (uint16_t)vector[i-1].iov_len);
-	}
+/* state helper for the streaming writer
+ */
+#define STREAM(x)	(sock->stream_state.x)
 
-	STATE(skb)->pgm_header->pgm_checksum	= pgm_csum_fold (pgm_csum_block_add (unfolded_header, STATE(unfolded_odata), (uint16_t)pgm_header_len));
+/* stamp, checksum and send the filled fragment of the streamed APDU, or resend
+ * a fragment that blocked.  caller holds source_mutex.
+ *
+ * returns as send_fragments().
+ */
 
-/* add to transmit window, skb::data set to payload */
-	pgm_spinlock_lock (&sock->txw_spinlock);
-	pgm_txw_add (sock->window, STATE(skb));
-	pgm_spinlock_unlock (&sock->txw_spinlock);
+static
+int
+stream_send_fragment (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_sk_buff_t* skb = STREAM(skb);
+	int save_errno;
 
-	pgm_assert ((char*)STATE(skb)->tail > (char*)STATE(skb)->head);
-	tpdu_length = (char*)STATE(skb)->tail - (char*)STATE(skb)->head;
+	pgm_assert (NULL != skb);
+	pgm_assert (STREAM(tsdu_offset) == STREAM(tsdu_length));
 
-/* check rate limit at last moment */
-	STATE(is_rate_limited) = FALSE;
-	if (sock->is_nonblocking && sock->is_controlled_odata)
+	if (!STREAM(is_eagain))
 	{
-		if (!pgm_rate_check2 (&sock->rate_control,		/* total rate limit */
-				      &sock->odata_rate_control,	/* original data limit */
-				      tpdu_length,			/* excludes IP header len */
-				      sock->is_nonblocking))
-		{
-			sock->is_apdu_eagain = TRUE;
-			sock->blocklen = tpdu_length + sock->iphdr_len;
-			return PGM_IO_STATUS_RATE_LIMITED;
-		}
-		STATE(is_rate_limited) = TRUE;
+/* ODATA with OPT_FRAGMENT stamped at completion for the current trail */
+		const uint32_t unfolded_header = odata_template_stamp_fragment (sock,
+										skb,
+										STREAM(tsdu_length),
+										pgm_txw_next_lead (sock->window),
+										STREAM(first_sqn),
+										(uint32_t)(STREAM(offset) - STREAM(tsdu_length)),
+										(uint32_t)STREAM(apdu_length),
+										0);
+		skb->pgm_header->pgm_checksum = data_csum_fold_unfolded (sock, skb, unfolded_header, sock->odata_template[ PGM_ODATA_TEMPLATE_FRAGMENT ].header_length, STREAM(unfolded_odata));
+		pgm_txw_add (sock->window, skb);
+		pgm_txw_set_unfolded_checksum (skb, STREAM(unfolded_odata));
 	}
 
-retry_send:
-	sent = pgm_sendto (sock,
-			   !STATE(is_rate_limited),	/* rate limit on blocking */
-			   &sock->odata_rate_control,
-			   FALSE,			/* regular socket */
-			   STATE(skb)->head,
-			   tpdu_length,
-			   (struct sockaddr*)&sock->send_gsr.gsr_group,
-			   pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
+	const size_t tpdu_length = (char*)skb->tail - (char*)skb->head;
+	const ssize_t sent = pgm_sendskb (sock,
+					  TRUE,			/* rate limited */
+					  &sock->odata_rate_control,
+					  skb,
+					  odata_group (sock, skb),
+					  pgm_sockaddr_len (odata_group (sock, skb)));
 	if (sent < 0) {
-		const int save_errno = pgm_get_last_sock_error();
+		save_errno = pgm_get_last_sock_error();
 		if (PGM_LIKELY(PGM_SOCK_EAGAIN == save_errno || PGM_SOCK_ENOBUFS == save_errno))
 		{
-			sock->is_apdu_eagain = TRUE;
+			STREAM(is_eagain) = TRUE;
 			sock->blocklen = tpdu_length + sock->iphdr_len;
 			if (PGM_SOCK_ENOBUFS == save_errno)
 				return PGM_IO_STATUS_RATE_LIMITED;
@@ -1574,221 +4910,249 @@ retry_send:
 /* fall through silently on other errors */
 	}
 
-/* success */
-	sock->is_apdu_eagain = FALSE;
-/* SPM heartbeats decay from last sent data packet */
-	reset_heartbeat_spm (sock, STATE(skb)->tstamp);
-/* save unfolded odata for retransmissions */
-	pgm_txw_set_unfolded_checksum (STATE(skb), STATE(unfolded_odata));
-/* increment socket statistics */
-	if (PGM_LIKELY((size_t)sent == STATE(skb)->len)) {
-		sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += STATE(tsdu_length);
-		sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  ++;
-		pgm_atomic_add32 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint32_t)(tpdu_length + sock->iphdr_len));
+	if (PGM_LIKELY((size_t)sent == tpdu_length)) {
+		pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)(tpdu_length + sock->iphdr_len));
+		sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]++;
+		sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += STREAM(tsdu_length);
 	}
+	reset_heartbeat_spm (sock, skb->tstamp);
+
 /* check for end of transmission group */
-	if (sock->use_proactive_parity) {
-		const uint32_t odata_sqn   = pgm_ntohl (STATE(skb)->pgm_data->data_sqn);
-		const uint32_t tg_sqn_mask = 0xffffffff << sock->tg_sqn_shift;
-		if (!((odata_sqn + 1) & ~tg_sqn_mask))
-			pgm_schedule_proactive_nak (sock, odata_sqn & tg_sqn_mask);
-	}
+	if (sock->use_proactive_parity)
+		source_odata_sent (sock, skb);
 
-/* return data payload length sent */
-	if (bytes_written)
-		*bytes_written = STATE(tsdu_length);
+	STREAM(skb)	  = NULL;
+	STREAM(is_eagain) = FALSE;
 	return PGM_IO_STATUS_NORMAL;
 }
 
-/* send PGM original data, callee owned memory.  if larger than maximum TPDU
- * size will be fragmented.
+/* Begin an APDU of apdu_length bytes to be appended in chunks with
+ * pgm_send_append() as the data is produced, and completed with
+ * pgm_send_commit().  Each fragment is sent as soon as it is filled, such
+ * that production overlaps transmission and receivers see the first bytes
+ * before the APDU exists in full.
+ *
+ * The source of the socket is held from begin to commit: other sends wait,
+ * and the three calls must be made from one thread which must not send by
+ * other means in between.  Streamed APDUs are neither coalesced nor
+ * compressed.
  *
  * on success, returns PGM_IO_STATUS_NORMAL, on block for non-blocking sockets
- * returns PGM_IO_STATUS_WOULD_BLOCK, returns PGM_IO_STATUS_RATE_LIMITED if
- * packet size exceeds the current rate limit.
+ * sending previously coalesced APDUs returns PGM_IO_STATUS_WOULD_BLOCK or
+ * PGM_IO_STATUS_RATE_LIMITED without beginning the APDU.
  */
 
-static
 int
-send_apdu (
-	pgm_sock_t* 	 const restrict	sock,
-	const void*	       restrict	apdu,
-	const size_t			apdu_length,
-	size_t*		       restrict	bytes_written
+pgm_send_begin (
+	pgm_sock_t* 	 const restrict sock,
+	const size_t			apdu_length
 	)
 {
-	size_t		bytes_sent = 0;		/* counted at IP layer */
-	unsigned	packets_sent = 0;	/* IP packets */
-	size_t		data_bytes_sent = 0;
-	int		save_errno;
+	pgm_debug ("pgm_send_begin (sock:%p apdu-length:%" PRIzu ")",
+		(void*)sock, apdu_length);
 
-	pgm_assert (NULL != sock);
-	pgm_assert (NULL != apdu);
+/* parameters */
+	pgm_return_val_if_fail (NULL != sock, PGM_IO_STATUS_ERROR);
+	pgm_return_val_if_fail (apdu_length > 0, PGM_IO_STATUS_ERROR);
 
-	const sa_family_t pgmcc_family = sock->use_pgmcc ? sock->family : 0;
+/* shutdown */
+	if (PGM_UNLIKELY(!pgm_sock_reader_trylock (sock)))
+		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
 
-/* continue if blocked mid-apdu */
-	if (sock->is_apdu_eagain)
-		goto retry_send;
+	source_update_path_mtu (sock);
 
-/* if non-blocking calculate total wire size and check rate limit */
-	STATE(is_rate_limited) = FALSE;
-	if (sock->is_nonblocking && sock->is_controlled_odata)
+/* state */
+	if (PGM_UNLIKELY(!sock->is_bound ||
+	    sock->is_destroyed ||
+	    sock->is_standby ||
+	    sock->use_multi_producer ||
+	    0 != sock->async_len ||
+	    sock->is_apdu_eagain ||
+	    apdu_length > sock->max_apdu))
 	{
-		const size_t header_length = pgm_pkt_offset (TRUE, pgmcc_family);
-		size_t tpdu_length = 0;
-		size_t offset_	   = 0;
-
-		do {
-			const uint_fast16_t tsdu_length = (uint_fast16_t)MIN( source_max_tsdu (sock, TRUE), apdu_length - offset_ );
-			tpdu_length += sock->iphdr_len + header_length + tsdu_length;
-			offset_ += tsdu_length;
-		} while (offset_ < apdu_length);
+		pgm_sock_reader_unlock (sock);
+		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
+	}
 
-		if (!pgm_rate_check2 (&sock->rate_control,
-				      &sock->odata_rate_control,
-				      tpdu_length - sock->iphdr_len,	/* includes 1 × IP header len */
-				      sock->is_nonblocking))
-		{
-			sock->blocklen = tpdu_length;
-			return PGM_IO_STATUS_RATE_LIMITED;
+/* source */
+	pgm_sock_mutex_lock (sock, &sock->source_mutex);
+	pgm_assert (!STREAM(is_open));
+
+/* preserve order with APDUs already coalesced */
+	if (sock->coalesce_len) {
+		const int status = pgm_coalesce_flush (sock);
+		if (PGM_IO_STATUS_NORMAL != status) {
+			pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+			pgm_sock_reader_unlock (sock);
+			return status;
 		}
-		STATE(is_rate_limited) = TRUE;
 	}
 
-	STATE(data_bytes_offset)	= 0;
-	STATE(first_sqn)		= pgm_txw_next_lead(sock->window);
-
-	do {
-		size_t			 tpdu_length, header_length;
-		struct pgm_opt_header	*opt_header;
-		struct pgm_opt_length	*opt_len;
-		ssize_t			 sent;
+/* pending repairs ahead of new original data */
+	if (sock->use_tx_priority)
+		tx_sched_odata (sock, apdu_length);
+
+	STREAM(is_open)		= TRUE;
+	STREAM(apdu_length)	= apdu_length;
+	STREAM(offset)		= 0;
+	STREAM(first_sqn)	= pgm_txw_next_lead (sock->window);
+	STREAM(skb)		= NULL;
+	STREAM(is_eagain)	= FALSE;
+	pgm_sock_reader_unlock (sock);
+	return PGM_IO_STATUS_NORMAL;
+}
 
-/* retrieve packet storage from transmit window */
-		header_length = pgm_pkt_offset (TRUE, pgmcc_family);
-		STATE(tsdu_length) = MIN( source_max_tsdu (sock, TRUE), apdu_length - STATE(data_bytes_offset) );
+/* Append len bytes of buf to the APDU begun with pgm_send_begin(), sending
+ * every fragment filled.  Bytes beyond the declared length are rejected.
+ *
+ * on success, returns PGM_IO_STATUS_NORMAL with len saved into bytes_written.
+ * on block for non-blocking sockets returns PGM_IO_STATUS_WOULD_BLOCK, or
+ * PGM_IO_STATUS_RATE_LIMITED, with the bytes consumed saved into
+ * bytes_written; the call is repeated with the remainder of buf.
+ */
 
-		STATE(skb) = pgm_alloc_skb (sock->max_tpdu);
-		STATE(skb)->sock = sock;
-		STATE(skb)->tstamp = pgm_time_update_now();
-		pgm_skb_reserve (STATE(skb), (uint16_t)header_length);
-		pgm_skb_put (STATE(skb), (uint16_t)STATE(tsdu_length));
+int
+pgm_send_append (
+	pgm_sock_t* 	 const restrict sock,
+	const void*	       restrict	buf,
+	const size_t			len,
+	size_t*	       	       restrict	bytes_written
+	)
+{
+	const char* src = buf;
+	size_t count = 0;
+	int status = PGM_IO_STATUS_NORMAL;
 
-		STATE(skb)->pgm_header  = (struct pgm_header*)STATE(skb)->head;
-		STATE(skb)->pgm_data    = (struct pgm_data*)(STATE(skb)->pgm_header + 1);
-		memcpy (STATE(skb)->pgm_header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
-		STATE(skb)->pgm_header->pgm_sport	= sock->tsi.sport;
-		STATE(skb)->pgm_header->pgm_dport	= sock->dport;
-		STATE(skb)->pgm_header->pgm_type	= PGM_ODATA;
-		STATE(skb)->pgm_header->pgm_options	= PGM_OPT_PRESENT;
-		STATE(skb)->pgm_header->pgm_tsdu_length = pgm_htons ((uint16_t)STATE(tsdu_length));
+	pgm_debug ("pgm_send_append (sock:%p buf:%p len:%" PRIzu " bytes-written:%p)",
+		(void*)sock, buf, len, (void*)bytes_written);
 
-/* ODATA */
-		STATE(skb)->pgm_data->data_sqn		= pgm_htonl (pgm_txw_next_lead(sock->window));
-		STATE(skb)->pgm_data->data_trail	= pgm_htonl (pgm_txw_trail(sock->window));
+/* parameters */
+	pgm_return_val_if_fail (NULL != sock, PGM_IO_STATUS_ERROR);
+	if (PGM_LIKELY(len)) pgm_return_val_if_fail (NULL != buf, PGM_IO_STATUS_ERROR);
 
-/* OPT_LENGTH */
-		opt_len					= (struct pgm_opt_length*)(STATE(skb)->pgm_data + 1);
-		opt_len->opt_type			= PGM_OPT_LENGTH;
-		opt_len->opt_length			= sizeof(struct pgm_opt_length);
-		opt_len->opt_total_length		= pgm_htons ((uint16_t)(sizeof(struct pgm_opt_length) +
-									sizeof(struct pgm_opt_header) +
-									sizeof(struct pgm_opt_fragment)));
-/* OPT_FRAGMENT */
-		opt_header				= (struct pgm_opt_header*)(opt_len + 1);
-		opt_header->opt_type			= PGM_OPT_FRAGMENT | PGM_OPT_END;
-		opt_header->opt_length			= sizeof(struct pgm_opt_header) +
-						  	  sizeof(struct pgm_opt_fragment);
-		STATE(skb)->pgm_opt_fragment			= (struct pgm_opt_fragment*)(opt_header + 1);
-		STATE(skb)->pgm_opt_fragment->opt_reserved	= 0;
-		STATE(skb)->pgm_opt_fragment->opt_sqn		= pgm_htonl (STATE(first_sqn));
-		STATE(skb)->pgm_opt_fragment->opt_frag_off	= pgm_htonl ((uint32_t)STATE(data_bytes_offset));
-		STATE(skb)->pgm_opt_fragment->opt_frag_len	= pgm_htonl ((uint32_t)apdu_length);
+/* shutdown */
+	if (PGM_UNLIKELY(!pgm_sock_reader_trylock (sock)))
+		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
 
-/* TODO: the assembly checksum & copy routine is faster than memcpy & pgm_cksum on >= opteron hardware */
-		STATE(skb)->pgm_header->pgm_checksum	= 0;
-		const size_t   pgm_header_len		= (char*)(STATE(skb)->pgm_opt_fragment + 1) - (char*)STATE(skb)->pgm_header;
-		const uint32_t unfolded_header		= pgm_csum_partial (STATE(skb)->pgm_header, (uint16_t)pgm_header_len, 0);
-		STATE(unfolded_odata)			= pgm_csum_partial_copy ((const char*)apdu + STATE(data_bytes_offset), STATE(skb)->pgm_opt_fragment + 1, (uint16_t)STATE(tsdu_length), 0);
-		STATE(skb)->pgm_header->pgm_checksum	= pgm_csum_fold (pgm_csum_block_add (unfolded_header, STATE(unfolded_odata), (uint16_t)pgm_header_len));
+/* state */
+	if (PGM_UNLIKELY(sock->is_destroyed ||
+	    !STREAM(is_open) ||
+	    len > STREAM(apdu_length) - STREAM(offset) + (NULL != STREAM(skb) ? STREAM(tsdu_length) - STREAM(tsdu_offset) : 0)))
+	{
+		pgm_sock_reader_unlock (sock);
+		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
+	}
 
-/* add to transmit window, skb::data set to payload */
-		pgm_spinlock_lock (&sock->txw_spinlock);
-		pgm_txw_add (sock->window, STATE(skb));
-		pgm_spinlock_unlock (&sock->txw_spinlock);
+/* continue if blocked mid-apdu */
+	if (STREAM(is_eagain)) {
+		status = stream_send_fragment (sock);
+		if (PGM_IO_STATUS_NORMAL != status)
+			goto out;
+	}
 
-retry_send:
-		pgm_assert ((char*)STATE(skb)->tail > (char*)STATE(skb)->head);
-		tpdu_length = (char*)STATE(skb)->tail - (char*)STATE(skb)->head;
-		sent = pgm_sendto (sock,
-				   !STATE(is_rate_limited),	/* rate limit on blocking */
-			   	   &sock->odata_rate_control,
-				   FALSE,			/* regular socket */
-				   STATE(skb)->head,
-				   tpdu_length,
-				   (struct sockaddr*)&sock->send_gsr.gsr_group,
-				   pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
-		if (sent < 0) {
-			save_errno = pgm_get_last_sock_error();
-			if (PGM_LIKELY(PGM_SOCK_EAGAIN == save_errno || PGM_SOCK_ENOBUFS == save_errno))
-			{
-				sock->is_apdu_eagain = TRUE;
-				sock->blocklen = tpdu_length + sock->iphdr_len;
-				goto blocked;
-			}
-/* fall through silently on other errors */
+	while (count < len)
+	{
+		if (NULL == STREAM(skb))
+		{
+/* retrieve packet storage from transmit window */
+			const sa_family_t pgmcc_family = sock->use_pgmcc ? sock->family : 0;
+			const size_t header_length = pgm_pkt_offset (TRUE, pgmcc_family);
+			STREAM(tsdu_length) = (uint16_t)MIN( source_max_tsdu (sock, TRUE), STREAM(apdu_length) - STREAM(offset) );
+			STREAM(tsdu_offset) = 0;
+			STREAM(skb) = pgm_txw_alloc_skb (sock->window, sock->skb_pool, sock->max_tpdu);
+			STREAM(skb)->sock = sock;
+			pgm_skb_reserve (STREAM(skb), (uint16_t)header_length);
+			pgm_skb_put (STREAM(skb), STREAM(tsdu_length));
+			STREAM(offset) += STREAM(tsdu_length);
 		}
 
-/* save unfolded odata for retransmissions */
-		pgm_txw_set_unfolded_checksum (STATE(skb), STATE(unfolded_odata));
+/* copy behind the fragment header, continuing the payload checksum */
+		const uint16_t chunk = (uint16_t)MIN( len - count, (size_t)(STREAM(tsdu_length) - STREAM(tsdu_offset)) );
+		char* dst = (char*)STREAM(skb)->head + sock->odata_template[ PGM_ODATA_TEMPLATE_FRAGMENT ].header_length + STREAM(tsdu_offset);
+		if (0 == STREAM(tsdu_offset))
+			STREAM(unfolded_odata) = odata_csum_partial_copy_apdu (sock, src + count, dst, chunk, STREAM(apdu_length));
+		else
+			STREAM(unfolded_odata) = odata_csum_partial_copy_next (sock, src + count, dst, chunk, STREAM(apdu_length), STREAM(unfolded_odata), STREAM(tsdu_offset));
+		STREAM(tsdu_offset) += chunk;
+		count += chunk;
+
+		if (STREAM(tsdu_offset) < STREAM(tsdu_length))
+			break;
+		STREAM(skb)->tstamp = pgm_time_update_now();
+		status = stream_send_fragment (sock);
+		if (PGM_IO_STATUS_NORMAL != status)
+			break;
+	}
+
+out:
+	if (bytes_written)
+		*bytes_written = count;
+	pgm_sock_reader_unlock (sock);
+	return status;
+}
+
+/* Complete the APDU begun with pgm_send_begin() once every declared byte has
+ * been appended, releasing the source of the socket.
+ *
+ * on success, returns PGM_IO_STATUS_NORMAL with the APDU length saved into
+ * bytes_written.  on block for non-blocking sockets returns
+ * PGM_IO_STATUS_WOULD_BLOCK or PGM_IO_STATUS_RATE_LIMITED, the call is
+ * repeated.  returns PGM_IO_STATUS_ERROR with the APDU still open if bytes
+ * remain to be appended.
+ */
+
+int
+pgm_send_commit (
+	pgm_sock_t* 	 const restrict sock,
+	size_t*	       	       restrict	bytes_written
+	)
+{
+	pgm_debug ("pgm_send_commit (sock:%p bytes-written:%p)",
+		(void*)sock, (void*)bytes_written);
 
-		if (PGM_LIKELY((size_t)sent == tpdu_length)) {
-			bytes_sent += tpdu_length + sock->iphdr_len;	/* as counted at IP layer */
-			packets_sent++;					/* IP packets */
-			data_bytes_sent += STATE(tsdu_length);
-		}
+/* parameters */
+	pgm_return_val_if_fail (NULL != sock, PGM_IO_STATUS_ERROR);
 
-		STATE(data_bytes_offset) += STATE(tsdu_length);
+/* shutdown */
+	if (PGM_UNLIKELY(!pgm_sock_reader_trylock (sock)))
+		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
 
-/* check for end of transmission group */
-		if (sock->use_proactive_parity) {
-			const uint32_t odata_sqn = pgm_ntohl (STATE(skb)->pgm_data->data_sqn);
-			const uint32_t tg_sqn_mask = 0xffffffff << sock->tg_sqn_shift;
-			if (!((odata_sqn + 1) & ~tg_sqn_mask))
-				pgm_schedule_proactive_nak (sock, odata_sqn & tg_sqn_mask);
-		}
+/* state */
+	if (PGM_UNLIKELY(sock->is_destroyed ||
+	    !STREAM(is_open) ||
+	    STREAM(offset) < STREAM(apdu_length) ||
+	    (NULL != STREAM(skb) && STREAM(tsdu_offset) < STREAM(tsdu_length))))
+	{
+		pgm_sock_reader_unlock (sock);
+		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
+	}
 
-	} while ( STATE(data_bytes_offset)  < apdu_length);
-	pgm_assert( STATE(data_bytes_offset) == apdu_length );
+	if (STREAM(is_eagain)) {
+		const int status = stream_send_fragment (sock);
+		if (PGM_IO_STATUS_NORMAL != status) {
+			pgm_sock_reader_unlock (sock);
+			return status;
+		}
+	}
 
-/* success */
-	sock->is_apdu_eagain = FALSE;
-/* SPM heartbeats decay from last sent data packet */
-	reset_heartbeat_spm (sock, STATE(skb)->tstamp);
-/* increment socket statistics */
-	pgm_atomic_add32 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint32_t)bytes_sent);
-	sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  += packets_sent;
-	sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += data_bytes_sent;
+	pgm_assert (NULL == STREAM(skb));
+	STREAM(is_open) = FALSE;
 	if (bytes_written)
-		*bytes_written = apdu_length;
+		*bytes_written = STREAM(apdu_length);
+	pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+	pgm_sock_reader_unlock (sock);
 	return PGM_IO_STATUS_NORMAL;
-
-blocked:
-	if (bytes_sent) {
-		reset_heartbeat_spm (sock, STATE(skb)->tstamp);
-		pgm_atomic_add32 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint32_t)bytes_sent);
-		sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  += packets_sent;
-		sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += data_bytes_sent;
-	}
-	if (PGM_SOCK_ENOBUFS == save_errno)
-		return PGM_IO_STATUS_RATE_LIMITED;
-	if (sock->use_pgmcc)
-		pgm_notify_clear (&sock->ack_notify);
-	return PGM_IO_STATUS_WOULD_BLOCK;
 }
 
-/* Send one APDU, whether it fits within one TPDU or more.
+/* Send one APDU of a single TPDU without reliability: the packet is original
+ * data as any other but the transmit window holds the sequence number alone,
+ * NAKs for it are not repaired, and subsequent original data carries
+ * OPT_UNRELIABLE such that receivers declare the sequence lost on detecting
+ * the gap instead of sending NAKs.  Receivers missing every such packet fall
+ * back to NAKs which are confirmed but never repaired.
+ *
+ * APDUs larger than one TPDU, and sockets with FEC, are rejected with
+ * PGM_IO_STATUS_ERROR.  The APDU is neither coalesced nor compressed.
  *
  * on success, returns PGM_IO_STATUS_NORMAL, on block for non-blocking sockets
  * returns PGM_IO_STATUS_WOULD_BLOCK, returns PGM_IO_STATUS_RATE_LIMITED if
@@ -1796,14 +5160,14 @@ blocked:
  */
 
 int
-pgm_send (
+pgm_send_unreliable (
 	pgm_sock_t* 	 const restrict sock,
 	const void*	       restrict	apdu,
 	const size_t			apdu_length,
 	size_t*	       	       restrict	bytes_written
 	)
 {
-	pgm_debug ("pgm_send (sock:%p apdu:%p apdu-length:%" PRIzu " bytes-written:%p)",
+	pgm_debug ("pgm_send_unreliable (sock:%p apdu:%p apdu-length:%" PRIzu " bytes-written:%p)",
 		(void*)sock, apdu, apdu_length, (void*)bytes_written);
 
 /* parameters */
@@ -1811,36 +5175,48 @@ pgm_send (
 	if (PGM_LIKELY(apdu_length)) pgm_return_val_if_fail (NULL != apdu, PGM_IO_STATUS_ERROR);
 
 /* shutdown */
-	if (PGM_UNLIKELY(!pgm_rwlock_reader_trylock (&sock->lock)))
+	if (PGM_UNLIKELY(!pgm_sock_reader_trylock (sock)))
 		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
 
+	source_update_path_mtu (sock);
+
 /* state */
 	if (PGM_UNLIKELY(!sock->is_bound ||
 	    sock->is_destroyed ||
-	    apdu_length > sock->max_apdu))
+	    sock->is_standby ||
+	    sock->use_multi_producer ||
+	    0 != sock->async_len ||
+	    sock->use_proactive_parity ||
+	    sock->use_ondemand_parity ||
+	    apdu_length > sock->max_tsdu))
 	{
-		pgm_rwlock_reader_unlock (&sock->lock);
+		pgm_sock_reader_unlock (sock);
 		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
 	}
 
 /* source */
-	pgm_mutex_lock (&sock->source_mutex);
-
-/* pass on non-fragment calls */
-	if (apdu_length <= sock->max_tsdu)
-	{
-		const int status = send_odata_copy (sock, apdu, (uint16_t)apdu_length, bytes_written);
-		pgm_mutex_unlock (&sock->source_mutex);
-		pgm_rwlock_reader_unlock (&sock->lock);
-		return status;
-	}
-	else
-	{
-		const int status = send_apdu (sock, apdu, (uint16_t)apdu_length, bytes_written);
-		pgm_mutex_unlock (&sock->source_mutex);
-		pgm_rwlock_reader_unlock (&sock->lock);
-		return status;
+	pgm_sock_mutex_lock (sock, &sock->source_mutex);
+
+/* pending repairs ahead of new original data */
+	if (sock->use_tx_priority)
+		tx_sched_odata (sock, apdu_length);
+
+/* preserve order with APDUs already coalesced */
+	if (sock->coalesce_threshold) {
+		const int status = pgm_coalesce_flush (sock);
+		if (PGM_IO_STATUS_NORMAL != status) {
+			pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+			pgm_sock_reader_unlock (sock);
+			return status;
+		}
 	}
+
+	if (!sock->is_apdu_eagain)
+		STATE(is_unreliable) = TRUE;
+	const int status = send_odata_copy (sock, apdu, (uint16_t)apdu_length, FALSE, bytes_written);
+	pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+	pgm_sock_reader_unlock (sock);
+	return status;
 }
 
 /* send PGM original data, callee owned scatter/gather IO vector.  if larger than maximum TPDU
@@ -1887,23 +5263,46 @@ pgm_sendv (
 	pgm_return_val_if_fail (NULL != sock, PGM_IO_STATUS_ERROR);
 	pgm_return_val_if_fail (count <= PGM_MAX_FRAGMENTS, PGM_IO_STATUS_ERROR);
 	if (PGM_LIKELY(count)) pgm_return_val_if_fail (NULL != vector, PGM_IO_STATUS_ERROR);
-	if (PGM_UNLIKELY(!pgm_rwlock_reader_trylock (&sock->lock)))
+	if (PGM_UNLIKELY(!pgm_sock_reader_trylock (sock)))
 		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
+
+	source_update_path_mtu (sock);
 	if (PGM_UNLIKELY(!sock->is_bound ||
-	    sock->is_destroyed))
+	    sock->is_destroyed ||
+	    sock->is_standby ||
+	    sock->use_multi_producer ||
+	    0 != sock->async_len))
 	{
-		pgm_rwlock_reader_unlock (&sock->lock);
+		pgm_sock_reader_unlock (sock);
 		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
 	}
 
-	pgm_mutex_lock (&sock->source_mutex);
+	pgm_sock_mutex_lock (sock, &sock->source_mutex);
+
+/* pending repairs ahead of new original data */
+	if (sock->use_tx_priority) {
+		size_t apdu_length = 0;
+		for (unsigned i = 0; i < count; i++)
+			apdu_length += vector[i].iov_len;
+		tx_sched_odata (sock, apdu_length);
+	}
+
+/* preserve order with APDUs already coalesced */
+	if (sock->coalesce_threshold) {
+		const int flush_status = pgm_coalesce_flush (sock);
+		if (PGM_IO_STATUS_NORMAL != flush_status) {
+			pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+			pgm_sock_reader_unlock (sock);
+			return flush_status;
+		}
+	}
 
 /* pass on zero length as cannot count vector lengths */
 	if (PGM_UNLIKELY(0 == count))
 	{
-		const int status = send_odata_copy (sock, NULL, 0, bytes_written);
-		pgm_mutex_unlock (&sock->source_mutex);
-		pgm_rwlock_reader_unlock (&sock->lock);
+		const int status = send_odata_copy (sock, NULL, 0, FALSE, bytes_written);
+		pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+		pgm_sock_reader_unlock (sock);
 		return status;
 	}
 
@@ -1912,13 +5311,17 @@ pgm_sendv (
 /* continue if blocked mid-apdu */
 	if (sock->is_apdu_eagain) {
 		if (is_one_apdu) {
-			if (STATE(apdu_length) <= sock->max_tsdu)
+			if (sock->compress_accel && STATE(apdu_length) >= PGM_COMPRESS_MIN_APDU)
+				goto retry_one_apdu_compress;
+			else if (STATE(apdu_length) <= sock->max_tsdu)
 			{
 				const int status = send_odatav (sock, vector, count, bytes_written);
-				pgm_mutex_unlock (&sock->source_mutex);
-				pgm_rwlock_reader_unlock (&sock->lock);
+				pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+				pgm_sock_reader_unlock (sock);
 				return status;
 			}
+			else if (STATE(batch_len))
+				goto retry_one_apdu_batch;
 			else
 				goto retry_one_apdu_send;
 		} else {
@@ -1938,8 +5341,8 @@ pgm_sendv (
 		if (!is_one_apdu &&
 		    vector[i].iov_len > sock->max_apdu)
 		{
-			pgm_mutex_unlock (&sock->source_mutex);
-			pgm_rwlock_reader_unlock (&sock->lock);
+			pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+			pgm_sock_reader_unlock (sock);
 			pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
 		}
 		STATE(apdu_length) += vector[i].iov_len;
@@ -1947,15 +5350,32 @@ pgm_sendv (
 
 /* pass on non-fragment calls */
 	if (is_one_apdu) {
+		if (STATE(apdu_length) > sock->max_apdu) {
+			pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+			pgm_sock_reader_unlock (sock);
+			pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
+		}
+/* gathered into one contiguous APDU to compress */
+		if (sock->compress_accel && STATE(apdu_length) >= PGM_COMPRESS_MIN_APDU) {
+			size_t offset_ = 0;
+			for (unsigned i = 0; i < count; i++) {
+				if (PGM_LIKELY(vector[i].iov_len))
+					memcpy (sock->compress_gather + offset_, vector[i].iov_base, vector[i].iov_len);
+				offset_ += vector[i].iov_len;
+			}
+retry_one_apdu_compress:
+			{
+				const int status = send_apdu (sock, sock->compress_gather, STATE(apdu_length), bytes_written);
+				pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+				pgm_sock_reader_unlock (sock);
+				return status;
+			}
+		}
 		if (STATE(apdu_length) <= sock->max_tsdu) {
 			const int status = send_odatav (sock, vector, count, bytes_written);
-			pgm_mutex_unlock (&sock->source_mutex);
-			pgm_rwlock_reader_unlock (&sock->lock);
+			pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+			pgm_sock_reader_unlock (sock);
 			return status;
-		} else if (STATE(apdu_length) > sock->max_apdu) {
-			pgm_mutex_unlock (&sock->source_mutex);
-			pgm_rwlock_reader_unlock (&sock->lock);
-			pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
 		}
 	}
 
@@ -1977,12 +5397,12 @@ retry_send:
 			case PGM_IO_STATUS_WOULD_BLOCK:
 			case PGM_IO_STATUS_RATE_LIMITED:
 				sock->is_apdu_eagain = TRUE;
-				pgm_mutex_unlock (&sock->source_mutex);
-				pgm_rwlock_reader_unlock (&sock->lock);
+				pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+				pgm_sock_reader_unlock (sock);
 				return status;
 			case PGM_IO_STATUS_ERROR:
-				pgm_mutex_unlock (&sock->source_mutex);
-				pgm_rwlock_reader_unlock (&sock->lock);
+				pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+				pgm_sock_reader_unlock (sock);
 				return status;
 			default:
 				pgm_assert_not_reached();
@@ -1993,8 +5413,8 @@ retry_send:
 		sock->is_apdu_eagain = FALSE;
 		if (bytes_written)
 			*bytes_written = data_bytes_sent;
-		pgm_mutex_unlock (&sock->source_mutex);
-		pgm_rwlock_reader_unlock (&sock->lock);
+		pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+		pgm_sock_reader_unlock (sock);
 		return PGM_IO_STATUS_NORMAL;
 	}
 
@@ -2002,7 +5422,7 @@ retry_send:
 	STATE(is_rate_limited) = FALSE;
 	if (sock->is_nonblocking && sock->is_controlled_odata)
         {
-		const size_t header_length = pgm_pkt_offset (TRUE, pgmcc_family);
+		const size_t header_length = pgm_pkt_offset (TRUE, pgmcc_family) + pgm_data_trailer_len (sock);
                 size_t tpdu_length = 0;
 		size_t offset_	   = 0;
 
@@ -2017,9 +5437,9 @@ retry_send:
 				      tpdu_length - sock->iphdr_len,	/* includes 1 × IP header len */
 				      sock->is_nonblocking))
 		{
-			sock->blocklen = tpdu_length;
-			pgm_mutex_unlock (&sock->source_mutex);
-			pgm_rwlock_reader_unlock (&sock->lock);
+			odata_rate_limited (sock, tpdu_length);
+			pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+			pgm_sock_reader_unlock (sock);
 			return PGM_IO_STATUS_RATE_LIMITED;
 		}
 		STATE(is_rate_limited) = TRUE;
@@ -2033,8 +5453,6 @@ retry_send:
 
 	do {
 		size_t			 tpdu_length, header_length;
-		struct pgm_opt_header	*opt_header;
-		struct pgm_opt_length	*opt_len;
 		const char		*src;
 		char			*dst;
 		size_t			 src_length, dst_length, copy_length;
@@ -2043,47 +5461,23 @@ retry_send:
 /* retrieve packet storage from transmit window */
 		header_length = pgm_pkt_offset (TRUE, pgmcc_family);
 		STATE(tsdu_length) = MIN( source_max_tsdu (sock, TRUE), STATE(apdu_length) - STATE(data_bytes_offset) );
-		STATE(skb) = pgm_alloc_skb (sock->max_tpdu);
+		STATE(skb) = pgm_txw_alloc_skb (sock->window, sock->skb_pool, sock->max_tpdu);
 		STATE(skb)->sock = sock;
 		STATE(skb)->tstamp = pgm_time_update_now();
 		pgm_skb_reserve (STATE(skb), (uint16_t)header_length);
 		pgm_skb_put (STATE(skb), (uint16_t)STATE(tsdu_length));
 
-		STATE(skb)->pgm_header  = (struct pgm_header*)STATE(skb)->head;
-		STATE(skb)->pgm_data    = (struct pgm_data*)(STATE(skb)->pgm_header + 1);
-		memcpy (STATE(skb)->pgm_header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t));
-		STATE(skb)->pgm_header->pgm_sport	= sock->tsi.sport;
-		STATE(skb)->pgm_header->pgm_dport	= sock->dport;
-		STATE(skb)->pgm_header->pgm_type	= PGM_ODATA;
-		STATE(skb)->pgm_header->pgm_options	= PGM_OPT_PRESENT;
-		STATE(skb)->pgm_header->pgm_tsdu_length = pgm_htons ((uint16_t)STATE(tsdu_length));
-
-/* ODATA */
-		STATE(skb)->pgm_data->data_sqn		= pgm_htonl (pgm_txw_next_lead(sock->window));
-		STATE(skb)->pgm_data->data_trail	= pgm_htonl (pgm_txw_trail(sock->window));
-
-/* OPT_LENGTH */
-		opt_len					= (struct pgm_opt_length*)(STATE(skb)->pgm_data + 1);
-		opt_len->opt_type			= PGM_OPT_LENGTH;
-		opt_len->opt_length			= sizeof(struct pgm_opt_length);
-		opt_len->opt_total_length		= pgm_htons ((uint16_t)(sizeof(struct pgm_opt_length) +
-									sizeof(struct pgm_opt_header) +
-									sizeof(struct pgm_opt_fragment)));
-/* OPT_FRAGMENT */
-		opt_header				= (struct pgm_opt_header*)(opt_len + 1);
-		opt_header->opt_type			= PGM_OPT_FRAGMENT | PGM_OPT_END;
-		opt_header->opt_length			= sizeof(struct pgm_opt_header) +
-							  sizeof(struct pgm_opt_fragment);
-		STATE(skb)->pgm_opt_fragment			= (struct pgm_opt_fragment*)(opt_header + 1);
-		STATE(skb)->pgm_opt_fragment->opt_reserved	= 0;
-		STATE(skb)->pgm_opt_fragment->opt_sqn		= pgm_htonl (STATE(first_sqn));
-		STATE(skb)->pgm_opt_fragment->opt_frag_off	= pgm_htonl ((uint32_t)STATE(data_bytes_offset));
-		STATE(skb)->pgm_opt_fragment->opt_frag_len	= pgm_htonl ((uint32_t)STATE(apdu_length));
+/* ODATA with OPT_FRAGMENT from the socket template */
+		const uint32_t unfolded_header		= odata_template_stamp_fragment (sock,
+											 STATE(skb),
+											 (uint16_t)STATE(tsdu_length),
+											 pgm_txw_next_lead (sock->window),
+											 STATE(first_sqn),
+											 (uint32_t)STATE(data_bytes_offset),
+											 (uint32_t)STATE(apdu_length),
+											 0);
 
 /* checksum & copy */
-		STATE(skb)->pgm_header->pgm_checksum	= 0;
-		const size_t   pgm_header_len		= (char*)(STATE(skb)->pgm_opt_fragment + 1) - (char*)STATE(skb)->pgm_header;
-		const uint32_t unfolded_header		= pgm_csum_partial (STATE(skb)->pgm_header, (uint16_t)pgm_header_len, 0);
 
 /* iterate over one or more vector elements to perform scatter/gather checksum & copy
  *
@@ -2096,7 +5490,7 @@ retry_send:
 		src_length	= vector[STATE(vector_index)].iov_len - STATE(vector_offset);
 		dst_length	= 0;
 		copy_length	= MIN( STATE(tsdu_length), src_length );
-		STATE(unfolded_odata)	= pgm_csum_partial_copy (src, dst, (uint16_t)copy_length, 0);
+		STATE(unfolded_odata)	= odata_csum_partial_copy_apdu (sock, src, dst, (uint16_t)copy_length, STATE(apdu_length));
 
 		for(;;)
 		{
@@ -2119,27 +5513,39 @@ retry_send:
 			dst	       += copy_length;
 			src_length	= vector[STATE(vector_index)].iov_len - STATE(vector_offset);
 			copy_length	= MIN( STATE(tsdu_length) - dst_length, src_length );
-			const uint32_t unfolded_element = pgm_csum_partial_copy (src, dst, (uint16_t)copy_length, 0);
-			STATE(unfolded_odata) = pgm_csum_block_add (STATE(unfolded_odata), unfolded_element, (uint16_t)dst_length);
+			STATE(unfolded_odata) = odata_csum_partial_copy_next (sock, src, dst, (uint16_t)copy_length, STATE(apdu_length), STATE(unfolded_odata), (uint16_t)dst_length);
 		}
 
-		STATE(skb)->pgm_header->pgm_checksum = pgm_csum_fold (pgm_csum_block_add (unfolded_header, STATE(unfolded_odata), (uint16_t)pgm_header_len));
+		STATE(skb)->pgm_header->pgm_checksum = data_csum_fold_unfolded (sock, STATE(skb), unfolded_header, sock->odata_template[ PGM_ODATA_TEMPLATE_FRAGMENT ].header_length, STATE(unfolded_odata));
 
 /* add to transmit window, skb::data set to payload */
-		pgm_spinlock_lock (&sock->txw_spinlock);
 		pgm_txw_add (sock->window, STATE(skb));
-		pgm_spinlock_unlock (&sock->txw_spinlock);
+
+/* defer transmit until batch is full or APDU complete */
+		if (sock->tx_batch) {
+			pgm_txw_set_unfolded_checksum (STATE(skb), STATE(unfolded_odata));
+			sock->tx_batch[STATE(batch_len)++] = pgm_skb_get (STATE(skb));
+			STATE(data_bytes_offset) += STATE(tsdu_length);
+			if (STATE(batch_len) < sock->tx_batch_size &&
+			    STATE(data_bytes_offset) < STATE(apdu_length))
+				continue;
+retry_one_apdu_batch:
+			if (!send_odata_batch (sock, !STATE(is_rate_limited), &bytes_sent, &packets_sent, &data_bytes_sent)) {
+				save_errno = pgm_get_last_sock_error();
+				sock->is_apdu_eagain = TRUE;
+				goto blocked;
+			}
+			continue;
+		}
 
 retry_one_apdu_send:
 		tpdu_length = (char*)STATE(skb)->tail - (char*)STATE(skb)->head;
-		sent = pgm_sendto (sock,
+		sent = pgm_sendskb (sock,
 				   !STATE(is_rate_limited),	/* rate limited on blocking */
-			   	   &sock->odata_rate_control,
-				   FALSE,			/* regular socket */
-				   STATE(skb)->head,
-				   tpdu_length,
-				   (struct sockaddr*)&sock->send_gsr.gsr_group,
-				   pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
+				   &sock->odata_rate_control,
+				   STATE(skb),
+				   odata_group (sock, STATE(skb)),
+				   pgm_sockaddr_len (odata_group (sock, STATE(skb))));
 		if (sent < 0) {
 			save_errno = pgm_get_last_sock_error();
 			if (PGM_LIKELY(PGM_SOCK_EAGAIN == save_errno || PGM_SOCK_ENOBUFS == save_errno))
@@ -2163,12 +5569,8 @@ retry_one_apdu_send:
 		STATE(data_bytes_offset) += STATE(tsdu_length);
 
 /* check for end of transmission group */
-		if (sock->use_proactive_parity) {
-			const uint32_t odata_sqn = pgm_ntohl (STATE(skb)->pgm_data->data_sqn);
-			const uint32_t tg_sqn_mask = 0xffffffff << sock->tg_sqn_shift;
-			if (!((odata_sqn + 1) & ~tg_sqn_mask))
-				pgm_schedule_proactive_nak (sock, odata_sqn & tg_sqn_mask);
-		}
+		if (sock->use_proactive_parity)
+			source_odata_sent (sock, STATE(skb));
 
 	} while ( STATE(data_bytes_offset)  < STATE(apdu_length) );
 	pgm_assert( STATE(data_bytes_offset) == STATE(apdu_length) );
@@ -2178,24 +5580,24 @@ retry_one_apdu_send:
 /* SPM heartbeats decay from last sent data packet */
 	reset_heartbeat_spm (sock, STATE(skb)->tstamp);
 /* increment socket statistics */
-	pgm_atomic_add32 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint32_t)bytes_sent);
+	pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)bytes_sent);
 	sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  += packets_sent;
 	sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += data_bytes_sent;
 	if (bytes_written)
 		*bytes_written = STATE(apdu_length);
-	pgm_mutex_unlock (&sock->source_mutex);
-	pgm_rwlock_reader_unlock (&sock->lock);
+	pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+	pgm_sock_reader_unlock (sock);
 	return PGM_IO_STATUS_NORMAL;
 
 blocked:
 	if (bytes_sent) {
 		reset_heartbeat_spm (sock, STATE(skb)->tstamp);
-		pgm_atomic_add32 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint32_t)bytes_sent);
+		pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)bytes_sent);
 		sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  += packets_sent;
 		sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += data_bytes_sent;
 	}
-	pgm_mutex_unlock (&sock->source_mutex);
-	pgm_rwlock_reader_unlock (&sock->lock);
+	pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+	pgm_sock_reader_unlock (sock);
 	if (PGM_SOCK_ENOBUFS == save_errno)
 		return PGM_IO_STATUS_RATE_LIMITED;
 	if (sock->use_pgmcc)
@@ -2203,6 +5605,197 @@ blocked:
 	return PGM_IO_STATUS_WOULD_BLOCK;
 }
 
+/* send many APDUs taking the socket locks once.  runs of APDUs that fit one
+ * TPDU are added to the transmit window as consecutive sequences and sent
+ * together through the transmit batch, with one rate limit check per run.
+ * larger APDUs are fragmented as by pgm_send().
+ *
+ *    ⎢ APDU₀ ⎢
+ *    ⎢ APDU₁ ⎢ → pgm_send_batch() →  ⎢ ⋯ TSDU₁ TSDU₀ ⎢ → libc
+ *    ⎢   ⋮   ⎢
+ *
+ * on success, returns PGM_IO_STATUS_NORMAL, on block for non-blocking sockets
+ * returns PGM_IO_STATUS_WOULD_BLOCK, returns PGM_IO_STATUS_RATE_LIMITED if
+ * packet size exceeds the current rate limit.  after a block call again with
+ * the same vector, APDUs already in the transmit window are not sent again.
+ */
+
+int
+pgm_send_batch (
+	pgm_sock_t*		const restrict sock,
+	const struct pgm_iovec* const restrict apdus,
+	const unsigned			       count,		/* number of APDUs in vector */
+	size_t*			      restrict bytes_written
+	)
+{
+	unsigned	packets_sent = 0;
+	size_t		bytes_sent = 0;
+	size_t		data_bytes_sent = 0;
+	size_t		apdu_bytes_sent = 0;
+	int		status;
+
+	pgm_debug ("pgm_send_batch (sock:%p apdus:%p count:%u bytes-written:%p)",
+		(const void*)sock,
+		(const void*)apdus,
+		count,
+		(const void*)bytes_written);
+
+	pgm_return_val_if_fail (NULL != sock, PGM_IO_STATUS_ERROR);
+	if (PGM_LIKELY(count)) pgm_return_val_if_fail (NULL != apdus, PGM_IO_STATUS_ERROR);
+	if (PGM_UNLIKELY(!pgm_sock_reader_trylock (sock)))
+		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
+
+	source_update_path_mtu (sock);
+	if (PGM_UNLIKELY(!sock->is_bound ||
+	    sock->is_destroyed ||
+	    sock->is_standby ||
+	    sock->use_multi_producer ||
+	    0 != sock->async_len))
+	{
+		pgm_sock_reader_unlock (sock);
+		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
+	}
+
+	pgm_sock_mutex_lock (sock, &sock->source_mutex);
+
+/* pending repairs ahead of new original data */
+	if (sock->use_tx_priority) {
+		size_t apdu_length = 0;
+		for (unsigned i = 0; i < count; i++)
+			apdu_length += apdus[i].iov_len;
+		tx_sched_odata (sock, apdu_length);
+	}
+
+/* preserve order with APDUs already coalesced */
+	if (sock->coalesce_threshold) {
+		const int flush_status = pgm_coalesce_flush (sock);
+		if (PGM_IO_STATUS_NORMAL != flush_status) {
+			pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+			pgm_sock_reader_unlock (sock);
+			return flush_status;
+		}
+	}
+
+	const sa_family_t pgmcc_family = sock->use_pgmcc ? sock->family : 0;
+/* congestion control takes a token per packet */
+	const bool use_batch = (NULL != sock->tx_batch && !sock->use_pgmcc);
+/* non-blocking sockets check the rate limit for a whole run before adding it to the window */
+	const bool use_rate_check = (sock->is_nonblocking && sock->is_controlled_odata);
+
+/* continue if blocked mid-batch */
+	if (STATE(is_batch_eagain)) {
+		if (use_batch &&
+		    sock->is_apdu_eagain &&
+		    STATE(batch_len) &&
+		    apdus[STATE(data_pkt_offset)].iov_len <= sock->max_tsdu)
+			goto retry_batch;
+		goto retry_send;
+	}
+
+	for (unsigned i = 0; i < count; i++)
+	{
+#ifdef TRANSPORT_DEBUG
+		if (PGM_LIKELY(apdus[i].iov_len)) {
+			pgm_assert( apdus[i].iov_base );
+		}
+#endif
+		if (PGM_UNLIKELY(apdus[i].iov_len > sock->max_apdu))
+		{
+			pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+			pgm_sock_reader_unlock (sock);
+			pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
+		}
+	}
+
+	STATE(data_pkt_offset) = 0;
+retry_send:
+	while (STATE(data_pkt_offset) < count)
+	{
+		const struct pgm_iovec* apdu = &apdus[STATE(data_pkt_offset)];
+
+/* fragmented APDUs and a socket without a transmit batch */
+		if (!use_batch || apdu->iov_len > sock->max_tsdu)
+		{
+			size_t wrote_bytes;
+			status = (apdu->iov_len <= sock->max_tsdu) ?
+				send_odata_copy (sock, apdu->iov_base, (uint16_t)apdu->iov_len, FALSE, &wrote_bytes) :
+				send_apdu (sock, apdu->iov_base, apdu->iov_len, &wrote_bytes);
+			if (PGM_IO_STATUS_NORMAL != status)
+				goto blocked;
+			apdu_bytes_sent += wrote_bytes;
+			STATE(data_pkt_offset)++;
+			continue;
+		}
+
+/* run of single TPDU APDUs up to the batch size */
+		size_t tpdu_length = 0;
+		STATE(vector_index) = (unsigned)STATE(data_pkt_offset);
+		do {
+			tpdu_length += sock->iphdr_len + pgm_pkt_offset (FALSE, pgmcc_family) + pgm_data_trailer_len (sock) + apdus[STATE(vector_index)].iov_len;
+			STATE(vector_index)++;
+		} while (STATE(vector_index) < count &&
+			 STATE(vector_index) - STATE(data_pkt_offset) < sock->tx_batch_size &&
+			 apdus[STATE(vector_index)].iov_len <= sock->max_tsdu);
+
+		if (use_rate_check &&
+		    !pgm_rate_check2 (&sock->rate_control,
+				      &sock->odata_rate_control,
+				      tpdu_length - sock->iphdr_len,	/* includes 1 × IP header len */
+				      sock->is_nonblocking))
+		{
+			odata_rate_limited (sock, tpdu_length);
+			status = PGM_IO_STATUS_RATE_LIMITED;
+			goto blocked;
+		}
+
+		for (size_t i = STATE(data_pkt_offset); i < STATE(vector_index); i++)
+		{
+			STATE(skb) = build_odata_copy (sock, apdus[i].iov_base, (uint16_t)apdus[i].iov_len, FALSE, &STATE(unfolded_odata));
+			pgm_txw_set_unfolded_checksum (STATE(skb), STATE(unfolded_odata));
+			sock->tx_batch[STATE(batch_len)++] = pgm_skb_get (STATE(skb));
+		}
+
+retry_batch:
+		if (!send_odata_batch (sock, !use_rate_check, &bytes_sent, &packets_sent, &data_bytes_sent)) {
+			const int save_errno = pgm_get_last_sock_error();
+			sock->is_apdu_eagain = TRUE;
+			status = (PGM_SOCK_ENOBUFS == save_errno) ? PGM_IO_STATUS_RATE_LIMITED : PGM_IO_STATUS_WOULD_BLOCK;
+			goto blocked;
+		}
+		sock->is_apdu_eagain = FALSE;
+		for (; STATE(data_pkt_offset) < STATE(vector_index); STATE(data_pkt_offset)++)
+			apdu_bytes_sent += apdus[STATE(data_pkt_offset)].iov_len;
+	}
+
+/* success */
+	STATE(is_batch_eagain) = FALSE;
+	sock->is_apdu_eagain = FALSE;
+	if (bytes_sent) {
+/* SPM heartbeats decay from last sent data packet */
+		reset_heartbeat_spm (sock, STATE(skb)->tstamp);
+		pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)bytes_sent);
+		sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  += packets_sent;
+		sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += data_bytes_sent;
+	}
+	if (bytes_written)
+		*bytes_written = apdu_bytes_sent;
+	pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+	pgm_sock_reader_unlock (sock);
+	return PGM_IO_STATUS_NORMAL;
+
+blocked:
+	STATE(is_batch_eagain) = TRUE;
+	if (bytes_sent) {
+		reset_heartbeat_spm (sock, STATE(skb)->tstamp);
+		pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)bytes_sent);
+		sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  += packets_sent;
+		sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += data_bytes_sent;
+	}
+	pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+	pgm_sock_reader_unlock (sock);
+	return status;
+}
+
 /* send PGM original data, transmit window owned scatter/gather IO vector.
  *
  *    ⎢ TSDU₀ ⎢
@@ -2238,30 +5831,53 @@ pgm_send_skbv (
 	pgm_return_val_if_fail (NULL != sock, PGM_IO_STATUS_ERROR);
 	pgm_return_val_if_fail (count <= PGM_MAX_FRAGMENTS, PGM_IO_STATUS_ERROR);
 	if (PGM_LIKELY(count)) pgm_return_val_if_fail (NULL != vector, PGM_IO_STATUS_ERROR);
-	if (PGM_UNLIKELY(!pgm_rwlock_reader_trylock (&sock->lock)))
+	if (PGM_UNLIKELY(!pgm_sock_reader_trylock (sock)))
 		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
+
+	source_update_path_mtu (sock);
 	if (PGM_UNLIKELY(!sock->is_bound ||
-	    sock->is_destroyed))
+	    sock->is_destroyed ||
+	    sock->is_standby ||
+	    sock->use_multi_producer ||
+	    0 != sock->async_len))
 	{
-		pgm_rwlock_reader_unlock (&sock->lock);
+		pgm_sock_reader_unlock (sock);
 		pgm_return_val_if_reached (PGM_IO_STATUS_ERROR);
 	}
 
-	pgm_mutex_lock (&sock->source_mutex);
+	pgm_sock_mutex_lock (sock, &sock->source_mutex);
+
+/* pending repairs ahead of new original data */
+	if (sock->use_tx_priority) {
+		size_t apdu_length = 0;
+		for (unsigned i = 0; i < count; i++)
+			apdu_length += vector[i]->len;
+		tx_sched_odata (sock, apdu_length);
+	}
+
+/* preserve order with APDUs already coalesced */
+	if (sock->coalesce_threshold) {
+		const int flush_status = pgm_coalesce_flush (sock);
+		if (PGM_IO_STATUS_NORMAL != flush_status) {
+			pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+			pgm_sock_reader_unlock (sock);
+			return flush_status;
+		}
+	}
 
 /* pass on zero length as cannot count vector lengths */
 	if (PGM_UNLIKELY(0 == count))
 	{
-		const int status = send_odata_copy (sock, NULL, 0, bytes_written);
-		pgm_mutex_unlock (&sock->source_mutex);
-		pgm_rwlock_reader_unlock (&sock->lock);
+		const int status = send_odata_copy (sock, NULL, 0, FALSE, bytes_written);
+		pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+		pgm_sock_reader_unlock (sock);
 		return status;
 	}
 	else if (1 == count)
 	{
 		const int status = send_odata (sock, vector[0], bytes_written);
-		pgm_mutex_unlock (&sock->source_mutex);
-		pgm_rwlock_reader_unlock (&sock->lock);
+		pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+		pgm_sock_reader_unlock (sock);
 		return status;
 	}
 
@@ -2277,16 +5893,16 @@ pgm_send_skbv (
 		size_t total_tpdu_length = 0;
 
 		for (unsigned i = 0; i < count; i++)
-			total_tpdu_length += sock->iphdr_len + pgm_pkt_offset (is_one_apdu, pgmcc_family) + vector[i]->len;
+			total_tpdu_length += sock->iphdr_len + pgm_pkt_offset (is_one_apdu, pgmcc_family) + pgm_data_trailer_len (sock) + vector[i]->len;
 
 		if (!pgm_rate_check2 (&sock->rate_control,
 				      &sock->odata_rate_control,
 				      total_tpdu_length - sock->iphdr_len,	/* includes 1 × IP header len */
 				      sock->is_nonblocking))
 		{
-			sock->blocklen = total_tpdu_length;
-			pgm_mutex_unlock (&sock->source_mutex);
-			pgm_rwlock_reader_unlock (&sock->lock);
+			odata_rate_limited (sock, total_tpdu_length);
+			pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+			pgm_sock_reader_unlock (sock);
 			return PGM_IO_STATUS_RATE_LIMITED;
 		}
 		STATE(is_rate_limited) = TRUE;
@@ -2299,15 +5915,15 @@ pgm_send_skbv (
 		for (unsigned i = 0; i < count; i++)
 		{
 			if (PGM_UNLIKELY(vector[i]->len > sock->max_tsdu_fragment)) {
-				pgm_mutex_unlock (&sock->source_mutex);
-				pgm_rwlock_reader_unlock (&sock->lock);
+				pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+				pgm_sock_reader_unlock (sock);
 				return PGM_IO_STATUS_ERROR;
 			}
 			STATE(apdu_length) += vector[i]->len;
 		}
 		if (PGM_UNLIKELY(STATE(apdu_length) > sock->max_apdu)) {
-			pgm_mutex_unlock (&sock->source_mutex);
-			pgm_rwlock_reader_unlock (&sock->lock);
+			pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+			pgm_sock_reader_unlock (sock);
 			return PGM_IO_STATUS_ERROR;
 		}
 	}
@@ -2334,7 +5950,7 @@ pgm_send_skbv (
 
 /* ODATA */
 		STATE(skb)->pgm_data->data_sqn		= pgm_htonl (pgm_txw_next_lead(sock->window));
-		STATE(skb)->pgm_data->data_trail	= pgm_htonl (pgm_txw_trail(sock->window));
+		STATE(skb)->pgm_data->data_trail	= pgm_htonl (source_trail (sock));
 
 		if (is_one_apdu)
 		{
@@ -2370,25 +5986,20 @@ pgm_send_skbv (
 		STATE(skb)->pgm_header->pgm_checksum	= 0;
 		pgm_assert ((char*)STATE(skb)->data > (char*)STATE(skb)->pgm_header);
 		const size_t header_length		= (char*)STATE(skb)->data - (char*)STATE(skb)->pgm_header;
-		const uint32_t unfolded_header		= pgm_csum_partial (STATE(skb)->pgm_header, (uint16_t)header_length, 0);
-		STATE(unfolded_odata)			= pgm_csum_partial ((char*)STATE(skb)->data, (uint16_t)STATE(tsdu_length), 0);
-		STATE(skb)->pgm_header->pgm_checksum	= pgm_csum_fold (pgm_csum_block_add (unfolded_header, STATE(unfolded_odata), (uint16_t)header_length));
+		STATE(unfolded_odata)			= odata_csum_partial (sock, (char*)STATE(skb)->data, (uint16_t)STATE(tsdu_length));
+		STATE(skb)->pgm_header->pgm_checksum	= data_csum_fold (sock, STATE(skb), (uint16_t)header_length, STATE(unfolded_odata));
 
 /* add to transmit window, skb::data set to payload */
-		pgm_spinlock_lock (&sock->txw_spinlock);
 		pgm_txw_add (sock->window, STATE(skb));
-		pgm_spinlock_unlock (&sock->txw_spinlock);
 retry_send:
 		pgm_assert ((char*)STATE(skb)->tail > (char*)STATE(skb)->head);
 		tpdu_length = (char*)STATE(skb)->tail - (char*)STATE(skb)->head;
-		sent = pgm_sendto (sock,
+		sent = pgm_sendskb (sock,
 				   !STATE(is_rate_limited),	/* rate limited on blocking */
-			   	   &sock->odata_rate_control,
-				   FALSE,			/* regular socket */
-				   STATE(skb)->head,
-				   tpdu_length,
-				   (struct sockaddr*)&sock->send_gsr.gsr_group,
-				   pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
+				   &sock->odata_rate_control,
+				   STATE(skb),
+				   odata_group (sock, STATE(skb)),
+				   pgm_sockaddr_len (odata_group (sock, STATE(skb))));
 		if (sent < 0) {
 			save_errno = pgm_get_last_sock_error();
 			if (PGM_LIKELY(PGM_SOCK_EAGAIN == save_errno || PGM_SOCK_ENOBUFS == save_errno))
@@ -2413,12 +6024,8 @@ retry_send:
 		STATE(data_bytes_offset) += STATE(tsdu_length);
 
 /* check for end of transmission group */
-		if (sock->use_proactive_parity) {
-			const uint32_t odata_sqn   = pgm_ntohl (STATE(skb)->pgm_data->data_sqn);
-			const uint32_t tg_sqn_mask = 0xffffffff << sock->tg_sqn_shift;
-			if (!((odata_sqn + 1) & ~tg_sqn_mask))
-				pgm_schedule_proactive_nak (sock, odata_sqn & tg_sqn_mask);
-		}
+		if (sock->use_proactive_parity)
+			source_odata_sent (sock, STATE(skb));
 
 	}
 #ifdef TRANSPORT_DEBUG
@@ -2433,24 +6040,24 @@ retry_send:
 /* SPM heartbeats decay from last sent data packet */
 	reset_heartbeat_spm (sock, STATE(skb)->tstamp);
 /* increment socket statistics */
-	pgm_atomic_add32 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint32_t)bytes_sent);
+	pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)bytes_sent);
 	sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  += packets_sent;
 	sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += data_bytes_sent;
 	if (bytes_written)
 		*bytes_written = data_bytes_sent;
-	pgm_mutex_unlock (&sock->source_mutex);
-	pgm_rwlock_reader_unlock (&sock->lock);
+	pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+	pgm_sock_reader_unlock (sock);
 	return PGM_IO_STATUS_NORMAL;
 
 blocked:
 	if (bytes_sent) {
 		reset_heartbeat_spm (sock, STATE(skb)->tstamp);
-		pgm_atomic_add32 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint32_t)bytes_sent);
+		pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)bytes_sent);
 		sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]  += packets_sent;
 		sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT] += data_bytes_sent;
 	}
-	pgm_mutex_unlock (&sock->source_mutex);
-	pgm_rwlock_reader_unlock (&sock->lock);
+	pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+	pgm_sock_reader_unlock (sock);
 	if (PGM_SOCK_ENOBUFS == save_errno)
 		return PGM_IO_STATUS_RATE_LIMITED;
 	if (sock->use_pgmcc)
@@ -2462,6 +6069,26 @@ blocked:
  */
 #undef STATE
 
+/* record how far behind the lead a sequence served by RDATA was.
+ */
+
+static inline
+void
+rdata_age_add (
+	pgm_sock_t* const	sock,
+	const uint32_t		sequence
+	)
+{
+	const uint32_t age = pgm_txw_lead_atomic (sock->window) - sequence;
+	unsigned bucket = 0;
+
+	for (uint32_t t = age; t && bucket < PGM_RDATA_AGE_BUCKETS - 1; t >>= 1)
+		bucket++;
+	sock->rdata_age_hist[ bucket ]++;
+	if (age > sock->max_rdata_age)
+		sock->max_rdata_age = age;
+}
+
 /* send repair packet.
  *
  * on success, TRUE is returned.  on error, FALSE is returned.
@@ -2471,7 +6098,8 @@ static
 bool
 send_rdata (
 	pgm_sock_t*	      restrict sock,
-	struct pgm_sk_buff_t* restrict skb
+	struct pgm_sk_buff_t* restrict skb,
+	const bool		       is_nonblocking
 	)
 {
 	size_t			 tpdu_length;
@@ -2486,12 +6114,18 @@ send_rdata (
 
 	tpdu_length = (char*)skb->tail - (char*)skb->head;
 
+/* original data still read by the kernel cannot be rewritten as repair data */
+	if (PGM_UNLIKELY(pgm_zerocopy_is_pinned (sock, skb))) {
+		sock->blocklen = tpdu_length + sock->iphdr_len;
+		return FALSE;
+	}
+
 /* rate check including rdata specific limits */
 	if (sock->is_controlled_rdata &&
 	    !pgm_rate_check2 (&sock->rate_control,		/* total rate limit */
 			      &sock->rdata_rate_control,	/* repair data limit */
 			      tpdu_length,			/* excludes IP header len */
-			      sock->is_nonblocking))
+			      is_nonblocking))
 	{
 		sock->blocklen = tpdu_length + sock->iphdr_len;
 		return FALSE;
@@ -2502,13 +6136,12 @@ send_rdata (
 	rdata				= skb->pgm_data;
 	header->pgm_type		= PGM_RDATA;
 /* RDATA */
-        rdata->data_trail		= pgm_htonl (pgm_txw_trail(sock->window));
+        rdata->data_trail		= pgm_htonl (source_trail (sock));
 
         header->pgm_checksum		= 0;
-	const size_t header_length	= tpdu_length - pgm_ntohs(header->pgm_tsdu_length);
-	const uint32_t unfolded_header	= pgm_csum_partial (header, (uint16_t)header_length, 0);
+	const size_t header_length	= tpdu_length - pgm_ntohs(header->pgm_tsdu_length) - (skb->crc32c ? sizeof(uint32_t) : 0);
 	const uint32_t unfolded_odata	= pgm_txw_get_unfolded_checksum (skb);
-	header->pgm_checksum		= pgm_csum_fold (pgm_csum_block_add (unfolded_header, unfolded_odata, (uint16_t)header_length));
+	header->pgm_checksum		= data_csum_fold (sock, skb, (uint16_t)header_length, unfolded_odata);
 
 /* congestion control */
 	if (sock->use_pgmcc &&
@@ -2516,6 +6149,7 @@ send_rdata (
 	{
 //		pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("Token limit reached."));
 		sock->blocklen = tpdu_length + sock->iphdr_len;
+		congestion_stall_begin (sock);
 		return FALSE;
 	}
 
@@ -2540,22 +6174,153 @@ send_rdata (
 	const pgm_time_t now = pgm_time_update_now();
 
 	if (sock->use_pgmcc) {
-		sock->tokens -= pgm_fp8 (1);
+		if (!sock->use_tfmcc)
+			sock->tokens -= pgm_fp8 (1);
+		congestion_stall_end (sock);
 		sock->ack_expiry = now + sock->ack_expiry_ivl;
 	}
 
 /* re-set spm timer: we are already in the timer thread, no need to prod timers
  */
-	pgm_mutex_lock (&sock->timer_mutex);
+	pgm_sock_mutex_lock (sock, &sock->timer_mutex);
 	sock->spm_heartbeat_state = 1;
 	sock->next_heartbeat_spm = now + sock->spm_heartbeat_interval[sock->spm_heartbeat_state++];
-	pgm_mutex_unlock (&sock->timer_mutex);
+	pgm_sock_mutex_unlock (sock, &sock->timer_mutex);
 
+	if (sock->use_tx_priority)
+		tx_sched_credit (sock, -(int32_t)pgm_ntohs(header->pgm_tsdu_length));
+	PGM_PROBE3 (rdata_send, sock, pgm_ntohl (rdata->data_sqn), tpdu_length);
+	pgm_flightrec_add (sock->flightrec, PGM_FLIGHTREC_RDATA_SEND, 0, sock->tsi.sport, pgm_ntohl (rdata->data_sqn), tpdu_length);
 	pgm_txw_inc_retransmit_count (skb);
+	rdata_age_add (sock, skb->sequence);
 	sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_BYTES_RETRANSMITTED] += pgm_ntohs(header->pgm_tsdu_length);
 	sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_MSGS_RETRANSMITTED]++;	/* impossible to determine APDU count */
-	pgm_atomic_add32 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint32_t)(tpdu_length + sock->iphdr_len));
+	pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)(tpdu_length + sock->iphdr_len));
 	return TRUE;
 }
 
+/* send a vector of selective repair packets with one system call.
+ *
+ * returns count of packets sent, less than count if the operation would block.
+ */
+
+static
+unsigned
+send_rdatav (
+	pgm_sock_t*	       restrict sock,
+	struct pgm_sk_buff_t** restrict skbs,
+	unsigned			count,
+	const bool			is_nonblocking
+	)
+{
+	size_t tpdu_length = 0;
+	int sent;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != skbs);
+	pgm_assert (count > 0);
+
+/* stop before original data still read by the kernel */
+	for (unsigned i = 0; i < count; i++)
+		if (PGM_UNLIKELY(pgm_zerocopy_is_pinned (sock, skbs[i]))) {
+			if (0 == i) {
+				sock->blocklen = (char*)skbs[0]->tail - (char*)skbs[0]->head + sock->iphdr_len;
+				return 0;
+			}
+			count = i;
+			break;
+		}
+
+/* congestion control, one token per packet */
+	if (sock->use_pgmcc && !sock->use_tfmcc) {
+		const unsigned tokens = sock->tokens / pgm_fp8 (1);
+		if (0 == tokens) {
+			sock->blocklen = (char*)skbs[0]->tail - (char*)skbs[0]->head + sock->iphdr_len;
+			return 0;
+		}
+		count = MIN( count, tokens );
+	}
+
+/* rate check including rdata specific limits, 1 × IP header len excluded */
+	for (unsigned i = 0; i < count; i++)
+		tpdu_length += (char*)skbs[i]->tail - (char*)skbs[i]->head;
+	tpdu_length += (count - 1) * sock->iphdr_len;
+	if (sock->is_controlled_rdata &&
+	    !pgm_rate_check2 (&sock->rate_control,
+			      &sock->rdata_rate_control,
+			      tpdu_length,
+			      is_nonblocking))
+	{
+/* vector may exceed bucket capacity, fall back to one packet */
+		tpdu_length = (char*)skbs[0]->tail - (char*)skbs[0]->head;
+		if (1 == count ||
+		    !pgm_rate_check2 (&sock->rate_control,
+				      &sock->rdata_rate_control,
+				      tpdu_length,
+				      is_nonblocking))
+		{
+			sock->blocklen = tpdu_length + sock->iphdr_len;
+			return 0;
+		}
+		count = 1;
+	}
+
+/* update previous odata/rdata contents */
+	for (unsigned i = 0; i < count; i++)
+	{
+		struct pgm_header* header	= skbs[i]->pgm_header;
+		struct pgm_data* rdata		= skbs[i]->pgm_data;
+		header->pgm_type		= PGM_RDATA;
+		rdata->data_trail		= pgm_htonl (source_trail (sock));
+
+		header->pgm_checksum		= 0;
+		const size_t header_length	= (char*)skbs[i]->tail - (char*)skbs[i]->head - pgm_ntohs(header->pgm_tsdu_length) - (skbs[i]->crc32c ? sizeof(uint32_t) : 0);
+		const uint32_t unfolded_odata	= pgm_txw_get_unfolded_checksum (skbs[i]);
+		header->pgm_checksum		= data_csum_fold (sock, skbs[i], (uint16_t)header_length, unfolded_odata);
+	}
+
+	sent = pgm_sendmmsg (sock,
+			     FALSE,			/* already rate limited */
+			     &sock->rdata_rate_control,
+			     TRUE,			/* with router alert */
+			     skbs,
+			     count,
+			     (struct sockaddr*)&sock->send_gsr.gsr_group,
+			     pgm_sockaddr_len((struct sockaddr*)&sock->send_gsr.gsr_group));
+	if (sent < 0) {
+		sock->blocklen = (char*)skbs[0]->tail - (char*)skbs[0]->head + sock->iphdr_len;
+		return 0;
+	}
+
+	const pgm_time_t now = pgm_time_update_now();
+
+	if (sock->use_pgmcc) {
+		if (!sock->use_tfmcc)
+			sock->tokens -= pgm_fp8 (sent);
+		congestion_stall_end (sock);
+		sock->ack_expiry = now + sock->ack_expiry_ivl;
+	}
+
+/* re-set spm timer */
+	pgm_sock_mutex_lock (sock, &sock->timer_mutex);
+	sock->spm_heartbeat_state = 1;
+	sock->next_heartbeat_spm = now + sock->spm_heartbeat_interval[sock->spm_heartbeat_state++];
+	pgm_sock_mutex_unlock (sock, &sock->timer_mutex);
+
+	for (int i = 0; i < sent; i++)
+	{
+		if (sock->use_tx_priority)
+			tx_sched_credit (sock, -(int32_t)pgm_ntohs(skbs[i]->pgm_header->pgm_tsdu_length));
+		PGM_PROBE3 (rdata_send, sock, pgm_ntohl (skbs[i]->pgm_data->data_sqn), (char*)skbs[i]->tail - (char*)skbs[i]->head);
+		pgm_flightrec_add (sock->flightrec, PGM_FLIGHTREC_RDATA_SEND, 0, sock->tsi.sport, pgm_ntohl (skbs[i]->pgm_data->data_sqn), (uint32_t)((char*)skbs[i]->tail - (char*)skbs[i]->head));
+		pgm_txw_inc_retransmit_count (skbs[i]);
+		rdata_age_add (sock, skbs[i]->sequence);
+		sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_BYTES_RETRANSMITTED] += pgm_ntohs(skbs[i]->pgm_header->pgm_tsdu_length);
+		sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_MSGS_RETRANSMITTED]++;
+		pgm_atomic_add64 (&sock->cumulative_stats[PGM_PC_SOURCE_BYTES_SENT], (uint64_t)((char*)skbs[i]->tail - (char*)skbs[i]->head + sock->iphdr_len));
+	}
+	return (unsigned)sent;
+}
+
 /* eof */
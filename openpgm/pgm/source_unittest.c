@@ -63,20 +63,32 @@ static gboolean mock_is_valid_spmr = TRUE;
 static gboolean mock_is_valid_ack = TRUE;
 static gboolean mock_is_valid_nak = TRUE;
 static gboolean mock_is_valid_nnak = TRUE;
+static guint mock_parity_count = 0;
+static guint mock_rdata_sent = 0;
 
 
 #define pgm_txw_get_unfolded_checksum	mock_pgm_txw_get_unfolded_checksum
 #define pgm_txw_set_unfolded_checksum	mock_pgm_txw_set_unfolded_checksum
 #define pgm_txw_inc_retransmit_count	mock_pgm_txw_inc_retransmit_count
 #define pgm_txw_add			mock_pgm_txw_add
+#define pgm_txw_add_unreliable		mock_pgm_txw_add_unreliable
+#define pgm_txw_ack			mock_pgm_txw_ack
+#define pgm_txw_alloc_skb		mock_pgm_txw_alloc_skb
 #define pgm_txw_peek			mock_pgm_txw_peek
+#define pgm_txw_peek_get		mock_pgm_txw_peek_get
 #define pgm_txw_retransmit_push		mock_pgm_txw_retransmit_push
 #define pgm_txw_retransmit_try_peek	mock_pgm_txw_retransmit_try_peek
+#define pgm_txw_retransmit_is_empty	mock_pgm_txw_retransmit_is_empty
+#define pgm_txw_retransmit_try_peekv	mock_pgm_txw_retransmit_try_peekv
 #define pgm_txw_retransmit_remove_head	mock_pgm_txw_retransmit_remove_head
+#define pgm_txw_parity_encode		mock_pgm_txw_parity_encode
+#define pgm_txw_parity_reserve		mock_pgm_txw_parity_reserve
 #define pgm_rs_encode			mock_pgm_rs_encode
 #define pgm_rate_check			mock_pgm_rate_check
+#define pgm_tfmcc_feedback		mock_pgm_tfmcc_feedback
 #define pgm_verify_spmr			mock_pgm_verify_spmr
 #define pgm_verify_ack			mock_pgm_verify_ack
+#define pgm_verify_polr			mock_pgm_verify_polr
 #define pgm_verify_nak			mock_pgm_verify_nak
 #define pgm_verify_nnak			mock_pgm_verify_nnak
 #define pgm_compat_csum_partial		mock_pgm_compat_csum_partial
@@ -84,8 +96,13 @@ static gboolean mock_is_valid_nnak = TRUE;
 #define pgm_csum_block_add		mock_pgm_csum_block_add
 #define pgm_csum_fold			mock_pgm_csum_fold
 #define pgm_sendto_hops			mock_pgm_sendto_hops
+#define pgm_sendmmsg			mock_pgm_sendmmsg
+#define pgm_sendskb			mock_pgm_sendskb
+#define pgm_zerocopy_is_pinned		mock_pgm_zerocopy_is_pinned
 #define pgm_time_update_now		mock_pgm_time_update_now
+#define pgm_time_wall_now		mock_pgm_time_wall_now
 #define pgm_setsockopt			mock_pgm_setsockopt
+#define pgm_standby_mirror		mock_pgm_standby_mirror
 
 
 #define SOURCE_DEBUG
@@ -116,16 +133,21 @@ generate_sock (void)
 	sock->window = g_malloc0 (sizeof(pgm_txw_t));
 	sock->txw_sqns = TEST_TXW_SQNS;
 	sock->max_tpdu = TEST_MAX_TPDU;
+	sock->path_mtu = TEST_MAX_TPDU;
 	sock->max_tsdu = TEST_MAX_TPDU - sizeof(struct pgm_ip) - pgm_pkt_offset (FALSE, FALSE);
 	sock->max_tsdu_fragment = TEST_MAX_TPDU - sizeof(struct pgm_ip) - pgm_pkt_offset (TRUE, FALSE);
 	sock->max_apdu = MIN(TEST_TXW_SQNS, PGM_MAX_FRAGMENTS) * sock->max_tsdu_fragment;
 	sock->iphdr_len = sizeof(struct pgm_ip);
+	sock->numa_node = PGM_NUMA_NODE_NONE;
+	sock->event_sock = INVALID_SOCKET;
+	sock->event_timer_fd = INVALID_SOCKET;
 	sock->spm_heartbeat_interval = g_malloc0 (sizeof(guint) * (2+2));
 	sock->spm_heartbeat_interval[0] = pgm_secs(1);
 	pgm_spinlock_init (&sock->txw_spinlock);
 	pgm_mutex_init (&sock->source_mutex);
 	pgm_mutex_init (&sock->timer_mutex);
 	pgm_rwlock_init (&sock->lock);
+	pgm_odata_template_init (sock);
 	return sock;
 }
 
@@ -196,6 +218,18 @@ generate_spmr (void)
 	return skb;
 }
 
+/* IP source address of upstream packets */
+static
+const struct sockaddr*
+generate_receiver_addr (void)
+{
+	static struct sockaddr_in sin;
+	memset (&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = inet_addr ("127.0.0.3");
+	return (const struct sockaddr*)&sin;
+}
+
 static
 struct pgm_sk_buff_t*
 generate_single_nak (void)
@@ -290,6 +324,50 @@ generate_parity_nak_list (void)
 	return skb;
 }
 
+static
+struct pgm_sk_buff_t*
+generate_nak_range (void)
+{
+	struct pgm_sk_buff_t* skb = generate_single_nak ();
+	const guint16 opt_length = sizeof(struct pgm_opt_length) +
+				   sizeof(struct pgm_opt_header) + sizeof(guint8) +
+				   ( 2 * sizeof(struct pgm_nak_range) );
+	skb->pgm_header->pgm_options = PGM_OPT_PRESENT | PGM_OPT_NETWORK;
+	struct pgm_nak *nak = (struct pgm_nak*)(skb->pgm_header + 1);
+	nak->nak_sqn = g_htonl (1);
+	struct pgm_opt_length* opt_len = (struct pgm_opt_length*)(nak + 1);
+	memset (opt_len, 0, opt_length);
+	opt_len->opt_type = PGM_OPT_LENGTH;
+	opt_len->opt_length = sizeof(struct pgm_opt_length);
+	opt_len->opt_total_length = g_htons (opt_length);
+	struct pgm_opt_header* opt_header = (struct pgm_opt_header*)(opt_len + 1);
+	opt_header->opt_type = PGM_OPT_NAK_RANGE | PGM_OPT_END;
+	opt_header->opt_length = opt_length - sizeof(struct pgm_opt_length);
+	struct pgm_opt_nak_range* opt_nak_range = (struct pgm_opt_nak_range*)(opt_header + 1);
+/* #1-#40, #50-#59 */
+	opt_nak_range->opt_range[0].range_sqn	= g_htonl (1);
+	opt_nak_range->opt_range[0].range_count	= g_htonl (40);
+	opt_nak_range->opt_range[1].range_sqn	= g_htonl (50);
+	opt_nak_range->opt_range[1].range_count	= g_htonl (10);
+	pgm_skb_put (skb, opt_length);
+	return skb;
+}
+
+/** transmit window module */
+static struct pgm_sk_buff_t* mock_txw_skb = NULL;
+
+struct pgm_sk_buff_t*
+mock_pgm_txw_alloc_skb (
+	pgm_txw_t* const		window,
+	pgm_skb_pool_t* const		pool,
+	const uint16_t			size
+	)
+{
+	g_debug ("mock_pgm_txw_alloc_skb (window:%p pool:%p size:%u)",
+		(gpointer)window, (gpointer)pool, (unsigned)size);
+	return pgm_alloc_skb (size);
+}
+
 void
 mock_pgm_txw_add (
 	pgm_txw_t* const		window,
@@ -298,6 +376,18 @@ mock_pgm_txw_add (
 {
 	g_debug ("mock_pgm_txw_add (window:%p skb:%p)",
 		(gpointer)window, (gpointer)skb);
+	skb->sequence = pgm_txw_next_lead (window);
+	window->lead++;
+}
+
+void
+mock_pgm_txw_add_unreliable (
+	pgm_txw_t* const		window,
+	struct pgm_sk_buff_t* const	skb
+	)
+{
+	g_debug ("mock_pgm_txw_add_unreliable (window:%p skb:%p)",
+		(gpointer)window, (gpointer)skb);
 }
 
 struct pgm_sk_buff_t*
@@ -308,7 +398,18 @@ mock_pgm_txw_peek (
 {
 	g_debug ("mock_pgm_txw_peek (window:%p sequence:%" G_GUINT32_FORMAT ")",
 		(gpointer)window, sequence);
-	return NULL;
+	return mock_txw_skb;
+}
+
+struct pgm_sk_buff_t*
+mock_pgm_txw_peek_get (
+	pgm_txw_t* const		window,
+	const uint32_t			sequence
+	)
+{
+	g_debug ("mock_pgm_txw_peek_get (window:%p sequence:%" G_GUINT32_FORMAT ")",
+		(gpointer)window, sequence);
+	return NULL != mock_txw_skb ? pgm_skb_get (mock_txw_skb) : NULL;
 }
 
 bool
@@ -350,6 +451,23 @@ mock_pgm_txw_inc_retransmit_count (
 {
 }
 
+void
+mock_pgm_standby_mirror (
+	struct pgm_standby_t* const	standby,
+	const void*			tpdu,
+	const size_t			tpdu_length
+	)
+{
+}
+
+void
+mock_pgm_txw_ack (
+	pgm_txw_t* const	window,
+	const uint32_t		sequence
+	)
+{
+}
+
 struct pgm_sk_buff_t*
 mock_pgm_txw_retransmit_try_peek (
 	pgm_txw_t* const		window
@@ -360,6 +478,29 @@ mock_pgm_txw_retransmit_try_peek (
 	return generate_odata (); 
 }
 
+bool
+mock_pgm_txw_retransmit_is_empty (
+	const pgm_txw_t* const		window
+	)
+{
+	g_debug ("mock_pgm_txw_retransmit_is_empty (window:%p)",
+		(gconstpointer)window);
+	return TRUE;
+}
+
+unsigned
+mock_pgm_txw_retransmit_try_peekv (
+	pgm_txw_t* const		window,
+	struct pgm_sk_buff_t**const	skbs,
+	const unsigned			count
+	)
+{
+	g_debug ("mock_pgm_txw_retransmit_try_peekv (window:%p skbs:%p count:%u)",
+		(gpointer)window, (gpointer)skbs, count);
+	skbs[0] = generate_odata ();
+	return 1;
+}
+
 void
 mock_pgm_txw_retransmit_remove_head (
 	pgm_txw_t* const		window
@@ -369,6 +510,43 @@ mock_pgm_txw_retransmit_remove_head (
 		(gpointer)window);
 }
 
+uint8_t
+mock_pgm_txw_parity_reserve (
+	pgm_txw_t* const		window,
+	struct pgm_sk_buff_t* const	skb,
+	const uint8_t			count
+	)
+{
+	g_debug ("mock_pgm_txw_parity_reserve (window:%p skb:%p count:%u)",
+		(gpointer)window, (gpointer)skb, count);
+	return 0;
+}
+
+void
+mock_pgm_txw_parity_encode (
+	pgm_txw_t* const			window,
+	struct pgm_sk_buff_t*const*const	odata_skbs,
+	const uint8_t				rs_h,
+	const uint8_t				count,
+	struct pgm_sk_buff_t*const*const	parity_skbs
+	)
+{
+	g_debug ("mock_pgm_txw_parity_encode (window:%p odata-skbs:%p rs-h:%u count:%u parity-skbs:%p)",
+		(gpointer)window, (gpointer)odata_skbs, rs_h, count, (gpointer)parity_skbs);
+/* parity packets shaped as original data */
+	for (unsigned i = 0; i < count; i++) {
+		struct pgm_sk_buff_t* skb = parity_skbs[i];
+		const guint16 header_length = sizeof(struct pgm_header) + sizeof(struct pgm_data);
+		memset (skb->head, 0, header_length);
+		skb->pgm_header = (struct pgm_header*)skb->head;
+		skb->pgm_data   = (struct pgm_data*)(skb->pgm_header + 1);
+		skb->pgm_header->pgm_options = PGM_OPT_PARITY;
+		skb->pgm_header->pgm_tsdu_length = g_htons (odata_skbs[0]->len);
+		pgm_skb_put (skb, header_length + odata_skbs[0]->len);
+	}
+	mock_parity_count += count;
+}
+
 void
 mock_pgm_rs_encode (
 	pgm_rs_t*			rs,
@@ -382,6 +560,18 @@ mock_pgm_rs_encode (
 		rs, src, offset, dst, len);
 }
 
+/** tfmcc module */
+PGM_GNUC_INTERNAL
+void
+mock_pgm_tfmcc_feedback (
+	pgm_sock_t* const	sock,
+	const uint32_t		rtt,
+	const uint16_t		loss_rate,
+	const pgm_time_t	now
+	)
+{
+}
+
 PGM_GNUC_INTERNAL
 bool
 mock_pgm_rate_check (
@@ -411,6 +601,14 @@ mock_pgm_verify_ack (
 	return mock_is_valid_ack;
 }
 
+bool
+mock_pgm_verify_polr (
+	const struct pgm_sk_buff_t* const	skb
+	)
+{
+	return TRUE;
+}
+
 bool
 mock_pgm_verify_nak (
 	const struct pgm_sk_buff_t* const	skb
@@ -492,9 +690,90 @@ mock_pgm_sendto_hops (
 		(unsigned)len,
 		saddr,
 		tolen);
+	if (PGM_RDATA == ((const struct pgm_header*)buf)->pgm_type)
+		mock_rdata_sent++;
 	return len;
 }
 
+PGM_GNUC_INTERNAL
+int
+mock_pgm_sendmmsg (
+	pgm_sock_t*			sock,
+	bool				use_rate_limit,
+	pgm_rate_t*			minor_rate_control,
+	bool				use_router_alert,
+	struct pgm_sk_buff_t*const*	skbs,
+	unsigned			count,
+	const struct sockaddr*		to,
+	socklen_t			tolen
+	)
+{
+	char saddr[INET6_ADDRSTRLEN];
+	pgm_sockaddr_ntop (to, saddr, sizeof(saddr));
+	g_debug ("mock_pgm_sendmmsg (sock:%p use-rate-limit:%s minor-rate-control:%p use-router-alert:%s skbs:%p count:%u to:%s tolen:%d)",
+		(gpointer)sock,
+		use_rate_limit ? "YES" : "NO",
+		(gpointer)minor_rate_control,
+		use_router_alert ? "YES" : "NO",
+		(gpointer)skbs,
+		count,
+		saddr,
+		tolen);
+	return count;
+}
+
+PGM_GNUC_INTERNAL
+ssize_t
+mock_pgm_sendskb (
+	pgm_sock_t*			sock,
+	bool				use_rate_limit,
+	pgm_rate_t*			minor_rate_control,
+	struct pgm_sk_buff_t*		skb,
+	const struct sockaddr*		to,
+	socklen_t			tolen
+	)
+{
+	char saddr[INET6_ADDRSTRLEN];
+	pgm_sockaddr_ntop (to, saddr, sizeof(saddr));
+	g_debug ("mock_pgm_sendskb (sock:%p use-rate-limit:%s minor-rate-control:%p skb:%p to:%s tolen:%d)",
+		(gpointer)sock,
+		use_rate_limit ? "YES" : "NO",
+		(gpointer)minor_rate_control,
+		(gpointer)skb,
+		saddr,
+		tolen);
+	return (char*)skb->tail - (char*)skb->head;
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_zerocopy_is_pinned (
+	pgm_sock_t*			sock,
+	const struct pgm_sk_buff_t*	skb
+	)
+{
+	return FALSE;
+}
+
+/** engine module */
+PGM_GNUC_INTERNAL
+void
+pgm_engine_timer_wake (
+	const pgm_time_t		expiration
+	)
+{
+}
+
+/** timer module */
+PGM_GNUC_INTERNAL
+void
+pgm_timer_event_rate (
+	pgm_sock_t* const		sock,
+	const pgm_time_t		expiration
+	)
+{
+}
+
 /** time module */
 static pgm_time_t _mock_pgm_time_update_now (void);
 pgm_time_update_func mock_pgm_time_update_now = _mock_pgm_time_update_now;
@@ -506,6 +785,13 @@ _mock_pgm_time_update_now (void)
 	return 0x1;
 }
 
+PGM_GNUC_INTERNAL
+pgm_time_t
+mock_pgm_time_wall_now (void)
+{
+	return 0x1;
+}
+
 /** socket module */
 size_t
 pgm_pkt_offset (
@@ -521,6 +807,27 @@ pgm_pkt_offset (
 			    : ( sizeof(struct pgm_header) + sizeof(struct pgm_data) );
 }
 
+size_t
+pgm_coalesce_pkt_offset (
+	const sa_family_t		pgmcc_family	/* 0 = disable */
+	)
+{
+	return sizeof(struct pgm_header)
+	     + sizeof(struct pgm_data)
+	     + sizeof(struct pgm_opt_length)
+	     + sizeof(struct pgm_opt_header)
+	     + sizeof(struct pgm_opt_coalesce);
+}
+
+void
+pgm_sock_set_path_mtu (
+	pgm_sock_t* const		sock,
+	const uint16_t			path_mtu
+	)
+{
+	sock->path_mtu = path_mtu;
+}
+
 PGM_GNUC_INTERNAL
 int
 pgm_get_nprocs (void)
@@ -583,6 +890,130 @@ START_TEST (test_send_pass_002)
 }
 END_TEST
 
+/* coalesced small apdus */
+START_TEST (test_send_pass_003)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->max_tsdu_coalesce = TEST_MAX_TPDU - sizeof(struct pgm_ip) - pgm_coalesce_pkt_offset (0);
+	sock->coalesce_threshold = 200;
+	sock->coalesce_ivl = pgm_secs(1);
+	sock->coalesce_buf = g_malloc0 (sock->max_tsdu_coalesce);
+	sock->is_bound = TRUE;
+	const gsize apdu_length = 100;
+	guint8 buffer[ apdu_length ];
+	gsize bytes_written;
+/* first apdu is held back */
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send (sock, buffer, apdu_length, &bytes_written), "send not normal");
+	fail_unless ((gssize)apdu_length == bytes_written, "send underrun");
+	fail_unless ((sizeof(guint16) + apdu_length) == sock->coalesce_len, "coalesce_len failed");
+	fail_if (0 == sock->coalesce_expiry, "coalesce_expiry failed");
+/* second apdu crosses the threshold */
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send (sock, buffer, apdu_length, &bytes_written), "send not normal");
+	fail_unless ((gssize)apdu_length == bytes_written, "send underrun");
+	fail_unless (0 == sock->coalesce_len, "coalesce_len failed");
+	fail_unless (0 == sock->coalesce_expiry, "coalesce_expiry failed");
+}
+END_TEST
+
+/* large apdu flushes pending small apdus */
+START_TEST (test_send_pass_004)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->max_tsdu_coalesce = TEST_MAX_TPDU - sizeof(struct pgm_ip) - pgm_coalesce_pkt_offset (0);
+	sock->coalesce_threshold = sock->max_tsdu_coalesce;
+	sock->coalesce_ivl = pgm_secs(1);
+	sock->coalesce_buf = g_malloc0 (sock->max_tsdu_coalesce);
+	sock->is_bound = TRUE;
+	guint8 buffer[ 16000 ];
+	gsize bytes_written;
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send (sock, buffer, 100, &bytes_written), "send not normal");
+	fail_if (0 == sock->coalesce_len, "coalesce_len failed");
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send (sock, buffer, sizeof(buffer), &bytes_written), "send not normal");
+	fail_unless (sizeof(buffer) == bytes_written, "send underrun");
+	fail_unless (0 == sock->coalesce_len, "coalesce_len failed");
+}
+END_TEST
+
+/* single tpdu apdu carries OPT_TIMESTAMP, dropped without room */
+START_TEST (test_send_pass_005)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->is_bound = TRUE;
+	sock->use_send_timestamp = TRUE;
+	guint8 buffer[ TEST_MAX_TPDU ];
+	gsize bytes_written;
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send (sock, buffer, 100, &bytes_written), "send not normal");
+	fail_unless (100 == bytes_written, "send underrun");
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send (sock, buffer, sock->max_tsdu, &bytes_written), "send not normal");
+	fail_unless (sock->max_tsdu == bytes_written, "send underrun");
+}
+END_TEST
+
+/* producers commit single and fragmented apdus in sequence order */
+START_TEST (test_send_pass_006)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->use_multi_producer = TRUE;
+	sock->mp_ring = g_new0 (struct pgm_sk_buff_t*, PGM_MP_RING_LEN);
+	sock->mp_reserve_sqn = sock->mp_commit_sqn = pgm_txw_next_lead (sock->window);
+	sock->is_bound = TRUE;
+	guint8 buffer[ 16000 ];
+	gsize bytes_written;
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send (sock, buffer, 100, &bytes_written), "send not normal");
+	fail_unless (100 == bytes_written, "send underrun");
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send (sock, buffer, sizeof(buffer), &bytes_written), "send not normal");
+	fail_unless (sizeof(buffer) == bytes_written, "send underrun");
+	fail_unless (sock->mp_reserve_sqn == sock->mp_commit_sqn, "commit failed");
+	fail_unless (pgm_txw_next_lead (sock->window) == sock->mp_commit_sqn, "window lead failed");
+	fail_unless (0 == sock->is_mp_committing, "is_mp_committing failed");
+}
+END_TEST
+
+/* queued apdus are sent by the sender thread before it stops */
+START_TEST (test_send_pass_007)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->async_len = 3;
+	const uint32_t lead = pgm_txw_next_lead (sock->window);
+	fail_unless (TRUE == pgm_async_thread_create (sock), "async_thread_create failed");
+	fail_unless (3 == sock->async_thread->mask, "ring length not power of two");
+	sock->is_bound = TRUE;
+	guint8 buffer[ TEST_MAX_TPDU ];
+	gsize bytes_written;
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send (sock, buffer, 100, &bytes_written), "send not normal");
+	fail_unless (100 == bytes_written, "send underrun");
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send (sock, buffer, 200, &bytes_written), "send not normal");
+	pgm_async_thread_destroy (sock);
+	fail_unless (NULL == sock->async_thread, "async_thread not released");
+	fail_unless (lead + 2 == pgm_txw_next_lead (sock->window), "window lead failed");
+}
+END_TEST
+
+/* full ring refuses without blocking */
+START_TEST (test_send_pass_008)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	struct pgm_async_thread_t* async = g_new0 (struct pgm_async_thread_t, 1);
+	async->ring = (struct pgm_async_apdu_t* volatile*)g_new0 (struct pgm_async_apdu_t*, 1);
+	sock->async_len = 1;
+	sock->async_thread = async;
+	sock->is_bound = TRUE;
+	guint8 buffer[ TEST_MAX_TPDU ];
+	gsize bytes_written;
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send (sock, buffer, 100, &bytes_written), "send not normal");
+	fail_unless (NULL != async->ring[ 0 ], "apdu not queued");
+	fail_unless (100 == async->ring[ 0 ]->length, "apdu length failed");
+	fail_unless (PGM_IO_STATUS_WOULD_BLOCK == pgm_send (sock, buffer, 100, &bytes_written), "send not would-block");
+	fail_unless (1 == sock->cumulative_stats[PGM_PC_SOURCE_ASYNC_QUEUE_FULL], "async_queue_full failed");
+}
+END_TEST
+
 START_TEST (test_send_fail_001)
 {
 	guint8 buffer[ TEST_TXW_SQNS * TEST_MAX_TPDU ];
@@ -592,6 +1023,164 @@ START_TEST (test_send_fail_001)
 }
 END_TEST
 
+/* target:
+ *	PGMIOStatus
+ *	pgm_sendfile (
+ *		pgm_sock_t*	sock,
+ *		int			fd,
+ *		guint64			offset,
+ *		gsize			length,
+ *		gsize*			bytes_written
+ *		)
+ */
+
+START_TEST (test_sendfile_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->is_bound = TRUE;
+	guint8 buffer[ 16000 ];
+	memset (buffer, 'x', sizeof(buffer));
+	FILE* fp = tmpfile ();
+	fail_if (NULL == fp, "tmpfile failed");
+	fail_unless (sizeof(buffer) == fwrite (buffer, 1, sizeof(buffer), fp), "fwrite failed");
+	fflush (fp);
+	gsize bytes_written;
+/* unaligned offset */
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_sendfile (sock, fileno (fp), 100, sizeof(buffer) - 100, &bytes_written), "sendfile not normal");
+	fail_unless ((sizeof(buffer) - 100) == bytes_written, "sendfile underrun");
+	fclose (fp);
+}
+END_TEST
+
+/* region past the end of the file */
+START_TEST (test_sendfile_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->is_bound = TRUE;
+	FILE* fp = tmpfile ();
+	fail_if (NULL == fp, "tmpfile failed");
+	gsize bytes_written;
+	fail_unless (PGM_IO_STATUS_ERROR == pgm_sendfile (sock, fileno (fp), 0, 100, &bytes_written), "sendfile not error");
+	fclose (fp);
+}
+END_TEST
+
+START_TEST (test_sendfile_fail_002)
+{
+	gsize bytes_written;
+	fail_unless (PGM_IO_STATUS_ERROR == pgm_sendfile (NULL, 0, 0, 100, &bytes_written), "sendfile not error");
+}
+END_TEST
+
+/* target:
+ *	PGMIOStatus
+ *	pgm_send_begin (
+ *		pgm_sock_t*	sock,
+ *		gsize			apdu_length
+ *		)
+ *	pgm_send_append (
+ *		pgm_sock_t*	sock,
+ *		gconstpointer		buf,
+ *		gsize			len,
+ *		gsize*			bytes_written
+ *		)
+ *	pgm_send_commit (
+ *		pgm_sock_t*	sock,
+ *		gsize*			bytes_written
+ *		)
+ */
+
+/* large apdu in chunks straddling fragment boundaries */
+START_TEST (test_send_stream_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->is_bound = TRUE;
+	const gsize apdu_length = 16000;
+	guint8 buffer[ apdu_length ];
+	gsize bytes_written, offset = 0;
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send_begin (sock, apdu_length), "begin not normal");
+	while (offset < apdu_length) {
+		const gsize len = MIN(333, apdu_length - offset);
+		fail_unless (PGM_IO_STATUS_NORMAL == pgm_send_append (sock, buffer + offset, len, &bytes_written), "append not normal");
+		fail_unless (len == bytes_written, "append underrun");
+		offset += len;
+	}
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send_commit (sock, &bytes_written), "commit not normal");
+	fail_unless (apdu_length == bytes_written, "commit underrun");
+	fail_if (sock->stream_state.is_open, "stream still open");
+}
+END_TEST
+
+/* commit short of the declared length, append beyond it */
+START_TEST (test_send_stream_fail_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->is_bound = TRUE;
+	guint8 buffer[ 200 ];
+	gsize bytes_written;
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send_begin (sock, 100), "begin not normal");
+	fail_unless (PGM_IO_STATUS_ERROR == pgm_send_append (sock, buffer, sizeof(buffer), &bytes_written), "append not error");
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send_append (sock, buffer, 50, &bytes_written), "append not normal");
+	fail_unless (PGM_IO_STATUS_ERROR == pgm_send_commit (sock, &bytes_written), "commit not error");
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send_append (sock, buffer, 50, &bytes_written), "append not normal");
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send_commit (sock, &bytes_written), "commit not normal");
+	fail_unless (100 == bytes_written, "commit underrun");
+}
+END_TEST
+
+START_TEST (test_send_stream_fail_002)
+{
+	fail_unless (PGM_IO_STATUS_ERROR == pgm_send_begin (NULL, 100), "begin not error");
+}
+END_TEST
+
+/* target:
+ *	PGMIOStatus
+ *	pgm_send_unreliable (
+ *		pgm_sock_t*	sock,
+ *		gconstpointer		apdu,
+ *		gsize			apdu_length,
+ *		gsize*			bytes_written
+ *		)
+ */
+
+START_TEST (test_send_unreliable_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->is_bound = TRUE;
+	const gsize apdu_length = 100;
+	guint8 buffer[ apdu_length ];
+	gsize bytes_written;
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send_unreliable (sock, buffer, apdu_length, &bytes_written), "send not normal");
+	fail_unless ((gssize)apdu_length == bytes_written, "send underrun");
+	fail_unless (FALSE == sock->pkt_dontwait_state.is_unreliable, "unreliable packet held");
+/* following original data carries OPT_UNRELIABLE */
+	sock->window->unreliable_recent = 1;
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send (sock, buffer, apdu_length, &bytes_written), "send not normal");
+	fail_unless ((gssize)apdu_length == bytes_written, "send underrun");
+}
+END_TEST
+
+/* apdu larger than one tpdu, and with fec */
+START_TEST (test_send_unreliable_fail_001)
+{
+	guint8 buffer[ TEST_MAX_TPDU ];
+	gsize bytes_written;
+	fail_unless (PGM_IO_STATUS_ERROR == pgm_send_unreliable (NULL, buffer, 100, &bytes_written), "send not error");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->is_bound = TRUE;
+	fail_unless (PGM_IO_STATUS_ERROR == pgm_send_unreliable (sock, buffer, sock->max_tsdu + 1, &bytes_written), "send not error");
+	sock->use_ondemand_parity = TRUE;
+	fail_unless (PGM_IO_STATUS_ERROR == pgm_send_unreliable (sock, buffer, 100, &bytes_written), "send not error");
+}
+END_TEST
+
 /* target:
  *	PGMIOStatus
  *	pgm_sendv (
@@ -679,6 +1268,76 @@ START_TEST (test_sendv_fail_001)
 }
 END_TEST
 
+/* target:
+ *	PGMIOStatus
+ *	pgm_send_batch (
+ *		pgm_sock_t*		sock,
+ *		const struct pgmiovec*	apdus,
+ *		guint			count,
+ *		gsize*			bytes_written
+ *		)
+ */
+
+/* without a transmit batch */
+START_TEST (test_send_batch_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->is_bound = TRUE;
+	const gsize apdu_length = 100;
+	guint8 buffer[ apdu_length ];
+	struct pgm_iovec apdus[ 16 ];
+	for (unsigned i = 0; i < G_N_ELEMENTS(apdus); i++) {
+		apdus[i].iov_base = buffer;
+		apdus[i].iov_len  = apdu_length;
+	}
+	gsize bytes_written;
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send_batch (sock, apdus, G_N_ELEMENTS(apdus), &bytes_written), "send not normal");
+	fail_unless ((gssize)(apdu_length * G_N_ELEMENTS(apdus)) == bytes_written, "send underrun");
+}
+END_TEST
+
+/* runs of small apdus through the transmit batch around a fragmented apdu */
+START_TEST (test_send_batch_pass_002)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->is_bound = TRUE;
+	sock->tx_batch_size = 4;
+	sock->tx_batch = g_new0 (struct pgm_sk_buff_t*, sock->tx_batch_size);
+	const gsize apdu_length = 100;
+	const gsize large_apdu_length = 16000;
+	guint8 buffer[ large_apdu_length ];
+	struct pgm_iovec apdus[ 11 ];
+	gsize total_length = 0;
+	for (unsigned i = 0; i < G_N_ELEMENTS(apdus); i++) {
+		apdus[i].iov_base = buffer;
+		apdus[i].iov_len  = (5 == i) ? large_apdu_length : apdu_length;
+		total_length += apdus[i].iov_len;
+	}
+	gsize bytes_written;
+	fail_unless (PGM_IO_STATUS_NORMAL == pgm_send_batch (sock, apdus, G_N_ELEMENTS(apdus), &bytes_written), "send not normal");
+	fail_unless ((gssize)total_length == bytes_written, "send underrun");
+	fail_unless (0 == sock->pkt_dontwait_state.batch_len, "batch not flushed");
+	fail_unless (FALSE == sock->pkt_dontwait_state.is_batch_eagain, "batch blocked");
+}
+END_TEST
+
+/* apdu larger than the maximum */
+START_TEST (test_send_batch_fail_001)
+{
+	guint8 buffer[ 100 ];
+	struct pgm_iovec apdus[] = { { .iov_base = buffer, .iov_len = sizeof(buffer) } };
+	gsize bytes_written;
+	fail_unless (PGM_IO_STATUS_ERROR == pgm_send_batch (NULL, apdus, 1, &bytes_written), "send not error");
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->is_bound = TRUE;
+	apdus[0].iov_len = sock->max_apdu + 1;
+	fail_unless (PGM_IO_STATUS_ERROR == pgm_send_batch (sock, apdus, 1, &bytes_written), "send not error");
+}
+END_TEST
+
 /* target:
  *	PGMIOStatus
  *	pgm_send_skbv (
@@ -752,6 +1411,56 @@ START_TEST (test_send_skbv_fail_001)
 }
 END_TEST
 
+/* target:
+ *	void
+ *	pgm_odata_template_init (
+ *		pgm_sock_t*	sock
+ *		)
+ */
+
+START_TEST (test_odata_template_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	struct pgm_sk_buff_t* skb = pgm_alloc_skb (TEST_MAX_TPDU);
+	fail_if (NULL == skb, "alloc_skb failed");
+	(void)odata_template_stamp_fragment (sock, skb, 100, 12, 10, 200, 1000, 0);
+	fail_unless (0 == memcmp (skb->pgm_header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t)), "gsi mismatch");
+	fail_unless (sock->tsi.sport == skb->pgm_header->pgm_sport, "sport mismatch");
+	fail_unless (sock->dport == skb->pgm_header->pgm_dport, "dport mismatch");
+	fail_unless (PGM_ODATA == skb->pgm_header->pgm_type, "type not ODATA");
+	fail_unless (PGM_OPT_PRESENT == skb->pgm_header->pgm_options, "options not present");
+	fail_unless (100 == g_ntohs (skb->pgm_header->pgm_tsdu_length), "tsdu length mismatch");
+	fail_unless (12 == g_ntohl (skb->pgm_data->data_sqn), "data sqn mismatch");
+	const struct pgm_opt_length* opt_len = (const struct pgm_opt_length*)(skb->pgm_data + 1);
+	fail_unless (PGM_OPT_LENGTH == opt_len->opt_type, "OPT_LENGTH missing");
+	fail_unless (sizeof(struct pgm_opt_length) + sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_fragment) == g_ntohs (opt_len->opt_total_length), "option length mismatch");
+	fail_unless (10 == g_ntohl (skb->pgm_opt_fragment->opt_sqn), "fragment sqn mismatch");
+	fail_unless (200 == g_ntohl (skb->pgm_opt_fragment->opt_frag_off), "fragment offset mismatch");
+	fail_unless (1000 == g_ntohl (skb->pgm_opt_fragment->opt_frag_len), "fragment length mismatch");
+	fail_unless (sock->odata_template[ PGM_ODATA_TEMPLATE_FRAGMENT ].header_length == (char*)(skb->pgm_opt_fragment + 1) - (char*)skb->pgm_header, "header length mismatch");
+	pgm_free_skb (skb);
+}
+END_TEST
+
+/* compressed APDU */
+START_TEST (test_odata_template_pass_002)
+{
+	pgm_sock_t* sock = generate_sock ();
+	struct pgm_sk_buff_t* skb = pgm_alloc_skb (TEST_MAX_TPDU);
+	fail_if (NULL == skb, "alloc_skb failed");
+	(void)odata_template_stamp_fragment (sock, skb, 100, 10, 10, 0, 100, 4000);
+	const struct pgm_opt_length* opt_len = (const struct pgm_opt_length*)(skb->pgm_data + 1);
+	const struct pgm_opt_header* opt_header = (const struct pgm_opt_header*)(skb->pgm_opt_fragment + 1);
+	const struct pgm_opt_compress* opt_compress = (const struct pgm_opt_compress*)(opt_header + 1);
+	fail_unless (sizeof(struct pgm_opt_length) + 2 * sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_fragment) + sizeof(struct pgm_opt_compress) == g_ntohs (opt_len->opt_total_length), "option length mismatch");
+	fail_unless (100 == g_ntohl (skb->pgm_opt_fragment->opt_frag_len), "fragment length mismatch");
+	fail_unless ((PGM_OPT_COMPRESS | PGM_OPT_END) == opt_header->opt_type, "OPT_COMPRESS missing");
+	fail_unless (4000 == g_ntohl (opt_compress->opt_apdu_len), "decompressed length mismatch");
+	fail_unless (sock->odata_template[ PGM_ODATA_TEMPLATE_COMPRESS ].header_length == (char*)(opt_compress + 1) - (char*)skb->pgm_header, "header length mismatch");
+	pgm_free_skb (skb);
+}
+END_TEST
+
 /* target:
  *	gboolean
  *	pgm_send_spm (
@@ -768,6 +1477,23 @@ START_TEST (test_send_spm_pass_001)
 }
 END_TEST
 
+/* heartbeat from the connected socket template */
+START_TEST (test_send_spm_pass_002)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	pgm_spm_template_init (sock);
+	sock->is_connected = TRUE;
+	const struct pgm_header* header = (const struct pgm_header*)sock->spm_template.header;
+	fail_unless (PGM_SPM == header->pgm_type, "type not SPM");
+	fail_unless (0 == header->pgm_checksum, "template checksum not zero");
+	fail_unless (sizeof(struct pgm_header) + sizeof(struct pgm_spm) == sock->spm_template.header_length, "unexpected template length");
+	const uint32_t spm_sqn = sock->spm_sqn;
+	fail_unless (TRUE == pgm_send_spm (sock, 0), "send_spm failed");
+	fail_unless (spm_sqn + 1 == sock->spm_sqn, "spm sqn not advanced");
+}
+END_TEST
+
 START_TEST (test_send_spm_fail_001)
 {
 	pgm_send_spm (NULL, 0);
@@ -775,6 +1501,128 @@ START_TEST (test_send_spm_fail_001)
 }
 END_TEST
 
+/* target:
+ *	void
+ *	pgm_fec_idle_flush (
+ *		pgm_sock_t* const	sock,
+ *		const pgm_time_t	now
+ *	)
+ */
+
+#define TEST_FEC_IDLE_IVL	( pgm_msecs(10) )
+
+/* partial group of #0-#2 with a transmission group size of 8 */
+static
+struct pgm_sock_t*
+generate_fec_sock (void)
+{
+	struct pgm_sock_t* sock = generate_sock ();
+	sock->use_proactive_parity = TRUE;
+	sock->use_var_pktlen = TRUE;
+	sock->rs_k = 8;
+	sock->tg_sqn_shift = 3;
+	sock->rs_proactive_h = 2;
+	sock->fec_idle_ivl = TEST_FEC_IDLE_IVL;
+	sock->fec_idle_expiry = 100 + TEST_FEC_IDLE_IVL;
+	sock->window->trail = 0;
+	sock->window->lead = 2;
+	mock_txw_skb = generate_odata ();
+	mock_txw_skb->tstamp = 100;
+	mock_parity_count = mock_rdata_sent = 0;
+	return sock;
+}
+
+/* idle partial group sends the proactive parity */
+START_TEST (test_fec_idle_flush_pass_001)
+{
+	pgm_sock_t* sock = generate_fec_sock ();
+	pgm_fec_idle_flush (sock, 100 + TEST_FEC_IDLE_IVL);
+	fail_unless (2 == mock_parity_count, "unexpected parity count");
+	fail_unless (2 == mock_rdata_sent, "parity not sent");
+	fail_unless (0 == sock->fec_idle_expiry, "idle expiry not cleared");
+	fail_unless (1 == pgm_atomic_read32 (&mock_txw_skb->users), "original data not released");
+}
+END_TEST
+
+/* at least one parity packet when proactive parity is adapted to zero */
+START_TEST (test_fec_idle_flush_pass_002)
+{
+	pgm_sock_t* sock = generate_fec_sock ();
+	sock->rs_proactive_h = 0;
+	pgm_fec_idle_flush (sock, 100 + TEST_FEC_IDLE_IVL);
+	fail_unless (1 == mock_parity_count, "unexpected parity count");
+	fail_unless (1 == mock_rdata_sent, "parity not sent");
+}
+END_TEST
+
+/* lead sent within the interval re-arms the timer */
+START_TEST (test_fec_idle_flush_pass_003)
+{
+	pgm_sock_t* sock = generate_fec_sock ();
+	sock->next_poll = 100 + pgm_secs(1);
+	sock->is_pending_read = TRUE;
+	pgm_fec_idle_flush (sock, 100 + TEST_FEC_IDLE_IVL - 1);
+	fail_unless (0 == mock_parity_count, "unexpected parity");
+	fail_unless (0 == mock_rdata_sent, "unexpected send");
+	fail_unless (100 + TEST_FEC_IDLE_IVL == sock->fec_idle_expiry, "idle expiry not re-armed");
+	fail_unless (100 + TEST_FEC_IDLE_IVL == sock->next_poll, "next poll not pulled in");
+}
+END_TEST
+
+/* full group is covered by the regular proactive parity */
+START_TEST (test_fec_idle_flush_pass_004)
+{
+	pgm_sock_t* sock = generate_fec_sock ();
+	sock->window->lead = 7;
+	pgm_fec_idle_flush (sock, 100 + TEST_FEC_IDLE_IVL);
+	fail_unless (0 == mock_parity_count, "unexpected parity");
+	fail_unless (0 == sock->fec_idle_expiry, "idle expiry not cleared");
+}
+END_TEST
+
+/* empty window or blocked APDU */
+START_TEST (test_fec_idle_flush_pass_005)
+{
+	pgm_sock_t* sock = generate_fec_sock ();
+	sock->window->trail = 3;
+	pgm_fec_idle_flush (sock, 100 + TEST_FEC_IDLE_IVL);
+	fail_unless (0 == mock_parity_count, "unexpected parity on empty window");
+	sock = generate_fec_sock ();
+	sock->is_apdu_eagain = TRUE;
+	pgm_fec_idle_flush (sock, 100 + TEST_FEC_IDLE_IVL);
+	fail_unless (0 == mock_parity_count, "unexpected parity on blocked apdu");
+	fail_unless (0 == sock->fec_idle_expiry, "idle expiry not cleared");
+}
+END_TEST
+
+/* group left the window before encoding */
+START_TEST (test_fec_idle_flush_pass_006)
+{
+	pgm_sock_t* sock = generate_fec_sock ();
+	mock_txw_skb = NULL;
+	pgm_fec_idle_flush (sock, 100 + TEST_FEC_IDLE_IVL);
+	fail_unless (0 == mock_parity_count, "unexpected parity");
+	fail_unless (0 == mock_rdata_sent, "unexpected send");
+}
+END_TEST
+
+START_TEST (test_fec_idle_flush_fail_001)
+{
+	pgm_fec_idle_flush (NULL, 100);
+	fail ("reached");
+}
+END_TEST
+
+/* disabled */
+START_TEST (test_fec_idle_flush_fail_002)
+{
+	pgm_sock_t* sock = generate_fec_sock ();
+	sock->fec_idle_ivl = 0;
+	pgm_fec_idle_flush (sock, 100 + TEST_FEC_IDLE_IVL);
+	fail ("reached");
+}
+END_TEST
+
 /* target:
  *	void
  *	pgm_on_deferred_nak (
@@ -858,6 +1706,7 @@ END_TEST
  *	gboolean
  *	pgm_on_nak (
  *		pgm_sock_t*	sock,
+ *		const struct sockaddr*	src_addr,
  *		struct pgm_sk_buff_t*	skb
  *	)
  */
@@ -870,7 +1719,7 @@ START_TEST (test_on_nak_pass_001)
 	struct pgm_sk_buff_t* skb = generate_single_nak ();
 	fail_if (NULL == skb, "generate_single_nak failed");
 	skb->sock = sock;
-	fail_unless (TRUE == pgm_on_nak (sock, skb), "on_nak failed");
+	fail_unless (TRUE == pgm_on_nak (sock, generate_receiver_addr (), skb), "on_nak failed");
 }
 END_TEST
 
@@ -882,7 +1731,7 @@ START_TEST (test_on_nak_pass_002)
 	struct pgm_sk_buff_t* skb = generate_nak_list ();
 	fail_if (NULL == skb, "generate_nak_list failed");
 	skb->sock = sock;
-	fail_unless (TRUE == pgm_on_nak (sock, skb), "on_nak failed");
+	fail_unless (TRUE == pgm_on_nak (sock, generate_receiver_addr (), skb), "on_nak failed");
 }
 END_TEST
 
@@ -895,7 +1744,7 @@ START_TEST (test_on_nak_pass_003)
 	struct pgm_sk_buff_t* skb = generate_parity_nak ();
 	fail_if (NULL == skb, "generate_parity_nak failed");
 	skb->sock = sock;
-	fail_unless (TRUE == pgm_on_nak (sock, skb), "on_nak failed");
+	fail_unless (TRUE == pgm_on_nak (sock, generate_receiver_addr (), skb), "on_nak failed");
 }
 END_TEST
 
@@ -908,7 +1757,60 @@ START_TEST (test_on_nak_pass_004)
 	struct pgm_sk_buff_t* skb = generate_parity_nak_list ();
 	fail_if (NULL == skb, "generate_parity_nak_list failed");
 	skb->sock = sock;
-	fail_unless (TRUE == pgm_on_nak (sock, skb), "on_nak failed");
+	fail_unless (TRUE == pgm_on_nak (sock, generate_receiver_addr (), skb), "on_nak failed");
+}
+END_TEST
+
+/* nak range */
+START_TEST (test_on_nak_pass_005)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->use_nak_range = TRUE;
+	sock->window->alloc = sock->window->max_length = 100;
+	struct pgm_sk_buff_t* skb = generate_nak_range ();
+	fail_if (NULL == skb, "generate_nak_range failed");
+	skb->sock = sock;
+	fail_unless (TRUE == pgm_on_nak (sock, generate_receiver_addr (), skb), "on_nak failed");
+}
+END_TEST
+
+/* nak list beyond the receiver rate */
+START_TEST (test_on_nak_pass_006)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->nak_receiver_rate = 10;
+	sock->nak_peers = g_new0 (struct pgm_nak_peer_t, PGM_NAK_PEERS_LEN);
+	struct pgm_sk_buff_t* skb = generate_nak_list ();
+	fail_if (NULL == skb, "generate_nak_list failed");
+	skb->sock = sock;
+	fail_unless (TRUE == pgm_on_nak (sock, generate_receiver_addr (), skb), "on_nak failed");
+	fail_unless (52 == sock->cumulative_stats[PGM_PC_SOURCE_NAKS_RATE_LIMITED], "naks_rate_limited failed");
+/* bucket empty */
+	skb = generate_single_nak ();
+	skb->sock = sock;
+	fail_unless (TRUE == pgm_on_nak (sock, generate_receiver_addr (), skb), "on_nak failed");
+	fail_unless (53 == sock->cumulative_stats[PGM_PC_SOURCE_NAKS_RATE_LIMITED], "naks_rate_limited failed");
+}
+END_TEST
+
+/* batched naks confirmed once */
+START_TEST (test_on_nak_pass_007)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->ncf_batch = g_new0 (struct pgm_ncf_batch_t, 1);
+	struct pgm_sk_buff_t* skb = generate_nak_list ();
+	fail_if (NULL == skb, "generate_nak_list failed");
+	skb->sock = sock;
+	fail_unless (TRUE == pgm_on_nak (sock, generate_receiver_addr (), skb), "on_nak failed");
+	skb = generate_single_nak ();
+	skb->sock = sock;
+	fail_unless (TRUE == pgm_on_nak (sock, generate_receiver_addr (), skb), "on_nak failed");
+	fail_unless (62 == sock->ncf_batch->len[0], "batch len failed");
+	pgm_ncf_batch_flush (sock);
+	fail_unless (0 == sock->ncf_batch->len[0], "batch len failed");
 }
 END_TEST
 
@@ -920,13 +1822,27 @@ START_TEST (test_on_nak_fail_001)
 	fail_if (NULL == skb, "generate_single_nak failed");
 	skb->sock = sock;
 	mock_is_valid_nak = FALSE;
-	fail_unless (FALSE == pgm_on_nak (sock, skb), "on_nak failed");
+	fail_unless (FALSE == pgm_on_nak (sock, generate_receiver_addr (), skb), "on_nak failed");
+}
+END_TEST
+
+/* nak range exceeding the transmit window */
+START_TEST (test_on_nak_fail_003)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->use_nak_range = TRUE;
+	sock->window->alloc = sock->window->max_length = 40;
+	struct pgm_sk_buff_t* skb = generate_nak_range ();
+	fail_if (NULL == skb, "generate_nak_range failed");
+	skb->sock = sock;
+	fail_unless (FALSE == pgm_on_nak (sock, generate_receiver_addr (), skb), "on_nak failed");
 }
 END_TEST
 
 START_TEST (test_on_nak_fail_002)
 {
-	pgm_on_nak (NULL, NULL);
+	pgm_on_nak (NULL, NULL, NULL);
 	fail ("reached");
 }
 END_TEST
@@ -1158,8 +2074,34 @@ make_test_suite (void)
 	tcase_add_checked_fixture (tc_send, mock_setup, NULL);
 	tcase_add_test (tc_send, test_send_pass_001);
 	tcase_add_test (tc_send, test_send_pass_002);
+	tcase_add_test (tc_send, test_send_pass_003);
+	tcase_add_test (tc_send, test_send_pass_004);
+	tcase_add_test (tc_send, test_send_pass_005);
+	tcase_add_test (tc_send, test_send_pass_006);
+	tcase_add_test (tc_send, test_send_pass_007);
+	tcase_add_test (tc_send, test_send_pass_008);
 	tcase_add_test (tc_send, test_send_fail_001);
 
+	TCase* tc_sendfile = tcase_create ("sendfile");
+	suite_add_tcase (s, tc_sendfile);
+	tcase_add_checked_fixture (tc_sendfile, mock_setup, NULL);
+	tcase_add_test (tc_sendfile, test_sendfile_pass_001);
+	tcase_add_test (tc_sendfile, test_sendfile_fail_001);
+	tcase_add_test (tc_sendfile, test_sendfile_fail_002);
+
+	TCase* tc_send_stream = tcase_create ("send-stream");
+	suite_add_tcase (s, tc_send_stream);
+
+	tcase_add_test (tc_send_stream, test_send_stream_pass_001);
+	tcase_add_test (tc_send_stream, test_send_stream_fail_001);
+	tcase_add_test (tc_send_stream, test_send_stream_fail_002);
+
+	TCase* tc_send_unreliable = tcase_create ("send-unreliable");
+	suite_add_tcase (s, tc_send_unreliable);
+	tcase_add_checked_fixture (tc_send_unreliable, mock_setup, NULL);
+	tcase_add_test (tc_send_unreliable, test_send_unreliable_pass_001);
+	tcase_add_test (tc_send_unreliable, test_send_unreliable_fail_001);
+
 	TCase* tc_sendv = tcase_create ("sendv");
 	suite_add_tcase (s, tc_sendv);
 	tcase_add_checked_fixture (tc_sendv, mock_setup, NULL);
@@ -1169,6 +2111,13 @@ make_test_suite (void)
 	tcase_add_test (tc_sendv, test_sendv_pass_004);
 	tcase_add_test (tc_sendv, test_sendv_fail_001);
 
+	TCase* tc_send_batch = tcase_create ("send-batch");
+	suite_add_tcase (s, tc_send_batch);
+	tcase_add_checked_fixture (tc_send_batch, mock_setup, NULL);
+	tcase_add_test (tc_send_batch, test_send_batch_pass_001);
+	tcase_add_test (tc_send_batch, test_send_batch_pass_002);
+	tcase_add_test (tc_send_batch, test_send_batch_fail_001);
+
 	TCase* tc_send_skbv = tcase_create ("send-skbv");
 	suite_add_tcase (s, tc_send_skbv);
 	tcase_add_checked_fixture (tc_send_skbv, mock_setup, NULL);
@@ -1176,14 +2125,35 @@ make_test_suite (void)
 	tcase_add_test (tc_send_skbv, test_send_skbv_pass_002);
 	tcase_add_test (tc_send_skbv, test_send_skbv_fail_001);
 
+	TCase* tc_odata_template = tcase_create ("odata-template");
+	suite_add_tcase (s, tc_odata_template);
+	tcase_add_checked_fixture (tc_odata_template, mock_setup, NULL);
+	tcase_add_test (tc_odata_template, test_odata_template_pass_001);
+	tcase_add_test (tc_odata_template, test_odata_template_pass_002);
+
 	TCase* tc_send_spm = tcase_create ("send-spm");
 	suite_add_tcase (s, tc_send_spm);
 	tcase_add_checked_fixture (tc_send_spm, mock_setup, NULL);
 	tcase_add_test (tc_send_spm, test_send_spm_pass_001);
+	tcase_add_test (tc_send_spm, test_send_spm_pass_002);
 #ifndef PGM_CHECK_NOFORK
 	tcase_add_test_raise_signal (tc_send_spm, test_send_spm_fail_001, SIGABRT);
 #endif
 
+	TCase* tc_fec_idle_flush = tcase_create ("fec-idle-flush");
+	suite_add_tcase (s, tc_fec_idle_flush);
+	tcase_add_checked_fixture (tc_fec_idle_flush, mock_setup, NULL);
+	tcase_add_test (tc_fec_idle_flush, test_fec_idle_flush_pass_001);
+	tcase_add_test (tc_fec_idle_flush, test_fec_idle_flush_pass_002);
+	tcase_add_test (tc_fec_idle_flush, test_fec_idle_flush_pass_003);
+	tcase_add_test (tc_fec_idle_flush, test_fec_idle_flush_pass_004);
+	tcase_add_test (tc_fec_idle_flush, test_fec_idle_flush_pass_005);
+	tcase_add_test (tc_fec_idle_flush, test_fec_idle_flush_pass_006);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_fec_idle_flush, test_fec_idle_flush_fail_001, SIGABRT);
+	tcase_add_test_raise_signal (tc_fec_idle_flush, test_fec_idle_flush_fail_002, SIGABRT);
+#endif
+
 	TCase* tc_on_deferred_nak = tcase_create ("on-deferred-nak");
 	suite_add_tcase (s, tc_on_deferred_nak);
 	tcase_add_checked_fixture (tc_on_deferred_nak, mock_setup, NULL);
@@ -1209,7 +2179,11 @@ make_test_suite (void)
 	tcase_add_test (tc_on_nak, test_on_nak_pass_002);
 	tcase_add_test (tc_on_nak, test_on_nak_pass_003);
 	tcase_add_test (tc_on_nak, test_on_nak_pass_004);
+	tcase_add_test (tc_on_nak, test_on_nak_pass_005);
+	tcase_add_test (tc_on_nak, test_on_nak_pass_006);
+	tcase_add_test (tc_on_nak, test_on_nak_pass_007);
 	tcase_add_test (tc_on_nak, test_on_nak_fail_001);
+	tcase_add_test (tc_on_nak, test_on_nak_fail_003);
 #ifndef PGM_CHECK_NOFORK
 	tcase_add_test_raise_signal (tc_on_nak, test_on_nak_fail_002, SIGABRT);
 #endif
@@ -0,0 +1,477 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Hot-standby source, the transmit window and sequence state of a primary
+ * mirrored to a standby over a side channel.
+ *
+ * Primary and standby bind the same TSI.  The primary copies every packet
+ * added to its transmit window and every SPM it sends, unchanged, in one UDP
+ * datagram to the standby.  The standby sends nothing and ignores NAKs whilst
+ * a thread of its own adds the mirrored packets to its transmit window with
+ * the sequence numbers of the primary, such that on takeover it continues
+ * the same sequence space with the recent history of the session in the
+ * window.  A mirrored packet lost on the side channel restarts the standby
+ * window at the following sequence number.
+ *
+ * Takeover is requested by the application, or made by the standby thread
+ * after a configured time without mirrored packets, which must exceed the
+ * ambient SPM interval of the primary.  The standby announces itself at once
+ * with a heartbeat SPM ahead of the SPM sequence of the primary, receivers
+ * move the NAK target of the source to the standby and repair any gap from
+ * its window.
+ *
+ * The side channel is plain unauthenticated UDP.  Anything accepted from it is
+ * added to the standby window and later sent as the source, and the SPM
+ * sequence of the takeover follows it, such that a forged datagram can inject
+ * data into the session or suppress the silence that triggers takeover.  The
+ * standby only accepts datagrams from the configured address of the primary,
+ * which the primary binds to, but source addresses are trivially spoofed off
+ * link: keep the side channel on a private link or behind a filter admitting
+ * only the primary.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <string.h>
+#ifndef _WIN32
+#	include <poll.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/standby.h>
+#include <impl/source.h>
+
+
+//#define STANDBY_DEBUG
+
+#ifndef STANDBY_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+static
+#ifndef _WIN32
+void*
+#else
+unsigned
+__stdcall
+#endif
+standby_routine (void*);
+
+/* open the side channel socket whilst privileges permit, called by
+ * pgm_setsockopt().
+ *
+ * returns the standby state, or NULL if the socket cannot be opened.
+ */
+
+PGM_GNUC_INTERNAL
+struct pgm_standby_t*
+pgm_standby_create (
+	pgm_sock_t*			 const restrict sock,
+	const struct pgm_standbyinfo_t*	 const restrict info
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != info);
+
+	const SOCKET side_sock = socket (info->addr.ss_family, SOCK_DGRAM, IPPROTO_UDP);
+	if (INVALID_SOCKET == side_sock)
+		return NULL;
+	struct pgm_standby_t* standby = pgm_new0 (struct pgm_standby_t, 1);
+	standby->side_sock = side_sock;
+	memcpy (&standby->addr, &info->addr, sizeof(struct sockaddr_storage));
+	memcpy (&standby->peer, &info->peer, sizeof(struct sockaddr_storage));
+	standby->is_mirror = !info->is_standby;
+	standby->timeout   = info->timeout;
+	return standby;
+}
+
+/* stop the standby thread and close the side channel, called by pgm_close()
+ * ahead of the transmit window.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_standby_destroy (
+	struct pgm_standby_t* const	standby
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != standby);
+
+	if (standby->has_thread) {
+		pgm_atomic_inc32 (&standby->is_terminated);
+#ifndef _WIN32
+		pthread_join (standby->thread, NULL);
+#else
+		WaitForSingleObject (standby->thread, INFINITE);
+		CloseHandle (standby->thread);
+#endif
+	}
+	if (INVALID_SOCKET != standby->side_sock) {
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Closing standby side channel socket."));
+		closesocket (standby->side_sock);
+	}
+	pgm_free (standby);
+}
+
+/* a primary mirrors to the standby address without blocking, from the peer
+ * address when set, a standby binds the side channel and starts the thread
+ * following the primary.  called by pgm_bind() once the transmit window exists.
+ *
+ * returns TRUE on success, or FALSE on error and sets error appropriately.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_standby_bind (
+	pgm_sock_t*    const restrict sock,
+	pgm_error_t**	     restrict error
+	)
+{
+	struct pgm_standby_t* standby = sock->standby;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != standby);
+	pgm_assert (NULL != sock->window);
+
+	pgm_sockaddr_nonblocking (standby->side_sock, TRUE);
+	if (standby->is_mirror) {
+		if (AF_UNSPEC != standby->peer.ss_family &&
+		    SOCKET_ERROR == bind (standby->side_sock,
+					  (struct sockaddr*)&standby->peer,
+					  pgm_sockaddr_len ((struct sockaddr*)&standby->peer)))
+		{
+			const int save_errno = pgm_get_last_sock_error();
+			char errbuf[1024];
+			char addr[INET6_ADDRSTRLEN];
+			pgm_sockaddr_ntop ((struct sockaddr*)&standby->peer, addr, sizeof(addr));
+			pgm_set_error (error,
+				       PGM_ERROR_DOMAIN_SOCKET,
+				       pgm_error_from_sock_errno (save_errno),
+				       _("Binding primary side channel socket to address %s: %s"),
+				       addr,
+				       pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+			return FALSE;
+		}
+		pgm_txw_set_mirror (sock->window, standby);
+		if (PGM_UNLIKELY(pgm_log_mask & PGM_LOG_ROLE_NETWORK)) {
+			char addr[INET6_ADDRSTRLEN];
+			pgm_sockaddr_ntop ((struct sockaddr*)&standby->addr, addr, sizeof(addr));
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Mirroring transmit window to standby %s port %u"),
+				   addr, (unsigned)ntohs (((struct sockaddr_in*)&standby->addr)->sin_port));
+		}
+		return TRUE;
+	}
+
+	if (SOCKET_ERROR == bind (standby->side_sock,
+				  (struct sockaddr*)&standby->addr,
+				  pgm_sockaddr_len ((struct sockaddr*)&standby->addr)))
+	{
+		const int save_errno = pgm_get_last_sock_error();
+		char errbuf[1024];
+		char addr[INET6_ADDRSTRLEN];
+		pgm_sockaddr_ntop ((struct sockaddr*)&standby->addr, addr, sizeof(addr));
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_sock_errno (save_errno),
+			       _("Binding standby side channel socket to address %s: %s"),
+			       addr,
+			       pgm_sock_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		return FALSE;
+	}
+	standby->last_heard = pgm_time_update_now();
+#ifndef _WIN32
+	const int status = pthread_create (&standby->thread, NULL, &standby_routine, sock);
+	if (0 != status) {
+		char errbuf[1024];
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_errno (status),
+			       _("Creating standby thread: %s"),
+			       pgm_strerror_s (errbuf, sizeof (errbuf), status));
+		return FALSE;
+	}
+#else
+	standby->thread = (HANDLE)_beginthreadex (NULL, 0, &standby_routine, sock, 0, NULL);
+	if (0 == standby->thread) {
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_errno (save_errno),
+			       _("Creating standby thread: %s"),
+			       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		return FALSE;
+	}
+#endif /* _WIN32 */
+	standby->has_thread = TRUE;
+	return TRUE;
+}
+
+/* copy one TPDU from the PGM header to the standby, a packet refused is
+ * recovered by the standby restarting its window.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_standby_mirror (
+	struct pgm_standby_t* const restrict standby,
+	const void*		    restrict tpdu,
+	const size_t			     tpdu_length
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != standby);
+	pgm_assert (NULL != tpdu);
+
+	const ssize_t sent = sendto (standby->side_sock,
+				     tpdu,
+				     tpdu_length,
+				     0,
+				     (const struct sockaddr*)&standby->addr,
+				     pgm_sockaddr_len ((const struct sockaddr*)&standby->addr));
+	if (PGM_LIKELY(sent >= 0))
+		standby->packets++;
+}
+
+/* stop following the primary and send as the source from the next sequence
+ * number, announcing the standby as path NLA with a heartbeat SPM.
+ *
+ * returns TRUE on success, FALSE if the socket is not a standby or has
+ * already taken over.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_standby_takeover (
+	pgm_sock_t* const	sock
+	)
+{
+	struct pgm_standby_t* standby = sock->standby;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	if (NULL == standby || standby->is_mirror)
+		return FALSE;
+
+	pgm_sock_mutex_lock (sock, &sock->source_mutex);
+	if (!sock->is_standby) {
+		pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+		return FALSE;
+	}
+	sock->spm_sqn = standby->spm_sqn + PGM_STANDBY_SPM_SQN_GAP;
+	sock->is_standby = FALSE;
+	pgm_atomic_inc32 (&standby->is_active);
+	pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+	pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Standby taking over the session at sequence %" PRIu32 "."),
+		   pgm_txw_next_lead (sock->window));
+
+	const pgm_time_t now = pgm_time_update_now();
+	pgm_sock_mutex_lock (sock, &sock->timer_mutex);
+	sock->spm_heartbeat_state = 1;
+	sock->next_heartbeat_spm = now + sock->spm_heartbeat_interval[sock->spm_heartbeat_state++];
+	sock->next_poll = MIN(sock->next_poll, sock->next_heartbeat_spm);
+	pgm_sock_mutex_unlock (sock, &sock->timer_mutex);
+	if (!pgm_send_spm (sock, 0))
+		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Takeover SPM would block, left to the heartbeat timer."));
+	return TRUE;
+}
+
+/* add one mirrored original data packet to the window, restarting the window
+ * when the sequence number does not follow the lead.  caller holds
+ * source_mutex.
+ */
+
+static
+void
+standby_add (
+	pgm_sock_t* const restrict	sock,
+	const char* const restrict	buf,
+	const size_t			len
+	)
+{
+	struct pgm_standby_t* standby = sock->standby;
+	const struct pgm_header* header = (const struct pgm_header*)buf;
+	const struct pgm_data*   data   = (const struct pgm_data*)(header + 1);
+
+	if (PGM_UNLIKELY(len < sizeof(struct pgm_header) + sizeof(struct pgm_data)))
+		return;
+	const uint16_t tsdu_length = pgm_ntohs (header->pgm_tsdu_length);
+	const size_t header_length = len - tsdu_length;
+	if (PGM_UNLIKELY(tsdu_length > len ||
+			 header_length < sizeof(struct pgm_header) + sizeof(struct pgm_data) ||
+			 len > sock->max_tpdu))
+	{
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded malformed mirrored packet."));
+		return;
+	}
+
+	const uint32_t sequence = pgm_ntohl (data->data_sqn);
+	const uint32_t next_lead = pgm_txw_next_lead (sock->window);
+	if (sequence != next_lead) {
+		if (!pgm_txw_is_empty (sock->window) && pgm_uint32_lt (sequence, next_lead))
+			return;
+		if (!pgm_txw_is_empty (sock->window)) {
+			pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Standby restarting window at sequence %" PRIu32 " after %" PRIu32 " lost mirrored packets."),
+				   sequence, sequence - next_lead);
+			standby->gaps++;
+		}
+		pgm_txw_reset (sock->window, sequence);
+	}
+
+	struct pgm_sk_buff_t* skb = pgm_txw_alloc_skb (sock->window, sock->skb_pool, sock->max_tpdu);
+	skb->sock   = sock;
+	skb->tstamp = pgm_time_update_now();
+	pgm_skb_reserve (skb, (uint16_t)header_length);
+	pgm_skb_put (skb, tsdu_length);
+	memcpy (skb->head, buf, len);
+	skb->pgm_header = (struct pgm_header*)skb->head;
+	skb->pgm_data   = (struct pgm_data*)(skb->pgm_header + 1);
+	pgm_txw_set_unfolded_checksum (skb, sock->use_zero_checksum ? 0 : pgm_csum_partial (skb->data, tsdu_length, 0));
+	pgm_txw_add (sock->window, skb);
+}
+
+/* only the configured primary, any port when the peer port is zero */
+
+static inline
+bool
+standby_is_peer (
+	const struct pgm_standby_t* const restrict standby,
+	const struct sockaddr*	    const restrict from
+	)
+{
+	const struct sockaddr* peer = (const struct sockaddr*)&standby->peer;
+	if (0 != pgm_sockaddr_cmp (from, peer))
+		return FALSE;
+	return 0 == pgm_sockaddr_port (peer) || pgm_sockaddr_port (from) == pgm_sockaddr_port (peer);
+}
+
+static
+void
+standby_on_mirror (
+	pgm_sock_t*	       const restrict sock,
+	const struct sockaddr* const restrict from,
+	const char*	       const restrict buf,
+	const size_t			      len
+	)
+{
+	struct pgm_standby_t* standby = sock->standby;
+	const struct pgm_header* header = (const struct pgm_header*)buf;
+
+	if (PGM_UNLIKELY(!standby_is_peer (standby, from))) {
+		if (PGM_UNLIKELY(pgm_log_mask & PGM_LOG_ROLE_NETWORK)) {
+			char addr[INET6_ADDRSTRLEN];
+			pgm_sockaddr_ntop (from, addr, sizeof(addr));
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded side channel packet from %s, not the primary."), addr);
+		}
+		standby->refused++;
+		return;
+	}
+	if (PGM_UNLIKELY(len < sizeof(struct pgm_header)))
+		return;
+	if (PGM_UNLIKELY(0 != memcmp (header->pgm_gsi, &sock->tsi.gsi, sizeof(pgm_gsi_t)) ||
+			 header->pgm_sport != sock->tsi.sport))
+	{
+		pgm_trace (PGM_LOG_ROLE_NETWORK,_("Discarded mirrored packet of another TSI."));
+		return;
+	}
+	standby->last_heard = pgm_time_update_now();
+	standby->packets++;
+
+	switch (header->pgm_type) {
+	case PGM_SPM:
+		if (PGM_LIKELY(len >= sizeof(struct pgm_header) + sizeof(struct pgm_spm)))
+			standby->spm_sqn = pgm_ntohl (((const struct pgm_spm*)(header + 1))->spm_sqn);
+		break;
+
+	case PGM_ODATA:
+		pgm_sock_mutex_lock (sock, &sock->source_mutex);
+		if (sock->is_standby)
+			standby_add (sock, buf, len);
+		pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+		break;
+
+	default:
+		break;
+	}
+}
+
+static
+#ifndef _WIN32
+void*
+#else
+unsigned
+__stdcall
+#endif
+standby_routine (
+	void*		arg
+	)
+{
+	pgm_sock_t* sock = arg;
+	struct pgm_standby_t* standby = sock->standby;
+	char* buf = pgm_malloc (sock->max_tpdu);
+
+	pgm_thread_setup ("standby");
+	while (!pgm_atomic_read32 (&standby->is_terminated) && sock->is_standby)
+	{
+#ifndef _WIN32
+		struct pollfd fds = {
+			.fd	= standby->side_sock,
+			.events	= POLLIN
+		};
+		const int ready = poll (&fds, 1, (int)pgm_to_msecs (PGM_STANDBY_POLL_IVL));
+#else
+		WSAPOLLFD fds = {
+			.fd	= standby->side_sock,
+			.events	= POLLRDNORM
+		};
+		const int ready = WSAPoll (&fds, 1, (int)pgm_to_msecs (PGM_STANDBY_POLL_IVL));
+#endif
+		if (ready > 0) {
+			struct sockaddr_storage from;
+			socklen_t fromlen = sizeof (from);
+			ssize_t len;
+			while ((len = recvfrom (standby->side_sock, buf, sock->max_tpdu, 0, (struct sockaddr*)&from, &fromlen)) > 0) {
+				standby_on_mirror (sock, (const struct sockaddr*)&from, buf, (size_t)len);
+				fromlen = sizeof (from);
+			}
+		}
+		if (standby->timeout > 0 &&
+		    pgm_time_after (pgm_time_update_now(), standby->last_heard + standby->timeout))
+		{
+			pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("No mirrored packets from the primary for %" PGM_TIME_FORMAT " usec."),
+				   (pgm_time_t)standby->timeout);
+			pgm_standby_takeover (sock);
+		}
+	}
+	pgm_free (buf);
+
+#ifndef _WIN32
+	return NULL;
+#else
+	_endthread();
+	return 0;
+#endif
+}
+
+/* eof */
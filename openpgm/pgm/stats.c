@@ -0,0 +1,589 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Statistics export: counter names and the shared-memory statistics segment.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#	include <fcntl.h>
+#	include <poll.h>
+#	include <pthread.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <sys/time.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/socket.h>
+#include <impl/sock_registry.h>
+#include <impl/stats.h>
+
+
+//#define STATS_DEBUG
+
+
+/* globals */
+
+const struct pgm_counter_name_t pgm_source_counter_names[PGM_PC_SOURCE_MAX] = {
+	[PGM_PC_SOURCE_DATA_BYTES_SENT]			= { "data_bytes_sent", FALSE },
+	[PGM_PC_SOURCE_DATA_MSGS_SENT]			= { "data_msgs_sent", FALSE },
+	[PGM_PC_SOURCE_BYTES_SENT]			= { "bytes_sent", FALSE },
+	[PGM_PC_SOURCE_CKSUM_ERRORS]			= { "cksum_errors", FALSE },
+	[PGM_PC_SOURCE_MALFORMED_NAKS]			= { "malformed_naks", FALSE },
+	[PGM_PC_SOURCE_PACKETS_DISCARDED]		= { "packets_discarded", FALSE },
+	[PGM_PC_SOURCE_PARITY_BYTES_RETRANSMITTED]	= { "parity_bytes_retransmitted", FALSE },
+	[PGM_PC_SOURCE_SELECTIVE_BYTES_RETRANSMITTED]	= { "selective_bytes_retransmitted", FALSE },
+	[PGM_PC_SOURCE_PARITY_MSGS_RETRANSMITTED]	= { "parity_msgs_retransmitted", FALSE },
+	[PGM_PC_SOURCE_SELECTIVE_MSGS_RETRANSMITTED]	= { "selective_msgs_retransmitted", FALSE },
+	[PGM_PC_SOURCE_PARITY_NAK_PACKETS_RECEIVED]	= { "parity_nak_packets_received", FALSE },
+	[PGM_PC_SOURCE_SELECTIVE_NAK_PACKETS_RECEIVED]	= { "selective_nak_packets_received", FALSE },
+	[PGM_PC_SOURCE_PARITY_NAKS_RECEIVED]		= { "parity_naks_received", FALSE },
+	[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED]		= { "selective_naks_received", FALSE },
+	[PGM_PC_SOURCE_PARITY_NAKS_IGNORED]		= { "parity_naks_ignored", FALSE },
+	[PGM_PC_SOURCE_SELECTIVE_NAKS_IGNORED]		= { "selective_naks_ignored", FALSE },
+	[PGM_PC_SOURCE_ACK_ERRORS]			= { "ack_errors", FALSE },
+	[PGM_PC_SOURCE_TRANSMISSION_CURRENT_RATE]	= { "transmission_current_rate", TRUE },
+	[PGM_PC_SOURCE_ACK_PACKETS_RECEIVED]		= { "ack_packets_received", FALSE },
+	[PGM_PC_SOURCE_PARITY_NNAK_PACKETS_RECEIVED]	= { "parity_nnak_packets_received", FALSE },
+	[PGM_PC_SOURCE_SELECTIVE_NNAK_PACKETS_RECEIVED]	= { "selective_nnak_packets_received", FALSE },
+	[PGM_PC_SOURCE_PARITY_NNAKS_RECEIVED]		= { "parity_nnaks_received", FALSE },
+	[PGM_PC_SOURCE_SELECTIVE_NNAKS_RECEIVED]	= { "selective_nnaks_received", FALSE },
+	[PGM_PC_SOURCE_NNAK_ERRORS]			= { "nnak_errors", FALSE },
+	[PGM_PC_SOURCE_RATE_STALLS]			= { "rate_stalls", FALSE },
+	[PGM_PC_SOURCE_RATE_STALL_USECS]		= { "rate_stall_usecs", FALSE },
+	[PGM_PC_SOURCE_ODATA_RATE_STALLS]		= { "odata_rate_stalls", FALSE },
+	[PGM_PC_SOURCE_ODATA_RATE_STALL_USECS]		= { "odata_rate_stall_usecs", FALSE },
+	[PGM_PC_SOURCE_CONGESTION_STALLS]		= { "congestion_stalls", FALSE },
+	[PGM_PC_SOURCE_CONGESTION_STALL_USECS]		= { "congestion_stall_usecs", FALSE },
+	[PGM_PC_SOURCE_SNDBUF_STALLS]			= { "sndbuf_stalls", FALSE },
+	[PGM_PC_SOURCE_SNDBUF_STALL_USECS]		= { "sndbuf_stall_usecs", FALSE },
+	[PGM_PC_SOURCE_NAKS_RATE_LIMITED]		= { "naks_rate_limited", FALSE },
+	[PGM_PC_SOURCE_PATHOLOGICAL_NAKERS]		= { "pathological_nakers", FALSE },
+	[PGM_PC_SOURCE_SPMS_SENT]			= { "spms_sent", FALSE },
+	[PGM_PC_SOURCE_SPMS_SUPPRESSED]			= { "spms_suppressed", FALSE },
+	[PGM_PC_SOURCE_ASYNC_QUEUE_FULL]		= { "async_queue_full", FALSE }
+};
+
+const struct pgm_counter_name_t pgm_receiver_counter_names[PGM_PC_RECEIVER_MAX] = {
+	[PGM_PC_RECEIVER_DATA_BYTES_RECEIVED]		= { "data_bytes_received", FALSE },
+	[PGM_PC_RECEIVER_DATA_MSGS_RECEIVED]		= { "data_msgs_received", FALSE },
+	[PGM_PC_RECEIVER_NAK_FAILURES]			= { "nak_failures", FALSE },
+	[PGM_PC_RECEIVER_BYTES_RECEIVED]		= { "bytes_received", FALSE },
+	[PGM_PC_RECEIVER_MALFORMED_SPMS]		= { "malformed_spms", FALSE },
+	[PGM_PC_RECEIVER_MALFORMED_ODATA]		= { "malformed_odata", FALSE },
+	[PGM_PC_RECEIVER_MALFORMED_RDATA]		= { "malformed_rdata", FALSE },
+	[PGM_PC_RECEIVER_MALFORMED_NCFS]		= { "malformed_ncfs", FALSE },
+	[PGM_PC_RECEIVER_PACKETS_DISCARDED]		= { "packets_discarded", FALSE },
+	[PGM_PC_RECEIVER_LOSSES]			= { "losses", FALSE },
+	[PGM_PC_RECEIVER_DUP_SPMS]			= { "dup_spms", FALSE },
+	[PGM_PC_RECEIVER_DUP_DATAS]			= { "dup_datas", FALSE },
+	[PGM_PC_RECEIVER_PARITY_NAK_PACKETS_SENT]	= { "parity_nak_packets_sent", FALSE },
+	[PGM_PC_RECEIVER_SELECTIVE_NAK_PACKETS_SENT]	= { "selective_nak_packets_sent", FALSE },
+	[PGM_PC_RECEIVER_PARITY_NAKS_SENT]		= { "parity_naks_sent", FALSE },
+	[PGM_PC_RECEIVER_SELECTIVE_NAKS_SENT]		= { "selective_naks_sent", FALSE },
+	[PGM_PC_RECEIVER_PARITY_NAKS_RETRANSMITTED]	= { "parity_naks_retransmitted", FALSE },
+	[PGM_PC_RECEIVER_SELECTIVE_NAKS_RETRANSMITTED]	= { "selective_naks_retransmitted", FALSE },
+	[PGM_PC_RECEIVER_PARITY_NAKS_FAILED]		= { "parity_naks_failed", FALSE },
+	[PGM_PC_RECEIVER_SELECTIVE_NAKS_FAILED]		= { "selective_naks_failed", FALSE },
+	[PGM_PC_RECEIVER_NAKS_FAILED_RXW_ADVANCED]	= { "naks_failed_rxw_advanced", FALSE },
+	[PGM_PC_RECEIVER_NAKS_FAILED_NCF_RETRIES_EXCEEDED] = { "naks_failed_ncf_retries_exceeded", FALSE },
+	[PGM_PC_RECEIVER_NAKS_FAILED_DATA_RETRIES_EXCEEDED] = { "naks_failed_data_retries_exceeded", FALSE },
+	[PGM_PC_RECEIVER_NAK_FAILURES_DELIVERED]	= { "nak_failures_delivered", FALSE },
+	[PGM_PC_RECEIVER_SELECTIVE_NAKS_SUPPRESSED]	= { "selective_naks_suppressed", FALSE },
+	[PGM_PC_RECEIVER_NAK_ERRORS]			= { "nak_errors", FALSE },
+	[PGM_PC_RECEIVER_NAK_SVC_TIME_MEAN]		= { "nak_svc_time_mean", TRUE },
+	[PGM_PC_RECEIVER_NAK_FAIL_TIME_MEAN]		= { "nak_fail_time_mean", TRUE },
+	[PGM_PC_RECEIVER_TRANSMIT_MEAN]			= { "transmit_mean", TRUE },
+	[PGM_PC_RECEIVER_ACKS_SENT]			= { "acks_sent", FALSE },
+	[PGM_PC_RECEIVER_DEADLINE_DROPS]		= { "deadline_drops", FALSE },
+	[PGM_PC_RECEIVER_PEER_REPAIRS_SENT]		= { "peer_repairs_sent", FALSE },
+	[PGM_PC_RECEIVER_MSGS_CONFLATED]		= { "msgs_conflated", FALSE }
+};
+
+
+#ifndef _WIN32
+static volatile uint32_t	stats_ref_count = 0;
+static char*			stats_name = NULL;
+static struct pgm_stats_shm_t*	stats_shm = NULL;
+static size_t			stats_len = 0;
+static pgm_notify_t		stats_notify = PGM_NOTIFY_INIT;
+static pthread_t		stats_thread;
+
+static void* stats_routine (void*);
+static void stats_publish (struct pgm_stats_shm_t*const);
+
+
+/* create the named segment and start the publisher thread, a NULL name
+ * selects "/pgm-stats.<pid>".
+ *
+ * returns TRUE on success, returns FALSE on error and sets error.
+ */
+
+bool
+pgm_stats_shm_init (
+	const char*		name,
+	pgm_error_t**		error
+	)
+{
+	struct pgm_stats_shm_t* shm;
+	int fd = -1;
+
+	if (pgm_atomic_exchange_and_add32 (&stats_ref_count, 1) > 0)
+		return TRUE;
+
+	if (NULL == name || '\0' == *name) {
+		char buf[64];
+		pgm_snprintf_s (buf, sizeof (buf), _TRUNCATE, "/pgm-stats.%d", (int)getpid());
+		stats_name = pgm_strdup (buf);
+	} else {
+		stats_name = pgm_strdup (name);
+	}
+
+	const size_t names_len = (PGM_PC_SOURCE_MAX + PGM_PC_RECEIVER_MAX) * sizeof (struct pgm_stats_name_t);
+	const size_t sock_len  = sizeof (struct pgm_stats_sock_t) + PGM_PC_SOURCE_MAX * sizeof (uint64_t);
+	const size_t peer_len  = sizeof (struct pgm_stats_peer_t) + PGM_PC_RECEIVER_MAX * sizeof (uint64_t);
+	stats_len = sizeof (struct pgm_stats_shm_t) + names_len +
+		    PGM_STATS_SHM_MAX_SOCKS * sock_len +
+		    PGM_STATS_SHM_MAX_PEERS * peer_len;
+
+	fd = shm_open (stats_name, O_CREAT | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (-1 == fd || 0 != ftruncate (fd, stats_len)) {
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			     PGM_ERROR_DOMAIN_ENGINE,
+			     pgm_error_from_errno (save_errno),
+			     _("Creating statistics segment %s: %s"),
+			     stats_name,
+			     pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		goto err_cleanup;
+	}
+	shm = mmap (NULL, stats_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close (fd);
+	if (MAP_FAILED == shm) {
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			     PGM_ERROR_DOMAIN_ENGINE,
+			     pgm_error_from_errno (save_errno),
+			     _("Mapping statistics segment %s: %s"),
+			     stats_name,
+			     pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		goto err_cleanup;
+	}
+
+/* fixed layout and names, published with the magic */
+	shm->version		= PGM_STATS_SHM_VERSION;
+	shm->pid		= (uint32_t)getpid();
+	shm->source_counters	= PGM_PC_SOURCE_MAX;
+	shm->receiver_counters	= PGM_PC_RECEIVER_MAX;
+	shm->max_socks		= PGM_STATS_SHM_MAX_SOCKS;
+	shm->max_peers		= PGM_STATS_SHM_MAX_PEERS;
+	shm->names_offset	= sizeof (struct pgm_stats_shm_t);
+	shm->socks_offset	= (uint32_t)(shm->names_offset + names_len);
+	shm->sock_len		= (uint32_t)sock_len;
+	shm->peers_offset	= (uint32_t)(shm->socks_offset + PGM_STATS_SHM_MAX_SOCKS * sock_len);
+	shm->peer_len		= (uint32_t)peer_len;
+	struct pgm_stats_name_t* names = (struct pgm_stats_name_t*)pgm_stats_shm_names (shm);
+	for (unsigned i = 0; i < PGM_PC_SOURCE_MAX; i++, names++) {
+		if (NULL != pgm_source_counter_names[ i ].name)
+			pgm_strncpy_s (names->name, sizeof (names->name), pgm_source_counter_names[ i ].name, _TRUNCATE);
+		names->is_gauge = pgm_source_counter_names[ i ].is_gauge;
+	}
+	for (unsigned i = 0; i < PGM_PC_RECEIVER_MAX; i++, names++) {
+		if (NULL != pgm_receiver_counter_names[ i ].name)
+			pgm_strncpy_s (names->name, sizeof (names->name), pgm_receiver_counter_names[ i ].name, _TRUNCATE);
+		names->is_gauge = pgm_receiver_counter_names[ i ].is_gauge;
+	}
+	stats_publish (shm);
+	pgm_atomic_write32_release (&shm->magic, PGM_STATS_SHM_MAGIC);
+	stats_shm = shm;
+
+	if (0 != pgm_notify_init (&stats_notify)) {
+		const int save_errno = errno;
+		char errbuf[1024];
+		pgm_set_error (error,
+			     PGM_ERROR_DOMAIN_ENGINE,
+			     pgm_error_from_errno (save_errno),
+			     _("Creating statistics notification channel: %s"),
+			     pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+		goto err_cleanup;
+	}
+
+	const int status = pthread_create (&stats_thread, NULL, &stats_routine, NULL);
+	if (0 != status) {
+		char errbuf[1024];
+		pgm_set_error (error,
+			     PGM_ERROR_DOMAIN_ENGINE,
+			     pgm_error_from_errno (status),
+			     _("Creating statistics thread: %s"),
+			     pgm_strerror_s (errbuf, sizeof (errbuf), status));
+		goto err_cleanup;
+	}
+	pgm_minor (_("Publishing statistics to shared memory segment %s."), stats_name);
+	return TRUE;
+
+err_cleanup:
+	if (pgm_notify_is_valid (&stats_notify))
+		pgm_notify_destroy (&stats_notify);
+	if (NULL != stats_shm) {
+		munmap (stats_shm, stats_len);
+		stats_shm = NULL;
+	}
+	if (-1 != fd)
+		shm_unlink (stats_name);
+	pgm_free (stats_name);
+	stats_name = NULL;
+	pgm_atomic_dec32 (&stats_ref_count);
+	return FALSE;
+}
+
+/* stop the publisher and remove the segment, mapped readers keep their
+ * final copy.
+ */
+
+bool
+pgm_stats_shm_shutdown (void)
+{
+	pgm_return_val_if_fail (pgm_atomic_read32 (&stats_ref_count) > 0, FALSE);
+
+	if (pgm_atomic_exchange_and_add32 (&stats_ref_count, (uint32_t)-1) != 1)
+		return TRUE;
+
+	pgm_notify_send (&stats_notify);
+	pthread_join (stats_thread, NULL);
+	pgm_notify_destroy (&stats_notify);
+	munmap (stats_shm, stats_len);
+	stats_shm = NULL;
+	shm_unlink (stats_name);
+	pgm_free (stats_name);
+	stats_name = NULL;
+	return TRUE;
+}
+
+static
+void*
+stats_routine (
+	PGM_GNUC_UNUSED void*	arg
+	)
+{
+	struct pollfd fds = {
+		.fd	= pgm_notify_get_socket (&stats_notify),
+		.events	= POLLIN
+	};
+
+	pgm_thread_setup ("stats");
+	for (;;) {
+		const int ready = poll (&fds, 1, PGM_STATS_SHM_INTERVAL);
+		if (ready > 0 || (-1 == ready && EINTR != errno))
+			break;
+		stats_publish (stats_shm);
+	}
+	return NULL;
+}
+
+/* copy every socket and peer into the segment under the seqlock.  the
+ * hosting process locks are taken only by this thread, never by readers.
+ */
+
+static
+void
+stats_publish (
+	struct pgm_stats_shm_t*const	shm
+	)
+{
+	struct timeval now;
+	unsigned sock_count = 0, peer_count = 0, dropped = 0;
+	const uint32_t seq = shm->sequence;
+
+	pgm_atomic_write32 (&shm->sequence, seq + 1);
+	pgm_atomic_fence_release ();
+
+	unsigned epoch;
+	const pgm_sock_registry_t* registry = pgm_sock_registry_enter (&epoch);
+	for (unsigned n = 0; n < registry->len; n++)
+	{
+		pgm_sock_t* sock = registry->socks[ n ];
+		if (sock_count == shm->max_socks) {
+			dropped++;
+			continue;
+		}
+		struct pgm_stats_sock_t* s = (struct pgm_stats_sock_t*)pgm_stats_shm_sock (shm, sock_count);
+		pgm_tsi_print_r (&sock->tsi, s->tsi, sizeof (s->tsi));
+		s->is_source = (NULL != sock->window);
+		if (s->is_source) {
+			s->txw_length	  = pgm_txw_length (sock->window);
+			s->txw_max_length = pgm_txw_max_length (sock->window);
+			s->txw_size	  = pgm_txw_size (sock->window);
+		} else
+			s->txw_length = s->txw_max_length = s->txw_size = 0;
+		s->mem_used   = pgm_atomic_read64 (&sock->mem_budget.used);
+		s->mem_budget = sock->mem_budget.max;
+		s->rx_cpu     = (NULL != sock->rx_shard) ? sock->rx_shard[ 0 ].rx_cpu : -1;
+		for (unsigned i = 0; i < PGM_PC_SOURCE_MAX; i++)
+			s->stats[ i ] = pgm_atomic_read64 (&sock->cumulative_stats[ i ]);
+		s->peer_first = peer_count;
+		pgm_rwlock_reader_lock (&sock->peers_lock);
+		for (pgm_list_t* peers = sock->peers_list; peers; peers = peers->next)
+		{
+			const pgm_peer_t* peer = peers->data;
+			if (peer_count == shm->max_peers) {
+				dropped++;
+				continue;
+			}
+			struct pgm_stats_peer_t* p = (struct pgm_stats_peer_t*)pgm_stats_shm_peer (shm, peer_count++);
+			pgm_tsi_print_r (&peer->tsi, p->tsi, sizeof (p->tsi));
+			p->sock_index	  = sock_count;
+			p->rxw_length	  = pgm_rxw_length (peer->window);
+			p->rxw_max_length = pgm_rxw_max_length (peer->window);
+			p->rxw_size	  = pgm_rxw_size (peer->window);
+			for (unsigned i = 0; i < PGM_PC_RECEIVER_MAX; i++)
+				p->stats[ i ] = pgm_atomic_read64 (&peer->cumulative_stats[ i ]);
+		}
+		pgm_rwlock_reader_unlock (&sock->peers_lock);
+		s->peer_count = peer_count - s->peer_first;
+		sock_count++;
+	}
+	pgm_sock_registry_leave (epoch);
+
+	gettimeofday (&now, NULL);
+	shm->sock_count  = sock_count;
+	shm->peer_count  = peer_count;
+	shm->dropped	 = dropped;
+	shm->update_time = (uint64_t)now.tv_sec * 1000000 + now.tv_usec;
+
+	pgm_atomic_write32_release (&shm->sequence, seq + 2);
+}
+
+#else /* _WIN32 */
+
+bool
+pgm_stats_shm_init (
+	PGM_GNUC_UNUSED const char*	name,
+	pgm_error_t**			error
+	)
+{
+	pgm_set_error (error,
+		     PGM_ERROR_DOMAIN_ENGINE,
+		     PGM_ERROR_NOSYS,
+		     _("Shared memory statistics are not supported on this platform."));
+	return FALSE;
+}
+
+bool
+pgm_stats_shm_shutdown (void)
+{
+	return FALSE;
+}
+
+#endif /* _WIN32 */
+
+/* append one sample of the counters in value, overwriting the oldest once the
+ * ring is full.  called by the sampler thread alone.
+ */
+
+void
+pgm_stats_ring_sample (
+	struct pgm_stats_ring_t* const restrict ring,
+	const uint64_t*		 const restrict value,
+	const pgm_time_t			now
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != ring);
+	pgm_assert (NULL != value);
+
+	const uint32_t seq = ring->sequence;
+	const unsigned slot = ring->count % PGM_STATS_RING_LEN;
+	pgm_atomic_write32 (&ring->sequence, seq + 1);
+	pgm_atomic_fence_release ();
+	ring->tstamp[ slot ] = now;
+	memcpy (ring->value[ slot ], value, sizeof (ring->value[ slot ]));
+	ring->count++;
+	pgm_atomic_write32_release (&ring->sequence, seq + 2);
+}
+
+/* per second rates over the most recent samples spanning up to interval
+ * seconds, fewer when the ring holds less history.
+ *
+ * returns seconds covered, returns 0 with rates zeroed before two samples.
+ */
+
+unsigned
+pgm_stats_ring_rates (
+	const struct pgm_stats_ring_t* const restrict ring,
+	const unsigned				      interval,
+	uint64_t*		       const restrict rates
+	)
+{
+	uint64_t newest[PGM_STATS_RATE_MAX], oldest[PGM_STATS_RATE_MAX];
+	pgm_time_t newest_tstamp, oldest_tstamp;
+	unsigned span;
+	uint32_t seq;
+
+/* pre-conditions */
+	pgm_assert (NULL != ring);
+	pgm_assert (NULL != rates);
+
+	do {
+		while ((seq = pgm_atomic_read32_acquire (&ring->sequence)) & 1)
+			;
+		const uint32_t count = ring->count;
+		span = count > 0 ? count - 1 : 0;
+		if (span > interval)
+			span = interval;
+		if (span > PGM_STATS_RING_LEN - 1)
+			span = PGM_STATS_RING_LEN - 1;
+		if (0 == span)
+			break;
+		const unsigned head = (count - 1) % PGM_STATS_RING_LEN;
+		const unsigned tail = (count - 1 - span) % PGM_STATS_RING_LEN;
+		newest_tstamp = ring->tstamp[ head ];
+		oldest_tstamp = ring->tstamp[ tail ];
+		memcpy (newest, ring->value[ head ], sizeof (newest));
+		memcpy (oldest, ring->value[ tail ], sizeof (oldest));
+		pgm_atomic_fence_acquire ();
+	} while (pgm_atomic_read32 (&ring->sequence) != seq);
+
+	if (0 == span || !pgm_time_after (newest_tstamp, oldest_tstamp)) {
+		memset (rates, 0, PGM_STATS_RATE_MAX * sizeof (uint64_t));
+		return 0;
+	}
+	const pgm_time_t elapsed = newest_tstamp - oldest_tstamp;
+	for (unsigned i = 0; i < PGM_STATS_RATE_MAX; i++)
+		rates[ i ] = (newest[ i ] - oldest[ i ]) * pgm_secs(1) / elapsed;
+	return span;
+}
+
+#ifndef _WIN32
+static pgm_notify_t		sampler_notify = PGM_NOTIFY_INIT;
+static pthread_t		sampler_thread;
+
+static void* sampler_routine (void*);
+
+/* start the thread sampling every socket and peer once a second.
+ *
+ * returns TRUE on success, returns FALSE if the thread cannot be created.
+ */
+
+bool
+pgm_stats_sampler_init (void)
+{
+	if (0 != pgm_notify_init (&sampler_notify))
+		return FALSE;
+	if (0 != pthread_create (&sampler_thread, NULL, &sampler_routine, NULL)) {
+		pgm_notify_destroy (&sampler_notify);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+void
+pgm_stats_sampler_shutdown (void)
+{
+	pgm_notify_send (&sampler_notify);
+	pthread_join (sampler_thread, NULL);
+	pgm_notify_destroy (&sampler_notify);
+}
+
+/* sample the counters of every socket and its peers, peers are held by the
+ * peers lock and sockets by the registry read section.
+ */
+
+static
+void
+sampler_sweep (void)
+{
+	uint64_t value[PGM_STATS_RATE_MAX];
+	unsigned epoch;
+
+	const pgm_time_t now = pgm_time_update_now();
+	const pgm_sock_registry_t* registry = pgm_sock_registry_enter (&epoch);
+	for (unsigned n = 0; n < registry->len; n++)
+	{
+		pgm_sock_t* sock = registry->socks[ n ];
+		if (NULL != sock->rates) {
+			value[PGM_STATS_RATE_PACKETS] = pgm_atomic_read64 (&sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT]);
+			value[PGM_STATS_RATE_BYTES]   = pgm_atomic_read64 (&sock->cumulative_stats[PGM_PC_SOURCE_DATA_BYTES_SENT]);
+			value[PGM_STATS_RATE_NAKS]    = pgm_atomic_read64 (&sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED]) +
+							pgm_atomic_read64 (&sock->cumulative_stats[PGM_PC_SOURCE_PARITY_NAKS_RECEIVED]);
+			value[PGM_STATS_RATE_LOSSES]  = 0;
+			pgm_stats_ring_sample (sock->rates, value, now);
+		}
+		pgm_rwlock_reader_lock (&sock->peers_lock);
+		for (pgm_list_t* peers = sock->peers_list; peers; peers = peers->next)
+		{
+			pgm_peer_t* peer = peers->data;
+			if (NULL == peer->rates)
+				continue;
+			value[PGM_STATS_RATE_PACKETS] = pgm_atomic_read64 (&peer->cumulative_stats[PGM_PC_RECEIVER_DATA_MSGS_RECEIVED]);
+			value[PGM_STATS_RATE_BYTES]   = pgm_atomic_read64 (&peer->cumulative_stats[PGM_PC_RECEIVER_DATA_BYTES_RECEIVED]);
+			value[PGM_STATS_RATE_NAKS]    = pgm_atomic_read64 (&peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SENT]) +
+							pgm_atomic_read64 (&peer->cumulative_stats[PGM_PC_RECEIVER_PARITY_NAKS_SENT]);
+			value[PGM_STATS_RATE_LOSSES]  = pgm_atomic_read64 (&peer->cumulative_stats[PGM_PC_RECEIVER_LOSSES]);
+			pgm_stats_ring_sample (peer->rates, value, now);
+		}
+		pgm_rwlock_reader_unlock (&sock->peers_lock);
+	}
+	pgm_sock_registry_leave (epoch);
+}
+
+static
+void*
+sampler_routine (
+	PGM_GNUC_UNUSED void*	arg
+	)
+{
+	struct pollfd fds = {
+		.fd	= pgm_notify_get_socket (&sampler_notify),
+		.events	= POLLIN
+	};
+
+	pgm_thread_setup ("sampler");
+	for (;;) {
+		const int ready = poll (&fds, 1, PGM_STATS_RING_INTERVAL);
+		if (ready > 0 || (-1 == ready && EINTR != errno))
+			break;
+		sampler_sweep ();
+	}
+	return NULL;
+}
+
+#else /* _WIN32 */
+
+bool
+pgm_stats_sampler_init (void)
+{
+	return FALSE;
+}
+
+void
+pgm_stats_sampler_shutdown (void)
+{
+}
+
+#endif /* _WIN32 */
+
+/* eof */
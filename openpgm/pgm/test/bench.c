@@ -0,0 +1,678 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * PGM loss recovery benchmark: one source and a number of receiver processes
+ * on the local host, with loss injected on every receiver.
+ *
+ * Receivers are forked before the engine starts so each draws its own loss
+ * from PGM_LOSS_RATE and PGM_LOSS_BURST, the library must be a debug build or
+ * built with WITH_LOSS_INJECTION.  Messages carry their send time so
+ * delivery latency, including head-of-line blocking behind repairs, is
+ * measured against the same monotonic clock.
+ *
+ * The network parameter selects loopback or a veth pair.  PGM/IP is the
+ * default as with UDP encapsulation every process on the host binds the one
+ * port NAKs are unicast to.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#       include <config.h>
+#endif
+
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <glib.h>
+#include <impl/framework.h>
+#include <impl/socket.h>
+#include <impl/source.h>
+#include <impl/receiver.h>
+#include <pgm/pgm.h>
+
+
+/* typedefs */
+
+/* prefix of every message, the remainder is padding */
+struct bench_header_t {
+	guint32			sequence;
+	guint32			reserved;
+	guint64			tstamp;			/* μs, CLOCK_MONOTONIC */
+};
+
+/* written by each receiver to the result pipe, smaller than PIPE_BUF */
+struct bench_result_t {
+	guint			id;
+	guint64			msgs;
+	guint64			bytes;
+	guint64			first_tstamp;
+	guint64			last_tstamp;
+	guint32			latency[5];		/* p50, p90, p99, p99.9, max in μs */
+	guint64			cpu_usecs;
+	guint64			resets;
+	guint64			naks_sent;
+	guint64			nak_failures;
+};
+
+/* globals */
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN	"bench"
+
+static int		g_port = 7500;
+static const char*	g_network = ";239.192.0.1";
+static int		g_udp_encap_port = 0;
+
+static int		g_max_tpdu = 1500;
+static int		g_max_rte = 10*1000*1000;
+static int		g_sqns = 100 * 1000;
+
+static int		g_receivers = 4;
+static int		g_count = 100 * 1000;
+static int		g_msg_len = 1000;
+static int		g_loss_rate = 0;
+static int		g_loss_burst = 0;
+static int		g_timeout = 30;			/* seconds */
+static int		g_idle_timeout = 2;
+
+static gboolean		g_use_fec = FALSE;
+static gboolean		g_use_proactive_parity = FALSE;
+static gboolean		g_use_ondemand_parity = FALSE;
+static int		g_rs_k = 8;
+static int		g_rs_n = 255;
+
+static volatile gboolean g_quit = FALSE;
+static int		g_quit_pipe[2];
+
+static pgm_sock_t* create_sock (const gboolean);
+static int receiver_main (const guint, const int, const int);
+static gpointer nak_thread (gpointer);
+
+
+G_GNUC_NORETURN static
+void
+usage (const char* bin)
+{
+	fprintf (stderr, "Usage: %s [options]\n", bin);
+	fprintf (stderr, "  -n <network>    : Multicast group or unicast IP address\n");
+	fprintf (stderr, "  -s <port>       : IP port\n");
+	fprintf (stderr, "  -p <port>       : Encapsulate PGM in UDP on IP port\n");
+	fprintf (stderr, "  -m <count>      : Receivers (4)\n");
+	fprintf (stderr, "  -c <count>      : Messages (100000)\n");
+	fprintf (stderr, "  -b <bytes>      : Message size (1000)\n");
+	fprintf (stderr, "  -r <rate>       : Regulate to rate bytes per second\n");
+	fprintf (stderr, "  -l <percent>    : Receiver packet loss\n");
+	fprintf (stderr, "  -B <length>     : Mean length of loss bursts, random loss otherwise\n");
+	fprintf (stderr, "  -f <type>       : Enable FEC with either proactive or ondemand parity\n");
+	fprintf (stderr, "  -N <n>          : Reed-Solomon block size (255)\n");
+	fprintf (stderr, "  -K <k>          : Reed-Solomon group size (8)\n");
+	fprintf (stderr, "  -t <seconds>    : Abandon the run after seconds (30)\n");
+	exit (1);
+}
+
+static inline
+guint64
+bench_now (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ((guint64)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static
+guint64
+bench_cpu_usecs (void)
+{
+	struct rusage ru;
+	getrusage (RUSAGE_SELF, &ru);
+	return ((guint64)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000) +
+		ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+static
+int
+latency_compare (
+	const void*	a,
+	const void*	b
+	)
+{
+	const guint32 x = *(const guint32*)a, y = *(const guint32*)b;
+	return (x > y) - (x < y);
+}
+
+int
+main (
+	int	argc,
+	char   *argv[]
+	)
+{
+	const char* binary_name = strrchr (argv[0], '/');
+	binary_name = binary_name ? binary_name + 1 : argv[0];
+	int c;
+	while ((c = getopt (argc, argv, "n:s:p:m:c:b:r:l:B:f:N:K:t:h")) != -1)
+	{
+		switch (c) {
+		case 'n':	g_network = optarg; break;
+		case 's':	g_port = atoi (optarg); break;
+		case 'p':	g_udp_encap_port = atoi (optarg); break;
+		case 'm':	g_receivers = atoi (optarg); break;
+		case 'c':	g_count = atoi (optarg); break;
+		case 'b':	g_msg_len = atoi (optarg); break;
+		case 'r':	g_max_rte = atoi (optarg); break;
+		case 'l':	g_loss_rate = atoi (optarg); break;
+		case 'B':	g_loss_burst = atoi (optarg); break;
+		case 't':	g_timeout = atoi (optarg); break;
+
+		case 'f':
+			g_use_fec = TRUE;
+			switch (optarg[0]) {
+			case 'p':
+			case 'P':
+				g_use_proactive_parity = TRUE;
+				break;
+			case 'o':
+			case 'O':
+				g_use_ondemand_parity = TRUE;
+				break;
+			default:
+				usage (binary_name);
+			}
+			break;
+		case 'N':	g_rs_n = atoi (optarg); break;
+		case 'K':	g_rs_k = atoi (optarg); break;
+
+		case 'h':
+		case '?': usage (binary_name);
+		}
+	}
+	if (g_receivers < 1 || g_count < 1 || g_msg_len < (int)sizeof(struct bench_header_t) ||
+	    g_loss_rate < 0 || g_loss_rate >= 100)
+		usage (binary_name);
+
+	g_message ("%d receivers, %d messages of %d bytes at %d bytes/s, loss %d%% %s",
+		   g_receivers, g_count, g_msg_len, g_max_rte, g_loss_rate,
+		   g_loss_burst > 1 ? "in bursts" : "random");
+	if (g_use_fec)
+		g_message ("FEC RS(%d,%d) %s parity", g_rs_n, g_rs_k,
+			   g_use_proactive_parity ? "proactive" : "on-demand");
+
+/* receivers before any engine state exists */
+	int ready_pipe[2], result_pipe[2];
+	if (0 != pipe (ready_pipe) || 0 != pipe (result_pipe) || 0 != pipe (g_quit_pipe)) {
+		g_critical ("pipe failed errno %i: \"%s\"", errno, strerror (errno));
+		return EXIT_FAILURE;
+	}
+	pid_t* pids = g_new0 (pid_t, g_receivers);
+	for (int i = 0; i < g_receivers; i++)
+	{
+		pids[i] = fork ();
+		if (0 == pids[i]) {
+			close (ready_pipe[0]);
+			close (result_pipe[0]);
+			_exit (receiver_main (i, ready_pipe[1], result_pipe[1]));
+		}
+		if (pids[i] < 0) {
+			g_critical ("fork failed errno %i: \"%s\"", errno, strerror (errno));
+			return EXIT_FAILURE;
+		}
+	}
+	close (ready_pipe[1]);
+	close (result_pipe[1]);
+
+	for (int i = 0; i < g_receivers; i++) {
+		char ready;
+		if (sizeof(ready) != read (ready_pipe[0], &ready, sizeof(ready))) {
+			g_critical ("receiver startup failed.");
+			return EXIT_FAILURE;
+		}
+	}
+	close (ready_pipe[0]);
+
+	pgm_error_t* pgm_err = NULL;
+	if (!pgm_init (&pgm_err)) {
+		g_error ("Unable to start PGM engine: %s", (pgm_err && pgm_err->message) ? pgm_err->message : "(null)");
+		pgm_error_free (pgm_err);
+		return EXIT_FAILURE;
+	}
+	pgm_sock_t* sock = create_sock (TRUE);
+	if (NULL == sock)
+		return EXIT_FAILURE;
+
+	GError* err = NULL;
+	GThread* thread = g_thread_create_full (nak_thread, sock, 0, TRUE, TRUE, G_THREAD_PRIORITY_NORMAL, &err);
+	if (NULL == thread) {
+		g_critical ("g_thread_create_full failed errno %i: \"%s\"", err->code, err->message);
+		return EXIT_FAILURE;
+	}
+
+/* peers need an SPM before data can be repaired */
+	g_usleep (G_USEC_PER_SEC / 4);
+
+	char* buffer = g_malloc0 (g_msg_len);
+	struct bench_header_t* header = (struct bench_header_t*)buffer;
+	const guint64 source_cpu = bench_cpu_usecs();
+	const guint64 send_start = bench_now();
+	for (int i = 0, stamped = -1; i < g_count && !g_quit; )
+	{
+		struct timeval tv;
+		struct pollfd fds[ 16 ];
+		int n_fds = G_N_ELEMENTS(fds);
+		socklen_t optlen = sizeof (tv);
+/* a blocked APDU is resumed from the same buffer */
+		if (stamped != i) {
+			header->sequence = i;
+			header->tstamp = bench_now();
+			stamped = i;
+		}
+		const int status = pgm_send (sock, buffer, g_msg_len, NULL);
+		switch (status) {
+		case PGM_IO_STATUS_NORMAL:
+			i++;
+			break;
+		case PGM_IO_STATUS_RATE_LIMITED:
+			pgm_getsockopt (sock, IPPROTO_PGM, PGM_RATE_REMAIN, &tv, &optlen);
+			g_usleep ((tv.tv_sec * G_USEC_PER_SEC) + tv.tv_usec);
+			break;
+		case PGM_IO_STATUS_WOULD_BLOCK:
+		case PGM_IO_STATUS_CONGESTION:
+			pgm_poll_info (sock, fds, &n_fds, POLLOUT);
+			poll (fds, n_fds, 10 /* ms */);
+			break;
+		default:
+			g_critical ("pgm_send failed.");
+			g_quit = TRUE;
+			break;
+		}
+	}
+	const guint64 send_elapsed = bench_now() - send_start;
+	g_free (buffer);
+
+/* repairs continue until every receiver reports */
+	struct bench_result_t* results = g_new0 (struct bench_result_t, g_receivers);
+	for (int i = 0; i < g_receivers; i++) {
+		struct bench_result_t result;
+		if (sizeof(result) != read (result_pipe[0], &result, sizeof(result))) {
+			g_critical ("receiver result missing.");
+			break;
+		}
+		if (result.id < (guint)g_receivers)
+			results[result.id] = result;
+	}
+	close (result_pipe[0]);
+	const guint64 source_cpu_usecs = bench_cpu_usecs() - source_cpu;
+
+	g_quit = TRUE;
+	const char one = '1';
+	if (sizeof(one) != write (g_quit_pipe[1], &one, sizeof(one)))
+		g_warning ("quit notification failed.");
+	g_thread_join (thread);
+	for (int i = 0; i < g_receivers; i++)
+		waitpid (pids[i], NULL, 0);
+	g_free (pids);
+
+/* report */
+	const guint64 odata    = sock->cumulative_stats[PGM_PC_SOURCE_DATA_MSGS_SENT];
+	const guint64 rdata    = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_MSGS_RETRANSMITTED];
+	const guint64 parity   = sock->cumulative_stats[PGM_PC_SOURCE_PARITY_MSGS_RETRANSMITTED];
+	const guint64 naks     = sock->cumulative_stats[PGM_PC_SOURCE_SELECTIVE_NAKS_RECEIVED] +
+				 sock->cumulative_stats[PGM_PC_SOURCE_PARITY_NAKS_RECEIVED];
+	guint64 naks_sent = 0, delivered = 0;
+
+	printf ("receiver  messages  resets   Mb/s  naks sent  nak failures     p50     p90     p99   p99.9     max  cpu us/MB\n");
+	for (int i = 0; i < g_receivers; i++)
+	{
+		const struct bench_result_t* r = &results[i];
+		const guint64 elapsed = r->last_tstamp > r->first_tstamp ? r->last_tstamp - r->first_tstamp : 1;
+		printf ("%8d %9" G_GUINT64_FORMAT " %7" G_GUINT64_FORMAT " %6.1f %10" G_GUINT64_FORMAT " %13" G_GUINT64_FORMAT
+			" %7u %7u %7u %7u %7u %10.0f\n",
+			i, r->msgs, r->resets,
+			(8.0 * r->bytes) / elapsed,
+			r->naks_sent, r->nak_failures,
+			r->latency[0], r->latency[1], r->latency[2], r->latency[3], r->latency[4],
+			r->bytes ? (1000000.0 * r->cpu_usecs) / r->bytes : 0.0);
+		naks_sent += r->naks_sent;
+		delivered += r->bytes;
+	}
+	printf ("source: odata %" G_GUINT64_FORMAT ", rdata %" G_GUINT64_FORMAT ", parity %" G_GUINT64_FORMAT " in %.2f s, %.1f Mb/s, naks received %" G_GUINT64_FORMAT ", cpu %.0f us/MB\n",
+		odata, rdata, parity,
+		send_elapsed / 1000000.0,
+		(8.0 * g_count * g_msg_len) / (send_elapsed ? send_elapsed : 1),
+		naks,
+		delivered ? (1000000.0 * g_receivers * source_cpu_usecs) / delivered : 0.0);
+	printf ("amplification: %.3f repairs per odata, %.3f naks sent per repair, %.3f naks received per repair\n",
+		odata ? (double)(rdata + parity) / odata : 0.0,
+		(rdata + parity) ? (double)naks_sent / (rdata + parity) : 0.0,
+		(rdata + parity) ? (double)naks / (rdata + parity) : 0.0);
+
+	g_free (results);
+	pgm_close (sock, TRUE);
+	pgm_shutdown ();
+	close (g_quit_pipe[0]);
+	close (g_quit_pipe[1]);
+	return EXIT_SUCCESS;
+}
+
+/* source NAKs and SPMRs are only processed by reading the socket.
+ */
+
+static
+gpointer
+nak_thread (
+	gpointer	data
+	)
+{
+	pgm_sock_t* sock = (pgm_sock_t*)data;
+	char buffer[4096];
+
+	do {
+		struct timeval tv;
+		struct pollfd fds[ 1 + 16 ];
+		int n_fds = G_N_ELEMENTS(fds) - 1;
+		socklen_t optlen = sizeof (tv);
+		int timeout;
+		size_t len;
+		const int status = pgm_recv (sock, buffer, sizeof(buffer), 0, &len, NULL);
+		switch (status) {
+		case PGM_IO_STATUS_TIMER_PENDING:
+			pgm_getsockopt (sock, IPPROTO_PGM, PGM_TIME_REMAIN, &tv, &optlen);
+			timeout = (tv.tv_sec * 1000) + ((tv.tv_usec + 999) / 1000);
+			break;
+		case PGM_IO_STATUS_RATE_LIMITED:
+			pgm_getsockopt (sock, IPPROTO_PGM, PGM_RATE_REMAIN, &tv, &optlen);
+			timeout = (tv.tv_sec * 1000) + ((tv.tv_usec + 999) / 1000);
+			break;
+		case PGM_IO_STATUS_WOULD_BLOCK:
+			timeout = -1;
+			break;
+		default:
+			continue;
+		}
+		memset (fds, 0, sizeof(fds));
+		fds[0].fd = g_quit_pipe[0];
+		fds[0].events = POLLIN;
+		pgm_poll_info (sock, &fds[1], &n_fds, POLLIN);
+		poll (fds, 1 + n_fds, timeout /* ms */);
+	} while (!g_quit);
+	return NULL;
+}
+
+/* receiver process, reports one result and exits.
+ */
+
+static
+int
+receiver_main (
+	const guint	id,
+	const int	ready_fd,
+	const int	result_fd
+	)
+{
+	pgm_error_t* pgm_err = NULL;
+	char value[16];
+
+	if (g_loss_rate > 0) {
+		snprintf (value, sizeof(value), "%d", g_loss_rate);
+		setenv ("PGM_LOSS_RATE", value, 1);
+		if (g_loss_burst > 1) {
+			snprintf (value, sizeof(value), "%d", g_loss_burst);
+			setenv ("PGM_LOSS_BURST", value, 1);
+		}
+	}
+	if (!pgm_init (&pgm_err)) {
+		g_warning ("Unable to start PGM engine: %s", (pgm_err && pgm_err->message) ? pgm_err->message : "(null)");
+		pgm_error_free (pgm_err);
+		return EXIT_FAILURE;
+	}
+	pgm_sock_t* sock = create_sock (FALSE);
+	if (NULL == sock)
+		return EXIT_FAILURE;
+	const char ready = '1';
+	if (sizeof(ready) != write (ready_fd, &ready, sizeof(ready)))
+		return EXIT_FAILURE;
+	close (ready_fd);
+
+	struct bench_result_t result;
+	memset (&result, 0, sizeof(result));
+	result.id = id;
+	guint32* latency = g_new (guint32, g_count);
+	char* buffer = g_malloc (g_msg_len < 4096 ? 4096 : g_msg_len);
+	const guint64 cpu = bench_cpu_usecs();
+	const guint64 start = bench_now();
+	guint64 last = start;
+
+	while (result.msgs < (guint64)g_count)
+	{
+		struct timeval tv;
+		struct pollfd fds[ 16 ];
+		int n_fds = G_N_ELEMENTS(fds);
+		socklen_t optlen = sizeof (tv);
+		int timeout = 0;
+		size_t len;
+		const guint64 now = bench_now();
+		const guint64 deadline = result.msgs ? last + (g_idle_timeout * G_USEC_PER_SEC) : start + (g_timeout * G_USEC_PER_SEC);
+		if (now >= deadline)
+			break;
+		const int status = pgm_recv (sock, buffer, g_msg_len < 4096 ? 4096 : g_msg_len, 0, &len, NULL);
+		switch (status) {
+		case PGM_IO_STATUS_NORMAL:
+			last = bench_now();
+			if (len >= sizeof(struct bench_header_t)) {
+				const struct bench_header_t* header = (const struct bench_header_t*)buffer;
+				if (0 == result.msgs)
+					result.first_tstamp = header->tstamp;
+				latency[result.msgs++] = (guint32)MIN(last - header->tstamp, G_MAXUINT32);
+				result.bytes += len;
+				result.last_tstamp = last;
+			}
+			continue;
+		case PGM_IO_STATUS_RESET:
+			result.resets++;
+			continue;
+		case PGM_IO_STATUS_TIMER_PENDING:
+			pgm_getsockopt (sock, IPPROTO_PGM, PGM_TIME_REMAIN, &tv, &optlen);
+			timeout = (tv.tv_sec * 1000) + ((tv.tv_usec + 999) / 1000);
+			break;
+		case PGM_IO_STATUS_RATE_LIMITED:
+			pgm_getsockopt (sock, IPPROTO_PGM, PGM_RATE_REMAIN, &tv, &optlen);
+			timeout = (tv.tv_sec * 1000) + ((tv.tv_usec + 999) / 1000);
+			break;
+		case PGM_IO_STATUS_WOULD_BLOCK:
+			timeout = (int)((deadline - now + 999) / 1000);
+			break;
+		default:
+			continue;
+		}
+		timeout = MIN(timeout, (int)((deadline - now + 999) / 1000));
+		pgm_poll_info (sock, fds, &n_fds, POLLIN);
+		poll (fds, n_fds, timeout /* ms */);
+	}
+	result.cpu_usecs = bench_cpu_usecs() - cpu;
+
+	if (result.msgs > 0) {
+		const double rank[4] = { 0.5, 0.9, 0.99, 0.999 };
+		qsort (latency, result.msgs, sizeof(guint32), latency_compare);
+		for (unsigned i = 0; i < G_N_ELEMENTS(rank); i++)
+			result.latency[i] = latency[ (guint64)(rank[i] * (result.msgs - 1)) ];
+		result.latency[4] = latency[ result.msgs - 1 ];
+	}
+	g_free (latency);
+	g_free (buffer);
+
+	pgm_rwlock_reader_lock (&sock->peers_lock);
+	for (pgm_list_t* peers = sock->peers_list; peers; peers = peers->next)
+	{
+		const pgm_peer_t* peer = peers->data;
+		result.naks_sent	 += peer->cumulative_stats[PGM_PC_RECEIVER_SELECTIVE_NAKS_SENT] +
+					    peer->cumulative_stats[PGM_PC_RECEIVER_PARITY_NAKS_SENT];
+		result.nak_failures	 += peer->cumulative_stats[PGM_PC_RECEIVER_NAK_FAILURES];
+	}
+	pgm_rwlock_reader_unlock (&sock->peers_lock);
+
+	const gboolean is_written = (sizeof(result) == write (result_fd, &result, sizeof(result)));
+	close (result_fd);
+	pgm_close (sock, TRUE);
+	pgm_shutdown ();
+	return is_written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* source or receiver socket, multicast loop on for the local host.
+ */
+
+static
+pgm_sock_t*
+create_sock (
+	const gboolean	is_source
+	)
+{
+	struct pgm_addrinfo_t* res = NULL;
+	pgm_error_t* pgm_err = NULL;
+	pgm_sock_t* sock = NULL;
+
+	if (!pgm_getaddrinfo (g_network, NULL, &res, &pgm_err)) {
+		g_warning ("Parsing network parameter: %s", pgm_err->message);
+		goto err_abort;
+	}
+	const sa_family_t sa_family = res->ai_send_addrs[0].gsr_group.ss_family;
+	if (g_udp_encap_port) {
+		if (!pgm_socket (&sock, sa_family, SOCK_SEQPACKET, IPPROTO_UDP, &pgm_err)) {
+			g_warning ("Creating PGM/UDP socket: %s", pgm_err->message);
+			goto err_abort;
+		}
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_UDP_ENCAP_UCAST_PORT, &g_udp_encap_port, sizeof(g_udp_encap_port));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_UDP_ENCAP_MCAST_PORT, &g_udp_encap_port, sizeof(g_udp_encap_port));
+	} else {
+		if (!pgm_socket (&sock, sa_family, SOCK_SEQPACKET, IPPROTO_PGM, &pgm_err)) {
+			g_warning ("Creating PGM/IP socket: %s", pgm_err->message);
+			goto err_abort;
+		}
+	}
+
+	const int no_router_assist = 0;
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_IP_ROUTER_ALERT, &no_router_assist, sizeof(no_router_assist));
+
+	pgm_drop_superuser();
+
+	const int peer_expiry = pgm_secs (300),
+		  spmr_expiry = pgm_msecs (250),
+		  nak_bo_ivl = pgm_msecs (50),
+		  nak_rpt_ivl = pgm_msecs (200),
+		  nak_rdata_ivl = pgm_msecs (200),
+		  nak_data_retries = 50,
+		  nak_ncf_retries = 50;
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_MTU, &g_max_tpdu, sizeof(g_max_tpdu));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_RXW_SQNS, &g_sqns, sizeof(g_sqns));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_PEER_EXPIRY, &peer_expiry, sizeof(peer_expiry));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_SPMR_EXPIRY, &spmr_expiry, sizeof(spmr_expiry));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_BO_IVL, &nak_bo_ivl, sizeof(nak_bo_ivl));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_RPT_IVL, &nak_rpt_ivl, sizeof(nak_rpt_ivl));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_RDATA_IVL, &nak_rdata_ivl, sizeof(nak_rdata_ivl));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_DATA_RETRIES, &nak_data_retries, sizeof(nak_data_retries));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NAK_NCF_RETRIES, &nak_ncf_retries, sizeof(nak_ncf_retries));
+	if (is_source) {
+		const int ambient_spm = pgm_secs (30),
+			  heartbeat_spm[] = { pgm_msecs (100),
+					      pgm_msecs (100),
+					      pgm_msecs (100),
+					      pgm_msecs (100),
+					      pgm_msecs (1300),
+					      pgm_secs  (7),
+					      pgm_secs  (16),
+					      pgm_secs  (25),
+					      pgm_secs  (30) };
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_TXW_SQNS, &g_sqns, sizeof(g_sqns));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_TXW_MAX_RTE, &g_max_rte, sizeof(g_max_rte));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_AMBIENT_SPM, &ambient_spm, sizeof(ambient_spm));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_HEARTBEAT_SPM, &heartbeat_spm, sizeof(heartbeat_spm));
+	} else {
+		const int recv_only = 1,
+			  passive = 0;
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_RECV_ONLY, &recv_only, sizeof(recv_only));
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_PASSIVE, &passive, sizeof(passive));
+	}
+	if (g_use_fec) {
+		struct pgm_fecinfo_t fecinfo;
+		fecinfo.block_size		= g_rs_n;
+		fecinfo.proactive_packets	= g_use_proactive_parity ? (g_rs_n - g_rs_k) : 0;
+		fecinfo.group_size		= g_rs_k;
+		fecinfo.ondemand_parity_enabled	= g_use_ondemand_parity;
+		fecinfo.var_pktlen_enabled	= TRUE;
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_USE_FEC, &fecinfo, sizeof(fecinfo));
+	}
+
+/* every process shares the host GSI, the random source port tells them apart */
+	struct pgm_sockaddr_t addr;
+	memset (&addr, 0, sizeof(addr));
+	addr.sa_port = g_port ? g_port : DEFAULT_DATA_DESTINATION_PORT;
+	addr.sa_addr.sport = DEFAULT_DATA_SOURCE_PORT;
+	if (!pgm_gsi_create_from_hostname (&addr.sa_addr.gsi, &pgm_err)) {
+		g_warning ("Creating GSI: %s", pgm_err->message);
+		goto err_abort;
+	}
+
+	struct pgm_interface_req_t if_req;
+	memset (&if_req, 0, sizeof(if_req));
+	if_req.ir_interface = res->ai_recv_addrs[0].gsr_interface;
+	memcpy (&if_req.ir_address, &res->ai_send_addrs[0].gsr_addr, sizeof(struct sockaddr_storage));
+	if (!pgm_bind3 (sock,
+			&addr, sizeof(addr),
+			&if_req, sizeof(if_req),	/* tx interface */
+			&if_req, sizeof(if_req),	/* rx interface */
+			&pgm_err))
+	{
+		g_warning ("Binding PGM socket: %s", pgm_err->message);
+		goto err_abort;
+	}
+
+	for (unsigned i = 0; i < res->ai_recv_addrs_len; i++)
+		pgm_setsockopt (sock, IPPROTO_PGM, PGM_JOIN_GROUP, &res->ai_recv_addrs[i], sizeof(struct pgm_group_source_req));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_SEND_GROUP, &res->ai_send_addrs[0], sizeof(struct pgm_group_source_req));
+	pgm_freeaddrinfo (res);
+	res = NULL;
+
+	const int nonblocking = 1,
+		  multicast_loop = 1,
+		  multicast_hops = 16;
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_MULTICAST_LOOP, &multicast_loop, sizeof(multicast_loop));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_MULTICAST_HOPS, &multicast_hops, sizeof(multicast_hops));
+	pgm_setsockopt (sock, IPPROTO_PGM, PGM_NOBLOCK, &nonblocking, sizeof(nonblocking));
+
+	if (!pgm_connect (sock, &pgm_err)) {
+		g_warning ("Connecting PGM socket: %s", pgm_err->message);
+		goto err_abort;
+	}
+	return sock;
+
+err_abort:
+	if (NULL != sock)
+		pgm_close (sock, FALSE);
+	if (NULL != res)
+		pgm_freeaddrinfo (res);
+	if (NULL != pgm_err)
+		pgm_error_free (pgm_err);
+	return NULL;
+}
+
+/* eof */
@@ -48,6 +48,7 @@
 #include <glib.h>
 #include <impl/framework.h>
 #include <impl/socket.h>
+#include <impl/shard.h>
 #include <impl/sqn_list.h>
 #include <impl/packet_parse.h>
 #include <pgm/pgm.h>
@@ -307,6 +308,7 @@ fake_pgm_socket (
         new_sock->dport         = DEFAULT_DATA_DESTINATION_PORT;
         new_sock->tsi.sport     = DEFAULT_DATA_SOURCE_PORT;
         new_sock->adv_mode      = 0;    /* advance with time */
+	pgm_rx_shards_create (new_sock, 1);
 
 /* PGMCC */
         new_sock->acker_nla.ss_family = family;
@@ -430,7 +432,7 @@ on_io_data (
 
 /* parse packet to maintain peer database */
 	if (sock->udp_encap_ucast_port) {
-		if (!pgm_parse_udp_encap (skb, NULL))
+		if (!pgm_parse_udp_encap (skb, FALSE, NULL))
 			goto out;
         } else {
 		struct sockaddr_storage addr;
@@ -451,7 +453,7 @@ on_io_data (
                 goto out;
 
 /* search for TSI peer context or create a new one */
-        pgm_peer_t* sender = pgm_hashtable_lookup (sock->peers_hashtable, &skb->tsi);
+        pgm_peer_t* sender = pgm_peer_table_lookup (sock->rx_shard->peers_table, &skb->tsi);
         if (sender == NULL)
         {
 		printf ("new peer, tsi %s, local nla %s\n",
@@ -462,8 +464,9 @@ on_io_data (
 		memcpy (&peer->tsi, &skb->tsi, sizeof(pgm_tsi_t));
 		((struct sockaddr_in*)&peer->nla)->sin_addr.s_addr = INADDR_ANY;
 		memcpy (&peer->local_nla, &src_addr, src_addr_len);
+		peer->shard = sock->rx_shard;
 
-		pgm_hashtable_insert (sock->peers_hashtable, &peer->tsi, peer);
+		pgm_peer_table_insert (sock->rx_shard->peers_table, &peer->tsi, peer);
 		sender = peer;
         }
 
@@ -555,8 +558,8 @@ fake_pgm_bind3 (
 
 /* create peer list */
         if (sock->can_recv_data) {
-                sock->peers_hashtable = pgm_hashtable_new (pgm_tsi_hash, pgm_tsi_equal);
-                pgm_assert (NULL != sock->peers_hashtable);
+                sock->rx_shard->peers_table = pgm_peer_table_new (g_random_int ());
+                pgm_assert (NULL != sock->rx_shard->peers_table);
         }
 
 /* IP/PGM only */
@@ -751,7 +754,7 @@ fake_pgm_bind3 (
 	sock->is_controlled_rdata = FALSE;
 
 /* allocate first incoming packet buffer */
-        sock->rx_buffer = pgm_alloc_skb (sock->max_tpdu);
+        sock->rx_shard->rx_buffer = pgm_alloc_skb (sock->max_tpdu);
 
 /* bind complete */
         sock->is_bound = TRUE;
@@ -829,9 +832,9 @@ fake_pgm_close (
                 closesocket (sock->send_sock);
                 sock->send_sock = INVALID_SOCKET;
         }
-	if (sock->peers_hashtable) {
-		pgm_hashtable_destroy (sock->peers_hashtable);
-                sock->peers_hashtable = NULL;
+	if (sock->rx_shard->peers_table) {
+		pgm_peer_table_destroy (sock->rx_shard->peers_table);
+                sock->rx_shard->peers_table = NULL;
         }
         if (sock->peers_list) {
 		do {
@@ -851,11 +854,12 @@ fake_pgm_close (
                 g_free (sock->spm_heartbeat_interval);
                 sock->spm_heartbeat_interval = NULL;
         }
-        if (sock->rx_buffer) {
+        if (sock->rx_shard->rx_buffer) {
                 puts ("freeing receive buffer.");
-                pgm_free_skb (sock->rx_buffer);
-                sock->rx_buffer = NULL;
+                pgm_free_skb (sock->rx_shard->rx_buffer);
+                sock->rx_shard->rx_buffer = NULL;
         }
+	pgm_rx_shards_destroy (sock);
 
 	g_free (sock);
 	return TRUE;
@@ -1689,7 +1693,7 @@ net_send_spmr (
 	pgm_sock_t* sock = sess->sock;
 
 /* check that the peer exists */
-	pgm_peer_t* peer = pgm_hashtable_lookup (sock->peers_hashtable, tsi);
+	pgm_peer_t* peer = pgm_peer_table_lookup (sock->rx_shard->peers_table, tsi);
 	struct sockaddr_storage peer_nla;
 	pgm_gsi_t* peer_gsi;
 	guint16 peer_sport;
@@ -1777,7 +1781,7 @@ net_send_ncf (
 
 /* check that the peer exists */
 	pgm_sock_t* sock = sess->sock;
-	pgm_peer_t* peer = pgm_hashtable_lookup (sock->peers_hashtable, tsi);
+	pgm_peer_t* peer = pgm_peer_table_lookup (sock->rx_shard->peers_table, tsi);
 	if (peer == NULL) {
 		printf ("FAILED: peer \"%s\" not found\n", pgm_tsi_print (tsi));
 		return;
@@ -1876,7 +1880,7 @@ net_send_nak (
 
 /* check that the peer exists */
 	pgm_sock_t* sock = sess->sock;
-	pgm_peer_t* peer = pgm_hashtable_lookup (sock->peers_hashtable, tsi);
+	pgm_peer_t* peer = pgm_peer_table_lookup (sock->rx_shard->peers_table, tsi);
 	if (peer == NULL) {
 		printf ("FAILED: peer \"%s\" not found\n", pgm_tsi_print(tsi));
 		return;
@@ -0,0 +1,172 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * Equation-based multicast congestion control after TFMCC, RFC 4654.
+ *
+ * An alternative to the PGMCC window for sources with PGM_USE_TFMCC.  The
+ * PGMCC wire protocol is unchanged: receivers echo the source time stamp and
+ * report their loss rate in OPT_PGMCC_FEEDBACK of ACKs and POLRs, and the
+ * worst receiver by the PGMCC election is the current limiting receiver
+ * (CLR).  Instead of a token window the source sets the rate of the
+ * transmit rate regulator from the TCP throughput equation of RFC 5348 for
+ * the CLR, so that the rate is smooth across receivers of differing
+ * round-trip time.  Decreases apply at once, increases are limited to a
+ * doubling per round-trip time, and without feedback from the CLR the rate
+ * halves every few round-trip times.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <math.h>
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/tfmcc.h>
+
+
+//#define TFMCC_DEBUG
+
+#ifndef TFMCC_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+/* TCP throughput equation in bytes per second, RFC 5348 section 3.1 with
+ * t_RTO = 4R and b = 1.
+ */
+
+static
+double
+tfmcc_calc_rate (
+	const double		s,		/* segment size in bytes */
+	const double		R,		/* round-trip time in seconds */
+	const double		p		/* loss event rate */
+	)
+{
+	const double t_RTO = 4.0 * R;
+	return s / (R * sqrt (2.0 * p / 3.0) +
+		    t_RTO * (3.0 * sqrt (3.0 * p / 8.0)) * p * (1.0 + 32.0 * p * p));
+}
+
+/* apply a new rate bounded by one packet per second and the configured
+ * maximum rate.
+ */
+
+static
+void
+tfmcc_set_rate (
+	pgm_sock_t* const	sock,
+	ssize_t			rate
+	)
+{
+	rate = MAX(rate, (ssize_t)sock->max_tpdu);
+	rate = MIN(rate, sock->txw_max_rte);
+	if (rate == sock->tfmcc_rate)
+		return;
+	pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("TFMCC rate %" PRIzd " bytes per second."), rate);
+	sock->tfmcc_rate = rate;
+	pgm_rate_set (&sock->rate_control, rate, sock->max_tpdu);
+}
+
+/* start at most four packets per assumed round-trip time in slow-start,
+ * RFC 5348 section 4.2.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_tfmcc_init (
+	pgm_sock_t* const	sock,
+	const pgm_time_t	now
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (sock->use_tfmcc);
+	pgm_assert (sock->txw_max_rte > 0);
+
+	const ssize_t initial_rate = MIN(4 * sock->max_tpdu, MAX(2 * sock->max_tpdu, 4380));
+	sock->tfmcc_rtt		= PGM_TFMCC_INITIAL_RTT;
+	sock->tfmcc_is_slow_start = TRUE;
+	sock->tfmcc_last_update	= now;
+	sock->tfmcc_expiry	= now + PGM_TFMCC_NOFEEDBACK_RTTS * sock->tfmcc_rtt;
+	tfmcc_set_rate (sock, initial_rate);
+}
+
+/* feedback of the CLR, round-trip time in milliseconds and loss rate in
+ * 1/65535ths.  the first reported loss ends slow-start.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_tfmcc_feedback (
+	pgm_sock_t* const	sock,
+	const uint32_t		rtt,
+	const uint16_t		loss_rate,
+	const pgm_time_t	now
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (sock->use_tfmcc);
+
+	sock->tfmcc_rtt = pgm_msecs (MAX(rtt, 1));
+	sock->tfmcc_expiry = now + PGM_TFMCC_NOFEEDBACK_RTTS * sock->tfmcc_rtt;
+	if (loss_rate > 0)
+		sock->tfmcc_is_slow_start = FALSE;
+
+/* at most double per round-trip time since the last update */
+	const pgm_time_t elapsed = MIN(now - sock->tfmcc_last_update, sock->tfmcc_rtt);
+	const double max_rate = sock->tfmcc_rate * (1.0 + (double)elapsed / (double)sock->tfmcc_rtt);
+	sock->tfmcc_last_update = now;
+
+	double rate;
+	if (sock->tfmcc_is_slow_start) {
+		rate = max_rate;
+	} else {
+		const double p = MAX(loss_rate, 1) / (double)UINT16_MAX;
+		const double R = (double)sock->tfmcc_rtt / (double)pgm_secs(1);
+		rate = tfmcc_calc_rate (sock->max_tpdu, R, p);
+		if (rate > max_rate)
+			rate = max_rate;
+	}
+	tfmcc_set_rate (sock, rate >= (double)SSIZE_MAX ? SSIZE_MAX : (ssize_t)rate);
+}
+
+/* halve the rate without CLR feedback, which re-elects by the next ACKs.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_tfmcc_check (
+	pgm_sock_t* const	sock,
+	const pgm_time_t	now
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (sock->use_tfmcc);
+
+	if (!pgm_time_after_eq (now, sock->tfmcc_expiry))
+		return;
+	pgm_trace (PGM_LOG_ROLE_CONGESTION_CONTROL,_("TFMCC no feedback from current limiting receiver."));
+	sock->tfmcc_expiry = now + PGM_TFMCC_NOFEEDBACK_RTTS * sock->tfmcc_rtt;
+	sock->tfmcc_last_update = now;
+	tfmcc_set_rate (sock, sock->tfmcc_rate / 2);
+}
+
+/* eof */
@@ -23,7 +23,9 @@
 #	include <config.h>
 #endif
 #include <errno.h>
+#include <stdio.h>
 #include <impl/framework.h>
+#include <pgm/engine.h>
 
 //#define THREAD_DEBUG
 
@@ -42,6 +44,36 @@ static DWORD cond_event_tls = TLS_OUT_OF_INDEXES;
 
 static volatile uint32_t thread_ref_count = 0;
 
+/* placement of library threads by role, entry 0 applies to roles without
+ * their own.
+ */
+struct thread_attr_t {
+	bool		is_set;
+	char		cpus[64];
+	int		policy;
+	int		priority;
+};
+
+static const char* thread_roles[] = {
+	"default", "timer", "http", "snmp", "stats", "logring", "recv", "fec", "rdata", "decode",
+	"standby", "core", "async", "sampler"
+};
+
+static struct thread_attr_t thread_attrs[ PGM_N_ELEMENTS(thread_roles) ];
+
+#ifdef USE_LOCK_STATS
+/* named lock statistics, entries persist for the life of the process such
+ * that locks of a closed socket never reference a released entry.
+ */
+#	define LOCKSTAT_MAX		32
+
+static pgm_mutex_t		lockstat_mutex;
+static pgm_lockstat_t		lockstat_table[ LOCKSTAT_MAX ];
+static volatile uint32_t	lockstat_len = 0;
+
+static pgm_lockstat_t* lockstat_lookup (const char*);
+#endif
+
 
 #if !defined( _WIN32 ) && defined( __GNU__ )
 #	define posix_check_err(err, name) \
@@ -108,6 +140,9 @@ pgm_thread_init (void)
 
 	if (pgm_get_nprocs() <= 1)
 		pgm_smp_system = FALSE;
+#ifdef USE_LOCK_STATS
+	pgm_mutex_init (&lockstat_mutex);
+#endif
 }
 
 PGM_GNUC_INTERNAL
@@ -123,6 +158,9 @@ pgm_thread_shutdown (void)
 /* Condition variable implementation for Windows XP */
 	TlsFree (cond_event_tls);
 #endif
+#ifdef USE_LOCK_STATS
+	pgm_mutex_free (&lockstat_mutex);
+#endif
 }
 
 /* prefer adaptive-mutexes over regular mutexes, an adaptive mutex is wrapped by
@@ -158,6 +196,9 @@ pgm_mutex_init (
 	InitializeCriticalSection (&mutex->win32_crit);
 	SetCriticalSectionSpinCount (&mutex->win32_crit, PGM_ADAPTIVE_MUTEX_SPINCOUNT);
 #endif
+#ifdef USE_LOCK_STATS
+	mutex->stats = NULL;
+#endif
 }
 
 /* multiple calls to pgm_mutex_free is undefined.
@@ -199,6 +240,9 @@ pgm_spinlock_init (
 #else	/* Win32/GCC atomics */
 	spinlock->taken = 0;
 #endif
+#ifdef USE_LOCK_STATS
+	spinlock->stats = NULL;
+#endif
 }
 
 PGM_GNUC_INTERNAL
@@ -412,6 +456,9 @@ pgm_rwlock_init (
 	rwlock->want_to_read	= 0;
 	rwlock->want_to_write	= 0;
 #endif
+#ifdef USE_LOCK_STATS
+	rwlock->stats = NULL;
+#endif
 }
 
 PGM_GNUC_INTERNAL
@@ -454,8 +501,8 @@ _pgm_rwlock_signal (
 }
 
 PGM_GNUC_INTERNAL
-void
-pgm_rwlock_reader_lock (
+unsigned
+_pgm_rwlock_reader_lock (
 	pgm_rwlock_t*	rwlock
 	)
 {
@@ -468,11 +515,12 @@ pgm_rwlock_reader_lock (
 	rwlock->want_to_read--;
 	rwlock->read_counter++;
 	LeaveCriticalSection (&rwlock->win32_crit);
+	return 0;
 }
 
 PGM_GNUC_INTERNAL
 bool
-pgm_rwlock_reader_trylock (
+_pgm_rwlock_reader_trylock (
 	pgm_rwlock_t*	rwlock
 	)
 {
@@ -491,7 +539,7 @@ pgm_rwlock_reader_trylock (
 
 PGM_GNUC_INTERNAL
 void
-pgm_rwlock_reader_unlock(
+_pgm_rwlock_reader_unlock (
 	pgm_rwlock_t*	rwlock
 	)
 {
@@ -505,8 +553,8 @@ pgm_rwlock_reader_unlock(
 }
 
 PGM_GNUC_INTERNAL
-void
-pgm_rwlock_writer_lock (
+unsigned
+_pgm_rwlock_writer_lock (
 	pgm_rwlock_t*	rwlock
 	)
 {
@@ -519,11 +567,12 @@ pgm_rwlock_writer_lock (
 	rwlock->want_to_write--;
 	rwlock->have_writer = TRUE;
 	LeaveCriticalSection (&rwlock->win32_crit);
+	return 0;
 }
 
 PGM_GNUC_INTERNAL
 bool
-pgm_rwlock_writer_trylock (
+_pgm_rwlock_writer_trylock (
 	pgm_rwlock_t*	rwlock
 	)
 {
@@ -542,7 +591,7 @@ pgm_rwlock_writer_trylock (
 
 PGM_GNUC_INTERNAL
 void
-pgm_rwlock_writer_unlock (
+_pgm_rwlock_writer_unlock (
 	pgm_rwlock_t*	rwlock
 	)
 {
@@ -555,5 +604,513 @@ pgm_rwlock_writer_unlock (
 }
 #endif /* defined( _WIN32 ) && !( _WIN32_WINNT >= 0x600 ) */
 
+#ifdef USE_LOCK_STATS
+/* find or add the statistics of a lock name, names are static strings.
+ *
+ * returns NULL when the table is full.
+ */
+
+static
+pgm_lockstat_t*
+lockstat_lookup (
+	const char*	name
+	)
+{
+	pgm_lockstat_t* stats = NULL;
+
+	_pgm_mutex_lock (&lockstat_mutex);
+	for (unsigned i = 0; i < lockstat_len; i++)
+		if (0 == strcmp (name, lockstat_table[ i ].name)) {
+			stats = &lockstat_table[ i ];
+			break;
+		}
+	if (NULL == stats && lockstat_len < LOCKSTAT_MAX) {
+		stats = &lockstat_table[ lockstat_len ];
+		stats->name = name;
+		pgm_atomic_inc32 (&lockstat_len);
+	}
+	_pgm_mutex_unlock (&lockstat_mutex);
+	if (NULL == stats)
+		pgm_warn (_("Lock statistics table full, \"%s\" not counted."), name);
+	return stats;
+}
+
+/* count an acquisition, contended when the first attempt found the lock
+ * taken.
+ *
+ * returns the time of acquisition.
+ */
+
+PGM_GNUC_INTERNAL
+uint64_t
+pgm_lockstat_acquired (
+	pgm_lockstat_t*	stats,
+	const bool	is_contended,
+	const unsigned	spins
+	)
+{
+	pgm_atomic_add64 (&stats->acquisitions, 1);
+	if (is_contended) {
+		pgm_atomic_add64 (&stats->contended, 1);
+		pgm_atomic_add64 (&stats->spins, spins);
+	}
+	return pgm_time_update_now();
+}
+
+/* count a failed trylock.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_lockstat_busy (
+	pgm_lockstat_t*	stats
+	)
+{
+	pgm_atomic_add64 (&stats->contended, 1);
+}
+
+/* sample the hold time of an exclusive holder, across a condition wait this
+ * includes the time waiting.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_lockstat_released (
+	pgm_lockstat_t*	stats,
+	const uint64_t	locked_at
+	)
+{
+	const pgm_time_t now = pgm_time_update_now();
+	const uint64_t held = now > locked_at ? now - locked_at : 0;
+	unsigned bucket = 0;
+	while (bucket < PGM_LOCKSTAT_HOLD_BUCKETS - 1 && (held >> bucket))
+		bucket++;
+	pgm_atomic_add64 (&stats->hold[ bucket ], 1);
+	pgm_atomic_add64 (&stats->hold_sum, held);
+}
+#endif /* USE_LOCK_STATS */
+
+PGM_GNUC_INTERNAL
+void
+pgm_mutex_set_name (
+	pgm_mutex_t*	mutex,
+	const char*	name
+	)
+{
+	pgm_assert (NULL != mutex);
+	pgm_assert (NULL != name);
+
+#ifdef USE_LOCK_STATS
+	mutex->stats = lockstat_lookup (name);
+#else
+	(void)mutex;
+	(void)name;
+#endif
+}
+
+PGM_GNUC_INTERNAL
+void
+pgm_spinlock_set_name (
+	pgm_spinlock_t*	spinlock,
+	const char*	name
+	)
+{
+	pgm_assert (NULL != spinlock);
+	pgm_assert (NULL != name);
+
+#ifdef USE_LOCK_STATS
+	spinlock->stats = lockstat_lookup (name);
+#else
+	(void)spinlock;
+	(void)name;
+#endif
+}
+
+PGM_GNUC_INTERNAL
+void
+pgm_rwlock_set_name (
+	pgm_rwlock_t*	rwlock,
+	const char*	name
+	)
+{
+	pgm_assert (NULL != rwlock);
+	pgm_assert (NULL != name);
+
+#ifdef USE_LOCK_STATS
+	rwlock->stats = lockstat_lookup (name);
+#else
+	(void)rwlock;
+	(void)name;
+#endif
+}
+
+/* render the counters of every named lock, hold time percentiles as the upper
+ * bound of their bucket.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_lockstat_write_html_all (
+	pgm_string_t*	string
+	)
+{
+#ifdef USE_LOCK_STATS
+	const unsigned len = pgm_atomic_read32 (&lockstat_len);
+
+	pgm_string_append (string,	"\n<h2>Lock contention</h2>"
+					"\n<table>"
+					"<tr>"
+						"<th>Lock</th>"
+						"<th>Acquisitions</th>"
+						"<th>Contended</th>"
+						"<th>Spins</th>"
+						"<th>Mean hold</th>"
+						"<th>50% hold</th>"
+						"<th>99% hold</th>"
+						"<th>Max hold</th>"
+					"</tr>");
+	for (unsigned i = 0; i < len; i++)
+	{
+		const pgm_lockstat_t* stats = &lockstat_table[ i ];
+		uint64_t hold[ PGM_LOCKSTAT_HOLD_BUCKETS ], held = 0, count = 0, p50 = 0, p99 = 0, max = 0;
+		bool has_p50 = FALSE, has_p99 = FALSE;
+		for (unsigned j = 0; j < PGM_LOCKSTAT_HOLD_BUCKETS; j++) {
+			hold[ j ] = stats->hold[ j ];
+			held += hold[ j ];
+		}
+		for (unsigned j = 0; j < PGM_LOCKSTAT_HOLD_BUCKETS; j++) {
+			if (0 == hold[ j ])
+				continue;
+			const uint64_t upper = ((uint64_t)1 << j) - 1;
+			count += hold[ j ];
+			if (!has_p50 && count * 2 >= held) {
+				p50 = upper;
+				has_p50 = TRUE;
+			}
+			if (!has_p99 && count * 100 >= held * 99) {
+				p99 = upper;
+				has_p99 = TRUE;
+			}
+			max = upper;
+		}
+		pgm_string_append_printf (string,	"<tr>"
+								"<th>%s</th>"
+								"<td>%" PRIu64 "</td>"
+								"<td>%" PRIu64 "</td>"
+								"<td>%" PRIu64 "</td>"
+								"<td>%" PRIu64 " μs</td>"
+								"<td>%" PRIu64 " μs</td>"
+								"<td>%" PRIu64 " μs</td>"
+								"<td>%" PRIu64 " μs</td>"
+							"</tr>",
+					  stats->name,
+					  stats->acquisitions,
+					  stats->contended,
+					  stats->spins,
+					  held ? stats->hold_sum / held : 0,
+					  p50, p99, max);
+	}
+	pgm_string_append (string,	"</table>\n");
+#else
+	(void)string;
+#endif
+}
+
+static
+int
+thread_role_index (
+	const char*	role
+	)
+{
+	for (unsigned i = 0; i < PGM_N_ELEMENTS(thread_roles); i++)
+		if (0 == strcmp (role, thread_roles[ i ]))
+			return (int)i;
+	return -1;
+}
+
+/* returns placement of a role, the default for roles without their own
+ * setting.  an unknown role is a library defect, it is warned about and
+ * placed as the default.
+ */
+
+static
+const struct thread_attr_t*
+thread_role_attr (
+	const char*	role
+	)
+{
+	const int index = thread_role_index (role);
+	if (PGM_UNLIKELY(index < 0)) {
+		pgm_warn (_("Unknown thread role \"%s\", applying default placement."), role);
+		return &thread_attrs[ 0 ];
+	}
+	return &thread_attrs[ thread_attrs[ index ].is_set ? index : 0 ];
+}
+
+static
+bool
+thread_attr_store (
+	const int				index,
+	const struct pgm_thread_attr_t*const	attr
+	)
+{
+	struct thread_attr_t* dst = &thread_attrs[ index ];
+	if (PGM_UNLIKELY(attr->policy < PGM_SCHED_OTHER || attr->policy > PGM_SCHED_RR))
+		return FALSE;
+	if (NULL != attr->cpus && strlen (attr->cpus) >= sizeof (dst->cpus))
+		return FALSE;
+	if (NULL != attr->cpus)
+		strcpy (dst->cpus, attr->cpus);
+	else
+		dst->cpus[0] = '\0';
+	dst->policy	= attr->policy;
+	dst->priority	= attr->priority;
+	dst->is_set	= TRUE;
+	return TRUE;
+}
+
+/* set the CPU affinity, scheduling policy and priority of threads of a role
+ * created thereafter, role NULL for all roles without their own setting.
+ *
+ * returns TRUE on success, FALSE on unknown role or invalid attributes.
+ */
+
+bool
+pgm_thread_attr_set (
+	const char*				role,
+	const struct pgm_thread_attr_t*const	attr
+	)
+{
+	pgm_return_val_if_fail (NULL != attr, FALSE);
+	const int index = (NULL == role) ? 0 : thread_role_index (role);
+	if (PGM_UNLIKELY(index < 0))
+		return FALSE;
+	return thread_attr_store (index, attr);
+}
+
+/* PGM_THREAD_ATTR holds entries separated by ';' of the form
+ * role=cpus[@fifo:priority|@rr:priority], e.g. "default=0-1;timer=2@fifo:10".
+ * roles already set through pgm_thread_attr_set() are kept.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_thread_attr_init (void)
+{
+	char* env;
+	size_t envlen;
+
+	const errno_t err = pgm_dupenv_s (&env, &envlen, "PGM_THREAD_ATTR");
+	if (0 != err || 0 == envlen)
+		return;
+	char* next = env;
+	while (NULL != next)
+	{
+		char* entry = next;
+		next = strchr (entry, ';');
+		if (NULL != next)
+			*next++ = '\0';
+		if ('\0' == *entry)
+			continue;
+		struct pgm_thread_attr_t attr = { NULL, PGM_SCHED_OTHER, 0 };
+		char* cpus = strchr (entry, '=');
+		if (NULL == cpus)
+			goto bad_entry;
+		*cpus++ = '\0';
+		const int index = thread_role_index (entry);
+		if (index < 0)
+			goto bad_entry;
+		char* sched = strchr (cpus, '@');
+		if (NULL != sched) {
+			*sched++ = '\0';
+			char* priority = strchr (sched, ':');
+			if (NULL != priority) {
+				*priority++ = '\0';
+				attr.priority = atoi (priority);
+			}
+			if (0 == strcmp (sched, "fifo"))
+				attr.policy = PGM_SCHED_FIFO;
+			else if (0 == strcmp (sched, "rr"))
+				attr.policy = PGM_SCHED_RR;
+			else
+				goto bad_entry;
+		}
+		if ('\0' != *cpus)
+			attr.cpus = cpus;
+		if (thread_attrs[ index ].is_set)		/* application setting wins */
+			continue;
+		if (thread_attr_store (index, &attr))
+			continue;
+bad_entry:
+		pgm_warn (_("Ignoring invalid PGM_THREAD_ATTR entry \"%s\"."), entry);
+	}
+	pgm_free (env);
+}
+
+#if defined( __linux__ ) && defined( CPU_SETSIZE )
+/* parse a CPU list such as "0-3,8" into cpu_set.
+ *
+ * returns the number of CPUs set.
+ */
+
+static
+int
+thread_parse_cpus (
+	const char*	cpus,
+	cpu_set_t*	cpu_set
+	)
+{
+	unsigned first, last;
+	int n, count = 0;
+
+	CPU_ZERO (cpu_set);
+	while (1 == sscanf (cpus, "%u%n", &first, &n)) {
+		cpus += n;
+		last = first;
+		if ('-' == *cpus) {
+			if (1 != sscanf (++cpus, "%u%n", &last, &n))
+				return 0;
+			cpus += n;
+		}
+		for (unsigned cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++, count++)
+			CPU_SET (cpu, cpu_set);
+		if (',' != *cpus)
+			break;
+		cpus++;
+	}
+	return count;
+}
+#endif
+
+/* called first on every thread the library creates: names the thread for
+ * system tools and applies the configured placement of its role.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_thread_setup (
+	const char*	role
+	)
+{
+	const struct thread_attr_t* attr;
+
+/* pre-conditions */
+	pgm_assert (NULL != role);
+
+	attr = thread_role_attr (role);
+
+#if defined( __linux__ ) && defined( __GLIBC__ )
+	char name[16];
+	pgm_snprintf_s (name, sizeof (name), _TRUNCATE, "pgm-%s", role);
+	pthread_setname_np (pthread_self(), name);
+#endif
+	if (!attr->is_set)
+		return;
+
+#if defined( __linux__ ) && defined( CPU_SETSIZE )
+	if ('\0' != attr->cpus[0]) {
+		cpu_set_t cpu_set;
+		if (0 == thread_parse_cpus (attr->cpus, &cpu_set) ||
+		    0 != sched_setaffinity (0, sizeof (cpu_set), &cpu_set))
+			pgm_warn (_("Failed to set CPU affinity of %s thread to %s."), role, attr->cpus);
+	}
+#elif defined( _WIN32 )
+	if ('\0' != attr->cpus[0]) {
+		DWORD_PTR mask = 0;
+		unsigned first, last;
+		int n;
+		const char* cpus = attr->cpus;
+		while (1 == sscanf (cpus, "%u%n", &first, &n)) {
+			cpus += n;
+			last = first;
+			if ('-' == *cpus && 1 == sscanf (++cpus, "%u%n", &last, &n))
+				cpus += n;
+			for (unsigned cpu = first; cpu <= last && cpu < sizeof (mask) * 8; cpu++)
+				mask |= (DWORD_PTR)1 << cpu;
+			if (',' != *cpus++)
+				break;
+		}
+		if (0 == mask || 0 == SetThreadAffinityMask (GetCurrentThread(), mask))
+			pgm_warn (_("Failed to set CPU affinity of %s thread to %s."), role, attr->cpus);
+	}
+#endif
+
+	if (PGM_SCHED_OTHER == attr->policy)
+		return;
+#ifndef _WIN32
+	struct sched_param param;
+	memset (&param, 0, sizeof (param));
+	param.sched_priority = attr->priority;
+	const int status = pthread_setschedparam (pthread_self(),
+						  PGM_SCHED_FIFO == attr->policy ? SCHED_FIFO : SCHED_RR,
+						  &param);
+	if (0 != status) {
+		char errbuf[1024];
+		pgm_warn (_("Failed to set real-time priority %d of %s thread: %s"),
+			  attr->priority, role, pgm_strerror_s (errbuf, sizeof (errbuf), status));
+	}
+#else
+	if (!SetThreadPriority (GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+		pgm_warn (_("Failed to set real-time priority of %s thread."), role);
+#endif
+}
+
+/* pin the calling thread to the nth CPU, wrapping, of the role's CPU list or
+ * of the process affinity without one.  called after pgm_thread_setup() by
+ * roles that run one thread per CPU.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_thread_setup_nth (
+	const char*	role,
+	const unsigned	nth
+	)
+{
+	const struct thread_attr_t* attr;
+
+/* pre-conditions */
+	pgm_assert (NULL != role);
+
+	attr = thread_role_attr (role);
+
+#if defined( __linux__ ) && defined( CPU_SETSIZE )
+	cpu_set_t cpu_set;
+	int count = 0;
+	if (attr->is_set && '\0' != attr->cpus[0])
+		count = thread_parse_cpus (attr->cpus, &cpu_set);
+	if (0 == count && 0 == sched_getaffinity (0, sizeof (cpu_set), &cpu_set))
+		count = CPU_COUNT (&cpu_set);
+	if (0 == count)
+		return;
+	unsigned skip = nth % count, cpu;
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+		if (CPU_ISSET (cpu, &cpu_set) && 0 == skip--)
+			break;
+	CPU_ZERO (&cpu_set);
+	CPU_SET (cpu, &cpu_set);
+	if (0 != sched_setaffinity (0, sizeof (cpu_set), &cpu_set))
+		pgm_warn (_("Failed to set CPU affinity of %s thread %u to CPU %u."), role, nth, cpu);
+#elif defined( _WIN32 )
+	DWORD_PTR process_mask, system_mask;
+	(void)attr;
+	if (!GetProcessAffinityMask (GetCurrentProcess(), &process_mask, &system_mask) || 0 == process_mask)
+		return;
+	unsigned count = 0;
+	for (unsigned cpu = 0; cpu < sizeof (process_mask) * 8; cpu++)
+		if (process_mask & ((DWORD_PTR)1 << cpu))
+			count++;
+	unsigned skip = nth % count, cpu;
+	for (cpu = 0; cpu < sizeof (process_mask) * 8; cpu++)
+		if ((process_mask & ((DWORD_PTR)1 << cpu)) && 0 == skip--)
+			break;
+	if (0 == SetThreadAffinityMask (GetCurrentThread(), (DWORD_PTR)1 << cpu))
+		pgm_warn (_("Failed to set CPU affinity of %s thread %u to CPU %u."), role, nth, cpu);
+#else
+	(void)attr;
+	(void)nth;
+#endif
+}
+
 
 /* eof */
@@ -49,6 +49,16 @@ mock_teardown (void)
 	pgm_thread_shutdown ();
 }
 
+/* clean placement of every role */
+static
+void
+mock_attr_setup (void)
+{
+	pgm_thread_init ();
+	memset (thread_attrs, 0, sizeof (thread_attrs));
+	g_unsetenv ("PGM_THREAD_ATTR");
+}
+
 PGM_GNUC_INTERNAL
 int
 pgm_get_nprocs (void)
@@ -169,6 +179,24 @@ START_TEST (test_mutex_trylock_pass_001)
 }
 END_TEST
 
+/* target:
+ *	void
+ *	pgm_mutex_set_name (pgm_mutex_t* mutex, const char* name)
+ */
+
+START_TEST (test_mutex_set_name_pass_001)
+{
+	pgm_mutex_t mutex;
+	pgm_mutex_init (&mutex);
+	pgm_mutex_set_name (&mutex, "test_mutex");
+	pgm_mutex_lock (&mutex);
+	pgm_mutex_unlock (&mutex);
+	fail_unless (TRUE == pgm_mutex_trylock (&mutex), "named mutex");
+	pgm_mutex_unlock (&mutex);
+	pgm_mutex_free (&mutex);
+}
+END_TEST
+
 /* target:
  *	void
  *	pgm_spinlock_init (pgm_spinlock_t* spinlock)
@@ -427,6 +455,172 @@ START_TEST (test_rwlock_writer_trylock_pass_001)
 }
 END_TEST
 
+/* target:
+ *	void
+ *	pgm_thread_setup (const char* role)
+ */
+
+/* every role named by a library thread */
+START_TEST (test_thread_setup_pass_001)
+{
+	const char* roles[] = {
+		"timer", "http", "snmp", "stats", "logring", "recv", "fec", "rdata", "decode",
+		"standby", "core", "async", "sampler"
+	};
+	for (unsigned i = 0; i < G_N_ELEMENTS(roles); i++) {
+		fail_unless (thread_role_index (roles[ i ]) > 0, "role not resolved");
+		pgm_thread_setup (roles[ i ]);
+	}
+}
+END_TEST
+
+/* unknown role is placed as the default */
+START_TEST (test_thread_setup_pass_002)
+{
+	pgm_thread_setup ("bogus");
+	pgm_thread_setup_nth ("bogus", 0);
+}
+END_TEST
+
+START_TEST (test_thread_setup_fail_001)
+{
+	pgm_thread_setup (NULL);
+	fail ("reached");
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_thread_attr_set (
+ *		const char*				role,
+ *		const struct pgm_thread_attr_t*const	attr
+ *	)
+ */
+
+START_TEST (test_thread_attr_set_pass_001)
+{
+	const struct pgm_thread_attr_t attr = { "2-3", PGM_SCHED_FIFO, 10 };
+	fail_unless (TRUE == pgm_thread_attr_set ("timer", &attr), "attr_set failed");
+	const int index = thread_role_index ("timer");
+	fail_unless (TRUE == thread_attrs[ index ].is_set, "role not set");
+	fail_unless (0 == strcmp ("2-3", thread_attrs[ index ].cpus), "cpus not set");
+	fail_unless (PGM_SCHED_FIFO == thread_attrs[ index ].policy, "policy not set");
+	fail_unless (10 == thread_attrs[ index ].priority, "priority not set");
+	fail_unless (&thread_attrs[ index ] == thread_role_attr ("timer"), "role placement not applied");
+	fail_unless (&thread_attrs[ 0 ] == thread_role_attr ("http"), "default placement not applied");
+/* NULL role for the default */
+	const struct pgm_thread_attr_t dflt = { NULL, PGM_SCHED_OTHER, 0 };
+	fail_unless (TRUE == pgm_thread_attr_set (NULL, &dflt), "attr_set failed");
+	fail_unless (TRUE == thread_attrs[ 0 ].is_set, "default not set");
+	fail_unless ('\0' == thread_attrs[ 0 ].cpus[0], "unexpected default cpus");
+}
+END_TEST
+
+START_TEST (test_thread_attr_set_fail_001)
+{
+	const struct pgm_thread_attr_t attr = { "0", PGM_SCHED_OTHER, 0 };
+	fail_unless (FALSE == pgm_thread_attr_set ("bogus", &attr), "attr_set failed");
+	fail_unless (FALSE == pgm_thread_attr_set ("timer", NULL), "attr_set failed");
+	const struct pgm_thread_attr_t bad_policy = { "0", PGM_SCHED_RR + 1, 0 };
+	fail_unless (FALSE == pgm_thread_attr_set ("timer", &bad_policy), "attr_set failed");
+	char cpus[ sizeof (thread_attrs[0].cpus) + 1 ];
+	memset (cpus, '1', sizeof (cpus) - 1);
+	cpus[ sizeof (cpus) - 1 ] = '\0';
+	const struct pgm_thread_attr_t long_cpus = { cpus, PGM_SCHED_OTHER, 0 };
+	fail_unless (FALSE == pgm_thread_attr_set ("timer", &long_cpus), "attr_set failed");
+	for (unsigned i = 0; i < G_N_ELEMENTS(thread_attrs); i++)
+		fail_unless (FALSE == thread_attrs[ i ].is_set, "role set");
+}
+END_TEST
+
+/* target:
+ *	void
+ *	pgm_thread_attr_init (void)
+ */
+
+START_TEST (test_thread_attr_init_pass_001)
+{
+	g_setenv ("PGM_THREAD_ATTR", "default=0-1;timer=2@fifo:10;;recv=@rr:5;fec=0-3,5", TRUE);
+	pgm_thread_attr_init ();
+	const struct thread_attr_t* attr = &thread_attrs[ 0 ];
+	fail_unless (attr->is_set && 0 == strcmp ("0-1", attr->cpus) && PGM_SCHED_OTHER == attr->policy, "default not parsed");
+	attr = &thread_attrs[ thread_role_index ("timer") ];
+	fail_unless (attr->is_set && 0 == strcmp ("2", attr->cpus), "timer cpus not parsed");
+	fail_unless (PGM_SCHED_FIFO == attr->policy && 10 == attr->priority, "timer policy not parsed");
+	attr = &thread_attrs[ thread_role_index ("recv") ];
+	fail_unless (attr->is_set && '\0' == attr->cpus[0], "recv cpus not parsed");
+	fail_unless (PGM_SCHED_RR == attr->policy && 5 == attr->priority, "recv policy not parsed");
+	attr = &thread_attrs[ thread_role_index ("fec") ];
+	fail_unless (attr->is_set && 0 == strcmp ("0-3,5", attr->cpus), "fec cpus not parsed");
+	fail_unless (FALSE == thread_attrs[ thread_role_index ("http") ].is_set, "http set");
+}
+END_TEST
+
+/* application setting wins over the environment */
+START_TEST (test_thread_attr_init_pass_002)
+{
+	const struct pgm_thread_attr_t attr = { "3", PGM_SCHED_RR, 20 };
+	fail_unless (TRUE == pgm_thread_attr_set ("timer", &attr), "attr_set failed");
+	g_setenv ("PGM_THREAD_ATTR", "timer=2@fifo:10;http=1", TRUE);
+	pgm_thread_attr_init ();
+	const struct thread_attr_t* timer = &thread_attrs[ thread_role_index ("timer") ];
+	fail_unless (0 == strcmp ("3", timer->cpus), "timer cpus overridden");
+	fail_unless (PGM_SCHED_RR == timer->policy && 20 == timer->priority, "timer policy overridden");
+	fail_unless (0 == strcmp ("1", thread_attrs[ thread_role_index ("http") ].cpus), "http cpus not parsed");
+}
+END_TEST
+
+/* invalid entries are skipped, valid entries after them still apply */
+START_TEST (test_thread_attr_init_fail_001)
+{
+	g_setenv ("PGM_THREAD_ATTR", "bogus=1;timer;http=1@idle;snmp=1@fifo;stats=0123456789012345678901234567890123456789012345678901234567890123;decode=4", TRUE);
+	pgm_thread_attr_init ();
+	fail_unless (FALSE == thread_attrs[ 0 ].is_set, "default set");
+	fail_unless (FALSE == thread_attrs[ thread_role_index ("timer") ].is_set, "timer set");
+	fail_unless (FALSE == thread_attrs[ thread_role_index ("http") ].is_set, "http set");
+	fail_unless (FALSE == thread_attrs[ thread_role_index ("stats") ].is_set, "stats set");
+	const struct thread_attr_t* snmp = &thread_attrs[ thread_role_index ("snmp") ];
+	fail_unless (snmp->is_set && PGM_SCHED_FIFO == snmp->policy && 0 == snmp->priority, "snmp not parsed");
+	fail_unless (0 == strcmp ("4", thread_attrs[ thread_role_index ("decode") ].cpus), "decode not parsed");
+}
+END_TEST
+
+#if defined( __linux__ ) && defined( CPU_SETSIZE )
+/* target:
+ *	int
+ *	thread_parse_cpus (
+ *		const char*	cpus,
+ *		cpu_set_t*	cpu_set
+ *	)
+ */
+
+START_TEST (test_thread_parse_cpus_pass_001)
+{
+	cpu_set_t cpu_set;
+	fail_unless (5 == thread_parse_cpus ("0-3,5", &cpu_set), "parse_cpus failed");
+	for (unsigned cpu = 0; cpu < 4; cpu++)
+		fail_unless (CPU_ISSET (cpu, &cpu_set), "cpu not set");
+	fail_if (CPU_ISSET (4, &cpu_set), "cpu 4 set");
+	fail_unless (CPU_ISSET (5, &cpu_set), "cpu 5 not set");
+	fail_unless (5 == CPU_COUNT (&cpu_set), "unexpected cpu count");
+	fail_unless (1 == thread_parse_cpus ("7", &cpu_set), "parse_cpus failed");
+	fail_unless (CPU_ISSET (7, &cpu_set) && 1 == CPU_COUNT (&cpu_set), "cpu 7 not set");
+	fail_unless (3 == thread_parse_cpus ("1,2,8", &cpu_set), "parse_cpus failed");
+	fail_unless (CPU_ISSET (8, &cpu_set), "cpu 8 not set");
+}
+END_TEST
+
+START_TEST (test_thread_parse_cpus_fail_001)
+{
+	cpu_set_t cpu_set;
+	fail_unless (0 == thread_parse_cpus ("", &cpu_set), "parse_cpus failed");
+	fail_unless (0 == thread_parse_cpus ("x", &cpu_set), "parse_cpus failed");
+	fail_unless (0 == thread_parse_cpus ("2-", &cpu_set), "parse_cpus failed");
+	fail_unless (0 == CPU_COUNT (&cpu_set), "cpu set");
+}
+END_TEST
+#endif
+
 static
 Suite*
 make_test_suite (void)
@@ -479,6 +673,11 @@ make_mutex_suite (void)
 	suite_add_tcase (s, tc_trylock);
 	tcase_add_test (tc_trylock, test_mutex_trylock_pass_001);
 
+	TCase* tc_set_name = tcase_create ("set-name");
+	tcase_add_checked_fixture (tc_set_name, mock_setup, mock_teardown);
+	suite_add_tcase (s, tc_set_name);
+	tcase_add_test (tc_set_name, test_mutex_set_name_pass_001);
+
 	return s;
 }
 
@@ -569,6 +768,45 @@ make_rwlock_suite (void)
 	return s;
 }
 
+static
+Suite*
+make_setup_suite (void)
+{
+	Suite* s;
+
+	s = suite_create ("setup");
+
+	TCase* tc_setup = tcase_create ("setup");
+	suite_add_tcase (s, tc_setup);
+	tcase_add_checked_fixture (tc_setup, mock_setup, mock_teardown);
+	tcase_add_test (tc_setup, test_thread_setup_pass_001);
+	tcase_add_test (tc_setup, test_thread_setup_pass_002);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_setup, test_thread_setup_fail_001, SIGABRT);
+#endif
+
+	TCase* tc_attr_set = tcase_create ("attr-set");
+	suite_add_tcase (s, tc_attr_set);
+	tcase_add_checked_fixture (tc_attr_set, mock_attr_setup, mock_teardown);
+	tcase_add_test (tc_attr_set, test_thread_attr_set_pass_001);
+	tcase_add_test (tc_attr_set, test_thread_attr_set_fail_001);
+
+	TCase* tc_attr_init = tcase_create ("attr-init");
+	suite_add_tcase (s, tc_attr_init);
+	tcase_add_checked_fixture (tc_attr_init, mock_attr_setup, mock_teardown);
+	tcase_add_test (tc_attr_init, test_thread_attr_init_pass_001);
+	tcase_add_test (tc_attr_init, test_thread_attr_init_pass_002);
+	tcase_add_test (tc_attr_init, test_thread_attr_init_fail_001);
+
+#if defined( __linux__ ) && defined( CPU_SETSIZE )
+	TCase* tc_parse_cpus = tcase_create ("parse-cpus");
+	suite_add_tcase (s, tc_parse_cpus);
+	tcase_add_test (tc_parse_cpus, test_thread_parse_cpus_pass_001);
+	tcase_add_test (tc_parse_cpus, test_thread_parse_cpus_fail_001);
+#endif
+	return s;
+}
+
 static
 Suite*
 make_master_suite (void)
@@ -586,6 +824,7 @@ main (void)
 	srunner_add_suite (sr, make_mutex_suite ());
 	srunner_add_suite (sr, make_spinlock_suite ());
 	srunner_add_suite (sr, make_rwlock_suite ());
+	srunner_add_suite (sr, make_setup_suite ());
 	srunner_run_all (sr, CK_ENV);
 	int number_failed = srunner_ntests_failed (sr);
 	srunner_free (sr);
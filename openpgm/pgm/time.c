@@ -41,6 +41,8 @@
 
 pgm_time_update_func		pgm_time_update_now PGM_GNUC_READ_MOSTLY;
 pgm_time_since_epoch_func	pgm_time_since_epoch PGM_GNUC_READ_MOSTLY;
+bool				pgm_time_is_coarse PGM_GNUC_READ_MOSTLY = FALSE;
+PGM_THREAD_LOCAL pgm_time_t	pgm_time_cached = 0;
 
 
 /* locals */
@@ -225,6 +227,15 @@ us_to_tsc (
 #	ifndef _WIN32
 static bool			pgm_tsc_init (pgm_error_t**);
 #	endif
+#	ifdef __linux__
+#		include <fcntl.h>
+#		include <sys/types.h>
+#		include <sys/stat.h>
+#		include <unistd.h>
+static uint_fast32_t		tsc_khz_from_sysfs (void);
+static uint_fast32_t		tsc_cache_load (const uint32_t);
+static void			tsc_cache_store (const uint32_t, const uint_fast32_t);
+#	endif
 static pgm_time_t		pgm_tsc_update (void);
 #endif
 
@@ -330,6 +341,16 @@ pgm_time_init (
 /* clean environment copy */
 	pgm_free (pgm_timer);
 
+/* share one reading between packets of a receive call or batch */
+	err = pgm_dupenv_s (&pgm_timer, &envlen, "PGM_TIMER_COARSE");
+	if (0 == err && envlen > 0) {
+		if (atoi (pgm_timer) > 0) {
+			pgm_minor (_("Using coarse receive time stamps."));
+			pgm_time_is_coarse = TRUE;
+		}
+		pgm_free (pgm_timer);
+	}
+
 #ifdef HAVE_DEV_RTC
 	if (pgm_time_update_now == pgm_rtc_update)
 	{
@@ -371,107 +392,120 @@ pgm_time_init (
 	if (pgm_time_update_now == pgm_tsc_update)
 	{
 		char	*rdtsc_frequency;
+		pgm_cpu_t cpu;
 
+/* frequency reported by the processor, hypervisor, or kernel calibration
+ * avoids parsing /proc/cpuinfo which is slow on large hosts.
+ */
+		pgm_cpuid (&cpu);
+		tsc_khz = cpu.tsc_khz;
+#	ifdef __linux__
+		if (0 == tsc_khz)
+			tsc_khz = tsc_khz_from_sysfs ();
+#	endif
+		if (0 == tsc_khz)
+		{
 #ifdef HAVE_PROC_CPUINFO
 /* attempt to parse clock ticks from kernel
  */
-		FILE	*fp = fopen ("/proc/cpuinfo", "r");
-		if (fp)
-		{
-			char buffer[1024];
-			while (!feof(fp) && fgets (buffer, sizeof(buffer), fp))
+			FILE	*fp = fopen ("/proc/cpuinfo", "r");
+			if (fp)
 			{
-				if (strstr (buffer, "cpu MHz")) {
-					const char *p = strchr (buffer, ':');
-					if (p) tsc_khz = atoi (p + 1) * 1000;
-					break;
+				char buffer[1024];
+				while (!feof(fp) && fgets (buffer, sizeof(buffer), fp))
+				{
+					if (strstr (buffer, "cpu MHz")) {
+						const char *p = strchr (buffer, ':');
+						if (p) tsc_khz = atoi (p + 1) * 1000;
+						break;
+					}
 				}
+				fclose (fp);
 			}
-			fclose (fp);
-		}
 #elif defined(_WIN32)
 /* core frequency HKLM/Hardware/Description/System/CentralProcessor/0/~Mhz
  */
-		HKEY hKey;
-		if (ERROR_SUCCESS == RegOpenKeyExA (HKEY_LOCAL_MACHINE,
-					"HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0",
-					0,
-					KEY_QUERY_VALUE,
-					&hKey))
-		{
-			DWORD dwData = 0;
-			DWORD dwDataSize = sizeof (dwData);
-			if (ERROR_SUCCESS == RegQueryValueExA (hKey,
-						"~MHz",
-						NULL,
-						NULL,
-						(LPBYTE)&dwData,
-						&dwDataSize))
+			HKEY hKey;
+			if (ERROR_SUCCESS == RegOpenKeyExA (HKEY_LOCAL_MACHINE,
+						"HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0",
+						0,
+						KEY_QUERY_VALUE,
+						&hKey))
 			{
-				tsc_khz = dwData * 1000;
-				pgm_minor (_("Registry reports central processor frequency %u MHz"),
-					(unsigned)dwData);
-/* dump processor name for comparison aid of obtained frequency */
-				char szProcessorBrandString[48];
-				dwDataSize = sizeof (szProcessorBrandString);
+				DWORD dwData = 0;
+				DWORD dwDataSize = sizeof (dwData);
 				if (ERROR_SUCCESS == RegQueryValueExA (hKey,
-							"ProcessorNameString",
+							"~MHz",
 							NULL,
 							NULL,
-							(LPBYTE)szProcessorBrandString,
+							(LPBYTE)&dwData,
 							&dwDataSize))
 				{
-					pgm_minor (_("Processor Brand String \"%s\""), szProcessorBrandString);
+					tsc_khz = dwData * 1000;
+					pgm_minor (_("Registry reports central processor frequency %u MHz"),
+						(unsigned)dwData);
+/* dump processor name for comparison aid of obtained frequency */
+					char szProcessorBrandString[48];
+					dwDataSize = sizeof (szProcessorBrandString);
+					if (ERROR_SUCCESS == RegQueryValueExA (hKey,
+								"ProcessorNameString",
+								NULL,
+								NULL,
+								(LPBYTE)szProcessorBrandString,
+								&dwDataSize))
+					{
+						pgm_minor (_("Processor Brand String \"%s\""), szProcessorBrandString);
+					}
 				}
+				else
+				{
+					const DWORD save_errno = GetLastError();
+					char winstr[1024];
+					pgm_warn (_("Registry query on HKLM\\HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0\\~MHz failed: %s"),
+						pgm_win_strerror (winstr, sizeof (winstr), save_errno));
+				}
+				RegCloseKey (hKey);
 			}
-			else
-			{
-				const DWORD save_errno = GetLastError();
-				char winstr[1024];
-				pgm_warn (_("Registry query on HKLM\\HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0\\~MHz failed: %s"),
-					pgm_win_strerror (winstr, sizeof (winstr), save_errno));
-			}
-			RegCloseKey (hKey);
-		}
 #elif defined(__APPLE__)
 /* nb: RDTSC is non-functional on Darwin */
-		uint64_t cpufrequency;
-		size_t len;
-		len = sizeof (cpufrequency);
-		if (0 == sysctlbyname ("hw.cpufrequency", &cpufrequency, &len, NULL, 0)) {
-			tsc_khz = (uint_fast32_t)(cpufrequency / 1000);
-		}
+			uint64_t cpufrequency;
+			size_t len;
+			len = sizeof (cpufrequency);
+			if (0 == sysctlbyname ("hw.cpufrequency", &cpufrequency, &len, NULL, 0)) {
+				tsc_khz = (uint_fast32_t)(cpufrequency / 1000);
+			}
 #elif defined(__FreeBSD__)
 /* frequency in Mhz */
-		unsigned long clockrate;
-		size_t len;
-		len = sizeof (clockrate);
-		if (0 == sysctlbyname ("hw.clockrate", &clockrate, &len, NULL, 0)) {
-			tsc_khz = (uint_fast32_t)(clockrate * 1000);
-		}
+			unsigned long clockrate;
+			size_t len;
+			len = sizeof (clockrate);
+			if (0 == sysctlbyname ("hw.clockrate", &clockrate, &len, NULL, 0)) {
+				tsc_khz = (uint_fast32_t)(clockrate * 1000);
+			}
 #elif defined(__NetBSD__)
-		uint64_t clockrate;
-		size_t len;
-		len = sizeof (clockrate);
-		if (0 == sysctlbyname ("machdep.tsc_freq", &clockrate, &len, NULL, 0)) {
-			tsc_khz = (uint_fast32_t)(clockrate / 1000);
-		}
+			uint64_t clockrate;
+			size_t len;
+			len = sizeof (clockrate);
+			if (0 == sysctlbyname ("machdep.tsc_freq", &clockrate, &len, NULL, 0)) {
+				tsc_khz = (uint_fast32_t)(clockrate / 1000);
+			}
 #elif defined(KSTAT_DATA_INT32)
 /* ref: http://developers.sun.com/solaris/articles/kstatc.html */
-		kstat_ctl_t* kc;
-		kstat_t* ksp;
-		kstat_named_t* kdata;
-		if (NULL != (kc = kstat_open()) &&
-			NULL != (ksp = kstat_lookup (kc, "cpu_info", -1, NULL)) &&
-			KSTAT_TYPE_NAMED == ksp->ks_type &&
-			-1 != kstat_read (kc, ksp, NULL) &&
-			NULL != (kdata = kstat_data_lookup (ksp, "clock_MHz")) &&
-			KSTAT_DATA_INT32 == kdata->data_type)
-		{
-			tsc_khz = (uint_fast32_t)(kdata->value.i32 * 1000);
-			kstat_close (kc);
-		}
+			kstat_ctl_t* kc;
+			kstat_t* ksp;
+			kstat_named_t* kdata;
+			if (NULL != (kc = kstat_open()) &&
+				NULL != (ksp = kstat_lookup (kc, "cpu_info", -1, NULL)) &&
+				KSTAT_TYPE_NAMED == ksp->ks_type &&
+				-1 != kstat_read (kc, ksp, NULL) &&
+				NULL != (kdata = kstat_data_lookup (ksp, "clock_MHz")) &&
+				KSTAT_DATA_INT32 == kdata->data_type)
+			{
+				tsc_khz = (uint_fast32_t)(kdata->value.i32 * 1000);
+				kstat_close (kc);
+			}
 #endif /* !_WIN32 */
+		}
 
 /* e.g. export RDTSC_FREQUENCY=3200.000000
  *
@@ -484,6 +518,11 @@ pgm_time_init (
 		}
 
 #ifndef _WIN32
+#	ifdef __linux__
+/* result of a prior calibration on this boot of the host */
+		if (0 >= tsc_khz)
+			tsc_khz = tsc_cache_load (cpu.signature);
+#	endif
 /* calibrate */
 		if (0 >= tsc_khz) {
 			pgm_error_t* sub_error = NULL;
@@ -491,6 +530,10 @@ pgm_time_init (
 				pgm_propagate_error (error, sub_error);
 				goto err_cleanup;
 			}
+#	ifdef __linux__
+			if (pgm_time_update_now == pgm_tsc_update && tsc_khz > 0)
+				tsc_cache_store (cpu.signature, tsc_khz);
+#	endif
 		}
 #endif
 		pgm_minor (_("TSC frequency set at %u KHz"), (unsigned)(tsc_khz));
@@ -588,9 +631,40 @@ pgm_time_shutdown (void)
 	if (pgm_time_update_now == pgm_hpet_update)
 		retval = pgm_hpet_shutdown ();
 #endif
+	pgm_time_is_coarse = FALSE;
 	return retval;
 }
 
+/* system time in microseconds since the epoch.  unlike the core timer it is
+ * comparable between hosts with synchronized clocks, e.g. by PTP, and may
+ * step backwards.
+ */
+
+PGM_GNUC_INTERNAL
+pgm_time_t
+pgm_time_wall_now (void)
+{
+#if defined( HAVE_CLOCK_GETTIME )
+	struct timespec ts;
+	clock_gettime (CLOCK_REALTIME, &ts);
+	return secs_to_usecs (ts.tv_sec) + (pgm_time_t)ts.tv_nsec / 1000;
+#elif defined( HAVE_GETTIMEOFDAY )
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return secs_to_usecs (tv.tv_sec) + tv.tv_usec;
+#elif defined( _WIN32 )
+	FILETIME ft;
+	ULARGE_INTEGER now;
+	GetSystemTimeAsFileTime (&ft);
+	now.LowPart  = ft.dwLowDateTime;
+	now.HighPart = ft.dwHighDateTime;
+/* 100ns intervals since 1601 */
+	return (now.QuadPart - UINT64_C(116444736000000000)) / 10;
+#else
+	return pgm_time_update_now() + rel_offset;
+#endif
+}
+
 #ifdef HAVE_GETTIMEOFDAY
 static
 pgm_time_t
@@ -894,6 +968,140 @@ pgm_tsc_init (
 }
 #	endif
 
+#	ifdef __linux__
+/* TSC frequency as calibrated by the kernel, only exported by some kernels.
+ */
+
+static
+uint_fast32_t
+tsc_khz_from_sysfs (void)
+{
+	FILE		*fp = fopen ("/sys/devices/system/cpu/cpu0/tsc_freq_khz", "r");
+	unsigned long	 khz = 0;
+
+	if (fp) {
+		if (1 != fscanf (fp, "%lu", &khz))
+			khz = 0;
+		fclose (fp);
+	}
+	if (khz > 0)
+		pgm_minor (_("Kernel reports TSC frequency %lu KHz"), khz);
+	return (uint_fast32_t)khz;
+}
+
+/* Calibration results are cached in the file named by PGM_TSC_CACHE, or
+ * otherwise $XDG_RUNTIME_DIR/pgm-tsc, as one line of boot id, processor
+ * signature and frequency such that a reboot or migration invalidates
+ * the entry.
+ *
+ * returns path to be freed with pgm_free(), or NULL if caching is disabled.
+ */
+
+static
+char*
+tsc_cache_path (void)
+{
+	char	*env, *path = NULL;
+	size_t	 envlen;
+
+	if (0 == pgm_dupenv_s (&env, &envlen, "PGM_TSC_CACHE")) {
+		if (envlen > 1)
+			return env;
+		pgm_free (env);
+	}
+	if (0 == pgm_dupenv_s (&env, &envlen, "XDG_RUNTIME_DIR")) {
+		if (envlen > 1)
+			path = pgm_strconcat (env, "/pgm-tsc", NULL);
+		pgm_free (env);
+	}
+	return path;
+}
+
+static
+bool
+tsc_boot_id (
+	char*		buf,
+	const size_t	len
+	)
+{
+	FILE	*fp = fopen ("/proc/sys/kernel/random/boot_id", "r");
+	bool	 ret = FALSE;
+
+	if (fp) {
+		if (NULL != fgets (buf, (int)len, fp)) {
+			buf[ strcspn (buf, "\n") ] = '\0';
+			ret = ('\0' != buf[0]);
+		}
+		fclose (fp);
+	}
+	return ret;
+}
+
+static
+uint_fast32_t
+tsc_cache_load (
+	const uint32_t		signature
+	)
+{
+	char		 boot_id[64], cached_id[64];
+	unsigned long	 cached_signature, khz = 0;
+	struct stat	 statbuf;
+	FILE		*fp;
+	char		*path = tsc_cache_path ();
+
+	if (NULL == path)
+		return 0;
+	fp = fopen (path, "r");
+	pgm_free (path);
+	if (NULL == fp)
+		return 0;
+/* only trust a cache written by ourselves */
+	if (0 == fstat (fileno (fp), &statbuf) &&
+	    statbuf.st_uid == geteuid() &&
+	    tsc_boot_id (boot_id, sizeof (boot_id)) &&
+	    3 == fscanf (fp, "%63s %lx %lu", cached_id, &cached_signature, &khz) &&
+	    0 == strcmp (boot_id, cached_id) &&
+	    signature == cached_signature)
+	{
+		pgm_minor (_("Cached TSC calibration %lu KHz"), khz);
+	}
+	else
+		khz = 0;
+	fclose (fp);
+	return (uint_fast32_t)khz;
+}
+
+static
+void
+tsc_cache_store (
+	const uint32_t		signature,
+	const uint_fast32_t	khz
+	)
+{
+	char	 boot_id[64], record[128], tmp_path[1024];
+	char	*path;
+	int	 fd, record_len;
+
+	if (!tsc_boot_id (boot_id, sizeof (boot_id)))
+		return;
+	path = tsc_cache_path ();
+	if (NULL == path)
+		return;
+	record_len = pgm_snprintf_s (record, sizeof (record), _TRUNCATE, "%s %" PRIx32 " %" PRIuFAST32 "\n",
+				     boot_id, signature, khz);
+/* write aside and rename as concurrent processes may calibrate together */
+	pgm_snprintf_s (tmp_path, sizeof (tmp_path), _TRUNCATE, "%s.%d", path, (int)getpid());
+	fd = open (tmp_path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+	if (-1 != fd) {
+		const bool is_written = (record_len > 0 && record_len == write (fd, record, record_len));
+		close (fd);
+		if (!is_written || 0 != rename (tmp_path, path))
+			unlink (tmp_path);
+	}
+	pgm_free (path);
+}
+#	endif /* __linux__ */
+
 /* TSC is monotonic on the same core but we do neither force the same core or save the count
  * for each core as if the counter is unstable system wide another timing mechanism should be
  * used, preferably HPET on x86/AMD64 or gettimeofday() on SPARC.
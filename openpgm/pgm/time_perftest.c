@@ -0,0 +1,204 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * performance tests for time stamp functions.
+ *
+ * Copyright (c) 2010-2016 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <glib.h>
+#include <check.h>
+
+
+/* mock state */
+
+#define PERF_ITERATIONS		10000000
+#define PERF_BATCH_SIZE		32		/* packets per receive call */
+
+static const char* perf_timer	= NULL;
+
+static
+void
+mock_setup_gtod (void)
+{
+	perf_timer	= "GTOD";
+}
+
+static
+void
+mock_setup_clock (void)
+{
+	perf_timer	= "CLOCK";
+}
+
+static
+void
+mock_setup_tsc (void)
+{
+	perf_timer	= "TSC";
+}
+
+#include "time.c"
+
+PGM_GNUC_INTERNAL
+int
+pgm_get_nprocs (void)
+{
+	return 1;
+}
+
+static
+void
+mock_setup (void)
+{
+	g_setenv ("PGM_TIMER", perf_timer, TRUE);
+	g_setenv ("PGM_TIMER_COARSE", "1", TRUE);
+	g_assert (pgm_time_init (NULL));
+}
+
+static
+void
+mock_teardown (void)
+{
+	g_assert (pgm_time_shutdown ());
+	g_unsetenv ("PGM_TIMER_COARSE");
+}
+
+static
+void
+report (
+	const char*	name,
+	const gint64	elapsed_ns
+	)
+{
+	g_message ("%s/%s: elapsed time %" G_GINT64_FORMAT " us, unit time %" G_GINT64_FORMAT " ns",
+		name, perf_timer,
+		elapsed_ns / 1000,
+		elapsed_ns / PERF_ITERATIONS);
+}
+
+/* elapsed time from the monotonic clock independent of the timer under test.
+ */
+
+static
+gint64
+now_ns (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ((gint64)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+/* target:
+ *	pgm_time_t
+ *	pgm_time_update_now (void)
+ */
+
+START_TEST (test_update_now)
+{
+	volatile pgm_time_t sink;
+	const gint64 start = now_ns();
+	for (unsigned i = PERF_ITERATIONS; i; i--)
+		sink = pgm_time_update_now();
+	report ("update-now", now_ns() - start);
+	(void)sink;
+}
+END_TEST
+
+/* target:
+ *	pgm_time_t
+ *	pgm_time_coarse_now (void)
+ *
+ * refreshed once per receive batch as per pgm_recvmsgv().
+ */
+
+START_TEST (test_coarse_now)
+{
+	volatile pgm_time_t sink;
+	const gint64 start = now_ns();
+	for (unsigned i = PERF_ITERATIONS; i; i--) {
+		if (0 == i % PERF_BATCH_SIZE)
+			pgm_time_refresh();
+		sink = pgm_time_coarse_now();
+	}
+	report ("coarse-now", now_ns() - start);
+	(void)sink;
+}
+END_TEST
+
+static
+Suite*
+make_time_suite (void)
+{
+	Suite* s;
+
+	s = suite_create ("Time stamp functions");
+
+	TCase* tc_gtod = tcase_create ("gettimeofday");
+	suite_add_tcase (s, tc_gtod);
+	tcase_add_checked_fixture (tc_gtod, mock_setup_gtod, NULL);
+	tcase_add_checked_fixture (tc_gtod, mock_setup, mock_teardown);
+	tcase_add_test (tc_gtod, test_update_now);
+	tcase_add_test (tc_gtod, test_coarse_now);
+
+#ifdef HAVE_CLOCK_GETTIME
+	TCase* tc_clock = tcase_create ("clock_gettime");
+	suite_add_tcase (s, tc_clock);
+	tcase_add_checked_fixture (tc_clock, mock_setup_clock, NULL);
+	tcase_add_checked_fixture (tc_clock, mock_setup, mock_teardown);
+	tcase_add_test (tc_clock, test_update_now);
+	tcase_add_test (tc_clock, test_coarse_now);
+#endif
+
+#ifdef HAVE_RDTSC
+	TCase* tc_tsc = tcase_create ("TSC");
+	suite_add_tcase (s, tc_tsc);
+	tcase_add_checked_fixture (tc_tsc, mock_setup_tsc, NULL);
+	tcase_add_checked_fixture (tc_tsc, mock_setup, mock_teardown);
+	tcase_add_test (tc_tsc, test_update_now);
+	tcase_add_test (tc_tsc, test_coarse_now);
+#endif
+
+	return s;
+}
+
+static
+Suite*
+make_master_suite (void)
+{
+	Suite* s = suite_create ("Master");
+	return s;
+}
+
+int
+main (void)
+{
+	pgm_messages_init();
+	SRunner* sr = srunner_create (make_master_suite ());
+	srunner_add_suite (sr, make_time_suite ());
+	srunner_run_all (sr, CK_ENV);
+	int number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	pgm_messages_shutdown();
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* eof */
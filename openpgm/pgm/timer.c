@@ -27,6 +27,10 @@
 #include <impl/timer.h>
 #include <impl/receiver.h>
 #include <impl/source.h>
+#include <impl/tfmcc.h>
+#ifdef HAVE_TIMERFD_CREATE
+#	include <sys/timerfd.h>
+#endif
 
 
 //#define TIMER_DEBUG
@@ -78,7 +82,19 @@ pgm_timer_check (
 	pgm_sock_t* const	sock
 	)
 {
-	const pgm_time_t now = pgm_time_update_now();
+	return pgm_timer_check_at (sock, pgm_time_update_now());
+}
+
+/* as pgm_timer_check() against a clock reading shared by the caller.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_timer_check_at (
+	pgm_sock_t* const	sock,
+	const pgm_time_t	now
+	)
+{
 	bool expired;
 
 /* pre-conditions */
@@ -111,8 +127,54 @@ pgm_timer_expiration (
 	return expiration;
 }
 
+/* sweep the other shards with due timers that no receiving thread holds, a
+ * held shard is swept by its holder on the next timer check.
+ *
+ * returns the earliest timer expiration across all shards.
+ */
+
+static
+pgm_time_t
+dispatch_idle_shards (
+	pgm_sock_t*	       const restrict sock,
+	struct pgm_rx_shard_t* const restrict shard,	/* held by caller */
+	const pgm_time_t		      now,
+	pgm_time_t			      expiration
+	)
+{
+	pgm_timer_lock (sock);
+	shard->next_poll = expiration;
+	pgm_timer_unlock (sock);
+
+	for (unsigned i = 0; i < sock->rx_shard_len; i++)
+	{
+		struct pgm_rx_shard_t* other = &sock->rx_shard[ i ];
+		if (other == shard)
+			continue;
+		pgm_timer_lock (sock);
+		pgm_time_t next_poll = other->next_poll;
+		pgm_timer_unlock (sock);
+		if (pgm_time_after_eq (now, next_poll) &&
+		    pgm_mutex_trylock (&other->mutex))
+		{
+/* a blocked send leaves the shard due for the next sweep */
+			if (pgm_check_peer_state (sock, other, now)) {
+				next_poll = pgm_min_receiver_expiry (sock, other, now + sock->peer_expiry);
+				pgm_timer_lock (sock);
+				other->next_poll = next_poll;
+				pgm_timer_unlock (sock);
+			}
+			pgm_mutex_unlock (&other->mutex);
+		}
+		if (pgm_time_after (expiration, next_poll))
+			expiration = next_poll;
+	}
+	return expiration;
+}
+
 /* call all timers, assume that time_now has been updated by either pgm_timer_prepare
- * or pgm_timer_check and no other method calls here.
+ * or pgm_timer_check and no other method calls here.  peer timers are swept
+ * for the receive shard held by the caller.
  * 
  * returns TRUE on success, returns FALSE on blocked send-in-receive operation.
  */
@@ -120,7 +182,8 @@ pgm_timer_expiration (
 PGM_GNUC_INTERNAL
 bool
 pgm_timer_dispatch (
-	pgm_sock_t* const	sock
+	pgm_sock_t*	       const restrict sock,
+	struct pgm_rx_shard_t* const restrict shard
 	)
 {
 	const pgm_time_t now = pgm_time_update_now();
@@ -128,15 +191,18 @@ pgm_timer_dispatch (
 
 /* pre-conditions */
 	pgm_assert (NULL != sock);
+	pgm_assert (NULL != shard);
 
-	pgm_debug ("pgm_timer_dispatch (sock:%p)", (const void*)sock);
+	pgm_debug ("pgm_timer_dispatch (sock:%p shard:%u)", (const void*)sock, shard->index);
 
 /* find which timers have expired and call each */
 	if (sock->can_recv_data)
 	{
-		if (!pgm_check_peer_state (sock, now))
+		if (!pgm_check_peer_state (sock, shard, now))
 			return FALSE;
-		next_expiration = pgm_min_receiver_expiry (sock, now + sock->peer_expiry);
+		next_expiration = pgm_min_receiver_expiry (sock, shard, now + sock->peer_expiry);
+		if (sock->rx_shard_len > 1)
+			next_expiration = dispatch_idle_shards (sock, shard, now, next_expiration);
 	}
 
 	if (sock->can_send_data)
@@ -165,19 +231,89 @@ printf ("ACK timeout, T:%u W:%u\n", pgm_fp8tou(sock->tokens), pgm_fp8tou(sock->c
 			next_expiration = next_expiration > 0 ? MIN(next_expiration, sock->ack_expiry) : sock->ack_expiry;
 		}
 
+/* coalesced APDUs past their wait, a source busy in another thread sends them
+ * itself.
+ */
+		if (sock->coalesce_threshold)
+		{
+			pgm_sock_mutex_lock (sock, &sock->timer_mutex);
+			const pgm_time_t coalesce_expiry = sock->coalesce_expiry;
+			pgm_sock_mutex_unlock (sock, &sock->timer_mutex);
+			if (0 != coalesce_expiry)
+			{
+				if (pgm_time_after_eq (now, coalesce_expiry) &&
+				    pgm_sock_mutex_trylock (sock, &sock->source_mutex))
+				{
+					const int status = pgm_coalesce_flush (sock);
+					pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+					if (PGM_IO_STATUS_NORMAL != status)
+						return FALSE;
+				}
+				else
+					next_expiration = next_expiration > 0 ? MIN(next_expiration, coalesce_expiry) : coalesce_expiry;
+			}
+		}
+
+/* partial transmission group idle past its wait, a source busy in another
+ * thread is still adding to it.
+ */
+		if (sock->fec_idle_ivl)
+		{
+			pgm_sock_mutex_lock (sock, &sock->timer_mutex);
+			const pgm_time_t fec_idle_expiry = sock->fec_idle_expiry;
+			pgm_sock_mutex_unlock (sock, &sock->timer_mutex);
+			if (0 != fec_idle_expiry)
+			{
+				if (pgm_time_after_eq (now, fec_idle_expiry) &&
+				    pgm_sock_mutex_trylock (sock, &sock->source_mutex))
+				{
+					pgm_fec_idle_flush (sock, now);
+					pgm_sock_mutex_unlock (sock, &sock->source_mutex);
+				}
+				else
+					next_expiration = next_expiration > 0 ? MIN(next_expiration, fec_idle_expiry) : fec_idle_expiry;
+			}
+		}
+
+/* TFMCC rate halving without feedback */
+		if (sock->use_tfmcc)
+		{
+			pgm_tfmcc_check (sock, now);
+			next_expiration = next_expiration > 0 ? MIN(next_expiration, sock->tfmcc_expiry) : sock->tfmcc_expiry;
+		}
+
+/* general POLL rounds sizing the receiver population */
+		if (sock->poll_ivl)
+		{
+			if (0 == sock->next_general_poll)
+				sock->next_general_poll = now;
+			if (pgm_time_after_eq (now, sock->next_general_poll))
+			{
+				if (!pgm_send_poll (sock))
+					return FALSE;
+				sock->next_general_poll = now + sock->poll_ivl;
+			}
+			next_expiration = next_expiration > 0 ? MIN(next_expiration, sock->next_general_poll) : sock->next_general_poll;
+		}
+
 /* SPM broadcast */
-		pgm_mutex_lock (&sock->timer_mutex);
+		pgm_sock_mutex_lock (sock, &sock->timer_mutex);
 		const unsigned spm_heartbeat_state = sock->spm_heartbeat_state;
 		const pgm_time_t next_heartbeat_spm = sock->next_heartbeat_spm;
-		pgm_mutex_unlock (&sock->timer_mutex);
+		pgm_sock_mutex_unlock (sock, &sock->timer_mutex);
 
 /* no lock needed on ambient */
 		const pgm_time_t next_ambient_spm = sock->next_ambient_spm;
 		pgm_time_t next_spm = spm_heartbeat_state ? MIN(next_heartbeat_spm, next_ambient_spm) : next_ambient_spm;
 
 		if (pgm_time_after_eq (now, next_spm) &&
-		   !pgm_send_spm (sock, 0))
-			return FALSE;
+		    ((spm_heartbeat_state && pgm_time_after_eq (now, next_heartbeat_spm)) ||
+		     !pgm_spm_is_suppressed (sock, now)))
+		{
+			if (!pgm_send_spm (sock, 0))
+				return FALSE;
+			sock->spm_tstamp = now;
+		}
 
 /* ambient timing not so important so base next event off current time */
 		if (pgm_time_after_eq (now, next_ambient_spm))
@@ -200,7 +336,7 @@ printf ("ACK timeout, T:%u W:%u\n", pgm_fp8tou(sock->tokens), pgm_fp8tou(sock->c
 				}
 			} while (pgm_time_after_eq (now, new_heartbeat_spm));
 /* check for reset heartbeat */
-			pgm_mutex_lock (&sock->timer_mutex);
+			pgm_sock_mutex_lock (sock, &sock->timer_mutex);
 			if (next_heartbeat_spm == sock->next_heartbeat_spm) {
 				sock->spm_heartbeat_state = new_heartbeat_state;
 				sock->next_heartbeat_spm  = new_heartbeat_spm;
@@ -208,21 +344,92 @@ printf ("ACK timeout, T:%u W:%u\n", pgm_fp8tou(sock->tokens), pgm_fp8tou(sock->c
 			} else
 				next_spm = MIN(sock->next_ambient_spm, sock->next_heartbeat_spm);
 			sock->next_poll = next_expiration > 0 ? MIN(next_expiration, next_spm) : next_spm;
-			pgm_mutex_unlock (&sock->timer_mutex);
+			pgm_sock_mutex_unlock (sock, &sock->timer_mutex);
 			return TRUE;
 		}
 
 		next_expiration = next_expiration > 0 ? MIN(next_expiration, next_spm) : next_spm;
 
 /* check for reset */
-		pgm_mutex_lock (&sock->timer_mutex);
+		pgm_sock_mutex_lock (sock, &sock->timer_mutex);
 		sock->next_poll = sock->next_poll > now ? MIN(sock->next_poll, next_expiration) : next_expiration;
-		pgm_mutex_unlock (&sock->timer_mutex);
+		pgm_sock_mutex_unlock (sock, &sock->timer_mutex);
 	}
-	else
+	else {
+		pgm_timer_lock (sock);
 		sock->next_poll = next_expiration;
+		pgm_timer_unlock (sock);
+	}
 
 	return TRUE;
 }
 
+/* program the PGM_EVENT_SOCK timerfd with the earlier of the next timer and a
+ * pending rate limit expiry.  setting the timer discards any expiration not
+ * yet read, so re-arming after servicing the socket clears its readiness.  a
+ * due deadline is armed one nanosecond ahead as zero disarms the timer.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_timer_event_arm (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+#ifdef HAVE_TIMERFD_CREATE
+	if (INVALID_SOCKET == sock->event_timer_fd)
+		return;
+
+	const pgm_time_t now = pgm_time_update_now();
+	struct itimerspec its;
+	memset (&its, 0, sizeof(its));
+
+/* serialise programming so a stale deadline cannot overwrite a newer one */
+	pgm_sock_mutex_lock (sock, &sock->timer_mutex);
+	pgm_time_t expiration = sock->next_poll;
+	if (0 != sock->event_rate_expiry) {
+		if (pgm_time_after (sock->event_rate_expiry, now))
+			expiration = MIN(expiration, sock->event_rate_expiry);
+		else
+			sock->event_rate_expiry = 0;
+	}
+	if (pgm_time_after (expiration, now)) {
+		const pgm_time_t usecs = expiration - now;
+		its.it_value.tv_sec  = (time_t)(usecs / 1000000UL);
+		its.it_value.tv_nsec = (long)((usecs % 1000000UL) * 1000UL);
+	} else
+		its.it_value.tv_nsec = 1;
+	if (0 != timerfd_settime (sock->event_timer_fd, 0, &its, NULL)) {
+		char errbuf[1024];
+		pgm_warn (_("Arming event timer failed: %s"),
+			  pgm_strerror_s (errbuf, sizeof (errbuf), errno));
+	}
+	pgm_sock_mutex_unlock (sock, &sock->timer_mutex);
+#endif /* HAVE_TIMERFD_CREATE */
+}
+
+/* wake the PGM_EVENT_SOCK when a rate limited send may be retried.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_timer_event_rate (
+	pgm_sock_t* const	sock,
+	const pgm_time_t	expiration
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+	if (INVALID_SOCKET == sock->event_timer_fd)
+		return;
+	pgm_sock_mutex_lock (sock, &sock->timer_mutex);
+	sock->event_rate_expiry = expiration;
+	pgm_sock_mutex_unlock (sock, &sock->timer_mutex);
+	pgm_timer_event_arm (sock);
+}
+
 /* eof */
@@ -48,6 +48,11 @@
 #define pgm_min_receiver_expiry		mock_pgm_min_receiver_expiry
 #define pgm_check_peer_state		mock_pgm_check_peer_state
 #define pgm_send_spm			mock_pgm_send_spm
+#define pgm_coalesce_flush		mock_pgm_coalesce_flush
+#define pgm_fec_idle_flush		mock_pgm_fec_idle_flush
+#define pgm_spm_is_suppressed		mock_pgm_spm_is_suppressed
+#define pgm_send_poll			mock_pgm_send_poll
+#define pgm_tfmcc_check			mock_pgm_tfmcc_check
 
 
 #define TIMER_DEBUG
@@ -63,6 +68,8 @@ pgm_sock_t*
 generate_sock (void)
 {
 	pgm_sock_t* sock = g_new0 (pgm_sock_t, 1);
+	sock->rx_shard = g_new0 (struct pgm_rx_shard_t, 1);
+	sock->rx_shard_len = 1;
 	return sock;
 }
 
@@ -178,6 +185,15 @@ mock_g_source_unref (
 	g_free (source);
 }
 
+/** engine module */
+PGM_GNUC_INTERNAL
+void
+pgm_engine_timer_wake (
+	const pgm_time_t		expiration
+	)
+{
+}
+
 /** time module */
 static
 pgm_time_t
@@ -191,6 +207,7 @@ PGM_GNUC_INTERNAL
 pgm_time_t
 mock_pgm_min_receiver_expiry (
 	pgm_sock_t*		sock,
+	struct pgm_rx_shard_t*	shard,
 	pgm_time_t		expiration
 	)
 {
@@ -202,6 +219,7 @@ PGM_GNUC_INTERNAL
 bool
 mock_pgm_check_peer_state (
 	pgm_sock_t*		sock,
+	struct pgm_rx_shard_t*	shard,
 	pgm_time_t		now
 	)
 {
@@ -221,6 +239,58 @@ mock_pgm_send_spm (
 	return TRUE;
 }
 
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_spm_is_suppressed (
+	pgm_sock_t*		sock,
+	const pgm_time_t	now
+	)
+{
+	g_assert (NULL != sock);
+	return FALSE;
+}
+
+PGM_GNUC_INTERNAL
+bool
+mock_pgm_send_poll (
+	pgm_sock_t*		sock
+	)
+{
+	g_assert (NULL != sock);
+	return TRUE;
+}
+
+/** tfmcc module */
+PGM_GNUC_INTERNAL
+void
+mock_pgm_tfmcc_check (
+	pgm_sock_t*		sock,
+	const pgm_time_t	now
+	)
+{
+	g_assert (NULL != sock);
+}
+
+PGM_GNUC_INTERNAL
+int
+mock_pgm_coalesce_flush (
+	pgm_sock_t*		sock
+	)
+{
+	g_assert (NULL != sock);
+	return PGM_IO_STATUS_NORMAL;
+}
+
+PGM_GNUC_INTERNAL
+void
+mock_pgm_fec_idle_flush (
+	pgm_sock_t*		sock,
+	const pgm_time_t	now
+	)
+{
+	g_assert (NULL != sock);
+}
+
 
 /* target:
  *	bool
@@ -268,6 +338,31 @@ START_TEST (test_check_fail_001)
 }
 END_TEST
 
+/* target:
+ *	bool
+ *	pgm_timer_check_at (
+ *		pgm_sock_t*	sock,
+ *		pgm_time_t	now
+ *	)
+ */
+
+START_TEST (test_check_at_pass_001)
+{
+	pgm_sock_t* sock = generate_sock ();
+	fail_if (NULL == sock, "generate_sock failed");
+	sock->next_poll = mock_pgm_time_now + pgm_secs(1);
+	fail_unless (FALSE == pgm_timer_check_at (sock, mock_pgm_time_now), "check_at failed");
+	fail_unless (TRUE == pgm_timer_check_at (sock, mock_pgm_time_now + pgm_secs(1)), "check_at failed");
+}
+END_TEST
+
+START_TEST (test_check_at_fail_001)
+{
+	gboolean expired = pgm_timer_check_at (NULL, 0);
+	fail ("reached");
+}
+END_TEST
+
 /* target:
  *	pgm_time_t
  *	pgm_timer_expiration (
@@ -294,7 +389,8 @@ END_TEST
 /* target:
  *	void
  *	pgm_timer_dispatch (
- *		pgm_sock_t*	sock
+ *		pgm_sock_t*		sock,
+ *		struct pgm_rx_shard_t*	shard
  *	)
  */
 
@@ -302,13 +398,13 @@ START_TEST (test_dispatch_pass_001)
 {
 	pgm_sock_t* sock = generate_sock ();
 	fail_if (NULL == sock, "generate_sock failed");
-	pgm_timer_dispatch (sock);
+	pgm_timer_dispatch (sock, sock->rx_shard);
 }
 END_TEST
 
 START_TEST (test_dispatch_fail_001)
 {
-	pgm_timer_dispatch (NULL);
+	pgm_timer_dispatch (NULL, NULL);
 	fail ("reached");
 }
 END_TEST
@@ -336,6 +432,13 @@ make_test_suite (void)
 	tcase_add_test_raise_signal (tc_check, test_check_fail_001, SIGABRT);
 #endif
 
+	TCase* tc_check_at = tcase_create ("check-at");
+	suite_add_tcase (s, tc_check_at);
+	tcase_add_test (tc_check_at, test_check_at_pass_001);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_check_at, test_check_at_fail_001, SIGABRT);
+#endif
+
 	TCase* tc_expiration = tcase_create ("expiration");
 	suite_add_tcase (s, tc_expiration);
 	tcase_add_test (tc_expiration, test_expiration_pass_001);
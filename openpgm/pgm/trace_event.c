@@ -0,0 +1,275 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * Trace events of the protocol probes in Chrome trace-event JSON, buffered
+ * per thread and appended to a file for viewing as a timeline in
+ * chrome://tracing or Perfetto.
+ *
+ * Enabled with PGM_TRACE_EVENTS naming the output file, PGM_TRACE_SAMPLE
+ * keeps one in n events of each thread and PGM_TRACE_DURATION stops recording
+ * after that many seconds such that a production process can be traced
+ * briefly.
+ *
+ * Copyright (c) 2010-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#	include <unistd.h>
+#else
+#	include <process.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+
+
+//#define TRACE_EVENT_DEBUG
+
+
+/* globals */
+
+/* zero when not tracing, otherwise changes with every initialization such
+ * that buffers of a prior initialization are detached.
+ */
+uint32_t				pgm_trace_event_generation = 0;
+uint32_t				pgm_trace_event_sample = 1;
+pgm_time_t				pgm_trace_event_expiry = UINT64_MAX;
+PGM_THREAD_LOCAL pgm_trace_buffer_t*	pgm_trace_event_local = NULL;
+PGM_THREAD_LOCAL uint32_t		pgm_trace_event_local_generation = 0;
+
+/* locals */
+
+/* argument names of each probe after the first, see <impl/probe.h>, NULL
+ * arguments are not written.
+ */
+static const struct {
+	const char*	name;
+	const char*	args[3];
+} trace_event_probes[] = {
+	{ "receive",		{ "type", "length", NULL } },
+	{ "rxw_add",		{ NULL, "sqn", "status" } },
+	{ "nak_send",		{ NULL, "sqn", "count" } },
+	{ "parity_nak_send",	{ NULL, "sqn", "count" } },
+	{ "nak_receive",	{ "sqn", "count", "is_parity" } },
+	{ "ncf_send",		{ "sqn", "count", "is_parity" } },
+	{ "ncf_receive",	{ NULL, "sqn", "status" } },
+	{ "rdata_send",		{ "sqn", "length", NULL } },
+	{ "rate_stall",		{ "is_refused", "wait", NULL } },
+	{ "apdu_deliver",	{ "sqn", "length", NULL } }
+};
+
+static volatile uint32_t	trace_event_ref_count = 0;
+static uint32_t			trace_event_epoch = 0;
+static pgm_mutex_t		trace_event_mutex;
+static pgm_slist_t*		trace_event_list = NULL;	/* of pgm_trace_buffer_t */
+static FILE*			trace_event_fp = NULL;
+static unsigned			trace_event_pid = 0;
+static uint32_t			trace_event_tid = 0;
+static uint64_t			trace_event_count = 0;		/* written to the file */
+
+static void trace_event_write (pgm_trace_buffer_t*const);
+
+
+/* open the file named by PGM_TRACE_EVENTS and start recording, without the
+ * variable the probes remain a single branch.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_trace_event_init (void)
+{
+	char *path, *env;
+	size_t envlen;
+	errno_t err;
+
+	if (pgm_atomic_exchange_and_add32 (&trace_event_ref_count, 1) > 0)
+		return;
+
+	pgm_mutex_init (&trace_event_mutex);
+
+	err = pgm_dupenv_s (&path, &envlen, "PGM_TRACE_EVENTS");
+	if (0 != err || 0 == envlen)
+		return;
+	err = pgm_fopen_s (&trace_event_fp, path, "w");
+	if (0 != err) {
+		char errbuf[1024];
+		pgm_warn (_("Opening trace event file %s failed: %s"),
+			  path, pgm_strerror_s (errbuf, sizeof (errbuf), err));
+		trace_event_fp = NULL;
+		pgm_free (path);
+		return;
+	}
+
+	pgm_trace_event_sample = 1;
+	err = pgm_dupenv_s (&env, &envlen, "PGM_TRACE_SAMPLE");
+	if (0 == err && envlen > 0) {
+		const int sample = atoi (env);
+		if (sample > 1)
+			pgm_trace_event_sample = sample;
+		pgm_free (env);
+	}
+	pgm_trace_event_expiry = UINT64_MAX;
+	err = pgm_dupenv_s (&env, &envlen, "PGM_TRACE_DURATION");
+	if (0 == err && envlen > 0) {
+		const int duration = atoi (env);
+		if (duration > 0)
+			pgm_trace_event_expiry = pgm_time_update_now() + pgm_secs (duration);
+		pgm_free (env);
+	}
+
+#ifndef _WIN32
+	trace_event_pid = (unsigned)getpid();
+#else
+	trace_event_pid = (unsigned)_getpid();
+#endif
+	trace_event_count = 0;
+	fputs ("[\n", trace_event_fp);
+	if (0 == ++trace_event_epoch)
+		++trace_event_epoch;
+	pgm_trace_event_generation = trace_event_epoch;
+	pgm_minor (_("Writing trace events to %s, sampling 1 in %" PRIu32 "."),
+		   path, pgm_trace_event_sample);
+	pgm_free (path);
+}
+
+/* write the remaining events of every thread and close the file, no thread
+ * may be recording.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_trace_event_shutdown (void)
+{
+	pgm_return_if_fail (pgm_atomic_read32 (&trace_event_ref_count) > 0);
+
+	if (pgm_atomic_exchange_and_add32 (&trace_event_ref_count, (uint32_t)-1) != 1)
+		return;
+
+	pgm_trace_event_generation = 0;
+	while (trace_event_list) {
+		pgm_trace_buffer_t* buffer = trace_event_list->data;
+		trace_event_list = pgm_slist_remove_first (trace_event_list);
+		trace_event_write (buffer);
+		pgm_free (buffer);
+	}
+	if (NULL != trace_event_fp) {
+		fputs ("\n]\n", trace_event_fp);
+		fclose (trace_event_fp);
+		trace_event_fp = NULL;
+		pgm_minor (_("Wrote %" PRIu64 " trace events."), trace_event_count);
+	}
+	pgm_mutex_free (&trace_event_mutex);
+}
+
+/* allocate and register a buffer for the calling thread.
+ *
+ * returns the buffer, or NULL if not tracing.
+ */
+
+PGM_GNUC_INTERNAL
+pgm_trace_buffer_t*
+pgm_trace_event_attach (void)
+{
+	pgm_trace_buffer_t* buffer = NULL;
+
+	if (0 == pgm_atomic_read32 (&trace_event_ref_count))
+		goto detach;
+
+	pgm_mutex_lock (&trace_event_mutex);
+	if (0 != pgm_trace_event_generation) {
+		buffer = pgm_new0 (pgm_trace_buffer_t, 1);
+		buffer->tid = ++trace_event_tid;
+		buffer->countdown = 1;
+		buffer->link.data = buffer;
+		trace_event_list = pgm_slist_prepend_link (trace_event_list, &buffer->link);
+	}
+	pgm_mutex_unlock (&trace_event_mutex);
+
+detach:
+	pgm_trace_event_local = buffer;
+	pgm_trace_event_local_generation = pgm_trace_event_generation;
+	return buffer;
+}
+
+/* append a full buffer to the file from the owning thread.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_trace_event_flush (
+	pgm_trace_buffer_t*	buffer
+	)
+{
+	pgm_assert (NULL != buffer);
+
+	pgm_mutex_lock (&trace_event_mutex);
+	trace_event_write (buffer);
+	pgm_mutex_unlock (&trace_event_mutex);
+}
+
+/* write each event as an instant event on the timeline of its thread, call
+ * with the mutex held or at shutdown.
+ */
+
+static
+void
+trace_event_write (
+	pgm_trace_buffer_t* const	buffer
+	)
+{
+	if (NULL == trace_event_fp) {
+		buffer->len = 0;
+		return;
+	}
+
+	for (uint32_t i = 0; i < buffer->len; i++)
+	{
+		const pgm_trace_event_t* e = &buffer->events[ i ];
+		const char* const* args = NULL;
+		for (unsigned j = 0; j < PGM_N_ELEMENTS(trace_event_probes); j++)
+			if (0 == strcmp (e->name, trace_event_probes[ j ].name)) {
+				args = trace_event_probes[ j ].args;
+				break;
+			}
+		fprintf (trace_event_fp, "%s{\"name\":\"%s\",\"cat\":\"pgm\",\"ph\":\"i\",\"s\":\"t\","
+					 "\"ts\":%" PGM_TIME_FORMAT ",\"pid\":%u,\"tid\":%" PRIu32 ",\"args\":{",
+			 trace_event_count++ > 0 ? ",\n" : "",
+			 e->name,
+			 e->tstamp,
+			 trace_event_pid,
+			 buffer->tid);
+		bool is_first = TRUE;
+		for (unsigned j = 0; j < 3; j++) {
+			if (NULL != args && NULL == args[ j ])
+				continue;
+			if (NULL != args)
+				fprintf (trace_event_fp, "%s\"%s\":%" PRIu64, is_first ? "" : ",", args[ j ], e->arg[ j ]);
+			else
+				fprintf (trace_event_fp, "%s\"arg%u\":%" PRIu64, is_first ? "" : ",", j, e->arg[ j ]);
+			is_first = FALSE;
+		}
+		fputs ("}}", trace_event_fp);
+	}
+	buffer->len = 0;
+}
+
+/* eof */
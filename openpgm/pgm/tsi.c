@@ -86,15 +86,21 @@ pgm_tsi_hash (
 	const void*	 p
         )
 {
-	const union {
-		pgm_tsi_t	tsi;
-		uint32_t	l[2];
-	} *u = p;
+	uint64_t h;
 
 /* pre-conditions */
 	pgm_assert (NULL != p);
 
-	return u->l[0] ^ u->l[1];
+/* MurmurHash3 64-bit finaliser folded to 32 bits, a plain XOR of both halves
+ * lets the source port only reach the low 16 bits and matching GSI bytes cancel.
+ */
+	memcpy (&h, p, sizeof (h));
+	h ^= h >> 33;
+	h *= UINT64_C(0xff51afd7ed558ccd);
+	h ^= h >> 33;
+	h *= UINT64_C(0xc4ceb9fe1a85ec53);
+	h ^= h >> 33;
+	return (pgm_hash_t)(h ^ (h >> 32));
 }
 
 /* compare two transport session identifier TSI values.
@@ -0,0 +1,519 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * transmit log, packets leaving the transmit window spilled to memory-mapped
+ * segment files.
+ *
+ * The sending thread appends each packet evicted from the transmit window as
+ * a fixed length record to the newest segment, such that the log continues
+ * the window without a gap and repairs of sequences long gone from memory are
+ * served from the page cache.  Segments hold a fixed count of sequences, the
+ * oldest is unmapped and unlinked when the configured count is exceeded.
+ * Repair requests of logged sequences are queued as runs under the log mutex
+ * and read back into a private buffer one at a time by the repair path.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/txw.h>
+#include <impl/txlog.h>
+
+
+//#define TXLOG_DEBUG
+
+#ifndef TXLOG_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+#ifdef PGM_HAVE_TXLOG
+
+static
+size_t
+txlog_segment_len (
+	const pgm_txlog_t*const	log
+	)
+{
+	return PGM_TXLOG_HEADER_LEN + (size_t)log->segment_sqns * log->record_len;
+}
+
+static
+void
+txlog_segment_name (
+	const pgm_txlog_t*const	log,
+	const uint32_t		first_sqn,
+	char*			name,
+	const size_t		len
+	)
+{
+	snprintf (name, len, "%s.%08" PRIx32, log->path, first_sqn);
+}
+
+/* create, size and map the segment file of segment_sqns sequences starting at
+ * first_sqn, replacing any file of the same name.
+ *
+ * returns mapped address, or NULL on error and sets error appropriately.
+ */
+
+static
+char*
+txlog_segment_create (
+	const pgm_txlog_t* const restrict log,
+	const uint32_t			  first_sqn,
+	pgm_error_t**		restrict  error
+	)
+{
+	char name[1024], errbuf[1024];
+	const char* what;
+	const size_t len = txlog_segment_len (log);
+
+	txlog_segment_name (log, first_sqn, name, sizeof (name));
+	const int fd = open (name, O_CREAT | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (-1 == fd) {
+		what = _("Creating");
+		goto err_errno;
+	}
+	if (0 != ftruncate (fd, (off_t)len)) {
+		what = _("Sizing");
+		const int save_errno = errno;
+		close (fd);
+		unlink (name);
+		errno = save_errno;
+		goto err_errno;
+	}
+	char* addr = mmap (NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close (fd);
+	if (MAP_FAILED == addr) {
+		what = _("Mapping");
+		const int save_errno = errno;
+		unlink (name);
+		errno = save_errno;
+		goto err_errno;
+	}
+
+	struct pgm_txlog_header_t* header = (struct pgm_txlog_header_t*)addr;
+	header->version		= PGM_TXLOG_VERSION;
+	header->tsi		= *log->tsi;
+	header->first_sqn	= first_sqn;
+	header->sqns		= log->segment_sqns;
+	header->record_len	= (uint32_t)log->record_len;
+	header->magic		= PGM_TXLOG_MAGIC;
+	pgm_debug ("Created transmit log segment %s of %" PRIu32 " sequences.", name, log->segment_sqns);
+	return addr;
+
+err_errno:
+	{
+		const int save_errno = errno;
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       pgm_error_from_errno (save_errno),
+			       _("%s transmit log segment %s: %s"),
+			       what, name,
+			       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+	}
+	return NULL;
+}
+
+static
+void
+txlog_segment_destroy (
+	const pgm_txlog_t*const			log,
+	const struct pgm_txlog_segment_t*const	segment
+	)
+{
+	char name[1024];
+	munmap (segment->addr, txlog_segment_len (log));
+	txlog_segment_name (log, segment->first_sqn, name, sizeof (name));
+	unlink (name);
+}
+
+static inline
+struct pgm_txlog_segment_t*
+txlog_segment_nth (
+	pgm_txlog_t*const	log,
+	const unsigned		n		/* 0 = oldest */
+	)
+{
+	return &log->segments[ (log->segment_head + n) % log->segments_max ];
+}
+
+/* record of a logged sequence, caller holds the mutex or is the sending thread.
+ */
+
+static
+struct pgm_txlog_record_t*
+txlog_record (
+	pgm_txlog_t*const	log,
+	const uint32_t		sequence
+	)
+{
+	const struct pgm_txlog_segment_t* oldest = txlog_segment_nth (log, 0);
+	const unsigned n = (sequence - oldest->first_sqn) / log->segment_sqns;
+	pgm_assert_cmpuint (n, <, log->segment_len);
+	const struct pgm_txlog_segment_t* segment = txlog_segment_nth (log, n);
+	return (struct pgm_txlog_record_t*)(segment->addr + PGM_TXLOG_HEADER_LEN + (size_t)(sequence - segment->first_sqn) * log->record_len);
+}
+
+/* drop all segments after a failed append, the log stops such that it never
+ * presents a gap before the transmit window.
+ */
+
+static
+void
+txlog_abandon (
+	pgm_txlog_t*const	log
+	)
+{
+	pgm_mutex_lock (&log->mutex);
+	pgm_atomic_write32 (&log->trail, pgm_atomic_read32 (&log->lead) + 1);
+	while (log->segment_len > 0) {
+		txlog_segment_destroy (log, txlog_segment_nth (log, 0));
+		log->segment_head = (log->segment_head + 1) % log->segments_max;
+		log->segment_len--;
+	}
+	log->request_len = 0;
+	pgm_atomic_write32 (&log->request_pending, 0);
+	pgm_mutex_unlock (&log->mutex);
+}
+
+#endif /* PGM_HAVE_TXLOG */
+
+/* constructor for the transmit log of a transmit window, the first segment
+ * is created immediately at the initial window trail of zero.  segment files
+ * are named by the path prefix and the hexadecimal first sequence.
+ *
+ * returns pointer to log, or NULL on error and sets error appropriately.
+ */
+
+PGM_GNUC_INTERNAL
+pgm_txlog_t*
+pgm_txlog_create (
+	const pgm_tsi_t*const	tsi,
+	const char*const	path,
+	const uint16_t		max_tpdu,
+	const uint32_t		segment_sqns,	/* 0 = default */
+	const unsigned		segments,	/* 0 = default */
+	pgm_error_t**		error
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != tsi);
+	pgm_assert (NULL != path);
+	pgm_assert_cmpuint (max_tpdu, >, 0);
+
+#ifdef PGM_HAVE_TXLOG
+	pgm_txlog_t* log = pgm_new0 (pgm_txlog_t, 1);
+	log->tsi		= tsi;
+	log->path		= pgm_strdup (path);
+	log->max_tpdu		= max_tpdu;
+	log->record_len		= (sizeof (struct pgm_txlog_record_t) + max_tpdu + 63) & ~(size_t)63;	/* cache line */
+	log->segment_sqns	= segment_sqns ? segment_sqns : PGM_TXLOG_SEGMENT_SQNS_DEFAULT;
+	log->segments_max	= segments ? segments : PGM_TXLOG_SEGMENTS_DEFAULT;
+	log->segments		= pgm_new0 (struct pgm_txlog_segment_t, log->segments_max);
+	pgm_mutex_init (&log->mutex);
+
+/* continues the empty transmit window, trail = 0, lead = -1 */
+	log->lead		= -1;
+	log->trail		= log->lead + 1;
+
+	char* addr = txlog_segment_create (log, log->trail, error);
+	if (NULL == addr) {
+		pgm_txlog_destroy (log);
+		return NULL;
+	}
+	log->segments[0].first_sqn = log->trail;
+	log->segments[0].addr = addr;
+	log->segment_len = 1;
+
+	pgm_minor (_("Transmit log %s of %u segments of %" PRIu32 " sequences."),
+		   log->path, log->segments_max, log->segment_sqns);
+	return log;
+#else
+	(void)tsi; (void)path; (void)max_tpdu; (void)segment_sqns; (void)segments;
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       PGM_ERROR_NOSYS,
+		       _("Transmit log unavailable on this platform."));
+	return NULL;
+#endif /* PGM_HAVE_TXLOG */
+}
+
+/* destructor, unmaps and unlinks all segments.  the transmit window must no
+ * longer reference the log.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_txlog_destroy (
+	pgm_txlog_t*const	log
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != log);
+
+#ifdef PGM_HAVE_TXLOG
+	pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Transmit log %s appended %" PRIu64 " packets, %" PRIu64 " retransmitted."),
+		   log->path, log->packets, log->retransmits);
+	if (NULL != log->retransmit_skb)
+		pgm_free_skb (log->retransmit_skb);
+	while (log->segment_len > 0) {
+		txlog_segment_destroy (log, txlog_segment_nth (log, 0));
+		log->segment_head = (log->segment_head + 1) % log->segments_max;
+		log->segment_len--;
+	}
+	pgm_mutex_free (&log->mutex);
+	pgm_free (log->segments);
+	pgm_free (log->path);
+	pgm_free (log);
+#else
+	(void)log;
+#endif
+}
+
+/* append a packet leaving the trailing edge of the transmit window, the
+ * sequence must follow the log lead.  a new segment is started when the
+ * newest is full, retiring the oldest beyond the segment count.  sending
+ * thread only.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_txlog_append (
+	pgm_txlog_t*	      const restrict log,
+	const struct pgm_sk_buff_t* const restrict skb,
+	const uint32_t			     unfolded_checksum
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != log);
+	pgm_assert (NULL != skb);
+
+#ifdef PGM_HAVE_TXLOG
+	const uint32_t sequence = skb->sequence;
+
+/* abandoned */
+	if (0 == log->segment_len)
+		return;
+	pgm_assert_cmpuint (sequence, ==, log->lead + 1);
+
+	struct pgm_txlog_segment_t* newest = txlog_segment_nth (log, log->segment_len - 1);
+	if (sequence - newest->first_sqn >= log->segment_sqns)
+	{
+		pgm_error_t* error = NULL;
+/* write back the completed segment without waiting */
+		msync (newest->addr, txlog_segment_len (log), MS_ASYNC);
+		char* addr = txlog_segment_create (log, sequence, &error);
+		if (PGM_UNLIKELY(NULL == addr)) {
+			pgm_warn (_("%s, transmit log abandoned."), error->message);
+			pgm_error_free (error);
+			txlog_abandon (log);
+			return;
+		}
+		pgm_mutex_lock (&log->mutex);
+		if (log->segment_len == log->segments_max) {
+			struct pgm_txlog_segment_t* oldest = txlog_segment_nth (log, 0);
+			txlog_segment_destroy (log, oldest);
+			log->segment_head = (log->segment_head + 1) % log->segments_max;
+			log->segment_len--;
+			pgm_atomic_write32 (&log->trail, txlog_segment_nth (log, 0)->first_sqn);
+		}
+		newest = txlog_segment_nth (log, log->segment_len++);
+		newest->first_sqn = sequence;
+		newest->addr = addr;
+		pgm_mutex_unlock (&log->mutex);
+	}
+
+	const size_t tpdu_length = (char*)skb->tail - (char*)skb->pgm_header;
+	pgm_assert_cmpuint (tpdu_length, <=, log->max_tpdu);
+	struct pgm_txlog_record_t* record = (struct pgm_txlog_record_t*)(newest->addr + PGM_TXLOG_HEADER_LEN + (size_t)(sequence - newest->first_sqn) * log->record_len);
+	record->sequence		= sequence;
+	record->unfolded_checksum	= unfolded_checksum;
+	record->tpdu_length		= (uint16_t)tpdu_length;
+	record->header_length		= (uint16_t)((char*)skb->data - (char*)skb->pgm_header);
+	record->reserved		= 0;
+	memcpy (record->tpdu, skb->pgm_header, tpdu_length);
+	log->packets++;
+
+/* publish record to lockless readers */
+	pgm_atomic_inc32 (&log->lead);
+#else
+	(void)skb; (void)unfolded_checksum;
+#endif
+}
+
+/* queue a repair request of a logged sequence, merged into the runs of
+ * outstanding requests.  safe from any thread.
+ *
+ * returns FALSE if request was eliminated, returns TRUE if request was
+ * added to queue.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_txlog_retransmit_push (
+	pgm_txlog_t* const	log,
+	const uint32_t		sequence
+	)
+{
+	bool is_queued = FALSE;
+
+/* pre-conditions */
+	pgm_assert (NULL != log);
+
+	pgm_debug ("retransmit_push (log:%p sequence:%" PRIu32 ")", (const void*)log, sequence);
+
+	pgm_mutex_lock (&log->mutex);
+	if (!pgm_uint32_gte (sequence, pgm_atomic_read32 (&log->trail)) ||
+	    !pgm_uint32_lte (sequence, pgm_atomic_read32 (&log->lead)))
+	{
+		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Requested packet #%" PRIu32 " not in transmit log."), sequence);
+		goto out;
+	}
+	if (NULL != log->retransmit_skb && sequence == log->retransmit_skb->sequence)
+		goto out;
+	for (unsigned i = 0; i < log->request_len; i++) {
+		const struct pgm_txlog_request_t* run = &log->requests[ (log->request_head + i) % PGM_TXLOG_REQUESTS_MAX ];
+		if (sequence - run->sequence < run->count)
+			goto out;
+	}
+	if (log->request_len > 0) {
+		struct pgm_txlog_request_t* last = &log->requests[ (log->request_head + log->request_len - 1) % PGM_TXLOG_REQUESTS_MAX ];
+		if (last->sequence + last->count == sequence) {
+			last->count++;
+			is_queued = TRUE;
+		}
+	}
+	if (!is_queued) {
+		if (PGM_UNLIKELY(PGM_TXLOG_REQUESTS_MAX == log->request_len)) {
+			pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Transmit log request queue full, dropping #%" PRIu32 "."), sequence);
+			goto out;
+		}
+		struct pgm_txlog_request_t* run = &log->requests[ (log->request_head + log->request_len++) % PGM_TXLOG_REQUESTS_MAX ];
+		run->sequence = sequence;
+		run->count    = 1;
+		is_queued = TRUE;
+	}
+	pgm_atomic_inc32 (&log->request_pending);
+out:
+	pgm_mutex_unlock (&log->mutex);
+	return is_queued;
+}
+
+/* try to peek the oldest queued request, read from its segment into a
+ * private buffer which remains in service until removed.  repair path only.
+ *
+ * returns skb of the repair data, or NULL if no request is outstanding.
+ */
+
+PGM_GNUC_INTERNAL
+struct pgm_sk_buff_t*
+pgm_txlog_retransmit_try_peek (
+	pgm_txlog_t* const	log
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != log);
+
+	if (NULL != log->retransmit_skb)
+		return log->retransmit_skb;
+	if (0 == pgm_atomic_read32 (&log->request_pending))
+		return NULL;
+
+#ifdef PGM_HAVE_TXLOG
+	struct pgm_sk_buff_t* skb = NULL;
+	pgm_mutex_lock (&log->mutex);
+	while (NULL == skb && log->request_len > 0)
+	{
+		struct pgm_txlog_request_t* run = &log->requests[ log->request_head ];
+		const uint32_t sequence = run->sequence;
+		run->sequence++;
+		pgm_atomic_dec32 (&log->request_pending);
+		if (0 == --run->count) {
+			log->request_head = (log->request_head + 1) % PGM_TXLOG_REQUESTS_MAX;
+			log->request_len--;
+		}
+/* retired with its segment since requested */
+		if (!pgm_uint32_gte (sequence, pgm_atomic_read32 (&log->trail))) {
+			pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Retransmit sqn #%" PRIu32 " left transmit log."), sequence);
+			continue;
+		}
+		const struct pgm_txlog_record_t* record = txlog_record (log, sequence);
+		if (PGM_UNLIKELY(record->sequence != sequence ||
+				 record->tpdu_length > log->max_tpdu ||
+				 record->header_length > record->tpdu_length))
+		{
+			pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Invalid transmit log record of #%" PRIu32 "."), sequence);
+			continue;
+		}
+/* header alone of an unreliable packet */
+		if (record->tpdu_length - record->header_length != pgm_ntohs (((const struct pgm_header*)record->tpdu)->pgm_tsdu_length)) {
+			pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Retransmit sqn #%" PRIu32 " sent unreliable."), sequence);
+			continue;
+		}
+		skb = pgm_alloc_skb (log->max_tpdu);
+		memcpy (skb->head, record->tpdu, record->tpdu_length);
+		skb->sequence	= sequence;
+		skb->pgm_header	= skb->head;
+		skb->pgm_data	= (struct pgm_data*)(skb->pgm_header + 1);
+		skb->data	= (char*)skb->head + record->header_length;
+		skb->tail	= (char*)skb->head + record->tpdu_length;
+		skb->len	= (uint16_t)(record->tpdu_length - record->header_length);
+		pgm_txw_set_unfolded_checksum (skb, record->unfolded_checksum);
+		log->retransmit_skb = skb;
+	}
+	pgm_mutex_unlock (&log->mutex);
+	return skb;
+#else
+	return NULL;
+#endif
+}
+
+/* release the request in service after transmission.  repair path only.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_txlog_retransmit_remove_head (
+	pgm_txlog_t* const	log
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != log);
+	pgm_assert (NULL != log->retransmit_skb);
+
+	pgm_mutex_lock (&log->mutex);
+	struct pgm_sk_buff_t* skb = log->retransmit_skb;
+	log->retransmit_skb = NULL;
+	log->retransmits++;
+	pgm_mutex_unlock (&log->mutex);
+	pgm_free_skb (skb);
+}
+
+/* eof */
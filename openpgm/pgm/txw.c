@@ -2,6 +2,12 @@
  *
  * A basic transmit window: pointer array implementation.
  *
+ * The sending thread alone appends entries and advances the trail, without
+ * locking.  NAK processing marks retransmit requests in window wide bitmaps
+ * with word-wide atomics, the repair path scans them oldest first and resolves
+ * them against the window holding its own references such that neither side
+ * waits on the other.
+ *
  * Copyright (c) 2006-2011 Miru Limited.
  *
  * This library is free software; you can redistribute it and/or
@@ -25,6 +31,8 @@
 #include <impl/i18n.h>
 #include <impl/framework.h>
 #include <impl/txw.h>
+#include <impl/txlog.h>
+#include <impl/standby.h>
 
 
 //#define TXW_DEBUG
@@ -77,7 +85,7 @@ _pgm_txw_peek (
 
 	if (pgm_uint32_gte (sequence, window->trail) && pgm_uint32_lte (sequence, window->lead))
 	{
-		const uint_fast32_t index_ = sequence % pgm_txw_max_length (window);
+		const uint_fast32_t index_ = sequence & window->mask;
 		skb = window->pdata[index_];
 		pgm_assert (NULL != skb);
 		pgm_assert (pgm_skb_is_valid (skb));
@@ -89,6 +97,19 @@ _pgm_txw_peek (
 	return skb;
 }
 
+/* transmission group slot of the parity request state.
+ */
+
+static inline
+unsigned
+pgm_txw_tg_index (
+	const pgm_txw_t*const	window,
+	const uint32_t		tg_sqn
+	)
+{
+	return (tg_sqn >> window->tg_sqn_shift) % window->tg_alloc;
+}
+
 /* testing function: can a request be peeked from the retransmit queue.
  *
  * returns TRUE if request is available, returns FALSE if not available.
@@ -145,15 +166,22 @@ pgm_txw_retransmit_is_empty (
 	)
 {
 	pgm_assert (NULL != window);
-	return pgm_queue_is_empty (&window->retransmit_queue);
+	return pgm_queue_is_empty (&window->retransmit_queue) &&
+	       0 == pgm_atomic_read32 (&window->retransmit_pending) &&
+	       (NULL == window->log || pgm_txlog_retransmit_is_empty (window->log));
 }
 
 
 /* globals */
 
-static void pgm_txw_remove_tail (pgm_txw_t*const);
-static bool pgm_txw_retransmit_push_parity (pgm_txw_t*const, const uint32_t, const uint8_t);
-static bool pgm_txw_retransmit_push_selective (pgm_txw_t*const, const uint32_t);
+static void pgm_txw_remove_tail (pgm_txw_t*const, const pgm_time_t);
+static inline bool pgm_txw_bitmap_set (pgm_txw_t*const, volatile uint32_t*const, const unsigned);
+static inline void pgm_txw_bitmap_clear (pgm_txw_t*const, volatile uint32_t*const, const unsigned);
+static inline uint32_t pgm_txw_parity_take (pgm_txw_t*const, const unsigned);
+static void pgm_txw_retransmit_cancel (pgm_txw_t*const, const uint32_t);
+static struct pgm_sk_buff_t* pgm_txw_retransmit_select (pgm_txw_t*const, uint32_t);
+static void pgm_txw_retransmit_pop_tail (pgm_txw_t*const);
+static void pgm_txw_parity_cache_evict (pgm_txw_t*const, const uint32_t);
 
 
 /* constructor for transmit window.  zero-length windows are not permitted.
@@ -171,7 +199,8 @@ pgm_txw_create (
 	const ssize_t		max_rte,	/* max bandwidth */
 	const bool		use_fec,
 	const uint8_t		rs_n,
-	const uint8_t		rs_k
+	const uint8_t		rs_k,
+	const size_t		parity_cache	/* bytes, 0 = disabled */
 	)
 {
 	pgm_txw_t* window;
@@ -179,7 +208,6 @@ pgm_txw_create (
 /* pre-conditions */
 	pgm_assert (NULL != tsi);
 	if (sqns) {
-		pgm_assert_cmpuint (tpdu_size, ==, 0);
 		pgm_assert_cmpuint (sqns, >, 0);
 		pgm_assert_cmpuint (sqns & PGM_UINT32_SIGN_BIT, ==, 0);
 		pgm_assert_cmpuint (secs, ==, 0);
@@ -190,19 +218,22 @@ pgm_txw_create (
 		pgm_assert_cmpuint (max_rte, >, 0);
 	}
 	if (use_fec) {
+		pgm_assert_cmpuint (tpdu_size, >, 0);		/* sizes parity buffers */
 		pgm_assert_cmpuint (rs_n, >, 0);
 		pgm_assert_cmpuint (rs_k, >, 0);
 	}
 
-	pgm_debug ("create (tsi:%s max-tpdu:%" PRIu16 " sqns:%" PRIu32  " secs %u max-rte %" PRIzd " use-fec:%s rs(n):%u rs(k):%u)",
+	pgm_debug ("create (tsi:%s max-tpdu:%" PRIu16 " sqns:%" PRIu32  " secs %u max-rte %" PRIzd " use-fec:%s rs(n):%u rs(k):%u parity-cache:%" PRIzu ")",
 		pgm_tsi_print (tsi),
 		tpdu_size, sqns, secs, max_rte,
 		use_fec ? "YES" : "NO",
-		rs_n, rs_k);
+		rs_n, rs_k, parity_cache);
 
 /* calculate transmit window parameters */
 	pgm_assert (sqns || (tpdu_size && secs && max_rte));
-	const unsigned alloc_sqns = sqns ? sqns : (unsigned)( (secs * max_rte) / tpdu_size );
+	const unsigned max_sqns = sqns ? sqns : (unsigned)( (secs * max_rte) / tpdu_size );
+/* pointer array rounded up to a power of two to index by mask */
+	const unsigned alloc_sqns = (unsigned)pgm_nearest_power (1, max_sqns);
 	window = pgm_malloc0 (sizeof(pgm_txw_t) + ( alloc_sqns * sizeof(struct pgm_sk_buff_t*) ));
 	window->tsi = tsi;
 
@@ -213,19 +244,34 @@ pgm_txw_create (
 	window->lead = -1;
 	window->trail = window->lead + 1;
 
+/* one request bit per slot */
+	window->retransmit_bitmap = pgm_new0 (uint32_t, (alloc_sqns + 31) / 32);
+	window->unreliable_bitmap = pgm_new0 (uint32_t, (alloc_sqns + 31) / 32);
+
 /* reed-solomon forward error correction */
 	if (use_fec) {
-		window->parity_buffer = pgm_alloc_skb (tpdu_size);
+		window->parity_buffer_len = MIN(rs_n - rs_k, PGM_TXW_PARITY_BATCH_MAX);
+		window->parity_buffer = pgm_new (struct pgm_sk_buff_t*, window->parity_buffer_len);
+		for (unsigned i = 0; i < window->parity_buffer_len; i++)
+			window->parity_buffer[i] = pgm_alloc_skb (tpdu_size);
+		window->parity_tpdu = tpdu_size;
+		window->parity_cache_max = parity_cache;
 		window->tg_sqn_shift = pgm_power2_log2 (rs_k);
+/* every transmission group partially covered by the window */
+		window->tg_alloc = (alloc_sqns >> window->tg_sqn_shift) + 2;
+		window->parity_bitmap = pgm_new0 (uint32_t, (window->tg_alloc + 31) / 32);
+		window->parity_requested = pgm_new0 (uint32_t, window->tg_alloc);
 		pgm_rs_create (&window->rs, rs_n, rs_k);
 		window->is_fec_enabled = 1;
 	}
 
 /* pointer array */
 	window->alloc = alloc_sqns;
+	window->mask = alloc_sqns - 1;
+	window->max_length = max_sqns;
 
 /* post-conditions */
-	pgm_assert_cmpuint (pgm_txw_max_length (window), ==, alloc_sqns);
+	pgm_assert_cmpuint (pgm_txw_max_length (window), ==, max_sqns);
 	pgm_assert_cmpuint (pgm_txw_length (window), ==, 0);
 	pgm_assert_cmpuint (pgm_txw_size (window), ==, 0);
 	pgm_assert (pgm_txw_is_empty (window));
@@ -250,9 +296,16 @@ pgm_txw_shutdown (
 
 	pgm_debug ("shutdown (window:%p)", (const void*)window);
 
+/* contents are not spilled on shutdown */
+	window->log = NULL;
+
+/* discard the references of queued entries */
+	while (!pgm_queue_is_empty (&window->retransmit_queue))
+		pgm_txw_retransmit_pop_tail (window);
+
 /* contents of window */
 	while (!pgm_txw_is_empty (window)) {
-		pgm_txw_remove_tail (window);
+		pgm_txw_remove_tail (window, 0);
 	}
 
 /* window must now be empty */
@@ -266,14 +319,277 @@ pgm_txw_shutdown (
 
 /* free reed-solomon state */
 	if (window->is_fec_enabled) {
-		pgm_free_skb (window->parity_buffer);
+		while (!pgm_queue_is_empty (&window->parity_cache))
+			pgm_free_skb ((struct pgm_sk_buff_t*)pgm_queue_pop_tail_link (&window->parity_cache));
+		for (unsigned i = 0; i < window->parity_buffer_len; i++)
+			pgm_free_skb (window->parity_buffer[i]);
+		pgm_free (window->parity_buffer);
+		pgm_free ((void*)window->parity_requested);
+		pgm_free ((void*)window->parity_bitmap);
 		pgm_rs_destroy (&window->rs);
 	}
+	pgm_free ((void*)window->retransmit_bitmap);
+	pgm_free ((void*)window->unreliable_bitmap);
+
+/* packet slots are released as outstanding references drop */
+	if (window->slots)
+		pgm_skb_pool_destroy (window->slots);
 
 /* window */
 	pgm_free (window);
 }
 
+/* back the window with one contiguous ring of tpdu_size packet slots, one
+ * more than the window length such that the slot of the next sequence is not
+ * held by the window itself.  a window grown later allocates from the pool
+ * once its slot is held.  the ring is mapped on huge pages of page_size
+ * bytes when non-zero, and prefaulted and locked with use_mlock.  must be
+ * called before any add.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_txw_set_slots (
+	pgm_txw_t*const		window,
+	const uint16_t		tpdu_size,
+	const size_t		page_size,	/* 0 = regular pages */
+	const bool		use_mlock,
+	const int		numa_node	/* -1 = first touch */
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert_cmpuint (tpdu_size, >, 0);
+	pgm_assert (pgm_txw_is_empty (window));
+	pgm_assert (NULL == window->slots);
+
+	pgm_debug ("set_slots (window:%p tpdu-size:%" PRIu16 " page-size:%" PRIzu " use-mlock:%s numa-node:%d)",
+		(const void*)window, tpdu_size, page_size, use_mlock ? "YES" : "NO", numa_node);
+
+	window->slots = pgm_skb_ring_create (tpdu_size, window->max_length + 1, page_size, use_mlock, numa_node);
+}
+
+/* fault in the slot array, request bitmaps and packet slot ring ahead of
+ * the first sends, before any NAK can be processed.
+ *
+ * returns bytes touched.
+ */
+
+PGM_GNUC_INTERNAL
+size_t
+pgm_txw_prewarm (
+	pgm_txw_t*const		window
+	)
+{
+	size_t touched;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (pgm_txw_is_empty (window));
+
+	touched  = pgm_mem_prefault (window->pdata, window->alloc * sizeof(struct pgm_sk_buff_t*));
+	touched += pgm_mem_prefault ((void*)window->retransmit_bitmap, ((window->alloc + 31) / 32) * sizeof(uint32_t));
+	touched += pgm_mem_prefault ((void*)window->unreliable_bitmap, ((window->alloc + 31) / 32) * sizeof(uint32_t));
+	if (NULL != window->slots)
+		touched += pgm_skb_pool_prewarm (window->slots, 0);
+	return touched;
+}
+
+/* continue the trailing edge of the window with a transmit log, packets
+ * leaving the window are appended to the log and selective requests of
+ * sequences preceding the window are served from it.  must be called before
+ * any add, the log outlives the window.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_txw_set_log (
+	pgm_txw_t*	    const restrict window,
+	struct pgm_txlog_t* const restrict log
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != log);
+	pgm_assert (pgm_txw_is_empty (window));
+	pgm_assert (NULL == window->log);
+
+	pgm_debug ("set_log (window:%p log:%p)", (const void*)window, (const void*)log);
+
+	window->log = log;
+}
+
+/* copy every packet added to the window to a hot standby.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_txw_set_mirror (
+	pgm_txw_t*	      const restrict window,
+	struct pgm_standby_t* const restrict mirror
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != mirror);
+
+	pgm_debug ("set_mirror (window:%p mirror:%p)", (const void*)window, (const void*)mirror);
+
+	window->mirror = mirror;
+}
+
+/* empty the window and continue from sequence next_lead, for a standby that
+ * lost packets of its primary.  only the sending thread may reset.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_txw_reset (
+	pgm_txw_t* const	window,
+	const uint32_t		next_lead
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+
+	pgm_debug ("reset (window:%p next-lead:%" PRIu32 ")", (const void*)window, next_lead);
+
+	while (!pgm_queue_is_empty (&window->retransmit_queue))
+		pgm_txw_retransmit_pop_tail (window);
+	while (!pgm_txw_is_empty (window))
+		pgm_txw_remove_tail (window, 0);
+	pgm_atomic_write32 (&window->trail, next_lead);
+	pgm_atomic_write32 (&window->lead, next_lead - 1);
+	window->unreliable_recent = 0;
+
+/* post-conditions */
+	pgm_assert (pgm_txw_is_empty (window));
+	pgm_assert_cmpuint (pgm_txw_next_lead (window), ==, next_lead);
+}
+
+/* release the trailing edge once acknowledged by receivers and held for at
+ * least hold, instead of only when the window is full.  must be called
+ * before any add.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_txw_set_ack_release (
+	pgm_txw_t* const	window,
+	const pgm_time_t	hold
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (pgm_txw_is_empty (window));
+
+	pgm_debug ("set_ack_release (window:%p hold:%" PGM_TIME_FORMAT ")", (const void*)window, hold);
+
+	window->ack_hold = hold;
+	window->ack_sqn = pgm_txw_lead (window);
+}
+
+/* publish the sequence acknowledged by the receiver quorum, the sending
+ * thread releases up to it on the next add.  callable from any thread.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_txw_ack (
+	pgm_txw_t* const	window,
+	const uint32_t		sequence
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+
+	pgm_atomic_write32 (&window->ack_sqn, sequence);
+}
+
+/* remove acknowledged entries held beyond the minimum from the trail.  with
+ * FEC only whole transmission groups are released such that parity remains
+ * encodable.
+ */
+
+static
+void
+pgm_txw_release_acked (
+	pgm_txw_t* const	window,
+	const pgm_time_t	now
+	)
+{
+	uint32_t ack_sqn = pgm_atomic_read32 (&window->ack_sqn);
+
+	if (window->is_fec_enabled) {
+		const uint32_t tg_sqn_mask = 0xffffffff << window->tg_sqn_shift;
+		ack_sqn = ((ack_sqn + 1) & tg_sqn_mask) - 1;
+	}
+
+	while (!pgm_txw_is_empty (window) &&
+	       pgm_uint32_lte (pgm_txw_trail (window), ack_sqn))
+	{
+		const struct pgm_sk_buff_t* skb = _pgm_txw_peek (window, pgm_txw_trail (window));
+		if (pgm_time_after (skb->tstamp + window->ack_hold, now))
+			break;
+		pgm_txw_remove_tail (window, now);
+	}
+}
+
+/* resize the window in use up to the pointer array allocated on create.  a
+ * window shrunk below its length drains from the trail as data is added,
+ * growing takes effect immediately.  only the sending thread may resize.
+ *
+ * returns TRUE on success, returns FALSE if sqns exceeds the allocation.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_txw_set_max_length (
+	pgm_txw_t* const	window,
+	const uint32_t		sqns
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert_cmpuint (sqns, >, 0);
+
+	pgm_debug ("set_max_length (window:%p sqns:%" PRIu32 ")", (const void*)window, sqns);
+
+	if (PGM_UNLIKELY(sqns > window->alloc))
+		return FALSE;
+	window->max_length = sqns;
+	return TRUE;
+}
+
+/* allocate a buffer for the next sequence of the window, from its slot when
+ * the window has packet slots and the slot is no longer referenced by a
+ * retransmit request, pending send or encoder, otherwise from pool.  only the
+ * sending thread may allocate.
+ *
+ * returns pointer to skb.
+ */
+
+PGM_GNUC_INTERNAL
+struct pgm_sk_buff_t*
+pgm_txw_alloc_skb (
+	pgm_txw_t*	      const restrict window,
+	pgm_skb_pool_t*	      const restrict pool,
+	const uint16_t			     size
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != window);
+
+	if (NULL != window->slots &&
+	    size <= window->slots->size)
+	{
+		struct pgm_sk_buff_t* skb = pgm_skb_ring_alloc (window->slots, pgm_txw_next_lead (window));
+		if (PGM_LIKELY(NULL != skb))
+			return skb;
+	}
+	return pgm_skb_pool_alloc (pool, size);
+}
+
 /* add skb to transmit window, taking ownership.  window does not grow.
  * PGM skbuff data/tail pointers must point to the PGM payload, and hence skb->len
  * is allowed to be zero.
@@ -286,14 +602,17 @@ pgm_txw_shutdown (
  * no return value.  fatal error raised on invalid parameters.  if window is full then
  * an entry is dropped to fulfil the request.
  *
- * it is an error to try to free the skb after adding to the window.
+ * it is an error to try to free the skb after adding to the window.  only the
+ * sending thread may add, no lock is required.
  */
 
-PGM_GNUC_INTERNAL
+static
 void
-pgm_txw_add (
-	pgm_txw_t*	      const restrict window,
-	struct pgm_sk_buff_t* const restrict skb		/* cannot be NULL */
+_pgm_txw_add (
+	pgm_txw_t*		    const restrict window,
+	struct pgm_sk_buff_t*	    const restrict skb,		/* cannot be NULL */
+	const struct pgm_sk_buff_t* const restrict tpdu,	/* mirrored */
+	const bool				   is_unreliable
 	)
 {
 /* pre-conditions */
@@ -309,26 +628,100 @@ pgm_txw_add (
 
 	pgm_debug ("add (window:%p skb:%p)", (const char*)window, (const char*)skb);
 
+	if (window->ack_hold)
+		pgm_txw_release_acked (window, skb->tstamp);
+
 	if (pgm_txw_is_full (window))
 	{
 /* transmit window advancement scheme dependent action here */
-		pgm_txw_remove_tail (window);
+		pgm_txw_remove_tail (window, skb->tstamp);
+/* drain a window shrunk below its length one extra entry per add */
+		if (pgm_txw_is_full (window))
+			pgm_txw_remove_tail (window, skb->tstamp);
+	}
+/* likewise drain the trail while over the memory budget */
+	else if (PGM_UNLIKELY(!pgm_txw_is_empty (window) &&
+			      pgm_mem_budget_is_exceeded (window->budget)))
+	{
+		pgm_txw_remove_tail (window, skb->tstamp);
 	}
 
 /* generate new sequence number */
-	pgm_atomic_inc32 (&window->lead);
-	skb->sequence = window->lead;
+	skb->sequence = pgm_txw_next_lead (window);
 
 /* add skb to window */
-	const uint_fast32_t index_ = skb->sequence % pgm_txw_max_length (window);
+	const uint_fast32_t index_ = skb->sequence & window->mask;
 	window->pdata[index_] = skb;
 
+/* sole writer of the unreliable marks, published with the lead */
+	const uint32_t bit = 1U << (index_ & 31);
+	const uint32_t word = pgm_atomic_read32 (&window->unreliable_bitmap[ index_ >> 5 ]);
+	if (is_unreliable != !!(word & bit))
+		pgm_atomic_write32 (&window->unreliable_bitmap[ index_ >> 5 ], word ^ bit);
+	window->unreliable_recent = (window->unreliable_recent << 1) | (is_unreliable ? 1 : 0);
+
 /* statistics */
 	window->size += skb->len;
+	pgm_mem_budget_charge (window->budget, skb->truesize);
+	if (window->size > window->peak_size)
+		window->peak_size = window->size;
+
+/* publish entry to lockless readers */
+	pgm_atomic_inc32 (&window->lead);
+	if (pgm_txw_length (window) > window->peak_length)
+		window->peak_length = pgm_txw_length (window);
+
+/* complete TPDU from the PGM header */
+	if (NULL != window->mirror)
+		pgm_standby_mirror (window->mirror, tpdu->head, (char*)tpdu->tail - (char*)tpdu->head);
 
 /* post-conditions */
 	pgm_assert_cmpuint (pgm_txw_length (window), >, 0);
-	pgm_assert_cmpuint (pgm_txw_length (window), <=, pgm_txw_max_length (window));
+	pgm_assert_cmpuint (pgm_txw_length (window), <=, window->alloc);
+}
+
+PGM_GNUC_INTERNAL
+void
+pgm_txw_add (
+	pgm_txw_t*	      const restrict window,
+	struct pgm_sk_buff_t* const restrict skb		/* cannot be NULL */
+	)
+{
+	_pgm_txw_add (window, skb, skb, FALSE);
+}
+
+/* add the sequence of an unreliable packet to the window without its payload,
+ * the window holds a copy of the PGM header alone and requests for the
+ * sequence are refused.  skb remains owned by the caller, the sequence number
+ * is set as with pgm_txw_add(), and a standby mirror receives the complete
+ * TPDU.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_txw_add_unreliable (
+	pgm_txw_t*	      const restrict window,
+	struct pgm_sk_buff_t* const restrict skb		/* cannot be NULL */
+	)
+{
+	struct pgm_sk_buff_t* header_skb;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != skb);
+	pgm_assert ((char*)skb->data > (char*)skb->head);
+
+	const uint16_t header_length = (uint16_t)((char*)skb->data - (char*)skb->head);
+	header_skb = pgm_alloc_skb (header_length);
+	header_skb->sock   = skb->sock;
+	header_skb->tstamp = skb->tstamp;
+	pgm_skb_reserve (header_skb, header_length);
+	memcpy (header_skb->head, skb->head, header_length);
+	header_skb->pgm_header = (struct pgm_header*)header_skb->head;
+	header_skb->pgm_data   = (struct pgm_data*)(header_skb->pgm_header + 1);
+
+	_pgm_txw_add (window, header_skb, skb, TRUE);
+	skb->sequence = header_skb->sequence;
 }
 
 /* peek an entry from the window for retransmission.
@@ -348,13 +741,47 @@ pgm_txw_peek (
 	return _pgm_txw_peek (window, sequence);
 }
 
-/* remove an entry from the trailing edge of the transmit window.
+/* peek an entry from the window and take a reference, safe against concurrent
+ * advancement of the trail by the sending thread.  callers other than the
+ * sending thread are serialised by pgm_sock_t::txw_spinlock.
+ *
+ * returns pointer to referenced skbuff, returns NULL if not in window.
+ */
+
+PGM_GNUC_INTERNAL
+struct pgm_sk_buff_t*
+pgm_txw_peek_get (
+	pgm_txw_t*const		window,
+	const uint32_t		sequence
+	)
+{
+	struct pgm_sk_buff_t* skb;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+
+	pgm_debug ("peek_get (window:%p sequence:%" PRIu32 ")",
+		(const void*)window, sequence);
+
+/* pin before testing the trail, pairs with pgm_txw_remove_tail() */
+	window->pinned_sqn = sequence;
+	pgm_atomic_inc32 (&window->pinned);
+	skb = _pgm_txw_peek (window, sequence);
+	if (NULL != skb)
+		pgm_skb_get (skb);
+	pgm_atomic_dec32 (&window->pinned);
+	return skb;
+}
+
+/* remove an entry from the trailing edge of the transmit window, recording
+ * its residency against now unless zero.
  */
 
 static
 void
 pgm_txw_remove_tail (
-	pgm_txw_t* const	window
+	pgm_txw_t* const	window,
+	const pgm_time_t	now
 	)
 {
 	struct pgm_sk_buff_t	*skb;
@@ -372,173 +799,547 @@ pgm_txw_remove_tail (
 	pgm_assert (pgm_tsi_is_null (&skb->tsi));
 
 	state = (pgm_txw_state_t*)&skb->cb;
-	if (state->waiting_retransmit) {
-		pgm_queue_unlink (&window->retransmit_queue, (pgm_list_t*)skb);
-		state->waiting_retransmit = 0;
-	}
 
 /* statistics */
 	window->size -= skb->len;
+	pgm_mem_budget_charge (window->budget, -(int64_t)skb->truesize);
 	if (state->retransmit_count > 0) {
 		PGM_HISTOGRAM_COUNTS("Tx.RetransmitCount", state->retransmit_count);
 	}
-	if (state->nak_elimination_count > 0) {
-		PGM_HISTOGRAM_COUNTS("Tx.NakEliminationCount", state->nak_elimination_count);
+	if (now && skb->tstamp && !pgm_time_after (skb->tstamp, now)) {
+		const uint32_t residency = (uint32_t)MIN(now - skb->tstamp, UINT32_MAX);
+		unsigned bucket = 0;
+		for (uint32_t t = residency; t && bucket < PGM_TXW_RESIDENCY_BUCKETS - 1; t >>= 1)
+			bucket++;
+		window->residency_hist[ bucket ]++;
+		if (residency > window->max_residency)
+			window->max_residency = residency;
 	}
 
+/* spill to the log ahead of the trail such that no sequence is unavailable */
+	if (NULL != window->log)
+		pgm_txlog_append (window->log, skb, state->unfolded_checksum);
+
+/* advance trailing pointer, then let a repair path reference complete.  a
+ * queued retransmit request holds its own reference beyond this point.
+ */
+	pgm_atomic_inc32 (&window->trail);
+	pgm_txw_retransmit_cancel (window, skb->sequence);
+	while (pgm_atomic_read32 (&window->pinned) &&
+	       skb->sequence == window->pinned_sqn)
+		pgm_thread_yield ();
+
 /* remove reference to skb */
 	if (PGM_UNLIKELY(pgm_mem_gc_friendly)) {
-		const uint_fast32_t index_ = skb->sequence % pgm_txw_max_length (window);
+		const uint_fast32_t index_ = skb->sequence & window->mask;
 		window->pdata[index_] = NULL;
 	}
 	pgm_free_skb (skb);
 
-/* advance trailing pointer */
-	pgm_atomic_inc32 (&window->trail);
-
 /* post-conditions */
-	pgm_assert (!pgm_txw_is_full (window));
+	pgm_assert_cmpuint (pgm_txw_length (window), <, window->alloc);
 }
 
-/* Try to add a sequence number to the retransmit queue, ignore if
- * already there or no longer in the transmit window.
- *
- * For parity NAKs, we deal on the transmission group sequence number
- * rather than the packet sequence number.  To simplify managment we
- * use the leading window packet to store the details of the entire
- * transmisison group.  Parity NAKs are ignored if the packet count is
- * less than or equal to the count already queued for retransmission.
- *
- * returns FALSE if request was eliminated, returns TRUE if request was
- * added to queue.
+/* release all cached parity packets of transmission groups preceding tg_sqn,
+ * cached parity cannot outlive the leading packet of its group.
  */
 
-PGM_GNUC_INTERNAL
-bool
-pgm_txw_retransmit_push (
+static
+void
+pgm_txw_parity_cache_evict (
 	pgm_txw_t* const	window,
-	const uint32_t		sequence,
-	const bool		is_parity,	/* parity NAK ⇒ sequence_number = transmission group | packet count */
-	const uint8_t		tg_sqn_shift
+	const uint32_t		tg_sqn
 	)
 {
-/* pre-conditions */
-	pgm_assert (NULL != window);
-	pgm_assert_cmpuint (tg_sqn_shift, <, 8 * sizeof(uint32_t));
-
-	pgm_debug ("retransmit_push (window:%p sequence:%" PRIu32 " is_parity:%s tg_sqn_shift:%u)",
-		(const void*)window, sequence, is_parity ? "TRUE" : "FALSE", tg_sqn_shift);
-
-/* early elimination */
-	if (pgm_txw_is_empty (window))
-		return FALSE;
-
-	if (is_parity)
+	pgm_list_t* link = window->parity_cache.tail;
+	while (NULL != link)
 	{
-		return pgm_txw_retransmit_push_parity (window, sequence, tg_sqn_shift);
-	}
-	else
-	{
-		return pgm_txw_retransmit_push_selective (window, sequence);
+		struct pgm_sk_buff_t* skb = (struct pgm_sk_buff_t*)link;
+		link = link->prev;
+		if (!pgm_uint32_lt (skb->sequence & (0xffffffff << window->tg_sqn_shift), tg_sqn))
+			continue;
+		pgm_queue_unlink (&window->parity_cache, (pgm_list_t*)skb);
+		window->parity_cache_size -= skb->truesize;
+		pgm_free_skb (skb);
 	}
 }
 
+/* find a cached parity packet by transmission group and parity index.
+ *
+ * returns pointer to skb, or NULL if not cached.
+ */
+
 static
-bool
-pgm_txw_retransmit_push_parity (
+struct pgm_sk_buff_t*
+pgm_txw_parity_cache_peek (
+	pgm_txw_t* const	window,
+	const uint32_t		sequence	/* tg_sqn | h */
+	)
+{
+	for (pgm_list_t* link = window->parity_cache.head; NULL != link; link = link->next)
+	{
+		struct pgm_sk_buff_t* skb = (struct pgm_sk_buff_t*)link;
+		if (skb->sequence == sequence) {
+/* most recently used to head */
+			if (link != window->parity_cache.head) {
+				pgm_queue_unlink (&window->parity_cache, link);
+				pgm_queue_push_head_link (&window->parity_cache, link);
+			}
+			return skb;
+		}
+	}
+	return NULL;
+}
+
+/* allocate up to count parity packets into the cache, evicting least
+ * recently used entries to remain within budget.
+ *
+ * returns count of skbs written to skbs, zero if the budget cannot hold one packet.
+ */
+
+static
+unsigned
+pgm_txw_parity_cache_alloc (
+	pgm_txw_t* const		window,
+	struct pgm_sk_buff_t**const	skbs,
+	const unsigned			count
+	)
+{
+	const size_t truesize = window->parity_tpdu + sizeof(struct pgm_sk_buff_t);
+	const unsigned n = (unsigned)MIN(count, window->parity_cache_max / truesize);
+	while (window->parity_cache_size + (n * truesize) > window->parity_cache_max)
+	{
+		struct pgm_sk_buff_t* skb = (struct pgm_sk_buff_t*)pgm_queue_pop_tail_link (&window->parity_cache);
+		pgm_assert (NULL != skb);
+		window->parity_cache_size -= skb->truesize;
+		pgm_free_skb (skb);
+	}
+	for (unsigned i = 0; i < n; i++)
+	{
+		skbs[i] = pgm_alloc_skb (window->parity_tpdu);
+		pgm_queue_push_head_link (&window->parity_cache, (pgm_list_t*)skbs[i]);
+		window->parity_cache_size += skbs[i]->truesize;
+	}
+	return n;
+}
+
+/* Try to add a sequence number to the retransmit queue, ignore if no
+ * longer in the transmit window.  Safe from any thread, the request sets one
+ * bit of the window wide request bitmap and is resolved against the window
+ * by the next pgm_txw_retransmit_try_peek() of the repair path.
+ *
+ * For parity NAKs, we deal on the transmission group sequence number
+ * rather than the packet sequence number.  Each transmission group slot
+ * holds the highest packet count requested since last served.  Parity NAKs
+ * are ignored if the packet count is less than or equal to the count already
+ * queued for retransmission.
+ *
+ * The sending thread cancels requests of each packet leaving the window, a
+ * request racing with it withdraws itself on finding the trail passed.
+ * Selective requests preceding the window pass to the transmit log if any,
+ * requests for sequences added unreliable are refused.
+ *
+ * returns FALSE if request was eliminated, returns TRUE if request was
+ * added to queue.
+ */
+
+PGM_GNUC_INTERNAL
+bool
+pgm_txw_retransmit_push (
 	pgm_txw_t* const	window,
 	const uint32_t		sequence,
+	const bool		is_parity,	/* parity NAK ⇒ sequence_number = transmission group | packet count */
 	const uint8_t		tg_sqn_shift
 	)
 {
-	struct pgm_sk_buff_t	*skb;
-	pgm_txw_state_t		*state;
-
 /* pre-conditions */
 	pgm_assert (NULL != window);
 	pgm_assert_cmpuint (tg_sqn_shift, <, 8 * sizeof(uint32_t));
 
-	const uint32_t tg_sqn_mask = 0xffffffff << tg_sqn_shift;
-	const uint32_t nak_tg_sqn  = sequence &  tg_sqn_mask;	/* left unshifted */
-	const uint32_t nak_pkt_cnt = sequence & ~tg_sqn_mask;
-	skb = _pgm_txw_peek (window, nak_tg_sqn);
+	pgm_debug ("retransmit_push (window:%p sequence:%" PRIu32 " is_parity:%s tg_sqn_shift:%u)",
+		(const void*)window, sequence, is_parity ? "TRUE" : "FALSE", tg_sqn_shift);
 
-	if (NULL == skb) {
-		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Transmission group lead #%" PRIu32 " not in window."), nak_tg_sqn);
+/* early elimination */
+	if (pgm_txw_is_empty (window))
+		return FALSE;
+
+	if (is_parity && !window->is_fec_enabled) {
+		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Parity NAK for #%" PRIu32 " without FEC."), sequence);
 		return FALSE;
 	}
 
-	pgm_assert (pgm_skb_is_valid (skb));
-	pgm_assert (pgm_tsi_is_null (&skb->tsi));
-	state = (pgm_txw_state_t*)&skb->cb;
+	const uint32_t tg_sqn_mask = 0xffffffff << tg_sqn_shift;
+	const uint32_t lead_sqn = is_parity ? sequence & tg_sqn_mask : sequence;
+	if (!is_parity && NULL != window->log &&
+	    pgm_uint32_lt (sequence, pgm_txw_trail_atomic (window)))
+	{
+		return pgm_txlog_retransmit_push (window->log, sequence);
+	}
+	if (!pgm_uint32_gte (lead_sqn, pgm_txw_trail_atomic (window)) ||
+	    !pgm_uint32_lte (lead_sqn, pgm_txw_lead_atomic (window)))
+	{
+		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Requested packet #%" PRIu32 " not in window."), lead_sqn);
+		return FALSE;
+	}
 
-/* check if request can be eliminated */
-	if (state->waiting_retransmit)
+	if (is_parity)
 	{
-		pgm_assert (NULL != ((const pgm_list_t*)skb)->next);
-		pgm_assert (NULL != ((const pgm_list_t*)skb)->prev);
-		if (state->pkt_cnt_requested < nak_pkt_cnt) {
-/* more parity packets requested than currently scheduled, simply bump up the count */
-			state->pkt_cnt_requested = nak_pkt_cnt;
+		const unsigned index_ = pgm_txw_tg_index (window, lead_sqn);
+		const uint32_t nak_pkt_cnt = (sequence & ~tg_sqn_mask) + 1;	/* encoded as count minus one */
+		uint32_t requested;
+
+/* raise the count first, the bit follows such that the repair path clearing
+ * the bit finds the count.
+ */
+		do {
+			requested = pgm_atomic_read32 (&window->parity_requested[ index_ ]);
+			if (requested >= nak_pkt_cnt) {
+				pgm_atomic_inc32 (&window->nak_elimination_count);
+				return FALSE;
+			}
+		} while (!pgm_atomic_compare_and_exchange32 (&window->parity_requested[ index_ ], requested, nak_pkt_cnt));
+		pgm_txw_bitmap_set (window, window->parity_bitmap, index_);
+/* group left the window meanwhile and may be cancelled already */
+		if (PGM_UNLIKELY(pgm_uint32_lt (lead_sqn, pgm_txw_trail_atomic (window)))) {
+			pgm_txw_parity_take (window, index_);
+			pgm_txw_bitmap_clear (window, window->parity_bitmap, index_);
+			return FALSE;
 		}
-		state->nak_elimination_count++;
+		return TRUE;
+	}
+
+/* request already outstanding, test before writing to keep the line shared */
+	const unsigned index_ = sequence & window->mask;
+	const uint32_t bit = 1U << (index_ & 31);
+	if (PGM_UNLIKELY(pgm_atomic_read32 (&window->unreliable_bitmap[ index_ >> 5 ]) & bit)) {
+		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Requested packet #%" PRIu32 " sent unreliable."), sequence);
 		return FALSE;
 	}
-	else
+	if ((pgm_atomic_read32 (&window->retransmit_bitmap[ index_ >> 5 ]) & bit) ||
+	    !pgm_txw_bitmap_set (window, window->retransmit_bitmap, index_))
 	{
-		pgm_assert (((const pgm_list_t*)skb)->next == NULL);
-		pgm_assert (((const pgm_list_t*)skb)->prev == NULL);
+		pgm_atomic_inc32 (&window->nak_elimination_count);
+		return FALSE;
+	}
+	if (PGM_UNLIKELY(pgm_uint32_lt (sequence, pgm_txw_trail_atomic (window)))) {
+		pgm_txw_bitmap_clear (window, window->retransmit_bitmap, index_);
+		return FALSE;
 	}
+	return TRUE;
+}
+
+/* set one request bit.
+ *
+ * returns TRUE if the bit was clear, returns FALSE if already set.
+ */
 
-/* new request */
-	state->pkt_cnt_requested++;
-	pgm_queue_push_head_link (&window->retransmit_queue, (pgm_list_t*)skb);
-	pgm_assert (!pgm_queue_is_empty (&window->retransmit_queue));
-	state->waiting_retransmit = 1;
+static inline
+bool
+pgm_txw_bitmap_set (
+	pgm_txw_t* const		window,
+	volatile uint32_t* const	bitmap,
+	const unsigned			index_
+	)
+{
+	const uint32_t bit = 1U << (index_ & 31);
+	if (pgm_atomic_fetch_and_or32 (&bitmap[ index_ >> 5 ], bit) & bit)
+		return FALSE;
+	pgm_atomic_inc32 (&window->retransmit_pending);
 	return TRUE;
 }
 
+/* clear one request bit.
+ */
+
+static inline
+void
+pgm_txw_bitmap_clear (
+	pgm_txw_t* const		window,
+	volatile uint32_t* const	bitmap,
+	const unsigned			index_
+	)
+{
+	const uint32_t bit = 1U << (index_ & 31);
+	if (pgm_atomic_fetch_and_and32 (&bitmap[ index_ >> 5 ], ~bit) & bit)
+		pgm_atomic_dec32 (&window->retransmit_pending);
+}
+
+/* find the first set bit of len bits of a cyclic bitmap of nbits starting
+ * at index from, one word at a time.
+ *
+ * returns offset from index, or len if no bit is set.
+ */
+
 static
-bool
-pgm_txw_retransmit_push_selective (
+unsigned
+pgm_txw_bitmap_find (
+	const volatile uint32_t* const	bitmap,
+	const unsigned			nbits,
+	const unsigned			from,
+	const unsigned			len
+	)
+{
+	unsigned offset = 0;
+	while (offset < len)
+	{
+		const unsigned i = (from + offset) % nbits;
+		const unsigned run = MIN(MIN(len - offset, 32 - (i & 31)), nbits - i);
+		uint32_t word = pgm_atomic_read32 (&bitmap[ i >> 5 ]) >> (i & 31);
+		if (run < 32)
+			word &= (1U << run) - 1;
+		if (0 != word)
+			return offset + pgm_ctz32 (word);
+		offset += run;
+	}
+	return len;
+}
+
+/* take the parity packet count requested of a transmission group since last
+ * called.
+ */
+
+static inline
+uint32_t
+pgm_txw_parity_take (
+	pgm_txw_t* const	window,
+	const unsigned		index_
+	)
+{
+	uint32_t requested;
+	do {
+		requested = pgm_atomic_read32 (&window->parity_requested[ index_ ]);
+	} while (0 != requested &&
+		 !pgm_atomic_compare_and_exchange32 (&window->parity_requested[ index_ ], requested, 0));
+	return requested;
+}
+
+/* end parity request of a transmission group, re-arming the bit for a count
+ * raised since taken.
+ */
+
+static
+void
+pgm_txw_parity_clear (
+	pgm_txw_t* const	window,
+	const uint32_t		tg_sqn
+	)
+{
+	const unsigned index_ = pgm_txw_tg_index (window, tg_sqn);
+	pgm_txw_bitmap_clear (window, window->parity_bitmap, index_);
+	if (0 != pgm_atomic_read32 (&window->parity_requested[ index_ ]))
+		pgm_txw_bitmap_set (window, window->parity_bitmap, index_);
+}
+
+/* merge parity requests raised while a transmission group is in service.
+ */
+
+static
+void
+pgm_txw_parity_merge (
+	pgm_txw_t* const		window,
+	struct pgm_sk_buff_t* const	skb
+	)
+{
+	pgm_txw_state_t* state = (pgm_txw_state_t*)&skb->cb;
+	const uint32_t requested = pgm_txw_parity_take (window, pgm_txw_tg_index (window, skb->sequence));
+	if (0 == requested)
+		return;
+	if ((uint8_t)(state->pkt_cnt_requested - state->pkt_cnt_sent) < requested) {
+/* more parity packets requested than currently scheduled, simply bump up the count */
+		state->pkt_cnt_requested = (uint8_t)(state->pkt_cnt_sent + requested);
+	} else
+		pgm_atomic_inc32 (&window->nak_elimination_count);
+}
+
+/* cancel requests of a packet leaving the window, and of its transmission
+ * group with the leading packet, before the slot is reused.  sending thread
+ * only.
+ */
+
+static
+void
+pgm_txw_retransmit_cancel (
 	pgm_txw_t* const	window,
 	const uint32_t		sequence
 	)
+{
+	const unsigned index_ = sequence & window->mask;
+	if (pgm_atomic_read32 (&window->retransmit_bitmap[ index_ >> 5 ]) & (1U << (index_ & 31)))
+		pgm_txw_bitmap_clear (window, window->retransmit_bitmap, index_);
+
+	if (!window->is_fec_enabled ||
+	    0 != (sequence & ~(0xffffffff << window->tg_sqn_shift)))
+		return;
+	const unsigned tg_index = pgm_txw_tg_index (window, sequence);
+	if ((pgm_atomic_read32 (&window->parity_bitmap[ tg_index >> 5 ]) & (1U << (tg_index & 31))) ||
+	    0 != pgm_atomic_read32 (&window->parity_requested[ tg_index ]))
+	{
+		pgm_txw_parity_take (window, tg_index);
+		pgm_txw_bitmap_clear (window, window->parity_bitmap, tg_index);
+	}
+}
+
+/* move the oldest outstanding request at or after sequence from into the
+ * retransmit queue, scanning both bitmaps in sequence order.  a parity
+ * request is ordered by the leading packet of its transmission group.
+ * repair path only.
+ *
+ * returns the queued skb, or NULL if no request is outstanding.
+ */
+
+static
+struct pgm_sk_buff_t*
+pgm_txw_retransmit_select (
+	pgm_txw_t* const	window,
+	uint32_t		from
+	)
 {
 	struct pgm_sk_buff_t	*skb;
 	pgm_txw_state_t		*state;
 
-/* pre-conditions */
-	pgm_assert (NULL != window);
+	for (;;)
+	{
+		const uint32_t trail = pgm_txw_trail_atomic (window);
+		const uint32_t lead  = pgm_txw_lead_atomic (window);
+		if (pgm_uint32_lt (from, trail))
+			from = trail;
+		if (pgm_uint32_gt (from, lead))
+			return NULL;
+
+		const uint32_t len = (lead - from) + 1;
+		const uint32_t offset = pgm_txw_bitmap_find (window->retransmit_bitmap, window->alloc,
+							    from & window->mask, len);
+		const uint32_t sequence = from + offset;
+
+		if (window->is_fec_enabled)
+		{
+/* transmission groups starting at or after from, up to the selective request */
+			const uint32_t tg_sqn_mask = 0xffffffff << window->tg_sqn_shift;
+			const uint32_t first_tg = (from + ~tg_sqn_mask) & tg_sqn_mask;
+			const uint32_t last_sqn = offset < len ? sequence : lead;
+			if (pgm_uint32_lte (first_tg, last_sqn))
+			{
+				const uint32_t tgs = (((last_sqn & tg_sqn_mask) - first_tg) >> window->tg_sqn_shift) + 1;
+				const uint32_t tg_offset = pgm_txw_bitmap_find (window->parity_bitmap, window->tg_alloc,
+									       pgm_txw_tg_index (window, first_tg), tgs);
+				if (tg_offset < tgs)
+				{
+					const uint32_t tg_sqn = first_tg + (tg_offset << window->tg_sqn_shift);
+					const unsigned index_ = pgm_txw_tg_index (window, tg_sqn);
+					skb = pgm_txw_peek_get (window, tg_sqn);
+					if (PGM_UNLIKELY(NULL == skb)) {
+						pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Transmission group lead #%" PRIu32 " not in window."), tg_sqn);
+						pgm_txw_parity_take (window, index_);
+						pgm_txw_parity_clear (window, tg_sqn);
+						continue;
+					}
+					const uint32_t requested = pgm_txw_parity_take (window, index_);
+					if (PGM_UNLIKELY(0 == requested)) {
+						pgm_txw_parity_clear (window, tg_sqn);
+						pgm_free_skb (skb);
+						continue;
+					}
+					state = (pgm_txw_state_t*)&skb->cb;
+					pgm_assert (!state->waiting_retransmit);
+/* new request, for the next requested parity packets of the group, keeping the reference */
+					state->pkt_cnt_requested = (uint8_t)(state->pkt_cnt_sent + requested);
+					state->waiting_retransmit = 1;
+					pgm_queue_push_head_link (&window->retransmit_queue, (pgm_list_t*)skb);
+					return skb;
+				}
+			}
+		}
 
-	skb = _pgm_txw_peek (window, sequence);
-	if (NULL == skb) {
-		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Requested packet #%" PRIu32 " not in window."), sequence);
-		return FALSE;
+		if (offset == len)
+			return NULL;
+
+		skb = pgm_txw_peek_get (window, sequence);
+		if (PGM_UNLIKELY(NULL == skb)) {
+			pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Requested packet #%" PRIu32 " not in window."), sequence);
+			from = sequence + 1;
+			continue;
+		}
+		pgm_assert (pgm_skb_is_valid (skb));
+		pgm_assert (pgm_tsi_is_null (&skb->tsi));
+		state = (pgm_txw_state_t*)&skb->cb;
+		pgm_assert (!state->waiting_retransmit);
+		pgm_assert (((const pgm_list_t*)skb)->next == NULL);
+		pgm_assert (((const pgm_list_t*)skb)->prev == NULL);
+
+/* new request, keeping the reference */
+		state->waiting_retransmit = 1;
+		pgm_queue_push_head_link (&window->retransmit_queue, (pgm_list_t*)skb);
+		return skb;
 	}
+}
 
-	pgm_assert (pgm_skb_is_valid (skb));
-	pgm_assert (pgm_tsi_is_null (&skb->tsi));
-	state = (pgm_txw_state_t*)&skb->cb;
+/* remove the oldest request from the retransmit queue, clear its request bit
+ * unless cancelled with the packet leaving the window, and release its
+ * reference.
+ */
 
-/* check if request can be eliminated */
-	if (state->waiting_retransmit) {
-		pgm_assert (!pgm_queue_is_empty (&window->retransmit_queue));
-		state->nak_elimination_count++;
-		return FALSE;
+static
+void
+pgm_txw_retransmit_pop_tail (
+	pgm_txw_t* const	window
+	)
+{
+	struct pgm_sk_buff_t* skb = (struct pgm_sk_buff_t*)pgm_queue_pop_tail_link (&window->retransmit_queue);
+	pgm_assert (NULL != skb);
+	pgm_txw_state_t* state = (pgm_txw_state_t*)&skb->cb;
+	const bool is_in_window = pgm_uint32_gte (skb->sequence, pgm_txw_trail_atomic (window));
+	state->waiting_retransmit = 0;
+/* sent count remains as cursor for the next parity packet of the group */
+	if (state->pkt_cnt_requested) {
+		state->pkt_cnt_requested = 0;
+		window->parity_len = 0;
+		if (is_in_window)
+			pgm_txw_parity_clear (window, skb->sequence);
+	} else if (is_in_window) {
+		pgm_txw_bitmap_clear (window, window->retransmit_bitmap, skb->sequence & window->mask);
 	}
+	pgm_free_skb (skb);
+}
 
-	pgm_assert (((const pgm_list_t*)skb)->next == NULL);
-	pgm_assert (((const pgm_list_t*)skb)->prev == NULL);
+/* drop requests in service that left the window, then return the request in
+ * service or select the oldest outstanding request.
+ *
+ * returns the tail skb, or NULL if no request is outstanding.
+ */
 
-/* new request */
-	pgm_queue_push_head_link (&window->retransmit_queue, (pgm_list_t*)skb);
-	pgm_assert (!pgm_queue_is_empty (&window->retransmit_queue));
-	state->waiting_retransmit = 1;
-	return TRUE;
+static
+struct pgm_sk_buff_t*
+pgm_txw_retransmit_prepare (
+	pgm_txw_t* const	window
+	)
+{
+	struct pgm_sk_buff_t* skb;
+
+	const uint32_t trail = pgm_txw_trail_atomic (window);
+	while (NULL != (skb = (struct pgm_sk_buff_t*)pgm_queue_peek_tail_link (&window->retransmit_queue)) &&
+	       pgm_uint32_lt (skb->sequence, trail))
+	{
+		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Retransmit sqn #%" PRIu32 " left transmit window."), skb->sequence);
+		pgm_txw_retransmit_pop_tail (window);
+	}
+
+	if (NULL == skb)
+		skb = pgm_txw_retransmit_select (window, trail);
+	else if (((const pgm_txw_state_t*)&skb->cb)->pkt_cnt_requested)
+		pgm_txw_parity_merge (window, skb);
+
+/* cached parity of groups that left the window */
+	if (window->parity_cache.length > 0) {
+		const uint32_t tg_sqn = (trail - 1) & (0xffffffff << window->tg_sqn_shift);
+		if (tg_sqn != window->parity_cache_trail) {
+			pgm_txw_parity_cache_evict (window, trail);
+			window->parity_cache_trail = tg_sqn;
+		}
+	}
+	return skb;
 }
 
-/* try to peek a request from the retransmit queue
+/* try to peek a request from the retransmit queue, repair path only.
  *
  * return pointer of first skb in queue, or return NULL if the queue is empty.
  */
@@ -551,22 +1352,20 @@ pgm_txw_retransmit_try_peek (
 {
 	struct pgm_sk_buff_t	 *skb;
 	pgm_txw_state_t		 *state;
-	bool			  is_var_pktlen = FALSE;
-	bool			  is_op_encoded = FALSE;
-	uint16_t		  parity_length = 0;
-	const pgm_gf8_t		**src;
-	void			 *data;
 
 /* pre-conditions */
 	pgm_assert (NULL != window);
 
-	src = pgm_newa (const pgm_gf8_t*, window->rs.k);
-
 	pgm_debug ("retransmit_try_peek (window:%p)", (const void*)window);
 
-/* no lock required to detect presence of a request */
-	skb = (struct pgm_sk_buff_t*)pgm_queue_peek_tail_link (&window->retransmit_queue);
+/* a logged request in service completes first, others follow the window */
+	if (NULL != window->log && NULL != window->log->retransmit_skb)
+		return window->log->retransmit_skb;
+
+	skb = pgm_txw_retransmit_prepare (window);
 	if (PGM_UNLIKELY(NULL == skb)) {
+		if (NULL != window->log)
+			return pgm_txlog_retransmit_try_peek (window->log);
 		pgm_debug ("retransmit queue empty on peek.");
 		return NULL;
 	}
@@ -578,8 +1377,8 @@ pgm_txw_retransmit_try_peek (
 		pgm_assert (((const pgm_list_t*)skb)->next == NULL);
 		pgm_assert (((const pgm_list_t*)skb)->prev == NULL);
 	}
-/* packet payload still in transit */
-	if (PGM_UNLIKELY(1 != pgm_atomic_read32 (&skb->users))) {
+/* packet payload still in transit, beyond the window and queue references */
+	if (PGM_UNLIKELY(2 < pgm_atomic_read32 (&skb->users))) {
 		pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Retransmit sqn #%" PRIu32 " is still in transit in transmit thread."), skb->sequence);
 		return NULL;
 	}
@@ -587,13 +1386,168 @@ pgm_txw_retransmit_try_peek (
 		return skb;
 	}
 
-/* generate parity packet to satisify request */	
+/* parity packet already encoded by an earlier peek of this request */
 	const uint8_t rs_h = state->pkt_cnt_sent % (window->rs.n - window->rs.k);
 	const uint32_t tg_sqn_mask = 0xffffffff << window->tg_sqn_shift;
 	const uint32_t tg_sqn = skb->sequence & tg_sqn_mask;
+	if (window->parity_len > 0 && tg_sqn == window->parity_tg_sqn)
+	{
+		const unsigned j = (rs_h + (window->rs.n - window->rs.k) - window->parity_h) % (window->rs.n - window->rs.k);
+		if (j < window->parity_len)
+			return window->parity_buffer[ j ];
+	}
+
+/* parity packet generated for an earlier request of the group */
+	if (window->parity_cache_max > 0)
+	{
+		skb = pgm_txw_parity_cache_peek (window, tg_sqn | rs_h);
+		if (NULL != skb) {
+			window->parity_cache_hits++;
+			return skb;
+		}
+		window->parity_cache_misses++;
+	}
+
+/* generate all outstanding parity packets of the request in one pass over
+ * the transmission group, stopping short of parity already cached.
+ */
+	const uint8_t outstanding = state->pkt_cnt_requested - state->pkt_cnt_sent;
+	uint8_t count = (uint8_t)MIN(outstanding, window->parity_buffer_len);
+	struct pgm_sk_buff_t** odata_skbs = pgm_newa (struct pgm_sk_buff_t*, window->rs.k);
+	struct pgm_sk_buff_t** parity_skbs = window->parity_buffer;
+
+	pgm_assert_cmpuint (count, >, 0);
+
+/* whole group referenced against trail advancement while encoding */
+	for (uint_fast8_t i = 0; i < window->rs.k; i++) {
+		odata_skbs[i] = pgm_txw_peek_get (window, tg_sqn + i);
+		if (PGM_UNLIKELY(NULL == odata_skbs[i])) {
+			pgm_trace (PGM_LOG_ROLE_TX_WINDOW,_("Transmission group #%" PRIu32 " incomplete in transmit window."), tg_sqn);
+			while (i--)
+				pgm_free_skb (odata_skbs[i]);
+			pgm_txw_retransmit_pop_tail (window);
+			return NULL;
+		}
+	}
+
+	if (window->parity_cache_max > 0)
+	{
+		for (uint_fast8_t j = 1; j < count; j++) {
+			const uint8_t h = (rs_h + j) % (window->rs.n - window->rs.k);
+			if (NULL != pgm_txw_parity_cache_peek (window, tg_sqn | h)) {
+				count = j;
+				break;
+			}
+		}
+		struct pgm_sk_buff_t** cache_skbs = pgm_newa (struct pgm_sk_buff_t*, count);
+		const unsigned cached = pgm_txw_parity_cache_alloc (window, cache_skbs, count);
+		if (cached > 0) {
+			count = (uint8_t)cached;
+			parity_skbs = cache_skbs;
+		}
+	}
+
+	pgm_txw_parity_encode (window, odata_skbs, rs_h, count, parity_skbs);
+	for (uint_fast8_t i = 0; i < window->rs.k; i++)
+		pgm_free_skb (odata_skbs[i]);
+
+/* cache entries are keyed by transmission group and parity index */
+	if (parity_skbs != window->parity_buffer) {
+		for (uint_fast8_t j = 0; j < count; j++)
+			parity_skbs[j]->sequence = tg_sqn | ((rs_h + j) % (window->rs.n - window->rs.k));
+/* subsequent packets of the request are found in the cache */
+		window->parity_len = 0;
+		return parity_skbs[ 0 ];
+	}
+
+	window->parity_tg_sqn = tg_sqn;
+	window->parity_h = rs_h;
+	window->parity_len = count;
+	return window->parity_buffer[ 0 ];
+}
+
+/* reserve count parity indices of a transmission group for transmission
+ * outside of the retransmit queue, such that later parity requests continue
+ * with new parity packets.
+ *
+ * returns first reserved parity index h.
+ */
+
+PGM_GNUC_INTERNAL
+uint8_t
+pgm_txw_parity_reserve (
+	pgm_txw_t*	      const restrict window,
+	struct pgm_sk_buff_t* const restrict skb,	/* referenced group lead */
+	const uint8_t			     count
+	)
+{
+	pgm_txw_state_t		*state;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (window->is_fec_enabled);
+	pgm_assert (NULL != skb);
+
+	state = (pgm_txw_state_t*)&skb->cb;
+	const uint8_t rs_h = state->pkt_cnt_sent % (window->rs.n - window->rs.k);
+	state->pkt_cnt_sent += count;
+	if (state->pkt_cnt_requested)
+		state->pkt_cnt_requested += count;
+	return rs_h;
+}
+
+/* generate count parity packets of the transmission group of original data
+ * odata_skbs, starting at parity index rs_h, into parity_skbs.  the caller
+ * must keep all k original packets of the group alive for the duration.
+ *
+ * a partial group ends with NULL entries, encoded as zero length packets by
+ * variable packet length and announced with OPT_CURR_TGSIZE.
+ */
+
+PGM_GNUC_INTERNAL
+void
+pgm_txw_parity_encode (
+	pgm_txw_t* const			window,
+	struct pgm_sk_buff_t*const*const	odata_skbs,	/* k original packets */
+	const uint8_t				rs_h,
+	const uint8_t				count,
+	struct pgm_sk_buff_t*const*const	parity_skbs
+	)
+{
+	struct pgm_sk_buff_t	 *skb;
+	uint_fast8_t		  tg_size;
+	bool			  is_var_pktlen = FALSE;
+	bool			  is_op_encoded = FALSE;
+	uint16_t		  parity_length = 0;
+	const pgm_gf8_t		**src;
+	void			 *data;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (window->is_fec_enabled);
+	pgm_assert (NULL != odata_skbs);
+	pgm_assert (NULL != parity_skbs);
+	pgm_assert_cmpuint (count, >, 0);
+	pgm_assert_cmpuint (count, <=, window->rs.n - window->rs.k);
+
+	tg_size = window->rs.k;
+
+	pgm_debug ("parity_encode (window:%p odata-skbs:%p rs(h):%u count:%u parity-skbs:%p)",
+		(const void*)window, (const void*)odata_skbs, rs_h, count, (const void*)parity_skbs);
+
+	src = pgm_newa (const pgm_gf8_t*, window->rs.k);
+	const uint32_t tg_sqn = odata_skbs[0]->sequence;
+	uint8_t* offsets = pgm_newa (uint8_t, count);
+	pgm_gf8_t** dst = pgm_newa (pgm_gf8_t*, count);
+	pgm_gf8_t** opt_dst = pgm_newa (pgm_gf8_t*, count);
+
 	for (uint_fast8_t i = 0; i < window->rs.k; i++)
 	{
-		const struct pgm_sk_buff_t* odata_skb = pgm_txw_peek (window, tg_sqn + i);
+		const struct pgm_sk_buff_t* odata_skb = odata_skbs[i];
+		if (NULL == odata_skb) {
+			tg_size = i;
+			break;
+		}
 		const uint16_t odata_tsdu_length = pgm_ntohs (odata_skb->pgm_header->pgm_tsdu_length);
 		if (!parity_length)
 		{
@@ -612,27 +1566,18 @@ pgm_txw_retransmit_try_peek (
 		}
 	}
 
-/* construct basic PGM header to be completed by send_rdata() */
-	skb = window->parity_buffer;
-	skb->data = skb->tail = skb->head = skb + 1;
-
-/* space for PGM header */
-	pgm_skb_put (skb, sizeof(struct pgm_header));
-
-	skb->pgm_header		= skb->data;
-	skb->pgm_data		= (void*)( skb->pgm_header + 1 );
-	memcpy (skb->pgm_header->pgm_gsi, &window->tsi->gsi, sizeof(pgm_gsi_t));
-	skb->pgm_header->pgm_options = PGM_OPT_PARITY;
+	pgm_assert_cmpuint (tg_size, >, 0);
+	const bool is_partial = (tg_size < window->rs.k);
+	if (is_partial)
+		is_var_pktlen = TRUE;
 
 /* append actual TSDU length if variable length packets, zero pad as necessary.
  */
 	if (is_var_pktlen)
 	{
-		skb->pgm_header->pgm_options |= PGM_OPT_VAR_PKTLEN;
-
-		for (uint_fast8_t i = 0; i < window->rs.k; i++)
+		for (uint_fast8_t i = 0; i < tg_size; i++)
 		{
-			struct pgm_sk_buff_t* odata_skb = pgm_txw_peek (window, tg_sqn + i);
+			struct pgm_sk_buff_t* odata_skb = odata_skbs[i];
 			const uint16_t odata_tsdu_length = pgm_ntohs (odata_skb->pgm_header->pgm_tsdu_length);
 
 			pgm_assert (odata_tsdu_length == odata_skb->len);
@@ -647,100 +1592,214 @@ pgm_txw_retransmit_try_peek (
 		parity_length += 2;
 	}
 
-	skb->pgm_header->pgm_tsdu_length = pgm_htons (parity_length);
-
-/* space for DATA */
-	pgm_skb_put (skb, sizeof(struct pgm_data) + parity_length);
-
-	skb->pgm_data->data_sqn	= pgm_htonl ( tg_sqn | rs_h );
-
-	data = skb->pgm_data + 1;
+/* packets beyond a partial group are all zero, including the length */
+	if (is_partial)
+	{
+		pgm_gf8_t* zero = pgm_newa (pgm_gf8_t, parity_length);
+		memset (zero, 0, parity_length);
+		for (uint_fast8_t i = tg_size; i < window->rs.k; i++)
+			src[i] = zero;
+	}
 
 /* encode every option separately, currently only one applies: opt_fragment
  */
-	if (is_op_encoded)
-	{
-		struct pgm_opt_header	*opt_header;
-		struct pgm_opt_length	*opt_len;
-		struct pgm_opt_fragment	*opt_fragment, null_opt_fragment;
+	struct pgm_opt_fragment null_opt_fragment;
 #ifndef _MSC_VER
 /* MSVC 2013 unsupported:
  * error C2057: expected constant expression
  * error C2466: cannot allocate an array of constant size 0
  * error C2133: 'opt_src' : unknown size
  */
-		const pgm_gf8_t		*opt_src[ window->rs.k ];
+	const pgm_gf8_t		*opt_src[ window->rs.k ];
 #else
-		pgm_gf8_t               *opt_src = pgm_newa (pgm_gf8_t*, window->rs.k);
+	const pgm_gf8_t         **opt_src = pgm_newa (const pgm_gf8_t*, window->rs.k);
 #endif
+	const uint16_t opt_total_length = sizeof(struct pgm_opt_length) +
+					 (is_partial ? sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_curr_tgsize) : 0) +
+					 (is_op_encoded ? sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_fragment) : 0);
 
-		skb->pgm_header->pgm_options |= PGM_OPT_PRESENT;
-
+	if (is_op_encoded)
+	{
 		memset (&null_opt_fragment, 0, sizeof(null_opt_fragment));
 		*(uint8_t*)&null_opt_fragment |= PGM_OP_ENCODED_NULL;
 
 		for (uint_fast8_t i = 0; i < window->rs.k; i++)
 		{
-			const struct pgm_sk_buff_t* odata_skb = pgm_txw_peek (window, tg_sqn + i);
+			const struct pgm_sk_buff_t* odata_skb = odata_skbs[i];
 
-			if (odata_skb->pgm_opt_fragment)
+			if (i < tg_size && odata_skb->pgm_opt_fragment)
 			{
 				pgm_assert (odata_skb->pgm_header->pgm_options & PGM_OPT_PRESENT);
-/* skip three bytes of header */
-				opt_src[i] = (pgm_gf8_t*)((char*)odata_skb->pgm_opt_fragment + sizeof (struct pgm_opt_header));
+				opt_src[i] = (pgm_gf8_t*)odata_skb->pgm_opt_fragment;
 			}
 			else
 			{
 				opt_src[i] = (pgm_gf8_t*)&null_opt_fragment;
 			}
 		}
+	}
+
+/* construct basic PGM header of each parity packet to be completed by send_rdata(),
+ * ports as per the original data.
+ */
+	const struct pgm_header* lead_header = odata_skbs[0]->pgm_header;
+	for (uint_fast8_t j = 0; j < count; j++)
+	{
+		const uint8_t h = (rs_h + j) % (window->rs.n - window->rs.k);
+
+		skb = parity_skbs[ j ];
+		skb->data = skb->tail = skb->head = skb + 1;
+
+/* space for PGM header */
+		pgm_skb_put (skb, sizeof(struct pgm_header));
+
+		skb->pgm_header		= skb->data;
+		skb->pgm_data		= (void*)( skb->pgm_header + 1 );
+		memcpy (skb->pgm_header->pgm_gsi, &window->tsi->gsi, sizeof(pgm_gsi_t));
+		skb->pgm_header->pgm_sport = lead_header->pgm_sport;
+		skb->pgm_header->pgm_dport = lead_header->pgm_dport;
+		skb->pgm_header->pgm_options = PGM_OPT_PARITY;
+		if (is_var_pktlen)
+			skb->pgm_header->pgm_options |= PGM_OPT_VAR_PKTLEN;
+		skb->pgm_header->pgm_tsdu_length = pgm_htons (parity_length);
+
+/* space for DATA */
+		pgm_skb_put (skb, sizeof(struct pgm_data) + parity_length);
+
+		skb->pgm_data->data_sqn	= pgm_htonl ( tg_sqn | h );
+
+		data = skb->pgm_data + 1;
 
 /* add options to this rdata packet */
-		const uint16_t opt_total_length = sizeof(struct pgm_opt_length) +
-						 sizeof(struct pgm_opt_header) +
-						 sizeof(struct pgm_opt_fragment);
+		if (is_op_encoded || is_partial)
+		{
+			struct pgm_opt_length	*opt_len;
+
+			skb->pgm_header->pgm_options |= PGM_OPT_PRESENT;
 
 /* add space for PGM options */
-		pgm_skb_put (skb, opt_total_length);
-
-		opt_len					= data;
-		opt_len->opt_type			= PGM_OPT_LENGTH;
-		opt_len->opt_length			= sizeof(struct pgm_opt_length);
-		opt_len->opt_total_length		= pgm_htons ( opt_total_length );
-		opt_header			 	= (struct pgm_opt_header*)(opt_len + 1);
-		opt_header->opt_type			= PGM_OPT_FRAGMENT | PGM_OPT_END;
-		opt_header->opt_length			= sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_fragment);
-		opt_header->opt_reserved 		= PGM_OP_ENCODED;
-		opt_fragment				= (struct pgm_opt_fragment*)(opt_header + 1);
+			pgm_skb_put (skb, opt_total_length);
+
+			opt_len				= data;
+			opt_len->opt_type		= PGM_OPT_LENGTH;
+			opt_len->opt_length		= sizeof(struct pgm_opt_length);
+			opt_len->opt_total_length	= pgm_htons ( opt_total_length );
+			data				= opt_len + 1;
+		}
+		if (is_partial)
+		{
+			struct pgm_opt_header	*opt_header;
+			struct pgm_opt_curr_tgsize *opt_curr_tgsize;
+
+			opt_header			= data;
+			opt_header->opt_type		= is_op_encoded ? PGM_OPT_CURR_TGSIZE : (PGM_OPT_CURR_TGSIZE | PGM_OPT_END);
+			opt_header->opt_length		= sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_curr_tgsize);
+			opt_header->opt_reserved	= 0;
+			opt_curr_tgsize			= (struct pgm_opt_curr_tgsize*)(opt_header + 1);
+			opt_curr_tgsize->opt_reserved	= 0;
+			opt_curr_tgsize->prm_atgsize	= pgm_htonl ((uint32_t)tg_size);
+			data				= opt_curr_tgsize + 1;
+		}
+		if (is_op_encoded)
+		{
+			struct pgm_opt_header	*opt_header;
+			struct pgm_opt_fragment	*opt_fragment;
+
+			opt_header			= data;
+			opt_header->opt_type		= PGM_OPT_FRAGMENT | PGM_OPT_END;
+			opt_header->opt_length		= sizeof(struct pgm_opt_header) + sizeof(struct pgm_opt_fragment);
+			opt_header->opt_reserved 	= PGM_OP_ENCODED;
+			opt_fragment			= (struct pgm_opt_fragment*)(opt_header + 1);
 
 /* The cast below is the correct way to handle the problem. 
  * The (void *) cast is to avoid a GCC warning like: 
  *
  *   "warning: dereferencing type-punned pointer will break strict-aliasing rules"
  */
-		pgm_rs_encode (&window->rs,
-				opt_src,
-				window->rs.k + rs_h,
-				(pgm_gf8_t*)((char*)opt_fragment + sizeof(struct pgm_opt_header)),
-				sizeof(struct pgm_opt_fragment) - sizeof(struct pgm_opt_header));
+			opt_dst[j] = (pgm_gf8_t*)(void*)opt_fragment;
+			data = opt_fragment + 1;
+		}
 
-		data = opt_fragment + 1;
+		offsets[j] = window->rs.k + h;
+		dst[j] = data;
 	}
 
-/* encode payload */
-	pgm_rs_encode (&window->rs,
-			src,
-			window->rs.k + rs_h,
-			data,
-			parity_length);
+/* encode options and payload */
+	if (is_op_encoded)
+		pgm_rs_encode_multi (&window->rs,
+				     opt_src,
+				     offsets,
+				     opt_dst,
+				     count,
+				     sizeof(struct pgm_opt_fragment));
+	pgm_rs_encode_multi (&window->rs,
+			     src,
+			     offsets,
+			     dst,
+			     count,
+			     parity_length);
+
+/* calculate partial checksum of each parity packet */
+	for (uint_fast8_t j = 0; j < count; j++)
+	{
+		skb = parity_skbs[ j ];
+		const uint16_t tsdu_length = pgm_ntohs (skb->pgm_header->pgm_tsdu_length);
+		pgm_txw_set_unfolded_checksum (skb, pgm_csum_partial ((char*)skb->tail - tsdu_length, tsdu_length, 0));
+	}
+}
 
-/* calculate partial checksum */
-	const uint16_t tsdu_length = pgm_ntohs (skb->pgm_header->pgm_tsdu_length);
-	state->unfolded_checksum = pgm_csum_partial ((char*)skb->tail - tsdu_length, tsdu_length, 0);
-	return skb;
+/* try to peek a run of selective requests in sequence order, stopping at the
+ * first parity request or packet still in transit.
+ *
+ * returns count of skbs written to skbs, zero if the queue is empty or the
+ * first request requires parity generation via pgm_txw_retransmit_try_peek().
+ */
+
+PGM_GNUC_INTERNAL
+unsigned
+pgm_txw_retransmit_try_peekv (
+	pgm_txw_t* const		window,
+	struct pgm_sk_buff_t**const	skbs,
+	const unsigned			count
+	)
+{
+	unsigned n = 0;
+
+/* pre-conditions */
+	pgm_assert (NULL != window);
+	pgm_assert (NULL != skbs);
+	pgm_assert (count > 0);
+
+	pgm_debug ("retransmit_try_peekv (window:%p skbs:%p count:%u)",
+		(const void*)window, (const void*)skbs, count);
+
+/* logged requests are served one at a time */
+	if (NULL != window->log && NULL != window->log->retransmit_skb)
+		return 0;
+
+/* oldest request at tail, walk towards head */
+	const pgm_list_t* link = (const pgm_list_t*)pgm_txw_retransmit_prepare (window);
+	const uint32_t trail = pgm_txw_trail_atomic (window);
+	while (NULL != link && n < count)
+	{
+		struct pgm_sk_buff_t* skb = (struct pgm_sk_buff_t*)link;
+		const pgm_txw_state_t*const state = (const pgm_txw_state_t*const)&skb->cb;
+		pgm_assert (pgm_skb_is_valid (skb));
+		if (state->pkt_cnt_requested ||
+		    2 < pgm_atomic_read32 (&skb->users) ||
+		    pgm_uint32_lt (skb->sequence, trail))
+			break;
+		skbs[n++] = skb;
+		link = link->prev;
+/* queue exhausted, continue with the next outstanding request in sequence order */
+		if (NULL == link && n < count)
+			link = (const pgm_list_t*)pgm_txw_retransmit_select (window, skb->sequence + 1);
+	}
+	return n;
 }
 
-/* remove head entry from retransmit queue, will fail on assertion if queue is empty.
+/* remove head entry from retransmit queue releasing its reference, will fail
+ * on assertion if queue is empty.
  */
 
 PGM_GNUC_INTERNAL
@@ -758,8 +1817,15 @@ pgm_txw_retransmit_remove_head (
 	pgm_debug ("retransmit_remove_head (window:%p)",
 		(const void*)window);
 
+/* request in service read back from the log */
+	if (NULL != window->log && NULL != window->log->retransmit_skb) {
+		pgm_txlog_retransmit_remove_head (window->log);
+		return;
+	}
+
 /* tail link is valid without lock */
 	skb = (struct pgm_sk_buff_t*)pgm_queue_peek_tail_link (&window->retransmit_queue);
+	pgm_assert (NULL != skb);
 	pgm_assert (pgm_skb_is_valid (skb));
 	pgm_assert (pgm_tsi_is_null (&skb->tsi));
 	state = (pgm_txw_state_t*)&skb->cb;
@@ -772,16 +1838,16 @@ pgm_txw_retransmit_remove_head (
 	{
 		state->pkt_cnt_sent++;
 
-/* remove if all requested parity packets have been sent */
+/* remove if all requested parity packets have been sent, and none requested since */
 		if (state->pkt_cnt_sent == state->pkt_cnt_requested) {
-			pgm_queue_pop_tail_link (&window->retransmit_queue);
-			state->waiting_retransmit = 0;
+			pgm_txw_parity_merge (window, skb);
+			if (state->pkt_cnt_sent == state->pkt_cnt_requested)
+				pgm_txw_retransmit_pop_tail (window);
 		}
 	}
 	else	/* selective request */
 	{
-		pgm_queue_pop_tail_link (&window->retransmit_queue);
-		state->waiting_retransmit = 0;
+		pgm_txw_retransmit_pop_tail (window);
 	}
 }
 
@@ -0,0 +1,315 @@
+/* vim:ts=8:sts=8:sw=4:noai:noexpandtab
+ *
+ * performance tests for transmit window.
+ *
+ * Copyright (c) 2010-2016 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <glib.h>
+#include <check.h>
+
+
+/* mock state */
+
+#define PERF_ITERATIONS		1000000
+#define PERF_TSDU_LENGTH	1000
+
+static unsigned perf_sqns	= 0;
+
+static
+void
+mock_setup_1k (void)
+{
+	perf_sqns	= 1000;
+}
+
+/* power of two, the pointer array is not rounded up */
+static
+void
+mock_setup_1024 (void)
+{
+	perf_sqns	= 1024;
+}
+
+static
+void
+mock_setup_64k (void)
+{
+	perf_sqns	= 65536;
+}
+
+/* mock global */
+
+#define pgm_histogram_add		mock_pgm_histogram_add
+#define pgm_histogram_init		mock_pgm_histogram_init
+#define pgm_compat_csum_partial		mock_pgm_compat_csum_partial
+
+#define TXW_DEBUG
+#include "txw.c"
+
+uint32_t
+mock_pgm_compat_csum_partial (
+	const void*		addr,
+	uint16_t		len,
+	uint32_t		csum
+	)
+{
+	return 0x0;
+}
+
+void
+mock_pgm_histogram_init (
+	pgm_histogram_t*	histogram
+	)
+{
+}
+
+void
+mock_pgm_histogram_add (
+	pgm_histogram_t*	histogram,
+	int			value
+	)
+{
+}
+
+/* mock functions for external references */
+
+size_t
+pgm_pkt_offset (
+        const bool                      can_fragment,
+        const sa_family_t		pgmcc_family	/* 0 = disable */
+        )
+{
+        return 0;
+}
+
+PGM_GNUC_INTERNAL
+int
+pgm_get_nprocs (void)
+{
+	return 1;
+}
+
+static
+void
+mock_setup (void)
+{
+	g_assert (pgm_time_init (NULL));
+}
+
+static
+void
+mock_teardown (void)
+{
+	g_assert (pgm_time_shutdown ());
+}
+
+static
+void
+perf_report (
+	const char*		name,
+	const pgm_time_t	elapsed,		/* μs */
+	const guint64		count
+	)
+{
+	g_message ("%s/%u: elapsed time %" PGM_TIME_FORMAT " us, unit time %" PGM_TIME_FORMAT " ns, %" PGM_TIME_FORMAT " packets/s",
+		name, perf_sqns,
+		(guint64)elapsed,
+		(guint64)((1000 * elapsed) / count),
+		(guint64)(elapsed ? (1000000 * count) / elapsed : 0));
+}
+
+/* take the buffer of the next sequence from the window packet slots as the
+ * source does, data pointer pointing to PGM payload.
+ */
+static
+struct pgm_sk_buff_t*
+generate_valid_skb (
+	pgm_txw_t*		window
+	)
+{
+	const guint16 header_length = sizeof(struct pgm_header) + sizeof(struct pgm_data);
+	struct pgm_sk_buff_t* skb = pgm_txw_alloc_skb (window, NULL, header_length + PERF_TSDU_LENGTH);
+	skb->sock = (pgm_sock_t*)0x1;
+	skb->tstamp = 1;
+	pgm_skb_reserve (skb, header_length);
+	skb->pgm_header = (struct pgm_header*)skb->head;
+	skb->pgm_data   = (struct pgm_data*)(skb->pgm_header + 1);
+	skb->pgm_header->pgm_type = PGM_ODATA;
+	skb->pgm_header->pgm_options = 0;
+	skb->pgm_header->pgm_tsdu_length = g_htons (PERF_TSDU_LENGTH);
+	pgm_skb_put (skb, PERF_TSDU_LENGTH);
+	return skb;
+}
+
+static
+pgm_txw_t*
+generate_full_window (void)
+{
+	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, perf_sqns, 0, 0, FALSE, 0, 0, 0);
+	fail_if (NULL == window, "create failed");
+	pgm_txw_set_slots (window, 1500, 0, FALSE, -1);
+	for (unsigned i = 0; i < perf_sqns; i++)
+		pgm_txw_add (window, generate_valid_skb (window));
+	fail_unless (pgm_txw_is_full (window), "window not full");
+	return window;
+}
+
+/* target:
+ *	void
+ *	pgm_txw_add (
+ *		pgm_txw_t* const		window,
+ *		struct pgm_sk_buff_t* const	skb
+ *		)
+ *
+ * a full window removes the tail on every add.
+ */
+
+START_TEST (test_add)
+{
+	pgm_txw_t* window = generate_full_window ();
+	pgm_time_t start, check;
+
+	start = pgm_time_update_now();
+	for (unsigned i = PERF_ITERATIONS; i; i--)
+		pgm_txw_add (window, generate_valid_skb (window));
+	check = pgm_time_update_now();
+	perf_report ("add", check - start, PERF_ITERATIONS);
+	pgm_txw_shutdown (window);
+}
+END_TEST
+
+/* target:
+ *	struct pgm_sk_buff_t*
+ *	pgm_txw_peek (
+ *		const pgm_txw_t* const	window,
+ *		const uint32_t		sequence
+ *		)
+ */
+
+START_TEST (test_peek)
+{
+	pgm_txw_t* window = generate_full_window ();
+	const uint32_t trail = pgm_txw_trail (window);
+	pgm_time_t start, check;
+	unsigned found = 0;
+
+	start = pgm_time_update_now();
+	for (unsigned i = 0; i < PERF_ITERATIONS; i++)
+		if (NULL != pgm_txw_peek (window, trail + (i * 7919) % perf_sqns))
+			found++;
+	check = pgm_time_update_now();
+	fail_unless (PERF_ITERATIONS == found, "peek failed");
+	perf_report ("peek", check - start, PERF_ITERATIONS);
+	pgm_txw_shutdown (window);
+}
+END_TEST
+
+/* target:
+ *	bool
+ *	pgm_txw_retransmit_push (
+ *		pgm_txw_t* const	window,
+ *		const uint32_t		sequence,
+ *		const bool		is_parity,
+ *		const uint8_t		tg_sqn_shift
+ *		)
+ *
+ * followed by pgm_txw_retransmit_try_peek() and pgm_txw_retransmit_remove_head()
+ * as the repair path services each request.
+ */
+
+START_TEST (test_retransmit)
+{
+	pgm_txw_t* window = generate_full_window ();
+	const uint32_t trail = pgm_txw_trail (window);
+	pgm_time_t start, check;
+
+	start = pgm_time_update_now();
+	for (unsigned i = 0; i < PERF_ITERATIONS; i++) {
+		const bool is_pushed = pgm_txw_retransmit_push (window, trail + (i * 7919) % perf_sqns, FALSE, 0);
+		fail_unless (is_pushed, "retransmit_push failed");
+		struct pgm_sk_buff_t* skb = pgm_txw_retransmit_try_peek (window);
+		fail_if (NULL == skb, "retransmit_try_peek failed");
+		pgm_txw_retransmit_remove_head (window);
+	}
+	check = pgm_time_update_now();
+	perf_report ("retransmit", check - start, PERF_ITERATIONS);
+	pgm_txw_shutdown (window);
+}
+END_TEST
+
+static
+Suite*
+make_txw_suite (void)
+{
+	Suite* s;
+
+	s = suite_create ("Transmit window");
+
+	TCase* tc_1k = tcase_create ("1k sequences");
+	suite_add_tcase (s, tc_1k);
+	tcase_add_checked_fixture (tc_1k, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_1k, mock_setup_1k, NULL);
+	tcase_add_test (tc_1k, test_add);
+	tcase_add_test (tc_1k, test_peek);
+	tcase_add_test (tc_1k, test_retransmit);
+
+	TCase* tc_1024 = tcase_create ("1024 sequences");
+	suite_add_tcase (s, tc_1024);
+	tcase_add_checked_fixture (tc_1024, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_1024, mock_setup_1024, NULL);
+	tcase_add_test (tc_1024, test_add);
+	tcase_add_test (tc_1024, test_peek);
+	tcase_add_test (tc_1024, test_retransmit);
+
+	TCase* tc_64k = tcase_create ("64k sequences");
+	suite_add_tcase (s, tc_64k);
+	tcase_add_checked_fixture (tc_64k, mock_setup, mock_teardown);
+	tcase_add_checked_fixture (tc_64k, mock_setup_64k, NULL);
+	tcase_add_test (tc_64k, test_add);
+	tcase_add_test (tc_64k, test_peek);
+	tcase_add_test (tc_64k, test_retransmit);
+
+	return s;
+}
+
+static
+Suite*
+make_master_suite (void)
+{
+	Suite* s = suite_create ("Master");
+	return s;
+}
+
+int
+main (void)
+{
+	SRunner* sr = srunner_create (make_master_suite ());
+	srunner_add_suite (sr, make_txw_suite ());
+	srunner_run_all (sr, CK_ENV);
+	int number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* eof */
@@ -37,8 +37,14 @@
 #define pgm_rs_create			mock_pgm_rs_create
 #define pgm_rs_destroy			mock_pgm_rs_destroy
 #define pgm_rs_encode			mock_pgm_rs_encode
+#define pgm_rs_encode_multi		mock_pgm_rs_encode_multi
 #define pgm_compat_csum_partial		mock_pgm_compat_csum_partial
 #define pgm_histogram_init		mock_pgm_histogram_init
+#define pgm_txlog_append		mock_pgm_txlog_append
+#define pgm_txlog_retransmit_push	mock_pgm_txlog_retransmit_push
+#define pgm_txlog_retransmit_try_peek	mock_pgm_txlog_retransmit_try_peek
+#define pgm_txlog_retransmit_remove_head	mock_pgm_txlog_retransmit_remove_head
+#define pgm_standby_mirror		mock_pgm_standby_mirror
 
 #define TXW_DEBUG
 #include "txw.c"
@@ -52,6 +58,8 @@ mock_pgm_rs_create (
 	uint8_t			k
 	)
 {
+	rs->n = n;
+	rs->k = k;
 }
 
 void
@@ -72,6 +80,18 @@ mock_pgm_rs_encode(
 {
 }
 
+void
+mock_pgm_rs_encode_multi (
+	pgm_rs_t*		rs,
+	const pgm_gf8_t**	src,
+	const uint8_t*		offsets,
+	pgm_gf8_t**		dst,
+	const uint8_t		count,
+	const uint16_t		len
+        )
+{
+}
+
 /** checksum module */
 uint32_t
 mock_pgm_compat_csum_partial (
@@ -98,6 +118,50 @@ mock_pgm_histogram_add (
 {
 }
 
+/** transmit log module */
+void
+mock_pgm_txlog_append (
+	pgm_txlog_t* const			log,
+	const struct pgm_sk_buff_t* const	skb,
+	const uint32_t				unfolded_checksum
+	)
+{
+}
+
+bool
+mock_pgm_txlog_retransmit_push (
+	pgm_txlog_t* const	log,
+	const uint32_t		sequence
+	)
+{
+	return FALSE;
+}
+
+struct pgm_sk_buff_t*
+mock_pgm_txlog_retransmit_try_peek (
+	pgm_txlog_t* const	log
+	)
+{
+	return NULL;
+}
+
+void
+mock_pgm_txlog_retransmit_remove_head (
+	pgm_txlog_t* const	log
+	)
+{
+}
+
+/** hot standby module */
+void
+mock_pgm_standby_mirror (
+	struct pgm_standby_t* const	standby,
+	const void*			tpdu,
+	const size_t			tpdu_length
+	)
+{
+}
+
 
 /* mock functions for external references */
 
@@ -121,11 +185,12 @@ pgm_get_nprocs (void)
  */
 static
 struct pgm_sk_buff_t*
-generate_valid_skb (void)
+fill_valid_skb (
+	struct pgm_sk_buff_t*	skb
+	)
 {
 	const guint16 tsdu_length = 1000;
 	const guint16 header_length = sizeof(struct pgm_header) + sizeof(struct pgm_data);
-	struct pgm_sk_buff_t* skb = pgm_alloc_skb (1500);
 /* fake but valid transport and timestamp */
 	skb->sock = (pgm_sock_t*)0x1;
 	skb->tstamp = 1;
@@ -141,6 +206,13 @@ generate_valid_skb (void)
 	return skb;
 }
 
+static
+struct pgm_sk_buff_t*
+generate_valid_skb (void)
+{
+	return fill_valid_skb (pgm_alloc_skb (1500));
+}
+
 /* target:
  *	pgm_txw_t*
  *	pgm_txw_create (
@@ -151,7 +223,8 @@ generate_valid_skb (void)
  *		const guint		max_rte,
  *		const gboolean		use_fec,
  *		const guint		rs_n,
- *		const guint		rs_k
+ *		const guint		rs_k,
+ *		const gsize		parity_cache
  *		)
  */
 
@@ -159,7 +232,7 @@ generate_valid_skb (void)
 START_TEST (test_create_pass_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	fail_if (NULL == pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0), "create failed");
+	fail_if (NULL == pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0), "create failed");
 }
 END_TEST
 
@@ -167,7 +240,7 @@ END_TEST
 START_TEST (test_create_pass_002)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	fail_if (NULL == pgm_txw_create (&tsi, 1500, 0, 60, 800000, FALSE, 0, 0), "create failed");
+	fail_if (NULL == pgm_txw_create (&tsi, 1500, 0, 60, 800000, FALSE, 0, 0, 0), "create failed");
 }
 END_TEST
 
@@ -175,7 +248,7 @@ END_TEST
 START_TEST (test_create_pass_003)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	fail_if (NULL == pgm_txw_create (&tsi, 9000, 0, 60, 800000, FALSE, 0, 0), "create failed");
+	fail_if (NULL == pgm_txw_create (&tsi, 9000, 0, 60, 800000, FALSE, 0, 0, 0), "create failed");
 }
 END_TEST
 
@@ -183,7 +256,7 @@ END_TEST
 START_TEST (test_create_pass_004)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	fail_if (NULL == pgm_txw_create (&tsi, UINT16_MAX, 0, 60, 800000, FALSE, 0, 0), "create failed");
+	fail_if (NULL == pgm_txw_create (&tsi, UINT16_MAX, 0, 60, 800000, FALSE, 0, 0, 0), "create failed");
 }
 END_TEST
 
@@ -191,7 +264,7 @@ END_TEST
 START_TEST (test_create_fail_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	const pgm_txw_t* window = pgm_txw_create (&tsi, 0, 0, 60, 800000, FALSE, 0, 0);
+	const pgm_txw_t* window = pgm_txw_create (&tsi, 0, 0, 60, 800000, FALSE, 0, 0, 0);
 	fail ("reached");
 }
 END_TEST
@@ -200,7 +273,7 @@ END_TEST
 START_TEST (test_create_fail_002)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	const pgm_txw_t* window = pgm_txw_create (&tsi, 0, 0, 0, 800000, FALSE, 0, 0);
+	const pgm_txw_t* window = pgm_txw_create (&tsi, 0, 0, 0, 800000, FALSE, 0, 0, 0);
 	fail ("reached");
 }
 END_TEST
@@ -209,7 +282,7 @@ END_TEST
 START_TEST (test_create_fail_003)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	const pgm_txw_t* window = pgm_txw_create (&tsi, 0, 0, 60, 0, FALSE, 0, 0);
+	const pgm_txw_t* window = pgm_txw_create (&tsi, 0, 0, 60, 0, FALSE, 0, 0, 0);
 	fail ("reached");
 }
 END_TEST
@@ -218,7 +291,7 @@ END_TEST
 START_TEST (test_create_fail_004)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	const pgm_txw_t* window = pgm_txw_create (NULL, 0, 0, 0, 0, FALSE, 0, 0);
+	const pgm_txw_t* window = pgm_txw_create (NULL, 0, 0, 0, 0, FALSE, 0, 0, 0);
 	fail ("reached");
 }
 END_TEST
@@ -233,7 +306,7 @@ END_TEST
 START_TEST (test_shutdown_pass_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	pgm_txw_shutdown (window);
 }
@@ -258,7 +331,7 @@ END_TEST
 START_TEST (test_add_pass_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	struct pgm_sk_buff_t* skb = generate_valid_skb ();
 	fail_if (NULL == skb, "generate_valid_skb failed");
@@ -267,11 +340,34 @@ START_TEST (test_add_pass_001)
 }
 END_TEST
 
+/* occupancy high-water and residency of entries leaving the trail */
+START_TEST (test_add_pass_002)
+{
+	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 2, 0, 0, FALSE, 0, 0, 0);
+	fail_if (NULL == window, "create failed");
+	for (unsigned i = 0; i < 3; i++) {
+		struct pgm_sk_buff_t* skb = generate_valid_skb ();
+		fail_if (NULL == skb, "generate_valid_skb failed");
+		skb->tstamp = pgm_msecs(1) + i * pgm_msecs(100);
+		pgm_txw_add (window, skb);
+	}
+	fail_unless (2 == window->peak_length, "peak_length failed");
+	fail_unless (pgm_txw_size (window) == window->peak_size, "peak_size failed");
+	fail_unless (pgm_msecs(200) == window->max_residency, "max_residency failed");
+	guint32 samples = 0;
+	for (unsigned i = 0; i < PGM_TXW_RESIDENCY_BUCKETS; i++)
+		samples += window->residency_hist[ i ];
+	fail_unless (1 == samples, "residency_hist failed");
+	pgm_txw_shutdown (window);
+}
+END_TEST
+
 /* null skb */
 START_TEST (test_add_fail_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	pgm_txw_add (window, NULL);
 	fail ("reached");
@@ -292,7 +388,7 @@ END_TEST
 START_TEST (test_add_fail_003)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	char buffer[1500];
 	memset (buffer, 0, sizeof(buffer));
@@ -301,6 +397,63 @@ START_TEST (test_add_fail_003)
 }
 END_TEST
 
+/* target:
+ *	struct pgm_sk_buff_t*
+ *	pgm_txw_alloc_skb (
+ *		pgm_txw_t* const	window,
+ *		pgm_skb_pool_t* const	pool,
+ *		const guint16		size
+ *		)
+ */
+
+/* slots are re-used once released by the window */
+START_TEST (test_alloc_skb_pass_001)
+{
+	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 4, 0, 0, FALSE, 0, 0, 0);
+	fail_if (NULL == window, "create failed");
+	pgm_txw_set_slots (window, 1500, 0, FALSE, -1);
+	fail_if (NULL == window->slots, "set_slots failed");
+	struct pgm_sk_buff_t* skbs[6];
+	for (unsigned i = 0; i < G_N_ELEMENTS(skbs); i++)
+	{
+		skbs[i] = pgm_txw_alloc_skb (window, NULL, 1500);
+		fail_if (NULL == skbs[i], "alloc_skb failed");
+		fail_unless (window->slots == skbs[i]->pool, "alloc_skb not from slots");
+		pgm_txw_add (window, fill_valid_skb (skbs[i]));
+	}
+/* #0 removed by add of #4 */
+	fail_unless (skbs[0] == skbs[5], "slot not re-used");
+	pgm_txw_shutdown (window);
+}
+END_TEST
+
+/* referenced slot falls back to pool */
+START_TEST (test_alloc_skb_pass_002)
+{
+	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 4, 0, 0, FALSE, 0, 0, 0);
+	fail_if (NULL == window, "create failed");
+	pgm_txw_set_slots (window, 1500, 0, FALSE, -1);
+	struct pgm_sk_buff_t* skb = pgm_txw_alloc_skb (window, NULL, 1500);
+	fail_unless (window->slots == skb->pool, "alloc_skb not from slots");
+	struct pgm_sk_buff_t* held = pgm_skb_get (skb);
+	pgm_txw_add (window, fill_valid_skb (skb));
+	for (unsigned i = 1; i < 5; i++)
+		pgm_txw_add (window, fill_valid_skb (pgm_txw_alloc_skb (window, NULL, 1500)));
+	skb = pgm_txw_alloc_skb (window, NULL, 1500);
+	fail_unless (NULL == skb->pool, "alloc_skb re-used referenced slot");
+	pgm_free_skb (skb);
+/* larger than a slot */
+	skb = pgm_txw_alloc_skb (window, NULL, 9000);
+	fail_unless (NULL == skb->pool, "alloc_skb oversized from slots");
+	pgm_free_skb (skb);
+	pgm_txw_shutdown (window);
+/* ring outlives the window until the last reference is released */
+	pgm_free_skb (held);
+}
+END_TEST
+
 /* target:
  *	struct pgm_sk_buff_t*
  *	pgm_txw_peek (
@@ -312,7 +465,7 @@ END_TEST
 START_TEST (test_peek_pass_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	struct pgm_sk_buff_t* skb = generate_valid_skb ();
 	fail_if (NULL == skb, "generate_valid_skb failed");
@@ -334,13 +487,46 @@ END_TEST
 START_TEST (test_peek_fail_002)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	fail_unless (NULL == pgm_txw_peek (window, window->trail), "peek failed");
 	pgm_txw_shutdown (window);
 }
 END_TEST
 
+/* target:
+ *	struct pgm_sk_buff_t*
+ *	pgm_txw_peek_get (
+ *		pgm_txw_t* const	window,
+ *		const guint32		sequence
+ *		)
+ */
+
+START_TEST (test_peek_get_pass_001)
+{
+	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
+	fail_if (NULL == window, "create failed");
+	struct pgm_sk_buff_t* skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	pgm_txw_add (window, skb);
+	fail_unless (skb == pgm_txw_peek_get (window, window->trail), "peek_get failed");
+	fail_unless (2 == skb->users, "reference not taken");
+	fail_unless (0 == window->pinned, "pin not released");
+	fail_unless (NULL == pgm_txw_peek_get (window, window->lead + 1), "peek_get failed");
+	pgm_free_skb (skb);
+	pgm_txw_shutdown (window);
+}
+END_TEST
+
+/* null window */
+START_TEST (test_peek_get_fail_001)
+{
+	const struct pgm_sk_buff_t* skb = pgm_txw_peek_get (NULL, 0);
+	fail ("reached");
+}
+END_TEST
+
 /** inline function tests **/
 /* pgm_txw_max_length () 
  */
@@ -348,7 +534,7 @@ START_TEST (test_max_length_pass_001)
 {
 	const guint window_length = 100;
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, window_length, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, window_length, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	fail_unless (window_length == pgm_txw_max_length (window), "max_length failed");
 	pgm_txw_shutdown (window);
@@ -367,7 +553,7 @@ END_TEST
 START_TEST (test_length_pass_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	fail_unless (0 == pgm_txw_length (window), "length failed");
 	struct pgm_sk_buff_t* skb = generate_valid_skb ();
@@ -390,7 +576,7 @@ END_TEST
 START_TEST (test_size_pass_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	fail_unless (0 == pgm_txw_size (window), "size failed");
 	struct pgm_sk_buff_t* skb = generate_valid_skb ();
@@ -413,7 +599,7 @@ END_TEST
 START_TEST (test_is_empty_pass_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	fail_unless (pgm_txw_is_empty (window), "is_empty failed");
 	struct pgm_sk_buff_t* skb = generate_valid_skb ();
@@ -436,7 +622,7 @@ END_TEST
 START_TEST (test_is_full_pass_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 1, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 1, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	fail_if (pgm_txw_is_full (window), "is_full failed");
 	struct pgm_sk_buff_t* skb = generate_valid_skb ();
@@ -459,7 +645,7 @@ END_TEST
 START_TEST (test_lead_pass_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	guint32 lead = pgm_txw_lead (window);
 	struct pgm_sk_buff_t* skb = generate_valid_skb ();
@@ -483,7 +669,7 @@ START_TEST (test_next_lead_pass_001)
 {
 	const guint window_length = 100;
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, window_length, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, window_length, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	guint32 next_lead = pgm_txw_next_lead (window);
 	struct pgm_sk_buff_t* skb = generate_valid_skb ();
@@ -506,7 +692,7 @@ END_TEST
 START_TEST (test_trail_pass_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 1, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 1, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 /* does not advance with adding skb */
 	guint32 trail = pgm_txw_trail (window);
@@ -543,17 +729,22 @@ END_TEST
 START_TEST (test_retransmit_push_pass_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 /* empty window invalidates all requests */
 	fail_unless (FALSE == pgm_txw_retransmit_push (window, window->trail, FALSE, 0), "retransmit_push failed");
 	struct pgm_sk_buff_t* skb = generate_valid_skb ();
 	fail_if (NULL == skb, "generate_valid_skb failed");
 	pgm_txw_add (window, skb);
+/* beyond leading edge */
+	fail_unless (FALSE == pgm_txw_retransmit_push (window, window->lead + 1, FALSE, 0), "retransmit_push failed");
 /* first request */
 	fail_unless (TRUE == pgm_txw_retransmit_push (window, window->trail, FALSE, 0), "retransmit_push failed");
-/* second request eliminated */
+/* second request eliminated by the outstanding request bit */
 	fail_unless (FALSE == pgm_txw_retransmit_push (window, window->trail, FALSE, 0), "retransmit_push failed");
+	fail_unless (1 == window->nak_elimination_count, "request not eliminated");
+	fail_unless (skb == pgm_txw_retransmit_try_peek (window), "retransmit_try_peek failed");
+	fail_unless (1 == window->retransmit_queue.length, "unexpected queue length");
 	pgm_txw_shutdown (window);
 }
 END_TEST
@@ -575,7 +766,7 @@ END_TEST
 START_TEST (test_retransmit_try_peek_pass_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	struct pgm_sk_buff_t* skb = generate_valid_skb ();
 	fail_if (NULL == skb, "generate_valid_skb failed");
@@ -586,6 +777,77 @@ START_TEST (test_retransmit_try_peek_pass_001)
 }
 END_TEST
 
+/* repeated parity request of a transmission group served from the parity cache */
+START_TEST (test_retransmit_try_peek_pass_002)
+{
+	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	pgm_txw_t* window = pgm_txw_create (&tsi, 1500, 100, 0, 0, TRUE, 5, 4, 64 * 1024);
+	fail_if (NULL == window, "create failed");
+	for (unsigned i = 0; i < 4; i++) {
+		struct pgm_sk_buff_t* skb = generate_valid_skb ();
+		fail_if (NULL == skb, "generate_valid_skb failed");
+		pgm_txw_add (window, skb);
+	}
+	fail_unless (TRUE == pgm_txw_retransmit_push (window, window->trail, TRUE, window->tg_sqn_shift), "retransmit_push failed");
+	struct pgm_sk_buff_t* parity = pgm_txw_retransmit_try_peek (window);
+	fail_if (NULL == parity, "retransmit_try_peek failed");
+	pgm_txw_retransmit_remove_head (window);
+	fail_unless (0 == window->parity_cache_hits, "unexpected cache hit");
+	fail_unless (1 == window->parity_cache_misses, "unexpected cache miss count");
+	fail_unless (TRUE == pgm_txw_retransmit_push (window, window->trail, TRUE, window->tg_sqn_shift), "retransmit_push failed");
+	fail_unless (parity == pgm_txw_retransmit_try_peek (window), "parity not cached");
+	pgm_txw_retransmit_remove_head (window);
+	fail_unless (1 == window->parity_cache_hits, "unexpected cache hit count");
+	pgm_txw_shutdown (window);
+}
+END_TEST
+
+/* request for a packet that left the window before the repair path */
+START_TEST (test_retransmit_try_peek_pass_003)
+{
+	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 2, 0, 0, FALSE, 0, 0, 0);
+	fail_if (NULL == window, "create failed");
+	for (unsigned i = 0; i < 2; i++) {
+		struct pgm_sk_buff_t* skb = generate_valid_skb ();
+		fail_if (NULL == skb, "generate_valid_skb failed");
+		pgm_txw_add (window, skb);
+	}
+	fail_unless (TRUE == pgm_txw_retransmit_push (window, window->trail, FALSE, 0), "retransmit_push failed");
+	fail_if (NULL == pgm_txw_retransmit_try_peek (window), "retransmit_try_peek failed");
+/* advance trail past the queued request */
+	struct pgm_sk_buff_t* skb = generate_valid_skb ();
+	fail_if (NULL == skb, "generate_valid_skb failed");
+	pgm_txw_add (window, skb);
+	fail_unless (NULL == pgm_txw_retransmit_try_peek (window), "retransmit_try_peek failed");
+	fail_unless (pgm_txw_retransmit_is_empty (window), "retransmit queue not empty");
+	pgm_txw_shutdown (window);
+}
+END_TEST
+
+/* outstanding requests served oldest first regardless of arrival order */
+START_TEST (test_retransmit_try_peek_pass_004)
+{
+	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
+	fail_if (NULL == window, "create failed");
+	struct pgm_sk_buff_t* skbs[ 3 ];
+	for (unsigned i = 0; i < G_N_ELEMENTS(skbs); i++) {
+		skbs[i] = generate_valid_skb ();
+		fail_if (NULL == skbs[i], "generate_valid_skb failed");
+		pgm_txw_add (window, skbs[i]);
+	}
+	fail_unless (TRUE == pgm_txw_retransmit_push (window, window->trail + 2, FALSE, 0), "retransmit_push failed");
+	fail_unless (TRUE == pgm_txw_retransmit_push (window, window->trail, FALSE, 0), "retransmit_push failed");
+	fail_unless (skbs[0] == pgm_txw_retransmit_try_peek (window), "retransmit_try_peek failed");
+	pgm_txw_retransmit_remove_head (window);
+	fail_unless (skbs[2] == pgm_txw_retransmit_try_peek (window), "retransmit_try_peek failed");
+	pgm_txw_retransmit_remove_head (window);
+	fail_unless (pgm_txw_retransmit_is_empty (window), "retransmit queue not empty");
+	pgm_txw_shutdown (window);
+}
+END_TEST
+
 /* null window */
 START_TEST (test_retransmit_try_peek_fail_001)
 {
@@ -594,6 +856,92 @@ START_TEST (test_retransmit_try_peek_fail_001)
 }
 END_TEST
 
+/* target:
+ *	unsigned
+ *	pgm_txw_retransmit_try_peekv (
+ *		pgm_txw_t* const		window,
+ *		struct pgm_sk_buff_t**const	skbs,
+ *		const unsigned			count
+ *		)
+ */
+
+START_TEST (test_retransmit_try_peekv_pass_001)
+{
+	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
+	fail_if (NULL == window, "create failed");
+	for (unsigned i = 0; i < 3; i++) {
+		struct pgm_sk_buff_t* skb = generate_valid_skb ();
+		fail_if (NULL == skb, "generate_valid_skb failed");
+		pgm_txw_add (window, skb);
+	}
+	fail_unless (1 == pgm_txw_retransmit_push (window, window->trail, FALSE, 0), "retransmit_push failed");
+	fail_unless (1 == pgm_txw_retransmit_push (window, window->trail + 1, FALSE, 0), "retransmit_push failed");
+	struct pgm_sk_buff_t* skbs[ 3 ];
+	fail_unless (2 == pgm_txw_retransmit_try_peekv (window, skbs, G_N_ELEMENTS(skbs)), "retransmit_try_peekv failed");
+	fail_unless (window->trail == skbs[0]->sequence, "unexpected sequence");
+	fail_unless (window->trail + 1 == skbs[1]->sequence, "unexpected sequence");
+	fail_unless (1 == pgm_txw_retransmit_try_peekv (window, skbs, 1), "retransmit_try_peekv failed");
+	pgm_txw_shutdown (window);
+}
+END_TEST
+
+/* null window */
+START_TEST (test_retransmit_try_peekv_fail_001)
+{
+	struct pgm_sk_buff_t* skbs[ 1 ];
+	const unsigned count = pgm_txw_retransmit_try_peekv (NULL, skbs, G_N_ELEMENTS(skbs));
+	fail ("reached");
+}
+END_TEST
+
+/* target:
+ *	void
+ *	pgm_txw_parity_encode (
+ *		pgm_txw_t* const			window,
+ *		struct pgm_sk_buff_t*const*const	odata_skbs,
+ *		const uint8_t				rs_h,
+ *		const uint8_t				count,
+ *		struct pgm_sk_buff_t*const*const	parity_skbs
+ *		)
+ */
+
+START_TEST (test_parity_encode_pass_001)
+{
+	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
+	pgm_txw_t* window = pgm_txw_create (&tsi, 1500, 100, 0, 0, TRUE, 255, 4, 0);
+	fail_if (NULL == window, "create failed");
+	struct pgm_sk_buff_t* odata_skbs[ 4 ];
+	for (unsigned i = 0; i < G_N_ELEMENTS(odata_skbs); i++) {
+		struct pgm_sk_buff_t* skb = generate_valid_skb ();
+		fail_if (NULL == skb, "generate_valid_skb failed");
+		pgm_txw_add (window, skb);
+		odata_skbs[i] = skb;
+	}
+	struct pgm_sk_buff_t* parity_skbs[ 2 ];
+	for (unsigned j = 0; j < G_N_ELEMENTS(parity_skbs); j++)
+		parity_skbs[j] = pgm_alloc_skb (1500);
+	pgm_txw_parity_encode (window, odata_skbs, 1, G_N_ELEMENTS(parity_skbs), parity_skbs);
+	for (unsigned j = 0; j < G_N_ELEMENTS(parity_skbs); j++) {
+		fail_unless (PGM_OPT_PARITY & parity_skbs[j]->pgm_header->pgm_options, "parity option not set");
+		fail_unless ((window->trail | (1 + j)) == g_ntohl (parity_skbs[j]->pgm_data->data_sqn), "unexpected sequence");
+		fail_unless (1000 == g_ntohs (parity_skbs[j]->pgm_header->pgm_tsdu_length), "unexpected tsdu length");
+		pgm_free_skb (parity_skbs[j]);
+	}
+	pgm_txw_shutdown (window);
+}
+END_TEST
+
+/* null window */
+START_TEST (test_parity_encode_fail_001)
+{
+	struct pgm_sk_buff_t* odata_skbs[ 4 ];
+	struct pgm_sk_buff_t* parity_skbs[ 1 ];
+	pgm_txw_parity_encode (NULL, odata_skbs, 0, G_N_ELEMENTS(parity_skbs), parity_skbs);
+	fail ("reached");
+}
+END_TEST
+
 /* target:
  *	void
  *	pgm_txw_retransmit_remove_head (
@@ -604,7 +952,7 @@ END_TEST
 START_TEST (test_retransmit_remove_head_pass_001)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	struct pgm_sk_buff_t* skb = generate_valid_skb ();
 	fail_if (NULL == skb, "generate_valid_skb failed");
@@ -628,7 +976,7 @@ END_TEST
 START_TEST (test_retransmit_remove_head_fail_002)
 {
 	const pgm_tsi_t tsi = { { 1, 2, 3, 4, 5, 6 }, 1000 };
-	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0);
+	pgm_txw_t* window = pgm_txw_create (&tsi, 0, 100, 0, 0, FALSE, 0, 0, 0);
 	fail_if (NULL == window, "create failed");
 	pgm_txw_retransmit_remove_head (window);
 	fail ("reached");
@@ -666,12 +1014,18 @@ make_test_suite (void)
 	TCase* tc_add = tcase_create ("add");
 	suite_add_tcase (s, tc_add);
 	tcase_add_test (tc_add, test_add_pass_001);
+	tcase_add_test (tc_add, test_add_pass_002);
 #ifndef PGM_CHECK_NOFORK
 	tcase_add_test_raise_signal (tc_add, test_add_fail_001, SIGABRT);
 	tcase_add_test_raise_signal (tc_add, test_add_fail_002, SIGABRT);
 	tcase_add_test_raise_signal (tc_add, test_add_fail_003, SIGABRT);
 #endif
 
+	TCase* tc_alloc_skb = tcase_create ("alloc-skb");
+	suite_add_tcase (s, tc_alloc_skb);
+	tcase_add_test (tc_alloc_skb, test_alloc_skb_pass_001);
+	tcase_add_test (tc_alloc_skb, test_alloc_skb_pass_002);
+
 	TCase* tc_peek = tcase_create ("peek");
 	suite_add_tcase (s, tc_peek);
 	tcase_add_test (tc_peek, test_peek_pass_001);
@@ -681,6 +1035,13 @@ make_test_suite (void)
 /* logical not fatal errors */
 	tcase_add_test (tc_peek, test_peek_fail_002);
 
+	TCase* tc_peek_get = tcase_create ("peek-get");
+	suite_add_tcase (s, tc_peek_get);
+	tcase_add_test (tc_peek_get, test_peek_get_pass_001);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_peek_get, test_peek_get_fail_001, SIGABRT);
+#endif
+
 	TCase* tc_max_length = tcase_create ("max-length");
 	suite_add_tcase (s, tc_max_length);
 	tcase_add_test (tc_max_length, test_max_length_pass_001);
@@ -746,10 +1107,27 @@ make_test_suite (void)
 	TCase* tc_retransmit_try_peek = tcase_create ("retransmit-try-peek");
 	suite_add_tcase (s, tc_retransmit_try_peek);
 	tcase_add_test (tc_retransmit_try_peek, test_retransmit_try_peek_pass_001);
+	tcase_add_test (tc_retransmit_try_peek, test_retransmit_try_peek_pass_002);
+	tcase_add_test (tc_retransmit_try_peek, test_retransmit_try_peek_pass_003);
+	tcase_add_test (tc_retransmit_try_peek, test_retransmit_try_peek_pass_004);
 #ifndef PGM_CHECK_NOFORK
 	tcase_add_test_raise_signal (tc_retransmit_try_peek, test_retransmit_try_peek_fail_001, SIGABRT);
 #endif
 
+	TCase* tc_retransmit_try_peekv = tcase_create ("retransmit-try-peekv");
+	suite_add_tcase (s, tc_retransmit_try_peekv);
+	tcase_add_test (tc_retransmit_try_peekv, test_retransmit_try_peekv_pass_001);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_retransmit_try_peekv, test_retransmit_try_peekv_fail_001, SIGABRT);
+#endif
+
+	TCase* tc_parity_encode = tcase_create ("parity-encode");
+	suite_add_tcase (s, tc_parity_encode);
+	tcase_add_test (tc_parity_encode, test_parity_encode_pass_001);
+#ifndef PGM_CHECK_NOFORK
+	tcase_add_test_raise_signal (tc_parity_encode, test_parity_encode_fail_001, SIGABRT);
+#endif
+
 	TCase* tc_retransmit_remove_head = tcase_create ("retransmit-remove-head");
 	suite_add_tcase (s, tc_retransmit_remove_head);
 	tcase_add_test (tc_retransmit_remove_head, test_retransmit_remove_head_pass_001);
@@ -0,0 +1,649 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * io_uring packet I/O: multishot receive into a provided buffer ring of
+ * packet buffers and batched asynchronous transmit.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#ifdef HAVE_LINUX_IO_URING_H
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/socket.h>
+#	include <sys/syscall.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/uring.h>
+
+
+//#define URING_DEBUG
+
+#ifndef URING_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+#ifdef PGM_HAVE_IO_URING
+
+/* user_data tags of receive ring submissions */
+#define PGM_URING_RECV_TAG	0
+#define PGM_URING_CANCEL_TAG	1
+
+/* one in-flight datagram of the transmit ring */
+struct pgm_uring_send_t {
+	struct msghdr			msg;
+	struct iovec			iov;
+	struct sockaddr_storage		to;
+	struct pgm_sk_buff_t*		skb;		/* reference held until completion */
+};
+
+static inline
+int
+uring_setup (
+	const unsigned			entries,
+	struct io_uring_params*		params
+	)
+{
+	return (int)syscall (__NR_io_uring_setup, entries, params);
+}
+
+static inline
+int
+uring_enter (
+	const int			fd,
+	const unsigned			to_submit,
+	const unsigned			min_complete,
+	const unsigned			flags
+	)
+{
+	return (int)syscall (__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static inline
+int
+uring_register (
+	const int			fd,
+	const unsigned			opcode,
+	void*				arg,
+	const unsigned			nr_args
+	)
+{
+	return (int)syscall (__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/* create a ring of entries submission slots and cq_entries completion slots.
+ *
+ * returns TRUE on success, returns FALSE on error and sets errno.
+ */
+
+static
+bool
+ring_create (
+	struct pgm_uring_ring_t*	ring,
+	const unsigned			entries,
+	const unsigned			cq_entries
+	)
+{
+	struct io_uring_params p;
+	memset (&p, 0, sizeof(p));
+	p.flags		= IORING_SETUP_CQSIZE;
+	p.cq_entries	= cq_entries;
+	ring->fd = uring_setup (entries, &p);
+	if (ring->fd < 0) {
+		ring->fd = INVALID_SOCKET;
+		return FALSE;
+	}
+/* Linux 5.4 */
+	if (!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+		errno = ENOSYS;
+		return FALSE;
+	}
+
+	const size_t sq_len = p.sq_off.array + (p.sq_entries * sizeof(uint32_t));
+	const size_t cq_len = p.cq_off.cqes + (p.cq_entries * sizeof(struct io_uring_cqe));
+	ring->ring_map_len = MAX(sq_len, cq_len);
+	ring->ring_map = mmap (NULL, ring->ring_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (MAP_FAILED == ring->ring_map) {
+		ring->ring_map = NULL;
+		return FALSE;
+	}
+	ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap (NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (MAP_FAILED == ring->sqes) {
+		ring->sqes = NULL;
+		return FALSE;
+	}
+
+	char* map = ring->ring_map;
+	ring->sq_head	= (uint32_t*)(map + p.sq_off.head);
+	ring->sq_tail	= (uint32_t*)(map + p.sq_off.tail);
+	ring->sq_array	= (uint32_t*)(map + p.sq_off.array);
+	ring->sq_mask	= *(uint32_t*)(map + p.sq_off.ring_mask);
+	ring->cq_head	= (uint32_t*)(map + p.cq_off.head);
+	ring->cq_tail	= (uint32_t*)(map + p.cq_off.tail);
+	ring->cq_mask	= *(uint32_t*)(map + p.cq_off.ring_mask);
+	ring->cqes	= (struct io_uring_cqe*)(map + p.cq_off.cqes);
+	ring->pending	= 0;
+	return TRUE;
+}
+
+static
+void
+ring_destroy (
+	struct pgm_uring_ring_t*	ring
+	)
+{
+	if (NULL != ring->sqes) {
+		munmap (ring->sqes, ring->sqes_len);
+		ring->sqes = NULL;
+	}
+	if (NULL != ring->ring_map) {
+		munmap (ring->ring_map, ring->ring_map_len);
+		ring->ring_map = NULL;
+	}
+	if (INVALID_SOCKET != ring->fd) {
+		close (ring->fd);
+		ring->fd = INVALID_SOCKET;
+	}
+}
+
+/* next free submission entry, published to the kernel by ring_submit().
+ *
+ * returns NULL when the submission queue is full.
+ */
+
+static
+struct io_uring_sqe*
+ring_get_sqe (
+	struct pgm_uring_ring_t*	ring
+	)
+{
+	const uint32_t tail = *ring->sq_tail;
+	if (tail - __atomic_load_n (ring->sq_head, __ATOMIC_ACQUIRE) > ring->sq_mask)
+		return NULL;
+	const uint32_t index = tail & ring->sq_mask;
+	ring->sq_array[ index ] = index;
+	struct io_uring_sqe* sqe = &ring->sqes[ index ];
+	memset (sqe, 0, sizeof(struct io_uring_sqe));
+	__atomic_store_n (ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	ring->pending++;
+	return sqe;
+}
+
+/* submit prepared entries, optionally waiting for min_complete completions.
+ *
+ * returns number of entries submitted, or -1 with errno on error.
+ */
+
+static
+int
+ring_submit (
+	struct pgm_uring_ring_t*	ring,
+	const unsigned			min_complete
+	)
+{
+	int submitted;
+	do {
+		submitted = uring_enter (ring->fd, ring->pending, min_complete, min_complete ? IORING_ENTER_GETEVENTS : 0);
+	} while (submitted < 0 && EINTR == errno);
+	if (submitted > 0)
+		ring->pending -= submitted;
+	return submitted;
+}
+
+static
+bool
+ring_peek_cqe (
+	struct pgm_uring_ring_t*	ring,
+	struct io_uring_cqe*		cqe
+	)
+{
+	const uint32_t head = *ring->cq_head;
+	if (head == __atomic_load_n (ring->cq_tail, __ATOMIC_ACQUIRE))
+		return FALSE;
+	*cqe = ring->cqes[ head & ring->cq_mask ];
+	__atomic_store_n (ring->cq_head, head + 1, __ATOMIC_RELEASE);
+	return TRUE;
+}
+
+/* return a packet buffer to the kernel under buffer id bid */
+
+static
+void
+uring_provide (
+	struct pgm_uring_t*	uring,
+	struct pgm_sk_buff_t*	skb,
+	const uint16_t		bid
+	)
+{
+	struct io_uring_buf* buf = &uring->br->bufs[ uring->br_tail & (uring->entries - 1) ];
+	buf->addr	= (uintptr_t)skb->head;
+	buf->len	= uring->buffer_len;
+	buf->bid	= bid;
+	uring->rx_skb[ bid ] = skb;
+	__atomic_store_n (&uring->br->tail, ++uring->br_tail, __ATOMIC_RELEASE);
+}
+
+/* queue the multishot receive, re-armed whenever the kernel terminates it.
+ *
+ * returns TRUE on success, returns FALSE on error and sets errno.
+ */
+
+static
+bool
+uring_arm (
+	pgm_sock_t*		sock
+	)
+{
+	struct pgm_uring_t* uring = sock->uring;
+	struct io_uring_sqe* sqe = ring_get_sqe (&uring->rx);
+	if (NULL == sqe) {
+		errno = EBUSY;
+		return FALSE;
+	}
+	sqe->opcode	= IORING_OP_RECVMSG;
+	sqe->fd		= sock->recv_sock;
+	sqe->addr	= (uintptr_t)&uring->recv_msg;
+	sqe->len	= 1;
+	sqe->ioprio	= IORING_RECV_MULTISHOT;
+	sqe->flags	= IOSQE_BUFFER_SELECT;
+	sqe->buf_group	= 0;
+	sqe->user_data	= PGM_URING_RECV_TAG;
+	if (ring_submit (&uring->rx, 0) < 0)
+		return FALSE;
+	uring->is_armed = TRUE;
+	return TRUE;
+}
+
+/* release completed transmissions, caller holds tx_mutex */
+
+static
+void
+uring_reap_sends (
+	struct pgm_uring_t*	uring
+	)
+{
+	struct io_uring_cqe cqe;
+	while (ring_peek_cqe (&uring->tx, &cqe)) {
+		struct pgm_uring_send_t* slot = &uring->tx_slot[ cqe.user_data ];
+		if (PGM_UNLIKELY(cqe.res < 0)) {
+			char errbuf[1024];
+			pgm_trace (PGM_LOG_ROLE_NETWORK,_("sendmsg completion failed: %s"),
+				   pgm_strerror_s (errbuf, sizeof (errbuf), -cqe.res));
+		}
+		pgm_free_skb (slot->skb);
+		slot->skb = NULL;
+		uring->tx_free[ uring->tx_free_len++ ] = (unsigned)cqe.user_data;
+	}
+}
+#endif /* PGM_HAVE_IO_URING */
+
+/* receive buffer length, including io_uring recvmsg headroom when enabled.
+ * Called from pgm_bind() to size the packet buffer pool.
+ */
+
+uint16_t
+pgm_uring_buffer_len (
+	const pgm_sock_t* const	sock
+	)
+{
+#ifdef PGM_HAVE_IO_URING
+	if (sock->uring_entries > 0 &&
+	    (size_t)sock->max_tpdu + PGM_URING_RECV_HEADROOM <= UINT16_MAX)
+		return (uint16_t)(sock->max_tpdu + PGM_URING_RECV_HEADROOM);
+#endif
+	return sock->max_tpdu;
+}
+
+/* create receive and transmit rings and arm the multishot receive, called
+ * from pgm_bind() after sockets are bound.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error appropriately.
+ */
+
+bool
+pgm_uring_open (
+	pgm_sock_t*    const restrict sock,
+	pgm_error_t**	     restrict error
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL == sock->uring);
+	pgm_assert (sock->uring_entries > 0);
+	pgm_assert_cmpuint (sock->uring_entries, <=, PGM_URING_ENTRIES_MAX);
+
+#ifdef PGM_HAVE_IO_URING
+	char errbuf[1024];
+	int save_errno;
+	const char* what;
+
+	if (pgm_uring_buffer_len (sock) == sock->max_tpdu) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Maximum TPDU %u leaves no room for io_uring receive headroom."),
+			       (unsigned)sock->max_tpdu);
+		return FALSE;
+	}
+
+	const unsigned n = sock->uring_entries;
+	struct pgm_uring_t* uring = pgm_new0 (struct pgm_uring_t, 1);
+	uring->entries		= n;
+	uring->buffer_len	= pgm_uring_buffer_len (sock);
+	uring->rx.fd		= INVALID_SOCKET;
+	uring->tx.fd		= INVALID_SOCKET;
+	pgm_mutex_init (&uring->tx_mutex);
+	sock->uring		= uring;
+
+/* completion queue sized for every provided buffer plus the cancellation */
+	what = "io_uring_setup";
+	if (!ring_create (&uring->rx, 2, 2 * n) ||
+	    !ring_create (&uring->tx, n, 2 * n))
+		goto err_errno;
+
+	uring->br_len = n * sizeof(struct io_uring_buf);
+	uring->br = mmap (NULL, uring->br_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	what = "mmap";
+	if (MAP_FAILED == uring->br) {
+		uring->br = NULL;
+		goto err_errno;
+	}
+	struct io_uring_buf_reg reg;
+	memset (&reg, 0, sizeof(reg));
+	reg.ring_addr		= (uintptr_t)uring->br;
+	reg.ring_entries	= n;
+	reg.bgid		= 0;
+	what = "IORING_REGISTER_PBUF_RING";
+	if (uring_register (uring->rx.fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+		goto err_errno;
+
+	uring->rx_skb = pgm_new0 (struct pgm_sk_buff_t*, n);
+	for (unsigned i = 0; i < n; i++)
+		uring_provide (uring, pgm_skb_pool_alloc (sock->skb_pool, uring->buffer_len), (uint16_t)i);
+
+/* only the reserved lengths are read by a multishot receive */
+	uring->recv_msg.msg_namelen	= sizeof(struct sockaddr_storage);
+	uring->recv_msg.msg_controllen	= PGM_URING_AUXLEN;
+
+	uring->tx_slot	= pgm_new0 (struct pgm_uring_send_t, n);
+	uring->tx_free	= pgm_new (unsigned, n);
+	for (unsigned i = 0; i < n; i++)
+		uring->tx_free[ i ] = n - 1 - i;
+	uring->tx_free_len = n;
+
+	what = "multishot recvmsg";
+	if (!uring_arm (sock))
+		goto err_errno;
+
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("Using io_uring with %u provided receive buffers."), n);
+	return TRUE;
+
+err_errno:
+	save_errno = errno;
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       pgm_error_from_errno (save_errno),
+		       _("io_uring %s: %s"),
+		       what,
+		       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+	pgm_uring_close (sock);
+	return FALSE;
+#else
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       PGM_ERROR_NOSYS,
+		       _("io_uring unavailable on this platform."));
+	return FALSE;
+#endif /* PGM_HAVE_IO_URING */
+}
+
+/* cancel the multishot receive and wait for outstanding transmissions
+ * before releasing buffers referenced by the kernel.
+ */
+
+void
+pgm_uring_close (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+#ifdef PGM_HAVE_IO_URING
+	struct pgm_uring_t* uring = sock->uring;
+	if (NULL == uring)
+		return;
+
+	if (uring->is_armed) {
+		struct io_uring_sqe* sqe = ring_get_sqe (&uring->rx);
+		if (NULL != sqe) {
+			sqe->opcode	= IORING_OP_ASYNC_CANCEL;
+			sqe->addr	= PGM_URING_RECV_TAG;
+			sqe->user_data	= PGM_URING_CANCEL_TAG;
+		}
+/* final receive completion is posted without IORING_CQE_F_MORE */
+		while (uring->is_armed && ring_submit (&uring->rx, 1) >= 0) {
+			struct io_uring_cqe cqe;
+			while (ring_peek_cqe (&uring->rx, &cqe))
+				if (PGM_URING_RECV_TAG == cqe.user_data && !(cqe.flags & IORING_CQE_F_MORE))
+					uring->is_armed = FALSE;
+		}
+	}
+	if (NULL != uring->tx_slot) {
+		pgm_mutex_lock (&uring->tx_mutex);
+		uring_reap_sends (uring);
+		while (uring->tx_free_len < uring->entries && ring_submit (&uring->tx, 1) >= 0)
+			uring_reap_sends (uring);
+		pgm_mutex_unlock (&uring->tx_mutex);
+		pgm_free (uring->tx_free);
+		pgm_free (uring->tx_slot);
+	}
+	ring_destroy (&uring->tx);
+	ring_destroy (&uring->rx);
+	if (NULL != uring->rx_skb) {
+		for (unsigned i = 0; i < uring->entries; i++)
+			if (NULL != uring->rx_skb[ i ])
+				pgm_free_skb (uring->rx_skb[ i ]);
+		pgm_free (uring->rx_skb);
+	}
+	if (NULL != uring->br)
+		munmap (uring->br, uring->br_len);
+	pgm_mutex_free (&uring->tx_mutex);
+	pgm_free (uring);
+	sock->uring = NULL;
+#endif
+}
+
+#ifdef PGM_HAVE_IO_URING
+/* read the next datagram of the multishot receive.  The filled buffer is
+ * exchanged with the shard receive buffer as per recvmmskb(), the previous buffer
+ * replaces it in the provided buffer ring.  Control messages are returned in
+ * ctl for destination address extraction.
+ *
+ * on success returns packet length, on empty completion queue returns -1 with
+ * EAGAIN, on error returns -1.
+ */
+
+ssize_t
+pgm_uring_recvskb (
+	pgm_sock_t*           const restrict sock,
+	struct sockaddr*      const restrict src_addr,
+	const socklen_t			     src_addrlen,
+	struct msghdr*	      const restrict ctl
+	)
+{
+	struct pgm_uring_t* uring = sock->uring;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != uring);
+	pgm_assert (NULL != src_addr);
+	pgm_assert (src_addrlen > 0);
+	pgm_assert (NULL != ctl);
+
+	if (PGM_UNLIKELY(sock->is_destroyed))
+		return 0;
+
+	const size_t headroom = sizeof(struct io_uring_recvmsg_out) + uring->recv_msg.msg_namelen + uring->recv_msg.msg_controllen;
+	for (;;)
+	{
+		struct io_uring_cqe cqe;
+		if (!uring->is_armed && !uring_arm (sock))
+			return SOCKET_ERROR;
+		if (!ring_peek_cqe (&uring->rx, &cqe)) {
+			pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+			return SOCKET_ERROR;
+		}
+		if (PGM_URING_RECV_TAG != cqe.user_data)
+			continue;
+		if (!(cqe.flags & IORING_CQE_F_MORE))
+			uring->is_armed = FALSE;
+		if (cqe.res < 0) {
+/* provided buffers exhausted, re-armed on next read */
+			if (-ENOBUFS == cqe.res)
+				continue;
+			pgm_set_last_sock_error (-cqe.res);
+			return SOCKET_ERROR;
+		}
+		if (!(cqe.flags & IORING_CQE_F_BUFFER))
+			continue;
+
+		const uint16_t bid = (uint16_t)(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+		struct pgm_sk_buff_t* skb = uring->rx_skb[ bid ];
+		if (PGM_UNLIKELY((size_t)cqe.res < headroom)) {
+			uring_provide (uring, skb, bid);
+			continue;
+		}
+
+		const struct io_uring_recvmsg_out* out = skb->head;
+		char* name	= (char*)(out + 1);
+		char* control	= name + uring->recv_msg.msg_namelen;
+		char* payload	= control + uring->recv_msg.msg_controllen;
+		size_t len = MIN((size_t)out->payloadlen, (size_t)cqe.res - headroom);
+		len = MIN(len, sock->max_tpdu);
+
+/* replace with the previous receive buffer when large enough */
+		struct pgm_sk_buff_t* old = sock->rx_shard->rx_buffer;
+		sock->rx_shard->rx_buffer = skb;
+		if (old->truesize - sizeof(struct pgm_sk_buff_t) < uring->buffer_len) {
+			pgm_free_skb (old);
+			old = pgm_skb_pool_alloc (sock->skb_pool, uring->buffer_len);
+		}
+		uring_provide (uring, old, bid);
+
+		memcpy (src_addr, name, MIN(src_addrlen, out->namelen));
+		memset (ctl, 0, sizeof(struct msghdr));
+		ctl->msg_control	= control;
+		ctl->msg_controllen	= MIN(out->controllen, PGM_URING_AUXLEN);
+
+		skb->sock		= sock;
+		skb->tstamp		= pgm_time_coarse_now();
+		skb->rx_tstamp		= 0;
+		skb->data		= payload;
+		skb->len		= (uint16_t)len;
+		skb->zero_padded	= 0;
+		skb->tail		= (char*)skb->data + len;
+		if (0 == len)
+			continue;
+		return len;
+	}
+}
+
+/* queue a vector of packets to one destination as individual sendmsg
+ * submissions with one io_uring_enter() call.  References to each packet are
+ * held until completion.  Blocking sockets wait for a completion when all
+ * slots are in flight.
+ *
+ * on success, returns number of packets queued.  on error, -1 is returned
+ * and errno set appropriately.
+ */
+
+int
+pgm_uring_sendv (
+	pgm_sock_t*	       const restrict sock,
+	const bool			      use_router_alert,
+	struct pgm_sk_buff_t*const* const restrict skbs,
+	const unsigned			      count,
+	const struct sockaddr* const restrict to,
+	const socklen_t			      tolen
+	)
+{
+	struct pgm_uring_t* uring = sock->uring;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != uring);
+	pgm_assert (NULL != skbs);
+	pgm_assert (count > 0);
+	pgm_assert (NULL != to);
+	pgm_assert (tolen <= sizeof(struct sockaddr_storage));
+
+	const SOCKET send_sock = use_router_alert ? sock->send_with_router_alert_sock : sock->send_sock;
+	unsigned i;
+
+	pgm_mutex_lock (&uring->tx_mutex);
+	uring_reap_sends (uring);
+	for (i = 0; i < count; i++)
+	{
+		if (0 == uring->tx_free_len) {
+			if (ring_submit (&uring->tx, sock->is_nonblocking ? 0 : 1) < 0)
+				break;
+			uring_reap_sends (uring);
+			if (0 == uring->tx_free_len)
+				break;
+		}
+		const unsigned index = uring->tx_free[ --uring->tx_free_len ];
+		struct pgm_uring_send_t* slot = &uring->tx_slot[ index ];
+		memcpy (&slot->to, to, tolen);
+		slot->skb		= pgm_skb_get (skbs[i]);
+		slot->iov.iov_base	= skbs[i]->head;
+		slot->iov.iov_len	= (char*)skbs[i]->tail - (char*)skbs[i]->head;
+		memset (&slot->msg, 0, sizeof(struct msghdr));
+		slot->msg.msg_name	= &slot->to;
+		slot->msg.msg_namelen	= tolen;
+		slot->msg.msg_iov	= &slot->iov;
+		slot->msg.msg_iovlen	= 1;
+
+/* one submission slot per transmit slot, cannot be full */
+		struct io_uring_sqe* sqe = ring_get_sqe (&uring->tx);
+		pgm_assert (NULL != sqe);
+		sqe->opcode	= IORING_OP_SENDMSG;
+		sqe->fd		= send_sock;
+		sqe->addr	= (uintptr_t)&slot->msg;
+		sqe->len	= 1;
+		sqe->user_data	= index;
+	}
+	if (uring->tx.pending > 0)
+		ring_submit (&uring->tx, 0);
+	pgm_mutex_unlock (&uring->tx_mutex);
+
+	if (0 == i) {
+		pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+		return -1;
+	}
+	return (int)i;
+}
+#endif /* PGM_HAVE_IO_URING */
+
+/* eof */
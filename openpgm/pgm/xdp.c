@@ -0,0 +1,642 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * AF_XDP packet I/O: receive and transmit rings over a shared UMEM region
+ * bypassing the kernel network stack for multicast traffic.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#ifdef HAVE_LINUX_IF_XDP_H
+#	include <unistd.h>
+#	include <sys/ioctl.h>
+#	include <sys/mman.h>
+#	include <sys/socket.h>
+#	include <sys/syscall.h>
+#	include <net/if.h>
+#	include <net/ethernet.h>
+#	include <netinet/in.h>
+#	include <linux/bpf.h>
+#	include <linux/if_xdp.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/xdp.h>
+
+
+//#define XDP_DEBUG
+
+#ifndef XDP_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+#ifdef HAVE_LINUX_IF_XDP_H
+
+#ifndef SOL_XDP
+#	define SOL_XDP			283
+#endif
+
+/* largest link, network and transport headers prepended on transmit */
+#define PGM_XDP_HEADROOM	(sizeof(struct ether_header) + sizeof(struct pgm_ip) + 4 + sizeof(struct pgm_udphdr))
+
+/* ring indices are shared with the kernel: producer and consumer updates
+ * publish descriptor contents and must be ordered.
+ */
+
+static inline
+uint32_t
+ring_load (
+	const uint32_t*		p
+	)
+{
+	return __atomic_load_n (p, __ATOMIC_ACQUIRE);
+}
+
+static inline
+void
+ring_store (
+	uint32_t*		p,
+	const uint32_t		v
+	)
+{
+	__atomic_store_n (p, v, __ATOMIC_RELEASE);
+}
+
+static inline
+bool
+ring_needs_wakeup (
+	const struct pgm_xdp_ring_t*	ring
+	)
+{
+	return (0 != (__atomic_load_n (ring->flags, __ATOMIC_RELAXED) & XDP_RING_NEED_WAKEUP));
+}
+
+/* map one of the four rings into user space.
+ *
+ * returns TRUE on success, returns FALSE on error and sets errno.
+ */
+
+static
+bool
+ring_map (
+	const SOCKET			     fd,
+	struct pgm_xdp_ring_t*	    restrict ring,
+	const struct xdp_ring_offset* restrict off,
+	const size_t			     desc_len,
+	const off_t			     pgoff
+	)
+{
+	ring->map_len	= off->desc + (PGM_XDP_RING_SIZE * desc_len);
+	ring->map	= mmap (NULL, ring->map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, pgoff);
+	if (MAP_FAILED == ring->map) {
+		ring->map = NULL;
+		return FALSE;
+	}
+	ring->producer	= (uint32_t*)((char*)ring->map + off->producer);
+	ring->consumer	= (uint32_t*)((char*)ring->map + off->consumer);
+	ring->flags	= (uint32_t*)((char*)ring->map + off->flags);
+	ring->ring	= (char*)ring->map + off->desc;
+	ring->mask	= PGM_XDP_RING_SIZE - 1;
+	ring->cached_prod = *ring->producer;
+	ring->cached_cons = *ring->consumer;
+	return TRUE;
+}
+
+static
+void
+ring_unmap (
+	struct pgm_xdp_ring_t*	ring
+	)
+{
+	if (NULL != ring->map) {
+		munmap (ring->map, ring->map_len);
+		ring->map = NULL;
+	}
+}
+
+/* return completed transmit frames to the idle stack, caller holds tx_lock.
+ */
+
+static
+void
+xdp_reclaim (
+	struct pgm_xdp_t*	xdp
+	)
+{
+	uint32_t cons = xdp->comp.cached_cons;
+	const uint32_t prod = ring_load (xdp->comp.producer);
+	if (cons == prod)
+		return;
+	const uint64_t* addrs = xdp->comp.ring;
+	while (cons != prod)
+		xdp->tx_frames[ xdp->tx_free++ ] = addrs[ cons++ & xdp->comp.mask ];
+	ring_store (xdp->comp.consumer, cons);
+	xdp->comp.cached_cons = cons;
+}
+
+/* start transmission of queued frames, also drives completions in
+ * XDP_USE_NEED_WAKEUP mode.
+ */
+
+static inline
+void
+xdp_kick (
+	struct pgm_xdp_t*	xdp
+	)
+{
+	if (!ring_needs_wakeup (&xdp->tx))
+		return;
+/* EAGAIN, EBUSY and ENOBUFS indicate the ring is still being drained */
+	sendto (xdp->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+}
+#endif /* HAVE_LINUX_IF_XDP_H */
+
+/* create an AF_XDP socket on a queue of the send interface, register the
+ * socket with the operator supplied XSKMAP of a loaded redirect program.
+ * Called from pgm_bind() after the send socket is bound.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error appropriately.
+ */
+
+bool
+pgm_xdp_open (
+	pgm_sock_t*    const restrict sock,
+	const unsigned		      ifindex,
+	pgm_error_t**	     restrict error
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL == sock->xdp);
+	pgm_assert (sock->xdp_xskmap_fd >= 0);
+
+#ifdef HAVE_LINUX_IF_XDP_H
+	char errbuf[1024];
+	int save_errno;
+	const char* what;
+
+	if (AF_INET != sock->family) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_AFNOSUPPORT,
+			       _("AF_XDP transport requires IPv4."));
+		return FALSE;
+	}
+	if ((size_t)sock->max_tpdu + PGM_XDP_HEADROOM > PGM_XDP_FRAME_SIZE) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_INVAL,
+			       _("Maximum TPDU %u exceeds AF_XDP frame size %u."),
+			       (unsigned)sock->max_tpdu, (unsigned)PGM_XDP_FRAME_SIZE);
+		return FALSE;
+	}
+	if (0 == ifindex) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_NODEV,
+			       _("AF_XDP transport requires an explicit network interface."));
+		return FALSE;
+	}
+
+	struct pgm_xdp_t* xdp = pgm_new0 (struct pgm_xdp_t, 1);
+	xdp->fd		= INVALID_SOCKET;
+	xdp->umem	= MAP_FAILED;
+	pgm_spinlock_init (&xdp->tx_lock);
+	sock->xdp	= xdp;
+
+/* source link and network addresses for transmitted frames */
+	socklen_t addrlen = sizeof(xdp->src_addr);
+	what = "getsockname";
+	if (SOCKET_ERROR == getsockname (sock->send_sock, (struct sockaddr*)&xdp->src_addr, &addrlen))
+		goto err_errno;
+	struct ifreq ifr;
+	memset (&ifr, 0, sizeof(ifr));
+	what = "SIOCGIFHWADDR";
+	if (NULL == if_indextoname (ifindex, ifr.ifr_name) ||
+	    SOCKET_ERROR == ioctl (sock->send_sock, SIOCGIFHWADDR, &ifr))
+		goto err_errno;
+	memcpy (xdp->src_hwaddr, ifr.ifr_hwaddr.sa_data, sizeof(xdp->src_hwaddr));
+
+	what = "socket";
+	if (INVALID_SOCKET == (xdp->fd = socket (AF_XDP, SOCK_RAW, 0)))
+		goto err_errno;
+
+/* one region of 2 × ring size frames, lower half receive, upper half transmit */
+	xdp->umem_len = 2 * PGM_XDP_RING_SIZE * PGM_XDP_FRAME_SIZE;
+	what = "mmap";
+	xdp->umem = mmap (NULL, xdp->umem_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (MAP_FAILED == xdp->umem)
+		goto err_errno;
+
+	struct xdp_umem_reg mr;
+	memset (&mr, 0, sizeof(mr));
+	mr.addr		= (uintptr_t)xdp->umem;
+	mr.len		= xdp->umem_len;
+	mr.chunk_size	= PGM_XDP_FRAME_SIZE;
+	mr.headroom	= 0;
+	const int ring_size = PGM_XDP_RING_SIZE;
+	what = "XDP_UMEM_REG";
+	if (SOCKET_ERROR == setsockopt (xdp->fd, SOL_XDP, XDP_UMEM_REG, &mr, sizeof(mr)))
+		goto err_errno;
+	what = "XDP ring size";
+	if (SOCKET_ERROR == setsockopt (xdp->fd, SOL_XDP, XDP_UMEM_FILL_RING, &ring_size, sizeof(ring_size)) ||
+	    SOCKET_ERROR == setsockopt (xdp->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ring_size, sizeof(ring_size)) ||
+	    SOCKET_ERROR == setsockopt (xdp->fd, SOL_XDP, XDP_RX_RING, &ring_size, sizeof(ring_size)) ||
+	    SOCKET_ERROR == setsockopt (xdp->fd, SOL_XDP, XDP_TX_RING, &ring_size, sizeof(ring_size)))
+		goto err_errno;
+
+	struct xdp_mmap_offsets off;
+	socklen_t optlen = sizeof(off);
+	what = "XDP_MMAP_OFFSETS";
+	if (SOCKET_ERROR == getsockopt (xdp->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen))
+		goto err_errno;
+	what = "XDP ring mmap";
+	if (!ring_map (xdp->fd, &xdp->fill, &off.fr, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING) ||
+	    !ring_map (xdp->fd, &xdp->comp, &off.cr, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING) ||
+	    !ring_map (xdp->fd, &xdp->rx, &off.rx, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING) ||
+	    !ring_map (xdp->fd, &xdp->tx, &off.tx, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING))
+		goto err_errno;
+
+/* hand every receive frame to the kernel */
+	uint64_t* fill = xdp->fill.ring;
+	for (unsigned i = 0; i < PGM_XDP_RING_SIZE; i++)
+		fill[i] = (uint64_t)i * PGM_XDP_FRAME_SIZE;
+	xdp->fill.cached_prod += PGM_XDP_RING_SIZE;
+	ring_store (xdp->fill.producer, xdp->fill.cached_prod);
+
+	xdp->tx_frames = pgm_new (uint64_t, PGM_XDP_RING_SIZE);
+	for (unsigned i = 0; i < PGM_XDP_RING_SIZE; i++)
+		xdp->tx_frames[i] = (uint64_t)(PGM_XDP_RING_SIZE + i) * PGM_XDP_FRAME_SIZE;
+	xdp->tx_free = PGM_XDP_RING_SIZE;
+
+	struct sockaddr_xdp sxdp;
+	memset (&sxdp, 0, sizeof(sxdp));
+	sxdp.sxdp_family	= AF_XDP;
+	sxdp.sxdp_ifindex	= ifindex;
+	sxdp.sxdp_queue_id	= sock->xdp_queue_id;
+	sxdp.sxdp_flags		= XDP_USE_NEED_WAKEUP;
+	what = "bind";
+	if (SOCKET_ERROR == bind (xdp->fd, (struct sockaddr*)&sxdp, sizeof(sxdp)))
+		goto err_errno;
+
+/* direct the queue to this socket */
+	union bpf_attr attr;
+	memset (&attr, 0, sizeof(attr));
+	attr.map_fd	= sock->xdp_xskmap_fd;
+	attr.key	= (uintptr_t)&sock->xdp_queue_id;
+	attr.value	= (uintptr_t)&xdp->fd;
+	attr.flags	= BPF_ANY;
+	what = "XSKMAP update";
+	if (0 != syscall (__NR_bpf, BPF_MAP_UPDATE_ELEM, &attr, sizeof(attr)))
+		goto err_errno;
+
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("AF_XDP socket bound to interface index %u queue %u."),
+		   (unsigned)ifindex, (unsigned)sock->xdp_queue_id);
+	return TRUE;
+
+err_errno:
+	save_errno = errno;
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       pgm_error_from_errno (save_errno),
+		       _("AF_XDP %s: %s"),
+		       what,
+		       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+	pgm_xdp_close (sock);
+	return FALSE;
+#else
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       PGM_ERROR_NOSYS,
+		       _("AF_XDP unavailable on this platform."));
+	return FALSE;
+#endif /* HAVE_LINUX_IF_XDP_H */
+}
+
+void
+pgm_xdp_close (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+#ifdef HAVE_LINUX_IF_XDP_H
+	struct pgm_xdp_t* xdp = sock->xdp;
+	if (NULL == xdp)
+		return;
+	ring_unmap (&xdp->tx);
+	ring_unmap (&xdp->rx);
+	ring_unmap (&xdp->comp);
+	ring_unmap (&xdp->fill);
+	if (INVALID_SOCKET != xdp->fd)
+		closesocket (xdp->fd);
+	if (MAP_FAILED != xdp->umem)
+		munmap (xdp->umem, xdp->umem_len);
+	if (NULL != xdp->tx_frames)
+		pgm_free (xdp->tx_frames);
+	pgm_spinlock_free (&xdp->tx_lock);
+	pgm_free (xdp);
+	sock->xdp = NULL;
+#endif
+}
+
+#ifdef HAVE_LINUX_IF_XDP_H
+/* strip link and network headers of a received frame, leaving the datagram
+ * format of recvskb(): IP header onwards for raw PGM, payload for UDP
+ * encapsulation.
+ *
+ * returns datagram length, or 0 for frames not addressed to this socket.
+ */
+
+static
+size_t
+xdp_parse (
+	const pgm_sock_t*     const restrict sock,
+	const char*	      const restrict frame,
+	const size_t			     frame_len,
+	const char**	      const restrict datagram,
+	struct sockaddr_in*   const restrict src,
+	struct sockaddr_in*   const restrict dst
+	)
+{
+	if (PGM_UNLIKELY(frame_len < sizeof(struct ether_header) + sizeof(struct pgm_ip)))
+		return 0;
+
+	const struct ether_header* eth = (const struct ether_header*)frame;
+	size_t offset = sizeof(struct ether_header);
+	uint16_t ether_type = eth->ether_type;
+/* single 802.1Q tag */
+	if (htons (ETHERTYPE_VLAN) == ether_type) {
+		memcpy (&ether_type, frame + offset + 2, sizeof(ether_type));
+		offset += 4;
+	}
+	if (htons (ETHERTYPE_IP) != ether_type)
+		return 0;
+
+	const struct pgm_ip* ip = (const struct pgm_ip*)(frame + offset);
+	const size_t ip_header_length = ip->ip_hl * 4;
+	const size_t packet_length = ntohs (ip->ip_len);
+	if (PGM_UNLIKELY(4 != ip->ip_v ||
+			 ip_header_length < sizeof(struct pgm_ip) ||
+			 packet_length < ip_header_length ||
+			 offset + packet_length > frame_len))
+		return 0;
+/* fragments are reassembled by the kernel stack only */
+	if (PGM_UNLIKELY(0 != (ntohs (ip->ip_off) & 0x3fff)))
+		return 0;
+
+	memset (src, 0, sizeof(struct sockaddr_in));
+	src->sin_family	= AF_INET;
+	src->sin_addr	= ip->ip_src;
+	memset (dst, 0, sizeof(struct sockaddr_in));
+	dst->sin_family	= AF_INET;
+	dst->sin_addr	= ip->ip_dst;
+
+	if (IPPROTO_UDP == sock->protocol)
+	{
+		if (IPPROTO_UDP != ip->ip_p ||
+		    packet_length < ip_header_length + sizeof(struct pgm_udphdr))
+			return 0;
+		const struct pgm_udphdr* udp = (const struct pgm_udphdr*)((const char*)ip + ip_header_length);
+		if (htons (sock->udp_encap_mcast_port) != udp->uh_dport &&
+		    htons (sock->udp_encap_ucast_port) != udp->uh_dport)
+			return 0;
+		const size_t udp_length = ntohs (udp->uh_ulen);
+		if (PGM_UNLIKELY(udp_length < sizeof(struct pgm_udphdr) ||
+				 udp_length > packet_length - ip_header_length))
+			return 0;
+		src->sin_port	= udp->uh_sport;
+		dst->sin_port	= udp->uh_dport;
+		*datagram	= (const char*)udp + sizeof(struct pgm_udphdr);
+		return udp_length - sizeof(struct pgm_udphdr);
+	}
+
+	if (IPPROTO_PGM != ip->ip_p)
+		return 0;
+	*datagram = (const char*)ip;
+	return packet_length;
+}
+
+/* read the next PGM packet from the AF_XDP receive ring into a PGM skbuff,
+ * the frame is returned to the fill ring immediately.
+ *
+ * on success returns packet length, on empty ring returns -1 with EAGAIN.
+ */
+
+ssize_t
+pgm_xdp_recvskb (
+	pgm_sock_t*           const restrict sock,
+	struct pgm_sk_buff_t* const restrict skb,
+	struct sockaddr*      const restrict src_addr,
+	const socklen_t			     src_addrlen,
+	struct sockaddr*      const restrict dst_addr,
+	const socklen_t			     dst_addrlen
+	)
+{
+	struct pgm_xdp_t* xdp = sock->xdp;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != xdp);
+	pgm_assert (NULL != skb);
+	pgm_assert (NULL != src_addr);
+	pgm_assert (src_addrlen > 0);
+	pgm_assert (NULL != dst_addr);
+	pgm_assert (dst_addrlen > 0);
+
+	if (PGM_UNLIKELY(sock->is_destroyed))
+		return 0;
+
+	for (;;)
+	{
+		uint32_t cons = xdp->rx.cached_cons;
+		if (cons == ring_load (xdp->rx.producer)) {
+			if (ring_needs_wakeup (&xdp->fill))
+				recvfrom (xdp->fd, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+			pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+			return SOCKET_ERROR;
+		}
+
+		const struct xdp_desc* desc = &((const struct xdp_desc*)xdp->rx.ring)[ cons & xdp->rx.mask ];
+		const uint64_t addr = desc->addr;
+		const char* datagram = NULL;
+		struct sockaddr_in src, dst;
+		size_t len = xdp_parse (sock, xdp->umem + addr, desc->len, &datagram, &src, &dst);
+		if (len > 0) {
+/* truncate as per recvmsg() into max_tpdu */
+			len = MIN(len, sock->max_tpdu);
+			memcpy (skb->head, datagram, len);
+		}
+		ring_store (xdp->rx.consumer, ++cons);
+		xdp->rx.cached_cons = cons;
+
+/* fill ring is sized for every receive frame and cannot overflow */
+		((uint64_t*)xdp->fill.ring)[ xdp->fill.cached_prod++ & xdp->fill.mask ] = addr - (addr % PGM_XDP_FRAME_SIZE);
+		ring_store (xdp->fill.producer, xdp->fill.cached_prod);
+
+		if (0 == len)
+			continue;
+
+		memcpy (src_addr, &src, MIN(src_addrlen, sizeof(src)));
+		memcpy (dst_addr, &dst, MIN(dst_addrlen, sizeof(dst)));
+
+		skb->sock		= sock;
+		skb->tstamp		= pgm_time_coarse_now();
+		skb->rx_tstamp		= 0;
+		skb->data		= skb->head;
+		skb->len		= (uint16_t)len;
+		skb->zero_padded	= 0;
+		skb->tail		= (char*)skb->data + len;
+		return len;
+	}
+}
+
+/* prepend Ethernet, IPv4 and optional UDP headers to a PGM packet.
+ *
+ * returns frame length.
+ */
+
+static
+size_t
+xdp_build (
+	const pgm_sock_t*	  const restrict sock,
+	struct pgm_xdp_t*	  const restrict xdp,
+	char*			  const restrict frame,
+	const bool				 use_router_alert,
+	const int				 hops,
+	const void*		  const restrict buf,
+	const size_t				 len,
+	const struct sockaddr_in* const restrict to
+	)
+{
+	const uint8_t* group = (const uint8_t*)&to->sin_addr.s_addr;
+	struct ether_header* eth = (struct ether_header*)frame;
+/* RFC 1112 multicast mapping */
+	eth->ether_dhost[0] = 0x01;
+	eth->ether_dhost[1] = 0x00;
+	eth->ether_dhost[2] = 0x5e;
+	eth->ether_dhost[3] = group[1] & 0x7f;
+	eth->ether_dhost[4] = group[2];
+	eth->ether_dhost[5] = group[3];
+	memcpy (eth->ether_shost, xdp->src_hwaddr, sizeof(eth->ether_shost));
+	eth->ether_type = htons (ETHERTYPE_IP);
+
+	struct pgm_ip* ip = (struct pgm_ip*)(eth + 1);
+	size_t ip_header_length = sizeof(struct pgm_ip);
+	if (use_router_alert) {
+		uint8_t* ra = (uint8_t*)(ip + 1);
+		ra[0] = PGM_IPOPT_RA;
+		ra[1] = 4;
+		ra[2] = ra[3] = 0;
+		ip_header_length += 4;
+	}
+	const bool is_udp = (IPPROTO_UDP == sock->protocol);
+	const size_t packet_length = ip_header_length + (is_udp ? sizeof(struct pgm_udphdr) : 0) + len;
+	ip->ip_v	= 4;
+	ip->ip_hl	= ip_header_length / 4;
+	ip->ip_tos	= 0;
+	ip->ip_len	= htons ((uint16_t)packet_length);
+	ip->ip_id	= htons (xdp->ip_id++);
+	ip->ip_off	= 0;
+	ip->ip_ttl	= (-1 != hops) ? hops : sock->hops;
+	ip->ip_p	= is_udp ? IPPROTO_UDP : IPPROTO_PGM;
+	ip->ip_sum	= 0;
+	ip->ip_src	= xdp->src_addr.sin_addr;
+	ip->ip_dst	= to->sin_addr;
+	ip->ip_sum	= pgm_inet_checksum (ip, (uint16_t)ip_header_length, 0);
+
+	char* payload = (char*)ip + ip_header_length;
+	if (is_udp) {
+		struct pgm_udphdr* udp = (struct pgm_udphdr*)payload;
+		udp->uh_sport	= xdp->src_addr.sin_port;
+		udp->uh_dport	= to->sin_port;
+		udp->uh_ulen	= htons ((uint16_t)(sizeof(struct pgm_udphdr) + len));
+		udp->uh_sum	= 0;		/* optional for IPv4 */
+		payload += sizeof(struct pgm_udphdr);
+	}
+	memcpy (payload, buf, len);
+	return sizeof(struct ether_header) + packet_length;
+}
+
+/* queue a vector of PGM packets to one multicast destination on the AF_XDP
+ * transmit ring.  Blocking sockets wait for completed frames when the ring
+ * is exhausted.
+ *
+ * on success, returns number of packets queued.  on error, -1 is returned
+ * and errno set to EAGAIN.
+ */
+
+int
+pgm_xdp_sendv (
+	pgm_sock_t*	       const restrict sock,
+	const bool			      use_router_alert,
+	const int			      hops,
+	const struct pgm_iovec* const restrict vector,
+	const unsigned			      count,
+	const struct sockaddr*  const restrict to
+	)
+{
+	struct pgm_xdp_t* xdp = sock->xdp;
+
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL != xdp);
+	pgm_assert (NULL != vector);
+	pgm_assert (count > 0);
+	pgm_assert (pgm_xdp_can_sendto (sock, to));
+
+	unsigned i = 0;
+	pgm_spinlock_lock (&xdp->tx_lock);
+	xdp_reclaim (xdp);
+	while (0 == xdp->tx_free && !sock->is_nonblocking) {
+		xdp_kick (xdp);
+		xdp_reclaim (xdp);
+	}
+	uint32_t prod = xdp->tx.cached_prod;
+/* transmit ring is sized for every transmit frame and cannot overflow */
+	for (; i < count && xdp->tx_free > 0; i++)
+	{
+		pgm_assert_cmpuint (vector[i].iov_len + PGM_XDP_HEADROOM, <=, PGM_XDP_FRAME_SIZE);
+		const uint64_t addr = xdp->tx_frames[ --xdp->tx_free ];
+		struct xdp_desc* desc = &((struct xdp_desc*)xdp->tx.ring)[ prod++ & xdp->tx.mask ];
+		desc->addr	= addr;
+		desc->len	= xdp_build (sock, xdp, xdp->umem + addr, use_router_alert, hops,
+					     vector[i].iov_base, vector[i].iov_len,
+					     (const struct sockaddr_in*)to);
+		desc->options	= 0;
+	}
+	if (i > 0) {
+		ring_store (xdp->tx.producer, prod);
+		xdp->tx.cached_prod = prod;
+		xdp_kick (xdp);
+	}
+	pgm_spinlock_unlock (&xdp->tx_lock);
+	if (0 == i) {
+		pgm_set_last_sock_error (PGM_SOCK_EAGAIN);
+		return -1;
+	}
+	return (int)i;
+}
+#endif /* HAVE_LINUX_IF_XDP_H */
+
+/* eof */
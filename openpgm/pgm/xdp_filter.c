@@ -0,0 +1,492 @@
+/* vim:ts=8:sts=4:sw=4:noai:noexpandtab
+ *
+ * XDP early drop of duplicate and irrelevant PGM traffic.
+ *
+ * In a large group every receiver is sent the repairs requested by any
+ * other receiver and the upstream packets of a source addressed to the
+ * group, all of which the kernel delivers to the receiving socket only for
+ * the parser or receive window to discard.  An XDP program attached to the
+ * receive interface drops, for the session data-destination port:
+ *
+ * 1) ODATA and RDATA of a source below the sequence the receive window has
+ *    already committed, published per TSI in a hash map by the window.
+ * 2) NNAKs, ACKs and POLRs when the socket does not send data.
+ *
+ * Everything else, including other sessions and other protocols, passes to
+ * the stack untouched.  The program is assembled at bind time for the
+ * session ports and requires Linux 5.9 for BPF links.
+ *
+ * Copyright (c) 2006-2011 Miru Limited.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#ifdef HAVE_LINUX_IF_XDP_H
+#	include <unistd.h>
+#	include <sys/syscall.h>
+#	include <net/ethernet.h>
+#	include <linux/bpf.h>
+#endif
+#include <impl/i18n.h>
+#include <impl/framework.h>
+#include <impl/xdp_filter.h>
+
+
+//#define XDP_FILTER_DEBUG
+
+#ifndef XDP_FILTER_DEBUG
+#	define PGM_DISABLE_ASSERT
+#endif
+
+#ifdef HAVE_LINUX_IF_XDP_H
+#define XDP_FILTER_INSNS_MAX	96
+
+/* jump targets resolved once the program is complete */
+enum {
+	XDP_LABEL_NONE = 0,
+	XDP_LABEL_UPSTREAM,
+	XDP_LABEL_DATA,
+	XDP_LABEL_PASS,
+	XDP_LABEL_DROP,
+	XDP_LABEL_MAX
+};
+
+struct xdp_prog_t {
+	struct bpf_insn		insn[XDP_FILTER_INSNS_MAX];
+	uint8_t			target[XDP_FILTER_INSNS_MAX];
+	unsigned		label[XDP_LABEL_MAX];
+	unsigned		len;
+};
+
+static
+void
+emit (
+	struct xdp_prog_t* const	prog,
+	const uint8_t			code,
+	const uint8_t			dst_reg,
+	const uint8_t			src_reg,
+	const int16_t			off,
+	const int32_t			imm,
+	const uint8_t			target
+	)
+{
+	pgm_assert (prog->len < XDP_FILTER_INSNS_MAX);
+	struct bpf_insn* insn = &prog->insn[ prog->len ];
+	insn->code	= code;
+	insn->dst_reg	= dst_reg;
+	insn->src_reg	= src_reg;
+	insn->off	= off;
+	insn->imm	= imm;
+	prog->target[ prog->len++ ] = target;
+}
+
+/* dst = *(size*)(src + off) */
+static inline
+void
+emit_load (
+	struct xdp_prog_t* const	prog,
+	const uint8_t			size,
+	const uint8_t			dst_reg,
+	const uint8_t			src_reg,
+	const int16_t			off
+	)
+{
+	emit (prog, BPF_LDX | size | BPF_MEM, dst_reg, src_reg, off, 0, XDP_LABEL_NONE);
+}
+
+/* *(size*)(dst + off) = src */
+static inline
+void
+emit_store (
+	struct xdp_prog_t* const	prog,
+	const uint8_t			size,
+	const uint8_t			dst_reg,
+	const int16_t			off,
+	const uint8_t			src_reg
+	)
+{
+	emit (prog, BPF_STX | size | BPF_MEM, dst_reg, src_reg, off, 0, XDP_LABEL_NONE);
+}
+
+static inline
+void
+emit_alu (
+	struct xdp_prog_t* const	prog,
+	const uint8_t			op,
+	const uint8_t			dst_reg,
+	const int32_t			imm
+	)
+{
+	emit (prog, BPF_ALU64 | op | BPF_K, dst_reg, 0, 0, imm, XDP_LABEL_NONE);
+}
+
+static inline
+void
+emit_alu_reg (
+	struct xdp_prog_t* const	prog,
+	const uint8_t			op,
+	const uint8_t			dst_reg,
+	const uint8_t			src_reg
+	)
+{
+	emit (prog, BPF_ALU64 | op | BPF_X, dst_reg, src_reg, 0, 0, XDP_LABEL_NONE);
+}
+
+/* convert a big-endian field to host order in place */
+static inline
+void
+emit_ntoh (
+	struct xdp_prog_t* const	prog,
+	const uint8_t			dst_reg,
+	const int32_t			bits
+	)
+{
+	emit (prog, BPF_ALU | BPF_END | BPF_TO_BE, dst_reg, 0, 0, bits, XDP_LABEL_NONE);
+}
+
+/* jump to a label when dst op imm */
+static inline
+void
+emit_jmp (
+	struct xdp_prog_t* const	prog,
+	const uint8_t			op,
+	const uint8_t			dst_reg,
+	const int32_t			imm,
+	const uint8_t			target
+	)
+{
+	emit (prog, BPF_JMP | op | BPF_K, dst_reg, 0, 0, imm, target);
+}
+
+/* pass unless the packet extends len octets beyond r6 */
+static inline
+void
+emit_bounds (
+	struct xdp_prog_t* const	prog,
+	const int32_t			len
+	)
+{
+	emit_alu_reg (prog, BPF_MOV, BPF_REG_2, BPF_REG_6);
+	emit_alu (prog, BPF_ADD, BPF_REG_2, len);
+	emit (prog, BPF_JMP | BPF_JGT | BPF_X, BPF_REG_2, BPF_REG_9, 0, 0, XDP_LABEL_PASS);
+}
+
+static inline
+void
+set_label (
+	struct xdp_prog_t* const	prog,
+	const unsigned			label
+	)
+{
+	prog->label[ label ] = prog->len;
+}
+
+static
+void
+resolve_labels (
+	struct xdp_prog_t* const	prog
+	)
+{
+	for (unsigned i = 0; i < prog->len; i++)
+		if (XDP_LABEL_NONE != prog->target[ i ])
+			prog->insn[ i ].off = (int16_t)(prog->label[ prog->target[ i ] ] - (i + 1));
+}
+
+/* r6 walks the packet, r9 holds the packet end and r7 the data sequence
+ * across the map lookup.  16-bit port fields are compared as loaded, the
+ * constants taken from network order memory such that no conversion is
+ * needed on either endianness.
+ */
+
+static
+void
+build_program (
+	const pgm_sock_t* const		sock,
+	struct xdp_prog_t* const	prog,
+	const int			map_fd
+	)
+{
+	uint16_t dport, encap_port;
+	const bool is_udp = (IPPROTO_UDP == sock->protocol);
+	const uint16_t encap_port_n = htons (sock->udp_encap_mcast_port);
+
+	memcpy (&dport, &sock->dport, sizeof(dport));
+	memcpy (&encap_port, &encap_port_n, sizeof(encap_port));
+	memset (prog, 0, sizeof(struct xdp_prog_t));
+
+	emit_load (prog, BPF_W, BPF_REG_6, BPF_REG_1, offsetof(struct xdp_md, data));
+	emit_load (prog, BPF_W, BPF_REG_9, BPF_REG_1, offsetof(struct xdp_md, data_end));
+
+/* IPv4 without VLAN tag */
+	emit_bounds (prog, sizeof(struct ether_header) + sizeof(struct pgm_ip));
+	emit_load (prog, BPF_H, BPF_REG_3, BPF_REG_6, offsetof(struct ether_header, ether_type));
+	emit_ntoh (prog, BPF_REG_3, 16);
+	emit_jmp (prog, BPF_JNE, BPF_REG_3, ETHERTYPE_IP, XDP_LABEL_PASS);
+	emit_load (prog, BPF_B, BPF_REG_4, BPF_REG_6, sizeof(struct ether_header) + offsetof(struct pgm_ip, ip_p));
+	emit_jmp (prog, BPF_JNE, BPF_REG_4, is_udp ? IPPROTO_UDP : IPPROTO_PGM, XDP_LABEL_PASS);
+	emit_load (prog, BPF_B, BPF_REG_3, BPF_REG_6, sizeof(struct ether_header));
+	emit_alu (prog, BPF_AND, BPF_REG_3, 0x0f);
+	emit_alu (prog, BPF_LSH, BPF_REG_3, 2);
+	emit_alu (prog, BPF_ADD, BPF_REG_6, sizeof(struct ether_header));
+	emit_alu_reg (prog, BPF_ADD, BPF_REG_6, BPF_REG_3);
+
+/* UDP encapsulation on the multicast port */
+	if (is_udp) {
+		emit_bounds (prog, sizeof(struct pgm_udphdr));
+		emit_load (prog, BPF_H, BPF_REG_3, BPF_REG_6, offsetof(struct pgm_udphdr, uh_dport));
+		emit_jmp (prog, BPF_JNE, BPF_REG_3, encap_port, XDP_LABEL_PASS);
+		emit_alu (prog, BPF_ADD, BPF_REG_6, sizeof(struct pgm_udphdr));
+	}
+
+	emit_bounds (prog, sizeof(struct pgm_header) + sizeof(struct pgm_data));
+	emit_load (prog, BPF_B, BPF_REG_3, BPF_REG_6, offsetof(struct pgm_header, pgm_type));
+	emit_jmp (prog, BPF_JEQ, BPF_REG_3, PGM_ODATA, XDP_LABEL_DATA);
+	emit_jmp (prog, BPF_JEQ, BPF_REG_3, PGM_RDATA, XDP_LABEL_DATA);
+	if (!sock->can_send_data) {
+		emit_jmp (prog, BPF_JEQ, BPF_REG_3, PGM_NNAK, XDP_LABEL_UPSTREAM);
+		emit_jmp (prog, BPF_JEQ, BPF_REG_3, PGM_ACK,  XDP_LABEL_UPSTREAM);
+		emit_jmp (prog, BPF_JEQ, BPF_REG_3, PGM_POLR, XDP_LABEL_UPSTREAM);
+	}
+	emit (prog, BPF_JMP | BPF_JA, 0, 0, 0, 0, XDP_LABEL_PASS);
+
+/* upstream ports are reversed */
+	set_label (prog, XDP_LABEL_UPSTREAM);
+	emit_load (prog, BPF_H, BPF_REG_3, BPF_REG_6, offsetof(struct pgm_header, pgm_sport));
+	emit_jmp (prog, BPF_JNE, BPF_REG_3, dport, XDP_LABEL_PASS);
+	emit (prog, BPF_JMP | BPF_JA, 0, 0, 0, 0, XDP_LABEL_DROP);
+
+/* key is the TSI as pgm_tsi_t, GSI then source port */
+	set_label (prog, XDP_LABEL_DATA);
+	emit_load (prog, BPF_H, BPF_REG_3, BPF_REG_6, offsetof(struct pgm_header, pgm_dport));
+	emit_jmp (prog, BPF_JNE, BPF_REG_3, dport, XDP_LABEL_PASS);
+	emit_load (prog, BPF_W, BPF_REG_7, BPF_REG_6, sizeof(struct pgm_header) + offsetof(struct pgm_data, data_sqn));
+	emit_ntoh (prog, BPF_REG_7, 32);
+	emit_load (prog, BPF_W, BPF_REG_3, BPF_REG_6, offsetof(struct pgm_header, pgm_gsi));
+	emit_store (prog, BPF_W, BPF_REG_10, -8, BPF_REG_3);
+	emit_load (prog, BPF_H, BPF_REG_3, BPF_REG_6, offsetof(struct pgm_header, pgm_gsi) + 4);
+	emit_store (prog, BPF_H, BPF_REG_10, -4, BPF_REG_3);
+	emit_load (prog, BPF_H, BPF_REG_3, BPF_REG_6, offsetof(struct pgm_header, pgm_sport));
+	emit_store (prog, BPF_H, BPF_REG_10, -2, BPF_REG_3);
+	emit (prog, BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, map_fd, XDP_LABEL_NONE);
+	emit (prog, 0, 0, 0, 0, 0, XDP_LABEL_NONE);
+	emit_alu_reg (prog, BPF_MOV, BPF_REG_2, BPF_REG_10);
+	emit_alu (prog, BPF_ADD, BPF_REG_2, -8);
+	emit (prog, BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_map_lookup_elem, XDP_LABEL_NONE);
+	emit_jmp (prog, BPF_JEQ, BPF_REG_0, 0, XDP_LABEL_PASS);
+
+/* held when sequence - commit_lead is negative in serial arithmetic */
+	emit_load (prog, BPF_W, BPF_REG_1, BPF_REG_0, 0);
+	emit (prog, BPF_ALU | BPF_SUB | BPF_X, BPF_REG_7, BPF_REG_1, 0, 0, XDP_LABEL_NONE);
+	emit (prog, BPF_ALU | BPF_RSH | BPF_K, BPF_REG_7, 0, 0, 31, XDP_LABEL_NONE);
+	emit_jmp (prog, BPF_JNE, BPF_REG_7, 0, XDP_LABEL_DROP);
+
+	set_label (prog, XDP_LABEL_PASS);
+	emit (prog, BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS, XDP_LABEL_NONE);
+	emit (prog, BPF_JMP | BPF_EXIT, 0, 0, 0, 0, XDP_LABEL_NONE);
+	set_label (prog, XDP_LABEL_DROP);
+	emit (prog, BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_DROP, XDP_LABEL_NONE);
+	emit (prog, BPF_JMP | BPF_EXIT, 0, 0, 0, 0, XDP_LABEL_NONE);
+	resolve_labels (prog);
+}
+
+static inline
+int
+sys_bpf (
+	const int		cmd,
+	union bpf_attr*		attr
+	)
+{
+	return (int)syscall (__NR_bpf, cmd, attr, sizeof(*attr));
+}
+#endif /* HAVE_LINUX_IF_XDP_H */
+
+/* load the program for the session and attach it to the receive interface,
+ * replacing none.  IPv4 only.
+ *
+ * returns TRUE on success, returns FALSE on error and sets error appropriately.
+ */
+
+bool
+pgm_xdp_filter_attach (
+	pgm_sock_t*    const restrict sock,
+	const unsigned		      ifindex,
+	pgm_error_t**	     restrict error
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+	pgm_assert (NULL == sock->xdp_filter);
+
+#ifdef HAVE_LINUX_IF_XDP_H
+	char errbuf[1024];
+	int save_errno;
+	const char* what;
+	union bpf_attr attr;
+
+	if (AF_INET != sock->family) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_AFNOSUPPORT,
+			       _("XDP filter requires IPv4."));
+		return FALSE;
+	}
+	if (0 == ifindex) {
+		pgm_set_error (error,
+			       PGM_ERROR_DOMAIN_SOCKET,
+			       PGM_ERROR_NODEV,
+			       _("XDP filter requires an explicit network interface."));
+		return FALSE;
+	}
+
+	pgm_xdp_filter_t* filter = pgm_new (pgm_xdp_filter_t, 1);
+	filter->prog_fd = filter->map_fd = filter->link_fd = -1;
+	sock->xdp_filter = filter;
+
+	memset (&attr, 0, sizeof(attr));
+	attr.map_type		= BPF_MAP_TYPE_HASH;
+	attr.key_size		= sizeof(pgm_tsi_t);
+	attr.value_size		= sizeof(uint32_t);
+	attr.max_entries	= PGM_XDP_FILTER_SOURCES;
+	what = "BPF_MAP_CREATE";
+	if ((filter->map_fd = sys_bpf (BPF_MAP_CREATE, &attr)) < 0)
+		goto err_errno;
+
+	struct xdp_prog_t* prog = pgm_new (struct xdp_prog_t, 1);
+	build_program (sock, prog, filter->map_fd);
+	memset (&attr, 0, sizeof(attr));
+	attr.prog_type		= BPF_PROG_TYPE_XDP;
+	attr.insn_cnt		= prog->len;
+	attr.insns		= (uintptr_t)prog->insn;
+	attr.license		= (uintptr_t)"LGPL";
+	what = "BPF_PROG_LOAD";
+	filter->prog_fd = sys_bpf (BPF_PROG_LOAD, &attr);
+	save_errno = errno;
+	pgm_free (prog);
+	if (filter->prog_fd < 0) {
+		errno = save_errno;
+		goto err_errno;
+	}
+
+	memset (&attr, 0, sizeof(attr));
+	attr.link_create.prog_fd	 = filter->prog_fd;
+	attr.link_create.target_ifindex	 = ifindex;
+	attr.link_create.attach_type	 = BPF_XDP;
+	what = "BPF_LINK_CREATE";
+	if ((filter->link_fd = sys_bpf (BPF_LINK_CREATE, &attr)) < 0)
+		goto err_errno;
+
+	pgm_trace (PGM_LOG_ROLE_NETWORK,_("XDP filter attached to interface index %u."),
+		   (unsigned)ifindex);
+	return TRUE;
+
+err_errno:
+	save_errno = errno;
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       pgm_error_from_errno (save_errno),
+		       _("XDP filter %s: %s"),
+		       what,
+		       pgm_strerror_s (errbuf, sizeof (errbuf), save_errno));
+	pgm_xdp_filter_detach (sock);
+	return FALSE;
+#else
+	pgm_set_error (error,
+		       PGM_ERROR_DOMAIN_SOCKET,
+		       PGM_ERROR_NOSYS,
+		       _("XDP unavailable on this platform."));
+	return FALSE;
+#endif /* HAVE_LINUX_IF_XDP_H */
+}
+
+void
+pgm_xdp_filter_detach (
+	pgm_sock_t* const	sock
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != sock);
+
+#ifdef HAVE_LINUX_IF_XDP_H
+	pgm_xdp_filter_t* filter = sock->xdp_filter;
+	if (NULL == filter)
+		return;
+	if (filter->link_fd >= 0)
+		close (filter->link_fd);
+	if (filter->prog_fd >= 0)
+		close (filter->prog_fd);
+	if (filter->map_fd >= 0)
+		close (filter->map_fd);
+	pgm_free (filter);
+	sock->xdp_filter = NULL;
+#endif
+}
+
+/* set the commit lead of a source.  a full map leaves further sources
+ * unfiltered.
+ */
+
+void
+pgm_xdp_filter_update (
+	pgm_xdp_filter_t* const restrict filter,
+	const pgm_tsi_t*  const restrict tsi,
+	const uint32_t			 commit_lead
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != filter);
+	pgm_assert (NULL != tsi);
+
+#ifdef HAVE_LINUX_IF_XDP_H
+	union bpf_attr attr;
+	memset (&attr, 0, sizeof(attr));
+	attr.map_fd	= filter->map_fd;
+	attr.key	= (uintptr_t)tsi;
+	attr.value	= (uintptr_t)&commit_lead;
+	attr.flags	= BPF_ANY;
+	if (PGM_UNLIKELY(0 != sys_bpf (BPF_MAP_UPDATE_ELEM, &attr)))
+		pgm_debug ("held sequence update for %s failed", pgm_tsi_print (tsi));
+#endif
+}
+
+/* stop filtering a source whose receive window is destroyed.
+ */
+
+void
+pgm_xdp_filter_remove (
+	pgm_xdp_filter_t* const restrict filter,
+	const pgm_tsi_t*  const restrict tsi
+	)
+{
+/* pre-conditions */
+	pgm_assert (NULL != tsi);
+
+#ifdef HAVE_LINUX_IF_XDP_H
+	if (NULL == filter)
+		return;
+	union bpf_attr attr;
+	memset (&attr, 0, sizeof(attr));
+	attr.map_fd	= filter->map_fd;
+	attr.key	= (uintptr_t)tsi;
+	sys_bpf (BPF_MAP_DELETE_ELEM, &attr);
+#endif
+}
+
+/* eof */